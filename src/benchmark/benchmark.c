@@ -10,7 +10,11 @@ void
 benchmark_start(
 	void
 ) {
-	ram_counter		= free_ram();
+	ion_alloc_usage_t usage;
+
+	ion_alloc_reset_peak(ion_alloc_all);
+	ion_alloc_get_usage(ion_alloc_all, &usage);
+	ram_counter		= usage.total.current;
 	time_counter	= millis();
 }
 
@@ -18,8 +22,10 @@ void
 benchmark_stop(
 	void
 ) {
-	unsigned int	ram_used		= ram_counter - free_ram() - 4;	/* Magic offset - compensates for benchmark requiring 4 bytes to work */
-	unsigned int	time_elapsed	= millis() - time_counter;
+	ion_alloc_usage_t	usage;
+	unsigned int		time_elapsed	= millis() - time_counter;
 
-	printf("%db RAM use in %dms.\n", ram_used, time_elapsed);
+	/* counted by the allocation hooks, so every platform reports it */
+	ion_alloc_get_usage(ion_alloc_all, &usage);
+	printf("%ldb RAM use (%ldb peak) in %dms.\n", (long) usage.total.current - (long) ram_counter, (long) (usage.total.peak - ram_counter), time_elapsed);
 }
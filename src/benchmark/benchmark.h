@@ -13,9 +13,9 @@ extern "C" {
 
 #include "./../serial/serial_c_iface.h"
 #include "../key_value/kv_system.h"
-#include "ram/ram_util.h"
+#include "../dictionary/ion_alloc.h"
 
-static unsigned volatile int	ram_counter;
+static volatile size_t			ram_counter;
 static unsigned volatile int	time_counter;
 
 void
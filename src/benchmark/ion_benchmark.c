@@ -0,0 +1,420 @@
+/******************************************************************************/
+/**
+@file		ion_benchmark.c
+@brief		A portable benchmark of the dictionary engines under YCSB-style
+			workloads, see @ref ion_benchmark.h.
+*/
+/******************************************************************************/
+
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(ARDUINO)
+#include <time.h>
+#else
+#include "../file/SD_stdio_c_iface.h"
+#endif
+#include "ion_benchmark.h"
+#include "../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+#include "../dictionary/open_address_hash/open_address_hash_dictionary_handler.h"
+#include "../dictionary/skip_list/skip_list_handler.h"
+
+/**
+@brief		The records loaded by the standard workloads, and the operations
+			they run.
+*/
+#if defined(ARDUINO)
+#define ION_BENCH_RECORDS		200
+#define ION_BENCH_OPERATIONS	200L
+#else
+#define ION_BENCH_RECORDS		10000
+#define ION_BENCH_OPERATIONS	10000L
+#endif
+
+const ion_bench_engine_t ion_bench_engines[] = {
+	{ "bpptree", bpptree_init, 0 },
+	{ "flat_file", ffdict_init, 30 },
+	{ "open_address_hash", oadict_init, 0 },
+	{ "open_address_file_hash", oafdict_init, 0 },
+	{ "skip_list", sldict_init, 10 },
+};
+
+const int ion_bench_engine_count = sizeof(ion_bench_engines) / sizeof(ion_bench_engines[0]);
+
+const ion_bench_workload_t ion_bench_workloads[] = {
+	{ "load", ION_BENCH_RECORDS, 0, 0, 0, 0, 0, 0, ion_keygen_uniform, 16, 1 },
+	{ "read_heavy", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS, 95, 5, 0, 0, 0, ion_keygen_uniform, 16, 1 },
+	{ "read_heavy_zipf", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS, 95, 5, 0, 0, 0, ion_keygen_zipfian, 16, 1 },
+	{ "update_heavy", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS, 50, 50, 0, 0, 0, ion_keygen_uniform, 16, 1 },
+	{ "update_heavy_zipf", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS, 50, 50, 0, 0, 0, ion_keygen_zipfian, 16, 1 },
+	{ "read_insert", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS, 95, 0, 5, 0, 0, ion_keygen_uniform, 16, 1 },
+	{ "read_latest", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS, 95, 0, 5, 0, 0, ion_keygen_latest, 16, 1 },
+	{ "scan", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS / 10, 0, 0, 5, 95, 50, ion_keygen_uniform, 16, 1 },
+	{ "scan_zipf", ION_BENCH_RECORDS, ION_BENCH_OPERATIONS / 10, 0, 0, 5, 95, 50, ion_keygen_zipfian, 16, 1 },
+};
+
+const int ion_bench_workload_count = sizeof(ion_bench_workloads) / sizeof(ion_bench_workloads[0]);
+
+uint64_t
+ion_bench_clock(
+	void
+) {
+#if defined(ARDUINO)
+	return micros();
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+#endif
+}
+
+/**
+@brief		Counts an operation that took @p ticks.
+*/
+static void
+ion_bench_count(
+	ion_bench_histogram_t	*histogram,
+	uint32_t				ticks
+) {
+	int bucket;
+	int exponent;
+
+	if (ticks < ION_BENCH_SUB_BUCKETS) {
+		bucket = (int) ticks;
+	}
+	else {
+		for (exponent = ION_BENCH_SUB_BUCKETS_LOG; (exponent < 31) && ((ticks >> (exponent + 1)) > 0); exponent++) {}
+
+		/* the bits below the leading one pick the linear bucket */
+		bucket = (exponent - ION_BENCH_SUB_BUCKETS_LOG + 1) * ION_BENCH_SUB_BUCKETS + (int) ((ticks >> (exponent - ION_BENCH_SUB_BUCKETS_LOG)) & (ION_BENCH_SUB_BUCKETS - 1));
+	}
+
+	histogram->counts[bucket]++;
+	histogram->count++;
+	histogram->total += ticks;
+
+	if (ticks > histogram->max) {
+		histogram->max = ticks;
+	}
+}
+
+uint32_t
+ion_bench_percentile(
+	const ion_bench_histogram_t *histogram,
+	int							per_mille
+) {
+	uint64_t	want	= ((uint64_t) histogram->count * per_mille + 999) / 1000;
+	uint64_t	seen	= 0;
+	int			bucket;
+	int			shift;
+
+	for (bucket = 0; bucket < ION_BENCH_BUCKETS; bucket++) {
+		seen += histogram->counts[bucket];
+
+		if ((0 < seen) && (seen >= want)) {
+			break;
+		}
+	}
+
+	if (bucket < ION_BENCH_SUB_BUCKETS) {
+		return (uint32_t) bucket;
+	}
+
+	if (bucket >= ION_BENCH_BUCKETS) {
+		return histogram->max;
+	}
+
+	/* the last tick of the bucket, but no more than was seen */
+	shift = bucket / ION_BENCH_SUB_BUCKETS - 1;
+
+	uint64_t bound = ((uint64_t) (ION_BENCH_SUB_BUCKETS + bucket % ION_BENCH_SUB_BUCKETS + 1) << shift) - 1;
+
+	return (bound > histogram->max) ? histogram->max : (uint32_t) bound;
+}
+
+/**
+@brief		Fills the value stored under a key, so each value differs.
+*/
+static void
+ion_bench_value(
+	ion_byte_t			*value,
+	ion_value_size_t	size,
+	int32_t				key,
+	int					version
+) {
+	int i;
+
+	for (i = 0; i < size; i++) {
+		value[i] = (ion_byte_t) (key + version + i);
+	}
+}
+
+int
+ion_bench_scan(
+	ion_dictionary_t	*dict,
+	int32_t				key,
+	int					length,
+	ion_byte_t			*value
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int32_t				found;
+	int32_t				last	= key + length - 1;
+	int					read	= 0;
+
+	record.key		= &found;
+	record.value	= value;
+	dictionary_build_predicate(&predicate, predicate_range, &key, &last);
+
+	if (err_ok != dictionary_find(dict, &predicate, &cursor)) {
+		return -1;
+	}
+
+	while ((read < length) && (cs_cursor_active == cursor->next(cursor, &record))) {
+		read++;
+	}
+
+	cursor->destroy(&cursor);
+
+	return read;
+}
+
+ion_err_t
+ion_bench_run(
+	const ion_bench_engine_t	*engine,
+	const ion_bench_workload_t	*workload,
+	ion_dictionary_id_t			id,
+	ion_bench_result_t			*result
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_keygen_t				keys;
+	ion_byte_t					*value;
+	ion_err_t					err;
+	ion_status_t				status;
+	uint64_t					start;
+	uint64_t					began;
+	int32_t						key;
+	int32_t						next_key	= workload->record_count;
+	long						capacity	= workload->record_count + workload->operation_count * workload->insert_percent / 100 + 1;
+	long						op;
+	uint32_t					step;
+	int							i;
+	int							pick;
+
+	memset(result, 0, sizeof(*result));
+
+	if ((0 >= workload->record_count) || (NULL == (value = malloc(workload->value_size)))) {
+		return (0 >= workload->record_count) ? err_invalid_initial_size : err_out_of_memory;
+	}
+
+	engine->init(&handler);
+	err = dictionary_create(&handler, &dict, id, key_type_numeric_signed, sizeof(int32_t), workload->value_size, (0 != engine->dictionary_size) ? engine->dictionary_size : (ion_dictionary_size_t) (capacity * 2));
+
+	if (err_ok != err) {
+		free(value);
+		return err;
+	}
+
+	/* load in an order scattered over the keys, by a step prime to the count */
+	for (step = 7919; ((uint32_t) workload->record_count % step == 0) && (1 != workload->record_count); step += 2) {}
+
+	began = ion_bench_clock();
+
+	for (i = 0; i < workload->record_count; i++) {
+		key = (int32_t) (((uint64_t) i * step) % (uint32_t) workload->record_count);
+		ion_bench_value(value, workload->value_size, key, 0);
+		start	= ion_bench_clock();
+		status	= dictionary_insert(&dict, &key, value);
+		ion_bench_count(&result->load, (uint32_t) (ion_bench_clock() - start));
+
+		if (err_ok != status.error) {
+			result->failures++;
+		}
+	}
+
+	result->load_ticks = ion_bench_clock() - began;
+	dictionary_get_memory(&dict, &result->load_memory);
+	ion_alloc_reset_peak(dict.alloc_account);
+	ion_keygen_init(&keys, workload->distribution, (uint32_t) workload->record_count, workload->seed);
+	began = ion_bench_clock();
+
+	for (op = 0; op < workload->operation_count; op++) {
+		pick	= (int) (ion_keygen_random(&keys) % 100);
+		key		= (int32_t) ion_keygen_next(&keys);
+
+		if (pick < workload->read_percent) {
+			start	= ion_bench_clock();
+			status	= dictionary_get(&dict, &key, value);
+			ion_bench_count(&result->run, (uint32_t) (ion_bench_clock() - start));
+			result->reads++;
+		}
+		else if (pick < workload->read_percent + workload->update_percent) {
+			ion_bench_value(value, workload->value_size, key, (int) op);
+			start	= ion_bench_clock();
+			status	= dictionary_update(&dict, &key, value);
+			ion_bench_count(&result->run, (uint32_t) (ion_bench_clock() - start));
+			result->updates++;
+		}
+		else if (pick < workload->read_percent + workload->update_percent + workload->insert_percent) {
+			key = next_key++;
+			ion_bench_value(value, workload->value_size, key, 0);
+			start	= ion_bench_clock();
+			status	= dictionary_insert(&dict, &key, value);
+			ion_bench_count(&result->run, (uint32_t) (ion_bench_clock() - start));
+			result->inserts++;
+			ion_keygen_grow(&keys, (uint32_t) next_key);
+		}
+		else {
+			start		= ion_bench_clock();
+			i			= ion_bench_scan(&dict, key, workload->scan_length, value);
+			ion_bench_count(&result->run, (uint32_t) (ion_bench_clock() - start));
+			result->scans++;
+			result->scanned += (i < 0) ? 0 : i;
+			status		= (i < 0) ? ION_STATUS_ERROR(err_illegal_state) : ION_STATUS_OK(i);
+		}
+
+		if (err_ok != status.error) {
+			result->failures++;
+		}
+	}
+
+	result->run_ticks = ion_bench_clock() - began;
+	dictionary_get_memory(&dict, &result->run_memory);
+	dictionary_delete_dictionary(&dict);
+	free(value);
+
+	return err_ok;
+}
+
+/**
+@brief		Operations a second done in @p ticks.
+*/
+static double
+ion_bench_throughput(
+	long		operations,
+	uint64_t	ticks
+) {
+	return (0 == ticks) ? 0 : operations * (double) ION_BENCH_TICKS_PER_SECOND / ticks;
+}
+
+/**
+@brief		Ticks as microseconds.
+*/
+static double
+ion_bench_micros(
+	uint32_t ticks
+) {
+	return ticks * (1000000.0 / ION_BENCH_TICKS_PER_SECOND);
+}
+
+/**
+@brief		Prints a line for one phase of a run.
+*/
+static void
+ion_bench_print_phase(
+	const ion_bench_engine_t	*engine,
+	const ion_bench_workload_t	*workload,
+	const char					*phase,
+	const ion_bench_histogram_t *histogram,
+	uint64_t					ticks
+) {
+	printf("%-24s %-18s %-4s %8lu %12.0f %10.2f %10.2f %10.2f %10.2f\n", engine->name, workload->name, phase, (unsigned long) histogram->count, ion_bench_throughput(histogram->count, ticks), ion_bench_micros(ion_bench_percentile(histogram, 500)), ion_bench_micros(ion_bench_percentile(histogram, 990)), ion_bench_micros(ion_bench_percentile(histogram, 999)), ion_bench_micros(histogram->max));
+}
+
+void
+ion_bench_print_header(
+	void
+) {
+	printf("%-24s %-18s %-4s %8s %12s %10s %10s %10s %10s\n", "engine", "workload", "part", "ops", "ops/s", "p50 us", "p99 us", "p999 us", "max us");
+}
+
+void
+ion_bench_print(
+	const ion_bench_engine_t	*engine,
+	const ion_bench_workload_t	*workload,
+	const ion_bench_result_t	*result
+) {
+	const ion_alloc_usage_t *memory;
+
+	ion_bench_print_phase(engine, workload, "load", &result->load, result->load_ticks);
+
+	if (0 < result->run.count) {
+		ion_bench_print_phase(engine, workload, "run", &result->run, result->run_ticks);
+	}
+
+	memory = (0 < result->run.count) ? &result->run_memory : &result->load_memory;
+
+	if (0 < memory->total.allocations) {
+		printf("%-24s %-18s memory peak %lu load, %lu run, %lu held: %lu buffers, %lu nodes, %lu cursors, %lu other\n", engine->name, workload->name, (unsigned long) result->load_memory.total.peak, (unsigned long) result->run_memory.total.peak, (unsigned long) memory->total.current, (unsigned long) memory->kinds[ion_alloc_buffer].current, (unsigned long) memory->kinds[ion_alloc_node].current, (unsigned long) memory->kinds[ion_alloc_cursor].current, (unsigned long) memory->kinds[ion_alloc_other].current);
+	}
+
+	if (0 < result->scans) {
+		printf("%-24s %-18s scans read %ld records, %.1f each\n", engine->name, workload->name, result->scanned, (double) result->scanned / result->scans);
+	}
+
+	if (0 < result->failures) {
+		printf("%-24s %-18s %ld operations failed\n", engine->name, workload->name, result->failures);
+	}
+}
+
+int
+ion_bench_run_all(
+	const char	*engine,
+	const char	*workload,
+	int			record_count,
+	long		operation_count
+) {
+	ion_bench_result_t		result;
+	ion_bench_workload_t	run;
+	ion_err_t				err;
+	int						e;
+	int						w;
+	int						failed	= 0;
+	ion_dictionary_id_t		id		= 1;
+
+	ion_bench_print_header();
+
+	for (e = 0; e < ion_bench_engine_count; e++) {
+		if ((NULL != engine) && (0 != strcmp(engine, ion_bench_engines[e].name))) {
+			continue;
+		}
+
+		for (w = 0; w < ion_bench_workload_count; w++) {
+			if ((NULL != workload) && (0 != strcmp(workload, ion_bench_workloads[w].name))) {
+				continue;
+			}
+
+			run = ion_bench_workloads[w];
+
+			if (0 < record_count) {
+				run.record_count = record_count;
+			}
+
+			if ((0 < operation_count) && (0 < run.operation_count)) {
+				run.operation_count = (0 < run.scan_percent) ? operation_count / 10 : operation_count;
+			}
+
+			err = ion_bench_run(&ion_bench_engines[e], &run, id++, &result);
+
+			if (err_ok != err) {
+				printf("%-24s %-18s could not run, error %d\n", ion_bench_engines[e].name, run.name, (int) err);
+				failed++;
+				continue;
+			}
+
+			ion_bench_print(&ion_bench_engines[e], &run, &result);
+		}
+	}
+
+	return failed;
+}
@@ -0,0 +1,256 @@
+/******************************************************************************/
+/**
+@file		ion_benchmark.h
+@brief		A portable benchmark of the dictionary engines under YCSB-style
+			workloads.
+@details	A run creates a dictionary, loads @c record_count records into
+			it, then serves @c operation_count operations mixed in the
+			proportions of its workload, with keys picked by the generators
+			of @ref keygen.h. Throughput and latency percentiles are kept for
+			the load and for the mix. Hosts time operations in nanoseconds
+			with @c clock_gettime, Arduino in microseconds with @c micros.
+*/
+/******************************************************************************/
+
+#if !defined(ION_BENCHMARK_H_)
+#define ION_BENCHMARK_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../key_value/kv_system.h"
+#include "../dictionary/dictionary_types.h"
+#include "../dictionary/dictionary.h"
+#include "../util/keygen/keygen.h"
+
+/**
+@brief		How many linear buckets each power of two of latency is split
+			into, which bounds the error of a percentile to 1 in this many.
+*/
+#if !defined(ION_BENCH_SUB_BUCKETS_LOG)
+#if defined(ARDUINO)
+#define ION_BENCH_SUB_BUCKETS_LOG 2
+#else
+#define ION_BENCH_SUB_BUCKETS_LOG 4
+#endif
+#endif
+
+#define ION_BENCH_SUB_BUCKETS	(1 << ION_BENCH_SUB_BUCKETS_LOG)
+#define ION_BENCH_BUCKETS		((32 - ION_BENCH_SUB_BUCKETS_LOG + 1) * ION_BENCH_SUB_BUCKETS)
+
+/**
+@brief		How many clock ticks a second has: nanoseconds on hosts,
+			microseconds on Arduino.
+*/
+#if defined(ARDUINO)
+#define ION_BENCH_TICKS_PER_SECOND 1000000UL
+#else
+#define ION_BENCH_TICKS_PER_SECOND 1000000000UL
+#endif
+
+/**
+@brief		A workload: what is loaded, and what mix of operations is run
+			against it. The percentages should add up to 100.
+*/
+typedef struct {
+	const char					*name;			/**< Shown in reports. */
+	int							record_count;	/**< Records loaded. */
+	long						operation_count;/**< Operations run after the
+													 load, 0 for a load
+													 alone. */
+	unsigned char				read_percent;	/**< Gets of loaded keys. */
+	unsigned char				update_percent;	/**< Updates of loaded keys. */
+	unsigned char				insert_percent;	/**< Inserts of new keys. */
+	unsigned char				scan_percent;	/**< Range scans starting at
+													 a loaded key. */
+	int							scan_length;	/**< Records a scan reads. */
+	ion_keygen_distribution_t	distribution;	/**< How keys are picked. */
+	ion_value_size_t			value_size;		/**< Bytes of each value. */
+	uint32_t					seed;			/**< Seeds the key choice. */
+} ion_bench_workload_t;
+
+/**
+@brief		An engine to benchmark.
+*/
+typedef struct {
+	const char				*name;			/**< Shown in reports. */
+	void (*init)(
+		ion_dictionary_handler_t *
+	);										/**< Its handler's init. */
+	ion_dictionary_size_t	dictionary_size;/**< Its dictionary size, or 0
+												 to size it for the records
+												 a workload can hold. */
+} ion_bench_engine_t;
+
+/**
+@brief		Latencies of a phase, counted in buckets a power of two wide
+			split linearly in @ref ION_BENCH_SUB_BUCKETS.
+*/
+typedef struct {
+	uint32_t	counts[ION_BENCH_BUCKETS];	/**< Operations per bucket. */
+	uint32_t	count;						/**< Operations counted. */
+	uint32_t	max;						/**< The slowest, in ticks. */
+	uint64_t	total;						/**< All of them, in ticks. */
+} ion_bench_histogram_t;
+
+/**
+@brief		What a run measured.
+*/
+typedef struct {
+	ion_bench_histogram_t	load;		/**< Each insert of the load. */
+	ion_bench_histogram_t	run;		/**< Each operation of the mix. */
+	uint64_t				load_ticks;	/**< The load end to end. */
+	uint64_t				run_ticks;	/**< The mix end to end. */
+	long					reads;		/**< Of the mix, the gets, */
+	long					updates;	/**< updates, */
+	long					inserts;	/**< inserts */
+	long					scans;		/**< and scans. */
+	long					scanned;	/**< Records the scans read. */
+	long					failures;	/**< Operations that did not
+											 succeed, loads included. */
+	ion_alloc_usage_t		load_memory;/**< The dictionary's memory
+											 after the load, its peaks
+											 those of the load. */
+	ion_alloc_usage_t		run_memory;	/**< After the mix, its peaks
+											 those of the mix. */
+} ion_bench_result_t;
+
+/**
+@brief		The engines covered by default.
+*/
+extern const ion_bench_engine_t ion_bench_engines[];
+
+/**
+@brief		The number of @ref ion_bench_engines.
+*/
+extern const int ion_bench_engine_count;
+
+/**
+@brief		The standard workloads, at the default sizes for the target.
+*/
+extern const ion_bench_workload_t ion_bench_workloads[];
+
+/**
+@brief		The number of @ref ion_bench_workloads.
+*/
+extern const int ion_bench_workload_count;
+
+/**
+@brief		Ticks of a monotonic clock, see @ref ION_BENCH_TICKS_PER_SECOND.
+*/
+uint64_t
+ion_bench_clock(
+	void
+);
+
+/**
+@brief		Reads up to @p length records from @p key on, as a scan of a
+			workload does.
+@param		dict
+				The dictionary to scan.
+@param		key
+				The first key of the range.
+@param		length
+				The keys the range spans.
+@param		value
+				Room for a value.
+@return		The number of records read, or -1 if the scan failed.
+*/
+int
+ion_bench_scan(
+	ion_dictionary_t	*dict,
+	int32_t				key,
+	int					length,
+	ion_byte_t			*value
+);
+
+/**
+@brief		Runs a workload against a fresh dictionary of an engine, which
+			is deleted after.
+@param		engine
+				The engine to run it against.
+@param		workload
+				What to run.
+@param		id
+				The dictionary id to create it with.
+@param		result
+				Receives what was measured.
+@return		@ref err_ok once the run is done, or why it could not start.
+*/
+ion_err_t
+ion_bench_run(
+	const ion_bench_engine_t	*engine,
+	const ion_bench_workload_t	*workload,
+	ion_dictionary_id_t			id,
+	ion_bench_result_t			*result
+);
+
+/**
+@brief		The latency under which a share of a phase's operations fell.
+@param		histogram
+				The latencies of the phase.
+@param		per_mille
+				The share, in thousandths: 500 for the median, 999 for
+				the 99.9th percentile.
+@return		The bound, in ticks, to within a bucket.
+*/
+uint32_t
+ion_bench_percentile(
+	const ion_bench_histogram_t *histogram,
+	int							per_mille
+);
+
+/**
+@brief		Runs and prints the standard workloads against the engines, each
+			run on a dictionary of its own.
+@param		engine
+				The name of the one engine to run, or @c NULL for all.
+@param		workload
+				The name of the one workload to run, or @c NULL for all.
+@param		record_count
+				Records to load in place of the workloads' own, or 0.
+@param		operation_count
+				Operations to run in place of the workloads' own, or 0.
+				Scan workloads run a tenth as many.
+@return		The number of runs that could not start.
+*/
+int
+ion_bench_run_all(
+	const char	*engine,
+	const char	*workload,
+	int			record_count,
+	long		operation_count
+);
+
+/**
+@brief		Prints a header naming the columns @ref ion_bench_print prints.
+*/
+void
+ion_bench_print_header(
+	void
+);
+
+/**
+@brief		Prints a run's throughput and its p50, p99 and p999 latencies
+			in microseconds, a line for the load and one for the mix, and
+			the bytes its dictionary held at its peak and at the end.
+@param		engine
+				The engine that was run.
+@param		workload
+				The workload that was run.
+@param		result
+				What was measured.
+*/
+void
+ion_bench_print(
+	const ion_bench_engine_t	*engine,
+	const ion_bench_workload_t	*workload,
+	const ion_bench_result_t	*result
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_BENCHMARK_H_ */
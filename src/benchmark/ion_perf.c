@@ -0,0 +1,395 @@
+/******************************************************************************/
+/**
+@file		ion_perf.c
+@brief		A performance regression suite of the dictionary engines, see
+			@ref ion_perf.h.
+*/
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "ion_perf.h"
+#include "../dictionary/art/art_dictionary_handler.h"
+#include "../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../dictionary/cuckoo_hash/cuckoo_hash_dictionary_handler.h"
+#include "../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../dictionary/linear_hash/linear_hash_dictionary_handler.h"
+#include "../dictionary/lsm/lsm_dictionary_handler.h"
+#include "../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+#include "../dictionary/open_address_hash/open_address_hash_dictionary_handler.h"
+#include "../dictionary/skip_list/concurrent_skip_list_handler.h"
+#include "../dictionary/skip_list/skip_list_handler.h"
+#include "../dictionary/skip_list/unrolled_skip_list_handler.h"
+#include "../dictionary/sorted_array/sorted_array_dictionary_handler.h"
+#include "../dictionary/time_series/time_series_dictionary_handler.h"
+
+const char *const ion_perf_case_names[ion_perf_case_count] = {
+	"insert", "get_hit", "get_miss", "range_scan", "open_close", "delete", "bulk_load"
+};
+
+/* the LSM tree's memtable is kept small, so the cases read its runs, and the time series keeps its own block size */
+const ion_perf_engine_t ion_perf_engines[] = {
+	{ { "bpptree", bpptree_init, 0 }, 0 },
+	{ { "flat_file", ffdict_init, 30 }, 0 },
+	{ { "open_address_hash", oadict_init, 0 }, 0 },
+	{ { "open_address_file_hash", oafdict_init, 0 }, 0 },
+	{ { "skip_list", sldict_init, 10 }, 0 },
+	{ { "unrolled_skip_list", usldict_init, 10 }, 0 },
+	{ { "concurrent_skip_list", csldict_init, 10 }, 0 },
+	{ { "lsm", lsmdict_init, 256 }, 0 },
+	{ { "art", artdict_init, 0 }, 0 },
+	{ { "sorted_array", sadict_init, 0 }, ION_PERF_IN_ORDER | ION_PERF_NO_DELETE },
+	{ { "linear_hash", lhdict_init, 0 }, 0 },
+	{ { "cuckoo_hash", ckhdict_init, 0 }, 0 },
+	{ { "time_series", tsdict_init, (ion_dictionary_size_t) -1 }, ION_PERF_IN_ORDER | ION_PERF_NO_DELETE },
+};
+
+const int ion_perf_engine_count = sizeof(ion_perf_engines) / sizeof(ion_perf_engines[0]);
+
+/**
+@brief		A step prime to the records, visiting every key once when
+			walked modulo their count, in an order scattered over them.
+*/
+static uint32_t
+ion_perf_step(
+	int records
+) {
+	uint32_t step;
+
+	for (step = 7919; ((uint32_t) records % step == 0) && (1 != records); step += 2) {}
+
+	return step;
+}
+
+/**
+@brief		The key visited @p i-th by a walk of @ref ion_perf_step.
+*/
+static int32_t
+ion_perf_scatter(
+	int			i,
+	int			records,
+	uint32_t	step
+) {
+	return (int32_t) (((uint64_t) i * step) % (uint32_t) records);
+}
+
+/**
+@brief		Keeps a run of a case if it is the fastest yet, and counts its
+			failures.
+*/
+static void
+ion_perf_keep(
+	ion_perf_result_t	*result,
+	long				operations,
+	uint64_t			ticks,
+	long				failures
+) {
+	double ns_per_op = (0 == operations) ? 0 : ticks * (1000000000.0 / ION_BENCH_TICKS_PER_SECOND) / operations;
+
+	if ((0 == result->operations) || (ns_per_op < result->ns_per_op)) {
+		result->ns_per_op = ns_per_op;
+	}
+
+	result->operations	= operations;
+	result->failures	+= failures;
+}
+
+/**
+@brief		Runs every case once, on a dictionary loaded by the first case
+			and one bulk loaded by the last.
+*/
+static ion_err_t
+ion_perf_run_once(
+	const ion_perf_engine_t		*engine,
+	int							records,
+	ion_dictionary_id_t			id,
+	ion_perf_result_t			*results
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dict;
+	ion_dictionary_config_info_t	config;
+	ion_byte_t						value[ION_PERF_VALUE_SIZE];
+	ion_dictionary_size_t			size	= (0 != engine->engine.dictionary_size) ? engine->engine.dictionary_size : (ion_dictionary_size_t) (records * 2);
+	uint32_t						step	= ion_perf_step(records);
+	int								scans	= (records < ION_PERF_SCAN_LENGTH) ? 1 : records / ION_PERF_SCAN_LENGTH;
+	int32_t							*keys;
+	ion_byte_t						*values;
+	ion_status_t					status;
+	ion_err_t						err;
+	uint64_t						began;
+	long							failures;
+	int32_t							key;
+	int								batch;
+	int								i;
+
+	engine->engine.init(&handler);
+	err = dictionary_create(&handler, &dict, id, key_type_numeric_signed, sizeof(int32_t), ION_PERF_VALUE_SIZE, size);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	failures	= 0;
+	began		= ion_bench_clock();
+
+	for (i = 0; i < records; i++) {
+		key = (engine->flags & ION_PERF_IN_ORDER) ? i : ion_perf_scatter(i, records, step);
+		memset(value, (ion_byte_t) key, ION_PERF_VALUE_SIZE);
+		failures += (err_ok != dictionary_insert(&dict, &key, value).error);
+	}
+
+	ion_perf_keep(&results[ion_perf_insert], records, ion_bench_clock() - began, failures);
+
+	failures	= 0;
+	began		= ion_bench_clock();
+
+	for (i = 0; i < records; i++) {
+		key			= ion_perf_scatter(i, records, step);
+		failures	+= (err_ok != dictionary_get(&dict, &key, value).error);
+	}
+
+	ion_perf_keep(&results[ion_perf_get_hit], records, ion_bench_clock() - began, failures);
+
+	failures	= 0;
+	began		= ion_bench_clock();
+
+	for (i = 0; i < records; i++) {
+		key			= records + ion_perf_scatter(i, records, step);
+		failures	+= (err_item_not_found != dictionary_get(&dict, &key, value).error);
+	}
+
+	ion_perf_keep(&results[ion_perf_get_miss], records, ion_bench_clock() - began, failures);
+
+	failures	= 0;
+	began		= ion_bench_clock();
+
+	for (i = 0; i < scans; i++) {
+		failures += (0 > ion_bench_scan(&dict, ion_perf_scatter(i, records, step), ION_PERF_SCAN_LENGTH, value));
+	}
+
+	ion_perf_keep(&results[ion_perf_range_scan], scans, ion_bench_clock() - began, failures);
+
+	memset(&config, 0, sizeof(config));
+	config.id				= id;
+	config.type				= key_type_numeric_signed;
+	config.key_size			= sizeof(int32_t);
+	config.value_size		= ION_PERF_VALUE_SIZE;
+	config.dictionary_size	= size;
+	began					= ion_bench_clock();
+
+	for (i = 0; i < ION_PERF_REOPENS; i++) {
+		if ((err_ok != (err = dictionary_close(&dict))) || (err_ok != (err = dictionary_open(&handler, &dict, &config)))) {
+			/* the dictionary may be neither open nor closed, so nothing more is run on it */
+			return err;
+		}
+	}
+
+	ion_perf_keep(&results[ion_perf_open_close], ION_PERF_REOPENS, ion_bench_clock() - began, 0);
+
+	if (!(engine->flags & ION_PERF_NO_DELETE)) {
+		failures	= 0;
+		began		= ion_bench_clock();
+
+		for (i = 0; i < records; i++) {
+			key			= ion_perf_scatter(i, records, step);
+			failures	+= (err_ok != dictionary_delete(&dict, &key).error);
+		}
+
+		ion_perf_keep(&results[ion_perf_delete], records, ion_bench_clock() - began, failures);
+	}
+
+	dictionary_delete_dictionary(&dict);
+
+	keys	= malloc(records * sizeof(int32_t));
+	values	= malloc((size_t) records * ION_PERF_VALUE_SIZE);
+
+	if ((NULL == keys) || (NULL == values)) {
+		free(keys);
+		free(values);
+		return err_out_of_memory;
+	}
+
+	for (i = 0; i < records; i++) {
+		keys[i] = i;
+		memset(values + (size_t) i * ION_PERF_VALUE_SIZE, (ion_byte_t) i, ION_PERF_VALUE_SIZE);
+	}
+
+	err = dictionary_create(&handler, &dict, id, key_type_numeric_signed, sizeof(int32_t), ION_PERF_VALUE_SIZE, size);
+
+	if (err_ok == err) {
+		failures	= 0;
+		began		= ion_bench_clock();
+
+		for (i = 0; i < records; i += batch) {
+			batch		= (records - i < ION_PERF_BATCH) ? records - i : ION_PERF_BATCH;
+			status		= dictionary_insert_many(&dict, keys + i, values + (size_t) i * ION_PERF_VALUE_SIZE, NULL, batch);
+			failures	+= batch - status.count;
+		}
+
+		ion_perf_keep(&results[ion_perf_bulk_load], records, ion_bench_clock() - began, failures);
+		dictionary_delete_dictionary(&dict);
+	}
+
+	free(keys);
+	free(values);
+
+	return err;
+}
+
+void
+ion_perf_reset(
+	const ion_perf_engine_t *engine,
+	ion_perf_result_t		*results
+) {
+	int i;
+
+	memset(results, 0, ion_perf_case_count * sizeof(ion_perf_result_t));
+
+	for (i = 0; i < ion_perf_case_count; i++) {
+		strncpy(results[i].engine, engine->engine.name, ION_PERF_NAME_SIZE - 1);
+		strncpy(results[i].benchmark, ion_perf_case_names[i], ION_PERF_NAME_SIZE - 1);
+		results[i].tolerance = (ion_perf_open_close == i) ? ION_PERF_REOPEN_TOLERANCE : ION_PERF_TOLERANCE;
+	}
+}
+
+ion_err_t
+ion_perf_run_engine(
+	const ion_perf_engine_t *engine,
+	int						records,
+	ion_dictionary_id_t		id,
+	ion_perf_result_t		*results
+) {
+	if (0 >= records) {
+		return err_invalid_initial_size;
+	}
+
+	return ion_perf_run_once(engine, records, id, results);
+}
+
+void
+ion_perf_write(
+	FILE					*file,
+	const char				*host,
+	const ion_perf_result_t *results,
+	int						count
+) {
+	int i;
+
+	if (NULL != host) {
+		fprintf(file, "# host=%s\n", host);
+	}
+
+	fprintf(file, "engine,benchmark,operations,ns_per_op,failures,tolerance\n");
+
+	for (i = 0; i < count; i++) {
+		if (0 == results[i].operations) {
+			continue;
+		}
+
+		fprintf(file, "%s,%s,%ld,%.1f,%ld,%d\n", results[i].engine, results[i].benchmark, results[i].operations, results[i].ns_per_op, results[i].failures, results[i].tolerance);
+	}
+}
+
+int
+ion_perf_read(
+	FILE				*file,
+	char				*host,
+	ion_perf_result_t	*results,
+	int					max
+) {
+	char	line[256];
+	int		count = 0;
+
+	if (NULL != host) {
+		host[0] = '\0';
+	}
+
+	while ((count < max) && (NULL != fgets(line, sizeof(line), file))) {
+		if ((NULL != host) && (0 == strncmp("# host=", line, 7))) {
+			strncpy(host, line + 7, ION_PERF_HOST_SIZE - 1);
+			host[ION_PERF_HOST_SIZE - 1]	= '\0';
+			host[strcspn(host, "\r\n")]	= '\0';
+		}
+
+		/* the header, comments and blank lines */
+		if ((0 == strncmp("engine,", line, 7)) || ('#' == line[0]) || ('\n' == line[0]) || ('\r' == line[0])) {
+			continue;
+		}
+
+		if (6 != sscanf(line, "%31[^,],%31[^,],%ld,%lf,%ld,%d", results[count].engine, results[count].benchmark, &results[count].operations, &results[count].ns_per_op, &results[count].failures, &results[count].tolerance)) {
+			return -1;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+const ion_perf_result_t *
+ion_perf_find(
+	const ion_perf_result_t *results,
+	int						count,
+	const char				*engine,
+	const char				*benchmark
+) {
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if ((0 == strcmp(engine, results[i].engine)) && (0 == strcmp(benchmark, results[i].benchmark))) {
+			return &results[i];
+		}
+	}
+
+	return NULL;
+}
+
+int
+ion_perf_compare(
+	const ion_perf_result_t *results,
+	int						count,
+	const ion_perf_result_t *baseline,
+	int						baseline_count,
+	int						tolerance,
+	ion_boolean_t			timed,
+	FILE					*report
+) {
+	const ion_perf_result_t *base;
+	const char				*verdict;
+	double					limit;
+	double					noise;
+	int						failed = 0;
+	int						i;
+
+	for (i = 0; i < count; i++) {
+		if (0 == results[i].operations) {
+			fprintf(report, "%-24s %-12s %12s    %12s    not run\n", results[i].engine, results[i].benchmark, "", "");
+			continue;
+		}
+
+		base = ion_perf_find(baseline, baseline_count, results[i].engine, results[i].benchmark);
+
+		if (NULL == base) {
+			fprintf(report, "%-24s %-12s %12.1f ns %12s    not in baseline\n", results[i].engine, results[i].benchmark, results[i].ns_per_op, "");
+			continue;
+		}
+
+		limit	= base->ns_per_op * (100 + ((0 > tolerance) ? base->tolerance : tolerance)) / 100;
+		noise	= (0 == strcmp(ion_perf_case_names[ion_perf_open_close], results[i].benchmark)) ? ION_PERF_REOPEN_NOISE_NS : ION_PERF_NOISE_NS;
+		verdict = "ok";
+
+		if (0 < results[i].failures) {
+			verdict = "FAILED";
+			failed++;
+		}
+		else if ((results[i].ns_per_op > limit) && (results[i].ns_per_op - base->ns_per_op > noise)) {
+			/* another host's timings say nothing of a change to the code */
+			verdict = timed ? "REGRESSED" : "slower";
+			failed	+= timed;
+		}
+
+		fprintf(report, "%-24s %-12s %12.1f ns %12.1f ns %+7.1f%% %s\n", results[i].engine, results[i].benchmark, results[i].ns_per_op, base->ns_per_op, (0 == base->ns_per_op) ? 0 : (results[i].ns_per_op / base->ns_per_op - 1) * 100, verdict);
+	}
+
+	return failed;
+}
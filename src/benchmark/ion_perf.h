@@ -0,0 +1,317 @@
+/******************************************************************************/
+/**
+@file		ion_perf.h
+@brief		A performance regression suite: a fixed set of microbenchmarks
+			run against each engine and compared with stored timings.
+@details	Each engine is timed inserting, getting keys it holds and keys
+			it does not, scanning ranges, closing and reopening, deleting,
+			and bulk loading through @ref dictionary_insert_many. A case is
+			run several times and its fastest run kept, which is the
+			steadiest figure a shared machine gives. Results are written as
+			CSV lines of <tt>engine,benchmark,operations,ns_per_op,failures,
+			tolerance</tt> after a <tt># host=</tt> comment naming the host,
+			the same form a baseline is read in, so the results of one run
+			are the baseline of the next.
+
+			A case regresses when it is slower than its baseline by more
+			than its tolerance, a percentage, and by more than
+			@ref ION_PERF_NOISE_NS. Timings depend on the machine, so a
+			baseline records the host it was taken on, and the timings of
+			another host are only reported against it. Host only.
+*/
+/******************************************************************************/
+
+#if !defined(ION_PERF_H_)
+#define ION_PERF_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "ion_benchmark.h"
+
+/**
+@brief		The records each case runs over, by default.
+*/
+#if !defined(ION_PERF_RECORDS)
+#define ION_PERF_RECORDS 2000
+#endif
+
+/**
+@brief		How many times each case is run, by default, the fastest kept.
+*/
+#if !defined(ION_PERF_REPEATS)
+#define ION_PERF_REPEATS 9
+#endif
+
+/**
+@brief		The tolerance of cases, as a percentage, that a baseline does
+			not give its own.
+*/
+#if !defined(ION_PERF_TOLERANCE)
+#define ION_PERF_TOLERANCE 30
+#endif
+
+/**
+@brief		Nanoseconds an operation may slow down by without regressing,
+			whatever its tolerance, so the quickest cases are not failed by
+			the jitter of the clock.
+*/
+#if !defined(ION_PERF_NOISE_NS)
+#define ION_PERF_NOISE_NS 50
+#endif
+
+/**
+@brief		The tolerance of closing and reopening, as a percentage, by
+			default. It opens and syncs files, and varies with the file
+			system far more than the cases in memory do.
+*/
+#if !defined(ION_PERF_REOPEN_TOLERANCE)
+#define ION_PERF_REOPEN_TOLERANCE 200
+#endif
+
+/**
+@brief		Nanoseconds a close and reopen may slow down by without
+			regressing, whatever its tolerance.
+*/
+#if !defined(ION_PERF_REOPEN_NOISE_NS)
+#define ION_PERF_REOPEN_NOISE_NS 250000
+#endif
+
+/**
+@brief		The records a range scan reads.
+*/
+#if !defined(ION_PERF_SCAN_LENGTH)
+#define ION_PERF_SCAN_LENGTH 50
+#endif
+
+/**
+@brief		The times a dictionary is closed and reopened.
+*/
+#if !defined(ION_PERF_REOPENS)
+#define ION_PERF_REOPENS 10
+#endif
+
+/**
+@brief		The records given to each @ref dictionary_insert_many of a bulk
+			load.
+*/
+#if !defined(ION_PERF_BATCH)
+#define ION_PERF_BATCH 64
+#endif
+
+/**
+@brief		The bytes of each value.
+*/
+#if !defined(ION_PERF_VALUE_SIZE)
+#define ION_PERF_VALUE_SIZE 16
+#endif
+
+/**
+@brief		Room for a name of an engine or a case, its terminator included.
+*/
+#define ION_PERF_NAME_SIZE 32
+
+/**
+@brief		Room for the name of a host, its terminator included.
+*/
+#define ION_PERF_HOST_SIZE 64
+
+/**
+@brief		An engine whose keys are appended in order, whose inserts are
+			made in order too.
+*/
+#define ION_PERF_IN_ORDER	0x01
+
+/**
+@brief		An engine that does not delete, whose deletes are not run.
+*/
+#define ION_PERF_NO_DELETE	0x02
+
+/**
+@brief		The cases run against each engine.
+*/
+typedef enum ION_PERF_CASE {
+	ion_perf_insert,		/**< Inserts, in an order scattered over keys. */
+	ion_perf_get_hit,		/**< Gets of keys held. */
+	ion_perf_get_miss,		/**< Gets of keys not held. */
+	ion_perf_range_scan,	/**< Scans of @ref ION_PERF_SCAN_LENGTH keys. */
+	ion_perf_open_close,	/**< Closes and reopens of the dictionary. */
+	ion_perf_delete,		/**< Deletes of every key. */
+	ion_perf_bulk_load,		/**< Batched inserts of keys in order. */
+	ion_perf_case_count		/**< The number of cases. */
+} ion_perf_case_t;
+
+/**
+@brief		The names of the cases, by @ref ion_perf_case_t.
+*/
+extern const char *const ion_perf_case_names[ion_perf_case_count];
+
+/**
+@brief		An engine the suite runs.
+*/
+typedef struct {
+	ion_bench_engine_t	engine;	/**< The engine. */
+	unsigned char		flags;	/**< @ref ION_PERF_IN_ORDER and
+									 @ref ION_PERF_NO_DELETE, as they
+									 apply. */
+} ion_perf_engine_t;
+
+/**
+@brief		The engines the suite runs, every one the host builds.
+*/
+extern const ion_perf_engine_t ion_perf_engines[];
+
+/**
+@brief		The number of @ref ion_perf_engines.
+*/
+extern const int ion_perf_engine_count;
+
+/**
+@brief		The timing of one case of one engine, measured or read from a
+			baseline.
+*/
+typedef struct {
+	char	engine[ION_PERF_NAME_SIZE];		/**< The engine. */
+	char	benchmark[ION_PERF_NAME_SIZE];	/**< The case. */
+	long	operations;						/**< Operations timed, 0 for
+												 a case not run. */
+	double	ns_per_op;						/**< Nanoseconds for each, of
+												 the fastest run. */
+	long	failures;						/**< Operations that did not
+												 succeed, in every run. */
+	int		tolerance;						/**< The percentage it may
+												 slow down by. */
+} ion_perf_result_t;
+
+/**
+@brief		Readies the results of an engine for its runs.
+@param		engine
+				The engine.
+@param		results
+				Receives @ref ion_perf_case_count results, by case, with no
+				runs.
+*/
+void
+ion_perf_reset(
+	const ion_perf_engine_t *engine,
+	ion_perf_result_t		*results
+);
+
+/**
+@brief		Runs every case an engine supports against it once, keeping
+			the fastest timing of each since @ref ion_perf_reset.
+@details	Taking one run of every engine in turn, rather than every run
+			of one engine, shares a slow spell of the machine out between
+			them instead of it spoiling each run of the same cases.
+@param		engine
+				The engine.
+@param		records
+				The records each case runs over.
+@param		id
+				The id of the dictionaries it creates, deleted after.
+@param		results
+				The @ref ion_perf_case_count results of the engine, by case.
+@return		@c err_ok once every case ran, or why one could not.
+*/
+ion_err_t
+ion_perf_run_engine(
+	const ion_perf_engine_t *engine,
+	int						records,
+	ion_dictionary_id_t		id,
+	ion_perf_result_t		*results
+);
+
+/**
+@brief		Writes the results of cases that ran as CSV, after a comment
+			naming the host and a header line.
+@param		file
+				The file to write.
+@param		host
+				The host they were measured on, or @c NULL to leave it out.
+@param		results
+				The results.
+@param		count
+				The number of @p results.
+*/
+void
+ion_perf_write(
+	FILE					*file,
+	const char				*host,
+	const ion_perf_result_t *results,
+	int						count
+);
+
+/**
+@brief		Reads results written by @ref ion_perf_write.
+@param		file
+				The file to read.
+@param		host
+				Receives the host they were measured on, of at most
+				@ref ION_PERF_HOST_SIZE bytes, or an empty string if the
+				file does not name one. May be @c NULL.
+@param		results
+				Receives them.
+@param		max
+				The room in @p results.
+@return		The number read, or -1 if a line is not a result.
+*/
+int
+ion_perf_read(
+	FILE				*file,
+	char				*host,
+	ion_perf_result_t	*results,
+	int					max
+);
+
+/**
+@brief		Finds the result of a case of an engine.
+@return		The result, or @c NULL if there is none.
+*/
+const ion_perf_result_t *
+ion_perf_find(
+	const ion_perf_result_t *results,
+	int						count,
+	const char				*engine,
+	const char				*benchmark
+);
+
+/**
+@brief		Compares results with a baseline, printing a line for each.
+@param		results
+				What was measured.
+@param		count
+				The number of @p results.
+@param		baseline
+				The timings they are held to.
+@param		baseline_count
+				The number of @p baseline.
+@param		tolerance
+				The percentage every case may slow down by, or -1 to use
+				the tolerance of each case of the baseline.
+@param		timed
+				Whether cases that regressed count, as they should only
+				where the baseline was taken. If not, they are reported as
+				slower and only failures count.
+@param		report
+				Where the comparison is printed.
+@return		The number of cases that regressed or had failures. Cases not
+			in the baseline, or not run, are noted but do not count.
+*/
+int
+ion_perf_compare(
+	const ion_perf_result_t *results,
+	int						count,
+	const ion_perf_result_t *baseline,
+	int						baseline_count,
+	int						tolerance,
+	ion_boolean_t			timed,
+	FILE					*report
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_PERF_H_ */
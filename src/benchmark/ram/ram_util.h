@@ -1,15 +0,0 @@
-/******************************************************************************/
-/**
-@file
-@author		Kris Wallperington
-@brief		Utility function to check how many bytes of available RAM remains.
-*/
-/******************************************************************************/
-#if !defined(RAMUTIL_H_)
-#define RAMUTIL_H_
-
-int
-free_ram(
-);
-
-#endif /* RAMUTIL_H_ */
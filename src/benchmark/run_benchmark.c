@@ -0,0 +1,50 @@
+/******************************************************************************/
+/**
+@file		run_benchmark.c
+@brief		Runs the dictionary benchmark on a host.
+@details	Usage: <tt>ion_benchmark [-e engine] [-w workload] [-n records]
+			[-o operations]</tt>, every engine and workload by default.
+*/
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ion_benchmark.h"
+
+int
+main(
+	int		argc,
+	char	**argv
+) {
+	const char	*engine		= NULL;
+	const char	*workload	= NULL;
+	int			records		= 0;
+	long		operations	= 0;
+	int			i;
+
+	for (i = 1; i + 1 < argc; i += 2) {
+		if (0 == strcmp("-e", argv[i])) {
+			engine = argv[i + 1];
+		}
+		else if (0 == strcmp("-w", argv[i])) {
+			workload = argv[i + 1];
+		}
+		else if (0 == strcmp("-n", argv[i])) {
+			records = atoi(argv[i + 1]);
+		}
+		else if (0 == strcmp("-o", argv[i])) {
+			operations = atol(argv[i + 1]);
+		}
+		else {
+			break;
+		}
+	}
+
+	if (i < argc) {
+		fprintf(stderr, "usage: %s [-e engine] [-w workload] [-n records] [-o operations]\n", argv[0]);
+		return 2;
+	}
+
+	return (0 == ion_bench_run_all(engine, workload, records, operations)) ? 0 : 1;
+}
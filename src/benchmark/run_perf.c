@@ -0,0 +1,194 @@
+/******************************************************************************/
+/**
+@file		run_perf.c
+@brief		Runs the performance regression suite on a host.
+@details	Usage: <tt>ion_perf [-e engine] [-n records] [-r repeats]
+			[-b baseline.csv] [-t tolerance] [-s 0|1] [-o results.csv]</tt>.
+			The results are written as CSV to @c -o, or to standard output,
+			and compared with the baseline given, if any, on standard
+			error. Exits 1 if an engine could not run, or a case failed or,
+			when the baseline was taken on this host or @c -s is 1,
+			regressed. @c -s 0 never fails a case for its timing.
+*/
+/******************************************************************************/
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ion_perf.h"
+
+/**
+@brief		The most results a baseline is read with.
+*/
+#define ION_PERF_MAX_BASELINE 256
+
+int
+main(
+	int		argc,
+	char	**argv
+) {
+	static ion_perf_result_t	baseline[ION_PERF_MAX_BASELINE];
+	char						host[ION_PERF_HOST_SIZE];
+	char						baseline_host[ION_PERF_HOST_SIZE];
+	ion_perf_result_t			*results;
+	int							*chosen;
+	const ion_perf_result_t		*base;
+	const char					*engine			= NULL;
+	const char					*baseline_path	= NULL;
+	const char					*output_path	= NULL;
+	FILE						*file;
+	ion_err_t					err;
+	int							records			= ION_PERF_RECORDS;
+	int							repeats			= ION_PERF_REPEATS;
+	int							tolerance		= -1;
+	int							strict			= -1;
+	int							baseline_count	= 0;
+	int							engines			= 0;
+	int							count			= 0;
+	int							failed			= 0;
+	int							e;
+	int							r;
+	int							i;
+
+	for (i = 1; i + 1 < argc; i += 2) {
+		if (0 == strcmp("-e", argv[i])) {
+			engine = argv[i + 1];
+		}
+		else if (0 == strcmp("-n", argv[i])) {
+			records = atoi(argv[i + 1]);
+		}
+		else if (0 == strcmp("-r", argv[i])) {
+			repeats = atoi(argv[i + 1]);
+		}
+		else if (0 == strcmp("-b", argv[i])) {
+			baseline_path = argv[i + 1];
+		}
+		else if (0 == strcmp("-t", argv[i])) {
+			tolerance = atoi(argv[i + 1]);
+		}
+		else if (0 == strcmp("-s", argv[i])) {
+			strict = atoi(argv[i + 1]);
+		}
+		else if (0 == strcmp("-o", argv[i])) {
+			output_path = argv[i + 1];
+		}
+		else {
+			break;
+		}
+	}
+
+	if ((i < argc) || (0 >= records) || (0 >= repeats)) {
+		fprintf(stderr, "usage: %s [-e engine] [-n records] [-r repeats] [-b baseline.csv] [-t tolerance] [-s 0|1] [-o results.csv]\n", argv[0]);
+		return 2;
+	}
+
+	if (0 != gethostname(host, sizeof(host))) {
+		host[0] = '\0';
+	}
+
+	host[sizeof(host) - 1] = '\0';
+
+	/* read before the run, as the results may be written over it */
+	if (NULL != baseline_path) {
+		if (NULL == (file = fopen(baseline_path, "r"))) {
+			fprintf(stderr, "cannot read baseline %s, take one on this host with -o first\n", baseline_path);
+			return 1;
+		}
+
+		baseline_count = ion_perf_read(file, baseline_host, baseline, ION_PERF_MAX_BASELINE);
+		fclose(file);
+
+		if (0 > baseline_count) {
+			fprintf(stderr, "baseline %s is not one\n", baseline_path);
+			return 1;
+		}
+
+		/* a baseline of no known host is another host's */
+		if (0 > strict) {
+			strict = ('\0' != host[0]) && (0 == strcmp(host, baseline_host));
+		}
+
+		if (!strict) {
+			fprintf(stderr, "baseline %s is of host \"%s\", not \"%s\": only failures fail\n", baseline_path, baseline_host, host);
+		}
+	}
+
+	results = malloc(ion_perf_engine_count * ion_perf_case_count * sizeof(ion_perf_result_t));
+	chosen	= malloc(ion_perf_engine_count * sizeof(int));
+
+	if ((NULL == results) || (NULL == chosen)) {
+		free(results);
+		free(chosen);
+		return 1;
+	}
+
+	for (e = 0; e < ion_perf_engine_count; e++) {
+		if ((NULL == engine) || (0 == strcmp(engine, ion_perf_engines[e].engine.name))) {
+			ion_perf_reset(&ion_perf_engines[e], results + engines * ion_perf_case_count);
+			chosen[engines++] = e;
+		}
+	}
+
+	/* a round runs every engine once, and an engine that could not run is run no more */
+	for (r = 0; r < repeats; r++) {
+		for (i = 0; i < engines; i++) {
+			if (0 > (e = chosen[i])) {
+				continue;
+			}
+
+			err = ion_perf_run_engine(&ion_perf_engines[e], records, (ion_dictionary_id_t) (e + 1), results + i * ion_perf_case_count);
+
+			if (err_ok != err) {
+				fprintf(stderr, "%s could not run, error %d\n", ion_perf_engines[e].engine.name, (int) err);
+				failed++;
+				chosen[i] = -1;
+			}
+		}
+	}
+
+	for (i = 0; i < engines; i++) {
+		if (0 <= chosen[i]) {
+			memmove(results + count, results + i * ion_perf_case_count, ion_perf_case_count * sizeof(ion_perf_result_t));
+			count += ion_perf_case_count;
+		}
+	}
+
+	free(chosen);
+
+	/* cases keep the tolerance they were given in the baseline */
+	for (i = 0; i < count; i++) {
+		if (NULL != (base = ion_perf_find(baseline, baseline_count, results[i].engine, results[i].benchmark))) {
+			results[i].tolerance = base->tolerance;
+		}
+		else if (0 <= tolerance) {
+			results[i].tolerance = tolerance;
+		}
+	}
+
+	if (NULL != baseline_path) {
+		failed += ion_perf_compare(results, count, baseline, baseline_count, tolerance, (ion_boolean_t) (0 != strict), stderr);
+	}
+
+	file = (NULL == output_path) ? stdout : fopen(output_path, "w");
+
+	if (NULL == file) {
+		fprintf(stderr, "cannot write %s\n", output_path);
+		failed++;
+	}
+	else {
+		ion_perf_write(file, host, results, count);
+
+		if (stdout != file) {
+			fclose(file);
+		}
+	}
+
+	free(results);
+
+	return (0 == failed) ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+/******************************************************************************/
+/**
+@file
+@brief		The C++ implementation of an adaptive radix tree based
+			dictionary.
+*/
+/******************************************************************************/
+
+#ifndef PROJECT_ADAPTIVERADIXTREE_H
+#define PROJECT_ADAPTIVERADIXTREE_H
+
+#include "Dictionary.h"
+#include "../key_value/kv_system.h"
+#include "../dictionary/art/art_dictionary_handler.h"
+
+template<typename K, typename V>
+class AdaptiveRadixTree:public Dictionary<K, V> {
+public:
+
+/**
+@brief		Registers a specific adaptive radix tree dictionary instance.
+
+@details	Registers functions for dictionary.
+
+@param		type_key
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param	  value_size
+				The size of the values to be stored in the dictionary.
+@param	  dictionary_size
+				Unused, as the tree grows with its records.
+*/
+AdaptiveRadixTree(
+	ion_key_type_t			type_key,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	dictionary_size
+) {
+	artdict_init(&this->handler);
+
+	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
+}
+};
+
+#endif /* PROJECT_ADAPTIVERADIXTREE_H */
@@ -36,6 +36,7 @@ BppTree(
 	bpptree_init(&this->handler);
 
 	this->initializeDictionary(type_key, key_size, value_size, 0);
+	this->load_sorted = bpptree_bulk_load;
 }
 };
 
@@ -0,0 +1,47 @@
+/******************************************************************************/
+/**
+@file
+@brief		The C++ implementation of a cuckoo hash based
+			dictionary.
+*/
+/******************************************************************************/
+
+#ifndef PROJECT_CUCKOOHASH_H
+#define PROJECT_CUCKOOHASH_H
+
+#include "Dictionary.h"
+#include "../key_value/kv_system.h"
+#include "../dictionary/cuckoo_hash/cuckoo_hash_dictionary_handler.h"
+
+template<typename K, typename V>
+class CuckooHash:public Dictionary<K, V> {
+public:
+
+/**
+@brief		Registers a specific cuckoo hash dictionary instance.
+
+@details	Registers functions for dictionary.
+
+@param		type_key
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param	  value_size
+				The size of the values to be stored in the dictionary.
+@param	  dictionary_size
+				The number of records the dictionary is sized
+				for; it does not grow past it.
+*/
+CuckooHash(
+	ion_key_type_t			type_key,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	dictionary_size
+) {
+	ckhdict_init(&this->handler);
+
+	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
+}
+};
+
+#endif /* PROJECT_CUCKOOHASH_H */
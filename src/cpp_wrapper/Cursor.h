@@ -25,40 +25,217 @@
 #if !defined(CURSOR_H)
 #define CURSOR_H
 
+#include <string.h>
+#if !defined(ARDUINO)
+#include <iterator>
+#endif
+
+/**
+@brief		The records a cursor reads at once for its iterators, so a
+			loop over them costs one call of the cursor per batch.
+*/
+#if !defined(ION_CPP_CURSOR_BATCH)
+#if defined(ARDUINO)
+#define ION_CPP_CURSOR_BATCH 4
+#else
+#define ION_CPP_CURSOR_BATCH 16
+#endif
+#endif
+
+/**
+@brief		A query over a dictionary, owning the cursor it reads by.
+@details	A cursor is moved, not copied, and frees what it holds when it
+			goes out of scope. Records of the sizes of @p K and @p V are
+			read into the cursor itself, so a query takes no memory but
+			that of the cursor of the dictionary; records of other sizes
+			are read into memory taken for them.
+*/
 template<typename K, typename V>
 class Cursor {
 public:
+
+/**
+@brief		A record a cursor is at, read in place in the cursor, valid
+			until the cursor moves on.
+*/
+struct Record {
+	const K &key;	/**< Its key */
+	const V &value; /**< Its value */
+};
+
+/**
+@brief		Reads the records of a cursor from where it is to the end, a
+			batch at a time, as a range-for does.
+*/
+class Iterator {
+public:
+
+#if !defined(ARDUINO)
+typedef std::input_iterator_tag	iterator_category;
+typedef Record					value_type;
+typedef int						difference_type;
+typedef const Record			*pointer;
+typedef Record					reference;
+#endif
+
+Iterator(
+	Cursor *cursor
+) : cursor(cursor) {}
+
+Record
+operator*(
+) const {
+	return Record { cursor->batchKey(cursor->at), cursor->batchValue(cursor->at) };
+}
+
+Iterator &
+operator++(
+) {
+	if ((++cursor->at >= cursor->count) && !cursor->fill()) {
+		cursor = NULL;
+	}
+
+	return *this;
+}
+
+bool
+operator==(
+	const Iterator &other
+) const {
+	return cursor == other.cursor;
+}
+
+bool
+operator!=(
+	const Iterator &other
+) const {
+	return cursor != other.cursor;
+}
+
+private:
+
+Cursor *cursor;
+};
+
 Cursor(
 	ion_dictionary_t	*dictionary,
 	ion_predicate_t		*predicate
-) {
-	this->dictionary	= dictionary;
-	dictionary_find(dictionary, predicate, &cursor);
-	record.key			= malloc(dictionary->instance->record.key_size);
-	record.value		= malloc(dictionary->instance->record.value_size);
+) : dictionary(dictionary), cursor(NULL), at(0), count(0), done(false) {
+	key_size	= dictionary->instance->record.key_size;
+	value_size	= dictionary->instance->record.value_size;
+	inline_		= (sizeof(K) == key_size) && (sizeof(V) == value_size);
+
+	if (err_ok != dictionary_find(dictionary, predicate, &cursor)) {
+		cursor = NULL;
+	}
+
+	point();
+}
+
+Cursor(
+	Cursor &&other
+) : dictionary(other.dictionary), cursor(other.cursor), key_size(other.key_size), value_size(other.value_size), inline_(other.inline_), at(other.at), count(other.count), done(other.done) {
+	if (inline_) {
+		memcpy(key_bytes, other.key_bytes, sizeof(key_bytes));
+		memcpy(value_bytes, other.value_bytes, sizeof(value_bytes));
+		memcpy(batch_keys, other.batch_keys, sizeof(batch_keys));
+		memcpy(batch_values, other.batch_values, sizeof(batch_values));
+		point();
+	}
+	else {
+		record	= other.record;
+		keys	= other.keys;
+		values	= other.values;
+	}
+
+	other.cursor		= NULL;
+	other.inline_		= true;
+	other.at			= 0;
+	other.count			= 0;
+	other.done			= true;
+	other.record.key	= NULL;
+	other.record.value	= NULL;
+	other.keys			= NULL;
+	other.values		= NULL;
 }
 
+Cursor(
+	const Cursor &
+) = delete;
+
+Cursor &
+operator=(
+	const Cursor &
+) = delete;
+
+Cursor &
+operator=(
+	Cursor &&
+) = delete;
+
 ~Cursor(
 ) {
-	cursor->destroy(&cursor);
-	free(record.key);
-	free(record.value);
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	if (!inline_) {
+		free(record.key);
+		free(record.value);
+		free(keys);
+		free(values);
+	}
+}
+
+/**
+@brief		Whether the cursor was made and can be read.
+*/
+bool
+isValid(
+) const {
+	return NULL != cursor;
 }
 
 bool
 hasNext(
 ) {
-	return cursor->status == cs_cursor_initialized || cursor->status == cs_cursor_active;
+	return (NULL != cursor) && (cursor->status == cs_cursor_initialized || cursor->status == cs_cursor_active);
 }
 
 bool
 next(
 ) {
+	if ((NULL == cursor) || (NULL == record.key) || (NULL == record.value)) {
+		return false;
+	}
+
 	ion_cursor_status_t status = cursor->next(cursor, &record);
 
 	return status == cs_cursor_initialized || status == cs_cursor_active;
 }
 
+/**
+@brief		Reads up to @p max records at once, see @ref dictionary_next_batch.
+@details	The current record, as seen by @ref getKey and @ref getValue,
+			is left as it was.
+@param		keys
+				Room for @p max keys.
+@param		values
+				Room for @p max values.
+@param		max
+				The most records to read.
+@return		The number of records read, fewer than @p max once there
+			are no more.
+*/
+int
+nextBatch(
+	K	*keys,
+	V	*values,
+	int max
+) {
+	return (NULL == cursor) ? 0 : dictionary_next_batch(cursor, keys, values, max);
+}
+
 K
 getKey(
 ) {
@@ -71,11 +248,95 @@ getValue(
 	return *((V *) record.value);
 }
 
+/**
+@brief		Starts reading the records left, a batch at a time.
+@details	Records an iterator has stepped past are not read again; the
+			record a loop broke out on is.
+*/
+Iterator
+begin(
+) {
+	return Iterator(((at < count) || fill()) ? this : NULL);
+}
+
+Iterator
+end(
+) {
+	return Iterator(NULL);
+}
+
 private:
 
-ion_dictionary_t	*dictionary;
-ion_dict_cursor_t	*cursor;
-ion_record_t		record;
+/**
+@brief		Points the record and the batch at the memory they are read
+			into, that of the cursor where the records fit in it.
+*/
+void
+point(
+) {
+	if (inline_) {
+		record.key		= key_bytes;
+		record.value	= value_bytes;
+		keys			= batch_keys;
+		values			= batch_values;
+		return;
+	}
+
+	record.key		= malloc(key_size);
+	record.value	= malloc(value_size);
+	keys			= (ion_byte_t *) malloc((size_t) ION_CPP_CURSOR_BATCH * key_size);
+	values			= (ion_byte_t *) malloc((size_t) ION_CPP_CURSOR_BATCH * value_size);
+}
+
+/**
+@brief		Reads the next batch of records, if there are more.
+@return		Whether any were read.
+*/
+bool
+fill(
+) {
+	at		= 0;
+	count	= 0;
+
+	if (done || (NULL == cursor) || (NULL == keys) || (NULL == values)) {
+		return false;
+	}
+
+	count	= dictionary_next_batch(cursor, keys, values, ION_CPP_CURSOR_BATCH);
+	done	= count < ION_CPP_CURSOR_BATCH;
+
+	return 0 < count;
+}
+
+const K &
+batchKey(
+	int i
+) const {
+	return *((const K *) (keys + (size_t) i * key_size));
+}
+
+const V &
+batchValue(
+	int i
+) const {
+	return *((const V *) (values + (size_t) i * value_size));
+}
+
+ion_dictionary_t		*dictionary;
+ion_dict_cursor_t		*cursor;
+ion_key_size_t			key_size;
+ion_value_size_t		value_size;
+bool					inline_;
+int						at;
+int						count;
+bool					done;
+ion_record_t			record;
+ion_byte_t				*keys;
+ion_byte_t				*values;
+alignas(K) ion_byte_t	key_bytes[sizeof(K)];
+alignas(V) ion_byte_t	value_bytes[sizeof(V)];
+alignas(K) ion_byte_t	batch_keys[ION_CPP_CURSOR_BATCH * sizeof(K)];
+alignas(V) ion_byte_t	batch_values[ION_CPP_CURSOR_BATCH * sizeof(V)];
 };
 
 #endif
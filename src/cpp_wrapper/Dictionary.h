@@ -15,6 +15,28 @@
 #include "../key_value/kv_system.h"
 
 #include "Cursor.h"
+#include "KeyTraits.h"
+
+/**
+@brief		The records a bulk insert hands the dictionary at once.
+*/
+#if !defined(ION_CPP_INSERT_BATCH)
+#if defined(ARDUINO)
+#define ION_CPP_INSERT_BATCH 4
+#else
+#define ION_CPP_INSERT_BATCH 32
+#endif
+#endif
+
+/**
+@brief		Supplies the next record of a bulk load, as the engines' bulk
+			loaders take them: @ref err_ok once @p record is filled, and
+			@ref err_item_not_found when there are no more.
+*/
+typedef ion_err_t (*ion_cpp_bulk_next_t)(
+	void			*context,
+	ion_record_t	*record
+);
 
 template<typename K, typename V>
 class Dictionary {
@@ -27,6 +49,21 @@ ion_value_size_t			size_v;
 ion_dictionary_size_t		dict_size;
 ion_status_t				last_status;
 
+/**
+@brief		Loads records given in key order into the empty dictionary in
+			one pass, set by the engines that have a bulk loader. It fails
+			with @ref err_illegal_state, reading no record, if the
+			dictionary is not empty.
+*/
+ion_status_t (*load_sorted)(
+	ion_dictionary_t	*dictionary,
+	ion_cpp_bulk_next_t next,
+	void				*context
+);
+
+Dictionary(
+) : load_sorted(NULL) {}
+
 ~Dictionary(
 ) {
 	this->destroy();
@@ -39,7 +76,7 @@ initializeDictionary(
 	ion_value_size_t		value_size,
 	ion_dictionary_size_t	dictionary_size
 ) {
-	ion_err_t err = dictionary_create(&handler, &dict, 0, type_key, key_size, value_size, dictionary_size);
+	ion_err_t err = dictionary_create_with_compare(&handler, &dict, 0, type_key, key_size, value_size, dictionary_size, KeyTraits<K>::comparator(type_key, key_size));
 
 	size_k		= key_size;
 	size_v		= value_size;
@@ -72,6 +109,98 @@ insert(
 	return status;
 }
 
+/**
+@brief		Inserts the records of a range of pairs, such as those of a
+			@c std::vector or @c std::map, generally a batch at a time.
+
+@details	Records that are @c K and @c V wide go to
+			@ref dictionary_insert_many a batch at a time, others to
+			@ref insert one at a time. A range flagged @p sorted given to an
+			empty dictionary whose engine has a bulk loader, see
+			@ref load_sorted, is loaded in one pass instead; the range must
+			then be in ascending key order, or the load stops with
+			@ref err_sorted_order_violation.
+
+@param		first
+				The first pair to insert, with the key as @c first and the
+				value as @c second.
+@param		last
+				Past the last pair to insert.
+@param		sorted
+				Whether the range is in ascending key order.
+@returns	The number of records inserted, with the error of the first
+			insert that did not succeed, if any.
+*/
+template<typename InputIt>
+auto
+insert(
+	InputIt first,
+	InputIt last,
+	bool	sorted = false
+)->decltype((void) (*first).first, (void) (*first).second, ion_status_t()) {
+	ion_status_t status = ION_STATUS_OK(0);
+
+	if ((sizeof(K) != (size_t) size_k) || (sizeof(V) != (size_t) size_v)) {
+		for (; first != last; ++first) {
+			addStatus(&status, insert((K) (*first).first, (V) (*first).second));
+		}
+
+		this->last_status = status;
+
+		return status;
+	}
+
+	if (sorted && (NULL != load_sorted)) {
+		BulkSource<InputIt> source = { first, last, 0 };
+
+		status = load_sorted(&dict, bulkNext<InputIt>, &source);
+
+		/* a dictionary that is not empty has read nothing, and takes the batches */
+		if ((0 != source.read) || (err_illegal_state != status.error)) {
+			this->last_status = status;
+
+			return status;
+		}
+
+		status = ION_STATUS_OK(0);
+	}
+
+	alignas(K) ion_byte_t	keys[ION_CPP_INSERT_BATCH * sizeof(K)];
+	alignas(V) ion_byte_t	values[ION_CPP_INSERT_BATCH * sizeof(V)];
+
+	while (first != last) {
+		int count = 0;
+
+		for (; (count < ION_CPP_INSERT_BATCH) && (first != last); ++first, ++count) {
+			K	key		= (*first).first;
+			V	value	= (*first).second;
+
+			memcpy(keys + count * sizeof(K), &key, sizeof(K));
+			memcpy(values + count * sizeof(V), &value, sizeof(V));
+		}
+
+		addStatus(&status, dictionary_insert_many(&dict, keys, values, NULL, count));
+	}
+
+	this->last_status = status;
+
+	return status;
+}
+
+/**
+@brief		Inserts @p count pairs stored back to back, see the range
+			@ref insert.
+*/
+template<typename Pair>
+auto
+insert(
+	const Pair	*records,
+	int			count,
+	bool		sorted = false
+)->decltype((void) records->first, (void) records->second, ion_status_t()) {
+	return insert(records, records + count, sorted);
+}
+
 V
 get(
 	K key
@@ -174,9 +303,10 @@ close(
 				The minimum key to be included in the query.
 @param	  max_key
 				The maximum key to be included in the query.
-@returns	An initialized cursor for the particular query.
+@returns	An initialized cursor for the particular query, owned by the
+			caller and freed when it goes out of scope.
 */
-Cursor<K, V> *
+Cursor<K, V>
 range(
 	K	min_key,
 	K	max_key
@@ -186,7 +316,7 @@ range(
 	ion_key_t		ion_max_key = &max_key;
 
 	dictionary_build_predicate(&predicate, predicate_range, ion_min_key, ion_max_key);
-	return new Cursor<K, V>(&dict, &predicate);
+	return Cursor<K, V>(&dict, &predicate);
 }
 
 /**
@@ -195,9 +325,10 @@ range(
 
 @param	  key
 				The key used to determine equality.
-@returns	An initialized cursor for the particular query.
+@returns	An initialized cursor for the particular query, owned by the
+			caller and freed when it goes out of scope.
 */
-Cursor<K, V> *
+Cursor<K, V>
 equality(
 	K key
 ) {
@@ -205,22 +336,76 @@ equality(
 	ion_key_t		ion_key = &key;
 
 	dictionary_build_predicate(&predicate, predicate_equality, ion_key);
-	return new Cursor<K, V>(&dict, &predicate);
+	return Cursor<K, V>(&dict, &predicate);
 }
 
 /**
 @brief	  Sets up cursor and predicate in order to find all records
 			present in the dictionary.
 
-@returns	An initialized cursor for the particular query.
+@returns	An initialized cursor for the particular query, owned by the
+			caller and freed when it goes out of scope.
 */
-Cursor<K, V> *
+Cursor<K, V>
 allRecords(
 ) {
 	ion_predicate_t predicate;
 
 	dictionary_build_predicate(&predicate, predicate_all_records);
-	return new Cursor<K, V>(&dict, &predicate);
+	return Cursor<K, V>(&dict, &predicate);
+}
+
+private:
+
+/**
+@brief		The rest of a range being bulk loaded.
+*/
+template<typename InputIt>
+struct BulkSource {
+	InputIt next;	/**< The next pair to load */
+	InputIt last;	/**< Past the last pair */
+	int		read;	/**< How many pairs were handed out */
+};
+
+/**
+@brief		Hands the loader the next pair of a @ref BulkSource.
+*/
+template<typename InputIt>
+static ion_err_t
+bulkNext(
+	void			*context,
+	ion_record_t	*record
+) {
+	BulkSource<InputIt> *source = (BulkSource<InputIt> *) context;
+
+	if (source->next == source->last) {
+		return err_item_not_found;
+	}
+
+	K	key		= (*source->next).first;
+	V	value	= (*source->next).second;
+
+	memcpy(record->key, &key, sizeof(K));
+	memcpy(record->value, &value, sizeof(V));
+	++source->next;
+	source->read++;
+
+	return err_ok;
+}
+
+/**
+@brief		Adds the outcome of part of a bulk insert to its total.
+*/
+static void
+addStatus(
+	ion_status_t	*status,
+	ion_status_t	part
+) {
+	status->count += part.count;
+
+	if ((err_ok == status->error) && (err_ok != part.error)) {
+		status->error = part.error;
+	}
 }
 };
 
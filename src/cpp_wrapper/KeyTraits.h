@@ -0,0 +1,179 @@
+/******************************************************************************/
+/**
+@file
+@brief		How the C++ wrapper compares and hashes keys of a given type.
+@details	A dictionary of keys of type @c K asks @c KeyTraits<K> for its
+			comparator when it is created, so the order of its keys follows
+			from @c K rather than only from the key type it is given. The
+			wrappers' own fast paths, such as the lookups of
+			@ref OpenAddressHash, compare and hash keys through the same
+			traits, inlined for @c K.
+@par
+			The built-in integer types map to the engines' stock native
+			comparators, so engines keep their integer specialisations.
+			Other key types can be given an order by specialising
+			@c KeyTraits on @ref OrderedKeyTraits:
+@code
+template<>
+struct KeyTraits<Point>:public OrderedKeyTraits<Point, KeyTraits<Point> > {
+	static int
+	compare(
+		const Point &first,
+		const Point &second
+	) {
+		...
+	}
+};
+@endcode
+*/
+/******************************************************************************/
+
+#if !defined(PROJECT_CPP_KEY_TRAITS_H)
+#define PROJECT_CPP_KEY_TRAITS_H
+
+#include <string.h>
+#include "../dictionary/dictionary.h"
+
+/**
+@brief		What every key type has: bytewise equality and hashing, and no
+			comparator of its own, leaving it to the key type the
+			dictionary is created with.
+*/
+template<typename K>
+struct KeyTraitsBase {
+	/**
+	@brief		Whether keys are equal exactly when their bytes are, so
+				a fast path may compare and hash them as bytes.
+	*/
+	static const bool bytewise = false;
+
+	/**
+	@brief		The comparator to create a dictionary with.
+	@param		key_type
+					The key type the dictionary is created with.
+	@param		key_size
+					The key size the dictionary is created with.
+	@return		The comparator, or @c NULL for the one the C interface picks
+				for @p key_type.
+	*/
+	static ion_dictionary_compare_t
+	comparator(
+		ion_key_type_t	key_type,
+		ion_key_size_t	key_size
+	) {
+		UNUSED(key_type);
+		UNUSED(key_size);
+		return NULL;
+	}
+
+	static bool
+	equal(
+		const K &first,
+		const K &second
+	) {
+		return 0 == memcmp(&first, &second, sizeof(K));
+	}
+
+	/**
+	@brief		Hashes a key as @ref dictionary_hash_key hashes numeric
+				keys, unrolled for the size of @c K.
+	*/
+	static uint32_t
+	hash(
+		const K		&key,
+		uint32_t	seed
+	) {
+		return dictionary_hash_bytes((const ion_byte_t *) &key, sizeof(K), seed);
+	}
+};
+
+/**
+@brief		The traits of a key type, see the file description.
+*/
+template<typename K>
+struct KeyTraits:public KeyTraitsBase<K> {};
+
+/**
+@brief		Traits for a key type ordered by a @c compare of its own, which
+			@p Traits defines as returning less than, equal to or greater
+			than zero.
+@details	Dictionaries of such keys call @p Traits::compare on copies of
+			their keys, whatever key type they are created with.
+*/
+template<typename K, typename Traits>
+struct OrderedKeyTraits:public KeyTraitsBase<K> {
+	/**
+	@brief		Compares two stored keys with @p Traits::compare.
+	*/
+	static char
+	compareKeys(
+		ion_key_t		first_key,
+		ion_key_t		second_key,
+		ion_key_size_t	key_size
+	) {
+		K	first;
+		K	second;
+
+		UNUSED(key_size);
+		memcpy(&first, first_key, sizeof(K));
+		memcpy(&second, second_key, sizeof(K));
+
+		int order = Traits::compare(first, second);
+
+		return (order > 0) - (order < 0);
+	}
+
+	static ion_dictionary_compare_t
+	comparator(
+		ion_key_type_t	key_type,
+		ion_key_size_t	key_size
+	) {
+		UNUSED(key_type);
+		return (sizeof(K) == (size_t) key_size) ? compareKeys : NULL;
+	}
+};
+
+/**
+@brief		Traits for a built-in integer type, handing the engines the
+			stock comparator of its width so they keep their native paths.
+*/
+#define ION_CPP_NATIVE_KEY_TRAITS(type, type_key) \
+	template<> \
+	struct KeyTraits<type>:public KeyTraitsBase<type> { \
+		static const bool bytewise = true; \
+ \
+		static ion_dictionary_compare_t \
+		comparator( \
+			ion_key_type_t	key_type, \
+			ion_key_size_t	key_size \
+		) { \
+			return ((type_key == key_type) && (sizeof(type) == (size_t) key_size)) ? dictionary_switch_compare(key_type, key_size) : NULL; \
+		} \
+ \
+		static int \
+		compare( \
+			const type	&first, \
+			const type	&second \
+		) { \
+			return (first > second) - (first < second); \
+		} \
+ \
+		static bool \
+		equal( \
+			const type	&first, \
+			const type	&second \
+		) { \
+			return first == second; \
+		} \
+	};
+
+ION_CPP_NATIVE_KEY_TRAITS(int8_t, key_type_numeric_signed)
+ION_CPP_NATIVE_KEY_TRAITS(int16_t, key_type_numeric_signed)
+ION_CPP_NATIVE_KEY_TRAITS(int32_t, key_type_numeric_signed)
+ION_CPP_NATIVE_KEY_TRAITS(int64_t, key_type_numeric_signed)
+ION_CPP_NATIVE_KEY_TRAITS(uint8_t, key_type_numeric_unsigned)
+ION_CPP_NATIVE_KEY_TRAITS(uint16_t, key_type_numeric_unsigned)
+ION_CPP_NATIVE_KEY_TRAITS(uint32_t, key_type_numeric_unsigned)
+ION_CPP_NATIVE_KEY_TRAITS(uint64_t, key_type_numeric_unsigned)
+
+#endif /* PROJECT_CPP_KEY_TRAITS_H */
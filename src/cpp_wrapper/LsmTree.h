@@ -0,0 +1,47 @@
+/******************************************************************************/
+/**
+@file
+@brief		The C++ implementation of a log-structured merge tree based
+			dictionary.
+*/
+/******************************************************************************/
+
+#ifndef PROJECT_LSMTREE_H
+#define PROJECT_LSMTREE_H
+
+#include "Dictionary.h"
+#include "../key_value/kv_system.h"
+#include "../dictionary/lsm/lsm_dictionary_handler.h"
+
+template<typename K, typename V>
+class LsmTree:public Dictionary<K, V> {
+public:
+
+/**
+@brief		Registers a specific log-structured merge tree dictionary instance.
+
+@details	Registers functions for dictionary.
+
+@param		type_key
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param	  value_size
+				The size of the values to be stored in the dictionary.
+@param	  dictionary_size
+				The number of records the memtable holds before
+				it is written out as a run.
+*/
+LsmTree(
+	ion_key_type_t			type_key,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	dictionary_size
+) {
+	lsmdict_init(&this->handler);
+
+	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
+}
+};
+
+#endif /* PROJECT_LSMTREE_H */
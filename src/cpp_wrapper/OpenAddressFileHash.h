@@ -41,6 +41,107 @@ OpenAddressFileHash(
 	oafdict_init(&this->handler);
 
 	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
+	this->load_sorted = loadSorted;
+}
+
+private:
+
+/**
+@brief		Builds the empty map from a batch of records in one pass over its
+			file, see @ref oafh_bulk_build.
+
+@details	The map places records by their hash, so their order does not
+			matter here. They are gathered in memory first; a batch the
+			build turns away, for a key given twice or more records than
+			buckets, is inserted record by record instead.
+*/
+static ion_status_t
+loadSorted(
+	ion_dictionary_t	*dictionary,
+	ion_cpp_bulk_next_t next,
+	void				*context
+) {
+	ion_file_hashmap_t	*hash_map	= (ion_file_hashmap_t *) dictionary->instance;
+	ion_key_size_t		key_size	= hash_map->super.record.key_size;
+	int					data_size	= key_size + hash_map->super.record.value_size;
+	int					count		= 0;
+	int					capacity	= ION_CPP_INSERT_BATCH;
+	ion_byte_t			*records	= (ion_byte_t *) malloc((size_t) capacity * data_size);
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor		= NULL;
+	ion_record_t		record;
+	ion_err_t			err;
+
+	if (NULL == records) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	/* the build replaces what the map holds, so it must hold nothing */
+	record.key		= records;
+	record.value	= records + key_size;
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	err				= dictionary_find(dictionary, &predicate, &cursor);
+
+	bool empty = (err_ok == err) && (cs_end_of_results == cursor->next(cursor, &record));
+
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	if (!empty) {
+		free(records);
+		return ION_STATUS_ERROR(err_illegal_state);
+	}
+
+	while (1) {
+		if (count == capacity) {
+			capacity *= 2;
+
+			ion_byte_t *grown = (ion_byte_t *) realloc(records, (size_t) capacity * data_size);
+
+			if (NULL == grown) {
+				free(records);
+				return ION_STATUS_ERROR(err_out_of_memory);
+			}
+
+			records = grown;
+		}
+
+		record.key		= records + count * data_size;
+		record.value	= records + count * data_size + key_size;
+		err				= next(context, &record);
+
+		if (err_item_not_found == err) {
+			break;
+		}
+
+		if (err_ok != err) {
+			free(records);
+			return ION_STATUS_ERROR(err);
+		}
+
+		count++;
+	}
+
+	ion_status_t built = oafh_bulk_build(hash_map, records, count);
+
+	if ((err_duplicate_key == built.error) || (err_max_capacity == built.error)) {
+		built = ION_STATUS_OK(0);
+
+		for (int i = 0; i < count; i++) {
+			ion_status_t one = dictionary_insert(dictionary, records + i * data_size, records + i * data_size + key_size);
+
+			built.count += one.count;
+
+			if ((err_ok == built.error) && (err_ok != one.error)) {
+				built.error = one.error;
+			}
+		}
+	}
+
+	free(records);
+
+	return built;
 }
 };
 
@@ -12,6 +12,11 @@
 #include "Dictionary.h"
 #include "../key_value/kv_system.h"
 #include "../dictionary/open_address_hash/open_address_hash_dictionary_handler.h"
+#include "../dictionary/open_address_hash/open_address_hash.h"
+
+#if !defined(ARDUINO)
+#include <type_traits>
+#endif
 
 template<typename K, typename V>
 class OpenAddressHash:public Dictionary<K, V> {
@@ -40,6 +45,163 @@ OpenAddressHash(
 
 	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
 }
+
+/**
+@brief		Retrieves the value stored under a key.
+
+@details	Maps of numeric keys that are exactly @c K and @c V wide are
+			probed here directly, with the key compare and hash unrolled
+			for their size. Anything else takes the generic path.
+
+@param		key
+				The key to look up.
+@return		The value stored under @p key.
+*/
+V
+get(
+	K key
+) {
+	if (!fastPath()) {
+		return Dictionary<K, V>::get(key);
+	}
+
+	ion_byte_t	ion_value[sizeof(V)];
+	Bucket		*bucket = find(key);
+
+	if (NULL == bucket) {
+		this->last_status = ION_STATUS_ERROR(err_item_not_found);
+	}
+	else {
+		memcpy(ion_value, &bucket->value, sizeof(V));
+		this->last_status = ION_STATUS_OK(1);
+	}
+
+	return *((V *) ion_value);
+}
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@details	A key already in the map has its value overwritten in place
+			on the fast path, see @ref get. Inserts always go through the
+			map itself, which keeps its control bytes and load in step.
+
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+update(
+	K	key,
+	V	value
+) {
+	Bucket *bucket = fastPath() ? find(key) : NULL;
+
+	if (NULL == bucket) {
+		return Dictionary<K, V>::update(key, value);
+	}
+
+	memcpy(&bucket->value, &value, sizeof(V));
+	this->last_status = ION_STATUS_OK(1);
+
+	return this->last_status;
+}
+
+private:
+
+#pragma pack(push, 1)
+/**
+@brief		The layout of one bucket of the map: a status byte, then the
+			key and value, with no padding in between. The map may pad
+			around it, see @ref ION_OAH_BUCKET_ALIGN, so buckets are
+			@c bucket_size apart.
+*/
+struct Bucket {
+	char	status;
+	K		key;
+	V		value;
+};
+#pragma pack(pop)
+
+/**
+@brief		Whether @c K and @c V can be copied bytewise.
+*/
+static bool
+triviallyCopyable(
+) {
+#if defined(ARDUINO)
+	return __has_trivial_copy(K) && __has_trivial_copy(V);
+#else
+	return std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value;
+#endif
+}
+
+/**
+@brief		Whether the map can be probed here rather than through the
+			dictionary interface.
+
+@details	Numeric keys under a stock comparator compare equal exactly
+			when their bytes do, so the key compare becomes that of
+			@ref KeyTraits for @c K. Only maps placing
+			keys with the seeded hash qualify, and only while no resize
+			is in progress, since records then span two tables.
+*/
+bool
+fastPath(
+) {
+	ion_hashmap_t *hash_map = (ion_hashmap_t *) this->dict.instance;
+
+	return triviallyCopyable() && (NULL != hash_map) && ((key_type_numeric_signed == hash_map->super.key_type) || (key_type_numeric_unsigned == hash_map->super.key_type)) && (sizeof(K) == (size_t) hash_map->super.record.key_size) && (sizeof(V) == (size_t) hash_map->super.record.value_size) && (dictionary_is_signed_compare(hash_map->super.compare) || dictionary_is_unsigned_compare(hash_map->super.compare)) && (oah_compute_seeded_hash == hash_map->compute_hash) && (NULL == hash_map->old_entry);
+}
+
+/**
+@brief		Probes the map for a key, walking the bucket status bytes
+			from the key's home slot.
+
+@details	Bucket status is kept in step with the control bytes, so the
+			walk sees the same records the map's own probe does, and with
+			an inlined compare of @c K there is little a fingerprint would
+			save.
+
+@param		key
+				The key to find.
+@return		The bucket holding @p key, or @c NULL.
+*/
+Bucket *
+find(
+	K key
+) {
+	ion_hashmap_t	*hash_map	= (ion_hashmap_t *) this->dict.instance;
+	int				size		= hash_map->map_size;
+	int				loc			= (int) (KeyTraits<K>::hash(key, hash_map->seed) % (uint32_t) size);
+
+	for (int count = 0; count < size; count++) {
+		Bucket *bucket = (Bucket *) (hash_map->entry + hash_map->bucket_size * loc);
+
+		if (ION_EMPTY == bucket->status) {
+			break;
+		}
+
+		if (ION_IN_USE == bucket->status) {
+			/* the bucket is packed, so its key is copied out to be compared */
+			K stored;
+
+			memcpy(&stored, &bucket->key, sizeof(K));
+
+			if (KeyTraits<K>::equal(stored, key)) {
+				return bucket;
+			}
+		}
+
+		if (++loc == size) {
+			loc = 0;
+		}
+	}
+
+	return NULL;
+}
 };
 
 #endif /* PROJECT_OPENADDRESSHASH_H */
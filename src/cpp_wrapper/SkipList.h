@@ -39,6 +39,21 @@ SkipList(
 	sldict_init(&this->handler);
 
 	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
+	this->load_sorted = loadSorted;
+}
+
+private:
+
+/**
+@brief		Links sorted records into the empty skip list, see @ref sl_bulk_load.
+*/
+static ion_status_t
+loadSorted(
+	ion_dictionary_t	*dictionary,
+	ion_cpp_bulk_next_t next,
+	void				*context
+) {
+	return sl_bulk_load((ion_skiplist_t *) dictionary->instance, next, context, boolean_false);
 }
 };
 
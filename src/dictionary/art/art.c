@@ -0,0 +1,1057 @@
+/******************************************************************************/
+/**
+@file
+@brief		An in-memory adaptive radix tree.
+@details	Keys are all the same length, so no key is a prefix of another
+			and every leaf of an inner node is below a byte that sets it
+			apart. The bytes a node keeps past @ref ION_ART_PREFIX_BYTES
+			are skipped by searches, which compare the whole key at the
+			leaf, and read off the least leaf below the node by inserts
+			and iterators, which need them.
+*/
+/******************************************************************************/
+
+#include "art.h"
+
+/**
+@brief		The fewer of two sizes.
+*/
+#define ION_ART_MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+void
+art_encode_key(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_byte_t	*bytes
+) {
+	ion_key_size_t	key_size	= art->super.record.key_size;
+	ion_byte_t		*source		= (ion_byte_t *) key;
+	int				i;
+
+	switch (art->super.key_type) {
+		case key_type_numeric_signed:
+		case key_type_numeric_unsigned: {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+			for (i = 0; i < key_size; i++) {
+				bytes[i] = source[key_size - 1 - i];
+			}
+
+#else
+			memcpy(bytes, source, key_size);
+#endif
+
+			/* negative numbers come before the rest */
+			if (key_type_numeric_signed == art->super.key_type) {
+				bytes[0] ^= 0x80;
+			}
+
+			break;
+		}
+
+		default: {
+			/* strings compare up to their terminator, so what follows it is not part of the key */
+			for (i = 0; (i < key_size) && (0 != source[i]); i++) {
+				bytes[i] = source[i];
+			}
+
+			memset(bytes + i, 0, key_size - i);
+			break;
+		}
+	}
+}
+
+void
+art_decode_key(
+	ion_art_t	*art,
+	ion_byte_t	*bytes,
+	ion_key_t	key
+) {
+	ion_key_size_t	key_size	= art->super.record.key_size;
+	ion_byte_t		*target		= (ion_byte_t *) key;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	int i;
+#endif
+
+	if ((key_type_numeric_signed != art->super.key_type) && (key_type_numeric_unsigned != art->super.key_type)) {
+		memcpy(target, bytes, key_size);
+		return;
+	}
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+	for (i = 0; i < key_size; i++) {
+		target[key_size - 1 - i] = bytes[i];
+	}
+
+	if (key_type_numeric_signed == art->super.key_type) {
+		target[key_size - 1] ^= 0x80;
+	}
+
+#else
+	memcpy(target, bytes, key_size);
+
+	if (key_type_numeric_signed == art->super.key_type) {
+		target[0] ^= 0x80;
+	}
+
+#endif
+}
+
+/**
+@brief		Allocates an inner node of a kind, with no children.
+*/
+static ion_art_node_t *
+art_new_node(
+	ion_byte_t type
+) {
+	ion_art_node_t	*node;
+	size_t			size;
+
+	switch (type) {
+		case ION_ART_NODE4: {
+			size = sizeof(ion_art_node4_t);
+			break;
+		}
+
+		case ION_ART_NODE16: {
+			size = sizeof(ion_art_node16_t);
+			break;
+		}
+
+		case ION_ART_NODE48: {
+			size = sizeof(ion_art_node48_t);
+			break;
+		}
+
+		default: {
+			size = sizeof(ion_art_node256_t);
+			break;
+		}
+	}
+
+	if (NULL == (node = ion_calloc(ion_alloc_node, 1, size))) {
+		return NULL;
+	}
+
+	node->type = type;
+
+	return node;
+}
+
+/**
+@brief		Gives a node grown or shrunk into another kind the header of
+			the one it replaces.
+*/
+static void
+art_copy_header(
+	ion_art_node_t	*target,
+	ion_art_node_t	*source
+) {
+	target->children		= source->children;
+	target->prefix_length	= source->prefix_length;
+	memcpy(target->prefix, source->prefix, ION_ART_MIN(source->prefix_length, ION_ART_PREFIX_BYTES));
+}
+
+/**
+@brief		Finds the link to the child of a node under a byte.
+@return		The link, or @c NULL if there is no such child.
+*/
+static ion_art_node_t **
+art_find_child(
+	ion_art_node_t	*node,
+	ion_byte_t		byte
+) {
+	ion_byte_t		*keys;
+	ion_art_node_t	**child;
+	int				i;
+
+	switch (node->type) {
+		case ION_ART_NODE4: {
+			keys	= ((ion_art_node4_t *) node)->keys;
+			child	= ((ion_art_node4_t *) node)->child;
+			break;
+		}
+
+		case ION_ART_NODE16: {
+			keys	= ((ion_art_node16_t *) node)->keys;
+			child	= ((ion_art_node16_t *) node)->child;
+			break;
+		}
+
+		case ION_ART_NODE48: {
+			i = ((ion_art_node48_t *) node)->index[byte];
+			return (0 == i) ? NULL : &((ion_art_node48_t *) node)->child[i - 1];
+		}
+
+		default: {
+			child = &((ion_art_node256_t *) node)->child[byte];
+			return (NULL == *child) ? NULL : child;
+		}
+	}
+
+	/* the bytes are in order, so the search ends at the first not less */
+	for (i = 0; (i < node->children) && (keys[i] <= byte); i++) {
+		if (keys[i] == byte) {
+			return &child[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Finds the child of a node under the least byte not less than
+			@p byte, which may be 256 for none.
+@param		found
+				Receives the byte of the child.
+@return		The child, or @c NULL if there is no such child.
+*/
+static ion_art_node_t *
+art_next_child(
+	ion_art_node_t	*node,
+	int				byte,
+	int				*found
+) {
+	ion_byte_t		*keys;
+	ion_art_node_t	**child;
+	int				i;
+
+	switch (node->type) {
+		case ION_ART_NODE4: {
+			keys	= ((ion_art_node4_t *) node)->keys;
+			child	= ((ion_art_node4_t *) node)->child;
+			break;
+		}
+
+		case ION_ART_NODE16: {
+			keys	= ((ion_art_node16_t *) node)->keys;
+			child	= ((ion_art_node16_t *) node)->child;
+			break;
+		}
+
+		case ION_ART_NODE48: {
+			for (; byte < 256; byte++) {
+				if (0 != (i = ((ion_art_node48_t *) node)->index[byte])) {
+					*found = byte;
+					return ((ion_art_node48_t *) node)->child[i - 1];
+				}
+			}
+
+			return NULL;
+		}
+
+		default: {
+			for (; byte < 256; byte++) {
+				if (NULL != ((ion_art_node256_t *) node)->child[byte]) {
+					*found = byte;
+					return ((ion_art_node256_t *) node)->child[byte];
+				}
+			}
+
+			return NULL;
+		}
+	}
+
+	for (i = 0; i < node->children; i++) {
+		if (keys[i] >= byte) {
+			*found = keys[i];
+			return child[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Finds the least leaf below a node.
+*/
+static ion_art_leaf_t *
+art_minimum(
+	ion_art_node_t *node
+) {
+	int byte;
+
+	while (ION_ART_LEAF != node->type) {
+		node = art_next_child(node, 0, &byte);
+	}
+
+	return (ion_art_leaf_t *) node;
+}
+
+/**
+@brief		Adds a child in order to the bytes and children of a node of 4
+			or 16 that has room for it.
+*/
+static void
+art_add_sorted(
+	ion_byte_t		*keys,
+	ion_art_node_t	**children,
+	int				count,
+	ion_byte_t		byte,
+	ion_art_node_t	*child
+) {
+	int i;
+
+	for (i = count; (i > 0) && (keys[i - 1] > byte); i--) {
+		keys[i]		= keys[i - 1];
+		children[i] = children[i - 1];
+	}
+
+	keys[i]		= byte;
+	children[i] = child;
+}
+
+/**
+@brief		Adds a child to a node that has none under its byte, growing
+			the node into the next kind if it is full.
+@param		link
+				The link to the node, which a grown node replaces it in.
+*/
+static ion_err_t
+art_add_child(
+	ion_art_node_t	**link,
+	ion_art_node_t	*node,
+	ion_byte_t		byte,
+	ion_art_node_t	*child
+) {
+	ion_art_node_t	*grown;
+	int				i;
+
+	switch (node->type) {
+		case ION_ART_NODE4: {
+			if (node->children < 4) {
+				art_add_sorted(((ion_art_node4_t *) node)->keys, ((ion_art_node4_t *) node)->child, node->children, byte, child);
+				node->children++;
+				return err_ok;
+			}
+
+			if (NULL == (grown = art_new_node(ION_ART_NODE16))) {
+				return err_out_of_memory;
+			}
+
+			memcpy(((ion_art_node16_t *) grown)->keys, ((ion_art_node4_t *) node)->keys, 4);
+			memcpy(((ion_art_node16_t *) grown)->child, ((ion_art_node4_t *) node)->child, 4 * sizeof(ion_art_node_t *));
+			break;
+		}
+
+		case ION_ART_NODE16: {
+			if (node->children < 16) {
+				art_add_sorted(((ion_art_node16_t *) node)->keys, ((ion_art_node16_t *) node)->child, node->children, byte, child);
+				node->children++;
+				return err_ok;
+			}
+
+			if (NULL == (grown = art_new_node(ION_ART_NODE48))) {
+				return err_out_of_memory;
+			}
+
+			for (i = 0; i < 16; i++) {
+				((ion_art_node48_t *) grown)->child[i]										= ((ion_art_node16_t *) node)->child[i];
+				((ion_art_node48_t *) grown)->index[((ion_art_node16_t *) node)->keys[i]]	= i + 1;
+			}
+
+			break;
+		}
+
+		case ION_ART_NODE48: {
+			if (node->children < 48) {
+				/* deletes leave holes, so take the first free slot */
+				for (i = 0; NULL != ((ion_art_node48_t *) node)->child[i]; i++) {}
+
+				((ion_art_node48_t *) node)->child[i]		= child;
+				((ion_art_node48_t *) node)->index[byte]	= i + 1;
+				node->children++;
+				return err_ok;
+			}
+
+			if (NULL == (grown = art_new_node(ION_ART_NODE256))) {
+				return err_out_of_memory;
+			}
+
+			for (i = 0; i < 256; i++) {
+				if (0 != ((ion_art_node48_t *) node)->index[i]) {
+					((ion_art_node256_t *) grown)->child[i] = ((ion_art_node48_t *) node)->child[((ion_art_node48_t *) node)->index[i] - 1];
+				}
+			}
+
+			break;
+		}
+
+		default: {
+			((ion_art_node256_t *) node)->child[byte] = child;
+			node->children++;
+			return err_ok;
+		}
+	}
+
+	art_copy_header(grown, node);
+	ion_free(node);
+	*link = grown;
+
+	return art_add_child(link, grown, byte, child);
+}
+
+/**
+@brief		Takes the only child of a node of 4 up into its place, adding
+			the node's prefix and byte to the child's.
+*/
+static void
+art_collapse(
+	ion_art_node_t	**link,
+	ion_art_node_t	*node
+) {
+	ion_art_node_t	*child	= ((ion_art_node4_t *) node)->child[0];
+	ion_key_size_t	length	= node->prefix_length;
+	ion_key_size_t	more;
+
+	if (ION_ART_LEAF != child->type) {
+		if (length < ION_ART_PREFIX_BYTES) {
+			node->prefix[length++] = ((ion_art_node4_t *) node)->keys[0];
+		}
+
+		if (length < ION_ART_PREFIX_BYTES) {
+			more = ION_ART_MIN(child->prefix_length, ION_ART_PREFIX_BYTES - length);
+			memcpy(node->prefix + length, child->prefix, more);
+			length += more;
+		}
+
+		memcpy(child->prefix, node->prefix, ION_ART_MIN(length, ION_ART_PREFIX_BYTES));
+		child->prefix_length += node->prefix_length + 1;
+	}
+
+	*link = child;
+	ion_free(node);
+}
+
+/**
+@brief		Removes the child of a node under a byte, shrinking the node
+			into the kind before if it is left sparse.
+@param		link
+				The link to the node, which a shrunk node or its only
+				remaining child replaces it in.
+@param		child
+				The link to the child within the node.
+*/
+static void
+art_remove_child(
+	ion_art_node_t	**link,
+	ion_art_node_t	*node,
+	ion_byte_t		byte,
+	ion_art_node_t	**child
+) {
+	ion_art_node_t	*shrunk = NULL;
+	ion_byte_t		*keys;
+	ion_art_node_t	**children;
+	int				i;
+	int				n;
+
+	switch (node->type) {
+		case ION_ART_NODE4:
+		case ION_ART_NODE16: {
+			keys		= (ION_ART_NODE4 == node->type) ? ((ion_art_node4_t *) node)->keys : ((ion_art_node16_t *) node)->keys;
+			children	= (ION_ART_NODE4 == node->type) ? ((ion_art_node4_t *) node)->child : ((ion_art_node16_t *) node)->child;
+			i			= (int) (child - children);
+			node->children--;
+			memmove(keys + i, keys + i + 1, node->children - i);
+			memmove(children + i, children + i + 1, (node->children - i) * sizeof(ion_art_node_t *));
+
+			if ((ION_ART_NODE4 == node->type) && (1 == node->children)) {
+				art_collapse(link, node);
+				return;
+			}
+
+			/* shrinking is put off a few children past where the smaller kind fills, so a node on the edge does not flip between them */
+			if ((ION_ART_NODE16 == node->type) && (3 == node->children) && (NULL != (shrunk = art_new_node(ION_ART_NODE4)))) {
+				memcpy(((ion_art_node4_t *) shrunk)->keys, keys, 3);
+				memcpy(((ion_art_node4_t *) shrunk)->child, children, 3 * sizeof(ion_art_node_t *));
+			}
+
+			break;
+		}
+
+		case ION_ART_NODE48: {
+			*child										= NULL;
+			((ion_art_node48_t *) node)->index[byte]	= 0;
+			node->children--;
+
+			if ((12 == node->children) && (NULL != (shrunk = art_new_node(ION_ART_NODE16)))) {
+				for (i = 0, n = 0; i < 256; i++) {
+					if (0 != ((ion_art_node48_t *) node)->index[i]) {
+						((ion_art_node16_t *) shrunk)->keys[n]	= (ion_byte_t) i;
+						((ion_art_node16_t *) shrunk)->child[n] = ((ion_art_node48_t *) node)->child[((ion_art_node48_t *) node)->index[i] - 1];
+						n++;
+					}
+				}
+			}
+
+			break;
+		}
+
+		default: {
+			*child = NULL;
+			node->children--;
+
+			if ((37 == node->children) && (NULL != (shrunk = art_new_node(ION_ART_NODE48)))) {
+				for (i = 0, n = 0; i < 256; i++) {
+					if (NULL != ((ion_art_node256_t *) node)->child[i]) {
+						((ion_art_node48_t *) shrunk)->child[n] = ((ion_art_node256_t *) node)->child[i];
+						((ion_art_node48_t *) shrunk)->index[i] = n + 1;
+						n++;
+					}
+				}
+			}
+
+			break;
+		}
+	}
+
+	/* without the memory to shrink, the node is left as it is */
+	if (NULL != shrunk) {
+		art_copy_header(shrunk, node);
+		ion_free(node);
+		*link = shrunk;
+	}
+}
+
+/**
+@brief		Finds how many bytes of the prefix of a node a key shares.
+*/
+static ion_key_size_t
+art_prefix_mismatch(
+	ion_art_node_t	*node,
+	ion_byte_t		*bytes,
+	int				depth
+) {
+	ion_key_size_t	stored = ION_ART_MIN(node->prefix_length, ION_ART_PREFIX_BYTES);
+	ion_key_size_t	i;
+	ion_byte_t		*least;
+
+	for (i = 0; i < stored; i++) {
+		if (node->prefix[i] != bytes[depth + i]) {
+			return i;
+		}
+	}
+
+	if (node->prefix_length > ION_ART_PREFIX_BYTES) {
+		least = ION_ART_LEAF_KEY(art_minimum(node));
+
+		for (; i < node->prefix_length; i++) {
+			if (least[depth + i] != bytes[depth + i]) {
+				return i;
+			}
+		}
+	}
+
+	return i;
+}
+
+/**
+@brief		Inserts a leaf below a link, @p depth bytes into its key.
+*/
+static ion_err_t
+art_insert_leaf(
+	ion_art_t		*art,
+	ion_art_node_t	**link,
+	ion_art_leaf_t	*leaf,
+	int				depth
+) {
+	ion_key_size_t	key_size	= art->super.record.key_size;
+	ion_byte_t		*bytes		= ION_ART_LEAF_KEY(leaf);
+	ion_art_node_t	*node		= *link;
+	ion_art_node_t	*split;
+	ion_art_leaf_t	*existing;
+	ion_byte_t		*other;
+	ion_key_size_t	length;
+	ion_byte_t		byte;
+	ion_art_node_t	**child;
+
+	if (NULL == node) {
+		*link = (ion_art_node_t *) leaf;
+		return err_ok;
+	}
+
+	if (ION_ART_LEAF == node->type) {
+		existing	= (ion_art_leaf_t *) node;
+		other		= ION_ART_LEAF_KEY(existing);
+
+		if (0 == memcmp(other + depth, bytes + depth, key_size - depth)) {
+			while (NULL != existing->duplicate) {
+				existing = existing->duplicate;
+			}
+
+			existing->duplicate = leaf;
+			return err_ok;
+		}
+
+		/* the two keys part where a node of 4 takes them both */
+		if (NULL == (split = art_new_node(ION_ART_NODE4))) {
+			return err_out_of_memory;
+		}
+
+		for (length = 0; other[depth + length] == bytes[depth + length]; length++) {}
+
+		split->prefix_length = length;
+		memcpy(split->prefix, bytes + depth, ION_ART_MIN(length, ION_ART_PREFIX_BYTES));
+		art_add_child(&split, split, other[depth + length], node);
+		art_add_child(&split, split, bytes[depth + length], (ion_art_node_t *) leaf);
+		*link = split;
+
+		return err_ok;
+	}
+
+	if (0 != node->prefix_length) {
+		length = art_prefix_mismatch(node, bytes, depth);
+
+		if (length < node->prefix_length) {
+			/* the key leaves the prefix, so a node of 4 takes the prefix up to there, the node and the leaf */
+			if (NULL == (split = art_new_node(ION_ART_NODE4))) {
+				return err_out_of_memory;
+			}
+
+			split->prefix_length = length;
+			memcpy(split->prefix, node->prefix, ION_ART_MIN(length, ION_ART_PREFIX_BYTES));
+
+			if (node->prefix_length <= ION_ART_PREFIX_BYTES) {
+				byte				= node->prefix[length];
+				node->prefix_length -= length + 1;
+				memmove(node->prefix, node->prefix + length + 1, node->prefix_length);
+			}
+			else {
+				other				= ION_ART_LEAF_KEY(art_minimum(node));
+				byte				= other[depth + length];
+				node->prefix_length -= length + 1;
+				memcpy(node->prefix, other + depth + length + 1, ION_ART_MIN(node->prefix_length, ION_ART_PREFIX_BYTES));
+			}
+
+			art_add_child(&split, split, byte, node);
+			art_add_child(&split, split, bytes[depth + length], (ion_art_node_t *) leaf);
+			*link = split;
+
+			return err_ok;
+		}
+
+		depth += node->prefix_length;
+	}
+
+	if (NULL != (child = art_find_child(node, bytes[depth]))) {
+		return art_insert_leaf(art, child, leaf, depth + 1);
+	}
+
+	return art_add_child(link, node, bytes[depth], (ion_art_node_t *) leaf);
+}
+
+/**
+@brief		Finds the first leaf holding a key, given as its bytes.
+@return		The leaf, or @c NULL if no record has the key.
+*/
+static ion_art_leaf_t *
+art_search(
+	ion_art_t	*art,
+	ion_byte_t	*bytes
+) {
+	ion_art_node_t	*node	= art->root;
+	int				depth	= 0;
+	ion_art_node_t	**child;
+
+	while (NULL != node) {
+		if (ION_ART_LEAF == node->type) {
+			return (0 == memcmp(ION_ART_LEAF_KEY(node), bytes, art->super.record.key_size)) ? (ion_art_leaf_t *) node : NULL;
+		}
+
+		if (0 != node->prefix_length) {
+			/* the prefix past what the node holds is left to the leaf to check */
+			if (0 != memcmp(node->prefix, bytes + depth, ION_ART_MIN(node->prefix_length, ION_ART_PREFIX_BYTES))) {
+				return NULL;
+			}
+
+			depth += node->prefix_length;
+		}
+
+		child	= art_find_child(node, bytes[depth]);
+		node	= (NULL == child) ? NULL : *child;
+		depth++;
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Unlinks the leaf holding a key, given as its bytes, from below
+			a link, @p depth bytes into the key.
+@return		The leaf, the first of those with the key, or @c NULL if no
+			record has it.
+*/
+static ion_art_leaf_t *
+art_remove_leaf(
+	ion_art_t		*art,
+	ion_art_node_t	**link,
+	ion_byte_t		*bytes,
+	int				depth
+) {
+	ion_key_size_t	key_size	= art->super.record.key_size;
+	ion_art_node_t	*node		= *link;
+	ion_art_node_t	**child;
+	ion_art_leaf_t	*leaf;
+
+	if (NULL == node) {
+		return NULL;
+	}
+
+	if (ION_ART_LEAF == node->type) {
+		if (0 != memcmp(ION_ART_LEAF_KEY(node), bytes, key_size)) {
+			return NULL;
+		}
+
+		*link = NULL;
+		return (ion_art_leaf_t *) node;
+	}
+
+	if (0 != node->prefix_length) {
+		if (0 != memcmp(node->prefix, bytes + depth, ION_ART_MIN(node->prefix_length, ION_ART_PREFIX_BYTES))) {
+			return NULL;
+		}
+
+		depth += node->prefix_length;
+	}
+
+	if (NULL == (child = art_find_child(node, bytes[depth]))) {
+		return NULL;
+	}
+
+	if (ION_ART_LEAF != (*child)->type) {
+		return art_remove_leaf(art, child, bytes, depth + 1);
+	}
+
+	leaf = (ion_art_leaf_t *) *child;
+
+	if (0 != memcmp(ION_ART_LEAF_KEY(leaf), bytes, key_size)) {
+		return NULL;
+	}
+
+	art_remove_child(link, node, bytes[depth], child);
+
+	return leaf;
+}
+
+/**
+@brief		Frees a node, or a leaf and its duplicates, and everything
+			below it.
+*/
+static void
+art_free(
+	ion_art_node_t *node
+) {
+	ion_art_leaf_t	*leaf;
+	ion_art_node_t	*child;
+	int				byte = 0;
+
+	if (ION_ART_LEAF == node->type) {
+		while (NULL != node) {
+			leaf	= ((ion_art_leaf_t *) node)->duplicate;
+			ion_free(node);
+			node	= (ion_art_node_t *) leaf;
+		}
+
+		return;
+	}
+
+	while (NULL != (child = art_next_child(node, byte, &byte))) {
+		art_free(child);
+		byte++;
+	}
+
+	ion_free(node);
+}
+
+ion_err_t
+art_initialize(
+	ion_art_t			*art,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size
+) {
+	art->super.key_type				= key_type;
+	art->super.record.key_size		= key_size;
+	art->super.record.value_size	= value_size;
+	art->root						= NULL;
+	art->count						= 0;
+
+	if (NULL == (art->key = ion_alloc(ion_alloc_buffer, key_size))) {
+		return err_out_of_memory;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+art_destroy(
+	ion_art_t *art
+) {
+	if (NULL != art->root) {
+		art_free(art->root);
+	}
+
+	ion_free(art->key);
+	art->root	= NULL;
+	art->key	= NULL;
+	art->count	= 0;
+
+	return err_ok;
+}
+
+ion_status_t
+art_insert(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	ion_art_leaf_t	*leaf;
+	ion_err_t		err;
+
+	if (NULL == (leaf = ion_alloc(ion_alloc_node, sizeof(ion_art_leaf_t) + art->super.record.key_size + art->super.record.value_size))) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	leaf->type		= ION_ART_LEAF;
+	leaf->duplicate = NULL;
+	art_encode_key(art, key, ION_ART_LEAF_KEY(leaf));
+	memcpy(ION_ART_LEAF_VALUE(art, leaf), value, art->super.record.value_size);
+
+	if (err_ok != (err = art_insert_leaf(art, &art->root, leaf, 0))) {
+		ion_free(leaf);
+		return ION_STATUS_ERROR(err);
+	}
+
+	art->count++;
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+art_get_ref(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t *value
+) {
+	ion_art_leaf_t *leaf;
+
+	art_encode_key(art, key, art->key);
+
+	if (NULL == (leaf = art_search(art, art->key))) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	*value = ION_ART_LEAF_VALUE(art, leaf);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+art_query(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	ion_value_t		stored;
+	ion_status_t	status = art_get_ref(art, key, &stored);
+
+	if (err_ok == status.error) {
+		memcpy(value, stored, art->super.record.value_size);
+	}
+
+	return status;
+}
+
+ion_status_t
+art_update(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	ion_status_t	status = ION_STATUS_INITIALIZE;
+	ion_art_leaf_t	*leaf;
+
+	art_encode_key(art, key, art->key);
+
+	if (NULL == (leaf = art_search(art, art->key))) {
+		return art_insert(art, key, value);
+	}
+
+	for (; NULL != leaf; leaf = leaf->duplicate) {
+		memcpy(ION_ART_LEAF_VALUE(art, leaf), value, art->super.record.value_size);
+		status.count++;
+	}
+
+	status.error = err_ok;
+
+	return status;
+}
+
+ion_status_t
+art_delete(
+	ion_art_t	*art,
+	ion_key_t	key
+) {
+	ion_status_t	status = ION_STATUS_INITIALIZE;
+	ion_art_leaf_t	*leaf;
+	ion_art_leaf_t	*next;
+
+	status.error = err_item_not_found;
+	art_encode_key(art, key, art->key);
+
+	for (leaf = art_remove_leaf(art, &art->root, art->key, 0); NULL != leaf; leaf = next) {
+		next			= leaf->duplicate;
+		ion_free(leaf);
+		art->count--;
+		status.count++;
+		status.error	= err_ok;
+	}
+
+	return status;
+}
+
+/**
+@brief		Moves an iterator down to the least leaf below a node.
+*/
+static void
+art_iterator_leftmost(
+	ion_art_iterator_t	*iterator,
+	ion_art_node_t		*node
+) {
+	ion_art_frame_t *frame;
+
+	while (ION_ART_LEAF != node->type) {
+		frame		= &iterator->frames[iterator->depth++];
+		frame->node = node;
+		node		= art_next_child(node, 0, &frame->byte);
+	}
+
+	iterator->leaf = (ion_art_leaf_t *) node;
+}
+
+/**
+@brief		Moves an iterator on to the least leaf past the child it last
+			went down to.
+*/
+static void
+art_iterator_ascend(
+	ion_art_iterator_t *iterator
+) {
+	ion_art_frame_t *frame;
+	ion_art_node_t	*child;
+
+	for (; iterator->depth > 0; iterator->depth--) {
+		frame = &iterator->frames[iterator->depth - 1];
+
+		if (NULL != (child = art_next_child(frame->node, frame->byte + 1, &frame->byte))) {
+			art_iterator_leftmost(iterator, child);
+			return;
+		}
+	}
+
+	iterator->leaf = NULL;
+}
+
+ion_err_t
+art_iterator_start(
+	ion_art_t			*art,
+	ion_art_iterator_t	*iterator,
+	ion_byte_t			*key
+) {
+	ion_art_node_t	*node	= art->root;
+	int				depth	= 0;
+	ion_art_frame_t *frame;
+	ion_art_node_t	*child;
+	ion_byte_t		*least;
+	ion_byte_t		byte;
+	ion_key_size_t	i;
+
+	iterator->art	= art;
+	iterator->depth = 0;
+	iterator->leaf	= NULL;
+
+	/* every inner node on a path takes at least a byte of the key */
+	if (NULL == (iterator->frames = ion_alloc(ion_alloc_cursor, art->super.record.key_size * sizeof(ion_art_frame_t)))) {
+		return err_out_of_memory;
+	}
+
+	if (NULL == node) {
+		return err_ok;
+	}
+
+	if (NULL == key) {
+		art_iterator_leftmost(iterator, node);
+		return err_ok;
+	}
+
+	while (ION_ART_LEAF != node->type) {
+		least = (node->prefix_length > ION_ART_PREFIX_BYTES) ? ION_ART_LEAF_KEY(art_minimum(node)) + depth : NULL;
+
+		for (i = 0; i < node->prefix_length; i++) {
+			byte = (i < ION_ART_PREFIX_BYTES) ? node->prefix[i] : least[i];
+
+			if (byte != key[depth + i]) {
+				/* the keys below all part from the key the same way */
+				if (byte > key[depth + i]) {
+					art_iterator_leftmost(iterator, node);
+				}
+				else {
+					art_iterator_ascend(iterator);
+				}
+
+				return err_ok;
+			}
+		}
+
+		depth	+= node->prefix_length;
+		frame	= &iterator->frames[iterator->depth];
+
+		if (NULL == (child = art_next_child(node, key[depth], &frame->byte))) {
+			art_iterator_ascend(iterator);
+			return err_ok;
+		}
+
+		frame->node = node;
+		iterator->depth++;
+
+		if (frame->byte != key[depth]) {
+			art_iterator_leftmost(iterator, child);
+			return err_ok;
+		}
+
+		node = child;
+		depth++;
+	}
+
+	if (memcmp(ION_ART_LEAF_KEY(node), key, art->super.record.key_size) >= 0) {
+		iterator->leaf = (ion_art_leaf_t *) node;
+	}
+	else {
+		art_iterator_ascend(iterator);
+	}
+
+	return err_ok;
+}
+
+void
+art_iterator_next(
+	ion_art_iterator_t *iterator
+) {
+	if (NULL != iterator->leaf->duplicate) {
+		iterator->leaf = iterator->leaf->duplicate;
+		return;
+	}
+
+	art_iterator_ascend(iterator);
+}
+
+void
+art_iterator_stop(
+	ion_art_iterator_t *iterator
+) {
+	ion_free(iterator->frames);
+	iterator->frames	= NULL;
+	iterator->leaf		= NULL;
+}
@@ -0,0 +1,372 @@
+/******************************************************************************/
+/**
+@file
+@brief		An in-memory adaptive radix tree.
+@details	Keys are stored as bytes that compare, one after another, in
+			the order of the dictionary's keys: numeric keys most
+			significant byte first, signed ones with the sign bit flipped,
+			and strings zeroed after their terminator. A search then reads
+			one byte of the key per level of the tree and compares the key
+			once, at the leaf.
+
+			Inner nodes come in four sizes, holding up to 4, 16, 48 and 256
+			children, and grow or shrink to fit as children come and go.
+			The bytes every key under a node shares are kept in the node
+			rather than as a chain of nodes with one child, the first
+			@ref ION_ART_PREFIX_BYTES of them in the node itself and the
+			rest read off a leaf when needed.
+
+			Records with the same key are kept in a chain from the first,
+			in the order they were inserted.
+*/
+/******************************************************************************/
+
+#if !defined(ART_H_)
+#define ART_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		How many bytes of the prefix shared below a node the node
+			holds. Longer prefixes are read off a leaf.
+*/
+#if !defined(ION_ART_PREFIX_BYTES)
+#if defined(ARDUINO)
+#define ION_ART_PREFIX_BYTES 4
+#else
+#define ION_ART_PREFIX_BYTES 8
+#endif
+#endif
+
+/**
+@brief		The kinds of node in a tree, the first byte of each.
+*/
+#define ION_ART_LEAF	0
+#define ION_ART_NODE4	1
+#define ION_ART_NODE16	2
+#define ION_ART_NODE48	3
+#define ION_ART_NODE256 4
+
+/**
+@brief		The header of every inner node.
+*/
+typedef struct art_node {
+	ion_byte_t		type;		/**< One of the node kinds */
+	int				children;	/**< How many children the node has */
+	ion_key_size_t	prefix_length;	/**< How many bytes every key below
+									 the node shares past its parent */
+	ion_byte_t		prefix[ION_ART_PREFIX_BYTES];	/**< The first of those
+													 bytes */
+} ion_art_node_t;
+
+/**
+@brief		A node of up to 4 children, kept in order of their bytes.
+*/
+typedef struct {
+	ion_art_node_t	super;			/**< The header */
+	ion_byte_t		keys[4];		/**< The byte of each child */
+	ion_art_node_t	*child[4];		/**< The children */
+} ion_art_node4_t;
+
+/**
+@brief		A node of up to 16 children, kept in order of their bytes.
+*/
+typedef struct {
+	ion_art_node_t	super;			/**< The header */
+	ion_byte_t		keys[16];		/**< The byte of each child */
+	ion_art_node_t	*child[16];		/**< The children */
+} ion_art_node16_t;
+
+/**
+@brief		A node of up to 48 children, found through an index of every
+			byte.
+*/
+typedef struct {
+	ion_art_node_t	super;			/**< The header */
+	ion_byte_t		index[256];		/**< Per byte, 1 more than the slot of
+									 its child, or 0 for none */
+	ion_art_node_t	*child[48];		/**< The children */
+} ion_art_node48_t;
+
+/**
+@brief		A node with a child for every byte.
+*/
+typedef struct {
+	ion_art_node_t	super;			/**< The header */
+	ion_art_node_t	*child[256];	/**< The child of each byte, or
+									 @c NULL */
+} ion_art_node256_t;
+
+/**
+@brief		A record of a tree. Its key bytes, then its value, follow it in
+			the same piece of memory.
+*/
+typedef struct art_leaf {
+	ion_byte_t		type;		/**< @ref ION_ART_LEAF, where an inner node
+								 keeps its kind */
+	struct art_leaf *duplicate;	/**< The next record with the same key, or
+								 @c NULL */
+} ion_art_leaf_t;
+
+/**
+@brief		The key bytes of a leaf.
+*/
+#define ION_ART_LEAF_KEY(leaf)			((ion_byte_t *) ((ion_art_leaf_t *) (leaf) + 1))
+
+/**
+@brief		The value of a leaf of a tree.
+*/
+#define ION_ART_LEAF_VALUE(art, leaf)	(ION_ART_LEAF_KEY(leaf) + (art)->super.record.key_size)
+
+/**
+@brief		Struct used to maintain an instance of an adaptive radix tree.
+*/
+typedef struct art {
+	ion_dictionary_parent_t super;
+	ion_art_node_t			*root;	/**< The root node or leaf, @c NULL when
+									 the tree is empty */
+	unsigned long			count;	/**< The records held */
+	ion_byte_t				*key;	/**< Room for the bytes of a key being
+									 looked up */
+} ion_art_t;
+
+/**
+@brief		A node an iterator went down through, and the byte of the
+			child it took.
+*/
+typedef struct {
+	ion_art_node_t	*node;		/**< The node */
+	int				byte;		/**< The byte of the child taken */
+} ion_art_frame_t;
+
+/**
+@brief		A position among the records of a tree, in key order.
+@details	The tree must not change while an iterator is on it.
+*/
+typedef struct {
+	ion_art_t		*art;		/**< The tree */
+	int				depth;		/**< How many frames are in use */
+	ion_art_frame_t *frames;	/**< The nodes down to the leaf, a key's
+								 length worth */
+	ion_art_leaf_t	*leaf;		/**< The record, @c NULL past the last */
+} ion_art_iterator_t;
+
+/**
+@brief		Initializes an empty tree.
+
+@param		art
+				The tree to initialize.
+@param		key_type
+				The type of key that is being stored in the tree.
+@param		key_size
+				The size of key that is being stored in the tree.
+@param		value_size
+				The size of value that is being stored in the tree.
+@return		The status of the initialization.
+*/
+ion_err_t
+art_initialize(
+	ion_art_t			*art,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size
+);
+
+/**
+@brief		Frees every node and record of a tree.
+
+@param		art
+				The tree to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+art_destroy(
+	ion_art_t *art
+);
+
+/**
+@brief		Inserts a record, after any others with the same key.
+
+@param		art
+				The tree to insert into.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		The status of the insertion.
+*/
+ion_status_t
+art_insert(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t value
+);
+
+/**
+@brief		Looks up the value of the first record with a key.
+
+@param		art
+				The tree to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value.
+@return		The status of the query.
+*/
+ion_status_t
+art_query(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t value
+);
+
+/**
+@brief		Points at the value of the first record with a key, where the
+			tree holds it.
+
+@param		art
+				The tree to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value, valid until the tree next
+				changes.
+@return		The status of the query.
+*/
+ion_status_t
+art_get_ref(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t *value
+);
+
+/**
+@brief		Sets the value of every record with a key, inserting one if
+			there is none.
+
+@param		art
+				The tree to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		The status of the update; the count is the records changed
+			or inserted.
+*/
+ion_status_t
+art_update(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_value_t value
+);
+
+/**
+@brief		Removes every record with a key.
+
+@param		art
+				The tree to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion; the count is the records
+			removed.
+*/
+ion_status_t
+art_delete(
+	ion_art_t	*art,
+	ion_key_t	key
+);
+
+/**
+@brief		Puts an iterator on the first record whose key is not less
+			than a key.
+
+@param		art
+				The tree to iterate over.
+@param		iterator
+				The iterator to start, whose @c leaf is @c NULL if there is
+				no such record.
+@param		key
+				The key to start from, its bytes as @ref art_encode_key
+				gives them, or @c NULL to start from the first record.
+@return		The status of the start. Unless it is @c err_ok, there is
+			nothing to stop.
+*/
+ion_err_t
+art_iterator_start(
+	ion_art_t			*art,
+	ion_art_iterator_t	*iterator,
+	ion_byte_t			*key
+);
+
+/**
+@brief		Moves an iterator on to the next record, in key order, those
+			with the same key in the order they were inserted.
+
+@param		iterator
+				The iterator to move, which is on a record.
+*/
+void
+art_iterator_next(
+	ion_art_iterator_t *iterator
+);
+
+/**
+@brief		Frees the memory of an iterator.
+
+@param		iterator
+				The iterator to stop.
+*/
+void
+art_iterator_stop(
+	ion_art_iterator_t *iterator
+);
+
+/**
+@brief		Writes the bytes a tree stores a key as, which compare with
+			@c memcmp as the keys compare.
+
+@param		art
+				The tree.
+@param		key
+				The key.
+@param		bytes
+				Receives the key size of bytes.
+*/
+void
+art_encode_key(
+	ion_art_t	*art,
+	ion_key_t	key,
+	ion_byte_t	*bytes
+);
+
+/**
+@brief		Writes the key that a tree stores as some bytes.
+
+@param		art
+				The tree.
+@param		bytes
+				The bytes, as @ref art_encode_key gives them.
+@param		key
+				Receives the key.
+*/
+void
+art_decode_key(
+	ion_art_t	*art,
+	ion_byte_t	*bytes,
+	ion_key_t	key
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ART_H_ */
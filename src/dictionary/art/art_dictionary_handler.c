@@ -0,0 +1,366 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for an adaptive radix tree.
+*/
+/******************************************************************************/
+
+#include "art_dictionary_handler.h"
+
+/**
+@brief		Moves a cursor from its record on to the first one, in key
+			order, that satisfies its predicate.
+@return		@c cs_valid_data, or @c cs_end_of_results once no record left
+			can.
+*/
+static ion_cursor_status_t
+artdict_scan(
+	ion_artdict_cursor_t *cursor
+) {
+	ion_art_t		*art		= (ion_art_t *) cursor->super.dictionary->instance;
+	ion_key_size_t	key_size	= art->super.record.key_size;
+	ion_predicate_t *predicate	= cursor->super.predicate;
+	ion_byte_t		*bytes;
+
+	for (; NULL != cursor->iterator.leaf; art_iterator_next(&cursor->iterator)) {
+		bytes = ION_ART_LEAF_KEY(cursor->iterator.leaf);
+
+		/* the records are in key order, so nothing past the key or the upper bound can match */
+		if ((predicate_equality == predicate->type) && (0 != memcmp(bytes, cursor->bound, key_size))) {
+			break;
+		}
+
+		if ((predicate_range == predicate->type) && (0 < memcmp(bytes, cursor->bound, key_size))) {
+			break;
+		}
+
+		if (predicate_predicate != predicate->type) {
+			return cs_valid_data;
+		}
+
+		art_decode_key(art, bytes, cursor->key);
+
+		if (boolean_true == test_record_predicate(&cursor->super, cursor->key, ION_ART_LEAF_VALUE(art, cursor->iterator.leaf))) {
+			return cs_valid_data;
+		}
+	}
+
+	return cs_end_of_results;
+}
+
+ion_cursor_status_t
+artdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_artdict_cursor_t	*artdict_cursor = (ion_artdict_cursor_t *) cursor;
+	ion_art_t				*art			= (ion_art_t *) cursor->dictionary->instance;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active == cursor->status) {
+		art_iterator_next(&artdict_cursor->iterator);
+
+		if (cs_end_of_results == artdict_scan(artdict_cursor)) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else {
+		return cs_invalid_cursor;
+	}
+
+	art_decode_key(art, ION_ART_LEAF_KEY(artdict_cursor->iterator.leaf), record->key);
+	memcpy(record->value, ION_ART_LEAF_VALUE(art, artdict_cursor->iterator.leaf), art->super.record.value_size);
+
+	return cursor->status;
+}
+
+ion_err_t
+artdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_art_t				*art		= (ion_art_t *) dictionary->instance;
+	ion_key_size_t			key_size	= art->super.record.key_size;
+	ion_artdict_cursor_t	*artdict_cursor;
+	ion_byte_t				*start		= NULL;
+	ion_err_t				err;
+
+	if (NULL == (artdict_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_artdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	/* room for the bound, then a key */
+	if (NULL == (artdict_cursor->bound = ion_alloc(ion_alloc_cursor, 2 * key_size))) {
+		ion_free(artdict_cursor);
+		return err_out_of_memory;
+	}
+
+	artdict_cursor->key		= artdict_cursor->bound + key_size;
+
+	*cursor					= (ion_dict_cursor_t *) artdict_cursor;
+	(*cursor)->dictionary	= dictionary;
+	(*cursor)->status		= cs_cursor_uninitialized;
+	(*cursor)->destroy		= artdict_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
+	(*cursor)->next			= artdict_next;
+
+	if (NULL == ((*cursor)->predicate = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(artdict_cursor->bound);
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			/* the predicate may be destroyed while the cursor is open, so keep a copy of its key */
+			if (NULL == ((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(artdict_cursor->bound);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+			art_encode_key(art, predicate->statement.equality.equality_value, artdict_cursor->bound);
+			start = artdict_cursor->bound;
+			break;
+		}
+
+		case predicate_range: {
+			if (NULL == ((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(artdict_cursor->bound);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			if (NULL == ((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(artdict_cursor->bound);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+
+			/* the key is free until the first filter, so it holds the lower bound for the start */
+			art_encode_key(art, predicate->statement.range.lower_bound, artdict_cursor->key);
+			art_encode_key(art, predicate->statement.range.upper_bound, artdict_cursor->bound);
+			start = artdict_cursor->key;
+			break;
+		}
+
+		case predicate_predicate: {
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			break;
+		}
+
+		case predicate_all_records: {
+			break;
+		}
+
+		default: {
+			ion_free((*cursor)->predicate);
+			ion_free(artdict_cursor->bound);
+			ion_free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	if (err_ok != (err = art_iterator_start(art, &artdict_cursor->iterator, start))) {
+		(*cursor)->predicate->destroy(&(*cursor)->predicate);
+		ion_free(artdict_cursor->bound);
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err;
+	}
+
+	(*cursor)->status = (cs_valid_data == artdict_scan(artdict_cursor)) ? cs_cursor_initialized : cs_end_of_results;
+
+	return err_ok;
+}
+
+ion_err_t
+artdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_art_t	*art;
+	ion_err_t	err;
+
+	UNUSED(id);
+	UNUSED(dictionary_size);
+
+	if (NULL == (art = ion_alloc(ion_alloc_other, sizeof(ion_art_t)))) {
+		return err_out_of_memory;
+	}
+
+	art->super.compare	= compare;
+
+	err					= art_initialize(art, key_type, key_size, value_size);
+
+	if (err_ok != err) {
+		ion_free(art);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) art;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_err_t
+artdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+ion_err_t
+artdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+ion_err_t
+artdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = art_destroy((ion_art_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+artdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return art_insert((ion_art_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+artdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return art_query((ion_art_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+artdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return art_get_ref((ion_art_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+artdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return art_update((ion_art_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+artdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return art_delete((ion_art_t *) dictionary->instance, key);
+}
+
+void
+artdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_artdict_cursor_t *artdict_cursor = (ion_artdict_cursor_t *) *cursor;
+
+	art_iterator_stop(&artdict_cursor->iterator);
+	ion_free(artdict_cursor->bound);
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+/**
+@brief		Tells the size of an adaptive radix tree dictionary, see
+			@ref dictionary_get_info. Only its records are counted.
+*/
+static ion_err_t
+artdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_art_t *art = (ion_art_t *) dictionary->instance;
+
+	info->record_count	= (long) art->count;
+	info->file_bytes	= 0;
+
+	return err_ok;
+}
+
+void
+artdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= artdict_insert;
+	handler->create_dictionary	= artdict_create_dictionary;
+	handler->get				= artdict_query;
+	handler->update				= artdict_update;
+	handler->find				= artdict_find;
+	handler->remove				= artdict_delete;
+	handler->delete_dictionary	= artdict_delete_dictionary;
+	handler->open_dictionary	= artdict_open_dictionary;
+	handler->close_dictionary	= artdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= artdict_get_ref;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= artdict_get_info;
+	handler->bulk_load			= NULL;
+}
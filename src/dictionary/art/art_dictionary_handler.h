@@ -0,0 +1,277 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for an adaptive radix tree.
+*/
+/******************************************************************************/
+
+#if !defined(ART_DICTIONARY_HANDLER_H_)
+#define ART_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "art.h"
+
+/**
+@brief		A cursor over an adaptive radix tree.
+@details	The records are read in key order, from the lower bound of an
+			equality or range predicate. Changing the tree invalidates the
+			cursors open on it.
+*/
+typedef struct artdict_cursor {
+	ion_dict_cursor_t	super;		/**< Cursor supertype this type inherits
+									 from */
+	ion_art_iterator_t	iterator;	/**< The position of the record returned
+									 next */
+	ion_byte_t			*bound;		/**< The bytes of the key of an equality
+									 predicate or the upper bound of a range,
+									 as the tree stores them */
+	ion_byte_t			*key;		/**< Room for the key of a record tested
+									 against a filter */
+} ion_artdict_cursor_t;
+
+/**
+@brief		Registers the adaptive radix tree handler.
+
+@details	Registers functions for handlers. This only needs to be called
+			once for each type of dictionary that is present.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+artdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Inserts a record into an adaptive radix tree dictionary, after
+			any others with the same key.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+artdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value of the first record with a key.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+artdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at the value of the first record with a key, for
+			@ref dictionary_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the query, see @ref art_get_ref.
+*/
+ion_status_t
+artdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Creates an adaptive radix tree dictionary.
+
+@param		id
+				The identifier of the dictionary, unused as the tree is
+				only in memory.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				Unused, as the tree grows with its records.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+artdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes every record with a key.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+artdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes an adaptive radix tree dictionary and its records.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+artdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the value of every record with a key, inserting one
+			if there is none.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+artdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+artdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of an adaptive radix tree cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+artdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys an adaptive radix tree cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+artdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opening is not implemented, as the tree is only in memory.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		@c err_not_implemented.
+*/
+ion_err_t
+artdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closing is not implemented, as the tree is only in memory.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		@c err_not_implemented.
+*/
+ion_err_t
+artdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ART_DICTIONARY_HANDLER_H_ */
@@ -0,0 +1,564 @@
+/******************************************************************************/
+/**
+@file
+@brief		Asynchronous dictionary operations, run by a pool of worker
+			threads.
+*/
+/******************************************************************************/
+
+#include "dictionary_async.h"
+#include "../ion_memory_budget.h"
+
+/**
+@brief		The worker that runs every operation on a dictionary.
+@details	Dictionaries are rarely closer together than the size of one,
+			so the address is counted in those, and its high bits folded
+			in for dictionaries kept in larger structures.
+*/
+static ion_async_worker_t *
+dictionary_async_worker(
+	ion_async_pool_t	*pool,
+	ion_dictionary_t	*dictionary
+) {
+	uintptr_t address = (uintptr_t) dictionary / sizeof(ion_dictionary_t);
+
+	return &pool->worker[(address ^ (address >> 7)) % (uintptr_t) pool->workers];
+}
+
+/**
+@brief		Makes the operation of a request.
+*/
+static ion_status_t
+dictionary_async_run(
+	ion_async_request_t *request
+) {
+	switch (request->op) {
+		case async_op_get:
+			return dictionary_get(request->dictionary, request->key, request->value);
+
+		case async_op_insert:
+			return dictionary_insert(request->dictionary, request->key, request->value);
+
+		case async_op_update:
+			return dictionary_update(request->dictionary, request->key, request->value);
+
+		case async_op_delete:
+			return dictionary_delete(request->dictionary, request->key);
+
+		case async_op_open:
+			return ION_STATUS_ERROR(dictionary_open(request->handler, request->dictionary, request->config));
+
+		case async_op_call:
+			return request->call(request);
+	}
+
+	return ION_STATUS_ERROR(err_illegal_state);
+}
+
+/**
+@brief		Runs the requests queued for a worker, until the pool stops
+			and none are left.
+*/
+static void *
+dictionary_async_loop(
+	void *argument
+) {
+	ion_async_worker_t	*worker = argument;
+	ion_async_pool_t	*pool	= worker->pool;
+	ion_async_request_t *request;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (boolean_true) {
+		while (NULL == worker->head && !pool->stopping) {
+			pthread_cond_wait(&worker->ready, &pool->lock);
+		}
+
+		if (NULL == worker->head) {
+			break;
+		}
+
+		request			= worker->head;
+		worker->head	= request->next;
+
+		if (NULL == worker->head) {
+			worker->tail = NULL;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+		request->status = dictionary_async_run(request);
+		pthread_mutex_lock(&pool->lock);
+
+		request->done	= boolean_true;
+		request->next	= NULL;
+
+		if (NULL != request->callback) {
+			/* the callback may submit, which takes the lock */
+			pthread_mutex_unlock(&pool->lock);
+			request->callback(request, request->context);
+			pthread_mutex_lock(&pool->lock);
+			continue;
+		}
+
+		if (NULL == pool->done_tail) {
+			pool->done_head = request;
+		}
+		else {
+			pool->done_tail->next = request;
+		}
+
+		pool->done_tail = request;
+		pool->pending--;
+		pthread_cond_broadcast(&pool->completed);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+ion_err_t
+dictionary_async_start(
+	ion_async_pool_t	*pool,
+	int					workers
+) {
+	int i;
+
+	if ((workers < 1) || (workers > ION_ASYNC_MAX_WORKERS)) {
+		return err_invalid_initial_size;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->completed, NULL);
+	pool->workers	= workers;
+	pool->stopping	= boolean_false;
+	pool->pending	= 0;
+	pool->done_head = NULL;
+	pool->done_tail = NULL;
+
+	for (i = 0; i < workers; i++) {
+		pool->worker[i].pool	= pool;
+		pool->worker[i].head	= NULL;
+		pool->worker[i].tail	= NULL;
+		pthread_cond_init(&pool->worker[i].ready, NULL);
+	}
+
+	for (i = 0; i < workers; i++) {
+		if (0 != pthread_create(&pool->worker[i].thread, NULL, dictionary_async_loop, &pool->worker[i])) {
+			/* the workers started stop at once, as nothing was submitted */
+			pool->workers = i;
+			dictionary_async_stop(pool);
+
+			for (; i < workers; i++) {
+				pthread_cond_destroy(&pool->worker[i].ready);
+			}
+
+			return err_dictionary_initialization_failed;
+		}
+	}
+
+	return err_ok;
+}
+
+void
+dictionary_async_stop(
+	ion_async_pool_t *pool
+) {
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = boolean_true;
+
+	for (i = 0; i < pool->workers; i++) {
+		pthread_cond_signal(&pool->worker[i].ready);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->workers; i++) {
+		pthread_join(pool->worker[i].thread, NULL);
+		pthread_cond_destroy(&pool->worker[i].ready);
+	}
+
+	pthread_cond_destroy(&pool->completed);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+ion_err_t
+dictionary_async_submit_to(
+	ion_async_pool_t	*pool,
+	int					worker,
+	ion_async_request_t *request
+) {
+	ion_async_worker_t *queue;
+
+	pthread_mutex_lock(&pool->lock);
+
+	if (pool->stopping) {
+		pthread_mutex_unlock(&pool->lock);
+		return err_illegal_state;
+	}
+
+	queue			= &pool->worker[(unsigned int) worker % (unsigned int) pool->workers];
+	request->done	= boolean_false;
+	request->next	= NULL;
+
+	if (NULL == queue->tail) {
+		queue->head = request;
+	}
+	else {
+		queue->tail->next = request;
+	}
+
+	queue->tail = request;
+
+	if (NULL == request->callback) {
+		pool->pending++;
+	}
+
+	pthread_cond_signal(&queue->ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	return err_ok;
+}
+
+ion_err_t
+dictionary_async_submit(
+	ion_async_pool_t	*pool,
+	ion_async_request_t *request
+) {
+	return dictionary_async_submit_to(pool, (int) (dictionary_async_worker(pool, request->dictionary) - pool->worker), request);
+}
+
+/**
+@brief		Fills in a request and submits it.
+*/
+static ion_err_t
+dictionary_async_prepare(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_async_op_t			op,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+) {
+	request->op			= op;
+	request->dictionary = dictionary;
+	request->key		= key;
+	request->value		= value;
+	request->handler	= NULL;
+	request->config		= NULL;
+	request->call		= NULL;
+	request->argument	= NULL;
+	request->status		= ION_STATUS_INITIALIZE;
+	request->callback	= callback;
+	request->context	= context;
+
+	return dictionary_async_submit(pool, request);
+}
+
+ion_err_t
+dictionary_async_get(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+) {
+	return dictionary_async_prepare(pool, request, async_op_get, dictionary, key, value, callback, context);
+}
+
+ion_err_t
+dictionary_async_insert(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+) {
+	return dictionary_async_prepare(pool, request, async_op_insert, dictionary, key, value, callback, context);
+}
+
+ion_err_t
+dictionary_async_update(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+) {
+	return dictionary_async_prepare(pool, request, async_op_update, dictionary, key, value, callback, context);
+}
+
+ion_err_t
+dictionary_async_delete(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_async_callback_t	callback,
+	void					*context
+) {
+	return dictionary_async_prepare(pool, request, async_op_delete, dictionary, key, NULL, callback, context);
+}
+
+ion_err_t
+dictionary_async_open(
+	ion_async_pool_t				*pool,
+	ion_async_request_t				*request,
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_async_callback_t			callback,
+	void							*context
+) {
+	request->op			= async_op_open;
+	request->dictionary = dictionary;
+	request->key		= NULL;
+	request->value		= NULL;
+	request->handler	= handler;
+	request->config		= config;
+	request->call		= NULL;
+	request->argument	= NULL;
+	request->status		= ION_STATUS_INITIALIZE;
+	request->callback	= callback;
+	request->context	= context;
+
+	return dictionary_async_submit(pool, request);
+}
+
+ion_err_t
+dictionary_async_call(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	int						worker,
+	ion_dictionary_t		*dictionary,
+	ion_async_call_t		call,
+	void					*argument,
+	ion_async_callback_t	callback,
+	void					*context
+) {
+	request->op			= async_op_call;
+	request->dictionary = dictionary;
+	request->key		= NULL;
+	request->value		= NULL;
+	request->handler	= NULL;
+	request->config		= NULL;
+	request->call		= call;
+	request->argument	= argument;
+	request->status		= ION_STATUS_INITIALIZE;
+	request->callback	= callback;
+	request->context	= context;
+
+	if (0 > worker) {
+		return dictionary_async_submit(pool, request);
+	}
+
+	return dictionary_async_submit_to(pool, worker, request);
+}
+
+#if ION_USING_MASTER_TABLE
+
+/**
+@brief		A dictionary being opened on a pool, and its config.
+*/
+typedef struct {
+	ion_async_request_t				request;	/**< The open */
+	ion_dictionary_config_info_t	config;		/**< The config opened */
+	ion_boolean_t					submitted;	/**< Whether it is in
+												 flight */
+} ion_async_opening_t;
+
+ion_err_t
+dictionary_async_open_dictionaries(
+	ion_async_pool_t			*pool,
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handlers,
+	ion_dictionary_t			*dictionaries,
+	ion_dictionary_id_t			*ids,
+	int							count,
+	ion_err_t					*errors
+) {
+	ion_async_opening_t				*openings	= NULL;
+	ion_dictionary_config_info_t	config;
+	ion_err_t						first		= err_ok;
+	int								i;
+
+	/* with a budget, an open resizes the dictionaries opening beside it */
+	if ((count > 1) && (0 == ion_budget_get(NULL))) {
+		openings = ion_alloc(ion_alloc_buffer, count * sizeof(ion_async_opening_t));
+	}
+
+	for (i = 0; i < count; i++) {
+		errors[i] = ion_mt_lookup(table, ids[i], &config);
+
+		if (err_ok != errors[i]) {
+			if (NULL != openings) {
+				openings[i].submitted = boolean_false;
+			}
+
+			continue;
+		}
+
+		if (NULL == openings) {
+			errors[i] = dictionary_open(&handlers[i], &dictionaries[i], &config);
+			continue;
+		}
+
+		openings[i].config		= config;
+		errors[i]				= dictionary_async_open(pool, &openings[i].request, &handlers[i], &dictionaries[i], &openings[i].config, NULL, NULL);
+		openings[i].submitted	= (err_ok == errors[i]);
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((NULL != openings) && openings[i].submitted) {
+			errors[i] = dictionary_async_wait(pool, &openings[i].request).error;
+		}
+
+		if ((err_ok == first) && (err_ok != errors[i])) {
+			first = errors[i];
+		}
+	}
+
+	ion_free(openings);
+
+	return first;
+}
+
+ion_err_t
+dictionary_async_open_by_use(
+	ion_async_pool_t			*pool,
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handlers,
+	ion_dictionary_t			*dictionaries,
+	ion_dictionary_id_t			*ids,
+	int							max,
+	ion_dict_use_t				use_type,
+	int							*count,
+	ion_err_t					*errors
+) {
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_id_t				id;
+	ion_err_t						error;
+
+	*count = 0;
+
+	for (id = table->id_base + 1; id < table->id_base + table->next_row; id++) {
+		error = ion_mt_lookup(table, id, &config);
+
+		if (err_item_not_found == error) {
+			continue;
+		}
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		if (use_type != config.use_type) {
+			continue;
+		}
+
+		if (*count < max) {
+			ids[*count] = id;
+		}
+
+		(*count)++;
+	}
+
+	return dictionary_async_open_dictionaries(pool, table, handlers, dictionaries, ids, (*count < max) ? *count : max, errors);
+}
+
+#endif /* ION_USING_MASTER_TABLE */
+
+ion_boolean_t
+dictionary_async_done(
+	ion_async_pool_t	*pool,
+	ion_async_request_t *request
+) {
+	ion_boolean_t done;
+
+	pthread_mutex_lock(&pool->lock);
+	done = request->done;
+	pthread_mutex_unlock(&pool->lock);
+
+	return done;
+}
+
+ion_status_t
+dictionary_async_wait(
+	ion_async_pool_t	*pool,
+	ion_async_request_t *request
+) {
+	ion_async_request_t *previous = NULL;
+	ion_async_request_t *completion;
+	ion_status_t		status;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (!request->done) {
+		pthread_cond_wait(&pool->completed, &pool->lock);
+	}
+
+	/* requests are mostly waited on in the order they complete, so it is near the head */
+	for (completion = pool->done_head; NULL != completion && request != completion; completion = completion->next) {
+		previous = completion;
+	}
+
+	if (NULL != completion) {
+		if (NULL == previous) {
+			pool->done_head = request->next;
+		}
+		else {
+			previous->next = request->next;
+		}
+
+		if (pool->done_tail == request) {
+			pool->done_tail = previous;
+		}
+
+		request->next = NULL;
+	}
+
+	status = request->status;
+	pthread_mutex_unlock(&pool->lock);
+
+	return status;
+}
+
+ion_async_request_t *
+dictionary_async_poll(
+	ion_async_pool_t	*pool,
+	ion_boolean_t		wait
+) {
+	ion_async_request_t *request;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (wait && NULL == pool->done_head && pool->pending > 0) {
+		pthread_cond_wait(&pool->completed, &pool->lock);
+	}
+
+	request = pool->done_head;
+
+	if (NULL != request) {
+		pool->done_head = request->next;
+
+		if (NULL == pool->done_head) {
+			pool->done_tail = NULL;
+		}
+
+		request->next = NULL;
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return request;
+}
@@ -0,0 +1,523 @@
+/******************************************************************************/
+/**
+@file
+@brief		Asynchronous dictionary operations, run by a pool of worker
+			threads.
+@details	A request is submitted and the call returns at once; a worker
+			then makes the operation on the dictionary, as
+			@ref dictionary_get and its siblings would, and completes the
+			request. The caller learns of it through a callback, by
+			polling the pool's completions, or by waiting on the request.
+			One thread can so keep many lookups on file-backed
+			dictionaries in flight, each blocking a worker rather than
+			the caller.
+
+			Dictionaries are not thread-safe, so each is given to one
+			worker, picked from its address, which makes its operations
+			one at a time and in the order they were submitted.
+			Operations on different dictionaries run side by side as far
+			as the workers allow. A dictionary with requests in flight
+			must not be used directly until they complete.
+
+			Dictionaries can be opened on a pool too, so that a program
+			starting up with many of them opens, and recovers, them side
+			by side rather than one after the other.
+
+			Only available on hosts with POSIX threads.
+*/
+/******************************************************************************/
+
+#if !defined(DICTIONARY_ASYNC_H_)
+#define DICTIONARY_ASYNC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <pthread.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../ion_master_table.h"
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		The most workers a pool runs.
+*/
+#if !defined(ION_ASYNC_MAX_WORKERS)
+#define ION_ASYNC_MAX_WORKERS 32
+#endif
+
+/**
+@brief		The operations a request can make.
+*/
+typedef enum ION_ASYNC_OP {
+	async_op_get,		/**< @ref dictionary_get */
+	async_op_insert,	/**< @ref dictionary_insert */
+	async_op_update,	/**< @ref dictionary_update */
+	async_op_delete,	/**< @ref dictionary_delete */
+	async_op_open,		/**< @ref dictionary_open */
+	async_op_call		/**< A function of the caller's, see
+						 @ref dictionary_async_call */
+} ion_async_op_t;
+
+typedef struct async_request ion_async_request_t;
+
+/**
+@brief		Work of the caller's made on the worker of a dictionary, in
+			turn with its other operations.
+@details	It is given the request, to read its dictionary and argument
+			from, and returns the status the request completes with.
+*/
+typedef ion_status_t (*ion_async_call_t)(
+	ion_async_request_t *request
+);
+
+/**
+@brief		Called by a worker once it has made the operation of a
+			request, with the context given on submission.
+@details	It runs on the worker, which makes no other operation until it
+			returns, so it should be brief. The request is the caller's
+			again by then, so it may be submitted anew, as may others.
+*/
+typedef void (*ion_async_callback_t)(
+	ion_async_request_t *request,
+	void *context
+);
+
+/**
+@brief		An operation submitted to a pool.
+@details	The caller owns its memory, and that of its key and value,
+			which must stay put until it completes. Its fields are the
+			pool's from submission to completion. Requests with a
+			callback complete when it is called; those without are
+			waited on or polled for.
+*/
+struct async_request {
+	ion_async_op_t					op;			/**< The operation to make */
+	ion_dictionary_t				*dictionary;/**< The dictionary to make it
+												 on */
+	ion_key_t						key;		/**< Its key */
+	ion_value_t						value;		/**< Its value, or room for the
+												 value of a get */
+	ion_dictionary_handler_t		*handler;	/**< The handler of a
+												 dictionary to open */
+	ion_dictionary_config_info_t	*config;	/**< Its config */
+	ion_async_call_t				call;		/**< The function a call
+												 makes */
+	void							*argument;	/**< What it works on */
+	ion_status_t					status;		/**< The status of the
+												 operation, once complete */
+	ion_async_callback_t			callback;	/**< Called on completion, or
+												 @c NULL to queue the
+												 request on the pool's
+												 completions */
+	void							*context;	/**< Passed to @p callback */
+	ion_boolean_t					done;		/**< Whether the request is
+												 complete */
+	ion_async_request_t				*next;		/**< The next request in the
+												 queue it is on */
+};
+
+/**
+@brief		The requests waiting for one worker, and its thread.
+*/
+typedef struct async_worker {
+	struct async_pool	*pool;	/**< The pool of the worker */
+	pthread_t			thread;	/**< The thread running the requests */
+	pthread_cond_t		ready;	/**< Signalled when a request is queued
+								 or the pool stops */
+	ion_async_request_t *head;	/**< The next request to run */
+	ion_async_request_t *tail;	/**< The last request submitted */
+} ion_async_worker_t;
+
+/**
+@brief		A pool of workers making dictionary operations.
+@details	One mutex guards the queues of every worker and the
+			completions. It is only held to move requests between them,
+			never during an operation.
+*/
+typedef struct async_pool {
+	pthread_mutex_t		lock;		/**< Guards the queues and flags */
+	pthread_cond_t		completed;	/**< Broadcast when a request
+									 completes */
+	int					workers;	/**< The number of workers */
+	ion_boolean_t		stopping;	/**< Whether the pool is stopping */
+	int					pending;	/**< Requests without a callback
+									 that have not completed */
+	ion_async_request_t *done_head;	/**< The oldest completion not
+									 polled yet */
+	ion_async_request_t *done_tail;	/**< The newest one */
+	ion_async_worker_t	worker[ION_ASYNC_MAX_WORKERS];
+	/**< The workers and their queues */
+} ion_async_pool_t;
+
+/**
+@brief		Starts the workers of a pool.
+
+@param		pool
+				The pool, allocated by the caller.
+@param		workers
+				How many workers to run, from 1 up to
+				@ref ION_ASYNC_MAX_WORKERS. As each dictionary is run by
+				one worker, more than the dictionaries used gains nothing.
+@return		@c err_ok, @c err_invalid_initial_size for a number of
+			workers out of range, or @c err_dictionary_initialization_failed
+			if the threads could not be started.
+*/
+ion_err_t
+dictionary_async_start(
+	ion_async_pool_t	*pool,
+	int					workers
+);
+
+/**
+@brief		Stops the workers of a pool, once they have made every
+			request already submitted.
+
+@param		pool
+				The pool to stop. Requests complete that were not yet
+				polled keep their status, but can no longer be polled.
+*/
+void
+dictionary_async_stop(
+	ion_async_pool_t *pool
+);
+
+/**
+@brief		Submits a request whose fields are filled in.
+
+@param		pool
+				The pool to run the request.
+@param		request
+				The request. Its @c done and @c next fields are set here.
+@return		@c err_ok, or @c err_illegal_state if the pool is stopping,
+			in which case the request is not run.
+*/
+ion_err_t
+dictionary_async_submit(
+	ion_async_pool_t	*pool,
+	ion_async_request_t *request
+);
+
+/**
+@brief		Submits a request whose fields are filled in to one worker,
+			rather than the one picked from its dictionary's address.
+
+@details	Every request on a dictionary must go to the same worker, so
+			they are made one at a time and in order; a dictionary given
+			to a worker this way must not be submitted to otherwise.
+
+@param		pool
+				The pool to run the request.
+@param		worker
+				The worker to run it, taken modulo the number of workers.
+@param		request
+				The request.
+@return		The status of the submission, as for
+			@ref dictionary_async_submit.
+*/
+ion_err_t
+dictionary_async_submit_to(
+	ion_async_pool_t	*pool,
+	int					worker,
+	ion_async_request_t *request
+);
+
+/**
+@brief		Fills in a request to get the value of a key and submits it.
+
+@param		pool
+				The pool to run the request.
+@param		request
+				The request to fill in.
+@param		dictionary
+				The dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value, allocated by the caller.
+@param		callback
+				Called on completion, or @c NULL to queue the request on
+				the pool's completions.
+@param		context
+				Passed to @p callback.
+@return		The status of the submission.
+*/
+ion_err_t
+dictionary_async_get(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+);
+
+/**
+@brief		Fills in a request to insert a record and submits it.
+
+@see		@ref dictionary_async_get for the parameters.
+*/
+ion_err_t
+dictionary_async_insert(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+);
+
+/**
+@brief		Fills in a request to update a key and submits it.
+
+@see		@ref dictionary_async_get for the parameters.
+*/
+ion_err_t
+dictionary_async_update(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_async_callback_t	callback,
+	void					*context
+);
+
+/**
+@brief		Fills in a request to delete a key and submits it.
+
+@see		@ref dictionary_async_get for the parameters, less the
+			value.
+*/
+ion_err_t
+dictionary_async_delete(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	ion_dictionary_t		*dictionary,
+	ion_key_t				key,
+	ion_async_callback_t	callback,
+	void					*context
+);
+
+/**
+@brief		Fills in a request to make a call on the worker of a
+			dictionary and submits it there.
+
+@details	The call is made in turn with the other requests on the
+			dictionary, so it may use it, and cursors opened on it, as
+			though it were the only thread to. Wrappers over several
+			dictionaries so run every operation on each on its worker.
+
+@param		pool
+				The pool to run the request.
+@param		request
+				The request to fill in.
+@param		worker
+				The worker to run it, or -1 for the one picked from the
+				dictionary's address, see @ref dictionary_async_submit_to.
+@param		dictionary
+				The dictionary the call works on.
+@param		call
+				The function to call.
+@param		argument
+				What it works on, set in the request.
+@param		callback
+				Called on completion, or @c NULL to queue the request on
+				the pool's completions.
+@param		context
+				Passed to @p callback.
+@return		The status of the submission. The request's status is the
+			one @p call returns.
+*/
+ion_err_t
+dictionary_async_call(
+	ion_async_pool_t		*pool,
+	ion_async_request_t		*request,
+	int						worker,
+	ion_dictionary_t		*dictionary,
+	ion_async_call_t		call,
+	void					*argument,
+	ion_async_callback_t	callback,
+	void					*context
+);
+
+/**
+@brief		Fills in a request to open a dictionary and submits it.
+
+@param		pool
+				The pool to run the request.
+@param		request
+				The request to fill in.
+@param		handler
+				The initialized handler of the dictionary, which must stay
+				put while it is open.
+@param		dictionary
+				The dictionary to open.
+@param		config
+				Its config, which must stay put until the request
+				completes.
+@param		callback
+				Called on completion, or @c NULL to queue the request on
+				the pool's completions.
+@param		context
+				Passed to @p callback.
+@return		The status of the submission. The request's status holds
+			the error of @ref dictionary_open.
+*/
+ion_err_t
+dictionary_async_open(
+	ion_async_pool_t				*pool,
+	ion_async_request_t				*request,
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_async_callback_t			callback,
+	void							*context
+);
+
+#if ION_USING_MASTER_TABLE
+
+/**
+@brief		Opens dictionaries of the master table side by side, on the
+			workers of a pool, and waits for them all.
+@details	Their configs are looked up first, one by one, as the master
+			table is not shared between threads; only the opens, each
+			with whatever recovery its implementation makes, run on the
+			workers. The dictionaries are opened as
+			@ref dictionary_open opens them, not shared through the
+			cache of @ref ion_open_dictionary, and are closed with
+			@ref dictionary_close. With a memory budget set, opening one
+			resizes the others, so they are then opened one at a time.
+			So they are, should the memory to track the requests not be
+			had.
+
+@param		pool
+				The pool to open them on, with no other requests on these
+				dictionaries.
+@param		table
+				The open master table they are recorded in.
+@param		handlers
+				One initialized handler for each dictionary, which must
+				stay put while it is open.
+@param		dictionaries
+				Receives the dictionaries.
+@param		ids
+				Their IDs in @p table.
+@param		count
+				How many there are.
+@param		errors
+				Receives the result of each, @c err_ok for those open.
+@return		@c err_ok if all are open, otherwise the first error of
+			those that are not.
+*/
+ion_err_t
+dictionary_async_open_dictionaries(
+	ion_async_pool_t			*pool,
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handlers,
+	ion_dictionary_t			*dictionaries,
+	ion_dictionary_id_t			*ids,
+	int							count,
+	ion_err_t					*errors
+);
+
+/**
+@brief		Opens every dictionary of the master table with a given use,
+			side by side, as @ref dictionary_async_open_dictionaries
+			does.
+
+@param		pool
+				The pool to open them on.
+@param		table
+				The open master table they are recorded in.
+@param		handlers
+				Up to @p max initialized handlers, one for each dictionary
+				found, in the order of their IDs.
+@param		dictionaries
+				Receives the dictionaries.
+@param		ids
+				Receives their IDs.
+@param		max
+				The most to open.
+@param		use_type
+				The use of the dictionaries to open.
+@param		count
+				Receives how many there are, which may be more than
+				@p max, in which case the first @p max are opened.
+@param		errors
+				Receives the result of each opened.
+@return		@c err_ok if all those found are open, an error reading
+			@p table, or the first error opening one.
+*/
+ion_err_t
+dictionary_async_open_by_use(
+	ion_async_pool_t			*pool,
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handlers,
+	ion_dictionary_t			*dictionaries,
+	ion_dictionary_id_t			*ids,
+	int							max,
+	ion_dict_use_t				use_type,
+	int							*count,
+	ion_err_t					*errors
+);
+
+#endif /* ION_USING_MASTER_TABLE */
+
+/**
+@brief		Whether a request has completed, without waiting.
+
+@param		pool
+				The pool running the request.
+@param		request
+				A request without a callback.
+@return		@c boolean_true once its status can be read.
+*/
+ion_boolean_t
+dictionary_async_done(
+	ion_async_pool_t	*pool,
+	ion_async_request_t *request
+);
+
+/**
+@brief		Waits until a request completes.
+
+@param		pool
+				The pool running the request.
+@param		request
+				A request without a callback, which is taken off the
+				completions, so it is not polled as well.
+@return		The status of its operation.
+*/
+ion_status_t
+dictionary_async_wait(
+	ion_async_pool_t	*pool,
+	ion_async_request_t *request
+);
+
+/**
+@brief		Takes the oldest completed request without a callback off
+			the pool's completions.
+
+@param		pool
+				The pool to poll.
+@param		wait
+				Whether to wait for a request to complete if none has,
+				as long as any are in flight.
+@return		The request, or @c NULL if none has completed.
+*/
+ion_async_request_t *
+dictionary_async_poll(
+	ion_async_pool_t	*pool,
+	ion_boolean_t		wait
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* DICTIONARY_ASYNC_H_ */
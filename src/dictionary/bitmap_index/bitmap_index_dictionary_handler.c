@@ -0,0 +1,741 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that keeps bitmap indexes on fields of the values of
+			a dictionary of any other handler.
+*/
+/******************************************************************************/
+
+#include "bitmap_index_dictionary_handler.h"
+
+/**
+@brief		The rows the row table first makes room for.
+*/
+#define ION_BIDX_INITIAL_ROWS	16
+
+/**
+@brief		The key of a row.
+*/
+#define ION_BIDX_ROW_KEY(index_dict, row)	((index_dict)->row_keys + (size_t) (row) * (index_dict)->super.record.key_size)
+
+/**
+@brief		Finds a value of the field of an index.
+@return		Its entry, or the entry to insert it at less @c count plus
+			one if there is none, so that a negative result says it is
+			missing.
+*/
+static int
+bidxdict_find_value(
+	ion_bidx_index_t	*index,
+	ion_byte_t			*field_value
+) {
+	int low		= 0;
+	int high	= index->count;
+	int middle;
+	int order;
+
+	while (low < high) {
+		middle	= low + (high - low) / 2;
+		order	= memcmp(index->values + middle * index->field.size, field_value, index->field.size);
+
+		if (0 == order) {
+			return middle;
+		}
+
+		if (0 > order) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	return low - index->count - 1;
+}
+
+/**
+@brief		Adds a row to the bitmap of the value its record has for the
+			field of an index, making one if it is the first.
+*/
+static ion_err_t
+bidxdict_index_row(
+	ion_bidx_index_t	*index,
+	ion_value_t			value,
+	uint32_t			row
+) {
+	ion_byte_t		*field_value	= (ion_byte_t *) value + index->field.offset;
+	int				entry			= bidxdict_find_value(index, field_value);
+	ion_byte_t		*values;
+	ion_bitmap_t	*rows;
+	int				capacity;
+
+	if (entry < 0) {
+		entry = entry + index->count + 1;
+
+		if (index->count == index->capacity) {
+			capacity	= (0 == index->capacity) ? 4 : 2 * index->capacity;
+			values		= ion_realloc(ion_alloc_node, index->values, (size_t) capacity * index->field.size);
+
+			if (NULL == values) {
+				return err_out_of_memory;
+			}
+
+			index->values	= values;
+			rows			= ion_realloc(ion_alloc_node, index->rows, capacity * sizeof(ion_bitmap_t));
+
+			if (NULL == rows) {
+				return err_out_of_memory;
+			}
+
+			index->rows		= rows;
+			index->capacity = capacity;
+		}
+
+		memmove(index->values + (entry + 1) * index->field.size, index->values + entry * index->field.size, (size_t) (index->count - entry) * index->field.size);
+		memmove(index->rows + entry + 1, index->rows + entry, (index->count - entry) * sizeof(ion_bitmap_t));
+		memcpy(index->values + entry * index->field.size, field_value, index->field.size);
+		ion_bitmap_init(index->rows + entry);
+		index->count++;
+	}
+
+	return ion_bitmap_add(index->rows + entry, row);
+}
+
+/**
+@brief		Takes a row out of every bitmap of an index, dropping values
+			left without rows.
+@details	The value of the row is not known, but the values are few, so
+			each bitmap is simply tried.
+*/
+static void
+bidxdict_unindex_row(
+	ion_bidx_index_t	*index,
+	uint32_t			row
+) {
+	int entry;
+
+	for (entry = 0; entry < index->count; entry++) {
+		if (!ion_bitmap_remove(index->rows + entry, row)) {
+			continue;
+		}
+
+		if (0 == ion_bitmap_cardinality(index->rows + entry)) {
+			ion_bitmap_free(index->rows + entry);
+			index->count--;
+			memmove(index->values + entry * index->field.size, index->values + (entry + 1) * index->field.size, (size_t) (index->count - entry) * index->field.size);
+			memmove(index->rows + entry, index->rows + entry + 1, (index->count - entry) * sizeof(ion_bitmap_t));
+		}
+
+		/* a row has one value for each field */
+		return;
+	}
+}
+
+/**
+@brief		Indexes a row under every field of its value.
+*/
+static ion_err_t
+bidxdict_index_value(
+	ion_bidx_dictionary_t	*index_dict,
+	ion_value_t				value,
+	uint32_t				row
+) {
+	ion_err_t	err;
+	int			i;
+
+	for (i = 0; i < index_dict->index_count; i++) {
+		if (err_ok != (err = bidxdict_index_row(index_dict->indexes + i, value, row))) {
+			return err;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Gives a new record a row, reusing the lowest row freed before
+			going past the last.
+*/
+static ion_err_t
+bidxdict_add_row(
+	ion_bidx_dictionary_t	*index_dict,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	uint32_t	row = 0;
+	ion_byte_t	*row_keys;
+	uint32_t	capacity;
+
+	if (ion_bitmap_next(&index_dict->free_rows, &row)) {
+		ion_bitmap_remove(&index_dict->free_rows, row);
+	}
+	else {
+		if (index_dict->row_count == index_dict->row_capacity) {
+			capacity	= (0 == index_dict->row_capacity) ? ION_BIDX_INITIAL_ROWS : 2 * index_dict->row_capacity;
+			row_keys	= ion_realloc(ion_alloc_node, index_dict->row_keys, (size_t) capacity * index_dict->super.record.key_size);
+
+			if (NULL == row_keys) {
+				return err_out_of_memory;
+			}
+
+			index_dict->row_keys		= row_keys;
+			index_dict->row_capacity	= capacity;
+		}
+
+		row = index_dict->row_count++;
+	}
+
+	memcpy(ION_BIDX_ROW_KEY(index_dict, row), key, index_dict->super.record.key_size);
+
+	return bidxdict_index_value(index_dict, value, row);
+}
+
+/**
+@brief		Finds the rows of the records of a key.
+@details	The values of the key are read from the wrapped dictionary,
+			and only the rows of those values in the first index are
+			searched for the key.
+*/
+static ion_err_t
+bidxdict_rows_of(
+	ion_bidx_dictionary_t	*index_dict,
+	ion_key_t				key,
+	ion_bitmap_t			*rows
+) {
+	ion_key_size_t		key_size	= index_dict->super.record.key_size;
+	ion_bidx_index_t	*index		= index_dict->indexes;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor		= NULL;
+	ion_record_t		record;
+	ion_err_t			err;
+	uint32_t			row;
+	int					entry;
+
+	record.key		= ion_alloc(ion_alloc_buffer, key_size);
+	record.value	= ion_alloc(ion_alloc_buffer, index_dict->super.record.value_size);
+
+	if ((NULL == record.key) || (NULL == record.value)) {
+		ion_free(record.key);
+		ion_free(record.value);
+		return err_out_of_memory;
+	}
+
+	dictionary_build_predicate(&predicate, predicate_equality, key);
+	err = dictionary_find(&index_dict->inner, &predicate, &cursor);
+
+	while ((err_ok == err) && (cs_cursor_active == cursor->next(cursor, &record))) {
+		entry = bidxdict_find_value(index, (ion_byte_t *) record.value + index->field.offset);
+
+		if (entry < 0) {
+			continue;
+		}
+
+		for (row = 0; ion_bitmap_next(index->rows + entry, &row); row++) {
+			if ((0 == index_dict->super.compare(ION_BIDX_ROW_KEY(index_dict, row), key, key_size)) && (err_ok != (err = ion_bitmap_add(rows, row)))) {
+				break;
+			}
+		}
+	}
+
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	ion_free(record.key);
+	ion_free(record.value);
+
+	return err;
+}
+
+/**
+@brief		Frees the indexes and rows of a dictionary.
+*/
+static void
+bidxdict_free(
+	ion_bidx_dictionary_t *index_dict
+) {
+	int i;
+	int entry;
+
+	for (i = 0; i < index_dict->index_count; i++) {
+		for (entry = 0; entry < index_dict->indexes[i].count; entry++) {
+			ion_bitmap_free(index_dict->indexes[i].rows + entry);
+		}
+
+		ion_free(index_dict->indexes[i].values);
+		ion_free(index_dict->indexes[i].rows);
+	}
+
+	ion_free(index_dict->indexes);
+	ion_free(index_dict->row_keys);
+	ion_bitmap_free(&index_dict->free_rows);
+	ion_free(index_dict);
+}
+
+/**
+@brief		Gives every record already in a dictionary a row.
+*/
+static ion_err_t
+bidxdict_build(
+	ion_bidx_dictionary_t *index_dict
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	ion_err_t			err;
+
+	record.key		= ion_alloc(ion_alloc_buffer, index_dict->super.record.key_size);
+	record.value	= ion_alloc(ion_alloc_buffer, index_dict->super.record.value_size);
+
+	if ((NULL == record.key) || (NULL == record.value)) {
+		ion_free(record.key);
+		ion_free(record.value);
+		return err_out_of_memory;
+	}
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	err = dictionary_find(&index_dict->inner, &predicate, &cursor);
+
+	while ((err_ok == err) && (cs_cursor_active == cursor->next(cursor, &record))) {
+		err = bidxdict_add_row(index_dict, record.key, record.value);
+	}
+
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	ion_free(record.key);
+	ion_free(record.value);
+
+	return err;
+}
+
+ion_err_t
+bidxdict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_bidx_field_t			*fields,
+	int							field_count
+) {
+	ion_bidx_dictionary_t	*index_dict;
+	ion_err_t				err;
+	int						i;
+
+	if (field_count < 1) {
+		return err_invalid_initial_size;
+	}
+
+	for (i = 0; i < field_count; i++) {
+		if ((0 == fields[i].size) || (fields[i].offset + fields[i].size > dictionary->instance->record.value_size)) {
+			return err_invalid_initial_size;
+		}
+	}
+
+	if (NULL == (index_dict = ion_alloc(ion_alloc_other, sizeof(ion_bidx_dictionary_t)))) {
+		return err_out_of_memory;
+	}
+
+	index_dict->super			= *dictionary->instance;
+	index_dict->inner			= *dictionary;
+	index_dict->inner_handler	= *dictionary->handler;
+	index_dict->inner.handler	= &index_dict->inner_handler;
+	/* the durability too, so each write is pushed once */
+	index_dict->inner.durability.level	= durability_none;
+	index_dict->inner.durability.pending	= 0;
+#if ION_DICTIONARY_STATS
+	/* the counters stay with the caller's dictionary, so each operation counts once */
+	index_dict->inner.stats		= NULL;
+#endif
+	index_dict->index_count		= field_count;
+	index_dict->row_keys		= NULL;
+	index_dict->row_count		= 0;
+	index_dict->row_capacity	= 0;
+	ion_bitmap_init(&index_dict->free_rows);
+
+	if (NULL == (index_dict->indexes = ion_alloc(ion_alloc_other, field_count * sizeof(ion_bidx_index_t)))) {
+		ion_free(index_dict);
+		return err_out_of_memory;
+	}
+
+	for (i = 0; i < field_count; i++) {
+		index_dict->indexes[i].field	= fields[i];
+		index_dict->indexes[i].count	= 0;
+		index_dict->indexes[i].capacity = 0;
+		index_dict->indexes[i].values	= NULL;
+		index_dict->indexes[i].rows		= NULL;
+	}
+
+	if (err_ok != (err = bidxdict_build(index_dict))) {
+		bidxdict_free(index_dict);
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) index_dict;
+	dictionary->handler		= handler;
+	dictionary_opened(dictionary);
+
+	return err_ok;
+}
+
+ion_err_t
+bidxdict_match(
+	ion_dictionary_t	*dictionary,
+	int					index,
+	ion_value_t			field_value,
+	ion_bitmap_t		*rows
+) {
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) dictionary->instance;
+	int						entry;
+
+	if ((bidxdict_insert != dictionary->handler->insert) || (index < 0) || (index >= index_dict->index_count)) {
+		return err_illegal_state;
+	}
+
+	entry = bidxdict_find_value(index_dict->indexes + index, field_value);
+
+	if (entry < 0) {
+		ion_bitmap_free(rows);
+		return err_ok;
+	}
+
+	return ion_bitmap_copy(index_dict->indexes[index].rows + entry, rows);
+}
+
+/**
+@brief		Reads the record of the next row of a row cursor.
+*/
+static ion_cursor_status_t
+bidxdict_next_row(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_bidxdict_cursor_t	*row_cursor = (ion_bidxdict_cursor_t *) cursor;
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) cursor->dictionary->instance;
+	uint32_t				row			= row_cursor->row;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	for (; ion_bitmap_next(&row_cursor->rows, &row); row++) {
+		/* rows freed since the set was read no longer hold its records */
+		if ((row >= index_dict->row_count) || ion_bitmap_contains(&index_dict->free_rows, row)) {
+			continue;
+		}
+
+		memcpy(record->key, ION_BIDX_ROW_KEY(index_dict, row), index_dict->super.record.key_size);
+
+		if (err_ok == dictionary_get(&index_dict->inner, record->key, record->value).error) {
+			row_cursor->row = row + 1;
+			cursor->status	= cs_cursor_active;
+			return cursor->status;
+		}
+	}
+
+	cursor->status = cs_end_of_results;
+
+	return cursor->status;
+}
+
+/**
+@brief		Destroys a row cursor.
+*/
+static void
+bidxdict_destroy_row_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_bitmap_free(&((ion_bidxdict_cursor_t *) *cursor)->rows);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+bidxdict_find_rows(
+	ion_dictionary_t	*dictionary,
+	ion_bitmap_t		*rows,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_bidxdict_cursor_t *row_cursor;
+
+	if (bidxdict_insert != dictionary->handler->insert) {
+		return err_illegal_state;
+	}
+
+	if (NULL == (row_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_bidxdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	ion_bitmap_init(&row_cursor->rows);
+
+	if (err_ok != ion_bitmap_copy(rows, &row_cursor->rows)) {
+		ion_free(row_cursor);
+		return err_out_of_memory;
+	}
+
+	row_cursor->row					= 0;
+	row_cursor->super.dictionary	= dictionary;
+	row_cursor->super.predicate		= NULL;
+	row_cursor->super.status		= (0 == ion_bitmap_cardinality(rows)) ? cs_end_of_results : cs_cursor_initialized;
+	row_cursor->super.destroy		= bidxdict_destroy_row_cursor;
+	row_cursor->super.next_batch	= NULL;
+	row_cursor->super.next			= bidxdict_next_row;
+	*cursor							= (ion_dict_cursor_t *) row_cursor;
+
+	return err_ok;
+}
+
+ion_status_t
+bidxdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) dictionary->instance;
+	ion_status_t			status		= dictionary_insert(&index_dict->inner, key, value);
+
+	if (err_ok == status.error) {
+		status.error = bidxdict_add_row(index_dict, key, value);
+	}
+
+	return status;
+}
+
+ion_status_t
+bidxdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return dictionary_get(&((ion_bidx_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_status_t
+bidxdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return dictionary_get_ref(&((ion_bidx_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_err_t
+bidxdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+	UNUSED(key_type);
+	UNUSED(key_size);
+	UNUSED(value_size);
+	UNUSED(dictionary_size);
+	UNUSED(compare);
+	UNUSED(handler);
+	UNUSED(dictionary);
+	return err_dictionary_initialization_failed;
+}
+
+ion_status_t
+bidxdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) dictionary->instance;
+	ion_bitmap_t			rows;
+	ion_status_t			status;
+	ion_err_t				err;
+	uint32_t				row;
+	int						i;
+
+	ion_bitmap_init(&rows);
+
+	/* the values of the key are read before they are gone */
+	if (err_ok != (err = bidxdict_rows_of(index_dict, key, &rows))) {
+		ion_bitmap_free(&rows);
+		return ION_STATUS_ERROR(err);
+	}
+
+	status = dictionary_delete(&index_dict->inner, key);
+
+	if (err_ok == status.error) {
+		for (row = 0; ion_bitmap_next(&rows, &row); row++) {
+			for (i = 0; i < index_dict->index_count; i++) {
+				bidxdict_unindex_row(index_dict->indexes + i, row);
+			}
+
+			if (err_ok != ion_bitmap_add(&index_dict->free_rows, row)) {
+				status.error = err_out_of_memory;
+			}
+		}
+	}
+
+	ion_bitmap_free(&rows);
+
+	return status;
+}
+
+ion_err_t
+bidxdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err			= dictionary_delete_dictionary(&index_dict->inner);
+
+	bidxdict_free(index_dict);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+bidxdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) dictionary->instance;
+	ion_bitmap_t			rows;
+	ion_status_t			status;
+	ion_err_t				err;
+	uint32_t				row;
+	int						i;
+
+	ion_bitmap_init(&rows);
+
+	if (err_ok != (err = bidxdict_rows_of(index_dict, key, &rows))) {
+		ion_bitmap_free(&rows);
+		return ION_STATUS_ERROR(err);
+	}
+
+	status = dictionary_update(&index_dict->inner, key, value);
+
+	if (err_ok == status.error) {
+		/* an update of a key there was none of inserts it */
+		if (0 == ion_bitmap_cardinality(&rows)) {
+			status.error = bidxdict_add_row(index_dict, key, value);
+		}
+
+		for (row = 0; ion_bitmap_next(&rows, &row); row++) {
+			for (i = 0; i < index_dict->index_count; i++) {
+				bidxdict_unindex_row(index_dict->indexes + i, row);
+			}
+
+			if (err_ok != (err = bidxdict_index_value(index_dict, value, row))) {
+				status.error = err;
+			}
+		}
+	}
+
+	ion_bitmap_free(&rows);
+
+	return status;
+}
+
+ion_err_t
+bidxdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	return dictionary_find(&((ion_bidx_dictionary_t *) dictionary->instance)->inner, predicate, cursor);
+}
+
+ion_err_t
+bidxdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_dictionary_initialization_failed;
+}
+
+ion_err_t
+bidxdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_bidx_dictionary_t	*index_dict = (ion_bidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err			= dictionary_close(&index_dict->inner);
+
+	if (err_ok == err) {
+		bidxdict_free(index_dict);
+		dictionary->instance = NULL;
+	}
+
+	return err;
+}
+
+/**
+@brief		Pushes every write of a indexed dictionary through to storage.
+*/
+static ion_err_t
+bidxdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return dictionary_sync(&((ion_bidx_dictionary_t *) dictionary->instance)->inner);
+}
+
+/**
+@brief		Tells the size of a dictionary with bitmap indexes, see
+			@ref dictionary_get_info, the indexes counted with what the
+			wrapped dictionary holds in memory.
+*/
+static ion_err_t
+bidxdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_bidx_dictionary_t	*bidx_dict	= (ion_bidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err			= dictionary_get_info(&bidx_dict->inner, info);
+	ion_bidx_index_t		*index;
+	int						i;
+	int						j;
+
+	if (-1 == info->memory_bytes) {
+		return err;
+	}
+
+	info->memory_bytes += (long) (bidx_dict->row_capacity * bidx_dict->super.record.key_size + ion_bitmap_bytes(&bidx_dict->free_rows));
+
+	for (i = 0; i < bidx_dict->index_count; i++) {
+		index				= &bidx_dict->indexes[i];
+		info->memory_bytes	+= (long) (index->capacity * (index->field.size + sizeof(ion_bitmap_t)));
+
+		for (j = 0; j < index->count; j++) {
+			info->memory_bytes += (long) ion_bitmap_bytes(&index->rows[j]);
+		}
+	}
+
+	return err;
+}
+
+void
+bidxdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= bidxdict_insert;
+	handler->create_dictionary	= bidxdict_create_dictionary;
+	handler->get				= bidxdict_query;
+	handler->update				= bidxdict_update;
+	handler->find				= bidxdict_find;
+	handler->remove				= bidxdict_delete;
+	handler->delete_dictionary	= bidxdict_delete_dictionary;
+	handler->close_dictionary	= bidxdict_close_dictionary;
+	handler->open_dictionary	= bidxdict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= bidxdict_get_ref;
+	handler->sync_dictionary	= bidxdict_sync_dictionary;
+	handler->get_info			= bidxdict_get_info;
+	handler->bulk_load			= NULL;
+}
@@ -0,0 +1,376 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that keeps bitmap indexes on fields of the values of
+			a dictionary of any other handler.
+@details	A dictionary is wrapped once it is created or opened, see
+			@ref bidxdict_wrap, naming the fields to index by where they
+			sit in the value. Each record is given a row, a small integer
+			reused once the record is deleted, and each index keeps one
+			compressed bitmap of rows for every distinct value of its
+			field. The bitmaps of a value are found with
+			@ref bidxdict_match, combined with @ref ion_bitmap_and and
+			@ref ion_bitmap_or, and only the records of the rows left are
+			then read, through @ref bidxdict_find_rows, so a filter on
+			fields of few distinct values, such as status codes or
+			sensor ids, does not scan the whole dictionary.
+
+			Rows are read back by their key, so for a dictionary with
+			duplicate keys every row of a key reads its first value.
+			The indexes live in memory and are rebuilt from the records
+			at each wrap.
+*/
+/******************************************************************************/
+
+#if !defined(BITMAP_INDEX_DICTIONARY_HANDLER_H_)
+#define BITMAP_INDEX_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "ion_bitmap.h"
+
+/**
+@brief		A field of the values of a dictionary.
+*/
+typedef struct {
+	ion_value_size_t	offset;	/**< Where it starts in the value */
+	ion_value_size_t	size;	/**< Its bytes */
+} ion_bidx_field_t;
+
+/**
+@brief		The rows of each distinct value of a field.
+*/
+typedef struct {
+	ion_bidx_field_t	field;		/**< The field indexed */
+	int					count;		/**< Its distinct values */
+	int					capacity;	/**< The values there is room for */
+	ion_byte_t			*values;	/**< The values, in @c memcmp order */
+	ion_bitmap_t		*rows;		/**< The rows of each */
+} ion_bidx_index_t;
+
+/**
+@brief		A dictionary with bitmap indexes on fields of its values.
+*/
+typedef struct bitmap_index_dictionary {
+	ion_dictionary_parent_t		super;
+	ion_dictionary_t			inner;			/**< The wrapped dictionary */
+	ion_dictionary_handler_t	inner_handler;	/**< Its handler, kept here as
+												 the caller's is rebound to
+												 the index */
+	ion_bidx_index_t			*indexes;		/**< One for each field */
+	int							index_count;	/**< How many */
+	ion_byte_t					*row_keys;		/**< The key of each row */
+	uint32_t					row_count;		/**< One past the last row
+												 used */
+	uint32_t					row_capacity;	/**< The rows there is room
+												 for */
+	ion_bitmap_t				free_rows;		/**< Rows below @c row_count
+												 of deleted records */
+} ion_bidx_dictionary_t;
+
+/**
+@brief		A cursor over the records of a set of rows.
+*/
+typedef struct bidxdict_cursor {
+	ion_dict_cursor_t	super;	/**< Cursor supertype this type inherits
+								 from */
+	ion_bitmap_t		rows;	/**< The rows to read */
+	uint32_t			row;	/**< The first row not yet read */
+} ion_bidxdict_cursor_t;
+
+/**
+@brief		Registers the bitmap index handler.
+
+@details	The handler cannot create dictionaries of its own, it only
+			serves those given to @ref bidxdict_wrap.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+bidxdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Indexes fields of the values of a dictionary.
+
+@details	The records already in the dictionary are read to build the
+			indexes. From then on the dictionary is used through
+			@p handler as before, and deleting or closing it also does
+			away with the indexes. Its own handler is copied, so it may
+			be reused.
+
+@param		dictionary
+				A dictionary, created or opened with any handler.
+@param		handler
+				A handler registered with @ref bidxdict_init, to bind to
+				@p dictionary.
+@param		fields
+				The fields to index, which are copied.
+@param		field_count
+				How many, at least 1.
+@return		The status of the wrap: @c err_invalid_initial_size if a
+			field does not lie within the value. @p dictionary is left as
+			it was unless it is @c err_ok.
+*/
+ion_err_t
+bidxdict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_bidx_field_t			*fields,
+	int							field_count
+);
+
+/**
+@brief		Reads the rows of the records with a value of an indexed
+			field.
+
+@param		dictionary
+				A dictionary wrapped with @ref bidxdict_wrap.
+@param		index
+				Which of the fields given to the wrap, from 0.
+@param		field_value
+				The value of the field, of the size of the field.
+@param		rows
+				An initialized bitmap, emptied then given the rows.
+@return		@c err_ok, @c err_illegal_state if @p dictionary is not
+			indexed or has no such field, or @c err_out_of_memory.
+*/
+ion_err_t
+bidxdict_match(
+	ion_dictionary_t	*dictionary,
+	int					index,
+	ion_value_t			field_value,
+	ion_bitmap_t		*rows
+);
+
+/**
+@brief		Opens a cursor over the records of a set of rows, in row
+			order.
+
+@details	Rows of records deleted after the set was read are skipped.
+			The cursor is used and destroyed as any other.
+
+@param		dictionary
+				A dictionary wrapped with @ref bidxdict_wrap.
+@param		rows
+				The rows, as given by @ref bidxdict_match and combined,
+				which are copied.
+@param		cursor
+				Receives the cursor.
+@return		@c err_ok, @c err_illegal_state if @p dictionary is not
+			indexed, or @c err_out_of_memory.
+*/
+ion_err_t
+bidxdict_find_rows(
+	ion_dictionary_t	*dictionary,
+	ion_bitmap_t		*rows,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Inserts a record into the wrapped dictionary and gives it a
+			row.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion. With @c err_out_of_memory the
+			record may be in the dictionary but missing from the indexes.
+*/
+ion_status_t
+bidxdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Reads a record from the wrapped dictionary.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+bidxdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at a value held by the wrapped dictionary.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the query.
+*/
+ion_status_t
+bidxdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Refuses to create a dictionary, see @ref bidxdict_wrap.
+
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The size of the dictionary.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+bidxdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes the records of a key from the wrapped dictionary and
+			frees their rows.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+bidxdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes the wrapped dictionary and the indexes.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+bidxdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the records of a key in the wrapped dictionary and
+			moves their rows to the bitmaps of the new value.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+bidxdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds records in the wrapped dictionary.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+bidxdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Refuses to open a dictionary, see @ref bidxdict_wrap.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+bidxdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes the wrapped dictionary and frees the indexes.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		The status of the closing.
+*/
+ion_err_t
+bidxdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* BITMAP_INDEX_DICTIONARY_HANDLER_H_ */
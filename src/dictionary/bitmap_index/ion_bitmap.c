@@ -0,0 +1,753 @@
+/******************************************************************************/
+/**
+@file
+@brief		A compressed bitmap of 32 bit positions.
+*/
+/******************************************************************************/
+
+#include "ion_bitmap.h"
+#include "../ion_alloc.h"
+
+/**
+@brief		Whether a container holds a bitmap rather than an array.
+*/
+#define ION_BITMAP_IS_DENSE(container)	(NULL != (container)->words)
+
+/**
+@brief		The entries an array container first makes room for.
+*/
+#define ION_BITMAP_ARRAY_INITIAL		4
+
+/**
+@brief		Finds the container of a value of the high bits.
+@return		Its index, or the index to insert it at less @c count plus
+			one if there is none, so that a negative result says it is
+			missing.
+*/
+static int
+ion_bitmap_find(
+	ion_bitmap_t	*bitmap,
+	uint16_t		high
+) {
+	int low_index	= 0;
+	int high_index	= bitmap->count;
+	int middle;
+
+	while (low_index < high_index) {
+		middle = low_index + (high_index - low_index) / 2;
+
+		if (bitmap->containers[middle].high < high) {
+			low_index = middle + 1;
+		}
+		else {
+			high_index = middle;
+		}
+	}
+
+	if ((low_index < bitmap->count) && (bitmap->containers[low_index].high == high)) {
+		return low_index;
+	}
+
+	return low_index - bitmap->count - 1;
+}
+
+/**
+@brief		The first entry of an array container no less than @p low.
+*/
+static int
+ion_bitmap_lower_bound(
+	ion_bitmap_container_t	*container,
+	uint16_t				low
+) {
+	int low_index	= 0;
+	int high_index	= (int) container->cardinality;
+	int middle;
+
+	while (low_index < high_index) {
+		middle = low_index + (high_index - low_index) / 2;
+
+		if (container->values[middle] < low) {
+			low_index = middle + 1;
+		}
+		else {
+			high_index = middle;
+		}
+	}
+
+	return low_index;
+}
+
+/**
+@brief		Makes room for an empty container at @p index.
+@return		The container, or NULL if there is no memory for it.
+*/
+static ion_bitmap_container_t *
+ion_bitmap_insert_container(
+	ion_bitmap_t	*bitmap,
+	int				index,
+	uint16_t		high
+) {
+	ion_bitmap_container_t	*containers;
+	ion_bitmap_container_t	*container;
+	int						capacity;
+
+	if (bitmap->count == bitmap->capacity) {
+		capacity	= (0 == bitmap->capacity) ? 1 : 2 * bitmap->capacity;
+		containers	= ion_realloc(ion_alloc_node, bitmap->containers, capacity * sizeof(ion_bitmap_container_t));
+
+		if (NULL == containers) {
+			return NULL;
+		}
+
+		bitmap->containers	= containers;
+		bitmap->capacity	= capacity;
+	}
+
+	memmove(bitmap->containers + index + 1, bitmap->containers + index, (bitmap->count - index) * sizeof(ion_bitmap_container_t));
+	bitmap->count++;
+
+	container				= bitmap->containers + index;
+	container->high			= high;
+	container->cardinality	= 0;
+	container->capacity		= 0;
+	container->values		= NULL;
+	container->words		= NULL;
+
+	return container;
+}
+
+/**
+@brief		Frees a container and takes it out of its bitmap.
+*/
+static void
+ion_bitmap_remove_container(
+	ion_bitmap_t	*bitmap,
+	int				index
+) {
+	ion_free(bitmap->containers[index].values);
+	ion_free(bitmap->containers[index].words);
+	bitmap->count--;
+	memmove(bitmap->containers + index, bitmap->containers + index + 1, (bitmap->count - index) * sizeof(ion_bitmap_container_t));
+}
+
+/**
+@brief		Writes the positions of a container into a bitmap of words.
+*/
+static void
+ion_bitmap_fill_words(
+	ion_bitmap_container_t	*container,
+	uint64_t				*words
+) {
+	uint32_t i;
+
+	if (ION_BITMAP_IS_DENSE(container)) {
+		memcpy(words, container->words, ION_BITMAP_WORDS * sizeof(uint64_t));
+		return;
+	}
+
+	memset(words, 0, ION_BITMAP_WORDS * sizeof(uint64_t));
+
+	for (i = 0; i < container->cardinality; i++) {
+		words[container->values[i] >> 6] |= (uint64_t) 1 << (container->values[i] & 63);
+	}
+}
+
+/**
+@brief		Turns an array container into a bitmap.
+*/
+static ion_err_t
+ion_bitmap_to_dense(
+	ion_bitmap_container_t *container
+) {
+	uint64_t *words = ion_alloc(ion_alloc_node, ION_BITMAP_WORDS * sizeof(uint64_t));
+
+	if (NULL == words) {
+		return err_out_of_memory;
+	}
+
+	ion_bitmap_fill_words(container, words);
+	ion_free(container->values);
+	container->values	= NULL;
+	container->capacity = 0;
+	container->words	= words;
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the positions of a bitmap of words as an array.
+*/
+static void
+ion_bitmap_fill_values(
+	uint64_t	*words,
+	uint16_t	*values
+) {
+	uint64_t	word;
+	int			count = 0;
+	int			i;
+
+	for (i = 0; i < ION_BITMAP_WORDS; i++) {
+		for (word = words[i]; 0 != word; word &= word - 1) {
+			values[count++] = (uint16_t) (i * 64 + __builtin_ctzll(word));
+		}
+	}
+}
+
+/**
+@brief		Turns a bitmap container back into an array.
+*/
+static ion_err_t
+ion_bitmap_to_sparse(
+	ion_bitmap_container_t *container
+) {
+	uint16_t *values = ion_alloc(ion_alloc_node, container->cardinality * sizeof(uint16_t));
+
+	if (NULL == values) {
+		return err_out_of_memory;
+	}
+
+	ion_bitmap_fill_values(container->words, values);
+	ion_free(container->words);
+	container->words	= NULL;
+	container->values	= values;
+	container->capacity = (int) container->cardinality;
+
+	return err_ok;
+}
+
+/**
+@brief		Appends a container of the positions of a bitmap of words to a
+			result, as an array if they are few enough.
+*/
+static ion_err_t
+ion_bitmap_push_words(
+	ion_bitmap_t	*result,
+	uint16_t		high,
+	uint64_t		*words
+) {
+	ion_bitmap_container_t	*container;
+	uint32_t				cardinality = 0;
+	int						i;
+
+	for (i = 0; i < ION_BITMAP_WORDS; i++) {
+		cardinality += (uint32_t) __builtin_popcountll(words[i]);
+	}
+
+	if (0 == cardinality) {
+		return err_ok;
+	}
+
+	if (NULL == (container = ion_bitmap_insert_container(result, result->count, high))) {
+		return err_out_of_memory;
+	}
+
+	container->cardinality = cardinality;
+
+	if (cardinality > ION_BITMAP_ARRAY_MAX) {
+		container->words = ion_alloc(ion_alloc_node, ION_BITMAP_WORDS * sizeof(uint64_t));
+
+		if (NULL == container->words) {
+			result->count--;
+			return err_out_of_memory;
+		}
+
+		memcpy(container->words, words, ION_BITMAP_WORDS * sizeof(uint64_t));
+		return err_ok;
+	}
+
+	container->values	= ion_alloc(ion_alloc_node, cardinality * sizeof(uint16_t));
+	container->capacity = (int) cardinality;
+
+	if (NULL == container->values) {
+		result->count--;
+		return err_out_of_memory;
+	}
+
+	ion_bitmap_fill_values(words, container->values);
+
+	return err_ok;
+}
+
+/**
+@brief		Appends an array container with room for @p capacity entries to
+			a result.
+*/
+static ion_bitmap_container_t *
+ion_bitmap_push_array(
+	ion_bitmap_t	*result,
+	uint16_t		high,
+	uint32_t		capacity
+) {
+	ion_bitmap_container_t *container = ion_bitmap_insert_container(result, result->count, high);
+
+	if (NULL == container) {
+		return NULL;
+	}
+
+	container->values	= ion_alloc(ion_alloc_node, capacity * sizeof(uint16_t));
+	container->capacity = (int) capacity;
+
+	if (NULL == container->values) {
+		result->count--;
+		return NULL;
+	}
+
+	return container;
+}
+
+/**
+@brief		Appends a copy of a container to a result.
+*/
+static ion_err_t
+ion_bitmap_push_copy(
+	ion_bitmap_t			*result,
+	ion_bitmap_container_t	*from
+) {
+	ion_bitmap_container_t *container;
+
+	if (ION_BITMAP_IS_DENSE(from)) {
+		return ion_bitmap_push_words(result, from->high, from->words);
+	}
+
+	if (NULL == (container = ion_bitmap_push_array(result, from->high, from->cardinality))) {
+		return err_out_of_memory;
+	}
+
+	memcpy(container->values, from->values, from->cardinality * sizeof(uint16_t));
+	container->cardinality = from->cardinality;
+
+	return err_ok;
+}
+
+/**
+@brief		Whether a container holds the low bits of a position.
+*/
+static ion_boolean_t
+ion_bitmap_container_contains(
+	ion_bitmap_container_t	*container,
+	uint16_t				low
+) {
+	int index;
+
+	if (ION_BITMAP_IS_DENSE(container)) {
+		return 0 != (container->words[low >> 6] & ((uint64_t) 1 << (low & 63)));
+	}
+
+	index = ion_bitmap_lower_bound(container, low);
+
+	return (index < (int) container->cardinality) && (container->values[index] == low);
+}
+
+void
+ion_bitmap_init(
+	ion_bitmap_t *bitmap
+) {
+	bitmap->containers	= NULL;
+	bitmap->count		= 0;
+	bitmap->capacity	= 0;
+}
+
+void
+ion_bitmap_free(
+	ion_bitmap_t *bitmap
+) {
+	int i;
+
+	for (i = 0; i < bitmap->count; i++) {
+		ion_free(bitmap->containers[i].values);
+		ion_free(bitmap->containers[i].words);
+	}
+
+	ion_free(bitmap->containers);
+	ion_bitmap_init(bitmap);
+}
+
+ion_err_t
+ion_bitmap_add(
+	ion_bitmap_t	*bitmap,
+	uint32_t		position
+) {
+	uint16_t				high	= (uint16_t) (position >> 16);
+	uint16_t				low		= (uint16_t) position;
+	int						index	= ion_bitmap_find(bitmap, high);
+	ion_bitmap_container_t	*container;
+	uint16_t				*values;
+	int						capacity;
+	int						at;
+
+	if (index < 0) {
+		if (NULL == (container = ion_bitmap_insert_container(bitmap, index + bitmap->count + 1, high))) {
+			return err_out_of_memory;
+		}
+	}
+	else {
+		container = bitmap->containers + index;
+	}
+
+	if (!ION_BITMAP_IS_DENSE(container)) {
+		at = ion_bitmap_lower_bound(container, low);
+
+		if ((at < (int) container->cardinality) && (container->values[at] == low)) {
+			return err_ok;
+		}
+
+		if (container->cardinality < ION_BITMAP_ARRAY_MAX) {
+			if ((int) container->cardinality == container->capacity) {
+				capacity	= (0 == container->capacity) ? ION_BITMAP_ARRAY_INITIAL : 2 * container->capacity;
+				capacity	= (capacity > ION_BITMAP_ARRAY_MAX) ? ION_BITMAP_ARRAY_MAX : capacity;
+				values		= ion_realloc(ion_alloc_node, container->values, capacity * sizeof(uint16_t));
+
+				if (NULL == values) {
+					if (0 == container->cardinality) {
+						ion_bitmap_remove_container(bitmap, (int) (container - bitmap->containers));
+					}
+
+					return err_out_of_memory;
+				}
+
+				container->values	= values;
+				container->capacity = capacity;
+			}
+
+			memmove(container->values + at + 1, container->values + at, (container->cardinality - at) * sizeof(uint16_t));
+			container->values[at] = low;
+			container->cardinality++;
+			return err_ok;
+		}
+
+		/* an array this full takes as much room as a bitmap */
+		if (err_ok != ion_bitmap_to_dense(container)) {
+			return err_out_of_memory;
+		}
+	}
+
+	if (!ion_bitmap_container_contains(container, low)) {
+		container->words[low >> 6] |= (uint64_t) 1 << (low & 63);
+		container->cardinality++;
+	}
+
+	return err_ok;
+}
+
+ion_boolean_t
+ion_bitmap_remove(
+	ion_bitmap_t	*bitmap,
+	uint32_t		position
+) {
+	uint16_t				low		= (uint16_t) position;
+	int						index	= ion_bitmap_find(bitmap, (uint16_t) (position >> 16));
+	ion_bitmap_container_t	*container;
+	int						at;
+
+	if ((index < 0) || !ion_bitmap_container_contains(container = bitmap->containers + index, low)) {
+		return boolean_false;
+	}
+
+	container->cardinality--;
+
+	if (0 == container->cardinality) {
+		ion_bitmap_remove_container(bitmap, index);
+		return boolean_true;
+	}
+
+	if (ION_BITMAP_IS_DENSE(container)) {
+		container->words[low >> 6] &= ~((uint64_t) 1 << (low & 63));
+
+		/* should there be no memory for the array, the bitmap is kept */
+		if (container->cardinality <= ION_BITMAP_ARRAY_MAX / 2) {
+			ion_bitmap_to_sparse(container);
+		}
+	}
+	else {
+		at = ion_bitmap_lower_bound(container, low);
+		memmove(container->values + at, container->values + at + 1, (container->cardinality - at) * sizeof(uint16_t));
+	}
+
+	return boolean_true;
+}
+
+ion_boolean_t
+ion_bitmap_contains(
+	ion_bitmap_t	*bitmap,
+	uint32_t		position
+) {
+	int index = ion_bitmap_find(bitmap, (uint16_t) (position >> 16));
+
+	return (index >= 0) && ion_bitmap_container_contains(bitmap->containers + index, (uint16_t) position);
+}
+
+uint32_t
+ion_bitmap_cardinality(
+	ion_bitmap_t *bitmap
+) {
+	uint32_t	cardinality = 0;
+	int			i;
+
+	for (i = 0; i < bitmap->count; i++) {
+		cardinality += bitmap->containers[i].cardinality;
+	}
+
+	return cardinality;
+}
+
+size_t
+ion_bitmap_bytes(
+	ion_bitmap_t *bitmap
+) {
+	size_t	bytes = bitmap->capacity * sizeof(ion_bitmap_container_t);
+	int		i;
+
+	for (i = 0; i < bitmap->count; i++) {
+		if (0 == bitmap->containers[i].capacity) {
+			bytes += ION_BITMAP_WORDS * sizeof(uint64_t);
+		}
+		else {
+			bytes += bitmap->containers[i].capacity * sizeof(uint16_t);
+		}
+	}
+
+	return bytes;
+}
+
+ion_boolean_t
+ion_bitmap_next(
+	ion_bitmap_t	*bitmap,
+	uint32_t		*position
+) {
+	int						index	= ion_bitmap_find(bitmap, (uint16_t) (*position >> 16));
+	uint32_t				low		= *position & 0xFFFF;
+	ion_bitmap_container_t	*container;
+	uint64_t				word;
+	int						at;
+
+	/* a missing container is passed over to the next one, from its first position */
+	if (index < 0) {
+		index	= index + bitmap->count + 1;
+		low		= 0;
+	}
+
+	for (; index < bitmap->count; index++, low = 0) {
+		container = bitmap->containers + index;
+
+		if (ION_BITMAP_IS_DENSE(container)) {
+			at		= (int) (low >> 6);
+			word	= container->words[at] & (~(uint64_t) 0 << (low & 63));
+
+			while ((0 == word) && (++at < ION_BITMAP_WORDS)) {
+				word = container->words[at];
+			}
+
+			if (0 != word) {
+				*position = ((uint32_t) container->high << 16) | (uint32_t) (at * 64 + __builtin_ctzll(word));
+				return boolean_true;
+			}
+		}
+		else {
+			at = ion_bitmap_lower_bound(container, (uint16_t) low);
+
+			if (at < (int) container->cardinality) {
+				*position = ((uint32_t) container->high << 16) | container->values[at];
+				return boolean_true;
+			}
+		}
+	}
+
+	return boolean_false;
+}
+
+ion_err_t
+ion_bitmap_copy(
+	ion_bitmap_t	*from,
+	ion_bitmap_t	*to
+) {
+	int i;
+
+	ion_bitmap_free(to);
+
+	for (i = 0; i < from->count; i++) {
+		if (err_ok != ion_bitmap_push_copy(to, from->containers + i)) {
+			ion_bitmap_free(to);
+			return err_out_of_memory;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Intersects two containers of the same high bits into a result.
+*/
+static ion_err_t
+ion_bitmap_and_containers(
+	ion_bitmap_container_t	*a,
+	ion_bitmap_container_t	*b,
+	ion_bitmap_t			*result,
+	uint64_t				*words
+) {
+	ion_bitmap_container_t	*container;
+	ion_bitmap_container_t	*swap;
+	uint32_t				i;
+	uint32_t				j;
+
+	if (ION_BITMAP_IS_DENSE(a) && ION_BITMAP_IS_DENSE(b)) {
+		for (i = 0; i < ION_BITMAP_WORDS; i++) {
+			words[i] = a->words[i] & b->words[i];
+		}
+
+		return ion_bitmap_push_words(result, a->high, words);
+	}
+
+	/* an array the other side, or both, so the result is no larger than it */
+	if (ION_BITMAP_IS_DENSE(a)) {
+		swap	= a;
+		a		= b;
+		b		= swap;
+	}
+
+	if (NULL == (container = ion_bitmap_push_array(result, a->high, a->cardinality))) {
+		return err_out_of_memory;
+	}
+
+	for (i = 0, j = 0; i < a->cardinality; i++) {
+		if (ION_BITMAP_IS_DENSE(b)) {
+			if (ion_bitmap_container_contains(b, a->values[i])) {
+				container->values[container->cardinality++] = a->values[i];
+			}
+
+			continue;
+		}
+
+		while ((j < b->cardinality) && (b->values[j] < a->values[i])) {
+			j++;
+		}
+
+		if ((j < b->cardinality) && (b->values[j] == a->values[i])) {
+			container->values[container->cardinality++] = a->values[i];
+		}
+	}
+
+	if (0 == container->cardinality) {
+		ion_bitmap_remove_container(result, result->count - 1);
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Unites two containers of the same high bits into a result.
+*/
+static ion_err_t
+ion_bitmap_or_containers(
+	ion_bitmap_container_t	*a,
+	ion_bitmap_container_t	*b,
+	ion_bitmap_t			*result,
+	uint64_t				*words
+) {
+	ion_bitmap_container_t	*container;
+	uint32_t				i = 0;
+	uint32_t				j = 0;
+
+	if (ION_BITMAP_IS_DENSE(a) || ION_BITMAP_IS_DENSE(b) || (a->cardinality + b->cardinality > ION_BITMAP_ARRAY_MAX)) {
+		ion_bitmap_fill_words(a, words);
+
+		if (ION_BITMAP_IS_DENSE(b)) {
+			for (i = 0; i < ION_BITMAP_WORDS; i++) {
+				words[i] |= b->words[i];
+			}
+		}
+		else {
+			for (i = 0; i < b->cardinality; i++) {
+				words[b->values[i] >> 6] |= (uint64_t) 1 << (b->values[i] & 63);
+			}
+		}
+
+		return ion_bitmap_push_words(result, a->high, words);
+	}
+
+	if (NULL == (container = ion_bitmap_push_array(result, a->high, a->cardinality + b->cardinality))) {
+		return err_out_of_memory;
+	}
+
+	while ((i < a->cardinality) || (j < b->cardinality)) {
+		if ((j == b->cardinality) || ((i < a->cardinality) && (a->values[i] < b->values[j]))) {
+			container->values[container->cardinality++] = a->values[i++];
+		}
+		else if ((i == a->cardinality) || (b->values[j] < a->values[i])) {
+			container->values[container->cardinality++] = b->values[j++];
+		}
+		else {
+			container->values[container->cardinality++] = a->values[i++];
+			j++;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Combines two bitmaps a container at a time.
+@param		unite
+				Whether to unite them, or else intersect them.
+*/
+static ion_err_t
+ion_bitmap_combine(
+	ion_bitmap_t	*a,
+	ion_bitmap_t	*b,
+	ion_bitmap_t	*result,
+	ion_boolean_t	unite
+) {
+	uint64_t	*words	= NULL;
+	ion_err_t	err		= err_ok;
+	int			i		= 0;
+	int			j		= 0;
+
+	ion_bitmap_free(result);
+
+	while ((err_ok == err) && ((i < a->count) || (j < b->count))) {
+		if ((j == b->count) || ((i < a->count) && (a->containers[i].high < b->containers[j].high))) {
+			err = unite ? ion_bitmap_push_copy(result, a->containers + i) : err_ok;
+			i++;
+		}
+		else if ((i == a->count) || (b->containers[j].high < a->containers[i].high)) {
+			err = unite ? ion_bitmap_push_copy(result, b->containers + j) : err_ok;
+			j++;
+		}
+		else {
+			/* one page of words, for the containers that have to be combined as bitmaps */
+			if ((NULL == words) && (NULL == (words = ion_alloc(ion_alloc_buffer, ION_BITMAP_WORDS * sizeof(uint64_t))))) {
+				err = err_out_of_memory;
+				break;
+			}
+
+			err = unite ? ion_bitmap_or_containers(a->containers + i, b->containers + j, result, words) : ion_bitmap_and_containers(a->containers + i, b->containers + j, result, words);
+			i++;
+			j++;
+		}
+	}
+
+	ion_free(words);
+
+	if (err_ok != err) {
+		ion_bitmap_free(result);
+	}
+
+	return err;
+}
+
+ion_err_t
+ion_bitmap_and(
+	ion_bitmap_t	*a,
+	ion_bitmap_t	*b,
+	ion_bitmap_t	*result
+) {
+	return ion_bitmap_combine(a, b, result, boolean_false);
+}
+
+ion_err_t
+ion_bitmap_or(
+	ion_bitmap_t	*a,
+	ion_bitmap_t	*b,
+	ion_bitmap_t	*result
+) {
+	return ion_bitmap_combine(a, b, result, boolean_true);
+}
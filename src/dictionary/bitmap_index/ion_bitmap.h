@@ -0,0 +1,235 @@
+/******************************************************************************/
+/**
+@file
+@brief		A compressed bitmap of 32 bit positions.
+@details	Positions are split on their high 16 bits into containers in
+			the manner of Roaring bitmaps. A container of few positions
+			holds their low 16 bits as a sorted array, two bytes each; one
+			of many holds a plain bitmap of all 65536, which is smaller
+			past @ref ION_BITMAP_ARRAY_MAX positions. Sparse and dense
+			sets thus both stay compact, and intersections and unions
+			work a container at a time, merging arrays or combining words.
+*/
+/******************************************************************************/
+
+#if !defined(ION_BITMAP_H_)
+#define ION_BITMAP_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		The most positions an array container holds before it is
+			turned into a bitmap.
+@details	A bitmap container takes 8 KiB, as much as 4096 array entries.
+			It is only turned back into an array once it holds half as
+			many, so a set that hovers around the limit is not converted
+			on every change.
+*/
+#if !defined(ION_BITMAP_ARRAY_MAX)
+#define ION_BITMAP_ARRAY_MAX 4096
+#endif
+
+/**
+@brief		The 64 bit words of a bitmap container.
+*/
+#define ION_BITMAP_WORDS		1024
+
+/**
+@brief		The positions of one value of their high 16 bits.
+*/
+typedef struct {
+	uint16_t	high;			/**< The high 16 bits of the positions */
+	uint32_t	cardinality;	/**< How many there are */
+	int			capacity;		/**< The entries of @c values there is
+								 room for, 0 once it is a bitmap */
+	uint16_t	*values;		/**< Their low 16 bits, ascending */
+	uint64_t	*words;			/**< Or their bitmap, bit @c n of word
+								 @c n/64 for low bits @c n */
+} ion_bitmap_container_t;
+
+/**
+@brief		A set of positions.
+*/
+typedef struct {
+	ion_bitmap_container_t	*containers;	/**< The containers that are
+											 not empty, by @c high */
+	int						count;			/**< How many */
+	int						capacity;		/**< How many there is room
+											 for */
+} ion_bitmap_t;
+
+/**
+@brief		Makes an empty bitmap.
+
+@param		bitmap
+				The bitmap to initialize.
+*/
+void
+ion_bitmap_init(
+	ion_bitmap_t *bitmap
+);
+
+/**
+@brief		Frees the memory of a bitmap, leaving it empty.
+
+@param		bitmap
+				The bitmap to empty.
+*/
+void
+ion_bitmap_free(
+	ion_bitmap_t *bitmap
+);
+
+/**
+@brief		Adds a position to a bitmap.
+
+@param		bitmap
+				The bitmap to add to.
+@param		position
+				The position to add, which may already be there.
+@return		@c err_ok, or @c err_out_of_memory, in which case the bitmap
+			is as it was.
+*/
+ion_err_t
+ion_bitmap_add(
+	ion_bitmap_t	*bitmap,
+	uint32_t		position
+);
+
+/**
+@brief		Removes a position from a bitmap.
+
+@param		bitmap
+				The bitmap to remove from.
+@param		position
+				The position to remove.
+@return		Whether it was there.
+*/
+ion_boolean_t
+ion_bitmap_remove(
+	ion_bitmap_t	*bitmap,
+	uint32_t		position
+);
+
+/**
+@brief		Tells whether a position is in a bitmap.
+
+@param		bitmap
+				The bitmap to search.
+@param		position
+				The position to look for.
+@return		Whether it is there.
+*/
+ion_boolean_t
+ion_bitmap_contains(
+	ion_bitmap_t	*bitmap,
+	uint32_t		position
+);
+
+/**
+@brief		Counts the positions of a bitmap.
+
+@param		bitmap
+				The bitmap to count.
+@return		The number of positions.
+*/
+uint32_t
+ion_bitmap_cardinality(
+	ion_bitmap_t *bitmap
+);
+
+/**
+@brief		Counts the bytes a bitmap holds on to, its containers and
+			their positions.
+
+@param		bitmap
+				The bitmap to measure.
+@return		The number of bytes.
+*/
+size_t
+ion_bitmap_bytes(
+	ion_bitmap_t *bitmap
+);
+
+/**
+@brief		Finds the first position of a bitmap at or after another.
+
+@param		bitmap
+				The bitmap to search.
+@param		position
+				The position to start from, which receives the one found.
+@return		@c boolean_false if there is none, and @p position is left
+			as it was.
+*/
+ion_boolean_t
+ion_bitmap_next(
+	ion_bitmap_t	*bitmap,
+	uint32_t		*position
+);
+
+/**
+@brief		Copies a bitmap.
+
+@param		from
+				The bitmap to copy.
+@param		to
+				An initialized bitmap, emptied then given the positions
+				of @p from.
+@return		@c err_ok, or @c err_out_of_memory, in which case @p to is
+			left empty.
+*/
+ion_err_t
+ion_bitmap_copy(
+	ion_bitmap_t	*from,
+	ion_bitmap_t	*to
+);
+
+/**
+@brief		Intersects two bitmaps.
+
+@param		a
+				The first bitmap.
+@param		b
+				The second bitmap.
+@param		result
+				An initialized bitmap other than @p a and @p b, emptied
+				then given the positions in both.
+@return		@c err_ok, or @c err_out_of_memory, in which case @p result
+			is left empty.
+*/
+ion_err_t
+ion_bitmap_and(
+	ion_bitmap_t	*a,
+	ion_bitmap_t	*b,
+	ion_bitmap_t	*result
+);
+
+/**
+@brief		Unites two bitmaps.
+
+@param		a
+				The first bitmap.
+@param		b
+				The second bitmap.
+@param		result
+				An initialized bitmap other than @p a and @p b, emptied
+				then given the positions in either.
+@return		@c err_ok, or @c err_out_of_memory, in which case @p result
+			is left empty.
+*/
+ion_err_t
+ion_bitmap_or(
+	ion_bitmap_t	*a,
+	ion_bitmap_t	*b,
+	ion_bitmap_t	*result
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_BITMAP_H_ */
@@ -22,10 +22,52 @@
  *
  *	A LRR (least-recently-read) buffering scheme for nodes is used to
  *	simplify storage management, and, assuming some locality of reference,
- *	improve performance.
+ *	improve performance.  The size of the pool is chosen at open time, and
+ *	a CLOCK (second chance) policy may be used in place of LRR.  Either way,
+ *	the ION_BPP_MIN_BUFFER_COUNT - 1 most recently read buffers are never
+ *	replaced, as insert/delete hold that many at once.  Buffers are found
+ *	through a small hash on their disk address, so large pools stay cheap.
  *
- *	To simplify matters, both internal nodes and leafs contain the
- *	same fields.
+ *	Nodes released when siblings are joined go on a free list and are
+ *	handed out again before the file grows.  The list is chained through
+ *	the next field of each free node, with its head kept at the end of the
+ *	root, which never fills its 3 sectors.  bCompact moves the nodes at the
+ *	end of the file into the free slots and trims the file.
+ *
+ *	Node search calls the compare routine at every probe.  Keys of 4 or 8
+ *	bytes that use the stock numeric comparators are compared as native
+ *	integers instead, with the same ordering.
+ *
+ *	Leaf and internal entries share their leading [key,rec,childGE]
+ *	fields, so a separator is copied up by taking the front of a leaf
+ *	entry.  Only leaves carry the value, internal entries stop short of
+ *	it and more of them fit in a sector.
+ *
+ *	A compressed file stores every node but the root in a frame: a
+ *	header with the frame's length and kind, then the node packed or,
+ *	when packing doesn't shrink it, as it is.  Packing moves integer
+ *	keys out of the entries into varint distances, the rest goes through
+ *	page_codec_compress.  A frame still owns its whole sector, so
+ *	addresses don't change, only the bytes read and written do; readNode
+ *	guesses the length from the frames before it and reads again only
+ *	when it guessed short.  The way nodes are stored is kept in a byte
+ *	of the root just before the free list head.
+ *
+ *	A logged file never writes a node where it was.  Addresses stay
+ *	what the tree links nodes by, but a map gives where each node last
+ *	went, and every write appends the node to the segment being filled,
+ *	sectors of whole segments following two superblocks.  A commit
+ *	appends the pages of the map that changed, and above them the pages
+ *	of the map's own map up to a single top page, then writes the
+ *	superblock not written last with where the root and the top page
+ *	are.  The superblock with the valid checksum and the later sequence
+ *	is the tree, so a crash part way through a commit leaves the one
+ *	before.  A segment none of the last commit uses is reused once a
+ *	later commit has pushed that one to the device.  When more than
+ *	ION_BPP_LOG_DEAD_PERCENT of the segments in use is dead, a commit
+ *	first empties the segments with the least left alive, copying their
+ *	sectors as they are to the segment being filled; only the root and
+ *	the pages of the map are written anew.
  *
 */
 
@@ -35,11 +77,12 @@
 #define bAdr(p)		*(ion_bpp_address_t *) (p)
 #define eAdr(p)		*(ion_bpp_external_address_t *) (p)
 
-/* based on k = &[key,rec,childGE] */
+/* based on k = &[key,rec,childGE,value], value is valueSize bytes in leaves only */
 #define childLT(k)	bAdr((char *) k - sizeof(ion_bpp_address_t))
 #define key(k)		(k)
 #define rec(k)		eAdr((char *) (k) + h->keySize)
 #define childGE(k)	bAdr((char *) (k) + h->keySize + sizeof(ion_bpp_external_address_t))
+#define val(k)		((char *) (k) + h->ksi)
 
 /* based on b = &ion_bpp_buffer_t */
 #define leaf(b)		b->p->leaf
@@ -47,14 +90,42 @@
 #define next(b)		b->p->next
 #define prev(b)		b->p->prev
 #define fkey(b)		& b->p->fkey
-#define lkey(b)		(fkey(b) + ks((ct(b) - 1)))
+#define lkey(b)		(fkey(b) + ks(b, ct(b) - 1))
 #define p(b)		(char *) (b->p)
 
-/* shortcuts */
-#define ks(ct)		((ct) * h->ks)
+/* based on b = &root buffer; head of the free node list */
+#define freeHead(b) bAdr(p(b) + 3 * h->sectorSize - sizeof(ion_bpp_address_t))
+
+/* based on b = &root buffer; how the other nodes are stored */
+#define nodeFormat(b)	(*(unsigned char *) (p(b) + 3 * h->sectorSize - sizeof(ion_bpp_address_t) - 1))
+
+#define FORMAT_PLAIN	0	/* as they are in memory, the format before frames */
+#define FORMAT_PACKED	1	/* framed, packed where it shrinks them */
+#define FORMAT_FRAMED	2	/* framed, as they are */
+
+/* kind of a frame, its third byte after the 2 byte length */
+#define FRAME_RAW		0	/* the node as it is */
+#define FRAME_PACKED	1	/* 2 byte length of the key varints, 0 if the keys stayed in
+							 * the entries, the varints, then the rest compressed */
+
+/* shortcuts, based on b = &ion_bpp_buffer_t */
+#define ks(b, ct)	((ct) * (leaf(b) ? h->ks : h->ksi))
+#define maxCt(b)	(leaf(b) ? h->maxCt : h->maxCti)
+#define krSize		(h->keySize + sizeof(ion_bpp_external_address_t))	/* [key,rec] */
+
+/* based on h; the pages and segments of a log */
+#define logPerPage(h)	((long) ((h)->sectorSize / sizeof(ion_bpp_address_t)))
+#define logSegBytes(h)	((ion_bpp_address_t) ION_BPP_LOG_SEGMENT * (h)->sectorSize)
+#define logSegOf(h, a)	((long) (((a) - 2 * (h)->sectorSize) / logSegBytes(h)))
+#define logSegAt(h, s)	(2 * (h)->sectorSize + (ion_bpp_address_t) (s) * logSegBytes(h))
 
 typedef char ion_bpp_key_t;	/* keys entries are treated as char arrays */
 
+/* keys the node search compares natively instead of through comp */
+typedef enum ION_BPP_KEY_KIND {
+	bKeyGeneric, bKeySigned32, bKeySigned64, bKeyUnsigned32, bKeyUnsigned64
+} ion_bpp_key_kind_t;
+
 typedef struct {
 #if 0
 
@@ -68,10 +139,40 @@ typedef struct {
 	ion_bpp_address_t	prev;			/* prev node in sequence (leaf) */
 	ion_bpp_address_t	next;			/* next node in sequence (leaf) */
 	ion_bpp_address_t	childLT;		/* child LT first key */
-	/* ct occurrences of [key,rec,childGE] */
+	/* ct occurrences of [key,rec,childGE,value] */
 	ion_bpp_key_t		fkey;			/* first occurrence */
 } ion_bpp_node_t;
 
+/* a level of the map of a log, level 0 giving where the nodes are */
+typedef struct {
+	ion_bpp_address_t	*at;	/* where each page of the level is, 0 if never written */
+	ion_bpp_bool_t		*dirty;	/* true if the page changed since the last commit */
+	long				ct;		/* pages in the level at the last commit */
+	long				max;	/* room in at and dirty */
+} ion_bpp_log_level_t;
+
+/* a commit of a log, in one of its first two sectors */
+typedef struct {
+	char				magic[4];	/* LOG_MAGIC */
+	uint32_t			checksum;	/* FNV-1a of what follows */
+	uint32_t			seq;		/* commits before this one */
+	uint32_t			depth;		/* levels of the map */
+	ion_bpp_address_t	root;		/* where the root is */
+	ion_bpp_address_t	map;		/* where the top page of the map is */
+	ion_bpp_address_t	nodes;		/* nextFreeAdr */
+} ion_bpp_log_super_t;
+
+/* never the first bytes of a root, whose count leaves its upper 2 bytes 0 */
+#define LOG_MAGIC		"IBPL"
+
+/* the map of a map is at most this deep, far more than any file needs */
+#define LOG_MAX_DEPTH	8
+
+/* state of a segment of a log */
+#define LOG_IN_USE		0	/* holds sectors, or is being filled */
+#define LOG_EMPTIED		1	/* none in use, but the commit that left it so may not be on the device */
+#define LOG_FREE		2	/* may be filled */
+
 typedef struct ion_bpp_buffer_tag {
 	/* location of node */
 	struct ion_bpp_buffer_tag	*next;	/* next */
@@ -80,15 +181,20 @@ typedef struct ion_bpp_buffer_tag {
 	ion_bpp_node_t				*p;	/* in memory */
 	ion_bpp_bool_t				valid;		/* true if buffer contents valid */
 	ion_bpp_bool_t				modified;	/* true if buffer modified */
+	ion_bpp_bool_t				referenced;	/* CLOCK reference bit */
+	ion_bpp_bool_t				hashed;		/* true if adr is in the hash */
+	struct ion_bpp_buffer_tag	*hnext;	/* next in hash chain */
 } ion_bpp_buffer_t;
 
 /* one node for each open handle */
 typedef struct ion_bpp_h_node_tag {
 	ion_file_handle_t		fp;		/* idx file */
 	int						keySize;/* key length */
+	int						valueSize;	/* inline value length */
 	ion_bpp_bool_t			dupKeys;/* true if duplicate keys */
 	int						sectorSize;	/* block size for idx records */
 	ion_bpp_comparison_t	comp;			/* pointer to compare routine */
+	ion_bpp_key_kind_t		keyKind;/* native compare for integer keys */
 	ion_bpp_buffer_t		root;			/* root of b-tree, room for 3 sets */
 	ion_bpp_buffer_t		bufList;		/* head of buf list */
 	void					*malloc1;	/* malloc'd resources */
@@ -96,13 +202,51 @@ typedef struct ion_bpp_h_node_tag {
 	ion_bpp_buffer_t		gbuf;			/* gather buffer, room for 3 sets */
 	ion_bpp_buffer_t		*curBuf;		/* current location */
 	ion_bpp_key_t			*curKey;	/* current key in current node */
-	unsigned int			maxCt;	/* minimum # keys in node */
-	int						ks;	/* sizeof key entry */
+	unsigned int			maxCt;	/* maximum # keys in leaf */
+	unsigned int			maxCti;	/* maximum # keys in internal node */
+	int						ks;	/* sizeof leaf entry */
+	int						ksi;	/* sizeof internal entry, no value */
 	ion_bpp_address_t		nextFreeAdr;/* next free b-tree record address */
+	int						bufCt;	/* number of node buffers */
+	ion_bpp_buffer_policy_t policy;			/* buffer replacement policy */
+	int						clockHand;	/* next CLOCK candidate */
+	ion_bpp_buffer_t		**bufHash;		/* buffers hashed by adr */
+	unsigned int			hashMask;	/* number of hash slots - 1 */
+	ion_bpp_stats_t			stats;	/* counters for bStats */
+	int						groupCt;	/* dirty nodes that trigger a group write */
+	ion_bpp_sync_policy_t	syncPolicy;	/* how far bSync pushes writes */
+	int						dirtyCt;	/* buffers, root included, with modified set */
+	ion_bpp_buffer_t		**flushList;/* dirty buffers, sorted by flushAll */
+	ion_bpp_address_t		*freeList;	/* free nodes, the last is handed out first */
+	int						freeCt;	/* entries in freeList */
+	int						freeMax;/* room in freeList */
+	int						freeLinked;	/* entries whose link is already on disk */
+	ion_bpp_bool_t			framed;	/* nodes but the root are kept in frames */
+	ion_bpp_bool_t			compress;	/* frames are packed where it shrinks them */
+	ion_byte_t				*frame;	/* a frame, then a node without its keys */
+	int						readLen;/* bytes of a frame read at first */
+	ion_bpp_address_t		fileEnd;/* bytes of the file known to be written */
+	ion_bpp_bool_t			logged;	/* nodes are appended to a log, see logCommit */
+	ion_bpp_address_t		*logMap;/* where each node is, by adr / sectorSize */
+	long					logMapMax;	/* room in logMap */
+	ion_bpp_log_level_t		logLevel[LOG_MAX_DEPTH];	/* pages the map is kept in */
+	int						logDepth;	/* levels of the map at the last commit */
+	int						*logLive;	/* sectors of each segment in use */
+	unsigned char			*logState;	/* LOG_IN_USE, LOG_EMPTIED or LOG_FREE, by segment */
+	long					logSegs;/* segments in the file */
+	long					logSegMax;	/* room in logLive and logState */
+	ion_bpp_address_t		logHead;/* where the next append goes */
+	ion_bpp_address_t		logSegEnd;	/* end of the segment being filled, 0 if none */
+	uint32_t				logSeq;	/* commits so far */
+	ion_bpp_bool_t			logChanged;	/* a node moved since the last commit */
+	ion_byte_t				*logPage;	/* a page of the map, or a sector being moved */
+	ion_bpp_sync_policy_t	barrier;/* how far a commit pushes its pages before the superblock */
 } ion_bpp_h_node_t;
 
 #define error(rc) lineError(__LINE__, rc)
 
+int bErrLineNo;
+
 static ion_bpp_err_t
 lineError(
 	int				lineno,
@@ -117,626 +261,870 @@ lineError(
 	return rc;
 }
 
-static ion_bpp_address_t
-allocAdr(
-	ion_bpp_handle_t handle
+static ion_bpp_err_t
+writeDisk(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf
 ) {
-	ion_bpp_h_node_t	*h = handle;
-	ion_bpp_address_t	adr;
+	ion_bpp_h_node_t *h = handle;
 
-	adr				= h->nextFreeAdr;
-	h->nextFreeAdr	+= h->sectorSize;
-	return adr;
+	/* mark buf for writing; flushAll or eviction does the write */
+	if (!buf->modified) {
+		h->dirtyCt++;
+	}
+
+	buf->valid		= boolean_true;
+	buf->modified	= boolean_true;
+	return bErrOk;
 }
 
-static ion_bpp_err_t
-flush(
-	ion_bpp_handle_t	handle,
-	ion_bpp_buffer_t	*buf
+static int
+packNode(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_node_t		*p
 ) {
-	ion_bpp_h_node_t	*h = handle;
-	int					len;/* number of bytes to write */
-	ion_err_t			err;
+	/* frame p in h->frame, returning the frame's length */
+	ion_byte_t	*frame		= h->frame;
+	ion_byte_t	*rest		= h->frame + h->sectorSize;
+	int			header		= offsetof(ion_bpp_node_t, fkey);
+	int			entry		= p->leaf ? h->ks : h->ksi;
+	int			skip		= 0;
+	int			keyBytes	= 0;
+	int			restLen;
+	int			packed;
+	int			i;
+	uint16_t	len;
+
+	if (h->compress) {
+		/* integer keys go out as varints, the remains of the entries are compressed */
+		if ((bKeyGeneric != h->keyKind) && (0 != p->ct)) {
+			keyBytes	= page_codec_delta_encode((ion_byte_t *) &p->fkey, entry, p->ct, h->keySize, (bKeySigned32 == h->keyKind) || (bKeySigned64 == h->keyKind), frame + ION_BPP_FRAME_HEADER + 2, h->sectorSize - ION_BPP_FRAME_HEADER - 2);
+			skip		= h->keySize;
+		}
 
-	/* flush buffer to disk */
-	len = h->sectorSize;
+		if (-1 != keyBytes) {
+			memcpy(rest, p, header);
+			restLen = header;
 
-	if (buf->adr == 0) {
-		len *= 3;	/* root */
-	}
+			for (i = 0; i < (int) p->ct; i++) {
+				memcpy(rest + restLen, &p->fkey + i * entry + skip, entry - skip);
+				restLen += entry - skip;
+			}
 
-	err = ion_fwrite_at(h->fp, buf->adr, len, (ion_byte_t *) buf->p);
+			packed = page_codec_compress(rest, restLen, frame + ION_BPP_FRAME_HEADER + 2 + keyBytes, h->sectorSize - ION_BPP_FRAME_HEADER - 2 - keyBytes);
 
-	if (err_ok != err) {
-		return error(bErrIO);
+			if (-1 != packed) {
+				len			= (uint16_t) (ION_BPP_FRAME_HEADER + 2 + keyBytes + packed);
+				frame[2]	= FRAME_PACKED;
+				frame[3]	= 0;
+				frame[4]	= (ion_byte_t) (keyBytes & 0xFF);
+				frame[5]	= (ion_byte_t) (keyBytes >> 8);
+				memcpy(frame, &len, sizeof(len));
+				return len;
+			}
+		}
 	}
 
-#if 0
-	/* flush buffer to disk */
-	len = 1;
+	len			= (uint16_t) h->sectorSize;
+	frame[2]	= FRAME_RAW;
+	frame[3]	= 0;
+	memcpy(frame, &len, sizeof(len));
+	memcpy(frame + ION_BPP_FRAME_HEADER, p, h->sectorSize - ION_BPP_FRAME_HEADER);
+	return len;
+}
 
-	if (buf->adr == 0) {
-		len = 3;/* root */
+static ion_bpp_err_t
+unpackNode(
+	ion_bpp_h_node_t	*h,
+	int					len,
+	ion_bpp_node_t		*p
+) {
+	/* restore the node framed in the len bytes of h->frame into p */
+	ion_byte_t	*frame	= h->frame;
+	ion_byte_t	*rest	= h->frame + h->sectorSize;
+	int			header	= offsetof(ion_bpp_node_t, fkey);
+	int			skip	= 0;
+	int			keyBytes;
+	int			restLen;
+	int			entry;
+	int			i;
+
+	if (FRAME_RAW == frame[2]) {
+		memcpy(p, frame + ION_BPP_FRAME_HEADER, h->sectorSize - ION_BPP_FRAME_HEADER);
+		memset((char *) p + h->sectorSize - ION_BPP_FRAME_HEADER, 0, ION_BPP_FRAME_HEADER);
+		return bErrOk;
 	}
 
-	if (0 != fseek(h->fp, buf->adr, SEEK_SET)) {
+	keyBytes = frame[4] | (frame[5] << 8);
+
+	if ((FRAME_PACKED != frame[2]) || (ION_BPP_FRAME_HEADER + 2 + keyBytes > len)) {
 		return error(bErrIO);
 	}
 
-	for (i = 0; i < len; i++) {
-		if (1 != fwrite(&buf[i].p->leaf, sizeof(buf->p->leaf), 1, h->fp)) {
-			return error(bErrIO);
-		}
+	restLen = page_codec_decompress(frame + ION_BPP_FRAME_HEADER + 2 + keyBytes, len - ION_BPP_FRAME_HEADER - 2 - keyBytes, rest, h->sectorSize);
 
-		if (1 != fwrite(&buf[i].p->ct, sizeof(buf->p->ct), 1, h->fp)) {
-			return error(bErrIO);
-		}
+	if (restLen < header) {
+		return error(bErrIO);
+	}
 
-		if (1 != fwrite(&buf[i].p->prev, sizeof(buf->p->prev), 1, h->fp)) {
-			return error(bErrIO);
-		}
+	memset(p, 0, h->sectorSize);
+	memcpy(p, rest, header);
+	entry = p->leaf ? h->ks : h->ksi;
 
-		if (1 != fwrite(&buf[i].p->next, sizeof(buf->p->next), 1, h->fp)) {
-			return error(bErrIO);
-		}
+	if (0 != keyBytes) {
+		skip = h->keySize;
+	}
 
-		if (1 != fwrite(&buf[i].p->childLT, sizeof(buf->p->childLT), 1, h->fp)) {
-			return error(bErrIO);
-		}
+	if ((p->ct > (p->leaf ? h->maxCt : h->maxCti)) || (restLen != header + (int) p->ct * (entry - skip))) {
+		return error(bErrIO);
+	}
 
-		if (1 != fwrite(&buf[i].p->fkey, sizeof(buf->p->fkey), 1, h->fp)) {
-			return error(bErrIO);
-		}
+	for (i = 0; i < (int) p->ct; i++) {
+		memcpy(&p->fkey + i * entry + skip, rest + header + i * (entry - skip), entry - skip);
 	}
 
-#endif
+	if ((0 != keyBytes) && (keyBytes != page_codec_delta_decode(frame + ION_BPP_FRAME_HEADER + 2, keyBytes, (ion_byte_t *) &p->fkey, entry, p->ct, h->keySize, (bKeySigned32 == h->keyKind) || (bKeySigned64 == h->keyKind)))) {
+		return error(bErrIO);
+	}
 
-	buf->modified = boolean_false;
-	nDiskWrites++;
 	return bErrOk;
 }
 
 static ion_bpp_err_t
-flushAll(
-	ion_bpp_handle_t handle
+writeNode(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	adr,
+	ion_bpp_node_t		*p
 ) {
-	ion_bpp_h_node_t	*h = handle;
-	ion_bpp_err_t		rc;			/* return code */
-	ion_bpp_buffer_t	*buf;				/* buffer */
+	/* write a node other than the root, framed in a compressed file */
+	int len = h->sectorSize;
 
-	if (h->root.modified) {
-		if ((rc = flush(handle, &h->root)) != 0) {
-			return rc;
+	if (h->framed) {
+		len = packNode(h, p);
+
+		/* the file only ever ends on a whole sector, for readNode to read ahead */
+		if (adr + h->sectorSize > h->fileEnd) {
+			memset(h->frame + len, 0, h->sectorSize - len);
+			len = h->sectorSize;
 		}
 	}
 
-	buf = h->bufList.next;
-
-	while (buf != &h->bufList) {
-		if (buf->modified) {
-			if ((rc = flush(handle, buf)) != 0) {
-				return rc;
-			}
-		}
+	if (err_ok != ion_fwrite_at(h->fp, adr, len, h->framed ? h->frame : (ion_byte_t *) p)) {
+		return error(bErrIO);
+	}
 
-		buf = buf->next;
+	if (adr + h->sectorSize > h->fileEnd) {
+		h->fileEnd = adr + h->sectorSize;
 	}
 
+	h->stats.bytesWritten += len;
 	return bErrOk;
 }
 
 static ion_bpp_err_t
-assignBuf(
-	ion_bpp_handle_t	handle,
+readNode(
+	ion_bpp_h_node_t	*h,
 	ion_bpp_address_t	adr,
-	ion_bpp_buffer_t	**b
+	ion_bpp_node_t		*p
 ) {
-	ion_bpp_h_node_t *h = handle;
-	/* assign buf to adr */
-	ion_bpp_buffer_t	*buf;				/* buffer */
-	ion_bpp_err_t		rc;			/* return code */
+	/* read a node other than the root */
+	int			len = h->sectorSize;
+	uint16_t	frameLen;
 
-	if (adr == 0) {
-		*b = &h->root;
+	/* a log has the node where it was last appended */
+	if (h->logged && ((adr / h->sectorSize >= h->logMapMax) || (0 == (adr = h->logMap[adr / h->sectorSize])))) {
+		return error(bErrIO);
+	}
+
+	if (!h->framed) {
+		if (err_ok != ion_fread_at(h->fp, adr, len, (ion_byte_t *) p)) {
+			return error(bErrIO);
+		}
+
+		h->stats.bytesRead += len;
 		return bErrOk;
 	}
 
-	/* search for buf with matching adr */
-	buf = h->bufList.next;
+	/* ask for as much as the frames read lately took, then for any rest */
+	len = h->readLen;
 
-	while (buf->next != &h->bufList) {
-		if (buf->valid && (buf->adr == adr)) {
-			break;
-		}
+	if (err_ok != ion_fread_at(h->fp, adr, len, h->frame)) {
+		return error(bErrIO);
+	}
 
-		buf = buf->next;
+	memcpy(&frameLen, h->frame, sizeof(frameLen));
+
+	if ((frameLen < ION_BPP_FRAME_HEADER + 2) || (frameLen > h->sectorSize)) {
+		return error(bErrIO);
 	}
 
-	/* either buf points to a match, or it's last one in list (LRR) */
-	if (buf->valid) {
-		if (buf->adr != adr) {
-			if (buf->modified) {
-				if ((rc = flush(handle, buf)) != 0) {
-					return rc;
-				}
-			}
+	if ((frameLen > len) && (err_ok != ion_fread_at(h->fp, adr + len, frameLen - len, h->frame + len))) {
+		return error(bErrIO);
+	}
 
-			buf->adr	= adr;
-			buf->valid	= boolean_false;
-		}
+	h->stats.bytesRead += (frameLen > len) ? frameLen : len;
+
+	/* up at once to a longer frame, down an eighth of the way to a shorter one */
+	if (frameLen > h->readLen) {
+		h->readLen = frameLen;
 	}
 	else {
-		buf->adr = adr;
+		h->readLen -= (h->readLen - frameLen) / 8;
 	}
 
-	/* remove from current position and place at front of list */
-	buf->next->prev = buf->prev;
-	buf->prev->next = buf->next;
-	buf->next		= h->bufList.next;
-	buf->prev		= &h->bufList;
-	buf->next->prev = buf;
-	buf->prev->next = buf;
-	*b				= buf;
-	return bErrOk;
+	return unpackNode(h, frameLen, p);
 }
 
-static ion_bpp_err_t
-writeDisk(
-	ion_bpp_buffer_t *buf
+static ion_bpp_address_t
+allocAdr(
+	ion_bpp_handle_t handle
 ) {
-	/* write buf to disk */
-	buf->valid		= boolean_true;
-	buf->modified	= boolean_true;
-	return bErrOk;
-}
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_address_t	adr;
 
-static ion_bpp_err_t
-readDisk(
-	ion_bpp_handle_t	handle,
-	ion_bpp_address_t	adr,
-	ion_bpp_buffer_t	**b
-) {
-	ion_bpp_h_node_t *h = handle;
-	/* read data into buf */
-	int					len;
-	ion_bpp_buffer_t	*buf;				/* buffer */
-	ion_bpp_err_t		rc;			/* return code */
+	/* reuse a released node before growing the file */
+	if (0 != h->freeCt) {
+		adr = h->freeList[--h->freeCt];
 
-	if ((rc = assignBuf(handle, adr, &buf)) != 0) {
-		return rc;
+		if (h->freeLinked > h->freeCt) {
+			h->freeLinked = h->freeCt;
+		}
+
+		return adr;
 	}
 
-	if (!buf->valid) {
-		len = h->sectorSize;
+	adr				= h->nextFreeAdr;
+	h->nextFreeAdr	+= h->sectorSize;
+	return adr;
+}
 
-		if (adr == 0) {
-			len *= 3;	/* root */
+static void
+pushFree(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	adr
+) {
+	ion_bpp_address_t *list;
+
+	if (h->freeCt == h->freeMax) {
+		/* if there's no room the node is simply not reused */
+		if (NULL == (list = ion_realloc(ion_alloc_other, h->freeList, (h->freeMax + 16) * sizeof(ion_bpp_address_t)))) {
+			return;
 		}
 
-		ion_err_t err = ion_fread_at(h->fp, adr, len, (ion_byte_t *) buf->p);
+		h->freeList = list;
+		h->freeMax	+= 16;
+	}
 
-		if (err_ok != err) {
-			return error(bErrIO);
-		}
+	h->freeList[h->freeCt++] = adr;
+}
 
-		buf->modified	= boolean_false;
-		buf->valid		= boolean_true;
-		nDiskReads++;
+static ion_bpp_err_t
+linkFree(
+	ion_bpp_handle_t handle
+) {
+	/*
+	 * write the links of nodes freed since the last call, and the
+	 * list head in the root if it moved
+	*/
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_address_t	link;
+	ion_bpp_address_t	head;
+	int					i;
 
-#if 0
-		len = 1;
+	ion_bpp_buffer_t	*root = &h->root;
 
-		if (adr == 0) {
-			len = 3;/* root */
-		}
+	/* a log holds its free nodes in the map, by where they are not */
+	if (h->logged) {
+		h->freeLinked = h->freeCt;
+		return bErrOk;
+	}
 
-		if (0 != fseek(h->fp, buf->adr, SEEK_SET)) {
+	for (i = h->freeLinked; i < h->freeCt; i++) {
+		link = (0 == i) ? 0 : h->freeList[i - 1];
+
+		if (err_ok != ion_fwrite_at(h->fp, h->freeList[i] + offsetof(ion_bpp_node_t, next), sizeof(link), (ion_byte_t *) &link)) {
 			return error(bErrIO);
 		}
+	}
 
-		for (i = 0; i < len; i++) {
-			if (1 != fread(&buf[i].p->leaf, sizeof(buf->p->leaf), 1, h->fp)) {
-				return error(bErrIO);
-			}
+	h->freeLinked	= h->freeCt;
+	head			= (0 == h->freeCt) ? 0 : h->freeList[h->freeCt - 1];
 
-			if (1 != fread(&buf[i].p->ct, sizeof(buf->p->ct), 1, h->fp)) {
-				return error(bErrIO);
-			}
+	if (freeHead(root) != head) {
+		freeHead(root) = head;
+		writeDisk(handle, root);
+	}
 
-			if (1 != fread(&buf[i].p->prev, sizeof(buf->p->prev), 1, h->fp)) {
-				return error(bErrIO);
-			}
+	return bErrOk;
+}
 
-			if (1 != fread(&buf[i].p->next, sizeof(buf->p->next), 1, h->fp)) {
-				return error(bErrIO);
-			}
+static ion_bpp_err_t
+loadFree(
+	ion_bpp_handle_t handle
+) {
+	/* read the free list of an existing file, dropping it if it looks wrong */
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_address_t	adr;
+	int					i;
 
-			if (1 != fread(&buf[i].p->childLT, sizeof(buf->p->childLT), 1, h->fp)) {
-				return error(bErrIO);
-			}
+	ion_bpp_buffer_t *root = &h->root;
 
-			if (1 != fread(&buf[i].p->fkey, sizeof(buf->p->fkey), 1, h->fp)) {
-				return error(bErrIO);
-			}
+	adr = freeHead(root);
+
+	while (0 != adr) {
+		if ((adr < 3 * h->sectorSize) || (adr >= h->nextFreeAdr) || (0 != adr % h->sectorSize) || (h->freeCt >= h->nextFreeAdr / h->sectorSize)) {
+			h->freeCt = 0;
+			break;
 		}
 
-#endif
+		pushFree(h, adr);
 
-		buf->modified	= boolean_false;
-		buf->valid		= boolean_true;
-		nDiskReads++;
+		if (err_ok != ion_fread_at(h->fp, adr + offsetof(ion_bpp_node_t, next), sizeof(adr), (ion_byte_t *) &adr)) {
+			return error(bErrIO);
+		}
 	}
 
-	*b = buf;
+	/* read head first, but the head is handed out first */
+	for (i = 0; i < h->freeCt / 2; i++) {
+		adr								= h->freeList[i];
+		h->freeList[i]					= h->freeList[h->freeCt - 1 - i];
+		h->freeList[h->freeCt - 1 - i]	= adr;
+	}
+
+	h->freeLinked = h->freeCt;
 	return bErrOk;
 }
 
-typedef enum ION_BPP_MODE { MODE_FIRST, MODE_MATCH, MODE_FGEQ, MODE_LLEQ } ion_bpp_mode_e;
-
-static int
-search(
-	ion_bpp_handle_t			handle,
-	ion_bpp_buffer_t			*buf,
-	void						*key,
-	ion_bpp_external_address_t	rec,
-	ion_bpp_key_t				**mkey,
-	ion_bpp_mode_e				mode
+static uint32_t
+logChecksum(
+	const ion_byte_t	*bytes,
+	int					length
 ) {
-	/*
-	 * input:
-	 *   p					  pointer to node
-	 *   key					key to find
-	 *   rec					record address (dupkey only)
-	 * output:
-	 *   k					  pointer to ion_bpp_key_t info
-	 * returns:
-	 *   CC_EQ				  key = mkey
-	 *   CC_LT				  key < mkey
-	 *   CC_GT				  key > mkey
-	*/
-	ion_bpp_h_node_t	*h = handle;
-	int					cc;		/* condition code */
-	int					m;		/* midpoint of search */
-	int					lb;		/* lower-bound of binary search */
-	int					ub;		/* upper-bound of binary search */
-	ion_bpp_bool_t		foundDup;			/* true if found a duplicate key */
+	uint32_t	checksum = 2166136261UL;
+	int			i;
 
-	/* scan current node for key using binary search */
-	foundDup	= boolean_false;
-	lb			= 0;
-	ub			= ct(buf) - 1;
+	for (i = 0; i < length; i++) {
+		checksum	^= bytes[i];
+		checksum	*= 16777619UL;
+	}
 
-	while (lb <= ub) {
-		m		= (lb + ub) / 2;
-		*mkey	= fkey(buf) + ks(m);
-		cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
+	return checksum;
+}
 
-		if ((cc < 0) || ((cc == 0) && (MODE_FGEQ == mode))) {
-			/* key less than key[m] */
-			ub = m - 1;
-		}
-		else if ((cc > 0) || ((cc == 0) && (MODE_LLEQ == mode))) {
-			/* key greater than key[m] */
-			lb = m + 1;
-		}
-		else {
-			/* keys match */
-			if (h->dupKeys) {
-				switch (mode) {
-					case MODE_FIRST:
-						/* backtrack to first key */
-						ub			= m - 1;
-						foundDup	= boolean_true;
-						break;
+static ion_bpp_err_t
+logGrow(
+	void	**array,
+	long	*max,
+	long	ct,
+	size_t	size
+) {
+	/* room for ct elements of size bytes in *array, new ones zeroed */
+	void	*grown;
+	long	want;
 
-					case MODE_MATCH:
+	if (ct <= *max) {
+		return bErrOk;
+	}
 
-						/* rec's must also match */
-						if (rec < rec(*mkey)) {
-							ub	= m - 1;
-							cc	= ION_CC_LT;
-						}
-						else if (rec > rec(*mkey)) {
-							lb	= m + 1;
-							cc	= ION_CC_GT;
-						}
-						else {
-							return ION_CC_EQ;
-						}
+	want = 2 * *max + 16;
 
-						break;
+	if (want < ct) {
+		want = ct;
+	}
 
-					case MODE_FGEQ:
-					case MODE_LLEQ:	/* nop */
-						break;
-				}
-			}
-			else {
-				return cc;
-			}
-		}
+	if (NULL == (grown = ion_realloc(ion_alloc_other, *array, want * size))) {
+		return error(bErrMemory);
 	}
 
-	if (ct(buf) == 0) {
-		/* empty list */
-		*mkey = fkey(buf);
-		return ION_CC_LT;
+	memset((char *) grown + *max * size, 0, (want - *max) * size);
+	*array	= grown;
+	*max	= want;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+logGrowLevel(
+	ion_bpp_log_level_t *level,
+	long				ct
+) {
+	long			max = level->max;
+	ion_bpp_err_t	rc;			/* return code */
+
+	if ((rc = logGrow((void **) &level->at, &max, ct, sizeof(ion_bpp_address_t))) != 0) {
+		return rc;
 	}
 
-	if (h->dupKeys && (mode == MODE_FIRST) && foundDup) {
-		/* next key is first key in set of duplicates */
-		*mkey += ks(1);
-		return ION_CC_EQ;
+	max = level->max;
+
+	if ((rc = logGrow((void **) &level->dirty, &max, ct, sizeof(ion_bpp_bool_t))) != 0) {
+		return rc;
 	}
 
-	if (MODE_LLEQ == mode) {
-		*mkey	= fkey(buf) + ks(ub + 1);
-		cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
+	level->max = max;
+	return bErrOk;
+}
 
-		if ((ub == ct(buf) - 1) || ((ub != -1) && (cc <= 0))) {
-			*mkey	= fkey(buf) + ks(ub);
-			cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
-		}
+static ion_bpp_err_t
+logGrowSegs(
+	ion_bpp_h_node_t	*h,
+	long				ct
+) {
+	long			max = h->logSegMax;
+	ion_bpp_err_t	rc;			/* return code */
 
-		return cc;
+	if ((rc = logGrow((void **) &h->logLive, &max, ct, sizeof(int))) != 0) {
+		return rc;
 	}
 
-	if (MODE_FGEQ == mode) {
-		*mkey	= fkey(buf) + ks(lb);
-		cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
+	max = h->logSegMax;
 
-		if ((lb < ct(buf) - 1) && (cc < 0)) {
-			*mkey	= fkey(buf) + ks(lb + 1);
-			cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
+	if ((rc = logGrow((void **) &h->logState, &max, ct, sizeof(unsigned char))) != 0) {
+		return rc;
+	}
+
+	h->logSegMax = max;
+	return bErrOk;
+}
+
+static void
+logRelease(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	adr,
+	int					sectors
+) {
+	/* sectors at adr of the file are no longer in use */
+	if (0 != adr) {
+		h->logLive[logSegOf(h, adr)] -= sectors;
+	}
+}
+
+static ion_bpp_err_t
+logAppend(
+	ion_bpp_h_node_t	*h,
+	int					sectors,
+	ion_bpp_address_t	*adr
+) {
+	/*
+	 * output:
+	 *   adr					where the next sectors of the log go
+	 * notes:
+	 *   A segment too full for them is left, the lowest free one or a new
+	 *   one at the end of the file filled next.
+	*/
+	ion_bpp_err_t	rc;			/* return code */
+	long			s;
+
+	if (h->logHead + (ion_bpp_address_t) sectors * h->sectorSize > h->logSegEnd) {
+		for (s = 0; s < h->logSegs && LOG_FREE != h->logState[s]; s++) {}
+
+		if (s == h->logSegs) {
+			if ((rc = logGrowSegs(h, s + 1)) != 0) {
+				return rc;
+			}
+
+			h->logSegs++;
 		}
 
-		return cc;
+		h->logState[s]	= LOG_IN_USE;
+		h->logHead		= logSegAt(h, s);
+		h->logSegEnd	= h->logHead + logSegBytes(h);
 	}
 
-	/* didn't find key */
-	return cc;
+	*adr						= h->logHead;
+	h->logHead					+= (ion_bpp_address_t) sectors * h->sectorSize;
+	h->logLive[logSegOf(h, *adr)] += sectors;
+	return bErrOk;
 }
 
 static ion_bpp_err_t
-scatterRoot(
-	ion_bpp_handle_t handle
+logRemap(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	adr,
+	ion_bpp_address_t	at
 ) {
-	ion_bpp_h_node_t	*h = handle;
-	ion_bpp_buffer_t	*gbuf;
-	ion_bpp_buffer_t	*root;
+	/* the node at adr is now at at in the file, or nowhere if at is 0 */
+	long			slot = adr / h->sectorSize;
+	ion_bpp_err_t	rc;			/* return code */
 
-	/* scatter gbuf to root */
+	if ((rc = logGrow((void **) &h->logMap, &h->logMapMax, slot + 1, sizeof(ion_bpp_address_t))) != 0) {
+		return rc;
+	}
 
-	root				= &h->root;
-	gbuf				= &h->gbuf;
-	memcpy(fkey(root), fkey(gbuf), ks(ct(gbuf)));
-	childLT(fkey(root)) = childLT(fkey(gbuf));
-	ct(root)			= ct(gbuf);
-	leaf(root)			= leaf(gbuf);
+	if ((rc = logGrowLevel(&h->logLevel[0], slot / logPerPage(h) + 1)) != 0) {
+		return rc;
+	}
+
+	logRelease(h, h->logMap[slot], (0 == adr) ? 3 : 1);
+	h->logMap[slot]								= at;
+	h->logLevel[0].dirty[slot / logPerPage(h)]	= boolean_true;
+	h->logChanged								= boolean_true;
 	return bErrOk;
 }
 
 static ion_bpp_err_t
-scatter(
-	ion_bpp_handle_t	handle,
-	ion_bpp_buffer_t	*pbuf,
-	ion_bpp_key_t		*pkey,
-	int					is,
-	ion_bpp_buffer_t	**tmp
+logPut(
+	ion_bpp_h_node_t	*h,
+	int					sectors,
+	ion_byte_t			*bytes,
+	ion_bpp_address_t	*adr
 ) {
-	ion_bpp_h_node_t	*h = handle;
-	ion_bpp_buffer_t	*gbuf;				/* gather buf */
-	ion_bpp_key_t		*gkey;			/* gather buf key */
-	ion_bpp_err_t		rc;			/* return code */
-	int					iu;		/* number of tmp's used */
-	int					k0Min;	/* min #keys that can be mapped to tmp[0] */
-	int					knMin;	/* min #keys that can be mapped to tmp[1..3] */
-	int					k0Max;	/* max #keys that can be mapped to tmp[0] */
-	int					knMax;	/* max #keys that can be mapped to tmp[1..3] */
-	int					sw;		/* shift width */
-	int					len;	/* length of remainder of buf */
-	int					base;	/* base count distributed to tmps */
-	int					extra;	/* extra counts */
-	int					ct;
-	int					i;
+	/* append sectors of bytes as they are, returning where they went */
+	ion_bpp_err_t rc;	/* return code */
 
-	/*
-	 * input:
-	 *   pbuf				   parent buffer of gathered keys
-	 *   pkey				   where we insert a key if needed in parent
-	 *   is					 number of supplied tmps
-	 *   tmp					array of tmp's to be used for scattering
-	 * output:
-	 *   tmp					array of tmp's used for scattering
-	*/
+	if ((rc = logAppend(h, sectors, adr)) != 0) {
+		return rc;
+	}
 
-	/* scatter gbuf to tmps, placing 3/4 max in each tmp */
+	if (err_ok != ion_fwrite_at(h->fp, *adr, sectors * h->sectorSize, bytes)) {
+		return error(bErrIO);
+	}
 
-	gbuf	= &h->gbuf;
-	gkey	= fkey(gbuf);
-	ct		= ct(gbuf);
+	if (*adr + sectors * h->sectorSize > h->fileEnd) {
+		h->fileEnd = *adr + sectors * h->sectorSize;
+	}
 
-	/****************************************
-	 * determine number of tmps to use (iu) *
-	 ****************************************/
-	iu		= is;
+	h->stats.bytesWritten += sectors * h->sectorSize;
+	return bErrOk;
+}
 
-	/* determine limits */
-	if (leaf(gbuf)) {
-		/* minus 1 to allow for insertion */
-		k0Max	= h->maxCt - 1;
-		knMax	= h->maxCt - 1;
-		/* plus 1 to allow for deletion */
-		k0Min	= (h->maxCt / 2) + 1;
-		knMin	= (h->maxCt / 2) + 1;
+static ion_bpp_err_t
+logWrite(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	adr,
+	ion_bpp_node_t		*p
+) {
+	/* append the node at adr, the root as its 3 sectors */
+	ion_bpp_address_t	at;
+	ion_bpp_err_t		rc;			/* return code */
+
+	if (0 == adr) {
+		rc = logPut(h, 3, (ion_byte_t *) p, &at);
 	}
-	else {
-		/* can hold an extra gbuf key as it's translated to a LT pointer */
-		k0Max	= h->maxCt - 1;
-		knMax	= h->maxCt;
-		k0Min	= (h->maxCt / 2) + 1;
-		knMin	= ((h->maxCt + 1) / 2) + 1;
+	else if ((rc = logAppend(h, 1, &at)) == 0) {
+		rc = writeNode(h, at, p);
 	}
 
-	/* calculate iu, number of tmps to use */
-	while (1) {
-		if ((iu == 0) || (ct > (k0Max + (iu - 1) * knMax))) {
-			/* add a buffer */
-			if ((rc = assignBuf(handle, allocAdr(handle), &tmp[iu])) != 0) {
-				return rc;
-			}
+	if (0 != rc) {
+		return rc;
+	}
 
-			/* update sequential links */
-			if (leaf(gbuf)) {
-				/* adjust sequential links */
-				if (iu == 0) {
-					/* no tmps supplied when splitting root for first time */
-					prev(tmp[0])	= 0;
-					next(tmp[0])	= 0;
-				}
-				else {
-					prev(tmp[iu])		= tmp[iu - 1]->adr;
-					next(tmp[iu])		= next(tmp[iu - 1]);
-					next(tmp[iu - 1])	= tmp[iu]->adr;
-				}
+	return logRemap(h, adr, at);
+}
+
+static ion_bpp_err_t
+logBarrier(
+	ion_bpp_h_node_t *h
+) {
+	/* push what was written as far as the commit in progress asks */
+	switch (h->barrier) {
+		case bSyncFlush:
+
+			if (err_ok != ion_fflush(h->fp)) {
+				return error(bErrIO);
 			}
 
-			iu++;
-			nNodesIns++;
-		}
-		else if ((iu > 1) && (ct < (k0Min + (iu - 1) * knMin))) {
-			/* del a buffer */
-			iu--;
+			break;
 
-			/* adjust sequential links */
-			if (leaf(gbuf) && tmp[iu - 1]->adr) {
-				next(tmp[iu - 1]) = next(tmp[iu]);
+		case bSyncFsync:
+
+			if (err_ok != ion_fsync(h->fp)) {
+				return error(bErrIO);
 			}
 
-			next(tmp[iu - 1]) = next(tmp[iu]);
-			nNodesDel++;
-		}
-		else {
 			break;
-		}
-	}
 
-	/* establish count for each tmp used */
-	base	= ct / iu;
-	extra	= ct % iu;
+		case bSyncNone:	/* nop */
+			break;
+	}
 
-	for (i = 0; i < iu; i++) {
-		int n;
+	return bErrOk;
+}
 
-		n = base;
+static ion_bpp_err_t
+logSettle(
+	ion_bpp_h_node_t *h
+) {
+	/* once the last commit is on the device, what it left unused may be filled */
+	ion_bpp_err_t	rc;			/* return code */
+	long			s;
 
-		/* distribute extras, one at a time */
-		/* don't do to 1st node, as it may be internal and can't hold it */
-		if (i && extra) {
-			n++;
-			extra--;
+	if ((rc = logBarrier(h)) != 0) {
+		return rc;
+	}
+
+	for (s = 0; s < h->logSegs; s++) {
+		if (LOG_EMPTIED == h->logState[s]) {
+			h->logState[s] = LOG_FREE;
 		}
+	}
 
-		ct(tmp[i]) = n;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+logClean(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_bool_t		compact,
+	long				*cleaned
+) {
+	/*
+	 * input:
+	 *   compact				clean every segment holding dead sectors, and
+	 *							as many from the end as there are free ones
+	 *							before them, however little is dead
+	 * output:
+	 *   cleaned				segments emptied
+	 * notes:
+	 *   Nodes are copied as they are and the root and the pages of the
+	 *   map marked for the commit to write, so the segments are empty
+	 *   once it is done.
+	*/
+	ion_bpp_err_t		rc = bErrOk;	/* return code */
+	unsigned char		*victim;
+	ion_bpp_address_t	at;
+	long				head = (0 == h->logSegEnd) ? -1 : logSegOf(h, h->logSegEnd - 1);
+	long				slots = h->nextFreeAdr / h->sectorSize;
+	long				used;
+	long				dead;
+	long				freeCt;
+	long				best;
+	long				slot;
+	long				s;
+	long				p;
+	int					n;
+	int					l;
+
+	/* nodes not yet written have no place */
+	if (slots > h->logMapMax) {
+		slots = h->logMapMax;
 	}
 
-	/**************************************
-	 * update sequential links and parent *
-	 **************************************/
-	if (iu != is) {
-		/* link last node to next */
-		if (leaf(gbuf) && next(tmp[iu - 1])) {
-			ion_bpp_buffer_t *buf;
+	*cleaned	= 0;
+	used		= 0;
+	dead		= 0;
+	freeCt		= 0;
 
-			if ((rc = readDisk(handle, next(tmp[iu - 1]), &buf)) != 0) {
-				return rc;
-			}
+	for (s = 0; s < h->logSegs; s++) {
+		if (LOG_IN_USE == h->logState[s]) {
+			used	+= ION_BPP_LOG_SEGMENT;
+			dead	+= ION_BPP_LOG_SEGMENT - h->logLive[s];
+		}
+		else if (LOG_FREE == h->logState[s]) {
+			freeCt++;
+		}
+	}
 
-			prev(buf) = tmp[iu - 1]->adr;
+	/* the rest of the segment being filled isn't dead */
+	dead -= (h->logSegEnd - h->logHead) / h->sectorSize;
 
-			if ((rc = writeDisk(buf)) != 0) {
-				return rc;
+	if (!compact && (dead * 100 <= used * ION_BPP_LOG_DEAD_PERCENT)) {
+		return bErrOk;
+	}
+
+	if (NULL == (victim = ion_calloc(ion_alloc_buffer, h->logSegs + 1, 1))) {
+		return error(bErrMemory);
+	}
+
+	if (compact) {
+		/* from the end, each segment with a free one before it moves into it */
+		for (s = h->logSegs - 1; s >= 0; s--) {
+			if (LOG_FREE == h->logState[s]) {
+				freeCt--;
+			}
+			else if ((LOG_IN_USE == h->logState[s]) && (s != head) && ((freeCt > 0) || (h->logLive[s] < ION_BPP_LOG_SEGMENT))) {
+				freeCt		-= (freeCt > 0) ? 1 : 0;
+				victim[s]	= 1;
+				(*cleaned)++;
 			}
 		}
+	}
+	else {
+		/* the segments with the least left alive */
+		for (n = 0; n < ION_BPP_LOG_CLEAN_SEGMENTS; n++) {
+			best = -1;
 
-		/* shift keys in parent */
-		sw = ks(iu - is);
+			for (s = 0; s < h->logSegs; s++) {
+				if ((LOG_IN_USE == h->logState[s]) && (s != head) && !victim[s] && (h->logLive[s] < ION_BPP_LOG_SEGMENT) && ((-1 == best) || (h->logLive[s] < h->logLive[best]))) {
+					best = s;
+				}
+			}
 
-		if (sw < 0) {
-			len = ks(ct(pbuf)) - (pkey - fkey(pbuf)) + sw;
-			memmove(pkey, pkey - sw, len);
+			if (-1 == best) {
+				break;
+			}
+
+			victim[best] = 1;
+			(*cleaned)++;
 		}
-		else {
-			len = ks(ct(pbuf)) - (pkey - fkey(pbuf));
-			memmove(pkey + sw, pkey, len);
+	}
+
+	if (0 != *cleaned) {
+		if ((0 != h->logMap[0]) && victim[logSegOf(h, h->logMap[0])]) {
+			writeDisk(h, &h->root);
 		}
 
-		/* don't count LT buffer for empty parent */
-		if (ct(pbuf)) {
-			ct(pbuf) += iu - is;
+		for (slot = 3; slot < slots && bErrOk == rc; slot++) {
+			if ((0 == h->logMap[slot]) || !victim[logSegOf(h, h->logMap[slot])]) {
+				continue;
+			}
+
+			if (err_ok != ion_fread_at(h->fp, h->logMap[slot], h->sectorSize, h->logPage)) {
+				rc = error(bErrIO);
+			}
+			else if ((rc = logPut(h, 1, h->logPage, &at)) == 0) {
+				rc = logRemap(h, slot * h->sectorSize, at);
+				h->stats.bytesRead += h->sectorSize;
+			}
 		}
-		else {
-			ct(pbuf) += iu - is - 1;
+
+		for (l = 0; l < h->logDepth; l++) {
+			for (p = 0; p < h->logLevel[l].ct; p++) {
+				if ((0 != h->logLevel[l].at[p]) && victim[logSegOf(h, h->logLevel[l].at[p])]) {
+					h->logLevel[l].dirty[p] = boolean_true;
+					h->logChanged			= boolean_true;
+				}
+			}
 		}
+
+		h->stats.segmentsCleaned += *cleaned;
 	}
 
-	/*******************************
-	 * distribute keys to children *
-	 *******************************/
-	for (i = 0; i < iu; i++) {
-		/* update LT pointer and parent nodes */
-		if (leaf(gbuf)) {
-			/* update LT, tmp[i] */
-			childLT(fkey(tmp[i])) = 0;
+	ion_free(victim);
+	return rc;
+}
 
-			/* update parent */
-			if (i == 0) {
-				childLT(pkey) = tmp[i]->adr;
-			}
-			else {
-				memcpy(pkey, gkey, ks(1));
-				childGE(pkey)	= tmp[i]->adr;
-				pkey			+= ks(1);
-			}
+static ion_bpp_err_t
+logWriteMap(
+	ion_bpp_h_node_t *h
+) {
+	/*
+	 * notes:
+	 *   Appends each page of the map that changed, then the pages above
+	 *   them, up to a level of one page.  Pages past the end of a level,
+	 *   and levels past the top, are left by a tree that shrank.
+	*/
+	ion_bpp_log_level_t *level;
+	ion_bpp_address_t	*from;
+	ion_bpp_err_t		rc;			/* return code */
+	long				perPage = logPerPage(h);
+	long				fromCt	= h->nextFreeAdr / h->sectorSize;
+	long				ct;
+	long				p;
+	long				n;
+	int					l;
+
+	if ((rc = logGrow((void **) &h->logMap, &h->logMapMax, fromCt, sizeof(ion_bpp_address_t))) != 0) {
+		return rc;
+	}
+
+	from	= h->logMap;
+	ct		= (fromCt + perPage - 1) / perPage;
+
+	for (l = 0; l < LOG_MAX_DEPTH; l++) {
+		level = &h->logLevel[l];
+
+		if (((rc = logGrowLevel(level, ct)) != 0) || ((ct > 1) && ((rc = logGrowLevel(&h->logLevel[l + 1], (ct + perPage - 1) / perPage)) != 0))) {
+			return rc;
 		}
-		else {
-			if (i == 0) {
-				/* update LT, tmp[0] */
-				childLT(fkey(tmp[i]))	= childLT(gkey);
-				/* update LT, parent */
-				childLT(pkey)			= tmp[i]->adr;
+
+		for (p = ct; p < level->max; p++) {
+			logRelease(h, level->at[p], 1);
+			level->at[p]	= 0;
+			level->dirty[p] = boolean_false;
+		}
+
+		level->ct = ct;
+
+		for (p = 0; p < ct; p++) {
+			if (!level->dirty[p] && (0 != level->at[p])) {
+				continue;
 			}
-			else {
-				/* update LT, tmp[i] */
-				childLT(fkey(tmp[i]))	= childGE(gkey);
-				/* update parent key */
-				memcpy(pkey, gkey, ks(1));
-				childGE(pkey)			= tmp[i]->adr;
-				gkey					+= ks(1);
-				pkey					+= ks(1);
-				ct(tmp[i])--;
+
+			n = (fromCt - p * perPage < perPage) ? fromCt - p * perPage : perPage;
+			memset(h->logPage, 0, h->sectorSize);
+			memcpy(h->logPage, from + p * perPage, n * sizeof(ion_bpp_address_t));
+			logRelease(h, level->at[p], 1);
+
+			if ((rc = logPut(h, 1, h->logPage, &level->at[p])) != 0) {
+				return rc;
+			}
+
+			level->dirty[p] = boolean_false;
+
+			if (ct > 1) {
+				h->logLevel[l + 1].dirty[p / perPage] = boolean_true;
 			}
 		}
 
-		/* install keys, tmp[i] */
-		memcpy(fkey(tmp[i]), gkey, ks(ct(tmp[i])));
-		leaf(tmp[i])	= leaf(gbuf);
+		if (1 == ct) {
+			break;
+		}
 
-		gkey			+= ks(ct(tmp[i]));
+		from	= level->at;
+		fromCt	= ct;
+		ct		= (ct + perPage - 1) / perPage;
 	}
 
-	leaf(pbuf) = boolean_false;
+	if (LOG_MAX_DEPTH == l) {
+		return error(bErrMemory);
+	}
 
-	/************************
-	 * write modified nodes *
-	 ************************/
-	if ((rc = writeDisk(pbuf)) != 0) {
+	for (n = l + 1; n < h->logDepth; n++) {
+		for (p = 0; p < h->logLevel[n].ct; p++) {
+			logRelease(h, h->logLevel[n].at[p], 1);
+			h->logLevel[n].at[p] = 0;
+		}
+
+		h->logLevel[n].ct = 0;
+	}
+
+	h->logDepth = l + 1;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+logCommit(
+	ion_bpp_h_node_t *h
+) {
+	/*
+	 * notes:
+	 *   Called once every dirty node is in the log.  The map and the
+	 *   nodes go to the device before the superblock naming them is
+	 *   written over the older of the two.
+	*/
+	ion_bpp_log_super_t super;
+	ion_bpp_err_t		rc;			/* return code */
+	long				head = (0 == h->logSegEnd) ? -1 : logSegOf(h, h->logSegEnd - 1);
+	long				s;
+
+	if (!h->logChanged) {
+		return bErrOk;
+	}
+
+	if (((rc = logWriteMap(h)) != 0) || ((rc = logSettle(h)) != 0)) {
 		return rc;
 	}
 
-	for (i = 0; i < iu; i++) {
-		if ((rc = writeDisk(tmp[i])) != 0) {
-			return rc;
+	memset(&super, 0, sizeof(super));
+	memcpy(super.magic, LOG_MAGIC, sizeof(super.magic));
+	super.seq		= h->logSeq;
+	super.depth		= h->logDepth;
+	super.root		= h->logMap[0];
+	super.map		= h->logLevel[h->logDepth - 1].at[0];
+	super.nodes		= h->nextFreeAdr;
+	super.checksum	= logChecksum((ion_byte_t *) &super + offsetof(ion_bpp_log_super_t, seq), sizeof(super) - offsetof(ion_bpp_log_super_t, seq));
+
+	if (err_ok != ion_fwrite_at(h->fp, (ion_bpp_address_t) (h->logSeq & 1) * h->sectorSize, sizeof(super), (ion_byte_t *) &super)) {
+		return error(bErrIO);
+	}
+
+	h->stats.bytesWritten += sizeof(super);
+	h->logSeq++;
+	h->logChanged = boolean_false;
+
+	for (s = 0; s < h->logSegs; s++) {
+		if ((LOG_IN_USE == h->logState[s]) && (0 == h->logLive[s]) && (s != head)) {
+			h->logState[s] = LOG_EMPTIED;
 		}
 	}
 
@@ -744,280 +1132,2062 @@ scatter(
 }
 
 static ion_bpp_err_t
-gatherRoot(
-	ion_bpp_handle_t handle
+logStart(
+	ion_bpp_h_node_t *h
 ) {
-	ion_bpp_h_node_t	*h = handle;
-	ion_bpp_buffer_t	*gbuf;
-	ion_bpp_buffer_t	*root;
+	/* make a handle keep its nodes in a log */
+	if (NULL == (h->logPage = ion_alloc(ion_alloc_buffer, h->sectorSize))) {
+		return error(bErrMemory);
+	}
 
-	/* gather root to gbuf */
-	root		= &h->root;
-	gbuf		= &h->gbuf;
-	memcpy(p(gbuf), root->p, 3 * h->sectorSize);
-	leaf(gbuf)	= leaf(root);
-	ct(root)	= 0;
+	h->logged = boolean_true;
 	return bErrOk;
 }
 
+static ion_bpp_bool_t
+logFound(
+	ion_bpp_h_node_t *h
+) {
+	/* true if either superblock of a log begins the file */
+	char	magic[sizeof(LOG_MAGIC) - 1];
+	int		i;
+
+	for (i = 0; i < 2; i++) {
+		if ((err_ok == ion_fread_at(h->fp, (ion_bpp_address_t) i * h->sectorSize, sizeof(magic), (ion_byte_t *) magic)) && (0 == memcmp(magic, LOG_MAGIC, sizeof(magic)))) {
+			return boolean_true;
+		}
+	}
+
+	return boolean_false;
+}
+
 static ion_bpp_err_t
-gather(
+logLoad(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	at,
+	int					sectors
+) {
+	/* count sectors at at as in use, checking they are in the file */
+	if ((at < 2 * h->sectorSize) || (at + sectors * h->sectorSize > h->fileEnd) || (0 != at % h->sectorSize) || (logSegOf(h, at) != logSegOf(h, at + (sectors - 1) * h->sectorSize))) {
+		return error(bErrIO);
+	}
+
+	h->logLive[logSegOf(h, at)] += sectors;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+logOpen(
+	ion_bpp_h_node_t *h
+) {
+	/* take up the last commit of a log, the file's end already known */
+	ion_bpp_log_super_t super[2];
+	ion_bpp_log_level_t *level;
+	ion_bpp_address_t	*to;
+	ion_bpp_err_t		rc;			/* return code */
+	long				perPage = logPerPage(h);
+	long				ct[LOG_MAX_DEPTH];
+	long				slots;
+	long				toCt;
+	long				p;
+	long				n;
+	int					best;
+	int					i;
+	int					l;
+
+	best = -1;
+
+	for (i = 0; i < 2; i++) {
+		if ((err_ok != ion_fread_at(h->fp, (ion_bpp_address_t) i * h->sectorSize, sizeof(super[i]), (ion_byte_t *) &super[i])) || (0 != memcmp(super[i].magic, LOG_MAGIC, sizeof(super[i].magic))) || (super[i].checksum != logChecksum((ion_byte_t *) &super[i] + offsetof(ion_bpp_log_super_t, seq), sizeof(super[i]) - offsetof(ion_bpp_log_super_t, seq)))) {
+			continue;
+		}
+
+		if ((-1 == best) || ((int32_t) (super[i].seq - super[best].seq) > 0)) {
+			best = i;
+		}
+	}
+
+	if ((-1 == best) || (super[best].depth < 1) || (super[best].depth > LOG_MAX_DEPTH) || (super[best].nodes < 3 * h->sectorSize) || (0 != super[best].nodes % h->sectorSize)) {
+		return error(bErrIO);
+	}
+
+	if ((rc = logStart(h)) != 0) {
+		return rc;
+	}
+
+	h->logSeq		= super[best].seq + 1;
+	h->logDepth		= super[best].depth;
+	h->nextFreeAdr	= super[best].nodes;
+	h->logSegs		= (h->fileEnd <= 2 * h->sectorSize) ? 0 : (h->fileEnd - 2 * h->sectorSize + logSegBytes(h) - 1) / logSegBytes(h);
+	slots			= h->nextFreeAdr / h->sectorSize;
+
+	if (((rc = logGrowSegs(h, h->logSegs)) != 0) || ((rc = logGrow((void **) &h->logMap, &h->logMapMax, slots, sizeof(ion_bpp_address_t))) != 0)) {
+		return rc;
+	}
+
+	/* the pages of each level, which must end in one at the top */
+	ct[0] = (slots + perPage - 1) / perPage;
+
+	for (l = 1; l < h->logDepth; l++) {
+		ct[l] = (ct[l - 1] + perPage - 1) / perPage;
+	}
+
+	if (1 != ct[h->logDepth - 1]) {
+		return error(bErrIO);
+	}
+
+	for (l = 0; l < h->logDepth; l++) {
+		if ((rc = logGrowLevel(&h->logLevel[l], ct[l])) != 0) {
+			return rc;
+		}
+
+		h->logLevel[l].ct = ct[l];
+	}
+
+	h->logLevel[h->logDepth - 1].at[0] = super[best].map;
+
+	/* down from the top, each page giving where the pages below it are */
+	for (l = h->logDepth - 1; l >= 0; l--) {
+		level	= &h->logLevel[l];
+		to		= (0 == l) ? h->logMap : h->logLevel[l - 1].at;
+		toCt	= (0 == l) ? slots : ct[l - 1];
+
+		for (p = 0; p < level->ct; p++) {
+			if ((rc = logLoad(h, level->at[p], 1)) != 0) {
+				return rc;
+			}
+
+			if (err_ok != ion_fread_at(h->fp, level->at[p], h->sectorSize, h->logPage)) {
+				return error(bErrIO);
+			}
+
+			n = (toCt - p * perPage < perPage) ? toCt - p * perPage : perPage;
+			memcpy(to + p * perPage, h->logPage, n * sizeof(ion_bpp_address_t));
+			h->stats.bytesRead += h->sectorSize;
+		}
+	}
+
+	h->logMap[0] = super[best].root;
+
+	if ((rc = logLoad(h, h->logMap[0], 3)) != 0) {
+		return rc;
+	}
+
+	if (err_ok != ion_fread_at(h->fp, h->logMap[0], 3 * h->sectorSize, (ion_byte_t *) h->root.p)) {
+		return error(bErrIO);
+	}
+
+	h->stats.bytesRead	+= 3 * h->sectorSize;
+	h->root.valid		= boolean_true;
+	h->root.modified	= boolean_false;
+
+	/* unmapped nodes are free, the lowest handed out first */
+	for (p = slots - 1; p >= 3; p--) {
+		if (0 == h->logMap[p]) {
+			pushFree(h, p * h->sectorSize);
+		}
+		else if ((rc = logLoad(h, h->logMap[p], 1)) != 0) {
+			return rc;
+		}
+	}
+
+	h->freeLinked = h->freeCt;
+
+	for (p = 0; p < h->logSegs; p++) {
+		h->logState[p] = (0 == h->logLive[p]) ? LOG_FREE : LOG_IN_USE;
+	}
+
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+flush(
 	ion_bpp_handle_t	handle,
-	ion_bpp_buffer_t	*pbuf,
-	ion_bpp_key_t		**pkey,
-	ion_bpp_buffer_t	**tmp
+	ion_bpp_buffer_t	*buf
 ) {
 	ion_bpp_h_node_t	*h = handle;
+	int					len;/* number of bytes to write */
+	ion_err_t			err;
 	ion_bpp_err_t		rc;			/* return code */
-	ion_bpp_buffer_t	*gbuf;
-	ion_bpp_key_t		*gkey;
 
-	/*
-	 * input:
-	 *   pbuf				   parent buffer
-	 *   pkey				   pointer to match key in parent
-	 * output:
-	 *   tmp					buffers to use for scatter
-	 *   pkey				   pointer to match key in parent
+	/* the root keeps the way the other nodes are stored */
+	if ((buf->adr == 0) && h->framed) {
+		nodeFormat(buf) = h->compress ? FORMAT_PACKED : FORMAT_FRAMED;
+	}
+
+	/* flush buffer to disk */
+	if (h->logged) {
+		if ((rc = logWrite(h, buf->adr, buf->p)) != 0) {
+			return rc;
+		}
+	}
+	else if (buf->adr == 0) {
+		len = 3 * h->sectorSize;	/* root */
+
+		err = ion_fwrite_at(h->fp, 0, len, (ion_byte_t *) buf->p);
+
+		if (err_ok != err) {
+			return error(bErrIO);
+		}
+
+		if (len > h->fileEnd) {
+			h->fileEnd = len;
+		}
+
+		h->stats.bytesWritten += len;
+	}
+	else if ((rc = writeNode(h, buf->adr, buf->p)) != 0) {
+		return rc;
+	}
+
+#if 0
+	/* flush buffer to disk */
+	len = 1;
+
+	if (buf->adr == 0) {
+		len = 3;/* root */
+	}
+
+	if (0 != fseek(h->fp, buf->adr, SEEK_SET)) {
+		return error(bErrIO);
+	}
+
+	for (i = 0; i < len; i++) {
+		if (1 != fwrite(&buf[i].p->leaf, sizeof(buf->p->leaf), 1, h->fp)) {
+			return error(bErrIO);
+		}
+
+		if (1 != fwrite(&buf[i].p->ct, sizeof(buf->p->ct), 1, h->fp)) {
+			return error(bErrIO);
+		}
+
+		if (1 != fwrite(&buf[i].p->prev, sizeof(buf->p->prev), 1, h->fp)) {
+			return error(bErrIO);
+		}
+
+		if (1 != fwrite(&buf[i].p->next, sizeof(buf->p->next), 1, h->fp)) {
+			return error(bErrIO);
+		}
+
+		if (1 != fwrite(&buf[i].p->childLT, sizeof(buf->p->childLT), 1, h->fp)) {
+			return error(bErrIO);
+		}
+
+		if (1 != fwrite(&buf[i].p->fkey, sizeof(buf->p->fkey), 1, h->fp)) {
+			return error(bErrIO);
+		}
+	}
+
+#endif
+
+	if (buf->modified) {
+		h->dirtyCt--;
+	}
+
+	buf->modified = boolean_false;
+	h->stats.diskWrites++;
+	return bErrOk;
+}
+
+static int
+compareAdr(
+	const void	*a,
+	const void	*b
+) {
+	ion_bpp_address_t	adrA	= (*(ion_bpp_buffer_t **) a)->adr;
+	ion_bpp_address_t	adrB	= (*(ion_bpp_buffer_t **) b)->adr;
+
+	return (adrA > adrB) - (adrA < adrB);
+}
+
+static ion_bpp_err_t
+flushAll(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	int					n;			/* dirty buffers found */
+	long				cleaned;
+	int					i;
+
+	/* a log cleans first, the root may be among what it moves */
+	if ((rc = (h->logged ? logClean(h, boolean_false, &cleaned) : linkFree(handle))) != 0) {
+		return rc;
+	}
+
+	if (0 == h->dirtyCt) {
+		return h->logged ? logCommit(h) : bErrOk;
+	}
+
+	/* write in address order, so the batch is one sweep over the file */
+	n = 0;
+
+	if (h->root.modified) {
+		h->flushList[n++] = &h->root;
+	}
+
+	buf = h->bufList.next;
+
+	while (buf != &h->bufList) {
+		if (buf->modified) {
+			h->flushList[n++] = buf;
+		}
+
+		buf = buf->next;
+	}
+
+	qsort(h->flushList, n, sizeof(ion_bpp_buffer_t *), compareAdr);
+
+	for (i = 0; i < n; i++) {
+		if ((rc = flush(handle, h->flushList[i])) != 0) {
+			return rc;
+		}
+	}
+
+	h->stats.buffers.groupWrites++;
+	return h->logged ? logCommit(h) : bErrOk;
+}
+
+static ion_bpp_err_t
+groupCommit(
+	ion_bpp_handle_t handle
+) {
+	/*
 	 * returns:
-	 *   bErrOk				 operation successful
+	 *   as flushAll, once groupCt nodes are dirty
+	*/
+	ion_bpp_h_node_t *h = handle;
+
+	if ((0 != h->groupCt) && (h->dirtyCt >= h->groupCt)) {
+		return flushAll(handle);
+	}
+
+	return bErrOk;
+}
+
+#define hashAdr(h, adr) ((unsigned int) ((adr) / (h)->sectorSize) & (h)->hashMask)
+
+static ion_bpp_buffer_t *
+hashFind(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_address_t	adr
+) {
+	ion_bpp_buffer_t *buf;
+
+	buf = h->bufHash[hashAdr(h, adr)];
+
+	while (NULL != buf && buf->adr != adr) {
+		buf = buf->hnext;
+	}
+
+	return buf;
+}
+
+static void
+hashRemove(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_buffer_t	*buf
+) {
+	ion_bpp_buffer_t **link;
+
+	if (!buf->hashed) {
+		return;
+	}
+
+	link = &h->bufHash[hashAdr(h, buf->adr)];
+
+	while (*link != buf) {
+		link = &(*link)->hnext;
+	}
+
+	*link		= buf->hnext;
+	buf->hnext	= NULL;
+	buf->hashed = boolean_false;
+}
+
+static void
+hashInsert(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_buffer_t	*buf
+) {
+	unsigned int slot;
+
+	slot			= hashAdr(h, buf->adr);
+	buf->hnext		= h->bufHash[slot];
+	h->bufHash[slot]	= buf;
+	buf->hashed		= boolean_true;
+}
+
+static ion_bpp_buffer_t *
+clockVictim(
+	ion_bpp_h_node_t *h
+) {
+	ion_bpp_buffer_t	*bufs;
+	ion_bpp_buffer_t	*buf;
+	ion_bpp_buffer_t	*recent;
+	int					sweep;
+	int					i;
+
+	bufs = h->malloc1;
+
+	/* unprotected buffers are taken within two sweeps of the hand */
+	for (sweep = 0; sweep < 2 * h->bufCt; sweep++) {
+		buf				= &bufs[h->clockHand];
+		h->clockHand	= (h->clockHand + 1) % h->bufCt;
+
+		/* never take a buffer an insert/delete may still be holding, */
+		/* even one it has just assigned and not yet filled */
+		recent = h->bufList.next;
+
+		for (i = 0; i < ION_BPP_MIN_BUFFER_COUNT - 1 && recent != buf; i++) {
+			recent = recent->next;
+		}
+
+		if (recent == buf) {
+			continue;
+		}
+
+		if (!buf->valid) {
+			return buf;
+		}
+
+		if (buf->referenced) {
+			buf->referenced = boolean_false;
+			continue;
+		}
+
+		return buf;
+	}
+
+	/* a pool of ION_BPP_MIN_BUFFER_COUNT is all protected, so fall back to LRR */
+	return h->bufList.prev;
+}
+
+static ion_bpp_err_t
+assignBuf(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr,
+	ion_bpp_buffer_t	**b
+) {
+	ion_bpp_h_node_t *h = handle;
+	/* assign buf to adr */
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	ion_bpp_err_t		rc;			/* return code */
+
+	if (adr == 0) {
+		*b = &h->root;
+		return bErrOk;
+	}
+
+	/* search for buf with matching adr */
+	buf = hashFind(h, adr);
+
+	if (NULL == buf) {
+		/* no match, pick a buffer to replace */
+		if (bPolicyClock == h->policy) {
+			buf = clockVictim(h);
+		}
+		else {
+			/* last one in list (LRR) */
+			buf = h->bufList.prev;
+		}
+
+		if (buf->valid) {
+			h->stats.buffers.evictions++;
+
+			if (buf->modified) {
+				h->stats.buffers.writebacks++;
+
+				/* with group commit, the victim goes out with the rest of the batch */
+				if ((rc = ((0 != h->groupCt) ? flushAll(handle) : flush(handle, buf))) != 0) {
+					return rc;
+				}
+			}
+
+			buf->valid = boolean_false;
+		}
+
+		hashRemove(h, buf);
+		buf->adr		= adr;
+		buf->referenced = boolean_false;
+		hashInsert(h, buf);
+	}
+	else {
+		buf->referenced = boolean_true;
+	}
+
+	/* remove from current position and place at front of list */
+	buf->next->prev = buf->prev;
+	buf->prev->next = buf->next;
+	buf->next		= h->bufList.next;
+	buf->prev		= &h->bufList;
+	buf->next->prev = buf;
+	buf->prev->next = buf;
+	*b				= buf;
+	return bErrOk;
+}
+
+static void
+dropBuf(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf
+) {
+	/*
+	 * input:
+	 *   buf					buffer whose node is no longer in the tree
 	 * notes:
-	 *   Gather 3 buffers to gbuf.  Setup for subsequent scatter by
-	 *   doing the following:
-	 *	 - setup tmp buffer array for scattered buffers
-	 *	 - adjust pkey to point to first key of 3 buffers
+	 *   The buffer is emptied, without writing it, and made the next
+	 *   LRR victim.
+	*/
+	ion_bpp_h_node_t *h = handle;
+
+	if (buf->modified) {
+		h->dirtyCt--;
+	}
+
+	hashRemove(h, buf);
+	buf->modified	= boolean_false;
+	buf->valid		= boolean_false;
+	buf->referenced = boolean_false;
+
+	buf->next->prev = buf->prev;
+	buf->prev->next = buf->next;
+	buf->prev		= h->bufList.prev;
+	buf->next		= &h->bufList;
+	buf->prev->next = buf;
+	buf->next->prev = buf;
+}
+
+static void
+freeNode(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	/* release a node of the tree for reuse, in a log its place too */
+	if (h->logged) {
+		logRemap(h, buf->adr, 0);
+	}
+
+	pushFree(handle, buf->adr);
+	dropBuf(handle, buf);
+}
+
+static ion_bpp_err_t
+readDisk(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr,
+	ion_bpp_buffer_t	**b
+) {
+	ion_bpp_h_node_t *h = handle;
+	/* read data into buf */
+	int					len;
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	ion_bpp_err_t		rc;			/* return code */
+
+	if ((rc = assignBuf(handle, adr, &buf)) != 0) {
+		return rc;
+	}
+
+	if (adr != 0) {
+		if (buf->valid) {
+			h->stats.buffers.hits++;
+		}
+		else {
+			h->stats.buffers.misses++;
+		}
+	}
+
+	if (!buf->valid) {
+		if (adr == 0) {
+			len = 3 * h->sectorSize;	/* root */
+
+			if (err_ok != ion_fread_at(h->fp, 0, len, (ion_byte_t *) buf->p)) {
+				return error(bErrIO);
+			}
+
+			h->stats.bytesRead += len;
+		}
+		else if ((rc = readNode(h, adr, buf->p)) != 0) {
+			return rc;
+		}
+
+		buf->modified	= boolean_false;
+		buf->valid		= boolean_true;
+		h->stats.diskReads++;
+
+#if 0
+		len = 1;
+
+		if (adr == 0) {
+			len = 3;/* root */
+		}
+
+		if (0 != fseek(h->fp, buf->adr, SEEK_SET)) {
+			return error(bErrIO);
+		}
+
+		for (i = 0; i < len; i++) {
+			if (1 != fread(&buf[i].p->leaf, sizeof(buf->p->leaf), 1, h->fp)) {
+				return error(bErrIO);
+			}
+
+			if (1 != fread(&buf[i].p->ct, sizeof(buf->p->ct), 1, h->fp)) {
+				return error(bErrIO);
+			}
+
+			if (1 != fread(&buf[i].p->prev, sizeof(buf->p->prev), 1, h->fp)) {
+				return error(bErrIO);
+			}
+
+			if (1 != fread(&buf[i].p->next, sizeof(buf->p->next), 1, h->fp)) {
+				return error(bErrIO);
+			}
+
+			if (1 != fread(&buf[i].p->childLT, sizeof(buf->p->childLT), 1, h->fp)) {
+				return error(bErrIO);
+			}
+
+			if (1 != fread(&buf[i].p->fkey, sizeof(buf->p->fkey), 1, h->fp)) {
+				return error(bErrIO);
+			}
+		}
+
+#endif
+	}
+
+	*b = buf;
+	return bErrOk;
+}
+
+typedef enum ION_BPP_MODE { MODE_FIRST, MODE_MATCH, MODE_FGEQ, MODE_LLEQ } ion_bpp_mode_e;
+
+static int
+compareKeys(
+	ion_bpp_h_node_t	*h,
+	void				*key1,
+	void				*key2
+) {
+	/*
+	 * input:
+	 *   key1				   first key
+	 *   key2				   second key
+	 * returns:
+	 *   ION_CC_LT, ION_CC_EQ or ION_CC_GT, ordered as h->comp
+	 * notes:
+	 *   Integer keys are loaded with memcpy since entries are not aligned.
+	*/
+	switch (h->keyKind) {
+		case bKeySigned32: {
+			int32_t a, b;
+
+			memcpy(&a, key1, sizeof(a));
+			memcpy(&b, key2, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		case bKeySigned64: {
+			int64_t a, b;
+
+			memcpy(&a, key1, sizeof(a));
+			memcpy(&b, key2, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		case bKeyUnsigned32: {
+			uint32_t a, b;
+
+			memcpy(&a, key1, sizeof(a));
+			memcpy(&b, key2, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		case bKeyUnsigned64: {
+			uint64_t a, b;
+
+			memcpy(&a, key1, sizeof(a));
+			memcpy(&b, key2, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		default: {
+			/* callers switch on ION_CC_*, strncmp and friends return any sign */
+			int cc = h->comp(key1, key2, (ion_key_size_t) (h->keySize));
+
+			return (cc > 0) - (cc < 0);
+		}
+	}
+}
+
+static int
+search(
+	ion_bpp_handle_t			handle,
+	ion_bpp_buffer_t			*buf,
+	void						*key,
+	ion_bpp_external_address_t	rec,
+	ion_bpp_key_t				**mkey,
+	ion_bpp_mode_e				mode
+) {
+	/*
+	 * input:
+	 *   p					  pointer to node
+	 *   key					key to find
+	 *   rec					record address (dupkey only)
+	 * output:
+	 *   k					  pointer to ion_bpp_key_t info
+	 * returns:
+	 *   CC_EQ				  key = mkey
+	 *   CC_LT				  key < mkey
+	 *   CC_GT				  key > mkey
+	*/
+	ion_bpp_h_node_t	*h = handle;
+	int					cc;		/* condition code */
+	int					m;		/* midpoint of search */
+	int					lb;		/* lower-bound of binary search */
+	int					ub;		/* upper-bound of binary search */
+	ion_bpp_bool_t		foundDup;			/* true if found a duplicate key */
+
+	/* scan current node for key using binary search */
+	foundDup	= boolean_false;
+	lb			= 0;
+	ub			= ct(buf) - 1;
+
+	while (lb <= ub) {
+		m		= (lb + ub) / 2;
+		*mkey	= fkey(buf) + ks(buf, m);
+		cc		= compareKeys(h, key, key(*mkey));
+
+		if ((cc < 0) || ((cc == 0) && (MODE_FGEQ == mode))) {
+			/* key less than key[m] */
+			ub = m - 1;
+		}
+		else if ((cc > 0) || ((cc == 0) && (MODE_LLEQ == mode))) {
+			/* key greater than key[m] */
+			lb = m + 1;
+		}
+		else {
+			/* keys match */
+			if (h->dupKeys) {
+				switch (mode) {
+					case MODE_FIRST:
+						/* backtrack to first key */
+						ub			= m - 1;
+						foundDup	= boolean_true;
+						break;
+
+					case MODE_MATCH:
+
+						/* rec's must also match */
+						if (rec < rec(*mkey)) {
+							ub	= m - 1;
+							cc	= ION_CC_LT;
+						}
+						else if (rec > rec(*mkey)) {
+							lb	= m + 1;
+							cc	= ION_CC_GT;
+						}
+						else {
+							return ION_CC_EQ;
+						}
+
+						break;
+
+					case MODE_FGEQ:
+					case MODE_LLEQ:	/* nop */
+						break;
+				}
+			}
+			else {
+				return cc;
+			}
+		}
+	}
+
+	if (ct(buf) == 0) {
+		/* empty list */
+		*mkey = fkey(buf);
+		return ION_CC_LT;
+	}
+
+	if (h->dupKeys && (mode == MODE_FIRST) && foundDup) {
+		/* next key is first key in set of duplicates */
+		*mkey += ks(buf, 1);
+		return ION_CC_EQ;
+	}
+
+	if (MODE_LLEQ == mode) {
+		*mkey	= fkey(buf) + ks(buf, ub + 1);
+		cc		= compareKeys(h, key, key(*mkey));
+
+		if ((ub == ct(buf) - 1) || ((ub != -1) && (cc <= 0))) {
+			*mkey	= fkey(buf) + ks(buf, ub);
+			cc		= compareKeys(h, key, key(*mkey));
+		}
+
+		return cc;
+	}
+
+	if (MODE_FGEQ == mode) {
+		*mkey	= fkey(buf) + ks(buf, lb);
+		cc		= compareKeys(h, key, key(*mkey));
+
+		if ((lb < ct(buf) - 1) && (cc < 0)) {
+			*mkey	= fkey(buf) + ks(buf, lb + 1);
+			cc		= compareKeys(h, key, key(*mkey));
+		}
+
+		return cc;
+	}
+
+	/* didn't find key */
+	return cc;
+}
+
+static ion_bpp_err_t
+scatterRoot(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	*gbuf;
+	ion_bpp_buffer_t	*root;
+
+	/* scatter gbuf to root */
+
+	root				= &h->root;
+	gbuf				= &h->gbuf;
+	memcpy(fkey(root), fkey(gbuf), ks(gbuf, ct(gbuf)));
+	childLT(fkey(root)) = childLT(fkey(gbuf));
+	ct(root)			= ct(gbuf);
+	leaf(root)			= leaf(gbuf);
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+scatter(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*pbuf,
+	ion_bpp_key_t		*pkey,
+	int					is,
+	ion_bpp_buffer_t	**tmp
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	*gbuf;				/* gather buf */
+	ion_bpp_key_t		*gkey;			/* gather buf key */
+	ion_bpp_err_t		rc;			/* return code */
+	int					iu;		/* number of tmp's used */
+	int					k0Min;	/* min #keys that can be mapped to tmp[0] */
+	int					knMin;	/* min #keys that can be mapped to tmp[1..3] */
+	int					k0Max;	/* max #keys that can be mapped to tmp[0] */
+	int					knMax;	/* max #keys that can be mapped to tmp[1..3] */
+	int					sw;		/* shift width */
+	int					len;	/* length of remainder of buf */
+	int					base;	/* base count distributed to tmps */
+	int					extra;	/* extra counts */
+	int					ct;
+	int					i;
+
+	/*
+	 * input:
+	 *   pbuf				   parent buffer of gathered keys
+	 *   pkey				   where we insert a key if needed in parent
+	 *   is					 number of supplied tmps
+	 *   tmp					array of tmp's to be used for scattering
+	 * output:
+	 *   tmp					array of tmp's used for scattering
+	*/
+
+	/* scatter gbuf to tmps, placing 3/4 max in each tmp */
+
+	gbuf	= &h->gbuf;
+	gkey	= fkey(gbuf);
+	ct		= ct(gbuf);
+
+	/* the parent may be a root that was a leaf until now */
+	leaf(pbuf) = boolean_false;
+
+	/****************************************
+	 * determine number of tmps to use (iu) *
+	 ****************************************/
+	iu		= is;
+
+	/* determine limits */
+	if (leaf(gbuf)) {
+		/* minus 1 to allow for insertion */
+		k0Max	= h->maxCt - 1;
+		knMax	= h->maxCt - 1;
+		/* plus 1 to allow for deletion */
+		k0Min	= (h->maxCt / 2) + 1;
+		knMin	= (h->maxCt / 2) + 1;
+	}
+	else {
+		/* can hold an extra gbuf key as it's translated to a LT pointer */
+		k0Max	= h->maxCti - 1;
+		knMax	= h->maxCti;
+		k0Min	= (h->maxCti / 2) + 1;
+		knMin	= ((h->maxCti + 1) / 2) + 1;
+	}
+
+	/* calculate iu, number of tmps to use */
+	while (1) {
+		if ((iu == 0) || (ct > (k0Max + (iu - 1) * knMax))) {
+			/* add a buffer */
+			if ((rc = assignBuf(handle, allocAdr(handle), &tmp[iu])) != 0) {
+				return rc;
+			}
+
+			/* update sequential links */
+			if (leaf(gbuf)) {
+				/* adjust sequential links */
+				if (iu == 0) {
+					/* no tmps supplied when splitting root for first time */
+					prev(tmp[0])	= 0;
+					next(tmp[0])	= 0;
+				}
+				else {
+					prev(tmp[iu])		= tmp[iu - 1]->adr;
+					next(tmp[iu])		= next(tmp[iu - 1]);
+					next(tmp[iu - 1])	= tmp[iu]->adr;
+				}
+			}
+
+			iu++;
+			h->stats.nodesIns++;
+		}
+		else if ((iu > 1) && (ct < (k0Min + (iu - 1) * knMin)) && (ct <= (k0Max + (iu - 2) * knMax))) {
+			/*
+			 * del a buffer, if the rest can hold the keys: on small nodes no
+			 * count of tmps may be within both limits, and one left short is
+			 * better than adding and deleting the same buffer forever
+			*/
+			iu--;
+
+			/* adjust sequential links */
+			if (leaf(gbuf) && tmp[iu - 1]->adr) {
+				next(tmp[iu - 1]) = next(tmp[iu]);
+			}
+
+			next(tmp[iu - 1]) = next(tmp[iu]);
+			freeNode(handle, tmp[iu]);
+			h->stats.nodesDel++;
+		}
+		else {
+			break;
+		}
+	}
+
+	/* establish count for each tmp used */
+	base	= ct / iu;
+	extra	= ct % iu;
+
+	for (i = 0; i < iu; i++) {
+		int n;
+
+		n = base;
+
+		/* distribute extras, one at a time */
+		/* don't do to 1st node, as it may be internal and can't hold it */
+		if (i && extra) {
+			n++;
+			extra--;
+		}
+
+		ct(tmp[i]) = n;
+	}
+
+	/**************************************
+	 * update sequential links and parent *
+	 **************************************/
+	if (iu != is) {
+		/* link last node to next */
+		if (leaf(gbuf) && next(tmp[iu - 1])) {
+			ion_bpp_buffer_t *buf;
+
+			if ((rc = readDisk(handle, next(tmp[iu - 1]), &buf)) != 0) {
+				return rc;
+			}
+
+			prev(buf) = tmp[iu - 1]->adr;
+
+			if ((rc = writeDisk(handle, buf)) != 0) {
+				return rc;
+			}
+		}
+
+		/* shift keys in parent */
+		sw = ks(pbuf, iu - is);
+
+		if (sw < 0) {
+			len = ks(pbuf, ct(pbuf)) - (pkey - fkey(pbuf)) + sw;
+			memmove(pkey, pkey - sw, len);
+		}
+		else {
+			len = ks(pbuf, ct(pbuf)) - (pkey - fkey(pbuf));
+			memmove(pkey + sw, pkey, len);
+		}
+
+		/* don't count LT buffer for empty parent */
+		if (ct(pbuf)) {
+			ct(pbuf) += iu - is;
+		}
+		else {
+			ct(pbuf) += iu - is - 1;
+		}
+	}
+
+	/*******************************
+	 * distribute keys to children *
+	 *******************************/
+	for (i = 0; i < iu; i++) {
+		/* update LT pointer and parent nodes */
+		if (leaf(gbuf)) {
+			/* update LT, tmp[i] */
+			childLT(fkey(tmp[i])) = 0;
+
+			/* update parent */
+			if (i == 0) {
+				childLT(pkey) = tmp[i]->adr;
+			}
+			else {
+				memcpy(pkey, gkey, ks(pbuf, 1));
+				childGE(pkey)	= tmp[i]->adr;
+				pkey			+= ks(pbuf, 1);
+			}
+		}
+		else {
+			if (i == 0) {
+				/* update LT, tmp[0] */
+				childLT(fkey(tmp[i]))	= childLT(gkey);
+				/* update LT, parent */
+				childLT(pkey)			= tmp[i]->adr;
+			}
+			else {
+				/* update LT, tmp[i] */
+				childLT(fkey(tmp[i]))	= childGE(gkey);
+				/* update parent key */
+				memcpy(pkey, gkey, ks(pbuf, 1));
+				childGE(pkey)			= tmp[i]->adr;
+				gkey					+= ks(gbuf, 1);
+				pkey					+= ks(pbuf, 1);
+				ct(tmp[i])--;
+			}
+		}
+
+		/* install keys, tmp[i] */
+		memcpy(fkey(tmp[i]), gkey, ks(gbuf, ct(tmp[i])));
+		leaf(tmp[i])	= leaf(gbuf);
+
+		gkey			+= ks(gbuf, ct(tmp[i]));
+	}
+
+	/************************
+	 * write modified nodes *
+	 ************************/
+	if ((rc = writeDisk(handle, pbuf)) != 0) {
+		return rc;
+	}
+
+	for (i = 0; i < iu; i++) {
+		if ((rc = writeDisk(handle, tmp[i])) != 0) {
+			return rc;
+		}
+	}
+
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+gatherRoot(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	*gbuf;
+	ion_bpp_buffer_t	*root;
+
+	/* gather root to gbuf */
+	root		= &h->root;
+	gbuf		= &h->gbuf;
+	memcpy(p(gbuf), root->p, 3 * h->sectorSize);
+	leaf(gbuf)	= leaf(root);
+	ct(root)	= 0;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+gather(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*pbuf,
+	ion_bpp_key_t		**pkey,
+	ion_bpp_buffer_t	**tmp
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_buffer_t	*gbuf;
+	ion_bpp_key_t		*gkey;
+
+	/*
+	 * input:
+	 *   pbuf				   parent buffer
+	 *   pkey				   pointer to match key in parent
+	 * output:
+	 *   tmp					buffers to use for scatter
+	 *   pkey				   pointer to match key in parent
+	 * returns:
+	 *   bErrOk				 operation successful
+	 * notes:
+	 *   Gather 3 buffers to gbuf.  Setup for subsequent scatter by
+	 *   doing the following:
+	 *	 - setup tmp buffer array for scattered buffers
+	 *	 - adjust pkey to point to first key of 3 buffers
+	*/
+
+	/* find 3 adjacent buffers */
+	if (*pkey == lkey(pbuf)) {
+		*pkey -= ks(pbuf, 1);
+	}
+
+	if ((rc = readDisk(handle, childLT(*pkey), &tmp[0])) != 0) {
+		return rc;
+	}
+
+	if ((rc = readDisk(handle, childGE(*pkey), &tmp[1])) != 0) {
+		return rc;
+	}
+
+	if ((rc = readDisk(handle, childGE(*pkey + ks(pbuf, 1)), &tmp[2])) != 0) {
+		return rc;
+	}
+
+	/* gather nodes to gbuf */
+	gbuf			= &h->gbuf;
+	gkey			= fkey(gbuf);
+
+	/* tmp[0] */
+	childLT(gkey)	= childLT(fkey(tmp[0]));
+	memcpy(gkey, fkey(tmp[0]), ks(tmp[0], ct(tmp[0])));
+	gkey			+= ks(tmp[0], ct(tmp[0]));
+	ct(gbuf)		= ct(tmp[0]);
+
+	/* tmp[1] */
+	if (!leaf(tmp[1])) {
+		memcpy(gkey, *pkey, ks(pbuf, 1));
+		childGE(gkey)	= childLT(fkey(tmp[1]));
+		ct(gbuf)++;
+		gkey			+= ks(pbuf, 1);
+	}
+
+	memcpy(gkey, fkey(tmp[1]), ks(tmp[1], ct(tmp[1])));
+	gkey		+= ks(tmp[1], ct(tmp[1]));
+	ct(gbuf)	+= ct(tmp[1]);
+
+	/* tmp[2] */
+	if (!leaf(tmp[2])) {
+		memcpy(gkey, *pkey + ks(pbuf, 1), ks(pbuf, 1));
+		childGE(gkey)	= childLT(fkey(tmp[2]));
+		ct(gbuf)++;
+		gkey			+= ks(pbuf, 1);
+	}
+
+	memcpy(gkey, fkey(tmp[2]), ks(tmp[2], ct(tmp[2])));
+	ct(gbuf)	+= ct(tmp[2]);
+
+	leaf(gbuf)	= leaf(tmp[0]);
+
+	return bErrOk;
+}
+
+int
+bNodeCapacity(
+	ion_bpp_open_t info
+) {
+	int maxCt;
+
+	/* determine sizes and offsets */
+	/* leaf/n, prev, next, childLT, [key,rec,childGE,value]...; leaves hold the fewest */
+	maxCt	= info.sectorSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t)) - (info.compress ? ION_BPP_FRAME_HEADER : 0);
+	maxCt	/= sizeof(ion_bpp_address_t) + info.keySize + info.valueSize + sizeof(ion_bpp_external_address_t);
+	return maxCt;
+}
+
+static ion_bpp_err_t
+frameNodes(
+	ion_bpp_h_node_t	*h,
+	ion_bpp_bool_t		framed
+) {
+	/* size the nodes for, and make room to build, frames or not */
+	int			room = h->sectorSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t));
+	ion_byte_t	*frame;
+
+	if (framed) {
+		room -= ION_BPP_FRAME_HEADER;
+
+		if ((h->sectorSize > PAGE_CODEC_MAX_PAGE) || (room / h->ks < ION_BPP_MIN_NODE_KEYS)) {
+			return bErrSectorSize;
+		}
+
+		if ((NULL == h->frame) && (NULL == (frame = ion_alloc(ion_alloc_buffer, 2 * h->sectorSize)))) {
+			return error(bErrMemory);
+		}
+
+		if (NULL == h->frame) {
+			h->frame = frame;
+		}
+	}
+
+	h->framed	= framed;
+	h->maxCt	= room / h->ks;
+	h->maxCti	= room / h->ksi;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+allocPool(
+	ion_bpp_h_node_t	*h,
+	int					bufCt
+) {
+	/* give the handle a pool of bufCt buffers, keeping the root of any pool before */
+	ion_bpp_buffer_t	**flushList;
+	ion_bpp_buffer_t	**bufHash;
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	ion_bpp_node_t		*p;
+	void				*malloc1;
+	void				*malloc2;
+	unsigned int		hashMask;
+	int					i;
+
+	/* hash slots, a power of two no smaller than the pool */
+	hashMask = 1;
+
+	while ((int) hashMask < bufCt) {
+		hashMask <<= 1;
+	}
+
+	/*
+	 * Allocate bufs.
+	 * We need space for the following:
+	 *  - bufCt buffers, of size sectorSize
+	 *  - 1 buffer for root, of size 3*sectorSize
+	 *  - 1 buffer for gbuf, size 3*sectorsize + 2 extra keys
+	 *	to allow for LT pointers in last 2 nodes when gathering 3 full nodes
+	*/
+	flushList	= ion_calloc(ion_alloc_buffer, bufCt + 1, sizeof(ion_bpp_buffer_t *));
+	malloc1		= ion_calloc(ion_alloc_buffer, bufCt, sizeof(ion_bpp_buffer_t));
+	bufHash		= ion_calloc(ion_alloc_buffer, hashMask, sizeof(ion_bpp_buffer_t *));
+	malloc2		= ion_calloc(ion_alloc_buffer, 1, (bufCt + 6) * h->sectorSize + 2 * h->ks);
+
+	if ((NULL == flushList) || (NULL == malloc1) || (NULL == bufHash) || (NULL == malloc2)) {
+		ion_free(flushList);
+		ion_free(malloc1);
+		ion_free(bufHash);
+		ion_free(malloc2);
+		return error(bErrMemory);
+	}
+
+	buf = malloc1;
+	p	= malloc2;
+
+	/* initialize buflist */
+	h->bufList.next = buf;
+	h->bufList.prev = buf + (bufCt - 1);
+
+	for (i = 0; i < bufCt; i++) {
+		buf->next		= buf + 1;
+		buf->prev		= buf - 1;
+		buf->modified	= boolean_false;
+		buf->valid		= boolean_false;
+		buf->p			= p;
+		p				= (ion_bpp_node_t *) ((char *) p + h->sectorSize);
+		buf++;
+	}
+
+	h->bufList.next->prev	= &h->bufList;
+	h->bufList.prev->next	= &h->bufList;
+
+	/* initialize root */
+	if (NULL != h->root.p) {
+		memcpy(p, h->root.p, 3 * h->sectorSize);
+	}
+
+	h->root.p	= p;
+	p			= (ion_bpp_node_t *) ((char *) p + 3 * h->sectorSize);
+	h->gbuf.p	= p;/* done last to include extra 2 keys */
+
+	ion_free(h->flushList);
+	ion_free(h->malloc1);
+	ion_free(h->bufHash);
+	ion_free(h->malloc2);
+
+	h->flushList	= flushList;
+	h->malloc1		= malloc1;
+	h->bufHash		= bufHash;
+	h->malloc2		= malloc2;
+	h->hashMask		= hashMask - 1;
+	h->bufCt		= bufCt;
+	h->clockHand	= 0;
+	return bErrOk;
+}
+
+int
+bPoolSize(
+	ion_bpp_open_t	info,
+	int				bufCt
+) {
+	/* a buffer, its node and its share of the hash and flush list; then the root and gbuf */
+	return bufCt * (int) (info.sectorSize + sizeof(ion_bpp_buffer_t) + 3 * sizeof(ion_bpp_buffer_t *)) + 6 * (int) info.sectorSize;
+}
+
+ion_bpp_err_t
+bOpen(
+	ion_bpp_open_t		info,
+	ion_bpp_handle_t	*handle
+) {
+	ion_bpp_h_node_t	*h;
+	ion_bpp_err_t		rc;			/* return code */
+	int					bufCt;	/* number of tmp buffers */
+	int					maxCt;	/* maximum number of keys in a node */
+	ion_bpp_buffer_t	*root;
+
+	/* a sector must hold the node header; maxCt below checks for room for keys */
+	if ((info.sectorSize < sizeof(ion_bpp_node_t)) || (0 != info.sectorSize % 4)) {
+		return bErrSectorSize;
+	}
+
+	/* frames give their length in 2 bytes */
+	if (info.compress && (info.sectorSize > PAGE_CODEC_MAX_PAGE)) {
+		return bErrSectorSize;
+	}
+
+	/* ensure that there are at least 3 children/parent for gather/scatter */
+	maxCt = bNodeCapacity(info);
+
+	if (maxCt < ION_BPP_MIN_NODE_KEYS) {
+		return bErrSectorSize;
+	}
+
+	/* copy parms to ion_bpp_h_node_t */
+	if ((h = ion_calloc(ion_alloc_other, 1, sizeof(ion_bpp_h_node_t))) == NULL) {
+		return error(bErrMemory);
+	}
+
+	h->keySize		= info.keySize;
+	h->valueSize	= info.valueSize;
+	h->dupKeys		= info.dupKeys;
+	h->sectorSize	= info.sectorSize;
+	h->comp			= info.comp;
+	h->keyKind		= bKeyGeneric;
+
+	/* the stock numeric comparators order keys as native integers do */
+	if (dictionary_is_signed_compare(info.comp) && (sizeof(int32_t) == info.keySize)) {
+		h->keyKind = bKeySigned32;
+	}
+	else if (dictionary_is_signed_compare(info.comp) && (sizeof(int64_t) == info.keySize)) {
+		h->keyKind = bKeySigned64;
+	}
+	else if (dictionary_is_unsigned_compare(info.comp) && (sizeof(uint32_t) == info.keySize)) {
+		h->keyKind = bKeyUnsigned32;
+	}
+	else if (dictionary_is_unsigned_compare(info.comp) && (sizeof(uint64_t) == info.keySize)) {
+		h->keyKind = bKeyUnsigned64;
+	}
+
+	/* key, rec, childGE, then the value in leaves only */
+	h->ksi			= h->keySize + sizeof(ion_bpp_external_address_t) + sizeof(ion_bpp_address_t);
+	h->ks			= h->ksi + h->valueSize;
+	h->maxCt		= maxCt;
+	h->maxCti		= (info.sectorSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t))) / h->ksi;
+	h->readLen		= info.sectorSize;
+
+	/* Allocate buflist.
+	 * Never fewer than ION_BPP_MIN_BUFFER_COUNT, see bpp_tree.h.
+	*/
+	bufCt			= info.bufCt;
+
+	if (0 == bufCt) {
+		bufCt = ION_BPP_DEFAULT_BUFFER_COUNT;
+	}
+
+	if (bufCt < ION_BPP_MIN_BUFFER_COUNT) {
+		bufCt = ION_BPP_MIN_BUFFER_COUNT;
+	}
+
+	h->bufCt	= bufCt;
+	h->policy	= info.policy;
+
+	/* a batch can't outgrow the pool, eviction would write it first */
+	h->groupCt		= (info.groupCt > bufCt) ? bufCt : info.groupCt;
+	h->syncPolicy	= info.syncPolicy;
+	h->barrier		= info.syncPolicy;
+	h->dirtyCt		= 0;
+
+	if ((rc = allocPool(h, bufCt)) != 0) {
+		return rc;
+	}
+
+	root		= &h->root;
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+
+	/* initialize root */
+	if (ion_fexists(info.iName)) {
+		/* open an existing database */
+		h->fp = ion_fopen(info.iName);
+
+		if (ion_fseek(h->fp, 0, ION_FILE_END)) {
+			return error(bErrIO);
+		}
+
+		if ((h->fileEnd = ion_ftell(h->fp)) == -1) {
+			return error(bErrIO);
+		}
+
+		if (logFound(h)) {
+			/* a log has the tree of its last commit */
+			if ((rc = logOpen(h)) != 0) {
+				return rc;
+			}
+		}
+		else {
+			if ((rc = readDisk(h, 0, &root)) != 0) {
+				return rc;
+			}
+
+			/* a write torn by a crash may leave the last sector short */
+			h->nextFreeAdr = (h->fileEnd + h->sectorSize - 1) / h->sectorSize * h->sectorSize;
+		}
+
+		/* the file decides how nodes are stored, whatever info asks */
+		if ((rc = frameNodes(h, FORMAT_PLAIN != nodeFormat(root))) != 0) {
+			return rc;
+		}
+
+		h->compress = FORMAT_PACKED == nodeFormat(root);
+
+		if (!h->logged && ((rc = loadFree(h)) != 0)) {
+			return rc;
+		}
+	}
+
+	/*TODO make this cleaner **/
+#if defined(ARDUINO)
+	else if (NULL != (h->fp = ion_fopen(info.iName)).file) {
+#else
+	else if (ION_NOFILE != (h->fp = ion_fopen(info.iName))) {
+#endif
+		/* initialize root */
+		memset(root->p, 0, 3 * h->sectorSize);
+		leaf(root)		= 1;
+		h->nextFreeAdr	= 3 * h->sectorSize;
+
+		if (info.compress && ((rc = frameNodes(h, boolean_true)) != 0)) {
+			return rc;
+		}
+
+		/* the first commit writes the first superblock, the second starts out invalid */
+		if (info.logged) {
+			if ((rc = logStart(h)) != 0) {
+				return rc;
+			}
+
+			memset(h->logPage, 0, h->sectorSize);
+
+			if (err_ok != ion_fwrite_at(h->fp, h->sectorSize, h->sectorSize, h->logPage)) {
+				return error(bErrIO);
+			}
+
+			h->fileEnd = 2 * h->sectorSize;
+		}
+
+		h->compress = info.compress;
+		writeDisk(h, root);
+		flushAll(h);
+	}
+	else {
+		/* something's wrong */
+		ion_free(h);
+		return bErrFileNotOpen;
+	}
+
+	*handle = h;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bClose(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t	*h = handle;
+	int					i;
+
+	if (h == NULL) {
+		return bErrOk;
+	}
+
+	/* flush idx */
+/*TODO: Cleanup **/
+#if defined(ARDUINO)
+
+	if (h->fp.file) {
+#else
+
+	if (ION_NOFILE != h->fp) {
+#endif
+		bSync(handle);
+		ion_fclose(h->fp);
+	}
+
+	if (h->malloc2) {
+		ion_free(h->malloc2);
+	}
+
+	if (h->malloc1) {
+		ion_free(h->malloc1);
+	}
+
+	if (h->bufHash) {
+		ion_free(h->bufHash);
+	}
+
+	if (h->flushList) {
+		ion_free(h->flushList);
+	}
+
+	if (h->freeList) {
+		ion_free(h->freeList);
+	}
+
+	if (h->frame) {
+		ion_free(h->frame);
+	}
+
+	if (h->logged) {
+		for (i = 0; i < LOG_MAX_DEPTH; i++) {
+			ion_free(h->logLevel[i].at);
+			ion_free(h->logLevel[i].dirty);
+		}
+
+		ion_free(h->logMap);
+		ion_free(h->logLive);
+		ion_free(h->logState);
+		ion_free(h->logPage);
+	}
+
+	ion_free(h);
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bCurrentValue(
+	ion_bpp_handle_t	handle,
+	void				*value
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	if (NULL == h->curBuf) {
+		return bErrKeyNotFound;
+	}
+
+	memcpy(value, val(h->curKey), h->valueSize);
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bBufferStats(
+	ion_bpp_handle_t		handle,
+	ion_bpp_buffer_stats_t	*stats
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	*stats = h->stats.buffers;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bStats(
+	ion_bpp_handle_t	handle,
+	ion_bpp_stats_t		*stats
+) {
+	ion_bpp_h_node_t	*h = handle;
+	unsigned long		reads;
+
+	*stats				= h->stats;
+	stats->freeNodes	= h->freeCt;
+	stats->fileBytes	= h->logged ? h->fileEnd : h->nextFreeAdr;
+	/* the root takes the first three sectors, every other node one */
+	stats->nodes		= 1 + (h->nextFreeAdr - 3 * h->sectorSize) / h->sectorSize - h->freeCt;
+	reads				= stats->buffers.hits + stats->buffers.misses;
+
+	/* scale the divisor instead of hits once 1000 * hits could overflow */
+	if (0 == reads) {
+		stats->hitRate = 0;
+	}
+	else if (reads > 1000000UL) {
+		stats->hitRate = (unsigned int) (stats->buffers.hits / (reads / 1000));
+	}
+	else {
+		stats->hitRate = (unsigned int) ((1000 * stats->buffers.hits) / reads);
+	}
+
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bResetStats(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t	*h = handle;
+	int					maxHeight;
+
+	maxHeight				= h->stats.maxHeight;
+	memset(&h->stats, 0, sizeof(h->stats));
+	h->stats.maxHeight		= maxHeight;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bSync(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	return bSyncTo(handle, h->syncPolicy);
+}
+
+ion_bpp_err_t
+bSyncTo(
+	ion_bpp_handle_t		handle,
+	ion_bpp_sync_policy_t	policy
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;			/* return code */
+
+	/* a log pushes its pages as far before the superblock goes out */
+	h->barrier	= policy;
+	rc			= flushAll(handle);
+	h->barrier	= h->syncPolicy;
+
+	if (rc != 0) {
+		return rc;
+	}
+
+	switch (policy) {
+		case bSyncFlush:
+
+			if (err_ok != ion_fflush(h->fp)) {
+				return error(bErrIO);
+			}
+
+			break;
+
+		case bSyncFsync:
+
+			if (err_ok != ion_fsync(h->fp)) {
+				return error(bErrIO);
+			}
+
+			break;
+
+		case bSyncNone:	/* nop */
+			break;
+	}
+
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+trimFile(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	oldEnd
+) {
+	/*
+	 * input:
+	 *   oldEnd				 end of the file before nextFreeAdr was pulled back
+	 * notes:
+	 *   Where the file can't be truncated, the nodes past nextFreeAdr go
+	 *   on the free list, lowest handed out first.
+	*/
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_address_t	adr;
+	ion_bpp_buffer_t	*buf;
+	int					i;
+
+	/* no buffer may write past the new end */
+	buf = h->malloc1;
+
+	for (i = 0; i < h->bufCt; i++, buf++) {
+		if (buf->hashed && (buf->adr >= h->nextFreeAdr)) {
+			dropBuf(handle, buf);
+		}
+	}
+
+	/* in a log the nodes past the end are simply nowhere */
+	for (adr = h->nextFreeAdr; h->logged && (adr < oldEnd) && (adr / h->sectorSize < h->logMapMax); adr += h->sectorSize) {
+		if ((0 != h->logMap[adr / h->sectorSize]) && ((rc = logRemap(h, adr, 0)) != 0)) {
+			return rc;
+		}
+	}
+
+	if (((rc = flushAll(handle)) != 0) || h->logged) {
+		return rc;
+	}
+
+	if (oldEnd <= h->nextFreeAdr) {
+		return bErrOk;
+	}
+
+	if (err_ok == ion_ftruncate(h->fp, h->nextFreeAdr)) {
+		h->fileEnd = h->nextFreeAdr;
+		return bErrOk;
+	}
+
+	for (adr = oldEnd - h->sectorSize; adr >= h->nextFreeAdr; adr -= h->sectorSize) {
+		pushFree(h, adr);
+	}
+
+	h->nextFreeAdr = oldEnd;
+	return flushAll(handle);
+}
+
+static ion_bpp_err_t
+moveNode(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	from,
+	ion_bpp_address_t	to,
+	void				*key
+) {
+	/*
+	 * input:
+	 *   from				   node to move
+	 *   to					 free node to move it to
+	 *   key					room for one key
+	 * returns:
+	 *   bErrOk				 node moved, parent and siblings fixed up
+	 *   bErrKeyNotFound		node can't be found from the root, nothing moved
 	*/
+	ion_bpp_h_node_t			*h = handle;
+	ion_bpp_err_t				rc;			/* return code */
+	ion_bpp_buffer_t			*buf;
+	ion_bpp_buffer_t			*tbuf;
+	ion_bpp_key_t				*mkey;
+	ion_bpp_external_address_t	rec;
+	ion_bpp_address_t			parent;
+	ion_bpp_address_t			child;
+	ion_bpp_address_t			prevAdr;
+	ion_bpp_address_t			nextAdr;
+	ion_bpp_bool_t				isLeaf;
+	int							offset;		/* of the child pointer in parent */
+	int							cc;
+
+	if ((rc = readDisk(handle, from, &buf)) != 0) {
+		return rc;
+	}
 
-	/* find 3 adjacent buffers */
-	if (*pkey == lkey(pbuf)) {
-		*pkey -= ks(1);
+	if (0 == ct(buf)) {
+		return bErrKeyNotFound;
 	}
 
-	if ((rc = readDisk(handle, childLT(*pkey), &tmp[0])) != 0) {
-		return rc;
+	memcpy(key, key(fkey(buf)), h->keySize);
+	rec		= rec(fkey(buf));
+	isLeaf	= leaf(buf);
+	prevAdr = prev(buf);
+	nextAdr = next(buf);
+
+	/* find the pointer to the node before changing anything */
+	tbuf	= &h->root;
+	parent	= 0;
+
+	while (1) {
+		if (leaf(tbuf)) {
+			return bErrKeyNotFound;
+		}
+
+		if ((cc = search(handle, tbuf, key, rec, &mkey, MODE_MATCH)) < 0) {
+			child	= childLT(mkey);
+			offset	= (char *) &childLT(mkey) - p(tbuf);
+		}
+		else {
+			child	= childGE(mkey);
+			offset	= (char *) &childGE(mkey) - p(tbuf);
+		}
+
+		if (child == from) {
+			break;
+		}
+
+		parent = child;
+
+		if ((rc = readDisk(handle, child, &tbuf)) != 0) {
+			return rc;
+		}
 	}
 
-	if ((rc = readDisk(handle, childGE(*pkey), &tmp[1])) != 0) {
+	/* copy the node over */
+	if ((rc = readDisk(handle, from, &buf)) != 0) {
 		return rc;
 	}
 
-	if ((rc = readDisk(handle, childGE(*pkey + ks(1)), &tmp[2])) != 0) {
+	if ((rc = assignBuf(handle, to, &tbuf)) != 0) {
 		return rc;
 	}
 
-	/* gather nodes to gbuf */
-	gbuf			= &h->gbuf;
-	gkey			= fkey(gbuf);
-
-	/* tmp[0] */
-	childLT(gkey)	= childLT(fkey(tmp[0]));
-	memcpy(gkey, fkey(tmp[0]), ks(ct(tmp[0])));
-	gkey			+= ks(ct(tmp[0]));
-	ct(gbuf)		= ct(tmp[0]);
+	memcpy(tbuf->p, buf->p, h->sectorSize);
 
-	/* tmp[1] */
-	if (!leaf(tmp[1])) {
-		memcpy(gkey, *pkey, ks(1));
-		childGE(gkey)	= childLT(fkey(tmp[1]));
-		ct(gbuf)++;
-		gkey			+= ks(1);
+	if ((rc = writeDisk(handle, tbuf)) != 0) {
+		return rc;
 	}
 
-	memcpy(gkey, fkey(tmp[1]), ks(ct(tmp[1])));
-	gkey		+= ks(ct(tmp[1]));
-	ct(gbuf)	+= ct(tmp[1]);
+	dropBuf(handle, buf);
 
-	/* tmp[2] */
-	if (!leaf(tmp[2])) {
-		memcpy(gkey, *pkey + ks(1), ks(1));
-		childGE(gkey)	= childLT(fkey(tmp[2]));
-		ct(gbuf)++;
-		gkey			+= ks(1);
+	/* point the parent and the leaf's neighbours at the copy */
+	if (0 == parent) {
+		tbuf = &h->root;
+	}
+	else if ((rc = readDisk(handle, parent, &tbuf)) != 0) {
+		return rc;
 	}
 
-	memcpy(gkey, fkey(tmp[2]), ks(ct(tmp[2])));
-	ct(gbuf)	+= ct(tmp[2]);
+	bAdr(p(tbuf) + offset) = to;
 
-	leaf(gbuf)	= leaf(tmp[0]);
+	if ((rc = writeDisk(handle, tbuf)) != 0) {
+		return rc;
+	}
 
-	return bErrOk;
-}
+	if (isLeaf && prevAdr) {
+		if ((rc = readDisk(handle, prevAdr, &tbuf)) != 0) {
+			return rc;
+		}
 
-ion_bpp_err_t
-bOpen(
-	ion_bpp_open_t		info,
-	ion_bpp_handle_t	*handle
-) {
-	ion_bpp_h_node_t	*h;
-	ion_bpp_err_t		rc;			/* return code */
-	int					bufCt;	/* number of tmp buffers */
-	ion_bpp_buffer_t	*buf;				/* buffer */
-	int					maxCt;	/* maximum number of keys in a node */
-	ion_bpp_buffer_t	*root;
-	int					i;
-	ion_bpp_node_t		*p;
+		next(tbuf) = to;
 
-	if ((info.sectorSize < sizeof(ion_bpp_h_node_t)) || (0 != info.sectorSize % 4)) {
-		return bErrSectorSize;
+		if ((rc = writeDisk(handle, tbuf)) != 0) {
+			return rc;
+		}
 	}
 
-	/* determine sizes and offsets */
-	/* leaf/n, prev, next, [childLT,key,rec]... childGE */
-	/* ensure that there are at least 3 children/parent for gather/scatter */
-	maxCt	= info.sectorSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t));
-	maxCt	/= sizeof(ion_bpp_address_t) + info.keySize + sizeof(ion_bpp_external_address_t);
+	if (isLeaf && nextAdr) {
+		if ((rc = readDisk(handle, nextAdr, &tbuf)) != 0) {
+			return rc;
+		}
 
-	if (maxCt < 6) {
-		return bErrSectorSize;
-	}
+		prev(tbuf) = to;
 
-	/* copy parms to ion_bpp_h_node_t */
-	if ((h = calloc(1, sizeof(ion_bpp_h_node_t))) == NULL) {
-		return error(bErrMemory);
+		if ((rc = writeDisk(handle, tbuf)) != 0) {
+			return rc;
+		}
 	}
 
-	h->keySize		= info.keySize;
-	h->dupKeys		= info.dupKeys;
-	h->sectorSize	= info.sectorSize;
-	h->comp			= info.comp;
-
-	/* childLT, key, rec */
-	h->ks			= sizeof(ion_bpp_address_t) + h->keySize + sizeof(ion_bpp_external_address_t);
-	h->maxCt		= maxCt;
+	return bErrOk;
+}
 
-	/* Allocate buflist.
-	 * During insert/delete, need simultaneous access to 7 buffers:
-	 *  - 4 adjacent child bufs
-	 *  - 1 parent buf
-	 *  - 1 next sequential link
-	 *  - 1 lastGE
+static ion_bpp_err_t
+logCompact(
+	ion_bpp_h_node_t *h
+) {
+	/*
+	 * notes:
+	 *   Each pass cleans into the free segments the last one left, so a
+	 *   few passes draw the sectors in use to the front of the file.
 	*/
-	bufCt			= 7;
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_address_t	end;
+	long				cleaned;
+	long				s;
+	int					pass;
 
-	if ((h->malloc1 = calloc(bufCt, sizeof(ion_bpp_buffer_t))) == NULL) {
-		return error(bErrMemory);
+	if ((rc = flushAll(h)) != 0) {
+		return rc;
 	}
 
-	buf = h->malloc1;
+	for (pass = 0; pass < 4; pass++) {
+		if ((rc = logSettle(h)) != 0) {
+			return rc;
+		}
 
-	/*
-	 * Allocate bufs.
-	 * We need space for the following:
-	 *  - bufCt buffers, of size sectorSize
-	 *  - 1 buffer for root, of size 3*sectorSize
-	 *  - 1 buffer for gbuf, size 3*sectorsize + 2 extra keys
-	 *	to allow for LT pointers in last 2 nodes when gathering 3 full nodes
-	*/
-	if ((h->malloc2 = malloc((bufCt + 6) * h->sectorSize + 2 * h->ks)) == NULL) {
-		return error(bErrMemory);
+		/* the segment being filled is cleaned like any other */
+		h->logHead		= 0;
+		h->logSegEnd	= 0;
+
+		if ((rc = logClean(h, boolean_true, &cleaned)) != 0) {
+			return rc;
+		}
+
+		if (0 == cleaned) {
+			break;
+		}
+
+		if ((rc = flushAll(h)) != 0) {
+			return rc;
+		}
 	}
 
-	for (i = 0; i < (bufCt + 6) * h->sectorSize + 2 * h->ks; i++) {
-		((char *) h->malloc2)[i] = 0;
+	if ((rc = logSettle(h)) != 0) {
+		return rc;
 	}
 
-	p				= h->malloc2;
+	/* cut the file after the last segment in use, if it can be */
+	for (s = h->logSegs; (s > 0) && (LOG_FREE == h->logState[s - 1]); s--) {}
 
-	/* initialize buflist */
-	h->bufList.next = buf;
-	h->bufList.prev = buf + (bufCt - 1);
+	end = logSegAt(h, s);
 
-	for (i = 0; i < bufCt; i++) {
-		buf->next		= buf + 1;
-		buf->prev		= buf - 1;
-		buf->modified	= boolean_false;
-		buf->valid		= boolean_false;
-		buf->p			= p;
-		p				= (ion_bpp_node_t *) ((char *) p + h->sectorSize);
-		buf++;
+	if ((s < h->logSegs) && (end < h->fileEnd) && (err_ok == ion_ftruncate(h->fp, end))) {
+		h->logSegs	= s;
+		h->fileEnd	= end;
 	}
 
-	h->bufList.next->prev	= &h->bufList;
-	h->bufList.prev->next	= &h->bufList;
+	return bErrOk;
+}
 
-	/* initialize root */
-	root					= &h->root;
-	root->p					= p;
-	p						= (ion_bpp_node_t *) ((char *) p + 3 * h->sectorSize);
-	h->gbuf.p				= p;/* done last to include extra 2 keys */
+static int
+compareAdrValue(
+	const void	*a,
+	const void	*b
+) {
+	ion_bpp_address_t	adrA	= *(ion_bpp_address_t *) a;
+	ion_bpp_address_t	adrB	= *(ion_bpp_address_t *) b;
 
-	h->curBuf				= NULL;
-	h->curKey				= NULL;
+	return (adrA > adrB) - (adrA < adrB);
+}
 
-	/* initialize root */
-	if (ion_fexists(info.iName)) {
-		/* open an existing database */
-		h->fp = ion_fopen(info.iName);
+static ion_bpp_err_t
+addChildren(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf,
+	ion_bpp_address_t	**live,
+	int					*liveCt,
+	int					*liveMax
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_address_t	*grown;
+	int					k;
 
-		if ((rc = readDisk(h, 0, &root)) != 0) {
-			return rc;
-		}
+	if (*liveCt + ct(buf) + 1 > *liveMax) {
+		*liveMax = 2 * *liveMax + ct(buf) + 1;
 
-		if (ion_fseek(h->fp, 0, ION_FILE_END)) {
-			return error(bErrIO);
+		if (NULL == (grown = ion_realloc(ion_alloc_buffer, *live, *liveMax * sizeof(ion_bpp_address_t)))) {
+			return bErrMemory;
 		}
 
-		if ((h->nextFreeAdr = ion_ftell(h->fp)) == -1) {
-			return error(bErrIO);
-		}
+		*live = grown;
 	}
 
-	/*TODO make this cleaner **/
-#if defined(ARDUINO)
-	else if (NULL != (h->fp = ion_fopen(info.iName)).file) {
-#else
-	else if (NULL != (h->fp = ion_fopen(info.iName))) {
-#endif
-		/* initialize root */
-		memset(root->p, 0, 3 * h->sectorSize);
-		leaf(root)		= 1;
-		h->nextFreeAdr	= 3 * h->sectorSize;
-		root->modified	= 1;
-		flushAll(h);
-	}
-	else {
-		/* something's wrong */
-		free(h);
-		return bErrFileNotOpen;
+	(*live)[(*liveCt)++] = childLT(fkey(buf));
+
+	for (k = 0; k < ct(buf); k++) {
+		(*live)[(*liveCt)++] = childGE(fkey(buf) + ks(buf, k));
 	}
 
-	*handle = h;
 	return bErrOk;
 }
 
 ion_bpp_err_t
-bClose(
+bCompact(
 	ion_bpp_handle_t handle
 ) {
-	ion_bpp_h_node_t *h = handle;
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_buffer_t	*buf;
+	ion_bpp_address_t	*live;		/* every node below the root */
+	ion_bpp_address_t	oldEnd;
+	ion_bpp_address_t	newEnd;
+	ion_bpp_address_t	gap;
+	void				*key;
+	int					liveCt;
+	int					liveMax;
+	int					height;
+	int					start;
+	int					end;
+	int					i;
+	int					j;
 
-	if (h == NULL) {
-		return bErrOk;
+	if (h->logged) {
+		return logCompact(h);
 	}
 
-	/* flush idx */
-/*TODO: Cleanup **/
-#if defined(ARDUINO)
+	/* height below the root, down the leftmost path */
+	height	= 0;
+	buf		= &h->root;
 
-	if (h->fp.file) {
-#else
+	while (!leaf(buf)) {
+		if ((rc = readDisk(handle, childLT(fkey(buf)), &buf)) != 0) {
+			return rc;
+		}
 
-	if (h->fp) {
-#endif
-		flushAll(handle);
-		ion_fclose(h->fp);
+		height++;
 	}
 
-	if (h->malloc2) {
-		free(h->malloc2);
+	/* collect the nodes level by level, reading internal nodes only */
+	live	= NULL;
+	liveCt	= 0;
+	liveMax = 0;
+	rc		= addChildren(handle, &h->root, &live, &liveCt, &liveMax);
+	start	= 0;
+
+	for (i = 1; i < height && bErrOk == rc; i++) {
+		end = liveCt;
+
+		for (j = start; j < end && bErrOk == rc; j++) {
+			if ((rc = readDisk(handle, live[j], &buf)) == 0) {
+				rc = addChildren(handle, buf, &live, &liveCt, &liveMax);
+			}
+		}
+
+		start = end;
 	}
 
-	if (h->malloc1) {
-		free(h->malloc1);
+	if (bErrOk != rc) {
+		ion_free(live);
+		return rc;
 	}
 
-	free(h);
-	return bErrOk;
+	if (NULL == (key = ion_alloc(ion_alloc_buffer, h->keySize))) {
+		ion_free(live);
+		return error(bErrMemory);
+	}
+
+	if ((rc = flushAll(handle)) != 0) {
+		ion_free(key);
+		ion_free(live);
+		return rc;
+	}
+
+	qsort(live, liveCt, sizeof(ion_bpp_address_t), compareAdrValue);
+
+	/* move the nodes past newEnd into the gaps before it */
+	oldEnd	= h->nextFreeAdr;
+	newEnd	= 3 * h->sectorSize + (ion_bpp_address_t) liveCt * h->sectorSize;
+	gap		= 3 * h->sectorSize;
+	j		= 0;
+
+	for (i = liveCt - 1; i >= 0 && live[i] >= newEnd; i--) {
+		while (j < liveCt && live[j] == gap) {
+			j++;
+			gap += h->sectorSize;
+		}
+
+		if ((rc = moveNode(handle, live[i], gap, key)) != 0) {
+			break;
+		}
+
+		gap += h->sectorSize;
+	}
+
+	ion_free(key);
+	ion_free(live);
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+
+	if (bErrOk != rc) {
+		/* moves done so far stand, but the file can't shrink */
+		return rc;
+	}
+
+	/* every slot before newEnd holds a node now */
+	h->freeCt		= 0;
+	h->freeLinked	= 0;
+	h->nextFreeAdr	= newEnd;
+
+	return trimFile(handle, oldEnd);
 }
 
 ion_bpp_err_t
@@ -1081,12 +3251,26 @@ bFindFirstGreaterOrEqual(
 	/* find key, and return address */
 	while (1) {
 		if (leaf(buf)) {
+			if (0 == ct(buf)) {
+				return bErrKeyNotFound;
+			}
+
 			if ((cc = search(handle, buf, key, 0, &lgeqkey, MODE_LLEQ)) > 0) {
-				if ((lgeqkey - fkey(buf)) / (h->ks) == (ct(buf))) {
-					return bErrKeyNotFound;
-				}
+				if (lgeqkey == lkey(buf)) {
+					/* key falls between this leaf and the next */
+					if (0 == next(buf)) {
+						return bErrKeyNotFound;
+					}
 
-				lgeqkey += ks(1);
+					if ((rc = readDisk(handle, next(buf), &buf)) != 0) {
+						return rc;
+					}
+
+					lgeqkey = fkey(buf);
+				}
+				else {
+					lgeqkey += ks(buf, 1);
+				}
 			}
 
 			h->curBuf	= buf;
@@ -1118,6 +3302,16 @@ bInsertKey(
 	ion_bpp_handle_t			handle,
 	void						*key,
 	ion_bpp_external_address_t	rec
+) {
+	return bInsertKeyValue(handle, key, NULL, rec);
+}
+
+ion_bpp_err_t
+bInsertKeyValue(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	rec
 ) {
 	int					rc;		/* return code */
 	ion_bpp_key_t		*mkey;			/* match key */
@@ -1139,7 +3333,7 @@ bInsertKey(
 	lastLTvalid = boolean_false;
 
 	/* check for full root */
-	if (ct(root) == 3 * h->maxCt) {
+	if (ct(root) == 3 * maxCt(root)) {
 		/* gather root and scatter to 4 bufs */
 		/* this increases b-tree height by 1 */
 		if ((rc = gatherRoot(handle)) != 0) {
@@ -1158,15 +3352,15 @@ bInsertKey(
 		if (leaf(buf)) {
 			/* in leaf, and there' room guaranteed */
 
-			if (height > maxHeight) {
-				maxHeight = height;
+			if (height > h->stats.maxHeight) {
+				h->stats.maxHeight = height;
 			}
 
 			/* set mkey to point to insertion point */
 			switch (search(handle, buf, key, rec, &mkey, MODE_MATCH)) {
 				case ION_CC_LT:	/* key < mkey */
 
-					if (!h->dupKeys && (0 != ct(buf)) && (h->comp(key, mkey, (ion_key_size_t) (h->keySize)) == ION_CC_EQ)) {
+					if (!h->dupKeys && (0 != ct(buf)) && (compareKeys(h, key, mkey) == ION_CC_EQ)) {
 						return bErrDupKeys;
 					}
 
@@ -1178,29 +3372,37 @@ bInsertKey(
 
 				case ION_CC_GT:	/* key > mkey */
 
-					if (!h->dupKeys && (h->comp(key, mkey, (ion_key_size_t) (h->keySize)) == ION_CC_EQ)) {
+					if (!h->dupKeys && (compareKeys(h, key, mkey) == ION_CC_EQ)) {
 						return bErrDupKeys;
 					}
 
-					mkey += ks(1);
+					mkey += ks(buf, 1);
 					break;
 			}
 
 			/* shift items GE key to right */
 			keyOff	= mkey - fkey(buf);
-			len		= ks(ct(buf)) - keyOff;
+			len		= ks(buf, ct(buf)) - keyOff;
 
 			if (len) {
-				memmove(mkey + ks(1), mkey, len);
+				memmove(mkey + ks(buf, 1), mkey, len);
 			}
 
 			/* insert new key */
 			memcpy(key(mkey), key, h->keySize);
+
+			if (NULL != value) {
+				memcpy(val(mkey), value, h->valueSize);
+			}
+			else {
+				memset(val(mkey), 0, h->valueSize);
+			}
+
 			rec(mkey)		= rec;
 			childGE(mkey)	= 0;
 			ct(buf)++;
 
-			if ((rc = writeDisk(buf)) != 0) {
+			if ((rc = writeDisk(handle, buf)) != 0) {
 				return rc;
 			}
 
@@ -1213,17 +3415,17 @@ bInsertKey(
 					return rc;
 				}
 
-				/* tkey = fkey(tbuf) + lastGEkey; */
-				tkey		= fkey(tbuf);
+				/* the separator the descent went right of, not the first */
+				tkey		= fkey(tbuf) + lastGEkey;
 				memcpy(key(tkey), key, h->keySize);
 				rec(tkey)	= rec;
 
-				if ((rc = writeDisk(tbuf)) != 0) {
+				if ((rc = writeDisk(handle, tbuf)) != 0) {
 					return rc;
 				}
 			}
 
-			nKeysIns++;
+			h->stats.keysIns++;
 			break;
 		}
 		else {
@@ -1245,7 +3447,7 @@ bInsertKey(
 			}
 
 			/* check for room in child */
-			if (ct(cbuf) == h->maxCt) {
+			if (ct(cbuf) == maxCt(cbuf)) {
 				/* gather 3 bufs and scatter */
 				if ((rc = gather(handle, buf, &mkey, tmp)) != 0) {
 					return rc;
@@ -1275,7 +3477,7 @@ bInsertKey(
 				lastGEkey	= mkey - fkey(buf);
 
 				if (cc < 0) {
-					lastGEkey -= ks(1);
+					lastGEkey -= ks(buf, 1);
 				}
 			}
 			else {
@@ -1288,7 +3490,7 @@ bInsertKey(
 		}
 	}
 
-	return bErrOk;
+	return groupCommit(handle);
 }
 
 ion_bpp_err_t
@@ -1296,6 +3498,16 @@ bUpdateKey(
 	ion_bpp_handle_t			handle,
 	void						*key,
 	ion_bpp_external_address_t	rec
+) {
+	return bUpdateKeyValue(handle, key, NULL, rec);
+}
+
+ion_bpp_err_t
+bUpdateKeyValue(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	rec
 ) {
 	int					rc;		/* return code */
 	ion_bpp_key_t		*mkey;	/* match key */
@@ -1309,7 +3521,7 @@ bUpdateKey(
 	root = &h->root;
 
 	/* check for full root */
-	if (ct(root) == 3 * h->maxCt) {
+	if (ct(root) == 3 * maxCt(root)) {
 		/* gather root and scatter to 4 bufs */
 		/* this increases b-tree height by 1 */
 		if ((rc = gatherRoot(handle)) != 0) {
@@ -1328,8 +3540,8 @@ bUpdateKey(
 		if (leaf(buf)) {
 			/* in leaf, and there' room guaranteed */
 
-			if (height > maxHeight) {
-				maxHeight = height;
+			if (height > h->stats.maxHeight) {
+				h->stats.maxHeight = height;
 			}
 
 			/* set mkey to point to update point */
@@ -1348,6 +3560,15 @@ bUpdateKey(
 
 			/* update key */
 			rec(mkey) = rec;
+
+			if (NULL != value) {
+				memcpy(val(mkey), value, h->valueSize);
+			}
+
+			if ((rc = writeDisk(handle, buf)) != 0) {
+				return rc;
+			}
+
 			break;
 		}
 		else {
@@ -1369,7 +3590,7 @@ bUpdateKey(
 			}
 
 			/* check for room in child */
-			if (ct(cbuf) == h->maxCt) {
+			if (ct(cbuf) == maxCt(cbuf)) {
 				/* gather 3 bufs and scatter */
 				if ((rc = gather(handle, buf, &mkey, tmp)) != 0) {
 					return rc;
@@ -1396,7 +3617,7 @@ bUpdateKey(
 		}
 	}
 
-	return bErrOk;
+	return groupCommit(handle);
 }
 
 ion_bpp_err_t
@@ -1411,6 +3632,7 @@ bDeleteKey(
 	int					cc;		/* condition code */
 	ion_bpp_buffer_t	*buf;				/* buffer */
 	ion_bpp_buffer_t	*tmp[4];
+	int					i;
 	unsigned int		keyOff;
 	ion_bpp_bool_t		lastGEvalid;		/* true if GE branch taken */
 	ion_bpp_bool_t		lastLTvalid;		/* true if LT branch taken after GE branch */
@@ -1440,15 +3662,15 @@ bDeleteKey(
 
 			/* shift items GT key to left */
 			keyOff	= mkey - fkey(buf);
-			len		= ks(ct(buf) - 1) - keyOff;
+			len		= ks(buf, ct(buf) - 1) - keyOff;
 
 			if (len) {
-				memmove(mkey, mkey + ks(1), len);
+				memmove(mkey, mkey + ks(buf, 1), len);
 			}
 
 			ct(buf)--;
 
-			if ((rc = writeDisk(buf)) != 0) {
+			if ((rc = writeDisk(handle, buf)) != 0) {
 				return rc;
 			}
 
@@ -1465,12 +3687,12 @@ bDeleteKey(
 				memcpy(key(tkey), mkey, h->keySize);
 				rec(tkey)	= rec(mkey);
 
-				if ((rc = writeDisk(tbuf)) != 0) {
+				if ((rc = writeDisk(handle, tbuf)) != 0) {
 					return rc;
 				}
 			}
 
-			nKeysDel++;
+			h->stats.keysDel++;
 			break;
 		}
 		else {
@@ -1489,18 +3711,23 @@ bDeleteKey(
 				}
 			}
 
-			/* check for room to delete */
-			if (ct(cbuf) == h->maxCt / 2) {
+			/* check for room to delete, a scatter below may have left less than half */
+			if (ct(cbuf) <= maxCt(cbuf) / 2) {
 				/* gather 3 bufs and scatter */
 				if ((rc = gather(handle, buf, &mkey, tmp)) != 0) {
 					return rc;
 				}
 
 				/* if last 3 bufs in root, and count is low enough... */
-				if ((buf == root) && (ct(root) == 2) && (ct(gbuf) < (3 * (3 * h->maxCt)) / 4)) {
+				if ((buf == root) && (ct(root) == 2) && (ct(gbuf) < (3 * (3 * maxCt(gbuf))) / 4)) {
 					/* collapse tree by one level */
 					scatterRoot(handle);
-					nNodesDel += 3;
+
+					for (i = 0; i < 3; i++) {
+						freeNode(handle, tmp[i]);
+					}
+
+					h->stats.nodesDel += 3;
 					continue;
 				}
 
@@ -1528,7 +3755,7 @@ bDeleteKey(
 				lastGEkey	= mkey - fkey(buf);
 
 				if (cc < 0) {
-					lastGEkey -= ks(1);
+					lastGEkey -= ks(buf, 1);
 				}
 			}
 			else {
@@ -1541,7 +3768,7 @@ bDeleteKey(
 		}
 	}
 
-	return bErrOk;
+	return groupCommit(handle);
 }
 
 ion_bpp_err_t
@@ -1648,7 +3875,7 @@ bFindNextKey(
 	}
 	else {
 		/* bump to next key */
-		nkey = h->curKey + ks(1);
+		nkey = h->curKey + ks(buf, 1);
 	}
 
 	memcpy(key, key(nkey), h->keySize);
@@ -1658,6 +3885,96 @@ bFindNextKey(
 	return bErrOk;
 }
 
+static void
+scanCopy(
+	ion_bpp_handle_t	handle,
+	ion_bpp_scan_t		*scan,
+	ion_bpp_buffer_t	*buf
+) {
+	/*
+	 * input:
+	 *   buf					leaf to copy, only the entries in use
+	*/
+	ion_bpp_h_node_t *h = handle;
+
+	memcpy(scan->node, buf->p, (fkey(buf) - p(buf)) + ks(buf, ct(buf)));
+	scan->ct	= ct(buf);
+	scan->next	= next(buf);
+	scan->idx	= 0;
+}
+
+ion_bpp_err_t
+bScanStart(
+	ion_bpp_handle_t	handle,
+	ion_bpp_scan_t		*scan
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	if (NULL == h->curBuf) {
+		return bErrKeyNotFound;
+	}
+
+	/* the root leaf holds up to 3 sectors */
+	if ((NULL == scan->node) && (NULL == (scan->node = ion_alloc(ion_alloc_cursor, 3 * h->sectorSize)))) {
+		return error(bErrMemory);
+	}
+
+	scanCopy(handle, scan, h->curBuf);
+	scan->idx = (h->curKey - fkey(h->curBuf)) / h->ks + 1;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bScanNext(
+	ion_bpp_handle_t			handle,
+	ion_bpp_scan_t				*scan,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_key_t		*nkey;			/* next key */
+	ion_bpp_buffer_t	*buf;				/* buffer */
+
+	ion_bpp_h_node_t *h = handle;
+
+	if (NULL == scan->node) {
+		return bErrKeyNotFound;
+	}
+
+	/* step over empty leaves too, the tree may have changed under us */
+	while (scan->idx >= scan->ct) {
+		if (0 == scan->next) {
+			return bErrKeyNotFound;
+		}
+
+		if ((rc = readDisk(handle, scan->next, &buf)) != 0) {
+			return rc;
+		}
+
+		scanCopy(handle, scan, buf);
+	}
+
+	nkey = &((ion_bpp_node_t *) scan->node)->fkey + scan->idx * h->ks;
+	memcpy(key, key(nkey), h->keySize);
+
+	if (NULL != value) {
+		memcpy(value, val(nkey), h->valueSize);
+	}
+
+	*rec = rec(nkey);
+	scan->idx++;
+	return bErrOk;
+}
+
+void
+bScanEnd(
+	ion_bpp_scan_t *scan
+) {
+	ion_free(scan->node);
+	scan->node = NULL;
+}
+
 /*
  * input:
  *   handle				 handle returned by bOpen
@@ -1695,7 +4012,7 @@ bFindPrevKey(
 				return rc;
 			}
 
-			pkey = fkey(buf) + ks((ct(buf) - 1));
+			pkey = lkey(buf);
 		}
 		else {
 			/* no more sets */
@@ -1704,7 +4021,7 @@ bFindPrevKey(
 	}
 	else {
 		/* bump to previous key */
-		pkey = h->curKey - ks(1);
+		pkey = h->curKey - ks(buf, 1);
 	}
 
 	memcpy(key, key(pkey), h->keySize);
@@ -1713,3 +4030,474 @@ bFindPrevKey(
 	h->curKey	= pkey;
 	return bErrOk;
 }
+
+/*
+ * Bulk loading.
+ *
+ * Sorted input is packed into leaves from left to right, and each finished
+ * node hands its lowest [key,rec] and address up to the level above, so all
+ * levels are built in the same pass and every node is written exactly once.
+ * Each level keeps the node being filled plus the last full node, which is
+ * held back so that an underfull final node can borrow from its neighbour
+ * before either is written.  Whatever is left at the top becomes the root.
+*/
+
+#define ION_BPP_BULK_MAX_LEVELS 24
+
+typedef struct {
+	ion_bpp_buffer_t	node[2];	/* [0] held back, [1] being filled */
+	ion_bpp_key_t		*low[2];	/* lowest [key,rec] under each node */
+	int					count[2];	/* entries (leaf) or children (internal) */
+	ion_bpp_bool_t		held;		/* true if node[0] is in use */
+	long				emitted;	/* nodes written at this level */
+	ion_bpp_address_t	lastAdr;	/* last node written at this level */
+	char				*mem;		/* storage for both nodes and low keys */
+} ion_bpp_bulk_level_t;
+
+static ion_bpp_err_t
+bulkAdd(
+	ion_bpp_h_node_t		*h,
+	ion_bpp_bulk_level_t	*levels,
+	int						l,
+	ion_bpp_key_t			*entry,
+	ion_bpp_address_t		child
+);
+
+static void
+bulkSwap(
+	ion_bpp_h_node_t		*h,
+	ion_bpp_bulk_level_t	*lvl
+) {
+	ion_bpp_buffer_t	tbuf;
+	ion_bpp_key_t		*tlow;
+
+	tbuf				= lvl->node[0];
+	lvl->node[0]		= lvl->node[1];
+	lvl->node[1]		= tbuf;
+	tlow				= lvl->low[0];
+	lvl->low[0]			= lvl->low[1];
+	lvl->low[1]			= tlow;
+	lvl->count[0]		= lvl->count[1];
+	lvl->count[1]		= 0;
+	lvl->held			= boolean_true;
+
+	memset(lvl->node[1].p, 0, h->sectorSize);
+	lvl->node[1].adr	= 0;
+}
+
+static ion_bpp_err_t
+bulkEmit(
+	ion_bpp_h_node_t		*h,
+	ion_bpp_bulk_level_t	*levels,
+	int						l,
+	int						which
+) {
+	ion_bpp_bulk_level_t	*lvl = &levels[l];
+	ion_bpp_buffer_t		*buf = &lvl->node[which];
+	ion_bpp_err_t			rc;			/* return code */
+
+	if (0 == buf->adr) {
+		buf->adr = allocAdr(h);
+	}
+
+	leaf(buf) = (0 == l);
+
+	if (leaf(buf)) {
+		prev(buf) = lvl->lastAdr;
+		next(buf) = 0;
+
+		/* the held node is followed by the one being filled */
+		if ((0 == which) && (lvl->count[1] > 0)) {
+			lvl->node[1].adr	= allocAdr(h);
+			next(buf)			= lvl->node[1].adr;
+		}
+	}
+
+	if ((rc = (h->logged ? logWrite(h, buf->adr, buf->p) : writeNode(h, buf->adr, buf->p))) != 0) {
+		return rc;
+	}
+
+	h->stats.diskWrites++;
+	h->stats.nodesIns++;
+	lvl->emitted++;
+	lvl->lastAdr = buf->adr;
+
+	return bulkAdd(h, levels, l + 1, lvl->low[which], buf->adr);
+}
+
+static ion_bpp_err_t
+bulkAdd(
+	ion_bpp_h_node_t		*h,
+	ion_bpp_bulk_level_t	*levels,
+	int						l,
+	ion_bpp_key_t			*entry,
+	ion_bpp_address_t		child
+) {
+	ion_bpp_bulk_level_t	*lvl;
+	ion_bpp_buffer_t		*buf;
+	ion_bpp_key_t			*k;
+	ion_bpp_err_t			rc;
+	int						full;
+	int						i;
+
+	if (l >= ION_BPP_BULK_MAX_LEVELS) {
+		return error(bErrMemory);
+	}
+
+	lvl = &levels[l];
+
+	if (NULL == lvl->mem) {
+		/* first visit, two nodes plus their low keys in one block */
+		if ((lvl->mem = ion_calloc(ion_alloc_buffer, 1, 2 * h->sectorSize + 2 * h->ks)) == NULL) {
+			return error(bErrMemory);
+		}
+
+		for (i = 0; i < 2; i++) {
+			lvl->node[i].p	= (ion_bpp_node_t *) (lvl->mem + i * h->sectorSize);
+			lvl->low[i]		= lvl->mem + 2 * h->sectorSize + i * h->ks;
+		}
+	}
+
+	/* leaves hold maxCt keys, internal nodes maxCti keys plus childLT */
+	full = (0 == l) ? h->maxCt : h->maxCti + 1;
+
+	if (lvl->count[1] == full) {
+		if (lvl->held) {
+			if ((rc = bulkEmit(h, levels, l, 0)) != 0) {
+				return rc;
+			}
+		}
+
+		bulkSwap(h, lvl);
+	}
+
+	buf			= &lvl->node[1];
+	leaf(buf)	= (0 == l);
+
+	if (0 == lvl->count[1]) {
+		memcpy(lvl->low[1], entry, krSize);
+	}
+
+	if ((0 != l) && (0 == lvl->count[1])) {
+		childLT(fkey(buf)) = child;
+	}
+	else {
+		k	= fkey(buf) + ks(buf, ct(buf));
+		memcpy(k, entry, krSize);
+
+		if (leaf(buf)) {
+			memcpy(val(k), val(entry), h->valueSize);
+		}
+
+		childGE(k)	= child;
+		ct(buf)++;
+	}
+
+	lvl->count[1]++;
+	return bErrOk;
+}
+
+static void
+bulkBalance(
+	ion_bpp_h_node_t		*h,
+	ion_bpp_bulk_level_t	*lvl,
+	int						isLeaf
+) {
+	ion_bpp_buffer_t	*hbuf = &lvl->node[0];
+	ion_bpp_buffer_t	*cbuf = &lvl->node[1];
+	int					move;
+	ion_bpp_key_t		*last;
+
+	if (!lvl->held || (ct(cbuf) > maxCt(cbuf) / 2)) {
+		return;
+	}
+
+	move = (lvl->count[0] + lvl->count[1]) / 2 - lvl->count[1];
+
+	if (isLeaf) {
+		memmove(fkey(cbuf) + ks(cbuf, move), fkey(cbuf), ks(cbuf, ct(cbuf)));
+		memcpy(fkey(cbuf), fkey(hbuf) + ks(hbuf, ct(hbuf) - move), ks(hbuf, move));
+		ct(hbuf)	-= move;
+		ct(cbuf)	+= move;
+		memcpy(lvl->low[1], fkey(cbuf), krSize);
+	}
+	else {
+		/* rotate one child at a time through the separator */
+		while (move-- > 0) {
+			last = lkey(hbuf);
+			memmove(fkey(cbuf) + ks(cbuf, 1), fkey(cbuf), ks(cbuf, ct(cbuf)));
+			memcpy(fkey(cbuf), lvl->low[1], krSize);
+			childGE(fkey(cbuf)) = childLT(fkey(cbuf));
+			childLT(fkey(cbuf)) = childGE(last);
+			memcpy(lvl->low[1], last, krSize);
+			ct(hbuf)--;
+			ct(cbuf)++;
+		}
+	}
+
+	lvl->count[0]	= (isLeaf) ? ct(hbuf) : ct(hbuf) + 1;
+	lvl->count[1]	= (isLeaf) ? ct(cbuf) : ct(cbuf) + 1;
+}
+
+static ion_bpp_err_t
+bulkFinish(
+	ion_bpp_h_node_t		*h,
+	ion_bpp_bulk_level_t	*levels
+) {
+	ion_bpp_bulk_level_t	*lvl;
+	ion_bpp_buffer_t		*root = &h->root;
+	ion_bpp_buffer_t		*hbuf;
+	ion_bpp_buffer_t		*cbuf;
+	ion_bpp_key_t			*k;
+	ion_bpp_err_t			rc;
+	int						l;
+
+	for (l = 0; l < ION_BPP_BULK_MAX_LEVELS; l++) {
+		lvl = &levels[l];
+
+		if (0 == lvl->count[1]) {
+			/* empty input */
+			return bErrOk;
+		}
+
+		if (0 != lvl->emitted) {
+			/* level above exists, so write out what is left here */
+			bulkBalance(h, lvl, 0 == l);
+
+			if (lvl->held && ((rc = bulkEmit(h, levels, l, 0)) != 0)) {
+				return rc;
+			}
+
+			if ((rc = bulkEmit(h, levels, l, 1)) != 0) {
+				return rc;
+			}
+
+			continue;
+		}
+
+		/* top level: one or two nodes, copied into the root */
+		hbuf = &lvl->node[0];
+		cbuf = &lvl->node[1];
+
+		memset(root->p, 0, 3 * h->sectorSize);
+
+		if (!lvl->held) {
+			memcpy(root->p, cbuf->p, h->sectorSize);
+		}
+		else {
+			memcpy(root->p, hbuf->p, h->sectorSize);
+			k = fkey(root) + ks(root, ct(root));
+
+			if (0 != l) {
+				memcpy(k, lvl->low[1], krSize);
+				childGE(k) = childLT(fkey(cbuf));
+				ct(root)++;
+				k += ks(root, 1);
+			}
+
+			memcpy(k, fkey(cbuf), ks(cbuf, ct(cbuf)));
+			ct(root) += ct(cbuf);
+		}
+
+		leaf(root)		= (0 == l);
+		prev(root)		= 0;
+		next(root)		= 0;
+		writeDisk(h, root);
+
+		if (l > h->stats.maxHeight) {
+			h->stats.maxHeight = l;
+		}
+
+		return flushAll(h);
+	}
+
+	return error(bErrMemory);
+}
+
+ion_bpp_err_t
+bBulkLoad(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bulk_next_t getNext,
+	void				*context
+) {
+	ion_bpp_h_node_t			*h = handle;
+	ion_bpp_bulk_level_t		*levels;
+	ion_bpp_key_t				*entry;
+	ion_bpp_key_t				*last;
+	ion_bpp_external_address_t	rec;
+	ion_bpp_err_t				rc;
+	ion_bpp_address_t			oldEnd;
+	ion_bpp_buffer_t			*buf;
+	ion_bpp_bool_t				first;
+	int							cc;
+	int							l;
+
+	ion_bpp_buffer_t			*root = &h->root;
+
+	if (!leaf(root) || (0 != ct(root))) {
+		return bErrNotEmpty;
+	}
+
+	/* nothing below an empty root is live, lay the tree out from the front */
+	buf = h->malloc1;
+
+	for (l = 0; l < h->bufCt; l++, buf++) {
+		if (buf->hashed) {
+			dropBuf(handle, buf);
+		}
+	}
+
+	oldEnd			= h->nextFreeAdr;
+	h->freeCt		= 0;
+	h->freeLinked	= 0;
+	h->nextFreeAdr	= 3 * h->sectorSize;
+
+	/* a log gives up where the nodes were, the loaded nodes go after them */
+	if (h->logged && ((rc = trimFile(handle, oldEnd)) != 0)) {
+		return rc;
+	}
+
+	levels = ion_calloc(ion_alloc_buffer, ION_BPP_BULK_MAX_LEVELS, sizeof(ion_bpp_bulk_level_t));
+
+	if (NULL == levels) {
+		return error(bErrMemory);
+	}
+
+	/* current and previous entry, to check the input order */
+	entry = ion_calloc(ion_alloc_buffer, 2, h->ks);
+
+	if (NULL == entry) {
+		ion_free(levels);
+		return error(bErrMemory);
+	}
+
+	last	= entry + h->ks;
+	first	= boolean_true;
+
+	while (bErrOk == (rc = getNext(context, key(entry), val(entry), &rec))) {
+		rec(entry) = rec;
+
+		if (!first) {
+			cc = compareKeys(h, key(entry), key(last));
+
+			if ((cc < 0) || ((0 == cc) && (!h->dupKeys || (rec <= rec(last))))) {
+				rc = bErrKeyOrder;
+				break;
+			}
+		}
+
+		if ((rc = bulkAdd(h, levels, 0, entry, 0)) != 0) {
+			break;
+		}
+
+		memcpy(last, entry, h->ks);
+		first = boolean_false;
+		h->stats.keysIns++;
+	}
+
+	if (bErrKeyNotFound == rc) {
+		/* input exhausted */
+		rc = bulkFinish(h, levels);
+	}
+
+	for (l = 0; l < ION_BPP_BULK_MAX_LEVELS; l++) {
+		if (NULL != levels[l].mem) {
+			ion_free(levels[l].mem);
+		}
+	}
+
+	ion_free(entry);
+	ion_free(levels);
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+
+	if (bErrOk == rc) {
+		rc = trimFile(handle, oldEnd);
+	}
+
+	return rc;
+}
+
+ion_bpp_err_t
+bSetCompression(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bool_t		compress
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;			/* return code */
+
+	ion_bpp_buffer_t *root = &h->root;
+
+	if (compress && !h->framed) {
+		/* nodes in the file are as they are in memory, only an empty tree can change */
+		if (!leaf(root) || (0 != ct(root))) {
+			return bErrNotEmpty;
+		}
+
+		if ((rc = frameNodes(h, boolean_true)) != 0) {
+			return rc;
+		}
+	}
+
+	h->compress = compress && h->framed;
+
+	/* the root keeps the choice */
+	if (h->framed) {
+		writeDisk(handle, root);
+	}
+
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bResize(
+	ion_bpp_handle_t	handle,
+	int					bufCt
+) {
+	ion_bpp_h_node_t	*h		= handle;
+	ion_bpp_address_t	curAdr	= -1;
+	int					curOff	= 0;
+	ion_bpp_err_t		rc;			/* return code */
+
+	if (bufCt < ION_BPP_MIN_BUFFER_COUNT) {
+		bufCt = ION_BPP_MIN_BUFFER_COUNT;
+	}
+
+	if (bufCt == h->bufCt) {
+		return bErrOk;
+	}
+
+	/* the new pool starts out empty, so nothing may be left to write */
+	if ((rc = flushAll(handle)) != 0) {
+		return rc;
+	}
+
+	if (NULL != h->curBuf) {
+		curAdr	= h->curBuf->adr;
+		curOff	= (int) (h->curKey - p(h->curBuf));
+	}
+
+	if ((rc = allocPool(h, bufCt)) != 0) {
+		return rc;
+	}
+
+	if (h->groupCt > bufCt) {
+		h->groupCt = bufCt;
+	}
+
+	h->dirtyCt	= h->root.modified ? 1 : 0;
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+
+	/* a walk through bFindNextKey goes on from the same key */
+	if (-1 != curAdr) {
+		if ((rc = readDisk(handle, curAdr, &h->curBuf)) != 0) {
+			h->curBuf = NULL;
+			return rc;
+		}
+
+		h->curKey = p(h->curBuf) + curOff;
+	}
+
+	return bErrOk;
+}
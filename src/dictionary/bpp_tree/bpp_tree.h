@@ -8,11 +8,13 @@ extern "C" {
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include "../../key_value/kv_system.h"
 #include "./../dictionary.h"
 #include "./../../file/ion_file.h"
+#include "./../../file/page_codec.h"
 
 /****************************
  * implementation dependent *
@@ -41,39 +43,177 @@ typedef char (*ion_bpp_comparison_t)(
  * implementation independent *
  ******************************/
 
-/* statistics */
-int maxHeight;	/* maximum height attained */
-int nNodesIns;	/* number of nodes inserted */
-int nNodesDel;	/* number of nodes deleted */
-int nKeysIns;	/* number of keys inserted */
-int nKeysDel;	/* number of keys deleted */
-int nDiskReads;	/* number of disk reads */
-int nDiskWrites;/* number of disk writes */
-
 /* line number for last IO or memory error */
-int bErrLineNo;
+extern int bErrLineNo;
 
 typedef ion_boolean_e ion_bpp_bool_t;
 
 /* typedef enum {false, true} bool; */
 typedef enum ION_BPP_ERR {
-	bErrOk, bErrKeyNotFound, bErrDupKeys, bErrSectorSize, bErrFileNotOpen, bErrFileExists, bErrIO, bErrMemory
+	bErrOk, bErrKeyNotFound, bErrDupKeys, bErrSectorSize, bErrFileNotOpen, bErrFileExists, bErrIO, bErrMemory, bErrNotEmpty, bErrKeyOrder
 } ion_bpp_err_t;
 
 typedef void *ion_bpp_handle_t;
 
+/* supplies the next record to bBulkLoad(), bErrKeyNotFound when done */
+typedef ion_bpp_err_t (*ion_bpp_bulk_next_t)(
+	void						*context,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	*rec
+);
+
+/* replacement policy used for the node buffer pool */
+typedef enum ION_BPP_BUFFER_POLICY {
+	bPolicyLRR,		/* least-recently-read buffer is reused */
+	bPolicyClock	/* second chance: referenced buffers are skipped once */
+} ion_bpp_buffer_policy_t;
+
+/* how far bSync, and bClose, push dirty nodes */
+typedef enum ION_BPP_SYNC_POLICY {
+	bSyncNone,		/* written to the file, may sit in stdio buffers */
+	bSyncFlush,		/* stdio buffers flushed to the OS */
+	bSyncFsync		/* flushed and forced to the device */
+} ion_bpp_sync_policy_t;
+
+/*
+ * During insert/delete, need simultaneous access to 7 buffers:
+ *  - 4 adjacent child bufs
+ *  - 1 parent buf
+ *  - 1 next sequential link
+ *  - 1 lastGE
+*/
+#define ION_BPP_MIN_BUFFER_COUNT	7
+
+/*
+ * fewest keys a node may hold, so gather/scatter have 3 children to work with.
+ * Nodes normally keep more than half their keys, but at 6 or 7 keys a scatter
+ * may find no split within both limits and leave one node short; a delete
+ * gathers any child at or below half, so the next one through it refills it.
+*/
+#define ION_BPP_MIN_NODE_KEYS		6
+
+#if !defined(ION_BPP_DEFAULT_BUFFER_COUNT)
+#define ION_BPP_DEFAULT_BUFFER_COUNT	ION_BPP_MIN_BUFFER_COUNT
+#endif
+
+#if !defined(ION_BPP_DEFAULT_BUFFER_POLICY)
+#define ION_BPP_DEFAULT_BUFFER_POLICY	bPolicyLRR
+#endif
+
+/* 0 writes each dirty node when it is evicted */
+#if !defined(ION_BPP_DEFAULT_GROUP_COUNT)
+#define ION_BPP_DEFAULT_GROUP_COUNT		0
+#endif
+
+#if !defined(ION_BPP_DEFAULT_SYNC_POLICY)
+#define ION_BPP_DEFAULT_SYNC_POLICY		bSyncNone
+#endif
+
+/* whether new files keep their nodes compressed, see bSetCompression */
+#if !defined(ION_BPP_DEFAULT_COMPRESS)
+#define ION_BPP_DEFAULT_COMPRESS		0
+#endif
+
+/* bytes at the front of each node of a compressed file, taken from its keys */
+#define ION_BPP_FRAME_HEADER			4
+
+/* whether new files append their nodes to a log, see ion_bpp_open_t */
+#if !defined(ION_BPP_DEFAULT_LOG)
+#define ION_BPP_DEFAULT_LOG				0
+#endif
+
+/* sectors in each segment of a log, the unit the cleaner empties and reuses */
+#if !defined(ION_BPP_LOG_SEGMENT)
+#define ION_BPP_LOG_SEGMENT				64
+#endif
+
+#if ION_BPP_LOG_SEGMENT < 3
+#error "ION_BPP_LOG_SEGMENT must hold a root of 3 sectors"
+#endif
+
+/* share of the segments in use that may be dead before commits clean */
+#if !defined(ION_BPP_LOG_DEAD_PERCENT)
+#define ION_BPP_LOG_DEAD_PERCENT		50
+#endif
+
+/* most segments a commit empties */
+#if !defined(ION_BPP_LOG_CLEAN_SEGMENTS)
+#define ION_BPP_LOG_CLEAN_SEGMENTS		2
+#endif
+
+/* node buffer pool counters, kept per open handle */
+typedef struct {
+	unsigned long	hits;		/* node reads satisfied from the pool */
+	unsigned long	misses;		/* node reads that went to disk */
+	unsigned long	evictions;	/* valid buffers reassigned to another node */
+	unsigned long	writebacks;	/* evictions that had to flush a dirty buffer */
+	unsigned long	groupWrites;/* batches of dirty nodes written in address order */
+} ion_bpp_buffer_stats_t;
+
+/* statistics, kept per open handle */
+typedef struct {
+	ion_bpp_buffer_stats_t	buffers;	/* node buffer pool counters */
+	unsigned int			hitRate;	/* pool hits per 1000 node reads */
+	int						maxHeight;	/* maximum height attained */
+	unsigned long			nodesIns;	/* number of nodes inserted */
+	unsigned long			nodesDel;	/* number of nodes deleted */
+	unsigned long			keysIns;	/* number of keys inserted */
+	unsigned long			keysDel;	/* number of keys deleted */
+	unsigned long			diskReads;	/* number of disk reads */
+	unsigned long			diskWrites;	/* number of disk writes */
+	unsigned long			bytesRead;	/* bytes of nodes read from disk */
+	unsigned long			bytesWritten;	/* bytes of nodes written to disk */
+	unsigned long			freeNodes;	/* nodes in the file waiting for reuse */
+	unsigned long			nodes;		/* nodes in the file holding keys, the root among them */
+	unsigned long			fileBytes;	/* bytes of the file nodes are given out from */
+	unsigned long			segmentsCleaned;/* segments of a log the cleaner emptied */
+} ion_bpp_stats_t;
+
+/* private copy of a leaf, walked by bScanNext without going through the pool */
+typedef struct {
+	void				*node;	/* copy of the leaf, NULL until bScanStart */
+	int					idx;	/* next entry to return */
+	int					ct;		/* entries in the copy */
+	ion_bpp_address_t	next;	/* following leaf, 0 if last */
+} ion_bpp_scan_t;
+
 typedef struct {
 	/* info for bOpen() */
 	char					*iName;	/* name of index file */
 	int						keySize;/* length, in bytes, of key */
+	int						valueSize;	/* bytes of value stored inline with each key */
 	ion_bpp_bool_t			dupKeys;		/* true if duplicate keys allowed */
 	size_t					sectorSize;	/* size of sector on disk */
 	ion_bpp_comparison_t	comp;			/* pointer to compare function */
+	int						bufCt;	/* number of node buffers, 0 for default */
+	ion_bpp_buffer_policy_t policy;			/* buffer replacement policy */
+	int						groupCt;/* dirty nodes held before a group write, 0 for none */
+	ion_bpp_sync_policy_t	syncPolicy;	/* durability of bSync and bClose */
+	ion_bpp_bool_t			compress;	/* new files store nodes compressed */
+	ion_bpp_bool_t			logged;	/* new files append nodes to a log */
 } ion_bpp_open_t;
 
 /***********************
  * function prototypes *
  ***********************/
+int
+bNodeCapacity(
+	ion_bpp_open_t info
+);
+
+/*
+ * input:
+ *   info				   info for open
+ * returns:
+ *   number of keys a leaf holds; bOpen fails if this is below
+ *   ION_BPP_MIN_NODE_KEYS
+ * notes:
+ *   Internal nodes leave the value out of their entries and hold more.
+ *   With compress set, ION_BPP_FRAME_HEADER bytes of each node are
+ *   kept for its frame.
+*/
+
 ion_bpp_err_t
 bOpen(
 	ion_bpp_open_t		info,
@@ -90,6 +230,18 @@ bOpen(
  *   bErrMemory			 insufficient memory
  *   bErrSectorSize		 sector size too small or not 0 mod 4
  *   bErrFileNotOpen		unable to open index file
+ * notes:
+ *   A bufCt of 0 selects ION_BPP_DEFAULT_BUFFER_COUNT.  Counts below
+ *   ION_BPP_MIN_BUFFER_COUNT are raised to the minimum.
+ *
+ *   With logged set a new file is a log: nodes are never written over,
+ *   each write appends the node to the end of the log and a commit, any
+ *   bSync or group write, switches to the new nodes at once by writing
+ *   one superblock.  A crash leaves the tree as the last commit that
+ *   reached the device, so a sync policy of bSyncFlush or bSyncFsync is
+ *   needed for that to hold.  Commits clean the segments of the log
+ *   that are mostly dead.  An existing file is opened the way it was
+ *   created, whatever logged says.
 */
 
 ion_bpp_err_t
@@ -127,6 +279,25 @@ bInsertKey(
  *   nodes to generate a "unique" key.
 */
 
+ion_bpp_err_t
+bInsertKeyValue(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   key					key to insert
+ *   value				  valueSize bytes kept inline with the key, or NULL
+ *							for zeroes
+ *   rec					record address
+ * returns:
+ *   as bInsertKey
+*/
+
 ion_bpp_err_t
 bUpdateKey(
 	ion_bpp_handle_t			handle,
@@ -150,6 +321,24 @@ bUpdateKey(
  *   nodes to generate a "unique" key.
 */
 
+ion_bpp_err_t
+bUpdateKeyValue(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   key					key to update
+ *   value				  new inline value, or NULL to keep the old one
+ *   rec					record address
+ * returns:
+ *   as bUpdateKey
+*/
+
 ion_bpp_err_t
 bDeleteKey(
 	ion_bpp_handle_t			handle,
@@ -264,6 +453,275 @@ bFindNextKey(
  *   bErrKeyNotFound		key not found
 */
 
+ion_bpp_err_t
+bScanStart(
+	ion_bpp_handle_t	handle,
+	ion_bpp_scan_t		*scan
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   scan				   scan state, node NULL or from an earlier scan
+ * returns:
+ *   bErrOk				 scan positioned just past the key last found
+ *   bErrKeyNotFound		no current key
+ *   bErrMemory			 no room for the leaf copy
+ * notes:
+ *   Copies the leaf holding the key found by one of the bFind functions.
+ *   Later finds, inserts and deletes don't move the scan, but a scan
+ *   that spans changes to the tree may see stale entries.
+*/
+
+ion_bpp_err_t
+bScanNext(
+	ion_bpp_handle_t			handle,
+	ion_bpp_scan_t				*scan,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	*rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   scan				   scan set up by bScanStart
+ * output:
+ *   key					next key
+ *   value				  its inline value, skipped if NULL
+ *   rec					record address
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no more keys
+ * notes:
+ *   Keys of a leaf come from the copy; the pool is only read when
+ *   the scan steps to the next leaf.
+*/
+
+void
+bScanEnd(
+	ion_bpp_scan_t *scan
+);
+
+/*
+ * input:
+ *   scan				   scan to release
+*/
+
+ion_bpp_err_t
+bBulkLoad(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bulk_next_t getNext,
+	void				*context
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   getNext				called for each record, in ascending key order;
+ *							fills in the key, inline value and rec
+ *   context				passed through to getNext
+ * returns:
+ *   bErrOk				 tree built from all records
+ *   bErrNotEmpty		   tree already holds keys
+ *   bErrKeyOrder		   keys out of order, or repeated without dupKeys
+ *   other				  error from getNext, or an I/O or memory error
+ * notes:
+ *   Builds the tree bottom-up in one sequential pass.  Leaves are
+ *   packed full and the internal levels written as they complete.
+ *   On error the tree is left empty; nodes already written stay
+ *   in the file but are unreachable.
+*/
+
+ion_bpp_err_t
+bCurrentValue(
+	ion_bpp_handle_t	handle,
+	void				*value
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   value				  inline value of the key last found by one of
+ *							the bFind functions
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no current key
+ * notes:
+ *   Only valid until the tree is next modified.
+*/
+
+ion_bpp_err_t
+bBufferStats(
+	ion_bpp_handle_t		handle,
+	ion_bpp_buffer_stats_t	*stats
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   stats				  node buffer pool counters since bOpen
+ * returns:
+ *   bErrOk				 operation successful
+ * notes:
+ *   The root node is always resident and is not counted.
+*/
+
+ion_bpp_err_t
+bStats(
+	ion_bpp_handle_t	handle,
+	ion_bpp_stats_t		*stats
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   stats				  counters since bOpen or the last bResetStats
+ * returns:
+ *   bErrOk				 operation successful
+*/
+
+ion_bpp_err_t
+bResetStats(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   bErrOk				 operation successful
+ * notes:
+ *   maxHeight is kept, it describes the tree rather than the period.
+*/
+
+ion_bpp_err_t
+bSync(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   policy				 how far to push the dirty nodes
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrIO				 writing or pushing the nodes failed
+ * notes:
+ *   As bSync, but for this call only pushing as far as policy rather
+ *   than the syncPolicy the tree was opened with.
+*/
+
+ion_bpp_err_t
+bSyncTo(
+	ion_bpp_handle_t		handle,
+	ion_bpp_sync_policy_t	policy
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   bErrOk				 every modified node written, then pushed as far
+ *							as the sync policy asks
+ *   bErrIO				 write or flush failed
+ * notes:
+ *   Nodes are written in address order.  With groupCt set, dirty nodes
+ *   otherwise reach the file only as a batch, once groupCt of them are
+ *   dirty or when one has to be evicted.
+*/
+
+ion_bpp_err_t
+bCompact(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   bErrOk				 nodes packed to the front of the file, file shrunk
+ *   bErrKeyNotFound		a node could not be reached from the root; the
+ *							nodes moved so far stay moved, the file keeps
+ *							its size
+ *   bErrIO				 write failed
+ *   bErrMemory			 no room for the list of live nodes
+ * notes:
+ *   Nodes near the end of the file are moved into free nodes nearer the
+ *   front, then the file is cut after the last live node.  Where the file
+ *   can't be cut, the tail is kept on the free list instead.
+ *
+ *   A log is compacted by cleaning every segment that holds dead space,
+ *   and the segments near its end, into free segments nearer the front,
+ *   then cutting it after the last segment in use.  Its free nodes stay
+ *   on the free list, they take no room in the file.
+*/
+
+int
+bPoolSize(
+	ion_bpp_open_t	info,
+	int				bufCt
+);
+
+/*
+ * input:
+ *   info				   info for open
+ *   bufCt				  number of node buffers
+ * returns:
+ *   bytes bOpen, or bResize, allocates for a pool of bufCt buffers,
+ *   the root and the gather buffer included
+*/
+
+ion_bpp_err_t
+bResize(
+	ion_bpp_handle_t	handle,
+	int					bufCt
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   bufCt				  number of node buffers, raised to
+ *							ION_BPP_MIN_BUFFER_COUNT
+ * returns:
+ *   bErrOk				 the pool holds bufCt buffers
+ *   bErrMemory			 no room for the new pool, the old one is kept
+ *   bErrIO				 writing the modified nodes failed
+ * notes:
+ *   Modified nodes are written and the new pool starts out empty but
+ *   for the node bFindNextKey is at, read back in.  Call between
+ *   operations, not during one.
+*/
+
+ion_bpp_err_t
+bSetCompression(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bool_t		compress
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   compress			   whether nodes are written compressed
+ * returns:
+ *   bErrOk				 nodes are written as asked from now on
+ *   bErrNotEmpty		   compression asked of a tree that holds keys
+ *							and was not created compressed
+ *   bErrSectorSize		 a node would hold too few keys once framed
+ * notes:
+ *   A compressed file keeps each node but the root in a frame whose
+ *   header gives its length, so a read asks the device for about as
+ *   many bytes as the last frames took and fetches the rest only when
+ *   a frame is longer.  Integer keys are stored as distances from the
+ *   previous key, the rest of the node goes through page_codec_compress,
+ *   and a node that does not shrink is framed as it is.  The choice is
+ *   kept in the root and outlives the handle; turning compression off
+ *   leaves the file framed, with its nodes framed as they are.
+*/
+
 #if defined(__cplusplus)
 }
 #endif
@@ -17,88 +17,150 @@ bpptree_get_value_filename(
 }
 
 /**
-@brief		Creates an instance of a dictionary.
-
-@details	Creates as instance of a dictionary given a @p key_size and
-			@p value_size, in bytes. The @p dictionary_size parameter is
-			not used for this implementation, as there is no size bound.
-@param		id
-				ID of a dictionary that's given to us.
-@param		key_type
-				The key category given to us.
-@param		key_size
-				The size of the key in bytes.
-@param		value_size
-				The size of the value in bytes.
-@param		dictionary_size
-				The size of the hashmap in discrete units
-@param		compare
-				Function pointer for the comparison function for the dictionary.
-@param		handler
-				 THe handler for the specific dictionary being created.
-@param		dictionary
-				 The pointer declared by the caller that will reference
-				 the instance of the dictionary created.
-@return		The status of the creation of the dictionary.
+@brief		Fits the node buffer pool of a tree to its grant from the
+			memory budget.
 */
-ion_err_t
-bpptree_create_dictionary(
-	ion_dictionary_id_t			id,
-	ion_key_type_t				key_type,
-	ion_key_size_t				key_size,
-	ion_value_size_t			value_size,
-	ion_dictionary_size_t		dictionary_size,
-	ion_dictionary_compare_t	compare,
-	ion_dictionary_handler_t	*handler,
-	ion_dictionary_t			*dictionary
+static ion_err_t
+bpptree_budget_resize(
+	void	*context,
+	size_t	bytes
 ) {
-	UNUSED(dictionary_size);
+	ion_bpptree_t	*bpptree = (ion_bpptree_t *) context;
+	ion_bpp_err_t	bErr;
 
-	/* TODO: Uncomment this when IINQ has been merged into development */
-/*	if (key_size != sizeof(int)) {
-		return err_invalid_initial_size;
-	}*/
+	bErr = bResize(bpptree->tree, ((int) bytes - bpptree->pool_base) / bpptree->pool_buffer);
 
+	if (bErrOk == bErr) {
+		return err_ok;
+	}
+
+	return (bErrMemory == bErr) ? err_out_of_memory : err_file_write_error;
+}
+
+/**
+@brief		Opens, or creates, the index and value files of a dictionary.
+@details	See @ref bpptree_create_dictionary; @p page_size is the node
+			size, 0 for @ref ION_BPPTREE_DEFAULT_PAGE_SIZE grown to fit
+			the key. The buffer count, compression and logging of
+			@p config's options, if it is not NULL, take the place of the
+			defaults.
+*/
+static ion_err_t
+bpptree_open_tree(
+	ion_dictionary_id_t					id,
+	ion_key_type_t						key_type,
+	ion_key_size_t						key_size,
+	ion_value_size_t					value_size,
+	ion_dictionary_size_t				dictionary_size,
+	ion_dictionary_size_t				page_size,
+	const ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t			compare,
+	ion_dictionary_handler_t			*handler,
+	ion_dictionary_t					*dictionary
+) {
 	ion_bpptree_t	*bpptree;
 	ion_bpp_open_t	info;
+	ion_bpp_err_t	bErr;
+	ion_err_t		err;
+	int				wanted;
+	uint32_t		option;
+	char			value_filename[20];
+	char			addr_filename[ION_MAX_FILENAME_LENGTH];
 
-	bpptree = malloc(sizeof(ion_bpptree_t));
+	if (dictionary_get_filename(id, "bpt", addr_filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_initialization_failed;
+	}
 
-	if (NULL == bpptree) {
-		return err_out_of_memory;
+	info.iName		= addr_filename;
+	info.keySize	= key_size;
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = (int) page_size;
+	info.comp		= compare;
+	/* The dictionary size is taken as the node buffer count; anything too
+	 * small, including the unbounded size of -1, selects the default. */
+	info.bufCt		= 0;
+	info.policy		= ION_BPP_DEFAULT_BUFFER_POLICY;
+	info.groupCt	= ION_BPP_DEFAULT_GROUP_COUNT;
+	info.syncPolicy = ION_BPP_DEFAULT_SYNC_POLICY;
+	info.compress	= ION_BPP_DEFAULT_COMPRESS;
+	info.logged		= ION_BPP_DEFAULT_LOG;
+
+	if ((dictionary_size >= ION_BPP_MIN_BUFFER_COUNT) && (dictionary_size != (ion_dictionary_size_t) -1)) {
+		info.bufCt = (int) dictionary_size;
 	}
 
-	char value_filename[20];
+	if ((NULL != config) && (err_ok == dictionary_get_option(config, dictionary_option_buffer_count, &option)) && ((int) option >= ION_BPP_MIN_BUFFER_COUNT)) {
+		info.bufCt = (int) option;
+	}
 
-	bpptree_get_value_filename(id, value_filename);
-	bpptree->values.file_handle = ion_fopen(value_filename);
+	if ((NULL != config) && (err_ok == dictionary_get_option(config, dictionary_option_compression, &option))) {
+		info.compress = (0 != option);
+	}
 
-	bpptree->values.next_empty	= ION_FILE_NULL;
+	if ((NULL != config) && (err_ok == dictionary_get_option(config, dictionary_option_log_structured, &option))) {
+		info.logged = (0 != option);
+	}
 
-	/* FIXME: read this from a property bag. */
+	/* The default grows with the key, the same way on every open. */
+	if (0 == page_size) {
+		info.sectorSize = ION_BPPTREE_DEFAULT_PAGE_SIZE;
 
-	/* FIXME: VARIABLE NAMES! */
-	char addr_filename[ION_MAX_FILENAME_LENGTH];
+		while (bNodeCapacity(info) < ION_BPP_MIN_NODE_KEYS) {
+			info.sectorSize *= 2;
+		}
+	}
 
-	int actual_filename_length = dictionary_get_filename(id, "bpt", addr_filename);
+	/* Keep small values in the leaves, as long as the nodes stay wide enough. */
+	if (value_size <= ION_BPPTREE_INLINE_VALUE_MAX) {
+		info.valueSize = value_size;
 
-	if (actual_filename_length >= ION_MAX_FILENAME_LENGTH) {
-		return err_dictionary_initialization_failed;
+		if (bNodeCapacity(info) < ION_BPP_MIN_NODE_KEYS) {
+			info.valueSize = 0;
+		}
 	}
 
-	info.iName		= addr_filename;
-	info.keySize	= key_size;
-	info.dupKeys	= boolean_false;
-	/* FIXME: HOW DO WE SET BLOCK SIZE? */
-	info.sectorSize = 256;
-	info.comp		= compare;
+	bpptree = ion_alloc(ion_alloc_other, sizeof(ion_bpptree_t));
 
-	ion_bpp_err_t bErr = bOpen(info, &(bpptree->tree));
+	if (NULL == bpptree) {
+		return err_out_of_memory;
+	}
+
+	bpptree->inline_values	= (0 != info.valueSize);
+	bpptree->sync_policy	= info.syncPolicy;
+	memset(&bpptree->stats, 0, sizeof(bpptree->stats));
+
+	/* The budget sizes the pool, from the minimum up to the buffers asked
+	 * for, or more for a tree left to the default while there is a budget. */
+	wanted = (0 == info.bufCt) ? ION_BPP_DEFAULT_BUFFER_COUNT : info.bufCt;
+
+	if ((0 == info.bufCt) && (0 != ion_budget_get(NULL))) {
+		wanted = ION_BPPTREE_BUDGET_BUFFER_COUNT;
+	}
+
+	bpptree->pool_base		= bPoolSize(info, 0);
+	bpptree->pool_buffer	= bPoolSize(info, 1) - bpptree->pool_base;
+
+	err						= ion_budget_join(&bpptree->budget, (size_t) bPoolSize(info, ION_BPP_MIN_BUFFER_COUNT), (size_t) bPoolSize(info, wanted), bpptree_budget_resize, bpptree);
+
+	if (err_ok != err) {
+		ion_free(bpptree);
+		return err;
+	}
+
+	info.bufCt	= ((int) bpptree->budget.granted - bpptree->pool_base) / bpptree->pool_buffer;
+	bErr		= bOpen(info, &(bpptree->tree));
 
 	if (bErrOk != bErr) {
-		return err_dictionary_initialization_failed;
+		ion_budget_leave(&bpptree->budget);
+		ion_free(bpptree);
+		return (bErrSectorSize == bErr) ? err_invalid_initial_size : err_dictionary_initialization_failed;
 	}
 
+	bpptree_get_value_filename(id, value_filename);
+	bpptree->values.file_handle = ion_fopen(value_filename);
+	bpptree->values.next_empty	= ION_FILE_NULL;
+
 	dictionary->instance					= (ion_dictionary_parent_t *) bpptree;
 	dictionary->instance->compare			= compare;
 	dictionary->instance->key_type			= key_type;
@@ -110,6 +172,51 @@ bpptree_create_dictionary(
 	return err_ok;
 }
 
+/**
+@brief		Creates an instance of a dictionary.
+
+@details	Creates as instance of a dictionary given a @p key_size and
+			@p value_size, in bytes. There is no size bound for this
+			implementation, so @p dictionary_size instead sizes the pool
+			of node buffers the tree keeps in memory. Nodes are
+			@ref ION_BPPTREE_DEFAULT_PAGE_SIZE bytes, or larger for wide
+			keys; see @ref ion_master_table_create_dictionary_paged to
+			choose the size.
+@param		id
+				ID of a dictionary that's given to us.
+@param		key_type
+				The key category given to us.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		dictionary_size
+				The number of node buffers to keep in memory. Values below
+				@ref ION_BPP_MIN_BUFFER_COUNT select
+				@ref ION_BPP_DEFAULT_BUFFER_COUNT.
+@param		compare
+				Function pointer for the comparison function for the dictionary.
+@param		handler
+				 THe handler for the specific dictionary being created.
+@param		dictionary
+				 The pointer declared by the caller that will reference
+				 the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+bpptree_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return bpptree_open_tree(id, key_type, key_size, value_size, dictionary_size, 0, NULL, compare, handler, dictionary);
+}
+
 /**
 @brief		Inserts a @p key and @p value into the dictionary.
 
@@ -133,6 +240,7 @@ bpptree_insert(
 	ion_file_offset_t	offset;
 
 	bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_budget_touch(&bpptree->budget);
 
 	offset	= ION_FILE_NULL;
 	bErr	= bFindKey(bpptree->tree, key, &offset);
@@ -141,6 +249,31 @@ bpptree_insert(
 		offset = ION_FILE_NULL;
 	}
 
+	if (bpptree->inline_values) {
+		ion_byte_t old_value[ION_BPPTREE_INLINE_VALUE_MAX];
+
+		if (bErrKeyNotFound == bErr) {
+			bErr = bInsertKeyValue(bpptree->tree, key, value, ION_FILE_NULL);
+		}
+		else {
+			/* The newest value stays inline, older ones move to the bag. */
+			bCurrentValue(bpptree->tree, old_value);
+			err = lfb_put(&(bpptree->values), old_value, bpptree->super.record.value_size, offset, &offset);
+
+			if (err_ok != err) {
+				return ION_STATUS_ERROR(err_unable_to_insert);
+			}
+
+			bErr = bUpdateKeyValue(bpptree->tree, key, value, offset);
+		}
+
+		if (bErrOk != bErr) {
+			return ION_STATUS_ERROR(err_unable_to_insert);
+		}
+
+		return ION_STATUS_OK(1);
+	}
+
 	err = lfb_put(&(bpptree->values), (ion_byte_t *) value, bpptree->super.record.value_size, offset, &offset);
 
 	if (err_ok == err) {
@@ -200,6 +333,7 @@ bpptree_query(
 	ion_err_t			err;
 
 	bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_budget_touch(&bpptree->budget);
 
 	bErr	= bFindKey(bpptree->tree, key, &offset);
 
@@ -207,6 +341,11 @@ bpptree_query(
 		return ION_STATUS_ERROR(err_item_not_found);
 	}
 
+	if (bpptree->inline_values) {
+		bCurrentValue(bpptree->tree, value);
+		return ION_STATUS_OK(1);
+	}
+
 	err = lfb_get(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &next);
 
 	if (err_ok == err) {
@@ -239,10 +378,15 @@ bpptree_delete(
 	status	= ION_STATUS_INITIALIZE;
 
 	bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_budget_touch(&bpptree->budget);
 
 	bErr	= bDeleteKey(bpptree->tree, key, &offset);
 
 	if (bErrKeyNotFound != bErr) {
+		if (bpptree->inline_values) {
+			status.count = 1;
+		}
+
 		status.error = lfb_delete_all(&(bpptree->values), offset, &(status.count));
 	}
 	else {
@@ -261,9 +405,10 @@ bpptree_close_dictionary(
 	ion_bpp_err_t	bErr;
 
 	bpptree					= (ion_bpptree_t *) dictionary->instance;
+	ion_budget_leave(&bpptree->budget);
 	bErr					= bClose(bpptree->tree);
 	ion_fclose(bpptree->values.file_handle);
-	free(dictionary->instance);
+	ion_free(dictionary->instance);
 	dictionary->instance	= NULL;
 
 	if (bErrOk != bErr) {
@@ -335,10 +480,21 @@ bpptree_update(
 
 	count	= 0;
 	bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_budget_touch(&bpptree->budget);
 
 	bErr	= bFindKey(bpptree->tree, key, &offset);
 
 	if (bErrKeyNotFound != bErr) {
+		if (bpptree->inline_values) {
+			bErr = bUpdateKeyValue(bpptree->tree, key, value, offset);
+
+			if (bErrOk != bErr) {
+				return ION_STATUS_ERROR(err_unable_to_insert);
+			}
+
+			count = 1;
+		}
+
 		lfb_update_all(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &count);
 	}
 	else {
@@ -348,6 +504,87 @@ bpptree_update(
 	return ION_STATUS_OK(count);
 }
 
+/**
+@brief		Picks up the inline value of the key the tree just found for
+			a cursor, so that it is returned ahead of the value bag.
+*/
+static void
+bpptree_cursor_take_value(
+	ion_bpptree_t		*bpptree,
+	ion_bpp_cursor_t	*bCursor
+) {
+	bCursor->at_inline = bpptree->inline_values;
+
+	if (bCursor->at_inline) {
+		bCurrentValue(bpptree->tree, bCursor->cur_value);
+	}
+}
+
+/**
+@brief		Steps a range or all records cursor to the next key of its leaf
+			scan, along with the inline value.
+@return		@ref bErrOk, or @ref bErrKeyNotFound past the last key.
+*/
+static ion_bpp_err_t
+bpptree_cursor_scan_next(
+	ion_bpptree_t		*bpptree,
+	ion_bpp_cursor_t	*bCursor
+) {
+	ion_bpp_err_t bErr;
+
+	bErr				= bScanNext(bpptree->tree, &bCursor->scan, bCursor->cur_key, bpptree->inline_values ? bCursor->cur_value : NULL, &bCursor->offset);
+	bCursor->at_inline	= (bErrOk == bErr) && bpptree->inline_values;
+
+	return bErr;
+}
+
+/**
+@brief		Next function of a predicate cursor, which walks the leaves as an
+			all records cursor does until a record passes the filter.
+@details	Inline values are tested where the leaf holds them, the others
+			once they are read into @p record.
+*/
+static ion_cursor_status_t
+bpptree_next_filtered(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_bpp_cursor_t	*bCursor	= (ion_bpp_cursor_t *) cursor;
+	ion_bpptree_t		*bpptree	= (ion_bpptree_t *) cursor->dictionary->instance;
+	ion_value_t			value;
+
+	while (boolean_true) {
+		/* The first key of the walk was found by the find, later ones are stepped to once their values run out */
+		if ((-1 == bCursor->offset) && !bCursor->at_inline && (bErrOk != bpptree_cursor_scan_next(bpptree, bCursor))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		if (bCursor->at_inline) {
+			value				= bCursor->cur_value;
+			bCursor->at_inline	= boolean_false;
+		}
+		else {
+			value = record->value;
+			lfb_get(&(bpptree->values), bCursor->offset, cursor->dictionary->instance->record.value_size, value, &bCursor->offset);
+		}
+
+		if (test_record_predicate(cursor, bCursor->cur_key, value)) {
+			break;
+		}
+	}
+
+	cursor->status = cs_cursor_active;
+
+	memcpy(record->key, bCursor->cur_key, cursor->dictionary->instance->record.key_size);
+
+	if (value != record->value) {
+		memcpy(record->value, value, cursor->dictionary->instance->record.value_size);
+	}
+
+	return cursor->status;
+}
+
 /**
 @brief		Next function to query and retrieve the next
 			<K,V> that stratifies the predicate of the cursor.
@@ -374,13 +611,16 @@ bpptree_next(
 	else if (cursor->status == cs_end_of_results) {
 		return cursor->status;
 	}
+	else if (predicate_predicate == cursor->predicate->type) {
+		return bpptree_next_filtered(cursor, record);
+	}
 	else if ((cursor->status == cs_cursor_initialized) || (cursor->status == cs_cursor_active)) {
 		if (cursor->status == cs_cursor_active) {
 			ion_boolean_t is_valid = boolean_true;
 
 			switch (cursor->predicate->type) {
 				case predicate_equality: {
-					if (-1 == bCursor->offset) {
+					if ((-1 == bCursor->offset) && !bCursor->at_inline) {
 						/* End of results, we can quit */
 						is_valid = boolean_false;
 					}
@@ -389,9 +629,9 @@ bpptree_next(
 				}
 
 				case predicate_range: {
-					/*do bFindNextKey then test_predicate */
-					if (-1 == bCursor->offset) {
-						ion_bpp_err_t bErr = bFindNextKey(bpptree->tree, bCursor->cur_key, &bCursor->offset);
+					/* step the leaf scan then test_predicate */
+					if ((-1 == bCursor->offset) && !bCursor->at_inline) {
+						ion_bpp_err_t bErr = bpptree_cursor_scan_next(bpptree, bCursor);
 
 						if ((bErrOk != bErr) || (boolean_false == test_predicate(cursor, bCursor->cur_key))) {
 							is_valid = boolean_false;
@@ -402,8 +642,8 @@ bpptree_next(
 				}
 
 				case predicate_all_records: {
-					if (-1 == bCursor->offset) {
-						ion_bpp_err_t bErr = bFindNextKey(bpptree->tree, bCursor->cur_key, &bCursor->offset);
+					if ((-1 == bCursor->offset) && !bCursor->at_inline) {
+						ion_bpp_err_t bErr = bpptree_cursor_scan_next(bpptree, bCursor);
 
 						if (bErrOk != bErr) {
 							is_valid = boolean_false;
@@ -413,10 +653,6 @@ bpptree_next(
 					break;
 				}
 
-				case predicate_predicate: {
-					/*TODO Not implemented */
-					break;
-				}
 					/*No default since we can assume the predicate is valid. */
 			}
 
@@ -433,8 +669,15 @@ bpptree_next(
 		/* Get key */
 		memcpy(record->key, bCursor->cur_key, cursor->dictionary->instance->record.key_size);
 
-		/* Get value */
-		lfb_get(&(bpptree->values), bCursor->offset, cursor->dictionary->instance->record.value_size, record->value, &bCursor->offset);
+		/* Get the bytes of the value wanted, the rest of it not read from its file */
+		if (bCursor->at_inline) {
+			memcpy((ion_byte_t *) record->value + cursor->value_offset, (ion_byte_t *) bCursor->cur_value + cursor->value_offset, cursor->value_size);
+			bCursor->at_inline = boolean_false;
+		}
+		else {
+			lfb_get_part(&(bpptree->values), bCursor->offset, cursor->value_offset, cursor->value_size, (ion_byte_t *) record->value + cursor->value_offset, &bCursor->offset);
+		}
+
 		return cursor->status;
 	}
 
@@ -458,8 +701,9 @@ bpptree_destroy_cursor(
 	ion_dict_cursor_t **cursor
 ) {
 	(*cursor)->predicate->destroy(&(*cursor)->predicate);
-	free(((ion_bpp_cursor_t *) (*cursor))->cur_key);
-	free((*cursor));
+	bScanEnd(&((ion_bpp_cursor_t *) (*cursor))->scan);
+	ion_free(((ion_bpp_cursor_t *) (*cursor))->cur_key);
+	ion_free((*cursor));
 	*cursor = NULL;
 }
 
@@ -490,7 +734,9 @@ bpptree_find(
 	ion_bpptree_t	*bpptree	= (ion_bpptree_t *) dictionary->instance;
 	ion_key_size_t	key_size	= dictionary->instance->record.key_size;
 
-	*cursor = malloc(sizeof(ion_bpp_cursor_t));
+	ion_budget_touch(&bpptree->budget);
+
+	*cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_bpp_cursor_t));
 
 	if (NULL == *cursor) {
 		return err_out_of_memory;
@@ -498,41 +744,54 @@ bpptree_find(
 
 	ion_bpp_cursor_t *bCursor = (ion_bpp_cursor_t *) (*cursor);
 
-	bCursor->cur_key = malloc(key_size);
+	/* Room for the inline value goes after the key. */
+	bCursor->cur_key = ion_alloc(ion_alloc_cursor, key_size + (bpptree->inline_values ? dictionary->instance->record.value_size : 0));
 
 	if (NULL == bCursor->cur_key) {
-		free(bCursor);
+		ion_free(bCursor);
 		return err_out_of_memory;
 	}
 
+	bCursor->cur_value	= (ion_value_t) ((ion_byte_t *) bCursor->cur_key + key_size);
+	bCursor->at_inline	= boolean_false;
+	bCursor->scan.node	= NULL;
+
 	(*cursor)->dictionary	= dictionary;
 	(*cursor)->status		= cs_cursor_uninitialized;
+	(*cursor)->value_offset = 0;
+	(*cursor)->value_size	= dictionary->instance->record.value_size;
 
 	(*cursor)->destroy		= bpptree_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
 	(*cursor)->next			= bpptree_next;
 
-	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
+	(*cursor)->predicate	= ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t));
 
 	if (NULL == (*cursor)->predicate) {
-		free(bCursor->cur_key);
-		free(*cursor);
+		ion_free(bCursor->cur_key);
+		ion_free(*cursor);
 		return err_out_of_memory;
 	}
 
 	(*cursor)->predicate->type		= predicate->type;
 	(*cursor)->predicate->destroy	= predicate->destroy;
 
+	/* a predicate query walks the leaves as all records do, its filter tested as it goes */
+	if (predicate_predicate == predicate->type) {
+		(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+	}
+
 	switch (predicate->type) {
 		case predicate_equality: {
 			/* TODO get ALL these lines within 80 cols */
 			ion_key_t target_key = predicate->statement.equality.equality_value;
 
-			(*cursor)->predicate->statement.equality.equality_value = malloc(key_size);
+			(*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.equality.equality_value) {
-				free((*cursor)->predicate);
-				free(bCursor->cur_key);
-				free(*cursor);
+				ion_free((*cursor)->predicate);
+				ion_free(bCursor->cur_key);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
@@ -548,6 +807,7 @@ bpptree_find(
 				return err_ok;
 			}
 			else {
+				bpptree_cursor_take_value(bpptree, bCursor);
 				(*cursor)->status = cs_cursor_initialized;
 				return err_ok;
 			}
@@ -556,46 +816,54 @@ bpptree_find(
 		}
 
 		case predicate_range: {
-			(*cursor)->predicate->statement.range.lower_bound = malloc(key_size);
+			(*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.lower_bound) {
-				free((*cursor)->predicate);
-				free(bCursor->cur_key);
-				free(*cursor);
+				ion_free((*cursor)->predicate);
+				ion_free(bCursor->cur_key);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
 			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
 
-			(*cursor)->predicate->statement.range.upper_bound = malloc(key_size);
+			(*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.upper_bound) {
-				free((*cursor)->predicate->statement.range.lower_bound);
-				free((*cursor)->predicate);
-				free(bCursor->cur_key);
-				free(*cursor);
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(bCursor->cur_key);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
 			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
 
 			/* We search for the FGEQ of the Lower bound. */
-			bFindFirstGreaterOrEqual(bpptree->tree, (*cursor)->predicate->statement.range.lower_bound, bCursor->cur_key, &bCursor->offset);
+			ion_bpp_err_t err = bFindFirstGreaterOrEqual(bpptree->tree, (*cursor)->predicate->statement.range.lower_bound, bCursor->cur_key, &bCursor->offset);
 
 			/* If the key returned doesn't satisfy the predicate, we can exit */
-			if (boolean_false == test_predicate(*cursor, bCursor->cur_key)) {
+			if ((bErrOk != err) || (boolean_false == test_predicate(*cursor, bCursor->cur_key))) {
 				(*cursor)->status = cs_end_of_results;
 				return err_ok;
 			}
-			else {
-				(*cursor)->status = cs_cursor_initialized;
-				return err_ok;
+
+			bpptree_cursor_take_value(bpptree, bCursor);
+
+			/* Later keys are walked straight off a copy of this leaf. */
+			if (bErrOk != bScanStart(bpptree->tree, &bCursor->scan)) {
+				bpptree_destroy_cursor(cursor);
+				return err_out_of_memory;
 			}
 
+			(*cursor)->status = cs_cursor_initialized;
+			return err_ok;
+
 			break;
 		}
 
-		case predicate_all_records: {
+		case predicate_all_records:
+		case predicate_predicate: {
 			ion_bpp_err_t err;
 
 			/* We search for first key in B++ tree. */
@@ -606,16 +874,19 @@ bpptree_find(
 			if (bErrOk != err) {
 				(*cursor)->status = cs_end_of_results;
 			}
+			else {
+				bpptree_cursor_take_value(bpptree, bCursor);
+
+				if (bErrOk != bScanStart(bpptree->tree, &bCursor->scan)) {
+					bpptree_destroy_cursor(cursor);
+					return err_out_of_memory;
+				}
+			}
 
 			return err_ok;
 			break;
 		}
 
-		case predicate_predicate: {
-			/* TODO not implemented */
-			break;
-		}
-
 		default: {
 			return err_invalid_predicate;
 			break;
@@ -625,7 +896,20 @@ bpptree_find(
 	return err_ok;
 }
 
-/* TODO Write me doc! */
+/**
+@brief		Opens a dictionary from its master table record, with the node
+			size it was created with.
+@param		handler
+				The handler for the dictionary.
+@param		dictionary
+				The dictionary to open into.
+@param		config
+				The stored configuration; @c page_size is the node size,
+				0 for the default.
+@param		compare
+				The comparison function for the keys.
+@return		The status of opening the dictionary.
+*/
 ion_err_t
 bpptree_open_dictionary(
 	ion_dictionary_handler_t		*handler,
@@ -633,20 +917,688 @@ bpptree_open_dictionary(
 	ion_dictionary_config_info_t	*config,
 	ion_dictionary_compare_t		compare
 ) {
-	return bpptree_create_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+	return bpptree_open_tree(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, config->page_size, config, compare, handler, dictionary);
+}
+
+/**
+@brief		State threaded through @ref bBulkLoad on behalf of
+			@ref bpptree_bulk_load.
+*/
+typedef struct {
+	ion_bpptree_t			*bpptree;	/**< Tree being loaded. */
+	ion_bpptree_bulk_next_t next;		/**< Caller's record source. */
+	void					*context;	/**< Caller's context for @p next. */
+	ion_record_t			record;		/**< One record of look-ahead. */
+	ion_value_t				held;		/**< Newest value of the current key. */
+	ion_boolean_t			have_record;/**< Whether @p record holds a record. */
+	ion_err_t				error;		/**< First error seen, if any. */
+	ion_result_count_t		count;		/**< Values written so far. */
+} ion_bpptree_bulk_state_t;
+
+/**
+@brief		Pulls the next record from the caller into the look-ahead slot.
+@return		@ref bErrOk if a record was fetched, @ref bErrKeyNotFound once
+			the input is exhausted, or @ref bErrIO on a caller error.
+*/
+static ion_bpp_err_t
+bpptree_bulk_fetch(
+	ion_bpptree_bulk_state_t *state
+) {
+	ion_err_t err = state->next(state->context, &state->record);
+
+	if (err_item_not_found == err) {
+		state->have_record = boolean_false;
+		return bErrKeyNotFound;
+	}
+
+	if (err_ok != err) {
+		state->error = err;
+		return bErrIO;
+	}
+
+	state->have_record = boolean_true;
+	return bErrOk;
+}
+
+/**
+@brief		Feeds one distinct key to @ref bBulkLoad, along with all of the
+			values that share it. The last of them is the newest, so it is
+			the one kept inline when the tree holds values; the rest are
+			chained in the value file as repeated inserts would leave them.
+*/
+static ion_bpp_err_t
+bpptree_bulk_next(
+	void						*context,
+	void						*key,
+	void						*value,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpptree_bulk_state_t	*state		= context;
+	ion_bpptree_t				*bpptree	= state->bpptree;
+	ion_key_size_t				key_size	= bpptree->super.record.key_size;
+	ion_value_size_t			value_size	= bpptree->super.record.value_size;
+	ion_file_offset_t			offset		= ION_FILE_NULL;
+	ion_bpp_err_t				bErr;
+	ion_err_t					err;
+
+	if (!state->have_record && (bErrOk != (bErr = bpptree_bulk_fetch(state)))) {
+		return bErr;
+	}
+
+	memcpy(key, state->record.key, key_size);
+
+	while (1) {
+		memcpy(state->held, state->record.value, value_size);
+		state->count++;
+
+		bErr = bpptree_bulk_fetch(state);
+
+		if (bErrIO == bErr) {
+			return bErr;
+		}
+
+		if (!state->have_record || (0 != bpptree->super.compare(key, state->record.key, key_size))) {
+			break;
+		}
+
+		/* an older value of a duplicated key */
+		err = lfb_put(&(bpptree->values), (ion_byte_t *) state->held, value_size, offset, &offset);
+
+		if (err_ok != err) {
+			state->error = err;
+			return bErrIO;
+		}
+	}
+
+	if (bpptree->inline_values) {
+		memcpy(value, state->held, value_size);
+	}
+	else {
+		err = lfb_put(&(bpptree->values), (ion_byte_t *) state->held, value_size, offset, &offset);
+
+		if (err_ok != err) {
+			state->error = err;
+			return bErrIO;
+		}
+	}
+
+	*rec = offset;
+	return bErrOk;
+}
+
+/**
+@brief		Writes every pending change of a B+ tree dictionary, pushing
+			the writes as far as @p policy.
+*/
+static ion_err_t
+bpptree_sync_to(
+	ion_dictionary_t		*dictionary,
+	ion_bpp_sync_policy_t	policy
+) {
+	ion_bpptree_t	*bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_err_t		err;
+
+	err = err_ok;
+
+	if (bSyncFsync == policy) {
+		err = ion_fsync(bpptree->values.file_handle);
+	}
+	else if (bSyncFlush == policy) {
+		err = ion_fflush(bpptree->values.file_handle);
+	}
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	if (bErrOk != bSyncTo(bpptree->tree, policy)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes every pending change of a B+ tree dictionary.
+
+@details	The value file is pushed first, so the tree never points at
+			values that did not make it. The index nodes follow in address
+			order, see @ref bSync. How far the writes go is set by
+			@ref ION_BPP_DEFAULT_SYNC_POLICY.
+
+@param		dictionary
+				An open B+ tree dictionary.
+@return		The status of the sync.
+*/
+ion_err_t
+bpptree_sync(
+	ion_dictionary_t *dictionary
+) {
+	return bpptree_sync_to(dictionary, ((ion_bpptree_t *) dictionary->instance)->sync_policy);
+}
+
+/**
+@brief		Pushes every write of a B+ tree dictionary to the device, for
+			its durability, see @ref dictionary_set_durability.
+*/
+static ion_err_t
+bpptree_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return bpptree_sync_to(dictionary, bSyncFsync);
+}
+
+/**
+@brief		Packs the index nodes of a B+ tree dictionary to the front of
+			its index file and shrinks the file.
+
+@details	Nodes freed by deletes are reused by later inserts without
+			this; compaction only gives the space back, see @ref bCompact.
+			The value file is left as it is, see
+			@ref bpptree_compact_values.
+
+@param		dictionary
+				An open B+ tree dictionary.
+@return		The status of the compaction.
+*/
+ion_err_t
+bpptree_compact(
+	ion_dictionary_t *dictionary
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	switch (bCompact(bpptree->tree)) {
+		case bErrOk:
+			return err_ok;
+
+		case bErrMemory:
+			return err_out_of_memory;
+
+		case bErrKeyNotFound:
+			return err_item_not_found;
+
+		default:
+			return err_file_write_error;
+	}
+}
+
+/**
+@brief		Copies the first bytes of one file over another.
+*/
+static ion_err_t
+bpptree_copy_file(
+	ion_file_handle_t	from,
+	ion_file_handle_t	to,
+	ion_file_offset_t	size,
+	ion_byte_t			*buffer,
+	unsigned int		buffer_size
+) {
+	ion_file_offset_t	at;
+	unsigned int		chunk;
+	ion_err_t			err = err_ok;
+
+	for (at = 0; (err_ok == err) && (at < size); at += chunk) {
+		chunk = buffer_size;
+
+		if ((ion_file_offset_t) chunk > size - at) {
+			chunk = (unsigned int) (size - at);
+		}
+
+		err = ion_fread_at(from, at, chunk, buffer);
+
+		if (err_ok == err) {
+			err = ion_fwrite_at(to, at, chunk, buffer);
+		}
+	}
+
+	return err;
+}
+
+/**
+@brief		Rewrites the value file of a B+ tree dictionary with the values
+			of each key consecutive, and shrinks the file.
+
+@details	Values freed by deletes are reused by later inserts, so after
+			enough churn the values of a key are scattered over the file
+			and reading them all is a random read each. Compaction copies
+			the values of each key, in key order, to one run of records
+			read front to back, then points the tree at the runs. Keys
+			with their newest value inline only have their older values
+			moved.
+
+			The runs are built in a scratch file and copied back over the
+			value file, as not every file system can rename, and the keys
+			to repoint are listed in a second scratch file so the tree is
+			not changed while it is being walked. Where the file can't be
+			cut, its tail is put on the free list instead. A crash during
+			compaction can leave the tree pointing at the wrong values, so
+			sync before and keep a copy where that matters.
+
+@param		dictionary
+				An open B+ tree dictionary with no cursors open.
+@return		The status of the compaction, @ref err_out_of_memory if there
+			is no room for a key and value, or the error of the file that
+			failed.
+*/
+ion_err_t
+bpptree_compact_values(
+	ion_dictionary_t *dictionary
+) {
+	ion_bpptree_t				*bpptree	= (ion_bpptree_t *) dictionary->instance;
+	ion_key_size_t				key_size	= bpptree->super.record.key_size;
+	unsigned int				record_size = sizeof(ion_file_offset_t) + bpptree->super.record.value_size;
+	char						packed_filename[ION_MAX_FILENAME_LENGTH];
+	char						keys_filename[ION_MAX_FILENAME_LENGTH];
+	ion_lfb_t					packed;
+	ion_file_handle_t			keys;
+	ion_file_offset_t			keys_end	= 0;
+	ion_file_offset_t			end			= 0;
+	ion_file_offset_t			old_end;
+	ion_file_offset_t			at;
+	ion_bpp_external_address_t	rec;
+	ion_file_vector_t			pair[2];
+	ion_byte_t					*key;
+	ion_byte_t					*buffer;
+	unsigned int				buffer_size;
+	ion_bpp_err_t				bErr;
+	ion_err_t					err = err_ok;
+
+	if ((dictionary_get_filename(bpptree->super.id, "vpk", packed_filename) >= ION_MAX_FILENAME_LENGTH) || (dictionary_get_filename(bpptree->super.id, "vky", keys_filename) >= ION_MAX_FILENAME_LENGTH)) {
+		return err_dictionary_initialization_failed;
+	}
+
+	/* the buffer holds a value, and is reused to copy the file back */
+	buffer_size = (record_size > ION_FILE_CACHE_PAGE_SIZE) ? record_size : ION_FILE_CACHE_PAGE_SIZE;
+	key			= ion_alloc(ion_alloc_buffer, key_size + buffer_size);
+
+	if (NULL == key) {
+		return err_out_of_memory;
+	}
+
+	buffer = key + key_size;
+
+	ion_fremove(packed_filename);
+	ion_fremove(keys_filename);
+	packed.file_handle	= ion_fopen(packed_filename);
+	packed.next_empty	= ION_LFB_NULL;
+	keys				= ion_fopen(keys_filename);
+
+	if ((ION_NOFILE == packed.file_handle) || (ION_NOFILE == keys)) {
+		err = err_file_open_error;
+	}
+
+	pair[0].bytes		= key;
+	pair[0].num_bytes	= key_size;
+	pair[1].bytes		= (ion_byte_t *) &end;
+	pair[1].num_bytes	= sizeof(end);
+
+	/* each key's values go to the next run, and the key and run are listed */
+	for (bErr = bFindFirstKey(bpptree->tree, key, &rec); (err_ok == err) && (bErrOk == bErr); bErr = bFindNextKey(bpptree->tree, key, &rec)) {
+		if (ION_LFB_NULL == rec) {
+			continue;
+		}
+
+		err = ion_fwritev_at(keys, keys_end, pair, 2);
+
+		if (err_ok == err) {
+			keys_end	+= key_size + sizeof(end);
+			err			= lfb_copy(&bpptree->values, rec, bpptree->super.record.value_size, buffer, &packed, &end);
+		}
+	}
+
+	/* the walk ends when the keys run out, and only then */
+	if ((err_ok == err) && (bErrKeyNotFound != bErr)) {
+		err = err_file_read_error;
+	}
+
+	old_end = ion_fend(bpptree->values.file_handle);
+
+	if (err_ok == err) {
+		err = bpptree_copy_file(packed.file_handle, bpptree->values.file_handle, end, buffer, buffer_size);
+	}
+
+	if (err_ok == err) {
+		bpptree->values.next_empty = ION_LFB_NULL;
+
+		if (end < old_end) {
+			err = ion_ftruncate(bpptree->values.file_handle, end);
+		}
+
+		/* records past the runs are free for reuse if the file keeps them */
+		for (at = end; (err_not_implemented == err) && (at + (ion_file_offset_t) record_size <= old_end); at += record_size) {
+			if (err_ok != lfb_delete(&bpptree->values, at)) {
+				err = err_file_write_error;
+			}
+		}
+
+		if (err_not_implemented == err) {
+			err = err_ok;
+		}
+	}
+
+	/* the tree is only changed now the walk is over */
+	for (at = 0; (err_ok == err) && (at < keys_end); at += key_size + sizeof(end)) {
+		err = ion_freadv_at(keys, at, pair, 2);
+
+		if ((err_ok == err) && (bErrOk != bUpdateKey(bpptree->tree, key, end))) {
+			err = err_file_write_error;
+		}
+	}
+
+	if (ION_NOFILE != packed.file_handle) {
+		ion_fclose(packed.file_handle);
+	}
+
+	if (ION_NOFILE != keys) {
+		ion_fclose(keys);
+	}
+
+	ion_fremove(packed_filename);
+	ion_fremove(keys_filename);
+	ion_free(key);
+
+	return err;
+}
+
+/**
+@brief		Chooses whether a B+ tree dictionary stores its index nodes
+			compressed.
+
+@details	Compressed nodes each take a whole page of the index file
+			still, but only their compressed bytes are read and written.
+			Integer keys are stored as the distance from the previous
+			key and the rest of the node is compressed with
+			@ref page_codec_compress, see @ref bSetCompression. The
+			choice is kept in the index file, so the dictionary reopens
+			the same way.
+
+@param		dictionary
+				An open B+ tree dictionary. To turn compression on, it
+				must be empty or have been compressed before.
+@param		compress
+				Whether to compress nodes from now on.
+@return		@ref err_ok, @ref err_illegal_state if @p dictionary holds
+			records stored uncompressed, or @ref err_invalid_initial_size
+			if its pages are too small, or too large, for compression.
+*/
+ion_err_t
+bpptree_set_compression(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		compress
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	switch (bSetCompression(bpptree->tree, compress ? boolean_true : boolean_false)) {
+		case bErrOk:
+			return err_ok;
+
+		case bErrNotEmpty:
+			return err_illegal_state;
+
+		case bErrSectorSize:
+			return err_invalid_initial_size;
+
+		default:
+			return err_out_of_memory;
+	}
+}
+
+/**
+@brief		Builds an empty B+ tree dictionary from records supplied in
+			ascending key order.
+
+@details	Instead of inserting one record at a time, the tree is built
+			bottom-up in a single sequential pass, see @ref bBulkLoad.
+			Values go into the leaves when small enough, and are otherwise
+			appended to the value file in input order. Consecutive records
+			with equal keys are kept as duplicates.
+
+@param		dictionary
+				An open, empty B+ tree dictionary.
+@param		next
+				Called for each record in turn.
+@param		context
+				Passed through to @p next.
+@return		The status of the load; the count is the number of records
+			loaded.
+*/
+ion_status_t
+bpptree_bulk_load(
+	ion_dictionary_t		*dictionary,
+	ion_bpptree_bulk_next_t next,
+	void					*context
+) {
+	ion_bpptree_t				*bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_bpptree_bulk_state_t	state;
+	ion_status_t				status;
+	ion_bpp_err_t				bErr;
+
+	state.bpptree		= bpptree;
+	state.next			= next;
+	state.context		= context;
+	state.have_record	= boolean_false;
+	state.error			= err_ok;
+	state.count			= 0;
+	state.record.key	= ion_alloc(ion_alloc_buffer, bpptree->super.record.key_size);
+	state.record.value	= ion_alloc(ion_alloc_buffer, bpptree->super.record.value_size);
+	state.held			= ion_alloc(ion_alloc_buffer, bpptree->super.record.value_size);
+
+	if ((NULL == state.record.key) || (NULL == state.record.value) || (NULL == state.held)) {
+		ion_free(state.record.key);
+		ion_free(state.record.value);
+		ion_free(state.held);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	bErr = bBulkLoad(bpptree->tree, bpptree_bulk_next, &state);
+
+	switch (bErr) {
+		case bErrOk:
+			status = ION_STATUS_OK(state.count);
+			break;
+
+		case bErrNotEmpty:
+			status = ION_STATUS_ERROR(err_illegal_state);
+			break;
+
+		case bErrKeyOrder:
+			status = ION_STATUS_ERROR(err_sorted_order_violation);
+			break;
+
+		case bErrMemory:
+			status = ION_STATUS_ERROR(err_out_of_memory);
+			break;
+
+		default:
+			status = ION_STATUS_ERROR((err_ok != state.error) ? state.error : err_file_write_error);
+			break;
+	}
+
+	ion_free(state.record.key);
+	ion_free(state.record.value);
+	ion_free(state.held);
+	return status;
+}
+
+/**
+@brief		Adds one operation that started at @p start to @p op.
+*/
+static void
+bpptree_count_op(
+	ion_bpptree_op_stats_t	*op,
+	unsigned long			start
+) {
+	op->calls++;
+	op->ticks += ION_BPPTREE_CLOCK() - start;
+}
+
+/**
+@brief		@ref bpptree_insert, timed into the dictionary's statistics.
+*/
+static ion_status_t
+bpptree_timed_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	unsigned long	start	= ION_BPPTREE_CLOCK();
+	ion_status_t	status	= bpptree_insert(dictionary, key, value);
+
+	bpptree_count_op(&((ion_bpptree_t *) dictionary->instance)->stats.insert, start);
+	return status;
+}
+
+/**
+@brief		@ref bpptree_query, timed into the dictionary's statistics.
+*/
+static ion_status_t
+bpptree_timed_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	unsigned long	start	= ION_BPPTREE_CLOCK();
+	ion_status_t	status	= bpptree_query(dictionary, key, value);
+
+	bpptree_count_op(&((ion_bpptree_t *) dictionary->instance)->stats.get, start);
+	return status;
+}
+
+/**
+@brief		@ref bpptree_update, timed into the dictionary's statistics.
+*/
+static ion_status_t
+bpptree_timed_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	unsigned long	start	= ION_BPPTREE_CLOCK();
+	ion_status_t	status	= bpptree_update(dictionary, key, value);
+
+	bpptree_count_op(&((ion_bpptree_t *) dictionary->instance)->stats.update, start);
+	return status;
+}
+
+/**
+@brief		@ref bpptree_delete, timed into the dictionary's statistics.
+*/
+static ion_status_t
+bpptree_timed_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	unsigned long	start	= ION_BPPTREE_CLOCK();
+	ion_status_t	status	= bpptree_delete(dictionary, key);
+
+	bpptree_count_op(&((ion_bpptree_t *) dictionary->instance)->stats.remove, start);
+	return status;
+}
+
+/**
+@brief		Reads the statistics of a B+ tree dictionary.
+
+@details	Operation counters cover calls made through the handler. The
+			tree counters come from @ref bStats.
+
+@param		dictionary
+				An open B+ tree dictionary.
+@param		stats
+				Filled with the counters since the dictionary was opened or
+				last reset.
+@return		The status of the call.
+*/
+ion_err_t
+bpptree_stats(
+	ion_dictionary_t	*dictionary,
+	ion_bpptree_stats_t *stats
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	*stats = bpptree->stats;
+
+	if (bErrOk != bStats(bpptree->tree, &stats->tree)) {
+		return err_uninitialized;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Starts a new measurement period for a B+ tree dictionary.
+
+@param		dictionary
+				An open B+ tree dictionary.
+@return		The status of the call.
+*/
+ion_err_t
+bpptree_reset_stats(
+	ion_dictionary_t *dictionary
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	memset(&bpptree->stats, 0, sizeof(bpptree->stats));
+	bResetStats(bpptree->tree);
+
+	return err_ok;
+}
+
+/**
+@brief		Tells the size of a B+ tree dictionary, see
+			@ref dictionary_get_info. Its nodes are its pages, and its
+			bounds are read off the ends of the tree, which moves the
+			position of an equality cursor open on it. How many records
+			it holds is not kept.
+*/
+static ion_err_t
+bpptree_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_bpptree_t				*bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_bpp_stats_t				stats;
+	ion_bpp_external_address_t	rec;
+	ion_file_offset_t			values;
+
+	if (bErrOk != bStats(bpptree->tree, &stats)) {
+		return err_uninitialized;
+	}
+
+	values				= ion_fend(bpptree->values.file_handle);
+	info->pages			= (long) stats.nodes;
+	info->file_bytes	= (long) stats.fileBytes + ((values > 0) ? (long) values : 0);
+	info->memory_bytes	= (long) bpptree->budget.granted;
+	info->ordered		= boolean_true;
+
+	if ((NULL == info->min_key) || (NULL == info->max_key)) {
+		return err_ok;
+	}
+
+	if ((bErrOk == bFindFirstKey(bpptree->tree, info->min_key, &rec)) && (bErrOk == bFindLastKey(bpptree->tree, info->max_key, &rec))) {
+		info->has_bounds = boolean_true;
+	}
+
+	return err_ok;
 }
 
 void
 bpptree_init(
 	ion_dictionary_handler_t *handler
 ) {
-	handler->insert				= bpptree_insert;
+	handler->insert				= bpptree_timed_insert;
 	handler->create_dictionary	= bpptree_create_dictionary;
-	handler->get				= bpptree_query;
-	handler->update				= bpptree_update;
+	handler->get				= bpptree_timed_query;
+	handler->update				= bpptree_timed_update;
 	handler->find				= bpptree_find;
-	handler->remove				= bpptree_delete;
+	handler->remove				= bpptree_timed_delete;
 	handler->delete_dictionary	= bpptree_delete_dictionary;
 	handler->open_dictionary	= bpptree_open_dictionary;
 	handler->close_dictionary	= bpptree_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= bpptree_sync_dictionary;
+	handler->get_info			= bpptree_get_info;
+	handler->bulk_load			= bpptree_bulk_load;
 }
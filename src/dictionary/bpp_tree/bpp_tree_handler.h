@@ -17,20 +17,222 @@ extern "C" {
 #include "./../dictionary.h"
 #include "../../key_value/kv_system.h"
 #include "../../file/linked_file_bag.h"
+#include "../ion_memory_budget.h"
 #include "bpp_tree.h"
 
+/**
+@brief		Largest value, in bytes, kept inline in the B+ tree leaves.
+@details	Smaller values are stored next to their key, so a point lookup
+			reads only the index file. Larger values, and all but the
+			newest value of a duplicated key, live in the value file.
+*/
+#if !defined(ION_BPPTREE_INLINE_VALUE_MAX)
+#define ION_BPPTREE_INLINE_VALUE_MAX 16
+#endif
+
+/**
+@brief		Node buffers a B+ tree opened without a buffer count asks a
+			memory budget for.
+@details	Only asked for while @ref ion_budget_set has set a budget;
+			otherwise such a tree keeps @ref ION_BPP_DEFAULT_BUFFER_COUNT
+			buffers.
+*/
+#if !defined(ION_BPPTREE_BUDGET_BUFFER_COUNT)
+#if defined(ARDUINO)
+#define ION_BPPTREE_BUDGET_BUFFER_COUNT 16
+#else
+#define ION_BPPTREE_BUDGET_BUFFER_COUNT 256
+#endif
+#endif
+
+/**
+@brief		Node size, in bytes, of B+ tree dictionaries created without a
+			page size.
+@details	Doubled as needed until a node holds
+			@ref ION_BPP_MIN_NODE_KEYS keys. Pass a page size to
+			@ref ion_master_table_create_dictionary_paged to match a
+			device, such as 512 bytes for an SD card or 4096 for a host
+			file system. With @ref ION_FILE_DIRECT it is a block of
+			@ref ION_FILE_DIRECT_ALIGNMENT, so nodes fill the pages of the
+			file cache.
+*/
+#if !defined(ION_BPPTREE_DEFAULT_PAGE_SIZE)
+#if defined(ION_FILE_DIRECT)
+#define ION_BPPTREE_DEFAULT_PAGE_SIZE ION_FILE_DIRECT_ALIGNMENT
+#else
+#define ION_BPPTREE_DEFAULT_PAGE_SIZE 256
+#endif
+#endif
+
+/**
+@brief		Clock read around each dictionary operation for the latency
+			counters in @ref ion_bpptree_stats_t.
+@details	Defaults to processor time from @c clock(). Define it, for
+			example as @c millis() on Arduino, to measure something else;
+			without a definition Arduino builds count calls only.
+*/
+#if !defined(ION_BPPTREE_CLOCK)
+#if defined(ARDUINO)
+#define ION_BPPTREE_CLOCK() 0
+#else
+#include <time.h>
+#define ION_BPPTREE_CLOCK() ((unsigned long) clock())
+#endif
+#endif
+
+/**
+@brief		Call count and time spent, in @ref ION_BPPTREE_CLOCK ticks,
+			for one kind of dictionary operation.
+*/
+typedef struct {
+	unsigned long	calls;	/**< Operations completed. */
+	unsigned long	ticks;	/**< Total clock ticks spent in them. */
+} ion_bpptree_op_stats_t;
+
+/**
+@brief		Statistics of one B+ tree dictionary, see @ref bpptree_stats.
+*/
+typedef struct {
+	ion_bpp_stats_t			tree;	/**< Index node and buffer pool counters. */
+	ion_bpptree_op_stats_t	get;	/**< Point lookups. */
+	ion_bpptree_op_stats_t	insert;	/**< Inserts. */
+	ion_bpptree_op_stats_t	update;	/**< Updates. */
+	ion_bpptree_op_stats_t	remove;	/**< Deletes. */
+} ion_bpptree_stats_t;
+
 typedef struct bplusplustree {
 	ion_dictionary_parent_t super;
 	ion_bpp_handle_t		tree;
 	ion_lfb_t				values;
+	ion_boolean_t			inline_values;	/**< Whether leaves hold the newest value. */
+	ion_bpp_sync_policy_t	sync_policy;	/**< How far @ref bpptree_sync pushes writes. */
+	ion_bpptree_stats_t		stats;			/**< Operation counters, tree counters unused. */
+	ion_budget_client_t		budget;			/**< Place of the buffer pool in the memory budget. */
+	int						pool_base;		/**< Pool bytes besides the node buffers. */
+	int						pool_buffer;	/**< Pool bytes per node buffer. */
 } ion_bpptree_t;
 
 typedef struct {
 	ion_dict_cursor_t	super;		/**< Supertype of cursor		*/
 	ion_key_t			cur_key;/**< Current key we're visiting */
 	ion_file_offset_t	offset;		/**< offset in LFB; holds value */
+	ion_value_t			cur_value;	/**< Inline value of the current key */
+	ion_boolean_t		at_inline;	/**< Inline value not yet returned */
+	ion_bpp_scan_t		scan;		/**< Leaf walked by range and all records */
 } ion_bpp_cursor_t;
 
+/**
+@brief		Supplies records to @ref bpptree_bulk_load.
+@param		context
+				The context given to @ref bpptree_bulk_load.
+@param		record
+				Key and value buffers, sized for the dictionary, to fill with
+				the next record. Records must come in ascending key order.
+@return		@ref err_ok if @p record was filled, @ref err_item_not_found once
+			there are no more records, or any other error to abort the load.
+*/
+typedef ion_err_t (*ion_bpptree_bulk_next_t)(
+	void			*context,
+	ion_record_t	*record
+);
+
+/**
+@brief		Builds an empty B+ tree dictionary from sorted records in one
+			sequential pass.
+@param		dictionary
+				An open, empty B+ tree dictionary.
+@param		next
+				Called for each record in turn.
+@param		context
+				Passed through to @p next.
+@return		The status of the load; the count is the number of records
+			loaded.
+*/
+ion_status_t
+bpptree_bulk_load(
+	ion_dictionary_t		*dictionary,
+	ion_bpptree_bulk_next_t next,
+	void					*context
+);
+
+/**
+@brief		Writes every pending change of a B+ tree dictionary, the
+			durability point for group commit.
+@param		dictionary
+				An open B+ tree dictionary.
+@return		The status of the sync.
+*/
+ion_err_t
+bpptree_sync(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Packs the index nodes of a B+ tree dictionary to the front of
+			its index file and shrinks the file.
+@param		dictionary
+				An open B+ tree dictionary.
+@return		The status of the compaction.
+*/
+ion_err_t
+bpptree_compact(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Rewrites the value file of a B+ tree dictionary with the values
+			of each key consecutive, and shrinks the file.
+@param		dictionary
+				An open B+ tree dictionary with no cursors open.
+@return		The status of the compaction.
+*/
+ion_err_t
+bpptree_compact_values(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Chooses whether a B+ tree dictionary stores its index nodes
+			compressed, cutting the bytes each node read moves.
+@param		dictionary
+				An open B+ tree dictionary, empty or compressed before to
+				turn compression on.
+@param		compress
+				Whether to compress nodes from now on.
+@return		The status of the call.
+*/
+ion_err_t
+bpptree_set_compression(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		compress
+);
+
+/**
+@brief		Reads the statistics of a B+ tree dictionary.
+@param		dictionary
+				An open B+ tree dictionary.
+@param		stats
+				Filled with the counters since the dictionary was opened or
+				last reset.
+@return		The status of the call.
+*/
+ion_err_t
+bpptree_stats(
+	ion_dictionary_t	*dictionary,
+	ion_bpptree_stats_t *stats
+);
+
+/**
+@brief		Starts a new measurement period for a B+ tree dictionary.
+@param		dictionary
+				An open B+ tree dictionary.
+@return		The status of the call.
+*/
+ion_err_t
+bpptree_reset_stats(
+	ion_dictionary_t *dictionary
+);
+
 /**
 @brief		Registers a specific handler for a  dictionary instance.
 
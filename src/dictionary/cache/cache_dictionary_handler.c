@@ -0,0 +1,584 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that puts a bounded cache of records in front of a
+			dictionary of any other handler.
+*/
+/******************************************************************************/
+
+#include "cache_dictionary_handler.h"
+
+/**
+@brief		The states of a cache slot.
+*/
+#define ION_CACHE_SLOT_EMPTY	0
+#define ION_CACHE_SLOT_COLD		1
+#define ION_CACHE_SLOT_HOT		2
+
+/**
+@brief		The record held in a slot, its value after the key.
+*/
+static ion_byte_t *
+cachedict_record(
+	ion_cache_dictionary_t	*cache,
+	int						slot
+) {
+	return cache->records + slot * (cache->super.record.key_size + cache->super.record.value_size);
+}
+
+/**
+@brief		The bucket a key is chained into.
+*/
+static int
+cachedict_bucket(
+	ion_cache_dictionary_t	*cache,
+	ion_key_t				key
+) {
+	return (int) (dictionary_hash_key(cache->super.key_type, key, cache->super.record.key_size, 0) & (uint32_t) cache->bucket_mask);
+}
+
+/**
+@brief		The slot holding a key, or -1 if the cache does not hold it.
+*/
+static int
+cachedict_lookup(
+	ion_cache_dictionary_t	*cache,
+	ion_key_t				key
+) {
+	int slot;
+
+	for (slot = cache->buckets[cachedict_bucket(cache, key)]; -1 != slot; slot = cache->next[slot]) {
+		if (0 == cache->super.compare(cachedict_record(cache, slot), key, cache->super.record.key_size)) {
+			return slot;
+		}
+	}
+
+	return -1;
+}
+
+/**
+@brief		Empties a slot, taking it out of its bucket.
+*/
+static void
+cachedict_unlink(
+	ion_cache_dictionary_t	*cache,
+	int						slot
+) {
+	int *link = &cache->buckets[cachedict_bucket(cache, cachedict_record(cache, slot))];
+
+	while (slot != *link) {
+		link = &cache->next[*link];
+	}
+
+	*link				= cache->next[slot];
+	cache->states[slot] = ION_CACHE_SLOT_EMPTY;
+}
+
+/**
+@brief		Finds a slot for a new record with the clock, evicting the
+			first cold record it comes to.
+@details	Every hot slot passed is cooled, so at most two turns of the
+			clock are made.
+*/
+static int
+cachedict_claim(
+	ion_cache_dictionary_t *cache
+) {
+	int slot;
+
+	while (boolean_true) {
+		slot		= cache->hand;
+		cache->hand = (cache->hand + 1) % cache->capacity;
+
+		if (ION_CACHE_SLOT_HOT == cache->states[slot]) {
+			cache->states[slot] = ION_CACHE_SLOT_COLD;
+			continue;
+		}
+
+		if (ION_CACHE_SLOT_COLD == cache->states[slot]) {
+			cachedict_unlink(cache, slot);
+			cache->stats.evictions++;
+		}
+
+		return slot;
+	}
+}
+
+/**
+@brief		Caches the value of a key, replacing any it had.
+*/
+static void
+cachedict_store(
+	ion_cache_dictionary_t	*cache,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_key_size_t	key_size	= cache->super.record.key_size;
+	int				slot		= cachedict_lookup(cache, key);
+	int				bucket;
+
+	if (-1 == slot) {
+		slot	= cachedict_claim(cache);
+		bucket	= cachedict_bucket(cache, key);
+		memcpy(cachedict_record(cache, slot), key, key_size);
+		cache->next[slot]		= cache->buckets[bucket];
+		cache->buckets[bucket]	= slot;
+	}
+
+	memcpy(cachedict_record(cache, slot) + key_size, value, cache->super.record.value_size);
+	cache->states[slot] = ION_CACHE_SLOT_HOT;
+}
+
+/**
+@brief		Drops a key from the cache, if it holds it.
+*/
+static void
+cachedict_forget(
+	ion_cache_dictionary_t	*cache,
+	ion_key_t				key
+) {
+	int slot = cachedict_lookup(cache, key);
+
+	if (-1 != slot) {
+		cachedict_unlink(cache, slot);
+	}
+}
+
+/**
+@brief		The number of buckets for a number of slots, about one a
+			slot so chains stay short.
+*/
+static int
+cachedict_bucket_count(
+	int capacity
+) {
+	int bucket_count = 1;
+
+	while (bucket_count < capacity) {
+		bucket_count *= 2;
+	}
+
+	return bucket_count;
+}
+
+/**
+@brief		The bytes of the slots and buckets for a number of slots.
+*/
+static size_t
+cachedict_size(
+	ion_record_info_t	*record,
+	int					capacity
+) {
+	return (size_t) cachedict_bucket_count(capacity) * sizeof(int) + (size_t) capacity * (sizeof(int) + 1 + record->key_size + record->value_size);
+}
+
+/**
+@brief		The most slots, up to the limit, that fit in @p bytes, and
+			at least one.
+*/
+static int
+cachedict_fit(
+	ion_cache_dictionary_t	*cache,
+	size_t					bytes
+) {
+	int low		= 1;
+	int high	= cache->limit;
+	int middle;
+
+	while (low < high) {
+		middle = low + (high - low + 1) / 2;
+
+		if (cachedict_size(&cache->super.record, middle) <= bytes) {
+			low = middle;
+		}
+		else {
+			high = middle - 1;
+		}
+	}
+
+	return low;
+}
+
+/**
+@brief		Gives a cache a fresh set of empty slots.
+@details	The slots it had are left to the caller to free.
+*/
+static ion_err_t
+cachedict_allocate(
+	ion_cache_dictionary_t	*cache,
+	int						capacity
+) {
+	int bucket_count = cachedict_bucket_count(capacity);
+	int *buckets;
+	int i;
+
+	/* the slots and buckets in one piece, the int arrays first to keep them aligned */
+	buckets = ion_alloc(ion_alloc_node, cachedict_size(&cache->super.record, capacity));
+
+	if (NULL == buckets) {
+		return err_out_of_memory;
+	}
+
+	cache->capacity		= capacity;
+	cache->hand			= 0;
+	cache->bucket_mask	= bucket_count - 1;
+	cache->buckets		= buckets;
+	cache->next			= cache->buckets + bucket_count;
+	cache->states		= (ion_byte_t *) (cache->next + capacity);
+	cache->records		= cache->states + capacity;
+
+	for (i = 0; i < bucket_count; i++) {
+		cache->buckets[i] = -1;
+	}
+
+	memset(cache->states, ION_CACHE_SLOT_EMPTY, capacity);
+
+	return err_ok;
+}
+
+/**
+@brief		Fits the slots of a cache to its grant from the memory
+			budget, keeping the hot records, then the cold, that fit.
+*/
+static ion_err_t
+cachedict_budget_resize(
+	void	*context,
+	size_t	bytes
+) {
+	ion_cache_dictionary_t	*cache			= (ion_cache_dictionary_t *) context;
+	ion_key_size_t			key_size		= cache->super.record.key_size;
+	int						old_capacity	= cache->capacity;
+	int						*old_buckets	= cache->buckets;
+	ion_byte_t				*old_states		= cache->states;
+	ion_byte_t				*old_records	= cache->records;
+	int						capacity		= cachedict_fit(cache, bytes);
+	int						kept			= 0;
+	ion_byte_t				state;
+	ion_byte_t				*record;
+	ion_err_t				err;
+	int						slot;
+
+	if (capacity == old_capacity) {
+		return err_ok;
+	}
+
+	err = cachedict_allocate(cache, capacity);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	for (state = ION_CACHE_SLOT_HOT; state >= ION_CACHE_SLOT_COLD; state--) {
+		for (slot = 0; slot < old_capacity; slot++) {
+			if (state != old_states[slot]) {
+				continue;
+			}
+
+			if (kept == capacity) {
+				cache->stats.evictions++;
+				continue;
+			}
+
+			record = old_records + slot * (key_size + cache->super.record.value_size);
+			cachedict_store(cache, record, record + key_size);
+			cache->states[cachedict_lookup(cache, record)] = state;
+			kept++;
+		}
+	}
+
+	ion_free(old_buckets);
+
+	return err_ok;
+}
+
+ion_err_t
+cachedict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_size_t		capacity
+) {
+	ion_cache_dictionary_t	*cache;
+	ion_record_info_t		*record = &dictionary->instance->record;
+	ion_err_t				err;
+
+	if (0 == capacity) {
+		capacity = ION_CACHE_DEFAULT_CAPACITY;
+	}
+
+	cache = ion_alloc(ion_alloc_other, sizeof(ion_cache_dictionary_t));
+
+	if (NULL == cache) {
+		return err_out_of_memory;
+	}
+
+	cache->super			= *dictionary->instance;
+	cache->inner			= *dictionary;
+	cache->inner_handler	= *dictionary->handler;
+	cache->inner.handler	= &cache->inner_handler;
+	/* the durability too, so each write is pushed once */
+	cache->inner.durability.level	= durability_none;
+	cache->inner.durability.pending	= 0;
+#if ION_DICTIONARY_STATS
+	/* the counters stay with the caller's dictionary, so each operation counts once */
+	cache->inner.stats		= NULL;
+#endif
+	cache->limit			= (int) capacity;
+	cache->stats.hits		= 0;
+	cache->stats.misses		= 0;
+	cache->stats.evictions	= 0;
+
+	err						= ion_budget_join(&cache->budget, cachedict_size(record, 1), cachedict_size(record, cache->limit), cachedict_budget_resize, cache);
+
+	if (err_ok == err) {
+		err = cachedict_allocate(cache, cachedict_fit(cache, cache->budget.granted));
+
+		if (err_ok != err) {
+			ion_budget_leave(&cache->budget);
+		}
+	}
+
+	if (err_ok != err) {
+		ion_free(cache);
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) cache;
+	dictionary->handler		= handler;
+	dictionary_opened(dictionary);
+
+	return err_ok;
+}
+
+ion_err_t
+cachedict_get_stats(
+	ion_dictionary_t	*dictionary,
+	ion_cache_stats_t	*stats
+) {
+	if (cachedict_query != dictionary->handler->get) {
+		return err_illegal_state;
+	}
+
+	*stats = ((ion_cache_dictionary_t *) dictionary->instance)->stats;
+
+	return err_ok;
+}
+
+ion_status_t
+cachedict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_cache_dictionary_t *cache = (ion_cache_dictionary_t *) dictionary->instance;
+
+	ion_budget_touch(&cache->budget);
+
+	/* a duplicate key goes after the value gets see, so the cache cannot tell which to hold */
+	cachedict_forget(cache, key);
+
+	return dictionary_insert(&cache->inner, key, value);
+}
+
+ion_status_t
+cachedict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_cache_dictionary_t	*cache = (ion_cache_dictionary_t *) dictionary->instance;
+	int						slot;
+	ion_status_t			status;
+
+	/* first, as it may move the slots */
+	ion_budget_touch(&cache->budget);
+	slot = cachedict_lookup(cache, key);
+
+	if (-1 != slot) {
+		memcpy(value, cachedict_record(cache, slot) + cache->super.record.key_size, cache->super.record.value_size);
+		cache->states[slot] = ION_CACHE_SLOT_HOT;
+		cache->stats.hits++;
+		return ION_STATUS_OK(1);
+	}
+
+	cache->stats.misses++;
+	status = dictionary_get(&cache->inner, key, value);
+
+	if (err_ok == status.error) {
+		cachedict_store(cache, key, value);
+	}
+
+	return status;
+}
+
+ion_status_t
+cachedict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return dictionary_get_ref(&((ion_cache_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_err_t
+cachedict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+	UNUSED(key_type);
+	UNUSED(key_size);
+	UNUSED(value_size);
+	UNUSED(dictionary_size);
+	UNUSED(compare);
+	UNUSED(handler);
+	UNUSED(dictionary);
+	return err_dictionary_initialization_failed;
+}
+
+ion_status_t
+cachedict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_cache_dictionary_t *cache = (ion_cache_dictionary_t *) dictionary->instance;
+
+	ion_budget_touch(&cache->budget);
+	cachedict_forget(cache, key);
+
+	return dictionary_delete(&cache->inner, key);
+}
+
+ion_err_t
+cachedict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_cache_dictionary_t	*cache	= (ion_cache_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= dictionary_delete_dictionary(&cache->inner);
+
+	ion_budget_leave(&cache->budget);
+	ion_free(cache->buckets);
+	ion_free(cache);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+cachedict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_cache_dictionary_t	*cache = (ion_cache_dictionary_t *) dictionary->instance;
+	ion_status_t			status;
+
+	ion_budget_touch(&cache->budget);
+	status = dictionary_update(&cache->inner, key, value);
+
+	if (err_ok == status.error) {
+		cachedict_store(cache, key, value);
+	}
+	else {
+		cachedict_forget(cache, key);
+	}
+
+	return status;
+}
+
+ion_err_t
+cachedict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	return dictionary_find(&((ion_cache_dictionary_t *) dictionary->instance)->inner, predicate, cursor);
+}
+
+ion_err_t
+cachedict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_dictionary_initialization_failed;
+}
+
+ion_err_t
+cachedict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_cache_dictionary_t	*cache	= (ion_cache_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= dictionary_close(&cache->inner);
+
+	if (err_ok == err) {
+		ion_budget_leave(&cache->budget);
+		ion_free(cache->buckets);
+		ion_free(cache);
+		dictionary->instance = NULL;
+	}
+
+	return err;
+}
+
+/**
+@brief		Pushes every write of a cached dictionary through to storage.
+*/
+static ion_err_t
+cachedict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return dictionary_sync(&((ion_cache_dictionary_t *) dictionary->instance)->inner);
+}
+
+/**
+@brief		Tells the size of a cached dictionary, see
+			@ref dictionary_get_info, its slots counted with what the
+			wrapped dictionary holds in memory.
+*/
+static ion_err_t
+cachedict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_cache_dictionary_t	*cache	= (ion_cache_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= dictionary_get_info(&cache->inner, info);
+
+	if (-1 != info->memory_bytes) {
+		info->memory_bytes += (long) cachedict_size(&cache->super.record, cache->capacity);
+	}
+
+	return err;
+}
+
+void
+cachedict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= cachedict_insert;
+	handler->create_dictionary	= cachedict_create_dictionary;
+	handler->get				= cachedict_query;
+	handler->update				= cachedict_update;
+	handler->find				= cachedict_find;
+	handler->remove				= cachedict_delete;
+	handler->delete_dictionary	= cachedict_delete_dictionary;
+	handler->close_dictionary	= cachedict_close_dictionary;
+	handler->open_dictionary	= cachedict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= cachedict_get_ref;
+	handler->sync_dictionary	= cachedict_sync_dictionary;
+	handler->get_info			= cachedict_get_info;
+	handler->bulk_load			= NULL;
+}
@@ -0,0 +1,315 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that puts a bounded cache of records in front of a
+			dictionary of any other handler.
+@details	A dictionary is wrapped once it is created or opened, see
+			@ref cachedict_wrap. Gets are answered from the cache when
+			they can be, and read through to the wrapped dictionary
+			when they cannot. Updates are written through to both,
+			while inserts and deletes drop the key from the cache, as
+			with duplicate keys only the wrapped dictionary knows which
+			value a get should see. Records are evicted with the CLOCK
+			algorithm, which approximates least recently used eviction
+			with one flag per record rather than a list to reorder on
+			every hit.
+*/
+/******************************************************************************/
+
+#if !defined(CACHE_DICTIONARY_HANDLER_H_)
+#define CACHE_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "../ion_memory_budget.h"
+
+/**
+@brief		The number of records a cache wrapped with a capacity of 0
+			holds.
+*/
+#if !defined(ION_CACHE_DEFAULT_CAPACITY)
+#if defined(ARDUINO)
+#define ION_CACHE_DEFAULT_CAPACITY 8
+#else
+#define ION_CACHE_DEFAULT_CAPACITY 64
+#endif
+#endif
+
+/**
+@brief		How often a cache has answered gets, see
+			@ref cachedict_get_stats.
+*/
+typedef struct cache_stats {
+	uint32_t	hits;		/**< Gets answered from the cache */
+	uint32_t	misses;		/**< Gets read through to the wrapped
+							 dictionary */
+	uint32_t	evictions;	/**< Records dropped to make room for
+							 others */
+} ion_cache_stats_t;
+
+/**
+@brief		A dictionary behind a cache of its records.
+@details	The records sit in a fixed array of slots, chained into
+			buckets by the hash of their key. A slot is empty, cold or
+			hot; hits make it hot, and the clock hand cools the hot
+			slots it passes and evicts the first cold one it finds.
+			The slots are sized by the memory budget, up to the capacity
+			asked for at the wrap.
+*/
+typedef struct cache_dictionary {
+	ion_dictionary_parent_t		super;
+	ion_dictionary_t			inner;			/**< The wrapped dictionary */
+	ion_dictionary_handler_t	inner_handler;	/**< Its handler, kept here as
+												 the caller's is rebound to
+												 the cache */
+	int							limit;			/**< The most slots, as asked
+												 for at the wrap */
+	int							capacity;		/**< The number of slots */
+	int							hand;			/**< The slot the clock looks
+												 at next */
+	int							bucket_mask;	/**< One less than the number
+												 of buckets, a power of 2 */
+	int							*buckets;		/**< The first slot of each
+												 bucket, -1 if none */
+	int							*next;			/**< The slot after each in
+												 its bucket, -1 if none */
+	ion_byte_t					*states;		/**< Whether each slot is
+												 empty, cold or hot */
+	ion_byte_t					*records;		/**< The key then value of
+												 each slot */
+	ion_cache_stats_t			stats;			/**< Counted since the wrap */
+	ion_budget_client_t			budget;			/**< Place of the slots in the
+												 memory budget */
+} ion_cache_dictionary_t;
+
+/**
+@brief		Registers the cache handler.
+
+@details	The handler cannot create dictionaries of its own, it only
+			serves those given to @ref cachedict_wrap.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+cachedict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Puts a cache in front of a dictionary.
+
+@details	From then on the dictionary is used through @p handler as
+			before, and deleting or closing it also does away with the
+			cache. Its own handler is copied, so it may be reused.
+
+@param		dictionary
+				A dictionary, created or opened with any handler.
+@param		handler
+				A handler registered with @ref cachedict_init, to bind to
+				@p dictionary.
+@param		capacity
+				The most records the cache holds, 0 for
+				@ref ION_CACHE_DEFAULT_CAPACITY.
+@return		The status of the wrap. @p dictionary is left as it was
+			unless it is @c err_ok.
+*/
+ion_err_t
+cachedict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_size_t		capacity
+);
+
+/**
+@brief		Reads the counters of a cache.
+
+@param		dictionary
+				A dictionary wrapped with @ref cachedict_wrap.
+@param		stats
+				Receives the counters.
+@return		@c err_ok, or @c err_illegal_state if @p dictionary is not
+			behind a cache.
+*/
+ion_err_t
+cachedict_get_stats(
+	ion_dictionary_t	*dictionary,
+	ion_cache_stats_t	*stats
+);
+
+/**
+@brief		Inserts a record into the wrapped dictionary, dropping its
+			key from the cache.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+cachedict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Reads the value of a key from the cache, or through it from
+			the wrapped dictionary, caching what is read.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value, allocated by the caller.
+@return		The status of the query.
+*/
+ion_status_t
+cachedict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at the value of a key where the wrapped dictionary
+			holds it, for @ref dictionary_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the query.
+*/
+ion_status_t
+cachedict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Creating is not supported, see @ref cachedict_wrap.
+
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+cachedict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes a key from the cache and the wrapped dictionary.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+cachedict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes the wrapped dictionary and frees the cache.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+cachedict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates a key in the wrapped dictionary, and in the cache
+			if the update succeeds.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		The status of the update.
+*/
+ion_status_t
+cachedict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate in the wrapped
+			dictionary, bypassing the cache.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to match.
+@param		cursor
+				Receives a cursor over the records.
+@return		The status of the find.
+*/
+ion_err_t
+cachedict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Opening is not supported, a dictionary is opened with its
+			own handler and wrapped again.
+
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+cachedict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes the wrapped dictionary and frees the cache.
+
+@param		dictionary
+				The instance of the dictionary to close.
+@return		The status of closing the wrapped dictionary.
+*/
+ion_err_t
+cachedict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CACHE_DICTIONARY_HANDLER_H_ */
@@ -0,0 +1,552 @@
+/******************************************************************************/
+/**
+@file
+@brief		A file based hash table using bucketized cuckoo hashing, so
+			that any lookup reads at most two pages.
+@details	Page @c 0 of the file holds the @ref ion_ckh_header_t, and
+			bucket @c b is page <tt>b + 1</tt>. A page is nothing but its
+			record slots.
+*/
+/******************************************************************************/
+
+#include "cuckoo_hash.h"
+#include "../../file/ion_file.h"
+
+/**
+@brief		Mixed into the seed of the second hash, so the two hashes of a
+			key are independent.
+*/
+#define ION_CKH_SECOND_SEED 0x5BD1E995UL
+
+/**
+@brief		Writes @p length bytes at @p within bytes into a slot.
+*/
+static ion_err_t
+ckh_write(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	int					bucket,
+	int					slot,
+	long				within,
+	void				*data,
+	int					length
+) {
+	long offset = ((long) bucket + 1) * cuckoo_hash->header.page_size + (long) slot * cuckoo_hash->record_size + within;
+
+	if ((0 != fseek(cuckoo_hash->file, offset, SEEK_SET)) || (1 != fwrite(data, length, 1, cuckoo_hash->file))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the header of a table to the start of its file.
+*/
+static ion_err_t
+ckh_write_header(
+	ion_cuckoo_hash_t *cuckoo_hash
+) {
+	if ((0 != fseek(cuckoo_hash->file, 0, SEEK_SET)) || (1 != fwrite(&cuckoo_hash->header, sizeof(cuckoo_hash->header), 1, cuckoo_hash->file))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Picks a pseudo-random number, so that inserts displace
+			different records and do not cycle between the same two.
+*/
+static int
+ckh_next_victim(
+	ion_cuckoo_hash_t *cuckoo_hash
+) {
+	cuckoo_hash->victim = cuckoo_hash->victim * 1103515245UL + 12345UL;
+
+	return (int) ((cuckoo_hash->victim >> 16) & 0x7FFF);
+}
+
+/**
+@brief		Returns whether a slot is already on a displacement path.
+*/
+static ion_boolean_t
+ckh_on_path(
+	ion_ckh_position_t	*path,
+	int					length,
+	int					bucket,
+	int					slot
+) {
+	int i;
+
+	for (i = 0; i < length; i++) {
+		if ((path[i].bucket == bucket) && (path[i].slot == slot)) {
+			return boolean_true;
+		}
+	}
+
+	return boolean_false;
+}
+
+/**
+@brief		Frees a slot in one of the two full pages of a key, by moving
+			a record from it to its other page, and so on.
+
+@details	The path of records to move is found first, reading a page
+			per step, reasoning about the table as if the moves had been
+			made. Its slots are never picked twice, so every record on it
+			is still where it was read. Only once a page with room is
+			reached are the records moved, the last first, so the table is
+			left as it was if none is.
+
+@param		buckets
+				The two pages of the key, both full.
+@param		room
+				Receives the slot freed, in one of @p buckets.
+@return		@c err_ok, @c err_max_capacity if no path was found within
+			@ref ION_CKH_MAX_KICKS moves, or the error reading or writing
+			the table.
+*/
+static ion_err_t
+ckh_make_room(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	int					buckets[2],
+	ion_ckh_position_t	*room
+) {
+	ion_ckh_position_t	path[ION_CKH_MAX_KICKS];
+	int					alternates[2];
+	int					bucket;
+	int					slot;
+	int					step;
+	int					tried;
+	ion_byte_t			*page;
+	ion_err_t			err;
+
+	if (cuckoo_hash->header.bucket_count < 2) {
+		return err_max_capacity;
+	}
+
+	bucket = buckets[ckh_next_victim(cuckoo_hash) & 1];
+
+	if (NULL == (page = ckh_read_page(cuckoo_hash, bucket))) {
+		return err_file_read_error;
+	}
+
+	for (step = 0; step < ION_CKH_MAX_KICKS; step++) {
+		slot = ckh_next_victim(cuckoo_hash) % cuckoo_hash->records_per_page;
+
+		for (tried = 0; (tried < cuckoo_hash->records_per_page) && ckh_on_path(path, step, bucket, slot); tried++) {
+			slot = (slot + 1) % cuckoo_hash->records_per_page;
+		}
+
+		if (tried == cuckoo_hash->records_per_page) {
+			return err_max_capacity;
+		}
+
+		path[step].bucket	= bucket;
+		path[step].slot		= slot;
+
+		/* the record goes to whichever of its pages it is not in */
+		ckh_buckets_of(cuckoo_hash, ckh_page_slot(cuckoo_hash, page, slot) + 1, alternates);
+		bucket = (alternates[0] == bucket) ? alternates[1] : alternates[0];
+
+		if (NULL == (page = ckh_read_page(cuckoo_hash, bucket))) {
+			return err_file_read_error;
+		}
+
+		for (slot = 0; slot < cuckoo_hash->records_per_page; slot++) {
+			if (ION_CKH_IN_USE != *ckh_page_slot(cuckoo_hash, page, slot)) {
+				break;
+			}
+		}
+
+		if (slot == cuckoo_hash->records_per_page) {
+			continue;
+		}
+
+		room->bucket	= bucket;
+		room->slot		= slot;
+
+		for (; step >= 0; step--) {
+			if (NULL == (page = ckh_read_page(cuckoo_hash, path[step].bucket))) {
+				return err_file_read_error;
+			}
+
+			memcpy(cuckoo_hash->record, ckh_page_slot(cuckoo_hash, page, path[step].slot), cuckoo_hash->record_size);
+
+			if (err_ok != (err = ckh_write(cuckoo_hash, room->bucket, room->slot, 0, cuckoo_hash->record, cuckoo_hash->record_size))) {
+				return err;
+			}
+
+			*room = path[step];
+		}
+
+		return err_ok;
+	}
+
+	return err_max_capacity;
+}
+
+ion_err_t
+ckh_initialize(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_dictionary_id_t id,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					size,
+	int					page_size
+) {
+	char	filename[ION_MAX_FILENAME_LENGTH];
+	int		bucket;
+
+	cuckoo_hash->write_concern				= wc_insert_unique;
+	cuckoo_hash->super.id					= id;
+	cuckoo_hash->super.key_type				= key_type;
+	cuckoo_hash->super.record.key_size		= key_size;
+	cuckoo_hash->super.record.value_size	= value_size;
+	cuckoo_hash->seed						= id;
+	cuckoo_hash->victim						= id;
+	cuckoo_hash->record_size				= 1 + key_size + value_size;
+	cuckoo_hash->page						= NULL;
+	cuckoo_hash->record						= NULL;
+
+	if (dictionary_get_filename(id, "ckh", filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_initialization_failed;
+	}
+
+	cuckoo_hash->file = fopen(filename, "r+b");
+
+	if (NULL != cuckoo_hash->file) {
+		/* an existing table keeps the layout it was created with */
+		if ((1 != fread(&cuckoo_hash->header, sizeof(cuckoo_hash->header), 1, cuckoo_hash->file)) || (key_size != cuckoo_hash->header.key_size) || (value_size != cuckoo_hash->header.value_size)) {
+			fclose(cuckoo_hash->file);
+			cuckoo_hash->file = NULL;
+			return err_dictionary_initialization_failed;
+		}
+
+		cuckoo_hash->records_per_page	= cuckoo_hash->header.page_size / cuckoo_hash->record_size;
+		cuckoo_hash->page				= ion_alloc(ion_alloc_buffer, cuckoo_hash->header.page_size);
+		cuckoo_hash->record				= ion_alloc(ion_alloc_buffer, cuckoo_hash->record_size);
+
+		if ((NULL == cuckoo_hash->page) || (NULL == cuckoo_hash->record)) {
+			ckh_close(cuckoo_hash);
+			return err_out_of_memory;
+		}
+
+		return err_ok;
+	}
+
+	if (NULL == (cuckoo_hash->file = fopen(filename, "w+b"))) {
+		return err_file_open_error;
+	}
+
+	if (0 == page_size) {
+		page_size = ION_CKH_DEFAULT_PAGE_SIZE;
+	}
+
+	/* a page holds at least the header, and one record */
+	if (page_size < (int) sizeof(ion_ckh_header_t)) {
+		page_size = sizeof(ion_ckh_header_t);
+	}
+
+	if (page_size < cuckoo_hash->record_size) {
+		page_size = cuckoo_hash->record_size;
+	}
+
+	cuckoo_hash->records_per_page		= page_size / cuckoo_hash->record_size;
+
+	cuckoo_hash->header.key_size		= key_size;
+	cuckoo_hash->header.value_size		= value_size;
+	cuckoo_hash->header.page_size		= page_size;
+	cuckoo_hash->header.record_count	= 0;
+
+	/* enough slots for the expected size at the load the table is built for, in at least two pages */
+	cuckoo_hash->header.bucket_count	= (int32_t) (((long) (size > 0 ? size : 0) * 100 / ION_CKH_LOAD_PERCENT + cuckoo_hash->records_per_page - 1) / cuckoo_hash->records_per_page);
+
+	if (cuckoo_hash->header.bucket_count < 2) {
+		cuckoo_hash->header.bucket_count = 2;
+	}
+
+	cuckoo_hash->page	= ion_alloc(ion_alloc_buffer, page_size);
+	cuckoo_hash->record = ion_alloc(ion_alloc_buffer, cuckoo_hash->record_size);
+
+	if ((NULL == cuckoo_hash->page) || (NULL == cuckoo_hash->record)) {
+		ckh_close(cuckoo_hash);
+		return err_out_of_memory;
+	}
+
+	/* a new table: a page for the header, then its empty buckets */
+	memset(cuckoo_hash->page, 0, page_size);
+	memcpy(cuckoo_hash->page, &cuckoo_hash->header, sizeof(cuckoo_hash->header));
+
+	if ((0 != fseek(cuckoo_hash->file, 0, SEEK_SET)) || (1 != fwrite(cuckoo_hash->page, page_size, 1, cuckoo_hash->file))) {
+		ckh_close(cuckoo_hash);
+		return err_file_write_error;
+	}
+
+	memset(cuckoo_hash->page, ION_CKH_EMPTY, page_size);
+
+	for (bucket = 0; bucket < cuckoo_hash->header.bucket_count; bucket++) {
+		if (1 != fwrite(cuckoo_hash->page, page_size, 1, cuckoo_hash->file)) {
+			ckh_close(cuckoo_hash);
+			return err_file_write_error;
+		}
+	}
+
+	fflush(cuckoo_hash->file);
+
+	return err_ok;
+}
+
+ion_err_t
+ckh_sync(
+	ion_cuckoo_hash_t *cuckoo_hash
+) {
+	ion_err_t err = ckh_write_header(cuckoo_hash);
+
+	if (err_ok == err) {
+		err = ion_fsync_stream(cuckoo_hash->file);
+	}
+
+	return err;
+}
+
+ion_err_t
+ckh_close(
+	ion_cuckoo_hash_t *cuckoo_hash
+) {
+	ion_err_t err = err_ok;
+
+	if (NULL != cuckoo_hash->file) {
+		err = ckh_write_header(cuckoo_hash);
+
+		if (0 != fclose(cuckoo_hash->file)) {
+			err = err_file_close_error;
+		}
+
+		cuckoo_hash->file = NULL;
+	}
+	else {
+		err = err_file_close_error;
+	}
+
+	ion_free(cuckoo_hash->page);
+	ion_free(cuckoo_hash->record);
+	cuckoo_hash->page	= NULL;
+	cuckoo_hash->record = NULL;
+
+	return err;
+}
+
+ion_err_t
+ckh_destroy(
+	ion_cuckoo_hash_t *cuckoo_hash
+) {
+	char		filename[ION_MAX_FILENAME_LENGTH];
+	ion_err_t	err = ckh_close(cuckoo_hash);
+
+	if (err_ok != err) {
+		return err_dictionary_destruction_error;
+	}
+
+	dictionary_get_filename(cuckoo_hash->super.id, "ckh", filename);
+
+	if (0 != fremove(filename)) {
+		return err_file_delete_error;
+	}
+
+	return err_ok;
+}
+
+void
+ckh_buckets_of(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	int					buckets[2]
+) {
+	uint32_t count = (uint32_t) cuckoo_hash->header.bucket_count;
+
+	buckets[0]	= (int) (dictionary_hash_key(cuckoo_hash->super.key_type, key, cuckoo_hash->super.record.key_size, cuckoo_hash->seed) % count);
+	buckets[1]	= (int) (dictionary_hash_key(cuckoo_hash->super.key_type, key, cuckoo_hash->super.record.key_size, cuckoo_hash->seed ^ ION_CKH_SECOND_SEED) % count);
+
+	/* a key with one page could never be moved out of it */
+	if ((buckets[0] == buckets[1]) && (1 < count)) {
+		buckets[1] = (int) ((buckets[0] + 1) % count);
+	}
+}
+
+ion_byte_t *
+ckh_read_page(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	int					bucket
+) {
+	if ((0 != fseek(cuckoo_hash->file, ((long) bucket + 1) * cuckoo_hash->header.page_size, SEEK_SET)) || (1 != fread(cuckoo_hash->page, cuckoo_hash->header.page_size, 1, cuckoo_hash->file))) {
+		return NULL;
+	}
+
+	return cuckoo_hash->page;
+}
+
+ion_byte_t *
+ckh_page_slot(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_byte_t			*page,
+	int					slot
+) {
+	return page + slot * cuckoo_hash->record_size;
+}
+
+ion_err_t
+ckh_find_position(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_ckh_position_t	*position
+) {
+	int			buckets[2];
+	int			i;
+	ion_byte_t	*page;
+	int			slot;
+
+	ckh_buckets_of(cuckoo_hash, key, buckets);
+
+	for (i = 0; i < 2; i++) {
+		if ((1 == i) && (buckets[1] == buckets[0])) {
+			break;
+		}
+
+		if (NULL == (page = ckh_read_page(cuckoo_hash, buckets[i]))) {
+			return err_file_read_error;
+		}
+
+		for (slot = 0; slot < cuckoo_hash->records_per_page; slot++) {
+			ion_byte_t *record = ckh_page_slot(cuckoo_hash, page, slot);
+
+			if ((ION_CKH_IN_USE == *record) && (0 == cuckoo_hash->super.compare(record + 1, key, cuckoo_hash->super.record.key_size))) {
+				position->bucket	= buckets[i];
+				position->slot		= slot;
+				return err_ok;
+			}
+		}
+	}
+
+	return err_item_not_found;
+}
+
+ion_status_t
+ckh_insert(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_ckh_position_t	room = { 0, -1 };
+	int					buckets[2];
+	int					i;
+	ion_byte_t			*page;
+	ion_err_t			err;
+	int					slot;
+
+	ckh_buckets_of(cuckoo_hash, key, buckets);
+
+	/* read both pages, both for a record to replace and for room */
+	for (i = 0; i < 2; i++) {
+		if ((1 == i) && (buckets[1] == buckets[0])) {
+			break;
+		}
+
+		if (NULL == (page = ckh_read_page(cuckoo_hash, buckets[i]))) {
+			return ION_STATUS_ERROR(err_file_read_error);
+		}
+
+		for (slot = 0; slot < cuckoo_hash->records_per_page; slot++) {
+			ion_byte_t *record = ckh_page_slot(cuckoo_hash, page, slot);
+
+			if (ION_CKH_IN_USE != *record) {
+				if (-1 == room.slot) {
+					room.bucket = buckets[i];
+					room.slot	= slot;
+				}
+			}
+			else if (0 == cuckoo_hash->super.compare(record + 1, key, cuckoo_hash->super.record.key_size)) {
+				if (wc_update != cuckoo_hash->write_concern) {
+					return ION_STATUS_ERROR(err_duplicate_key);
+				}
+
+				if (err_ok != (err = ckh_write(cuckoo_hash, buckets[i], slot, 1 + cuckoo_hash->super.record.key_size, value, cuckoo_hash->super.record.value_size))) {
+					return ION_STATUS_ERROR(err);
+				}
+
+				return ION_STATUS_OK(1);
+			}
+		}
+	}
+
+	if ((-1 == room.slot) && (err_ok != (err = ckh_make_room(cuckoo_hash, buckets, &room)))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	cuckoo_hash->record[0] = ION_CKH_IN_USE;
+	memcpy(cuckoo_hash->record + 1, key, cuckoo_hash->super.record.key_size);
+	memcpy(cuckoo_hash->record + 1 + cuckoo_hash->super.record.key_size, value, cuckoo_hash->super.record.value_size);
+
+	if (err_ok != (err = ckh_write(cuckoo_hash, room.bucket, room.slot, 0, cuckoo_hash->record, cuckoo_hash->record_size))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	cuckoo_hash->header.record_count++;
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+ckh_update(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_write_concern_t current_write_concern = cuckoo_hash->write_concern;
+
+	cuckoo_hash->write_concern = wc_update;
+
+	ion_status_t status = ckh_insert(cuckoo_hash, key, value);
+
+	cuckoo_hash->write_concern = current_write_concern;
+	return status;
+}
+
+ion_status_t
+ckh_query(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_ckh_position_t	position;
+	ion_err_t			err = ckh_find_position(cuckoo_hash, key, &position);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	memcpy(value, ckh_page_slot(cuckoo_hash, cuckoo_hash->page, position.slot) + 1 + cuckoo_hash->super.record.key_size, cuckoo_hash->super.record.value_size);
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+ckh_delete(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key
+) {
+	ion_ckh_position_t	position;
+	ion_byte_t			status	= ION_CKH_EMPTY;
+	ion_err_t			err		= ckh_find_position(cuckoo_hash, key, &position);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	/* both pages are always read, so the slot needs no tombstone */
+	if (err_ok != (err = ckh_write(cuckoo_hash, position.bucket, position.slot, 0, &status, 1))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	cuckoo_hash->header.record_count--;
+	return ION_STATUS_OK(1);
+}
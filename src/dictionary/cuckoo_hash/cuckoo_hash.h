@@ -0,0 +1,352 @@
+/******************************************************************************/
+/**
+@file
+@brief		A file based hash table using bucketized cuckoo hashing, so
+			that any lookup reads at most two pages.
+@details	Records live in fixed size pages of slots. Every key has two
+			candidate pages, picked by two independent hashes, and is
+			always in one of them. An insert into two full pages moves a
+			record out of one of them to its other page, and so on along a
+			path of at most @ref ION_CKH_MAX_KICKS displacements; the path
+			is found before anything is moved, so an insert that finds
+			none leaves the table as it was. With several slots per page,
+			tables stay insertable to around @ref ION_CKH_LOAD_PERCENT
+			full, the load they are sized for.
+*/
+/******************************************************************************/
+
+#if !defined(CUCKOO_HASH_H_)
+#define CUCKOO_HASH_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdio.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+/*edefines file operations for arduino */
+#include "./../../file/SD_stdio_c_iface.h"
+
+/**
+@brief		The size in bytes of a bucket page, used when the dictionary
+			is created with a page size of 0. More slots per page let the
+			table fill further before inserts fail.
+*/
+#if !defined(ION_CKH_DEFAULT_PAGE_SIZE)
+#if defined(ARDUINO)
+#define ION_CKH_DEFAULT_PAGE_SIZE 128
+#else
+#define ION_CKH_DEFAULT_PAGE_SIZE 512
+#endif
+#endif
+
+/**
+@brief		How full, in percent of its slots, a new table is sized to be
+			once it holds the number of records it was created for.
+*/
+#if !defined(ION_CKH_LOAD_PERCENT)
+#define ION_CKH_LOAD_PERCENT 90
+#endif
+
+/**
+@brief		The most records an insert displaces to make room, each
+			costing a page read, before it gives up with
+			@c err_max_capacity.
+*/
+#if !defined(ION_CKH_MAX_KICKS)
+#if defined(ARDUINO)
+#define ION_CKH_MAX_KICKS 16
+#else
+#define ION_CKH_MAX_KICKS 64
+#endif
+#endif
+
+/**
+@brief		The status byte of a free record slot.
+*/
+#define ION_CKH_EMPTY	0
+
+/**
+@brief		The status byte of a slot holding a record.
+*/
+#define ION_CKH_IN_USE	1
+
+/**
+@brief		The state of a cuckoo hash table, kept at the start of its
+			file.
+*/
+typedef struct {
+	int32_t key_size;		/**< The size of the keys stored */
+	int32_t value_size;		/**< The size of the values stored */
+	int32_t page_size;		/**< The size in bytes of every page */
+	int32_t bucket_count;	/**< The bucket pages in the table */
+	int32_t record_count;	/**< The records in the table */
+} ion_ckh_header_t;
+
+/**
+@brief		A slot of a bucket page.
+*/
+typedef struct {
+	int bucket;	/**< The bucket page holding the slot */
+	int slot;	/**< The slot within the page */
+} ion_ckh_position_t;
+
+/**
+@brief		Struct used to maintain an instance of a cuckoo hash table.
+*/
+typedef struct cuckoo_hash {
+	ion_dictionary_parent_t super;
+	ion_write_concern_t		write_concern;		/**< The current @p write_concern
+												 level of the table */
+	uint32_t				seed;				/**< The seed given to the
+												 first hash, taken from the
+												 dictionary id */
+	uint32_t				victim;				/**< The state picking which
+												 record an insert displaces */
+	ion_ckh_header_t		header;				/**< The state of the table,
+												 written back to its file */
+	int						record_size;		/**< The bytes of a slot: status,
+												 key and value */
+	int						records_per_page;	/**< The slots of a page */
+	FILE					*file;				/**< The header and the bucket
+												 pages */
+	ion_byte_t				*page;				/**< The page last read,
+												 allocated once so operations
+												 never allocate */
+	ion_byte_t				*record;			/**< A slot's worth of room, for
+												 the record being moved */
+} ion_cuckoo_hash_t;
+
+/**
+@brief		Opens a cuckoo hash table, creating its file if it does not
+			exist yet.
+
+@details	A table found on disk keeps its own page size and buckets;
+			those given here are only used to create a new one. Its key
+			and value sizes must match those given.
+
+@param		cuckoo_hash
+				The table to initialize.
+@param		id
+				The id of the dictionary, which names the file and seeds
+				the hashes.
+@param		key_type
+				The type of key that is being stored in the table.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		size
+				The number of records the table is sized for, at
+				@ref ION_CKH_LOAD_PERCENT of its slots.
+@param		page_size
+				The size in bytes of each page, 0 for
+				@ref ION_CKH_DEFAULT_PAGE_SIZE.
+@return		The status of the initialization.
+*/
+ion_err_t
+ckh_initialize(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_dictionary_id_t id,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					size,
+	int					page_size
+);
+
+/**
+@brief		Writes the state of a table to its file and pushes it through
+			to storage.
+
+@param		cuckoo_hash
+				The table to sync.
+@return		The status of the sync.
+*/
+ion_err_t
+ckh_sync(
+	ion_cuckoo_hash_t *cuckoo_hash
+);
+
+/**
+@brief		Writes the state of a table to its file and closes it.
+
+@param		cuckoo_hash
+				The table to close.
+@return		The status of the close.
+*/
+ion_err_t
+ckh_close(
+	ion_cuckoo_hash_t *cuckoo_hash
+);
+
+/**
+@brief		Closes a table and deletes its file.
+
+@param		cuckoo_hash
+				The table to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+ckh_destroy(
+	ion_cuckoo_hash_t *cuckoo_hash
+);
+
+/**
+@brief		Inserts a record, or replaces its value when the write
+			concern is @c wc_update.
+
+@details	If both pages of the key are full, records are displaced to
+			their other pages to make room.
+
+@param		cuckoo_hash
+				The table to insert into.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		The status of the insert, @c err_max_capacity if no room
+			could be made.
+*/
+ion_status_t
+ckh_insert(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@param		cuckoo_hash
+				The table to update.
+@param		key
+				The key of the record.
+@param		value
+				The new value of the record.
+@return		The status of the update.
+*/
+ion_status_t
+ckh_update(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value stored under a key.
+
+@param		cuckoo_hash
+				The table to search.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value of the record.
+@return		The status of the query.
+*/
+ion_status_t
+ckh_query(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Deletes the record stored under a key.
+
+@param		cuckoo_hash
+				The table to delete from.
+@param		key
+				The key of the record.
+@return		The status of the deletion.
+*/
+ion_status_t
+ckh_delete(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key
+);
+
+/**
+@brief		Returns the two bucket pages a key may be stored in.
+
+@details	The pages differ whenever the table has more than one.
+
+@param		cuckoo_hash
+				The table the key is stored in.
+@param		key
+				The key.
+@param		buckets
+				Receives the two buckets.
+*/
+void
+ckh_buckets_of(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	int					buckets[2]
+);
+
+/**
+@brief		Finds the slot holding a key, reading at most its two pages.
+
+@param		cuckoo_hash
+				The table to search.
+@param		key
+				The key to search for.
+@param		position
+				Receives the slot of the record, whose page is left in the
+				page buffer.
+@return		@c err_ok, @c err_item_not_found, or the error reading the
+			table.
+*/
+ion_err_t
+ckh_find_position(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_key_t			key,
+	ion_ckh_position_t	*position
+);
+
+/**
+@brief		Reads a bucket page into the page buffer of a table.
+
+@param		cuckoo_hash
+				The table to read.
+@param		bucket
+				The bucket to read.
+@return		The page, valid until the next call into the table, or
+			@c NULL if it could not be read.
+*/
+ion_byte_t *
+ckh_read_page(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	int					bucket
+);
+
+/**
+@brief		Returns a slot of a page.
+
+@param		cuckoo_hash
+				The table the page belongs to.
+@param		page
+				The page, as returned by @ref ckh_read_page.
+@param		slot
+				The slot.
+@return		The status byte of the slot, followed by its key and value.
+*/
+ion_byte_t *
+ckh_page_slot(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	ion_byte_t			*page,
+	int					slot
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CUCKOO_HASH_H_ */
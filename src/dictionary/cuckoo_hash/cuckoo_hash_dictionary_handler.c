@@ -0,0 +1,370 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a file based hash table using bucketized
+			cuckoo hashing.
+*/
+/******************************************************************************/
+
+#include "cuckoo_hash_dictionary_handler.h"
+
+/**
+@brief		Moves a cursor from its position to the next record that
+			satisfies its predicate, which is left in the page buffer of
+			the table.
+@return		@c cs_valid_data, or @c cs_end_of_results once the cursor is
+			past the last bucket.
+*/
+static ion_cursor_status_t
+ckhdict_scan(
+	ion_ckhdict_cursor_t *cursor
+) {
+	ion_cuckoo_hash_t	*cuckoo_hash	= (ion_cuckoo_hash_t *) cursor->super.dictionary->instance;
+	ion_ckh_position_t	*position		= &cursor->position;
+	ion_byte_t			*page;
+
+	for (; position->bucket < cuckoo_hash->header.bucket_count; position->bucket++, position->slot = 0) {
+		if (NULL == (page = ckh_read_page(cuckoo_hash, position->bucket))) {
+			return cs_end_of_results;
+		}
+
+		for (; position->slot < cuckoo_hash->records_per_page; position->slot++) {
+			ion_byte_t *record = ckh_page_slot(cuckoo_hash, page, position->slot);
+
+			if ((ION_CKH_IN_USE == *record) && (boolean_true == test_record_predicate(&cursor->super, record + 1, record + 1 + cuckoo_hash->super.record.key_size))) {
+				return cs_valid_data;
+			}
+		}
+	}
+
+	return cs_end_of_results;
+}
+
+ion_cursor_status_t
+ckhdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_ckhdict_cursor_t	*ckhdict_cursor = (ion_ckhdict_cursor_t *) cursor;
+	ion_cuckoo_hash_t		*cuckoo_hash	= (ion_cuckoo_hash_t *) cursor->dictionary->instance;
+	ion_byte_t				*page			= cuckoo_hash->page;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	if (cs_cursor_initialized == cursor->status) {
+		/* the record was found by the find, but the table may have been used since */
+		if (NULL == (page = ckh_read_page(cuckoo_hash, ckhdict_cursor->position.bucket))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active == cursor->status) {
+		/* keys are unique, so an equality cursor has nothing past its first record */
+		if (predicate_equality == cursor->predicate->type) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		ckhdict_cursor->position.slot++;
+
+		if (cs_end_of_results == ckhdict_scan(ckhdict_cursor)) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else {
+		return cs_invalid_cursor;
+	}
+
+	ion_byte_t *slot = ckh_page_slot(cuckoo_hash, page, ckhdict_cursor->position.slot);
+
+	memcpy(record->key, slot + 1, cuckoo_hash->super.record.key_size);
+	memcpy(record->value, slot + 1 + cuckoo_hash->super.record.key_size, cuckoo_hash->super.record.value_size);
+
+	return cursor->status;
+}
+
+ion_err_t
+ckhdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_cuckoo_hash_t		*cuckoo_hash	= (ion_cuckoo_hash_t *) dictionary->instance;
+	ion_key_size_t			key_size		= cuckoo_hash->super.record.key_size;
+	ion_ckhdict_cursor_t	*ckhdict_cursor;
+	ion_cursor_status_t		status;
+
+	if (NULL == (ckhdict_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_ckhdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	*cursor							= (ion_dict_cursor_t *) ckhdict_cursor;
+	(*cursor)->dictionary			= dictionary;
+	(*cursor)->status				= cs_cursor_uninitialized;
+	(*cursor)->destroy				= ckhdict_destroy_cursor;
+	(*cursor)->next_batch			= NULL;
+	(*cursor)->next					= ckhdict_next;
+
+	ckhdict_cursor->position.bucket = 0;
+	ckhdict_cursor->position.slot	= 0;
+
+	if (NULL == ((*cursor)->predicate = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			/* the predicate may be destroyed while the cursor is open, so keep a copy of its key */
+			if (NULL == ((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+
+			/* only the two pages of the key can hold it */
+			status				= (err_ok == ckh_find_position(cuckoo_hash, predicate->statement.equality.equality_value, &ckhdict_cursor->position)) ? cs_cursor_initialized : cs_end_of_results;
+			(*cursor)->status	= status;
+			return err_ok;
+		}
+
+		case predicate_range: {
+			if (NULL == ((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			if (NULL == ((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			break;
+		}
+
+		case predicate_predicate: {
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			break;
+		}
+
+		case predicate_all_records: {
+			break;
+		}
+
+		default: {
+			ion_free((*cursor)->predicate);
+			ion_free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	(*cursor)->status = (cs_valid_data == ckhdict_scan(ckhdict_cursor)) ? cs_cursor_initialized : cs_end_of_results;
+
+	return err_ok;
+}
+
+/**
+@brief		Creates, or opens, the cuckoo hash instance of a dictionary.
+
+@param		page_size
+				The size of the pages of a new table, 0 for the default.
+
+@see		ckhdict_create_dictionary for the other parameters.
+*/
+static ion_err_t
+ckhdict_open_table(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_size_t		page_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_cuckoo_hash_t	*cuckoo_hash;
+	ion_err_t			err;
+
+	if (NULL == (cuckoo_hash = ion_alloc(ion_alloc_other, sizeof(ion_cuckoo_hash_t)))) {
+		return err_out_of_memory;
+	}
+
+	cuckoo_hash->super.compare = compare;
+
+	err = ckh_initialize(cuckoo_hash, id, key_type, key_size, value_size, dictionary_size, page_size);
+
+	if (err_ok != err) {
+		ion_free(cuckoo_hash);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) cuckoo_hash;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_err_t
+ckhdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return ckhdict_open_table(id, key_type, key_size, value_size, dictionary_size, 0, compare, handler, dictionary);
+}
+
+ion_err_t
+ckhdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return ckhdict_open_table(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, config->page_size, compare, handler, dictionary);
+}
+
+ion_err_t
+ckhdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = ckh_close((ion_cuckoo_hash_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_err_t
+ckhdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = ckh_destroy((ion_cuckoo_hash_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+ckhdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return ckh_insert((ion_cuckoo_hash_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+ckhdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return ckh_query((ion_cuckoo_hash_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+ckhdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return ckh_update((ion_cuckoo_hash_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+ckhdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return ckh_delete((ion_cuckoo_hash_t *) dictionary->instance, key);
+}
+
+void
+ckhdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+/**
+@brief		Pushes every write of a cuckoo hash dictionary through to storage.
+*/
+static ion_err_t
+ckhdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return ckh_sync((ion_cuckoo_hash_t *) dictionary->instance);
+}
+
+/**
+@brief		Tells the size of a cuckoo hash dictionary, see
+			@ref dictionary_get_info. Its bucket pages are its pages.
+*/
+static ion_err_t
+ckhdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_cuckoo_hash_t *cuckoo_hash = (ion_cuckoo_hash_t *) dictionary->instance;
+
+	info->record_count	= cuckoo_hash->header.record_count;
+	info->pages			= cuckoo_hash->header.bucket_count;
+	info->file_bytes	= ((long) cuckoo_hash->header.bucket_count + 1) * cuckoo_hash->header.page_size;
+	info->memory_bytes	= cuckoo_hash->header.page_size + cuckoo_hash->record_size;
+
+	return err_ok;
+}
+
+void
+ckhdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= ckhdict_insert;
+	handler->create_dictionary	= ckhdict_create_dictionary;
+	handler->get				= ckhdict_query;
+	handler->update				= ckhdict_update;
+	handler->find				= ckhdict_find;
+	handler->remove				= ckhdict_delete;
+	handler->delete_dictionary	= ckhdict_delete_dictionary;
+	handler->open_dictionary	= ckhdict_open_dictionary;
+	handler->close_dictionary	= ckhdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= ckhdict_sync_dictionary;
+	handler->get_info			= ckhdict_get_info;
+	handler->bulk_load			= NULL;
+}
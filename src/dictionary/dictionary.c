@@ -21,9 +21,294 @@
 */
 /******************************************************************************/
 
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "dictionary.h"
 #include "flat_file/flat_file_dictionary_handler.h"
 
+/**
+@brief		The clock, in milliseconds, that the group interval of
+			@ref durability_group is measured with. It may be defined to
+			another, for example as @c millis() on Arduino; without a
+			definition Arduino builds group by count only.
+*/
+#if !defined(ION_DURABILITY_CLOCK)
+#if defined(ARDUINO)
+#define ION_DURABILITY_CLOCK() 0
+#else
+#include <time.h>
+#define ION_DURABILITY_CLOCK() dictionary_durability_clock()
+
+/**
+@brief		Milliseconds of the monotonic clock.
+*/
+static unsigned long
+dictionary_durability_clock(
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long) now.tv_sec * 1000UL + (unsigned long) now.tv_nsec / 1000000UL;
+}
+
+#endif
+#endif
+
+/**
+@brief		Gives a dictionary being created or opened the default
+			durability, if it has anything to push.
+*/
+static void
+dictionary_durability_init(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	dictionary->durability.level		= (NULL == handler->sync_dictionary) ? durability_none : ION_DEFAULT_DURABILITY;
+	dictionary->durability.group_ops	= 0;
+	dictionary->durability.group_ms		= 0;
+	dictionary->durability.pending		= 0;
+	dictionary->durability.since		= ION_DURABILITY_CLOCK();
+}
+
+/**
+@brief		An open dictionary, for @ref dictionary_sync_all and
+			@ref dictionary_get_info_all.
+@details	Only the instances are kept, never read but to push them or
+			ask them of their size, so one done away with other than
+			through this interface is harmless until then.
+*/
+typedef struct dictionary_open {
+	ion_dictionary_parent_t *instance;	/**< Its instance */
+	ion_dictionary_id_t		id;			/**< Its ID, so those asked of
+										 need not be read to be found */
+	ion_err_t (*sync)(
+		ion_dictionary_t *
+	);
+	/**< The sync of the handler it was opened with, or NULL if it keeps
+		 nothing in storage */
+	ion_err_t (*info)(
+		ion_dictionary_t *,
+		ion_dictionary_info_t *
+	);
+	/**< The get_info of that handler, or NULL */
+	ion_err_t (*close)(
+		ion_dictionary_t *
+	);
+	/**< The close of that handler, which those sharing its instance under
+		 another do not close it with */
+	struct dictionary_open *next;	/**< The next opened before it */
+} ion_dictionary_open_t;
+
+/**
+@brief		The open dictionaries, most recently opened first, so those
+			wrapping others come before them.
+*/
+static ion_dictionary_open_t *dictionary_opens = NULL;
+
+/**
+@brief		Takes and gives up the lock on the open dictionaries, so they
+			may be opened and closed from several threads.
+*/
+#if defined(ARDUINO)
+#define ION_DICTIONARY_OPENS_LOCK()
+#define ION_DICTIONARY_OPENS_UNLOCK()
+#else
+#include <pthread.h>
+
+static pthread_mutex_t dictionary_opens_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define ION_DICTIONARY_OPENS_LOCK()		pthread_mutex_lock(&dictionary_opens_lock)
+#define ION_DICTIONARY_OPENS_UNLOCK()	pthread_mutex_unlock(&dictionary_opens_lock)
+#endif
+
+/**
+@brief		Takes a dictionary being closed or deleted out of the open
+			dictionaries, unless it shares the instance of one under
+			another handler.
+*/
+static void
+dictionary_closing(
+	ion_dictionary_t *dictionary
+) {
+	ion_dictionary_open_t	**link;
+	ion_dictionary_open_t	*open;
+
+	ION_DICTIONARY_OPENS_LOCK();
+
+	for (link = &dictionary_opens; (NULL != *link) && ((*link)->instance != dictionary->instance); link = &(*link)->next) {}
+
+	open = *link;
+
+	if ((NULL != open) && (open->close == dictionary->handler->close_dictionary)) {
+		*link = open->next;
+		ion_free(open);
+	}
+
+	ION_DICTIONARY_OPENS_UNLOCK();
+}
+
+/**
+@brief		Counts writes made to a dictionary against its durability,
+			pushing them as it asks.
+
+@param		dictionary
+				The dictionary written to.
+@param		status
+				The status of the writes, whose error is set if they could
+				not be pushed.
+@param		count
+				The number of records they changed.
+*/
+static void
+dictionary_durability_wrote(
+	ion_dictionary_t	*dictionary,
+	ion_status_t		*status,
+	int					count
+) {
+	ion_dictionary_durability_t *durability = &dictionary->durability;
+	ion_err_t					err;
+
+	if ((durability_none == durability->level) || (count <= 0)) {
+		return;
+	}
+
+	durability->pending += count;
+
+	if (durability_close == durability->level) {
+		return;
+	}
+
+	if ((durability_group == durability->level) && ((0 == durability->group_ops) || (durability->pending < durability->group_ops)) && ((0 == durability->group_ms) || (ION_DURABILITY_CLOCK() - durability->since < durability->group_ms))) {
+		return;
+	}
+
+	err = dictionary_sync(dictionary);
+
+	if ((err_ok == status->error) && (err_ok != err)) {
+		status->error = err;
+	}
+}
+
+#if ION_DICTIONARY_STATS
+
+/**
+@brief		The clock the operation counters time with. It may be defined
+			to another, for example as @c micros() on Arduino; without a
+			definition Arduino builds count operations only.
+*/
+#if !defined(ION_DICTIONARY_CLOCK)
+#if defined(ARDUINO)
+#define ION_DICTIONARY_CLOCK() 0
+#else
+#include <time.h>
+#define ION_DICTIONARY_CLOCK() dictionary_clock()
+
+/**
+@brief		Microseconds of the monotonic clock, which unlike @c clock()
+			goes on while an operation waits on its files.
+*/
+static unsigned long
+dictionary_clock(
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long) now.tv_sec * 1000000UL + (unsigned long) now.tv_nsec / 1000UL;
+}
+
+#endif
+#endif
+
+/**
+@brief		Adds an operation to the counters of a dictionary.
+
+@param		dictionary
+				The dictionary, which keeps counters.
+@param		op
+				The kind of operation.
+@param		start
+				The clock when the operation began.
+@param		failed
+				Whether the operation failed.
+@param		count
+				The number of records it touched.
+*/
+static void
+dictionary_stats_record(
+	ion_dictionary_t	*dictionary,
+	ion_dictionary_op_t op,
+	unsigned long		start,
+	ion_boolean_t		failed,
+	int					count
+) {
+	ion_dictionary_op_stats_t	*stats	= &dictionary->stats->ops[op];
+	unsigned long				ticks	= ION_DICTIONARY_CLOCK() - start;
+	int							bucket	= 0;
+
+	stats->calls++;
+	stats->ticks += ticks;
+
+	if (failed) {
+		stats->errors++;
+	}
+
+	if (count > 0) {
+		stats->bytes += (unsigned long) count * (dictionary->instance->record.key_size + dictionary->instance->record.value_size);
+	}
+
+	while (0 != ticks && bucket < ION_DICTIONARY_STATS_BUCKETS - 1) {
+		ticks >>= 1;
+		bucket++;
+	}
+
+	stats->latency[bucket]++;
+}
+
+/**
+@brief		Reads the clock if @p dictionary keeps counters, to begin
+			timing an operation on it.
+*/
+#define ION_STATS_BEGIN(dictionary) \
+	unsigned long ion_stats_start = (NULL != (dictionary)->stats) ? ION_DICTIONARY_CLOCK() : 0
+
+/**
+@brief		Counts an operation begun with @ref ION_STATS_BEGIN, if
+			@p dictionary keeps counters. A key that is not there does not
+			fail it.
+*/
+#define ION_STATS_END(dictionary, op, error, count) \
+	if (NULL != (dictionary)->stats) { \
+		dictionary_stats_record((dictionary), (op), ion_stats_start, (err_ok != (error)) && (err_item_not_found != (error)), (count)); \
+	}
+
+#else
+
+#define ION_STATS_BEGIN(dictionary)
+#define ION_STATS_END(dictionary, op, error, count)
+
+#endif
+
+/**
+@brief		Begins an operation on @p dictionary: charges the memory its
+			engine allocates to the dictionary's account, and begins timing
+			it if it keeps counters.
+*/
+#define ION_OP_BEGIN(dictionary) \
+	ion_alloc_account_t ion_op_outer = ion_alloc_enter((dictionary)->alloc_account); \
+	ION_STATS_BEGIN(dictionary)
+
+/**
+@brief		Ends an operation begun with @ref ION_OP_BEGIN.
+*/
+#define ION_OP_END(dictionary, op, error, count) \
+	ion_alloc_leave(ion_op_outer); \
+	ION_STATS_END(dictionary, op, error, count)
+
+
 int
 dictionary_get_filename(
 	ion_dictionary_id_t id,
@@ -50,7 +335,10 @@ dictionary_compare_char_array(
 	ion_key_t		second_key,
 	ion_key_size_t	key_size
 ) {
-	return strncmp((char *) first_key, (char *) second_key, key_size);
+	/* only the sign, as a difference of bytes above 0x7F does not fit the char returned */
+	int result = strncmp((char *) first_key, (char *) second_key, key_size);
+
+	return (result > 0) - (result < 0);
 }
 
 /**
@@ -69,23 +357,115 @@ dictionary_compare_null_terminated_string(
 	ion_key_t		second_key,
 	ion_key_size_t	key_size
 ) {
-	return strncmp((char *) first_key, (char *) second_key, key_size);
+	/* the sign alone, as for char arrays */
+	int result = strncmp((char *) first_key, (char *) second_key, key_size);
+
+	return (result > 0) - (result < 0);
+}
+
+/**
+@brief		Defines a comparator of numeric keys of one native type.
+@details	The keys are copied out rather than read in place, since a key
+			within a record or a page has no alignment to speak of. Such a
+			copy compiles to a single load where unaligned ones are allowed.
+*/
+#define ION_DEFINE_NATIVE_COMPARE(name, type) \
+	static char \
+	name( \
+		ion_key_t		first_key, \
+		ion_key_t		second_key, \
+		ion_key_size_t	key_size \
+	) { \
+		type	first; \
+		type	second; \
+ \
+		UNUSED(key_size); \
+		memcpy(&first, first_key, sizeof(type)); \
+		memcpy(&second, second_key, sizeof(type)); \
+ \
+		return (first > second) - (first < second); \
+	}
+
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_signed_8, int8_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_signed_16, int16_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_signed_32, int32_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_signed_64, int64_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_unsigned_8, uint8_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_unsigned_16, uint16_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_unsigned_32, uint32_t)
+ION_DEFINE_NATIVE_COMPARE(dictionary_compare_unsigned_64, uint64_t)
+
+ion_boolean_t
+dictionary_is_signed_compare(
+	ion_dictionary_compare_t compare
+) {
+	return (dictionary_compare_signed_value == compare) || (dictionary_compare_signed_8 == compare) || (dictionary_compare_signed_16 == compare) || (dictionary_compare_signed_32 == compare) || (dictionary_compare_signed_64 == compare);
+}
+
+ion_boolean_t
+dictionary_is_unsigned_compare(
+	ion_dictionary_compare_t compare
+) {
+	return (dictionary_compare_unsigned_value == compare) || (dictionary_compare_unsigned_8 == compare) || (dictionary_compare_unsigned_16 == compare) || (dictionary_compare_unsigned_32 == compare) || (dictionary_compare_unsigned_64 == compare);
 }
 
 ion_dictionary_compare_t
 dictionary_switch_compare(
-	ion_key_type_t key_type
+	ion_key_type_t	key_type,
+	ion_key_size_t	key_size
 ) {
-	ion_dictionary_compare_t compare;
+	ion_dictionary_compare_t compare = NULL;
 
 	switch (key_type) {
 		case key_type_numeric_signed: {
-			compare = dictionary_compare_signed_value;
+			switch (key_size) {
+				case sizeof(int8_t):
+					compare = dictionary_compare_signed_8;
+					break;
+
+				case sizeof(int16_t):
+					compare = dictionary_compare_signed_16;
+					break;
+
+				case sizeof(int32_t):
+					compare = dictionary_compare_signed_32;
+					break;
+
+				case sizeof(int64_t):
+					compare = dictionary_compare_signed_64;
+					break;
+
+				default:
+					compare = dictionary_compare_signed_value;
+					break;
+			}
+
 			break;
 		}
 
 		case key_type_numeric_unsigned: {
-			compare = dictionary_compare_unsigned_value;
+			switch (key_size) {
+				case sizeof(uint8_t):
+					compare = dictionary_compare_unsigned_8;
+					break;
+
+				case sizeof(uint16_t):
+					compare = dictionary_compare_unsigned_16;
+					break;
+
+				case sizeof(uint32_t):
+					compare = dictionary_compare_unsigned_32;
+					break;
+
+				case sizeof(uint64_t):
+					compare = dictionary_compare_unsigned_64;
+					break;
+
+				default:
+					compare = dictionary_compare_unsigned_value;
+					break;
+			}
+
 			break;
 		}
 
@@ -108,6 +488,54 @@ dictionary_switch_compare(
 	return compare;
 }
 
+uint32_t
+dictionary_hash_key(
+	ion_key_type_t	key_type,
+	ion_key_t		key,
+	ion_key_size_t	key_size,
+	uint32_t		seed
+) {
+	ion_byte_t	*bytes	= key;
+	size_t		length	= key_size;
+
+	if ((key_type_char_array == key_type) || (key_type_null_terminated_string == key_type)) {
+		ion_byte_t *end = memchr(bytes, '\0', length);
+
+		if (NULL != end) {
+			length = end - bytes;
+		}
+	}
+
+	return dictionary_hash_bytes(bytes, length, seed);
+}
+
+void
+dictionary_hash_count_probes(
+	ion_hash_stats_t	*stats,
+	ion_hash_op_stats_t *op,
+	int					home,
+	int					probes,
+	int					size
+) {
+	int bin = 0;
+
+	while ((bin < ION_HASH_PROBE_BINS - 1) && ((probes >> (bin + 1)) > 0)) {
+		bin++;
+	}
+
+	op->calls++;
+	op->probes += probes;
+	op->histogram[bin]++;
+
+	if (probes > op->max_probes) {
+		op->max_probes = probes;
+	}
+
+	if (home + probes > size) {
+		stats->wraps++;
+	}
+}
+
 ion_err_t
 dictionary_create(
 	ion_dictionary_handler_t	*handler,
@@ -118,17 +546,46 @@ dictionary_create(
 	ion_value_size_t			value_size,
 	ion_dictionary_size_t		dictionary_size
 ) {
-	ion_err_t					err;
-	ion_dictionary_compare_t	compare = dictionary_switch_compare(key_type);
+	return dictionary_create_with_compare(handler, dictionary, id, key_type, key_size, value_size, dictionary_size, NULL);
+}
+
+ion_err_t
+dictionary_create_with_compare(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare
+) {
+	ion_err_t err;
+
+	if (NULL == compare) {
+		compare = dictionary_switch_compare(key_type, key_size);
+	}
+
+#if ION_DICTIONARY_STATS
+	dictionary->stats = NULL;
+#endif
+	dictionary_durability_init(handler, dictionary);
+	dictionary->alloc_account = ion_alloc_open_account(id);
+
+	ion_alloc_account_t outer = ion_alloc_enter(dictionary->alloc_account);
 
 	err = handler->create_dictionary(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary);
+	ion_alloc_leave(outer);
 
 	if (err_ok == err) {
 		dictionary->instance->id	= id;
 		dictionary->status			= ion_dictionary_status_ok;
+		dictionary_opened(dictionary);
 	}
 	else {
-		dictionary->status = ion_dictionary_status_error;
+		ion_alloc_close_account(dictionary->alloc_account);
+		dictionary->alloc_account	= ion_alloc_unattributed;
+		dictionary->status			= ion_dictionary_status_error;
 	}
 
 	return err;
@@ -140,7 +597,14 @@ dictionary_insert(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->insert(dictionary, key, value);
+	ION_OP_BEGIN(dictionary);
+
+	ion_status_t status = dictionary->handler->insert(dictionary, key, value);
+
+	dictionary_durability_wrote(dictionary, &status, status.count);
+	ION_OP_END(dictionary, dictionary_op_insert, status.error, status.count);
+
+	return status;
 }
 
 ion_status_t
@@ -149,100 +613,380 @@ dictionary_get(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->get(dictionary, key, value);
-}
+	ION_OP_BEGIN(dictionary);
 
-ion_status_t
-dictionary_update(
-	ion_dictionary_t	*dictionary,
-	ion_key_t			key,
-	ion_value_t			value
-) {
-	return dictionary->handler->update(dictionary, key, value);
+	ion_status_t status = dictionary->handler->get(dictionary, key, value);
+
+	ION_OP_END(dictionary, dictionary_op_get, status.error, status.count);
+
+	return status;
 }
 
-ion_err_t
-dictionary_delete_dictionary(
-	ion_dictionary_t *dictionary
+/**
+@brief		Adds the status of one record of a batch to the status of the
+			batch, and to @p statuses if there are any.
+*/
+static void
+dictionary_batch_add(
+	ion_status_t	*status,
+	ion_status_t	one,
+	ion_status_t	*statuses,
+	int				i
 ) {
-	return dictionary->handler->delete_dictionary(dictionary);
+	status->count += one.count;
+
+	if ((err_ok == status->error) && (err_ok != one.error)) {
+		status->error = one.error;
+	}
+
+	if (NULL != statuses) {
+		statuses[i] = one;
+	}
 }
 
 ion_status_t
-dictionary_delete(
+dictionary_get_many(
 	ion_dictionary_t	*dictionary,
-	ion_key_t			key
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
 ) {
-	return dictionary->handler->remove(dictionary, key);
-}
+	ion_status_t	status = ION_STATUS_OK(0);
+	ion_status_t	found;
+	int				i;
 
-char
-dictionary_compare_unsigned_value(
-	ion_key_t		first_key,
-	ion_key_t		second_key,
-	ion_key_size_t	key_size
-) {
-	int		idx;
-	char	return_value = 0x73;/* Magic default return value to be easy to spot */
+	ION_OP_BEGIN(dictionary);
 
-	/*
-	 * In this case, the endianness of the process does matter as the code does
-	 * a direct comparison of bytes in memory starting for MSB.
-	*/
-#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	if (NULL != dictionary->handler->get_many) {
+		status = dictionary->handler->get_many(dictionary, keys, values, statuses, count);
+		ION_OP_END(dictionary, dictionary_op_get, status.error, status.count);
+		return status;
+	}
 
-	for (idx = key_size - 1; idx >= 0; idx--) {
-#else
+	for (i = 0; i < count; i++) {
+		found = dictionary->handler->get(dictionary, (ion_byte_t *) keys + i * dictionary->instance->record.key_size, (ion_byte_t *) values + i * dictionary->instance->record.value_size);
+		dictionary_batch_add(&status, found, statuses, i);
+	}
 
-	/*@todo This is a potential issue and needs to be tested on SAMD3 */
-	for (idx = 0; idx < key_size; idx++) {
-#endif
+	ION_OP_END(dictionary, dictionary_op_get, status.error, status.count);
 
-		ion_byte_t	firstbyte	= *((ion_byte_t *) first_key + idx);
-		ion_byte_t	secondbyte	= *((ion_byte_t *) second_key + idx);
+	return status;
+}
 
-		if ((return_value = (firstbyte > secondbyte) - (firstbyte < secondbyte)) != ION_ZERO) {
-			return return_value;
-		}
+ion_status_t
+dictionary_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	if (NULL == dictionary->handler->get_ref) {
+		return ION_STATUS_ERROR(err_not_implemented);
 	}
 
-	return return_value;
+	ION_OP_BEGIN(dictionary);
+
+	ion_status_t status = dictionary->handler->get_ref(dictionary, key, value);
+
+	ION_OP_END(dictionary, dictionary_op_get, status.error, (err_ok == status.error) ? status.count : 0);
+
+	return status;
 }
 
-char
-dictionary_compare_signed_value(
-	ion_key_t		first_key,
-	ion_key_t		second_key,
-	ion_key_size_t	key_size
+ion_status_t
+dictionary_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
 ) {
-	int		idx;
-	char	return_value = 0x73;/* Magic default return value to be easy to spot TODO refactor out into macro */
-
-	/*
-	 * In this case, the endianness of the process does matter as the code does
-	 * a direct comparison of bytes in memory starting for MSB.
-	*/
+	ion_status_t	status = ION_STATUS_OK(0);
+	ion_status_t	inserted;
+	int				i;
 
-/* Start at the MSB */
-#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-	idx = key_size - 1;
-#else
-	idx = 0;
-#endif
+	ION_OP_BEGIN(dictionary);
 
-	ion_byte_t	firstbyte	= *((ion_byte_t *) first_key + idx);
-	ion_byte_t	secondbyte	= *((ion_byte_t *) second_key + idx);
+	if (NULL != dictionary->handler->insert_many) {
+		status = dictionary->handler->insert_many(dictionary, keys, values, statuses, count);
+		dictionary_durability_wrote(dictionary, &status, status.count);
+		ION_OP_END(dictionary, dictionary_op_insert, status.error, status.count);
+		return status;
+	}
 
-	/* Do bit comparison on the sign bit to do positive/negative comparison. Lets us exit early in many cases */
-	if ((return_value = (secondbyte >> 7) - (firstbyte >> 7)) != ION_ZERO) {
-		return return_value;
+	for (i = 0; i < count; i++) {
+		inserted = dictionary->handler->insert(dictionary, (ion_byte_t *) keys + i * dictionary->instance->record.key_size, (ion_byte_t *) values + i * dictionary->instance->record.value_size);
+		dictionary_batch_add(&status, inserted, statuses, i);
 	}
 
-/* In this case, we are of the same sign. Do byte-for-byte comparison. */
-#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	dictionary_durability_wrote(dictionary, &status, status.count);
+	ION_OP_END(dictionary, dictionary_op_insert, status.error, status.count);
 
-	for (; idx >= 0; idx--) {
-#else
+	return status;
+}
+
+/**
+@brief		The source of a bulk load, noting whether it was read from.
+*/
+typedef struct {
+	ion_dictionary_bulk_next_t	next;	/**< The caller's source. */
+	void						*context;	/**< Its context. */
+	ion_boolean_t				taken;	/**< Whether a record was asked for. */
+} ion_bulk_source_t;
+
+/**
+@brief		Asks the caller's source of a bulk load for the next record.
+*/
+static ion_err_t
+dictionary_bulk_next(
+	void			*context,
+	ion_record_t	*record
+) {
+	ion_bulk_source_t *source = context;
+
+	source->taken = boolean_true;
+	return source->next(source->context, record);
+}
+
+/**
+@brief		Loads records from a source by inserting them in batches.
+*/
+static ion_status_t
+dictionary_bulk_insert(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_bulk_next_t	next,
+	void						*context
+) {
+	ion_key_size_t		key_size	= dictionary->instance->record.key_size;
+	ion_value_size_t	value_size	= dictionary->instance->record.value_size;
+	ion_status_t		status		= ION_STATUS_OK(0);
+	ion_status_t		inserted;
+	ion_record_t		record;
+	ion_byte_t			*keys;
+	ion_byte_t			*values;
+	ion_err_t			err			= err_ok;
+	int					count;
+
+	keys	= ion_alloc(ion_alloc_buffer, ION_BULK_LOAD_BATCH * key_size);
+	values	= ion_alloc(ion_alloc_buffer, ION_BULK_LOAD_BATCH * value_size);
+
+	if ((NULL == keys) || (NULL == values)) {
+		ion_free(keys);
+		ion_free(values);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	while (err_ok == err) {
+		for (count = 0; count < ION_BULK_LOAD_BATCH; count++) {
+			record.key		= keys + count * key_size;
+			record.value	= values + count * value_size;
+
+			if (err_ok != (err = next(context, &record))) {
+				break;
+			}
+		}
+
+		if (0 != count) {
+			inserted		= dictionary_insert_many(dictionary, keys, values, NULL, count);
+			status.count	+= inserted.count;
+
+			if (err_ok != inserted.error) {
+				status.error = inserted.error;
+				break;
+			}
+		}
+	}
+
+	if ((err_ok == status.error) && (err_item_not_found != err)) {
+		status.error = err;
+	}
+
+	ion_free(keys);
+	ion_free(values);
+	return status;
+}
+
+ion_status_t
+dictionary_bulk_load(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_bulk_next_t	next,
+	void						*context
+) {
+	ion_bulk_source_t	source;
+	ion_status_t		status;
+
+	if (NULL == dictionary->handler->bulk_load) {
+		return dictionary_bulk_insert(dictionary, next, context);
+	}
+
+	source.next		= next;
+	source.context	= context;
+	source.taken	= boolean_false;
+
+	ION_OP_BEGIN(dictionary);
+
+	status = dictionary->handler->bulk_load(dictionary, dictionary_bulk_next, &source);
+	dictionary_durability_wrote(dictionary, &status, status.count);
+
+	ION_OP_END(dictionary, dictionary_op_insert, status.error, status.count);
+
+	/* refused before a record was taken, as a dictionary holding records is */
+	if ((err_illegal_state == status.error) && !source.taken) {
+		return dictionary_bulk_insert(dictionary, next, context);
+	}
+
+	return status;
+}
+
+ion_status_t
+dictionary_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ION_OP_BEGIN(dictionary);
+
+	ion_status_t status = dictionary->handler->update(dictionary, key, value);
+
+	dictionary_durability_wrote(dictionary, &status, status.count);
+	ION_OP_END(dictionary, dictionary_op_update, status.error, status.count);
+
+	return status;
+}
+
+ion_err_t
+dictionary_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	dictionary_closing(dictionary);
+
+	ion_alloc_account_t outer	= ion_alloc_enter(dictionary->alloc_account);
+	ion_err_t			err		= dictionary->handler->delete_dictionary(dictionary);
+
+	ion_alloc_leave(outer);
+	ion_alloc_close_account(dictionary->alloc_account);
+	dictionary->alloc_account = ion_alloc_unattributed;
+
+#if ION_DICTIONARY_STATS
+	dictionary_stats_disable(dictionary);
+#endif
+
+	return err;
+}
+
+ion_status_t
+dictionary_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ION_OP_BEGIN(dictionary);
+
+	ion_status_t status = dictionary->handler->remove(dictionary, key);
+
+	dictionary_durability_wrote(dictionary, &status, status.count);
+	ION_OP_END(dictionary, dictionary_op_delete, status.error, status.count);
+
+	return status;
+}
+
+ion_status_t
+dictionary_delete_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_status_t		*statuses,
+	int					count
+) {
+	ion_status_t	status = ION_STATUS_OK(0);
+	ion_status_t	deleted;
+	int				i;
+
+	ION_OP_BEGIN(dictionary);
+
+	if (NULL != dictionary->handler->delete_many) {
+		status = dictionary->handler->delete_many(dictionary, keys, statuses, count);
+		dictionary_durability_wrote(dictionary, &status, status.count);
+		ION_OP_END(dictionary, dictionary_op_delete, status.error, status.count);
+		return status;
+	}
+
+	for (i = 0; i < count; i++) {
+		deleted = dictionary->handler->remove(dictionary, (ion_byte_t *) keys + i * dictionary->instance->record.key_size);
+		dictionary_batch_add(&status, deleted, statuses, i);
+	}
+
+	dictionary_durability_wrote(dictionary, &status, status.count);
+	ION_OP_END(dictionary, dictionary_op_delete, status.error, status.count);
+
+	return status;
+}
+
+char
+dictionary_compare_unsigned_value(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	int		idx;
+	char	return_value = 0x73;/* Magic default return value to be easy to spot */
+
+	/*
+	 * In this case, the endianness of the process does matter as the code does
+	 * a direct comparison of bytes in memory starting for MSB.
+	*/
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+	for (idx = key_size - 1; idx >= 0; idx--) {
+#else
+
+	/*@todo This is a potential issue and needs to be tested on SAMD3 */
+	for (idx = 0; idx < key_size; idx++) {
+#endif
+
+		ion_byte_t	firstbyte	= *((ion_byte_t *) first_key + idx);
+		ion_byte_t	secondbyte	= *((ion_byte_t *) second_key + idx);
+
+		if ((return_value = (firstbyte > secondbyte) - (firstbyte < secondbyte)) != ION_ZERO) {
+			return return_value;
+		}
+	}
+
+	return return_value;
+}
+
+char
+dictionary_compare_signed_value(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	int		idx;
+	char	return_value = 0x73;/* Magic default return value to be easy to spot TODO refactor out into macro */
+
+	/*
+	 * In this case, the endianness of the process does matter as the code does
+	 * a direct comparison of bytes in memory starting for MSB.
+	*/
+
+/* Start at the MSB */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	idx = key_size - 1;
+#else
+	idx = 0;
+#endif
+
+	ion_byte_t	firstbyte	= *((ion_byte_t *) first_key + idx);
+	ion_byte_t	secondbyte	= *((ion_byte_t *) second_key + idx);
+
+	/* Do bit comparison on the sign bit to do positive/negative comparison. Lets us exit early in many cases */
+	if ((return_value = (secondbyte >> 7) - (firstbyte >> 7)) != ION_ZERO) {
+		return return_value;
+	}
+
+/* In this case, we are of the same sign. Do byte-for-byte comparison. */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+	for (; idx >= 0; idx--) {
+#else
 
 	/*@todo This is a potential issue and needs to be tested on SAMD3 */
 	for (; idx < key_size; idx++) {
@@ -258,13 +1002,22 @@ dictionary_compare_signed_value(
 	return return_value;
 }
 
-ion_err_t
-dictionary_open(
+/**
+@brief		Opens a dictionary for @ref dictionary_open, within the account
+			of its memory.
+*/
+static ion_err_t
+dictionary_open_engine(
 	ion_dictionary_handler_t		*handler,
 	ion_dictionary_t				*dictionary,
 	ion_dictionary_config_info_t	*config
 ) {
-	ion_dictionary_compare_t compare	= dictionary_switch_compare(config->type);
+	ion_dictionary_compare_t compare	= dictionary_switch_compare(config->type, config->key_size);
+
+#if ION_DICTIONARY_STATS
+	dictionary->stats = NULL;
+#endif
+	dictionary_durability_init(handler, dictionary);
 
 	ion_err_t error						= handler->open_dictionary(handler, dictionary, config, compare);
 
@@ -335,6 +1088,7 @@ dictionary_open(
 	if (err_ok == error) {
 		dictionary->status			= ion_dictionary_status_ok;
 		dictionary->instance->id	= config->id;
+		dictionary_opened(dictionary);
 	}
 	else {
 		dictionary->status = ion_dictionary_status_error;
@@ -344,13 +1098,48 @@ dictionary_open(
 }
 
 ion_err_t
-dictionary_close(
-	ion_dictionary_t *dictionary
+dictionary_open(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config
 ) {
-	if (ion_dictionary_status_closed == dictionary->status) {
-		return err_ok;
+	ion_alloc_account_t account = ion_alloc_open_account(config->id);
+	ion_alloc_account_t outer	= ion_alloc_enter(account);
+
+	dictionary->alloc_account = ion_alloc_unattributed;
+
+	ion_err_t error = dictionary_open_engine(handler, dictionary, config);
+
+	ion_alloc_leave(outer);
+
+	/* a dictionary rebuilt from a flat file was created, opening the account itself */
+	if (ion_alloc_unattributed != dictionary->alloc_account) {
+		ion_alloc_close_account(account);
+	}
+	else if (err_ok == error) {
+		dictionary->alloc_account = account;
+	}
+	else {
+		ion_alloc_close_account(account);
 	}
 
+	return error;
+}
+
+/**
+@brief		Closes a dictionary for @ref dictionary_close, within the
+			account of its memory.
+*/
+static ion_err_t
+dictionary_close_engine(
+	ion_dictionary_t *dictionary
+) {
+
+	/* closing may not push the writes all the way */
+	ion_err_t sync_error = (0 != dictionary->durability.pending) ? dictionary_sync(dictionary) : err_ok;
+
+	dictionary_closing(dictionary);
+
 	ion_err_t error = dictionary->handler->close_dictionary(dictionary);
 
 	if (err_not_implemented == error) {
@@ -419,6 +1208,30 @@ dictionary_close(
 
 	if (err_ok == error) {
 		dictionary->status = ion_dictionary_status_closed;
+#if ION_DICTIONARY_STATS
+		dictionary_stats_disable(dictionary);
+#endif
+	}
+
+	return (err_ok != error) ? error : sync_error;
+}
+
+ion_err_t
+dictionary_close(
+	ion_dictionary_t *dictionary
+) {
+	if (ion_dictionary_status_closed == dictionary->status) {
+		return err_ok;
+	}
+
+	ion_alloc_account_t outer	= ion_alloc_enter(dictionary->alloc_account);
+	ion_err_t			error	= dictionary_close_engine(dictionary);
+
+	ion_alloc_leave(outer);
+
+	if (ion_dictionary_status_closed == dictionary->status) {
+		ion_alloc_close_account(dictionary->alloc_account);
+		dictionary->alloc_account = ion_alloc_unattributed;
 	}
 
 	return error;
@@ -437,8 +1250,8 @@ dictionary_destroy_predicate_equality(
 	ion_predicate_t **predicate
 ) {
 	if (*predicate != NULL) {
-		free((*predicate)->statement.equality.equality_value);
-		free(*predicate);
+		ion_free((*predicate)->statement.equality.equality_value);
+		ion_free(*predicate);
 		*predicate = NULL;
 	}
 }
@@ -456,9 +1269,9 @@ dictionary_destroy_predicate_range(
 	ion_predicate_t **predicate
 ) {
 	if (*predicate != NULL) {
-		free((*predicate)->statement.range.upper_bound);
-		free((*predicate)->statement.range.lower_bound);
-		free(*predicate);
+		ion_free((*predicate)->statement.range.upper_bound);
+		ion_free((*predicate)->statement.range.lower_bound);
+		ion_free(*predicate);
 		*predicate = NULL;
 	}
 }
@@ -476,7 +1289,46 @@ dictionary_destroy_predicate_all_records(
 	ion_predicate_t **predicate
 ) {
 	if (*predicate != NULL) {
-		free(*predicate);
+		ion_free(*predicate);
+		*predicate = NULL;
+	}
+}
+
+/**
+@brief		Destroys a predicate (conditional) predicate.
+@details	This function should not be called directly. Instead, it is set
+			while building the predicate. The context of the filter
+			belongs to the caller, so it is left alone.
+@param		predicate
+				A pointer to the pointer to the predicate object being
+				destroyed.
+*/
+void
+dictionary_destroy_predicate_predicate(
+	ion_predicate_t **predicate
+) {
+	if (*predicate != NULL) {
+		ion_free(*predicate);
+		*predicate = NULL;
+	}
+}
+
+/**
+@brief		Destroys a prefix predicate.
+@details	This function should not be called directly. Instead, it is set
+			while building the predicate. Cursors are given the range a
+			prefix spans rather than a copy of it, so the prefix belongs
+			to the caller and is left alone.
+@param		predicate
+				A pointer to the pointer to the predicate object being
+				destroyed.
+*/
+void
+dictionary_destroy_predicate_prefix(
+	ion_predicate_t **predicate
+) {
+	if (*predicate != NULL) {
+		ion_free(*predicate);
 		*predicate = NULL;
 	}
 }
@@ -518,8 +1370,17 @@ dictionary_build_predicate(
 		}
 
 		case predicate_predicate: {
-			/* TODO not implemented */
-			return err_invalid_predicate;
+			predicate->statement.other_predicate.filter		= va_arg(arg_list, ion_predicate_filter_t);
+			predicate->statement.other_predicate.context	= va_arg(arg_list, void *);
+			predicate->destroy								= dictionary_destroy_predicate_predicate;
+			break;
+		}
+
+		case predicate_prefix: {
+			predicate->statement.prefix.prefix	= va_arg(arg_list, ion_key_t);
+			predicate->statement.prefix.length	= (ion_key_size_t) va_arg(arg_list, int);
+			predicate->destroy					= dictionary_destroy_predicate_prefix;
+			break;
 		}
 
 		default: {
@@ -538,28 +1399,464 @@ dictionary_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
-	return dictionary->handler->find(dictionary, predicate, cursor);
-}
+	ion_key_size_t	key_size = dictionary->instance->record.key_size;
+	ion_predicate_t range;
+	ion_byte_t		*lower;
+	ion_byte_t		*upper;
 
-ion_boolean_t
-test_predicate(
-	ion_dict_cursor_t	*cursor,
-	ion_key_t			key
-) {
-	ion_dictionary_parent_t *parent		= cursor->dictionary->instance;
-	ion_key_size_t			key_size	= cursor->dictionary->instance->record.key_size;
-	ion_boolean_t			result		= boolean_false;
+	if (predicate_prefix == predicate->type) {
+		if (((key_type_char_array != dictionary->instance->key_type) && (key_type_null_terminated_string != dictionary->instance->key_type)) || (predicate->statement.prefix.length > key_size)) {
+			return err_invalid_predicate;
+		}
 
-	switch (cursor->predicate->type) {
-		case predicate_equality: {
-			if (parent->compare(key, cursor->predicate->statement.equality.equality_value, cursor->dictionary->instance->record.key_size) == 0) {
-				result = boolean_true;
-			}
+		/* the keys with a prefix are those from it padded with the least byte to it padded with the greatest,
+		   so ordered implementations seek to the first and stop past the last, and the others test the range */
+		lower	= alloca(key_size);
+		upper	= alloca(key_size);
+		memcpy(lower, predicate->statement.prefix.prefix, predicate->statement.prefix.length);
+		memcpy(upper, predicate->statement.prefix.prefix, predicate->statement.prefix.length);
+		memset(lower + predicate->statement.prefix.length, 0x00, key_size - predicate->statement.prefix.length);
+		memset(upper + predicate->statement.prefix.length, 0xFF, key_size - predicate->statement.prefix.length);
+		dictionary_build_predicate(&range, predicate_range, lower, upper);
+		predicate = &range;
+	}
 
-			break;
-		}
+	ION_OP_BEGIN(dictionary);
 
-		case predicate_range: {
+	ion_err_t err = dictionary->handler->find(dictionary, predicate, cursor);
+
+	ION_OP_END(dictionary, dictionary_op_find, err, 0);
+
+	if (err_ok == err) {
+		(*cursor)->value_offset = 0;
+		(*cursor)->value_size	= dictionary->instance->record.value_size;
+	}
+
+	return err;
+}
+
+ion_err_t
+dictionary_cursor_project(
+	ion_dict_cursor_t	*cursor,
+	ion_value_size_t	offset,
+	ion_value_size_t	size
+) {
+	if ((offset > cursor->dictionary->instance->record.value_size) || (size > cursor->dictionary->instance->record.value_size - offset)) {
+		return err_invalid_predicate;
+	}
+
+	cursor->value_offset	= offset;
+	cursor->value_size		= size;
+
+	return err_ok;
+}
+
+/**
+@brief		Reads up to @p max records from a cursor, as
+			@ref dictionary_next_batch does but without counting them.
+*/
+static int
+dictionary_read_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+) {
+	ion_record_t		record;
+	ion_cursor_status_t status;
+	int					read;
+
+	if (NULL != cursor->next_batch) {
+		return cursor->next_batch(cursor, keys, values, max);
+	}
+
+	for (read = 0; read < max; read++) {
+		record.key		= (ion_byte_t *) keys + read * cursor->dictionary->instance->record.key_size;
+		record.value	= (ion_byte_t *) values + read * cursor->dictionary->instance->record.value_size;
+		status			= cursor->next(cursor, &record);
+
+		if ((cs_cursor_active != status) && (cs_cursor_initialized != status)) {
+			break;
+		}
+	}
+
+	return read;
+}
+
+int
+dictionary_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+) {
+	ION_OP_BEGIN(cursor->dictionary);
+
+	int read = dictionary_read_batch(cursor, keys, values, max);
+
+	ION_OP_END(cursor->dictionary, dictionary_op_next, (cs_cursor_uninitialized == cursor->status) ? err_illegal_state : err_ok, read);
+
+	return read;
+}
+
+ion_cursor_status_t
+dictionary_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ION_OP_BEGIN(cursor->dictionary);
+
+	ion_cursor_status_t status = cursor->next(cursor, record);
+
+	ION_OP_END(cursor->dictionary, dictionary_op_next, (cs_cursor_uninitialized == status) ? err_illegal_state : err_ok, (cs_cursor_active == status) ? 1 : 0);
+
+	return status;
+}
+
+/**
+@brief		Reads up to @p max records of a snapshot cursor, from memory
+			and then from its file.
+*/
+static int
+dictionary_snapshot_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+) {
+	ion_snapshot_cursor_t	*snapshot	= (ion_snapshot_cursor_t *) cursor;
+	ion_key_size_t			key_size	= cursor->dictionary->instance->record.key_size;
+	ion_value_size_t		value_size	= cursor->dictionary->instance->record.value_size;
+	ion_predicate_t			predicate;
+	int						read		= 0;
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active != cursor->status) {
+		return 0;
+	}
+
+	if (snapshot->position < snapshot->count) {
+		read = (snapshot->count - snapshot->position < max) ? snapshot->count - snapshot->position : max;
+		memcpy(keys, snapshot->keys + snapshot->position * key_size, read * key_size);
+		memcpy(values, snapshot->values + snapshot->position * value_size, read * value_size);
+		snapshot->position += read;
+	}
+
+	if ((read < max) && snapshot->spilled) {
+		if (NULL == snapshot->file_cursor) {
+			dictionary_build_predicate(&predicate, predicate_all_records);
+
+			if (err_ok != dictionary_find(&snapshot->file, &predicate, &snapshot->file_cursor)) {
+				snapshot->file_cursor	= NULL;
+				cursor->status			= cs_invalid_cursor;
+				return read;
+			}
+		}
+
+		read += dictionary_read_batch(snapshot->file_cursor, (ion_byte_t *) keys + read * key_size, (ion_byte_t *) values + read * value_size, max - read);
+
+		if ((read < max) && (cs_end_of_results != snapshot->file_cursor->status)) {
+			cursor->status = snapshot->file_cursor->status;
+			return read;
+		}
+	}
+
+	if (read < max) {
+		cursor->status = cs_end_of_results;
+	}
+
+	return read;
+}
+
+/**
+@brief		Reads the next record of a snapshot cursor.
+*/
+static ion_cursor_status_t
+dictionary_snapshot_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	dictionary_snapshot_next_batch(cursor, record->key, record->value, 1);
+
+	return cursor->status;
+}
+
+/**
+@brief		Destroys a snapshot cursor, with its file, and sets it to
+			@c NULL.
+*/
+static void
+dictionary_snapshot_destroy(
+	ion_dict_cursor_t **cursor
+) {
+	ion_snapshot_cursor_t *snapshot = (ion_snapshot_cursor_t *) *cursor;
+
+	if (NULL != snapshot->file_cursor) {
+		snapshot->file_cursor->destroy(&snapshot->file_cursor);
+	}
+
+	if (snapshot->spilled) {
+		dictionary_delete_dictionary(&snapshot->file);
+	}
+
+	ion_free(snapshot->keys);
+	ion_free(snapshot->values);
+	ion_free(snapshot);
+	*cursor = NULL;
+}
+
+/**
+@brief		Creates the flat file a snapshot cursor writes the records
+			past its budget to, under the first snapshot id no file has.
+*/
+static ion_err_t
+dictionary_snapshot_spill(
+	ion_snapshot_cursor_t	*snapshot,
+	ion_record_info_t		*record,
+	ion_key_type_t			key_type
+) {
+	char				filename[ION_MAX_FILENAME_LENGTH];
+	ion_dictionary_id_t id;
+	FILE				*file;
+	ion_err_t			err;
+
+	ffdict_init(&snapshot->file_handler);
+
+	/* another snapshot, maybe of another process, may be writing the first ids */
+	for (id = ION_SNAPSHOT_ID_BASE; id < ION_SNAPSHOT_ID_BASE + 1024; id++) {
+		dictionary_get_filename(id, "ffs", filename);
+
+		if (NULL == (file = fopen(filename, "rb"))) {
+			err					= dictionary_create(&snapshot->file_handler, &snapshot->file, id, key_type, record->key_size, record->value_size, 1);
+			snapshot->spilled	= (err_ok == err);
+			return err;
+		}
+
+		fclose(file);
+	}
+
+	return err_file_open_error;
+}
+
+/**
+@brief		Copies the records of a cursor into a snapshot, in memory
+			until @p capacity records are held and into its file after.
+*/
+static ion_err_t
+dictionary_snapshot_copy(
+	ion_snapshot_cursor_t	*snapshot,
+	ion_dict_cursor_t		*cursor,
+	int						capacity
+) {
+	ion_dictionary_parent_t *parent		= cursor->dictionary->instance;
+	ion_key_size_t			key_size	= parent->record.key_size;
+	ion_value_size_t		value_size	= parent->record.value_size;
+	int						room		= 0;
+	int						read;
+	ion_byte_t				*grown;
+	ion_err_t				err;
+
+	while (snapshot->count < capacity) {
+		if (snapshot->count == room) {
+			/* doubled as it fills, so a small predicate costs little */
+			room = (0 == room) ? 16 : room * 2;
+
+			if (room > capacity) {
+				room = capacity;
+			}
+
+			if (NULL == (grown = ion_realloc(ion_alloc_cursor, snapshot->keys, room * key_size))) {
+				return err_out_of_memory;
+			}
+
+			snapshot->keys = grown;
+
+			if (NULL == (grown = ion_realloc(ion_alloc_cursor, snapshot->values, room * value_size))) {
+				return err_out_of_memory;
+			}
+
+			snapshot->values = grown;
+		}
+
+		read			= dictionary_read_batch(cursor, snapshot->keys + snapshot->count * key_size, snapshot->values + snapshot->count * value_size, room - snapshot->count);
+		snapshot->count += read;
+
+		if (snapshot->count < room) {
+			return (cs_end_of_results == cursor->status) ? err_ok : err_illegal_state;
+		}
+	}
+
+	/* past the budget, a few records at a time go through the stack to the file */
+	ion_byte_t	*keys	= alloca(16 * key_size);
+	ion_byte_t	*values = alloca(16 * value_size);
+
+	while (0 != (read = dictionary_read_batch(cursor, keys, values, 16))) {
+		if (!snapshot->spilled && (err_ok != (err = dictionary_snapshot_spill(snapshot, &parent->record, parent->key_type)))) {
+			return err;
+		}
+
+		if (err_ok != (err = dictionary_insert_many(&snapshot->file, keys, values, NULL, read).error)) {
+			return err;
+		}
+	}
+
+	return (cs_end_of_results == cursor->status) ? err_ok : err_illegal_state;
+}
+
+ion_err_t
+dictionary_find_snapshot(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	size_t				budget,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_snapshot_cursor_t	*snapshot;
+	ion_dict_cursor_t		*live	= NULL;
+	size_t					record_size = dictionary->instance->record.key_size + dictionary->instance->record.value_size;
+	ion_err_t				err;
+
+	if (NULL == (snapshot = ion_alloc(ion_alloc_cursor, sizeof(ion_snapshot_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	snapshot->super.status		= cs_cursor_initialized;
+	snapshot->super.dictionary	= dictionary;
+	snapshot->super.predicate	= &snapshot->predicate;
+	snapshot->super.value_offset	= 0;
+	snapshot->super.value_size		= dictionary->instance->record.value_size;
+	snapshot->super.next		= dictionary_snapshot_next;
+	snapshot->super.next_batch	= dictionary_snapshot_next_batch;
+	snapshot->super.destroy		= dictionary_snapshot_destroy;
+	snapshot->predicate			= *predicate;
+	snapshot->keys				= NULL;
+	snapshot->values			= NULL;
+	snapshot->count				= 0;
+	snapshot->position			= 0;
+	snapshot->spilled			= boolean_false;
+	snapshot->file_cursor		= NULL;
+
+	if (0 == budget) {
+		budget = ION_SNAPSHOT_MEMORY_BUDGET;
+	}
+
+	err = dictionary_find(dictionary, predicate, &live);
+
+	if (err_ok == err) {
+		err = dictionary_snapshot_copy(snapshot, live, (int) (budget / record_size));
+		live->destroy(&live);
+	}
+
+	if (err_ok != err) {
+		dictionary_snapshot_destroy((ion_dict_cursor_t **) &snapshot);
+		return err;
+	}
+
+	if ((0 == snapshot->count) && !snapshot->spilled) {
+		snapshot->super.status = cs_end_of_results;
+	}
+
+	*cursor = (ion_dict_cursor_t *) snapshot;
+
+	return err_ok;
+}
+
+ion_err_t
+dictionary_stats_enable(
+	ion_dictionary_t *dictionary
+) {
+#if ION_DICTIONARY_STATS
+
+	if (NULL == dictionary->stats) {
+		if (NULL == (dictionary->stats = ion_alloc(ion_alloc_other, sizeof(ion_dictionary_stats_t)))) {
+			return err_out_of_memory;
+		}
+	}
+
+	memset(dictionary->stats, 0, sizeof(ion_dictionary_stats_t));
+
+	return err_ok;
+#else
+	UNUSED(dictionary);
+	return err_not_implemented;
+#endif
+}
+
+void
+dictionary_stats_disable(
+	ion_dictionary_t *dictionary
+) {
+#if ION_DICTIONARY_STATS
+	ion_free(dictionary->stats);
+	dictionary->stats = NULL;
+#else
+	UNUSED(dictionary);
+#endif
+}
+
+ion_err_t
+dictionary_get_stats(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_stats_t	*stats
+) {
+#if ION_DICTIONARY_STATS
+
+	if (NULL == dictionary->stats) {
+		return err_illegal_state;
+	}
+
+	*stats = *dictionary->stats;
+	dictionary_get_memory(dictionary, &stats->memory);
+
+	return err_ok;
+#else
+	UNUSED(dictionary);
+	UNUSED(stats);
+	return err_not_implemented;
+#endif
+}
+
+ion_err_t
+dictionary_get_memory(
+	ion_dictionary_t	*dictionary,
+	ion_alloc_usage_t	*usage
+) {
+	if (ion_alloc_unattributed == dictionary->alloc_account) {
+		memset(usage, 0, sizeof(*usage));
+		return err_illegal_state;
+	}
+
+	return ion_alloc_get_usage(dictionary->alloc_account, usage);
+}
+
+ion_err_t
+dictionary_set_allocator(
+	ion_dictionary_id_t		id,
+	const ion_allocator_t	*allocator
+) {
+	return ion_alloc_bind(id, allocator);
+}
+
+ion_boolean_t
+test_predicate(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			key
+) {
+	ion_dictionary_parent_t *parent		= cursor->dictionary->instance;
+	ion_key_size_t			key_size	= cursor->dictionary->instance->record.key_size;
+	ion_boolean_t			result		= boolean_false;
+
+	switch (cursor->predicate->type) {
+		case predicate_equality: {
+			if (parent->compare(key, cursor->predicate->statement.equality.equality_value, cursor->dictionary->instance->record.key_size) == 0) {
+				result = boolean_true;
+			}
+
+			break;
+		}
+
+		case predicate_range: {
 			ion_key_t	lower_b			= cursor->predicate->statement.range.lower_bound;
 			ion_key_t	upper_b			= cursor->predicate->statement.range.upper_bound;
 
@@ -577,7 +1874,373 @@ test_predicate(
 			result = boolean_true;
 			break;
 		}
+
+		case predicate_prefix: {
+			ion_prefix_statement_t *prefix = &cursor->predicate->statement.prefix;
+
+			result = prefix->length <= key_size && 0 == memcmp(key, prefix->prefix, prefix->length);
+			break;
+		}
 	}
 
 	return result;
 }
+
+ion_boolean_t
+test_record_predicate(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_other_predicate_statement_t *other = &cursor->predicate->statement.other_predicate;
+
+	if (predicate_predicate == cursor->predicate->type) {
+		return other->filter(key, value, other->context);
+	}
+
+	return test_predicate(cursor, key);
+}
+
+ion_err_t
+dictionary_set_durability(
+	ion_dictionary_t	*dictionary,
+	ion_durability_t	level,
+	unsigned int		group_ops,
+	unsigned long		group_ms
+) {
+	ion_err_t err = err_ok;
+
+	if ((durability_none != level) && (NULL == dictionary->handler->sync_dictionary)) {
+		return err_not_implemented;
+	}
+
+	/* what was held back under the old policy goes out first */
+	if (0 != dictionary->durability.pending) {
+		err = dictionary_sync(dictionary);
+	}
+
+	dictionary->durability.level		= level;
+	dictionary->durability.group_ops	= group_ops;
+	dictionary->durability.group_ms		= group_ms;
+
+	return err;
+}
+
+ion_err_t
+dictionary_sync(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = err_ok;
+
+	if (NULL != dictionary->handler->sync_dictionary) {
+		err = dictionary->handler->sync_dictionary(dictionary);
+	}
+
+	if (err_ok == err) {
+		dictionary->durability.pending	= 0;
+		dictionary->durability.since	= ION_DURABILITY_CLOCK();
+	}
+
+	return err;
+}
+
+void
+dictionary_opened(
+	ion_dictionary_t *dictionary
+) {
+	ion_dictionary_open_t	**link;
+	ion_dictionary_open_t	*open;
+	ion_alloc_account_t		outer;
+
+	ION_DICTIONARY_OPENS_LOCK();
+
+	/* an instance in place of one done away with unseen takes its entry,
+	   brought to the front as though it were new */
+	for (link = &dictionary_opens; (NULL != *link) && ((*link)->instance != dictionary->instance); link = &(*link)->next) {}
+
+	open = *link;
+
+	if (NULL != open) {
+		*link = open->next;
+	}
+	else {
+		/* the entry outlives the dictionary, so it is not charged to one a wrapper opens it within */
+		outer	= ion_alloc_enter(ion_alloc_unattributed);
+		open	= ion_alloc(ion_alloc_other, sizeof(ion_dictionary_open_t));
+		ion_alloc_leave(outer);
+	}
+
+	if (NULL != open) {
+		open->instance		= dictionary->instance;
+		open->id			= dictionary->instance->id;
+		open->sync			= dictionary->handler->sync_dictionary;
+		open->info			= dictionary->handler->get_info;
+		open->close			= dictionary->handler->close_dictionary;
+		open->next			= dictionary_opens;
+		dictionary_opens	= open;
+	}
+
+	ION_DICTIONARY_OPENS_UNLOCK();
+}
+
+ion_err_t
+dictionary_sync_all(
+	void
+) {
+	ion_dictionary_open_t		*open;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_err_t					error = err_ok;
+	ion_err_t					err;
+
+	/* the syncs reach every dictionary through its instance */
+	memset(&handler, 0, sizeof(handler));
+	memset(&dictionary, 0, sizeof(dictionary));
+	dictionary.handler = &handler;
+
+	ION_DICTIONARY_OPENS_LOCK();
+
+	for (open = dictionary_opens; NULL != open; open = open->next) {
+		if (NULL == open->sync) {
+			continue;
+		}
+
+		handler.sync_dictionary = open->sync;
+		dictionary.instance		= open->instance;
+		err						= open->sync(&dictionary);
+
+		if (err_ok == error) {
+			error = err;
+		}
+	}
+
+	ION_DICTIONARY_OPENS_UNLOCK();
+
+	return error;
+}
+
+ion_err_t
+dictionary_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	info->record_count	= -1;
+	info->file_bytes	= -1;
+	info->pages			= -1;
+	info->memory_bytes	= -1;
+	info->has_bounds	= boolean_false;
+	info->ordered		= boolean_false;
+
+	if (NULL == dictionary->handler->get_info) {
+		return err_not_implemented;
+	}
+
+	return dictionary->handler->get_info(dictionary, info);
+}
+
+/**
+@brief		Adds one count of a dictionary to the sum of others, which
+			stays unknown once any is.
+*/
+static void
+dictionary_info_add(
+	long	*total,
+	long	count
+) {
+	if ((-1 == *total) || (-1 == count)) {
+		*total = -1;
+	}
+	else {
+		*total += count;
+	}
+}
+
+ion_err_t
+dictionary_get_info_all(
+	ion_dictionary_id_t		first_id,
+	ion_dictionary_id_t		end_id,
+	ion_dictionary_info_t	*total,
+	int						*count
+) {
+	ion_dictionary_open_t		*open;
+	ion_dictionary_open_t		*seen;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_info_t		info;
+	ion_err_t					error = err_ok;
+	ion_err_t					err;
+
+	memset(&handler, 0, sizeof(handler));
+	memset(&dictionary, 0, sizeof(dictionary));
+	dictionary.handler	= &handler;
+	info.min_key		= NULL;
+	info.max_key		= NULL;
+
+	total->record_count = 0;
+	total->file_bytes	= 0;
+	total->pages		= 0;
+	total->memory_bytes = 0;
+	total->has_bounds	= boolean_false;
+	total->ordered		= boolean_false;
+	*count				= 0;
+
+	ION_DICTIONARY_OPENS_LOCK();
+
+	for (open = dictionary_opens; NULL != open; open = open->next) {
+		if ((open->id < first_id) || (open->id >= end_id)) {
+			continue;
+		}
+
+		/* one wrapping another comes first and answers for both */
+		for (seen = dictionary_opens; (seen != open) && (seen->id != open->id); seen = seen->next) {}
+
+		if (seen != open) {
+			continue;
+		}
+
+		(*count)++;
+
+		info.record_count	= -1;
+		info.file_bytes		= -1;
+		info.pages			= -1;
+		info.memory_bytes	= -1;
+		info.has_bounds		= boolean_false;
+
+		if (NULL == open->info) {
+			err = err_not_implemented;
+		}
+		else {
+			handler.get_info	= open->info;
+			dictionary.instance = open->instance;
+			err					= open->info(&dictionary, &info);
+		}
+
+		if (err_ok == error) {
+			error = err;
+		}
+
+		dictionary_info_add(&total->record_count, info.record_count);
+		dictionary_info_add(&total->file_bytes, info.file_bytes);
+		dictionary_info_add(&total->pages, info.pages);
+		dictionary_info_add(&total->memory_bytes, info.memory_bytes);
+	}
+
+	ION_DICTIONARY_OPENS_UNLOCK();
+
+	return error;
+}
+
+/**
+@brief		Where the option after the one at @p at starts, or past the
+			end of the options if the one at @p at runs over it.
+*/
+static int
+dictionary_option_next(
+	const ion_byte_t	*options,
+	int					at
+) {
+	return at + 2 + options[at + 1];
+}
+
+ion_err_t
+dictionary_set_option(
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_option_t			option,
+	uint32_t						value
+) {
+	ion_byte_t	*options = config->options;
+	int			at;
+	int			next;
+	int			size;
+
+	if ((dictionary_option_end == option) || ((int) option > 0xFF)) {
+		return err_illegal_state;
+	}
+
+	if (0 == options[0]) {
+		memset(options, 0, ION_DICTIONARY_OPTIONS_SIZE);
+		options[0] = ION_DICTIONARY_OPTIONS_VERSION;
+	}
+	else if (ION_DICTIONARY_OPTIONS_VERSION != options[0]) {
+		return err_illegal_state;
+	}
+
+	/* the one set before is taken out, the rest moving up over it */
+	at = 1;
+
+	while ((at + 1 < ION_DICTIONARY_OPTIONS_SIZE) && (dictionary_option_end != options[at])) {
+		next = dictionary_option_next(options, at);
+
+		if (next > ION_DICTIONARY_OPTIONS_SIZE) {
+			memset(options + at, 0, ION_DICTIONARY_OPTIONS_SIZE - at);
+			break;
+		}
+
+		if (option != options[at]) {
+			at = next;
+			continue;
+		}
+
+		memmove(options + at, options + next, ION_DICTIONARY_OPTIONS_SIZE - next);
+		memset(options + ION_DICTIONARY_OPTIONS_SIZE - (next - at), 0, next - at);
+	}
+
+	/* the value takes as few bytes as it needs, least significant first */
+	size = 1;
+
+	while ((size < (int) sizeof(value)) && (0 != (value >> (8 * size)))) {
+		size++;
+	}
+
+	if (at + 2 + size > ION_DICTIONARY_OPTIONS_SIZE) {
+		return err_max_capacity;
+	}
+
+	options[at]		= (ion_byte_t) option;
+	options[at + 1] = (ion_byte_t) size;
+
+	for (next = 0; next < size; next++) {
+		options[at + 2 + next] = (ion_byte_t) (value >> (8 * next));
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+dictionary_get_option(
+	const ion_dictionary_config_info_t	*config,
+	ion_dictionary_option_t				option,
+	uint32_t							*value
+) {
+	const ion_byte_t	*options = config->options;
+	int					at;
+	int					next;
+	int					i;
+
+	if (ION_DICTIONARY_OPTIONS_VERSION != options[0]) {
+		return err_item_not_found;
+	}
+
+	for (at = 1; (at + 1 < ION_DICTIONARY_OPTIONS_SIZE) && (dictionary_option_end != options[at]); at = next) {
+		next = dictionary_option_next(options, at);
+
+		if (next > ION_DICTIONARY_OPTIONS_SIZE) {
+			break;
+		}
+
+		/* a value wider than this reads is passed over, as an unknown option is */
+		if ((option != options[at]) || (options[at + 1] > sizeof(*value))) {
+			continue;
+		}
+
+		*value = 0;
+
+		for (i = options[at + 1] - 1; i >= 0; i--) {
+			*value = (*value << 8) | options[at + 2 + i];
+		}
+
+		return err_ok;
+	}
+
+	return err_item_not_found;
+}
@@ -85,6 +85,46 @@ dictionary_create(
 	ion_dictionary_size_t		dictionary_size
 );
 
+/**
+@brief		Creates a dictionary, as @ref dictionary_create does, that
+			orders its keys by a given comparator.
+@details	The comparator must treat keys as equal only when all their
+			bytes are, since hashing dictionaries place keys by their bytes.
+			The stock comparators keep the key handling the engines
+			specialise for them, such as native integer node searches; any
+			other comparator is only ever called through its pointer.
+@param		handler
+				A pointer to a handler object containing pointers to
+				all the functions necessary for this dictionary instance.
+@param		dictionary
+				A pointer to the dictionary to create.
+@param		id
+				The identifier used to identify the dictionary.
+@param		key_type
+				The type of the key.
+@param		key_size
+				The size of the key type to store.
+@param		value_size
+				The size of the value to store.
+@param		dictionary_size
+				The implementation specific dictionary size.
+@param		compare
+				How to order the keys, or @c NULL for the comparator
+				@ref dictionary_switch_compare gives @p key_type.
+@return		A status describing the result of dictionary creation.
+*/
+ion_err_t
+dictionary_create_with_compare(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare
+);
+
 /**
 @brief		Insert a value into a dictionary.
 
@@ -121,6 +161,120 @@ dictionary_get(
 	ion_value_t			value
 );
 
+/**
+@brief		Retrieve the values of a batch of keys.
+
+@details	Implementations that can overlap the work of several lookups,
+			such as prefetching where each key lands, provide their own;
+			others are looked up one key at a time with @ref dictionary_get.
+
+@param		dictionary
+				A pointer to the dictionary to search.
+@param		keys
+				@p count keys, stored back to back.
+@param		values
+				Room for @p count values, stored back to back.
+@param		statuses
+				If not @c NULL, receives the status of each key's lookup.
+@param		count
+				The number of keys.
+@return		The number of records retrieved, with the error of the
+			first lookup that did not succeed, if any.
+*/
+ion_status_t
+dictionary_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+);
+
+/**
+@brief		Point at the stored value of a key, instead of copying it.
+
+@details	Only implementations keeping their records in memory can do
+			this; the others report @c err_not_implemented, as may these
+			for a record they do not hold in memory at the moment, so
+			that the caller falls back on @ref dictionary_get. The
+			pointer stays valid until the dictionary is next changed by
+			an insert, update or delete, or closed. The value must not
+			be written through it.
+
+@param		dictionary
+				A pointer to the dictionary to search.
+@param		key
+				The key to look up.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the lookup.
+*/
+ion_status_t
+dictionary_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Insert a batch of records.
+
+@details	Implementations that can write several records at once, such
+			as appending them in one go, provide their own; others insert
+			one record at a time with @ref dictionary_insert. A native
+			batch may refuse the whole batch, for instance when its keys
+			break an order the dictionary keeps, in which case no record
+			is inserted.
+
+@param		dictionary
+				A pointer to the dictionary to insert into.
+@param		keys
+				@p count keys, stored back to back.
+@param		values
+				@p count values, stored back to back in the same order.
+@param		statuses
+				If not @c NULL, receives the status of each record's insert.
+@param		count
+				The number of records.
+@return		The number of records inserted, with the error of the
+			first insert that did not succeed, if any.
+*/
+ion_status_t
+dictionary_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+);
+
+/**
+@brief		Loads records given in ascending key order into a dictionary.
+
+@details	A dictionary with a bulk loader of its own, and no records
+			yet, is built by it in one pass. It refuses one that already
+			holds records before taking any, so those and dictionaries
+			without a loader have the records inserted
+			@ref ION_BULK_LOAD_BATCH at a time with
+			@ref dictionary_insert_many instead.
+
+@param		dictionary
+				The dictionary to load.
+@param		next
+				Called for each record in turn.
+@param		context
+				Passed through to @p next.
+@return		The number of records loaded, with the error that stopped the
+			load, if any. A loader may keep the records of a load that
+			fails part way, or none of them.
+*/
+ion_status_t
+dictionary_bulk_load(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_bulk_next_t	next,
+	void						*context
+);
+
 /**
 @brief		Delete a value given a key.
 @param		dictionary
@@ -135,6 +289,31 @@ dictionary_delete(
 	ion_key_t			key
 );
 
+/**
+@brief		Delete every record of a batch of keys.
+
+@details	Keys are deleted one at a time with @ref dictionary_delete
+			unless the implementation provides its own batch.
+
+@param		dictionary
+				A pointer to the dictionary to delete from.
+@param		keys
+				@p count keys, stored back to back.
+@param		statuses
+				If not @c NULL, receives the status of each key's deletion.
+@param		count
+				The number of keys.
+@return		The number of records deleted, with the error of the first
+			deletion that did not succeed, if any.
+*/
+ion_status_t
+dictionary_delete_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_status_t		*statuses,
+	int					count
+);
+
 /**
 @brief		Update all records with a given key.
 
@@ -222,6 +401,201 @@ dictionary_compare_signed_value(
 	ion_key_size_t	key_size
 );
 
+/**
+@brief		Compares two character (byte) arrays, which need not be
+			null-terminated.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				The length of the key in bytes.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_char_array(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two null-terminated strings, up to @p key_size bytes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				The maximum length of the key in bytes.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_null_terminated_string(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Picks the comparator for keys of a type and size.
+@details	Numeric keys of 1, 2, 4 or 8 bytes are compared as the native
+			integer of that width, which orders them as
+			@ref dictionary_compare_signed_value and
+			@ref dictionary_compare_unsigned_value do without their loop
+			over the bytes. Other sizes get those two.
+@param		key_type
+				The type of the key.
+@param		key_size
+				The size of the key in bytes.
+@return		The comparator, or @c NULL if @p key_type is not known.
+*/
+ion_dictionary_compare_t
+dictionary_switch_compare(
+	ion_key_type_t	key_type,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Whether a comparator is one of those
+			@ref dictionary_switch_compare gives signed numeric keys.
+@param		compare
+				The comparator to check.
+@return		@c boolean_true if it orders keys as signed integers.
+*/
+ion_boolean_t
+dictionary_is_signed_compare(
+	ion_dictionary_compare_t compare
+);
+
+/**
+@brief		Whether a comparator is one of those
+			@ref dictionary_switch_compare gives unsigned numeric keys.
+@param		compare
+				The comparator to check.
+@return		@c boolean_true if it orders keys as unsigned integers.
+*/
+ion_boolean_t
+dictionary_is_unsigned_compare(
+	ion_dictionary_compare_t compare
+);
+
+/**
+@brief		Hashes every byte of a key that takes part in its comparison.
+@details	Keys that compare equal under the comparator for @p key_type
+			hash equal: string keys stop at their terminator, so bytes
+			past it do not change the hash. Host builds mix the key a
+			machine word at a time with 64-bit multiplies; AVR builds use
+			a cheaper 32-bit multiply-shift per byte.
+@param		key_type
+				The type of the key, as given to @ref dictionary_switch_compare.
+@param		key
+				The key to hash.
+@param		key_size
+				The size of the key in bytes.
+@param		seed
+				A per-dictionary seed, so different dictionaries place
+				the same keys differently.
+@return		The 32-bit hash of the key.
+*/
+uint32_t
+dictionary_hash_key(
+	ion_key_type_t	key_type,
+	ion_key_t		key,
+	ion_key_size_t	key_size,
+	uint32_t		seed
+);
+
+/**
+@brief		The hash behind @ref dictionary_hash_key, over exactly
+			@p length bytes.
+@details	Kept inline so that callers hashing fixed-size keys, such
+			as the C++ wrappers, can have it unrolled for their key size.
+@param		bytes
+				The bytes to hash.
+@param		length
+				How many bytes to hash.
+@param		seed
+				The per-dictionary seed.
+@return		The 32-bit hash of the bytes.
+*/
+static inline uint32_t
+dictionary_hash_bytes(
+	const ion_byte_t	*bytes,
+	size_t				length,
+	uint32_t			seed
+) {
+#if defined(ARDUINO)
+
+	uint32_t	hash	= seed ^ 0x811C9DC5UL;
+	size_t		i;
+
+	for (i = 0; i < length; i++) {
+		hash	= (hash ^ bytes[i]) * 0x9E3779B1UL;
+		hash	^= hash >> 15;
+	}
+
+	hash	^= length;
+	hash	^= hash >> 16;
+	hash	*= 0x85EBCA6BUL;
+	hash	^= hash >> 13;
+
+	return hash;
+#else
+
+	uint64_t	hash = ((uint64_t) seed << 32 | seed) ^ (length * 0x9E3779B97F4A7C15ULL);
+	uint64_t	word;
+
+	/* whole words first, then the tail packed into one last word */
+	while (length >= sizeof(word)) {
+		memcpy(&word, bytes, sizeof(word));
+		hash	= (hash ^ word) * 0x9FB21C651E98DF25ULL;
+		hash	^= hash >> 29;
+		bytes	+= sizeof(word);
+		length	-= sizeof(word);
+	}
+
+	if (length > 0) {
+		word = 0;
+		memcpy(&word, bytes, length);
+		hash	= (hash ^ word) * 0x9FB21C651E98DF25ULL;
+		hash	^= hash >> 29;
+	}
+
+	hash	^= hash >> 33;
+	hash	*= 0xFF51AFD7ED558CCDULL;
+	hash	^= hash >> 33;
+	hash	*= 0xC4CEB9FE1A85EC53ULL;
+	hash	^= hash >> 33;
+
+	return (uint32_t) (hash ^ (hash >> 32));
+#endif
+}
+
+/**
+@brief		Counts one operation of a linear probing hash table in its
+			statistics.
+@param		stats
+				The statistics of the table.
+@param		op
+				The counters of the kind of operation, within @p stats.
+@param		home
+				The home bucket of the operation's key.
+@param		probes
+				The probe length of the operation, see
+				@ref ion_hash_op_stats_t.
+@param		size
+				The number of buckets in the table, to tell whether the
+				probe wrapped around.
+*/
+void
+dictionary_hash_count_probes(
+	ion_hash_stats_t	*stats,
+	ion_hash_op_stats_t *op,
+	int					home,
+	int					probes,
+	int					size
+);
+
 /**
 @brief		Opens a dictionary, given the desired config.
 @param		handler
@@ -266,7 +640,10 @@ dictionary_close(
 				Range:		  1st vparam is lower bound, 2nd vparam is upper
 								bound.
 				All_records:	No vparams used.
-				Predicate:	  TODO to be implemented
+				Predicate:	  1st vparam is the @ref ion_predicate_filter_t,
+								2nd vparam is the context passed to it.
+				Prefix:		 1st vparam is the prefix, 2nd the number of
+								its bytes, an int.
 @returns	An error describing the result of open operation.
 */
 ion_err_t
@@ -298,6 +675,396 @@ dictionary_find(
 	ion_dict_cursor_t	**cursor
 );
 
+/**
+@brief		Finds the records that satisfy a predicate as they are now,
+			into a cursor the dictionary may be changed under.
+
+@details	The records are copied out of the dictionary before this
+			returns, so reading the cursor gives the same records
+			whatever is inserted, updated or deleted meanwhile, without
+			writers waiting on the reader. The copy is made at the pace
+			of @ref dictionary_next_batch and costs memory up to
+			@p budget, and a flat file past it, until the cursor is
+			destroyed. Only the type of the cursor's predicate is
+			meaningful, as its statement points where @p predicate did.
+
+@param		dictionary
+				The dictionary to search.
+@param		predicate
+				The predicate to match.
+@param		budget
+				The most bytes of records to hold in memory, 0 for
+				@ref ION_SNAPSHOT_MEMORY_BUDGET.
+@param		cursor
+				Receives the cursor, of type @ref ion_snapshot_cursor_t.
+@return		The status of the find. Nothing is left to destroy unless
+			it is @c err_ok.
+*/
+ion_err_t
+dictionary_find_snapshot(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	size_t				budget,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Has a cursor read only some bytes of each value.
+@details	Implementations that can pass over the other bytes, as the
+			B+ tree reading its values from their file does, fetch or copy
+			only the bytes wanted, and others copy the value whole. Either
+			way the bytes wanted are at their places in the value read,
+			and the others are to be left unread. A cursor reads all of
+			each value until this is called.
+
+@param		cursor
+				The cursor, not yet read or read part way.
+@param		offset
+				The first byte of each value wanted.
+@param		size
+				How many are wanted from there, which may be 0 where only
+				the keys are.
+@return		An error code describing the result of the call, being
+			@c err_invalid_predicate if the bytes do not fit in a value.
+*/
+ion_err_t
+dictionary_cursor_project(
+	ion_dict_cursor_t	*cursor,
+	ion_value_size_t	offset,
+	ion_value_size_t	size
+);
+
+/**
+@brief		Reads up to @p max records from a cursor.
+
+@details	Implementations that keep their records in memory or in a
+			page buffer can hand several over at once; others are read
+			one record at a time, straight into @p keys and @p values,
+			with the cursor's @c next. Either way, the cursor may go on
+			being read with @c next afterwards.
+
+@param		cursor
+				The cursor to read from.
+@param		keys
+				Room for @p max keys, stored back to back.
+@param		values
+				Room for @p max values, stored back to back in the same
+				order.
+@param		max
+				The most records to read.
+@return		The number of records read. Fewer than @p max means the
+			cursor's status is no longer one that yields records, be
+			it @c cs_end_of_results or an error.
+*/
+int
+dictionary_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+);
+
+/**
+@brief		Reads the next record from a cursor, as its @c next does, and
+			counts the read if the dictionary keeps counters.
+
+@param		cursor
+				The cursor to read from.
+@param		record
+				Receives the record, its buffers allocated by the caller.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+dictionary_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Has a dictionary count its operations from now on, or resets
+			its counters if it already does.
+
+@details	The inserts, gets, updates, deletes, finds and cursor reads
+			made through this interface are counted by kind, with the
+			failures among them, the bytes of the records they touched
+			and a histogram of how long they took. Reads made straight
+			through a cursor's @c next rather than @ref dictionary_next
+			are not counted. Deleting or closing the dictionary frees
+			the counters.
+
+@param		dictionary
+				The dictionary to count the operations of.
+@return		@c err_ok, @c err_out_of_memory, or @c err_not_implemented
+			if @ref ION_DICTIONARY_STATS is 0.
+*/
+ion_err_t
+dictionary_stats_enable(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Stops a dictionary counting its operations and frees its
+			counters. Does nothing if it does not count them.
+
+@param		dictionary
+				The dictionary to stop counting the operations of.
+*/
+void
+dictionary_stats_disable(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Reads the counters of a dictionary.
+
+@param		dictionary
+				A dictionary that counts its operations, see
+				@ref dictionary_stats_enable.
+@param		stats
+				Receives a copy of the counters. Times are in
+				@c ION_DICTIONARY_CLOCK ticks, microseconds by default.
+@return		@c err_ok, @c err_illegal_state if @p dictionary does not
+			count its operations, or @c err_not_implemented if
+			@ref ION_DICTIONARY_STATS is 0.
+*/
+ion_err_t
+dictionary_get_stats(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_stats_t	*stats
+);
+
+/**
+@brief		Reads how much memory the engine of a dictionary holds, by kind.
+
+@details	Counted are the blocks its engine allocated through
+			@ref ion_alloc while working for it, from its create or open
+			on. They stay charged to it until freed, whoever frees them.
+			The counters are also in @ref ion_dictionary_stats_t, and are
+			kept whether or not the dictionary counts its operations.
+
+@param		dictionary
+				An open dictionary.
+@param		usage
+				Receives the counters.
+@return		@c err_ok, @c err_illegal_state if the dictionary found no
+			account free when it was opened, see @ref ION_ALLOC_ACCOUNTS,
+			or @c err_not_implemented if @ref ION_ALLOC_TRACKING is 0.
+*/
+ion_err_t
+dictionary_get_memory(
+	ion_dictionary_t	*dictionary,
+	ion_alloc_usage_t	*usage
+);
+
+/**
+@brief		Takes the memory of the dictionary with an ID from an allocator,
+			such as a pool or an arena of @ref ion_alloc.h.
+
+@details	Set before the dictionary is created or opened, it holds for
+			each time it is, until set again. The allocator must outlive
+			every block of it, so the dictionary must be closed or deleted
+			before an arena is destroyed.
+
+@param		id
+				The ID of the dictionary.
+@param		allocator
+				Where its memory comes from, or @c NULL for the default.
+@return		@c err_ok, @c err_illegal_state if the dictionary still holds
+			memory of another allocator, @c err_max_capacity if every
+			account is in use, see @ref ION_ALLOC_ACCOUNTS, or
+			@c err_not_implemented if @ref ION_ALLOC_TRACKING is 0.
+*/
+ion_err_t
+dictionary_set_allocator(
+	ion_dictionary_id_t		id,
+	const ion_allocator_t	*allocator
+);
+
+/**
+@brief		Sets how far a dictionary pushes its writes to storage on its
+			own.
+
+@details	Inserts, updates and deletes made through this interface are
+			counted against the policy. Under @ref durability_sync each
+			one is pushed before it returns, under @ref durability_group
+			once @p group_ops are pending or @p group_ms have passed since
+			the last push, and under @ref durability_close and
+			@ref durability_group whatever is left is pushed on close. A
+			push that fails sets the error of the write that made it. The
+			policy is not kept once the dictionary is closed; it reopens
+			with @ref ION_DEFAULT_DURABILITY.
+
+@param		dictionary
+				An open dictionary.
+@param		level
+				The @ref ION_DURABILITY.
+@param		group_ops
+				For @ref durability_group, how many writes are pushed
+				together, 0 for no limit.
+@param		group_ms
+				For @ref durability_group, how many milliseconds after a
+				push the next write pushes again, 0 for no limit.
+@return		@c err_ok, @c err_not_implemented if the dictionary keeps
+			nothing in storage and @p level is not @ref durability_none,
+			or the error of pushing the writes pending under the old
+			policy.
+*/
+ion_err_t
+dictionary_set_durability(
+	ion_dictionary_t	*dictionary,
+	ion_durability_t	level,
+	unsigned int		group_ops,
+	unsigned long		group_ms
+);
+
+/**
+@brief		Pushes every write made to a dictionary through to storage now,
+			whatever its durability.
+
+@param		dictionary
+				An open dictionary.
+@return		The status of the push. A dictionary that keeps nothing in
+			storage has nothing to push.
+*/
+ion_err_t
+dictionary_sync(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Lists a dictionary made open other than through
+			@ref dictionary_create or @ref dictionary_open, as one wrapping
+			another is, for @ref dictionary_sync_all and
+			@ref dictionary_get_info_all.
+
+@details	One that cannot be listed for want of memory is not pushed
+			nor counted.
+			One done away with other than by @ref dictionary_close or
+			@ref dictionary_delete_dictionary, as a crash is simulated,
+			stays listed, and must not be left so at the next
+			@ref dictionary_sync_all, nor, if in the IDs asked of, the
+			next @ref dictionary_get_info_all.
+
+@param		dictionary
+				An open dictionary.
+*/
+void
+dictionary_opened(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Pushes every open dictionary that keeps anything in storage
+			through to storage, whatever its durability, leaving it open.
+
+@details	Those wrapping others are pushed before them, so each is
+			pushed after whatever is written into it. No other thread may
+			be using them meanwhile, though others may open and close
+			dictionaries. Used with @ref ion_fsync_defer, each file is
+			forced only once, at the end.
+
+@return		@c err_ok, or the first error of the pushes; the rest are
+			pushed all the same.
+*/
+ion_err_t
+dictionary_sync_all(
+	void
+);
+
+/**
+@brief		Tells what a dictionary can of its size and shape without
+			reading its records, as its handler keeps count of them.
+
+@param		dictionary
+				An open dictionary.
+@param		info
+				Receives what the dictionary can tell, each count it
+				cannot being -1. Its @c min_key and @c max_key, if not
+				NULL, have room for a key each, and are filled in with
+				the smallest and largest keys held where that is cheap,
+				as @c has_bounds tells.
+@return		@c err_ok, or @c err_not_implemented if the dictionary can
+			tell nothing of itself.
+*/
+ion_err_t
+dictionary_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+);
+
+/**
+@brief		Sums what the open dictionaries with IDs in a range can tell of
+			their size, as @ref dictionary_get_info does of one.
+
+@details	A dictionary wrapping another is counted once, through the
+			wrapper. A sum is -1 if any dictionary cannot tell its part.
+			No bounds are given. No other thread may be using the
+			dictionaries meanwhile.
+
+@param		first_id
+				The first ID counted.
+@param		end_id
+				The ID after the last counted.
+@param		total
+				Receives the sums.
+@param		count
+				Receives the number of dictionaries counted.
+@return		@c err_ok, or the first error of a dictionary; the rest are
+			counted all the same.
+*/
+ion_err_t
+dictionary_get_info_all(
+	ion_dictionary_id_t		first_id,
+	ion_dictionary_id_t		end_id,
+	ion_dictionary_info_t	*total,
+	int						*count
+);
+
+/**
+@brief		Sets an option of a dictionary in its config, before it is
+			created through the master table, which keeps it.
+
+@details	Each option takes two bytes and those of its value, of which
+			there are @ref ION_DICTIONARY_OPTIONS_SIZE less one in all.
+			Setting one already set replaces it.
+
+@param		config
+				The config to set it in, its options all 0 if none are
+				set yet.
+@param		option
+				The option to set.
+@param		value
+				Its value.
+@return		@c err_ok, @c err_max_capacity if the options have no room
+			for it, or @c err_illegal_state if they are of a version this
+			cannot write, or @p option is not one.
+*/
+ion_err_t
+dictionary_set_option(
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_option_t			option,
+	uint32_t						value
+);
+
+/**
+@brief		Reads an option of a dictionary from its config.
+
+@param		config
+				The config the dictionary was created or opened with.
+@param		option
+				The option to read.
+@param		value
+				Receives its value, if it is set.
+@return		@c err_ok, or @c err_item_not_found if it is not set, or
+			not in a form this can read.
+*/
+ion_err_t
+dictionary_get_option(
+	const ion_dictionary_config_info_t	*config,
+	ion_dictionary_option_t				option,
+	uint32_t							*value
+);
+
 /**
 @brief		Tests the supplied @p key against the predicate registered in the
 			@p cursor. If the supplied @p cursor if of the type equality, the key is tested for equality with that
@@ -319,6 +1086,27 @@ test_predicate(
 	ion_key_t			key
 );
 
+/**
+@brief		Tests a record against the predicate registered in the
+			@p cursor.
+@details	Predicate cursors pass the record to their filter, the others
+			test its key as @ref test_predicate does. Implementations call
+			this on records where they hold them, before copying any out.
+@param		cursor
+				The cursor and predicate being used to test the record.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		Whether the record passes the predicate test.
+*/
+ion_boolean_t
+test_record_predicate(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 #include "../key_value/kv_system.h"
+#include "ion_alloc.h"
 
 /**
 @brief	  A type used to identify dictionaries, specifically in the master
@@ -45,6 +46,60 @@ typedef unsigned int ion_dictionary_id_t;
 */
 typedef ion_byte_t ion_dict_use_t;
 
+/**
+@brief		The hash functions a hashing dictionary can be created with.
+@details	Stored in the @c hash_function field of
+			@ref ion_dictionary_config_info_t, so a dictionary reopened
+			from the master table hashes its keys the same way again.
+*/
+typedef enum ION_HASH_FUNCTION {
+	/**> A seeded hash over every byte of the key. This is the default. */
+	hash_function_seeded,
+	/**> The key's leading @c int modulo the table size. Kept for
+		 tables that depend on the exact placement of integer keys. */
+	hash_function_modulo,
+} ion_hash_function_t;
+
+/**
+@brief		The bytes each dictionary has for its options, in its config
+			and so in its master table record.
+*/
+#if !defined(ION_DICTIONARY_OPTIONS_SIZE)
+#define ION_DICTIONARY_OPTIONS_SIZE 16
+#endif
+
+/**
+@brief		The layout of the options written by this version. A config
+			whose first option byte is 0 has none, as does one of a
+			version it does not know.
+*/
+#define ION_DICTIONARY_OPTIONS_VERSION 1
+
+/**
+@brief		The tuning a dictionary can be given beyond its config, kept
+			with it in the master table so it holds across opening it
+			again.
+@details	The node size and hash function have their own fields, the
+			@c page_size and @c hash_function of the config. An
+			implementation takes the options it knows and passes over the
+			rest, so new ones can be added without the older reading
+			them wrongly; the number of each is part of the format.
+*/
+typedef enum ION_DICTIONARY_OPTION {
+	/**> Ends the options. Not an option. */
+	dictionary_option_end				= 0,
+	/**> How many pages or nodes are buffered in memory. */
+	dictionary_option_buffer_count		= 1,
+	/**> Whether pages are stored compressed, if not 0. */
+	dictionary_option_compression		= 2,
+	/**> How many records a cache in front of it holds, for whoever
+		 puts one there. */
+	dictionary_option_cache_size		= 3,
+	/**> Whether pages are appended to a log rather than written over,
+		 if not 0. Taken when the dictionary is created. */
+	dictionary_option_log_structured	= 4,
+} ion_dictionary_option_t;
+
 /**
 @brief		Struct containing details for opening a dictionary previously
 			created.
@@ -62,6 +117,29 @@ typedef struct {
 													 parameter. Dependent on
 													 the dictionary
 													 implementation used. */
+	ion_dictionary_size_t	page_size;			/**< Bytes per on-disk page,
+													 for implementations
+													 built from pages. 0
+													 selects their default. */
+	ion_byte_t				hash_function;		/**< The @ref
+													 ion_hash_function_t,
+													 for hashing
+													 implementations. */
+	ion_dictionary_id_t		index_of;			/**< For a secondary index,
+													 the dictionary whose
+													 values it indexes, else
+													 0. */
+	ion_value_size_t		index_offset;		/**< For a secondary index,
+													 where the indexed bytes
+													 start in the value. */
+	ion_value_size_t		index_size;			/**< For a secondary index,
+													 how many bytes are
+													 indexed. */
+	ion_byte_t				options[ION_DICTIONARY_OPTIONS_SIZE];	/**< The tuning,
+																	 see @ref
+																	 dictionary_set_option,
+																	 all 0 for
+																	 none. */
 } ion_dictionary_config_info_t;
 
 /**
@@ -158,6 +236,44 @@ enum ION_CURSOR_STATUS {
 */
 typedef char ion_cursor_status_t;
 
+/**
+@brief		What a dictionary can tell cheaply of its size and shape, see
+			@ref dictionary_get_info. A count it cannot tell without
+			reading its records is -1.
+*/
+typedef struct {
+	long			record_count;	/**< The records it holds. */
+	long			file_bytes;		/**< The bytes of its files. */
+	long			pages;			/**< The pages, nodes, buckets or rows
+									 its records are laid out over. */
+	long			memory_bytes;	/**< The bytes of RAM it holds on to,
+									 its buffers and in-memory records,
+									 beyond its instance. */
+	ion_boolean_t	has_bounds;		/**< Whether @c min_key and
+									 @c max_key were filled in. */
+	ion_key_t		min_key;		/**< Room for the smallest key held,
+									 or NULL not to ask for it. */
+	ion_key_t		max_key;		/**< Room for the largest key held,
+									 or NULL not to ask for it. */
+	ion_boolean_t	ordered;		/**< Whether its cursors give records
+									 in ascending key order. */
+} ion_dictionary_info_t;
+
+/**
+@brief		Supplies records to a bulk load, see @ref dictionary_bulk_load.
+@param		context
+				The context given to the load.
+@param		record
+				Key and value buffers, sized for the dictionary, to fill with
+				the next record. Records come in ascending key order.
+@return		@ref err_ok if @p record was filled, @ref err_item_not_found once
+			there are no more records, or any other error to abort the load.
+*/
+typedef ion_err_t (*ion_dictionary_bulk_next_t)(
+	void			*context,
+	ion_record_t	*record
+);
+
 /**
 @brief		A dictionary_handler is responsible for dealing with the specific
 			interface for an underlying dictionary, but is decoupled from a
@@ -219,6 +335,59 @@ struct dictionary_handler {
 		ion_dictionary_t *
 	);
 	/**< A pointer to the dictionaries close function */
+	ion_status_t (*get_many)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_value_t,
+		ion_status_t *,
+		int
+	);
+	/**< A pointer to the dictionaries batched get function, or NULL to
+		 look each key up with @c get */
+	ion_status_t (*insert_many)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_value_t,
+		ion_status_t *,
+		int
+	);
+	/**< A pointer to the dictionaries batched insert function, or NULL to
+		 insert each record with @c insert */
+	ion_status_t (*delete_many)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_status_t *,
+		int
+	);
+	/**< A pointer to the dictionaries batched delete function, or NULL to
+		 delete each key with @c remove */
+	ion_status_t (*get_ref)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_value_t *
+	);
+	/**< A pointer to the dictionaries function pointing at a stored value
+		 in place, or NULL if its values cannot be handed out that way */
+	ion_err_t (*sync_dictionary)(
+		ion_dictionary_t *
+	);
+	/**< A pointer to the dictionaries function pushing every write made
+		 through to storage, or NULL if it keeps nothing there */
+	ion_err_t (*get_info)(
+		ion_dictionary_t *,
+		ion_dictionary_info_t *
+	);
+	/**< A pointer to the dictionaries function filling in what it can
+		 tell of its size without reading its records, or NULL if it
+		 can tell nothing */
+	ion_status_t (*bulk_load)(
+		ion_dictionary_t *,
+		ion_dictionary_bulk_next_t,
+		void *
+	);
+	/**< A pointer to the dictionaries function building it, empty, from
+		 records in ascending key order, or NULL to insert them in
+		 batches */
 };
 
 /**
@@ -241,6 +410,118 @@ enum ION_DICTIONARY_STATUS {
 */
 typedef char ion_dictionary_status_t;
 
+/**
+@brief		Whether dictionaries can keep operation counters, see
+			@ref dictionary_stats_enable.
+@details	When 0 the counters are compiled out of every operation.
+			When 1 a dictionary only pays for them once they are enabled
+			on it, and otherwise for a pointer test per operation.
+*/
+#if !defined(ION_DICTIONARY_STATS)
+#if defined(ARDUINO)
+#define ION_DICTIONARY_STATS 0
+#else
+#define ION_DICTIONARY_STATS 1
+#endif
+#endif
+
+/**
+@brief		The number of buckets in a latency histogram. Bucket 0 counts
+			operations that took no clock ticks, bucket @c b those that
+			took from 2^(b - 1) up to 2^b ticks, and the last bucket
+			everything longer.
+*/
+#if !defined(ION_DICTIONARY_STATS_BUCKETS)
+#define ION_DICTIONARY_STATS_BUCKETS 24
+#endif
+
+/**
+@brief		The dictionary operations counted by @ref ion_dictionary_stats_t.
+*/
+typedef enum ION_DICTIONARY_OP {
+	dictionary_op_insert,	/**< Inserts, batched or not. */
+	dictionary_op_get,		/**< Gets, batched or not, and gets by reference. */
+	dictionary_op_update,	/**< Updates. */
+	dictionary_op_delete,	/**< Deletes, batched or not. */
+	dictionary_op_find,		/**< Finds. */
+	dictionary_op_next,		/**< Reads from cursors, see @ref dictionary_next. */
+	dictionary_op_count		/**< The number of operations counted. */
+} ion_dictionary_op_t;
+
+/**
+@brief		Counters of one kind of dictionary operation.
+*/
+typedef struct {
+	unsigned long	calls;	/**< Operations made, a batch counting once. */
+	unsigned long	errors;	/**< Those that failed. A key that is not
+							 there is not a failure. */
+	unsigned long	bytes;	/**< Key and value bytes of the records the
+							 operations inserted, read, changed or
+							 deleted. */
+	unsigned long	ticks;	/**< Time spent in the operations, in
+							 @ref ION_DICTIONARY_CLOCK ticks. */
+	unsigned long	latency[ION_DICTIONARY_STATS_BUCKETS];
+	/**< Operations by how long they took, see @ref
+		 ION_DICTIONARY_STATS_BUCKETS. */
+} ion_dictionary_op_stats_t;
+
+/**
+@brief		Counters of a dictionary, see @ref dictionary_get_stats.
+*/
+typedef struct {
+	ion_dictionary_op_stats_t	ops[dictionary_op_count];	/**< By @ref ion_dictionary_op_t. */
+	ion_alloc_usage_t			memory;						/**< The memory of the
+																 dictionary, see
+																 @ref dictionary_get_memory. */
+} ion_dictionary_stats_t;
+
+/**
+@brief		How far a dictionary pushes its writes to storage on its own,
+			see @ref dictionary_set_durability.
+*/
+enum ION_DURABILITY {
+	/**> Writes reach storage whenever the dictionary and the system get
+		 to them. This is the default. */
+	durability_none,
+	/**> Every write reaches storage once the dictionary is closed. */
+	durability_close,
+	/**> Writes are pushed in groups, once a number of them are pending
+		 or some time has passed since the last push, and on close. */
+	durability_group,
+	/**> Every write reaches storage before it returns. */
+	durability_sync,
+};
+
+/**
+@brief		A type for the @ref ION_DURABILITY of a dictionary.
+*/
+typedef char ion_durability_t;
+
+/**
+@brief		The durability new dictionaries start with, and that the
+			master table is written with.
+*/
+#if !defined(ION_DEFAULT_DURABILITY)
+#define ION_DEFAULT_DURABILITY durability_none
+#endif
+
+/**
+@brief		The durability policy of a dictionary and the writes it has
+			not yet pushed.
+*/
+typedef struct {
+	ion_durability_t	level;		/**< The @ref ION_DURABILITY. */
+	unsigned int		group_ops;	/**< For @ref durability_group, the
+									 pending writes that are pushed
+									 together, 0 for no limit. */
+	unsigned long		group_ms;	/**< For @ref durability_group, the
+									 milliseconds after a push that the
+									 next write pushes again, 0 for no
+									 limit. */
+	unsigned int		pending;	/**< Writes since the last push. */
+	unsigned long		since;		/**< When the last push was. */
+} ion_dictionary_durability_t;
+
 /**
 @brief		A dictionary contains information regarding an instance of the
 			storage element and the associated handler.
@@ -252,6 +533,15 @@ struct dictionary {
 											 dictionary (but we don't
 											 know type). */
 	ion_dictionary_handler_t	*handler;	/**< Handler for the specific type. */
+	ion_dictionary_durability_t durability;	/**< When its writes are
+											 pushed to storage. */
+	ion_alloc_account_t			alloc_account;	/**< The account its engine's
+												 memory is charged to. */
+#if ION_DICTIONARY_STATS
+	ion_dictionary_stats_t		*stats;	/**< The counters of the dictionary,
+										 or NULL if it does not keep
+										 them. */
+#endif
 };
 
 /**
@@ -279,7 +569,9 @@ enum ION_PREDICATE_TYPE {
 	predicate_equality,	/**< Predicate type for equality cursors. */
 	predicate_range,/**< Predicate tyoe for range cursors. */
 	predicate_all_records,	/**< Predicate type for cursors over all records. */
-	predicate_predicate	/**< Predicate type for predicate cursors. */
+	predicate_predicate,/**< Predicate type for predicate cursors. */
+	predicate_prefix	/**< Predicate type for cursors over the keys
+						 starting with some bytes. */
 };
 
 /**
@@ -302,6 +594,18 @@ typedef struct range_statement {
 	/**< The upper value in the range */
 } ion_range_statement_t;
 
+/**
+@brief		This is a predicate data object for prefix queries, over char
+			array and string keys.
+@details	This is to be used by the user to setup a predicate for evaluation.
+*/
+typedef struct prefix_statement {
+	ion_key_t		prefix;
+	/**< The bytes the keys start with. */
+	ion_key_size_t	length;
+	/**< How many there are, at most the key size. */
+} ion_prefix_statement_t;
+
 /**
 @brief		Predicate type for cursors that iterate over all records in set.
 @details	This is to be used by the user to setup a predicate for evaluation.
@@ -311,13 +615,26 @@ typedef struct ion_all_records_statement {
 	char unused;
 } ion_all_records_statement_t;
 
+/**
+@brief		A test of a whole record, for predicate (conditional) queries.
+@details	It is called on each record in the place the implementation
+			holds it, so it must neither keep nor change @p key or @p value.
+*/
+typedef ion_boolean_t (*ion_predicate_filter_t)(
+	ion_key_t	key,
+	ion_value_t value,
+	void		*context
+);
+
 /**
 @brief		Predicate type for predicate (conditional) queries.
 @details	This is to be used by the user to setup a predicate for evaluation.
 */
 typedef struct other_predicate_statement {
-	/**> For now, other_predicate has no required information. */
-	char unused;
+	ion_predicate_filter_t	filter;
+	/**< The test a record must pass. */
+	void					*context;
+	/**< Passed to @c filter, for whatever it needs. */
 } ion_other_predicate_statement_t;
 
 /**
@@ -333,6 +650,8 @@ union predicate_statement {
 	ion_other_predicate_statement_t other_predicate;
 	/**> An all records predicate statement. */
 	ion_all_records_statement_t		all_records;
+	/**> A prefix predicate statement. */
+	ion_prefix_statement_t			prefix;
 };
 
 /**
@@ -375,6 +694,13 @@ struct dictionary_cursor {
 												 object. */
 	ion_predicate_t		*predicate;				/**< The predicate for the cursor.
 												*/
+	ion_value_size_t	value_offset;			/**< The first byte of each value
+												 wanted, see
+												 @ref dictionary_cursor_project */
+	ion_value_size_t	value_size;				/**< How many are wanted from
+												 there. An implementation may
+												 copy only these, the rest of
+												 the value left as it was */
 
 	ion_cursor_status_t (*next)(
 		ion_dict_cursor_t *,
@@ -382,6 +708,15 @@ struct dictionary_cursor {
 	);
 	/**< A pointer to the next function,
 		 which sets ion_cursor_status_t). */
+	int (*next_batch)(
+		ion_dict_cursor_t *,
+		ion_key_t,
+		ion_value_t,
+		int
+	);
+	/**< A pointer to the function reading
+		 several records at once, or NULL
+		 to read each with @c next. */
 	void (*destroy)(
 		ion_dict_cursor_t **
 	);
@@ -390,6 +725,69 @@ struct dictionary_cursor {
 		 internal memory). */
 };
 
+/**
+@brief		How many records @ref dictionary_bulk_load gives each insert of
+			a dictionary with no bulk loader of its own.
+*/
+#if !defined(ION_BULK_LOAD_BATCH)
+#if defined(ARDUINO)
+#define ION_BULK_LOAD_BATCH 4
+#else
+#define ION_BULK_LOAD_BATCH 64
+#endif
+#endif
+
+/**
+@brief		How many bytes of records a snapshot cursor given a budget of
+			0 holds in memory, before it writes the rest to a file. See
+			@ref dictionary_find_snapshot.
+*/
+#if !defined(ION_SNAPSHOT_MEMORY_BUDGET)
+#if defined(ARDUINO)
+#define ION_SNAPSHOT_MEMORY_BUDGET 256
+#else
+#define ION_SNAPSHOT_MEMORY_BUDGET 1048576
+#endif
+#endif
+
+/**
+@brief		The first dictionary id given to the files snapshot cursors
+			write their records to, kept to seven digits so the names
+			fit @ref ION_MAX_FILENAME_LENGTH.
+*/
+#if !defined(ION_SNAPSHOT_ID_BASE)
+#define ION_SNAPSHOT_ID_BASE 9000000
+#endif
+
+/**
+@brief		A cursor over a copy of the records a predicate matched when
+			it was made, see @ref dictionary_find_snapshot.
+@details	The records are kept in memory, in the order the dictionary
+			gave them, until the budget is spent; the rest are appended
+			to a flat file, which is read once the memory is.
+*/
+typedef struct snapshot_cursor {
+	ion_dict_cursor_t			super;		/**< Cursor supertype this type
+											 inherits from */
+	ion_predicate_t				predicate;	/**< The type of the predicate
+											 matched, and its statement as
+											 given, which may no longer hold */
+	ion_byte_t					*keys;		/**< The keys held in memory,
+											 back to back */
+	ion_byte_t					*values;	/**< Their values */
+	int							count;		/**< How many records are in
+											 memory */
+	int							position;	/**< The record in memory read
+											 next */
+	ion_boolean_t				spilled;	/**< Whether records went on to
+											 @p file */
+	ion_dictionary_handler_t	file_handler;	/**< The handler of @p file */
+	ion_dictionary_t			file;		/**< The records past the budget */
+	ion_dict_cursor_t			*file_cursor;	/**< A cursor over @p file, or
+												 @c NULL until the memory has
+												 been read */
+} ion_snapshot_cursor_t;
+
 /**
 @brief		The list of write concern options for supported dictionary
 			implementations.
@@ -421,6 +819,46 @@ typedef struct hash_bucket {
 	ion_byte_t	data[];			/**< the data in the bucket */
 } ion_hash_bucket_t;
 
+/**
+@brief		The number of bins the probe lengths of a hash table operation
+			are counted in, see @ref ion_hash_op_stats_t.
+*/
+#if !defined(ION_HASH_PROBE_BINS)
+#define ION_HASH_PROBE_BINS 8
+#endif
+
+/**
+@brief		Probe lengths of one kind of hash table operation.
+@details	The probe length of an operation is the number of buckets from
+			the home bucket of its key to the bucket it stopped at, both
+			included: the bucket holding the key, or the empty bucket that
+			shows the key is absent.
+*/
+typedef struct {
+	unsigned long	calls;		/**< Operations counted. */
+	unsigned long	probes;		/**< Sum of their probe lengths. */
+	int				max_probes;	/**< The longest probe length seen. */
+	unsigned long	histogram[ION_HASH_PROBE_BINS];	/**< Bin i counts probe
+													 lengths from 2^i up to
+													 2^(i+1) - 1, the last
+													 bin all longer ones. */
+} ion_hash_op_stats_t;
+
+/**
+@brief		Statistics of one linear probing hash table, for telling
+			whether it is degrading through clustering.
+*/
+typedef struct {
+	ion_hash_op_stats_t insert;		/**< Inserts and updates. */
+	ion_hash_op_stats_t get;		/**< Lookups. */
+	ion_hash_op_stats_t remove;		/**< Deletes. */
+	unsigned long		wraps;		/**< Probes that ran past the last
+									 bucket back to the first. */
+	int					buckets;	/**< The size of the table. */
+	int					occupied;	/**< Buckets holding a record. */
+	int					deleted;	/**< Buckets holding a tombstone. */
+} ion_hash_stats_t;
+
 /**
 @brief		Function signature for all init functions.
 */
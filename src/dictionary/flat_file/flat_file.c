@@ -21,7 +21,300 @@
 */
 /******************************************************************************/
 
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "flat_file.h"
+#include "../../file/ion_file.h"
+
+#if !defined(ARDUINO)
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#if ION_FLAT_FILE_USE_MMAP
+#include <sys/mman.h>
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+#include <float.h>
+#endif
+
+#if ION_FLAT_FILE_USE_MMAP
+
+/**
+@brief		Makes the mapping of a flat file cover, and agree with, every row before the EOF position.
+@details	Rows written since the last call are flushed so that the mapping sees them. When the
+			file has grown past the mapping, it is remapped at least twice as large, which drops the
+			loaded region since it may point into the old mapping. If remapping fails, the flat file
+			falls back to reading rows into its buffer from then on.
+@param[in]	flat_file
+				Which flat file instance to synchronize the mapping of.
+@return		@p boolean_true if rows may be read through the mapping.
+*/
+static ion_boolean_t
+flat_file_map_rows(
+	ion_flat_file_t *flat_file
+) {
+	if (NULL == flat_file->map) {
+		return boolean_false;
+	}
+
+	if (flat_file->map_dirty) {
+		if (0 != fflush(flat_file->data_file)) {
+			return boolean_false;
+		}
+
+		flat_file->map_dirty = boolean_false;
+	}
+
+	if ((size_t) flat_file->eof_position <= flat_file->map_size) {
+		return boolean_true;
+	}
+
+	size_t map_size = flat_file->map_size * 2;
+
+	if (map_size < (size_t) flat_file->eof_position) {
+		map_size = flat_file->eof_position;
+	}
+
+	munmap(flat_file->map, flat_file->map_size);
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+	/* Pages past the end of the file are never touched, since every row read lies before the EOF position. */
+	void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fileno(flat_file->data_file), 0);
+
+	if (MAP_FAILED == map) {
+		flat_file->map		= NULL;
+		flat_file->map_size = 0;
+		return boolean_false;
+	}
+
+	flat_file->map		= map;
+	flat_file->map_size = map_size;
+
+	return boolean_true;
+}
+
+#endif
+
+/**
+@brief		Picks how many rows to buffer when the dictionary size leaves it to the flat file.
+@details	This is one device block of rows. On hosts, the block is the preferred I/O
+			size of the data file, otherwise it is @ref ION_FLAT_FILE_DEVICE_BLOCK_SIZE.
+			With @ref ION_FILE_DIRECT it is at least @ref ION_FILE_DIRECT_ALIGNMENT.
+@param[in]	flat_file
+				Which flat file instance to size the buffer of. Its data file must be open.
+@return		How many rows to buffer, at least one.
+*/
+static ion_dictionary_size_t
+flat_file_device_rows(
+	ion_flat_file_t *flat_file
+) {
+	size_t block_size = ION_FLAT_FILE_DEVICE_BLOCK_SIZE;
+
+#if !defined(ARDUINO)
+	struct stat file_stat;
+
+	if ((0 == fstat(fileno(flat_file->data_file), &file_stat)) && (file_stat.st_blksize > 0)) {
+		block_size = file_stat.st_blksize;
+	}
+
+#endif
+#if defined(ION_FILE_DIRECT)
+
+	/* with stdio unbuffered, rows are read a whole aligned block at a time */
+	if (block_size < ION_FILE_DIRECT_ALIGNMENT) {
+		block_size = ION_FILE_DIRECT_ALIGNMENT;
+	}
+
+#endif
+
+	return block_size > flat_file->row_size ? block_size / flat_file->row_size : 1;
+}
+
+#if ION_FLAT_FILE_USE_BLOOM
+
+/**
+@brief		Describes the Bloom filter saved in a sidecar file, so that one saved
+			with different settings is not mistaken for a current one.
+*/
+typedef struct {
+	/**> The @ref ION_FLAT_FILE_BLOOM_BYTES the filter was saved with. */
+	uint32_t	num_bytes;
+	/**> The @ref ION_FLAT_FILE_BLOOM_HASHES the filter was saved with. */
+	uint32_t	num_hashes;
+} ion_flat_file_bloom_header_t;
+
+/**
+@brief		Allocates the Bloom filter of a flat file, loading it from its sidecar file if one was saved.
+@details	The sidecar is removed once loaded, and only written back on close, so that a
+			session that ends without closing leaves no stale filter behind. If the filter
+			cannot be allocated, the flat file runs without one.
+@param[in]	flat_file
+				Which flat file instance to load the filter of.
+@param[in]	id
+				The ID of the dictionary, which names the sidecar file.
+*/
+static void
+flat_file_bloom_load(
+	ion_flat_file_t		*flat_file,
+	ion_dictionary_id_t id
+) {
+	char							filename[ION_MAX_FILENAME_LENGTH];
+	ion_flat_file_bloom_header_t	header;
+	FILE							*bloom_file;
+
+	flat_file->bloom_ready	= boolean_false;
+	flat_file->bloom		= ion_calloc(ion_alloc_buffer, 1, ION_FLAT_FILE_BLOOM_BYTES);
+
+	if ((NULL == flat_file->bloom) || (dictionary_get_filename(id, "ffb", filename) >= ION_MAX_FILENAME_LENGTH)) {
+		ion_free(flat_file->bloom);
+		flat_file->bloom = NULL;
+		return;
+	}
+
+	bloom_file = fopen(filename, "rb");
+
+	if (NULL == bloom_file) {
+		return;
+	}
+
+	if ((1 == fread(&header, sizeof(header), 1, bloom_file)) && (ION_FLAT_FILE_BLOOM_BYTES == header.num_bytes) && (ION_FLAT_FILE_BLOOM_HASHES == header.num_hashes) && (1 == fread(flat_file->bloom, ION_FLAT_FILE_BLOOM_BYTES, 1, bloom_file))) {
+		flat_file->bloom_ready = boolean_true;
+	}
+
+	fclose(bloom_file);
+	fremove(filename);
+}
+
+/**
+@brief		Saves the Bloom filter of a flat file to its sidecar file, and frees it.
+@details	The filter is only a cache of the data file, so a failed save just removes
+			the sidecar, and the next session rebuilds the filter from the rows.
+@param[in]	flat_file
+				Which flat file instance to save the filter of.
+*/
+static void
+flat_file_bloom_save(
+	ion_flat_file_t *flat_file
+) {
+	char	filename[ION_MAX_FILENAME_LENGTH];
+	FILE	*bloom_file;
+
+	if ((NULL != flat_file->bloom) && flat_file->bloom_ready && (dictionary_get_filename(flat_file->super.id, "ffb", filename) < ION_MAX_FILENAME_LENGTH) && (NULL != (bloom_file = fopen(filename, "wb")))) {
+		ion_boolean_t saved = 1 == fwrite(&(ion_flat_file_bloom_header_t) { ION_FLAT_FILE_BLOOM_BYTES, ION_FLAT_FILE_BLOOM_HASHES }, sizeof(ion_flat_file_bloom_header_t), 1, bloom_file);
+
+		saved	= saved && 1 == fwrite(flat_file->bloom, ION_FLAT_FILE_BLOOM_BYTES, 1, bloom_file);
+		saved	= (0 == fclose(bloom_file)) && saved;
+
+		if (!saved) {
+			fremove(filename);
+		}
+	}
+
+	ion_free(flat_file->bloom);
+	flat_file->bloom		= NULL;
+	flat_file->bloom_ready	= boolean_false;
+}
+
+#endif
+
+#if ION_FLAT_FILE_SAVE_META
+
+/**
+@brief		Describes a flat file as it was closed, saved in a sidecar file.
+*/
+typedef struct {
+	/**> The row size the file was written with. */
+	uint32_t	row_size;
+	/**> Where its rows started. */
+	ion_fpos_t	start_of_data;
+	/**> The size of the data file. */
+	ion_fpos_t	file_size;
+	/**> One past the last row that was not empty. */
+	ion_fpos_t	eof_position;
+	/**> The tombstones among the rows. */
+	ion_fpos_t	num_tombstones;
+} ion_flat_file_meta_t;
+
+/**
+@brief		Takes where the rows of a flat file end from its sidecar file, if one was
+			saved for the file as it is.
+@param[in]	flat_file
+				Which flat file instance to load the description of. Its start of
+				data and row size are set.
+@param[in]	file_size
+				The size of the data file now.
+@return		Whether the end of the rows and the tombstones were set.
+*/
+static ion_boolean_t
+flat_file_meta_load(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		file_size
+) {
+	char					filename[ION_MAX_FILENAME_LENGTH];
+	ion_flat_file_meta_t	meta;
+	FILE					*meta_file;
+	ion_boolean_t			loaded = boolean_false;
+
+	if ((dictionary_get_filename(flat_file->super.id, "ffm", filename) >= ION_MAX_FILENAME_LENGTH) || (NULL == (meta_file = fopen(filename, "rb")))) {
+		return boolean_false;
+	}
+
+	if ((1 == fread(&meta, sizeof(meta), 1, meta_file)) && (flat_file->row_size == meta.row_size) && (flat_file->start_of_data == meta.start_of_data) && (file_size == meta.file_size) && (meta.eof_position >= meta.start_of_data) && (meta.eof_position <= file_size) && (0 == (meta.eof_position - meta.start_of_data) % flat_file->row_size) && (meta.num_tombstones >= 0)) {
+		flat_file->eof_position		= meta.eof_position;
+		flat_file->num_tombstones	= meta.num_tombstones;
+		loaded						= boolean_true;
+	}
+
+	fclose(meta_file);
+	fremove(filename);
+
+	return loaded;
+}
+
+/**
+@brief		Saves where the rows of a flat file end to its sidecar file.
+@details	The description is only a cache of the data file, so a failed save just
+			removes the sidecar, and the next open scans.
+@param[in]	flat_file
+				Which flat file instance to save the description of.
+*/
+static void
+flat_file_meta_save(
+	ion_flat_file_t *flat_file
+) {
+	char					filename[ION_MAX_FILENAME_LENGTH];
+	ion_flat_file_meta_t	meta;
+	FILE					*meta_file;
+	ion_boolean_t			saved;
+
+	if ((0 != fseek(flat_file->data_file, 0, SEEK_END)) || (dictionary_get_filename(flat_file->super.id, "ffm", filename) >= ION_MAX_FILENAME_LENGTH)) {
+		return;
+	}
+
+	meta.row_size		= (uint32_t) flat_file->row_size;
+	meta.start_of_data	= flat_file->start_of_data;
+	meta.file_size		= ftell(flat_file->data_file);
+	meta.eof_position	= flat_file->eof_position;
+	meta.num_tombstones = flat_file->num_tombstones;
+
+	if ((-1 == meta.file_size) || (NULL == (meta_file = fopen(filename, "wb")))) {
+		return;
+	}
+
+	saved	= 1 == fwrite(&meta, sizeof(meta), 1, meta_file);
+	saved	= (0 == fclose(meta_file)) && saved;
+
+	if (!saved) {
+		fremove(filename);
+	}
+}
+
+#endif
 
 ion_err_t
 flat_file_initialize(
@@ -32,11 +325,6 @@ flat_file_initialize(
 	ion_value_size_t		value_size,
 	ion_dictionary_size_t	dictionary_size
 ) {
-	if (dictionary_size <= 0) {
-		/* Clamp the dictionary size since we always need at least 1 row to buffer */
-		dictionary_size = 1;
-	}
-
 	flat_file->super.key_type			= key_type;
 	flat_file->super.record.key_size	= key_size;
 	flat_file->super.record.value_size	= value_size;
@@ -48,6 +336,7 @@ flat_file_initialize(
 		return err_dictionary_initialization_failed;
 	}
 
+	flat_file->super.id					= id;
 	flat_file->sorted_mode				= boolean_false;/* By default, we don't use sorted mode */
 	flat_file->num_buffered				= dictionary_size;	/* TODO: Sorted mode needs to be written out as a header? */
 	flat_file->current_loaded_region	= -1;	/* No loaded region yet */
@@ -64,6 +353,11 @@ flat_file_initialize(
 		}
 	}
 
+#if defined(ION_FILE_DIRECT)
+	/* Direct I/O leaves the row buffer as the only buffer of rows. */
+	setvbuf(flat_file->data_file, NULL, _IONBF, 0);
+#endif
+
 	/* For now, we don't have any header information. But we write some garbage there just so that
 	   we can verify that the code to handle the header is working.*/
 	fwrite(&(int) { 0xADDE }, sizeof(int), 1, flat_file->data_file);
@@ -76,8 +370,19 @@ flat_file_initialize(
 
 	/* A record is laid out as: | STATUS |	  KEY	 |	   VALUE	  | */
 	/*				   Bytes:	(1)	 (key_size)   (value_size)	*/
+#if ION_FLAT_FILE_SPLIT_VALUES
+	/* Except that the values are kept in a file of their own. */
+	flat_file->row_size = sizeof(ion_flat_file_row_status_t) + key_size;
+#else
 	flat_file->row_size = sizeof(ion_flat_file_row_status_t) + key_size + value_size;
-	flat_file->buffer	= calloc(flat_file->num_buffered, flat_file->row_size);
+#endif
+
+	if ((0 == dictionary_size) || ((ion_dictionary_size_t) -1 == dictionary_size)) {
+		/* No size given, so buffer a device block of rows. We always need at least 1 row to buffer. */
+		flat_file->num_buffered = flat_file_device_rows(flat_file);
+	}
+
+	flat_file->buffer = ion_calloc(ion_alloc_buffer, flat_file->num_buffered, flat_file->row_size);
 
 	if (NULL == flat_file->buffer) {
 		fclose(flat_file->data_file);
@@ -96,13 +401,97 @@ flat_file_initialize(
 		return err_file_read_error;
 	}
 
+#if ION_FLAT_FILE_SPLIT_VALUES
+	dictionary_get_filename(id, "ffv", filename);
+	flat_file->value_buffer = ion_alloc(ion_alloc_buffer, value_size);
+	flat_file->value_file	= fopen(filename, "r+b");
+
+	if (NULL == flat_file->value_file) {
+		flat_file->value_file = fopen(filename, "w+b");
+	}
+
+#if defined(ION_FILE_DIRECT)
+
+	if (NULL != flat_file->value_file) {
+		setvbuf(flat_file->value_file, NULL, _IONBF, 0);
+	}
+
+#endif
+
+	if ((NULL == flat_file->value_buffer) || (NULL == flat_file->value_file)) {
+		ion_err_t err = NULL == flat_file->value_buffer ? err_out_of_memory : err_file_open_error;
+
+		if (NULL != flat_file->value_file) {
+			fclose(flat_file->value_file);
+		}
+
+		ion_free(flat_file->value_buffer);
+		ion_free(flat_file->buffer);
+		fclose(flat_file->data_file);
+		return err;
+	}
+
+#endif
+
+	flat_file->block			= flat_file->buffer;
+	flat_file->num_tombstones	= 0;
+
+#if ION_FLAT_FILE_USE_FENCES
+	flat_file->fence_keys		= NULL;
+	flat_file->num_fences		= 0;
+	flat_file->fence_capacity	= 0;
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+	flat_file->segments			= NULL;
+	flat_file->num_segments		= 0;
+	flat_file->segment_capacity = 0;
+	flat_file->learned_rows		= 0;
+#endif
+
+#if ION_FLAT_FILE_USE_BLOOM
+	flat_file_bloom_load(flat_file, id);
+#endif
+
+#if ION_FLAT_FILE_USE_INDEX
+	flat_file->index			= NULL;
+	flat_file->index_capacity	= 0;
+	flat_file->index_count		= 0;
+	flat_file->index_ready		= boolean_false;
+#endif
+
+#if ION_FLAT_FILE_USE_MMAP
+	/* The header was just written, so there is always something to map. If this fails, rows are read into the buffer instead. */
+	flat_file->map_dirty	= boolean_false;
+	flat_file->map_size		= 0;
+	flat_file->map			= NULL;
+
+	if (0 == fflush(flat_file->data_file)) {
+		void *map = mmap(NULL, flat_file->eof_position, PROT_READ, MAP_SHARED, fileno(flat_file->data_file), 0);
+
+		if (MAP_FAILED != map) {
+			flat_file->map		= map;
+			flat_file->map_size = flat_file->eof_position;
+		}
+	}
+#endif
+
+#if ION_FLAT_FILE_SAVE_META
+
+	/* The file as it was closed needs no scan. */
+	if (flat_file_meta_load(flat_file, flat_file->eof_position)) {
+		return err_ok;
+	}
+
+#endif
+
 	/* Now move the eof to the last non-empty row in the file */
 	ion_fpos_t			loc = -1;
 	ion_flat_file_row_t row;
-	ion_err_t			err = flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, flat_file_predicate_not_empty);
+	ion_err_t			err = flat_file_scan_match(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL });
 
 	if ((err_ok != err) && (err_file_hit_eof != err)) {
-		fclose(flat_file->data_file);
+		flat_file_close(flat_file);
 		return err;
 	}
 
@@ -121,6 +510,12 @@ ion_err_t
 flat_file_destroy(
 	ion_flat_file_t *flat_file
 ) {
+#if ION_FLAT_FILE_USE_BLOOM
+	/* Drop the filter first, so that closing does not save it. */
+	ion_free(flat_file->bloom);
+	flat_file->bloom = NULL;
+#endif
+
 	ion_err_t err = flat_file_close(flat_file);
 
 	if (err_ok != err) {
@@ -131,126 +526,1581 @@ flat_file_destroy(
 
 	dictionary_get_filename(flat_file->super.id, "ffs", filename);
 
-	if (0 != fremove(filename)) {
-		return err_file_delete_error;
+	if (0 != fremove(filename)) {
+		return err_file_delete_error;
+	}
+
+	flat_file->data_file = NULL;
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+	dictionary_get_filename(flat_file->super.id, "ffv", filename);
+
+	if (0 != fremove(filename)) {
+		return err_file_delete_error;
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_BLOOM
+	/* A sidecar is only left if the file was last closed rather than destroyed. */
+	dictionary_get_filename(flat_file->super.id, "ffb", filename);
+	fremove(filename);
+#endif
+
+#if ION_FLAT_FILE_SAVE_META
+	/* Closing just saved one. */
+	dictionary_get_filename(flat_file->super.id, "ffm", filename);
+	fremove(filename);
+#endif
+
+	return err_ok;
+}
+
+/**
+@brief		Key layouts that @ref flat_file_scan_match compares natively.
+*/
+typedef enum {
+	ION_FLAT_FILE_KEY_GENERIC, ION_FLAT_FILE_KEY_SIGNED32, ION_FLAT_FILE_KEY_SIGNED64, ION_FLAT_FILE_KEY_UNSIGNED32, ION_FLAT_FILE_KEY_UNSIGNED64
+} ion_flat_file_key_kind_t;
+
+/**
+@brief		Works out whether the keys of a flat file can be compared as native integers.
+@details	This is only the case for the stock numeric comparators, which order
+			keys the same way a native comparison does.
+@param[in]	flat_file
+				Which flat file instance to inspect.
+@return		The key layout to use in a scan.
+*/
+static ion_flat_file_key_kind_t
+flat_file_key_kind(
+	ion_flat_file_t *flat_file
+) {
+	ion_key_size_t key_size = flat_file->super.record.key_size;
+
+	if (dictionary_is_signed_compare(flat_file->super.compare)) {
+		if (sizeof(int32_t) == key_size) {
+			return ION_FLAT_FILE_KEY_SIGNED32;
+		}
+
+		if (sizeof(int64_t) == key_size) {
+			return ION_FLAT_FILE_KEY_SIGNED64;
+		}
+	}
+	else if (dictionary_is_unsigned_compare(flat_file->super.compare)) {
+		if (sizeof(uint32_t) == key_size) {
+			return ION_FLAT_FILE_KEY_UNSIGNED32;
+		}
+
+		if (sizeof(uint64_t) == key_size) {
+			return ION_FLAT_FILE_KEY_UNSIGNED64;
+		}
+	}
+
+	return ION_FLAT_FILE_KEY_GENERIC;
+}
+
+/**
+@brief		Computes and checks the offsets a scan runs between.
+@param[in]	flat_file
+				Which flat file instance to scan.
+@param[in]	start_location
+				Where to begin the scan, as given to @ref flat_file_scan.
+@param[in]	scan_direction
+				Which direction the scan moves in.
+@param[out]	cur_offset
+				The file offset the scan starts at.
+@param[out]	end_offset
+				The file offset the scan stops at.
+@return		@ref err_out_of_bounds if the start lies outside the data, otherwise @ref err_ok.
+*/
+static ion_err_t
+flat_file_scan_bounds(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		start_location,
+	ion_byte_t		scan_direction,
+	ion_fpos_t		*cur_offset,
+	ion_fpos_t		*end_offset
+) {
+	*cur_offset = flat_file->start_of_data + start_location * flat_file->row_size;
+	*end_offset = ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? flat_file->eof_position : flat_file->start_of_data;
+
+	if (-1 == start_location) {
+		if (ION_FLAT_FILE_SCAN_FORWARDS == scan_direction) {
+			*cur_offset = flat_file->start_of_data;
+		}
+		else {
+			*cur_offset = flat_file->eof_position;
+		}
+	}
+
+	/* If we're scanning backwards, bump the cur_offset up one record so that we read the record we're sitting on. */
+	/* We don't do this if we're positioned at the EOF, since otherwise we would read garbage. */
+	if ((ION_FLAT_FILE_SCAN_BACKWARDS == scan_direction) && (*cur_offset != flat_file->eof_position)) {
+		*cur_offset += flat_file->row_size;
+	}
+
+	if ((*cur_offset > flat_file->eof_position) || (*cur_offset < flat_file->start_of_data)) {
+		return err_out_of_bounds;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Loads the next block of rows of a scan into the buffer.
+@details	On return, @p num_in_buffer rows starting at row index
+			@p current_loaded_region are held at @p block. When the file is
+			mapped, the block is addressed in place and holds up to
+			@ref ION_FLAT_FILE_READ_AHEAD_BYTES of rows, and the next block is
+			already being read ahead.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	cur_offset
+				The file offset of the scan. It is moved past the block read.
+@param[in]	end_offset
+				The file offset the scan stops at.
+@param[in]	scan_direction
+				Which direction the scan moves in.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_scan_block(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		*cur_offset,
+	ion_fpos_t		end_offset,
+	ion_byte_t		scan_direction
+) {
+#if ION_FLAT_FILE_USE_MMAP
+
+	if (flat_file_map_rows(flat_file)) {
+		ion_fpos_t	window			= flat_file->row_size * (ION_FLAT_FILE_READ_AHEAD_BYTES > flat_file->row_size * flat_file->num_buffered ? ION_FLAT_FILE_READ_AHEAD_BYTES / flat_file->row_size : flat_file->num_buffered);
+		ion_fpos_t	first_offset;
+		ion_fpos_t	last_offset;
+		ion_fpos_t	ahead_first;
+		ion_fpos_t	ahead_last;
+
+		if (ION_FLAT_FILE_SCAN_FORWARDS == scan_direction) {
+			first_offset	= *cur_offset;
+			last_offset		= end_offset - first_offset > window ? first_offset + window : end_offset;
+			ahead_first		= last_offset;
+			ahead_last		= end_offset - ahead_first > window ? ahead_first + window : end_offset;
+			*cur_offset		= last_offset;
+		}
+		else {
+			last_offset		= *cur_offset;
+			first_offset	= last_offset - end_offset > window ? last_offset - window : end_offset;
+			ahead_last		= first_offset;
+			ahead_first		= ahead_last - end_offset > window ? ahead_last - window : end_offset;
+			*cur_offset		= first_offset;
+		}
+
+		if (ahead_first != ahead_last) {
+			/* Start reading the next window while this one is worked on. The advice must start on a page. */
+			ion_fpos_t page_start = ahead_first - ahead_first % sysconf(_SC_PAGESIZE);
+
+			posix_madvise(flat_file->map + page_start, ahead_last - page_start, POSIX_MADV_WILLNEED);
+		}
+
+		flat_file->block					= flat_file->map + first_offset;
+		flat_file->current_loaded_region	= (first_offset - flat_file->start_of_data) / flat_file->row_size;
+		flat_file->num_in_buffer			= (last_offset - first_offset) / flat_file->row_size;
+
+		return err_ok;
+	}
+
+#endif
+
+	if (0 != fseek(flat_file->data_file, *cur_offset, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	/* We set cur_offset to be the next block to read after this next code segment, so */
+	/* we need t save what block we're currently reading now for location calculation purposes */
+	ion_fpos_t	prev_offset				= *cur_offset;
+	size_t		num_records_to_process	= flat_file->num_buffered;
+
+	if (ION_FLAT_FILE_SCAN_FORWARDS == scan_direction) {
+		/* It's possible for this to do a partial read (if you're close to EOF), calculate how many we need to read */
+		size_t records_left = (end_offset - *cur_offset) / flat_file->row_size;
+
+		num_records_to_process = records_left > (unsigned) /* TODO HACK: remove this */ flat_file->num_buffered ? (unsigned) flat_file->num_buffered : records_left;
+
+		if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
+			return err_file_incomplete_read;
+		}
+
+		if (-1 == (*cur_offset = ftell(flat_file->data_file))) {
+			return err_file_read_error;
+		}
+	}
+	else {
+		/* Move the offset pointer to the next read location, clamp it at start_of_file if we go too far. */
+		*cur_offset -= flat_file->row_size * flat_file->num_buffered;
+
+		if (*cur_offset < flat_file->start_of_data) {
+			/* We know how many rows we went past the start of file, calculate it so we don't fread too much */
+			num_records_to_process	= flat_file->num_buffered - (flat_file->start_of_data - *cur_offset) / flat_file->row_size;
+			*cur_offset				= flat_file->start_of_data;
+		}
+
+		if (0 != fseek(flat_file->data_file, *cur_offset, SEEK_SET)) {
+			return err_file_bad_seek;
+		}
+
+		if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
+			return err_file_incomplete_read;
+		}
+
+		/* In this case, the prev_offset is actually the cur_offset. */
+		prev_offset = *cur_offset;
+	}
+
+	flat_file->block					= flat_file->buffer;
+	flat_file->current_loaded_region	= (prev_offset - flat_file->start_of_data) / flat_file->row_size;
+	flat_file->num_in_buffer			= num_records_to_process;
+
+	return err_ok;
+}
+
+/**
+@brief		Points a row struct at the given row of the loaded region.
+*/
+static void
+flat_file_buffered_row(
+	ion_flat_file_t		*flat_file,
+	int32_t				index,
+	ion_flat_file_row_t *row
+) {
+	size_t cur_rec = index * flat_file->row_size;
+
+	/* This cast is done because in the future, the status could possibly be a non-byte type */
+	row->row_status = *((ion_flat_file_row_status_t *) &flat_file->block[cur_rec]);
+	row->key		= &flat_file->block[cur_rec + sizeof(ion_flat_file_row_status_t)];
+#if ION_FLAT_FILE_SPLIT_VALUES
+	row->value		= NULL;
+#else
+	row->value		= &flat_file->block[cur_rec + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
+#endif
+}
+
+/**
+@brief		Points a row struct at the value of the given row.
+@details	In the row layout the value is already in place, so this does nothing. With
+			@ref ION_FLAT_FILE_SPLIT_VALUES, the value is read into the value buffer, which
+			leaves the loaded region of key rows intact.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	location
+				Which row index to read the value of.
+@param[in]	row
+				The row to give the value to.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_row_value(
+	ion_flat_file_t		*flat_file,
+	ion_fpos_t			location,
+	ion_flat_file_row_t *row
+) {
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+	if (0 != fseek(flat_file->value_file, location * flat_file->super.record.value_size, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	if (1 != fread(flat_file->value_buffer, flat_file->super.record.value_size, 1, flat_file->value_file)) {
+		return err_file_incomplete_read;
+	}
+
+	row->value = flat_file->value_buffer;
+#else
+	UNUSED(flat_file);
+	UNUSED(location);
+	UNUSED(row);
+#endif
+
+	return err_ok;
+}
+
+/**
+@brief		Reads the status and key of the row at the given location, as
+			@ref flat_file_read_row does.
+@details	With @ref ION_FLAT_FILE_SPLIT_VALUES, the value is not read and is given
+			back as @p NULL, so that searches only touch key rows.
+*/
+static ion_err_t
+flat_file_read_key(
+	ion_flat_file_t		*flat_file,
+	ion_fpos_t			location,
+	ion_flat_file_row_t *row
+) {
+	ion_byte_t *rec;
+
+	if ((flat_file->current_loaded_region != -1) && (location >= flat_file->current_loaded_region) && ((unsigned) location < flat_file->current_loaded_region + flat_file->num_in_buffer)) {
+		/* Cache hit, return directly from the loaded region */
+		rec = &flat_file->block[(location - flat_file->current_loaded_region) * flat_file->row_size];
+	}
+
+#if ION_FLAT_FILE_USE_MMAP
+	else if ((location >= 0) && (flat_file->start_of_data + (location + 1) * (ion_fpos_t) flat_file->row_size <= flat_file->eof_position) && flat_file_map_rows(flat_file)) {
+		/* Rows before the EOF can be addressed in the mapping without a copy */
+		rec = &flat_file->map[flat_file->start_of_data + location * flat_file->row_size];
+	}
+#endif
+	else {
+		/* Cache miss, have to re-read from file. This overwrites the start of the buffer, so drop the loaded region. */
+		flat_file->current_loaded_region	= -1;
+		flat_file->num_in_buffer			= 0;
+
+		if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
+			return err_file_bad_seek;
+		}
+
+		if (1 != fread(flat_file->buffer, sizeof(row->row_status), 1, flat_file->data_file)) {
+			return err_file_incomplete_write;
+		}
+
+		if (1 != fread(flat_file->buffer + sizeof(row->row_status), flat_file->super.record.key_size, 1, flat_file->data_file)) {
+			return err_file_incomplete_write;
+		}
+
+#if !ION_FLAT_FILE_SPLIT_VALUES
+
+		if (1 != fread(flat_file->buffer + sizeof(row->row_status) + flat_file->super.record.key_size, flat_file->super.record.value_size, 1, flat_file->data_file)) {
+			return err_file_incomplete_write;
+		}
+
+#endif
+
+		rec = flat_file->buffer;
+	}
+
+	row->row_status = *((ion_flat_file_row_status_t *) rec);
+	row->key		= rec + sizeof(ion_flat_file_row_status_t);
+#if ION_FLAT_FILE_SPLIT_VALUES
+	row->value		= NULL;
+#else
+	row->value		= rec + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size;
+#endif
+
+	return err_ok;
+}
+
+#if ION_FLAT_FILE_USE_BLOOM || ION_FLAT_FILE_USE_INDEX
+
+/**
+@brief		Whether a flat file uses a stock comparator, which treats keys as equal
+			exactly when the bytes that @ref flat_file_key_hash looks at are.
+*/
+static ion_boolean_t
+flat_file_key_hashable(
+	ion_flat_file_t *flat_file
+) {
+	ion_dictionary_compare_t compare = flat_file->super.compare;
+
+	return dictionary_is_signed_compare(compare) || dictionary_is_unsigned_compare(compare) || (dictionary_compare_char_array == compare) || (dictionary_compare_null_terminated_string == compare);
+}
+
+/**
+@brief		Hashes the bytes of a key that its stock comparator looks at.
+@details	This is FNV-1a, with a final mix so that keys which differ only in
+			their last bytes still spread over the whole table. Both string
+			comparators stop at the first null byte, so the hash does too.
+*/
+static uint32_t
+flat_file_key_hash(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key
+) {
+	ion_byte_t		*bytes			= key;
+	uint32_t		hash			= 2166136261u;
+	ion_boolean_t	stop_at_null	= (dictionary_compare_char_array == flat_file->super.compare) || (dictionary_compare_null_terminated_string == flat_file->super.compare);
+	ion_key_size_t	i;
+
+	for (i = 0; i < flat_file->super.record.key_size; i++) {
+		if (stop_at_null && (0 == bytes[i])) {
+			break;
+		}
+
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+
+	hash	^= hash >> 16;
+	hash	*= 0x85EBCA6Bu;
+	hash	^= hash >> 13;
+	hash	*= 0xC2B2AE35u;
+	hash	^= hash >> 16;
+
+	return hash;
+}
+
+#endif
+
+#if ION_FLAT_FILE_USE_BLOOM
+
+/**
+@brief		Adds a key to the Bloom filter of a flat file, if it has one.
+*/
+static void
+flat_file_bloom_add(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key
+) {
+	if (NULL == flat_file->bloom) {
+		return;
+	}
+
+	uint32_t	hash	= flat_file_key_hash(flat_file, key);
+	/* The probes are spaced by a second hash made odd, so that they never all land on one bit. */
+	uint32_t	step	= ((hash >> 17) | (hash << 15)) | 1;
+	int			i;
+
+	for (i = 0; i < ION_FLAT_FILE_BLOOM_HASHES; i++, hash += step) {
+		uint32_t bit = hash % (ION_FLAT_FILE_BLOOM_BYTES * 8);
+
+		flat_file->bloom[bit / 8] |= 1 << (bit % 8);
+	}
+}
+
+/**
+@brief		Checks the Bloom filter of a flat file for a key, rebuilding the filter first if needed.
+@details	Rows deleted in sorted mode keep their keys, and an update revives them, so the
+			filter is rebuilt from every row before the EOF position, deleted or not.
+@param[in]	flat_file
+				Which flat file instance to check.
+@param[in]	key
+				The key to check for.
+@return		@p boolean_false only if no row before the EOF position holds @p key. If the
+			filter is missing, cannot be rebuilt, or the comparator is not a stock one,
+			this is always @p boolean_true.
+*/
+static ion_boolean_t
+flat_file_bloom_may_contain(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key
+) {
+	if ((NULL == flat_file->bloom) || !flat_file_key_hashable(flat_file)) {
+		return boolean_true;
+	}
+
+	if (!flat_file->bloom_ready) {
+		ion_fpos_t cur_offset = flat_file->start_of_data;
+
+		memset(flat_file->bloom, 0, ION_FLAT_FILE_BLOOM_BYTES);
+
+		while (cur_offset != flat_file->eof_position) {
+			if (err_ok != flat_file_scan_block(flat_file, &cur_offset, flat_file->eof_position, ION_FLAT_FILE_SCAN_FORWARDS)) {
+				return boolean_true;
+			}
+
+			size_t i;
+
+			for (i = 0; i < flat_file->num_in_buffer; i++) {
+				flat_file_bloom_add(flat_file, &flat_file->block[i * flat_file->row_size + sizeof(ion_flat_file_row_status_t)]);
+			}
+		}
+
+		flat_file->bloom_ready = boolean_true;
+	}
+
+	uint32_t	hash	= flat_file_key_hash(flat_file, key);
+	uint32_t	step	= ((hash >> 17) | (hash << 15)) | 1;
+	int			i;
+
+	for (i = 0; i < ION_FLAT_FILE_BLOOM_HASHES; i++, hash += step) {
+		uint32_t bit = hash % (ION_FLAT_FILE_BLOOM_BYTES * 8);
+
+		if (0 == (flat_file->bloom[bit / 8] & (1 << (bit % 8)))) {
+			return boolean_false;
+		}
+	}
+
+	return boolean_true;
+}
+
+#endif
+
+#if ION_FLAT_FILE_USE_INDEX
+
+/**
+@brief		Adds a row to the key index of a flat file.
+@details	The table is doubled once it is three quarters full. If that fails, the index
+			is dropped, and point operations scan the file until it can be rebuilt.
+@param[in]	flat_file
+				Which flat file instance to index the row of.
+@param[in]	hash
+				The hash of the key held by the row.
+@param[in]	location
+				The row index of the row.
+*/
+static void
+flat_file_index_add(
+	ion_flat_file_t *flat_file,
+	uint32_t		hash,
+	ion_fpos_t		location
+) {
+	if (NULL == flat_file->index) {
+		return;
+	}
+
+	if ((flat_file->index_count + 1) * 4 > flat_file->index_capacity * 3) {
+		ion_flat_file_index_entry_t *old_index		= flat_file->index;
+		ion_fpos_t					old_capacity	= flat_file->index_capacity;
+		ion_fpos_t					i;
+
+		flat_file->index = ion_alloc(ion_alloc_node, old_capacity * 2 * sizeof(ion_flat_file_index_entry_t));
+
+		if (NULL == flat_file->index) {
+			ion_free(old_index);
+			flat_file->index_capacity	= 0;
+			flat_file->index_count		= 0;
+			flat_file->index_ready		= boolean_false;
+			return;
+		}
+
+		flat_file->index_capacity	= old_capacity * 2;
+		flat_file->index_count		= 0;
+
+		for (i = 0; i < flat_file->index_capacity; i++) {
+			flat_file->index[i].location = -1;
+		}
+
+		for (i = 0; i < old_capacity; i++) {
+			if (-1 != old_index[i].location) {
+				flat_file_index_add(flat_file, old_index[i].hash, old_index[i].location);
+			}
+		}
+
+		ion_free(old_index);
+	}
+
+	ion_fpos_t	mask = flat_file->index_capacity - 1;
+	ion_fpos_t	slot = hash & mask;
+
+	while (-1 != flat_file->index[slot].location) {
+		slot = (slot + 1) & mask;
+	}
+
+	flat_file->index[slot].hash		= hash;
+	flat_file->index[slot].location = location;
+	flat_file->index_count++;
+}
+
+/**
+@brief		Finds the slot of the key index that refers to the given row.
+@return		The slot, or -1 if no entry refers to the row.
+*/
+static ion_fpos_t
+flat_file_index_slot(
+	ion_flat_file_t *flat_file,
+	uint32_t		hash,
+	ion_fpos_t		location
+) {
+	ion_fpos_t	mask = flat_file->index_capacity - 1;
+	ion_fpos_t	slot = hash & mask;
+
+	for (; -1 != flat_file->index[slot].location; slot = (slot + 1) & mask) {
+		if (location == flat_file->index[slot].location) {
+			return slot;
+		}
+	}
+
+	return -1;
+}
+
+/**
+@brief		Frees a slot of the key index.
+@details	Later entries of the probe run are shifted back into the hole, so that no
+			lookup stops short of them and no deleted markers are needed.
+*/
+static void
+flat_file_index_remove(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		slot
+) {
+	ion_fpos_t	mask = flat_file->index_capacity - 1;
+	ion_fpos_t	next = slot;
+
+	flat_file->index[slot].location = -1;
+	flat_file->index_count--;
+
+	while (boolean_true) {
+		next = (next + 1) & mask;
+
+		if (-1 == flat_file->index[next].location) {
+			return;
+		}
+
+		ion_fpos_t home = flat_file->index[next].hash & mask;
+
+		/* An entry can fill the hole unless its home slot lies cyclically after the hole, up to where it sits. */
+		if ((slot <= next) ? ((home <= slot) || (home > next)) : ((home <= slot) && (home > next))) {
+			flat_file->index[slot]			= flat_file->index[next];
+			flat_file->index[next].location = -1;
+			slot							= next;
+		}
+	}
+}
+
+/**
+@brief		Checks whether point operations on a flat file may go through its key index,
+			building the index in one pass over the rows first if needed.
+@details	Every row before the EOF position is indexed, including the rows deleted in
+			sorted mode, since an update revives them in place. Lookups check the status.
+*/
+static ion_boolean_t
+flat_file_index_usable(
+	ion_flat_file_t *flat_file
+) {
+	if (flat_file->sorted_mode || !flat_file_key_hashable(flat_file)) {
+		return boolean_false;
+	}
+
+	if (flat_file->index_ready) {
+		return boolean_true;
+	}
+
+	ion_fpos_t	num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t	capacity	= 64;
+	ion_fpos_t	cur_offset	= flat_file->start_of_data;
+	ion_fpos_t	i;
+
+	while (capacity * 3 < num_rows * 4) {
+		capacity *= 2;
+	}
+
+	ion_free(flat_file->index);
+	flat_file->index			= ion_alloc(ion_alloc_node, capacity * sizeof(ion_flat_file_index_entry_t));
+	flat_file->index_capacity	= capacity;
+	flat_file->index_count		= 0;
+
+	if (NULL == flat_file->index) {
+		flat_file->index_capacity = 0;
+		return boolean_false;
+	}
+
+	for (i = 0; i < capacity; i++) {
+		flat_file->index[i].location = -1;
+	}
+
+	while ((NULL != flat_file->index) && (cur_offset != flat_file->eof_position)) {
+		if (err_ok != flat_file_scan_block(flat_file, &cur_offset, flat_file->eof_position, ION_FLAT_FILE_SCAN_FORWARDS)) {
+			ion_free(flat_file->index);
+			flat_file->index = NULL;
+			break;
+		}
+
+		for (i = 0; (NULL != flat_file->index) && (i < (ion_fpos_t) flat_file->num_in_buffer); i++) {
+			flat_file_index_add(flat_file, flat_file_key_hash(flat_file, &flat_file->block[i * flat_file->row_size + sizeof(ion_flat_file_row_status_t)]), flat_file->current_loaded_region + i);
+		}
+	}
+
+	flat_file->index_ready = NULL != flat_file->index;
+
+	return flat_file->index_ready;
+}
+
+#endif
+
+ion_err_t
+flat_file_scan(
+	ion_flat_file_t				*flat_file,
+	ion_fpos_t					start_location,
+	ion_fpos_t					*location,
+	ion_flat_file_row_t			*row,
+	ion_byte_t					scan_direction,
+	ion_flat_file_predicate_t	predicate,
+	...
+) {
+	ion_fpos_t	cur_offset;
+	ion_fpos_t	end_offset;
+	ion_err_t	err = flat_file_scan_bounds(flat_file, start_location, scan_direction, &cur_offset, &end_offset);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	while (cur_offset != end_offset) {
+		err = flat_file_scan_block(flat_file, &cur_offset, end_offset, scan_direction);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		int32_t num_records_to_process = flat_file->num_in_buffer;
+		int32_t i;
+
+		for (i = ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? 0 : num_records_to_process - 1; ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? i < num_records_to_process : i >= 0; ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? i++ : i--) {
+			flat_file_buffered_row(flat_file, i, row);
+
+			va_list predicate_arguments;
+
+			va_start(predicate_arguments, predicate);
+
+			ion_boolean_t predicate_test = predicate(flat_file, row, &predicate_arguments);
+
+			va_end(predicate_arguments);
+
+			if (predicate_test) {
+				*location = flat_file->current_loaded_region + i;
+				return flat_file_row_value(flat_file, *location, row);
+			}
+		}
+	}
+
+	/* If we reach this point, then no row matched the predicate. */
+	*location = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	return err_file_hit_eof;
+}
+
+/**
+@brief		Tests the loaded rows from @p i towards @p end for occupied rows
+			whose native @p type key lies within @p lower and @p upper, and
+			returns the index of the first one found from the enclosing function.
+*/
+#define ION_FLAT_FILE_MATCH_NATIVE(type, lower_key, upper_key) \
+	{ \
+		type	lower; \
+		type	upper; \
+		type	key; \
+ \
+		memcpy(&lower, (lower_key), sizeof(type)); \
+		memcpy(&upper, (upper_key), sizeof(type)); \
+ \
+		for (; i != end; i += step) { \
+			ion_byte_t *rec = &flat_file->block[i * flat_file->row_size]; \
+ \
+			if (ION_FLAT_FILE_STATUS_OCCUPIED == *rec) { \
+				memcpy(&key, rec + sizeof(ion_flat_file_row_status_t), sizeof(type)); \
+ \
+				if ((key >= lower) && (key <= upper)) { \
+					return i; \
+				} \
+			} \
+		} \
+ \
+		return -1; \
+	}
+
+/**
+@brief		Finds the first loaded row, in the scan direction, that satisfies a match.
+@param[in]	flat_file
+				Which flat file instance to test the loaded region of.
+@param[in]	match
+				Describes the rows to look for.
+@param[in]	key_kind
+				How the keys of @p flat_file may be compared.
+@param[in]	scan_direction
+				Which direction the scan moves in.
+@param[in]	first
+				The buffer index of the first row to test. Rows before it, in the
+				direction of the scan, are skipped.
+@return		The buffer index of the row found, or -1 if no row matched.
+*/
+static int32_t
+flat_file_match_block(
+	ion_flat_file_t				*flat_file,
+	ion_flat_file_match_t		*match,
+	ion_flat_file_key_kind_t	key_kind,
+	ion_byte_t					scan_direction,
+	int32_t						first
+) {
+	int32_t		count		= flat_file->num_in_buffer;
+	int32_t		i			= first;
+	int32_t		end			= ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? count : -1;
+	int32_t		step		= ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? 1 : -1;
+	ion_key_t	lower_key	= match->lower_bound;
+	/* An exact match is a range whose bounds are the same key. */
+	ion_key_t	upper_key	= ION_FLAT_FILE_MATCH_KEY == match->type ? match->lower_bound : match->upper_bound;
+
+	if (ION_FLAT_FILE_MATCH_NOT_EMPTY == match->type) {
+		for (; i != end; i += step) {
+			if (ION_FLAT_FILE_STATUS_OCCUPIED == flat_file->block[i * flat_file->row_size]) {
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	if (ION_FLAT_FILE_MATCH_FILTER == match->type) {
+		for (; i != end; i += step) {
+			ion_byte_t			*rec = &flat_file->block[i * flat_file->row_size];
+			ion_flat_file_row_t candidate;
+
+			if (ION_FLAT_FILE_STATUS_OCCUPIED != *rec) {
+				continue;
+			}
+
+			flat_file_buffered_row(flat_file, i, &candidate);
+
+			/* A value that cannot be read is given back as found, so that reading it again reports the error. */
+			if ((err_ok != flat_file_row_value(flat_file, flat_file->current_loaded_region + i, &candidate)) || match->filter(candidate.key, candidate.value, match->context)) {
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	switch (key_kind) {
+		case ION_FLAT_FILE_KEY_SIGNED32:
+			ION_FLAT_FILE_MATCH_NATIVE(int32_t, lower_key, upper_key);
+
+		case ION_FLAT_FILE_KEY_SIGNED64:
+			ION_FLAT_FILE_MATCH_NATIVE(int64_t, lower_key, upper_key);
+
+		case ION_FLAT_FILE_KEY_UNSIGNED32:
+			ION_FLAT_FILE_MATCH_NATIVE(uint32_t, lower_key, upper_key);
+
+		case ION_FLAT_FILE_KEY_UNSIGNED64:
+			ION_FLAT_FILE_MATCH_NATIVE(uint64_t, lower_key, upper_key);
+
+		default:
+			break;
+	}
+
+	ion_dictionary_compare_t	compare		= flat_file->super.compare;
+	ion_key_size_t				key_size	= flat_file->super.record.key_size;
+
+	for (; i != end; i += step) {
+		ion_byte_t *rec = &flat_file->block[i * flat_file->row_size];
+
+		if ((ION_FLAT_FILE_STATUS_OCCUPIED == *rec) && (compare(rec + sizeof(ion_flat_file_row_status_t), lower_key, key_size) >= 0) && (compare(rec + sizeof(ion_flat_file_row_status_t), upper_key, key_size) <= 0)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+#undef ION_FLAT_FILE_MATCH_NATIVE
+
+ion_err_t
+flat_file_scan_match(
+	ion_flat_file_t			*flat_file,
+	ion_fpos_t				start_location,
+	ion_fpos_t				*location,
+	ion_flat_file_row_t		*row,
+	ion_byte_t				scan_direction,
+	ion_flat_file_match_t	*match
+) {
+	ion_fpos_t					cur_offset;
+	ion_fpos_t					end_offset;
+	ion_flat_file_key_kind_t	key_kind	= flat_file_key_kind(flat_file);
+	ion_err_t					err			= flat_file_scan_bounds(flat_file, start_location, scan_direction, &cur_offset, &end_offset);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	ion_fpos_t	region		= flat_file->current_loaded_region;
+	ion_fpos_t	num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+
+	/* If the scan starts inside the loaded region, finish the region before reading any more, so that */
+	/* stepping through the file one match at a time, as cursors do, reads each block once. */
+	if ((-1 != start_location) && (-1 != region) && (start_location >= region) && (start_location < region + (ion_fpos_t) flat_file->num_in_buffer) && (start_location < num_rows)) {
+		if (region + (ion_fpos_t) flat_file->num_in_buffer > num_rows) {
+			flat_file->num_in_buffer = num_rows - region;
+		}
+
+		int32_t found = flat_file_match_block(flat_file, match, key_kind, scan_direction, start_location - region);
+
+		if (-1 != found) {
+			flat_file_buffered_row(flat_file, found, row);
+			*location = region + found;
+			return flat_file_row_value(flat_file, *location, row);
+		}
+
+		cur_offset = flat_file->start_of_data + (ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? region + (ion_fpos_t) flat_file->num_in_buffer : region) * flat_file->row_size;
+	}
+
+	while (cur_offset != end_offset) {
+		err = flat_file_scan_block(flat_file, &cur_offset, end_offset, scan_direction);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		int32_t found = flat_file_match_block(flat_file, match, key_kind, scan_direction, ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? 0 : (int32_t) flat_file->num_in_buffer - 1);
+
+		if (-1 != found) {
+			flat_file_buffered_row(flat_file, found, row);
+			*location = flat_file->current_loaded_region + found;
+			return flat_file_row_value(flat_file, *location, row);
+		}
+	}
+
+	/* If we reach this point, then no row matched. */
+	*location = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	return err_file_hit_eof;
+}
+
+/**
+@brief		Finds the first row at or after @p start_location that holds @p key.
+@details	Behaves as a forward @ref flat_file_scan_match for the key, but when the key
+			index can be used, only the rows whose key hashes the same are read.
+@param[in]	flat_file
+				Which flat file instance to search.
+@param[in]	start_location
+				Where to begin the search, as for @ref flat_file_scan_match.
+@param[out]	location
+				The row index of the row found. On a miss, this is the EOF row index.
+@param[out]	row
+				The row found.
+@param[in]	key
+				The key to find.
+@return		Resulting status of the search, @ref err_file_hit_eof if no row matched.
+*/
+static ion_err_t
+flat_file_find_key(
+	ion_flat_file_t		*flat_file,
+	ion_fpos_t			start_location,
+	ion_fpos_t			*location,
+	ion_flat_file_row_t *row,
+	ion_key_t			key
+) {
+#if ION_FLAT_FILE_USE_INDEX
+
+	if (flat_file_index_usable(flat_file)) {
+		uint32_t	hash		= flat_file_key_hash(flat_file, key);
+		ion_fpos_t	mask		= flat_file->index_capacity - 1;
+		ion_fpos_t	slot		= hash & mask;
+		ion_fpos_t	found_loc	= -1;
+		ion_fpos_t	read_loc	= -1;
+		ion_err_t	err;
+
+		for (; -1 != flat_file->index[slot].location; slot = (slot + 1) & mask) {
+			ion_fpos_t candidate = flat_file->index[slot].location;
+
+			if ((hash != flat_file->index[slot].hash) || (candidate < start_location) || ((-1 != found_loc) && (candidate >= found_loc))) {
+				continue;
+			}
+
+			err			= flat_file_read_key(flat_file, candidate, row);
+			read_loc	= candidate;
+
+			if (err_ok != err) {
+				return err;
+			}
+
+			if ((ION_FLAT_FILE_STATUS_OCCUPIED == row->row_status) && (0 == flat_file->super.compare(row->key, key, flat_file->super.record.key_size))) {
+				found_loc = candidate;
+			}
+		}
+
+		if (-1 == found_loc) {
+			*location = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+			return err_file_hit_eof;
+		}
+
+		/* Only read the row found again if another candidate was read after it. */
+		if ((read_loc != found_loc) && (err_ok != (err = flat_file_read_key(flat_file, found_loc, row)))) {
+			return err;
+		}
+
+		*location = found_loc;
+		return flat_file_row_value(flat_file, found_loc, row);
+	}
+
+#endif
+
+	return flat_file_scan_match(flat_file, start_location, location, row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, key, NULL });
+}
+
+#if ION_FLAT_FILE_USE_FENCES || ION_FLAT_FILE_USE_LEARNED_INDEX
+
+/**
+@brief		Compares two keys of a flat file, natively where the key layout allows it.
+@param[in]	flat_file
+				Which flat file instance the keys belong to.
+@param[in]	key_kind
+				How the keys of @p flat_file may be compared.
+@param[in]	first_key
+				The first key to compare.
+@param[in]	second_key
+				The second key to compare.
+@return		As the comparator of @p flat_file.
+*/
+static int
+flat_file_compare_keys(
+	ion_flat_file_t				*flat_file,
+	ion_flat_file_key_kind_t	key_kind,
+	ion_key_t					first_key,
+	ion_key_t					second_key
+) {
+	switch (key_kind) {
+		case ION_FLAT_FILE_KEY_SIGNED32: {
+			int32_t a, b;
+
+			memcpy(&a, first_key, sizeof(a));
+			memcpy(&b, second_key, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		case ION_FLAT_FILE_KEY_SIGNED64: {
+			int64_t a, b;
+
+			memcpy(&a, first_key, sizeof(a));
+			memcpy(&b, second_key, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		case ION_FLAT_FILE_KEY_UNSIGNED32: {
+			uint32_t a, b;
+
+			memcpy(&a, first_key, sizeof(a));
+			memcpy(&b, second_key, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		case ION_FLAT_FILE_KEY_UNSIGNED64: {
+			uint64_t a, b;
+
+			memcpy(&a, first_key, sizeof(a));
+			memcpy(&b, second_key, sizeof(b));
+			return (a > b) - (a < b);
+		}
+
+		default:
+			return flat_file->super.compare(first_key, second_key, flat_file->super.record.key_size);
+	}
+}
+
+/**
+@brief		Reads a natively compared key as a position on the number line, for interpolation.
+*/
+static double
+flat_file_key_position(
+	ion_flat_file_key_kind_t	key_kind,
+	ion_key_t					key
+) {
+	switch (key_kind) {
+		case ION_FLAT_FILE_KEY_SIGNED32: {
+			int32_t k;
+
+			memcpy(&k, key, sizeof(k));
+			return (double) k;
+		}
+
+		case ION_FLAT_FILE_KEY_SIGNED64: {
+			int64_t k;
+
+			memcpy(&k, key, sizeof(k));
+			return (double) k;
+		}
+
+		case ION_FLAT_FILE_KEY_UNSIGNED32: {
+			uint32_t k;
+
+			memcpy(&k, key, sizeof(k));
+			return (double) k;
+		}
+
+		default: {
+			uint64_t k;
+
+			memcpy(&k, key, sizeof(k));
+			return (double) k;
+		}
+	}
+}
+
+/**
+@brief		Finds the first of a sorted run of in-memory keys that is not less than @p target_key.
+@details	Keys compared natively are probed by interpolation, and fall back to bisection
+			whenever the target lies outside the keys still in range. Other keys are bisected.
+@param[in]	flat_file
+				Which flat file instance the keys belong to.
+@param[in]	key_kind
+				How the keys of @p flat_file may be compared.
+@param[in]	keys
+				The first key of the run.
+@param[in]	stride
+				How many bytes apart the keys of the run are.
+@param[in]	count
+				How many keys the run holds.
+@param[in]	target_key
+				The key to look for.
+@return		The index of the key found, or @p count if every key is less than @p target_key.
+*/
+static ion_fpos_t
+flat_file_lower_bound(
+	ion_flat_file_t				*flat_file,
+	ion_flat_file_key_kind_t	key_kind,
+	ion_byte_t					*keys,
+	size_t						stride,
+	ion_fpos_t					count,
+	ion_key_t					target_key
+) {
+	ion_fpos_t	low_idx		= 0;
+	ion_fpos_t	high_idx	= count;
+	double		target		= ION_FLAT_FILE_KEY_GENERIC == key_kind ? 0 : flat_file_key_position(key_kind, target_key);
+
+	/* The answer always lies within [low_idx, high_idx]. */
+	while (low_idx < high_idx) {
+		ion_fpos_t probe_idx = low_idx + (high_idx - low_idx) / 2;
+
+		if (ION_FLAT_FILE_KEY_GENERIC != key_kind) {
+			double	low		= flat_file_key_position(key_kind, keys + low_idx * stride);
+			double	high	= flat_file_key_position(key_kind, keys + (high_idx - 1) * stride);
+
+			if ((low < target) && (target <= high)) {
+				probe_idx = low_idx + (ion_fpos_t) ((target - low) / (high - low) * (high_idx - 1 - low_idx));
+			}
+		}
+
+		if (flat_file_compare_keys(flat_file, key_kind, keys + probe_idx * stride, target_key) < 0) {
+			low_idx = probe_idx + 1;
+		}
+		else {
+			high_idx = probe_idx;
+		}
+	}
+
+	return low_idx;
+}
+
+#endif
+
+#if ION_FLAT_FILE_USE_FENCES
+
+/**
+@brief		Records the first key of another block in the fence index.
+@details	If the index cannot grow, it is dropped, and the next sorted mode
+			search will try to build it again.
+@param[in]	flat_file
+				Which flat file instance to add the fence to.
+@param[in]	key
+				The key of the first row of the next block.
+*/
+static void
+flat_file_add_fence(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key
+) {
+	ion_key_size_t key_size = flat_file->super.record.key_size;
+
+	if (flat_file->num_fences == flat_file->fence_capacity) {
+		ion_fpos_t	capacity	= 0 == flat_file->fence_capacity ? 8 : flat_file->fence_capacity * 2;
+		ion_byte_t	*keys		= ion_realloc(ion_alloc_node, flat_file->fence_keys, capacity * key_size);
+
+		if (NULL == keys) {
+			ion_free(flat_file->fence_keys);
+			flat_file->fence_keys		= NULL;
+			flat_file->num_fences		= 0;
+			flat_file->fence_capacity	= 0;
+			return;
+		}
+
+		flat_file->fence_keys		= keys;
+		flat_file->fence_capacity	= capacity;
+	}
+
+	memcpy(flat_file->fence_keys + flat_file->num_fences * key_size, key, key_size);
+	flat_file->num_fences++;
+}
+
+/**
+@brief		Searches a sorted flat file through its fence index, reading at most one block.
+@details	Behaves as @ref flat_file_binary_search. The index is first brought up to date
+			with any rows added since it was last extended.
+@param[in]	flat_file
+				Which flat file instance to search within.
+@param[in]	target_key
+				Desired key to search for.
+@param[out]	location
+				Found location to write back into.
+@param[out]	used
+				Set to @p boolean_false if no index could be built, in which case
+				nothing was searched.
+@return		Resulting status of the search.
+*/
+static ion_err_t
+flat_file_fence_search(
+	ion_flat_file_t *flat_file,
+	ion_key_t		target_key,
+	ion_fpos_t		*location,
+	ion_boolean_t	*used
+) {
+	ion_flat_file_key_kind_t	key_kind	= flat_file_key_kind(flat_file);
+	ion_key_size_t				key_size	= flat_file->super.record.key_size;
+	ion_fpos_t					block_size	= flat_file->num_buffered;
+	ion_fpos_t					num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_flat_file_row_t			row;
+	ion_err_t					err;
+
+	*used = boolean_true;
+
+	while (flat_file->num_fences * block_size < num_rows) {
+		err = flat_file_read_key(flat_file, flat_file->num_fences * block_size, &row);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		flat_file_add_fence(flat_file, row.key);
+
+		if (NULL == flat_file->fence_keys) {
+			*used = boolean_false;
+			return err_out_of_memory;
+		}
+	}
+
+	if (0 == num_rows) {
+		/* We're empty, short circuit */
+		*location = -1;
+		return err_item_not_found;
+	}
+
+	/* Every block before this one starts with a key less than the target. */
+	ion_fpos_t	fence_idx	= flat_file_lower_bound(flat_file, key_kind, flat_file->fence_keys, key_size, flat_file->num_fences, target_key);
+	ion_fpos_t	found_idx	= 0;
+	ion_key_t	found_key	= flat_file->fence_keys;
+
+	if (fence_idx > 0) {
+		/* The first key not less than the target is in the block before, or starts the block found. */
+		ion_fpos_t	block_start = (fence_idx - 1) * block_size;
+		ion_fpos_t	cur_offset	= flat_file->start_of_data + block_start * flat_file->row_size;
+
+		err = flat_file_scan_block(flat_file, &cur_offset, flat_file->eof_position, ION_FLAT_FILE_SCAN_FORWARDS);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		ion_fpos_t	num_in_block	= (ion_fpos_t) flat_file->num_in_buffer < block_size ? (ion_fpos_t) flat_file->num_in_buffer : block_size;
+		ion_fpos_t	block_idx		= flat_file_lower_bound(flat_file, key_kind, flat_file->block + sizeof(ion_flat_file_row_status_t), flat_file->row_size, num_in_block, target_key);
+
+		found_idx = block_start + block_idx;
+		found_key = block_idx < num_in_block ? flat_file->block + block_idx * flat_file->row_size + sizeof(ion_flat_file_row_status_t) : flat_file->fence_keys + fence_idx * key_size;
+	}
+
+	if ((found_idx < num_rows) && (0 == flat_file_compare_keys(flat_file, key_kind, found_key, target_key))) {
+		*location = found_idx;
+		return err_ok;
+	}
+
+	/* No match, so fall back to the last key less than the target */
+	*location = found_idx - 1;
+	return *location >= 0 ? err_ok : err_item_not_found;
+}
+
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+
+/**
+@brief		How many rows the learned model of a flat file may be off by.
+@return		At most @ref ION_FLAT_FILE_LEARNED_ERROR, so that the rows a search reads fit
+			in the buffer, or less than 0 if the buffer is too small for any.
+*/
+static ion_fpos_t
+flat_file_learned_error(
+	ion_flat_file_t *flat_file
+) {
+	ion_fpos_t error = ((ion_fpos_t) flat_file->num_buffered - 4) / 2;
+
+	if ((ion_fpos_t) flat_file->num_buffered < 4) {
+		return -1;
+	}
+
+	return error < ION_FLAT_FILE_LEARNED_ERROR ? error : ION_FLAT_FILE_LEARNED_ERROR;
+}
+
+/**
+@brief		Drops the learned model of a flat file until its rows next move.
+*/
+static void
+flat_file_learned_drop(
+	ion_flat_file_t *flat_file
+) {
+	ion_free(flat_file->segments);
+	flat_file->segments			= NULL;
+	flat_file->num_segments		= 0;
+	flat_file->segment_capacity = 0;
+	flat_file->learned_rows		= -1;
+}
+
+/**
+@brief		Fits the learned model through another point, past every point before it.
+@details	This is the shrinking cone: each segment starts at its first point, and keeps
+			the range of slopes that pass within the error of every point since. A point
+			that would empty the range starts the next segment. If the segments cannot
+			grow, the model is dropped.
+@param[in]	flat_file
+				Which flat file instance to fit the model of.
+@param[in]	key
+				The key of the point, greater than that of any point before.
+@param[in]	row
+				The row index the point should be predicted at.
+*/
+static void
+flat_file_learned_fit(
+	ion_flat_file_t *flat_file,
+	double			key,
+	ion_fpos_t		row
+) {
+	double error = (double) flat_file_learned_error(flat_file);
+
+	if (flat_file->num_segments > 0) {
+		ion_flat_file_segment_t *last	= &flat_file->segments[flat_file->num_segments - 1];
+		double					low		= (row - error - last->row) / (key - last->key);
+		double					high	= (row + error - last->row) / (key - last->key);
+
+		if (low < flat_file->slope_low) {
+			low = flat_file->slope_low;
+		}
+
+		if (high > flat_file->slope_high) {
+			high = flat_file->slope_high;
+		}
+
+		if (low <= high) {
+			flat_file->slope_low	= low;
+			flat_file->slope_high	= high;
+			last->slope				= low + (high - low) / 2;
+			return;
+		}
+	}
+
+	if (flat_file->num_segments == flat_file->segment_capacity) {
+		ion_fpos_t				capacity	= 0 == flat_file->segment_capacity ? 8 : flat_file->segment_capacity * 2;
+		ion_flat_file_segment_t *segments;
+
+		if (capacity > (ion_fpos_t) (ION_FLAT_FILE_LEARNED_BYTES / sizeof(ion_flat_file_segment_t))) {
+			capacity = ION_FLAT_FILE_LEARNED_BYTES / sizeof(ion_flat_file_segment_t);
+		}
+
+		if ((capacity == flat_file->segment_capacity) || (NULL == (segments = ion_realloc(ion_alloc_other, flat_file->segments, capacity * sizeof(ion_flat_file_segment_t))))) {
+			flat_file_learned_drop(flat_file);
+			return;
+		}
+
+		flat_file->segments			= segments;
+		flat_file->segment_capacity = capacity;
+	}
+
+	flat_file->segments[flat_file->num_segments].key	= key;
+	flat_file->segments[flat_file->num_segments].slope	= 0;
+	flat_file->segments[flat_file->num_segments].row	= row;
+	flat_file->num_segments++;
+	/* Keys only ever move forwards through the rows. */
+	flat_file->slope_low								= 0;
+	flat_file->slope_high								= DBL_MAX;
+}
+
+/**
+@brief		Adds the row after those the learned model describes to it.
+@details	The model is fit through the first row of each key. After a run of duplicates,
+			it is also fit through the key one past the run, at the row after it, so that
+			a key between two stored ones is predicted as closely as they are.
+@param[in]	flat_file
+				Which flat file instance to add the row to the model of.
+@param[in]	key_kind
+				How the keys of @p flat_file may be compared.
+@param[in]	key
+				The key of the row.
+*/
+static void
+flat_file_learned_add(
+	ion_flat_file_t				*flat_file,
+	ion_flat_file_key_kind_t	key_kind,
+	ion_key_t					key
+) {
+	double		position	= flat_file_key_position(key_kind, key);
+	ion_fpos_t	row			= flat_file->learned_rows;
+
+	/* As well as duplicates, this skips keys too large to tell apart as doubles. */
+	if ((row > 0) && (position <= flat_file->learned_key)) {
+		flat_file->learned_rows++;
+		return;
+	}
+
+	if ((row > 0) && (row - flat_file->learned_key_row > 1) && (flat_file->learned_key + 1 < position)) {
+		flat_file_learned_fit(flat_file, flat_file->learned_key + 1, row);
+
+		if (-1 == flat_file->learned_rows) {
+			return;
+		}
+	}
+
+	flat_file_learned_fit(flat_file, position, row);
+
+	if (-1 == flat_file->learned_rows) {
+		return;
+	}
+
+	flat_file->learned_key		= position;
+	flat_file->learned_key_row	= row;
+	flat_file->learned_rows		= row + 1;
+}
+
+/**
+@brief		Points the loaded region of a flat file at some consecutive rows, reading them
+			in one go unless the file is mapped.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	first
+				The row index of the first row.
+@param[in]	count
+				How many rows to load, no more than fit in the buffer.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_load_rows(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		first,
+	ion_fpos_t		count
+) {
+#if ION_FLAT_FILE_USE_MMAP
+
+	if (flat_file_map_rows(flat_file)) {
+		flat_file->block = flat_file->map + flat_file->start_of_data + first * flat_file->row_size;
+	}
+	else
+#endif
+	{
+		flat_file->current_loaded_region	= -1;
+		flat_file->num_in_buffer			= 0;
+
+		if (0 != fseek(flat_file->data_file, flat_file->start_of_data + first * flat_file->row_size, SEEK_SET)) {
+			return err_file_bad_seek;
+		}
+
+		if ((size_t) count != fread(flat_file->buffer, flat_file->row_size, count, flat_file->data_file)) {
+			return err_file_incomplete_read;
+		}
+
+		flat_file->block = flat_file->buffer;
 	}
 
-	flat_file->data_file = NULL;
+	flat_file->current_loaded_region	= first;
+	flat_file->num_in_buffer			= count;
 
 	return err_ok;
 }
 
-ion_err_t
-flat_file_scan(
-	ion_flat_file_t				*flat_file,
-	ion_fpos_t					start_location,
-	ion_fpos_t					*location,
-	ion_flat_file_row_t			*row,
-	ion_byte_t					scan_direction,
-	ion_flat_file_predicate_t	predicate,
-	...
+/**
+@brief		Searches a sorted flat file through its learned model, reading the rows around
+			the predicted one.
+@details	Behaves as @ref flat_file_binary_search. The model is first built, or brought up
+			to date with any rows appended since it was last extended, in one sequential pass.
+@param[in]	flat_file
+				Which flat file instance to search within.
+@param[in]	target_key
+				Desired key to search for.
+@param[out]	location
+				Found location to write back into.
+@param[out]	used
+				Set to @p boolean_false if the model could not answer, in which case
+				nothing was found.
+@return		Resulting status of the search.
+*/
+static ion_err_t
+flat_file_learned_search(
+	ion_flat_file_t *flat_file,
+	ion_key_t		target_key,
+	ion_fpos_t		*location,
+	ion_boolean_t	*used
 ) {
-	ion_fpos_t	cur_offset	= flat_file->start_of_data + start_location * flat_file->row_size;
-	ion_fpos_t	end_offset	= ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? flat_file->eof_position : flat_file->start_of_data;
+	ion_flat_file_key_kind_t	key_kind	= flat_file_key_kind(flat_file);
+	ion_fpos_t					error		= flat_file_learned_error(flat_file);
+	ion_fpos_t					num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_flat_file_row_t			row;
+	ion_err_t					err;
+	ion_fpos_t					i;
 
-	if (-1 == start_location) {
-		if (ION_FLAT_FILE_SCAN_FORWARDS == scan_direction) {
-			cur_offset = flat_file->start_of_data;
-		}
-		else {
-			cur_offset = flat_file->eof_position;
-		}
-	}
+	*used = boolean_false;
 
-	/* If we're scanning backwards, bump the cur_offset up one record so that we read the record we're sitting on. */
-	/* We don't do this if we're positioned at the EOF, since otherwise we would read garbage. */
-	if ((ION_FLAT_FILE_SCAN_BACKWARDS == scan_direction) && (cur_offset != flat_file->eof_position)) {
-		cur_offset += flat_file->row_size;
+	if ((ION_FLAT_FILE_KEY_GENERIC == key_kind) || (error < 0) || (0 == num_rows)) {
+		return err_ok;
 	}
 
-	if ((cur_offset > flat_file->eof_position) || (cur_offset < flat_file->start_of_data)) {
-		return err_out_of_bounds;
-	}
+	while ((-1 != flat_file->learned_rows) && (flat_file->learned_rows < num_rows)) {
+		ion_fpos_t cur_offset = flat_file->start_of_data + flat_file->learned_rows * flat_file->row_size;
 
-	while (cur_offset != end_offset) {
-		if (0 != fseek(flat_file->data_file, cur_offset, SEEK_SET)) {
-			return err_file_bad_seek;
+		err = flat_file_scan_block(flat_file, &cur_offset, flat_file->eof_position, ION_FLAT_FILE_SCAN_FORWARDS);
+
+		if (err_ok != err) {
+			*used = boolean_true;
+			return err;
 		}
 
-		/* We set cur_offset to be the next block to read after this next code segment, so */
-		/* we need t save what block we're currently reading now for location calculation purposes */
-		ion_fpos_t	prev_offset				= cur_offset;
-		size_t		num_records_to_process	= flat_file->num_buffered;
+		for (i = 0; (-1 != flat_file->learned_rows) && (i < (ion_fpos_t) flat_file->num_in_buffer); i++) {
+			flat_file_buffered_row(flat_file, i, &row);
+			flat_file_learned_add(flat_file, key_kind, row.key);
+		}
+	}
 
-		if (ION_FLAT_FILE_SCAN_FORWARDS == scan_direction) {
-			/* It's possible for this to do a partial read (if you're close to EOF), calculate how many we need to read */
-			size_t records_left = (end_offset - cur_offset) / flat_file->row_size;
+	if (-1 == flat_file->learned_rows) {
+		return err_ok;
+	}
 
-			num_records_to_process = records_left > (unsigned) /* TODO HACK: remove this */ flat_file->num_buffered ? (unsigned) flat_file->num_buffered : records_left;
+	/* Find the last segment that starts at or before the target. */
+	double		target		= flat_file_key_position(key_kind, target_key);
+	double		predicted	= 0;
+	ion_fpos_t	low_idx		= 0;
+	ion_fpos_t	high_idx	= flat_file->num_segments;
 
-			if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
-				return err_file_incomplete_read;
-			}
+	while (low_idx < high_idx) {
+		ion_fpos_t mid_idx = low_idx + (high_idx - low_idx) / 2;
 
-			if (-1 == (cur_offset = ftell(flat_file->data_file))) {
-				return err_file_read_error;
-			}
+		if (flat_file->segments[mid_idx].key <= target) {
+			low_idx = mid_idx + 1;
 		}
 		else {
-			/* Move the offset pointer to the next read location, clamp it at start_of_file if we go too far. */
-			cur_offset -= flat_file->row_size * flat_file->num_buffered;
-
-			if (cur_offset < flat_file->start_of_data) {
-				/* We know how many rows we went past the start of file, calculate it so we don't fread too much */
-				num_records_to_process	= flat_file->num_buffered - (flat_file->start_of_data - cur_offset) / flat_file->row_size;
-				cur_offset				= flat_file->start_of_data;
-			}
+			high_idx = mid_idx;
+		}
+	}
 
-			if (0 != fseek(flat_file->data_file, cur_offset, SEEK_SET)) {
-				return err_file_bad_seek;
-			}
+	if (low_idx > 0) {
+		ion_flat_file_segment_t *segment	= &flat_file->segments[low_idx - 1];
+		double					ceiling		= low_idx < flat_file->num_segments ? flat_file->segments[low_idx].row : num_rows;
 
-			if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
-				return err_file_incomplete_read;
-			}
+		/* The first key not less than the target lies between this segment and the next. */
+		predicted = segment->row + segment->slope * (target - segment->key);
 
-			/* In this case, the prev_offset is actually the cur_offset. */
-			prev_offset = cur_offset;
+		if (predicted > ceiling) {
+			predicted = ceiling;
 		}
+	}
 
-		flat_file->current_loaded_region	= (prev_offset - flat_file->start_of_data) / flat_file->row_size;
-		flat_file->num_in_buffer			= num_records_to_process;
-
-		int32_t i;
-
-		for (i = ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? 0 : num_records_to_process - 1; ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? (size_t) i < num_records_to_process : i >= 0; ION_FLAT_FILE_SCAN_FORWARDS == scan_direction ? i++ : i--) {
-			size_t cur_rec = i * flat_file->row_size;
+	/* The answer lies within error + 1 of the prediction, so it lies strictly inside these rows. */
+	ion_fpos_t	first	= (ion_fpos_t) predicted - error - 2;
+	ion_fpos_t	last	= (ion_fpos_t) predicted + error + 2;
 
-			/* This cast is done because in the future, the status could possibly be a non-byte type */
-			row->row_status = *((ion_flat_file_row_status_t *) &flat_file->buffer[cur_rec]);
-			row->key		= &flat_file->buffer[cur_rec + sizeof(ion_flat_file_row_status_t)];
-			row->value		= &flat_file->buffer[cur_rec + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
+	first	= first < 0 ? 0 : first;
+	last	= last > num_rows ? num_rows : last;
+	err		= flat_file_load_rows(flat_file, first, last - first);
 
-			va_list predicate_arguments;
+	if (err_ok != err) {
+		*used = boolean_true;
+		return err;
+	}
 
-			va_start(predicate_arguments, predicate);
+	ion_fpos_t	window_idx	= flat_file_lower_bound(flat_file, key_kind, flat_file->block + sizeof(ion_flat_file_row_status_t), flat_file->row_size, last - first, target_key);
+	ion_key_t	found_key	= flat_file->block + window_idx * flat_file->row_size + sizeof(ion_flat_file_row_status_t);
 
-			ion_boolean_t predicate_test = predicate(flat_file, row, &predicate_arguments);
+	/* Only keys the model skipped as too large for a double can land on an edge. */
+	if (((0 == window_idx) && (first > 0)) || ((last - first == window_idx) && (last < num_rows))) {
+		return err_ok;
+	}
 
-			va_end(predicate_arguments);
+	*used = boolean_true;
 
-			if (predicate_test) {
-				*location = (prev_offset - flat_file->start_of_data) / flat_file->row_size + i;
-				return err_ok;
-			}
-		}
+	if ((window_idx < last - first) && (0 == flat_file_compare_keys(flat_file, key_kind, found_key, target_key))) {
+		*location = first + window_idx;
+		return err_ok;
 	}
 
-	/* If we reach this point, then no row matched the predicate. */
-	*location = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
-	return err_file_hit_eof;
+	/* No match, so fall back to the last key less than the target */
+	*location = first + window_idx - 1;
+	return *location >= 0 ? err_ok : err_item_not_found;
 }
 
+#endif
+
 ion_boolean_t
 flat_file_predicate_not_empty(
 	ion_flat_file_t		*flat_file,
@@ -314,6 +2164,10 @@ flat_file_write_row(
 	flat_file->current_loaded_region	= -1;
 	flat_file->num_in_buffer			= 0;
 
+#if ION_FLAT_FILE_USE_MMAP
+	flat_file->map_dirty = boolean_true;
+#endif
+
 	if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
 		return err_file_bad_seek;
 	}
@@ -326,10 +2180,28 @@ flat_file_write_row(
 		return err_file_incomplete_write;
 	}
 
+#if ION_FLAT_FILE_USE_BLOOM
+
+	if (NULL != row->key) {
+		flat_file_bloom_add(flat_file, row->key);
+	}
+
+#endif
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+	if ((NULL != row->value) && ((0 != fseek(flat_file->value_file, location * flat_file->super.record.value_size, SEEK_SET)) || (1 != fwrite(row->value, flat_file->super.record.value_size, 1, flat_file->value_file)))) {
+		return err_file_incomplete_write;
+	}
+
+#else
+
 	if ((NULL != row->value) && (1 != fwrite(row->value, flat_file->super.record.value_size, 1, flat_file->data_file))) {
 		return err_file_incomplete_write;
 	}
 
+#endif
+
 	return err_ok;
 }
 
@@ -339,36 +2211,13 @@ flat_file_read_row(
 	ion_fpos_t			location,
 	ion_flat_file_row_t *row
 ) {
-	ion_fpos_t read_index = 0;
-
-	if ((flat_file->current_loaded_region != -1) && (location >= flat_file->current_loaded_region) && ((unsigned) location < flat_file->current_loaded_region + flat_file->num_in_buffer)) {
-		/* Cache hit, return directly from buffer */
-		read_index = location - flat_file->current_loaded_region;
-	}
-	else {
-		/* Cache miss, have to re-read from file */
-		if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
-			return err_file_bad_seek;
-		}
-
-		if (1 != fread(flat_file->buffer, sizeof(row->row_status), 1, flat_file->data_file)) {
-			return err_file_incomplete_write;
-		}
+	ion_err_t err = flat_file_read_key(flat_file, location, row);
 
-		if (1 != fread(flat_file->buffer + sizeof(row->row_status), flat_file->super.record.key_size, 1, flat_file->data_file)) {
-			return err_file_incomplete_write;
-		}
-
-		if (1 != fread(flat_file->buffer + sizeof(row->row_status) + flat_file->super.record.key_size, flat_file->super.record.value_size, 1, flat_file->data_file)) {
-			return err_file_incomplete_write;
-		}
+	if (err_ok != err) {
+		return err;
 	}
 
-	row->row_status = *((ion_flat_file_row_status_t *) &flat_file->buffer[read_index * flat_file->row_size]);
-	row->key		= &flat_file->buffer[read_index * flat_file->row_size + sizeof(ion_flat_file_row_status_t)];
-	row->value		= &flat_file->buffer[read_index * flat_file->row_size + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
-
-	return err_ok;
+	return flat_file_row_value(flat_file, location, row);
 }
 
 ion_status_t
@@ -380,7 +2229,7 @@ flat_file_insert(
 	ion_status_t	status	= ION_STATUS_INITIALIZE;
 	ion_err_t		err;
 	/* We can assume append-only insert here because our delete operation does a swap replacement, and
-	   in sorted mode, we don't allow deletes - so there are no holes to fill. */
+	   in sorted mode, deletes leave tombstones that keep their keys - so there are no holes to fill. */
 	ion_fpos_t insert_loc	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
 
 	if (flat_file->sorted_mode) {
@@ -388,7 +2237,7 @@ flat_file_insert(
 		ion_flat_file_row_t row;
 
 		if (last_record_loc >= 0) {
-			err = flat_file_read_row(flat_file, last_record_loc, &row);
+			err = flat_file_read_key(flat_file, last_record_loc, &row);
 
 			if (err_ok != err) {
 				status.error = err;
@@ -417,11 +2266,184 @@ flat_file_insert(
 		return status;
 	}
 
+#if ION_FLAT_FILE_USE_FENCES
+
+	/* Keep the fence index current while appending, rather than catching up at the next search. */
+	if ((NULL != flat_file->fence_keys) && (insert_loc == flat_file->num_fences * (ion_fpos_t) flat_file->num_buffered)) {
+		flat_file_add_fence(flat_file, key);
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+
+	/* Likewise the learned model, if it describes every row before this one. */
+	if ((NULL != flat_file->segments) && (insert_loc == flat_file->learned_rows)) {
+		flat_file_learned_add(flat_file, flat_file_key_kind(flat_file), key);
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_INDEX
+
+	if (flat_file->index_ready) {
+		flat_file_index_add(flat_file, flat_file_key_hash(flat_file, key), insert_loc);
+	}
+
+#endif
+
 	status.error	= err_ok;
 	status.count	= 1;
 	return status;
 }
 
+ion_status_t
+flat_file_insert_batch(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_result_count_t	count
+) {
+	ion_status_t		status		= ION_STATUS_INITIALIZE;
+	ion_key_size_t		key_size	= flat_file->super.record.key_size;
+	ion_value_size_t	value_size	= flat_file->super.record.value_size;
+	ion_fpos_t			insert_loc	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_byte_t			*key_bytes	= keys;
+	ion_byte_t			*value_bytes = values;
+	ion_err_t			err;
+	ion_result_count_t	i;
+
+	if (count <= 0) {
+		status.error = err_ok;
+		return status;
+	}
+
+	if (flat_file->sorted_mode) {
+		/* Check the whole batch before writing any of it, so that a violation leaves the file as it was. */
+		if (insert_loc > 0) {
+			ion_flat_file_row_t row;
+
+			err = flat_file_read_key(flat_file, insert_loc - 1, &row);
+
+			if (err_ok != err) {
+				status.error = err;
+				return status;
+			}
+
+			if (flat_file->super.compare(key_bytes, row.key, key_size) < 0) {
+				status.error = err_sorted_order_violation;
+				return status;
+			}
+		}
+
+		for (i = 1; i < count; i++) {
+			if (flat_file->super.compare(key_bytes + i * key_size, key_bytes + (i - 1) * key_size, key_size) < 0) {
+				status.error = err_sorted_order_violation;
+				return status;
+			}
+		}
+	}
+
+	/* The rows are staged in the buffer, so drop whatever region it held. */
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+#if ION_FLAT_FILE_USE_MMAP
+	flat_file->map_dirty = boolean_true;
+#endif
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+	/* The values are already packed, so they go out in one write. They are written first, so that no row is */
+	/* ever there without its value. */
+	if (0 != fseek(flat_file->value_file, insert_loc * value_size, SEEK_SET)) {
+		status.error = err_file_bad_seek;
+		return status;
+	}
+
+	if ((size_t) count != fwrite(value_bytes, value_size, count, flat_file->value_file)) {
+		status.error = err_file_incomplete_write;
+		return status;
+	}
+
+#endif
+
+	if (0 != fseek(flat_file->data_file, flat_file->eof_position, SEEK_SET)) {
+		status.error = err_file_bad_seek;
+		return status;
+	}
+
+	status.error = err_ok;
+
+	while (status.count < count) {
+		ion_result_count_t num_staged = count - status.count;
+
+		if (num_staged > (ion_result_count_t) flat_file->num_buffered) {
+			num_staged = flat_file->num_buffered;
+		}
+
+		for (i = 0; i < num_staged; i++) {
+			ion_byte_t *rec = &flat_file->buffer[i * flat_file->row_size];
+
+			*rec = ION_FLAT_FILE_STATUS_OCCUPIED;
+			memcpy(rec + sizeof(ion_flat_file_row_status_t), key_bytes + (status.count + i) * key_size, key_size);
+#if !ION_FLAT_FILE_SPLIT_VALUES
+			memcpy(rec + sizeof(ion_flat_file_row_status_t) + key_size, value_bytes + (status.count + i) * value_size, value_size);
+#endif
+#if ION_FLAT_FILE_USE_BLOOM
+			flat_file_bloom_add(flat_file, rec + sizeof(ion_flat_file_row_status_t));
+#endif
+		}
+
+		size_t num_written = fwrite(flat_file->buffer, flat_file->row_size, num_staged, flat_file->data_file);
+
+		status.count += num_written;
+
+		if ((size_t) num_staged != num_written) {
+			status.error = err_file_incomplete_write;
+			break;
+		}
+	}
+
+	/* Every whole row written is now part of the file */
+	flat_file->eof_position += status.count * flat_file->row_size;
+
+#if ION_FLAT_FILE_USE_INDEX
+
+	for (i = 0; flat_file->index_ready && (i < status.count); i++) {
+		flat_file_index_add(flat_file, flat_file_key_hash(flat_file, key_bytes + i * key_size), insert_loc + i);
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_FENCES
+
+	ion_fpos_t block_size = flat_file->num_buffered;
+
+	/* Extend the fence index only if it was current, otherwise the next search catches it up. */
+	if ((NULL != flat_file->fence_keys) && (flat_file->num_fences * block_size >= insert_loc)) {
+		while ((NULL != flat_file->fence_keys) && (flat_file->num_fences * block_size < insert_loc + status.count)) {
+			flat_file_add_fence(flat_file, key_bytes + (flat_file->num_fences * block_size - insert_loc) * key_size);
+		}
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+
+	if ((NULL != flat_file->segments) && (insert_loc == flat_file->learned_rows)) {
+		ion_flat_file_key_kind_t key_kind = flat_file_key_kind(flat_file);
+
+		for (i = 0; (-1 != flat_file->learned_rows) && (i < status.count); i++) {
+			flat_file_learned_add(flat_file, key_kind, key_bytes + i * key_size);
+		}
+	}
+
+#endif
+
+	return status;
+}
+
 ion_status_t
 flat_file_get(
 	ion_flat_file_t *flat_file,
@@ -433,8 +2455,17 @@ flat_file_get(
 	ion_fpos_t			found_loc	= -1;
 	ion_flat_file_row_t row;
 
+#if ION_FLAT_FILE_USE_BLOOM
+
+	if (!flat_file_bloom_may_contain(flat_file, key)) {
+		status.error = err_item_not_found;
+		return status;
+	}
+
+#endif
+
 	if (!flat_file->sorted_mode) {
-		err = flat_file_scan(flat_file, -1, &found_loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_key_match, key);
+		err = flat_file_find_key(flat_file, -1, &found_loc, &row, key);
 
 		if (err_ok != err) {
 			if (err_file_hit_eof == err) {
@@ -458,15 +2489,32 @@ flat_file_get(
 			return status;
 		}
 
-		err = flat_file_read_row(flat_file, found_loc, &row);
+		ion_fpos_t num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
 
-		if (err_ok != err) {
-			status.error = err;
+		/* Step over any deleted rows at the start of the run of matching keys. */
+		do {
+			err = flat_file_read_key(flat_file, found_loc, &row);
+
+			if (err_ok != err) {
+				status.error = err;
+				return status;
+			}
+
+			if (0 != flat_file->super.compare(row.key, key, flat_file->super.record.key_size)) {
+				status.error = err_item_not_found;
+				return status;
+			}
+		} while (ION_FLAT_FILE_STATUS_OCCUPIED != row.row_status && ++found_loc < num_rows);
+
+		if (ION_FLAT_FILE_STATUS_OCCUPIED != row.row_status) {
+			status.error = err_item_not_found;
 			return status;
 		}
 
-		if (0 != flat_file->super.compare(row.key, key, flat_file->super.record.key_size)) {
-			status.error = err_item_not_found;
+		err = flat_file_row_value(flat_file, found_loc, &row);
+
+		if (err_ok != err) {
+			status.error = err;
 			return status;
 		}
 	}
@@ -478,13 +2526,88 @@ flat_file_get(
 	return status;
 }
 
+/**
+@brief		Deletes all records stored with the given @p key from a sorted flat file.
+@details	Each matching row is marked empty in place, leaving its key behind as a
+			tombstone so that the file stays in key order for binary search. Once enough
+			of the file is tombstones, it is compacted.
+@param[in]	flat_file
+				Which flat file to delete in.
+@param[in]	key
+				Specified key to find and delete.
+@return		Resulting status of the operation.
+*/
+static ion_status_t
+flat_file_delete_sorted(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key
+) {
+	ion_status_t		status		= ION_STATUS_INITIALIZE;
+	ion_fpos_t			num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t			loc;
+	ion_flat_file_row_t row;
+	ion_err_t			err			= flat_file_binary_search(flat_file, key, &loc);
+
+	if (err_ok != err) {
+		status.error = err;
+		return status;
+	}
+
+	for (; loc < num_rows; loc++) {
+		err = flat_file_read_key(flat_file, loc, &row);
+
+		if (err_ok != err) {
+			status.error = err;
+			return status;
+		}
+
+		if (0 != flat_file->super.compare(row.key, key, flat_file->super.record.key_size)) {
+			break;
+		}
+
+		if (ION_FLAT_FILE_STATUS_OCCUPIED == row.row_status) {
+			/* Status-only write, the key stays behind to keep the order. */
+			err = flat_file_write_row(flat_file, loc, &(ion_flat_file_row_t) { ION_FLAT_FILE_STATUS_EMPTY, NULL, NULL });
+
+			if (err_ok != err) {
+				status.error = err;
+				return status;
+			}
+
+			status.count++;
+		}
+	}
+
+	if (0 == status.count) {
+		status.error = err_item_not_found;
+		return status;
+	}
+
+	flat_file->num_tombstones	+= status.count;
+	status.error				= err_ok;
+
+	if ((0 != ION_FLAT_FILE_COMPACT_PERCENT) && (flat_file->num_tombstones * 100 >= num_rows * ION_FLAT_FILE_COMPACT_PERCENT)) {
+		status.error = flat_file_compact(flat_file);
+	}
+
+	return status;
+}
+
 ion_status_t
 flat_file_delete(
 	ion_flat_file_t *flat_file,
 	ion_key_t		key
 ) {
+#if ION_FLAT_FILE_USE_BLOOM
+
+	if (!flat_file_bloom_may_contain(flat_file, key)) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+#endif
+
 	if (flat_file->sorted_mode) {
-		return ION_STATUS_ERROR(err_sorted_order_violation);
+		return flat_file_delete_sorted(flat_file, key);
 	}
 
 	ion_status_t		status	= ION_STATUS_INITIALIZE;
@@ -492,12 +2615,16 @@ flat_file_delete(
 	ion_err_t			err;
 	ion_fpos_t			loc		= -1;
 
-	while (err_ok == (err = flat_file_scan(flat_file, loc, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_key_match, key))) {
+	while (err_ok == (err = flat_file_find_key(flat_file, loc, &loc, &row, key))) {
 		ion_fpos_t			last_record_offset	= flat_file->eof_position - flat_file->row_size;
 		ion_flat_file_row_t last_row;
 		ion_fpos_t			last_record_index	= (last_record_offset - flat_file->start_of_data) / flat_file->row_size;
 		ion_err_t			row_err;
 
+#if ION_FLAT_FILE_USE_INDEX
+		uint32_t last_hash = 0;
+#endif
+
 		/* If the last index and the loc are the same, then we can just move the eof position. Saves a read/write. */
 		if (last_record_index != loc) {
 			row_err = flat_file_read_row(flat_file, last_record_index, &last_row);
@@ -507,6 +2634,10 @@ flat_file_delete(
 				return status;
 			}
 
+#if ION_FLAT_FILE_USE_INDEX
+			last_hash = flat_file_key_hash(flat_file, last_row.key);
+#endif
+
 			row_err = flat_file_write_row(flat_file, loc, &last_row);
 
 			if (err_ok != row_err) {
@@ -523,10 +2654,43 @@ flat_file_delete(
 			return status;
 		}
 
+#if ION_FLAT_FILE_USE_INDEX
+
+		if (flat_file->index_ready) {
+			/* The entry of the deleted row goes, and the entry of the last row follows it into its place. */
+			ion_fpos_t slot = flat_file_index_slot(flat_file, flat_file_key_hash(flat_file, key), loc);
+
+			if (-1 != slot) {
+				flat_file_index_remove(flat_file, slot);
+				slot = last_record_index != loc ? flat_file_index_slot(flat_file, last_hash, last_record_index) : -2;
+			}
+
+			if (-1 == slot) {
+				/* The index no longer agrees with the file, so rebuild it when next needed. */
+				flat_file->index_ready = boolean_false;
+			}
+			else if (-2 != slot) {
+				flat_file->index[slot].location = loc;
+			}
+		}
+
+#endif
+
 		/* Soft truncate the file by bumping the eof position back to cut off the last record. */
 		flat_file->eof_position = last_record_offset;
 		status.count++;
 
+#if ION_FLAT_FILE_USE_FENCES
+		/* Rows have moved, so the fence index no longer describes the file. */
+		flat_file->num_fences	= 0;
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+		/* Nor does the learned model, which is fit again from the first row. */
+		flat_file->num_segments = 0;
+		flat_file->learned_rows = 0;
+#endif
+
 		/* No location movement is done here, since we need to check the row we just swapped in to see if it is
 		   also a match. */
 	}
@@ -551,10 +2715,20 @@ flat_file_update(
 ) {
 	ion_status_t status		= ION_STATUS_INITIALIZE;
 
-	ion_fpos_t			loc = -1;
+	ion_fpos_t			loc				= -1;
+	ion_fpos_t			tombstone_loc	= -1;
 	ion_flat_file_row_t row;
 	ion_err_t			err;
 
+#if ION_FLAT_FILE_USE_BLOOM
+
+	if (!flat_file_bloom_may_contain(flat_file, key)) {
+		/* Nothing to update, so go straight to the upsert. */
+		return flat_file_insert(flat_file, key, value);
+	}
+
+#endif
+
 	if (flat_file->sorted_mode) {
 		err = flat_file_binary_search(flat_file, key, &loc);
 
@@ -568,7 +2742,7 @@ flat_file_update(
 			return status;
 		}
 
-		err = flat_file_read_row(flat_file, loc, &row);
+		err = flat_file_read_key(flat_file, loc, &row);
 
 		if (err_ok != err) {
 			status.error = err;
@@ -579,9 +2753,12 @@ flat_file_update(
 			/* Key didn't exist, do upsert. */
 			return flat_file_insert(flat_file, key, value);
 		}
+
+		/* If every row of the key turns out to be deleted, the upsert revives this one in place. */
+		tombstone_loc = loc;
 	}
 
-	while (err_ok == (err = flat_file_scan(flat_file, loc, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_key_match, key))) {
+	while (err_ok == (err = flat_file_find_key(flat_file, loc, &loc, &row, key))) {
 		ion_err_t row_err = flat_file_write_row(flat_file, loc, &(ion_flat_file_row_t) { ION_FLAT_FILE_STATUS_OCCUPIED, key, value });
 
 		if (err_ok != row_err) {
@@ -597,6 +2774,21 @@ flat_file_update(
 	status.error = err_ok;
 
 	if ((err == err_file_hit_eof) && (status.count == 0)) {
+		if (-1 != tombstone_loc) {
+			/* Appending would break the sorted order, so reuse the tombstone left by the key. */
+			status.error = flat_file_write_row(flat_file, tombstone_loc, &(ion_flat_file_row_t) { ION_FLAT_FILE_STATUS_OCCUPIED, key, value });
+
+			if (err_ok == status.error) {
+				status.count = 1;
+
+				if (flat_file->num_tombstones > 0) {
+					flat_file->num_tombstones--;
+				}
+			}
+
+			return status;
+		}
+
 		/* If this is the case, then we had nothing to update. Do an upsert instead */
 		return flat_file_insert(flat_file, key, value);
 	}
@@ -607,13 +2799,264 @@ flat_file_update(
 	return status;
 }
 
+/**
+@brief		Writes out the rows gathered at the start of the buffer by @ref flat_file_compact.
+@param[in]	flat_file
+				Which flat file to write to.
+@param[in]	write_loc
+				The row index to write the gathered rows at. It is moved past them.
+@param[in]	num_gathered
+				How many rows are gathered. It is reset to 0.
+@return		Resulting status of the write.
+*/
+static ion_err_t
+flat_file_compact_write(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		*write_loc,
+	ion_fpos_t		*num_gathered
+) {
+	if (0 == *num_gathered) {
+		return err_ok;
+	}
+
+#if ION_FLAT_FILE_USE_MMAP
+	flat_file->map_dirty = boolean_true;
+#endif
+
+	if (0 != fseek(flat_file->data_file, flat_file->start_of_data + *write_loc * flat_file->row_size, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	if ((size_t) *num_gathered != fwrite(flat_file->buffer, flat_file->row_size, *num_gathered, flat_file->data_file)) {
+		return err_file_incomplete_write;
+	}
+
+	*write_loc		+= *num_gathered;
+	*num_gathered	= 0;
+
+	return err_ok;
+}
+
+ion_err_t
+flat_file_compact(
+	ion_flat_file_t *flat_file
+) {
+	ion_fpos_t	cur_offset		= flat_file->start_of_data;
+	ion_fpos_t	end_offset		= flat_file->eof_position;
+	ion_fpos_t	write_loc		= 0;
+	ion_fpos_t	num_gathered	= 0;
+	ion_err_t	err;
+
+#if ION_FLAT_FILE_USE_BLOOM
+
+	/* Only the occupied rows survive, so the filter is rebuilt from them alone. */
+	if (NULL != flat_file->bloom) {
+		memset(flat_file->bloom, 0, ION_FLAT_FILE_BLOOM_BYTES);
+		flat_file->bloom_ready = boolean_true;
+	}
+
+#endif
+
+	/* Occupied rows are gathered at the front of the buffer and written back behind the read position, so */
+	/* nothing is overwritten before it has been read. */
+	while (cur_offset != end_offset) {
+		err = flat_file_scan_block(flat_file, &cur_offset, end_offset, ION_FLAT_FILE_SCAN_FORWARDS);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		size_t i;
+
+		for (i = 0; i < flat_file->num_in_buffer; i++) {
+			ion_byte_t *rec = &flat_file->block[i * flat_file->row_size];
+
+			if (ION_FLAT_FILE_STATUS_OCCUPIED != *rec) {
+				continue;
+			}
+
+#if ION_FLAT_FILE_USE_BLOOM
+			flat_file_bloom_add(flat_file, rec + sizeof(ion_flat_file_row_status_t));
+#endif
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+			/* Move the value along with its row. Values only ever move towards the front, so none is overwritten before it is moved. */
+			ion_fpos_t from_loc = flat_file->current_loaded_region + i;
+
+			if (from_loc != write_loc + num_gathered) {
+				ion_flat_file_row_t moved;
+
+				err = flat_file_row_value(flat_file, from_loc, &moved);
+
+				if ((err_ok == err) && ((0 != fseek(flat_file->value_file, (write_loc + num_gathered) * flat_file->super.record.value_size, SEEK_SET)) || (1 != fwrite(moved.value, flat_file->super.record.value_size, 1, flat_file->value_file)))) {
+					err = err_file_incomplete_write;
+				}
+
+				if (err_ok != err) {
+					return err;
+				}
+			}
+
+#endif
+
+			/* When reading through the buffer, the gathered rows never pass the row being read. */
+			memmove(&flat_file->buffer[num_gathered * flat_file->row_size], rec, flat_file->row_size);
+			num_gathered++;
+
+			if (num_gathered == flat_file->num_buffered) {
+				err = flat_file_compact_write(flat_file, &write_loc, &num_gathered);
+
+				if (err_ok != err) {
+					return err;
+				}
+			}
+		}
+
+		err = flat_file_compact_write(flat_file, &write_loc, &num_gathered);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		/* The buffer now holds written rows, not the region that was loaded. */
+		flat_file->current_loaded_region	= -1;
+		flat_file->num_in_buffer			= 0;
+	}
+
+	flat_file->eof_position		= flat_file->start_of_data + write_loc * flat_file->row_size;
+	flat_file->num_tombstones	= 0;
+
+#if ION_FLAT_FILE_USE_INDEX
+	/* Rows have moved, so the key index is rebuilt when next needed. */
+	flat_file->index_ready		= boolean_false;
+#endif
+
+#if ION_FLAT_FILE_USE_FENCES
+	/* Rows have moved, so the fence index no longer describes the file. */
+	flat_file->num_fences		= 0;
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+	/* Nor does the learned model, which is fit again from the first row. */
+	flat_file->num_segments		= 0;
+	flat_file->learned_rows		= 0;
+#endif
+
+	if (0 != fflush(flat_file->data_file)) {
+		return err_file_write_error;
+	}
+
+#if !defined(ARDUINO)
+
+	/* Cut the stale rows off, so that a reopen does not find them past the new EOF. */
+	if (0 != ftruncate(fileno(flat_file->data_file), flat_file->eof_position)) {
+		return err_file_write_error;
+	}
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+	if ((0 != fflush(flat_file->value_file)) || (0 != ftruncate(fileno(flat_file->value_file), write_loc * flat_file->super.record.value_size))) {
+		return err_file_write_error;
+	}
+
+#endif
+
+#else
+
+	/* Without truncation, mark every stale row empty instead. */
+	ion_fpos_t loc;
+
+	for (loc = write_loc; flat_file->start_of_data + loc * (ion_fpos_t) flat_file->row_size < end_offset; loc++) {
+		err = flat_file_write_row(flat_file, loc, &(ion_flat_file_row_t) { ION_FLAT_FILE_STATUS_EMPTY, NULL, NULL });
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+#endif
+
+	return err_ok;
+}
+
+ion_err_t
+flat_file_sync(
+	ion_flat_file_t *flat_file
+) {
+	ion_err_t err = ion_fsync_stream(flat_file->data_file);
+
+#if ION_FLAT_FILE_USE_MMAP
+
+	if (err_ok == err) {
+		flat_file->map_dirty = boolean_false;
+	}
+
+#endif
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+	if (err_ok == err) {
+		err = ion_fsync_stream(flat_file->value_file);
+	}
+
+#endif
+	return err;
+}
+
 ion_err_t
 flat_file_close(
 	ion_flat_file_t *flat_file
 ) {
-	free(flat_file->buffer);
+#if ION_FLAT_FILE_USE_MMAP
+
+	if (NULL != flat_file->map) {
+		munmap(flat_file->map, flat_file->map_size);
+		flat_file->map = NULL;
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_FENCES
+	ion_free(flat_file->fence_keys);
+	flat_file->fence_keys		= NULL;
+	flat_file->num_fences		= 0;
+	flat_file->fence_capacity	= 0;
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+	ion_free(flat_file->segments);
+	flat_file->segments			= NULL;
+	flat_file->num_segments		= 0;
+	flat_file->segment_capacity = 0;
+#endif
+
+#if ION_FLAT_FILE_USE_BLOOM
+	flat_file_bloom_save(flat_file);
+#endif
+
+#if ION_FLAT_FILE_SAVE_META
+	flat_file_meta_save(flat_file);
+#endif
+
+#if ION_FLAT_FILE_USE_INDEX
+	ion_free(flat_file->index);
+	flat_file->index			= NULL;
+	flat_file->index_ready		= boolean_false;
+#endif
+
+	ion_free(flat_file->buffer);
 	flat_file->buffer = NULL;
 
+#if ION_FLAT_FILE_SPLIT_VALUES
+	ion_free(flat_file->value_buffer);
+	flat_file->value_buffer = NULL;
+
+	if (0 != fclose(flat_file->value_file)) {
+		fclose(flat_file->data_file);
+		return err_file_close_error;
+	}
+#endif
+
 	if (0 != fclose(flat_file->data_file)) {
 		return err_file_close_error;
 	}
@@ -632,6 +3075,29 @@ flat_file_binary_search(
 	}
 
 	ion_err_t			err;
+
+#if ION_FLAT_FILE_USE_FENCES || ION_FLAT_FILE_USE_LEARNED_INDEX
+	ion_boolean_t used;
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+	err = flat_file_learned_search(flat_file, target_key, location, &used);
+
+	if (used) {
+		return err;
+	}
+
+#endif
+
+#if ION_FLAT_FILE_USE_FENCES
+	err = flat_file_fence_search(flat_file, target_key, location, &used);
+
+	if (used) {
+		return err;
+	}
+
+#endif
+
 	ion_flat_file_row_t row;
 	ion_fpos_t			low_idx		= 0;
 	ion_fpos_t			high_idx	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size - 1;
@@ -645,7 +3111,7 @@ flat_file_binary_search(
 
 	while (low_idx < high_idx) {
 		mid_idx = low_idx + (high_idx - low_idx) / 2;
-		err		= flat_file_read_row(flat_file, mid_idx, &row);
+		err		= flat_file_read_key(flat_file, mid_idx, &row);
 
 		if (err_ok != err) {
 			return err;
@@ -661,26 +3127,30 @@ flat_file_binary_search(
 		}
 		else {
 			/* Match found, scroll to beginning of (potential) duplicate block and return */
-			ion_fpos_t	last_dup_idx;
-			ion_fpos_t	dup_idx = mid_idx;
+			ion_fpos_t dup_idx = mid_idx;
 
-			do {
-				last_dup_idx	= dup_idx;
-				dup_idx--;
-				err				= flat_file_read_row(flat_file, dup_idx, &row);
+			/* Stop at the first row, so that we never read before the start of data. */
+			while (dup_idx > 0) {
+				err = flat_file_read_key(flat_file, dup_idx - 1, &row);
 
 				if (err_ok != err) {
 					return err;
 				}
-			} while (dup_idx >= 0 && 0 == flat_file->super.compare(row.key, target_key, flat_file->super.record.key_size));
 
-			*location = last_dup_idx;
+				if (0 != flat_file->super.compare(row.key, target_key, flat_file->super.record.key_size)) {
+					break;
+				}
+
+				dup_idx--;
+			}
+
+			*location = dup_idx;
 			return err_ok;
 		}
 	}
 
 	/* If we reach here, then we fell through the loop - do check and adjust for LEQ as necessary */
-	err = flat_file_read_row(flat_file, low_idx, &row);
+	err = flat_file_read_key(flat_file, low_idx, &row);
 
 	if (err_ok != err) {
 		return err;
@@ -693,3 +3163,214 @@ flat_file_binary_search(
 	*location = low_idx;
 	return low_idx >= 0 ? err_ok : err_item_not_found;
 }
+
+/**
+@brief		Finds the row just past the run of rows holding the key of the given row.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	location
+				The first row of the run.
+@param[in]	key
+				Room for a key, to hold the key of the run.
+@param[out]	end
+				The row index just past the run.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_run_end(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location,
+	ion_byte_t		*key,
+	ion_fpos_t		*end
+) {
+	ion_fpos_t			num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_flat_file_row_t row;
+	ion_err_t			err;
+
+	if (err_ok != (err = flat_file_read_key(flat_file, location, &row))) {
+		return err;
+	}
+
+	/* The row read may be overwritten by the next, so its key is kept aside. */
+	memcpy(key, row.key, flat_file->super.record.key_size);
+
+	for (*end = location + 1; *end < num_rows; (*end)++) {
+		if (err_ok != (err = flat_file_read_key(flat_file, *end, &row))) {
+			return err;
+		}
+
+		if (0 != flat_file->super.compare(row.key, key, flat_file->super.record.key_size)) {
+			break;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+flat_file_find_span(
+	ion_flat_file_t			*flat_file,
+	ion_key_t				lower_bound,
+	ion_key_t				upper_bound,
+	ion_flat_file_span_t	*span
+) {
+	ion_byte_t	*key;
+	ion_fpos_t	location;
+	ion_err_t	err;
+
+	span->next	= 0;
+	span->end	= 0;
+
+	if (!flat_file->sorted_mode) {
+		return err_sorted_order_violation;
+	}
+
+	if (flat_file->super.compare(lower_bound, upper_bound, flat_file->super.record.key_size) > 0) {
+		return err_ok;
+	}
+
+	/* The last run of keys not past the upper bound ends the span, if there is one. */
+	err = flat_file_binary_search(flat_file, upper_bound, &location);
+
+	if (err_item_not_found == err) {
+		return err_ok;
+	}
+	else if (err_ok != err) {
+		return err;
+	}
+
+	if (NULL == (key = ion_alloc(ion_alloc_buffer, flat_file->super.record.key_size))) {
+		return err_out_of_memory;
+	}
+
+	if (err_ok != (err = flat_file_run_end(flat_file, location, key, &span->end))) {
+		span->end = 0;
+		ion_free(key);
+		return err;
+	}
+
+	/* The span starts at the run of the lower bound, or else past the last run before it. */
+	err = flat_file_binary_search(flat_file, lower_bound, &location);
+
+	if (err_item_not_found == err) {
+		err = err_ok;
+	}
+	else if (err_ok == err) {
+		ion_flat_file_row_t row;
+
+		if (err_ok == (err = flat_file_read_key(flat_file, location, &row))) {
+			if (flat_file->super.compare(row.key, lower_bound, flat_file->super.record.key_size) < 0) {
+				err = flat_file_run_end(flat_file, location, key, &span->next);
+			}
+			else {
+				span->next = location;
+			}
+		}
+	}
+
+	if (err_ok != err) {
+		span->next	= 0;
+		span->end	= 0;
+	}
+
+	ion_free(key);
+	return err;
+}
+
+/**
+@brief		Reads the values of a run of rows of a split flat file into a batch buffer.
+*/
+static ion_err_t
+flat_file_span_values(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location,
+	ion_byte_t		*values,
+	int				count
+) {
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+	if (0 == count) {
+		return err_ok;
+	}
+
+	if (0 != fseek(flat_file->value_file, location * flat_file->super.record.value_size, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	if ((size_t) count != fread(values, flat_file->super.record.value_size, count, flat_file->value_file)) {
+		return err_file_incomplete_read;
+	}
+
+#else
+	UNUSED(flat_file);
+	UNUSED(location);
+	UNUSED(values);
+	UNUSED(count);
+#endif
+
+	return err_ok;
+}
+
+ion_err_t
+flat_file_read_span(
+	ion_flat_file_t			*flat_file,
+	ion_flat_file_span_t	*span,
+	ion_key_t				keys,
+	ion_value_t				values,
+	int						max,
+	int						*count
+) {
+	ion_key_size_t		key_size	= flat_file->super.record.key_size;
+	ion_value_size_t	value_size	= flat_file->super.record.value_size;
+	ion_fpos_t			cur_offset;
+	ion_fpos_t			last;
+	ion_fpos_t			run_start;
+	int					run_count;
+	ion_byte_t			*rec;
+	ion_err_t			err;
+
+	*count = 0;
+
+	while ((*count < max) && (span->next < span->end)) {
+		/* The rest of a block loaded by the last read is used before anything more is read. */
+		if ((-1 == flat_file->current_loaded_region) || (span->next < flat_file->current_loaded_region) || ((unsigned) span->next >= flat_file->current_loaded_region + flat_file->num_in_buffer)) {
+			cur_offset = flat_file->start_of_data + span->next * flat_file->row_size;
+
+			if (err_ok != (err = flat_file_scan_block(flat_file, &cur_offset, flat_file->start_of_data + span->end * flat_file->row_size, ION_FLAT_FILE_SCAN_FORWARDS))) {
+				return err;
+			}
+		}
+
+		last		= flat_file->current_loaded_region + flat_file->num_in_buffer;
+		last		= last < span->end ? last : span->end;
+		run_start	= span->next;
+		run_count	= *count;
+
+		for (; (span->next < last) && (*count < max); span->next++) {
+			rec = &flat_file->block[(span->next - flat_file->current_loaded_region) * flat_file->row_size];
+
+			if (ION_FLAT_FILE_STATUS_OCCUPIED != *rec) {
+				/* A deleted row ends the run of values read together. */
+				if (err_ok != (err = flat_file_span_values(flat_file, run_start, (ion_byte_t *) values + run_count * value_size, *count - run_count))) {
+					return err;
+				}
+
+				run_start	= span->next + 1;
+				run_count	= *count;
+				continue;
+			}
+
+			memcpy((ion_byte_t *) keys + *count * key_size, rec + sizeof(ion_flat_file_row_status_t), key_size);
+#if !ION_FLAT_FILE_SPLIT_VALUES
+			memcpy((ion_byte_t *) values + *count * value_size, rec + sizeof(ion_flat_file_row_status_t) + key_size, value_size);
+#endif
+			(*count)++;
+		}
+
+		if (err_ok != (err = flat_file_span_values(flat_file, run_start, (ion_byte_t *) values + run_count * value_size, *count - run_count))) {
+			return err;
+		}
+	}
+
+	return err_ok;
+}
@@ -51,7 +51,10 @@ extern "C" {
 				Value size, in bytes used for this instance.
 @param[in]	dictionary_size
 				Dictionary size is interpreted as how many records (key value pairs) are buffered. This should be given
-				as somewhere between 1 (minimum) and the page size of the device you are working on.
+				as somewhere between 1 (minimum) and the page size of the device you are working on. If given as 0
+				or -1, one device block of rows is buffered, as sized by the file system. When rows
+				are read through a mapping (see @ref ION_FLAT_FILE_USE_MMAP), the buffer is only used if
+				mapping fails.
 @return		The status of initialization.
 @see		ffdict_create_dictionary
 */
@@ -95,8 +98,36 @@ flat_file_insert(
 	ion_value_t		value
 );
 
+/**
+@brief		Appends a batch of records to the flat file store.
+@details	The batch is staged into the row buffer and written with one @p fwrite per
+			buffer of rows, and the EOF position is moved once. In sorted mode, the
+			whole batch is checked for order before anything is written, so a batch
+			that would break the order is refused as a whole.
+@param[in]	flat_file
+				Which flat file to insert into.
+@param[in]	keys
+				The keys of the batch, packed back to back.
+@param[in]	values
+				The values of the batch, packed back to back in the same order.
+@param[in]	count
+				How many records the batch holds.
+@return		Resulting status of insertion. The count is the number of records written,
+			which is less than @p count only if a write failed.
+*/
+ion_status_t
+flat_file_insert_batch(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_result_count_t	count
+);
+
 /**
 @brief		Fetches the record stored with the given @p key.
+@details	If the Bloom filter of the flat file (see @ref ION_FLAT_FILE_USE_BLOOM) rules
+			the key out, this returns without reading any rows. The same holds for
+			@ref flat_file_delete and @ref flat_file_update.
 @param[in]	flat_file
 				Which flat file to look in.
 @param[in]	key
@@ -116,6 +147,8 @@ flat_file_get(
 
 /**
 @brief		Deletes all records stored with the given @p key.
+@details	In sorted mode, the rows are marked empty where they lie, which keeps the rest
+			of the file in key order. The space is reclaimed by @ref flat_file_compact.
 @param[in]	flat_file
 				Which flat file to delete in.
 @param[in]	key
@@ -148,6 +181,34 @@ flat_file_update(
 	ion_value_t		value
 );
 
+/**
+@brief		Rewrites the flat file so that every occupied row is packed, in order,
+			at the front of the file, and shrinks the file to fit.
+@details	This drops the tombstones that sorted mode deletes leave behind, as well as
+			any other empty rows. Rows are streamed through the buffer in a single
+			sequential pass, so no scratch file is needed. A sorted mode delete calls
+			this by itself once @ref ION_FLAT_FILE_COMPACT_PERCENT of the rows are tombstones.
+			The Bloom filter, if any, is rebuilt from the rows that remain.
+@param[in]	flat_file
+				Which flat file to compact.
+@return		Resulting status of the compaction.
+*/
+ion_err_t
+flat_file_compact(
+	ion_flat_file_t *flat_file
+);
+
+/**
+@brief		Pushes every row written to the flat file through to storage.
+@param		flat_file
+				Which flat file to sync.
+@return		Status of the sync.
+*/
+ion_err_t
+flat_file_sync(
+	ion_flat_file_t *flat_file
+);
+
 /**
 @brief		Closes and frees any memory associated with the flat file.
 @param		flat_file
@@ -187,8 +248,7 @@ flat_file_close(
 					returns true, the scan is terminated and the found location and row
 					are written back to their respective output parameters.
 @return			Resulting status of scan.
-@todo			Try changing the predicate to be an enum-and-switch to eliminate the function
-				call. Benchmark the performance gain and decide which strategy to use.
+@see			flat_file_scan_match, which is faster for the stock predicates.
 @todo			Consider changing to @p SEEK_CUR whenever possible. Benchmark this and see
 				if the performance gain (if any) is worth it.
 */
@@ -203,6 +263,43 @@ flat_file_scan(
 	...
 );
 
+/**
+@brief			Performs a linear scan of the flat file writing the first location
+				seen that satisfies the given @p match to @p location.
+@details		Behaves as @ref flat_file_scan does with the equivalent stock
+				predicate, but evaluates each loaded block of rows in a single loop
+				with no per-row call, bar the filter of a filter match, which sees
+				the rows where they are loaded. Integer keys of 4 or 8 bytes that use the stock
+				numeric comparators are compared natively. If @p start_location lies
+				in the region loaded by the previous scan, the rest of that region is
+				tested before anything more is read, so stepping through the file one
+				match at a time reads each block only once.
+@param[in]		flat_file
+					Which flat file instance to scan.
+@param[in]		start_location
+					Where to begin the scan, as for @ref flat_file_scan.
+@param[out]		location
+					Allocated memory location to write back the found location into.
+@param[out]		row
+					A row struct to write back the found row into. This is allocated
+					by the user.
+@param[in]		scan_direction
+					Scans in the direction provided.
+@param[in]		match
+					Describes the rows to look for. The keys it points to must stay
+					valid for the duration of the scan.
+@return			Resulting status of scan.
+*/
+ion_err_t
+flat_file_scan_match(
+	ion_flat_file_t			*flat_file,
+	ion_fpos_t				start_location,
+	ion_fpos_t				*location,
+	ion_flat_file_row_t		*row,
+	ion_byte_t				scan_direction,
+	ion_flat_file_match_t	*match
+);
+
 /**
 @brief		Predicate function to return any row that has an exact match to the given target key.
 @details	We expect one @ref ion_key_t to be in @p args.
@@ -277,7 +374,10 @@ flat_file_read_row(
 			of duplicates, before writing back to @p location. As a result, it is guaranteed that
 			the returned index points to the first key in a contiguous block of duplicate keys. If
 			no key in the flat file satisfies the condition of being less-than-or-equal, then @p -1
-			is written back to @p location. This function will only return records that are not deleted.
+			is written back to @p location. Rows deleted in sorted mode keep their keys, so the
+			row found may be one of them; callers must check its status.
+			When @ref ION_FLAT_FILE_USE_FENCES is enabled, the first key of every block of rows is kept
+			in memory, and the search reads a single block instead of probing the file.
 @param[in]		flat_file
 				Which flat file instance to search within.
 @param[in]		target_key
@@ -293,6 +393,63 @@ flat_file_binary_search(
 	ion_fpos_t		*location
 );
 
+/**
+@brief		Finds the rows of a sorted flat file whose keys lie within
+			`lower_bound <= key <= upper_bound`.
+@details	Both ends are found by @ref flat_file_binary_search, so the rows
+			before and after the range are never read, bar the duplicates of a
+			key at its edge. The span may hold rows deleted in sorted mode, which
+			@ref flat_file_read_span skips.
+@param[in]	flat_file
+				Which flat file instance to search within.
+@param[in]	lower_bound
+				The least key of the range.
+@param[in]	upper_bound
+				The greatest key of the range.
+@param[out]	span
+				The rows found, empty if no key lies within the range.
+@return		@ref err_sorted_order_violation if the flat file is not in sorted mode,
+			otherwise the resulting status of the searches.
+*/
+ion_err_t
+flat_file_find_span(
+	ion_flat_file_t			*flat_file,
+	ion_key_t				lower_bound,
+	ion_key_t				upper_bound,
+	ion_flat_file_span_t	*span
+);
+
+/**
+@brief		Copies the next occupied rows of a span into batch buffers.
+@details	The rows are read a block at a time, as a scan reads them, but with no
+			test of their keys, since every row of the span is known to lie in its
+			range. The values of split files are read with one read for each run of
+			occupied rows. The span is moved past the rows read.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	span
+				The rows left to read, as found by @ref flat_file_find_span.
+@param[out]	keys
+				Room for @p max keys, written back to back.
+@param[out]	values
+				Room for @p max values, written back to back.
+@param[in]	max
+				The most rows to copy.
+@param[out]	count
+				How many rows were copied. Fewer than @p max only once the span
+				is used up, or on an error.
+@return		Resulting status of the file operations.
+*/
+ion_err_t
+flat_file_read_span(
+	ion_flat_file_t			*flat_file,
+	ion_flat_file_span_t	*span,
+	ion_key_t				keys,
+	ion_value_t				values,
+	int						max,
+	int						*count
+);
+
 #if defined(__cplusplus)
 }
 #endif
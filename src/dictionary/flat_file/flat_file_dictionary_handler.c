@@ -58,25 +58,28 @@ ffdict_next(
 			/* TODO: Implement sorted mode search */
 			switch (cursor->predicate->type) {
 				case predicate_equality: {
-					err = flat_file_scan(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_key_match, cursor->predicate->statement.equality.equality_value);
+					err = flat_file_scan_match(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, cursor->predicate->statement.equality.equality_value, NULL });
 
 					break;
 				}
 
 				case predicate_range: {
-					err = flat_file_scan(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_within_bounds, cursor->predicate->statement.range.lower_bound, cursor->predicate->statement.range.upper_bound);
+					err = flat_file_scan_match(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_WITHIN_BOUNDS, cursor->predicate->statement.range.lower_bound, cursor->predicate->statement.range.upper_bound });
 
 					break;
 				}
 
 				case predicate_all_records: {
-					err = flat_file_scan(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_not_empty);
+					err = flat_file_scan_match(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL });
 
 					break;
 				}
 
 				case predicate_predicate: {
-					/* TODO not implemented */
+					ion_other_predicate_statement_t *other = &cursor->predicate->statement.other_predicate;
+
+					err = flat_file_scan_match(flat_file, flat_file_cursor->current_location + 1, &flat_file_cursor->current_location, &throwaway_row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_FILTER, NULL, NULL, other->filter, other->context });
+
 					break;
 				}
 			}
@@ -102,9 +105,9 @@ ffdict_next(
 			return cs_invalid_index;
 		}
 
-		/*Copy both key and value into user provided struct */
+		/* Copy the key and the bytes of the value wanted into user provided struct */
 		memcpy(record->key, row.key, cursor->dictionary->instance->record.key_size);
-		memcpy(record->value, row.value, cursor->dictionary->instance->record.value_size);
+		memcpy((ion_byte_t *) record->value + cursor->value_offset, (ion_byte_t *) row.value + cursor->value_offset, cursor->value_size);
 
 		return cursor->status;
 	}
@@ -124,7 +127,7 @@ ffdict_destroy_cursor(
 	ion_dict_cursor_t **cursor
 ) {
 	(*cursor)->predicate->destroy(&(*cursor)->predicate);
-	free(*cursor);
+	ion_free(*cursor);
 	*cursor = NULL;
 }
 
@@ -169,7 +172,7 @@ ffdict_close_dictionary(
 ) {
 	ion_err_t err = flat_file_close((ion_flat_file_t *) dictionary->instance);
 
-	free(dictionary->instance);
+	ion_free(dictionary->instance);
 	dictionary->instance = NULL;
 
 	if (err_ok != err) {
@@ -179,6 +182,61 @@ ffdict_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief		Reads up to @p max records of a range cursor of a sorted flat file,
+			from the rows of its span.
+*/
+static int
+ffdict_span_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+) {
+	ion_flat_file_cursor_t	*flat_file_cursor	= (ion_flat_file_cursor_t *) cursor;
+	int						read				= 0;
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active != cursor->status) {
+		return 0;
+	}
+
+	if (err_ok != flat_file_read_span((ion_flat_file_t *) cursor->dictionary->instance, &flat_file_cursor->span, keys, values, max, &read)) {
+		cursor->status = cs_possible_data_inconsistency;
+	}
+	else if (read < max) {
+		cursor->status = cs_end_of_results;
+	}
+
+	return read;
+}
+
+/**
+@brief		Fetches the next record of a range cursor of a sorted flat file,
+			see @ref ffdict_next.
+*/
+static ion_cursor_status_t
+ffdict_span_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	if ((cs_cursor_initialized != cursor->status) && (cs_cursor_active != cursor->status)) {
+		return cursor->status;
+	}
+
+	if (1 != ffdict_span_next_batch(cursor, record->key, record->value, 1)) {
+		if (cs_cursor_active == cursor->status) {
+			cursor->status = cs_end_of_results;
+		}
+
+		return cursor->status;
+	}
+
+	return cs_cursor_active;
+}
+
 /**
 @brief			Initializes a cursor query and returns an allocated cursor object.
 @details		Given a @p predicate that was previously initialized by @ref dictionary_build_predicate,
@@ -200,7 +258,7 @@ ffdict_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
-	*cursor = malloc(sizeof(ion_flat_file_cursor_t));
+	*cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_flat_file_cursor_t));
 
 	ion_flat_file_t *flat_file = (ion_flat_file_t *) dictionary->instance;
 
@@ -210,14 +268,17 @@ ffdict_find(
 
 	(*cursor)->dictionary	= dictionary;
 	(*cursor)->status		= cs_cursor_uninitialized;
+	(*cursor)->value_offset = 0;
+	(*cursor)->value_size	= dictionary->instance->record.value_size;
 
 	(*cursor)->destroy		= ffdict_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
 	(*cursor)->next			= ffdict_next;
 
-	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
+	(*cursor)->predicate	= ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t));
 
 	if (NULL == (*cursor)->predicate) {
-		free(*cursor);
+		ion_free(*cursor);
 		return err_out_of_memory;
 	}
 
@@ -231,11 +292,11 @@ ffdict_find(
 		case predicate_equality: {
 			ion_key_t target_key = predicate->statement.equality.equality_value;
 
-			(*cursor)->predicate->statement.equality.equality_value = malloc(key_size);
+			(*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.equality.equality_value) {
-				free((*cursor)->predicate);
-				free(*cursor);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
@@ -243,7 +304,7 @@ ffdict_find(
 
 			ion_fpos_t			loc			= -1;
 			ion_flat_file_row_t row;
-			ion_err_t			scan_result = flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_key_match, target_key);
+			ion_err_t			scan_result = flat_file_scan_match(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, target_key, NULL });
 
 			if (err_file_hit_eof == scan_result) {
 				/* If this happens, that means the target key doesn't exist */
@@ -267,31 +328,51 @@ ffdict_find(
 		}
 
 		case predicate_range: {
-			(*cursor)->predicate->statement.range.lower_bound = malloc(key_size);
+			(*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.lower_bound) {
-				free((*cursor)->predicate);
-				free(*cursor);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
 			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
 
-			(*cursor)->predicate->statement.range.upper_bound = malloc(key_size);
+			(*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.upper_bound) {
-				free((*cursor)->predicate->statement.range.lower_bound);
-				free((*cursor)->predicate);
-				free(*cursor);
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
 			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
 
+			if (flat_file->sorted_mode) {
+				/* Both ends of the range are searched for, and the rows between read with no tests. */
+				ion_flat_file_cursor_t	*flat_file_cursor	= (ion_flat_file_cursor_t *) (*cursor);
+				ion_err_t				err					= flat_file_find_span(flat_file, (*cursor)->predicate->statement.range.lower_bound, (*cursor)->predicate->statement.range.upper_bound, &flat_file_cursor->span);
+
+				if (err_ok != err) {
+					ion_free((*cursor)->predicate->statement.range.upper_bound);
+					ion_free((*cursor)->predicate->statement.range.lower_bound);
+					ion_free((*cursor)->predicate);
+					ion_free(*cursor);
+					*cursor = NULL;
+					return err;
+				}
+
+				(*cursor)->next			= ffdict_span_next;
+				(*cursor)->next_batch	= ffdict_span_next_batch;
+				(*cursor)->status		= flat_file_cursor->span.next < flat_file_cursor->span.end ? cs_cursor_initialized : cs_end_of_results;
+				return err_ok;
+			}
+
 			/* Find the first satisfactory key. */
 			ion_fpos_t			loc			= -1;
 			ion_flat_file_row_t row;
-			ion_err_t			scan_result = flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_within_bounds, (*cursor)->predicate->statement.range.lower_bound, (*cursor)->predicate->statement.range.upper_bound);
+			ion_err_t			scan_result = flat_file_scan_match(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_WITHIN_BOUNDS, (*cursor)->predicate->statement.range.lower_bound, (*cursor)->predicate->statement.range.upper_bound });
 
 			if (err_file_hit_eof == scan_result) {
 				/* This means the returned node is smaller than the lower bound, which means that there are no valid records to return */
@@ -319,7 +400,7 @@ ffdict_find(
 
 			ion_fpos_t			loc						= -1;
 			ion_flat_file_row_t row;
-			ion_err_t			scan_result				= flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_not_empty);
+			ion_err_t			scan_result				= flat_file_scan_match(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL });
 
 			if (err_file_hit_eof == scan_result) {
 				(*cursor)->status = cs_end_of_results;
@@ -338,7 +419,29 @@ ffdict_find(
 		}
 
 		case predicate_predicate: {
-			/* TODO not implemented */
+			ion_flat_file_cursor_t			*flat_file_cursor	= (ion_flat_file_cursor_t *) (*cursor);
+			ion_other_predicate_statement_t *other				= &predicate->statement.other_predicate;
+
+			(*cursor)->predicate->statement.other_predicate = *other;
+
+			/* The filter is tested on the rows as they are loaded, without a copy of each. */
+			ion_fpos_t			loc			= -1;
+			ion_flat_file_row_t row;
+			ion_err_t			scan_result = flat_file_scan_match(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_FILTER, NULL, NULL, other->filter, other->context });
+
+			if (err_file_hit_eof == scan_result) {
+				(*cursor)->status = cs_end_of_results;
+			}
+			else if (err_ok == scan_result) {
+				flat_file_cursor->current_location	= loc;
+				(*cursor)->status					= cs_cursor_initialized;
+			}
+			else {
+				/* Scan failure */
+				return scan_result;
+			}
+
+			return err_ok;
 			break;
 		}
 
@@ -351,6 +454,47 @@ ffdict_find(
 	return err_ok;
 }
 
+/**
+@brief		Pushes every write of a flat file dictionary through to storage.
+*/
+static ion_err_t
+ffdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return flat_file_sync((ion_flat_file_t *) dictionary->instance);
+}
+
+/**
+@brief		Tells the size of a flat file dictionary, see
+			@ref dictionary_get_info. Its rows are its pages; how many of
+			them are deleted is not known without reading them.
+*/
+static ion_err_t
+ffdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_flat_file_t	*flat_file	= (ion_flat_file_t *) dictionary->instance;
+	long				rows		= (long) ((flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size);
+
+	info->pages			= rows;
+	info->file_bytes	= (long) flat_file->eof_position;
+	info->memory_bytes	= (long) (flat_file->num_buffered * flat_file->row_size);
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+	info->file_bytes	+= rows * flat_file->super.record.value_size;
+	info->memory_bytes	+= flat_file->super.record.value_size;
+#endif
+#if ION_FLAT_FILE_USE_FENCES
+	info->memory_bytes	+= (long) (flat_file->fence_capacity * flat_file->super.record.key_size);
+#endif
+#if ION_FLAT_FILE_USE_INDEX
+	info->memory_bytes	+= (long) (flat_file->index_capacity * sizeof(ion_flat_file_index_entry_t));
+#endif
+
+	return err_ok;
+}
+
 void
 ffdict_init(
 	ion_dictionary_handler_t *handler
@@ -364,6 +508,13 @@ ffdict_init(
 	handler->delete_dictionary	= ffdict_delete_dictionary;
 	handler->open_dictionary	= ffdict_open_dictionary;
 	handler->close_dictionary	= ffdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= ffdict_insert_many;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= ffdict_sync_dictionary;
+	handler->get_info			= ffdict_get_info;
+	handler->bulk_load			= NULL;
 }
 
 ion_status_t
@@ -375,6 +526,34 @@ ffdict_insert(
 	return flat_file_insert((ion_flat_file_t *) dictionary->instance, key, value);
 }
 
+ion_status_t
+ffdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_result_count_t	count
+) {
+	return flat_file_insert_batch((ion_flat_file_t *) dictionary->instance, keys, values, count);
+}
+
+ion_status_t
+ffdict_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+) {
+	ion_status_t	status = flat_file_insert_batch((ion_flat_file_t *) dictionary->instance, keys, values, count);
+	int				i;
+
+	for (i = 0; (NULL != statuses) && (i < count); i++) {
+		statuses[i] = (i < status.count) ? ION_STATUS_OK(1) : ION_STATUS_ERROR(status.error);
+	}
+
+	return status;
+}
+
 ion_status_t
 ffdict_get(
 	ion_dictionary_t	*dictionary,
@@ -395,7 +574,7 @@ ffdict_create_dictionary(
 	ion_dictionary_handler_t	*handler,
 	ion_dictionary_t			*dictionary
 ) {
-	dictionary->instance = malloc(sizeof(ion_flat_file_t));
+	dictionary->instance = ion_alloc(ion_alloc_other, sizeof(ion_flat_file_t));
 
 	if (NULL == dictionary->instance) {
 		return err_out_of_memory;
@@ -426,7 +605,7 @@ ffdict_delete_dictionary(
 ) {
 	ion_err_t result = flat_file_destroy((ion_flat_file_t *) dictionary->instance);
 
-	free(dictionary->instance);
+	ion_free(dictionary->instance);
 	dictionary->instance = NULL;
 	return result;
 }
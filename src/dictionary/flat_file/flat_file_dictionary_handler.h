@@ -63,6 +63,55 @@ ffdict_insert(
 	ion_value_t			value
 );
 
+/**
+@brief		Inserts a batch of records into the dictionary in one append.
+@param[in]	dictionary
+				The initialized flat file dictionary instance we want to insert into.
+@param[in]	keys
+				The keys of the batch, packed back to back.
+@param[in]	values
+				The values of the batch, packed back to back in the same order.
+@param[in]	count
+				How many records the batch holds.
+@return		The resulting status of the operation.
+@see		flat_file_insert_batch
+*/
+ion_status_t
+ffdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_result_count_t	count
+);
+
+/**
+@brief		Inserts a batch of records for @ref dictionary_insert_many, in
+			one append.
+@details	The records written are those at the front of the batch, so
+			each of them is reported inserted and each of the rest is
+			reported with the error that stopped the append.
+@param[in]	dictionary
+				The initialized flat file dictionary instance we want to insert into.
+@param[in]	keys
+				The keys of the batch, packed back to back.
+@param[in]	values
+				The values of the batch, packed back to back in the same order.
+@param[out]	statuses
+				If not @c NULL, receives the status of each record.
+@param[in]	count
+				How many records the batch holds.
+@return		The resulting status of the operation.
+@see		flat_file_insert_batch
+*/
+ion_status_t
+ffdict_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+);
+
 /**
 @brief		Performs a "get" operation on the dictionary to retrieve a single record.
 @details	Given a @p key, returns the associated value stored under
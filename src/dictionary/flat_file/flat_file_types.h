@@ -54,6 +54,199 @@ typedef ion_byte_t ion_flat_file_row_status_t;
 */
 #define ION_FLAT_FILE_SCAN_BACKWARDS	0
 
+/**
+@brief		Whether flat files read their rows through a memory mapping of the data file.
+@details	When enabled, scans and row reads address rows directly in a read-only
+			mapping instead of copying them into the row buffer, and the page cache
+			takes the place of that buffer. Writes still go through stdio. This is
+			the default on POSIX hosts; Arduino and other targets keep the buffered
+			path. Define as 0 to force the buffered path everywhere.
+*/
+#if !defined(ION_FLAT_FILE_USE_MMAP)
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define ION_FLAT_FILE_USE_MMAP	1
+#else
+#define ION_FLAT_FILE_USE_MMAP	0
+#endif
+#endif
+
+/**
+@brief		Whether flat files keep their values in a separate file from their statuses and keys.
+@details	When enabled, the data file holds rows of only a status and a key, and the
+			values are kept at the same row index in a second file. Scans, binary searches
+			and compaction then read just the key rows, and a value is only read once its
+			row is returned. The predicates given to @ref flat_file_scan only see the status
+			and key of each row. This is worth it when values are much larger than keys. It
+			is a build time choice, since the files of one layout cannot be read as the other.
+*/
+#if !defined(ION_FLAT_FILE_SPLIT_VALUES)
+#define ION_FLAT_FILE_SPLIT_VALUES	0
+#endif
+
+/**
+@brief		How many bytes of rows a mapped scan works through at a time.
+@details	Before testing one window of rows, the scan asks the kernel to start
+			reading the next window in the direction of the scan, so that the
+			I/O for it overlaps with the work on the current one. This matters
+			most for backward scans, which the kernel does not read ahead on its own.
+*/
+#if !defined(ION_FLAT_FILE_READ_AHEAD_BYTES)
+#define ION_FLAT_FILE_READ_AHEAD_BYTES	65536
+#endif
+
+/**
+@brief		The device block size a flat file sizes its row buffer by, when the
+			dictionary size leaves the choice to it and the file system gives no hint.
+*/
+#if !defined(ION_FLAT_FILE_DEVICE_BLOCK_SIZE)
+#define ION_FLAT_FILE_DEVICE_BLOCK_SIZE	512
+#endif
+
+/**
+@brief		Whether sorted mode searches are narrowed by an in-memory fence index.
+@details	The index holds the first key of every block of @p num_buffered rows, so a
+			search reads a single block instead of probing the file. It costs one key
+			per block of heap memory, so it is off by default on Arduino. Define as 0
+			to always search the file directly.
+*/
+#if !defined(ION_FLAT_FILE_USE_FENCES)
+#if !defined(ARDUINO)
+#define ION_FLAT_FILE_USE_FENCES	1
+#else
+#define ION_FLAT_FILE_USE_FENCES	0
+#endif
+#endif
+
+/**
+@brief		Whether flat files keep a Bloom filter of their keys, so that looking up a key
+			that is not stored usually finishes without reading any rows.
+@details	The filter takes @ref ION_FLAT_FILE_BLOOM_BYTES of heap memory and is kept in a
+			sidecar file next to the data file between sessions. Inserts add to it and
+			compaction rebuilds it; deletes leave it alone, which costs only false positives.
+			It is only consulted for the stock comparators, which treat keys as equal
+			exactly when their bytes are. It is off by default on Arduino.
+*/
+#if !defined(ION_FLAT_FILE_USE_BLOOM)
+#if !defined(ARDUINO)
+#define ION_FLAT_FILE_USE_BLOOM		1
+#else
+#define ION_FLAT_FILE_USE_BLOOM		0
+#endif
+#endif
+
+/**
+@brief		How many bytes the Bloom filter of a flat file takes.
+*/
+#if !defined(ION_FLAT_FILE_BLOOM_BYTES)
+#define ION_FLAT_FILE_BLOOM_BYTES	4096
+#endif
+
+/**
+@brief		How many bits of the Bloom filter each key sets.
+*/
+#if !defined(ION_FLAT_FILE_BLOOM_HASHES)
+#define ION_FLAT_FILE_BLOOM_HASHES	4
+#endif
+
+/**
+@brief		Whether flat files save where their rows end when closed, so that opening
+			one again reads a few bytes instead of scanning back over its empty rows.
+@details	The end of the rows and the count of tombstones are kept in a sidecar file
+			next to the data file, along with the size of the data file and the layout
+			of its rows. Opening trusts the sidecar only if those still match, and scans
+			otherwise. Like the Bloom filter's, it is removed once loaded, so a session
+			that ends without closing leaves none behind.
+*/
+#if !defined(ION_FLAT_FILE_SAVE_META)
+#define ION_FLAT_FILE_SAVE_META 1
+#endif
+
+/**
+@brief		Whether unsorted flat files keep an in-memory hash index from keys to row locations.
+@details	With the index, a get, update or delete outside of sorted mode reads only the
+			rows whose key hashes the same, instead of scanning the file. It costs about
+			16 bytes of heap memory per row, so it is off by default. It is built in one
+			sequential pass by the first point operation that needs it, kept current by
+			inserts and deletes, and rebuilt after compaction. Like the Bloom filter, it is
+			only used with the stock comparators.
+*/
+#if !defined(ION_FLAT_FILE_USE_INDEX)
+#define ION_FLAT_FILE_USE_INDEX 0
+#endif
+
+/**
+@brief		Percent of sorted mode rows that may be tombstones before a delete compacts the file.
+@details	Sorted mode deletes only mark rows as empty, so that the rows stay in key order.
+			Define as 0 to only compact through @ref flat_file_compact.
+*/
+#if !defined(ION_FLAT_FILE_COMPACT_PERCENT)
+#define ION_FLAT_FILE_COMPACT_PERCENT	50
+#endif
+
+/**
+@brief		Whether sorted mode searches of natively compared keys first ask a learned model where a key lies.
+@details	The model is a run of line segments from keys to row indexes, fit in one pass so
+			that it is never more than @ref ION_FLAT_FILE_LEARNED_ERROR rows from the first row
+			of any key. A search then reads the few rows around its prediction in one read.
+			A handful of segments describe near uniform keys, such as timestamps or sequence
+			numbers, however many rows they fill. The model is built by the first search that
+			needs it, kept current by appends and rebuilt after rows move. If it would take
+			more than @ref ION_FLAT_FILE_LEARNED_BYTES, it is dropped until rows next move, and
+			searches go to the fence index instead. It is off by default on Arduino.
+*/
+#if !defined(ION_FLAT_FILE_USE_LEARNED_INDEX)
+#if !defined(ARDUINO)
+#define ION_FLAT_FILE_USE_LEARNED_INDEX 1
+#else
+#define ION_FLAT_FILE_USE_LEARNED_INDEX 0
+#endif
+#endif
+
+/**
+@brief		How many rows the learned model may be off by. A search reads twice this, and
+			4 rows more, so it is lowered to fit in the buffer of smaller flat files.
+*/
+#if !defined(ION_FLAT_FILE_LEARNED_ERROR)
+#define ION_FLAT_FILE_LEARNED_ERROR 8
+#endif
+
+/**
+@brief		The most bytes of heap memory the segments of the learned model may take.
+*/
+#if !defined(ION_FLAT_FILE_LEARNED_BYTES)
+#define ION_FLAT_FILE_LEARNED_BYTES 4096
+#endif
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+
+/**
+@brief		One segment of the learned model of a flat file.
+*/
+typedef struct {
+	/**> The first key the segment describes. */
+	double		key;
+	/**> How many rows on from @p row a key lies, per unit it is past @p key. */
+	double		slope;
+	/**> The row index of the first row holding @p key. */
+	ion_fpos_t	row;
+} ion_flat_file_segment_t;
+
+#endif
+
+#if ION_FLAT_FILE_USE_INDEX
+
+/**
+@brief		One entry of the in-memory key index of a flat file.
+*/
+typedef struct {
+	/**> The hash of the key held by the row. */
+	uint32_t	hash;
+	/**> The row index of the row, or -1 if the entry is free. */
+	ion_fpos_t	location;
+} ion_flat_file_index_entry_t;
+
+#endif
+
 /**
 @brief		Metadata container that holds flat file specific information.
 */
@@ -67,9 +260,10 @@ typedef struct {
 	ion_fpos_t				start_of_data;
 	/**> This marks the eof position within the file, so that we can efficiently find it. */
 	ion_fpos_t				eof_position;
-	/**> This comes from the given dictionary size, and signifies how many
-		 records we want to buffer at a time. This is a trade-off between
-		 better performance and increased memory usage. */
+	/**> This comes from the given dictionary size, or from the device block
+		 size if none was given, and signifies how many records we want to
+		 buffer at a time. This is a trade-off between better performance and
+		 increased memory usage. */
 	ion_dictionary_size_t	num_buffered;
 	/**> Memory buffer capable of holding @p row_size number of rows. This is used
 		 for many purposes throughout the flat file. */
@@ -77,8 +271,15 @@ typedef struct {
 	/**> The file descriptor of the file this flat file instance operates on. */
 	FILE					*data_file;
 	/**> This value expresses the size of one row inside the @p data_file. A row is defined
-		 as a record + metadata. Change this if @ref ion_flat_file_row_t changes!*/
+		 as a record + metadata, or just a key + metadata when @ref ION_FLAT_FILE_SPLIT_VALUES
+		 is enabled. Change this if @ref ion_flat_file_row_t changes!*/
 	size_t					row_size;
+#if ION_FLAT_FILE_SPLIT_VALUES
+	/**> The file holding the value of every row, at the same index as its row. */
+	FILE		*value_file;
+	/**> Holds the value of the last row returned by a read or a scan. */
+	ion_byte_t	*value_buffer;
+#endif
 	/**> When a scan is performed, a region (defined as @p num_in_buffer number of records) is loaded into
 		 memory. We can utilize this fact to do efficient cached reads as long as the buffer is intact.
 		 This is expressed as an index that points to the first record in the region. @p num_in_buffer-1 would
@@ -86,6 +287,69 @@ typedef struct {
 	ion_fpos_t	current_loaded_region;
 	/**> Expresses how many valid records are currently in the buffer. */
 	size_t		num_in_buffer;
+	/**> How many rows this session has marked as deleted in sorted mode and not yet
+		 compacted away. Tombstones left by an earlier session are not counted. */
+	ion_fpos_t	num_tombstones;
+	/**> Points at the first row of the loaded region. This is @p buffer, or a
+		 place within @p map when rows are read through the mapping. */
+	ion_byte_t	*block;
+#if ION_FLAT_FILE_USE_MMAP
+	/**> Read-only mapping of the start of @p data_file, or @p NULL if rows are
+		 read into @p buffer instead. */
+	ion_byte_t		*map;
+	/**> How many bytes of @p data_file @p map covers. */
+	size_t			map_size;
+	/**> Set when rows were written through @p data_file since it was last flushed,
+		 so the mapping may not show them yet. */
+	ion_boolean_t	map_dirty;
+#endif
+#if ION_FLAT_FILE_USE_FENCES
+	/**> The first key of every @p num_buffered rows, in row order. This is @p NULL
+		 until the first sorted mode search builds it. */
+	ion_byte_t	*fence_keys;
+	/**> How many blocks @p fence_keys currently holds the first key of. */
+	ion_fpos_t	num_fences;
+	/**> How many keys @p fence_keys has room for. */
+	ion_fpos_t	fence_capacity;
+#endif
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+	/**> The segments of the learned model in key order, the last still being fit. This
+		 is @p NULL until the first sorted mode search builds it. */
+	ion_flat_file_segment_t *segments;
+	/**> How many of @p segments are in use. */
+	ion_fpos_t				num_segments;
+	/**> How many segments @p segments has room for. */
+	ion_fpos_t				segment_capacity;
+	/**> How many rows, from the first, the model describes, or -1 once it has been
+		 dropped until rows next move. */
+	ion_fpos_t				learned_rows;
+	/**> The least slope the last segment may still take. */
+	double					slope_low;
+	/**> The greatest slope the last segment may still take. */
+	double					slope_high;
+	/**> The greatest key the model describes. */
+	double					learned_key;
+	/**> The row index of the first row holding @p learned_key. */
+	ion_fpos_t				learned_key_row;
+#endif
+#if ION_FLAT_FILE_USE_BLOOM
+	/**> Bloom filter over the key of every row written since it was last rebuilt,
+		 or @p NULL if it could not be allocated. */
+	ion_byte_t		*bloom;
+	/**> Set once @p bloom covers every row before the EOF position. Until then, it is
+		 rebuilt from the rows by the first lookup that needs it. */
+	ion_boolean_t	bloom_ready;
+#endif
+#if ION_FLAT_FILE_USE_INDEX
+	/**> Open addressed table of one entry per row, or @p NULL if it is not built. */
+	ion_flat_file_index_entry_t *index;
+	/**> How many entries @p index has room for. This is always a power of two. */
+	ion_fpos_t					index_capacity;
+	/**> How many entries of @p index are in use. */
+	ion_fpos_t					index_count;
+	/**> Set once @p index holds an entry for every row before the EOF position. */
+	ion_boolean_t				index_ready;
+#endif
 } ion_flat_file_t;
 
 /**
@@ -109,14 +373,61 @@ typedef ion_boolean_t (*ion_flat_file_predicate_t)(
 	va_list *args
 );
 
+/**
+@brief		The row tests understood by @ref flat_file_scan_match.
+*/
+typedef enum {
+	/**> Matches any row that is occupied. */
+	ION_FLAT_FILE_MATCH_NOT_EMPTY,
+	/**> Matches occupied rows whose key equals @p lower_bound. */
+	ION_FLAT_FILE_MATCH_KEY,
+	/**> Matches occupied rows such that `lower_bound <= key <= upper_bound`. */
+	ION_FLAT_FILE_MATCH_WITHIN_BOUNDS,
+	/**> Matches occupied rows that pass @p filter. */
+	ION_FLAT_FILE_MATCH_FILTER
+} ion_flat_file_match_type_t;
+
+/**
+@brief		Describes the rows a @ref flat_file_scan_match is looking for.
+@details	Unlike a @ref ion_flat_file_predicate_t, the scan can see what a
+			match describes, and so tests a whole loaded block of rows in one
+			tight loop instead of calling out for every row.
+*/
+typedef struct {
+	/**> Which test to apply to each row. */
+	ion_flat_file_match_type_t	type;
+	/**> The target key, or the lower bound of a range. Unused when matching non-empty rows. */
+	ion_key_t					lower_bound;
+	/**> The upper bound of a range. Only used when matching within bounds. */
+	ion_key_t					upper_bound;
+	/**> The test of each row's key and value. Only used when matching a filter. */
+	ion_predicate_filter_t		filter;
+	/**> Passed to @p filter. */
+	void						*context;
+} ion_flat_file_match_t;
+
+/**
+@brief		The rows of a sorted flat file whose keys lie within a range, as
+			found by @ref flat_file_find_span.
+*/
+typedef struct {
+	/**> The row index of the next row to read. */
+	ion_fpos_t	next;
+	/**> The row index just past the last row of the range. */
+	ion_fpos_t	end;
+} ion_flat_file_span_t;
+
 /**
 @brief		Implementation cursor type for the flat file store cursor.
 */
 typedef struct {
 	/**> Supertype of the dictionary cursor. */
-	ion_dict_cursor_t	super;
+	ion_dict_cursor_t		super;
 	/**> Holds the index of the current location in our search. */
-	ion_fpos_t			current_location;
+	ion_fpos_t				current_location;
+	/**> The rows left to a range cursor of a sorted flat file, which reads
+		 them with @ref flat_file_read_span instead of scanning. */
+	ion_flat_file_span_t	span;
 } ion_flat_file_cursor_t;
 
 #if defined(__cplusplus)
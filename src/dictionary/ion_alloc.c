@@ -0,0 +1,771 @@
+/******************************************************************************/
+/**
+@file
+@brief		Allocations of the engines, counted by what they are for and by
+			the dictionary they were made for.
+*/
+/******************************************************************************/
+
+#include "ion_alloc.h"
+
+/**
+@brief		Takes and gives up the lock on the counters, so engines may
+			allocate from several threads, and makes the account being
+			charged one of each thread's own.
+*/
+#if defined(ARDUINO)
+#define ION_ALLOC_LOCK()
+#define ION_ALLOC_UNLOCK()
+#define ION_ALLOC_THREAD_LOCAL
+#else
+#include <pthread.h>
+
+/**
+@brief		Guards the accounts.
+*/
+static pthread_mutex_t ion_alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define ION_ALLOC_LOCK()	pthread_mutex_lock(&ion_alloc_lock)
+#define ION_ALLOC_UNLOCK()	pthread_mutex_unlock(&ion_alloc_lock)
+#define ION_ALLOC_THREAD_LOCAL __thread
+#endif
+
+/**
+@brief		An account and the dictionary it is for.
+*/
+typedef struct {
+	ion_alloc_usage_t		usage;		/**< What is charged to it. */
+	unsigned int			owner;		/**< The id of the dictionary. */
+	unsigned int			opened;		/**< Openings not yet closed. */
+	ion_boolean_t			used;		/**< Whether it was ever opened. */
+	ion_boolean_t			bound;		/**< Whether its allocator was
+											 bound to it. */
+	const ion_allocator_t	*allocator;	/**< Its blocks come from, or
+											 @c NULL for @c malloc. */
+} ion_alloc_account_state_t;
+
+/**
+@brief		The accounts, the first unattributed.
+*/
+static ion_alloc_account_state_t ion_alloc_accounts[ION_ALLOC_ACCOUNTS];
+
+/**
+@brief		Every account together.
+*/
+static ion_alloc_usage_t ion_alloc_total;
+
+/**
+@brief		The allocator of accounts not bound to one.
+*/
+static const ion_allocator_t *ion_alloc_default;
+
+/**
+@brief		The account charged now.
+*/
+static ION_ALLOC_THREAD_LOCAL ion_alloc_account_t ion_alloc_current = ion_alloc_unattributed;
+
+/**
+@brief		Whether an account is one that can be charged.
+*/
+static ion_boolean_t
+ion_alloc_valid(
+	ion_alloc_account_t account
+) {
+	return (account < ION_ALLOC_ACCOUNTS) && ((ion_alloc_unattributed == account) || ion_alloc_accounts[account].used);
+}
+
+/**
+@brief		Resets the peaks of a usage to what it has now.
+*/
+static void
+ion_alloc_reset_usage_peak(
+	ion_alloc_usage_t *usage
+) {
+	int kind;
+
+	for (kind = 0; kind < ion_alloc_kind_count; kind++) {
+		usage->kinds[kind].peak = usage->kinds[kind].current;
+	}
+
+	usage->total.peak = usage->total.current;
+}
+
+#if ION_ALLOC_TRACKING
+
+/**
+@brief		Adds to the bytes of a kind in a usage, or takes from them if
+			@p grow is false, keeping up its peaks.
+*/
+static void
+ion_alloc_count(
+	ion_alloc_usage_t	*usage,
+	ion_alloc_kind_t	kind,
+	size_t				bytes,
+	ion_boolean_t		grow,
+	ion_boolean_t		allocation
+) {
+	ion_alloc_counter_t *counter = &usage->kinds[kind];
+
+	if (grow) {
+		counter->current		+= bytes;
+		usage->total.current	+= bytes;
+	}
+	else {
+		counter->current		-= bytes;
+		usage->total.current	-= bytes;
+	}
+
+	if (allocation) {
+		counter->allocations++;
+		usage->total.allocations++;
+	}
+
+	if (counter->current > counter->peak) {
+		counter->peak = counter->current;
+	}
+
+	if (usage->total.current > usage->total.peak) {
+		usage->total.peak = usage->total.current;
+	}
+}
+
+/**
+@brief		What a counted block starts with, padded to keep the block
+			after it aligned.
+*/
+typedef union {
+	struct {
+		size_t				size;	/**< The bytes after the header. */
+		ion_alloc_account_t account;/**< Charged with them. */
+		uint8_t				kind;	/**< As @ref ion_alloc_kind_t. */
+	} info;
+	void		*align_pointer;
+	long		align_long;
+	long double align_double;
+} ion_alloc_header_t;
+
+/**
+@brief		Charges, or discharges if @p grow is false, the bytes of a block
+			to its account and to the total.
+*/
+static void
+ion_alloc_charge(
+	ion_alloc_header_t	*header,
+	size_t				bytes,
+	ion_boolean_t		grow,
+	ion_boolean_t		allocation
+) {
+	ION_ALLOC_LOCK();
+	ion_alloc_count(&ion_alloc_accounts[header->info.account].usage, (ion_alloc_kind_t) header->info.kind, bytes, grow, allocation);
+	ion_alloc_count(&ion_alloc_total, (ion_alloc_kind_t) header->info.kind, bytes, grow, allocation);
+	ION_ALLOC_UNLOCK();
+}
+
+/**
+@brief		The allocator of an account.
+*/
+static const ion_allocator_t *
+ion_alloc_allocator(
+	ion_alloc_account_t account
+) {
+	const ion_allocator_t *allocator;
+
+	ION_ALLOC_LOCK();
+	allocator = ion_alloc_accounts[account].allocator;
+	ION_ALLOC_UNLOCK();
+
+	return allocator;
+}
+
+void *
+ion_alloc(
+	ion_alloc_kind_t	kind,
+	size_t				size
+) {
+	ion_alloc_account_t		account		= ion_alloc_current;
+	const ion_allocator_t	*allocator	= ion_alloc_allocator(account);
+	ion_alloc_header_t		*header;
+
+	if (size > (size_t) -1 - sizeof(ion_alloc_header_t)) {
+		return NULL;
+	}
+
+	if (NULL == allocator) {
+		header = malloc(sizeof(ion_alloc_header_t) + size);
+	}
+	else {
+		header = allocator->allocate(allocator->context, sizeof(ion_alloc_header_t) + size);
+	}
+
+	if (NULL == header) {
+		return NULL;
+	}
+
+	header->info.size		= size;
+	header->info.account	= account;
+	header->info.kind		= (uint8_t) kind;
+	ion_alloc_charge(header, size, boolean_true, boolean_true);
+
+	return header + 1;
+}
+
+void *
+ion_calloc(
+	ion_alloc_kind_t	kind,
+	size_t				count,
+	size_t				size
+) {
+	void *block;
+
+	if ((0 != size) && (count > ((size_t) -1 - sizeof(ion_alloc_header_t)) / size)) {
+		return NULL;
+	}
+
+	if (NULL != (block = ion_alloc(kind, count * size))) {
+		memset(block, 0, count * size);
+	}
+
+	return block;
+}
+
+void *
+ion_realloc(
+	ion_alloc_kind_t	kind,
+	void				*block,
+	size_t				size
+) {
+	const ion_allocator_t	*allocator;
+	ion_alloc_header_t		*header;
+	ion_alloc_header_t		*moved;
+	size_t					old_size;
+
+	if (NULL == block) {
+		return ion_alloc(kind, size);
+	}
+
+	if (size > (size_t) -1 - sizeof(ion_alloc_header_t)) {
+		return NULL;
+	}
+
+	header		= (ion_alloc_header_t *) block - 1;
+	old_size	= header->info.size;
+	allocator	= ion_alloc_allocator(header->info.account);
+
+	if (NULL == allocator) {
+		moved = realloc(header, sizeof(ion_alloc_header_t) + size);
+	}
+	/* allocators have no resize, so the block moves */
+	else if (NULL != (moved = allocator->allocate(allocator->context, sizeof(ion_alloc_header_t) + size))) {
+		memcpy(moved, header, sizeof(ion_alloc_header_t) + ((size < old_size) ? size : old_size));
+		allocator->release(allocator->context, header, sizeof(ion_alloc_header_t) + old_size);
+	}
+
+	if (NULL == moved) {
+		return NULL;
+	}
+
+	header				= moved;
+	header->info.size	= size;
+
+	if (size >= old_size) {
+		ion_alloc_charge(header, size - old_size, boolean_true, boolean_true);
+	}
+	else {
+		ion_alloc_charge(header, old_size - size, boolean_false, boolean_true);
+	}
+
+	return header + 1;
+}
+
+void
+ion_free(
+	void *block
+) {
+	const ion_allocator_t	*allocator;
+	ion_alloc_header_t		*header;
+	size_t					size;
+
+	if (NULL == block) {
+		return;
+	}
+
+	header		= (ion_alloc_header_t *) block - 1;
+	size		= header->info.size;
+	allocator	= ion_alloc_allocator(header->info.account);
+	ion_alloc_charge(header, size, boolean_false, boolean_false);
+
+	if (NULL == allocator) {
+		free(header);
+	}
+	else {
+		allocator->release(allocator->context, header, sizeof(ion_alloc_header_t) + size);
+	}
+}
+
+#endif
+
+/**
+@brief		Finds the account of a dictionary, the one it had, else one
+			never used, else one closed, empty and not bound, made ready
+			for it. The lock must be held.
+*/
+static ion_alloc_account_t
+ion_alloc_find(
+	unsigned int owner
+) {
+	ion_alloc_account_state_t	*state;
+	ion_alloc_account_t			account;
+	ion_alloc_account_t			found = ion_alloc_unattributed;
+
+	for (account = 1; (account < ION_ALLOC_ACCOUNTS) && (ion_alloc_unattributed == found); account++) {
+		if (ion_alloc_accounts[account].used && (owner == ion_alloc_accounts[account].owner)) {
+			found = account;
+		}
+	}
+
+	for (account = 1; (account < ION_ALLOC_ACCOUNTS) && (ion_alloc_unattributed == found); account++) {
+		if (!ion_alloc_accounts[account].used) {
+			found = account;
+		}
+	}
+
+	for (account = 1; (account < ION_ALLOC_ACCOUNTS) && (ion_alloc_unattributed == found); account++) {
+		state = &ion_alloc_accounts[account];
+
+		if ((0 == state->opened) && !state->bound && (0 == state->usage.total.current)) {
+			found = account;
+		}
+	}
+
+	if (ion_alloc_unattributed == found) {
+		return found;
+	}
+
+	state = &ion_alloc_accounts[found];
+
+	if (!state->used || (owner != state->owner)) {
+		memset(state, 0, sizeof(*state));
+		state->used		= boolean_true;
+		state->owner	= owner;
+	}
+
+	/* the allocator changes only while nothing is held of it */
+	if (!state->bound && (0 == state->usage.total.current)) {
+		state->allocator = ion_alloc_default;
+	}
+
+	return found;
+}
+
+ion_alloc_account_t
+ion_alloc_open_account(
+	unsigned int owner
+) {
+	ion_alloc_account_t found;
+
+	ION_ALLOC_LOCK();
+
+	if (ion_alloc_unattributed != (found = ion_alloc_find(owner))) {
+		ion_alloc_accounts[found].opened++;
+	}
+
+	ION_ALLOC_UNLOCK();
+
+	return found;
+}
+
+ion_err_t
+ion_alloc_bind(
+	unsigned int			owner,
+	const ion_allocator_t	*allocator
+) {
+#if ION_ALLOC_TRACKING
+	ion_alloc_account_state_t	*state;
+	ion_alloc_account_t			found;
+	ion_err_t					err = err_ok;
+
+	ION_ALLOC_LOCK();
+
+	if (ion_alloc_unattributed == (found = ion_alloc_find(owner))) {
+		err = err_max_capacity;
+	}
+	else {
+		state = &ion_alloc_accounts[found];
+
+		if (NULL == allocator) {
+			allocator = ion_alloc_default;
+		}
+
+		if ((allocator != state->allocator) && (0 != state->usage.total.current)) {
+			err = err_illegal_state;
+		}
+		else {
+			state->allocator	= allocator;
+			state->bound		= allocator != ion_alloc_default;
+		}
+	}
+
+	ION_ALLOC_UNLOCK();
+
+	return err;
+#else
+	UNUSED(owner);
+	UNUSED(allocator);
+	return err_not_implemented;
+#endif
+}
+
+ion_err_t
+ion_alloc_set_default(
+	const ion_allocator_t *allocator
+) {
+#if ION_ALLOC_TRACKING
+	ion_alloc_account_state_t	*state	= &ion_alloc_accounts[ion_alloc_unattributed];
+	ion_err_t					err		= err_ok;
+
+	ION_ALLOC_LOCK();
+
+	if ((allocator != state->allocator) && (0 != state->usage.total.current)) {
+		err = err_illegal_state;
+	}
+	else {
+		ion_alloc_default	= allocator;
+		state->allocator	= allocator;
+	}
+
+	ION_ALLOC_UNLOCK();
+
+	return err;
+#else
+	UNUSED(allocator);
+	return err_not_implemented;
+#endif
+}
+
+void
+ion_alloc_close_account(
+	ion_alloc_account_t account
+) {
+	if ((ion_alloc_unattributed == account) || !ion_alloc_valid(account)) {
+		return;
+	}
+
+	ION_ALLOC_LOCK();
+
+	if (0 < ion_alloc_accounts[account].opened) {
+		ion_alloc_accounts[account].opened--;
+	}
+
+	ION_ALLOC_UNLOCK();
+}
+
+ion_alloc_account_t
+ion_alloc_enter(
+	ion_alloc_account_t account
+) {
+	ion_alloc_account_t previous = ion_alloc_current;
+
+	ion_alloc_current = ion_alloc_valid(account) ? account : ion_alloc_unattributed;
+
+	return previous;
+}
+
+void
+ion_alloc_leave(
+	ion_alloc_account_t previous
+) {
+	ion_alloc_current = previous;
+}
+
+ion_err_t
+ion_alloc_get_usage(
+	ion_alloc_account_t account,
+	ion_alloc_usage_t	*usage
+) {
+	memset(usage, 0, sizeof(*usage));
+
+	if ((ion_alloc_all != account) && !ion_alloc_valid(account)) {
+		return err_illegal_state;
+	}
+
+#if ION_ALLOC_TRACKING
+	ION_ALLOC_LOCK();
+	*usage = (ion_alloc_all == account) ? ion_alloc_total : ion_alloc_accounts[account].usage;
+	ION_ALLOC_UNLOCK();
+
+	return err_ok;
+#else
+	return err_not_implemented;
+#endif
+}
+
+void
+ion_alloc_reset_peak(
+	ion_alloc_account_t account
+) {
+	ion_alloc_account_t each;
+
+	ION_ALLOC_LOCK();
+
+	if (ion_alloc_all == account) {
+		ion_alloc_reset_usage_peak(&ion_alloc_total);
+
+		for (each = 0; each < ION_ALLOC_ACCOUNTS; each++) {
+			ion_alloc_reset_usage_peak(&ion_alloc_accounts[each].usage);
+		}
+	}
+	else if (ion_alloc_valid(account)) {
+		ion_alloc_reset_usage_peak(&ion_alloc_accounts[account].usage);
+	}
+
+	ION_ALLOC_UNLOCK();
+}
+
+/**
+@brief		The unit pools and arenas give out memory in, large enough for
+			a free region and aligned for any type.
+*/
+typedef union {
+	ion_pool_region_t	region;
+	void				*align_pointer;
+	long				align_long;
+	long double			align_double;
+} ion_alloc_unit_t;
+
+#define ION_ALLOC_UNIT sizeof(ion_alloc_unit_t)
+
+/**
+@brief		Rounds bytes up to whole units, one at least.
+*/
+static size_t
+ion_alloc_round(
+	size_t size
+) {
+	return (0 == size) ? ION_ALLOC_UNIT : (size + ION_ALLOC_UNIT - 1) / ION_ALLOC_UNIT * ION_ALLOC_UNIT;
+}
+
+/**
+@brief		Gives a block of a pool, cut from the top of the first free
+			region large enough.
+*/
+static void *
+ion_pool_allocate(
+	void	*context,
+	size_t	size
+) {
+	ion_pool_t			*pool = context;
+	ion_pool_region_t	**link;
+	ion_pool_region_t	*region;
+
+	if (size > pool->available) {
+		return NULL;
+	}
+
+	size = ion_alloc_round(size);
+
+	for (link = &pool->free; NULL != (region = *link); link = &region->next) {
+		if (region->size >= size) {
+			pool->available -= size;
+
+			if (region->size == size) {
+				*link = region->next;
+				return region;
+			}
+
+			region->size -= size;
+			return (ion_byte_t *) region + region->size;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Takes back a block of a pool, merging it with the free regions
+			either side of it.
+*/
+static void
+ion_pool_release(
+	void	*context,
+	void	*block,
+	size_t	size
+) {
+	ion_pool_t			*pool	= context;
+	ion_pool_region_t	*freed	= block;
+	ion_pool_region_t	*before = NULL;
+	ion_pool_region_t	*after	= pool->free;
+
+	size			= ion_alloc_round(size);
+	pool->available += size;
+
+	while ((NULL != after) && ((ion_byte_t *) after < (ion_byte_t *) freed)) {
+		before	= after;
+		after	= after->next;
+	}
+
+	freed->size = size;
+	freed->next = after;
+
+	if ((NULL != after) && ((ion_byte_t *) freed + freed->size == (ion_byte_t *) after)) {
+		freed->size += after->size;
+		freed->next = after->next;
+	}
+
+	if (NULL == before) {
+		pool->free = freed;
+	}
+	else if ((ion_byte_t *) before + before->size == (ion_byte_t *) freed) {
+		before->size	+= freed->size;
+		before->next	= freed->next;
+	}
+	else {
+		before->next = freed;
+	}
+}
+
+ion_err_t
+ion_pool_init(
+	ion_pool_t		*pool,
+	void			*memory,
+	size_t			size,
+	ion_allocator_t *allocator
+) {
+	size_t skip = (ION_ALLOC_UNIT - (size_t) ((uintptr_t) memory % ION_ALLOC_UNIT)) % ION_ALLOC_UNIT;
+
+	memset(pool, 0, sizeof(*pool));
+
+	if (size < skip + ION_ALLOC_UNIT) {
+		return err_invalid_initial_size;
+	}
+
+	pool->size			= (size - skip) / ION_ALLOC_UNIT * ION_ALLOC_UNIT;
+	pool->available		= pool->size;
+	pool->free			= (ion_pool_region_t *) ((ion_byte_t *) memory + skip);
+	pool->free->size	= pool->size;
+	pool->free->next	= NULL;
+
+	allocator->allocate = ion_pool_allocate;
+	allocator->release	= ion_pool_release;
+	allocator->context	= pool;
+
+	return err_ok;
+}
+
+/**
+@brief		The smallest size an arena keeps, and so the step between them.
+*/
+#define ION_ARENA_SMALLEST 16
+
+#if ION_ARENA_CHUNK_SIZE < 2 * (ION_ARENA_SMALLEST << (ION_ARENA_CLASSES - 1))
+#error "ION_ARENA_CHUNK_SIZE must hold two blocks of the largest arena size"
+#endif
+
+/**
+@brief		Which size of an arena a block is, or @ref ION_ARENA_CLASSES if
+			it is larger than every size.
+*/
+static int
+ion_arena_class(
+	size_t size
+) {
+	int class_index = 0;
+
+	while ((class_index < ION_ARENA_CLASSES) && (((size_t) ION_ARENA_SMALLEST << class_index) < size)) {
+		class_index++;
+	}
+
+	return class_index;
+}
+
+/**
+@brief		Gives a block of an arena: a freed one of its size, else one
+			cut from the newest chunk, which is replaced when too full.
+*/
+static void *
+ion_arena_allocate(
+	void	*context,
+	size_t	size
+) {
+	ion_arena_t *arena			= context;
+	int			class_index		= ion_arena_class(size);
+	size_t		class_bytes		= (size_t) ION_ARENA_SMALLEST << class_index;
+	void		*block;
+	void		**chunk;
+
+	if (ION_ARENA_CLASSES == class_index) {
+		return malloc(size);
+	}
+
+	if (NULL != (block = arena->free[class_index])) {
+		arena->free[class_index] = *(void **) block;
+		return block;
+	}
+
+	if (arena->left < class_bytes) {
+		if (NULL == (chunk = malloc(arena->chunk_bytes))) {
+			return NULL;
+		}
+
+		/* what is left of the chunk before is abandoned until destroy */
+		*chunk			= arena->chunks;
+		arena->chunks	= chunk;
+		arena->next		= (ion_byte_t *) chunk + ION_ALLOC_UNIT;
+		arena->left		= arena->chunk_bytes - ION_ALLOC_UNIT;
+	}
+
+	block			= arena->next;
+	arena->next		+= class_bytes;
+	arena->left		-= class_bytes;
+
+	return block;
+}
+
+/**
+@brief		Takes back a block of an arena, kept for the next of its size.
+*/
+static void
+ion_arena_release(
+	void	*context,
+	void	*block,
+	size_t	size
+) {
+	ion_arena_t *arena			= context;
+	int			class_index		= ion_arena_class(size);
+
+	if (ION_ARENA_CLASSES == class_index) {
+		free(block);
+		return;
+	}
+
+	*(void **) block			= arena->free[class_index];
+	arena->free[class_index]	= block;
+}
+
+void
+ion_arena_init(
+	ion_arena_t		*arena,
+	ion_allocator_t *allocator
+) {
+	memset(arena, 0, sizeof(*arena));
+	arena->chunk_bytes	= ION_ARENA_CHUNK_SIZE;
+
+	allocator->allocate = ion_arena_allocate;
+	allocator->release	= ion_arena_release;
+	allocator->context	= arena;
+}
+
+void
+ion_arena_destroy(
+	ion_arena_t *arena
+) {
+	void *chunk;
+
+	while (NULL != (chunk = arena->chunks)) {
+		arena->chunks = *(void **) chunk;
+		free(chunk);
+	}
+
+	memset(arena->free, 0, sizeof(arena->free));
+	arena->next = NULL;
+	arena->left = 0;
+}
@@ -0,0 +1,396 @@
+/******************************************************************************/
+/**
+@file
+@brief		Allocations of the engines, counted by what they are for and by
+			the dictionary they were made for.
+@details	Engines allocate through @ref ion_alloc, @ref ion_calloc and
+			@ref ion_realloc, naming the kind of memory, and free through
+			@ref ion_free. Each block carries a small header with its size,
+			its kind and its account, so it is counted off where it was
+			counted on whoever frees it. The dictionary interface opens an
+			account for each dictionary and enters it for the length of
+			every operation, so the blocks an engine allocates are charged
+			to the dictionary it works for. Blocks allocated outside any
+			operation, such as by a cursor's @c next called directly, are
+			charged to @ref ion_alloc_unattributed.
+
+			Every engine and the dictionary interface allocate this way,
+			cursors and the predicates they copy included, so a block one
+			part allocates another can free. The file layer's cache, IINQ
+			and the C++ wrapper keep to @c malloc for memory of their own,
+			which is never given to an engine to free, and is not counted.
+
+			Each account takes its blocks from an @ref ion_allocator_t,
+			@c malloc unless one is bound to the dictionary with
+			@ref ion_alloc_bind or set for all with @ref ion_alloc_set_default.
+			Two are provided: a pool carved from a static array, for builds
+			with no heap, and an arena that cuts chunks into slabs of a few
+			sizes and reuses freed blocks by size.
+
+			With @ref ION_ALLOC_TRACKING 0 the calls are @c malloc and its
+			kin, nothing is counted and no allocator can be set.
+*/
+/******************************************************************************/
+
+#if !defined(ION_ALLOC_H_)
+#define ION_ALLOC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../key_value/kv_system.h"
+
+/**
+@brief		Whether allocations are counted. Each block then costs a header
+			of a @c size_t and two bytes, rounded up to the alignment of
+			the target.
+*/
+#if !defined(ION_ALLOC_TRACKING)
+#define ION_ALLOC_TRACKING 1
+#endif
+
+/**
+@brief		The accounts kept, @ref ion_alloc_unattributed among them.
+			Dictionaries opened past the last are unattributed.
+*/
+#if !defined(ION_ALLOC_ACCOUNTS)
+#if defined(ARDUINO)
+#define ION_ALLOC_ACCOUNTS 4
+#else
+#define ION_ALLOC_ACCOUNTS 16
+#endif
+#endif
+
+/**
+@brief		What a block of memory is for.
+*/
+typedef enum ION_ALLOC_KIND {
+	ion_alloc_buffer,	/**< Pages, buffer pools, staging and scratch. */
+	ion_alloc_node,		/**< Nodes, buckets and tables holding records. */
+	ion_alloc_cursor,	/**< Cursors and what they read through. */
+	ion_alloc_other,	/**< The state of an engine itself. */
+	ion_alloc_kind_count/**< The number of kinds. */
+} ion_alloc_kind_t;
+
+/**
+@brief		An account blocks are charged to, an index into the accounts.
+*/
+typedef uint8_t ion_alloc_account_t;
+
+/**
+@brief		The account of blocks allocated outside any dictionary's
+			operations, or for a dictionary that found no account free.
+*/
+#define ion_alloc_unattributed	((ion_alloc_account_t) 0)
+
+/**
+@brief		Names every account at once to @ref ion_alloc_get_usage and
+			@ref ion_alloc_reset_peak.
+*/
+#define ion_alloc_all			((ion_alloc_account_t) 0xFF)
+
+/**
+@brief		Bytes of one kind of memory, headers not included.
+*/
+typedef struct {
+	size_t			current;		/**< Allocated now. */
+	size_t			peak;			/**< The most allocated at once since
+									 the account opened or its peak was
+									 reset. */
+	unsigned long	allocations;	/**< Blocks allocated or reallocated. */
+} ion_alloc_counter_t;
+
+/**
+@brief		Bytes of an account, by kind and in all.
+*/
+typedef struct {
+	ion_alloc_counter_t kinds[ion_alloc_kind_count];/**< By @ref ion_alloc_kind_t. */
+	ion_alloc_counter_t total;						/**< Of every kind together,
+														 its peak the most at
+														 once. */
+} ion_alloc_usage_t;
+
+/**
+@brief		Where an account takes its blocks from.
+@details	A block is given back with the size it was asked for with, so
+			an allocator need not keep sizes of its own. Blocks must be
+			aligned for any type. Allocators are called without a lock, so
+			one shared by dictionaries used in several threads must lock
+			itself.
+*/
+typedef struct {
+	void *(*allocate)(
+		void *,
+		size_t
+	);				/**< Gives a block of a size, or @c NULL. */
+	void (*release)(
+		void *,
+		void *,
+		size_t
+	);				/**< Takes back a block and its size. */
+	void *context;	/**< Given to both, such as a pool. */
+} ion_allocator_t;
+
+/**
+@brief		A region of free memory in a pool.
+*/
+typedef struct ION_POOL_REGION {
+	size_t					size;	/**< Its bytes, this header included. */
+	struct ION_POOL_REGION	*next;	/**< The next free, higher up. */
+} ion_pool_region_t;
+
+/**
+@brief		A pool of memory given once, such as a static array, handed
+			out first fit and merged back as blocks are freed.
+*/
+typedef struct {
+	ion_pool_region_t	*free;		/**< Free regions, lowest first. */
+	size_t				size;		/**< Its bytes, once aligned. */
+	size_t				available;	/**< Bytes free, in every region. */
+} ion_pool_t;
+
+/**
+@brief		The number of block sizes an arena keeps freed blocks of: 16
+			bytes and each power of two up from it.
+*/
+#if !defined(ION_ARENA_CLASSES)
+#if defined(ARDUINO)
+#define ION_ARENA_CLASSES 5
+#else
+#define ION_ARENA_CLASSES 9
+#endif
+#endif
+
+/**
+@brief		The bytes an arena asks @c malloc for at a time.
+*/
+#if !defined(ION_ARENA_CHUNK_SIZE)
+#if defined(ARDUINO)
+#define ION_ARENA_CHUNK_SIZE 512
+#else
+#define ION_ARENA_CHUNK_SIZE 65536
+#endif
+#endif
+
+/**
+@brief		An arena: chunks from @c malloc cut into blocks of a few sizes,
+			freed blocks kept for the next of their size, and every chunk
+			given back at once when it is destroyed. Blocks larger than
+			the largest size are @c malloc and @c free of their own.
+*/
+typedef struct {
+	void		*chunks;					/**< The chunks, newest first. */
+	ion_byte_t	*next;						/**< Where the newest is cut
+												 next. */
+	size_t		left;						/**< Bytes left to cut in it. */
+	void		*free[ION_ARENA_CLASSES];	/**< Freed blocks by size. */
+	size_t		chunk_bytes;				/**< Bytes of every chunk. */
+} ion_arena_t;
+
+/**
+@brief		Makes a pool of a region of memory.
+@param		pool
+				The pool.
+@param		memory
+				Its memory, which must last as long as it is used.
+@param		size
+				The bytes of @p memory.
+@param		allocator
+				Set to give out its blocks.
+@return		@c err_ok, or @c err_invalid_initial_size if the memory is
+			too small to give out anything.
+*/
+ion_err_t
+ion_pool_init(
+	ion_pool_t		*pool,
+	void			*memory,
+	size_t			size,
+	ion_allocator_t *allocator
+);
+
+/**
+@brief		Makes an empty arena.
+@param		arena
+				The arena.
+@param		allocator
+				Set to give out its blocks.
+*/
+void
+ion_arena_init(
+	ion_arena_t		*arena,
+	ion_allocator_t *allocator
+);
+
+/**
+@brief		Gives back every chunk of an arena, so every block cut from it
+			is freed, leaving it empty to be used again.
+*/
+void
+ion_arena_destroy(
+	ion_arena_t *arena
+);
+
+#if ION_ALLOC_TRACKING
+
+/**
+@brief		Allocates a counted block.
+@param		kind
+				What it is for.
+@param		size
+				Its bytes.
+@return		The block, or @c NULL if there is no memory for it.
+*/
+void *
+ion_alloc(
+	ion_alloc_kind_t	kind,
+	size_t				size
+);
+
+/**
+@brief		Allocates a counted block of zeros, as @c calloc does.
+*/
+void *
+ion_calloc(
+	ion_alloc_kind_t	kind,
+	size_t				count,
+	size_t				size
+);
+
+/**
+@brief		Resizes a counted block, as @c realloc does. A @c NULL block
+			is allocated as @p kind, and others keep their kind and account.
+*/
+void *
+ion_realloc(
+	ion_alloc_kind_t	kind,
+	void				*block,
+	size_t				size
+);
+
+/**
+@brief		Frees a counted block, or does nothing for @c NULL.
+*/
+void
+ion_free(
+	void *block
+);
+
+#else
+
+#define ion_alloc(kind, size)			malloc(size)
+#define ion_calloc(kind, count, size)	calloc((count), (size))
+#define ion_realloc(kind, block, size)	realloc((block), (size))
+#define ion_free(block)					free(block)
+
+#endif
+
+/**
+@brief		Opens the account of a dictionary, the one it already had if
+			it was opened before and not reused since.
+@param		owner
+				The dictionary id.
+@return		The account, or @ref ion_alloc_unattributed if none is free.
+*/
+ion_alloc_account_t
+ion_alloc_open_account(
+	unsigned int owner
+);
+
+/**
+@brief		Takes the blocks of a dictionary from an allocator, from before
+			it is created or opened until bound to another.
+@details	The dictionary keeps its account while bound, even closed and
+			empty. Binding it to @c NULL goes back to the default.
+@param		owner
+				The dictionary id.
+@param		allocator
+				The allocator, which must last as long as its blocks, or
+				@c NULL.
+@return		@c err_ok, @c err_max_capacity if no account is free for it,
+			@c err_illegal_state if it still holds blocks of another
+			allocator, or @c err_not_implemented if
+			@ref ION_ALLOC_TRACKING is 0.
+*/
+ion_err_t
+ion_alloc_bind(
+	unsigned int			owner,
+	const ion_allocator_t	*allocator
+);
+
+/**
+@brief		Sets the allocator of the accounts opened from now on that are
+			not bound to one, and of @ref ion_alloc_unattributed.
+@param		allocator
+				The allocator, or @c NULL for @c malloc.
+@return		@c err_ok, @c err_illegal_state if unattributed blocks of
+			another allocator are still held, or @c err_not_implemented
+			if @ref ION_ALLOC_TRACKING is 0.
+*/
+ion_err_t
+ion_alloc_set_default(
+	const ion_allocator_t *allocator
+);
+
+/**
+@brief		Closes an account opened with @ref ion_alloc_open_account. Its
+			counters are kept, and it is not reused for another dictionary,
+			until every opening is closed and its blocks are freed.
+*/
+void
+ion_alloc_close_account(
+	ion_alloc_account_t account
+);
+
+/**
+@brief		Charges the blocks allocated from now on to an account.
+@param		account
+				The account, which if not one opened counts as
+				@ref ion_alloc_unattributed.
+@return		The account charged until now, to give to
+			@ref ion_alloc_leave.
+*/
+ion_alloc_account_t
+ion_alloc_enter(
+	ion_alloc_account_t account
+);
+
+/**
+@brief		Goes back to charging the account @ref ion_alloc_enter replaced.
+*/
+void
+ion_alloc_leave(
+	ion_alloc_account_t previous
+);
+
+/**
+@brief		Reads the counters of an account.
+@param		account
+				The account, or @ref ion_alloc_all for every allocation.
+@param		usage
+				Receives the counters, all 0 if @ref ION_ALLOC_TRACKING is 0.
+@return		@c err_ok, @c err_illegal_state if @p account is not one, or
+			@c err_not_implemented if @ref ION_ALLOC_TRACKING is 0.
+*/
+ion_err_t
+ion_alloc_get_usage(
+	ion_alloc_account_t account,
+	ion_alloc_usage_t	*usage
+);
+
+/**
+@brief		Brings the peaks of an account down to what it has now, to
+			measure the peak of a phase.
+@param		account
+				The account, or @ref ion_alloc_all for every account.
+*/
+void
+ion_alloc_reset_peak(
+	ion_alloc_account_t account
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_ALLOC_H_ */
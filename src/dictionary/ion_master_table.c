@@ -21,262 +21,1538 @@
 */
 /******************************************************************************/
 
+/* fileno, ftruncate, mmap and msync are POSIX, not C99 */
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "ion_master_table.h"
+#include "../file/ion_file.h"
+
+#if ION_MASTER_TABLE_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-FILE				*ion_master_table_file		= NULL;
-ion_dictionary_id_t ion_master_table_next_id	= 1;
+ion_master_table_t ion_master_table_default = {
+	.file = NULL, .next_row = 1
+};
 
 #define ION_MASTER_TABLE_CALCULATE_POS	-1
 #define ION_MASTER_TABLE_WRITE_FROM_END -2
-#define ION_MASTER_TABLE_RECORD_SIZE(cp) (sizeof((cp)->id) + sizeof((cp)->use_type) + sizeof((cp)->type) + sizeof((cp)->key_size) + sizeof((cp)->value_size) + sizeof((cp)->dictionary_size))
+#define ION_MASTER_TABLE_RECORD_SIZE(cp) (sizeof((cp)->id) + sizeof((cp)->use_type) + sizeof((cp)->type) + sizeof((cp)->key_size) + sizeof((cp)->value_size) + sizeof((cp)->dictionary_size) + sizeof((cp)->page_size) + sizeof((cp)->hash_function) + sizeof((cp)->index_of) + sizeof((cp)->index_offset) + sizeof((cp)->index_size) + sizeof((cp)->options))
 
 /**
-@brief		Write a record to the master table.
-@details	Automatically, this call will reposition the file position
-			back to where it was once the call is complete.
-@param[in]	config
-				A pointer to a previously allocated config object to write from.
-@param[in]	where
-				An integral value representing where to write to in the file.
-				This file offset is byte-aligned, not record aligned, in general.
+@brief		The row of a table holding an ID, 0 for one it does not give
+			out.
+*/
+#define ION_MASTER_TABLE_ROW(table, id) (((id) > (table)->id_base) ? (id) - (table)->id_base : 0)
 
-				Two special flags can be passed in here:
-					- @c ION_MASTER_TABLE_CALCULATE_POS
-						Calculate the position based on the passed-in config id.
-					- @c ION_MASTER_TABLE_WRITE_FROM_END
-						Write the record at the end of the file.
-@returns	An error code describing the result of the call.
+#if ION_MASTER_TABLE_DIRECTORY
+
+/**
+@brief		Drops the directory, so the table is read from its file.
 */
-ion_err_t
-ion_master_table_write(
+static void
+ion_master_table_directory_clear(
+	ion_master_table_t *table
+) {
+	ion_free(table->directory.entries);
+	memset(&table->directory, 0, sizeof(table->directory));
+}
+
+/**
+@brief		Takes a record out of the directory and the list of its use.
+*/
+static void
+ion_master_table_directory_forget(
+	ion_master_table_directory_t	*directory,
+	ion_dictionary_id_t				row
+) {
+	ion_master_table_entry_t	*entry	= directory->entries + row;
+	ion_dict_use_t				use		= entry->config.use_type;
+
+	if (0 == entry->prev_of_use) {
+		directory->first_of_use[use] = entry->next_of_use;
+	}
+	else {
+		directory->entries[entry->prev_of_use].next_of_use = entry->next_of_use;
+	}
+
+	if (0 == entry->next_of_use) {
+		directory->last_of_use[use] = entry->prev_of_use;
+	}
+	else {
+		directory->entries[entry->next_of_use].prev_of_use = entry->prev_of_use;
+	}
+
+	memset(entry, 0, sizeof(ion_master_table_entry_t));
+}
+
+/**
+@brief		Puts a record written to the table into the directory, in ID
+			order in the list of its use.
+@param		table
+				The table written.
+@param		row
+				Where in the table it was written.
+@param		config
+				The record, its ID 0 if it was deleted.
+@returns	@c err_ok, or @c err_out_of_memory if the directory could not
+			grow, in which case it is dropped.
+*/
+static ion_err_t
+ion_master_table_directory_put(
+	ion_master_table_t				*table,
+	ion_dictionary_id_t				row,
+	ion_dictionary_config_info_t	*config
+) {
+	ion_master_table_directory_t	*directory	= &table->directory;
+	ion_master_table_entry_t		*entries;
+	ion_dictionary_id_t				capacity;
+	ion_dictionary_id_t				before;
+	ion_dict_use_t					use			= config->use_type;
+
+	if (row >= directory->capacity) {
+		for (capacity = (0 == directory->capacity) ? 16 : directory->capacity; capacity <= row; capacity *= 2) {}
+
+		entries = ion_realloc(ion_alloc_other, directory->entries, capacity * sizeof(ion_master_table_entry_t));
+
+		if (NULL == entries) {
+			ion_master_table_directory_clear(table);
+			return err_out_of_memory;
+		}
+
+		memset(entries + directory->capacity, 0, (capacity - directory->capacity) * sizeof(ion_master_table_entry_t));
+		directory->entries	= entries;
+		directory->capacity = capacity;
+	}
+
+	if (0 != directory->entries[row].config.id) {
+		ion_master_table_directory_forget(directory, row);
+	}
+
+	if (0 == config->id) {
+		return err_ok;
+	}
+
+	directory->entries[row].config = *config;
+
+	/* IDs are given out in order, so the record almost always goes last */
+	for (before = directory->last_of_use[use]; (0 != before) && (before > row); before = directory->entries[before].prev_of_use) {}
+
+	directory->entries[row].prev_of_use = before;
+
+	if (0 == before) {
+		directory->entries[row].next_of_use	= directory->first_of_use[use];
+		directory->first_of_use[use]		= row;
+	}
+	else {
+		directory->entries[row].next_of_use		= directory->entries[before].next_of_use;
+		directory->entries[before].next_of_use	= row;
+	}
+
+	if (0 == directory->entries[row].next_of_use) {
+		directory->last_of_use[use] = row;
+	}
+	else {
+		directory->entries[directory->entries[row].next_of_use].prev_of_use = row;
+	}
+
+	return err_ok;
+}
+
+#endif
+
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+
+/**
+@brief		A dictionary kept open by @ref ion_mt_open_dictionary.
+*/
+typedef struct ion_master_table_open {
+	ion_master_table_t				*table;		/**< The table it was opened from,
+												 @c NULL once that is closed */
+	ion_dictionary_id_t				id;			/**< Its ID */
+	ion_dictionary_t				dictionary;	/**< The dictionary, as opened */
+	ion_dictionary_handler_t		handler;	/**< Its handler */
+	ion_dictionary_handler_t		shared;		/**< The handler given out, closing
+												 and deleting through the cache */
+	int								pins;		/**< The openers yet to close it */
+	unsigned long					used;		/**< When it was last closed */
+	ion_boolean_t					forgotten;	/**< Whether it is given out no
+												 more, and closed once unpinned */
+	struct ion_master_table_open	*next;		/**< The next kept open */
+} ion_master_table_open_t;
+
+/**
+@brief		The dictionaries kept open, of every table, most recently opened
+			first.
+@details	Those given out close through a handler that names no table, so
+			they are found here by their instance.
+*/
+static ion_master_table_open_t	*ion_master_table_opens			= NULL;
+
+/**
+@brief		Ticks on every close, to find the least recently used.
+*/
+static unsigned long			ion_master_table_open_clock		= 0;
+
+/**
+@brief		Takes and gives up the lock on the dictionaries kept open, so
+			tables may be used from several threads, each by one of them.
+*/
+#if defined(ARDUINO)
+#define ION_MASTER_TABLE_LOCK()
+#define ION_MASTER_TABLE_UNLOCK()
+#else
+#include <pthread.h>
+
+/**
+@brief		Guards the dictionaries kept open.
+*/
+static pthread_mutex_t ion_master_table_open_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define ION_MASTER_TABLE_LOCK()		pthread_mutex_lock(&ion_master_table_open_lock)
+#define ION_MASTER_TABLE_UNLOCK()	pthread_mutex_unlock(&ion_master_table_open_lock)
+#endif
+
+/**
+@brief		Finds the dictionary kept open behind one given out.
+*/
+static ion_master_table_open_t *
+ion_master_table_open_find(
+	ion_dictionary_t *dictionary
+) {
+	ion_master_table_open_t *open;
+
+	for (open = ion_master_table_opens; NULL != open; open = open->next) {
+		if (open->dictionary.instance == dictionary->instance) {
+			return open;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Takes a dictionary out of those kept open.
+*/
+static void
+ion_master_table_open_unlink(
+	ion_master_table_open_t *open
+) {
+	ion_master_table_open_t **link;
+
+	for (link = &ion_master_table_opens; *link != open; link = &(*link)->next) {}
+
+	*link = open->next;
+}
+
+/**
+@brief		Closes a dictionary kept open for good.
+*/
+static ion_err_t
+ion_master_table_open_drop(
+	ion_master_table_open_t *open
+) {
+	ion_err_t error;
+
+	ion_master_table_open_unlink(open);
+	error = dictionary_close(&open->dictionary);
+	ion_free(open);
+
+	return error;
+}
+
+/**
+@brief		Closes for good the least recently used of those of a table no
+			one has open, until no more than the cache holds are left.
+*/
+static ion_err_t
+ion_master_table_open_trim(
+	ion_master_table_t *table
+) {
+	ion_master_table_open_t *open;
+	ion_master_table_open_t *oldest;
+	int						idle;
+	ion_err_t				error = err_ok;
+	ion_err_t				dropped;
+
+	do {
+		oldest	= NULL;
+		idle	= 0;
+
+		for (open = ion_master_table_opens; NULL != open; open = open->next) {
+			if ((table == open->table) && (0 == open->pins)) {
+				idle++;
+
+				if ((NULL == oldest) || (open->used < oldest->used)) {
+					oldest = open;
+				}
+			}
+		}
+
+		if (idle <= ION_MASTER_TABLE_OPEN_CACHE) {
+			break;
+		}
+
+		dropped = ion_master_table_open_drop(oldest);
+
+		if (err_ok == error) {
+			error = dropped;
+		}
+	} while (boolean_true);
+
+	return error;
+}
+
+/**
+@brief		Gives out no more a dictionary kept open, closing it if no one
+			has it open.
+*/
+static ion_err_t
+ion_master_table_open_forget(
+	ion_master_table_open_t *open
+) {
+	if (0 != open->pins) {
+		open->forgotten = boolean_true;
+		return err_ok;
+	}
+
+	return ion_master_table_open_drop(open);
+}
+
+/**
+@brief		Closes a dictionary given out, it being kept open for the next
+			to open it.
+*/
+static ion_err_t
+ion_master_table_open_release(
+	ion_dictionary_t *dictionary
+) {
+	ion_master_table_open_t *open;
+	ion_err_t				error = err_ok;
+
+	ION_MASTER_TABLE_LOCK();
+	open = ion_master_table_open_find(dictionary);
+
+	if (NULL == open) {
+		ION_MASTER_TABLE_UNLOCK();
+		return err_illegal_state;
+	}
+
+	open->pins--;
+	open->used				= ++ion_master_table_open_clock;
+	dictionary->instance	= NULL;
+
+	if (open->forgotten) {
+		if (0 == open->pins) {
+			error = ion_master_table_open_drop(open);
+		}
+	}
+	else {
+		error = ion_master_table_open_trim(open->table);
+	}
+
+	ION_MASTER_TABLE_UNLOCK();
+
+	return error;
+}
+
+/**
+@brief		Deletes a dictionary given out, so long as no one else has it
+			open.
+*/
+static ion_err_t
+ion_master_table_open_delete(
+	ion_dictionary_t *dictionary
+) {
+	ion_master_table_open_t *open;
+	ion_err_t				error;
+
+	ION_MASTER_TABLE_LOCK();
+	open = ion_master_table_open_find(dictionary);
+
+	if ((NULL == open) || (1 != open->pins)) {
+		ION_MASTER_TABLE_UNLOCK();
+		return err_illegal_state;
+	}
+
+	ion_master_table_open_unlink(open);
+	ION_MASTER_TABLE_UNLOCK();
+
+	error					= dictionary_delete_dictionary(&open->dictionary);
+	ion_free(open);
+	dictionary->instance	= NULL;
+
+	return error;
+}
+
+/**
+@brief		Gives out a share of a dictionary kept open.
+*/
+static void
+ion_master_table_open_give(
+	ion_master_table_open_t *open,
+	ion_dictionary_t		*dictionary
+) {
+	*dictionary						= open->dictionary;
+	dictionary->handler				= &open->shared;
+	/* each opener counts and pushes its own writes */
+	dictionary->durability.pending	= 0;
+#if ION_DICTIONARY_STATS
+	dictionary->stats				= NULL;
+#endif
+}
+
+/**
+@brief		Closes for good, or gives out no more, every dictionary kept
+			open from a table, which those still open then outlive.
+*/
+static ion_err_t
+ion_master_table_open_forget_all(
+	ion_master_table_t *table
+) {
+	ion_master_table_open_t *open;
+	ion_master_table_open_t *next;
+	ion_err_t				error = err_ok;
+	ion_err_t				forgot;
+
+	ION_MASTER_TABLE_LOCK();
+
+	for (open = ion_master_table_opens; NULL != open; open = next) {
+		next = open->next;
+
+		if (table != open->table) {
+			continue;
+		}
+
+		/* one still open outlives the table, which may be opened anew */
+		open->table = NULL;
+		forgot		= ion_master_table_open_forget(open);
+
+		if (err_ok == error) {
+			error = forgot;
+		}
+	}
+
+	ION_MASTER_TABLE_UNLOCK();
+
+	return error;
+}
+
+/**
+@brief		Gives out no more the dictionary of an ID kept open.
+*/
+static ion_err_t
+ion_master_table_open_forget_id(
+	ion_master_table_t	*table,
+	ion_dictionary_id_t id
+) {
+	ion_master_table_open_t *open;
+	ion_err_t				error = err_ok;
+
+	ION_MASTER_TABLE_LOCK();
+
+	for (open = ion_master_table_opens; NULL != open; open = open->next) {
+		if ((table == open->table) && (open->id == id) && !open->forgotten) {
+			error = ion_master_table_open_forget(open);
+			break;
+		}
+	}
+
+	ION_MASTER_TABLE_UNLOCK();
+
+	return error;
+}
+
+#endif
+
+/**
+@brief		Copies a field of a record into its bytes, moving past it.
+*/
+#define ION_MASTER_TABLE_PUT(record, field) (memcpy((record), &(field), sizeof(field)), (record) += sizeof(field))
+
+/**
+@brief		Copies a field of a record out of its bytes, moving past it.
+*/
+#define ION_MASTER_TABLE_GET(record, field) (memcpy(&(field), (record), sizeof(field)), (record) += sizeof(field))
+
+/**
+@brief		Packs a record into the bytes it takes in the table.
+*/
+static void
+ion_master_table_pack(
 	ion_dictionary_config_info_t	*config,
-	long							where
+	ion_byte_t						*record
 ) {
-	long old_pos = ftell(ion_master_table_file);
+	ION_MASTER_TABLE_PUT(record, config->id);
+	ION_MASTER_TABLE_PUT(record, config->use_type);
+	ION_MASTER_TABLE_PUT(record, config->type);
+	ION_MASTER_TABLE_PUT(record, config->key_size);
+	ION_MASTER_TABLE_PUT(record, config->value_size);
+	ION_MASTER_TABLE_PUT(record, config->dictionary_size);
+	ION_MASTER_TABLE_PUT(record, config->page_size);
+	ION_MASTER_TABLE_PUT(record, config->hash_function);
+	ION_MASTER_TABLE_PUT(record, config->index_of);
+	ION_MASTER_TABLE_PUT(record, config->index_offset);
+	ION_MASTER_TABLE_PUT(record, config->index_size);
+	ION_MASTER_TABLE_PUT(record, config->options);
+}
 
-	if (ION_MASTER_TABLE_CALCULATE_POS == where) {
-		where = (int) (config->id * ION_MASTER_TABLE_RECORD_SIZE(config));
+/**
+@brief		Unpacks a record from the bytes it takes in the table.
+*/
+static void
+ion_master_table_unpack(
+	ion_byte_t						*record,
+	ion_dictionary_config_info_t	*config
+) {
+	ION_MASTER_TABLE_GET(record, config->id);
+	ION_MASTER_TABLE_GET(record, config->use_type);
+	ION_MASTER_TABLE_GET(record, config->type);
+	ION_MASTER_TABLE_GET(record, config->key_size);
+	ION_MASTER_TABLE_GET(record, config->value_size);
+	ION_MASTER_TABLE_GET(record, config->dictionary_size);
+	ION_MASTER_TABLE_GET(record, config->page_size);
+	ION_MASTER_TABLE_GET(record, config->hash_function);
+	ION_MASTER_TABLE_GET(record, config->index_of);
+	ION_MASTER_TABLE_GET(record, config->index_offset);
+	ION_MASTER_TABLE_GET(record, config->index_size);
+	ION_MASTER_TABLE_GET(record, config->options);
+}
+
+#if ION_MASTER_TABLE_USE_MMAP
+
+/**
+@brief		The least a table file is mapped by. The mapping doubles from
+			there as the file outgrows it, so that a table given many
+			IDs is remapped rarely.
+*/
+#define ION_MASTER_TABLE_MAP_BYTES 4096
+
+/**
+@brief		Drops the mapping of a table's file, if it has one, leaving the
+			table going through the file.
+*/
+static void
+ion_master_table_unmap(
+	ion_master_table_t *table
+) {
+	if (NULL != table->map) {
+		munmap(table->map, table->map_size);
+		table->map = NULL;
 	}
 
-	if (ION_MASTER_TABLE_CALCULATE_POS > where) {
-		if (0 != fseek(ion_master_table_file, 0, SEEK_END)) {
-			return err_file_bad_seek;
+	table->map_size		= 0;
+	table->file_size	= 0;
+}
+
+/**
+@brief		Makes the mapping of a table's file cover its first @p end
+			bytes, growing the file to them if it is shorter.
+@details	A file grown is filled with zeros, which read as rows never
+			written. Touching a mapping past the end of its file faults,
+			so the file always grows first. A table whose file cannot be
+			grown or mapped is left going through the file.
+*/
+static void
+ion_master_table_map(
+	ion_master_table_t	*table,
+	size_t				end
+) {
+	size_t	size = table->map_size;
+	void	*map;
+
+	if (end > table->file_size) {
+		if (0 != ftruncate(fileno(table->file), (off_t) end)) {
+			ion_master_table_unmap(table);
+			return;
+		}
+
+		table->file_size = end;
+	}
+
+	if (end <= table->map_size) {
+		return;
+	}
+
+	if (size < ION_MASTER_TABLE_MAP_BYTES) {
+		size = ION_MASTER_TABLE_MAP_BYTES;
+	}
+
+	while (size < end) {
+		size *= 2;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(table->file), 0);
+
+	if (MAP_FAILED == map) {
+		ion_master_table_unmap(table);
+		return;
+	}
+
+	if (NULL != table->map) {
+		munmap(table->map, table->map_size);
+	}
+
+	table->map		= map;
+	table->map_size = size;
+}
+
+/**
+@brief		Maps the file of a table just opened, once what stdio holds
+			of it is written out and dropped.
+*/
+static void
+ion_master_table_map_file(
+	ion_master_table_t *table
+) {
+	struct stat file_stat;
+
+	if ((0 != fflush(table->file)) || (0 != fstat(fileno(table->file), &file_stat)) || (0 == file_stat.st_size)) {
+		return;
+	}
+
+	table->file_size = (size_t) file_stat.st_size;
+	ion_master_table_map(table, table->file_size);
+}
+
+#endif
+
+/**
+@brief		Copies bytes of a table file in, at @p where or, if that is
+			below @c ION_MASTER_TABLE_CALCULATE_POS, at the end, which
+			@p where is then set to.
+*/
+static ion_err_t
+ion_master_table_store(
+	ion_master_table_t	*table,
+	const ion_byte_t	*bytes,
+	size_t				size,
+	long				*where
+) {
+#if ION_MASTER_TABLE_USE_MMAP
+
+	if (NULL != table->map) {
+		if (ION_MASTER_TABLE_CALCULATE_POS > *where) {
+			*where = (long) table->file_size;
+		}
+
+		ion_master_table_map(table, (size_t) *where + size);
+	}
+
+	if (NULL != table->map) {
+		memcpy(table->map + *where, bytes, size);
+		return err_ok;
+	}
+
+#endif
+
+	if (ION_MASTER_TABLE_CALCULATE_POS > *where) {
+		if (0 != fseek(table->file, 0, SEEK_END)) {
+			return err_file_bad_seek;
+		}
+
+		*where = ftell(table->file);
+	}
+	else if (0 != fseek(table->file, *where, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	if (1 != fwrite(bytes, size, 1, table->file)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Copies bytes of a table file out, from @p where.
+*/
+static ion_err_t
+ion_master_table_load(
+	ion_master_table_t	*table,
+	ion_byte_t			*bytes,
+	size_t				size,
+	long				where
+) {
+#if ION_MASTER_TABLE_USE_MMAP
+
+	if (NULL != table->map) {
+		if (0 > where) {
+			return err_file_bad_seek;
+		}
+
+		/* the rows past the end of the file are read as stdio would, as not there */
+		if ((size_t) where + size > table->file_size) {
+			return err_file_read_error;
+		}
+
+		memcpy(bytes, table->map + where, size);
+		return err_ok;
+	}
+
+#endif
+
+	if (0 != fseek(table->file, where, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	if (1 != fread(bytes, size, 1, table->file)) {
+		return err_file_read_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Pushes a table file to storage.
+*/
+static ion_err_t
+ion_master_table_sync(
+	ion_master_table_t *table
+) {
+#if ION_MASTER_TABLE_USE_MMAP
+
+	if ((NULL != table->map) && (0 != msync(table->map, table->file_size, MS_SYNC))) {
+		return err_file_write_error;
+	}
+
+#endif
+
+	return ion_fsync_stream(table->file);
+}
+
+/**
+@brief		Write a record to the master table.
+@details	The record is packed and written at once. The file position is
+			left after it; every read and write seeks first.
+@param[in]	table
+				The table to write to.
+@param[in]	config
+				A pointer to a previously allocated config object to write from.
+@param[in]	where
+				An integral value representing where to write to in the file.
+				This file offset is byte-aligned, not record aligned, in general.
+
+				Two special flags can be passed in here:
+					- @c ION_MASTER_TABLE_CALCULATE_POS
+						Calculate the position based on the passed-in config id.
+					- @c ION_MASTER_TABLE_WRITE_FROM_END
+						Write the record at the end of the file.
+@returns	An error code describing the result of the call.
+*/
+static ion_err_t
+ion_master_table_write(
+	ion_master_table_t				*table,
+	ion_dictionary_config_info_t	*config,
+	long							where
+) {
+	ion_byte_t	record[ION_MASTER_TABLE_RECORD_SIZE(config)];
+	ion_err_t	err;
+
+	if (ION_MASTER_TABLE_CALCULATE_POS == where) {
+		where = (long) ION_MASTER_TABLE_ROW(table, config->id) * ION_MASTER_TABLE_RECORD_SIZE(config);
+	}
+
+	ion_master_table_pack(config, record);
+
+	err = ion_master_table_store(table, record, sizeof(record), &where);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	/* records are written rarely, so anything stronger than on close pushes each one, or each batch */
+	if (!table->batching && ((durability_group == ION_DEFAULT_DURABILITY) || (durability_sync == ION_DEFAULT_DURABILITY))) {
+		err = ion_master_table_sync(table);
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+#if ION_MASTER_TABLE_DIRECTORY
+
+	/* the master row at the start holds the next ID, not a dictionary */
+	if (table->directory.ready && (where > 0) && (0 == where % ION_MASTER_TABLE_RECORD_SIZE(config))) {
+		ion_master_table_directory_put(table, (ion_dictionary_id_t) (where / ION_MASTER_TABLE_RECORD_SIZE(config)), config);
+	}
+
+#endif
+
+	return err_ok;
+}
+
+/**
+@brief		Read a record to the master table.
+@details	The record is read at once and unpacked. The file position is
+			left after it.
+@param[in]	table
+				The table to read from.
+@param[out]	config
+				A pointer to a previously allocated config object to write to.
+@param[in]	where
+				An integral value representing where to read from in the file.
+				This file offset is byte-aligned, not record aligned, in general.
+
+				One special flag can be passed in here:
+					- @c ION_MASTER_TABLE_CALCULATE_POS
+						Calculate the position based on the passed-in config id.
+@returns	An error code describing the result of the call.
+*/
+static ion_err_t
+ion_master_table_read(
+	ion_master_table_t				*table,
+	ion_dictionary_config_info_t	*config,
+	long							where
+) {
+	ion_byte_t	record[ION_MASTER_TABLE_RECORD_SIZE(config)];
+	ion_err_t	err;
+
+	if (ION_MASTER_TABLE_CALCULATE_POS == where) {
+		where = (long) ION_MASTER_TABLE_ROW(table, config->id) * ION_MASTER_TABLE_RECORD_SIZE(config);
+	}
+
+	err = ion_master_table_load(table, record, sizeof(record), where);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	ion_master_table_unpack(record, config);
+
+	if (0 == config->id) {
+		return err_item_not_found;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the master row, which holds the next row and the first of
+			the rows free to be given out again.
+*/
+static ion_err_t
+ion_master_table_write_master_row(
+	ion_master_table_t *table
+) {
+	ion_dictionary_config_info_t master_config = { .id = table->next_row, .index_of = table->free_row };
+
+	return ion_master_table_write(table, &master_config, 0);
+}
+
+/**
+@brief		Gives out the next dictionary ID.
+*/
+static ion_err_t
+ion_master_table_get_next_id(
+	ion_master_table_t	*table,
+	ion_dictionary_id_t *id
+) {
+	ion_dictionary_id_t				next_row	= table->next_row;
+	ion_dictionary_id_t				free_row	= table->free_row;
+	ion_dictionary_id_t				row;
+	ion_dictionary_config_info_t	freed;
+	ion_err_t						error;
+
+	/* a freed record links to the next freed; one written over since is never given out */
+	if ((0 != table->free_row) && (err_item_not_found == ion_master_table_read(table, &freed, (long) table->free_row * ION_MASTER_TABLE_RECORD_SIZE(&freed)))) {
+		row				= table->free_row;
+		table->free_row = freed.index_of;
+	}
+	else {
+		row				= table->next_row++;
+		table->free_row = 0;
+	}
+
+	*id = table->id_base + row;
+
+	if (table->batching) {
+		return err_ok;
+	}
+
+	error = ion_master_table_write_master_row(table);
+
+	if (err_ok != error) {
+		table->next_row = next_row;
+		table->free_row = free_row;
+	}
+
+	return error;
+}
+
+/**
+@brief		Frees the ID of a dictionary deleted along with its files, so
+			it is given out again.
+*/
+static ion_err_t
+ion_master_table_free(
+	ion_master_table_t	*table,
+	ion_dictionary_id_t id
+) {
+	ion_dictionary_id_t				row		= ION_MASTER_TABLE_ROW(table, id);
+	ion_dictionary_config_info_t	freed	= { .id = 0, .index_of = table->free_row };
+	ion_err_t						error	= ion_master_table_write(table, &freed, (long) row * ION_MASTER_TABLE_RECORD_SIZE(&freed));
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	table->free_row = row;
+
+	if (table->batching) {
+		return err_ok;
+	}
+
+	return ion_master_table_write_master_row(table);
+}
+
+ion_err_t
+ion_mt_open(
+	ion_master_table_t	*table,
+	const char			*file_name,
+	ion_dictionary_id_t id_base
+) {
+	ion_err_t error = err_ok;
+
+	if (strlen(file_name) >= sizeof(table->name)) {
+		return err_file_open_error;
+	}
+
+	memset(table, 0, sizeof(ion_master_table_t));
+	strcpy(table->name, file_name);
+	table->id_base	= id_base;
+	table->file		= fopen(table->name, "r+b");
+
+	/* File may not exist. */
+	if (NULL == table->file) {
+		table->file = fopen(table->name, "w+b");
+
+		if (NULL == table->file) {
+			return err_file_open_error;
+		}
+
+		/* Clean fresh file was opened, so numbering starts over. */
+		/* Write master row. */
+		table->next_row = 1;
+		table->free_row = 0;
+
+		if (err_ok != (error = ion_master_table_write_master_row(table))) {
+			return error;
+		}
+	}
+	else {
+		/* Here we read an existing file. */
+
+		/* Find existing ID count. */
+		ion_dictionary_config_info_t master_config;
+
+		if (ion_master_table_read(table, &master_config, 0)) {
+			return err_file_read_error;
+		}
+
+		table->next_row = master_config.id;
+		table->free_row = master_config.index_of;
+
+		/* records written in a batch cut short are past the next row the master row has */
+		if ((0 == fseek(table->file, 0, SEEK_END)) && (ftell(table->file) / ION_MASTER_TABLE_RECORD_SIZE(&master_config) > table->next_row)) {
+			table->next_row = (ion_dictionary_id_t) (ftell(table->file) / ION_MASTER_TABLE_RECORD_SIZE(&master_config));
+		}
+	}
+
+#if ION_MASTER_TABLE_USE_MMAP
+	ion_master_table_map_file(table);
+#endif
+
+#if ION_MASTER_TABLE_DIRECTORY
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_id_t				row;
+
+	/* a table that cannot be held whole is read from its file instead */
+	table->directory.ready = boolean_true;
+
+	for (row = 1; (row < table->next_row) && table->directory.ready; row++) {
+		error = ion_master_table_read(table, &config, (long) row * ION_MASTER_TABLE_RECORD_SIZE(&config));
+
+		if (err_item_not_found == error) {
+			continue;
+		}
+
+		if ((err_ok != error) || (err_ok != ion_master_table_directory_put(table, row, &config))) {
+			ion_master_table_directory_clear(table);
+		}
+	}
+
+#endif
+
+	return err_ok;
+}
+
+ion_err_t
+ion_mt_close(
+	ion_master_table_t *table
+) {
+	ion_err_t error = err_ok;
+
+	if (table->batching) {
+		error = ion_mt_end_batch(table);
+	}
+
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+
+	/* IDs start over should the table be made anew */
+	if (err_ok == error) {
+		error = ion_master_table_open_forget_all(table);
+	}
+	else {
+		ion_master_table_open_forget_all(table);
+	}
+
+#endif
+#if ION_MASTER_TABLE_DIRECTORY
+	ion_master_table_directory_clear(table);
+#endif
+
+	if (NULL != table->file) {
+		if ((durability_close == ION_DEFAULT_DURABILITY) && (err_ok != ion_master_table_sync(table))) {
+#if ION_MASTER_TABLE_USE_MMAP
+			ion_master_table_unmap(table);
+#endif
+			fclose(table->file);
+			table->file = NULL;
+			return err_file_write_error;
+		}
+
+#if ION_MASTER_TABLE_USE_MMAP
+		ion_master_table_unmap(table);
+#endif
+
+		if (0 != fclose(table->file)) {
+			return err_file_close_error;
+		}
+	}
+
+	table->file = NULL;
+
+	return error;
+}
+
+ion_err_t
+ion_mt_begin_batch(
+	ion_master_table_t *table
+) {
+	if (NULL == table->file) {
+		return err_illegal_state;
+	}
+
+	table->batching = boolean_true;
+
+	return err_ok;
+}
+
+ion_err_t
+ion_mt_end_batch(
+	ion_master_table_t *table
+) {
+	if (!table->batching) {
+		return err_ok;
+	}
+
+	/* the row written last pushes the whole batch, as durability asks */
+	table->batching = boolean_false;
+
+	if (NULL == table->file) {
+		return err_illegal_state;
+	}
+
+	return ion_master_table_write_master_row(table);
+}
+
+ion_err_t
+ion_mt_checkpoint(
+	ion_master_table_t *table
+) {
+	ion_err_t	error;
+	ion_err_t	err;
+
+	if (NULL == table->file) {
+		return err_illegal_state;
+	}
+
+	if (err_ok != ion_fsync_defer()) {
+		return err_illegal_state;
+	}
+
+	error = dictionary_sync_all();
+
+	/* a batch holds back its master row, which the records are read by */
+	if (table->batching) {
+		err = ion_master_table_write_master_row(table);
+
+		if (err_ok == error) {
+			error = err;
+		}
+	}
+
+	err = ion_master_table_sync(table);
+
+	if (err_ok == error) {
+		error = err;
+	}
+
+	err = ion_fsync_deferred();
+
+	return (err_ok != error) ? error : err;
+}
+
+ion_err_t
+ion_mt_get_info(
+	ion_master_table_t		*table,
+	ion_dictionary_info_t	*total,
+	int						*count
+) {
+	if (NULL == table->file) {
+		return err_illegal_state;
+	}
+
+	/* row 0 is the master row, so the IDs of the table start past the base */
+	return dictionary_get_info_all(table->id_base + 1, table->id_base + table->next_row, total, count);
+}
+
+ion_err_t
+ion_mt_delete(
+	ion_master_table_t *table
+) {
+	if (NULL != table->file) {
+		if (0 != fremove(table->name)) {
+			return err_file_delete_error;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+ion_mt_create_dictionary(
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size
+) {
+	ion_err_t			err;
+	ion_dictionary_id_t id;
+
+	err = ion_master_table_get_next_id(table, &id);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	err = dictionary_create(handler, dictionary, id, key_type, key_size, value_size, dictionary_size);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	/* not all implementations track the dictionary size, so it is recorded as given */
+	ion_dictionary_config_info_t config = {
+		.id = dictionary->instance->id, .use_type = 0, .type = dictionary->instance->key_type, .key_size = dictionary->instance->record.key_size, .value_size = dictionary->instance->record.value_size, .dictionary_size = dictionary_size
+	};
+
+	return ion_master_table_write(table, &config, ION_MASTER_TABLE_CALCULATE_POS);
+}
+
+ion_err_t
+ion_mt_create_dictionary_paged(
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_size_t		page_size
+) {
+	ion_dictionary_config_info_t config = {
+		.id = 0, .use_type = 0, .type = key_type, .key_size = key_size, .value_size = value_size, .dictionary_size = dictionary_size, .page_size = page_size
+	};
+
+	return ion_mt_create_dictionary_from_config(table, handler, dictionary, &config);
+}
+
+ion_err_t
+ion_mt_create_dictionary_from_config(
+	ion_master_table_t				*table,
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config
+) {
+	ion_err_t err;
+
+	err = ion_master_table_get_next_id(table, &config->id);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	/* opening through the config creates the dictionary with every setting in it */
+	err = dictionary_open(handler, dictionary, config);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	return ion_master_table_write(table, config, ION_MASTER_TABLE_CALCULATE_POS);
+}
+
+ion_err_t
+ion_mt_lookup(
+	ion_master_table_t				*table,
+	ion_dictionary_id_t				id,
+	ion_dictionary_config_info_t	*config
+) {
+	ion_dictionary_id_t row = ION_MASTER_TABLE_ROW(table, id);
+
+	/* the master row is no dictionary's, nor are rows past the last */
+	if ((0 == row) || (row >= table->next_row)) {
+		return err_item_not_found;
+	}
+
+#if ION_MASTER_TABLE_DIRECTORY
+
+	if (table->directory.ready) {
+		if ((row >= table->directory.capacity) || (0 == table->directory.entries[row].config.id)) {
+			return err_item_not_found;
+		}
+
+		*config = table->directory.entries[row].config;
+		return err_ok;
+	}
+
+#endif
+
+	return ion_master_table_read(table, config, (long) row * ION_MASTER_TABLE_RECORD_SIZE(config));
+}
+
+ion_err_t
+ion_mt_find_by_use(
+	ion_master_table_t				*table,
+	ion_dictionary_config_info_t	*config,
+	ion_dict_use_t					use_type,
+	char							whence
+) {
+	ion_dictionary_id_t				row;
+	ion_dictionary_config_info_t	tconfig;
+	ion_err_t						error;
+
+#if ION_MASTER_TABLE_DIRECTORY
+
+	if (table->directory.ready) {
+		row = (ION_MASTER_TABLE_FIND_LAST == whence) ? table->directory.last_of_use[use_type] : table->directory.first_of_use[use_type];
+
+		if (0 == row) {
+			return err_item_not_found;
+		}
+
+		*config = table->directory.entries[row].config;
+		return err_ok;
+	}
+
+#endif
+
+	tconfig.id	= 0;
+
+	row			= 1;
+
+	if (ION_MASTER_TABLE_FIND_LAST == whence) {
+		row = table->next_row - 1;
+	}
+
+	/* Loop through all items. */
+	for (; row < table->next_row && row > 0; row += whence) {
+		error = ion_mt_lookup(table, table->id_base + row, &tconfig);
+
+		if (err_item_not_found == error) {
+			continue;
+		}
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		/* If this config has the right type, set the output pointer. */
+		if (tconfig.use_type == use_type) {
+			*config = tconfig;
+
+			return err_ok;
 		}
 	}
-	else if (0 != fseek(ion_master_table_file, where, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
 
-	if (1 != fwrite(&(config->id), sizeof(config->id), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+	return err_item_not_found;
+}
 
-	if (1 != fwrite(&(config->use_type), sizeof(config->use_type), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+ion_err_t
+ion_mt_find_index(
+	ion_master_table_t				*table,
+	ion_dictionary_id_t				primary_id,
+	ion_dictionary_config_info_t	*config
+) {
+	ion_dictionary_id_t				row;
+	ion_dictionary_config_info_t	tconfig;
+	ion_err_t						error;
 
-	if (1 != fwrite(&(config->type), sizeof(config->type), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+	for (row = ION_MASTER_TABLE_ROW(table, config->id) + 1; row < table->next_row; row++) {
+		error = ion_mt_lookup(table, table->id_base + row, &tconfig);
 
-	if (1 != fwrite(&(config->key_size), sizeof(config->key_size), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+		if (err_item_not_found == error) {
+			continue;
+		}
 
-	if (1 != fwrite(&(config->value_size), sizeof(config->value_size), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+		if (err_ok != error) {
+			return error;
+		}
 
-	if (1 != fwrite(&(config->dictionary_size), sizeof(config->dictionary_size), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+		if (tconfig.index_of == primary_id) {
+			*config = tconfig;
 
-	if (0 != fseek(ion_master_table_file, old_pos, SEEK_SET)) {
-		return err_file_bad_seek;
+			return err_ok;
+		}
 	}
 
-	return err_ok;
+	return err_item_not_found;
 }
 
 /**
-@brief		Read a record to the master table.
-@details	Automatically, this call will reposition the file position
-			back to where it was once the call is complete.
-@param[out]	config
-				A pointer to a previously allocated config object to write to.
-@param[in]	where
-				An integral value representing where to read from in the file.
-				This file offset is byte-aligned, not record aligned, in general.
-
-				One special flag can be passed in here:
-					- @c ION_MASTER_TABLE_CALCULATE_POS
-						Calculate the position based on the passed-in config id.
-@returns	An error code describing the result of the call.
+@brief		Takes a dictionary, and the indexes registered on it, out of the
+			table, its ID not given out again until freed.
 */
-ion_err_t
-ion_master_table_read(
-	ion_dictionary_config_info_t	*config,
-	long							where
+static ion_err_t
+ion_master_table_remove(
+	ion_master_table_t	*table,
+	ion_dictionary_id_t id
 ) {
-	long old_pos = ftell(ion_master_table_file);
+	ion_err_t						error;
+	ion_dictionary_config_info_t	blank	= { 0 };
+	ion_dictionary_config_info_t	index	= { 0 };
 
-	if (ION_MASTER_TABLE_CALCULATE_POS == where) {
-		where = (int) (config->id * ION_MASTER_TABLE_RECORD_SIZE(config));
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+	if (err_ok != (error = ion_master_table_open_forget_id(table, id))) {
+		return error;
 	}
 
-	if (0 != fseek(ion_master_table_file, where, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
+#endif
 
-	if (1 != fread(&(config->id), sizeof(config->id), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+	/* the indexes registered on the dictionary go with it */
+	while (err_ok == (error = ion_mt_find_index(table, id, &index))) {
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+		if (err_ok != (error = ion_master_table_open_forget_id(table, index.id))) {
+			return error;
+		}
 
-	if (1 != fread(&(config->use_type), sizeof(config->use_type), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+#endif
 
-	if (1 != fread(&(config->type), sizeof(config->type), 1, ion_master_table_file)) {
-		return err_file_write_error;
+		if (err_ok != (error = ion_master_table_write(table, &blank, (long) ION_MASTER_TABLE_ROW(table, index.id) * ION_MASTER_TABLE_RECORD_SIZE(&blank)))) {
+			return error;
+		}
 	}
 
-	if (1 != fread(&(config->key_size), sizeof(config->key_size), 1, ion_master_table_file)) {
-		return err_file_write_error;
+	if (err_item_not_found != error) {
+		return error;
 	}
 
-	if (1 != fread(&(config->value_size), sizeof(config->value_size), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+	return ion_master_table_write(table, &blank, (long) ION_MASTER_TABLE_ROW(table, id) * ION_MASTER_TABLE_RECORD_SIZE(&blank));
+}
 
-	if (1 != fread(&(config->dictionary_size), sizeof(config->dictionary_size), 1, ion_master_table_file)) {
-		return err_file_write_error;
-	}
+ion_err_t
+ion_mt_delete_from(
+	ion_master_table_t	*table,
+	ion_dictionary_t	*dictionary
+) {
+	ion_err_t			error;
+	ion_dictionary_id_t id = dictionary->instance->id;
 
-	if (0 != fseek(ion_master_table_file, old_pos, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
+	error = ion_close_dictionary(dictionary);
 
-	if (0 == config->id) {
-		return err_item_not_found;
+	if (err_ok != error) {
+		return error;
 	}
 
-	return err_ok;
+	return ion_master_table_remove(table, id);
 }
 
-/* Returns the next dictionary ID, then increments. */
 ion_err_t
-ion_master_table_get_next_id(
-	ion_dictionary_id_t *id
+ion_mt_delete_dictionary(
+	ion_master_table_t	*table,
+	ion_dictionary_t	*dictionary
 ) {
-	ion_err_t error								= err_ok;
+	ion_err_t			error;
+	ion_dictionary_id_t id = dictionary->instance->id;
 
-	/* Flush master row. This writes the next ID to be used, so add 1. */
-	ion_dictionary_config_info_t master_config	= { .id = ion_master_table_next_id + 1 };
-
-	error = ion_master_table_write(&master_config, 0);
+	error = dictionary_delete_dictionary(dictionary);
 
 	if (err_ok != error) {
 		return error;
 	}
 
-	*id = ion_master_table_next_id++;
+	if (err_ok != (error = ion_master_table_remove(table, id))) {
+		return error;
+	}
 
-	return err_ok;
+	/* its files are gone, so a dictionary made with its ID starts empty */
+	return ion_master_table_free(table, id);
 }
 
 ion_err_t
-ion_init_master_table(
-	void
+ion_mt_open_dictionary(
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handler,	/* This is already initialized. */
+	ion_dictionary_t			*dictionary,	/* Passed in empty, to be set. */
+	ion_dictionary_id_t			id
 ) {
-	ion_err_t error = err_ok;
+	ion_err_t err;
 
-	/* If it's already open, then we don't do anything. */
-	if (NULL != ion_master_table_file) {
-		return err_ok;
-	}
+	ion_dictionary_config_info_t config;
 
-	ion_master_table_file = fopen(ION_MASTER_TABLE_FILENAME, "r+b");
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+	ion_master_table_open_t *open;
 
-	/* File may not exist. */
-	if (NULL == ion_master_table_file) {
-		ion_master_table_file = fopen(ION_MASTER_TABLE_FILENAME, "w+b");
+	ION_MASTER_TABLE_LOCK();
 
-		if (NULL == ion_master_table_file) {
-			return err_file_open_error;
+	for (open = ion_master_table_opens; NULL != open; open = open->next) {
+		if ((table == open->table) && (open->id == id) && !open->forgotten) {
+			break;
 		}
+	}
 
-		/* Clean fresh file was opened. */
-		/* Write master row. */
-		ion_dictionary_config_info_t master_config = { .id = ion_master_table_next_id };
-
-		if (err_ok != (error = ion_master_table_write(&master_config, 0))) {
-			return error;
+	/* one opened as another kind is opened again */
+	if ((NULL != open) && (open->handler.open_dictionary != handler->open_dictionary)) {
+		if (err_ok != (err = ion_master_table_open_forget(open))) {
+			ION_MASTER_TABLE_UNLOCK();
+			return err;
 		}
+
+		open = NULL;
 	}
-	else {
-		/* Here we read an existing file. */
 
-		/* Find existing ID count. */
-		ion_dictionary_config_info_t master_config;
+	if (NULL != open) {
+		open->pins++;
+		ion_master_table_open_give(open, dictionary);
+		ION_MASTER_TABLE_UNLOCK();
+		return err_ok;
+	}
 
-		if (ion_master_table_read(&master_config, 0)) {
-			return err_file_read_error;
+	ION_MASTER_TABLE_UNLOCK();
+#endif
+
+	err = ion_mt_lookup(table, id, &config);
+
+	/* Lookup for id failed. */
+	if (err_ok != err) {
+		return err_dictionary_initialization_failed;
+	}
+
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+
+	/* without the memory to keep it, it is opened as before */
+	if (NULL != (open = ion_alloc(ion_alloc_other, sizeof(ion_master_table_open_t)))) {
+		open->handler	= *handler;
+		err				= dictionary_open(&open->handler, &open->dictionary, &config);
+
+		if (err_ok != err) {
+			ion_free(open);
+			return err;
 		}
 
-		ion_master_table_next_id = master_config.id;
+		open->shared					= open->handler;
+		open->shared.close_dictionary	= ion_master_table_open_release;
+		open->shared.delete_dictionary	= ion_master_table_open_delete;
+		open->table						= table;
+		open->id						= id;
+		open->pins						= 1;
+		open->used						= 0;
+		open->forgotten					= boolean_false;
+		ION_MASTER_TABLE_LOCK();
+		open->next						= ion_master_table_opens;
+		ion_master_table_opens			= open;
+		ion_master_table_open_give(open, dictionary);
+		ION_MASTER_TABLE_UNLOCK();
+
+		return err_ok;
 	}
 
-	return err_ok;
+#endif
+
+	err = dictionary_open(handler, dictionary, &config);
+	return err;
 }
 
 ion_err_t
-ion_close_master_table(
+ion_init_master_table(
 	void
 ) {
-	if (NULL != ion_master_table_file) {
-		if (0 != fclose(ion_master_table_file)) {
-			return err_file_close_error;
-		}
+	/* If it's already open, then we don't do anything. */
+	if (NULL != ion_master_table_default.file) {
+		return err_ok;
 	}
 
-	ion_master_table_file = NULL;
+#if ION_MASTER_TABLE_DIRECTORY
+	/* One whose file was dropped from under it still holds its directory. */
+	ion_master_table_directory_clear(&ion_master_table_default);
+#endif
+#if ION_MASTER_TABLE_USE_MMAP
+	ion_master_table_unmap(&ion_master_table_default);
+#endif
 
-	return err_ok;
+	return ion_mt_open(&ion_master_table_default, ION_MASTER_TABLE_FILENAME, 0);
 }
 
 ion_err_t
-ion_delete_master_table(
+ion_close_master_table(
 	void
 ) {
-	if (NULL != ion_master_table_file) {
-		if (0 != fremove(ION_MASTER_TABLE_FILENAME)) {
-			return err_file_delete_error;
-		}
-	}
+	return ion_mt_close(&ion_master_table_default);
+}
 
-	return err_ok;
+ion_err_t
+ion_master_table_begin_batch(
+	void
+) {
+	return ion_mt_begin_batch(&ion_master_table_default);
 }
 
-/**
-@brief		Adds the given dictionary to the master table.
-@param		dictionary
-				A pointer to the dictionary object to add to the master table.
-@param		dictionary_size
-				The implementation specific size parameter used when
-				creating the dictionary. This parameter must be passed
-				to this function by @ref ion_master_table_create_dictionary,
-				since not all implementations track the dictionary size.
-*/
 ion_err_t
-ion_add_to_master_table(
-	ion_dictionary_t		*dictionary,
-	ion_dictionary_size_t	dictionary_size
+ion_master_table_end_batch(
+	void
 ) {
-	ion_dictionary_config_info_t config = {
-		.id = dictionary->instance->id, .use_type = 0, .type = dictionary->instance->key_type, .key_size = dictionary->instance->record.key_size, .value_size = dictionary->instance->record.value_size, .dictionary_size = dictionary_size
-	};
+	return ion_mt_end_batch(&ion_master_table_default);
+}
+
+ion_err_t
+ion_master_table_checkpoint(
+	void
+) {
+	return ion_mt_checkpoint(&ion_master_table_default);
+}
+
+ion_err_t
+ion_master_table_get_info(
+	ion_dictionary_info_t	*total,
+	int						*count
+) {
+	return ion_mt_get_info(&ion_master_table_default, total, count);
+}
 
-	return ion_master_table_write(&config, ION_MASTER_TABLE_WRITE_FROM_END);
+ion_err_t
+ion_delete_master_table(
+	void
+) {
+	return ion_mt_delete(&ion_master_table_default);
 }
 
 ion_err_t
@@ -288,24 +1564,29 @@ ion_master_table_create_dictionary(
 	ion_value_size_t			value_size,
 	ion_dictionary_size_t		dictionary_size
 ) {
-	ion_err_t			err;
-	ion_dictionary_id_t id;
-
-	err = ion_master_table_get_next_id(&id);
-
-	if (err_ok != err) {
-		return err;
-	}
-
-	err = dictionary_create(handler, dictionary, id, key_type, key_size, value_size, dictionary_size);
-
-	if (err_ok != err) {
-		return err;
-	}
+	return ion_mt_create_dictionary(&ion_master_table_default, handler, dictionary, key_type, key_size, value_size, dictionary_size);
+}
 
-	err = ion_add_to_master_table(dictionary, dictionary_size);
+ion_err_t
+ion_master_table_create_dictionary_paged(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_size_t		page_size
+) {
+	return ion_mt_create_dictionary_paged(&ion_master_table_default, handler, dictionary, key_type, key_size, value_size, dictionary_size, page_size);
+}
 
-	return err;
+ion_err_t
+ion_master_table_create_dictionary_from_config(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config
+) {
+	return ion_mt_create_dictionary_from_config(&ion_master_table_default, handler, dictionary, config);
 }
 
 ion_err_t
@@ -313,16 +1594,7 @@ ion_lookup_in_master_table(
 	ion_dictionary_id_t				id,
 	ion_dictionary_config_info_t	*config
 ) {
-	ion_err_t error = err_ok;
-
-	config->id	= id;
-	error		= ion_master_table_read(config, ION_MASTER_TABLE_CALCULATE_POS);
-
-	if (err_ok != error) {
-		return error;
-	}
-
-	return err_ok;
+	return ion_mt_lookup(&ion_master_table_default, id, config);
 }
 
 ion_err_t
@@ -331,77 +1603,38 @@ ion_find_by_use_master_table(
 	ion_dict_use_t					use_type,
 	char							whence
 ) {
-	ion_dictionary_id_t				id;
-	ion_dictionary_config_info_t	tconfig;
-	ion_err_t						error;
-
-	tconfig.id	= 0;
-
-	id			= 1;
-
-	if (ION_MASTER_TABLE_FIND_LAST == whence) {
-		id = ion_master_table_next_id - 1;
-	}
-
-	/* Loop through all items. */
-	for (; id < ion_master_table_next_id && id > 0; id += whence) {
-		error = ion_lookup_in_master_table(id, &tconfig);
-
-		if (err_item_not_found == error) {
-			continue;
-		}
-
-		if (err_ok != error) {
-			return error;
-		}
-
-		/* If this config has the right type, set the output pointer. */
-		if (tconfig.use_type == use_type) {
-			*config = tconfig;
-
-			return err_ok;
-		}
-	}
+	return ion_mt_find_by_use(&ion_master_table_default, config, use_type, whence);
+}
 
-	return err_item_not_found;
+ion_err_t
+ion_find_index_master_table(
+	ion_dictionary_id_t				primary_id,
+	ion_dictionary_config_info_t	*config
+) {
+	return ion_mt_find_index(&ion_master_table_default, primary_id, config);
 }
 
 ion_err_t
 ion_delete_from_master_table(
 	ion_dictionary_t *dictionary
 ) {
-	ion_err_t						error;
-	ion_dictionary_config_info_t	blank	= { 0 };
-	long							where	= (dictionary->instance->id * ION_MASTER_TABLE_RECORD_SIZE(&blank));
-
-	error = ion_close_dictionary(dictionary);
-
-	if (err_ok != error) {
-		return error;
-	}
+	return ion_mt_delete_from(&ion_master_table_default, dictionary);
+}
 
-	return ion_master_table_write(&blank, where);
+ion_err_t
+ion_master_table_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return ion_mt_delete_dictionary(&ion_master_table_default, dictionary);
 }
 
 ion_err_t
 ion_open_dictionary(
-	ion_dictionary_handler_t	*handler,	/* This is already initialized. */
-	ion_dictionary_t			*dictionary,	/* Passed in empty, to be set. */
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
 	ion_dictionary_id_t			id
 ) {
-	ion_err_t err;
-
-	ion_dictionary_config_info_t config;
-
-	err = ion_lookup_in_master_table(id, &config);
-
-	/* Lookup for id failed. */
-	if (err_ok != err) {
-		return err_dictionary_initialization_failed;
-	}
-
-	err = dictionary_open(handler, dictionary, &config);
-	return err;
+	return ion_mt_open_dictionary(&ion_master_table_default, handler, dictionary, id);
 }
 
 ion_err_t
@@ -68,17 +68,322 @@ extern "C" {
 #define ION_MASTER_TABLE_FIND_LAST	-1
 
 /**
-@brief		Master table resposible for managing instances.
+@brief		Whether the master table is also held in memory, as a directory
+			of its records by ID and by use, so that lookups read no file.
+@details	The directory is loaded when the table is opened and kept
+			current as records are written and deleted. It takes a record
+			of memory for every ID given out, so it is off by default on
+			Arduino. Should the memory not be had, the table is read from
+			its file as before.
 */
-extern ion_dictionary_id_t ion_master_table_next_id;
+#if !defined(ION_MASTER_TABLE_DIRECTORY)
+#if defined(ARDUINO)
+#define ION_MASTER_TABLE_DIRECTORY	0
+#else
+#define ION_MASTER_TABLE_DIRECTORY	1
+#endif
+#endif
+
+/**
+@brief		How many dictionaries no one has open are kept open anyway, so
+			that opening one again by @ref ion_open_dictionary reads no
+			config and builds no state.
+@details	Those opening the same ID share it, and each close gives up a
+			share; the least recently closed is closed for good once more
+			than this are unshared. Each kept open holds its files, so
+			none are kept on Arduino.
+*/
+#if !defined(ION_MASTER_TABLE_OPEN_CACHE)
+#if defined(ARDUINO)
+#define ION_MASTER_TABLE_OPEN_CACHE 0
+#else
+#define ION_MASTER_TABLE_OPEN_CACHE 8
+#endif
+#endif
+
+/**
+@brief		Whether the table file is read and written in place through a
+			shared mapping, rather than through @c fseek, @c fread and
+			@c fwrite, so that a lookup is a copy out of an array by row
+			and a write a copy into it. The file grows a record at a time
+			as before and is laid out the same, and is @c msync'd where
+			durability would have it pushed. This is the default on POSIX
+			hosts; Arduino and other targets keep the stdio path, as does
+			a table whose file cannot be mapped. Define as 0 to force the
+			stdio path everywhere.
+*/
+#if !defined(ION_MASTER_TABLE_USE_MMAP)
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define ION_MASTER_TABLE_USE_MMAP 1
+#else
+#define ION_MASTER_TABLE_USE_MMAP 0
+#endif
+#endif
+
+#if ION_MASTER_TABLE_DIRECTORY
+
+/**
+@brief		The uses a dictionary can have.
+*/
+#define ION_MASTER_TABLE_USES (1 << (8 * sizeof(ion_dict_use_t)))
+
+/**
+@brief		A record of a master table held in memory.
+*/
+typedef struct {
+	ion_dictionary_config_info_t	config;			/**< The record, its ID 0 if there
+													 is none */
+	ion_dictionary_id_t				next_of_use;	/**< The row of the next dictionary
+													 of the same use, 0 if none */
+	ion_dictionary_id_t				prev_of_use;	/**< The one before, 0 if none */
+} ion_master_table_entry_t;
+
+/**
+@brief		A master table held in memory, while it is open.
+*/
+typedef struct {
+	ion_master_table_entry_t	*entries;							/**< By row, the first unused */
+	ion_dictionary_id_t			capacity;							/**< The entries taken */
+	ion_dictionary_id_t			first_of_use[ION_MASTER_TABLE_USES];/**< The lowest row of each use,
+																	 0 if none */
+	ion_dictionary_id_t			last_of_use[ION_MASTER_TABLE_USES];	/**< The highest */
+	ion_boolean_t				ready;								/**< Whether it holds the
+																	 whole table */
+} ion_master_table_directory_t;
+
+#endif
+
+/**
+@brief		A master table, the file of the records of the dictionaries it
+			gives out IDs to.
+@details	Each table is used through the @c ion_mt_ functions, so that
+			catalogs can be kept apart, for example one to a tenant or to
+			a storage device, and each used from its own thread. The
+			functions without a table, such as @ref ion_init_master_table,
+			use @ref ion_master_table_default.
+
+			Dictionary files are named by ID, so tables whose dictionaries
+			share a directory give out IDs above different bases.
+*/
+typedef struct ion_master_table {
+	FILE							*file;							/**< The table file, @c NULL
+																	 while it is closed */
+	char							name[ION_MAX_FILENAME_LENGTH];	/**< Its name */
+	ion_dictionary_id_t				id_base;						/**< The IDs given out are
+																	 above it */
+	ion_dictionary_id_t				next_row;						/**< The first row never given
+																	 out, its ID less the base */
+	ion_dictionary_id_t				free_row;						/**< The last row freed, which is
+																	 given out next, or 0 */
+	ion_boolean_t					batching;						/**< Whether the master row and
+																	 syncs wait for the end of a
+																	 batch */
+#if ION_MASTER_TABLE_DIRECTORY
+	ion_master_table_directory_t	directory;						/**< The table held in memory */
+#endif
+#if ION_MASTER_TABLE_USE_MMAP
+	ion_byte_t						*map;							/**< The table file, mapped to
+																	 be worked on in place, or
+																	 @c NULL to go through the
+																	 file */
+	size_t							map_size;						/**< The bytes mapped, at least
+																	 those of the file */
+	size_t							file_size;						/**< The bytes of the file */
+#endif
+} ion_master_table_t;
+
+/**
+@brief		The master table used by the functions that take none, kept in
+			@ref ION_MASTER_TABLE_FILENAME and giving out IDs from 1.
+*/
+extern ion_master_table_t ion_master_table_default;
+
+/**
+@brief		The next ID the default table gives out, unless one was freed.
+*/
+#define ion_master_table_next_id	(ion_master_table_default.next_row)
+
+/**
+@brief		The file of the default table, @c NULL while it is closed.
+*/
+#define ion_master_table_file		(ion_master_table_default.file)
+
+/**
+@brief		Opens a master table, creating its file if there is none.
+@param		table
+				The table, which must not be open.
+@param		file_name
+				The name of its file, shorter than
+				@ref ION_MAX_FILENAME_LENGTH.
+@param		id_base
+				The IDs it gives out are above this, so that the files of
+				its dictionaries are told apart from those of other tables.
+				It must be the same every time the table is opened.
+@returns	An error code describing the result of the operation,
+			@c err_file_open_error if the name is too long.
+*/
+ion_err_t
+ion_mt_open(
+	ion_master_table_t	*table,
+	const char			*file_name,
+	ion_dictionary_id_t id_base
+);
+
+/**
+@brief		Closes a master table, and the dictionaries it keeps open.
+@see		@ref ion_close_master_table
+*/
+ion_err_t
+ion_mt_close(
+	ion_master_table_t *table
+);
+
+/**
+@see		@ref ion_master_table_begin_batch
+*/
+ion_err_t
+ion_mt_begin_batch(
+	ion_master_table_t *table
+);
+
+/**
+@see		@ref ion_master_table_end_batch
+*/
+ion_err_t
+ion_mt_end_batch(
+	ion_master_table_t *table
+);
+
+/**
+@see		@ref ion_master_table_checkpoint
+*/
+ion_err_t
+ion_mt_checkpoint(
+	ion_master_table_t *table
+);
+
+/**
+@see		@ref ion_master_table_get_info
+*/
+ion_err_t
+ion_mt_get_info(
+	ion_master_table_t		*table,
+	ion_dictionary_info_t	*total,
+	int						*count
+);
+
+/**
+@see		@ref ion_delete_master_table
+*/
+ion_err_t
+ion_mt_delete(
+	ion_master_table_t *table
+);
+
+/**
+@see		@ref ion_master_table_create_dictionary
+*/
+ion_err_t
+ion_mt_create_dictionary(
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size
+);
+
+/**
+@see		@ref ion_master_table_create_dictionary_paged
+*/
+ion_err_t
+ion_mt_create_dictionary_paged(
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_size_t		page_size
+);
+
+/**
+@see		@ref ion_master_table_create_dictionary_from_config
+*/
+ion_err_t
+ion_mt_create_dictionary_from_config(
+	ion_master_table_t				*table,
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config
+);
+
+/**
+@see		@ref ion_lookup_in_master_table
+*/
+ion_err_t
+ion_mt_lookup(
+	ion_master_table_t				*table,
+	ion_dictionary_id_t				id,
+	ion_dictionary_config_info_t	*config
+);
+
+/**
+@see		@ref ion_find_by_use_master_table
+*/
+ion_err_t
+ion_mt_find_by_use(
+	ion_master_table_t				*table,
+	ion_dictionary_config_info_t	*config,
+	ion_dict_use_t					use_type,
+	char							whence
+);
+
+/**
+@see		@ref ion_find_index_master_table
+*/
+ion_err_t
+ion_mt_find_index(
+	ion_master_table_t				*table,
+	ion_dictionary_id_t				primary_id,
+	ion_dictionary_config_info_t	*config
+);
+
+/**
+@see		@ref ion_delete_from_master_table
+*/
+ion_err_t
+ion_mt_delete_from(
+	ion_master_table_t	*table,
+	ion_dictionary_t	*dictionary
+);
+
+/**
+@see		@ref ion_master_table_delete_dictionary
+*/
+ion_err_t
+ion_mt_delete_dictionary(
+	ion_master_table_t	*table,
+	ion_dictionary_t	*dictionary
+);
 
 /**
-@brief		Master table file.
+@brief		Opens a dictionary of a table, sharing it with those who have it
+			open from the same table.
+@see		@ref ion_open_dictionary
 */
-extern FILE *ion_master_table_file;
+ion_err_t
+ion_mt_open_dictionary(
+	ion_master_table_t			*table,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id
+);
 
 /**
-@brief	  Opens the master table.
+@brief	  Opens the default master table.
 @details	Can be safely called multiple times without closing.
 */
 ion_err_t
@@ -94,6 +399,72 @@ ion_close_master_table(
 	void
 );
 
+/**
+@brief		Starts a batch of dictionaries created or deleted together.
+@details	Until the batch ends, each record is written on its own but
+			the master row and any syncs the durability asks for wait, so
+			creating many dictionaries writes little more than their
+			records. Should the batch be cut short, the next ID is found
+			from the records when the table is opened again.
+@returns	@c err_ok, or @c err_illegal_state if the table is not open.
+*/
+ion_err_t
+ion_master_table_begin_batch(
+	void
+);
+
+/**
+@brief		Ends a batch, writing the master row once.
+@details	Closing the table ends a batch still going.
+@returns	An error code describing the result of the operation,
+			@c err_illegal_state if the table was closed under it.
+*/
+ion_err_t
+ion_master_table_end_batch(
+	void
+);
+
+/**
+@brief		Pushes every open dictionary, and the master table, through to
+			storage in one pass, leaving them open.
+@details	Each dictionary writes out what it holds dirty, B+ tree nodes,
+			flat file metadata and file hash pages among them, as
+			@ref dictionary_sync_all does, and the master row of a batch
+			still going is written. The syncs they ask for are put off
+			with @ref ion_fsync_defer and each file is forced once at the
+			end, so a checkpoint costs a flush of what changed and one
+			sync of each file touched, without closing and opening the
+			dictionaries again. No other thread may be using them
+			meanwhile.
+@returns	@c err_ok, the first error of the pushes, or
+			@c err_illegal_state if the table is not open or the calling
+			thread already puts its syncs off.
+*/
+ion_err_t
+ion_master_table_checkpoint(
+	void
+);
+
+/**
+@brief		Sums what the open dictionaries of the master table can tell of
+			their size, as @ref dictionary_get_info_all does, without
+			reading any of their records.
+@details	Only dictionaries open in this process are counted, each once,
+			a dictionary wrapping another through the wrapper. A sum is
+			-1 if one of them cannot tell its part.
+@param		total
+				Receives the sums.
+@param		count
+				Receives how many dictionaries were counted.
+@returns	@c err_ok, the first error of a dictionary, or
+			@c err_illegal_state if the table is not open.
+*/
+ion_err_t
+ion_master_table_get_info(
+	ion_dictionary_info_t	*total,
+	int						*count
+);
+
 /**
 @brief		Deletes the master table.
 */
@@ -133,8 +504,77 @@ ion_master_table_create_dictionary(
 	ion_dictionary_size_t		dictionary_size
 );
 
+/**
+@brief		Creates a dictionary through use of the master table, with the
+			size of its on-disk pages chosen by the caller.
+@details	The page size is kept in the master table record, so
+			@ref ion_open_dictionary opens the dictionary with the same
+			pages again. Implementations that are not built from pages
+			ignore it.
+@param		handler
+				A pointer to an allocated and initialized dictionary handler
+				object that contains all implementation specific data
+				and function pointers.
+@param		dictionary
+				A pointer to an allocated dictionary object, which will be
+				written into when opened.
+@param		key_type
+				The type of key to be used with this dictionary, which
+				determines the key comparison operator.
+@param		key_size
+				The size of the key type to be used with this dictionary.
+@param		value_size
+				The size of the value type to be used with this dictionary.
+@param		dictionary_size
+				The dictionary implementation specific dictionary size
+				parameter.
+@param		page_size
+				The size in bytes of each page, for example to match the
+				block size of the storage device. 0 selects the
+				implementation's default.
+@returns	An error code describing the result of the operation.
+*/
+ion_err_t
+ion_master_table_create_dictionary_paged(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_size_t		page_size
+);
+
+/**
+@brief		Creates a dictionary through use of the master table from a
+			complete configuration.
+@details	Every field except @c id is taken from @p config, so settings
+			such as the page size or the hash function are chosen by the
+			caller and kept in the master table record. @c use_type is
+			recorded as well. On success the assigned id is written back
+			into @p config.
+@param		handler
+				A pointer to an allocated and initialized dictionary handler
+				object that contains all implementation specific data
+				and function pointers.
+@param		dictionary
+				A pointer to an allocated dictionary object, which will be
+				written into when opened.
+@param		config
+				The configuration of the dictionary to create.
+@returns	An error code describing the result of the operation.
+*/
+ion_err_t
+ion_master_table_create_dictionary_from_config(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config
+);
+
 /**
 @brief		Looks up the config of the given id.
+@details	With @ref ION_MASTER_TABLE_DIRECTORY, this and the searches
+			below are answered from memory.
 @param		id
 				The identifier identifying the dictionary metadata in the
 				master table which is to be looked up.
@@ -172,8 +612,30 @@ ion_find_by_use_master_table(
 	char							whence
 );
 
+/**
+@brief		Finds the next secondary index registered on a dictionary.
+@details	Indexes are records whose @c index_of names the dictionary
+			they index, and are found in the order they were created.
+			Starting from a @p config whose @c id is 0, each call finds the
+			next one after @c id.
+@param		primary_id
+				The identifier of the indexed dictionary.
+@param		config
+				The last index found, or one with an @c id of 0 to find the
+				first, which receives the one found.
+@returns	@c err_ok if another index is found, @c err_item_not_found if
+			there are no more, otherwise an error reading the table.
+*/
+ion_err_t
+ion_find_index_master_table(
+	ion_dictionary_id_t				primary_id,
+	ion_dictionary_config_info_t	*config
+);
+
 /**
 @brief		Deletes a dictionary from the master table.
+@details	The secondary indexes registered on it are removed from the
+			table as well.
 @param		dictionary
 				A pointer to the dictionary object to delete (it contains its
 				own identifier info for the master table).
@@ -184,8 +646,29 @@ ion_delete_from_master_table(
 	ion_dictionary_t *dictionary
 );
 
+/**
+@brief		Deletes a dictionary, its files included, and takes it out of
+			the master table.
+@details	Unlike @ref ion_delete_from_master_table, its ID is freed, to
+			be given out to the next dictionary created. The secondary
+			indexes registered on it are removed from the table, their IDs
+			not freed, since their files may outlive it.
+@param		dictionary
+				A pointer to the open dictionary to delete.
+@returns	An error code describing the result of the operation.
+*/
+ion_err_t
+ion_master_table_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
 /**
 @brief		Finds the target dictionary and opens it.
+@details	With @ref ION_MASTER_TABLE_OPEN_CACHE, a dictionary already
+			open is shared: the one given has its own handler, through
+			which closing or deleting it goes back to the cache, and
+			deleting it fails with @c err_illegal_state while others have
+			it open. Those kept open are closed with the master table.
 @param		handler
 				A pointer to an initialized dictionary handler object
 				containing the implementation specific data and function
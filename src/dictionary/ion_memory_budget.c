@@ -0,0 +1,311 @@
+/******************************************************************************/
+/**
+@file
+@brief		A budget of memory shared by the caches of every open
+			dictionary.
+*/
+/******************************************************************************/
+
+#include "ion_memory_budget.h"
+
+/**
+@brief		Takes and gives up the lock on the budget, so engines may join
+			and leave it from several threads.
+*/
+#if defined(ARDUINO)
+#define ION_BUDGET_LOCK()
+#define ION_BUDGET_UNLOCK()
+#else
+#include <pthread.h>
+
+/**
+@brief		Guards the engines and the shares.
+*/
+static pthread_mutex_t ion_budget_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define ION_BUDGET_LOCK()	pthread_mutex_lock(&ion_budget_lock)
+#define ION_BUDGET_UNLOCK() pthread_mutex_unlock(&ion_budget_lock)
+#endif
+
+/**
+@brief		The engines in the budget, the last to join first.
+*/
+static ion_budget_client_t *ion_budget_clients = NULL;
+
+/**
+@brief		The bytes they share, 0 for no budget.
+*/
+static size_t ion_budget_total = ION_MEMORY_BUDGET;
+
+/**
+@brief		Touches since the shares were last worked out.
+*/
+static unsigned int ion_budget_ticks = 0;
+
+/**
+@brief		Works out the share of every engine: its minimum, then the
+			spare bytes in proportion to its weight, but never more than
+			it wants.
+@details	An engine whose proportion would take it past what it wants
+			is given just that, and the rest is shared again between the
+			others, until no one is over.
+@return		@c err_ok, or @c err_out_of_memory if the minimums alone are
+			over the budget, in which case each share is the minimum.
+*/
+static ion_err_t
+ion_budget_share(
+	void
+) {
+	ion_budget_client_t *client;
+	uint64_t			spare;
+	uint64_t			sum_weight;
+	size_t				sum_minimum = 0;
+	ion_boolean_t		capped;
+
+	for (client = ion_budget_clients; NULL != client; client = client->next) {
+		client->share	= (0 == ion_budget_total) ? client->wanted : client->minimum;
+		sum_minimum		+= client->minimum;
+	}
+
+	if (0 == ion_budget_total) {
+		return err_ok;
+	}
+
+	if (sum_minimum > ion_budget_total) {
+		return err_out_of_memory;
+	}
+
+	spare = ion_budget_total - sum_minimum;
+
+	do {
+		sum_weight = 0;
+
+		/* one more than the weight, so an idle engine still has a claim */
+		for (client = ion_budget_clients; NULL != client; client = client->next) {
+			if (client->share < client->wanted) {
+				sum_weight += (uint64_t) client->weight + 1;
+			}
+		}
+
+		if ((0 == sum_weight) || (0 == spare)) {
+			break;
+		}
+
+		capped = boolean_false;
+
+		for (client = ion_budget_clients; NULL != client; client = client->next) {
+			if ((client->share < client->wanted) && ((uint64_t) (client->wanted - client->share) * sum_weight <= spare * ((uint64_t) client->weight + 1))) {
+				spare			-= client->wanted - client->share;
+				client->share	= client->wanted;
+				capped			= boolean_true;
+			}
+		}
+
+		if (!capped) {
+			for (client = ion_budget_clients; NULL != client; client = client->next) {
+				if (client->share < client->wanted) {
+					client->share += (size_t) (spare * ((uint64_t) client->weight + 1) / sum_weight);
+				}
+			}
+		}
+	} while (capped);
+
+	return err_ok;
+}
+
+/**
+@brief		Resizes every engine but @p skip to its share, shrinking
+			before growing.
+@details	A growth that would take the total past the budget, as may
+			happen when an engine fails to shrink, is left for later.
+@return		@c err_ok, or the first error an engine gave when asked to
+			shrink.
+*/
+static ion_err_t
+ion_budget_apply(
+	ion_budget_client_t *skip
+) {
+	ion_budget_client_t *client;
+	ion_err_t			result	= err_ok;
+	size_t				granted = 0;
+	ion_err_t			err;
+
+	for (client = ion_budget_clients; NULL != client; client = client->next) {
+		if ((client != skip) && (client->share < client->granted)) {
+			err = client->resize(client->context, client->share);
+
+			if (err_ok == err) {
+				client->granted = client->share;
+			}
+			else if (err_ok == result) {
+				result = err;
+			}
+		}
+
+		if (client != skip) {
+			granted += client->granted;
+		}
+	}
+
+	if (NULL != skip) {
+		skip->granted	= skip->share;
+		granted			+= skip->granted;
+	}
+
+	for (client = ion_budget_clients; NULL != client; client = client->next) {
+		if ((client == skip) || (client->share <= client->granted)) {
+			continue;
+		}
+
+		if ((0 != ion_budget_total) && (granted + (client->share - client->granted) > ion_budget_total)) {
+			continue;
+		}
+
+		if (err_ok == client->resize(client->context, client->share)) {
+			granted			+= client->share - client->granted;
+			client->granted = client->share;
+		}
+	}
+
+	return result;
+}
+
+ion_err_t
+ion_budget_set(
+	size_t total
+) {
+	ion_err_t	share_err;
+	ion_err_t	apply_err;
+
+	ION_BUDGET_LOCK();
+	ion_budget_total	= total;
+	share_err			= ion_budget_share();
+	apply_err			= ion_budget_apply(NULL);
+	ION_BUDGET_UNLOCK();
+
+	return (err_ok != share_err) ? share_err : apply_err;
+}
+
+size_t
+ion_budget_get(
+	size_t *granted
+) {
+	ion_budget_client_t *client;
+	size_t				total;
+
+	ION_BUDGET_LOCK();
+
+	if (NULL != granted) {
+		*granted = 0;
+
+		for (client = ion_budget_clients; NULL != client; client = client->next) {
+			*granted += client->granted;
+		}
+	}
+
+	total = ion_budget_total;
+	ION_BUDGET_UNLOCK();
+
+	return total;
+}
+
+ion_err_t
+ion_budget_join(
+	ion_budget_client_t *client,
+	size_t				minimum,
+	size_t				wanted,
+	ion_budget_resize_t resize,
+	void				*context
+) {
+	ion_budget_client_t *other;
+	uint64_t			sum_weight	= 0;
+	uint32_t			count		= 0;
+
+	ION_BUDGET_LOCK();
+
+	for (other = ion_budget_clients; NULL != other; other = other->next) {
+		sum_weight += other->weight;
+		count++;
+	}
+
+	client->resize		= resize;
+	client->context		= context;
+	client->minimum		= minimum;
+	client->wanted		= (wanted < minimum) ? minimum : wanted;
+	client->granted		= 0;
+	client->touches		= 0;
+	client->weight		= (0 == count) ? 0 : (uint32_t) (sum_weight / count);
+	client->next		= ion_budget_clients;
+	ion_budget_clients	= client;
+
+	if (err_ok != ion_budget_share()) {
+		ion_budget_clients = client->next;
+		ion_budget_share();
+		ION_BUDGET_UNLOCK();
+		return err_out_of_memory;
+	}
+
+	ion_budget_apply(client);
+	ION_BUDGET_UNLOCK();
+
+	return err_ok;
+}
+
+void
+ion_budget_leave(
+	ion_budget_client_t *client
+) {
+	ion_budget_client_t **link;
+
+	ION_BUDGET_LOCK();
+
+	for (link = &ion_budget_clients; NULL != *link; link = &(*link)->next) {
+		if (client == *link) {
+			*link			= client->next;
+			client->next	= NULL;
+			client->granted = 0;
+			break;
+		}
+	}
+
+	ION_BUDGET_UNLOCK();
+}
+
+void
+ion_budget_touch(
+	ion_budget_client_t *client
+) {
+	ion_boolean_t due;
+
+	ION_BUDGET_LOCK();
+	client->touches++;
+	due = ++ion_budget_ticks >= ION_MEMORY_BUDGET_PERIOD;
+	ION_BUDGET_UNLOCK();
+
+	if (due) {
+		ion_budget_rebalance();
+	}
+}
+
+ion_err_t
+ion_budget_rebalance(
+	void
+) {
+	ion_budget_client_t *client;
+	ion_err_t			share_err;
+	ion_err_t			apply_err;
+
+	ION_BUDGET_LOCK();
+	ion_budget_ticks = 0;
+
+	for (client = ion_budget_clients; NULL != client; client = client->next) {
+		client->weight	= client->weight / 2 + client->touches;
+		client->touches = 0;
+	}
+
+	share_err	= ion_budget_share();
+	apply_err	= ion_budget_apply(NULL);
+	ION_BUDGET_UNLOCK();
+
+	return (err_ok != share_err) ? share_err : apply_err;
+}
@@ -0,0 +1,179 @@
+/******************************************************************************/
+/**
+@file
+@brief		A budget of memory shared by the caches of every open
+			dictionary.
+@details	Engines that keep memory they could do without, such as the
+			node buffer pool of a B+ tree or a record cache, join the
+			budget with the least they need to work and the most they can
+			put to use, and size themselves to what they are granted. The
+			rest of the budget, after every minimum, is shared out in
+			proportion to how often each has been used lately, as counted
+			through @ref ion_budget_touch, so busy dictionaries take memory
+			from quiet ones. Whenever the shares are worked out again,
+			engines over theirs are asked to shrink first and only then
+			are the others grown, so the total granted never goes over
+			the budget while memory changes hands.
+
+			Without a budget, the default, every engine is granted all it
+			asks for, as if there were no budget at all.
+*/
+/******************************************************************************/
+
+#if !defined(ION_MEMORY_BUDGET_H_)
+#define ION_MEMORY_BUDGET_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../key_value/kv_system.h"
+
+/**
+@brief		The bytes shared by all engines until @ref ion_budget_set is
+			called, 0 for no budget.
+*/
+#if !defined(ION_MEMORY_BUDGET)
+#define ION_MEMORY_BUDGET 0
+#endif
+
+/**
+@brief		The touches, over all engines, between two reckonings of the
+			shares.
+*/
+#if !defined(ION_MEMORY_BUDGET_PERIOD)
+#if defined(ARDUINO)
+#define ION_MEMORY_BUDGET_PERIOD 64
+#else
+#define ION_MEMORY_BUDGET_PERIOD 1024
+#endif
+#endif
+
+/**
+@brief		Asks an engine to fit its memory to a new grant.
+@param		context
+				The context the engine joined with.
+@param		bytes
+				The bytes it may now use, never below its minimum.
+@return		@c err_ok once it uses no more than @p bytes. On an error the
+			engine keeps what it had and the grant is left as it was.
+*/
+typedef ion_err_t (*ion_budget_resize_t)(
+	void	*context,
+	size_t	bytes
+);
+
+/**
+@brief		An engine's place in the budget, kept by the engine.
+*/
+typedef struct ion_budget_client {
+	struct ion_budget_client	*next;		/**< The next engine to join */
+	ion_budget_resize_t			resize;		/**< Fits the engine to a grant */
+	void						*context;	/**< Passed to @c resize */
+	size_t						minimum;	/**< Bytes it cannot do with
+											 less than */
+	size_t						wanted;		/**< Bytes past which more do no
+											 good */
+	size_t						granted;	/**< Bytes it may use now */
+	uint32_t					touches;	/**< Uses since the shares were
+											 last worked out */
+	uint32_t					weight;		/**< Uses, halved at each
+											 reckoning */
+	size_t						share;		/**< The grant being worked
+											 out */
+} ion_budget_client_t;
+
+/**
+@brief		Sets the bytes shared by all engines and works out the shares
+			again, shrinking engines at once if the budget went down.
+@param		total
+				The budget, 0 for none.
+@return		@c err_ok, or @c err_out_of_memory if @p total is below the
+			minimums of the engines that have joined, which then keep
+			their minimums.
+*/
+ion_err_t
+ion_budget_set(
+	size_t total
+);
+
+/**
+@brief		Reads the budget and how much of it is granted.
+@param		granted
+				Receives the bytes granted to all engines, if not NULL.
+@return		The budget, 0 for none.
+*/
+size_t
+ion_budget_get(
+	size_t *granted
+);
+
+/**
+@brief		Joins an engine to the budget.
+@details	The engine starts out as busy as the average of those already
+			in the budget, and others may be shrunk to make room for it.
+			Its own @p resize is not called; it sizes itself to
+			@c client->granted once this returns.
+@param		client
+				The engine's place, kept until @ref ion_budget_leave.
+@param		minimum
+				The bytes the engine cannot do with less than.
+@param		wanted
+				The bytes past which more do the engine no good.
+@param		resize
+				Called to fit the engine to a new grant.
+@param		context
+				Passed to @p resize.
+@return		@c err_ok, or @c err_out_of_memory if the budget cannot
+			cover @p minimum on top of the minimums of the others.
+*/
+ion_err_t
+ion_budget_join(
+	ion_budget_client_t *client,
+	size_t				minimum,
+	size_t				wanted,
+	ion_budget_resize_t resize,
+	void				*context
+);
+
+/**
+@brief		Takes an engine out of the budget, leaving its grant to the
+			others at the next reckoning.
+@param		client
+				A place given to @ref ion_budget_join, or one that never
+				joined.
+*/
+void
+ion_budget_leave(
+	ion_budget_client_t *client
+);
+
+/**
+@brief		Counts a use of an engine, working out the shares again once
+			every @ref ION_MEMORY_BUDGET_PERIOD uses.
+@details	Call at the start of an operation, as it may resize any
+			engine, that of @p client included.
+@param		client
+				The engine's place in the budget.
+*/
+void
+ion_budget_touch(
+	ion_budget_client_t *client
+);
+
+/**
+@brief		Works out the shares again from the uses since the last
+			time, resizing the engines whose share changed.
+@return		@c err_ok, or the first error an engine gave when asked to
+			shrink.
+*/
+ion_err_t
+ion_budget_rebalance(
+	void
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_MEMORY_BUDGET_H_ */
@@ -0,0 +1,736 @@
+/******************************************************************************/
+/**
+@file
+@brief		A file based hash table that grows a bucket at a time, using
+			linear hashing.
+@details	Page @c 0 of the bucket file holds the @ref ion_lh_header_t,
+			primary bucket @c b is page <tt>b + 1</tt>, and overflow page
+			@c o is page @c o of the overflow file. Every page starts with
+			the link to the next overflow page of its chain.
+*/
+/******************************************************************************/
+
+#include "linear_hash.h"
+#include "../../file/ion_file.h"
+
+/**
+@brief		Where the record slots of a page start.
+*/
+#define ION_LH_PAGE_HEADER_SIZE sizeof(int32_t)
+
+/**
+@brief		Positions the file holding a page of a chain at @p within
+			bytes into the page.
+@return		The file, or @c NULL if the seek failed.
+*/
+static FILE *
+lh_seek(
+	ion_linear_hash_t	*linear_hash,
+	int					bucket,
+	int					overflow,
+	long				within
+) {
+	FILE	*file;
+	long	offset;
+
+	if (ION_LH_NO_PAGE == overflow) {
+		file	= linear_hash->bucket_file;
+		offset	= ((long) bucket + 1) * linear_hash->header.page_size;
+	}
+	else {
+		file	= linear_hash->overflow_file;
+		offset	= (long) overflow * linear_hash->header.page_size;
+	}
+
+	if (0 != fseek(file, offset + within, SEEK_SET)) {
+		return NULL;
+	}
+
+	return file;
+}
+
+/**
+@brief		Writes @p length bytes at @p within bytes into a page of a
+			chain.
+*/
+static ion_err_t
+lh_write(
+	ion_linear_hash_t	*linear_hash,
+	int					bucket,
+	int					overflow,
+	long				within,
+	void				*data,
+	int					length
+) {
+	FILE *file = lh_seek(linear_hash, bucket, overflow, within);
+
+	if ((NULL == file) || (1 != fwrite(data, length, 1, file))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes a whole page of a chain.
+*/
+static ion_err_t
+lh_write_page(
+	ion_linear_hash_t	*linear_hash,
+	int					bucket,
+	int					overflow,
+	ion_byte_t			*page
+) {
+	return lh_write(linear_hash, bucket, overflow, 0, page, linear_hash->header.page_size);
+}
+
+/**
+@brief		Empties a page buffer, leaving it the last of its chain.
+*/
+static void
+lh_clear_page(
+	ion_linear_hash_t	*linear_hash,
+	ion_byte_t			*page
+) {
+	int32_t link = ION_LH_NO_PAGE;
+
+	memset(page, 0, linear_hash->header.page_size);
+	memcpy(page, &link, sizeof(link));
+}
+
+/**
+@brief		Writes the header of a table to the start of its bucket file.
+*/
+static ion_err_t
+lh_write_header(
+	ion_linear_hash_t *linear_hash
+) {
+	if ((0 != fseek(linear_hash->bucket_file, 0, SEEK_SET)) || (1 != fwrite(&linear_hash->header, sizeof(linear_hash->header), 1, linear_hash->bucket_file))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Takes an unused page for a chain from the overflow file,
+			reusing a freed one if there is any.
+@param		overflow
+				Receives the page, which the caller writes in full.
+*/
+static ion_err_t
+lh_allocate_overflow(
+	ion_linear_hash_t	*linear_hash,
+	int					*overflow
+) {
+	int32_t next;
+	FILE	*file;
+
+	if (ION_LH_NO_PAGE == linear_hash->header.free_overflow) {
+		*overflow = linear_hash->header.overflow_count++;
+		return err_ok;
+	}
+
+	*overflow	= linear_hash->header.free_overflow;
+	file		= lh_seek(linear_hash, 0, *overflow, 0);
+
+	if ((NULL == file) || (1 != fread(&next, sizeof(next), 1, file))) {
+		return err_file_read_error;
+	}
+
+	linear_hash->header.free_overflow = next;
+	return err_ok;
+}
+
+/**
+@brief		Hashes a key with the hash function of a table.
+*/
+static uint32_t
+lh_hash(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key
+) {
+	if (hash_function_modulo == linear_hash->header.hash_function) {
+		int leading = 0;
+
+		memcpy(&leading, key, linear_hash->super.record.key_size < (int) sizeof(leading) ? linear_hash->super.record.key_size : (int) sizeof(leading));
+		return (uint32_t) leading;
+	}
+
+	return dictionary_hash_key(linear_hash->super.key_type, key, linear_hash->super.record.key_size, linear_hash->seed);
+}
+
+/**
+@brief		Returns whether a page has no records left.
+*/
+static ion_boolean_t
+lh_page_is_empty(
+	ion_linear_hash_t	*linear_hash,
+	ion_byte_t			*page
+) {
+	int slot;
+
+	for (slot = 0; slot < linear_hash->records_per_page; slot++) {
+		if (ION_LH_IN_USE == *lh_page_slot(linear_hash, page, slot)) {
+			return boolean_false;
+		}
+	}
+
+	return boolean_true;
+}
+
+/**
+@brief		Splits the bucket at the split pointer.
+
+@details	The records of the bucket that hash to the new bucket with one
+			more bit of their hash are moved to it, and the overflow pages
+			this leaves empty are freed for other chains to reuse.
+*/
+static ion_err_t
+lh_split(
+	ion_linear_hash_t *linear_hash
+) {
+	ion_lh_header_t *header			= &linear_hash->header;
+	int				from			= header->next_split;
+	int				to				= header->bucket_count;
+	int				to_overflow		= ION_LH_NO_PAGE;
+	int				filled			= 0;
+	int				overflow		= ION_LH_NO_PAGE;
+	ion_boolean_t	emptied			= boolean_false;
+	ion_byte_t		*page;
+	ion_err_t		err;
+	int				slot;
+
+	/* with the pointer past it, @c from is addressed with one more bit of the hash */
+	header->bucket_count++;
+	header->next_split++;
+
+	if (header->next_split == (header->initial_buckets << header->level)) {
+		header->level++;
+		header->next_split = 0;
+	}
+
+	lh_clear_page(linear_hash, linear_hash->spare);
+
+	do {
+		ion_boolean_t changed = boolean_false;
+
+		if (NULL == (page = lh_read_page(linear_hash, from, overflow))) {
+			return err_file_read_error;
+		}
+
+		for (slot = 0; slot < linear_hash->records_per_page; slot++) {
+			ion_byte_t *record = lh_page_slot(linear_hash, page, slot);
+
+			if ((ION_LH_IN_USE != *record) || (from == lh_bucket_of(linear_hash, record + 1))) {
+				continue;
+			}
+
+			if (filled == linear_hash->records_per_page) {
+				int		next;
+				int32_t link;
+
+				if (err_ok != (err = lh_allocate_overflow(linear_hash, &next))) {
+					return err;
+				}
+
+				link = next;
+				memcpy(linear_hash->spare, &link, sizeof(link));
+
+				if (err_ok != (err = lh_write_page(linear_hash, to, to_overflow, linear_hash->spare))) {
+					return err;
+				}
+
+				to_overflow = next;
+				filled		= 0;
+				lh_clear_page(linear_hash, linear_hash->spare);
+			}
+
+			memcpy(lh_page_slot(linear_hash, linear_hash->spare, filled++), record, linear_hash->record_size);
+			*record = ION_LH_EMPTY;
+			changed = boolean_true;
+		}
+
+		if (changed) {
+			if (err_ok != (err = lh_write_page(linear_hash, from, overflow, page))) {
+				return err;
+			}
+
+			emptied = emptied || (ION_LH_NO_PAGE != overflow && lh_page_is_empty(linear_hash, page));
+		}
+
+		overflow = lh_page_link(page);
+	} while (ION_LH_NO_PAGE != overflow);
+
+	if (err_ok != (err = lh_write_page(linear_hash, to, to_overflow, linear_hash->spare))) {
+		return err;
+	}
+
+	/* unlink the overflow pages the split left empty, so the chain does not keep them */
+	if (emptied) {
+		int previous = ION_LH_NO_PAGE;
+
+		if (NULL == (page = lh_read_page(linear_hash, from, ION_LH_NO_PAGE))) {
+			return err_file_read_error;
+		}
+
+		overflow = lh_page_link(page);
+
+		while (ION_LH_NO_PAGE != overflow) {
+			int32_t next;
+
+			if (NULL == (page = lh_read_page(linear_hash, from, overflow))) {
+				return err_file_read_error;
+			}
+
+			next = lh_page_link(page);
+
+			if (lh_page_is_empty(linear_hash, page)) {
+				int32_t free_head = header->free_overflow;
+
+				if ((err_ok != (err = lh_write(linear_hash, from, previous, 0, &next, sizeof(next)))) || (err_ok != (err = lh_write(linear_hash, from, overflow, 0, &free_head, sizeof(free_head))))) {
+					return err;
+				}
+
+				header->free_overflow = overflow;
+			}
+			else {
+				previous = overflow;
+			}
+
+			overflow = next;
+		}
+	}
+
+	return lh_write_header(linear_hash);
+}
+
+ion_err_t
+lh_initialize(
+	ion_linear_hash_t	*linear_hash,
+	ion_dictionary_id_t id,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					size,
+	int					page_size,
+	ion_byte_t			hash_function
+) {
+	char			bucket_filename[ION_MAX_FILENAME_LENGTH];
+	char			overflow_filename[ION_MAX_FILENAME_LENGTH];
+	ion_boolean_t	created = boolean_false;
+	int				bucket;
+
+	linear_hash->write_concern				= wc_insert_unique;
+	linear_hash->super.id					= id;
+	linear_hash->super.key_type				= key_type;
+	linear_hash->super.record.key_size		= key_size;
+	linear_hash->super.record.value_size	= value_size;
+	linear_hash->seed						= id;
+	linear_hash->record_size				= 1 + key_size + value_size;
+	linear_hash->page						= NULL;
+	linear_hash->spare						= NULL;
+	linear_hash->overflow_file				= NULL;
+
+	if ((dictionary_get_filename(id, "lhb", bucket_filename) >= ION_MAX_FILENAME_LENGTH) || (dictionary_get_filename(id, "lho", overflow_filename) >= ION_MAX_FILENAME_LENGTH)) {
+		return err_dictionary_initialization_failed;
+	}
+
+	linear_hash->bucket_file = fopen(bucket_filename, "r+b");
+
+	if (NULL != linear_hash->bucket_file) {
+		/* an existing table keeps the layout it was created with */
+		if ((1 != fread(&linear_hash->header, sizeof(linear_hash->header), 1, linear_hash->bucket_file)) || (key_size != linear_hash->header.key_size) || (value_size != linear_hash->header.value_size)) {
+			fclose(linear_hash->bucket_file);
+			linear_hash->bucket_file = NULL;
+			return err_dictionary_initialization_failed;
+		}
+
+		linear_hash->records_per_page	= (linear_hash->header.page_size - ION_LH_PAGE_HEADER_SIZE) / linear_hash->record_size;
+		linear_hash->overflow_file		= fopen(overflow_filename, "r+b");
+	}
+	else {
+		if (NULL == (linear_hash->bucket_file = fopen(bucket_filename, "w+b"))) {
+			return err_file_open_error;
+		}
+
+		created = boolean_true;
+
+		if (0 == page_size) {
+			page_size = ION_LH_DEFAULT_PAGE_SIZE;
+		}
+
+		/* a page holds at least the header, and one record */
+		if (page_size < (int) sizeof(ion_lh_header_t)) {
+			page_size = sizeof(ion_lh_header_t);
+		}
+
+		if (page_size < (int) ION_LH_PAGE_HEADER_SIZE + linear_hash->record_size) {
+			page_size = ION_LH_PAGE_HEADER_SIZE + linear_hash->record_size;
+		}
+
+		linear_hash->records_per_page			= (page_size - ION_LH_PAGE_HEADER_SIZE) / linear_hash->record_size;
+
+		linear_hash->header.key_size			= key_size;
+		linear_hash->header.value_size			= value_size;
+		linear_hash->header.page_size			= page_size;
+		linear_hash->header.hash_function		= hash_function;
+		linear_hash->header.initial_buckets		= 1;
+		linear_hash->header.level				= 0;
+		linear_hash->header.next_split			= 0;
+		linear_hash->header.record_count		= 0;
+		linear_hash->header.overflow_count		= 0;
+		linear_hash->header.free_overflow		= ION_LH_NO_PAGE;
+
+		/* enough buckets to hold the expected size without splitting */
+		if (size > 0) {
+			linear_hash->header.initial_buckets = (int32_t) (((long) size * 100 / ION_LH_SPLIT_PERCENT + linear_hash->records_per_page - 1) / linear_hash->records_per_page);
+
+			if (linear_hash->header.initial_buckets < 1) {
+				linear_hash->header.initial_buckets = 1;
+			}
+		}
+
+		linear_hash->header.bucket_count	= linear_hash->header.initial_buckets;
+		linear_hash->overflow_file			= fopen(overflow_filename, "w+b");
+	}
+
+	linear_hash->page	= ion_alloc(ion_alloc_buffer, linear_hash->header.page_size);
+	linear_hash->spare	= ion_alloc(ion_alloc_buffer, linear_hash->header.page_size);
+
+	if ((NULL == linear_hash->page) || (NULL == linear_hash->spare) || (NULL == linear_hash->overflow_file)) {
+		ion_err_t err = (NULL == linear_hash->overflow_file) ? err_file_open_error : err_out_of_memory;
+
+		lh_close(linear_hash);
+		return err;
+	}
+
+	if (!created) {
+		return err_ok;
+	}
+
+	/* a new table: a page for the header, then its empty buckets */
+	memset(linear_hash->page, 0, linear_hash->header.page_size);
+	memcpy(linear_hash->page, &linear_hash->header, sizeof(linear_hash->header));
+
+	if ((0 != fseek(linear_hash->bucket_file, 0, SEEK_SET)) || (1 != fwrite(linear_hash->page, linear_hash->header.page_size, 1, linear_hash->bucket_file))) {
+		lh_close(linear_hash);
+		return err_file_write_error;
+	}
+
+	lh_clear_page(linear_hash, linear_hash->page);
+
+	for (bucket = 0; bucket < linear_hash->header.bucket_count; bucket++) {
+		if (1 != fwrite(linear_hash->page, linear_hash->header.page_size, 1, linear_hash->bucket_file)) {
+			lh_close(linear_hash);
+			return err_file_write_error;
+		}
+	}
+
+	fflush(linear_hash->bucket_file);
+
+	return err_ok;
+}
+
+ion_err_t
+lh_sync(
+	ion_linear_hash_t *linear_hash
+) {
+	ion_err_t err = lh_write_header(linear_hash);
+
+	if (err_ok == err) {
+		err = ion_fsync_stream(linear_hash->bucket_file);
+	}
+
+	if (err_ok == err) {
+		err = ion_fsync_stream(linear_hash->overflow_file);
+	}
+
+	return err;
+}
+
+ion_err_t
+lh_close(
+	ion_linear_hash_t *linear_hash
+) {
+	ion_err_t err = err_ok;
+
+	if (NULL != linear_hash->bucket_file) {
+		if (NULL != linear_hash->overflow_file) {
+			err = lh_write_header(linear_hash);
+		}
+
+		if (0 != fclose(linear_hash->bucket_file)) {
+			err = err_file_close_error;
+		}
+
+		linear_hash->bucket_file = NULL;
+	}
+	else {
+		err = err_file_close_error;
+	}
+
+	if ((NULL != linear_hash->overflow_file) && (0 != fclose(linear_hash->overflow_file))) {
+		err = err_file_close_error;
+	}
+
+	linear_hash->overflow_file = NULL;
+
+	ion_free(linear_hash->page);
+	ion_free(linear_hash->spare);
+	linear_hash->page	= NULL;
+	linear_hash->spare	= NULL;
+
+	return err;
+}
+
+ion_err_t
+lh_destroy(
+	ion_linear_hash_t *linear_hash
+) {
+	char		filename[ION_MAX_FILENAME_LENGTH];
+	ion_err_t	err = lh_close(linear_hash);
+
+	if (err_ok != err) {
+		return err_dictionary_destruction_error;
+	}
+
+	dictionary_get_filename(linear_hash->super.id, "lhb", filename);
+
+	if (0 != fremove(filename)) {
+		return err_file_delete_error;
+	}
+
+	dictionary_get_filename(linear_hash->super.id, "lho", filename);
+
+	if (0 != fremove(filename)) {
+		return err_file_delete_error;
+	}
+
+	return err_ok;
+}
+
+int
+lh_bucket_of(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key
+) {
+	uint32_t	hash	= lh_hash(linear_hash, key);
+	uint32_t	round	= (uint32_t) linear_hash->header.initial_buckets << linear_hash->header.level;
+	uint32_t	bucket	= hash % round;
+
+	/* buckets before the split pointer have been split this round */
+	if (bucket < (uint32_t) linear_hash->header.next_split) {
+		bucket = hash % (round << 1);
+	}
+
+	return (int) bucket;
+}
+
+ion_byte_t *
+lh_read_page(
+	ion_linear_hash_t	*linear_hash,
+	int					bucket,
+	int					overflow
+) {
+	FILE *file = lh_seek(linear_hash, bucket, overflow, 0);
+
+	if ((NULL == file) || (1 != fread(linear_hash->page, linear_hash->header.page_size, 1, file))) {
+		return NULL;
+	}
+
+	return linear_hash->page;
+}
+
+int
+lh_page_link(
+	ion_byte_t *page
+) {
+	int32_t link;
+
+	memcpy(&link, page, sizeof(link));
+	return link;
+}
+
+ion_byte_t *
+lh_page_slot(
+	ion_linear_hash_t	*linear_hash,
+	ion_byte_t			*page,
+	int					slot
+) {
+	return page + ION_LH_PAGE_HEADER_SIZE + slot * linear_hash->record_size;
+}
+
+ion_err_t
+lh_find_position(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_lh_position_t	*position
+) {
+	ion_byte_t	*page;
+	int			slot;
+
+	position->bucket	= lh_bucket_of(linear_hash, key);
+	position->overflow	= ION_LH_NO_PAGE;
+
+	do {
+		if (NULL == (page = lh_read_page(linear_hash, position->bucket, position->overflow))) {
+			return err_file_read_error;
+		}
+
+		for (slot = 0; slot < linear_hash->records_per_page; slot++) {
+			ion_byte_t *record = lh_page_slot(linear_hash, page, slot);
+
+			if ((ION_LH_IN_USE == *record) && (0 == linear_hash->super.compare(record + 1, key, linear_hash->super.record.key_size))) {
+				position->slot = slot;
+				return err_ok;
+			}
+		}
+
+		position->overflow = lh_page_link(page);
+	} while (ION_LH_NO_PAGE != position->overflow);
+
+	return err_item_not_found;
+}
+
+ion_status_t
+lh_insert(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_lh_position_t	free_slot	= { 0, ION_LH_NO_PAGE, -1 };
+	int					bucket		= lh_bucket_of(linear_hash, key);
+	int					overflow	= ION_LH_NO_PAGE;
+	int					tail;
+	ion_byte_t			*page;
+	ion_byte_t			status		= ION_LH_IN_USE;
+	ion_err_t			err;
+	int					slot;
+	FILE				*file;
+
+	/* walk the whole chain, both for a record to replace and for room */
+	do {
+		if (NULL == (page = lh_read_page(linear_hash, bucket, overflow))) {
+			return ION_STATUS_ERROR(err_file_read_error);
+		}
+
+		for (slot = 0; slot < linear_hash->records_per_page; slot++) {
+			ion_byte_t *record = lh_page_slot(linear_hash, page, slot);
+
+			if (ION_LH_IN_USE != *record) {
+				if (-1 == free_slot.slot) {
+					free_slot.overflow	= overflow;
+					free_slot.slot		= slot;
+				}
+			}
+			else if (0 == linear_hash->super.compare(record + 1, key, linear_hash->super.record.key_size)) {
+				if (wc_update != linear_hash->write_concern) {
+					return ION_STATUS_ERROR(err_duplicate_key);
+				}
+
+				if (err_ok != (err = lh_write(linear_hash, bucket, overflow, record + 1 + linear_hash->super.record.key_size - page, value, linear_hash->super.record.value_size))) {
+					return ION_STATUS_ERROR(err);
+				}
+
+				return ION_STATUS_OK(1);
+			}
+		}
+
+		tail		= overflow;
+		overflow	= lh_page_link(page);
+	} while (ION_LH_NO_PAGE != overflow);
+
+	if (-1 != free_slot.slot) {
+		file = lh_seek(linear_hash, bucket, free_slot.overflow, lh_page_slot(linear_hash, page, free_slot.slot) - page);
+
+		if ((NULL == file) || (1 != fwrite(&status, 1, 1, file)) || (1 != fwrite(key, linear_hash->super.record.key_size, 1, file)) || (1 != fwrite(value, linear_hash->super.record.value_size, 1, file))) {
+			return ION_STATUS_ERROR(err_file_write_error);
+		}
+	}
+	else {
+		/* the chain is full, so it gets another page */
+		int32_t		link;
+		ion_byte_t	*record;
+
+		if (err_ok != (err = lh_allocate_overflow(linear_hash, &overflow))) {
+			return ION_STATUS_ERROR(err);
+		}
+
+		lh_clear_page(linear_hash, linear_hash->page);
+		record	= lh_page_slot(linear_hash, linear_hash->page, 0);
+		*record = ION_LH_IN_USE;
+		memcpy(record + 1, key, linear_hash->super.record.key_size);
+		memcpy(record + 1 + linear_hash->super.record.key_size, value, linear_hash->super.record.value_size);
+		link	= overflow;
+
+		if ((err_ok != (err = lh_write_page(linear_hash, bucket, overflow, linear_hash->page))) || (err_ok != (err = lh_write(linear_hash, bucket, tail, 0, &link, sizeof(link))))) {
+			return ION_STATUS_ERROR(err);
+		}
+	}
+
+	linear_hash->header.record_count++;
+
+	if ((long) linear_hash->header.record_count * 100 > (long) ION_LH_SPLIT_PERCENT * linear_hash->header.bucket_count * linear_hash->records_per_page) {
+		if (err_ok != (err = lh_split(linear_hash))) {
+			return ION_STATUS_CREATE(err, 1);
+		}
+	}
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+lh_update(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_write_concern_t current_write_concern = linear_hash->write_concern;
+
+	linear_hash->write_concern = wc_update;
+
+	ion_status_t status = lh_insert(linear_hash, key, value);
+
+	linear_hash->write_concern = current_write_concern;
+	return status;
+}
+
+ion_status_t
+lh_query(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_lh_position_t	position;
+	ion_err_t			err = lh_find_position(linear_hash, key, &position);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	memcpy(value, lh_page_slot(linear_hash, linear_hash->page, position.slot) + 1 + linear_hash->super.record.key_size, linear_hash->super.record.value_size);
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+lh_delete(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key
+) {
+	ion_lh_position_t	position;
+	ion_byte_t			status	= ION_LH_EMPTY;
+	ion_err_t			err		= lh_find_position(linear_hash, key, &position);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	/* a chain is always walked to its end, so the slot needs no tombstone */
+	if (err_ok != (err = lh_write(linear_hash, position.bucket, position.overflow, lh_page_slot(linear_hash, linear_hash->page, position.slot) - linear_hash->page, &status, 1))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	linear_hash->header.record_count--;
+	return ION_STATUS_OK(1);
+}
@@ -0,0 +1,367 @@
+/******************************************************************************/
+/**
+@file
+@brief		A file based hash table that grows a bucket at a time, using
+			linear hashing.
+@details	Records live in fixed size pages of buckets. A bucket that
+			fills up chains overflow pages, kept in a second file. Once
+			the table is fuller than @ref ION_LH_SPLIT_PERCENT, the
+			bucket at the split pointer is split: its records are
+			rehashed over itself and a new bucket appended to the end of
+			the file, and the pointer moves on. When every bucket of a
+			round has been split the table has doubled and the next
+			round begins. Growth is therefore spread over the inserts,
+			and the files are never rebuilt.
+*/
+/******************************************************************************/
+
+#if !defined(LINEAR_HASH_H_)
+#define LINEAR_HASH_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdio.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+/*edefines file operations for arduino */
+#include "./../../file/SD_stdio_c_iface.h"
+
+/**
+@brief		The size in bytes of a bucket page, used when the dictionary
+			is created with a page size of 0. Each page holds a link to
+			its next overflow page and as many records as fit.
+*/
+#if !defined(ION_LH_DEFAULT_PAGE_SIZE)
+#if defined(ARDUINO)
+#define ION_LH_DEFAULT_PAGE_SIZE 128
+#else
+#define ION_LH_DEFAULT_PAGE_SIZE 512
+#endif
+#endif
+
+/**
+@brief		How full, in percent of the room in the primary bucket pages,
+			the table may get before an insert splits a bucket.
+*/
+#if !defined(ION_LH_SPLIT_PERCENT)
+#define ION_LH_SPLIT_PERCENT 80
+#endif
+
+/**
+@brief		The link of the last page of a chain.
+*/
+#define ION_LH_NO_PAGE		-1
+
+/**
+@brief		The status byte of a free record slot.
+*/
+#define ION_LH_EMPTY		0
+
+/**
+@brief		The status byte of a slot holding a record.
+*/
+#define ION_LH_IN_USE		1
+
+/**
+@brief		The state of a linear hash table, kept at the start of its
+			bucket file.
+*/
+typedef struct {
+	int32_t key_size;			/**< The size of the keys stored */
+	int32_t value_size;			/**< The size of the values stored */
+	int32_t page_size;			/**< The size in bytes of every page */
+	int32_t hash_function;		/**< An @ref ion_hash_function_t */
+	int32_t initial_buckets;	/**< The buckets the table started with */
+	int32_t level;				/**< The number of times the table has
+									 doubled */
+	int32_t next_split;			/**< The next bucket to split */
+	int32_t bucket_count;		/**< The primary buckets in the table */
+	int32_t record_count;		/**< The records in the table */
+	int32_t overflow_count;		/**< The pages in the overflow file */
+	int32_t free_overflow;		/**< The first of a chain of unused
+									 overflow pages */
+} ion_lh_header_t;
+
+/**
+@brief		A slot of a bucket page.
+*/
+typedef struct {
+	int		bucket;		/**< The primary bucket of the chain */
+	int		overflow;	/**< The overflow page of the chain holding the
+							 slot, or @ref ION_LH_NO_PAGE for the primary
+							 page */
+	int		slot;		/**< The slot within the page */
+} ion_lh_position_t;
+
+/**
+@brief		Struct used to maintain an instance of a linear hash table.
+*/
+typedef struct linear_hash {
+	ion_dictionary_parent_t super;
+	ion_write_concern_t		write_concern;		/**< The current @p write_concern
+												 level of the table */
+	uint32_t				seed;				/**< The seed given to the
+												 seeded hash, taken from the
+												 dictionary id */
+	ion_lh_header_t			header;				/**< The state of the table,
+												 written back to its file */
+	int						record_size;		/**< The bytes of a slot: status,
+												 key and value */
+	int						records_per_page;	/**< The slots of a page */
+	FILE					*bucket_file;		/**< The header and the primary
+												 bucket pages */
+	FILE					*overflow_file;		/**< The overflow pages */
+	ion_byte_t				*page;				/**< The page last read,
+												 allocated once so operations
+												 never allocate */
+	ion_byte_t				*spare;				/**< A second page, for the new
+												 bucket while splitting */
+} ion_linear_hash_t;
+
+/**
+@brief		Opens a linear hash table, creating its files if they do not
+			exist yet.
+
+@details	A table found on disk keeps its own page size, hash function
+			and buckets; those given here are only used to create a new
+			one. Its key and value sizes must match those given.
+
+@param		linear_hash
+				The table to initialize.
+@param		id
+				The id of the dictionary, which names the files and seeds
+				the hash.
+@param		key_type
+				The type of key that is being stored in the table.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		size
+				The number of records the table is expected to hold at
+				first, which sets its initial buckets. It grows past it.
+@param		page_size
+				The size in bytes of each page, 0 for
+				@ref ION_LH_DEFAULT_PAGE_SIZE.
+@param		hash_function
+				The @ref ion_hash_function_t to hash keys with.
+@return		The status of the initialization.
+*/
+ion_err_t
+lh_initialize(
+	ion_linear_hash_t	*linear_hash,
+	ion_dictionary_id_t id,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					size,
+	int					page_size,
+	ion_byte_t			hash_function
+);
+
+/**
+@brief		Writes the state of a table to its files and pushes them
+			through to storage.
+
+@param		linear_hash
+				The table to sync.
+@return		The status of the sync.
+*/
+ion_err_t
+lh_sync(
+	ion_linear_hash_t *linear_hash
+);
+
+/**
+@brief		Writes the state of a table to its file and closes it.
+
+@param		linear_hash
+				The table to close.
+@return		The status of the close.
+*/
+ion_err_t
+lh_close(
+	ion_linear_hash_t *linear_hash
+);
+
+/**
+@brief		Closes a table and deletes its files.
+
+@param		linear_hash
+				The table to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+lh_destroy(
+	ion_linear_hash_t *linear_hash
+);
+
+/**
+@brief		Inserts a record, or replaces its value when the write
+			concern is @c wc_update.
+
+@details	Splits a bucket afterwards if the table has become too full.
+
+@param		linear_hash
+				The table to insert into.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		The status of the insert.
+*/
+ion_status_t
+lh_insert(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@param		linear_hash
+				The table to update.
+@param		key
+				The key of the record.
+@param		value
+				The new value of the record.
+@return		The status of the update.
+*/
+ion_status_t
+lh_update(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value stored under a key.
+
+@param		linear_hash
+				The table to search.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value of the record.
+@return		The status of the query.
+*/
+ion_status_t
+lh_query(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Deletes the record stored under a key.
+
+@param		linear_hash
+				The table to delete from.
+@param		key
+				The key of the record.
+@return		The status of the deletion.
+*/
+ion_status_t
+lh_delete(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key
+);
+
+/**
+@brief		Returns the primary bucket a key belongs to.
+
+@param		linear_hash
+				The table the key is stored in.
+@param		key
+				The key.
+@return		The index of the bucket.
+*/
+int
+lh_bucket_of(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key
+);
+
+/**
+@brief		Finds the slot holding a key.
+
+@param		linear_hash
+				The table to search.
+@param		key
+				The key to search for.
+@param		position
+				Receives the slot of the record.
+@return		@c err_ok, @c err_item_not_found, or the error reading the
+			table.
+*/
+ion_err_t
+lh_find_position(
+	ion_linear_hash_t	*linear_hash,
+	ion_key_t			key,
+	ion_lh_position_t	*position
+);
+
+/**
+@brief		Reads a page of a bucket chain into the page buffer of a
+			table.
+
+@param		linear_hash
+				The table to read.
+@param		bucket
+				The primary bucket of the chain.
+@param		overflow
+				The overflow page to read, or @ref ION_LH_NO_PAGE for the
+				primary page of @p bucket.
+@return		The page, valid until the next call into the table, or
+			@c NULL if it could not be read.
+*/
+ion_byte_t *
+lh_read_page(
+	ion_linear_hash_t	*linear_hash,
+	int					bucket,
+	int					overflow
+);
+
+/**
+@brief		Returns the link to the next overflow page of a page.
+
+@param		page
+				The page, as returned by @ref lh_read_page.
+@return		The next page, or @ref ION_LH_NO_PAGE.
+*/
+int
+lh_page_link(
+	ion_byte_t *page
+);
+
+/**
+@brief		Returns a slot of a page.
+
+@param		linear_hash
+				The table the page belongs to.
+@param		page
+				The page, as returned by @ref lh_read_page.
+@param		slot
+				The slot.
+@return		The status byte of the slot, followed by its key and value.
+*/
+ion_byte_t *
+lh_page_slot(
+	ion_linear_hash_t	*linear_hash,
+	ion_byte_t			*page,
+	int					slot
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LINEAR_HASH_H_ */
@@ -0,0 +1,376 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a file based hash table that grows by linear
+			hashing.
+*/
+/******************************************************************************/
+
+#include "linear_hash_dictionary_handler.h"
+
+/**
+@brief		Moves a cursor from its position to the next record that
+			satisfies its predicate, which is left in the page buffer of
+			the table.
+@return		@c cs_valid_data, or @c cs_end_of_results once the cursor is
+			past its last bucket.
+*/
+static ion_cursor_status_t
+lhdict_scan(
+	ion_lhdict_cursor_t *cursor
+) {
+	ion_linear_hash_t	*linear_hash	= (ion_linear_hash_t *) cursor->super.dictionary->instance;
+	ion_lh_position_t	*position		= &cursor->position;
+	ion_byte_t			*page;
+
+	while (position->bucket <= cursor->last_bucket) {
+		if (NULL == (page = lh_read_page(linear_hash, position->bucket, position->overflow))) {
+			return cs_end_of_results;
+		}
+
+		for (; position->slot < linear_hash->records_per_page; position->slot++) {
+			ion_byte_t *record = lh_page_slot(linear_hash, page, position->slot);
+
+			if ((ION_LH_IN_USE == *record) && (boolean_true == test_record_predicate(&cursor->super, record + 1, record + 1 + linear_hash->super.record.key_size))) {
+				return cs_valid_data;
+			}
+		}
+
+		position->slot		= 0;
+		position->overflow	= lh_page_link(page);
+
+		if (ION_LH_NO_PAGE == position->overflow) {
+			position->bucket++;
+		}
+	}
+
+	return cs_end_of_results;
+}
+
+ion_cursor_status_t
+lhdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_lhdict_cursor_t *lhdict_cursor	= (ion_lhdict_cursor_t *) cursor;
+	ion_linear_hash_t	*linear_hash	= (ion_linear_hash_t *) cursor->dictionary->instance;
+	ion_byte_t			*page			= linear_hash->page;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	if (cs_cursor_initialized == cursor->status) {
+		/* the record was found by the find, but the table may have been used since */
+		if (NULL == (page = lh_read_page(linear_hash, lhdict_cursor->position.bucket, lhdict_cursor->position.overflow))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active == cursor->status) {
+		lhdict_cursor->position.slot++;
+
+		if (cs_end_of_results == lhdict_scan(lhdict_cursor)) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else {
+		return cs_invalid_cursor;
+	}
+
+	ion_byte_t *slot = lh_page_slot(linear_hash, page, lhdict_cursor->position.slot);
+
+	memcpy(record->key, slot + 1, linear_hash->super.record.key_size);
+	memcpy(record->value, slot + 1 + linear_hash->super.record.key_size, linear_hash->super.record.value_size);
+
+	return cursor->status;
+}
+
+ion_err_t
+lhdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_linear_hash_t	*linear_hash	= (ion_linear_hash_t *) dictionary->instance;
+	ion_key_size_t		key_size		= linear_hash->super.record.key_size;
+	ion_lhdict_cursor_t *lhdict_cursor;
+
+	if (NULL == (lhdict_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_lhdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	*cursor								= (ion_dict_cursor_t *) lhdict_cursor;
+	(*cursor)->dictionary				= dictionary;
+	(*cursor)->status					= cs_cursor_uninitialized;
+	(*cursor)->destroy					= lhdict_destroy_cursor;
+	(*cursor)->next_batch				= NULL;
+	(*cursor)->next						= lhdict_next;
+
+	lhdict_cursor->position.bucket		= 0;
+	lhdict_cursor->position.overflow	= ION_LH_NO_PAGE;
+	lhdict_cursor->position.slot		= 0;
+	lhdict_cursor->last_bucket			= linear_hash->header.bucket_count - 1;
+
+	if (NULL == ((*cursor)->predicate = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			/* the predicate may be destroyed while the cursor is open, so keep a copy of its key */
+			if (NULL == ((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+
+			/* keys are unique, and only the chain of their bucket can hold them */
+			lhdict_cursor->position.bucket	= lh_bucket_of(linear_hash, predicate->statement.equality.equality_value);
+			lhdict_cursor->last_bucket		= lhdict_cursor->position.bucket;
+			break;
+		}
+
+		case predicate_range: {
+			if (NULL == ((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			if (NULL == ((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			break;
+		}
+
+		case predicate_predicate: {
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			break;
+		}
+
+		case predicate_all_records: {
+			break;
+		}
+
+		default: {
+			ion_free((*cursor)->predicate);
+			ion_free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	(*cursor)->status = (cs_valid_data == lhdict_scan(lhdict_cursor)) ? cs_cursor_initialized : cs_end_of_results;
+
+	return err_ok;
+}
+
+/**
+@brief		Creates, or opens, the linear hash instance of a dictionary.
+
+@param		page_size
+				The size of the pages of a new table, 0 for the default.
+@param		hash_function
+				The @ref ion_hash_function_t of a new table.
+
+@see		lhdict_create_dictionary for the other parameters.
+*/
+static ion_err_t
+lhdict_open_table(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_size_t		page_size,
+	ion_byte_t					hash_function,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_linear_hash_t	*linear_hash;
+	ion_err_t			err;
+
+	if (NULL == (linear_hash = ion_alloc(ion_alloc_other, sizeof(ion_linear_hash_t)))) {
+		return err_out_of_memory;
+	}
+
+	linear_hash->super.compare = compare;
+
+	err = lh_initialize(linear_hash, id, key_type, key_size, value_size, dictionary_size, page_size, hash_function);
+
+	if (err_ok != err) {
+		ion_free(linear_hash);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) linear_hash;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_err_t
+lhdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return lhdict_open_table(id, key_type, key_size, value_size, dictionary_size, 0, hash_function_seeded, compare, handler, dictionary);
+}
+
+ion_err_t
+lhdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return lhdict_open_table(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, config->page_size, config->hash_function, compare, handler, dictionary);
+}
+
+ion_err_t
+lhdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = lh_close((ion_linear_hash_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_err_t
+lhdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = lh_destroy((ion_linear_hash_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+lhdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return lh_insert((ion_linear_hash_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+lhdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return lh_query((ion_linear_hash_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+lhdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return lh_update((ion_linear_hash_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+lhdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return lh_delete((ion_linear_hash_t *) dictionary->instance, key);
+}
+
+void
+lhdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+/**
+@brief		Pushes every write of a linear hash dictionary through to storage.
+*/
+static ion_err_t
+lhdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return lh_sync((ion_linear_hash_t *) dictionary->instance);
+}
+
+/**
+@brief		Tells the size of a linear hash dictionary, see
+			@ref dictionary_get_info. Its primary and overflow pages are
+			its pages.
+*/
+static ion_err_t
+lhdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_linear_hash_t *linear_hash = (ion_linear_hash_t *) dictionary->instance;
+
+	info->record_count	= linear_hash->header.record_count;
+	info->pages			= (long) linear_hash->header.bucket_count + linear_hash->header.overflow_count;
+	info->file_bytes	= (info->pages + 1) * linear_hash->header.page_size;
+	info->memory_bytes	= 2L * linear_hash->header.page_size;
+
+	return err_ok;
+}
+
+void
+lhdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= lhdict_insert;
+	handler->create_dictionary	= lhdict_create_dictionary;
+	handler->get				= lhdict_query;
+	handler->update				= lhdict_update;
+	handler->find				= lhdict_find;
+	handler->remove				= lhdict_delete;
+	handler->delete_dictionary	= lhdict_delete_dictionary;
+	handler->open_dictionary	= lhdict_open_dictionary;
+	handler->close_dictionary	= lhdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= lhdict_sync_dictionary;
+	handler->get_info			= lhdict_get_info;
+	handler->bulk_load			= NULL;
+}
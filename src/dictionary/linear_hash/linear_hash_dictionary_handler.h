@@ -0,0 +1,255 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a file based hash table that grows by linear
+			hashing.
+*/
+/******************************************************************************/
+
+#if !defined(LINEAR_HASH_DICTIONARY_HANDLER_H_)
+#define LINEAR_HASH_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "linear_hash.h"
+
+/**
+@brief		A cursor over a linear hash table.
+@details	Equality cursors walk the chain of their key's bucket, others
+			walk every bucket in turn. A split while the cursor is open
+			may move records past it or back in front of it.
+*/
+typedef struct lhdict_cursor {
+	ion_dict_cursor_t	super;			/**< Cursor supertype this type
+										 inherits from */
+	ion_lh_position_t	position;		/**< The slot of the current
+										 record */
+	int					last_bucket;	/**< The last bucket to walk */
+} ion_lhdict_cursor_t;
+
+/**
+@brief		Registers the linear hash handler.
+
+@details	Registers functions for handlers. This only needs to be called
+			once for each type of dictionary that is present.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+lhdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Inserts a record into a linear hash dictionary.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+lhdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value stored under a key.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+lhdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Creates a linear hash dictionary.
+
+@param		id
+				The identifier of the dictionary, which names its files and
+				seeds its hash.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The number of records the dictionary is expected to hold at
+				first. It grows past it.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+lhdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes the record stored under a key.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+lhdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a linear hash dictionary and its files.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+lhdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+lhdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+lhdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a linear hash cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+lhdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a linear hash cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+lhdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opens a linear hash dictionary from its files.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened. Its page size and hash function are only used if
+				the files do not exist yet.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		The status of opening the dictionary.
+*/
+ion_err_t
+lhdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes a linear hash dictionary, keeping its files.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		The status of closing the dictionary.
+*/
+ion_err_t
+lhdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LINEAR_HASH_DICTIONARY_HANDLER_H_ */
@@ -0,0 +1,943 @@
+/******************************************************************************/
+/**
+@file
+@brief		A log-structured merge tree, made of a skiplist memtable and
+			sorted flat file runs.
+@details	The manifest, file @c "<id>.lsm", holds the
+			@ref ion_lsm_header_t of the tree and then the
+			@ref ion_lsm_run_info_t of each run, newest first. It is
+			rewritten whenever the runs change, before the runs a merge
+			replaced are removed.
+*/
+/******************************************************************************/
+
+#include "lsm.h"
+
+/**
+@brief		The size of a value with its kind byte, as the memtable and the
+			runs store it.
+*/
+#define ION_LSM_ENTRY_SIZE(lsm)		((lsm)->super.record.value_size + 1)
+
+/**
+@brief		The size of a key followed by an entry.
+*/
+#define ION_LSM_RECORD_SIZE(lsm)	((lsm)->super.record.key_size + ION_LSM_ENTRY_SIZE(lsm))
+
+/**
+@brief		The dictionary id of a run of some number.
+*/
+static ion_dictionary_id_t
+lsm_run_id(
+	ion_lsm_t	*lsm,
+	int32_t		number
+) {
+	return lsm->run_id + (ion_dictionary_id_t) (number % ION_LSM_RUN_IDS);
+}
+
+/**
+@brief		Starts an empty memtable.
+*/
+static ion_err_t
+lsm_start_memtable(
+	ion_lsm_t *lsm
+) {
+	lsm->memtable.super.compare = lsm->super.compare;
+
+	return sl_initialize(&lsm->memtable, lsm->super.key_type, lsm->super.record.key_size, ION_LSM_ENTRY_SIZE(lsm), 0, 1, 4);
+}
+
+/**
+@brief		Rewrites the manifest of a tree from its header and runs.
+*/
+static ion_err_t
+lsm_save(
+	ion_lsm_t *lsm
+) {
+	char	filename[ION_MAX_FILENAME_LENGTH];
+	FILE	*file;
+	int		i;
+
+	dictionary_get_filename(lsm->super.id, "lsm", filename);
+
+	if (NULL == (file = fopen(filename, "wb"))) {
+		return err_file_open_error;
+	}
+
+	if (1 != fwrite(&lsm->header, sizeof(lsm->header), 1, file)) {
+		fclose(file);
+		return err_file_write_error;
+	}
+
+	for (i = 0; i < lsm->header.run_count; i++) {
+		if (1 != fwrite(&lsm->runs[i].info, sizeof(lsm->runs[i].info), 1, file)) {
+			fclose(file);
+			return err_file_write_error;
+		}
+	}
+
+	if (0 != fclose(file)) {
+		return err_file_close_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Opens the flat file of a run, in sorted mode.
+
+@param		fresh
+				Whether the run is new, so that any rows a file of its id
+				holds are stale and dropped.
+*/
+static ion_err_t
+lsm_open_run(
+	ion_lsm_t		*lsm,
+	ion_lsm_run_t	*run,
+	ion_boolean_t	fresh
+) {
+	ion_dictionary_id_t id = lsm_run_id(lsm, run->info.number);
+	ion_flat_file_t		*file;
+	ion_err_t			err;
+
+	if (NULL == (file = ion_alloc(ion_alloc_other, sizeof(ion_flat_file_t)))) {
+		return err_out_of_memory;
+	}
+
+	file->super.compare = lsm->super.compare;
+	err					= flat_file_initialize(file, id, lsm->super.key_type, lsm->super.record.key_size, ION_LSM_ENTRY_SIZE(lsm), 0);
+
+	/* left behind by a tree that was never destroyed */
+	if ((err_ok == err) && fresh && (file->eof_position > file->start_of_data)) {
+		if (err_ok == (err = flat_file_destroy(file))) {
+			err = flat_file_initialize(file, id, lsm->super.key_type, lsm->super.record.key_size, ION_LSM_ENTRY_SIZE(lsm), 0);
+		}
+	}
+
+	if (err_ok != err) {
+		ion_free(file);
+		return err;
+	}
+
+	file->sorted_mode	= boolean_true;
+	run->file			= file;
+
+	return err_ok;
+}
+
+/**
+@brief		Closes the flat file of a run, keeping it.
+*/
+static ion_err_t
+lsm_close_run(
+	ion_lsm_run_t *run
+) {
+	ion_err_t err = flat_file_close(run->file);
+
+	ion_free(run->file);
+	run->file = NULL;
+
+	return err;
+}
+
+/**
+@brief		Closes the flat file of a run and removes it.
+*/
+static ion_err_t
+lsm_destroy_run(
+	ion_lsm_run_t *run
+) {
+	ion_err_t err = flat_file_destroy(run->file);
+
+	ion_free(run->file);
+	run->file = NULL;
+
+	return err;
+}
+
+/**
+@brief		Opens a new, empty run at some level, under the next run
+			number whose id no run of the tree holds.
+*/
+static ion_err_t
+lsm_new_run(
+	ion_lsm_t		*lsm,
+	ion_lsm_run_t	*run,
+	int32_t			level
+) {
+	int i;
+
+	do {
+		run->info.number = lsm->header.next_run++;
+
+		for (i = 0; i < lsm->header.run_count; i++) {
+			if (lsm_run_id(lsm, lsm->runs[i].info.number) == lsm_run_id(lsm, run->info.number)) {
+				break;
+			}
+		}
+	} while (i < lsm->header.run_count);
+
+	run->info.level		= level;
+	run->info.records	= 0;
+
+	return lsm_open_run(lsm, run, boolean_true);
+}
+
+/**
+@brief		Reads the manifest of a tree and opens its runs.
+
+@param		check
+				Whether the sizes of the manifest must match those of the
+				tree, which are otherwise taken from it.
+@return		@c err_file_open_error if there is no manifest.
+*/
+static ion_err_t
+lsm_load(
+	ion_lsm_t		*lsm,
+	ion_boolean_t	check
+) {
+	char				filename[ION_MAX_FILENAME_LENGTH];
+	FILE				*file;
+	ion_lsm_header_t	header;
+	ion_err_t			err;
+	int					i;
+
+	dictionary_get_filename(lsm->super.id, "lsm", filename);
+
+	if (NULL == (file = fopen(filename, "rb"))) {
+		return err_file_open_error;
+	}
+
+	if ((1 != fread(&header, sizeof(header), 1, file)) || (header.run_count < 0) || (header.run_count > ION_LSM_MAX_RUNS) || (check && ((header.key_size != lsm->header.key_size) || (header.value_size != lsm->header.value_size)))) {
+		fclose(file);
+		return err_dictionary_initialization_failed;
+	}
+
+	lsm->header.next_run	= header.next_run;
+	lsm->header.run_count	= 0;
+
+	for (i = 0; i < header.run_count; i++) {
+		if (1 != fread(&lsm->runs[i].info, sizeof(lsm->runs[i].info), 1, file)) {
+			err = err_file_read_error;
+			break;
+		}
+
+		if (err_ok != (err = lsm_open_run(lsm, &lsm->runs[i], boolean_false))) {
+			break;
+		}
+
+		lsm->header.run_count++;
+	}
+
+	fclose(file);
+
+	if (lsm->header.run_count < header.run_count) {
+		while (lsm->header.run_count > 0) {
+			lsm_close_run(&lsm->runs[--lsm->header.run_count]);
+		}
+
+		return err;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Removes the runs and the manifest of a tree.
+*/
+static ion_err_t
+lsm_destroy_runs(
+	ion_lsm_t *lsm
+) {
+	char		filename[ION_MAX_FILENAME_LENGTH];
+	ion_err_t	err = err_ok;
+	ion_err_t	run_err;
+
+	while (lsm->header.run_count > 0) {
+		run_err = lsm_destroy_run(&lsm->runs[--lsm->header.run_count]);
+
+		if (err_ok == err) {
+			err = run_err;
+		}
+	}
+
+	dictionary_get_filename(lsm->super.id, "lsm", filename);
+	fremove(filename);
+
+	return err;
+}
+
+/**
+@brief		Frees the memory of a tree, bar the runs.
+*/
+static void
+lsm_free(
+	ion_lsm_t *lsm
+) {
+	sl_destroy(&lsm->memtable);
+	ion_free(lsm->entry);
+	ion_free(lsm->batch);
+	lsm->entry	= NULL;
+	lsm->batch	= NULL;
+}
+
+/**
+@brief		Sets up the memory of an empty tree.
+
+@see		lsm_initialize for the parameters.
+*/
+static ion_err_t
+lsm_setup(
+	ion_lsm_t				*lsm,
+	ion_dictionary_id_t		id,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	memtable_records
+) {
+	ion_err_t err;
+
+	if ((0 == memtable_records) || ((ion_dictionary_size_t) -1 == memtable_records)) {
+		memtable_records = ION_LSM_MEMTABLE_RECORDS;
+	}
+
+	/* the ids of the runs name their files, so they must keep to 7 digits */
+	if ((long) ION_LSM_RUN_ID_BASE + ((long) id + 1) * ION_LSM_RUN_IDS > 10000000L) {
+		return err_dictionary_initialization_failed;
+	}
+
+	lsm->super.id					= id;
+	lsm->super.key_type				= key_type;
+	lsm->super.record.key_size		= key_size;
+	lsm->super.record.value_size	= value_size;
+	lsm->run_id						= ION_LSM_RUN_ID_BASE + id * ION_LSM_RUN_IDS;
+	lsm->memtable_records			= memtable_records;
+	lsm->header.key_size			= key_size;
+	lsm->header.value_size			= value_size;
+	lsm->header.next_run			= 0;
+	lsm->header.run_count			= 0;
+	lsm->flushes					= 0;
+	lsm->merges						= 0;
+	lsm->entry						= ion_alloc(ion_alloc_buffer, ION_LSM_ENTRY_SIZE(lsm));
+	lsm->batch						= ion_alloc(ion_alloc_buffer, (size_t) ION_LSM_WRITE_BATCH * ION_LSM_RECORD_SIZE(lsm));
+
+	if ((NULL == lsm->entry) || (NULL == lsm->batch)) {
+		ion_free(lsm->entry);
+		ion_free(lsm->batch);
+		return err_out_of_memory;
+	}
+
+	if (err_ok != (err = lsm_start_memtable(lsm))) {
+		ion_free(lsm->entry);
+		ion_free(lsm->batch);
+		return err;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+lsm_initialize(
+	ion_lsm_t				*lsm,
+	ion_dictionary_id_t		id,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	memtable_records
+) {
+	ion_err_t err = lsm_setup(lsm, id, key_type, key_size, value_size, memtable_records);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	/* the runs of an earlier tree of this id would otherwise be left behind */
+	if (err_ok == lsm_load(lsm, boolean_false)) {
+		lsm_destroy_runs(lsm);
+	}
+
+	lsm->header.key_size	= key_size;
+	lsm->header.value_size	= value_size;
+	lsm->header.next_run	= 0;
+
+	return err_ok;
+}
+
+ion_err_t
+lsm_open(
+	ion_lsm_t				*lsm,
+	ion_dictionary_id_t		id,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	memtable_records
+) {
+	ion_err_t err = lsm_setup(lsm, id, key_type, key_size, value_size, memtable_records);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	err = lsm_load(lsm, boolean_true);
+
+	/* as other dictionaries do, a tree that is not there is opened empty */
+	if ((err_ok != err) && (err_file_open_error != err)) {
+		lsm_free(lsm);
+		return err;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+lsm_close(
+	ion_lsm_t *lsm
+) {
+	ion_err_t	err = lsm_flush(lsm);
+	ion_err_t	run_err;
+
+	if (err_ok == err) {
+		err = lsm_save(lsm);
+	}
+
+	while (lsm->header.run_count > 0) {
+		run_err = lsm_close_run(&lsm->runs[--lsm->header.run_count]);
+
+		if (err_ok == err) {
+			err = run_err;
+		}
+	}
+
+	lsm_free(lsm);
+
+	return err;
+}
+
+ion_err_t
+lsm_destroy(
+	ion_lsm_t *lsm
+) {
+	ion_err_t err = lsm_destroy_runs(lsm);
+
+	lsm_free(lsm);
+
+	return err;
+}
+
+/**
+@brief		Copies the record a source is on into its buffer, or marks it
+			as read through.
+*/
+static ion_err_t
+lsm_source_read(
+	ion_lsm_t			*lsm,
+	ion_lsm_source_t	*source
+) {
+	ion_key_size_t		key_size = lsm->super.record.key_size;
+	ion_flat_file_row_t row;
+	ion_err_t			err;
+
+	source->valid = boolean_false;
+
+	if (NULL == source->run) {
+		if (NULL != source->node) {
+			memcpy(source->record, source->node->key, key_size);
+			memcpy(source->record + key_size, source->node->value, ION_LSM_ENTRY_SIZE(lsm));
+			source->valid = boolean_true;
+		}
+
+		return err_ok;
+	}
+
+	while (source->next < source->rows) {
+		if (err_ok != (err = flat_file_read_row(source->run->file, source->next++, &row))) {
+			return err;
+		}
+
+		if (ION_FLAT_FILE_STATUS_OCCUPIED == row.row_status) {
+			memcpy(source->record, row.key, key_size);
+			memcpy(source->record + key_size, row.value, ION_LSM_ENTRY_SIZE(lsm));
+			source->valid = boolean_true;
+			break;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Puts a source on its first record whose key is not less than
+			@p key, or its first record if @p key is @c NULL.
+*/
+static ion_err_t
+lsm_source_seek(
+	ion_lsm_t			*lsm,
+	ion_lsm_source_t	*source,
+	ion_key_t			key
+) {
+	ion_flat_file_row_t row;
+	ion_fpos_t			location;
+	ion_err_t			err;
+
+	if (NULL == source->run) {
+		source->node = (NULL == key) ? lsm->memtable.head->next[0] : sl_lower_bound(&lsm->memtable, key);
+		return lsm_source_read(lsm, source);
+	}
+
+	source->rows	= (source->run->file->eof_position - source->run->file->start_of_data) / source->run->file->row_size;
+	source->next	= 0;
+
+	if ((NULL != key) && (source->rows > 0)) {
+		/* the last key not greater than the one sought, which the seek passes if it is less */
+		err = flat_file_binary_search(source->run->file, key, &location);
+
+		if ((err_ok != err) && (err_item_not_found != err)) {
+			return err;
+		}
+
+		/* with every key greater, the run is read from its start */
+		if ((err_ok == err) && (location >= 0)) {
+			if (err_ok != (err = flat_file_read_row(source->run->file, location, &row))) {
+				return err;
+			}
+
+			source->next = (lsm->super.compare(row.key, key, lsm->super.record.key_size) < 0) ? location + 1 : location;
+		}
+	}
+
+	return lsm_source_read(lsm, source);
+}
+
+ion_err_t
+lsm_merge_start(
+	ion_lsm_t		*lsm,
+	ion_lsm_merge_t *merge,
+	ion_boolean_t	memtable,
+	int				first,
+	int				last,
+	ion_key_t		key
+) {
+	int			record_size = ION_LSM_RECORD_SIZE(lsm);
+	int			sources		= (memtable ? 1 : 0) + (last - first);
+	ion_err_t	err;
+	int			i;
+
+	merge->lsm		= lsm;
+	merge->count	= 0;
+
+	if (NULL == (merge->records = ion_alloc(ion_alloc_buffer, (size_t) (sources + 1) * record_size))) {
+		return err_out_of_memory;
+	}
+
+	if (memtable) {
+		merge->source[merge->count].run		= NULL;
+		merge->source[merge->count].record	= merge->records;
+		merge->count++;
+	}
+
+	for (i = first; i < last; i++) {
+		merge->source[merge->count].run		= &lsm->runs[i];
+		merge->source[merge->count].record	= merge->records + merge->count * record_size;
+		merge->count++;
+	}
+
+	merge->current = merge->records + merge->count * record_size;
+
+	for (i = 0; i < merge->count; i++) {
+		if (err_ok != (err = lsm_source_seek(lsm, &merge->source[i], key))) {
+			ion_free(merge->records);
+			merge->records = NULL;
+			return err;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+lsm_merge_next(
+	ion_lsm_merge_t *merge
+) {
+	ion_lsm_t			*lsm		= merge->lsm;
+	ion_key_size_t		key_size	= lsm->super.record.key_size;
+	ion_lsm_source_t	*source;
+	ion_err_t			err;
+	int					best		= -1;
+	int					i;
+
+	/* on ties the newest source, the first, is kept */
+	for (i = 0; i < merge->count; i++) {
+		if (merge->source[i].valid && ((-1 == best) || (lsm->super.compare(merge->source[i].record, merge->source[best].record, key_size) < 0))) {
+			best = i;
+		}
+	}
+
+	if (-1 == best) {
+		return err_item_not_found;
+	}
+
+	memcpy(merge->current, merge->source[best].record, ION_LSM_RECORD_SIZE(lsm));
+
+	for (i = 0; i < merge->count; i++) {
+		source = &merge->source[i];
+
+		if (!source->valid || (0 != lsm->super.compare(source->record, merge->current, key_size))) {
+			continue;
+		}
+
+		if (NULL == source->run) {
+			source->node = source->node->next[0];
+		}
+
+		if (err_ok != (err = lsm_source_read(lsm, source))) {
+			return err;
+		}
+	}
+
+	return err_ok;
+}
+
+void
+lsm_merge_stop(
+	ion_lsm_merge_t *merge
+) {
+	ion_free(merge->records);
+	merge->records	= NULL;
+	merge->count	= 0;
+}
+
+/**
+@brief		Appends the staged records of a write batch to a run.
+*/
+static ion_err_t
+lsm_write_batch(
+	ion_lsm_t		*lsm,
+	ion_lsm_run_t	*run,
+	int				*staged
+) {
+	ion_status_t status;
+
+	if (0 == *staged) {
+		return err_ok;
+	}
+
+	status				= flat_file_insert_batch(run->file, lsm->batch, lsm->batch + ION_LSM_WRITE_BATCH * lsm->super.record.key_size, *staged);
+	run->info.records	+= status.count;
+	*staged				= 0;
+
+	return status.error;
+}
+
+/**
+@brief		Writes every record read off a merge to an empty run.
+
+@param		drop
+				Whether to leave tombstones out, which may only be done if
+				no run older than those merged is left.
+*/
+static ion_err_t
+lsm_write_run(
+	ion_lsm_t		*lsm,
+	ion_lsm_merge_t *merge,
+	ion_lsm_run_t	*run,
+	ion_boolean_t	drop
+) {
+	ion_key_size_t	key_size	= lsm->super.record.key_size;
+	int				entry_size	= ION_LSM_ENTRY_SIZE(lsm);
+	int				staged		= 0;
+	ion_err_t		err;
+
+	while (err_ok == (err = lsm_merge_next(merge))) {
+		if (drop && (ION_LSM_TOMBSTONE == merge->current[key_size])) {
+			continue;
+		}
+
+		memcpy(lsm->batch + staged * key_size, merge->current, key_size);
+		memcpy(lsm->batch + ION_LSM_WRITE_BATCH * key_size + staged * entry_size, merge->current + key_size, entry_size);
+
+		if ((ION_LSM_WRITE_BATCH == ++staged) && (err_ok != (err = lsm_write_batch(lsm, run, &staged)))) {
+			return err;
+		}
+	}
+
+	if (err_item_not_found != err) {
+		return err;
+	}
+
+	return lsm_write_batch(lsm, run, &staged);
+}
+
+/**
+@brief		Merges the runs from @p first up to @p last into one run a
+			level above the oldest of them, which takes their place.
+*/
+static ion_err_t
+lsm_merge_runs(
+	ion_lsm_t	*lsm,
+	int			first,
+	int			last
+) {
+	ion_lsm_run_t	merged[ION_LSM_MAX_RUNS];
+	ion_lsm_run_t	run;
+	ion_lsm_merge_t merge;
+	ion_err_t		err;
+	ion_err_t		run_err;
+	int				kept;
+	int				i;
+
+	if (err_ok != (err = lsm_new_run(lsm, &run, lsm->runs[last - 1].info.level + 1))) {
+		return err;
+	}
+
+	if (err_ok == (err = lsm_merge_start(lsm, &merge, boolean_false, first, last, NULL))) {
+		err = lsm_write_run(lsm, &merge, &run, last == lsm->header.run_count);
+		lsm_merge_stop(&merge);
+	}
+
+	if (err_ok != err) {
+		lsm_destroy_run(&run);
+		return err;
+	}
+
+	memcpy(merged, &lsm->runs[first], (last - first) * sizeof(ion_lsm_run_t));
+
+	/* every record may have been a tombstone, which leaves no run */
+	kept = (run.info.records > 0) ? 1 : 0;
+
+	if (kept) {
+		lsm->runs[first] = run;
+	}
+	else {
+		lsm_destroy_run(&run);
+	}
+
+	memmove(&lsm->runs[first + kept], &lsm->runs[last], (lsm->header.run_count - last) * sizeof(ion_lsm_run_t));
+	lsm->header.run_count -= last - first - kept;
+	lsm->merges++;
+
+	/* the manifest names the new run before the old ones go */
+	err = lsm_save(lsm);
+
+	for (i = 0; i < last - first; i++) {
+		run_err = lsm_destroy_run(&merged[i]);
+
+		if (err_ok == err) {
+			err = run_err;
+		}
+	}
+
+	return err;
+}
+
+/**
+@brief		Merges each level that holds @ref ION_LSM_FANOUT runs into the
+			next, and every run into one if there are still too many.
+*/
+static ion_err_t
+lsm_maintain(
+	ion_lsm_t *lsm
+) {
+	ion_err_t	err;
+	int			first;
+	int			last;
+
+	for (first = 0; first < lsm->header.run_count; first = last) {
+		for (last = first; last < lsm->header.run_count && lsm->runs[last].info.level == lsm->runs[first].info.level; last++) {}
+
+		if (last - first >= ION_LSM_FANOUT) {
+			if (err_ok != (err = lsm_merge_runs(lsm, first, last))) {
+				return err;
+			}
+
+			/* the merged run may fill the level above */
+			last = first;
+		}
+	}
+
+	if (lsm->header.run_count >= ION_LSM_MAX_RUNS) {
+		return lsm_merge_runs(lsm, 0, lsm->header.run_count);
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+lsm_flush(
+	ion_lsm_t *lsm
+) {
+	ion_lsm_run_t	run;
+	ion_lsm_merge_t merge;
+	ion_err_t		err;
+
+	if (0 == lsm->memtable.count) {
+		return err_ok;
+	}
+
+	if ((lsm->header.run_count >= ION_LSM_MAX_RUNS) && (err_ok != (err = lsm_merge_runs(lsm, 0, lsm->header.run_count)))) {
+		return err;
+	}
+
+	if (err_ok != (err = lsm_new_run(lsm, &run, 0))) {
+		return err;
+	}
+
+	if (err_ok == (err = lsm_merge_start(lsm, &merge, boolean_true, 0, 0, NULL))) {
+		err = lsm_write_run(lsm, &merge, &run, 0 == lsm->header.run_count);
+		lsm_merge_stop(&merge);
+	}
+
+	if (err_ok != err) {
+		lsm_destroy_run(&run);
+		return err;
+	}
+
+	if (run.info.records > 0) {
+		memmove(&lsm->runs[1], &lsm->runs[0], lsm->header.run_count * sizeof(ion_lsm_run_t));
+		lsm->runs[0] = run;
+		lsm->header.run_count++;
+
+		if (err_ok != (err = lsm_save(lsm))) {
+			return err;
+		}
+	}
+	else {
+		lsm_destroy_run(&run);
+	}
+
+	sl_destroy(&lsm->memtable);
+
+	if (err_ok != (err = lsm_start_memtable(lsm))) {
+		return err;
+	}
+
+	lsm->flushes++;
+
+	return lsm_maintain(lsm);
+}
+
+ion_err_t
+lsm_compact(
+	ion_lsm_t *lsm
+) {
+	ion_err_t err = lsm_flush(lsm);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	/* the oldest run never holds tombstones, so a lone run is already compact */
+	if (lsm->header.run_count > 1) {
+		return lsm_merge_runs(lsm, 0, lsm->header.run_count);
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes an entry to the memtable, flushing it once it is full.
+*/
+static ion_status_t
+lsm_put(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_byte_t	*entry
+) {
+	ion_status_t	status = sl_update(&lsm->memtable, key, entry);
+	ion_err_t		err;
+
+	if (err_ok != status.error) {
+		return status;
+	}
+
+	if ((lsm->memtable.count >= lsm->memtable_records) && (err_ok != (err = lsm_flush(lsm)))) {
+		return ION_STATUS_CREATE(err, 1);
+	}
+
+	return ION_STATUS_OK(1);
+}
+
+/**
+@brief		Reads the newest entry of a key into @c lsm->entry, which may be
+			a tombstone.
+*/
+static ion_status_t
+lsm_lookup(
+	ion_lsm_t	*lsm,
+	ion_key_t	key
+) {
+	ion_status_t	status = sl_query(&lsm->memtable, key, lsm->entry);
+	int				i;
+
+	for (i = 0; (err_item_not_found == status.error) && (i < lsm->header.run_count); i++) {
+		status = flat_file_get(lsm->runs[i].file, key, lsm->entry);
+	}
+
+	return status;
+}
+
+ion_status_t
+lsm_insert(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	lsm->entry[0] = ION_LSM_LIVE;
+	memcpy(lsm->entry + 1, value, lsm->super.record.value_size);
+
+	return lsm_put(lsm, key, lsm->entry);
+}
+
+ion_status_t
+lsm_query(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	ion_status_t status = lsm_lookup(lsm, key);
+
+	if (err_ok != status.error) {
+		return status;
+	}
+
+	if (ION_LSM_TOMBSTONE == lsm->entry[0]) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	memcpy(value, lsm->entry + 1, lsm->super.record.value_size);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+lsm_update(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	return lsm_insert(lsm, key, value);
+}
+
+ion_status_t
+lsm_delete(
+	ion_lsm_t	*lsm,
+	ion_key_t	key
+) {
+	ion_status_t status = lsm_lookup(lsm, key);
+
+	if (err_ok != status.error) {
+		return status;
+	}
+
+	if (ION_LSM_TOMBSTONE == lsm->entry[0]) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	/* with no runs under it, the memtable holds the only copy */
+	if (0 == lsm->header.run_count) {
+		return sl_delete(&lsm->memtable, key);
+	}
+
+	lsm->entry[0] = ION_LSM_TOMBSTONE;
+
+	return lsm_put(lsm, key, lsm->entry);
+}
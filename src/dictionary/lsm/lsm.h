@@ -0,0 +1,437 @@
+/******************************************************************************/
+/**
+@file
+@brief		A log-structured merge tree, made of a skiplist memtable and
+			sorted flat file runs.
+@details	Inserts, updates and deletes only write to the memtable, an
+			in-memory skiplist, so none of them reads or rewrites the disk.
+			Once the memtable holds its quota of records, it is written out
+			in key order as a new run: a flat file in sorted mode, whose
+			fence index and Bloom filter let a lookup skip the runs without
+			its key and read a single block of the others.
+
+			Runs are kept newest first, each with a level. A flushed run is
+			at level 0, and once @ref ION_LSM_FANOUT runs share a level they
+			are merged into one run of the next level, so the tree holds a
+			logarithmic number of runs and every record is rewritten once a
+			level. The newest version of a key wins: a delete writes a
+			tombstone, which hides the key in older runs until a merge
+			reaching the oldest run drops both.
+
+			Each record is stored with a leading kind byte, which tells a
+			value from a tombstone, so the values of the memtable and the
+			runs are one byte longer than the dictionary's. Keys are unique;
+			an insert of a key already there replaces its value.
+*/
+/******************************************************************************/
+
+#if !defined(LSM_H_)
+#define LSM_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdio.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../skip_list/skip_list.h"
+#include "../flat_file/flat_file.h"
+
+#include "../../key_value/kv_system.h"
+
+/* redefines file operations for arduino */
+#include "./../../file/SD_stdio_c_iface.h"
+
+/**
+@brief		How many records the memtable holds before it is flushed to a
+			run, when the dictionary is created with a size of 0.
+*/
+#if !defined(ION_LSM_MEMTABLE_RECORDS)
+#if defined(ARDUINO)
+#define ION_LSM_MEMTABLE_RECORDS 32
+#else
+#define ION_LSM_MEMTABLE_RECORDS 4096
+#endif
+#endif
+
+/**
+@brief		How many runs of one level are merged into a run of the next.
+			Larger fanouts rewrite records less often, at the cost of more
+			runs for a lookup to pass.
+*/
+#if !defined(ION_LSM_FANOUT)
+#define ION_LSM_FANOUT 4
+#endif
+
+/**
+@brief		The most runs a tree holds. Should the levels ever need more,
+			every run is merged into one.
+*/
+#if !defined(ION_LSM_MAX_RUNS)
+#if defined(ARDUINO)
+#define ION_LSM_MAX_RUNS 8
+#else
+#define ION_LSM_MAX_RUNS 32
+#endif
+#endif
+
+/**
+@brief		How many records are staged for each append to a run.
+*/
+#if !defined(ION_LSM_WRITE_BATCH)
+#if defined(ARDUINO)
+#define ION_LSM_WRITE_BATCH 4
+#else
+#define ION_LSM_WRITE_BATCH 64
+#endif
+#endif
+
+/**
+@brief		The dictionary ids set aside for the runs of each tree. The
+			runs of dictionary @c id are numbered from
+			@ref ION_LSM_RUN_ID_BASE plus @c id times this, and reuse those
+			ids in turn.
+*/
+#if !defined(ION_LSM_RUN_IDS)
+#define ION_LSM_RUN_IDS 256
+#endif
+
+/**
+@brief		The first dictionary id given to runs. Run ids name their
+			files, so they must keep to 7 digits.
+*/
+#if !defined(ION_LSM_RUN_ID_BASE)
+#define ION_LSM_RUN_ID_BASE 0x400000
+#endif
+
+/**
+@brief		The kind byte of a tombstone.
+*/
+#define ION_LSM_TOMBSTONE	0
+
+/**
+@brief		The kind byte of a record holding a value.
+*/
+#define ION_LSM_LIVE		1
+
+/**
+@brief		The state of a tree, kept at the start of its manifest file,
+			followed by a @ref ion_lsm_run_info_t per run.
+*/
+typedef struct {
+	int32_t key_size;	/**< The size of the keys stored */
+	int32_t value_size;	/**< The size of the values stored */
+	int32_t next_run;	/**< The number of the next run written */
+	int32_t run_count;	/**< The runs of the tree */
+} ion_lsm_header_t;
+
+/**
+@brief		What the manifest holds of a run.
+*/
+typedef struct {
+	int32_t number;		/**< Which run this is, counted over the life of
+						 the tree, which picks its id */
+	int32_t level;		/**< How many merges its records went through */
+	int32_t records;	/**< The records in the run, tombstones included */
+} ion_lsm_run_info_t;
+
+/**
+@brief		A run of a tree.
+*/
+typedef struct {
+	ion_lsm_run_info_t	info;	/**< Its entry in the manifest */
+	ion_flat_file_t		*file;	/**< The sorted flat file holding it */
+} ion_lsm_run_t;
+
+/**
+@brief		Struct used to maintain an instance of a log-structured merge
+			tree.
+*/
+typedef struct lsm {
+	ion_dictionary_parent_t super;
+	ion_dictionary_id_t		run_id;		/**< The id of run number 0 */
+	ion_dictionary_size_t	memtable_records;	/**< How many records the
+												 memtable holds before it
+												 is flushed */
+	ion_skiplist_t			memtable;	/**< The newest records, each value
+										 led by its kind byte */
+	ion_lsm_header_t		header;		/**< The state of the tree, written
+										 back to its manifest */
+	ion_lsm_run_t			runs[ION_LSM_MAX_RUNS];	/**< The runs, newest
+													 first, their levels
+													 never decreasing */
+	ion_byte_t				*entry;		/**< Room for a kind byte and a
+										 value */
+	ion_byte_t				*batch;		/**< Room for the keys and then the
+										 entries of a write batch */
+	unsigned long			flushes;	/**< Memtables written out as runs */
+	unsigned long			merges;		/**< Merges of runs made */
+} ion_lsm_t;
+
+/**
+@brief		Where a merge is in one of the memtable and the runs it reads.
+*/
+typedef struct {
+	ion_lsm_run_t	*run;		/**< The run read, or @c NULL for the
+								 memtable */
+	ion_sl_node_t	*node;		/**< The memtable node of the record */
+	ion_fpos_t		next;		/**< The row of the run to read next */
+	ion_fpos_t		rows;		/**< How many rows the run has */
+	ion_boolean_t	valid;		/**< Whether @p record holds a record */
+	ion_byte_t		*record;	/**< The current record, key then
+								 entry */
+} ion_lsm_source_t;
+
+/**
+@brief		A merge of the records of the memtable and some runs, in key
+			order, each key read once and from the newest source holding
+			it.
+*/
+typedef struct {
+	ion_lsm_t			*lsm;		/**< The tree merged */
+	int					count;		/**< The sources merged */
+	ion_lsm_source_t	source[ION_LSM_MAX_RUNS + 1];	/**< The sources,
+														 newest first */
+	ion_byte_t			*records;	/**< Room for the record of each source,
+									 then the current one */
+	ion_byte_t			*current;	/**< The record last read off the
+									 merge, key then entry */
+} ion_lsm_merge_t;
+
+/**
+@brief		Creates an empty tree, dropping any runs of an earlier one of
+			the same id.
+
+@param		lsm
+				The tree to initialize, whose @c super.compare is set.
+@param		id
+				The id of the dictionary, which names the manifest and
+				numbers the runs.
+@param		key_type
+				The type of key that is being stored in the tree.
+@param		key_size
+				The size of key that is being stored in the tree.
+@param		value_size
+				The size of value that is being stored in the tree.
+@param		memtable_records
+				How many records the memtable holds before it is flushed,
+				0 or -1 for @ref ION_LSM_MEMTABLE_RECORDS.
+@return		The status of the initialization, which fails if the ids of
+			the runs of @p id would pass 7 digits.
+*/
+ion_err_t
+lsm_initialize(
+	ion_lsm_t				*lsm,
+	ion_dictionary_id_t		id,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	memtable_records
+);
+
+/**
+@brief		Opens a tree closed with @ref lsm_close, from its manifest, or
+			an empty one if there is none.
+
+@see		lsm_initialize for the parameters, whose sizes must match those
+			the tree was created with.
+@return		The status of the opening, @c err_dictionary_initialization_failed
+			if the sizes do not match.
+*/
+ion_err_t
+lsm_open(
+	ion_lsm_t				*lsm,
+	ion_dictionary_id_t		id,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	memtable_records
+);
+
+/**
+@brief		Writes the memtable out and closes the tree, which can be
+			opened again with @ref lsm_open.
+
+@param		lsm
+				The tree to close.
+@return		The status of the closing.
+*/
+ion_err_t
+lsm_close(
+	ion_lsm_t *lsm
+);
+
+/**
+@brief		Frees a tree and removes its manifest and runs.
+
+@param		lsm
+				The tree to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+lsm_destroy(
+	ion_lsm_t *lsm
+);
+
+/**
+@brief		Stores a record, replacing any value of its key.
+
+@details	Only the memtable is written, unless it is then full and
+			flushed.
+
+@param		lsm
+				The tree to write to.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		The status of the write, with a count of 1.
+*/
+ion_status_t
+lsm_insert(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_value_t value
+);
+
+/**
+@brief		Looks up the value of a key, in the memtable and then the runs
+			from the newest.
+
+@param		lsm
+				The tree to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value.
+@return		The status of the query, @c err_item_not_found if the key is
+			not there or was deleted.
+*/
+ion_status_t
+lsm_query(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_value_t value
+);
+
+/**
+@brief		Sets the value of a key, inserting it if it is not there.
+
+@see		lsm_insert, which it is the same as.
+*/
+ion_status_t
+lsm_update(
+	ion_lsm_t	*lsm,
+	ion_key_t	key,
+	ion_value_t value
+);
+
+/**
+@brief		Deletes a key.
+
+@details	The key is looked up, so that a delete of a key that is not
+			there can be told apart. A key held by a run is hidden by a
+			tombstone in the memtable, and one only held by the memtable,
+			with no runs under it, is dropped from it.
+
+@param		lsm
+				The tree to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+lsm_delete(
+	ion_lsm_t	*lsm,
+	ion_key_t	key
+);
+
+/**
+@brief		Writes the memtable out as a run, if it holds any records, and
+			merges the levels that are then full.
+
+@param		lsm
+				The tree to flush.
+@return		The status of the flush.
+*/
+ion_err_t
+lsm_flush(
+	ion_lsm_t *lsm
+);
+
+/**
+@brief		Flushes the memtable and merges every run into one, which
+			holds no tombstones.
+
+@param		lsm
+				The tree to compact.
+@return		The status of the compaction.
+*/
+ion_err_t
+lsm_compact(
+	ion_lsm_t *lsm
+);
+
+/**
+@brief		Starts a merge over the memtable, if asked, and some runs.
+
+@param		lsm
+				The tree to read.
+@param		merge
+				The merge to start, allocated by the caller.
+@param		memtable
+				Whether to read the memtable, as the newest source.
+@param		first
+				The index of the newest run to read.
+@param		last
+				One past the index of the oldest run to read.
+@param		key
+				The key to start from, or @c NULL to read every record.
+@return		The status of the start. The merge holds memory only if it
+			is @c err_ok.
+*/
+ion_err_t
+lsm_merge_start(
+	ion_lsm_t		*lsm,
+	ion_lsm_merge_t *merge,
+	ion_boolean_t	memtable,
+	int				first,
+	int				last,
+	ion_key_t		key
+);
+
+/**
+@brief		Reads the next key of a merge into @c merge->current.
+
+@details	Of the sources holding the key, the record of the newest is
+			read, tombstones included, and the others skipped.
+
+@param		merge
+				The merge to read.
+@return		@c err_ok, @c err_item_not_found once every source is read,
+			or the error of a run that failed to read.
+*/
+ion_err_t
+lsm_merge_next(
+	ion_lsm_merge_t *merge
+);
+
+/**
+@brief		Frees the memory of a merge.
+
+@param		merge
+				A merge that was started.
+*/
+void
+lsm_merge_stop(
+	ion_lsm_merge_t *merge
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LSM_H_ */
@@ -0,0 +1,371 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a log-structured merge tree.
+*/
+/******************************************************************************/
+
+#include "lsm_dictionary_handler.h"
+
+/**
+@brief		Reads records off the merge of a cursor until one satisfies its
+			predicate, which is left as the current record of the merge.
+@return		@c cs_valid_data, or @c cs_end_of_results once no record left
+			can.
+*/
+static ion_cursor_status_t
+lsmdict_scan(
+	ion_lsmdict_cursor_t *cursor
+) {
+	ion_lsm_t		*lsm		= (ion_lsm_t *) cursor->super.dictionary->instance;
+	ion_key_size_t	key_size	= lsm->super.record.key_size;
+	ion_predicate_t *predicate	= cursor->super.predicate;
+	ion_byte_t		*record		= cursor->merge.current;
+
+	while (err_ok == lsm_merge_next(&cursor->merge)) {
+		/* the merge is in key order, so nothing past the key or the upper bound can match */
+		if ((predicate_equality == predicate->type) && (0 != lsm->super.compare(record, predicate->statement.equality.equality_value, key_size))) {
+			break;
+		}
+
+		if ((predicate_range == predicate->type) && (0 < lsm->super.compare(record, predicate->statement.range.upper_bound, key_size))) {
+			break;
+		}
+
+		if ((ION_LSM_LIVE == record[key_size]) && (boolean_true == test_record_predicate(&cursor->super, record, record + key_size + 1))) {
+			return cs_valid_data;
+		}
+	}
+
+	return cs_end_of_results;
+}
+
+ion_cursor_status_t
+lsmdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_lsmdict_cursor_t	*lsmdict_cursor = (ion_lsmdict_cursor_t *) cursor;
+	ion_lsm_t				*lsm			= (ion_lsm_t *) cursor->dictionary->instance;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active == cursor->status) {
+		/* keys are unique, so an equality cursor has nothing past its first record */
+		if ((predicate_equality == cursor->predicate->type) || (cs_end_of_results == lsmdict_scan(lsmdict_cursor))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else {
+		return cs_invalid_cursor;
+	}
+
+	memcpy(record->key, lsmdict_cursor->merge.current, lsm->super.record.key_size);
+	memcpy(record->value, lsmdict_cursor->merge.current + lsm->super.record.key_size + 1, lsm->super.record.value_size);
+
+	return cursor->status;
+}
+
+ion_err_t
+lsmdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_lsm_t				*lsm		= (ion_lsm_t *) dictionary->instance;
+	ion_key_size_t			key_size	= lsm->super.record.key_size;
+	ion_lsmdict_cursor_t	*lsmdict_cursor;
+	ion_key_t				start		= NULL;
+	ion_err_t				err;
+
+	if (NULL == (lsmdict_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_lsmdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	*cursor					= (ion_dict_cursor_t *) lsmdict_cursor;
+	(*cursor)->dictionary	= dictionary;
+	(*cursor)->status		= cs_cursor_uninitialized;
+	(*cursor)->destroy		= lsmdict_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
+	(*cursor)->next			= lsmdict_next;
+
+	if (NULL == ((*cursor)->predicate = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			/* the predicate may be destroyed while the cursor is open, so keep a copy of its key */
+			if (NULL == ((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+			start = (*cursor)->predicate->statement.equality.equality_value;
+			break;
+		}
+
+		case predicate_range: {
+			if (NULL == ((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			if (NULL == ((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			start = (*cursor)->predicate->statement.range.lower_bound;
+			break;
+		}
+
+		case predicate_predicate: {
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			break;
+		}
+
+		case predicate_all_records: {
+			break;
+		}
+
+		default: {
+			ion_free((*cursor)->predicate);
+			ion_free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	if (err_ok != (err = lsm_merge_start(lsm, &lsmdict_cursor->merge, boolean_true, 0, lsm->header.run_count, start))) {
+		(*cursor)->predicate->destroy(&(*cursor)->predicate);
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err;
+	}
+
+	(*cursor)->status = (cs_valid_data == lsmdict_scan(lsmdict_cursor)) ? cs_cursor_initialized : cs_end_of_results;
+
+	return err_ok;
+}
+
+/**
+@brief		Creates, or opens, the log-structured merge tree instance of a
+			dictionary.
+
+@param		open
+				Whether to open the tree from its manifest, rather than
+				create an empty one.
+
+@see		lsmdict_create_dictionary for the other parameters.
+*/
+static ion_err_t
+lsmdict_open_tree(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_boolean_t				open,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_lsm_t	*lsm;
+	ion_err_t	err;
+
+	if (NULL == (lsm = ion_alloc(ion_alloc_other, sizeof(ion_lsm_t)))) {
+		return err_out_of_memory;
+	}
+
+	lsm->super.compare	= compare;
+
+	err					= open ? lsm_open(lsm, id, key_type, key_size, value_size, dictionary_size) : lsm_initialize(lsm, id, key_type, key_size, value_size, dictionary_size);
+
+	if (err_ok != err) {
+		ion_free(lsm);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) lsm;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_err_t
+lsmdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return lsmdict_open_tree(id, key_type, key_size, value_size, dictionary_size, boolean_false, compare, handler, dictionary);
+}
+
+ion_err_t
+lsmdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return lsmdict_open_tree(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, boolean_true, compare, handler, dictionary);
+}
+
+ion_err_t
+lsmdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = lsm_close((ion_lsm_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_err_t
+lsmdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = lsm_destroy((ion_lsm_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+lsmdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return lsm_insert((ion_lsm_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+lsmdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return lsm_query((ion_lsm_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+lsmdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return lsm_update((ion_lsm_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+lsmdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return lsm_delete((ion_lsm_t *) dictionary->instance, key);
+}
+
+void
+lsmdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	lsm_merge_stop(&((ion_lsmdict_cursor_t *) *cursor)->merge);
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+/**
+@brief		Pushes every write of a LSM tree dictionary through to storage.
+*/
+static ion_err_t
+lsmdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	/* the memtable is the only part not yet in a run */
+	return lsm_flush((ion_lsm_t *) dictionary->instance);
+}
+
+/**
+@brief		Tells the size of a log-structured merge tree dictionary, see
+			@ref dictionary_get_info. The rows of its runs are its pages;
+			how many records are left once the tombstones among them and
+			the memtable are merged is not known without merging them.
+*/
+static ion_err_t
+lsmdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_lsm_t		*lsm = (ion_lsm_t *) dictionary->instance;
+	ion_flat_file_t *run;
+	int				i;
+
+	info->pages			= 0;
+	info->file_bytes	= (long) (sizeof(ion_lsm_header_t) + lsm->header.run_count * sizeof(ion_lsm_run_info_t));
+	info->memory_bytes	= (long) lsm->memtable.arena_total;
+
+	for (i = 0; i < lsm->header.run_count; i++) {
+		run					= lsm->runs[i].file;
+		info->pages			+= lsm->runs[i].info.records;
+		info->file_bytes	+= (long) run->eof_position;
+		info->memory_bytes	+= (long) (run->num_buffered * run->row_size);
+	}
+
+	return err_ok;
+}
+
+void
+lsmdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= lsmdict_insert;
+	handler->create_dictionary	= lsmdict_create_dictionary;
+	handler->get				= lsmdict_query;
+	handler->update				= lsmdict_update;
+	handler->find				= lsmdict_find;
+	handler->remove				= lsmdict_delete;
+	handler->delete_dictionary	= lsmdict_delete_dictionary;
+	handler->open_dictionary	= lsmdict_open_dictionary;
+	handler->close_dictionary	= lsmdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= lsmdict_sync_dictionary;
+	handler->get_info			= lsmdict_get_info;
+	handler->bulk_load			= NULL;
+}
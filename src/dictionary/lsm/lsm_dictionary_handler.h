@@ -0,0 +1,258 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a log-structured merge tree.
+*/
+/******************************************************************************/
+
+#if !defined(LSM_DICTIONARY_HANDLER_H_)
+#define LSM_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "lsm.h"
+
+/**
+@brief		A cursor over a log-structured merge tree.
+@details	The memtable and every run are merged in key order, from the
+			lower bound of an equality or range predicate, and tombstones
+			skipped. A write that flushes the memtable, or merges runs,
+			invalidates the cursors open on the tree.
+*/
+typedef struct lsmdict_cursor {
+	ion_dict_cursor_t	super;	/**< Cursor supertype this type inherits
+								 from */
+	ion_lsm_merge_t		merge;	/**< The merge of the memtable and the
+								 runs, whose current record is the one
+								 returned next */
+} ion_lsmdict_cursor_t;
+
+/**
+@brief		Registers the log-structured merge tree handler.
+
+@details	Registers functions for handlers. This only needs to be called
+			once for each type of dictionary that is present.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+lsmdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Inserts a record into a log-structured merge tree dictionary, replacing
+			the value of its key if it is there.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+lsmdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value stored under a key.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+lsmdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Creates a log-structured merge tree dictionary.
+
+@param		id
+				The identifier of the dictionary, which names its manifest
+				and numbers its runs.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The number of records the memtable holds before it is
+				written out as a run, 0 for @ref ION_LSM_MEMTABLE_RECORDS.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+lsmdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes the record stored under a key.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+lsmdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a log-structured merge tree dictionary, its manifest
+			and its runs.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+lsmdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+lsmdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+lsmdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a log-structured merge tree cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+lsmdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a log-structured merge tree cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+lsmdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opens a log-structured merge tree dictionary from its
+			manifest.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened. Its dictionary size sizes the memtable.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		The status of opening the dictionary.
+*/
+ion_err_t
+lsmdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes a log-structured merge tree dictionary, writing its
+			memtable out as a run.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		The status of closing the dictionary.
+*/
+ion_err_t
+lsmdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LSM_DICTIONARY_HANDLER_H_ */
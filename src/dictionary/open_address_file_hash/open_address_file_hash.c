@@ -13,19 +13,100 @@
 */
 /******************************************************************************/
 
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "open_address_file_hash.h"
 
+#if ION_OAFH_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #define ION_TEST_FILE "file.bin"
 
+#if ION_OAFH_USE_FINGERPRINTS
+
+/**
+@brief		The fingerprint a key is tagged with. Its top bit is clear,
+			so it never reads as free.
+*/
+static ion_byte_t
+oafh_tag(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key
+) {
+	return (ion_byte_t) (dictionary_hash_key(hash_map->super.key_type, key, hash_map->super.record.key_size, hash_map->seed ^ 0x2545F491UL) >> 25);
+}
+
+#endif
+
+#if ION_OAFH_USE_MMAP
+
+/**
+@brief		Maps the buckets of a map's file to be worked on in place.
+@details	The map is left going through the file if it cannot be
+			mapped, or if the file is too short for its buckets, since
+			touching a mapping past the end of its file faults.
+*/
+static void
+oafh_map_file(
+	ion_file_hashmap_t *hash_map
+) {
+	size_t		length = (size_t) hash_map->map_size * (SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size);
+	struct stat file_stat;
+	void		*map;
+
+	hash_map->map = NULL;
+
+	if ((0 == length) || (0 != fflush(hash_map->file)) || (0 != fstat(fileno(hash_map->file), &file_stat)) || ((size_t) file_stat.st_size < length)) {
+		return;
+	}
+
+	map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(hash_map->file), 0);
+
+	if (MAP_FAILED != map) {
+		hash_map->map = map;
+	}
+}
+
+/**
+@brief		Drops the mapping of a map's file, if it has one.
+*/
+static void
+oafh_unmap_file(
+	ion_file_hashmap_t *hash_map
+) {
+	if (NULL != hash_map->map) {
+		munmap(hash_map->map, (size_t) hash_map->map_size * (SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size));
+		hash_map->map = NULL;
+	}
+}
+
+#endif
+
 ion_err_t
 oafh_close(
 	ion_file_hashmap_t *hash_map
 ) {
 	if (NULL != hash_map->file) {
 		/* check to ensure that you are not freeing something already free */
+		ion_err_t err = oafh_sync(hash_map);
+
+#if ION_OAFH_USE_MMAP
+		oafh_unmap_file(hash_map);
+#endif
 		fclose(hash_map->file);
-		free(hash_map);
-		return err_ok;
+		ion_free(hash_map->page.buckets);
+#if ION_OAFH_USE_FINGERPRINTS
+		ion_free(hash_map->fingerprints);
+#endif
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+		ion_free(hash_map->dirty[0].buckets);
+#endif
+		ion_free(hash_map);
+		return err;
 	}
 	else {
 		return err_file_close_error;
@@ -52,6 +133,64 @@ oafh_initialize(
 
 	hashmap->compute_hash				= (*hashing_function);	/* Allows for binding of different hash functions
 																depending on requirements */
+	hashmap->seed						= id;
+	hashmap->version					= 0;
+	memset(&hashmap->stats, 0, sizeof(hashmap->stats));
+
+	int record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
+
+	/* the one buffer every probe reads through, so operations never allocate */
+	hashmap->page.capacity	= ION_OAFH_PAGE_SIZE / record_size;
+	hashmap->page.first		= 0;
+	hashmap->page.count		= 0;
+
+	if (hashmap->page.capacity < 1) {
+		hashmap->page.capacity = 1;
+	}
+
+	if (hashmap->page.capacity > hashmap->map_size) {
+		hashmap->page.capacity = hashmap->map_size;
+	}
+
+	hashmap->page.buckets	= ion_alloc(ion_alloc_buffer, hashmap->page.capacity * record_size);
+	hashmap->file			= NULL;
+#if ION_OAFH_USE_MMAP
+	hashmap->map			= NULL;
+#endif
+
+	if (NULL == hashmap->page.buckets) {
+		return err_out_of_memory;
+	}
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+
+	/* the held back pages share one allocation, made with the page's */
+	int frame;
+
+	hashmap->dirty[0].buckets = ion_alloc(ion_alloc_buffer, ION_OAFH_WRITE_BACK_PAGES * hashmap->page.capacity * record_size);
+
+	if (NULL == hashmap->dirty[0].buckets) {
+		ion_free(hashmap->page.buckets);
+		hashmap->page.buckets = NULL;
+		return err_out_of_memory;
+	}
+
+	for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+		hashmap->dirty[frame].buckets	= hashmap->dirty[0].buckets + frame * hashmap->page.capacity * record_size;
+		hashmap->dirty[frame].capacity	= hashmap->page.capacity;
+		hashmap->dirty[frame].first		= 0;
+		hashmap->dirty[frame].count		= 0;
+	}
+
+#endif
+
+#if ION_OAFH_USE_FINGERPRINTS
+	/* without room for them, probes read every bucket from the file */
+	if (NULL != (hashmap->fingerprints = ion_alloc(ion_alloc_buffer, hashmap->map_size))) {
+		memset(hashmap->fingerprints, ION_OAFH_FP_EMPTY, hashmap->map_size);
+	}
+
+#endif
 
 	char addr_filename[ION_MAX_FILENAME_LENGTH];
 
@@ -65,39 +204,48 @@ oafh_initialize(
 	hashmap->file = fopen(addr_filename, "r+b");
 
 	if (NULL != hashmap->file) {
-		return err_ok;
+#if ION_OAFH_USE_MMAP
+		oafh_map_file(hashmap);
+#endif
+		return oafh_rebuild_fingerprints(hashmap);
 	}
 
 	/* open the file */
 	hashmap->file = fopen(addr_filename, "w+b");
 
-	ion_hash_bucket_t *file_record;
-
-	int record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
-
-	file_record			= calloc(record_size, 1);
-	file_record->status = ION_EMPTY;
+	if (NULL == hashmap->file) {
+		return err_file_open_error;
+	}
 
-	/* write out the records to disk to prep */
+	/* write out the records to disk to prep, a page of empty ones at a time */
 #if ION_DEBUG
 	printf("Initializing hash table\n");
 #endif
 
-	int i, writes = 0;
+	int i, batch, writes = 0;
+
+	memset(hashmap->page.buckets, 0, hashmap->page.capacity * record_size);
 
-	for (i = 0; i < hashmap->map_size; i++) {
-		writes	+= fwrite(&file_record->status, SIZEOF(STATUS), 1, hashmap->file);
-		writes	+= fwrite(file_record->data, record_size - SIZEOF(STATUS), 1, hashmap->file);
+	for (i = 0; i < hashmap->page.capacity; i++) {
+		((ion_hash_bucket_t *) (hashmap->page.buckets + i * record_size))->status = ION_EMPTY;
+	}
+
+	for (i = 0; i < hashmap->map_size; i += batch) {
+		batch	= hashmap->map_size - i < hashmap->page.capacity ? hashmap->map_size - i : hashmap->page.capacity;
+		writes	+= fwrite(hashmap->page.buckets, record_size, batch, hashmap->file);
 	}
 
 	fflush(hashmap->file);
 
-	if (writes / 2 != hashmap->map_size) {
+	if (writes != hashmap->map_size) {
 		fclose(hashmap->file);
+		hashmap->file = NULL;
 		return err_file_write_error;
 	}
 
-	free(file_record);
+#if ION_OAFH_USE_MMAP
+	oafh_map_file(hashmap);
+#endif
 
 	return err_ok;
 }
@@ -114,11 +262,39 @@ ion_err_t
 oafh_destroy(
 	ion_file_hashmap_t *hash_map
 ) {
+#if ION_OAFH_USE_MMAP
+	/* the buckets go with the file, so there is nothing to sync */
+	oafh_unmap_file(hash_map);
+#endif
+
 	hash_map->compute_hash				= NULL;
 	hash_map->map_size					= 0;
 	hash_map->super.record.key_size		= 0;
 	hash_map->super.record.value_size	= 0;
 
+	ion_free(hash_map->page.buckets);
+	hash_map->page.buckets	= NULL;
+	hash_map->page.count	= 0;
+
+#if ION_OAFH_USE_FINGERPRINTS
+	ion_free(hash_map->fingerprints);
+	hash_map->fingerprints = NULL;
+#endif
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+
+	/* the file goes, so what was held back for it is dropped */
+	int frame;
+
+	ion_free(hash_map->dirty[0].buckets);
+
+	for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+		hash_map->dirty[frame].buckets	= NULL;
+		hash_map->dirty[frame].count	= 0;
+	}
+
+#endif
+
 	char addr_filename[ION_MAX_FILENAME_LENGTH];
 
 	int actual_filename_length = dictionary_get_filename(hash_map->super.id, "oaf", addr_filename);
@@ -156,158 +332,590 @@ oafh_update(
 	return result;
 }
 
-ion_status_t
-oafh_insert(
+ion_hash_bucket_t *
+oafh_read_bucket(
 	ion_file_hashmap_t	*hash_map,
-	ion_key_t			key,
-	ion_value_t			value
+	int					loc
 ) {
-	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);	/* compute hash value for given key */
+	return oafh_read_through(hash_map, &hash_map->page, loc);
+}
 
-	int loc			= oafh_get_location(hash, hash_map->map_size);
+ion_hash_bucket_t *
+oafh_read_through(
+	ion_file_hashmap_t	*hash_map,
+	ion_oafh_page_t		*page,
+	int					loc
+) {
+	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
-	/* Scan until find an empty location - oah_insert if found */
-	int count		= 0;
+#if ION_OAFH_USE_MMAP
 
-	ion_hash_bucket_t *item;
+	if (NULL != hash_map->map) {
+		return (ion_hash_bucket_t *) (hash_map->map + (long) loc * record_size);
+	}
 
-	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+#endif
 
-	item = malloc(record_size);
+#if ION_OAFH_WRITE_BACK_PAGES > 0
 
-	/* set file position */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	int frame;
 
-	while (count != hash_map->map_size) {
-		fread(item, record_size, 1, hash_map->file);
-#if ION_DEBUG
-		DUMP((int) ftell(hash_map->file), "%i");
-#endif
+	/* the file is behind the pages held back */
+	for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+		ion_oafh_page_t *dirty = &hash_map->dirty[frame];
 
-		if (item->status == ION_IN_USE) {
-			/* if a cell is in use, need to key to */
+		if ((loc >= dirty->first) && (loc < dirty->first + dirty->count)) {
+			return (ion_hash_bucket_t *) (dirty->buckets + (loc - dirty->first) * record_size);
+		}
+	}
 
-			if (hash_map->super.compare(item->data, key, hash_map->super.record.key_size) == ION_IS_EQUAL) {
-				if (hash_map->write_concern == wc_insert_unique) {
-					/* allow unique entries only */
-					free(item);
-					return ION_STATUS_ERROR(err_duplicate_key);
-				}
-				else if (hash_map->write_concern == wc_update) {
-					/* allows for values to be updated											// */
-					/* backup and write */
-					fseek(hash_map->file, SIZEOF(STATUS) + hash_map->super.record.key_size - record_size, SEEK_CUR);
-#if ION_DEBUG
-					DUMP((int) ftell(hash_map->file), "%i");
-					DUMP(value, "%s");
 #endif
-					fwrite(value, hash_map->super.record.value_size, 1, hash_map->file);
-					free(item);
-					return ION_STATUS_OK(1);
-				}
-				else {
-					free(item);
-					return ION_STATUS_ERROR(err_write_concern);	/* there is a configuration issue with write concern */
-				}
+
+	if ((loc < page->first) || (loc >= page->first + page->count)) {
+		page->first = loc;
+		page->count = hash_map->map_size - loc < page->capacity ? hash_map->map_size - loc : page->capacity;
+
+		if ((0 != fseek(hash_map->file, (long) loc * record_size, SEEK_SET)) || (page->count != (int) fread(page->buckets, record_size, page->count, hash_map->file))) {
+			page->count = 0;
+			return NULL;
+		}
+	}
+
+	return (ion_hash_bucket_t *) (page->buckets + (loc - page->first) * record_size);
+}
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+
+/**
+@brief		Writes the held back pages of a map to its file, lowest first,
+			leaving all of them unused.
+@return		@c err_ok, or @c err_file_write_error if a page could not be
+			written. The pages are unused either way.
+*/
+static ion_err_t
+oafh_write_back(
+	ion_file_hashmap_t *hash_map
+) {
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_err_t	err			= err_ok;
+	int			frame;
+	int			lowest;
+
+	/* what the page read from the file may be older than the pages */
+	hash_map->page.count = 0;
+
+	for (;;) {
+		lowest = -1;
+
+		for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+			if ((0 < hash_map->dirty[frame].count) && ((-1 == lowest) || (hash_map->dirty[frame].first < hash_map->dirty[lowest].first))) {
+				lowest = frame;
 			}
 		}
-		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
-			/* problem is here with base types as it is just an array of data.  Need better way */
-			/* printf("empty\n"); */
-			fseek(hash_map->file, -record_size, SEEK_CUR);
-#if ION_DEBUG
-			DUMP((int) ftell(hash_map->file), "%i");
+
+		if (-1 == lowest) {
+			return err;
+		}
+
+		ion_oafh_page_t *dirty = &hash_map->dirty[lowest];
+
+		if ((0 != fseek(hash_map->file, (long) dirty->first * record_size, SEEK_SET)) || (dirty->count != (int) fwrite(dirty->buckets, record_size, dirty->count, hash_map->file))) {
+			err = err_file_write_error;
+		}
+
+		dirty->count = 0;
+	}
+}
+
 #endif
-			item->status = ION_IN_USE;
-			memcpy(item->data, key, (hash_map->super.record.key_size));
-			memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
-			fwrite(item, record_size, 1, hash_map->file);
-			free(item);
 
-			return ION_STATUS_OK(1);
+/**
+@brief		Writes part of a bucket of a map, in place if its file is
+			mapped, else through a held back page if there are any.
+@details	A page not held back yet is read in to take the write, once
+			the others have been written back if they are all in use. The
+			buckets of @p data, which may lie in a held back page, are
+			left alone until copied.
+@param		loc
+				The bucket to write.
+@param		offset
+				Where in the bucket the write starts.
+@param		data
+				The bytes to write.
+@param		length
+				The number of bytes to write.
+@return		The status of the write.
+*/
+static ion_err_t
+oafh_write_bucket(
+	ion_file_hashmap_t	*hash_map,
+	int					loc,
+	int					offset,
+	void				*data,
+	int					length
+) {
+	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+
+	hash_map->version++;
+
+#if ION_OAFH_USE_MMAP
+
+	if (NULL != hash_map->map) {
+		memmove(hash_map->map + (long) loc * record_size + offset, data, length);
+		return err_ok;
+	}
+
+#endif
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+
+	ion_oafh_page_t *dirty	= NULL;
+	ion_err_t		err		= err_ok;
+	int				frame;
+
+	for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+		if ((loc >= hash_map->dirty[frame].first) && (loc < hash_map->dirty[frame].first + hash_map->dirty[frame].count)) {
+			dirty = &hash_map->dirty[frame];
+			break;
+		}
+	}
+
+	if (NULL == dirty) {
+		for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+			if (0 == hash_map->dirty[frame].count) {
+				break;
+			}
+		}
+
+		if (ION_OAFH_WRITE_BACK_PAGES == frame) {
+			err = oafh_write_back(hash_map);
 		}
 
-		loc++;
+		/* take a page other than the one holding the data, of which there are at least two */
+		for (frame = 0; frame < ION_OAFH_WRITE_BACK_PAGES; frame++) {
+			dirty = &hash_map->dirty[frame];
 
-		if (loc >= hash_map->map_size) {
-			/* Perform wrapping */
-			loc = 0;
-			/* rewind the file */
-			frewind(hash_map->file);
+			if ((0 == dirty->count) && (((ion_byte_t *) data < dirty->buckets) || ((ion_byte_t *) data >= dirty->buckets + dirty->capacity * record_size))) {
+				break;
+			}
 		}
 
-#if ION_DEBUG
-		printf("checking location %i\n", loc);
+		dirty->first	= loc - loc % dirty->capacity;
+		dirty->count	= hash_map->map_size - dirty->first < dirty->capacity ? hash_map->map_size - dirty->first : dirty->capacity;
+
+		if ((0 != fseek(hash_map->file, (long) dirty->first * record_size, SEEK_SET)) || (dirty->count != (int) fread(dirty->buckets, record_size, dirty->count, hash_map->file))) {
+			dirty->count = 0;
+			return err_file_read_error;
+		}
+	}
+
+	memmove(dirty->buckets + (loc - dirty->first) * record_size + offset, data, length);
+
+	return err;
+#else
+
+	if ((0 != fseek(hash_map->file, (long) loc * record_size + offset, SEEK_SET)) || (1 != fwrite(data, length, 1, hash_map->file))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+#endif
+}
+
+ion_err_t
+oafh_sync(
+	ion_file_hashmap_t *hash_map
+) {
+	ion_err_t err = err_ok;
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+	err = oafh_write_back(hash_map);
 #endif
-		count++;
+
+	if (0 != fflush(hash_map->file)) {
+		err = err_file_write_error;
+	}
+
+#if ION_OAFH_USE_MMAP
+
+	if ((NULL != hash_map->map) && (0 != msync(hash_map->map, (size_t) hash_map->map_size * (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)), MS_SYNC))) {
+		err = err_file_write_error;
 	}
 
-#if ION_DEBUG
-	printf("Hash table full.  Insert not done");
 #endif
-	free(item);
-	return ION_STATUS_ERROR(err_max_capacity);
+
+	return err;
 }
 
 ion_err_t
-oafh_find_item_loc(
+oafh_rebuild_fingerprints(
+	ion_file_hashmap_t *hash_map
+) {
+#if ION_OAFH_USE_FINGERPRINTS
+
+	ion_hash_bucket_t	*bucket;
+	int					i;
+
+	if (NULL == hash_map->fingerprints) {
+		return err_ok;
+	}
+
+	/* the file may have been written behind the page */
+	hash_map->page.count = 0;
+
+	for (i = 0; i < hash_map->map_size; i++) {
+		if (NULL == (bucket = oafh_read_bucket(hash_map, i))) {
+			return err_file_read_error;
+		}
+
+		if (ION_IN_USE == bucket->status) {
+			hash_map->fingerprints[i] = oafh_tag(hash_map, bucket->data);
+		}
+		else {
+			hash_map->fingerprints[i] = (ION_DELETED == bucket->status) ? ION_OAFH_FP_DELETED : ION_OAFH_FP_EMPTY;
+		}
+	}
+
+#else
+	UNUSED(hash_map);
+#endif
+
+	return err_ok;
+}
+
+/**
+@brief		Walks the probe path of @p key through pages of buckets, up to
+			the bucket holding it or the first that ends the path.
+@details	With fingerprints, only buckets whose fingerprint matches the
+			key's are read. A free bucket ending the path is not read
+			either; a blank one is made up in the page instead.
+@param		stop_at_deleted
+				Whether a tombstone ends the path, as it does for inserts
+				that may reuse it, rather than being stepped over.
+@param		loc
+				Receives the bucket the walk stopped at.
+@param		bucket
+				Receives that bucket, within the map's page.
+@return		@c err_ok if the walk stopped at a bucket,
+			@c err_max_capacity if it went round the whole map, or
+			@c err_file_read_error.
+*/
+static ion_err_t
+oafh_walk(
 	ion_file_hashmap_t	*hash_map,
 	ion_key_t			key,
-	int					*location
+	ion_boolean_t		stop_at_deleted,
+	int					*loc,
+	ion_hash_bucket_t	**bucket,
+	ion_hash_op_stats_t *op
 ) {
-	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
-	/* compute hash value for given key */
+	int home	= oafh_get_location(hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size), hash_map->map_size);
+	int count;
 
-	int loc			= oafh_get_location(hash, hash_map->map_size);
-	/* determine bucket based on hash */
+#if ION_OAFH_USE_FINGERPRINTS
+	ion_byte_t	tag = (NULL != hash_map->fingerprints) ? oafh_tag(hash_map, key) : 0;
+	ion_byte_t	fingerprint;
+#endif
 
-	int count		= 0;
+	*loc = home;
 
-	ion_hash_bucket_t *item;
+	/* writes since the page was read are not all mirrored in it */
+	hash_map->page.count = 0;
 
-	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	/* wrapping takes the next page from the start of the file */
+	for (count = 0; count < hash_map->map_size; count++, *loc = (*loc + 1 < hash_map->map_size) ? *loc + 1 : 0) {
+#if ION_OAFH_USE_FINGERPRINTS
+
+		if (NULL != hash_map->fingerprints) {
+			fingerprint = hash_map->fingerprints[*loc];
+
+			if ((ION_OAFH_FP_EMPTY == fingerprint) || (stop_at_deleted && (ION_OAFH_FP_DELETED == fingerprint))) {
+				hash_map->page.count	= 0;
+				*bucket					= (ion_hash_bucket_t *) hash_map->page.buckets;
+				(*bucket)->status		= (ION_OAFH_FP_EMPTY == fingerprint) ? ION_EMPTY : ION_DELETED;
+				break;
+			}
 
-	item = malloc(record_size);
+			/* another key, or a tombstone stepped over */
+			if (tag != fingerprint) {
+				continue;
+			}
+		}
+
+#endif
+
+		if (NULL == (*bucket = oafh_read_bucket(hash_map, *loc))) {
+			return err_file_read_error;
+		}
+
+		if (((*bucket)->status == ION_EMPTY) || (stop_at_deleted && ((*bucket)->status == ION_DELETED)) || (((*bucket)->status == ION_IN_USE) && (ION_IS_EQUAL == hash_map->super.compare((*bucket)->data, key, hash_map->super.record.key_size)))) {
+			break;
+		}
+	}
+
+	if (NULL != op) {
+		dictionary_hash_count_probes(&hash_map->stats, op, home, count < hash_map->map_size ? count + 1 : count, hash_map->map_size);
+	}
+
+	return count < hash_map->map_size ? err_ok : err_max_capacity;
+}
+
+ion_status_t
+oafh_insert(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_hash_bucket_t	*item;
+	ion_status_t		status;
+	ion_err_t			err;
+	int					loc;
 
-	/* set file position */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
-	/* needs to traverse file again */
-	while (count != hash_map->map_size) {
-		fread(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fread(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+	/* Scan until find an empty location - oah_insert if found */
+	err = oafh_walk(hash_map, key, boolean_true, &loc, &item, &hash_map->stats.insert);
 
-		if (item->status == ION_EMPTY) {
-			free(item);
-			return err_item_not_found;	/* if you hit an empty cell, exit */
+	if (err_ok != err) {
+#if ION_DEBUG
+		printf("Hash table full.  Insert not done");
+#endif
+		status = ION_STATUS_ERROR(err);
+	}
+	else if (item->status == ION_IN_USE) {
+		if (hash_map->write_concern == wc_insert_unique) {
+			/* allow unique entries only */
+			status = ION_STATUS_ERROR(err_duplicate_key);
+		}
+		else if (hash_map->write_concern == wc_update) {
+			/* allows for values to be updated */
+#if ION_DEBUG
+			DUMP(loc, "%i");
+			DUMP(value, "%s");
+#endif
+			err		= oafh_write_bucket(hash_map, loc, SIZEOF(STATUS) + hash_map->super.record.key_size, value, hash_map->super.record.value_size);
+			status	= err_ok == err ? ION_STATUS_OK(1) : ION_STATUS_ERROR(err);
 		}
 		else {
-			/* calculate if there is a match */
+			status = ION_STATUS_ERROR(err_write_concern);	/* there is a configuration issue with write concern */
+		}
+	}
+	else {
+		/* the free bucket is filled in place in the page and written back */
+		item->status = ION_IN_USE;
+		memcpy(item->data, key, (hash_map->super.record.key_size));
+		memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
+#if ION_DEBUG
+		DUMP(loc, "%i");
+#endif
+		err		= oafh_write_bucket(hash_map, loc, 0, item, record_size);
+		status	= err_ok == err ? ION_STATUS_OK(1) : ION_STATUS_ERROR(err);
 
-			if (item->status != ION_DELETED) {
-				/*@todo correct compare to use proper return type*/
-				int key_is_equal = hash_map->super.compare(item->data, key, hash_map->super.record.key_size);
+#if ION_OAFH_USE_FINGERPRINTS
 
-				if (ION_IS_EQUAL == key_is_equal) {
-					(*location) = loc;
-					free(item);
-					return err_ok;
-				}
+		if ((err_ok == status.error) && (NULL != hash_map->fingerprints)) {
+			hash_map->fingerprints[loc] = oafh_tag(hash_map, key);
+		}
+
+#endif
+	}
+
+	return status;
+}
+
+/**
+@brief		Where a record of a bulk build hashes to.
+*/
+typedef struct {
+	int home;	/**< The bucket the record's probe starts at */
+	int index;	/**< The record within the batch */
+} ion_oafh_placement_t;
+
+/**
+@brief		Orders placements by bucket, then by record, so a build lays
+			out the same batch the same way.
+*/
+static int
+oafh_placement_compare(
+	const void	*first,
+	const void	*second
+) {
+	const ion_oafh_placement_t	*a	= (const ion_oafh_placement_t *) first;
+	const ion_oafh_placement_t	*b	= (const ion_oafh_placement_t *) second;
+
+	if (a->home != b->home) {
+		return a->home < b->home ? -1 : 1;
+	}
+
+	return a->index < b->index ? -1 : (a->index > b->index ? 1 : 0);
+}
+
+ion_status_t
+oafh_bulk_build(
+	ion_file_hashmap_t	*hash_map,
+	ion_byte_t			*records,
+	int					count
+) {
+	ion_oafh_placement_t	*placements = NULL;
+	ion_hash_bucket_t		*bucket;
+	ion_byte_t				*buckets	= hash_map->page.buckets;
+	ion_status_t			status		= ION_STATUS_OK(0);
+	int						data_size	= hash_map->super.record.key_size + hash_map->super.record.value_size;
+	int						record_size = data_size + SIZEOF(STATUS);
+	int						i, j, next, first, batch;
+	int						placed		= 0;
+	int						loc			= 0;
+
+	if (count > hash_map->map_size) {
+		return ION_STATUS_ERROR(err_max_capacity);
+	}
+
+	if ((0 < count) && (NULL == (placements = ion_alloc(ion_alloc_buffer, count * sizeof(ion_oafh_placement_t))))) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	for (i = 0; i < count; i++) {
+		placements[i].home	= oafh_get_location(hash_map->compute_hash(hash_map, records + i * data_size, hash_map->super.record.key_size), hash_map->map_size);
+		placements[i].index = i;
+	}
+
+	if (0 < count) {
+		qsort(placements, count, sizeof(ion_oafh_placement_t), oafh_placement_compare);
+	}
+
+	/* equal keys hash to the same bucket, so only records sorted next to each other can clash */
+	for (i = 0; i < count; i++) {
+		for (j = i + 1; (j < count) && (placements[j].home == placements[i].home); j++) {
+			if (ION_IS_EQUAL == hash_map->super.compare(records + placements[i].index * data_size, records + placements[j].index * data_size, hash_map->super.record.key_size)) {
+				ion_free(placements);
+				return ION_STATUS_ERROR(err_duplicate_key);
+			}
+		}
+	}
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+
+	/* every bucket is rewritten, so nothing held back is worth keeping */
+	for (i = 0; i < ION_OAFH_WRITE_BACK_PAGES; i++) {
+		hash_map->dirty[i].count = 0;
+	}
+
+#endif
+#if ION_OAFH_USE_FINGERPRINTS
+
+	if (NULL != hash_map->fingerprints) {
+		memset(hash_map->fingerprints, ION_OAFH_FP_EMPTY, hash_map->map_size);
+	}
+
+#endif
+
+	/* each record goes to its home, or just past the one before it, a page of buckets at a time */
+	hash_map->page.count = 0;
+	hash_map->version++;
+
+	if (0 != fseek(hash_map->file, 0, SEEK_SET)) {
+		status.error = err_file_write_error;
+	}
+
+	for (first = 0; (err_ok == status.error) && (first < hash_map->map_size); first += batch) {
+		batch = hash_map->map_size - first < hash_map->page.capacity ? hash_map->map_size - first : hash_map->page.capacity;
+
+#if ION_OAFH_USE_MMAP
+
+		/* a mapped file is laid out in place */
+		if (NULL != hash_map->map) {
+			buckets = hash_map->map + (long) first * record_size;
+		}
+
+#endif
+
+		for (i = 0; i < batch; i++) {
+			((ion_hash_bucket_t *) (buckets + i * record_size))->status = ION_EMPTY;
+		}
+
+		for (; placed < count; placed++) {
+			next = placements[placed].home > loc ? placements[placed].home : loc;
+
+			if (next >= first + batch) {
+				break;
 			}
 
-			loc++;
-			count++;
+			bucket			= (ion_hash_bucket_t *) (buckets + (next - first) * record_size);
+			bucket->status	= ION_IN_USE;
+			memcpy(bucket->data, records + placements[placed].index * data_size, data_size);
+#if ION_OAFH_USE_FINGERPRINTS
 
-			if (loc >= hash_map->map_size) {
-				/* Perform wrapping */
-				loc = 0;
-				frewind(hash_map->file);
+			if (NULL != hash_map->fingerprints) {
+				hash_map->fingerprints[next] = oafh_tag(hash_map, bucket->data);
 			}
+
+#endif
+			loc = next + 1;
+		}
+
+		if ((buckets == hash_map->page.buckets) && (batch != (int) fwrite(buckets, record_size, batch, hash_map->file))) {
+			status.error = err_file_write_error;
 		}
 	}
 
-	free(item);
-	return err_item_not_found;	/* key have not been found */
+	status.count = placed;
+
+	/* the rest ran off the end, and probe on from the first bucket */
+	for (; (err_ok == status.error) && (placed < count); placed++) {
+		i				= placements[placed].index;
+		status.error	= oafh_insert(hash_map, records + i * data_size, records + i * data_size + hash_map->super.record.key_size).error;
+
+		if (err_ok == status.error) {
+			status.count++;
+		}
+	}
+
+	ion_free(placements);
+
+	if ((err_ok == status.error) && (0 != fflush(hash_map->file))) {
+		status.error = err_file_write_error;
+	}
+
+	return status;
+}
+
+/**
+@brief		Locates @p key in the map, counting the probe in @p op.
+@param		op
+				The counters of the operation looking for the key, or
+				@c NULL to leave the statistics alone.
+@return		The status of the find; @p location is only set if found.
+*/
+static ion_err_t
+oafh_probe(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key,
+	int					*location,
+	ion_hash_op_stats_t *op
+) {
+	ion_hash_bucket_t	*item;
+	ion_err_t			err;
+	int					loc;
+
+	err = oafh_walk(hash_map, key, boolean_false, &loc, &item, op);
+
+	if ((err_ok == err) && (item->status == ION_IN_USE)) {
+		(*location) = loc;
+	}
+	else if ((err_ok == err) || (err_max_capacity == err)) {
+		err = err_item_not_found;	/* key have not been found */
+	}
+
+	return err;
+}
+
+ion_err_t
+oafh_find_item_loc(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key,
+	int					*location
+) {
+	return oafh_probe(hash_map, key, location, NULL);
 }
 
 ion_status_t
@@ -315,36 +923,86 @@ oafh_delete(
 	ion_file_hashmap_t	*hash_map,
 	ion_key_t			key
 ) {
-	int loc;
+	int			loc;
+	ion_err_t	err = oafh_probe(hash_map, key, &loc, &hash_map->stats.remove);
 
-	if (oafh_find_item_loc(hash_map, key, &loc) == err_item_not_found) {
+	if (err_ok != err) {
 #if ION_DEBUG
 		printf("Item not found when trying to oah_delete.\n");
 #endif
-		return ION_STATUS_ERROR(err_item_not_found);
+		return ION_STATUS_ERROR(err);
 	}
 	else {
 		/* locate item */
-		ion_hash_bucket_t *item;
+		ion_hash_bucket_t	*item;
+		char				status = ION_EMPTY;
 
 		int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
-		item = malloc(record_size);
+		/* Shift back the records after it whose probe path passes through
+		   the hole, rather than leaving a tombstone for lookups to step over.
+		   Holes are always behind the walk, so the page never goes stale. */
+		int hole	= loc;
+		int next	= loc;
+		int count;
+		int home;
 
-		/* set file position */
-		fseek(hash_map->file, loc * record_size, SEEK_SET);
+		for (count = 1; count < hash_map->map_size; count++) {
+			next = (next + 1) % hash_map->map_size;
 
-		fread(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fread(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+#if ION_OAFH_USE_FINGERPRINTS
+
+			/* free buckets are known without reading them */
+			if ((NULL != hash_map->fingerprints) && (ION_OAFH_FP_EMPTY == hash_map->fingerprints[next])) {
+				break;
+			}
 
-		item->status = ION_DELETED;	/* delete item */
+			if ((NULL != hash_map->fingerprints) && (ION_OAFH_FP_DELETED == hash_map->fingerprints[next])) {
+				continue;
+			}
+
+#endif
+
+			if (NULL == (item = oafh_read_bucket(hash_map, next))) {
+				break;
+			}
+
+			if (item->status == ION_EMPTY) {
+				break;
+			}
+
+			/* tombstones left by earlier versions are stepped over */
+			if (item->status != ION_IN_USE) {
+				continue;
+			}
 
-		/* backup */
-		fseek(hash_map->file, -record_size, SEEK_CUR);
-		fwrite(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fwrite(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+			home = oafh_get_location(hash_map->compute_hash(hash_map, item->data, hash_map->super.record.key_size), hash_map->map_size);
+
+			/* the record may move back if the hole lies between its home and it */
+			if ((next - home + hash_map->map_size) % hash_map->map_size >= (next - hole + hash_map->map_size) % hash_map->map_size) {
+				oafh_write_bucket(hash_map, hole, 0, item, record_size);
+#if ION_OAFH_USE_FINGERPRINTS
+
+				if (NULL != hash_map->fingerprints) {
+					hash_map->fingerprints[hole] = hash_map->fingerprints[next];
+				}
+
+#endif
+				hole = next;
+			}
+		}
+
+		/* delete item */
+		oafh_write_bucket(hash_map, hole, 0, &status, SIZEOF(STATUS));
+
+#if ION_OAFH_USE_FINGERPRINTS
+
+		if (NULL != hash_map->fingerprints) {
+			hash_map->fingerprints[hole] = ION_OAFH_FP_EMPTY;
+		}
+
+#endif
 
-		free(item);
 #if ION_DEBUG
 		printf("Item deleted at location %d\n", loc);
 #endif
@@ -358,31 +1016,87 @@ oafh_query(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	int loc;
+	ion_hash_bucket_t	*item;
+	ion_status_t		status;
+	ion_err_t			err;
+	int					loc;
 
-	if (oafh_find_item_loc(hash_map, key, &loc) == err_ok) {
-#if ION_DEBUG
-		printf("Item found at location %d\n", loc);
-#endif
+	err = oafh_walk(hash_map, key, boolean_false, &loc, &item, &hash_map->stats.get);
 
-		int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
-
-		/* set file position */
-		fseek(hash_map->file, (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size, SEEK_SET);
+	if ((err_ok == err) && (item->status == ION_IN_USE)) {
 #if ION_DEBUG
-		printf("seeking %i\n", (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size);
+		printf("Item found at location %d\n", loc);
 #endif
-		fread(value, hash_map->super.record.value_size, 1, hash_map->file);
 
-		return ION_STATUS_OK(1);
+		/* the value came in with the page */
+		memcpy(value, item->data + hash_map->super.record.key_size, hash_map->super.record.value_size);
+		status = ION_STATUS_OK(1);
 	}
 	else {
 #if ION_DEBUG
 		printf("Item not found in hash table.\n");
 #endif
-		value = NULL;	/*et the number of bytes to 0 */
-		return ION_STATUS_ERROR(err_item_not_found);
+		status = ION_STATUS_ERROR(err_file_read_error == err ? err : err_item_not_found);
 	}
+
+	return status;
+}
+
+ion_err_t
+oafh_stats(
+	ion_file_hashmap_t	*hash_map,
+	ion_hash_stats_t	*stats
+) {
+	ion_hash_bucket_t	*bucket;
+	int					i;
+
+	*stats			= hash_map->stats;
+	stats->buckets	= hash_map->map_size;
+	stats->occupied = 0;
+	stats->deleted	= 0;
+
+#if ION_OAFH_USE_FINGERPRINTS
+
+	if (NULL != hash_map->fingerprints) {
+		for (i = 0; i < hash_map->map_size; i++) {
+			if (ION_OAFH_FP_DELETED == hash_map->fingerprints[i]) {
+				stats->deleted++;
+			}
+			else if (ION_OAFH_FP_EMPTY != hash_map->fingerprints[i]) {
+				stats->occupied++;
+			}
+		}
+
+		return err_ok;
+	}
+
+#endif
+
+	hash_map->page.count = 0;
+
+	for (i = 0; i < hash_map->map_size; i++) {
+		if (NULL == (bucket = oafh_read_bucket(hash_map, i))) {
+			return err_file_read_error;
+		}
+
+		if (ION_IN_USE == bucket->status) {
+			stats->occupied++;
+		}
+		else if (ION_DELETED == bucket->status) {
+			stats->deleted++;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+oafh_reset_stats(
+	ion_file_hashmap_t *hash_map
+) {
+	memset(&hash_map->stats, 0, sizeof(hash_map->stats));
+
+	return err_ok;
 }
 
 ion_hash_t
@@ -398,3 +1112,14 @@ oafh_compute_simple_hash(
 
 	return hash;
 }
+
+ion_hash_t
+oafh_compute_seeded_hash(
+	ion_file_hashmap_t	*hashmap,
+	ion_key_t			key,
+	int					size_of_key
+) {
+	uint32_t hash = dictionary_hash_key(hashmap->super.key_type, key, size_of_key, hashmap->seed);
+
+	return (ion_hash_t) (hash % (uint32_t) hashmap->map_size);
+}
@@ -30,6 +30,93 @@ extern "C" {
 #define ION_IN_USE	-3
 #define SIZEOF(STATUS) 1
 
+/**
+@brief		How many bytes of consecutive buckets a probe reads from the
+			file at once. Runs of collisions within a page then cost one
+			read rather than one per bucket. At least one bucket is read.
+*/
+#if !defined(ION_OAFH_PAGE_SIZE)
+#if defined(ARDUINO)
+#define ION_OAFH_PAGE_SIZE 64
+#else
+#define ION_OAFH_PAGE_SIZE 512
+#endif
+#endif
+
+/**
+@brief		Whether maps keep a byte per bucket in memory, holding whether
+			it is free and a 7-bit fingerprint of its key. Probing then
+			only reads a bucket from the file on a fingerprint match, so a
+			lookup of an absent key seldom reads the file at all. Maps
+			that cannot allocate the bytes probe the file instead.
+*/
+#if !defined(ION_OAFH_USE_FINGERPRINTS)
+#define ION_OAFH_USE_FINGERPRINTS 1
+#endif
+
+/**
+@brief		The fingerprint of a bucket never used, which ends a probe.
+*/
+#define ION_OAFH_FP_EMPTY	0x80
+
+/**
+@brief		The fingerprint of a tombstone, which a probe steps over.
+*/
+#define ION_OAFH_FP_DELETED 0xFE
+
+/**
+@brief		How many pages of buckets written by a map are held back in
+			memory before going to the file. Pages line up on multiples of
+			the buckets in @ref ION_OAFH_PAGE_SIZE. Once all are dirty, a
+			write to another page writes them all out in file order, as
+			do @ref oafh_sync and closing the map. 0 writes every change
+			straight through to the file, for callers that need each
+			operation to be durable once it returns. Otherwise it must be
+			at least 2.
+*/
+#if !defined(ION_OAFH_WRITE_BACK_PAGES)
+#if defined(ARDUINO)
+#define ION_OAFH_WRITE_BACK_PAGES 2
+#else
+#define ION_OAFH_WRITE_BACK_PAGES 4
+#endif
+#endif
+
+#if ION_OAFH_WRITE_BACK_PAGES == 1
+#error "ION_OAFH_WRITE_BACK_PAGES must be 0 or at least 2"
+#endif
+
+/**
+@brief		How many bytes of consecutive buckets a cursor scanning many
+			buckets reads from the file at once, into a buffer of its
+			own. At least a page of @ref ION_OAFH_PAGE_SIZE is read.
+*/
+#if !defined(ION_OAFH_SCAN_CHUNK_SIZE)
+#if defined(ARDUINO)
+#define ION_OAFH_SCAN_CHUNK_SIZE ION_OAFH_PAGE_SIZE
+#else
+#define ION_OAFH_SCAN_CHUNK_SIZE 65536
+#endif
+#endif
+
+/**
+@brief		Whether maps work on their buckets in place in a shared mapping
+			of their file, rather than through @c fseek, @c fread and
+			@c fwrite. The page cache then takes the place of the page
+			read and of the pages held back, @ref oafh_sync and closing
+			the map @c msync the mapping, and the file is laid out the
+			same. This is the default on POSIX hosts; Arduino and other
+			targets keep the stdio path, as does a map whose file cannot
+			be mapped. Define as 0 to force the stdio path everywhere.
+*/
+#if !defined(ION_OAFH_USE_MMAP)
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define ION_OAFH_USE_MMAP 1
+#else
+#define ION_OAFH_USE_MMAP 0
+#endif
+#endif
+
 /**
 @brief		Prototype declaration for hashmap
 */
@@ -52,7 +139,30 @@ struct file_hashmap {
 
 	/**< The hashing function to be used for
 		 the instance*/
+	uint32_t				seed;	/**< The seed given to the seeded
+								 hash, taken from the dictionary id */
+	uint32_t				version;	/**< Counts the writes to the
+										 buckets, so copies of them can
+										 tell they are stale */
 	FILE *file;	/**< file pointer */
+	ion_hash_stats_t		stats;	/**< Probe counters, see
+									 @ref oafh_stats */
+	ion_oafh_page_t			page;	/**< The buckets last read, allocated
+									 once so operations never allocate */
+#if ION_OAFH_USE_FINGERPRINTS
+	ion_byte_t				*fingerprints;	/**< One byte per bucket, or
+											 @c NULL to probe the file */
+#endif
+#if ION_OAFH_USE_MMAP
+	ion_byte_t				*map;	/**< The buckets of the file, mapped to
+									 be worked on in place, or @c NULL to
+									 go through the file */
+#endif
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+	ion_oafh_page_t			dirty[ION_OAFH_WRITE_BACK_PAGES];	/**< Pages written but
+																 not yet in the file,
+																 unused if empty */
+#endif
 };
 
 /**
@@ -153,6 +263,34 @@ oafh_insert(
 	ion_value_t			value
 );
 
+/**
+@brief		Builds a map from a batch of records, writing its file front
+			to back in one pass.
+
+@details	The records are sorted by the bucket they hash to, in memory,
+			and laid out in that order the way inserting them one by one
+			would probe them in. Records that run past the last bucket
+			wrap to the front, and are inserted once the pass is done.
+			Whatever the map held before is replaced. Takes two ints per
+			record of memory for the sort.
+
+@param		hash_map
+				The map to build.
+@param		records
+				@p count records, each its key followed by its value.
+@param		count
+				The number of records.
+@return		The status of the build, counting the records written. It
+			fails with @c err_duplicate_key, before writing anything, if
+			two records share a key.
+*/
+ion_status_t
+oafh_bulk_build(
+	ion_file_hashmap_t	*hash_map,
+	ion_byte_t			*records,
+	int					count
+);
+
 /**
 @brief		Updates a value in the map.
 
@@ -251,6 +389,121 @@ oafh_query(
 	ion_value_t			value
 );
 
+/**
+@brief		Returns a bucket of a map, read through its page.
+
+@details	Buckets of pages held back for writing are returned from
+			them. Otherwise, if the page does not hold bucket @p loc, the
+			page of buckets starting at it is read. The bucket stays valid
+			until the next call into the map.
+
+@param		hash_map
+				The map to read.
+@param		loc
+				The bucket to return.
+@return		The bucket, or @c NULL if it could not be read.
+*/
+ion_hash_bucket_t *
+oafh_read_bucket(
+	ion_file_hashmap_t	*hash_map,
+	int					loc
+);
+
+/**
+@brief		Returns a bucket of a map, read through a page of the
+			caller's.
+
+@details	As @ref oafh_read_bucket, but reading into @p page, whose
+			@c buckets and @c capacity the caller sets up. The page is
+			not reread when the map is written; comparing
+			@c hash_map->version tells when it has to be. A map whose
+			file is mapped returns the bucket in the mapping instead, and
+			leaves @p page alone.
+
+@param		hash_map
+				The map to read.
+@param		page
+				The page to read through.
+@param		loc
+				The bucket to return.
+@return		The bucket, or @c NULL if it could not be read.
+*/
+ion_hash_bucket_t *
+oafh_read_through(
+	ion_file_hashmap_t	*hash_map,
+	ion_oafh_page_t		*page,
+	int					loc
+);
+
+/**
+@brief		Writes the pages of buckets a map has held back to its file,
+			in file order, and flushes the file.
+
+@details	Does nothing more than flush the file if
+			@ref ION_OAFH_WRITE_BACK_PAGES is 0. A map whose file is
+			mapped holds nothing back, and instead waits for the mapping
+			to reach the file with @c msync. Closing a map syncs it.
+
+@param		hash_map
+				The map to sync.
+@return		The status of writing the file.
+*/
+ion_err_t
+oafh_sync(
+	ion_file_hashmap_t *hash_map
+);
+
+/**
+@brief		Rebuilds the fingerprints of a map from the buckets in its
+			file.
+
+@details	Done when a map is opened from an existing file, and only
+			otherwise needed after buckets have been written to the file
+			directly rather than through the map's functions. Does
+			nothing if @ref ION_OAFH_USE_FINGERPRINTS is off.
+
+@param		hash_map
+				The map whose fingerprints to rebuild.
+@return		The status of reading the file.
+*/
+ion_err_t
+oafh_rebuild_fingerprints(
+	ion_file_hashmap_t *hash_map
+);
+
+/**
+@brief		Reads the statistics of a map.
+
+@details	The probe counters cover the operations since the map was
+			initialized or last reset. The bucket counts are taken from
+			the fingerprints, or by reading the status of every bucket
+			from the file without them.
+
+@param		hash_map
+				The map to read.
+@param		stats
+				Filled with the statistics.
+@return		The status of the call.
+*/
+ion_err_t
+oafh_stats(
+	ion_file_hashmap_t	*hash_map,
+	ion_hash_stats_t	*stats
+);
+
+/**
+@brief		Starts a new measurement period for the probe counters of a
+			map.
+
+@param		hash_map
+				The map to reset.
+@return		The status of the call.
+*/
+ion_err_t
+oafh_reset_stats(
+	ion_file_hashmap_t *hash_map
+);
+
 /**
 @brief		A simple hashing algorithm implementation.
 
@@ -269,6 +522,30 @@ oafh_compute_simple_hash(
 	int					size_of_key
 );
 
+/**
+@brief		A seeded hash over the whole key.
+
+@details	Hashes the key with @ref dictionary_hash_key, seeded with
+			@c seed of the map, and reduces it to a slot in the map.
+			Unlike @ref oafh_compute_simple_hash it uses every key byte,
+			so keys that share their leading @c int, or that are all
+			multiples of the map size, still spread over the table.
+
+@param		hashmap
+				The hash function is associated with.
+@param		key
+				The original key value to find hash value for.
+@param		size_of_key
+				The size of the key in bytes.
+@return		The hashed value for the key.
+*/
+ion_hash_t
+oafh_compute_seeded_hash(
+	ion_file_hashmap_t	*hashmap,
+	ion_key_t			key,
+	int					size_of_key
+);
+
 /*void
 static_hash_init(ion_dictonary_handler_t * client);*/
 
@@ -15,16 +15,34 @@ extern "C" {
 /*edefines file operations for arduino */
 #include "./../../file/SD_stdio_c_iface.h"
 
+#if !defined(ION_HASH_T_DEFINED)
+#define ION_HASH_T_DEFINED
+
 /**
-@brief		The position in the hashmap.
+@brief		The position in the hashmap, shared by both hash engines.
 */
 typedef int ion_hash_t;
+#endif
+
+/**
+@brief		Consecutive buckets of a map, read from its file in one go.
+*/
+typedef struct {
+	ion_byte_t	*buckets;	/**< Room for @c capacity buckets */
+	int			capacity;	/**< The most buckets the page holds */
+	int			first;		/**< The bucket at the start of @c buckets */
+	int			count;		/**< The buckets read into @c buckets */
+} ion_oafh_page_t;
 
 typedef struct oafdict_cursor {
 	ion_dict_cursor_t	super;			/**< Cursor supertype this type inherits from */
 	ion_hash_t			first;			/**<First visited spot*/
 	ion_hash_t			current;		/**<Currently visited spot*/
 	char				status;		/*todo what is this for again as there are two status */
+	ion_oafh_page_t		chunk;			/**< The buckets a scan last read, or
+										 none to read through the map's page */
+	uint32_t			version;		/**< The version of the map
+										 @c chunk was read at */
 } ion_oafdict_cursor_t;
 
 #if defined(__cplusplus)
@@ -44,6 +44,30 @@ oafdict_query(
 	return oafh_query((ion_file_hashmap_t *) dictionary->instance, key, value);
 }
 
+/**
+@brief		Returns a bucket of the map a cursor is over, through the
+			cursor's chunk if it has one.
+@details	The chunk is read again once the map has been written to.
+*/
+static ion_hash_bucket_t *
+oafdict_read_bucket(
+	ion_oafdict_cursor_t	*cursor,
+	int						loc
+) {
+	ion_file_hashmap_t *hash_map = (ion_file_hashmap_t *) (cursor->super.dictionary->instance);
+
+	if (NULL == cursor->chunk.buckets) {
+		return oafh_read_bucket(hash_map, loc);
+	}
+
+	if (cursor->version != hash_map->version) {
+		cursor->chunk.count = 0;
+		cursor->version		= hash_map->version;
+	}
+
+	return oafh_read_through(hash_map, &cursor->chunk, loc);
+}
+
 /**
 @brief			Starts scanning map looking for conditions that match
 				predicate and returns result.
@@ -63,22 +87,45 @@ oafdict_scan(
 	/* need to scan hashmap fully looking for values that satisfy - need to think about */
 	ion_file_hashmap_t *hash_map	= (ion_file_hashmap_t *) (cursor->super.dictionary->instance);
 
-	int loc							= (cursor->current + 1) % hash_map->map_size;
+	int loc							= cursor->current + 1;
 	/* this is the current position of the cursor */
 	/* and start scanning 1 ahead */
 
-	int record_size = SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size;
-
-	/* move to the correct position in the fie */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
-
 	ion_hash_bucket_t *item;
 
-	item = malloc(record_size);
+	/* keys are unique, so an equality cursor is done with the record its find found */
+	if (predicate_equality == cursor->super.predicate->type) {
+		return cs_end_of_results;
+	}
+
+	/* without a chunk, read through the map's page, fresh as the map may have changed since the last call */
+	hash_map->page.count = 0;
 
 	/* start at the current position, scan forward */
 	while (loc != cursor->first) {
-		fread(item, record_size, 1, hash_map->file);
+		if (loc >= hash_map->map_size) {
+			/* a scan of the whole map ends at the last slot, others wrap back to where they began */
+			if (cs_invalid_index == cursor->first) {
+				break;
+			}
+
+			loc = 0;
+			continue;
+		}
+
+#if ION_OAFH_USE_FINGERPRINTS
+
+		/* free buckets are skipped without reading them */
+		if ((NULL != hash_map->fingerprints) && ((ION_OAFH_FP_EMPTY == hash_map->fingerprints[loc]) || (ION_OAFH_FP_DELETED == hash_map->fingerprints[loc]))) {
+			loc++;
+			continue;
+		}
+
+#endif
+
+		if (NULL == (item = oafdict_read_bucket(cursor, loc))) {
+			break;
+		}
 
 		if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 			/* if empty, just skip to next cell */
@@ -87,28 +134,20 @@ oafdict_scan(
 		else {
 			/* check to see if the current key value satisfies the predicate */
 
-			/* TODO need to check key match; what's the most efficient way? */
-
-			ion_boolean_t key_satisfies_predicate = test_predicate(&(cursor->super), item->data);	/* assumes that the key is first */
+			/* the key is first, the value right after it */
+			ion_boolean_t key_satisfies_predicate = test_record_predicate(&(cursor->super), item->data, item->data + hash_map->super.record.key_size);
 
 			if (key_satisfies_predicate == boolean_true) {
 				cursor->current = loc;	/* this is the next index for value */
-				free(item);
 				return cs_valid_data;
 			}
 
 			/* If valid bucket is not found, advance current position. */
 			loc++;
 		}
-
-		if (loc >= hash_map->map_size) {
-			/* Perform wrapping */
-			loc = 0;
-		}
 	}
 
 	/* if you end up here, you've wrapped the entire data structure and not found a value */
-	free(item);
 	return cs_end_of_results;
 }
 
@@ -141,9 +180,7 @@ oafdict_next(
 		/* extract reference to map */
 		ion_file_hashmap_t *hash_map = ((ion_file_hashmap_t *) cursor->dictionary->instance);
 
-		/* assume that the value has been pre-allocated */
-		/* compute length of data record stored in map */
-		int data_length = hash_map->super.record.key_size + hash_map->super.record.value_size;
+		ion_hash_bucket_t *item;
 
 		if (cursor->status == cs_cursor_active) {
 			/* find the next valid entry */
@@ -164,14 +201,15 @@ oafdict_next(
 
 		/* the results are now ready //reference item at given position */
 
-		/* set position in file to read value */
-		fseek(hash_map->file, (SIZEOF(STATUS) + data_length) * oafdict_cursor->current	/* position is based on indexes (not abs file pos) */
-			+ SIZEOF(STATUS), SEEK_SET);
+		/* read through the map, as the file may be behind the pages it holds back */
+		if (NULL == (item = oafdict_read_bucket(oafdict_cursor, oafdict_cursor->current))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
 
-/*@todo this needs to be addressed in terms of return type
-*/
-		fread(record->key, hash_map->super.record.key_size, 1, hash_map->file);
-		fread(record->value, hash_map->super.record.value_size, 1, hash_map->file);
+		/* assume that the value has been pre-allocated */
+		memcpy(record->key, item->data, hash_map->super.record.key_size);
+		memcpy((ion_byte_t *) record->value + cursor->value_offset, item->data + hash_map->super.record.key_size + cursor->value_offset, cursor->value_size);
 
 		/* and update current cursor position */
 		return cursor->status;
@@ -206,31 +244,42 @@ oafdict_find(
 	ion_dict_cursor_t	**cursor
 ) {
 	/* allocate memory for cursor */
-	if ((*cursor = malloc(sizeof(ion_oafdict_cursor_t))) == NULL) {
+	if ((*cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_oafdict_cursor_t))) == NULL) {
 		return err_out_of_memory;
 	}
 
 	(*cursor)->dictionary			= dictionary;
 	(*cursor)->status				= cs_cursor_uninitialized;
+	(*cursor)->value_offset			= 0;
+	(*cursor)->value_size			= dictionary->instance->record.value_size;
 
 	/* bind destroy method for cursor */
 	(*cursor)->destroy				= oafdict_destroy_cursor;
+	(*cursor)->next_batch			= NULL;
 
 	/* bind correct next function */
 	(*cursor)->next					= oafdict_next;	/* this will use the correct value */
 
+	/* only scans of the whole map get a chunk of their own */
+	((ion_oafdict_cursor_t *) (*cursor))->chunk.buckets = NULL;
+
 	/* allocate predicate */
-	(*cursor)->predicate			= malloc(sizeof(ion_predicate_t));
+	(*cursor)->predicate			= ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t));
 	(*cursor)->predicate->type		= predicate->type;
 	(*cursor)->predicate->destroy	= predicate->destroy;
 
+	/* a predicate query scans as all records do, its filter tested in the chunk */
+	if (predicate_predicate == predicate->type) {
+		(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+	}
+
 	/* based on the type of predicate that is being used, need to create the correct cursor */
 	switch (predicate->type) {
 		case predicate_equality: {
 			/* as this is an equality, need to malloc for key as well */
-			if (((*cursor)->predicate->statement.equality.equality_value = malloc((((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
-				free((*cursor)->predicate);
-				free(*cursor);	/* cleanup */
+			if (((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, (((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);	/* cleanup */
 				return err_out_of_memory;
 			}
 
@@ -262,9 +311,9 @@ oafdict_find(
 
 		case predicate_range: {
 			/* as this is a range, need to malloc lower bound key */
-			if (((*cursor)->predicate->statement.range.lower_bound = malloc((((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
-				free((*cursor)->predicate);
-				free(*cursor);	/* cleanup */
+			if (((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, (((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);	/* cleanup */
 				return err_out_of_memory;
 			}
 
@@ -272,10 +321,10 @@ oafdict_find(
 			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, (((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size));
 
 			/* as this is a range, need to malloc upper bound key */
-			if (((*cursor)->predicate->statement.range.upper_bound = malloc((((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
-				free((*cursor)->predicate->statement.range.lower_bound);
-				free((*cursor)->predicate);
-				free(*cursor);	/* cleanup */
+			if (((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, (((ion_file_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);	/* cleanup */
 				return err_out_of_memory;
 			}
 
@@ -284,12 +333,39 @@ oafdict_find(
 		}
 
 		/* Range query will intentionally continue to all record code to get rid of duplicate statements. */
-		case predicate_all_records: {
+		case predicate_all_records:
+		case predicate_predicate: {
 			ion_oafdict_cursor_t	*oafdict_cursor = (ion_oafdict_cursor_t *) (*cursor);
-			ion_file_hashmap_t		*hash_map		= ((ion_file_hashmap_t *) dictionary->instance);
+			ion_file_hashmap_t		*hash_map		= (ion_file_hashmap_t *) dictionary->instance;
+			int						record_size		= SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size;
+
+			/* big reads of the file, which without room for them goes through the map's page */
+			oafdict_cursor->chunk.capacity	= ION_OAFH_SCAN_CHUNK_SIZE / record_size;
+			oafdict_cursor->chunk.first		= 0;
+			oafdict_cursor->chunk.count		= 0;
+			oafdict_cursor->version			= hash_map->version;
+
+			if (oafdict_cursor->chunk.capacity < hash_map->page.capacity) {
+				oafdict_cursor->chunk.capacity = hash_map->page.capacity;
+			}
+
+			if (oafdict_cursor->chunk.capacity > hash_map->map_size) {
+				oafdict_cursor->chunk.capacity = hash_map->map_size;
+			}
+
+#if ION_OAFH_USE_MMAP
+
+			/* a mapped file is scanned in place */
+			if (NULL == hash_map->map) {
+				oafdict_cursor->chunk.buckets = ion_alloc(ion_alloc_cursor, oafdict_cursor->chunk.capacity * record_size);
+			}
+
+#else
+			oafdict_cursor->chunk.buckets = ion_alloc(ion_alloc_cursor, oafdict_cursor->chunk.capacity * record_size);
+#endif
 
 			(*cursor)->status		= cs_cursor_initialized;
-			oafdict_cursor->first	= (hash_map->map_size) - 1;
+			oafdict_cursor->first	= cs_invalid_index;
 			oafdict_cursor->current = -1;
 
 			ion_err_t err = oafdict_scan(oafdict_cursor);
@@ -302,10 +378,6 @@ oafdict_find(
 			break;
 		}
 
-		case predicate_predicate: {
-			break;
-		}
-
 		default: {
 			return err_invalid_predicate;	/* * Invalid predicate supplied */
 			break;
@@ -315,6 +387,45 @@ oafdict_find(
 	return err_ok;
 }
 
+/**
+@brief			Creates an open address file hash instance hashing its
+				keys with the given function.
+
+@param			hash_function
+					The @ref ion_hash_function_t to hash keys with.
+
+@see			oafdict_create_dictionary for the other parameters.
+ */
+static ion_err_t
+oafdict_create_hashed(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_byte_t					hash_function,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	/* this is the instance of the hashmap */
+	dictionary->instance			= ion_alloc(ion_alloc_other, sizeof(ion_file_hashmap_t));
+
+	dictionary->instance->compare	= compare;
+
+	/* this registers the dictionary the dictionary */
+	oafh_initialize((ion_file_hashmap_t *) dictionary->instance, (hash_function_modulo == hash_function) ? oafh_compute_simple_hash : oafh_compute_seeded_hash, key_type, key_size, value_size, dictionary_size, id);/* just pick an arbitary size for testing atm */
+
+	/*TODO The correct comparison operator needs to be bound at run time
+	 * based on the type of key defined
+	*/
+
+	/* register the correct handler */
+	dictionary->handler = handler;	/* todo: need to check to make sure that the handler is registered */
+
+	return 0;
+}
+
 /**
 @brief			Opens a specific open address file hash instance of a dictionary.
 
@@ -337,7 +448,7 @@ oafdict_open_dictionary(
 	ion_dictionary_config_info_t	*config,
 	ion_dictionary_compare_t		compare
 ) {
-	return oafdict_create_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+	return oafdict_create_hashed(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, config->hash_function, compare, handler, dictionary);
 }
 
 /**
@@ -370,6 +481,54 @@ oafdict_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief		Pushes every write of a file hash dictionary through to storage.
+*/
+static ion_err_t
+oafdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_file_hashmap_t	*hash_map	= (ion_file_hashmap_t *) dictionary->instance;
+	ion_err_t			err			= oafh_sync(hash_map);
+
+	if (err_ok == err) {
+		err = ion_fsync_stream(hash_map->file);
+	}
+
+	return err;
+}
+
+/**
+@brief		Tells the size of an open address file hash dictionary, see
+			@ref dictionary_get_info. Its buckets are its pages; how many
+			of them are full is not kept.
+*/
+static ion_err_t
+oafdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_file_hashmap_t	*hash_map	= (ion_file_hashmap_t *) dictionary->instance;
+	long				record_size	= SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size;
+
+	info->pages			= hash_map->map_size;
+	info->file_bytes	= hash_map->map_size * record_size;
+	info->memory_bytes	= hash_map->page.capacity * record_size;
+
+#if ION_OAFH_WRITE_BACK_PAGES > 0
+	info->memory_bytes += ION_OAFH_WRITE_BACK_PAGES * hash_map->page.capacity * record_size;
+#endif
+#if ION_OAFH_USE_FINGERPRINTS
+
+	if (NULL != hash_map->fingerprints) {
+		info->memory_bytes += hash_map->map_size;
+	}
+
+#endif
+
+	return err_ok;
+}
+
 void
 oafdict_init(
 	ion_dictionary_handler_t *handler
@@ -383,6 +542,13 @@ oafdict_init(
 	handler->delete_dictionary	= oafdict_delete_dictionary;
 	handler->open_dictionary	= oafdict_open_dictionary;
 	handler->close_dictionary	= oafdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= oafdict_sync_dictionary;
+	handler->get_info			= oafdict_get_info;
+	handler->bulk_load			= NULL;
 }
 
 ion_status_t
@@ -405,25 +571,10 @@ oafdict_create_dictionary(
 	ion_dictionary_handler_t	*handler,
 	ion_dictionary_t			*dictionary
 ) {
-	UNUSED(id);
-	/* this is the instance of the hashmap */
-	dictionary->instance			= malloc(sizeof(ion_file_hashmap_t));
-
-	dictionary->instance->compare	= compare;
-
-	/* this registers the dictionary the dictionary */
-	oafh_initialize((ion_file_hashmap_t *) dictionary->instance, oafh_compute_simple_hash, key_type, key_size, value_size, dictionary_size, id);/* just pick an arbitary size for testing atm */
-
-	/*TODO The correct comparison operator needs to be bound at run time
-	 * based on the type of key defined
-	*/
-
-	/* register the correct handler */
-	dictionary->handler = handler;	/* todo: need to check to make sure that the handler is registered */
-
-	return 0;
+	return oafdict_create_hashed(id, key_type, key_size, value_size, dictionary_size, hash_function_seeded, compare, handler, dictionary);
 }
 
+
 ion_status_t
 oafdict_delete(
 	ion_dictionary_t	*dictionary,
@@ -438,7 +589,7 @@ oafdict_delete_dictionary(
 ) {
 	ion_err_t result = oafh_destroy((ion_file_hashmap_t *) dictionary->instance);
 
-	free(dictionary->instance);
+	ion_free(dictionary->instance);
 	dictionary->instance = NULL;/* When releasing memory, set pointer to NULL */
 	return result;
 }
@@ -483,7 +634,23 @@ void
 oafdict_destroy_cursor(
 	ion_dict_cursor_t **cursor
 ) {
+	ion_free(((ion_oafdict_cursor_t *) (*cursor))->chunk.buckets);
 	(*cursor)->predicate->destroy(&(*cursor)->predicate);
-	free(*cursor);
+	ion_free(*cursor);
 	*cursor = NULL;
 }
+
+ion_err_t
+oafdict_stats(
+	ion_dictionary_t	*dictionary,
+	ion_hash_stats_t	*stats
+) {
+	return oafh_stats((ion_file_hashmap_t *) dictionary->instance, stats);
+}
+
+ion_err_t
+oafdict_reset_stats(
+	ion_dictionary_t *dictionary
+) {
+	return oafh_reset_stats((ion_file_hashmap_t *) dictionary->instance);
+}
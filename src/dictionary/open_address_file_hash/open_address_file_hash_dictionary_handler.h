@@ -252,6 +252,35 @@ oafdict_destroy_cursor(
 	ion_dict_cursor_t **cursor
 );
 
+/**
+@brief		Reads the probe and bucket statistics of an open address file
+			hash dictionary, see @ref oafh_stats.
+
+@param		dictionary
+				An open address file hash dictionary.
+@param		stats
+				Filled with the statistics.
+@return		The status of the call.
+*/
+ion_err_t
+oafdict_stats(
+	ion_dictionary_t	*dictionary,
+	ion_hash_stats_t	*stats
+);
+
+/**
+@brief		Starts a new measurement period for an open address file hash
+			dictionary.
+
+@param		dictionary
+				An open address file hash dictionary.
+@return		The status of the call.
+*/
+ion_err_t
+oafdict_reset_stats(
+	ion_dictionary_t *dictionary
+);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -15,6 +15,773 @@
 
 #include "open_address_hash.h"
 
+#if defined(__GNUC__)
+#define ION_OAH_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define ION_OAH_PREFETCH(address) ((void) 0)
+#endif
+
+/**
+@brief		The alignment tables are allocated at.
+*/
+#if ION_OAH_CACHE_LINE > ION_OAH_BUCKET_ALIGN
+#define ION_OAH_TABLE_ALIGN ION_OAH_CACHE_LINE
+#else
+#define ION_OAH_TABLE_ALIGN ION_OAH_BUCKET_ALIGN
+#endif
+
+/**
+@brief		The padding of a bucket ahead of its status byte, which brings
+			its key onto @ref ION_OAH_BUCKET_ALIGN.
+*/
+#define ION_OAH_BUCKET_LEAD (ION_OAH_BUCKET_ALIGN - 1)
+
+int
+oah_get_location(
+	ion_hash_t	num,
+	int			size
+) {
+	return num % size;
+}
+
+int
+oah_bucket_size(
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size
+) {
+	int size = (ION_OAH_BUCKET_LEAD + SIZEOF(STATUS) + key_size + value_size + ION_OAH_BUCKET_ALIGN - 1) / ION_OAH_BUCKET_ALIGN * ION_OAH_BUCKET_ALIGN;
+
+#if ION_OAH_CACHE_LINE > 0
+
+	int line_share = ION_OAH_BUCKET_ALIGN;
+
+	if (size > ION_OAH_CACHE_LINE) {
+		return (size + ION_OAH_CACHE_LINE - 1) / ION_OAH_CACHE_LINE * ION_OAH_CACHE_LINE;
+	}
+
+	/* a power of two divides the line, so buckets tile it */
+	while (line_share < size) {
+		line_share *= 2;
+	}
+
+	size = line_share;
+#endif
+
+	return size;
+}
+
+/**
+@brief		Allocates room for the buckets of a table.
+@details	The block is over-allocated so that it can start on
+			@ref ION_OAH_TABLE_ALIGN, and the distance to its start is kept
+			in the byte before that for @ref oah_entry_free.
+@return		Where the first bucket goes, or @c NULL.
+*/
+static char *
+oah_entry_allocate(
+	size_t bytes
+) {
+#if ION_OAH_TABLE_ALIGN > 1
+
+	ion_byte_t	*block = ion_alloc(ion_alloc_node, bytes + ION_OAH_TABLE_ALIGN);
+	int			offset;
+
+	if (NULL == block) {
+		return NULL;
+	}
+
+	offset				= ION_OAH_TABLE_ALIGN - (int) ((uintptr_t) block % ION_OAH_TABLE_ALIGN);
+	block[offset - 1]	= (ion_byte_t) (offset - 1);
+
+	return (char *) block + offset + ION_OAH_BUCKET_LEAD;
+#else
+	return ion_alloc(ion_alloc_node, bytes);
+#endif
+}
+
+/**
+@brief		Returns the start of the buckets of a table, padding included,
+			as written to and read from snapshots.
+*/
+static char *
+oah_entry_base(
+	char *entry
+) {
+	return entry - ION_OAH_BUCKET_LEAD;
+}
+
+/**
+@brief		Frees a table allocated by @ref oah_entry_allocate.
+*/
+static void
+oah_entry_free(
+	char *entry
+) {
+	if (NULL == entry) {
+		return;
+	}
+
+#if ION_OAH_TABLE_ALIGN > 1
+
+	ion_byte_t *aligned = (ion_byte_t *) oah_entry_base(entry);
+
+	ion_free(aligned - aligned[-1] - 1);
+#else
+	ion_free(entry);
+#endif
+}
+
+#if ION_OAH_USE_CONTROL_BYTES
+
+/* Control bytes of free buckets have their top bit set, those of used
+   buckets hold a 7-bit fingerprint of the key. */
+#define ION_OAH_CTRL_EMPTY		0x80
+#define ION_OAH_CTRL_DELETED	0xFE
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+/**
+@brief		A group of control bytes, matched with one SSE2 compare.
+*/
+typedef __m128i ion_oah_group_t;
+
+/**
+@brief		One bit per control byte of a group, lowest bucket first.
+*/
+typedef uint32_t ion_oah_mask_t;
+
+#define ION_OAH_GROUP_WIDTH 16
+#define ION_OAH_MASK_SHIFT	0
+
+static ion_oah_group_t
+oah_group_load(
+	const ion_byte_t *ctrl
+) {
+	return _mm_loadu_si128((const __m128i *) ctrl);
+}
+
+static ion_oah_mask_t
+oah_group_match(
+	ion_oah_group_t group,
+	ion_byte_t		tag
+) {
+	return (ion_oah_mask_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) tag)));
+}
+
+static ion_oah_mask_t
+oah_group_match_empty(
+	ion_oah_group_t group
+) {
+	return (ion_oah_mask_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) ION_OAH_CTRL_EMPTY)));
+}
+
+static ion_oah_mask_t
+oah_group_match_free(
+	ion_oah_group_t group
+) {
+	return (ion_oah_mask_t) _mm_movemask_epi8(group);
+}
+
+#else
+
+/* Without SIMD the control bytes of a group are packed into one word and
+   matched with word-wide (SWAR) arithmetic. AVR builds use 4 byte groups. */
+#if defined(ARDUINO)
+typedef uint32_t ion_oah_group_t;
+#else
+typedef uint64_t ion_oah_group_t;
+#endif
+
+/* The top bit of each byte of the mask is set for a matching bucket. */
+typedef ion_oah_group_t ion_oah_mask_t;
+
+#define ION_OAH_GROUP_WIDTH ((int) sizeof(ion_oah_group_t))
+#define ION_OAH_MASK_SHIFT	3
+#define ION_OAH_GROUP_LSBS	((ion_oah_group_t) -1 / 0xFF)
+#define ION_OAH_GROUP_MSBS	(ION_OAH_GROUP_LSBS << 7)
+
+static ion_oah_group_t
+oah_group_load(
+	const ion_byte_t *ctrl
+) {
+	ion_oah_group_t group = 0;
+	int				i;
+
+	/* byte i of the group lands in bits 8i, whatever the host byte order */
+	for (i = ION_OAH_GROUP_WIDTH - 1; i >= 0; i--) {
+		group = (group << 8) | ctrl[i];
+	}
+
+	return group;
+}
+
+static ion_oah_mask_t
+oah_group_match(
+	ion_oah_group_t group,
+	ion_byte_t		tag
+) {
+	ion_oah_group_t x = group ^ (ION_OAH_GROUP_LSBS * tag);
+
+	/* may flag a byte just above a true match; the key compare sorts that out */
+	return (x - ION_OAH_GROUP_LSBS) & ~x & ION_OAH_GROUP_MSBS;
+}
+
+static ion_oah_mask_t
+oah_group_match_empty(
+	ion_oah_group_t group
+) {
+	/* of the two free tags only EMPTY has bit 1 clear */
+	return group & ~(group << 6) & ION_OAH_GROUP_MSBS;
+}
+
+static ion_oah_mask_t
+oah_group_match_free(
+	ion_oah_group_t group
+) {
+	return group & ION_OAH_GROUP_MSBS;
+}
+
+#endif
+
+/**
+@brief		Removes the lowest match from @p mask.
+@return		The offset in the group of the bucket it stood for.
+*/
+static int
+oah_mask_next(
+	ion_oah_mask_t *mask
+) {
+	int offset = __builtin_ctzll((unsigned long long) *mask) >> ION_OAH_MASK_SHIFT;
+
+	*mask &= *mask - 1;
+
+	return offset;
+}
+
+/**
+@brief		The number of control bytes kept for a table of @p size
+			buckets. The first group is repeated past the end, so a group
+			can be loaded from any bucket without wrapping.
+*/
+#define ION_OAH_CTRL_BYTES(size) ((size) + ION_OAH_GROUP_WIDTH - 1)
+
+/**
+@brief		The fingerprint a key is tagged with in the control bytes.
+*/
+static ion_byte_t
+oah_tag(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key
+) {
+	return (ion_byte_t) (dictionary_hash_key(hash_map->super.key_type, key, hash_map->super.record.key_size, hash_map->seed ^ 0x2545F491UL) >> 25);
+}
+
+#endif
+
+/**
+@brief		Returns the buckets of the current table, or of the previous
+			one while a resize is in progress.
+*/
+static char *
+oah_table_entry(
+	ion_hashmap_t	*hash_map,
+	ion_boolean_t	old
+) {
+	return old ? hash_map->old_entry : hash_map->entry;
+}
+
+/**
+@brief		Returns the size of the current or the previous table.
+*/
+static int
+oah_table_size(
+	ion_hashmap_t	*hash_map,
+	ion_boolean_t	old
+) {
+	return old ? hash_map->old_size : hash_map->map_size;
+}
+
+/**
+@brief		Returns a bucket of one of the tables of a map.
+*/
+static ion_hash_bucket_t *
+oah_bucket(
+	ion_hashmap_t	*hash_map,
+	ion_boolean_t	old,
+	int				loc
+) {
+	return (ion_hash_bucket_t *) (oah_table_entry(hash_map, old) + hash_map->bucket_size * loc);
+}
+
+/**
+@brief		Allocates the buckets, and control bytes if used, of a table
+			of @p size buckets, all empty.
+@return		@c err_ok, or @c err_out_of_memory with nothing allocated.
+*/
+static ion_err_t
+oah_table_allocate(
+	ion_hashmap_t	*hash_map,
+	int				size,
+	char			**entry,
+	ion_byte_t		**ctrl
+) {
+	int i;
+
+	*entry = oah_entry_allocate((size_t) hash_map->bucket_size * size);
+
+	if (NULL == *entry) {
+		return err_out_of_memory;
+	}
+
+	for (i = 0; i < size; i++) {
+		((ion_hash_bucket_t *) (*entry + hash_map->bucket_size * i))->status = ION_EMPTY;
+	}
+
+#if ION_OAH_USE_CONTROL_BYTES
+	*ctrl = ion_alloc(ion_alloc_node, ION_OAH_CTRL_BYTES(size));
+
+	if (NULL == *ctrl) {
+		oah_entry_free(*entry);
+		*entry = NULL;
+		return err_out_of_memory;
+	}
+
+	memset(*ctrl, ION_OAH_CTRL_EMPTY, ION_OAH_CTRL_BYTES(size));
+#else
+	*ctrl = NULL;
+#endif
+
+	return err_ok;
+}
+
+/**
+@brief		Sets the status of a bucket, along with its control byte and
+			the copies of it past the end of the control bytes.
+*/
+static void
+oah_set_status(
+	ion_hashmap_t	*hash_map,
+	ion_boolean_t	old,
+	int				loc,
+	char			status
+) {
+	oah_bucket(hash_map, old, loc)->status = status;
+
+#if ION_OAH_USE_CONTROL_BYTES
+
+	ion_byte_t	*ctrl	= old ? hash_map->old_ctrl : hash_map->ctrl;
+	int			size	= oah_table_size(hash_map, old);
+	ion_byte_t	tag		= ION_OAH_CTRL_EMPTY;
+	int			i;
+
+	if (ION_IN_USE == status) {
+		tag = oah_tag(hash_map, oah_bucket(hash_map, old, loc)->data);
+	}
+	else if (ION_DELETED == status) {
+		tag = ION_OAH_CTRL_DELETED;
+	}
+
+	for (i = loc; i < ION_OAH_CTRL_BYTES(size); i += size) {
+		ctrl[i] = tag;
+	}
+#endif
+}
+
+void
+oah_rebuild_control_bytes(
+	ion_hashmap_t *hash_map
+) {
+#if ION_OAH_USE_CONTROL_BYTES
+
+	int i;
+
+	for (i = 0; i < hash_map->map_size; i++) {
+		oah_set_status(hash_map, boolean_false, i, oah_bucket(hash_map, boolean_false, i)->status);
+	}
+#else
+	UNUSED(hash_map);
+#endif
+}
+
+/**
+@brief		Computes where probing for @p key starts in a table of @p size
+			buckets.
+@details	The hash functions reduce by @c map_size, so it is swapped for
+			the size of the table asked about while the hash is taken.
+*/
+static int
+oah_home_slot(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	int				size
+) {
+	int			map_size = hash_map->map_size;
+	ion_hash_t	hash;
+
+	hash_map->map_size	= size;
+	hash				= hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
+	hash_map->map_size	= map_size;
+
+	return oah_get_location(hash, size);
+}
+
+/**
+@brief		Probes one table of a map for @p key, from its home slot
+			@p loc and with its fingerprint @p tag already computed.
+@details	With control bytes, a group of them is matched against the
+			key's fingerprint at a time and only fingerprint matches have
+			their keys compared. Without them @p tag is unused.
+@param		probes
+				If not @c NULL, receives the probe length, see
+				@ref ion_hash_op_stats_t.
+@return		The bucket holding the key, or @c cs_invalid_index.
+*/
+static int
+oah_probe_from(
+	ion_hashmap_t	*hash_map,
+	ion_boolean_t	old,
+	ion_key_t		key,
+	int				loc,
+	ion_byte_t		tag,
+	int				*probes
+) {
+	int size	= oah_table_size(hash_map, old);
+	int count	= 0;
+	int length	= size;
+	int found	= cs_invalid_index;
+
+#if ION_OAH_USE_CONTROL_BYTES
+
+	ion_byte_t		*ctrl = old ? hash_map->old_ctrl : hash_map->ctrl;
+	ion_oah_group_t group;
+	ion_oah_mask_t	match;
+	int				slot;
+
+	while ((count < size) && (cs_invalid_index == found)) {
+		group	= oah_group_load(ctrl + loc);
+		match	= oah_group_match(group, tag);
+
+		while (0 != match) {
+			slot = oah_mask_next(&match);
+
+			if (ION_IS_EQUAL == hash_map->super.compare(oah_bucket(hash_map, old, (loc + slot) % size)->data, key, hash_map->super.record.key_size)) {
+				found	= (loc + slot) % size;
+				length	= count + slot + 1;
+				break;
+			}
+		}
+
+		/* a key is never stored past an empty bucket on its probe path */
+		match = oah_group_match_empty(group);
+
+		if ((cs_invalid_index == found) && (0 != match)) {
+			length = count + oah_mask_next(&match) + 1;
+			break;
+		}
+
+		count	+= ION_OAH_GROUP_WIDTH;
+		loc		= (loc + ION_OAH_GROUP_WIDTH) % size;
+	}
+
+	/* the last group may run past the bucket probing started from */
+	if (length > size) {
+		length = size;
+	}
+#else
+
+	ion_hash_bucket_t *item;
+
+	UNUSED(tag);
+
+	while (count != size) {
+		item = oah_bucket(hash_map, old, loc);
+
+		if (item->status == ION_EMPTY) {
+			length = count + 1;
+			break;
+		}
+
+		if ((item->status != ION_DELETED) && (ION_IS_EQUAL == hash_map->super.compare(item->data, key, hash_map->super.record.key_size))) {
+			found	= loc;
+			length	= count + 1;
+			break;
+		}
+
+		count++;
+		loc++;
+
+		if (loc >= size) {
+			loc = 0;
+		}
+	}
+#endif
+
+	if (NULL != probes) {
+		*probes = length;
+	}
+
+	return found;
+}
+
+/**
+@brief		The fingerprint @ref oah_probe_from takes for @p key, or 0
+			without control bytes.
+*/
+static ion_byte_t
+oah_key_tag(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key
+) {
+#if ION_OAH_USE_CONTROL_BYTES
+	return oah_tag(hash_map, key);
+#else
+	UNUSED(hash_map);
+	UNUSED(key);
+	return 0;
+#endif
+}
+
+/**
+@brief		Probes one table of a map for @p key.
+@return		The bucket holding the key, or @c cs_invalid_index.
+*/
+static int
+oah_probe(
+	ion_hashmap_t	*hash_map,
+	ion_boolean_t	old,
+	ion_key_t		key
+) {
+	return oah_probe_from(hash_map, old, key, oah_home_slot(hash_map, key, oah_table_size(hash_map, old)), oah_key_tag(hash_map, key), NULL);
+}
+
+/**
+@brief		Counts an operation in the statistics of a map, unless it
+			keeps none.
+*/
+static void
+oah_count_probes(
+	ion_hashmap_t		*hash_map,
+	ion_hash_op_stats_t *op,
+	int					home,
+	int					probes
+) {
+	if (hash_map->keep_stats) {
+		dictionary_hash_count_probes(&hash_map->stats, op, home, probes, hash_map->map_size);
+	}
+}
+
+/**
+@brief		Finds the first empty or deleted bucket on the probe path of
+			@p key in the current table.
+@param		probes
+				If not @c NULL, receives the probe length to the bucket.
+@return		The bucket, or @c cs_invalid_index if the table is full.
+*/
+static int
+oah_free_slot(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	int				*probes
+) {
+	int loc		= oah_home_slot(hash_map, key, hash_map->map_size);
+	int count	= 0;
+
+#if ION_OAH_USE_CONTROL_BYTES
+
+	ion_oah_mask_t	free_slots;
+	int				slot;
+
+	while (count < hash_map->map_size) {
+		free_slots = oah_group_match_free(oah_group_load(hash_map->ctrl + loc));
+
+		if (0 != free_slots) {
+			slot = oah_mask_next(&free_slots);
+
+			if (NULL != probes) {
+				*probes = count + slot + 1;
+			}
+
+			return (loc + slot) % hash_map->map_size;
+		}
+
+		count	+= ION_OAH_GROUP_WIDTH;
+		loc		= (loc + ION_OAH_GROUP_WIDTH) % hash_map->map_size;
+	}
+#else
+
+	ion_hash_bucket_t *item;
+
+	while (count != hash_map->map_size) {
+		item = oah_bucket(hash_map, boolean_false, loc);
+
+		if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
+			if (NULL != probes) {
+				*probes = count + 1;
+			}
+
+			return loc;
+		}
+
+		count++;
+		loc++;
+
+		if (loc >= hash_map->map_size) {
+			loc = 0;
+		}
+	}
+#endif
+
+	return cs_invalid_index;
+}
+
+/**
+@brief		Empties a bucket of the current table without leaving a
+			tombstone.
+@details	Walks the cluster after @p hole and moves back every record
+			whose probe path passes through the hole, so each record stays
+			reachable from its home bucket with no empty bucket in
+			between. Probe lengths therefore stay bounded under sustained
+			inserts and deletes. Tombstones left by earlier versions are
+			stepped over.
+*/
+static void
+oah_backward_shift(
+	ion_hashmap_t	*hash_map,
+	int				hole
+) {
+	int					size	= hash_map->map_size;
+	int					loc		= hole;
+	int					count;
+	int					home;
+	ion_hash_bucket_t	*item;
+
+	for (count = 1; count < size; count++) {
+		loc		= (loc + 1) % size;
+		item	= oah_bucket(hash_map, boolean_false, loc);
+
+		if (item->status == ION_EMPTY) {
+			break;
+		}
+
+		if (item->status != ION_IN_USE) {
+			continue;
+		}
+
+		home = oah_home_slot(hash_map, item->data, size);
+
+		/* the record may move back if the hole lies between its home and it */
+		if ((loc - home + size) % size >= (loc - hole + size) % size) {
+			memcpy(oah_bucket(hash_map, boolean_false, hole)->data, item->data, hash_map->super.record.key_size + hash_map->super.record.value_size);
+			oah_set_status(hash_map, boolean_false, hole, ION_IN_USE);
+			hole = loc;
+		}
+	}
+
+	oah_set_status(hash_map, boolean_false, hole, ION_EMPTY);
+}
+
+/**
+@brief		Moves a record of the previous table into the current one.
+@details	The current table is sized to hold every record of the map, so
+			a free bucket is always found. The old bucket becomes a
+			tombstone rather than being shifted over, since shifting would
+			carry records back past the bucket the resize moves next. The
+			tombstones go away with the old table.
+@return		The bucket the record now occupies in @c entry.
+*/
+static int
+oah_move_record(
+	ion_hashmap_t	*hash_map,
+	int				old_loc
+) {
+	ion_hash_bucket_t	*from	= oah_bucket(hash_map, boolean_true, old_loc);
+	int					loc		= oah_free_slot(hash_map, from->data, NULL);
+
+	memcpy(oah_bucket(hash_map, boolean_false, loc)->data, from->data, hash_map->super.record.key_size + hash_map->super.record.value_size);
+	oah_set_status(hash_map, boolean_false, loc, ION_IN_USE);
+	oah_set_status(hash_map, boolean_true, old_loc, ION_DELETED);
+
+	return loc;
+}
+
+/**
+@brief		Frees the previous table once a resize has drained it.
+*/
+static void
+oah_release_old_table(
+	ion_hashmap_t *hash_map
+) {
+	oah_entry_free(hash_map->old_entry);
+	hash_map->old_entry = NULL;
+#if ION_OAH_USE_CONTROL_BYTES
+	ion_free(hash_map->old_ctrl);
+	hash_map->old_ctrl	= NULL;
+#endif
+}
+
+/**
+@brief		Moves up to @p steps buckets of the previous table, releasing it
+			once it has been drained.
+*/
+static void
+oah_rehash_step(
+	ion_hashmap_t	*hash_map,
+	int				steps
+) {
+	while ((NULL != hash_map->old_entry) && (steps-- > 0)) {
+		if (oah_bucket(hash_map, boolean_true, hash_map->old_next)->status == ION_IN_USE) {
+			oah_move_record(hash_map, hash_map->old_next);
+		}
+
+		if (++hash_map->old_next >= hash_map->old_size) {
+			oah_release_old_table(hash_map);
+		}
+	}
+}
+
+void
+oah_finish_rehash(
+	ion_hashmap_t *hash_map
+) {
+	while (NULL != hash_map->old_entry) {
+		oah_rehash_step(hash_map, hash_map->old_size);
+	}
+}
+
+/**
+@brief		Starts moving the records of a map into a table of @p size
+			buckets.
+@details	If the new table cannot be allocated the map keeps its current
+			table, and inserts fail with @c err_max_capacity once it fills
+			as they would in a map that is not resizable.
+*/
+static void
+oah_resize(
+	ion_hashmap_t	*hash_map,
+	int				size
+) {
+	char		*entry;
+	ion_byte_t	*ctrl;
+
+	oah_finish_rehash(hash_map);
+
+	if (err_ok != oah_table_allocate(hash_map, size, &entry, &ctrl)) {
+		return;
+	}
+
+	hash_map->old_entry = hash_map->entry;
+	hash_map->old_size	= hash_map->map_size;
+	hash_map->old_next	= 0;
+	hash_map->entry		= entry;
+	hash_map->map_size	= size;
+#if ION_OAH_USE_CONTROL_BYTES
+	hash_map->old_ctrl	= hash_map->ctrl;
+	hash_map->ctrl		= ctrl;
+#endif
+}
+
 ion_err_t
 oah_initialize(
 	ion_hashmap_t *hashmap,
@@ -24,7 +791,7 @@ oah_initialize(
 	ion_value_size_t value_size,
 	int size
 ) {
-	int i;
+	ion_byte_t *ctrl;
 
 	hashmap->write_concern				= wc_insert_unique;			/* By default allow unique inserts only */
 	hashmap->super.record.key_size		= key_size;
@@ -35,32 +802,34 @@ oah_initialize(
 
 	/* The hash map is allocated as a single contiguous array*/
 	hashmap->map_size		= size;
-	hashmap->entry			= malloc((hashmap->super.record.key_size + hashmap->super.record.value_size + 1) * hashmap->map_size);
+	hashmap->bucket_size	= oah_bucket_size(key_size, value_size);
 	/* Allows for binding of different hash function depending on requirements. */
 	hashmap->compute_hash	= (*hashing_function);
-
-	if (NULL == hashmap->entry) {
-		return 1;
-	}
+	hashmap->seed			= 0;
+	hashmap->resizable		= boolean_false;
+	hashmap->count			= 0;
+	hashmap->min_size		= size;
+	hashmap->old_entry		= NULL;
+	hashmap->old_size		= 0;
+	hashmap->old_next		= 0;
+	hashmap->keep_stats		= boolean_true;
+	memset(&hashmap->stats, 0, sizeof(hashmap->stats));
 
 #if ION_DEBUG
 	printf("Initializing hash table\n");
 #endif
 
-	/* Initialize hash table */
-	for (i = 0; i < size; i++) {
-		((ion_hash_bucket_t *) (hashmap->entry + ((hashmap->super.record.key_size + hashmap->super.record.value_size + SIZEOF(STATUS)) * i)))->status = ION_EMPTY;
+	if (err_ok != oah_table_allocate(hashmap, size, &hashmap->entry, &ctrl)) {
+		hashmap->entry = NULL;
+		return 1;
 	}
 
-	return 0;
-}
+#if ION_OAH_USE_CONTROL_BYTES
+	hashmap->ctrl			= ctrl;
+	hashmap->old_ctrl		= NULL;
+#endif
 
-int
-oah_get_location(
-	ion_hash_t	num,
-	int			size
-) {
-	return num % size;
+	return 0;
 }
 
 ion_err_t
@@ -72,9 +841,18 @@ oah_destroy(
 	hash_map->super.record.key_size		= 0;
 	hash_map->super.record.value_size	= 0;
 
+	if (hash_map->old_entry != NULL) {
+		oah_release_old_table(hash_map);
+	}
+
+#if ION_OAH_USE_CONTROL_BYTES
+	ion_free(hash_map->ctrl);
+	hash_map->ctrl = NULL;
+#endif
+
 	if (hash_map->entry != NULL) {
 		/* check to ensure that you are not freeing something already free */
-		free(hash_map->entry);
+		oah_entry_free(hash_map->entry);
 		hash_map->entry = NULL;	/*  */
 		return err_ok;
 	}
@@ -83,6 +861,42 @@ oah_destroy(
 	}
 }
 
+/**
+@brief		Finds @p key in a map, moving it into the current table if a
+			resize has not moved it yet.
+@param		home
+				Receives the home bucket of the key in the current table.
+@param		probes
+				Receives the probe length in the current table.
+@return		The bucket of @c entry holding the key, or
+			@c cs_invalid_index.
+*/
+static int
+oah_locate(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	int				*home,
+	int				*probes
+) {
+	int loc;
+	int old_loc;
+
+	*home	= oah_home_slot(hash_map, key, hash_map->map_size);
+	loc		= oah_probe_from(hash_map, boolean_false, key, *home, oah_key_tag(hash_map, key), probes);
+
+	if ((cs_invalid_index == loc) && (NULL != hash_map->old_entry)) {
+		/* not moved yet; move it now so the location refers to the current table */
+		old_loc = oah_probe(hash_map, boolean_true, key);
+
+		if (cs_invalid_index != old_loc) {
+			loc		= oah_move_record(hash_map, old_loc);
+			*probes = (loc - *home + hash_map->map_size) % hash_map->map_size + 1;
+		}
+	}
+
+	return loc;
+}
+
 ion_status_t
 oah_update(
 	ion_hashmap_t	*hash_map,
@@ -106,62 +920,59 @@ oah_insert(
 	ion_key_t		key,
 	ion_value_t		value
 ) {
-	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);	/* compute hash value for given key */
-
-	int loc			= oah_get_location(hash, hash_map->map_size);
+	int					loc;
+	int					home;
+	int					probes;
+	ion_hash_bucket_t	*item;
 
-	/* Scan until find an empty location - oah_insert if found */
-	int count		= 0;
-
-	ion_hash_bucket_t *item;
+	if (hash_map->resizable) {
+		oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+	}
 
-	while (count != hash_map->map_size) {
-		item = ((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc)));
+	loc = oah_locate(hash_map, key, &home, &probes);
 
-		if (item->status == ION_IN_USE) {
-			/* if a cell is in use, need to key to */
+	if (cs_invalid_index != loc) {
+		oah_count_probes(hash_map, &hash_map->stats.insert, home, probes);
+		item = oah_bucket(hash_map, boolean_false, loc);
 
-			if (hash_map->super.compare(item->data, key, hash_map->super.record.key_size) == ION_IS_EQUAL) {
-				if (hash_map->write_concern == wc_insert_unique) {
-					/* allow unique entries only */
-					return ION_STATUS_ERROR(err_duplicate_key);
-				}
-				else if (hash_map->write_concern == wc_update) {
-					/* allows for values to be updated */
-					memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
-					return ION_STATUS_OK(1);
-				}
-				else {
-					return ION_STATUS_ERROR(err_write_concern);	/* there is a configuration issue with write concern */
-				}
-			}
+		if (hash_map->write_concern == wc_insert_unique) {
+			/* allow unique entries only */
+			return ION_STATUS_ERROR(err_duplicate_key);
 		}
-		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
-			/* problem is here with base types as it is just an array of data.  Need better way */
-			item->status = ION_IN_USE;
-			memcpy(item->data, key, (hash_map->super.record.key_size));
+		else if (hash_map->write_concern == wc_update) {
+			/* allows for values to be updated */
 			memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
 			return ION_STATUS_OK(1);
 		}
+		else {
+			return ION_STATUS_ERROR(err_write_concern);	/* there is a configuration issue with write concern */
+		}
+	}
 
-		loc++;
+	if (hash_map->resizable && (ION_OAH_GROW_LOAD_PERCENT > 0) && (NULL == hash_map->old_entry) && ((long) (hash_map->count + 1) * 100 > (long) hash_map->map_size * ION_OAH_GROW_LOAD_PERCENT)) {
+		oah_resize(hash_map, hash_map->map_size * 2);
+	}
 
-		if (loc >= hash_map->map_size) {
-			/* Perform wrapping */
-			loc = 0;
-		}
+	loc = oah_free_slot(hash_map, key, &probes);
 
+	if (cs_invalid_index == loc) {
 #if ION_DEBUG
-		printf("checking location %i\n", loc);
+		printf("Hash table full.  Insert not done");
 #endif
-		count++;
+		oah_count_probes(hash_map, &hash_map->stats.insert, home, hash_map->map_size);
+		return ION_STATUS_ERROR(err_max_capacity);
 	}
 
-#if ION_DEBUG
-	printf("Hash table full.  Insert not done");
-#endif
+	/* a resize may have moved the home bucket */
+	oah_count_probes(hash_map, &hash_map->stats.insert, oah_home_slot(hash_map, key, hash_map->map_size), probes);
+
+	item = oah_bucket(hash_map, boolean_false, loc);
+	memcpy(item->data, key, (hash_map->super.record.key_size));
+	memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
+	oah_set_status(hash_map, boolean_false, loc, ION_IN_USE);
+	hash_map->count++;
 
-	return ION_STATUS_ERROR(err_max_capacity);
+	return ION_STATUS_OK(1);
 }
 
 ion_err_t
@@ -170,49 +981,16 @@ oah_find_item_loc(
 	ion_key_t		key,
 	int				*location
 ) {
-	/* compute hash value for given key */
-	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
-
-	int loc			= oah_get_location(hash, hash_map->map_size);
-	/* determine bucket based on hash */
-
-	int count		= 0;
+	int home;
+	int probes;
+	int loc = oah_locate(hash_map, key, &home, &probes);
 
-	while (count != hash_map->map_size) {
-		/* check to see if current item is a match based on key */
-		/* locate first item */
-		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc))));
-
-		if (item->status == ION_EMPTY) {
-			return err_item_not_found;	/* if you hit an empty cell, exit */
-		}
-		else {
-			/* calculate if there is a match */
-
-			if (item->status != ION_DELETED) {
-				/*@todo correct compare to use proper returen type*/
-				/*@todo An error exisits with the comparitor from the dictionary and will need to be
-				 * revisitied onced fixed */
-
-				int key_is_equal = hash_map->super.compare(item->data, key, hash_map->super.record.key_size);
-
-				if (ION_IS_EQUAL == key_is_equal) {
-					(*location) = loc;
-					return err_ok;
-				}
-			}
-
-			count++;
-			loc++;
-
-			if (loc >= hash_map->map_size) {
-				/* Perform wrapping */
-				loc = 0;
-			}
-		}
+	if (cs_invalid_index == loc) {
+		return err_item_not_found;	/* key have not been found */
 	}
 
-	return err_item_not_found;	/* key have not been found */
+	(*location) = loc;
+	return err_ok;
 }
 
 ion_status_t
@@ -220,19 +998,30 @@ oah_delete(
 	ion_hashmap_t	*hash_map,
 	ion_key_t		key
 ) {
-	int loc = -1;
+	int home;
+	int probes;
+	int loc;
+
+	if (hash_map->resizable) {
+		oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+	}
+
+	loc = oah_locate(hash_map, key, &home, &probes);
+	oah_count_probes(hash_map, &hash_map->stats.remove, home, probes);
 
-	if (oah_find_item_loc(hash_map, key, &loc) == err_item_not_found) {
+	if (cs_invalid_index == loc) {
 #if ION_DEBUG
 		printf("Item not found when trying to oah_delete.\n");
 #endif
 		return ION_STATUS_ERROR(err_item_not_found);
 	}
 	else {
-		/* locate item */
-		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc))));
+		oah_backward_shift(hash_map, loc);	/* delete item */
+		hash_map->count--;
 
-		item->status = ION_DELETED;	/* delete item */
+		if (hash_map->resizable && (ION_OAH_SHRINK_LOAD_PERCENT > 0) && (NULL == hash_map->old_entry) && (hash_map->map_size > hash_map->min_size) && ((long) hash_map->count * 100 < (long) hash_map->map_size * ION_OAH_SHRINK_LOAD_PERCENT)) {
+			oah_resize(hash_map, (hash_map->map_size / 2 > hash_map->min_size) ? hash_map->map_size / 2 : hash_map->min_size);
+		}
 
 #if ION_DEBUG
 		printf("Item deleted at location %d\n", loc);
@@ -242,23 +1031,28 @@ oah_delete(
 }
 
 ion_status_t
-oah_query(
+oah_get_ref(
 	ion_hashmap_t	*hash_map,
 	ion_key_t		key,
-	ion_value_t		value
+	ion_value_t		*value
 ) {
+	int home;
+	int probes;
 	int loc;
 
-	if (oah_find_item_loc(hash_map, key, &loc) == err_ok) {
+	if (hash_map->resizable) {
+		oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+	}
+
+	loc = oah_locate(hash_map, key, &home, &probes);
+	oah_count_probes(hash_map, &hash_map->stats.get, home, probes);
+
+	if (cs_invalid_index != loc) {
 #if ION_DEBUG
 		printf("Item found at location %d\n", loc);
 #endif
 
-		int					data_length = hash_map->super.record.key_size + hash_map->super.record.value_size;
-		ion_hash_bucket_t	*item		= (((ion_hash_bucket_t *) ((hash_map->entry + (data_length + SIZEOF(STATUS)) * loc))));
-
-		/* *value				   = malloc(sizeof(char) * (hash_map->super.record.value_size)); */
-		memcpy(value, (item->data + hash_map->super.record.key_size), hash_map->super.record.value_size);
+		*value = oah_bucket(hash_map, boolean_false, loc)->data + hash_map->super.record.key_size;
 		return ION_STATUS_OK(1);
 	}
 	else {
@@ -269,6 +1063,132 @@ oah_query(
 	}
 }
 
+ion_status_t
+oah_query(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	ion_value_t		value
+) {
+	ion_value_t		stored;
+	ion_status_t	status = oah_get_ref(hash_map, key, &stored);
+
+	if (err_ok == status.error) {
+		memcpy(value, stored, hash_map->super.record.value_size);
+	}
+
+	return status;
+}
+
+ion_status_t
+oah_get_many(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		keys,
+	ion_value_t		values,
+	ion_status_t	*statuses,
+	int				count
+) {
+	int				key_size	= hash_map->super.record.key_size;
+	int				value_size	= hash_map->super.record.value_size;
+	ion_status_t	status		= ION_STATUS_OK(0);
+	int				homes[ION_OAH_GET_MANY_BATCH];
+	ion_byte_t		tags[ION_OAH_GET_MANY_BATCH];
+	ion_status_t	found;
+	ion_byte_t		*key;
+	int				batch;
+	int				probes;
+	int				loc;
+	int				i;
+	int				j;
+
+	if (hash_map->resizable) {
+		oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+	}
+
+	for (i = 0; i < count; i += batch) {
+		batch = count - i < ION_OAH_GET_MANY_BATCH ? count - i : ION_OAH_GET_MANY_BATCH;
+
+		/* hash the whole batch and start loading every home bucket ... */
+		for (j = 0; j < batch; j++) {
+			key			= (ion_byte_t *) keys + (i + j) * key_size;
+			homes[j]	= oah_home_slot(hash_map, key, hash_map->map_size);
+			tags[j]		= oah_key_tag(hash_map, key);
+#if ION_OAH_USE_CONTROL_BYTES
+			ION_OAH_PREFETCH(hash_map->ctrl + homes[j]);
+#endif
+			ION_OAH_PREFETCH(oah_bucket(hash_map, boolean_false, homes[j]));
+		}
+
+		/* ... so their misses overlap, instead of one per key */
+		for (j = 0; j < batch; j++) {
+			key = (ion_byte_t *) keys + (i + j) * key_size;
+			loc = oah_probe_from(hash_map, boolean_false, key, homes[j], tags[j], &probes);
+
+			if ((cs_invalid_index == loc) && (NULL != hash_map->old_entry)) {
+				int old_loc = oah_probe(hash_map, boolean_true, key);
+
+				if (cs_invalid_index != old_loc) {
+					loc		= oah_move_record(hash_map, old_loc);
+					probes	= (loc - homes[j] + hash_map->map_size) % hash_map->map_size + 1;
+				}
+			}
+
+			oah_count_probes(hash_map, &hash_map->stats.get, homes[j], probes);
+
+			if (cs_invalid_index == loc) {
+				found			= ION_STATUS_ERROR(err_item_not_found);
+				status.error	= err_item_not_found;
+			}
+			else {
+				memcpy((ion_byte_t *) values + (i + j) * value_size, oah_bucket(hash_map, boolean_false, loc)->data + key_size, value_size);
+				found = ION_STATUS_OK(1);
+				status.count++;
+			}
+
+			if (NULL != statuses) {
+				statuses[i + j] = found;
+			}
+		}
+	}
+
+	return status;
+}
+
+ion_err_t
+oah_stats(
+	ion_hashmap_t		*hash_map,
+	ion_hash_stats_t	*stats
+) {
+	int		i;
+	char	status;
+
+	*stats			= hash_map->stats;
+	stats->buckets	= hash_map->map_size + (NULL != hash_map->old_entry ? hash_map->old_size : 0);
+	stats->occupied = 0;
+	stats->deleted	= 0;
+
+	for (i = 0; i < stats->buckets; i++) {
+		status = i < hash_map->map_size ? oah_bucket(hash_map, boolean_false, i)->status : oah_bucket(hash_map, boolean_true, i - hash_map->map_size)->status;
+
+		if (ION_IN_USE == status) {
+			stats->occupied++;
+		}
+		else if (ION_DELETED == status) {
+			stats->deleted++;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+oah_reset_stats(
+	ion_hashmap_t *hash_map
+) {
+	memset(&hash_map->stats, 0, sizeof(hash_map->stats));
+
+	return err_ok;
+}
+
 /**
 @brief		Helper function to print out map.
 
@@ -293,16 +1213,16 @@ oah_print(
 	printf("Printing map\n");
 
 	for (i = 0; i < size; i++) {
-		printf("%d -- %i ", i, ((ion_hash_bucket_t *) ((hash_map->entry + (record->key_size + record->value_size + SIZEOF(STATUS)) * i)))->status);
+		printf("%d -- %i ", i, ((ion_hash_bucket_t *) ((hash_map->entry + hash_map->bucket_size * i)))->status);
 		{
-			if (((ion_hash_bucket_t *) ((hash_map->entry + (record->key_size + record->value_size + SIZEOF(STATUS)) * i)))->status == (ION_EMPTY | ION_DELETED)) {
+			if (((ion_hash_bucket_t *) ((hash_map->entry + hash_map->bucket_size * i)))->status == (ION_EMPTY | ION_DELETED)) {
 				printf("(null)");
 			}
 			else {
 				int j;
 
 				for (j = 0; j < (record->key_size + record->value_size); j++) {
-					printf("%X ", *(ion_byte_t *) (((ion_hash_bucket_t *) ((hash_map->entry + (record->key_size + record->value_size + SIZEOF(STATUS)) * i)))->data + j));
+					printf("%X ", *(ion_byte_t *) (((ion_hash_bucket_t *) ((hash_map->entry + hash_map->bucket_size * i)))->data + j));
 				}
 			}
 
@@ -325,3 +1245,252 @@ oah_compute_simple_hash(
 
 	return hash;
 }
+
+ion_hash_t
+oah_compute_seeded_hash(
+	ion_hashmap_t	*hashmap,
+	ion_key_t		key,
+	int				size_of_key
+) {
+	uint32_t hash = dictionary_hash_key(hashmap->super.key_type, key, size_of_key, hashmap->seed);
+
+	return (ion_hash_t) (hash % (uint32_t) hashmap->map_size);
+}
+
+/**
+@brief		What a snapshot written by @ref oah_save starts with. The
+			buckets follow, then the control bytes if @c has_ctrl.
+*/
+typedef struct {
+	uint32_t	magic;			/**< @ref ION_OAH_SNAPSHOT_MAGIC */
+	uint32_t	check;			/**< @ref oah_snapshot_check of the writer */
+	int32_t		key_type;
+	int32_t		key_size;
+	int32_t		value_size;
+	int32_t		map_size;
+	int32_t		min_size;
+	int32_t		count;
+	uint32_t	seed;
+	int32_t		hash_function;	/**< An @ref ion_hash_function_t */
+	int32_t		resizable;
+	int32_t		has_ctrl;
+	int32_t		bucket_size;	/**< The distance between two buckets */
+	int32_t		bucket_lead;	/**< The padding of each bucket ahead of
+								 its status byte */
+} ion_oah_snapshot_t;
+
+/**
+@brief		Marks a file as an in memory hash snapshot ("OAHS").
+*/
+#define ION_OAH_SNAPSHOT_MAGIC 0x4F414853UL
+
+/**
+@brief		A hash of a fixed word under @p seed. Builds that place keys
+			differently, through another hash or byte order, disagree on
+			it, and so do not trust each other's bucket positions.
+*/
+static uint32_t
+oah_snapshot_check(
+	uint32_t seed
+) {
+	uint32_t probe = 0x01020304UL;
+
+	return dictionary_hash_bytes((const ion_byte_t *) &probe, sizeof(probe), seed);
+}
+
+ion_err_t
+oah_save(
+	ion_hashmap_t	*hash_map,
+	char			*filename
+) {
+	ion_oah_snapshot_t	snapshot;
+	FILE				*file;
+	ion_boolean_t		written;
+
+	if (oah_compute_seeded_hash == hash_map->compute_hash) {
+		snapshot.hash_function = hash_function_seeded;
+	}
+	else if (oah_compute_simple_hash == hash_map->compute_hash) {
+		snapshot.hash_function = hash_function_modulo;
+	}
+	else {
+		/* a custom hash cannot be bound again on load */
+		return err_illegal_state;
+	}
+
+	/* a snapshot holds one table */
+	oah_finish_rehash(hash_map);
+
+	snapshot.magic		= ION_OAH_SNAPSHOT_MAGIC;
+	snapshot.check		= oah_snapshot_check(hash_map->seed);
+	snapshot.key_type	= hash_map->super.key_type;
+	snapshot.key_size	= hash_map->super.record.key_size;
+	snapshot.value_size = hash_map->super.record.value_size;
+	snapshot.map_size	= hash_map->map_size;
+	snapshot.min_size	= hash_map->min_size;
+	snapshot.count		= hash_map->count;
+	snapshot.seed		= hash_map->seed;
+	snapshot.resizable	= hash_map->resizable;
+	snapshot.has_ctrl	= ION_OAH_USE_CONTROL_BYTES;
+	snapshot.bucket_size	= hash_map->bucket_size;
+	snapshot.bucket_lead	= ION_OAH_BUCKET_LEAD;
+
+	if (NULL == (file = fopen(filename, "wb"))) {
+		return err_file_open_error;
+	}
+
+	written = (1 == fwrite(&snapshot, sizeof(snapshot), 1, file)) && ((size_t) hash_map->map_size == fwrite(oah_entry_base(hash_map->entry), hash_map->bucket_size, hash_map->map_size, file));
+
+#if ION_OAH_USE_CONTROL_BYTES
+	written = written && ((size_t) hash_map->map_size == fwrite(hash_map->ctrl, 1, hash_map->map_size, file));
+#endif
+
+	if (0 != fclose(file)) {
+		written = boolean_false;
+	}
+
+	if (!written) {
+		fremove(filename);
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Places the records of a snapshot from another build back into
+			@p hash_map one by one, as its bucket positions or layout
+			cannot be trusted.
+@param		entry
+				The first bucket of the snapshot.
+@param		bucket_size
+				The distance between two buckets of the snapshot.
+*/
+static ion_err_t
+oah_load_by_insert(
+	ion_hashmap_t	*hash_map,
+	char			*entry,
+	int				bucket_size,
+	int				size
+) {
+	ion_byte_t			*ctrl;
+	ion_hash_bucket_t	*item;
+	int					i;
+
+	if (err_ok != oah_table_allocate(hash_map, hash_map->map_size, &hash_map->entry, &ctrl)) {
+		return err_out_of_memory;
+	}
+
+#if ION_OAH_USE_CONTROL_BYTES
+	hash_map->ctrl = ctrl;
+#endif
+	hash_map->count = 0;
+
+	for (i = 0; i < size; i++) {
+		item = (ion_hash_bucket_t *) (entry + bucket_size * i);
+
+		if ((ION_IN_USE == item->status) && (err_ok != oah_insert(hash_map, item->data, item->data + hash_map->super.record.key_size).error)) {
+			return err_unable_to_insert;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+oah_load(
+	ion_hashmap_t	*hash_map,
+	char			*filename
+) {
+	ion_oah_snapshot_t	snapshot;
+	FILE				*file;
+	char				*entry;
+	ion_boolean_t		in_place;
+	ion_err_t			err = err_ok;
+
+	if (NULL == (file = fopen(filename, "rb"))) {
+		return err_file_open_error;
+	}
+
+	if ((1 != fread(&snapshot, sizeof(snapshot), 1, file)) || (ION_OAH_SNAPSHOT_MAGIC != snapshot.magic) || (snapshot.map_size <= 0) || (snapshot.bucket_lead < 0) || (snapshot.bucket_size < snapshot.bucket_lead + SIZEOF(STATUS) + snapshot.key_size + snapshot.value_size)) {
+		fclose(file);
+		return err_file_incomplete_read;
+	}
+
+	/* buckets laid out as this build would can be used where they land */
+	in_place	= (oah_snapshot_check(snapshot.seed) == snapshot.check) && (oah_bucket_size(snapshot.key_size, snapshot.value_size) == snapshot.bucket_size) && (ION_OAH_BUCKET_LEAD == snapshot.bucket_lead);
+	entry		= in_place ? oah_entry_allocate((size_t) snapshot.bucket_size * snapshot.map_size) : ion_alloc(ion_alloc_buffer, (size_t) snapshot.bucket_size * snapshot.map_size);
+
+	/* one read brings in every bucket */
+	if ((NULL == entry) || ((size_t) snapshot.map_size != fread(in_place ? oah_entry_base(entry) : entry, snapshot.bucket_size, snapshot.map_size, file))) {
+		if (in_place) {
+			oah_entry_free(entry);
+		}
+		else {
+			ion_free(entry);
+		}
+
+		fclose(file);
+		return NULL == entry ? err_out_of_memory : err_file_incomplete_read;
+	}
+
+	hash_map->write_concern				= wc_insert_unique;
+	hash_map->super.key_type			= snapshot.key_type;
+	hash_map->super.record.key_size		= snapshot.key_size;
+	hash_map->super.record.value_size	= snapshot.value_size;
+	hash_map->compute_hash				= hash_function_modulo == snapshot.hash_function ? oah_compute_simple_hash : oah_compute_seeded_hash;
+	hash_map->seed						= snapshot.seed;
+	hash_map->resizable					= snapshot.resizable;
+	hash_map->count						= snapshot.count;
+	hash_map->min_size					= snapshot.min_size;
+	hash_map->map_size					= snapshot.map_size;
+	hash_map->bucket_size				= oah_bucket_size(snapshot.key_size, snapshot.value_size);
+	hash_map->old_entry					= NULL;
+	hash_map->old_size					= 0;
+	hash_map->old_next					= 0;
+	hash_map->entry						= NULL;
+	hash_map->keep_stats				= boolean_true;
+	memset(&hash_map->stats, 0, sizeof(hash_map->stats));
+#if ION_OAH_USE_CONTROL_BYTES
+	hash_map->ctrl						= NULL;
+	hash_map->old_ctrl					= NULL;
+#endif
+
+	if (!in_place) {
+		err = oah_load_by_insert(hash_map, entry + snapshot.bucket_lead, snapshot.bucket_size, snapshot.map_size);
+		ion_free(entry);
+	}
+	else {
+		hash_map->entry = entry;
+
+#if ION_OAH_USE_CONTROL_BYTES
+
+		int i;
+
+		if (NULL == (hash_map->ctrl = ion_alloc(ion_alloc_node, ION_OAH_CTRL_BYTES(hash_map->map_size)))) {
+			err = err_out_of_memory;
+		}
+		else if (snapshot.has_ctrl && ((size_t) hash_map->map_size == fread(hash_map->ctrl, 1, hash_map->map_size, file))) {
+			for (i = hash_map->map_size; i < ION_OAH_CTRL_BYTES(hash_map->map_size); i++) {
+				hash_map->ctrl[i] = hash_map->ctrl[i - hash_map->map_size];
+			}
+		}
+		else {
+			oah_rebuild_control_bytes(hash_map);
+		}
+#endif
+	}
+
+	fclose(file);
+
+	if (err_ok != err) {
+#if ION_OAH_USE_CONTROL_BYTES
+		ion_free(hash_map->ctrl);
+		hash_map->ctrl = NULL;
+#endif
+		oah_entry_free(hash_map->entry);
+		hash_map->entry = NULL;
+	}
+
+	return err;
+}
@@ -26,11 +26,79 @@ extern "C" {
 
 #include "../../key_value/kv_system.h"
 
+/* redefines file operations for arduino */
+#include "./../../file/SD_stdio_c_iface.h"
+
 #define ION_EMPTY	-1
 #define ION_DELETED -2
 #define ION_IN_USE	-3
 #define SIZEOF(STATUS) 1
 
+/**
+@brief		Whether maps keep a separate array of 1-byte control tags,
+			one per bucket, holding a 7-bit fingerprint of its key.
+			Probing then scans the tags a group at a time, with SSE2
+			where available and word-wide arithmetic elsewhere, and only
+			reads a bucket and compares its key on a fingerprint match.
+*/
+#if !defined(ION_OAH_USE_CONTROL_BYTES)
+#define ION_OAH_USE_CONTROL_BYTES 1
+#endif
+
+/**
+@brief		The alignment, in bytes, of the key of every bucket. 1 packs
+			buckets back to back; a larger power of two pads each bucket,
+			ahead of its status byte, so that its key starts on a multiple
+			of it and is read and copied naturally aligned.
+*/
+#if !defined(ION_OAH_BUCKET_ALIGN)
+#define ION_OAH_BUCKET_ALIGN 1
+#endif
+
+/**
+@brief		The cache line size, in bytes, buckets are laid out for, or 0
+			to ignore cache lines.
+@details	When set, tables start on a cache line and buckets are padded
+			to a power of two below it, or to whole lines above it, so no
+			bucket spans two lines. Must be a power of two no smaller than
+			@ref ION_OAH_BUCKET_ALIGN and at most 256.
+*/
+#if !defined(ION_OAH_CACHE_LINE)
+#define ION_OAH_CACHE_LINE 0
+#endif
+
+/**
+@brief		The load, in percent of the map size, past which a resizable
+			map doubles. 0 keeps every map at its initial size.
+*/
+#if !defined(ION_OAH_GROW_LOAD_PERCENT)
+#define ION_OAH_GROW_LOAD_PERCENT	75
+#endif
+
+/**
+@brief		The load, in percent of the map size, below which a resizable
+			map that has grown halves again. 0 disables shrinking.
+*/
+#if !defined(ION_OAH_SHRINK_LOAD_PERCENT)
+#define ION_OAH_SHRINK_LOAD_PERCENT 20
+#endif
+
+/**
+@brief		How many buckets of the previous table each operation moves
+			into the resized one while a resize is in progress.
+*/
+#if !defined(ION_OAH_REHASH_STEP)
+#define ION_OAH_REHASH_STEP 4
+#endif
+
+/**
+@brief		How many keys @ref oah_get_many hashes, and prefetches the
+			home buckets of, before it resolves any of them.
+*/
+#if !defined(ION_OAH_GET_MANY_BATCH)
+#define ION_OAH_GET_MANY_BATCH 16
+#endif
+
 /**
 @brief		Prototype declaration for hashmap
 */
@@ -53,7 +121,34 @@ struct hashmap {
 
 	/**< The hashing function to be used for
 		 the instance*/
+	uint32_t				seed;	/**< The seed given to the seeded
+								 hash, taken from the dictionary id */
 	char *entry;/**< Pointer to the entries in the hashmap*/
+	int						bucket_size;	/**< The distance between two
+											 buckets of @c entry, see
+											 @ref oah_bucket_size */
+	ion_boolean_t			resizable;	/**< Whether the map grows and shrinks
+										 with its load, see
+										 @ref ION_OAH_GROW_LOAD_PERCENT */
+	int						count;		/**< The number of records stored */
+	int						min_size;	/**< The initial size, which a
+										 shrinking map stops at */
+	char					*old_entry;	/**< The table being drained into
+										 @c entry during a resize, or
+										 @c NULL */
+	int						old_size;	/**< The size of @c old_entry */
+	int						old_next;	/**< The next bucket of
+										 @c old_entry to move */
+	ion_boolean_t			keep_stats;	/**< Whether operations are
+										 counted in @c stats */
+	ion_hash_stats_t		stats;		/**< Probe counters, see
+										 @ref oah_stats */
+#if ION_OAH_USE_CONTROL_BYTES
+	ion_byte_t				*ctrl;		/**< The control bytes of
+										 @c entry */
+	ion_byte_t				*old_ctrl;	/**< The control bytes of
+										 @c old_entry */
+#endif
 };
 
 /**
@@ -84,6 +179,24 @@ oah_initialize(
 	int size
 );
 
+/**
+@brief		Computes how far apart buckets are placed in a map.
+
+@details	A bucket is its status byte, key and value, padded as asked
+			by @ref ION_OAH_BUCKET_ALIGN and @ref ION_OAH_CACHE_LINE.
+
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@return		The size of a bucket, padding included.
+*/
+int
+oah_bucket_size(
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size
+);
+
 /**
 @brief		Destroys the map in memory
 
@@ -98,6 +211,40 @@ oah_destroy(
 	ion_hashmap_t *hash_map
 );
 
+/**
+@brief		Moves every remaining record of an in-progress resize into
+			the current table.
+
+@details	Operations on a resizing map each move a few buckets, so a
+			resize never stalls a single insert. Scans over
+			@c entry, such as cursors, call this first so that every
+			record is in the table they walk.
+
+@param		hash_map
+				The map to finish resizing. Nothing is done if it is not
+				resizing.
+*/
+void
+oah_finish_rehash(
+	ion_hashmap_t *hash_map
+);
+
+/**
+@brief		Rebuilds the control bytes of a map from the status of its
+			buckets.
+
+@details	Only needed after buckets of @c entry have been written
+			directly rather than through the map's functions. Does nothing
+			if @ref ION_OAH_USE_CONTROL_BYTES is off.
+
+@param		hash_map
+				The map whose control bytes to rebuild.
+*/
+void
+oah_rebuild_control_bytes(
+	ion_hashmap_t *hash_map
+);
+
 /**
 @brief		Returns the theoretical location of item in hashmap
 
@@ -200,6 +347,28 @@ oah_delete(
 	ion_key_t		key
 );
 
+/**
+@brief		Points at the value of a record in its bucket.
+
+@details	The bucket is in the current table, a record still in the
+			table being resized away from is moved first, so the pointer
+			holds until the next insert, update or delete.
+
+@param		hash_map
+				The map to search.
+@param		key
+				The key for the record that is being searched for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the lookup.
+*/
+ion_status_t
+oah_get_ref(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	ion_value_t		*value
+);
+
 /**
 @brief		Locates the record if it exists.
 
@@ -222,6 +391,114 @@ oah_query(
 	ion_value_t		value
 );
 
+/**
+@brief		Looks up a batch of keys.
+
+@details	The keys are taken @ref ION_OAH_GET_MANY_BATCH at a time:
+			all of them are hashed and their home buckets prefetched
+			before any is probed, so the cache misses of the batch
+			overlap rather than each key waiting on its own.
+
+@param		hash_map
+				The map to search.
+@param		keys
+				@p count keys, stored back to back.
+@param		values
+				Room for @p count values, stored back to back. The value
+				of each key that is not found is left untouched.
+@param		statuses
+				If not @c NULL, receives the status of each lookup.
+@param		count
+				The number of keys.
+@return		The number of keys found, with @c err_item_not_found if
+			any was not.
+*/
+ion_status_t
+oah_get_many(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		keys,
+	ion_value_t		values,
+	ion_status_t	*statuses,
+	int				count
+);
+
+/**
+@brief		Writes a snapshot of a map to a file.
+
+@details	The snapshot is the map's parameters followed by its buckets
+			and control bytes exactly as they are in memory, so it is
+			written, and read back by @ref oah_load, sequentially and
+			without hashing a single key. A resize in progress is
+			finished first.
+
+@param		hash_map
+				The map to save. It must use one of the hash functions
+				of this file.
+@param		filename
+				The file to write, replacing any file of that name.
+@return		The status of the save.
+*/
+ion_err_t
+oah_save(
+	ion_hashmap_t	*hash_map,
+	char			*filename
+);
+
+/**
+@brief		Sets up a map from a snapshot written by @ref oah_save.
+
+@details	The buckets are read in one go. A snapshot whose keys were
+			placed by a differently built hash, such as on a host of the
+			other byte order, is loaded by inserting its records instead.
+			As with @ref oah_initialize, the caller sets
+			@c super.compare.
+
+@param		hash_map
+				The map to set up. Any table it had is not freed.
+@param		filename
+				The snapshot to read.
+@return		The status of the load, @c err_file_open_error if there is
+			no such file.
+*/
+ion_err_t
+oah_load(
+	ion_hashmap_t	*hash_map,
+	char			*filename
+);
+
+/**
+@brief		Reads the statistics of a map.
+
+@details	The probe counters cover the operations since the map was
+			set up or last reset, while a resize is in progress only
+			counting the probes of the current table. The bucket counts
+			are taken from both tables as they are now.
+
+@param		hash_map
+				The map to read.
+@param		stats
+				Filled with the statistics.
+@return		The status of the call.
+*/
+ion_err_t
+oah_stats(
+	ion_hashmap_t		*hash_map,
+	ion_hash_stats_t	*stats
+);
+
+/**
+@brief		Starts a new measurement period for the probe counters of a
+			map.
+
+@param		hash_map
+				The map to reset.
+@return		The status of the call.
+*/
+ion_err_t
+oah_reset_stats(
+	ion_hashmap_t *hash_map
+);
+
 /**
 @brief		A simple hashing algorithm implementation.
 
@@ -240,6 +517,30 @@ oah_compute_simple_hash(
 	int				size_of_key
 );
 
+/**
+@brief		A seeded hash over the whole key.
+
+@details	Hashes the key with @ref dictionary_hash_key, seeded with
+			@c seed of the map, and reduces it to a slot in the map.
+			Unlike @ref oah_compute_simple_hash it uses every key byte,
+			so keys that share their leading @c int, or that are all
+			multiples of the map size, still spread over the table.
+
+@param		hashmap
+				The hash function is associated with.
+@param		key
+				The original key value to find hash value for.
+@param		size_of_key
+				The size of the key in bytes.
+@return		The hashed value for the key.
+*/
+ion_hash_t
+oah_compute_seeded_hash(
+	ion_hashmap_t	*hashmap,
+	ion_key_t		key,
+	int				size_of_key
+);
+
 #if defined(__cplusplus)
 }
 #endif
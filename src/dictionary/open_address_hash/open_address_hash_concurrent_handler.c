@@ -0,0 +1,474 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a thread-safe variant of the in memory hash
+			table.
+@details	Writers follow the usual sequence lock protocol: with the
+			stripe locked, its version is made odd, the map is changed and
+			the version made even again. Readers note the version, look
+			the key up in a map that may be changing under them and keep
+			the result only if the version was even and has not moved.
+			Since stripes never resize, a lookup that races a writer still
+			only reads memory of the stripe's table, and its bounded probe
+			ends; any result it gets is thrown away.
+*/
+/******************************************************************************/
+
+#include "open_address_hash_concurrent_handler.h"
+
+/**
+@brief		Returns the stripe a key belongs to.
+@details	The stripe comes from a hash with a different seed than the
+			one placing keys within a stripe, so that keys sharing a
+			stripe still spread over its buckets.
+*/
+static ion_oac_stripe_t *
+oacdict_stripe(
+	ion_oac_hashmap_t	*map,
+	ion_key_t			key
+) {
+	uint32_t hash = dictionary_hash_key(map->super.key_type, key, map->super.record.key_size, map->stripes[0].map.seed ^ 0x9E3779B9UL);
+
+	return &map->stripes[((uint64_t) hash * (uint32_t) map->stripe_count) >> 32];
+}
+
+/**
+@brief		Locks a stripe and marks it as being written.
+*/
+static void
+oacdict_write_begin(
+	ion_oac_stripe_t *stripe
+) {
+	pthread_mutex_lock(&stripe->lock);
+	__atomic_store_n(&stripe->version, stripe->version + 1, __ATOMIC_RELAXED);
+	/* the odd version is seen before any change to the map */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+@brief		Marks a stripe as no longer being written and unlocks it.
+*/
+static void
+oacdict_write_end(
+	ion_oac_stripe_t *stripe
+) {
+	__atomic_store_n(&stripe->version, stripe->version + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&stripe->lock);
+}
+
+ion_status_t
+oacdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_oac_stripe_t	*stripe = oacdict_stripe((ion_oac_hashmap_t *) dictionary->instance, key);
+	ion_status_t		status;
+
+	oacdict_write_begin(stripe);
+	status = oah_insert(&stripe->map, key, value);
+	oacdict_write_end(stripe);
+
+	return status;
+}
+
+ion_status_t
+oacdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_oac_stripe_t	*stripe = oacdict_stripe((ion_oac_hashmap_t *) dictionary->instance, key);
+	ion_value_size_t	value_size = dictionary->instance->record.value_size;
+	ion_byte_t			*buffer = alloca(value_size);
+	ion_status_t		status;
+	uint32_t			version;
+	int					attempt;
+
+	for (attempt = 0; attempt < ION_OAC_READ_ATTEMPTS; attempt++) {
+		version = __atomic_load_n(&stripe->version, __ATOMIC_ACQUIRE);
+
+		if (version & 1) {
+			continue;
+		}
+
+		/* maps that never resize are not changed by a query */
+		status = oah_query(&stripe->map, key, buffer);
+
+		/* the reads of the map are done before the version is checked */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&stripe->version, __ATOMIC_RELAXED) == version) {
+			if (err_ok == status.error) {
+				memcpy(value, buffer, value_size);
+			}
+
+			return status;
+		}
+	}
+
+	/* writers keep getting in the way, so wait for them */
+	pthread_mutex_lock(&stripe->lock);
+	status = oah_query(&stripe->map, key, value);
+	pthread_mutex_unlock(&stripe->lock);
+
+	return status;
+}
+
+ion_err_t
+oacdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_oac_hashmap_t	*map;
+	ion_oac_stripe_t	*stripe;
+	ion_err_t			err;
+	int					stripe_size;
+	int					i;
+
+	if (dictionary_size <= 0) {
+		return err_invalid_initial_size;
+	}
+
+	map = ion_alloc(ion_alloc_other, sizeof(ion_oac_hashmap_t));
+
+	if (NULL == map) {
+		return err_out_of_memory;
+	}
+
+	map->super.key_type			= key_type;
+	map->super.record.key_size	= key_size;
+	map->super.record.value_size = value_size;
+	map->super.compare			= compare;
+	map->stripe_count			= dictionary_size / ION_OAC_STRIPE_MIN_SIZE;
+
+	if (map->stripe_count < 1) {
+		map->stripe_count = 1;
+	}
+	else if (map->stripe_count > ION_OAC_STRIPES) {
+		map->stripe_count = ION_OAC_STRIPES;
+	}
+
+	stripe_size		= (dictionary_size + map->stripe_count - 1) / map->stripe_count;
+	stripe_size		+= (int) ((long) stripe_size * ION_OAC_STRIPE_SLACK_PERCENT / 100);
+	map->stripes	= ion_alloc(ion_alloc_node, sizeof(ion_oac_stripe_t) * map->stripe_count);
+
+	if (NULL == map->stripes) {
+		ion_free(map);
+		return err_out_of_memory;
+	}
+
+	for (i = 0; i < map->stripe_count; i++) {
+		stripe						= &map->stripes[i];
+		stripe->map.super.compare	= compare;
+
+		err							= oah_initialize(&stripe->map, oah_compute_seeded_hash, key_type, key_size, value_size, stripe_size);
+
+		if (err_ok != err) {
+			while (--i >= 0) {
+				oah_destroy(&map->stripes[i].map);
+				pthread_mutex_destroy(&map->stripes[i].lock);
+			}
+
+			ion_free(map->stripes);
+			ion_free(map);
+			return err;
+		}
+
+		/* one seed for every stripe, which oacdict_stripe relies on */
+		stripe->map.seed			= id;
+		stripe->map.super.id		= id;
+		/* lock-free readers would race on the probe counters */
+		stripe->map.keep_stats		= boolean_false;
+		stripe->dictionary.instance = (ion_dictionary_parent_t *) &stripe->map;
+		stripe->dictionary.handler	= handler;
+		stripe->dictionary.status	= ion_dictionary_status_ok;
+		stripe->version				= 0;
+		pthread_mutex_init(&stripe->lock, NULL);
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) map;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_status_t
+oacdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_oac_stripe_t	*stripe = oacdict_stripe((ion_oac_hashmap_t *) dictionary->instance, key);
+	ion_status_t		status;
+
+	oacdict_write_begin(stripe);
+	status = oah_delete(&stripe->map, key);
+	oacdict_write_end(stripe);
+
+	return status;
+}
+
+ion_err_t
+oacdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_oac_hashmap_t	*map	= (ion_oac_hashmap_t *) dictionary->instance;
+	ion_err_t			result	= err_ok;
+	int					i;
+
+	for (i = 0; i < map->stripe_count; i++) {
+		if (err_ok != oah_destroy(&map->stripes[i].map)) {
+			result = err_dictionary_destruction_error;
+		}
+
+		pthread_mutex_destroy(&map->stripes[i].lock);
+	}
+
+	ion_free(map->stripes);
+	ion_free(map);
+	dictionary->instance = NULL;
+
+	return result;
+}
+
+ion_status_t
+oacdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_oac_stripe_t	*stripe = oacdict_stripe((ion_oac_hashmap_t *) dictionary->instance, key);
+	ion_status_t		status;
+
+	oacdict_write_begin(stripe);
+	status = oah_update(&stripe->map, key, value);
+	oacdict_write_end(stripe);
+
+	return status;
+}
+
+/**
+@brief		Starts a cursor over one stripe, under the stripe's lock.
+*/
+static ion_err_t
+oacdict_find_in_stripe(
+	ion_oac_stripe_t	*stripe,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_err_t err;
+
+	pthread_mutex_lock(&stripe->lock);
+	err = oadict_find(&stripe->dictionary, predicate, cursor);
+	pthread_mutex_unlock(&stripe->lock);
+
+	return err;
+}
+
+/**
+@brief		Moves a cursor on to the next stripe holding a result.
+@return		@c err_ok, with the cursor at the end of its results if no
+			stripe is left, or the error of starting a stripe cursor.
+*/
+static ion_err_t
+oacdict_next_stripe(
+	ion_oacdict_cursor_t *cursor
+) {
+	ion_oac_hashmap_t	*map = (ion_oac_hashmap_t *) cursor->super.dictionary->instance;
+	ion_dict_cursor_t	*inner;
+	ion_err_t			err;
+
+	/* stripe cursors without a first result are uninitialized or at their end */
+	while (cs_cursor_initialized != cursor->inner->status) {
+		if (cursor->stripe == cursor->last) {
+			cursor->super.status = cs_end_of_results;
+			return err_ok;
+		}
+
+		/* the predicate copied by the current stripe cursor starts the next */
+		err = oacdict_find_in_stripe(&map->stripes[cursor->stripe + 1], cursor->inner->predicate, &inner);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		cursor->inner->destroy(&cursor->inner);
+		cursor->inner			= inner;
+		cursor->super.predicate = inner->predicate;
+		cursor->stripe++;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+oacdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_oac_hashmap_t		*map = (ion_oac_hashmap_t *) dictionary->instance;
+	ion_oacdict_cursor_t	*oac_cursor;
+	ion_err_t				err;
+
+	if (NULL == (oac_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_oacdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	oac_cursor->super.dictionary	= dictionary;
+	oac_cursor->super.status		= cs_cursor_initialized;
+	oac_cursor->super.next			= oacdict_next;
+	oac_cursor->super.destroy		= oacdict_destroy_cursor;
+	oac_cursor->super.next_batch	= NULL;
+	oac_cursor->stripe				= 0;
+	oac_cursor->last				= map->stripe_count - 1;
+
+	/* equal keys share a stripe */
+	if (predicate_equality == predicate->type) {
+		oac_cursor->stripe	= oacdict_stripe(map, predicate->statement.equality.equality_value) - map->stripes;
+		oac_cursor->last	= oac_cursor->stripe;
+	}
+
+	err = oacdict_find_in_stripe(&map->stripes[oac_cursor->stripe], predicate, &oac_cursor->inner);
+
+	if (err_ok != err) {
+		ion_free(oac_cursor);
+		return err;
+	}
+
+	oac_cursor->super.predicate = oac_cursor->inner->predicate;
+	err							= oacdict_next_stripe(oac_cursor);
+
+	if (err_ok != err) {
+		oacdict_destroy_cursor((ion_dict_cursor_t **) &oac_cursor);
+		return err;
+	}
+
+	*cursor = (ion_dict_cursor_t *) oac_cursor;
+
+	return err_ok;
+}
+
+ion_cursor_status_t
+oacdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_oacdict_cursor_t	*oac_cursor = (ion_oacdict_cursor_t *) cursor;
+	ion_oac_hashmap_t		*map		= (ion_oac_hashmap_t *) cursor->dictionary->instance;
+	ion_oac_stripe_t		*stripe;
+	ion_cursor_status_t		status;
+
+	if ((cs_cursor_initialized != cursor->status) && (cs_cursor_active != cursor->status)) {
+		return cursor->status;
+	}
+
+	while (1) {
+		stripe = &map->stripes[oac_cursor->stripe];
+
+		pthread_mutex_lock(&stripe->lock);
+		status = oac_cursor->inner->next(oac_cursor->inner, record);
+		pthread_mutex_unlock(&stripe->lock);
+
+		if (cs_cursor_active == status) {
+			cursor->status = cs_cursor_active;
+			return cursor->status;
+		}
+
+		if ((err_ok != oacdict_next_stripe(oac_cursor)) || (cs_end_of_results == cursor->status)) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+}
+
+void
+oacdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_oacdict_cursor_t *oac_cursor = (ion_oacdict_cursor_t *) *cursor;
+
+	oac_cursor->inner->destroy(&oac_cursor->inner);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+oacdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+ion_err_t
+oacdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+/**
+@brief		Tells the size of a concurrent hash dictionary, see
+			@ref dictionary_get_info, summed over its stripes. They are
+			read without their locks, so the sums are only as exact as
+			the writers made meanwhile allow.
+*/
+static ion_err_t
+oacdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_oac_hashmap_t	*oac	= (ion_oac_hashmap_t *) dictionary->instance;
+	ion_hashmap_t		*map;
+	int					i;
+
+	info->record_count	= 0;
+	info->file_bytes	= 0;
+	info->pages			= 0;
+	info->memory_bytes	= 0;
+
+	for (i = 0; i < oac->stripe_count; i++) {
+		map					= &oac->stripes[i].map;
+		info->record_count	+= map->count;
+		info->pages			+= map->map_size;
+		info->memory_bytes	+= (long) map->map_size * map->bucket_size;
+	}
+
+	return err_ok;
+}
+
+void
+oacdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= oacdict_insert;
+	handler->create_dictionary	= oacdict_create_dictionary;
+	handler->get				= oacdict_query;
+	handler->update				= oacdict_update;
+	handler->find				= oacdict_find;
+	handler->remove				= oacdict_delete;
+	handler->delete_dictionary	= oacdict_delete_dictionary;
+	handler->close_dictionary	= oacdict_close_dictionary;
+	handler->open_dictionary	= oacdict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= oacdict_get_info;
+	handler->bulk_load			= NULL;
+}
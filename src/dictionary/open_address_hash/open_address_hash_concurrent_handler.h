@@ -0,0 +1,314 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a thread-safe variant of the in memory hash
+			table, split into stripes that are locked independently.
+@details	Each stripe is an ordinary @ref ion_hashmap_t holding the keys
+			that hash to it. Writers lock the stripe they change; readers
+			take no lock at all, and instead check the stripe's version
+			before and after a lookup, retrying if a writer got in
+			between. Only available on hosts with POSIX threads.
+*/
+/******************************************************************************/
+
+#if !defined(OPEN_ADDRESS_CONCURRENT_HANDLER_H_)
+#define OPEN_ADDRESS_CONCURRENT_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <pthread.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "open_address_hash.h"
+#include "open_address_hash_dictionary_handler.h"
+
+/**
+@brief		The most stripes a dictionary is split into.
+*/
+#if !defined(ION_OAC_STRIPES)
+#define ION_OAC_STRIPES 64
+#endif
+
+/**
+@brief		The fewest buckets an even share of the dictionary size
+			gives each stripe. Small dictionaries use fewer stripes
+			rather than go below it, as keys spread less evenly over
+			small stripes.
+*/
+#if !defined(ION_OAC_STRIPE_MIN_SIZE)
+#define ION_OAC_STRIPE_MIN_SIZE 64
+#endif
+
+/**
+@brief		How much larger, in percent, each stripe is made than an even
+			share of the dictionary size, so a dictionary filled to its
+			size still fits when its keys land unevenly.
+@details	Stripes never resize: a reader may be walking a stripe's
+			table while a writer changes it, so the table must stay put.
+*/
+#if !defined(ION_OAC_STRIPE_SLACK_PERCENT)
+#define ION_OAC_STRIPE_SLACK_PERCENT 50
+#endif
+
+/**
+@brief		How many times a lookup is retried without a lock before it
+			waits for the stripe's writers instead.
+*/
+#if !defined(ION_OAC_READ_ATTEMPTS)
+#define ION_OAC_READ_ATTEMPTS 8
+#endif
+
+/**
+@brief		One independently locked part of a concurrent map.
+*/
+typedef struct oac_stripe {
+	ion_hashmap_t		map;		/**< The records of this stripe */
+	ion_dictionary_t	dictionary;	/**< @c map as a dictionary, for the
+									 cursors run over it */
+	pthread_mutex_t		lock;		/**< Held by writers of @c map */
+	uint32_t			version;	/**< Odd while a writer is changing
+									 @c map */
+} ion_oac_stripe_t;
+
+/**
+@brief		A concurrent in memory hash map.
+*/
+typedef struct oac_hashmap {
+	ion_dictionary_parent_t super;
+	int						stripe_count;	/**< The number of stripes */
+	ion_oac_stripe_t		*stripes;		/**< The stripes, each holding
+											 the keys that hash to it */
+} ion_oac_hashmap_t;
+
+/**
+@brief		A cursor over a concurrent map, walking its stripes in turn.
+@details	Each stripe is only locked while a record is read from it, so
+			records moved by writers between two reads may be skipped or
+			returned twice.
+*/
+typedef struct oacdict_cursor {
+	ion_dict_cursor_t	super;	/**< Cursor supertype this type inherits
+								 from */
+	int					stripe;	/**< The stripe @c inner walks */
+	int					last;	/**< The last stripe to walk */
+	ion_dict_cursor_t	*inner;	/**< A cursor over the current stripe */
+} ion_oacdict_cursor_t;
+
+/**
+@brief		Registers the concurrent open address hash handler.
+
+@details	Registers functions for handlers. The dictionaries created
+			with it may be used from several threads at once.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+oacdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Inserts a record into the stripe its key hashes to.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+oacdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up a key without taking a lock.
+
+@details	The lookup is retried if a writer changed the stripe while it
+			ran, and done under the stripe's lock after
+			@ref ION_OAC_READ_ATTEMPTS attempts. @p value is only written
+			once a consistent result has been found.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+oacdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Creates a concurrent open address hash dictionary.
+
+@param		id
+				The identifier of the dictionary, which seeds its hash.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The number of records the dictionary is expected to hold.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+oacdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes a key from the stripe it hashes to.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+oacdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a concurrent dictionary and frees its stripes.
+
+@details	No other thread may be using the dictionary.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+oacdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+oacdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate.
+
+@details	Equality cursors only visit the stripe of their key, others
+			visit every stripe in turn. See @ref ion_oacdict_cursor_t.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+oacdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a concurrent map cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+oacdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a concurrent map cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+oacdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opening is not supported by the in memory hash.
+
+@return		@c err_not_implemented.
+*/
+ion_err_t
+oacdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closing is not supported by the in memory hash.
+
+@return		@c err_not_implemented.
+*/
+ion_err_t
+oacdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* OPEN_ADDRESS_CONCURRENT_HANDLER_H_ */
@@ -12,10 +12,14 @@ extern "C" {
 
 #include "../dictionary_types.h"
 
+#if !defined(ION_HASH_T_DEFINED)
+#define ION_HASH_T_DEFINED
+
 /**
-@brief		The position in the hashmap.
+@brief		The position in the hashmap, shared by both hash engines.
 */
 typedef int ion_hash_t;
+#endif
 
 typedef struct oadict_cursor {
 	ion_dict_cursor_t	super;			/**< Cursor supertype this type inherits from */
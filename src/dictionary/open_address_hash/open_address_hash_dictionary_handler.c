@@ -41,6 +41,52 @@ oadict_query(
 	return oah_query((ion_hashmap_t *) dictionary->instance, key, value);
 }
 
+/**
+@brief		Points at the value of a key, see @ref oah_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to look up.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the lookup.
+*/
+ion_status_t
+oadict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return oah_get_ref((ion_hashmap_t *) dictionary->instance, key, value);
+}
+
+/**
+@brief		Looks up a batch of keys, see @ref oah_get_many.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		keys
+				@p count keys, stored back to back.
+@param		values
+				Room for @p count values, stored back to back.
+@param		statuses
+				If not @c NULL, receives the status of each lookup.
+@param		count
+				The number of keys.
+@return		The status of the batch.
+*/
+ion_status_t
+oadict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+) {
+	return oah_get_many((ion_hashmap_t *) dictionary->instance, keys, values, statuses, count);
+}
+
 /**
 
 @brief		  Starts scanning map looking for conditions that match
@@ -61,16 +107,26 @@ oadict_scan(
 	/* need to scan hashmap fully looking for values that satisfy - need to think about */
 	ion_hashmap_t *hash_map = (ion_hashmap_t *) (cursor->super.dictionary->instance);
 
-	int loc					= (cursor->current + 1) % hash_map->map_size;
+	int loc					= cursor->current + 1;
 
 	/* this is the current position of the cursor */
 	/* and start scanning 1 ahead */
 
 	/* start at the current position, scan forward */
 	while (loc != cursor->first) {
+		if (loc >= hash_map->map_size) {
+			/* a scan of the whole map ends at the last slot, others wrap back to where they began */
+			if (cs_invalid_index == cursor->first) {
+				break;
+			}
+
+			loc = 0;
+			continue;
+		}
+
 		/* check to see if current item is a match based on key */
 		/* locate first item */
-		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc))));
+		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + hash_map->bucket_size * loc))));
 
 		if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 			/* if empty, just skip to next cell */
@@ -79,9 +135,8 @@ oadict_scan(
 		else {
 			/* check to see if the current key value satisfies the predicate */
 
-			/* TODO need to check key match; what's the most efficient way? */
-
-			ion_boolean_t key_satisfies_predicate = test_predicate(&(cursor->super), item->data);	/* assumes that the key is first */
+			/* the key is first, the value right after it */
+			ion_boolean_t key_satisfies_predicate = test_record_predicate(&(cursor->super), item->data, item->data + hash_map->super.record.key_size);
 
 			if (key_satisfies_predicate == boolean_true) {
 				cursor->current = loc;	/* this is the next index for value */
@@ -91,11 +146,6 @@ oadict_scan(
 			/* If valid bucket is not found, advance current position. */
 			loc++;
 		}
-
-		if (loc >= hash_map->map_size) {
-			/* Perform wrapping */
-			loc = 0;
-		}
 	}
 
 	/* if you end up here, you've wrapped the entire data structure and not found a value */
@@ -126,8 +176,11 @@ oadict_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
+	/* cursors walk the current table only */
+	oah_finish_rehash((ion_hashmap_t *) dictionary->instance);
+
 	/* allocate memory for cursor */
-	if ((*cursor = malloc(sizeof(ion_oadict_cursor_t))) == NULL) {
+	if ((*cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_oadict_cursor_t))) == NULL) {
 		return err_out_of_memory;
 	}
 
@@ -136,22 +189,28 @@ oadict_find(
 
 	/* bind destroy method for cursor */
 	(*cursor)->destroy				= oadict_destroy_cursor;
+	(*cursor)->next_batch			= NULL;
 
 	/* bind correct next function */
 	(*cursor)->next					= oadict_next;	/* this will use the correct value */
 
 	/* allocate predicate */
-	(*cursor)->predicate			= malloc(sizeof(ion_predicate_t));
+	(*cursor)->predicate			= ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t));
 	(*cursor)->predicate->type		= predicate->type;
 	(*cursor)->predicate->destroy	= predicate->destroy;
 
+	/* a predicate query scans as all records do, its filter tested in the map */
+	if (predicate_predicate == predicate->type) {
+		(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+	}
+
 	/* based on the type of predicate that is being used, need to create the correct cursor */
 	switch (predicate->type) {
 		case predicate_equality: {
 			/* as this is an equality, need to malloc for key as well */
-			if (((*cursor)->predicate->statement.equality.equality_value = malloc((((ion_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
-				free((*cursor)->predicate);
-				free(*cursor);	/* cleanup */
+			if (((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, (((ion_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);	/* cleanup */
 				return err_out_of_memory;
 			}
 
@@ -182,9 +241,9 @@ oadict_find(
 		}
 
 		case predicate_range: {
-			if (((*cursor)->predicate->statement.range.lower_bound = malloc((((ion_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
-				free((*cursor)->predicate);
-				free(*cursor);	/* cleanup */
+			if (((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, (((ion_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);	/* cleanup */
 				return err_out_of_memory;
 			}
 
@@ -192,21 +251,20 @@ oadict_find(
 			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, (((ion_hashmap_t *) dictionary->instance)->super.record.key_size));
 
 			/* as this is a range, need to malloc upper bound key */
-			if (((*cursor)->predicate->statement.range.upper_bound = malloc((((ion_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
-				free((*cursor)->predicate->statement.range.lower_bound);
-				free((*cursor)->predicate);
-				free(*cursor);	/* cleanup */
+			if (((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, (((ion_hashmap_t *) dictionary->instance)->super.record.key_size))) == NULL) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);	/* cleanup */
 				return err_out_of_memory;
 			}
 
 			/* copy across the key value as the predicate may be destroyed */
 			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, (((ion_hashmap_t *) dictionary->instance)->super.record.key_size));
 
-			ion_oadict_cursor_t *oadict_cursor	= (ion_oadict_cursor_t *) (*cursor);
-			ion_hashmap_t		*hash_map		= ((ion_hashmap_t *) dictionary->instance);
+			ion_oadict_cursor_t *oadict_cursor = (ion_oadict_cursor_t *) (*cursor);
 
 			(*cursor)->status		= cs_cursor_initialized;
-			oadict_cursor->first	= (hash_map->map_size) - 1;
+			oadict_cursor->first	= cs_invalid_index;
 			oadict_cursor->current	= -1;
 
 			ion_err_t err = oadict_scan(oadict_cursor);
@@ -219,12 +277,12 @@ oadict_find(
 			break;
 		}
 
-		case predicate_all_records: {
-			ion_oadict_cursor_t *oadict_cursor	= (ion_oadict_cursor_t *) (*cursor);
-			ion_hashmap_t		*hash_map		= ((ion_hashmap_t *) dictionary->instance);
+		case predicate_all_records:
+		case predicate_predicate: {
+			ion_oadict_cursor_t *oadict_cursor = (ion_oadict_cursor_t *) (*cursor);
 
 			(*cursor)->status		= cs_cursor_initialized;
-			oadict_cursor->first	= (hash_map->map_size) - 1;
+			oadict_cursor->first	= cs_invalid_index;
 			oadict_cursor->current	= -1;
 
 			ion_err_t err = oadict_scan(oadict_cursor);
@@ -237,10 +295,6 @@ oadict_find(
 			break;
 		}
 
-		case predicate_predicate: {
-			break;
-		}
-
 		default: {
 			return err_invalid_predicate;	/* * Invalid predicate supplied */
 			break;
@@ -253,6 +307,11 @@ oadict_find(
 /**
 @brief			Opens a specific open address hash instance of a dictionary.
 
+@details		Loads the snapshot written when it was closed, see
+				@ref oah_load, and deletes it. Without one,
+				@c err_not_implemented lets the generic open rebuild the
+				dictionary from wherever the generic close left it.
+
 @param			handler
 					A pointer to the handler for the specific dictionary being opened.
 @param			dictionary
@@ -272,16 +331,49 @@ oadict_open_dictionary(
 	ion_dictionary_config_info_t	*config,
 	ion_dictionary_compare_t		compare
 ) {
-	UNUSED(handler);
-	UNUSED(dictionary);
-	UNUSED(config);
-	UNUSED(compare);
-	return err_not_implemented;
+	char			filename[ION_MAX_FILENAME_LENGTH];
+	ion_hashmap_t	*hash_map;
+	ion_err_t		err;
+
+	if (dictionary_get_filename(config->id, "oas", filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_initialization_failed;
+	}
+
+	if (NULL == (hash_map = ion_alloc(ion_alloc_other, sizeof(ion_hashmap_t)))) {
+		return err_out_of_memory;
+	}
+
+	hash_map->super.compare = compare;
+	err						= oah_load(hash_map, filename);
+
+	if ((err_ok == err) && ((hash_map->super.key_type != config->type) || (hash_map->super.record.key_size != config->key_size) || (hash_map->super.record.value_size != config->value_size))) {
+		oah_destroy(hash_map);
+		err = err_illegal_state;
+	}
+
+	if (err_ok != err) {
+		ion_free(hash_map);
+
+		/* without a snapshot, the records are where the generic close put them */
+		return err_file_open_error == err ? err_not_implemented : err;
+	}
+
+	/* the snapshot is consumed, later changes are only kept by the next close */
+	fremove(filename);
+
+	hash_map->super.id		= config->id;
+	dictionary->instance	= (ion_dictionary_parent_t *) hash_map;
+	dictionary->handler		= handler;
+
+	return err_ok;
 }
 
 /**
 @brief			Closes an open address hash instance of a dictionary.
 
+@details		Writes a snapshot of the map named after the dictionary id,
+				see @ref oah_save, then frees the map.
+
 @param			dictionary
 					A pointer to the specific dictionary instance to be closed.
 
@@ -291,8 +383,45 @@ ion_err_t
 oadict_close_dictionary(
 	ion_dictionary_t *dictionary
 ) {
-	UNUSED(dictionary);
-	return err_not_implemented;
+	char		filename[ION_MAX_FILENAME_LENGTH];
+	ion_err_t	err;
+
+	if (dictionary_get_filename(dictionary->instance->id, "oas", filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_destruction_error;
+	}
+
+	err = oah_save((ion_hashmap_t *) dictionary->instance, filename);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	return oadict_delete_dictionary(dictionary);
+}
+
+/**
+@brief		Tells the size of an open address hash dictionary, see
+			@ref dictionary_get_info. Its buckets are its pages, and a
+			table being drained by a resize is counted with them.
+*/
+static ion_err_t
+oadict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_hashmap_t *hash_map = (ion_hashmap_t *) dictionary->instance;
+
+	info->record_count	= hash_map->count;
+	info->file_bytes	= 0;
+	info->pages			= hash_map->map_size;
+	info->memory_bytes	= (long) hash_map->map_size * hash_map->bucket_size;
+
+	if (NULL != hash_map->old_entry) {
+		info->pages			+= hash_map->old_size;
+		info->memory_bytes	+= (long) hash_map->old_size * hash_map->bucket_size;
+	}
+
+	return err_ok;
 }
 
 void
@@ -308,6 +437,13 @@ oadict_init(
 	handler->delete_dictionary	= oadict_delete_dictionary;
 	handler->close_dictionary	= oadict_close_dictionary;
 	handler->open_dictionary	= oadict_open_dictionary;
+	handler->get_many			= oadict_get_many;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= oadict_get_ref;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= oadict_get_info;
+	handler->bulk_load			= NULL;
 }
 
 ion_status_t
@@ -330,14 +466,15 @@ oadict_create_dictionary(
 	ion_dictionary_handler_t	*handler,
 	ion_dictionary_t			*dictionary
 ) {
-	UNUSED(id);
 	/* this is the instance of the hashmap */
-	dictionary->instance			= malloc(sizeof(ion_hashmap_t));
+	dictionary->instance			= ion_alloc(ion_alloc_other, sizeof(ion_hashmap_t));
 
 	dictionary->instance->compare	= compare;
 
 	/* this registers the dictionary the dictionary */
-	oah_initialize((ion_hashmap_t *) dictionary->instance, oah_compute_simple_hash, key_type, key_size, value_size, dictionary_size);	/* just pick an arbitary size for testing atm */
+	oah_initialize((ion_hashmap_t *) dictionary->instance, oah_compute_seeded_hash, key_type, key_size, value_size, dictionary_size);	/* just pick an arbitary size for testing atm */
+	((ion_hashmap_t *) dictionary->instance)->seed		= id;
+	((ion_hashmap_t *) dictionary->instance)->resizable = ION_OAH_GROW_LOAD_PERCENT > 0;
 
 	/*TODO The correct comparison operator needs to be bound at run time
 	 * based on the type of key defined
@@ -363,7 +500,7 @@ oadict_delete_dictionary(
 ) {
 	ion_err_t result = oah_destroy((ion_hashmap_t *) dictionary->instance);
 
-	free(dictionary->instance);
+	ion_free(dictionary->instance);
 	dictionary->instance = NULL;/* When releasing memory, set pointer to NULL */
 	return result;
 }
@@ -398,9 +535,6 @@ oadict_next(
 		ion_hashmap_t *hash_map = ((ion_hashmap_t *) cursor->dictionary->instance);
 
 		/* assume that the value has been pre-allocated */
-		/* compute length of data record stored in map */
-		int data_length = hash_map->super.record.key_size + hash_map->super.record.value_size;
-
 		if (cursor->status == cs_cursor_active) {
 			/* find the next valid entry */
 
@@ -418,7 +552,7 @@ oadict_next(
 		}
 
 		/* the results are now ready //reference item at given position */
-		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (data_length + SIZEOF(STATUS)) * oadict_cursor->current /*idx*/))));
+		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + hash_map->bucket_size * oadict_cursor->current /*idx*/))));
 
 		/*@todo A discussion needs to be had regarding ion_record_t and its format in memory etc */
 		/* and copy key and value in */
@@ -454,6 +588,21 @@ oadict_destroy_cursor(
 	ion_dict_cursor_t **cursor
 ) {
 	(*cursor)->predicate->destroy(&(*cursor)->predicate);
-	free(*cursor);
+	ion_free(*cursor);
 	*cursor = NULL;
 }
+
+ion_err_t
+oadict_stats(
+	ion_dictionary_t	*dictionary,
+	ion_hash_stats_t	*stats
+) {
+	return oah_stats((ion_hashmap_t *) dictionary->instance, stats);
+}
+
+ion_err_t
+oadict_reset_stats(
+	ion_dictionary_t *dictionary
+) {
+	return oah_reset_stats((ion_hashmap_t *) dictionary->instance);
+}
@@ -264,6 +264,55 @@ oadict_destroy_cursor(
 	ion_dict_cursor_t **cursor
 );
 
+/**
+@brief	  Finds multiple instances of a keys that satisfy the provided
+			 predicate in the dictionary.
+
+@param	  dictionary
+				The instance of the dictionary to search.
+@param	  predicate
+				The predicate to be used as the condition for matching.
+@param	  cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return	 The status of the operation.
+*/
+ion_err_t
+oadict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the probe and bucket statistics of an open address hash
+			dictionary, see @ref oah_stats.
+
+@param		dictionary
+				An open address hash dictionary.
+@param		stats
+				Filled with the statistics.
+@return		The status of the call.
+*/
+ion_err_t
+oadict_stats(
+	ion_dictionary_t	*dictionary,
+	ion_hash_stats_t	*stats
+);
+
+/**
+@brief		Starts a new measurement period for an open address hash
+			dictionary.
+
+@param		dictionary
+				An open address hash dictionary.
+@return		The status of the call.
+*/
+ion_err_t
+oadict_reset_stats(
+	ion_dictionary_t *dictionary
+);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,752 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that keeps secondary indexes registered in the master
+			table on a dictionary of any other handler.
+*/
+/******************************************************************************/
+
+#include "secondary_index_dictionary_handler.h"
+
+/**
+@brief		Where the indexed bytes and the key of their record sit in an
+			index key.
+@details	Unsigned keys compare from their most significant byte, the
+			last one on a little endian platform and the first otherwise,
+			so the indexed bytes are put at that end.
+*/
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define ION_SIDX_FIELD_AT(key_size, field_size) (key_size)
+#define ION_SIDX_KEY_AT(key_size, field_size)	0
+#else
+#define ION_SIDX_FIELD_AT(key_size, field_size) 0
+#define ION_SIDX_KEY_AT(key_size, field_size)	(field_size)
+#endif
+
+/**
+@brief		Builds the key of a record in an index.
+*/
+static void
+sidxdict_index_key(
+	ion_sidx_dictionary_t	*sidx_dict,
+	ion_sidx_index_t		*index,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_byte_t				*index_key
+) {
+	ion_key_size_t key_size = sidx_dict->super.record.key_size;
+
+	memcpy(index_key + ION_SIDX_KEY_AT(key_size, index->size), key, key_size);
+	memcpy(index_key + ION_SIDX_FIELD_AT(key_size, index->size), (ion_byte_t *) value + index->offset, index->size);
+}
+
+/**
+@brief		Writes a record to an index.
+*/
+static ion_err_t
+sidxdict_index_record(
+	ion_sidx_dictionary_t	*sidx_dict,
+	ion_sidx_index_t		*index,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_byte_t *index_key = alloca(index->dictionary.instance->record.key_size);
+
+	sidxdict_index_key(sidx_dict, index, key, value, index_key);
+
+	return dictionary_insert(&index->dictionary, index_key, key).error;
+}
+
+/**
+@brief		Takes a record out of an index.
+*/
+static ion_err_t
+sidxdict_unindex_record(
+	ion_sidx_dictionary_t	*sidx_dict,
+	ion_sidx_index_t		*index,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_byte_t		*index_key = alloca(index->dictionary.instance->record.key_size);
+	ion_status_t	status;
+
+	sidxdict_index_key(sidx_dict, index, key, value, index_key);
+	status = dictionary_delete(&index->dictionary, index_key);
+
+	return (err_item_not_found == status.error) ? err_ok : status.error;
+}
+
+/**
+@brief		Points the indexes back at their own handlers once the array
+			holding them has moved.
+*/
+static void
+sidxdict_rebind(
+	ion_sidx_dictionary_t *sidx_dict
+) {
+	int i;
+
+	for (i = 0; i < sidx_dict->index_count; i++) {
+		sidx_dict->indexes[i].dictionary.handler = &sidx_dict->indexes[i].handler;
+	}
+}
+
+/**
+@brief		Writes every record already in a dictionary to an index.
+*/
+static ion_err_t
+sidxdict_fill(
+	ion_sidx_dictionary_t	*sidx_dict,
+	ion_sidx_index_t		*index
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	ion_err_t			err;
+
+	record.key		= ion_alloc(ion_alloc_buffer, sidx_dict->super.record.key_size);
+	record.value	= ion_alloc(ion_alloc_buffer, sidx_dict->super.record.value_size);
+
+	if ((NULL == record.key) || (NULL == record.value)) {
+		ion_free(record.key);
+		ion_free(record.value);
+		return err_out_of_memory;
+	}
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	err = dictionary_find(&sidx_dict->inner, &predicate, &cursor);
+
+	while ((err_ok == err) && (cs_cursor_active == cursor->next(cursor, &record))) {
+		err = sidxdict_index_record(sidx_dict, index, record.key, record.value);
+	}
+
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	ion_free(record.key);
+	ion_free(record.value);
+
+	return err;
+}
+
+ion_err_t
+sidxdict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_handler_t	*index_handlers,
+	int							index_count
+) {
+	ion_sidx_dictionary_t			*sidx_dict;
+	ion_dictionary_config_info_t	config;
+	ion_err_t						err;
+	int								registered;
+	int								i;
+
+	/* every index registered must be given its handler */
+	config.id	= 0;
+	registered	= 0;
+
+	while (err_ok == (err = ion_find_index_master_table(dictionary->instance->id, &config))) {
+		registered++;
+	}
+
+	if ((err_item_not_found != err) || (registered != index_count)) {
+		return err_dictionary_initialization_failed;
+	}
+
+	if (NULL == (sidx_dict = ion_alloc(ion_alloc_other, sizeof(ion_sidx_dictionary_t)))) {
+		return err_out_of_memory;
+	}
+
+	sidx_dict->super			= *dictionary->instance;
+	sidx_dict->inner			= *dictionary;
+	sidx_dict->inner_handler	= *dictionary->handler;
+	sidx_dict->inner.handler	= &sidx_dict->inner_handler;
+	/* the durability too, so each write is pushed once */
+	sidx_dict->inner.durability.level	= durability_none;
+	sidx_dict->inner.durability.pending	= 0;
+#if ION_DICTIONARY_STATS
+	/* the counters stay with the caller's dictionary, so each operation counts once */
+	sidx_dict->inner.stats		= NULL;
+#endif
+	sidx_dict->index_count		= 0;
+	sidx_dict->indexes			= NULL;
+
+	if ((index_count > 0) && (NULL == (sidx_dict->indexes = ion_alloc(ion_alloc_other, index_count * sizeof(ion_sidx_index_t))))) {
+		ion_free(sidx_dict);
+		return err_out_of_memory;
+	}
+
+	config.id = 0;
+
+	for (i = 0; i < index_count; i++) {
+		ion_sidx_index_t *index = sidx_dict->indexes + i;
+
+		if (err_ok != ion_find_index_master_table(dictionary->instance->id, &config)) {
+			break;
+		}
+
+		index->offset	= config.index_offset;
+		index->size		= config.index_size;
+		index->handler	= index_handlers[i];
+
+		if (err_ok != ion_open_dictionary(&index->handler, &index->dictionary, config.id)) {
+			break;
+		}
+
+		sidx_dict->index_count++;
+	}
+
+	if (sidx_dict->index_count != index_count) {
+		for (i = 0; i < sidx_dict->index_count; i++) {
+			dictionary_close(&sidx_dict->indexes[i].dictionary);
+		}
+
+		ion_free(sidx_dict->indexes);
+		ion_free(sidx_dict);
+		return err_dictionary_initialization_failed;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) sidx_dict;
+	dictionary->handler		= handler;
+	dictionary_opened(dictionary);
+
+	return err_ok;
+}
+
+ion_err_t
+sidxdict_create_index(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*index_handler,
+	ion_value_size_t			offset,
+	ion_value_size_t			size,
+	ion_dictionary_size_t		dictionary_size
+) {
+	ion_sidx_dictionary_t	*sidx_dict = (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_sidx_index_t		*indexes;
+	ion_sidx_index_t		*index;
+	ion_err_t				err;
+
+	if (sidxdict_insert != dictionary->handler->insert) {
+		return err_illegal_state;
+	}
+
+	if ((0 == size) || (offset + size > sidx_dict->super.record.value_size)) {
+		return err_invalid_initial_size;
+	}
+
+	ion_dictionary_config_info_t config = {
+		.id = 0, .use_type = 0, .type = key_type_numeric_unsigned, .key_size = sidx_dict->super.record.key_size + size, .value_size = sidx_dict->super.record.key_size, .dictionary_size = dictionary_size, .index_of = sidx_dict->super.id, .index_offset = offset, .index_size = size
+	};
+
+	if (NULL == (indexes = ion_realloc(ion_alloc_other, sidx_dict->indexes, (sidx_dict->index_count + 1) * sizeof(ion_sidx_index_t)))) {
+		return err_out_of_memory;
+	}
+
+	sidx_dict->indexes	= indexes;
+	sidxdict_rebind(sidx_dict);
+
+	index				= sidx_dict->indexes + sidx_dict->index_count;
+	index->offset		= offset;
+	index->size			= size;
+	index->handler		= *index_handler;
+
+	if (err_ok != (err = ion_master_table_create_dictionary_from_config(&index->handler, &index->dictionary, &config))) {
+		return err;
+	}
+
+	if (err_ok != (err = sidxdict_fill(sidx_dict, index))) {
+		/* the definition goes, so a later wrap does not expect the index */
+		ion_delete_from_master_table(&index->dictionary);
+		return err;
+	}
+
+	sidx_dict->index_count++;
+
+	return err_ok;
+}
+
+/**
+@brief		Reads the record of the next index record of an index cursor.
+*/
+static ion_cursor_status_t
+sidxdict_next_indexed(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_sidxdict_cursor_t	*index_cursor	= (ion_sidxdict_cursor_t *) cursor;
+	ion_sidx_dictionary_t	*sidx_dict		= (ion_sidx_dictionary_t *) cursor->dictionary->instance;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	while (cs_cursor_active == index_cursor->index_cursor->next(index_cursor->index_cursor, &index_cursor->index_record)) {
+		memcpy(record->key, index_cursor->index_record.value, sidx_dict->super.record.key_size);
+
+		if (err_ok == dictionary_get(&sidx_dict->inner, record->key, record->value).error) {
+			cursor->status = cs_cursor_active;
+			return cursor->status;
+		}
+	}
+
+	cursor->status = cs_end_of_results;
+
+	return cursor->status;
+}
+
+/**
+@brief		Destroys an index cursor.
+*/
+static void
+sidxdict_destroy_index_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_sidxdict_cursor_t *index_cursor = (ion_sidxdict_cursor_t *) *cursor;
+
+	index_cursor->index_cursor->destroy(&index_cursor->index_cursor);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+sidxdict_find_by_index(
+	ion_dictionary_t	*dictionary,
+	int					index,
+	ion_value_t			lower,
+	ion_value_t			upper,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_sidx_dictionary_t	*sidx_dict = (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_sidxdict_cursor_t	*index_cursor;
+	ion_sidx_index_t		*sidx_index;
+	ion_predicate_t			predicate;
+	ion_key_size_t			key_size;
+	ion_key_size_t			index_key_size;
+	ion_byte_t				*lower_key;
+	ion_byte_t				*upper_key;
+	ion_err_t				err;
+
+	if ((sidxdict_insert != dictionary->handler->insert) || (index < 0) || (index >= sidx_dict->index_count)) {
+		return err_illegal_state;
+	}
+
+	sidx_index		= sidx_dict->indexes + index;
+	key_size		= sidx_dict->super.record.key_size;
+	index_key_size	= sidx_index->dictionary.instance->record.key_size;
+
+	/* the index keys of a range of bytes run from them with the least key to them with the greatest */
+	lower_key		= alloca(index_key_size);
+	upper_key		= alloca(index_key_size);
+	memset(lower_key + ION_SIDX_KEY_AT(key_size, sidx_index->size), 0x00, key_size);
+	memset(upper_key + ION_SIDX_KEY_AT(key_size, sidx_index->size), 0xFF, key_size);
+	memcpy(lower_key + ION_SIDX_FIELD_AT(key_size, sidx_index->size), lower, sidx_index->size);
+	memcpy(upper_key + ION_SIDX_FIELD_AT(key_size, sidx_index->size), upper, sidx_index->size);
+
+	if (NULL == (index_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_sidxdict_cursor_t) + index_key_size + key_size))) {
+		return err_out_of_memory;
+	}
+
+	dictionary_build_predicate(&predicate, predicate_range, lower_key, upper_key);
+
+	if (err_ok != (err = dictionary_find(&sidx_index->dictionary, &predicate, &index_cursor->index_cursor))) {
+		ion_free(index_cursor);
+		return err;
+	}
+
+	index_cursor->index_record.key		= (ion_byte_t *) (index_cursor + 1);
+	index_cursor->index_record.value	= (ion_byte_t *) (index_cursor + 1) + index_key_size;
+	index_cursor->super.dictionary		= dictionary;
+	index_cursor->super.predicate		= NULL;
+	index_cursor->super.status			= (cs_end_of_results == index_cursor->index_cursor->status) ? cs_end_of_results : cs_cursor_initialized;
+	index_cursor->super.destroy			= sidxdict_destroy_index_cursor;
+	index_cursor->super.next_batch		= NULL;
+	index_cursor->super.next			= sidxdict_next_indexed;
+	*cursor								= (ion_dict_cursor_t *) index_cursor;
+
+	return err_ok;
+}
+
+ion_status_t
+sidxdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_sidx_dictionary_t	*sidx_dict	= (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_status_t			status		= dictionary_insert(&sidx_dict->inner, key, value);
+	ion_err_t				err;
+	int						i;
+
+	for (i = 0; (err_ok == status.error) && (i < sidx_dict->index_count); i++) {
+		if (err_ok != (err = sidxdict_index_record(sidx_dict, sidx_dict->indexes + i, key, value))) {
+			status.error = err;
+		}
+	}
+
+	return status;
+}
+
+ion_status_t
+sidxdict_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+) {
+	ion_sidx_dictionary_t	*sidx_dict		= (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_key_size_t			key_size		= sidx_dict->super.record.key_size;
+	ion_value_size_t		value_size		= sidx_dict->super.record.value_size;
+	ion_value_size_t		largest			= 0;
+	ion_status_t			*own_statuses	= NULL;
+	ion_byte_t				*index_keys		= NULL;
+	ion_byte_t				*index_values;
+	ion_sidx_index_t		*index;
+	ion_status_t			status;
+	ion_status_t			index_status;
+	int						inserted;
+	int						i;
+	int						j;
+
+	if (0 == sidx_dict->index_count) {
+		return dictionary_insert_many(&sidx_dict->inner, keys, values, statuses, count);
+	}
+
+	/* which records went in is needed to write them to the indexes */
+	if ((NULL == statuses) && (NULL == (statuses = own_statuses = ion_alloc(ion_alloc_buffer, count * sizeof(ion_status_t))))) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	status = dictionary_insert_many(&sidx_dict->inner, keys, values, statuses, count);
+
+	for (i = 0; i < sidx_dict->index_count; i++) {
+		if (sidx_dict->indexes[i].size > largest) {
+			largest = sidx_dict->indexes[i].size;
+		}
+	}
+
+	/* the index keys are followed by their values, the keys of the records */
+	if ((status.count > 0) && (NULL == (index_keys = ion_alloc(ion_alloc_buffer, (size_t) status.count * (key_size + largest + key_size))))) {
+		status.error = err_out_of_memory;
+	}
+
+	for (i = 0; (NULL != index_keys) && (i < sidx_dict->index_count); i++) {
+		index			= sidx_dict->indexes + i;
+		index_values	= index_keys + (size_t) status.count * (key_size + index->size);
+
+		for (inserted = 0, j = 0; j < count; j++) {
+			if ((err_ok != statuses[j].error) || (0 == statuses[j].count)) {
+				continue;
+			}
+
+			sidxdict_index_key(sidx_dict, index, (ion_byte_t *) keys + j * key_size, (ion_byte_t *) values + j * value_size, index_keys + inserted * (key_size + index->size));
+			memcpy(index_values + inserted * key_size, (ion_byte_t *) keys + j * key_size, key_size);
+			inserted++;
+		}
+
+		index_status = dictionary_insert_many(&index->dictionary, index_keys, index_values, NULL, inserted);
+
+		if ((err_ok == status.error) && (err_ok != index_status.error)) {
+			status.error = index_status.error;
+		}
+	}
+
+	ion_free(index_keys);
+	ion_free(own_statuses);
+
+	return status;
+}
+
+ion_status_t
+sidxdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return dictionary_get(&((ion_sidx_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_status_t
+sidxdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return dictionary_get_ref(&((ion_sidx_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_err_t
+sidxdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+	UNUSED(key_type);
+	UNUSED(key_size);
+	UNUSED(value_size);
+	UNUSED(dictionary_size);
+	UNUSED(compare);
+	UNUSED(handler);
+	UNUSED(dictionary);
+	return err_dictionary_initialization_failed;
+}
+
+/**
+@brief		Takes the records of a key out of the indexes, as they are
+			before an update or delete.
+@param		moved
+				If not @c NULL, tells for each index whether the bytes of
+				some record of the key differed from those of @p value,
+				which the records left in that index have.
+@param		found
+				If not @c NULL, tells whether the key has any records.
+*/
+static ion_err_t
+sidxdict_unindex_key(
+	ion_sidx_dictionary_t	*sidx_dict,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_boolean_t			*moved,
+	ion_boolean_t			*found
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	ion_sidx_index_t	*index;
+	ion_err_t			err;
+	int					i;
+
+	record.key		= ion_alloc(ion_alloc_buffer, sidx_dict->super.record.key_size);
+	record.value	= ion_alloc(ion_alloc_buffer, sidx_dict->super.record.value_size);
+
+	if ((NULL == record.key) || (NULL == record.value)) {
+		ion_free(record.key);
+		ion_free(record.value);
+		return err_out_of_memory;
+	}
+
+	dictionary_build_predicate(&predicate, predicate_equality, key);
+	err = dictionary_find(&sidx_dict->inner, &predicate, &cursor);
+
+	while ((err_ok == err) && (cs_cursor_active == cursor->next(cursor, &record))) {
+		if (NULL != found) {
+			*found = boolean_true;
+		}
+
+		for (i = 0; (err_ok == err) && (i < sidx_dict->index_count); i++) {
+			index = sidx_dict->indexes + i;
+
+			if (NULL != moved) {
+				if (0 == memcmp((ion_byte_t *) record.value + index->offset, (ion_byte_t *) value + index->offset, index->size)) {
+					continue;
+				}
+
+				moved[i] = boolean_true;
+			}
+
+			err = sidxdict_unindex_record(sidx_dict, index, key, record.value);
+		}
+	}
+
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	ion_free(record.key);
+	ion_free(record.value);
+
+	return err;
+}
+
+ion_status_t
+sidxdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_sidx_dictionary_t	*sidx_dict = (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err;
+
+	/* the values of the key are read before they are gone */
+	if ((sidx_dict->index_count > 0) && (err_ok != (err = sidxdict_unindex_key(sidx_dict, key, NULL, NULL, NULL)))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	return dictionary_delete(&sidx_dict->inner, key);
+}
+
+ion_err_t
+sidxdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_sidx_dictionary_t	*sidx_dict	= (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err			= dictionary_delete_dictionary(&sidx_dict->inner);
+	ion_err_t				index_err;
+	int						i;
+
+	for (i = 0; i < sidx_dict->index_count; i++) {
+		index_err = dictionary_delete_dictionary(&sidx_dict->indexes[i].dictionary);
+
+		if (err_ok == err) {
+			err = index_err;
+		}
+	}
+
+	ion_free(sidx_dict->indexes);
+	ion_free(sidx_dict);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+sidxdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_sidx_dictionary_t	*sidx_dict	= (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_boolean_t			found		= boolean_false;
+	ion_boolean_t			*moved;
+	ion_status_t			status;
+	ion_err_t				err;
+	int						i;
+
+	if (0 == sidx_dict->index_count) {
+		return dictionary_update(&sidx_dict->inner, key, value);
+	}
+
+	moved = alloca(sidx_dict->index_count * sizeof(ion_boolean_t));
+
+	for (i = 0; i < sidx_dict->index_count; i++) {
+		moved[i] = boolean_false;
+	}
+
+	if (err_ok != (err = sidxdict_unindex_key(sidx_dict, key, value, moved, &found))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	status = dictionary_update(&sidx_dict->inner, key, value);
+
+	for (i = 0; (err_ok == status.error) && (i < sidx_dict->index_count); i++) {
+		/* an update of a key there was none of inserts it, which every index then needs */
+		if ((found && !moved[i]) || (err_ok == (err = sidxdict_index_record(sidx_dict, sidx_dict->indexes + i, key, value)))) {
+			continue;
+		}
+
+		status.error = err;
+	}
+
+	return status;
+}
+
+ion_err_t
+sidxdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	return dictionary_find(&((ion_sidx_dictionary_t *) dictionary->instance)->inner, predicate, cursor);
+}
+
+ion_err_t
+sidxdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_dictionary_initialization_failed;
+}
+
+ion_err_t
+sidxdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_sidx_dictionary_t	*sidx_dict	= (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err			= dictionary_close(&sidx_dict->inner);
+	ion_err_t				index_err;
+	int						i;
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	for (i = 0; i < sidx_dict->index_count; i++) {
+		index_err = dictionary_close(&sidx_dict->indexes[i].dictionary);
+
+		if (err_ok == err) {
+			err = index_err;
+		}
+	}
+
+	ion_free(sidx_dict->indexes);
+	ion_free(sidx_dict);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+/**
+@brief		Pushes every write of a indexed dictionary through to storage.
+*/
+static ion_err_t
+sidxdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_sidx_dictionary_t	*sidx_dict	= (ion_sidx_dictionary_t *) dictionary->instance;
+	ion_err_t				err			= dictionary_sync(&sidx_dict->inner);
+	int						i;
+
+	for (i = 0; (err_ok == err) && (i < sidx_dict->index_count); i++) {
+		err = dictionary_sync(&sidx_dict->indexes[i].dictionary);
+	}
+
+	return err;
+}
+
+/**
+@brief		Tells the size of an indexed dictionary, see
+			@ref dictionary_get_info. Its indexes are dictionaries of the
+			master table, which tell their own.
+*/
+static ion_err_t
+sidxdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	return dictionary_get_info(&((ion_sidx_dictionary_t *) dictionary->instance)->inner, info);
+}
+
+void
+sidxdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= sidxdict_insert;
+	handler->create_dictionary	= sidxdict_create_dictionary;
+	handler->get				= sidxdict_query;
+	handler->update				= sidxdict_update;
+	handler->find				= sidxdict_find;
+	handler->remove				= sidxdict_delete;
+	handler->delete_dictionary	= sidxdict_delete_dictionary;
+	handler->close_dictionary	= sidxdict_close_dictionary;
+	handler->open_dictionary	= sidxdict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= sidxdict_insert_many;
+	handler->delete_many		= NULL;
+	handler->get_ref			= sidxdict_get_ref;
+	handler->sync_dictionary	= sidxdict_sync_dictionary;
+	handler->get_info			= sidxdict_get_info;
+	handler->bulk_load			= NULL;
+}
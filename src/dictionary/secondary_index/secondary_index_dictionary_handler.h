@@ -0,0 +1,422 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that keeps secondary indexes registered in the master
+			table on a dictionary of any other handler.
+@details	An index covers a range of bytes of the values, and is itself
+			a dictionary of any handler that can find a range of keys,
+			created with @ref sidxdict_create_index. Its definition is kept
+			in the master table, in the @c index_of, @c index_offset and
+			@c index_size of its record, so once the indexed dictionary is
+			opened again @ref sidxdict_wrap opens its indexes with it.
+			From then on every insert, update and delete through the
+			handler writes the indexes as well, a batch insert writing
+			each index in one batch too, and @ref sidxdict_find_by_index
+			gives the records of the indexed dictionary whose bytes fall
+			in a range.
+
+			Each index record pairs the indexed bytes with the key of the
+			record they came from, so the records of a key can be taken
+			out of an index without touching those of other keys with the
+			same bytes. Index keys compare as unsigned integers, the
+			indexed bytes being the most significant, so a range on the
+			indexed bytes is a range of index keys, and indexed bytes
+			compare as an unsigned integer of their size in the byte
+			order of the platform.
+
+			Records are read back by their key, so for a dictionary with
+			duplicate keys every record of a key reads its first value.
+			A handler given to @ref sidxdict_create_index is not recorded
+			in the master table, so the same handlers are given again, in
+			the order the indexes were created, to each
+			@ref sidxdict_wrap.
+*/
+/******************************************************************************/
+
+#if !defined(SECONDARY_INDEX_DICTIONARY_HANDLER_H_)
+#define SECONDARY_INDEX_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../ion_master_table.h"
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		A secondary index of a dictionary.
+*/
+typedef struct {
+	ion_value_size_t			offset;		/**< Where the indexed bytes start
+											 in the value */
+	ion_value_size_t			size;		/**< How many there are */
+	ion_dictionary_t			dictionary;	/**< The index, keyed by the
+											 indexed bytes and the key of
+											 their record */
+	ion_dictionary_handler_t	handler;	/**< Its handler */
+} ion_sidx_index_t;
+
+/**
+@brief		A dictionary with secondary indexes.
+*/
+typedef struct secondary_index_dictionary {
+	ion_dictionary_parent_t		super;
+	ion_dictionary_t			inner;			/**< The indexed dictionary */
+	ion_dictionary_handler_t	inner_handler;	/**< Its handler, kept here as
+												 the caller's is rebound to
+												 the indexes */
+	ion_sidx_index_t			*indexes;		/**< Its indexes, in the order
+												 they were created */
+	int							index_count;	/**< How many */
+} ion_sidx_dictionary_t;
+
+/**
+@brief		A cursor over the records found through an index.
+*/
+typedef struct sidxdict_cursor {
+	ion_dict_cursor_t	super;			/**< Cursor supertype this type
+										 inherits from */
+	ion_dict_cursor_t	*index_cursor;	/**< The range of the index */
+	ion_record_t		index_record;	/**< Receives each index record */
+} ion_sidxdict_cursor_t;
+
+/**
+@brief		Registers the secondary index handler.
+
+@details	The handler cannot create dictionaries of its own, it only
+			serves those given to @ref sidxdict_wrap.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+sidxdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Opens the secondary indexes of a dictionary.
+
+@details	The indexes registered on the dictionary in the master table
+			are opened, none at all being fine, and from then on the
+			dictionary is used through @p handler as before. Closing it
+			closes the indexes, and deleting it deletes them, but their
+			records stay in the master table until the dictionary is
+			removed from it with @ref ion_delete_from_master_table. Every
+			handler given is copied, so they may be reused.
+
+@param		dictionary
+				A dictionary created or opened through the master table
+				with any handler.
+@param		handler
+				A handler registered with @ref sidxdict_init, to bind to
+				@p dictionary.
+@param		index_handlers
+				The handlers of the indexes, in the order they were
+				created.
+@param		index_count
+				How many, which is the number of indexes registered.
+@return		The status of the wrap: @c err_dictionary_initialization_failed
+			if as many indexes are not registered or one fails to open.
+			@p dictionary is left as it was unless it is @c err_ok.
+*/
+ion_err_t
+sidxdict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_handler_t	*index_handlers,
+	int							index_count
+);
+
+/**
+@brief		Creates a secondary index on a range of bytes of the values of
+			a dictionary and registers it in the master table.
+
+@details	The records already in the dictionary are written to the
+			index. It becomes the last of the indexes, as numbered for
+			@ref sidxdict_find_by_index.
+
+@param		dictionary
+				A dictionary wrapped with @ref sidxdict_wrap.
+@param		index_handler
+				The handler of the engine to keep the index in, which must
+				find ranges of keys.
+@param		offset
+				Where the indexed bytes start in the value.
+@param		size
+				How many there are.
+@param		dictionary_size
+				The size parameter of the index's engine.
+@return		@c err_ok, @c err_illegal_state if @p dictionary is not
+			wrapped, @c err_invalid_initial_size if the bytes do not lie
+			within the value, or the error creating or filling the index.
+			The index is not registered unless it is @c err_ok.
+*/
+ion_err_t
+sidxdict_create_index(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*index_handler,
+	ion_value_size_t			offset,
+	ion_value_size_t			size,
+	ion_dictionary_size_t		dictionary_size
+);
+
+/**
+@brief		Opens a cursor over the records whose indexed bytes fall in a
+			range, in the order of the index.
+
+@details	The cursor is used and destroyed as any other, and gives the
+			keys and values of the indexed dictionary.
+
+@param		dictionary
+				A dictionary wrapped with @ref sidxdict_wrap.
+@param		index
+				Which index, from 0, in the order they were created.
+@param		lower
+				The least indexed bytes to find, of the size of the index.
+@param		upper
+				The greatest, the same as @p lower to find one value.
+@param		cursor
+				Receives the cursor.
+@return		@c err_ok, @c err_illegal_state if @p dictionary is not
+			wrapped or has no such index, or the error opening the cursor
+			of the index.
+*/
+ion_err_t
+sidxdict_find_by_index(
+	ion_dictionary_t	*dictionary,
+	int					index,
+	ion_value_t			lower,
+	ion_value_t			upper,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Inserts a record into the indexed dictionary and its indexes.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion. With an error other than that of
+			the indexed dictionary the record may be missing from an
+			index.
+*/
+ion_status_t
+sidxdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Inserts a batch of records into the indexed dictionary, then
+			those inserted into each index as one batch.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		keys
+				@p count keys, stored back to back.
+@param		values
+				@p count values, stored back to back in the same order.
+@param		statuses
+				If not @c NULL, receives the status of each record's insert
+				into the indexed dictionary.
+@param		count
+				The number of records.
+@return		The number of records inserted, with the error of the first
+			insert that did not succeed, if any.
+*/
+ion_status_t
+sidxdict_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+);
+
+/**
+@brief		Reads a record from the indexed dictionary.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+sidxdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at a value held by the indexed dictionary.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the query.
+*/
+ion_status_t
+sidxdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Refuses to create a dictionary, see @ref sidxdict_wrap.
+
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The size of the dictionary.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+sidxdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes the records of a key from the indexed dictionary and
+			its indexes.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+sidxdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes the indexed dictionary and its indexes.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+sidxdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the records of a key in the indexed dictionary and
+			moves them in the indexes whose bytes change.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+sidxdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds records in the indexed dictionary.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+sidxdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Refuses to open a dictionary, see @ref sidxdict_wrap.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+sidxdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes the indexed dictionary and its indexes.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		The status of the closing.
+*/
+ion_err_t
+sidxdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SECONDARY_INDEX_DICTIONARY_HANDLER_H_ */
@@ -0,0 +1,873 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that spreads the keys of a dictionary over several
+			dictionaries, its shards, each run by its own worker of an
+			asynchronous pool.
+*/
+/******************************************************************************/
+
+#include "shard_dictionary_handler.h"
+
+/**
+@brief		Requests a caller waits on together, counted down as each
+			completes.
+*/
+typedef struct {
+	pthread_mutex_t lock;	/**< Guards the count */
+	pthread_cond_t	done;	/**< Signalled when it reaches 0 */
+	int				left;	/**< The requests not complete yet */
+} ion_shard_latch_t;
+
+/**
+@brief		The records a cursor has read from one shard.
+*/
+typedef struct {
+	ion_dict_cursor_t	*cursor;	/**< The cursor on the shard, or
+									 @c NULL if it could not be opened */
+	ion_predicate_t		*predicate;	/**< What it is opened with */
+	ion_byte_t			*keys;		/**< The keys of the batch read */
+	ion_byte_t			*values;	/**< Their values */
+	int					held;		/**< The records in the batch */
+	int					taken;		/**< How many are passed on */
+	ion_boolean_t		ended;		/**< Whether the shard has no more */
+} ion_shard_stream_t;
+
+/**
+@brief		A cursor over the shards that can hold the records sought.
+*/
+typedef struct {
+	ion_dict_cursor_t	super;
+	ion_predicate_t		predicate;				/**< The type of the find */
+	ion_boolean_t		merge;					/**< Whether the least next
+												 key of the shards is taken
+												 each time, else they are
+												 read in turn */
+	int					first;					/**< The first shard read */
+	int					end;					/**< The shard after the last */
+	int					current;				/**< The shard read in turn */
+	ion_shard_stream_t	streams[ION_SHARD_MAX]; /**< By shard */
+} ion_shard_cursor_t;
+
+/**
+@brief		Starts counting down requests.
+*/
+static void
+shardict_latch_init(
+	ion_shard_latch_t	*latch,
+	int					left
+) {
+	pthread_mutex_init(&latch->lock, NULL);
+	pthread_cond_init(&latch->done, NULL);
+	latch->left = left;
+}
+
+/**
+@brief		Counts down a request as it completes, the callback of every
+			request made on a shard.
+*/
+static void
+shardict_latch_down(
+	ion_async_request_t *request,
+	void				*context
+) {
+	ion_shard_latch_t *latch = context;
+
+	UNUSED(request);
+	pthread_mutex_lock(&latch->lock);
+
+	if (0 == --latch->left) {
+		pthread_cond_broadcast(&latch->done);
+	}
+
+	pthread_mutex_unlock(&latch->lock);
+}
+
+/**
+@brief		Waits until every request counted is complete.
+*/
+static void
+shardict_latch_wait(
+	ion_shard_latch_t *latch
+) {
+	pthread_mutex_lock(&latch->lock);
+
+	while (0 < latch->left) {
+		pthread_cond_wait(&latch->done, &latch->lock);
+	}
+
+	pthread_mutex_unlock(&latch->lock);
+	pthread_cond_destroy(&latch->done);
+	pthread_mutex_destroy(&latch->lock);
+}
+
+/**
+@brief		Fills in a request to make an operation on a shard.
+*/
+static void
+shardict_prepare(
+	ion_shard_dictionary_t	*shard,
+	ion_async_request_t		*request,
+	ion_async_op_t			op,
+	int						index,
+	ion_key_t				key,
+	ion_value_t				value,
+	ion_shard_latch_t		*latch
+) {
+	request->op			= op;
+	request->dictionary = &shard->shards[index];
+	request->key		= key;
+	request->value		= value;
+	request->handler	= NULL;
+	request->config		= NULL;
+	request->call		= NULL;
+	request->argument	= NULL;
+	request->status		= ION_STATUS_INITIALIZE;
+	request->callback	= shardict_latch_down;
+	request->context	= latch;
+}
+
+/**
+@brief		Submits a request to the worker of its shard, counting it down
+			at once should the pool take no more.
+*/
+static void
+shardict_submit(
+	ion_shard_dictionary_t	*shard,
+	int						index,
+	ion_async_request_t		*request
+) {
+	ion_err_t err = dictionary_async_submit_to(shard->pool, index, request);
+
+	if (err_ok != err) {
+		request->status = ION_STATUS_ERROR(err);
+		shardict_latch_down(request, request->context);
+	}
+}
+
+/**
+@brief		Makes an operation on the shard of a key and waits for it.
+*/
+static ion_status_t
+shardict_make(
+	ion_dictionary_t	*dictionary,
+	ion_async_op_t		op,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_shard_dictionary_t	*shard	= (ion_shard_dictionary_t *) dictionary->instance;
+	int						index	= shardict_shard_of(dictionary, key);
+	ion_async_request_t		request;
+	ion_shard_latch_t		latch;
+
+	shardict_latch_init(&latch, 1);
+	shardict_prepare(shard, &request, op, index, key, value, &latch);
+	shardict_submit(shard, index, &request);
+	shardict_latch_wait(&latch);
+
+	return request.status;
+}
+
+/**
+@brief		Makes an operation on each key of a batch, on the workers of
+			their shards side by side, and waits for them all.
+@details	Without the memory to track the requests, the keys are made
+			one at a time.
+*/
+static ion_status_t
+shardict_make_many(
+	ion_dictionary_t	*dictionary,
+	ion_async_op_t		op,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+) {
+	ion_shard_dictionary_t	*shard		= (ion_shard_dictionary_t *) dictionary->instance;
+	ion_key_size_t			key_size	= shard->super.record.key_size;
+	ion_value_size_t		value_size	= shard->super.record.value_size;
+	ion_status_t			status		= ION_STATUS_OK(0);
+	ion_async_request_t		*requests	= (0 < count) ? ion_alloc(ion_alloc_buffer, count * sizeof(ion_async_request_t)) : NULL;
+	ion_shard_latch_t		latch;
+	ion_status_t			one;
+	ion_key_t				key;
+	ion_value_t				value;
+	int						i;
+
+	if (NULL != requests) {
+		shardict_latch_init(&latch, count);
+	}
+
+	for (i = 0; i < count; i++) {
+		key		= (ion_byte_t *) keys + i * key_size;
+		value	= (NULL == values) ? NULL : (ion_byte_t *) values + i * value_size;
+
+		if (NULL == requests) {
+			one				= shardict_make(dictionary, op, key, value);
+			status.count	+= one.count;
+
+			if ((err_ok == status.error) && (err_ok != one.error)) {
+				status.error = one.error;
+			}
+
+			if (NULL != statuses) {
+				statuses[i] = one;
+			}
+
+			continue;
+		}
+
+		shardict_prepare(shard, &requests[i], op, shardict_shard_of(dictionary, key), key, value, &latch);
+		shardict_submit(shard, requests[i].dictionary - shard->shards, &requests[i]);
+	}
+
+	if (NULL == requests) {
+		return status;
+	}
+
+	shardict_latch_wait(&latch);
+
+	for (i = 0; i < count; i++) {
+		status.count += requests[i].status.count;
+
+		if ((err_ok == status.error) && (err_ok != requests[i].status.error)) {
+			status.error = requests[i].status.error;
+		}
+
+		if (NULL != statuses) {
+			statuses[i] = requests[i].status;
+		}
+	}
+
+	ion_free(requests);
+
+	return status;
+}
+
+/**
+@brief		Makes a call on the worker of each shard from @p first up to
+			@p end, side by side, and waits for them all.
+@param		arguments
+				An array by shard of what the calls work on, each
+				@p argument_size bytes, or @c NULL.
+@return		The first error of a call, if any.
+*/
+static ion_err_t
+shardict_call_each(
+	ion_shard_dictionary_t	*shard,
+	int						first,
+	int						end,
+	ion_async_call_t		call,
+	void					*arguments,
+	size_t					argument_size
+) {
+	ion_async_request_t requests[ION_SHARD_MAX];
+	ion_shard_latch_t	latch;
+	ion_err_t			err = err_ok;
+	int					i;
+
+	shardict_latch_init(&latch, end - first);
+
+	for (i = first; i < end; i++) {
+		shardict_prepare(shard, &requests[i], async_op_call, i, NULL, NULL, &latch);
+		requests[i].call		= call;
+		requests[i].argument	= (NULL == arguments) ? NULL : (ion_byte_t *) arguments + i * argument_size;
+		shardict_submit(shard, i, &requests[i]);
+	}
+
+	shardict_latch_wait(&latch);
+
+	for (i = first; i < end; i++) {
+		if ((err_ok == err) && (err_ok != requests[i].status.error)) {
+			err = requests[i].status.error;
+		}
+	}
+
+	return err;
+}
+
+/**
+@brief		Pushes the writes of a shard to storage, on its worker.
+*/
+static ion_status_t
+shardict_call_sync(
+	ion_async_request_t *request
+) {
+	return ION_STATUS_ERROR(dictionary_sync(request->dictionary));
+}
+
+/**
+@brief		Closes a shard, on its worker.
+*/
+static ion_status_t
+shardict_call_close(
+	ion_async_request_t *request
+) {
+	return ION_STATUS_ERROR(dictionary_close(request->dictionary));
+}
+
+/**
+@brief		Deletes a shard, on its worker.
+*/
+static ion_status_t
+shardict_call_delete(
+	ion_async_request_t *request
+) {
+	return ION_STATUS_ERROR(dictionary_delete_dictionary(request->dictionary));
+}
+
+/**
+@brief		Asks a shard of its size, on its worker.
+*/
+static ion_status_t
+shardict_call_info(
+	ion_async_request_t *request
+) {
+	return ION_STATUS_ERROR(dictionary_get_info(request->dictionary, request->argument));
+}
+
+/**
+@brief		Reads the next batch of records of a shard into its stream.
+*/
+static ion_status_t
+shardict_fill(
+	ion_shard_stream_t *stream
+) {
+	stream->held	= dictionary_next_batch(stream->cursor, stream->keys, stream->values, ION_SHARD_CURSOR_BATCH);
+	stream->taken	= 0;
+
+	/* fewer than asked for, the shard has no more to read */
+	if (ION_SHARD_CURSOR_BATCH > stream->held) {
+		stream->ended = boolean_true;
+	}
+
+	return ION_STATUS_OK(stream->held);
+}
+
+/**
+@brief		Opens a cursor on a shard and reads its first batch, on its
+			worker.
+*/
+static ion_status_t
+shardict_call_find(
+	ion_async_request_t *request
+) {
+	ion_shard_stream_t	*stream = request->argument;
+	ion_err_t			err		= dictionary_find(request->dictionary, stream->predicate, &stream->cursor);
+
+	if (err_ok != err) {
+		stream->cursor	= NULL;
+		stream->ended	= boolean_true;
+		return ION_STATUS_ERROR(err);
+	}
+
+	return shardict_fill(stream);
+}
+
+/**
+@brief		Reads the next batch of a shard, on its worker.
+*/
+static ion_status_t
+shardict_call_fill(
+	ion_async_request_t *request
+) {
+	return shardict_fill(request->argument);
+}
+
+/**
+@brief		Destroys the cursor on a shard, on its worker.
+*/
+static ion_status_t
+shardict_call_destroy(
+	ion_async_request_t *request
+) {
+	ion_shard_stream_t *stream = request->argument;
+
+	if (NULL != stream->cursor) {
+		stream->cursor->destroy(&stream->cursor);
+	}
+
+	return ION_STATUS_OK(0);
+}
+
+/**
+@brief		Whether a shard of a cursor has a record to pass on, reading
+			its next batch if it has passed on all it read.
+*/
+static ion_boolean_t
+shardict_ready(
+	ion_shard_cursor_t	*cursor,
+	int					index
+) {
+	ion_shard_stream_t *stream = &cursor->streams[index];
+
+	if ((stream->taken == stream->held) && !stream->ended) {
+		if (err_ok != shardict_call_each((ion_shard_dictionary_t *) cursor->super.dictionary->instance, index, index + 1, shardict_call_fill, cursor->streams, sizeof(ion_shard_stream_t))) {
+			stream->ended = boolean_true;
+		}
+	}
+
+	return stream->taken < stream->held;
+}
+
+/**
+@brief		Passes on the next record of a cursor over shards: the least
+			of their next keys when merging, else the next of the shard
+			read in turn.
+*/
+static ion_cursor_status_t
+shardict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_shard_cursor_t	*shard_cursor	= (ion_shard_cursor_t *) cursor;
+	ion_dictionary_parent_t *parent		= cursor->dictionary->instance;
+	ion_key_size_t		key_size		= parent->record.key_size;
+	ion_value_size_t	value_size		= parent->record.value_size;
+	ion_shard_stream_t	*stream;
+	int					best			= -1;
+	int					i;
+
+	if ((cs_cursor_initialized != cursor->status) && (cs_cursor_active != cursor->status)) {
+		return cursor->status;
+	}
+
+	if (shard_cursor->merge) {
+		for (i = shard_cursor->first; i < shard_cursor->end; i++) {
+			if (!shardict_ready(shard_cursor, i)) {
+				continue;
+			}
+
+			stream = &shard_cursor->streams[i];
+
+			if ((-1 == best) || (0 > parent->compare(stream->keys + stream->taken * key_size, shard_cursor->streams[best].keys + shard_cursor->streams[best].taken * key_size, key_size))) {
+				best = i;
+			}
+		}
+	}
+	else {
+		while ((shard_cursor->current < shard_cursor->end) && !shardict_ready(shard_cursor, shard_cursor->current)) {
+			shard_cursor->current++;
+		}
+
+		if (shard_cursor->current < shard_cursor->end) {
+			best = shard_cursor->current;
+		}
+	}
+
+	if (-1 == best) {
+		cursor->status = cs_end_of_results;
+		return cursor->status;
+	}
+
+	stream = &shard_cursor->streams[best];
+	memcpy(record->key, stream->keys + stream->taken * key_size, key_size);
+	memcpy((ion_byte_t *) record->value + cursor->value_offset, stream->values + stream->taken * value_size + cursor->value_offset, cursor->value_size);
+	stream->taken++;
+
+	cursor->status = cs_cursor_active;
+	return cursor->status;
+}
+
+/**
+@brief		Destroys a cursor over shards, and the cursor on each shard.
+*/
+static void
+shardict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_shard_cursor_t *shard_cursor = (ion_shard_cursor_t *) *cursor;
+
+	shardict_call_each((ion_shard_dictionary_t *) (*cursor)->dictionary->instance, shard_cursor->first, shard_cursor->end, shardict_call_destroy, shard_cursor->streams, sizeof(ion_shard_stream_t));
+	ion_free(shard_cursor);
+	*cursor = NULL;
+}
+
+int
+shardict_shard_of(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_shard_dictionary_t	*shard		= (ion_shard_dictionary_t *) dictionary->instance;
+	ion_key_size_t			key_size	= shard->super.record.key_size;
+	int						low			= 0;
+	int						high		= shard->count - 1;
+	int						middle;
+
+	if (NULL == shard->splits) {
+		return (int) (dictionary_hash_key(shard->super.key_type, key, key_size, ION_SHARD_HASH_SEED) % (uint32_t) shard->count);
+	}
+
+	/* the shard of a key is the number of splits at or below it */
+	while (low < high) {
+		middle = (low + high) / 2;
+
+		if (0 >= shard->super.compare(shard->splits + middle * key_size, key, key_size)) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+ion_dictionary_t *
+shardict_get_shard(
+	ion_dictionary_t	*dictionary,
+	int					shard
+) {
+	ion_shard_dictionary_t *sharded = (ion_shard_dictionary_t *) dictionary->instance;
+
+	if ((0 > shard) || (shard >= sharded->count)) {
+		return NULL;
+	}
+
+	return &sharded->shards[shard];
+}
+
+ion_err_t
+shardict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*shards,
+	int							count,
+	ion_key_t					splits,
+	ion_async_pool_t			*pool
+) {
+	ion_shard_dictionary_t	*shard;
+	ion_dictionary_parent_t *first;
+	int						i;
+
+	if ((1 > count) || (ION_SHARD_MAX < count)) {
+		return err_invalid_initial_size;
+	}
+
+	first = shards[0].instance;
+
+	for (i = 0; i < count; i++) {
+		if ((NULL == shards[i].instance) || (first->key_type != shards[i].instance->key_type) || (first->record.key_size != shards[i].instance->record.key_size) || (first->record.value_size != shards[i].instance->record.value_size)) {
+			return err_illegal_state;
+		}
+	}
+
+	if (NULL == pool) {
+		return err_illegal_state;
+	}
+
+	shard = ion_alloc(ion_alloc_other, sizeof(ion_shard_dictionary_t) + ((NULL == splits) ? 0 : (count - 1) * first->record.key_size));
+
+	if (NULL == shard) {
+		return err_out_of_memory;
+	}
+
+	shard->super	= *first;
+	shard->pool		= pool;
+	shard->count	= count;
+	shard->splits	= NULL;
+
+	if (NULL != splits) {
+		shard->splits = (ion_byte_t *) (shard + 1);
+		memcpy(shard->splits, splits, (count - 1) * first->record.key_size);
+	}
+
+	memcpy(shard->shards, shards, count * sizeof(ion_dictionary_t));
+
+	/* the shards push their writes and count their memory themselves, on
+	   their workers, and are each open to the other dictionary calls */
+	dictionary->status					= ion_dictionary_status_ok;
+	dictionary->instance				= (ion_dictionary_parent_t *) shard;
+	dictionary->handler					= handler;
+	dictionary->durability.level		= durability_none;
+	dictionary->durability.group_ops	= 0;
+	dictionary->durability.group_ms		= 0;
+	dictionary->durability.pending		= 0;
+	dictionary->durability.since		= 0;
+	dictionary->alloc_account			= ion_alloc_unattributed;
+#if ION_DICTIONARY_STATS
+	dictionary->stats					= NULL;
+#endif
+
+	return err_ok;
+}
+
+ion_status_t
+shardict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return shardict_make(dictionary, async_op_insert, key, value);
+}
+
+ion_status_t
+shardict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return shardict_make(dictionary, async_op_get, key, value);
+}
+
+ion_err_t
+shardict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+	UNUSED(key_type);
+	UNUSED(key_size);
+	UNUSED(value_size);
+	UNUSED(dictionary_size);
+	UNUSED(compare);
+	UNUSED(handler);
+	UNUSED(dictionary);
+	return err_dictionary_initialization_failed;
+}
+
+ion_status_t
+shardict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return shardict_make(dictionary, async_op_delete, key, NULL);
+}
+
+ion_err_t
+shardict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_shard_dictionary_t	*shard	= (ion_shard_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= shardict_call_each(shard, 0, shard->count, shardict_call_delete, NULL, 0);
+
+	ion_free(shard);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+shardict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return shardict_make(dictionary, async_op_update, key, value);
+}
+
+/**
+@brief		Reads the values of a batch of keys, from their shards side by
+			side.
+*/
+static ion_status_t
+shardict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+) {
+	return shardict_make_many(dictionary, async_op_get, keys, values, statuses, count);
+}
+
+/**
+@brief		Inserts a batch of records into their shards side by side.
+*/
+static ion_status_t
+shardict_insert_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					count
+) {
+	return shardict_make_many(dictionary, async_op_insert, keys, values, statuses, count);
+}
+
+/**
+@brief		Deletes a batch of keys from their shards side by side.
+*/
+static ion_status_t
+shardict_delete_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_status_t		*statuses,
+	int					count
+) {
+	return shardict_make_many(dictionary, async_op_delete, keys, NULL, statuses, count);
+}
+
+ion_err_t
+shardict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_shard_dictionary_t	*shard			= (ion_shard_dictionary_t *) dictionary->instance;
+	ion_key_size_t			key_size		= shard->super.record.key_size;
+	size_t					batch_size		= ION_SHARD_CURSOR_BATCH * ((size_t) key_size + shard->super.record.value_size);
+	ion_shard_cursor_t		*shard_cursor;
+	ion_byte_t				*batches;
+	ion_err_t				err;
+	int						first			= 0;
+	int						end				= shard->count;
+	int						i;
+
+	if (predicate_equality == predicate->type) {
+		first	= shardict_shard_of(dictionary, predicate->statement.equality.equality_value);
+		end		= first + 1;
+	}
+	else if ((predicate_range == predicate->type) && (NULL != shard->splits)) {
+		first	= shardict_shard_of(dictionary, predicate->statement.range.lower_bound);
+		end		= shardict_shard_of(dictionary, predicate->statement.range.upper_bound) + 1;
+
+		if (end < first + 1) {
+			end = first + 1;
+		}
+	}
+
+	shard_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_shard_cursor_t) + (end - first) * batch_size);
+
+	if (NULL == shard_cursor) {
+		return err_out_of_memory;
+	}
+
+	memset(shard_cursor, 0, sizeof(ion_shard_cursor_t));
+	shard_cursor->super.status		= cs_cursor_initialized;
+	shard_cursor->super.dictionary	= dictionary;
+	shard_cursor->super.predicate	= &shard_cursor->predicate;
+	shard_cursor->super.next		= shardict_next;
+	shard_cursor->super.next_batch	= NULL;
+	shard_cursor->super.destroy		= shardict_destroy_cursor;
+	/* only the type is kept, the shards' cursors hold the bounds */
+	shard_cursor->predicate.type	= predicate->type;
+	shard_cursor->predicate.destroy = NULL;
+	shard_cursor->merge				= (NULL == shard->splits) && (predicate_equality != predicate->type);
+	shard_cursor->first				= first;
+	shard_cursor->end				= end;
+	shard_cursor->current			= first;
+	batches							= (ion_byte_t *) (shard_cursor + 1);
+
+	for (i = first; i < end; i++) {
+		shard_cursor->streams[i].predicate	= predicate;
+		shard_cursor->streams[i].keys		= batches + (i - first) * batch_size;
+		shard_cursor->streams[i].values		= shard_cursor->streams[i].keys + ION_SHARD_CURSOR_BATCH * key_size;
+	}
+
+	err = shardict_call_each(shard, first, end, shardict_call_find, shard_cursor->streams, sizeof(ion_shard_stream_t));
+
+	if (err_ok != err) {
+		shardict_destroy_cursor((ion_dict_cursor_t **) &shard_cursor);
+		return err;
+	}
+
+	*cursor = &shard_cursor->super;
+
+	return err_ok;
+}
+
+ion_err_t
+shardict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_dictionary_initialization_failed;
+}
+
+ion_err_t
+shardict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_shard_dictionary_t	*shard	= (ion_shard_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= shardict_call_each(shard, 0, shard->count, shardict_call_close, NULL, 0);
+
+	if (err_ok == err) {
+		ion_free(shard);
+		dictionary->instance = NULL;
+	}
+
+	return err;
+}
+
+/**
+@brief		Pushes the writes of every shard to storage, side by side.
+*/
+static ion_err_t
+shardict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_shard_dictionary_t *shard = (ion_shard_dictionary_t *) dictionary->instance;
+
+	return shardict_call_each(shard, 0, shard->count, shardict_call_sync, NULL, 0);
+}
+
+/**
+@brief		Sums what the shards can tell of their size. Bounds are not
+			given.
+*/
+static ion_err_t
+shardict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_shard_dictionary_t	*shard = (ion_shard_dictionary_t *) dictionary->instance;
+	ion_dictionary_info_t	infos[ION_SHARD_MAX];
+	ion_err_t				err;
+	int						i;
+
+	for (i = 0; i < shard->count; i++) {
+		infos[i].min_key	= NULL;
+		infos[i].max_key	= NULL;
+	}
+
+	err					= shardict_call_each(shard, 0, shard->count, shardict_call_info, infos, sizeof(ion_dictionary_info_t));
+	info->record_count	= 0;
+	info->file_bytes	= 0;
+	info->pages			= 0;
+	info->memory_bytes	= 0;
+	info->has_bounds	= boolean_false;
+
+	for (i = 0; i < shard->count; i++) {
+		info->record_count	= ((-1 == info->record_count) || (-1 == infos[i].record_count)) ? -1 : info->record_count + infos[i].record_count;
+		info->file_bytes	= ((-1 == info->file_bytes) || (-1 == infos[i].file_bytes)) ? -1 : info->file_bytes + infos[i].file_bytes;
+		info->pages			= ((-1 == info->pages) || (-1 == infos[i].pages)) ? -1 : info->pages + infos[i].pages;
+		info->memory_bytes	= ((-1 == info->memory_bytes) || (-1 == infos[i].memory_bytes)) ? -1 : info->memory_bytes + infos[i].memory_bytes;
+	}
+
+	return err;
+}
+
+void
+shardict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= shardict_insert;
+	handler->create_dictionary	= shardict_create_dictionary;
+	handler->get				= shardict_query;
+	handler->update				= shardict_update;
+	handler->find				= shardict_find;
+	handler->remove				= shardict_delete;
+	handler->delete_dictionary	= shardict_delete_dictionary;
+	handler->close_dictionary	= shardict_close_dictionary;
+	handler->open_dictionary	= shardict_open_dictionary;
+	handler->get_many			= shardict_get_many;
+	handler->insert_many		= shardict_insert_many;
+	handler->delete_many		= shardict_delete_many;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= shardict_sync_dictionary;
+	handler->get_info			= shardict_get_info;
+	handler->bulk_load			= NULL;
+}
@@ -0,0 +1,320 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that spreads the keys of a dictionary over several
+			dictionaries, its shards, each run by its own worker of an
+			asynchronous pool.
+@details	A dictionary is made of shards once they are created or
+			opened, with any handlers, see @ref shardict_wrap. Keys are
+			given to shards by their hash, or by ranges between split
+			keys. Every operation on a shard is made by the worker of
+			its shard, so no engine is used by two threads at once, while
+			operations on different shards run side by side. The sharded
+			dictionary itself may then be used from several threads at
+			once for gets, inserts, updates and deletes; batches are
+			spread over the workers, and cursors read every shard a batch
+			at a time, merging them by key. Cursors, syncs and closes must
+			not overlap with other operations from other threads.
+
+			Equality cursors read the one shard of their key. Range
+			cursors read only the shards of their range when sharded by
+			range, in order, so engines that keep their keys in order
+			return them in order. Shards by hash are merged, taking the
+			least of their next keys each time.
+
+			Only available on hosts with POSIX threads.
+*/
+/******************************************************************************/
+
+#if !defined(SHARD_DICTIONARY_HANDLER_H_)
+#define SHARD_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../async/dictionary_async.h"
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		The most shards a dictionary is spread over.
+*/
+#if !defined(ION_SHARD_MAX)
+#define ION_SHARD_MAX ION_ASYNC_MAX_WORKERS
+#endif
+
+/**
+@brief		How many records a cursor reads from each shard at a time.
+*/
+#if !defined(ION_SHARD_CURSOR_BATCH)
+#define ION_SHARD_CURSOR_BATCH 64
+#endif
+
+/**
+@brief		Seeds the hash keys are given to shards by, apart from those
+			of engines hashing the same keys within a shard.
+*/
+#if !defined(ION_SHARD_HASH_SEED)
+#define ION_SHARD_HASH_SEED 0x5EED5AD1UL
+#endif
+
+/**
+@brief		A dictionary spread over shards.
+*/
+typedef struct shard_dictionary {
+	ion_dictionary_parent_t super;
+	ion_async_pool_t		*pool;					/**< Runs shard @c i on its
+													 worker @c i, modulo the
+													 number of workers */
+	int						count;					/**< The number of shards */
+	ion_byte_t				*splits;				/**< The least key of each
+													 shard after the first, in
+													 order, or @c NULL for
+													 shards by hash */
+	ion_dictionary_t		shards[ION_SHARD_MAX];	/**< The shards */
+} ion_shard_dictionary_t;
+
+/**
+@brief		Registers the shard handler.
+
+@details	The handler cannot create dictionaries of its own, it only
+			serves those given to @ref shardict_wrap.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+shardict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Makes a dictionary of shards.
+
+@details	The shards are moved into the sharded dictionary, and are
+			only used through it from then on; their handlers must stay
+			put while it is open. Deleting or closing it deletes or
+			closes every shard. The memory of each shard is counted to
+			it, see @ref shardict_get_shard.
+
+@param		dictionary
+				Receives the sharded dictionary.
+@param		handler
+				A handler registered with @ref shardict_init, to bind to
+				@p dictionary.
+@param		shards
+				@p count dictionaries with the same key type and record
+				sizes, created or opened with any handlers, holding only
+				keys of their shard.
+@param		count
+				How many there are, from 1 up to @ref ION_SHARD_MAX.
+@param		splits
+				For shards by range, @p count less one keys in order, the
+				least key of each shard after the first; or @c NULL for
+				shards by hash.
+@param		pool
+				The started pool running the shards, shard @c i on
+				worker @c i modulo its workers, which must not be given
+				the shards otherwise.
+@return		The status of the wrap. The shards are left as they were
+			unless it is @c err_ok.
+*/
+ion_err_t
+shardict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*shards,
+	int							count,
+	ion_key_t					splits,
+	ion_async_pool_t			*pool
+);
+
+/**
+@brief		The shard a key is given to.
+
+@param		dictionary
+				A dictionary made with @ref shardict_wrap.
+@param		key
+				The key.
+@return		The index of its shard.
+*/
+int
+shardict_shard_of(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		A shard of a dictionary, to read its memory or counters.
+
+@details	It must not be operated on directly while the sharded
+			dictionary is open.
+
+@param		dictionary
+				A dictionary made with @ref shardict_wrap.
+@param		shard
+				The index of the shard.
+@return		The shard, or @c NULL if there is none by that index.
+*/
+ion_dictionary_t *
+shardict_get_shard(
+	ion_dictionary_t	*dictionary,
+	int					shard
+);
+
+/**
+@brief		Inserts a record into its shard, on the shard's worker.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+shardict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Reads the value of a key from its shard, on the shard's
+			worker.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value, allocated by the caller.
+@return		The status of the query.
+*/
+ion_status_t
+shardict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Creating is not supported, see @ref shardict_wrap.
+
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+shardict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes a key from its shard, on the shard's worker.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+shardict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes every shard, side by side, and frees the sharded
+			dictionary.
+
+@param		dictionary
+				The dictionary to delete.
+@return		The first error of a shard, if any.
+*/
+ion_err_t
+shardict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates a key in its shard, on the shard's worker.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+shardict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate in every shard
+			that can hold them, merging cursors over each.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to match.
+@param		cursor
+				Receives the cursor.
+@return		The status of the find.
+*/
+ion_err_t
+shardict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Opening is not supported, the shards are opened with their
+			own handlers and wrapped again.
+
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+shardict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes every shard, side by side, and frees the sharded
+			dictionary.
+
+@param		dictionary
+				The dictionary to close.
+@return		The first error of a shard, if any; the dictionary stays
+			open if there is one, and closing it again closes the
+			shards left.
+*/
+ion_err_t
+shardict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SHARD_DICTIONARY_HANDLER_H_ */
@@ -0,0 +1,678 @@
+/******************************************************************************/
+/**
+@file
+@brief		Implementation of a skiplist that several threads may use at
+			once without locks.
+@details	A node is only unlinked once it is marked, and only retired
+			once it can no longer be linked anywhere: its inserter may
+			still be building its tower when it is deleted, so the
+			inserter and the deleter each give up their ownership when
+			done, and the last of them makes sure the node is unlinked
+			from every level before retiring it.
+*/
+/******************************************************************************/
+
+#include <sched.h>
+
+#include "concurrent_skip_list.h"
+
+/**
+@brief		Whether a link is marked, which means the node holding it is
+			deleted.
+*/
+#define CSL_MARKED(link)	(0 != ((link) & 1))
+
+/**
+@brief		The node a link points to, without its mark.
+*/
+#define CSL_NODE(link)		((ion_csl_node_t *) ((link) & ~(ion_csl_link_t) 1))
+
+/**
+@brief		The slot this thread last found free, where it looks first.
+*/
+static __thread int csl_slot_hint;
+
+/**
+@brief		Returns the bytes of a value block.
+*/
+static ion_byte_t *
+csl_value_bytes(
+	ion_csl_retired_t *value
+) {
+	return (ion_byte_t *) (value + 1);
+}
+
+/**
+@brief		Allocates a value block holding a copy of a value.
+@return		The block, or @c NULL if out of memory.
+*/
+static ion_csl_retired_t *
+csl_new_value(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_value_t					value
+) {
+	ion_csl_retired_t *block = ion_alloc(ion_alloc_node, sizeof(ion_csl_retired_t) + skiplist->super.record.value_size);
+
+	if (NULL != block) {
+		block->is_node = boolean_false;
+		memcpy(csl_value_bytes(block), value, skiplist->super.record.value_size);
+	}
+
+	return block;
+}
+
+/**
+@brief		Frees a node, with its value, or a value.
+*/
+static void
+csl_free_retired(
+	ion_csl_retired_t *retired
+) {
+	if (retired->is_node) {
+		ion_free(((ion_csl_node_t *) retired)->value);
+	}
+
+	ion_free(retired);
+}
+
+/**
+@brief		Compares the key of a node to a key.
+*/
+static int
+csl_compare(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_csl_node_t				*node,
+	ion_key_t					key
+) {
+	return skiplist->super.compare(node->key, key, skiplist->super.record.key_size);
+}
+
+/**
+@brief		Claims a free slot and announces the current epoch in it, so
+			nothing retired from now on is freed under the caller.
+@return		The slot, which must be given back with @ref csl_exit.
+*/
+static int
+csl_enter(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	int			slot = csl_slot_hint;
+	int			tried;
+	uint64_t	epoch;
+	uint64_t	seen;
+	uint64_t	expected;
+
+	for (tried = 0;; tried++, slot = (slot + 1) % ION_CSL_SLOTS) {
+		if ((0 != tried) && (0 == tried % ION_CSL_SLOTS)) {
+			/* every slot is held, so give their holders a chance to finish */
+			sched_yield();
+		}
+
+		epoch		= __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+		expected	= 0;
+
+		if (__atomic_compare_exchange_n(&skiplist->slots[slot].state.announce, &expected, (epoch << 1) | 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	/* an epoch that moved on before it was announced must be announced again */
+	while ((seen = __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST)) != epoch) {
+		epoch = seen;
+		__atomic_store_n(&skiplist->slots[slot].state.announce, (epoch << 1) | 1, __ATOMIC_SEQ_CST);
+	}
+
+	csl_slot_hint = slot;
+
+	return slot;
+}
+
+/**
+@brief		Gives back a slot claimed by @ref csl_enter.
+*/
+static void
+csl_exit(
+	ion_concurrent_skiplist_t	*skiplist,
+	int							slot
+) {
+	__atomic_store_n(&skiplist->slots[slot].state.announce, 0, __ATOMIC_RELEASE);
+}
+
+/**
+@brief		Moves the epoch on if every running operation has seen it, then
+			frees the retired items no operation can still be reading.
+*/
+static void
+csl_reclaim(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	ion_csl_retired_t	*chain;
+	ion_csl_retired_t	*next;
+	ion_csl_retired_t	*keep		= NULL;
+	ion_csl_retired_t	*keep_tail	= NULL;
+	uint64_t			epoch		= __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+	uint64_t			announce;
+	int					i;
+
+	for (i = 0; i < ION_CSL_SLOTS; i++) {
+		announce = __atomic_load_n(&skiplist->slots[i].state.announce, __ATOMIC_SEQ_CST);
+
+		if ((0 != (announce & 1)) && ((announce >> 1) != epoch)) {
+			break;
+		}
+	}
+
+	if (ION_CSL_SLOTS == i) {
+		__atomic_compare_exchange_n(&skiplist->epoch, &epoch, epoch + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	}
+
+	epoch	= __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+	chain	= __atomic_exchange_n(&skiplist->retired, NULL, __ATOMIC_ACQUIRE);
+
+	for (; NULL != chain; chain = next) {
+		next = chain->next;
+
+		/* every operation that ran while it was linked has finished */
+		if (chain->epoch + 2 <= epoch) {
+			csl_free_retired(chain);
+		}
+		else {
+			chain->next = keep;
+			keep		= chain;
+
+			if (NULL == keep_tail) {
+				keep_tail = chain;
+			}
+		}
+	}
+
+	if (NULL != keep) {
+		keep_tail->next = __atomic_load_n(&skiplist->retired, __ATOMIC_RELAXED);
+
+		while (!__atomic_compare_exchange_n(&skiplist->retired, &keep_tail->next, keep, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+	}
+}
+
+/**
+@brief		Puts a node or value that can no longer be reached on the
+			retired list, to be freed once no operation can be reading it.
+*/
+static void
+csl_retire(
+	ion_concurrent_skiplist_t	*skiplist,
+	int							slot,
+	ion_csl_retired_t			*retired
+) {
+	retired->epoch	= __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+	retired->next	= __atomic_load_n(&skiplist->retired, __ATOMIC_RELAXED);
+
+	while (!__atomic_compare_exchange_n(&skiplist->retired, &retired->next, retired, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+
+	if (++skiplist->slots[slot].state.retired >= ION_CSL_RECLAIM_INTERVAL) {
+		skiplist->slots[slot].state.retired = 0;
+		csl_reclaim(skiplist);
+	}
+}
+
+/**
+@brief		Draws the height index of a new tower from a slot's generator.
+*/
+static ion_sl_level_t
+csl_gen_level(
+	ion_concurrent_skiplist_t	*skiplist,
+	int							slot
+) {
+	uint32_t		*rng	= &skiplist->slots[slot].state.rng;
+	ion_sl_level_t	level	= 0;
+
+	while (level < skiplist->maxheight - 1) {
+		*rng	^= *rng << 13;
+		*rng	^= *rng >> 17;
+		*rng	^= *rng << 5;
+
+		if (*rng >= skiplist->threshold) {
+			break;
+		}
+
+		level++;
+	}
+
+	return level;
+}
+
+/**
+@brief		Finds, on every level, the last node before a key and the
+			first one from it on, unlinking the marked nodes passed.
+
+@param		past_equal
+				Whether to also pass the nodes holding @p key, so that a
+				marked node holding it is unlinked wherever it is.
+@param		preds
+				Receives the last node before the key on each level, or
+				@c NULL if not wanted.
+@param		succs
+				Receives the node after those of @p preds.
+@return		Whether an unmarked node holding @p key was found, if
+			@p past_equal is not set.
+*/
+static ion_boolean_t
+csl_search(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_boolean_t				past_equal,
+	ion_csl_node_t				**preds,
+	ion_csl_node_t				**succs
+) {
+	ion_csl_node_t	*pred;
+	ion_csl_node_t	*curr;
+	ion_csl_link_t	link;
+	ion_csl_link_t	expected;
+	ion_sl_level_t	level;
+	int				compared;
+
+retry:
+	pred = skiplist->head;
+
+	for (level = skiplist->maxheight - 1; level >= 0; level--) {
+		curr = CSL_NODE(__atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE));
+
+		while (NULL != curr) {
+			link = __atomic_load_n(&curr->next[level], __ATOMIC_ACQUIRE);
+
+			if (CSL_MARKED(link)) {
+				expected = (ion_csl_link_t) curr;
+
+				/* fails if pred was marked or has moved on, which needs a new path */
+				if (!__atomic_compare_exchange_n(&pred->next[level], &expected, link & ~(ion_csl_link_t) 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+					goto retry;
+				}
+
+				curr = CSL_NODE(link);
+				continue;
+			}
+
+			compared = csl_compare(skiplist, curr, key);
+
+			if ((compared < 0) || (past_equal && (0 == compared))) {
+				pred	= curr;
+				curr	= CSL_NODE(link);
+			}
+			else {
+				break;
+			}
+		}
+
+		if (NULL != preds) {
+			preds[level]	= pred;
+			succs[level]	= curr;
+		}
+	}
+
+	return !past_equal && (NULL != curr) && (0 == csl_compare(skiplist, curr, key));
+}
+
+/**
+@brief		Finds the first unmarked node from a key on, without writing.
+@param		key
+				The key to start from, or @c NULL for the first node.
+@param		inclusive
+				Whether a node holding @p key may be returned.
+@return		The node, or @c NULL if there is none.
+*/
+static ion_csl_node_t *
+csl_seek(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_boolean_t				inclusive
+) {
+	ion_csl_node_t	*pred = skiplist->head;
+	ion_csl_node_t	*curr = NULL;
+	ion_csl_link_t	link;
+	ion_sl_level_t	level;
+	int				compared;
+
+	for (level = skiplist->maxheight - 1; level >= 0; level--) {
+		curr = CSL_NODE(__atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE));
+
+		while (NULL != curr) {
+			link = __atomic_load_n(&curr->next[level], __ATOMIC_ACQUIRE);
+
+			/* step over deleted nodes instead of unlinking them */
+			if (CSL_MARKED(link)) {
+				curr = CSL_NODE(link);
+				continue;
+			}
+
+			if (NULL == key) {
+				break;
+			}
+
+			compared = csl_compare(skiplist, curr, key);
+
+			if ((compared < 0) || (!inclusive && (0 == compared))) {
+				pred	= curr;
+				curr	= CSL_NODE(link);
+			}
+			else {
+				break;
+			}
+		}
+	}
+
+	return curr;
+}
+
+/**
+@brief		Gives up one ownership of a node, retiring it if it was the
+			last.
+@details	Its owner has stopped linking it, so once it is marked and
+			both owners are done, a search past it leaves it unlinked on
+			every level.
+*/
+static void
+csl_release_node(
+	ion_concurrent_skiplist_t	*skiplist,
+	int							slot,
+	ion_csl_node_t				*node
+) {
+	if (CSL_MARKED(__atomic_load_n(&node->next[0], __ATOMIC_ACQUIRE))) {
+		csl_search(skiplist, node->key, boolean_true, NULL, NULL);
+	}
+
+	if (0 == __atomic_sub_fetch(&node->owners, 1, __ATOMIC_ACQ_REL)) {
+		csl_retire(skiplist, slot, &node->retired);
+	}
+}
+
+ion_err_t
+csl_initialize(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	int							maxheight,
+	int							pnum,
+	int							pden
+) {
+	int i;
+
+	if ((maxheight < 1) || (maxheight > ION_CSL_MAX_HEIGHT)) {
+		return err_invalid_initial_size;
+	}
+
+	skiplist->super.key_type			= key_type;
+	skiplist->super.record.key_size		= key_size;
+	skiplist->super.record.value_size	= value_size;
+	skiplist->maxheight					= maxheight;
+	skiplist->threshold					= (uint32_t) pnum * (UINT32_MAX / (uint32_t) pden);
+	skiplist->epoch						= 0;
+	skiplist->retired					= NULL;
+	skiplist->head						= ion_alloc(ion_alloc_node, sizeof(ion_csl_node_t) + sizeof(ion_csl_link_t) * maxheight);
+
+	if (NULL == skiplist->head) {
+		return err_out_of_memory;
+	}
+
+	skiplist->slots = ion_alloc(ion_alloc_other, sizeof(ion_csl_slot_t) * ION_CSL_SLOTS);
+
+	if (NULL == skiplist->slots) {
+		ion_free(skiplist->head);
+		return err_out_of_memory;
+	}
+
+	skiplist->head->key		= NULL;
+	skiplist->head->value	= NULL;
+	skiplist->head->height	= maxheight - 1;
+	skiplist->head->next	= (ion_csl_link_t *) (skiplist->head + 1);
+
+	for (i = 0; i < maxheight; i++) {
+		skiplist->head->next[i] = 0;
+	}
+
+	for (i = 0; i < ION_CSL_SLOTS; i++) {
+		skiplist->slots[i].state.announce	= 0;
+		skiplist->slots[i].state.retired	= 0;
+		/* never 0, and apart for every slot */
+		skiplist->slots[i].state.rng		= ION_SL_DEFAULT_SEED ^ ((uint32_t) (i + 1) * 0x85EBCA6BUL);
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+csl_destroy(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	ion_csl_node_t		*node = CSL_NODE(skiplist->head->next[0]);
+	ion_csl_node_t		*next;
+	ion_csl_retired_t	*retired;
+
+	while (NULL != node) {
+		next = CSL_NODE(node->next[0]);
+		csl_free_retired(&node->retired);
+		node = next;
+	}
+
+	while (NULL != (retired = skiplist->retired)) {
+		skiplist->retired = retired->next;
+		csl_free_retired(retired);
+	}
+
+	ion_free(skiplist->head);
+	ion_free(skiplist->slots);
+	skiplist->head	= NULL;
+	skiplist->slots = NULL;
+
+	return err_ok;
+}
+
+ion_status_t
+csl_insert(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	ion_key_size_t	key_size = skiplist->super.record.key_size;
+	ion_csl_node_t	*preds[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*succs[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*node;
+	ion_csl_link_t	link;
+	ion_csl_link_t	expected;
+	ion_sl_level_t	height;
+	ion_sl_level_t	level;
+	int				slot = csl_enter(skiplist);
+
+	height	= csl_gen_level(skiplist, slot);
+	node	= ion_alloc(ion_alloc_node, sizeof(ion_csl_node_t) + sizeof(ion_csl_link_t) * (height + 1) + key_size);
+
+	if ((NULL == node) || (NULL == (node->value = csl_new_value(skiplist, value)))) {
+		ion_free(node);
+		csl_exit(skiplist, slot);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	node->retired.is_node	= boolean_true;
+	node->height			= height;
+	node->owners			= 2;
+	node->next				= (ion_csl_link_t *) (node + 1);
+	node->key				= (ion_key_t) (node->next + height + 1);
+	memcpy(node->key, key, key_size);
+
+	/* the record exists once it is linked on the bottom level */
+	while (1) {
+		if (csl_search(skiplist, key, boolean_false, preds, succs)) {
+			csl_free_retired(&node->retired);
+			csl_exit(skiplist, slot);
+			return ION_STATUS_ERROR(err_duplicate_key);
+		}
+
+		for (level = 0; level <= height; level++) {
+			node->next[level] = (ion_csl_link_t) succs[level];
+		}
+
+		expected = (ion_csl_link_t) succs[0];
+
+		if (__atomic_compare_exchange_n(&preds[0]->next[0], &expected, (ion_csl_link_t) node, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	/* the rest of the tower only speeds up searches, and stops once the node is deleted */
+	for (level = 1; level <= height; level++) {
+		while (1) {
+			link = __atomic_load_n(&node->next[level], __ATOMIC_ACQUIRE);
+
+			if (CSL_MARKED(link)) {
+				goto done;
+			}
+
+			if ((CSL_NODE(link) != succs[level]) && !__atomic_compare_exchange_n(&node->next[level], &link, (ion_csl_link_t) succs[level], 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				/* only a deleter changes the links of a linked node */
+				goto done;
+			}
+
+			expected = (ion_csl_link_t) succs[level];
+
+			if (__atomic_compare_exchange_n(&preds[level]->next[level], &expected, (ion_csl_link_t) node, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+				break;
+			}
+
+			csl_search(skiplist, key, boolean_false, preds, succs);
+		}
+	}
+
+done:
+	csl_release_node(skiplist, slot, node);
+	csl_exit(skiplist, slot);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+csl_update(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	ion_csl_node_t		*node;
+	ion_csl_retired_t	*block;
+	ion_status_t		status;
+	int					slot;
+
+	while (1) {
+		slot	= csl_enter(skiplist);
+		node	= csl_seek(skiplist, key, boolean_true);
+
+		if ((NULL != node) && (0 == csl_compare(skiplist, node, key))) {
+			if (NULL == (block = csl_new_value(skiplist, value))) {
+				csl_exit(skiplist, slot);
+				return ION_STATUS_ERROR(err_out_of_memory);
+			}
+
+			/* an update racing a delete lands just before it */
+			block = __atomic_exchange_n(&node->value, block, __ATOMIC_ACQ_REL);
+			csl_retire(skiplist, slot, block);
+			csl_exit(skiplist, slot);
+
+			return ION_STATUS_OK(1);
+		}
+
+		csl_exit(skiplist, slot);
+
+		status = csl_insert(skiplist, key, value);
+
+		/* another thread inserted it first, so update theirs */
+		if (err_duplicate_key != status.error) {
+			return status;
+		}
+	}
+}
+
+ion_status_t
+csl_delete(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key
+) {
+	ion_csl_node_t	*preds[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*succs[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*node;
+	ion_csl_link_t	link;
+	ion_sl_level_t	level;
+	int				slot = csl_enter(skiplist);
+
+	if (!csl_search(skiplist, key, boolean_false, preds, succs)) {
+		csl_exit(skiplist, slot);
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	node = succs[0];
+
+	/* marked from the top, so the tower stops growing before the record goes */
+	for (level = node->height; level > 0; level--) {
+		link = __atomic_load_n(&node->next[level], __ATOMIC_ACQUIRE);
+
+		while (!CSL_MARKED(link) && !__atomic_compare_exchange_n(&node->next[level], &link, link | 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {}
+	}
+
+	link = __atomic_load_n(&node->next[0], __ATOMIC_ACQUIRE);
+
+	while (1) {
+		if (CSL_MARKED(link)) {
+			/* another thread deleted it first */
+			csl_exit(skiplist, slot);
+			return ION_STATUS_ERROR(err_item_not_found);
+		}
+
+		if (__atomic_compare_exchange_n(&node->next[0], &link, link | 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			break;
+		}
+	}
+
+	csl_release_node(skiplist, slot, node);
+	csl_exit(skiplist, slot);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+csl_query(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	int				slot	= csl_enter(skiplist);
+	ion_csl_node_t	*node	= csl_seek(skiplist, key, boolean_true);
+
+	if ((NULL == node) || (0 != csl_compare(skiplist, node, key))) {
+		csl_exit(skiplist, slot);
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	memcpy(value, csl_value_bytes(__atomic_load_n(&node->value, __ATOMIC_ACQUIRE)), skiplist->super.record.value_size);
+	csl_exit(skiplist, slot);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_err_t
+csl_next_record(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_boolean_t				inclusive,
+	ion_key_t					record_key,
+	ion_value_t					record_value
+) {
+	int				slot	= csl_enter(skiplist);
+	ion_csl_node_t	*node	= csl_seek(skiplist, key, inclusive);
+
+	if (NULL == node) {
+		csl_exit(skiplist, slot);
+		return err_item_not_found;
+	}
+
+	memcpy(record_key, node->key, skiplist->super.record.key_size);
+	memcpy(record_value, csl_value_bytes(__atomic_load_n(&node->value, __ATOMIC_ACQUIRE)), skiplist->super.record.value_size);
+	csl_exit(skiplist, slot);
+
+	return err_ok;
+}
@@ -0,0 +1,279 @@
+/******************************************************************************/
+/**
+@file
+@brief		A skiplist that several threads may use at once without
+			locks.
+@details	Nodes are linked level by level with compare-and-swap. A node
+			is deleted by marking the low bit of each of its links, from
+			the top of its tower down, and whoever marks the bottom link
+			deletes it; a marked node is then unlinked by any search that
+			passes it. Lookups never write and never retry, so they finish
+			in a number of steps bounded by the nodes they pass.
+@par
+			Unlinked nodes and replaced values are freed through epochs.
+			Each operation announces the epoch it started in, in one of
+			@ref ION_CSL_SLOTS slots, and memory retired in an epoch is
+			only freed once the epoch has moved on twice, which it only
+			does once every running operation has seen the latest one.
+			Keys are unique. Only available on hosts with gcc atomics.
+*/
+/******************************************************************************/
+
+#if !defined(CONCURRENT_SKIP_LIST_H_)
+#define CONCURRENT_SKIP_LIST_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "skip_list_types.h"
+
+/**
+@brief		The tallest a tower may be, which bounds the search paths kept
+			on the stack.
+*/
+#if !defined(ION_CSL_MAX_HEIGHT)
+#define ION_CSL_MAX_HEIGHT 32
+#endif
+
+/**
+@brief		How many operations may run at once. Any more wait for a free
+			slot.
+*/
+#if !defined(ION_CSL_SLOTS)
+#define ION_CSL_SLOTS 64
+#endif
+
+/**
+@brief		The size of a slot, so that threads announcing their epochs do
+			not write the same cache line.
+*/
+#if !defined(ION_CSL_CACHE_LINE)
+#define ION_CSL_CACHE_LINE 64
+#endif
+
+/**
+@brief		How many nodes or values an operation's slot retires before
+			it tries to move the epoch on and free what has become safe.
+*/
+#if !defined(ION_CSL_RECLAIM_INTERVAL)
+#define ION_CSL_RECLAIM_INTERVAL 32
+#endif
+
+/**
+@brief		A link between nodes, whose low bit marks the node holding it
+			as deleted.
+*/
+typedef uintptr_t ion_csl_link_t;
+
+/**
+@brief		What a node or value needs to wait on the retired list until
+			no operation can still be reading it.
+*/
+typedef struct csl_retired {
+	struct csl_retired	*next;		/**< The next retired item */
+	uint64_t			epoch;		/**< The epoch it was retired in */
+	ion_boolean_t		is_node;	/**< Whether it is a node, or else a
+									 value */
+} ion_csl_retired_t;
+
+/**
+@brief		A node of a concurrent skiplist.
+@details	The tower of links and the key follow the node in the same
+			piece of memory. The value is kept apart so that an update can
+			swap it whole; its bytes follow an @ref ion_csl_retired_t.
+*/
+typedef struct csl_node {
+	ion_csl_retired_t	retired;	/**< Kept first, so the node can be
+									 retired as it is */
+	ion_key_t			key;		/**< The key, @c NULL for the head */
+	ion_csl_retired_t	*value;		/**< The current value, read and
+									 swapped atomically */
+	ion_sl_level_t		height;		/**< Height index of the node (counts
+									 from 0) */
+	int					owners;		/**< The inserter and the deleter,
+									 the last of which retires the node */
+	ion_csl_link_t		*next;		/**< The tower of links */
+} ion_csl_node_t;
+
+/**
+@brief		The epoch slot of one running operation.
+*/
+typedef union {
+	struct {
+		uint64_t	announce;	/**< 0 when free, else the epoch the
+								 operation saw, shifted up with the low
+								 bit set */
+		uint32_t	rng;		/**< The xorshift state towers are drawn
+								 from, owned by whichever operation holds
+								 the slot */
+		int			retired;	/**< Items retired since the last reclaim */
+	}			state;
+	ion_byte_t	line[ION_CSL_CACHE_LINE];
+} ion_csl_slot_t;
+
+/**
+@brief		Struct of a concurrent skiplist.
+*/
+typedef struct concurrent_skiplist {
+	ion_dictionary_parent_t super;
+	ion_csl_node_t			*head;		/**< Entry point, holding no record */
+	ion_sl_level_t			maxheight;	/**< Maximum height of a tower */
+	uint32_t				threshold;	/**< A draw below which a tower grows
+										 another level, p of the range */
+	uint64_t				epoch;		/**< The global epoch */
+	ion_csl_retired_t		*retired;	/**< The items waiting to be freed */
+	ion_csl_slot_t			*slots;		/**< The epoch slots */
+} ion_concurrent_skiplist_t;
+
+/**
+@brief		Initializes a concurrent skiplist.
+
+@param		skiplist
+				The skiplist to initialize.
+@param		key_type
+				The type of key that is being stored in the collection.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		maxheight
+				The maximum height of a tower, at most
+				@ref ION_CSL_MAX_HEIGHT.
+@param		pnum
+				Probability numerator of a tower growing a level.
+@param		pden
+				Probability denominator of a tower growing a level.
+@return		The status of the initialization.
+*/
+ion_err_t
+csl_initialize(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	int							maxheight,
+	int							pnum,
+	int							pden
+);
+
+/**
+@brief		Frees every node and value of a skiplist.
+
+@details	No other thread may be using the skiplist.
+
+@param		skiplist
+				The skiplist to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+csl_destroy(
+	ion_concurrent_skiplist_t *skiplist
+);
+
+/**
+@brief		Inserts a record whose key is not in the skiplist yet.
+
+@param		skiplist
+				The skiplist to insert into.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		The status of the insertion, @c err_duplicate_key if the key
+			is already there.
+*/
+ion_status_t
+csl_insert(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+);
+
+/**
+@brief		Replaces the value stored under a key, inserting it if absent.
+
+@param		skiplist
+				The skiplist to update.
+@param		key
+				The key of the record.
+@param		value
+				The new value of the record.
+@return		The status of the update.
+*/
+ion_status_t
+csl_update(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+);
+
+/**
+@brief		Deletes the record stored under a key.
+
+@param		skiplist
+				The skiplist to delete from.
+@param		key
+				The key of the record.
+@return		The status of the deletion.
+*/
+ion_status_t
+csl_delete(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key
+);
+
+/**
+@brief		Looks up the value stored under a key, without writing to the
+			skiplist or retrying.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value of the record.
+@return		The status of the query.
+*/
+ion_status_t
+csl_query(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+);
+
+/**
+@brief		Reads the record with the smallest key after a given one.
+
+@details	Cursors step through a skiplist with this, one search per
+			record, so they hold nothing between steps and writers never
+			wait for them.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to start from, or @c NULL to read the first record.
+@param		inclusive
+				Whether a record with @p key itself may be read.
+@param		record_key
+				Receives the key of the record.
+@param		record_value
+				Receives the value of the record.
+@return		@c err_ok, or @c err_item_not_found if no record follows.
+*/
+ion_err_t
+csl_next_record(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_boolean_t				inclusive,
+	ion_key_t					record_key,
+	ion_value_t					record_value
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONCURRENT_SKIP_LIST_H_ */
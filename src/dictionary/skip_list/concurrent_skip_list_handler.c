@@ -0,0 +1,289 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for the lock-free concurrent skiplist.
+*/
+/******************************************************************************/
+
+#include "concurrent_skip_list_handler.h"
+
+ion_status_t
+csldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return csl_insert((ion_concurrent_skiplist_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+csldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return csl_query((ion_concurrent_skiplist_t *) dictionary->instance, key, value);
+}
+
+ion_err_t
+csldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+
+	ion_concurrent_skiplist_t	*skiplist;
+	ion_err_t					err;
+
+	if (NULL == (skiplist = ion_alloc(ion_alloc_other, sizeof(ion_concurrent_skiplist_t)))) {
+		return err_out_of_memory;
+	}
+
+	skiplist->super.compare = compare;
+
+	/* the same p as the single threaded skiplist */
+	err						= csl_initialize(skiplist, key_type, key_size, value_size, dictionary_size, 1, 4);
+
+	if (err_ok != err) {
+		ion_free(skiplist);
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) skiplist;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_status_t
+csldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return csl_delete((ion_concurrent_skiplist_t *) dictionary->instance, key);
+}
+
+ion_err_t
+csldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t result = csl_destroy((ion_concurrent_skiplist_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return result;
+}
+
+ion_status_t
+csldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return csl_update((ion_concurrent_skiplist_t *) dictionary->instance, key, value);
+}
+
+/**
+@brief		Reads the first record after @p start, or at it if @p inclusive,
+			into the cursor, and tests it against the predicate.
+@details	A filter is tested on the copy each read takes anyway, and the
+			records it fails are passed over.
+*/
+static ion_boolean_t
+csldict_read(
+	ion_csldict_cursor_t	*cursor,
+	ion_key_t				start,
+	ion_boolean_t			inclusive
+) {
+	ion_concurrent_skiplist_t *skiplist = (ion_concurrent_skiplist_t *) cursor->super.dictionary->instance;
+
+	if (err_ok != csl_next_record(skiplist, start, inclusive, cursor->key, cursor->value)) {
+		return boolean_false;
+	}
+
+	while ((predicate_predicate == cursor->super.predicate->type) && (boolean_false == test_record_predicate(&cursor->super, cursor->key, cursor->value))) {
+		if (err_ok != csl_next_record(skiplist, cursor->key, boolean_false, cursor->key, cursor->value)) {
+			return boolean_false;
+		}
+	}
+
+	return test_record_predicate(&cursor->super, cursor->key, cursor->value);
+}
+
+/**
+@brief		Reads the first record a cursor returns into the cursor, and
+			sets its status by whether there is one.
+*/
+static void
+csldict_first(
+	ion_csldict_cursor_t *cursor
+) {
+	ion_predicate_t *predicate	= cursor->super.predicate;
+	ion_key_t		start		= NULL;
+
+	if (predicate_equality == predicate->type) {
+		start = predicate->statement.equality.equality_value;
+	}
+	else if (predicate_range == predicate->type) {
+		start = predicate->statement.range.lower_bound;
+	}
+
+	if (boolean_true == csldict_read(cursor, start, boolean_true)) {
+		cursor->super.status = cs_cursor_initialized;
+	}
+	else {
+		cursor->super.status = cs_end_of_results;
+	}
+}
+
+ion_err_t
+csldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_key_size_t			key_size	= dictionary->instance->record.key_size;
+	ion_value_size_t		value_size	= dictionary->instance->record.value_size;
+	ion_csldict_cursor_t	*csl_cursor;
+	ion_predicate_t			*copy;
+
+	if ((predicate_equality != predicate->type) && (predicate_range != predicate->type) && (predicate_all_records != predicate->type) && (predicate_predicate != predicate->type)) {
+		return err_invalid_predicate;
+	}
+
+	if (NULL == (csl_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_csldict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	/* the record read next, then the bounds of the predicate, in one piece */
+	if (NULL == (csl_cursor->key = ion_alloc(ion_alloc_cursor, key_size * 3 + value_size))) {
+		ion_free(csl_cursor);
+		return err_out_of_memory;
+	}
+
+	if (NULL == (copy = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(csl_cursor->key);
+		ion_free(csl_cursor);
+		return err_out_of_memory;
+	}
+
+	csl_cursor->value				= (ion_byte_t *) csl_cursor->key + key_size;
+	csl_cursor->super.dictionary	= dictionary;
+	csl_cursor->super.predicate		= copy;
+	csl_cursor->super.next			= csldict_next;
+	csl_cursor->super.destroy		= csldict_destroy_cursor;
+	csl_cursor->super.next_batch	= NULL;
+	copy->type						= predicate->type;
+
+	/* the predicate may be destroyed while the cursor is open, so keep its keys */
+	if (predicate_equality == predicate->type) {
+		copy->statement.equality.equality_value = (ion_byte_t *) csl_cursor->value + value_size;
+		memcpy(copy->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+	}
+	else if (predicate_range == predicate->type) {
+		copy->statement.range.lower_bound	= (ion_byte_t *) csl_cursor->value + value_size;
+		copy->statement.range.upper_bound	= (ion_byte_t *) copy->statement.range.lower_bound + key_size;
+		memcpy(copy->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+		memcpy(copy->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+	}
+	else if (predicate_predicate == predicate->type) {
+		copy->statement.other_predicate = predicate->statement.other_predicate;
+	}
+
+	csldict_first(csl_cursor);
+	*cursor = (ion_dict_cursor_t *) csl_cursor;
+
+	return err_ok;
+}
+
+ion_cursor_status_t
+csldict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_csldict_cursor_t		*csl_cursor = (ion_csldict_cursor_t *) cursor;
+	ion_concurrent_skiplist_t	*skiplist	= (ion_concurrent_skiplist_t *) cursor->dictionary->instance;
+
+	if (cs_cursor_active == cursor->status) {
+		/* keys are unique, so an equality cursor has nothing past its first record */
+		if ((predicate_equality == cursor->predicate->type) || (boolean_false == csldict_read(csl_cursor, csl_cursor->key, boolean_false))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else {
+		return cursor->status;
+	}
+
+	memcpy(record->key, csl_cursor->key, skiplist->super.record.key_size);
+	memcpy(record->value, csl_cursor->value, skiplist->super.record.value_size);
+
+	return cursor->status;
+}
+
+void
+csldict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_csldict_cursor_t *csl_cursor = (ion_csldict_cursor_t *) *cursor;
+
+	/* the keys of the predicate live with the cursor's record */
+	ion_free(csl_cursor->super.predicate);
+	ion_free(csl_cursor->key);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+csldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+ion_err_t
+csldict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+void
+csldict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= csldict_insert;
+	handler->create_dictionary	= csldict_create_dictionary;
+	handler->get				= csldict_query;
+	handler->update				= csldict_update;
+	handler->find				= csldict_find;
+	handler->remove				= csldict_delete;
+	handler->delete_dictionary	= csldict_delete_dictionary;
+	handler->close_dictionary	= csldict_close_dictionary;
+	handler->open_dictionary	= csldict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= NULL;
+	handler->bulk_load			= NULL;
+}
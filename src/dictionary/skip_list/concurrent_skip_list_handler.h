@@ -0,0 +1,241 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for the lock-free concurrent skiplist.
+@details	The dictionaries created with it may be used from several
+			threads at once. Keys are unique. Only available on hosts with
+			gcc atomics.
+*/
+/******************************************************************************/
+
+#if !defined(CONCURRENT_SKIP_LIST_HANDLER_H_)
+#define CONCURRENT_SKIP_LIST_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "concurrent_skip_list.h"
+
+/**
+@brief		A cursor over a concurrent skiplist.
+@details	The cursor keeps a copy of the record it read last, not a
+			node, and finds the record after it anew on each step, so
+			writers never wait for it. It sees each key at most once and
+			in order, but records changed while it runs may or may not be
+			seen.
+*/
+typedef struct csldict_cursor {
+	ion_dict_cursor_t	super;	/**< Cursor supertype this type inherits
+								 from */
+	ion_key_t			key;	/**< The key of the record read next, or
+								 read last once it was returned */
+	ion_value_t			value;	/**< The value read along with @c key */
+} ion_csldict_cursor_t;
+
+/**
+@brief		Registers the concurrent skiplist handler.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+csldict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Inserts a record whose key is not in the dictionary yet.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+csldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up a key without taking a lock or retrying.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+csldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Creates a concurrent skiplist dictionary.
+
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The maximum height of the skiplist's towers, at most
+				@ref ION_CSL_MAX_HEIGHT.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+csldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes a key from the dictionary.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+csldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a concurrent skiplist dictionary and frees its memory.
+
+@details	No other thread may be using the dictionary.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+csldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates the value stored under a key, inserting it if absent.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update.
+*/
+ion_status_t
+csldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate, in key order.
+
+@details	See @ref ion_csldict_cursor_t.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+csldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a concurrent skiplist cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+csldict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a concurrent skiplist cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+csldict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opening is not supported by the in memory skiplist.
+
+@return		@c err_not_implemented.
+*/
+ion_err_t
+csldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closing is not supported by the in memory skiplist.
+
+@return		@c err_not_implemented.
+*/
+ion_err_t
+csldict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONCURRENT_SKIP_LIST_HANDLER_H_ */
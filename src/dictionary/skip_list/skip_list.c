@@ -6,9 +6,377 @@
 */
 /******************************************************************************/
 
+#include <limits.h>
+
 #include "skip_list.h"
+#include "../bpp_tree/bpp_tree_handler.h"
 /* #include "serial_c_iface.h" */
 
+/**
+@brief		Rounds a size up so that what follows it is aligned for a
+			pointer.
+*/
+#define ION_SL_ALIGN(size) (((size) + sizeof(ion_sl_node_t *) - 1) / sizeof(ion_sl_node_t *) * sizeof(ion_sl_node_t *))
+
+#if defined(__GNUC__)
+#define ION_SL_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define ION_SL_PREFETCH(address) ((void) 0)
+#endif
+
+/**
+@brief		Carves @p size bytes from the arena of a skiplist, starting a
+			new block when the current one is too full.
+@param		size
+				How many bytes to carve, a multiple of the pointer size.
+@return		The bytes carved, or @c NULL if a block could not be
+			allocated.
+*/
+static void *
+sl_arena_alloc(
+	ion_skiplist_t	*skiplist,
+	size_t			size
+) {
+	if ((NULL == skiplist->arena) || (skiplist->arena_used + size > skiplist->arena_size)) {
+		size_t		block_size	= ION_SL_ALIGN(sizeof(ion_byte_t *)) + size;
+		ion_byte_t	*block;
+
+		if (block_size < ION_SL_ARENA_BLOCK_SIZE) {
+			block_size = ION_SL_ARENA_BLOCK_SIZE;
+		}
+
+		if (NULL == (block = ion_alloc(ion_alloc_node, block_size))) {
+			return NULL;
+		}
+
+		/* what is left of the block before is abandoned until destroy */
+		*(ion_byte_t **) block	= skiplist->arena;
+		skiplist->arena			= block;
+		skiplist->arena_used	= ION_SL_ALIGN(sizeof(ion_byte_t *));
+		skiplist->arena_size	= block_size;
+		skiplist->arena_total	+= block_size;
+	}
+
+	void *piece = skiplist->arena + skiplist->arena_used;
+
+	skiplist->arena_used += size;
+	return piece;
+}
+
+/**
+@brief		Makes a node of the given height, reusing one deleted at that
+			height if there is any.
+@details	The node, its tower, key and value are a single piece, laid
+			out in that order.
+@return		The node, with its links, key and value unset, or @c NULL if
+			there was no memory for it.
+*/
+static ion_sl_node_t *
+sl_new_node(
+	ion_skiplist_t	*skiplist,
+	ion_sl_level_t	height
+) {
+	ion_sl_node_t	*node	= skiplist->free_nodes[height];
+	size_t			tower	= sizeof(ion_sl_node_t *) * (height + 1);
+
+	if (NULL != node) {
+		skiplist->free_nodes[height] = node->next[0];
+		return node;
+	}
+
+	node = sl_arena_alloc(skiplist, ION_SL_ALIGN(sizeof(ion_sl_node_t)) + tower + ION_SL_ALIGN(skiplist->super.record.key_size) + ION_SL_ALIGN(skiplist->super.record.value_size));
+
+	if (NULL == node) {
+		return NULL;
+	}
+
+	/* the key goes right after the header and before the tower, so a hop's
+	 * comparison and its next link are as near the node as they can be */
+	node->height	= height;
+	node->key		= (ion_byte_t *) node + ION_SL_ALIGN(sizeof(ion_sl_node_t));
+	node->next		= (ion_sl_node_t **) ((ion_byte_t *) node->key + ION_SL_ALIGN(skiplist->super.record.key_size));
+	node->value		= (ion_byte_t *) node->next + tower;
+
+	return node;
+}
+
+/**
+@brief		Keeps a node unlinked from a skiplist for reuse by a later
+			insert of the same height.
+*/
+static void
+sl_free_node(
+	ion_skiplist_t	*skiplist,
+	ion_sl_node_t	*node
+) {
+	node->next[0]						= skiplist->free_nodes[node->height];
+	skiplist->free_nodes[node->height]	= node;
+}
+
+/**
+@brief		Moves the finger of a skiplist to a key, and returns the last
+			node before it.
+@details	The finger holds, per level, the last node before the key
+			searched last. Levels stay right for the new key up from the
+			lowest one where the finger is before the key with nothing
+			else between, so only the levels below it are searched again,
+			from there. A key close to the last costs a climb of a few
+			levels, appending costs about a node per level passed.
+@return		The last node before @p key on the bottom level, or the head.
+*/
+static ion_sl_node_t *
+sl_search(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key
+) {
+	int				key_size	= skiplist->super.record.key_size;
+	ion_sl_node_t	**finger	= skiplist->finger;
+	ion_sl_node_t	*cursor;
+	ion_sl_node_t	*next;
+	unsigned long	hops		= 0;
+	ion_sl_level_t	h			= 0;
+
+	while (h < skiplist->head->height) {
+		cursor = finger[h];
+
+		if (((NULL == cursor->key) || (skiplist->super.compare(cursor->key, key, key_size) < 0)) && ((NULL == cursor->next[h]) || (skiplist->super.compare(cursor->next[h]->key, key, key_size) >= 0))) {
+			break;
+		}
+
+		h++;
+	}
+
+	cursor = finger[h];
+
+	/* On the top level a finger past the key is no use, only the head is */
+	if ((NULL != cursor->key) && (skiplist->super.compare(cursor->key, key, key_size) >= 0)) {
+		cursor = skiplist->head;
+	}
+
+	for (; h >= 0; h--) {
+		while (NULL != (next = cursor->next[h])) {
+			/* fetch the hop after this one while the key is compared */
+			ION_SL_PREFETCH(next->next[h]);
+
+			if (skiplist->super.compare(next->key, key, key_size) >= 0) {
+				break;
+			}
+
+			cursor = next;
+			hops++;
+		}
+
+		/* and the first node of the level below, where the search drops */
+		if (0 < h) {
+			ION_SL_PREFETCH(cursor->next[h - 1]);
+		}
+
+		finger[h] = cursor;
+	}
+
+	skiplist->searches++;
+	skiplist->hops += hops;
+
+	return cursor;
+}
+
+/**
+@brief		How many times fewer nodes each level holds than the one
+			below, 1/p rounded down and at least 2.
+*/
+static unsigned long
+sl_level_step(
+	ion_skiplist_t *skiplist
+) {
+	unsigned long step = (0 < skiplist->pnum) ? (unsigned long) (skiplist->pden / skiplist->pnum) : 2;
+
+	return (step < 2) ? 2 : step;
+}
+
+/**
+@brief		Counts a node into a skiplist, raising an automatic maximum
+			height once there are 1/p times more nodes than it serves.
+*/
+static void
+sl_count_node(
+	ion_skiplist_t *skiplist
+) {
+	unsigned long step;
+
+	skiplist->count++;
+
+	while (skiplist->auto_height && (skiplist->count >= skiplist->grow_at) && (skiplist->maxheight < skiplist->capacity)) {
+		step = sl_level_step(skiplist);
+
+		/* the levels above the old top are empty, with the finger at the head */
+		skiplist->maxheight++;
+		skiplist->head->height	= skiplist->maxheight - 1;
+		skiplist->grow_at		= (skiplist->grow_at > ULONG_MAX / step) ? ULONG_MAX : skiplist->grow_at * step;
+	}
+}
+
+/**
+@brief		Frees the blocks of the arena of a skiplist, and with them
+			every node.
+*/
+static void
+sl_release_arena(
+	ion_skiplist_t *skiplist
+) {
+	ion_byte_t *block;
+
+	/* every node is in the arena, so freeing its blocks frees them all */
+	while (NULL != skiplist->arena) {
+		block			= skiplist->arena;
+		skiplist->arena = *(ion_byte_t **) block;
+		ion_free(block);
+	}
+
+	skiplist->head			= NULL;
+	skiplist->free_nodes	= NULL;
+	skiplist->finger		= NULL;
+	skiplist->arena_total	= 0;
+}
+
+/**
+@brief		Starts the empty set of nodes of a skiplist in a new arena.
+@return		The status of starting it.
+*/
+static ion_err_t
+sl_start_memtable(
+	ion_skiplist_t *skiplist
+) {
+	ion_sl_level_t h;
+
+	/* the free lists and the head are the first pieces of the arena */
+	skiplist->arena			= NULL;
+	skiplist->arena_used	= 0;
+	skiplist->arena_size	= 0;
+	skiplist->arena_total	= 0;
+	skiplist->head			= NULL;
+	skiplist->free_nodes	= sl_arena_alloc(skiplist, sizeof(ion_sl_node_t *) * skiplist->capacity);
+
+	if (NULL == skiplist->free_nodes) {
+		return err_out_of_memory;
+	}
+
+	memset(skiplist->free_nodes, 0, sizeof(ion_sl_node_t *) * skiplist->capacity);
+
+	skiplist->finger = sl_arena_alloc(skiplist, sizeof(ion_sl_node_t *) * skiplist->capacity);
+
+	if (NULL == skiplist->finger) {
+		sl_release_arena(skiplist);
+		return err_out_of_memory;
+	}
+
+	skiplist->head = sl_new_node(skiplist, skiplist->capacity - 1);
+
+	if (NULL == skiplist->head) {
+		sl_release_arena(skiplist);
+		return err_out_of_memory;
+	}
+
+	/* the head has room for the tallest tower, and uses what maxheight allows */
+	skiplist->head->key		= NULL;
+	skiplist->head->value	= NULL;
+	skiplist->head->height	= skiplist->maxheight - 1;
+	skiplist->count			= 0;
+
+	for (h = 0; h < skiplist->capacity; h++) {
+		skiplist->head->next[h] = NULL;
+		skiplist->finger[h]		= skiplist->head;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Feeds the nodes of a skiplist in order to
+			@ref bpptree_bulk_load.
+*/
+static ion_err_t
+sl_spill_next(
+	void			*context,
+	ion_record_t	*record
+) {
+	ion_sl_node_t	**cursor	= ((ion_sl_node_t **) context) + 1;
+	ion_skiplist_t	*skiplist	= *(ion_skiplist_t **) context;
+
+	if (NULL == *cursor) {
+		return err_item_not_found;
+	}
+
+	memcpy(record->key, (*cursor)->key, skiplist->super.record.key_size);
+	memcpy(record->value, (*cursor)->value, skiplist->super.record.value_size);
+	*cursor = (*cursor)->next[0];
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the nodes of a skiplist in order to a new run, one
+			sequential pass building a B+ tree, and starts afresh in
+			memory.
+@return		The status of the spill. On failure the nodes stay in memory.
+*/
+static ion_err_t
+sl_spill(
+	ion_skiplist_t *skiplist
+) {
+	ion_dictionary_t	*runs;
+	ion_dictionary_t	*run;
+	void				*source[2];
+	ion_status_t		status;
+	ion_err_t			err;
+
+	if (NULL == skiplist->run_value) {
+		if (NULL == (skiplist->run_value = ion_alloc(ion_alloc_other, skiplist->super.record.value_size))) {
+			return err_out_of_memory;
+		}
+
+		bpptree_init(&skiplist->run_handler);
+	}
+
+	if (NULL == (runs = ion_realloc(ion_alloc_other, skiplist->runs, sizeof(ion_dictionary_t) * (skiplist->run_count + 1)))) {
+		return err_out_of_memory;
+	}
+
+	skiplist->runs	= runs;
+	run				= &runs[skiplist->run_count];
+	err				= dictionary_create(&skiplist->run_handler, run, skiplist->run_id + skiplist->run_count, skiplist->super.key_type, skiplist->super.record.key_size, skiplist->super.record.value_size, 0);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	source[0]	= skiplist;
+	source[1]	= skiplist->head->next[0];
+	status		= bpptree_bulk_load(run, sl_spill_next, source);
+
+	if (err_ok != status.error) {
+		dictionary_delete_dictionary(run);
+		return status.error;
+	}
+
+	skiplist->run_count++;
+	sl_release_arena(skiplist);
+
+	return sl_start_memtable(skiplist);
+}
+
+/**
+@brief		Whether the next insert may need the arena to grow past the
+			budget of a skiplist, which then spills first.
+*/
+static ion_boolean_t
+sl_over_budget(
+	ion_skiplist_t *skiplist
+) {
+	size_t tallest = ION_SL_ALIGN(sizeof(ion_sl_node_t)) + sizeof(ion_sl_node_t *) * skiplist->maxheight + ION_SL_ALIGN(skiplist->super.record.key_size) + ION_SL_ALIGN(skiplist->super.record.value_size);
+
+	return (0 != skiplist->budget) && (NULL != skiplist->head->next[0]) && (skiplist->arena_used + tallest > skiplist->arena_size) && (skiplist->arena_total + ION_SL_ARENA_BLOCK_SIZE > skiplist->budget);
+}
+
 ion_err_t
 sl_initialize(
 	ion_skiplist_t	*skiplist,
@@ -19,17 +387,41 @@ sl_initialize(
 	int				pnum,
 	int				pden
 ) {
-	/* TODO srand may need to be changed */
-	/* srand(time(NULL)); */
-
 	skiplist->super.key_type			= key_type;
 	skiplist->super.record.key_size		= key_size;
 	skiplist->super.record.value_size	= value_size;
 	skiplist->maxheight					= maxheight;
+	skiplist->capacity					= maxheight;
+	skiplist->auto_height				= boolean_false;
 
 	/* TODO potentially check if pden and pnum are invalid (0) */
 	skiplist->pden						= pden;
 	skiplist->pnum						= pnum;
+	skiplist->level_bits				= 0;
+
+	/* p of 1/2 or 1/4 takes a height from the trailing zeros of one word */
+	if ((0 < pnum) && (pden == 2 * pnum)) {
+		skiplist->level_bits = 1;
+	}
+	else if ((0 < pnum) && (pden == 4 * pnum)) {
+		skiplist->level_bits = 2;
+	}
+
+	sl_seed(skiplist, ION_SL_DEFAULT_SEED);
+
+	/* Without a maximum height, it grows with the nodes, one level every 1/p times more */
+	if (0 >= maxheight) {
+		ion_sl_level_t h;
+
+		skiplist->maxheight		= ION_SL_AUTO_HEIGHT_START;
+		skiplist->capacity		= ION_SL_AUTO_HEIGHT_LIMIT;
+		skiplist->auto_height	= boolean_true;
+		skiplist->grow_at		= 1;
+
+		for (h = 1; h < skiplist->maxheight; h++) {
+			skiplist->grow_at *= sl_level_step(skiplist);
+		}
+	}
 
 #if ION_DEBUG
 	DUMP(skip_list->super.record.key_size, "%d");
@@ -40,47 +432,85 @@ sl_initialize(
 	printf("%s", "\n");
 #endif
 
-	skiplist->head = malloc(sizeof(ion_sl_node_t));
+	skiplist->searches	= 0;
+	skiplist->hops		= 0;
+	skiplist->budget	= 0;
+	skiplist->run_id	= 0;
+	skiplist->run_count = 0;
+	skiplist->runs		= NULL;
+	skiplist->run_value = NULL;
 
-	if (NULL == skiplist->head) {
-		return err_out_of_memory;
-	}
+	return sl_start_memtable(skiplist);
+}
 
-	skiplist->head->next = malloc(sizeof(ion_sl_node_t) * skiplist->maxheight);
+ion_err_t
+sl_destroy(
+	ion_skiplist_t *skiplist
+) {
+	ion_err_t	result = err_ok;
+	int			i;
 
-	if (NULL == skiplist->head->next) {
-		free(skiplist->head);
-		skiplist->head = NULL;
-		return err_out_of_memory;
+	sl_release_arena(skiplist);
+
+	for (i = 0; i < skiplist->run_count; i++) {
+		if (err_ok != dictionary_delete_dictionary(&skiplist->runs[i])) {
+			result = err_dictionary_destruction_error;
+		}
 	}
 
-	skiplist->head->height	= maxheight - 1;
-	skiplist->head->key		= NULL;
-	skiplist->head->value	= NULL;
+	ion_free(skiplist->runs);
+	ion_free(skiplist->run_value);
+	skiplist->runs		= NULL;
+	skiplist->run_value = NULL;
+	skiplist->run_count = 0;
+
+	return result;
+}
 
-	while (--maxheight >= 0) {
-		skiplist->head->next[maxheight] = NULL;
+ion_err_t
+sl_set_budget(
+	ion_skiplist_t		*skiplist,
+	size_t				budget,
+	ion_dictionary_id_t first_run_id
+) {
+	if (0 != skiplist->run_count) {
+		return err_illegal_state;
 	}
 
+	skiplist->budget	= budget;
+	skiplist->run_id	= first_run_id;
+
 	return err_ok;
 }
 
 ion_err_t
-sl_destroy(
-	ion_skiplist_t *skiplist
+sl_stats(
+	ion_skiplist_t	*skiplist,
+	ion_sl_stats_t	*stats
 ) {
-	ion_sl_node_t *cursor = skiplist->head, *tofree;
-
-	while (cursor != NULL) {
-		tofree	= cursor;
-		cursor	= cursor->next[0];
-		free(tofree->key);
-		free(tofree->value);
-		free(tofree->next);
-		free(tofree);
+	ion_sl_node_t *cursor;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->nodes		= skiplist->count;
+	stats->maxheight	= skiplist->maxheight;
+	stats->bytes		= skiplist->arena_total;
+	stats->runs			= skiplist->run_count;
+	stats->searches		= skiplist->searches;
+	stats->hops			= skiplist->hops;
+
+	for (cursor = skiplist->head->next[0]; NULL != cursor; cursor = cursor->next[0]) {
+		stats->levels[(cursor->height < ION_SL_STATS_LEVELS) ? cursor->height : ION_SL_STATS_LEVELS - 1]++;
 	}
 
-	skiplist->head = NULL;
+	return err_ok;
+}
+
+ion_err_t
+sl_reset_stats(
+	ion_skiplist_t *skiplist
+) {
+	skiplist->searches	= 0;
+	skiplist->hops		= 0;
 
 	return err_ok;
 }
@@ -92,33 +522,18 @@ sl_insert(
 	ion_value_t		value
 ) {
 	/* TODO Should this be refactored to be size_t? */
-	int key_size			= skiplist->super.record.key_size;
-	int value_size			= skiplist->super.record.value_size;
-
-	ion_sl_node_t *newnode	= malloc(sizeof(ion_sl_node_t));
-
-	if (NULL == newnode) {
-		return ION_STATUS_ERROR(err_out_of_memory);
-	}
-
-	newnode->key = malloc(key_size);
-
-	if (NULL == newnode->key) {
-		free(newnode);
-		return ION_STATUS_ERROR(err_out_of_memory);
-	}
+	int				key_size	= skiplist->super.record.key_size;
+	int				value_size	= skiplist->super.record.value_size;
+	ion_sl_node_t	*newnode;
 
-	newnode->value = malloc(value_size);
+	if (sl_over_budget(skiplist)) {
+		ion_err_t err = sl_spill(skiplist);
 
-	if (NULL == newnode->value) {
-		free(newnode->key);
-		free(newnode);
-		return ION_STATUS_ERROR(err_out_of_memory);
+		if (err_ok != err) {
+			return ION_STATUS_ERROR(err);
+		}
 	}
 
-	memcpy(newnode->key, key, key_size);
-	memcpy(newnode->value, value, value_size);
-
 	/* First we check if there's already a duplicate node. If there is, we're
 	 * going to do a modified insert instead. TODO write unit cpp_wrapper to check this
 	*/
@@ -126,16 +541,15 @@ sl_insert(
 
 	if ((NULL != duplicate->key) && (skiplist->super.compare(duplicate->key, key, key_size) == 0)) {
 		/* Child duplicate nodes have no height (which is effectively 1). */
-		newnode->height = 0;
-		newnode->next	= malloc(sizeof(ion_sl_node_t *) * (newnode->height + 1));
+		newnode = sl_new_node(skiplist, 0);
 
-		if (NULL == newnode->next) {
-			free(newnode->value);
-			free(newnode->key);
-			free(newnode);
+		if (NULL == newnode) {
 			return ION_STATUS_ERROR(err_out_of_memory);
 		}
 
+		memcpy(newnode->key, key, key_size);
+		memcpy(newnode->value, value, value_size);
+
 		/* We want duplicate to be the last node in the block of duplicate
 		 * nodes, so we traverse along the bottom until we get there.
 		*/
@@ -149,35 +563,117 @@ sl_insert(
 	}
 	else {
 		/* If there's no duplicate node, we do a vanilla insert instead */
-		newnode->height = sl_gen_level(skiplist);
-		newnode->next	= malloc(sizeof(ion_sl_node_t *) * (newnode->height + 1));
+		newnode = sl_new_node(skiplist, sl_gen_level(skiplist));
 
-		if (NULL == newnode->next) {
-			free(newnode->value);
-			free(newnode->key);
-			free(newnode);
+		if (NULL == newnode) {
 			return ION_STATUS_ERROR(err_out_of_memory);
 		}
 
-		ion_sl_node_t	*cursor = skiplist->head;
-		ion_sl_level_t	h;
+		memcpy(newnode->key, key, key_size);
+		memcpy(newnode->value, value, value_size);
 
-		for (h = skiplist->head->height; h >= 0; --h) {
-			/* The memcmp will return -1 if key is smaller, 0 if equal, 1 if greater. */
-			while (NULL != cursor->next[h] && skiplist->super.compare(key, cursor->next[h]->key, key_size) >= 0) {
-				cursor = cursor->next[h];
-			}
+		ion_sl_level_t h;
 
-			if (h <= newnode->height) {
-				newnode->next[h]	= cursor->next[h];
-				cursor->next[h]		= newnode;
-			}
+		/* The search for a duplicate left the finger just before the key */
+		for (h = 0; h <= newnode->height; h++) {
+			newnode->next[h]			= skiplist->finger[h]->next[h];
+			skiplist->finger[h]->next[h] = newnode;
 		}
 	}
 
+	sl_count_node(skiplist);
+
 	return ION_STATUS_OK(1);
 }
 
+/**
+@brief	  The height of the @p index th node of a perfectly balanced
+			skiplist, counting from 1.
+*/
+static ion_sl_level_t
+sl_balanced_level(
+	ion_skiplist_t	*skiplist,
+	unsigned long	index
+) {
+	unsigned long	step	= sl_level_step(skiplist);
+	ion_sl_level_t	level	= 0;
+
+	while (0 == index % step && level < skiplist->maxheight - 1) {
+		index /= step;
+		level++;
+	}
+
+	return level;
+}
+
+ion_status_t
+sl_bulk_load(
+	ion_skiplist_t		*skiplist,
+	ion_sl_bulk_next_t	next,
+	void				*context,
+	ion_boolean_t		deterministic
+) {
+	/* The finger keeps the last node of each level, where the next one links */
+	ion_sl_node_t	**tail	= skiplist->finger;
+	ion_sl_node_t	*node;
+	ion_record_t	record;
+	ion_sl_level_t	height;
+	ion_sl_level_t	h;
+	ion_err_t		err;
+	ion_status_t	status	= ION_STATUS_OK(0);
+
+	if ((NULL != skiplist->head->next[0]) || (0 != skiplist->run_count)) {
+		return ION_STATUS_ERROR(err_illegal_state);
+	}
+
+	for (h = 0; h < skiplist->capacity; h++) {
+		tail[h] = skiplist->head;
+	}
+
+	while (1) {
+		if (sl_over_budget(skiplist)) {
+			/* The records spilled come before the rest, so the runs stay in order */
+			if (err_ok != (err = sl_spill(skiplist))) {
+				status.error = err;
+				return status;
+			}
+
+			tail = skiplist->finger;
+		}
+
+		height	= deterministic ? sl_balanced_level(skiplist, (unsigned long) status.count + 1) : sl_gen_level(skiplist);
+		node	= sl_new_node(skiplist, height);
+
+		if (NULL == node) {
+			status.error = err_out_of_memory;
+			return status;
+		}
+
+		record.key		= node->key;
+		record.value	= node->value;
+		err				= next(context, &record);
+
+		if ((err_ok == err) && (skiplist->head != tail[0]) && (skiplist->super.compare(tail[0]->key, node->key, skiplist->super.record.key_size) > 0)) {
+			err = err_sorted_order_violation;
+		}
+
+		if (err_ok != err) {
+			sl_free_node(skiplist, node);
+			status.error = (err_item_not_found == err) ? err_ok : err;
+			return status;
+		}
+
+		for (h = 0; h <= height; h++) {
+			node->next[h]		= NULL;
+			tail[h]->next[h]	= node;
+			tail[h]				= node;
+		}
+
+		sl_count_node(skiplist);
+		status.count++;
+	}
+}
+
 ion_status_t
 sl_query(
 	ion_skiplist_t	*skiplist,
@@ -189,7 +685,16 @@ sl_query(
 	int				value_size	= skiplist->super.record.value_size;
 	ion_sl_node_t	*cursor		= sl_find_node(skiplist, key);
 
+	int				i;
+
 	if ((NULL == cursor->key) || (skiplist->super.compare(cursor->key, key, key_size) != 0)) {
+		/* The newest run holding the key has its latest record */
+		for (i = skiplist->run_count - 1; i >= 0; i--) {
+			if (err_ok == dictionary_get(&skiplist->runs[i], key, value).error) {
+				return ION_STATUS_OK(1);
+			}
+		}
+
 		return ION_STATUS_ERROR(err_item_not_found);
 	}
 
@@ -198,6 +703,24 @@ sl_query(
 	return ION_STATUS_OK(1);
 }
 
+ion_status_t
+sl_get_ref(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key,
+	ion_value_t		*value
+) {
+	ion_sl_node_t *cursor = sl_find_node(skiplist, key);
+
+	if ((NULL == cursor->key) || (skiplist->super.compare(cursor->key, key, skiplist->super.record.key_size) != 0)) {
+		/* The runs are read through their own buffers, so there is nothing to point at */
+		return ION_STATUS_ERROR((0 == skiplist->run_count) ? err_item_not_found : err_not_implemented);
+	}
+
+	*value = cursor->value;
+
+	return ION_STATUS_OK(1);
+}
+
 ion_status_t
 sl_update(
 	ion_skiplist_t	*skiplist,
@@ -212,14 +735,31 @@ sl_update(
 	int				key_size	= skiplist->super.record.key_size;
 	int				value_size	= skiplist->super.record.value_size;
 	ion_sl_node_t	*cursor		= sl_find_node(skiplist, key);
+	ion_status_t	run_status;
+	int				i;
+
+	/* The records spilled to runs are updated where they are */
+	for (i = 0; i < skiplist->run_count; i++) {
+		if (err_ok == dictionary_get(&skiplist->runs[i], key, skiplist->run_value).error) {
+			run_status = dictionary_update(&skiplist->runs[i], key, value);
+
+			if (err_ok != run_status.error) {
+				return run_status;
+			}
+
+			status.count += run_status.count;
+		}
+	}
 
 	/* If the key doesn't exist in the skiplist... */
 	if ((NULL == cursor->key) || (skiplist->super.compare(cursor->key, key, key_size) != 0)) {
+		if (0 != status.count) {
+			status.error = err_ok;
+			return status;
+		}
+
 		/* Insert it. TODO Possibly return different error code */
-		sl_insert(skiplist, key, value);
-		status.error	= err_ok;
-		status.count	= 1;
-		return status;
+		return sl_insert(skiplist, key, value);
 	}
 
 	/* Otherwise, the key exists and now we have the node to update. */
@@ -242,88 +782,119 @@ sl_delete(
 	ion_key_t		key
 ) {
 	/* TODO size_t this */
-	int key_size = skiplist->super.record.key_size;
+	int				key_size	= skiplist->super.record.key_size;
+	ion_sl_node_t	**finger	= skiplist->finger;
+	ion_sl_node_t	*cursor		= sl_search(skiplist, key);
+	ion_sl_node_t	*tofree;
+	ion_sl_level_t	h;
+	ion_status_t	run_status;
+	int				i;
 	/* Default return is no item */
-	ion_status_t status;
+	ion_status_t	status;
 
 	status			= ION_STATUS_INITIALIZE;
 	/* If we fall through, then we didn't find what we were looking for. */
 	status.error	= err_item_not_found;
 
-	ion_sl_node_t	*cursor = skiplist->head;
-	ion_sl_level_t	h;
+	/* The finger is right before every level of each node holding the key,
+	 * the first of which is the only one taller than the bottom level.
+	*/
+	while (NULL != cursor->next[0] && skiplist->super.compare(cursor->next[0]->key, key, key_size) == 0) {
+		tofree = cursor->next[0];
 
-	for (h = skiplist->head->height; h >= 0; --h) {
-		while (NULL != cursor->next[h] && skiplist->super.compare(cursor->next[h]->key, key, key_size) < 0) {
-			cursor = cursor->next[h];
+		for (h = 0; h <= tofree->height; h++) {
+			finger[h]->next[h] = tofree->next[h];
 		}
 
-		if ((NULL != cursor->next[h]) && (skiplist->super.compare(cursor->next[h]->key, key, key_size) == 0)) {
-			ion_sl_node_t *oldcursor = cursor;
-
-			while (NULL != cursor->next[h] && skiplist->super.compare(cursor->next[h]->key, key, key_size) == 0) {
-				ion_sl_node_t	*tofree = cursor->next[h];
-				ion_sl_node_t	*relink = cursor->next[h];
-				ion_sl_level_t	link_h	= relink->height;
-
-				while (link_h >= 0) {
-					while (cursor->next[link_h] != relink) {
-						cursor = cursor->next[link_h];
-					}
-
-					ion_sl_node_t *jump = relink->next[link_h];
-
-					cursor->next[link_h] = jump;
-					link_h--;
-				}
+		sl_free_node(skiplist, tofree);
+		skiplist->count--;
+		status.error = err_ok;
+		status.count++;
+	}
 
-				free(tofree->key);
-				free(tofree->value);
-				free(tofree->next);
-				free(tofree);
+	/* The key goes from the runs too, or it would show through again */
+	for (i = 0; i < skiplist->run_count; i++) {
+		run_status = dictionary_delete(&skiplist->runs[i], key);
 
-				cursor = oldcursor;
-				status.count++;
-			}
-
-			status.error = err_ok;
+		if (err_ok == run_status.error) {
+			status.error	= err_ok;
+			status.count	+= run_status.count;
+		}
+		else if (err_item_not_found != run_status.error) {
+			return run_status;
 		}
 	}
 
 	return status;
 }
 
+ion_sl_node_t *
+sl_lower_bound(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key
+) {
+	return sl_search(skiplist, key)->next[0];
+}
+
 ion_sl_node_t *
 sl_find_node(
 	ion_skiplist_t	*skiplist,
 	ion_key_t		key
 ) {
 	int				key_size	= skiplist->super.record.key_size;
-	ion_sl_node_t	*cursor		= skiplist->head;
-	ion_sl_level_t	h;
-
-	for (h = skiplist->head->height; h >= 0; h--) {
-		/* TODO Step through this and verify its integrity for all cases */
-		while (NULL != cursor->next[h] && skiplist->super.compare(cursor->next[h]->key, key, key_size) <= 0) {
-			if ((NULL != cursor->next[h]) && (skiplist->super.compare(cursor->next[h]->key, key, key_size) == 0)) {
-				return cursor->next[h];
-			}
+	ion_sl_node_t	*cursor		= sl_search(skiplist, key);
 
-			cursor = cursor->next[h];
-		}
+	if ((NULL != cursor->next[0]) && (skiplist->super.compare(cursor->next[0]->key, key, key_size) == 0)) {
+		return cursor->next[0];
 	}
 
 	/* Key was not found, so return closest thing to that key */
 	return cursor;
 }
 
+/**
+@brief		Draws the next word from the xorshift generator of a skiplist.
+*/
+static uint32_t
+sl_next_random(
+	ion_skiplist_t *skiplist
+) {
+	uint32_t x = skiplist->rng;
+
+	x				^= x << 13;
+	x				^= x >> 17;
+	x				^= x << 5;
+	skiplist->rng	= x;
+
+	return x;
+}
+
+void
+sl_seed(
+	ion_skiplist_t	*skiplist,
+	uint32_t		seed
+) {
+	skiplist->rng = (0 == seed) ? ION_SL_DEFAULT_SEED : seed;
+}
+
 ion_sl_level_t
 sl_gen_level(
 	ion_skiplist_t *skiplist
 ) {
-	ion_sl_level_t level = 1;
+	ion_sl_level_t level;
+
+	if (0 != skiplist->level_bits) {
+		/* each level is as likely as its bits all being 0; the top bit keeps the word from being 0 */
+		level = __builtin_ctzl((unsigned long) (sl_next_random(skiplist) | 0x80000000UL)) / skiplist->level_bits;
+
+		return (level < skiplist->maxheight) ? level : skiplist->maxheight - 1;
+	}
+
+	uint32_t threshold = (uint32_t) skiplist->pnum * (UINT32_MAX / (uint32_t) skiplist->pden);
+
+	level = 1;
 
-	while ((rand() < skiplist->pnum * (RAND_MAX / skiplist->pden)) && level < skiplist->maxheight) {
+	while ((sl_next_random(skiplist) < threshold) && level < skiplist->maxheight) {
 		level++;
 	}
 
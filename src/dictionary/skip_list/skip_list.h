@@ -27,7 +27,10 @@ extern "C" {
 @param	  value_size
 				Size of value in bytes.
 @param	  maxheight
-				Maximum number of levels the skiplist will have.
+				Maximum number of levels the skiplist will have, or 0 to
+				start at @ref ION_SL_AUTO_HEIGHT_START and add a level each
+				time the nodes grow 1/p times, up to
+				@ref ION_SL_AUTO_HEIGHT_LIMIT.
 @param	  pnum
 				The numerator portion of the p value.
 @param	  pden
@@ -48,7 +51,8 @@ sl_initialize(
 /**
 @brief	  Destroys the skiplist in memory.
 
-@details	Destroys the skiplist in memory and frees the underlying structures.
+@details	Destroys the skiplist in memory and frees the underlying structures,
+			the blocks its nodes were carved from, in one pass.
 
 @param	  skiplist
 				The skiplist to be destroyed
@@ -59,6 +63,62 @@ sl_destroy(
 	ion_skiplist_t *skiplist
 );
 
+/**
+@brief	  Caps the memory the nodes of a skiplist may take.
+
+@details	Once the arena would grow past @p budget bytes, the records are
+			written in order to a new B+ tree run and memory starts afresh.
+			Queries, updates and deletes then reach the runs as well. Open
+			cursors do not survive a spill. The runs are never merged.
+
+@param	  skiplist
+				The skiplist to cap, before anything has spilled.
+@param	  budget
+				The most bytes of arena to keep, or 0 for no cap.
+@param	  first_run_id
+				The dictionary id of the first run, the next ones following
+				it. They must not be used by any other dictionary.
+@return	 Status of setting the budget.
+*/
+ion_err_t
+sl_set_budget(
+	ion_skiplist_t		*skiplist,
+	size_t				budget,
+	ion_dictionary_id_t first_run_id
+);
+
+/**
+@brief	  Reads the shape of a skiplist and the cost of its searches.
+
+@details	The node count and heights cover the nodes in memory, read off
+			its bottom level, while the search counters cover the searches
+			since the skiplist was initialized or last reset.
+
+@param	  skiplist
+				The skiplist to read.
+@param	  stats
+				Filled with the statistics.
+@return	 Status of the call.
+*/
+ion_err_t
+sl_stats(
+	ion_skiplist_t	*skiplist,
+	ion_sl_stats_t	*stats
+);
+
+/**
+@brief	  Starts a new measurement period for the search counters of a
+			skiplist.
+
+@param	  skiplist
+				The skiplist to reset.
+@return	 Status of the call.
+*/
+ion_err_t
+sl_reset_stats(
+	ion_skiplist_t *skiplist
+);
+
 /**
 @brief	  Inserts a @p key @p value pair into the skiplist.
 
@@ -81,6 +141,69 @@ sl_insert(
 	ion_value_t		value
 );
 
+/**
+@brief	  Supplies records to @ref sl_bulk_load.
+@param	  context
+				The context given to @ref sl_bulk_load.
+@param	  record
+				Key and value buffers, sized for the skiplist, to fill with
+				the next record. Records must come in ascending key order.
+@return	 @ref err_ok if @p record was filled, @ref err_item_not_found once
+			there are no more records, or any other error to abort the load.
+*/
+typedef ion_err_t (*ion_sl_bulk_next_t)(
+	void			*context,
+	ion_record_t	*record
+);
+
+/**
+@brief	  Builds an empty skiplist from sorted records in one pass.
+
+@details	Each record is read straight into a new node, which is linked
+			after the last node of each of its levels, so no search is made.
+			Duplicate keys are kept. If the skiplist has a budget, it spills
+			as inserts would.
+
+@param	  skiplist
+				The empty skiplist to build.
+@param	  next
+				Called for each record in turn.
+@param	  context
+				Passed through to @p next.
+@param	  deterministic
+				Whether to give the nodes evenly spaced heights, a node every
+				pden/pnum nodes one level taller, instead of random ones.
+@return	 Status of the load; the count is the number of records loaded,
+			which stay if the load fails part way.
+*/
+ion_status_t
+sl_bulk_load(
+	ion_skiplist_t		*skiplist,
+	ion_sl_bulk_next_t	next,
+	void				*context,
+	ion_boolean_t		deterministic
+);
+
+/**
+@brief		Points at the value stored at the given @p key, in its node.
+
+@param		skiplist
+				The skiplist in which to query.
+@param		key
+				The key to be found.
+@param		value
+				Receives a pointer to the value, valid until the next insert,
+				update or delete.
+@return		Status of query, @c err_not_implemented if the key is not in
+			memory but may be in a run spilled to disk.
+*/
+ion_status_t
+sl_get_ref(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key,
+	ion_value_t		*value
+);
+
 /**
 @brief	  Requests the @p value stored at the given @p key.
 
@@ -106,7 +229,7 @@ sl_query(
 @brief	  Updates the value stored at @p key with the new @p value.
 
 @details	Updates the value stored at @p key with the new @p value. The given
-			value is copied byte-for-byte into the malloc'd memory already
+			value is copied byte-for-byte into the memory already
 			stored at the key. If the @p key does not exist within the skiplist,
 			the key/value pair is inserted into the skiplist instead.
 
@@ -130,8 +253,9 @@ sl_update(
 
 @details	Attempts to delete all key/value pairs stored at the given @p key.
 			Returns "err_item_not_found" if the requested @p key is not in
-			the skiplist, and "err_ok" if the deletion was successful. Any
-			memory previously used for the deleted key/value pair(s) is freed.
+			the skiplist, and "err_ok" if the deletion was successful. The
+			nodes of the deleted key/value pair(s) are kept for reuse by
+			later inserts, and freed with the skiplist.
 
 @param	  skiplist
 				The skiplist in which to delete from
@@ -145,6 +269,24 @@ sl_delete(
 	ion_key_t		key
 );
 
+/**
+@brief		Finds the first node whose key is not less than @p key.
+
+@details	One descent of the towers, from the finger of the skiplist,
+			so a range of @c k records is read in O(log n + k).
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search from.
+@return		The node, or @c NULL if every key is less than @p key.
+*/
+ion_sl_node_t *
+sl_lower_bound(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key
+);
+
 /**
 @brief	  Searches for a node with the given @p key. Used in conjunction with
 			sl_query to perform key lookups.
@@ -173,9 +315,28 @@ print_skiplist(
 );
 
 /**
-@brief	  Generates a psuedo-random height, bounded within [0, maxheight). The
-			generator is seeded using the current epoch time when the skiplist
-			is initialized.
+@brief	  Restarts the level generator of a skiplist from @p seed, so the
+			heights of the nodes inserted from then on can be reproduced.
+
+@param	  skiplist
+				The skiplist whose generator to seed
+@param	  seed
+				The state to start from. 0, which the generator cannot leave,
+				stands for @ref ION_SL_DEFAULT_SEED.
+*/
+void
+sl_seed(
+	ion_skiplist_t	*skiplist,
+	uint32_t		seed
+);
+
+/**
+@brief	  Generates a psuedo-random height, bounded within [0, maxheight), from
+			the skiplist's own generator.
+
+@details	When p is 1/2 or 1/4, the height is the number of trailing zero bits,
+			or pairs of bits, of a single random word. Otherwise one word is drawn
+			per level.
 
 @param	  skiplist
 				The skiplist to read level generation parameters from
@@ -7,6 +7,7 @@
 /******************************************************************************/
 
 #include "skip_list_handler.h"
+#include "../dictionary.h"
 
 /**
 @brief	  Queries a dictionary instance for a given @p key and returns the
@@ -37,6 +38,110 @@ sldict_query(
 	return sl_query((ion_skiplist_t *) dictionary->instance, key, value);
 }
 
+/**
+@brief		Points at the value of a key, for @ref dictionary_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		Status of query, see @ref sl_get_ref.
+*/
+ion_status_t
+sldict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return sl_get_ref((ion_skiplist_t *) dictionary->instance, key, value);
+}
+
+/**
+@brief	  Gives the first node from @p node on that a predicate cursor's
+			filter passes, testing each where it is held. Other cursors get
+			@p node back.
+*/
+static ion_sl_node_t *
+sldict_filter_from(
+	ion_dict_cursor_t	*cursor,
+	ion_sl_node_t		*node
+) {
+	if (predicate_predicate == cursor->predicate->type) {
+		while ((NULL != node) && (boolean_false == test_record_predicate(cursor, node->key, node->value))) {
+			node = node->next[0];
+		}
+	}
+
+	return node;
+}
+
+/**
+@brief	  Moves the cursor over a run on to its next record.
+*/
+static void
+sldict_advance_run(
+	ion_sldict_cursor_t *sl_cursor,
+	int					run
+) {
+	ion_record_info_t	*info	= &sl_cursor->super.dictionary->instance->record;
+	ion_dict_cursor_t	*cursor = sl_cursor->run_cursors[run];
+	ion_record_t		record;
+
+	record.key				= sl_cursor->run_records + run * (info->key_size + info->value_size);
+	record.value			= (ion_byte_t *) record.key + info->key_size;
+	sl_cursor->run_valid[run] = cs_cursor_active == cursor->next(cursor, &record);
+}
+
+/**
+@brief	  Reads the smallest record left among the nodes in memory and
+			the runs, those in memory first and then the newest run on
+			equal keys.
+*/
+static ion_cursor_status_t
+sldict_next_merged(
+	ion_sldict_cursor_t *sl_cursor,
+	ion_record_t		*record
+) {
+	ion_dictionary_parent_t *parent = sl_cursor->super.dictionary->instance;
+	ion_key_t				key		= NULL;
+	int						from	= -1;
+	int						i;
+	ion_byte_t				*run_record;
+
+	if (NULL != sl_cursor->current) {
+		key = sl_cursor->current->key;
+	}
+
+	for (i = sl_cursor->run_count - 1; i >= 0; i--) {
+		run_record = sl_cursor->run_records + i * (parent->record.key_size + parent->record.value_size);
+
+		if (sl_cursor->run_valid[i] && ((NULL == key) || (parent->compare(run_record, key, parent->record.key_size) < 0))) {
+			key		= run_record;
+			from	= i;
+		}
+	}
+
+	if (NULL == key) {
+		sl_cursor->super.status = cs_end_of_results;
+		return sl_cursor->super.status;
+	}
+
+	if (-1 == from) {
+		memcpy(record->key, sl_cursor->current->key, parent->record.key_size);
+		memcpy(record->value, sl_cursor->current->value, parent->record.value_size);
+		sl_cursor->current = sldict_filter_from(&sl_cursor->super, sl_cursor->current->next[0]);
+	}
+	else {
+		memcpy(record->key, key, parent->record.key_size);
+		memcpy(record->value, (ion_byte_t *) key + parent->record.key_size, parent->record.value_size);
+		sldict_advance_run(sl_cursor, from);
+	}
+
+	return sl_cursor->super.status;
+}
+
 /**
 @brief	  Next function queries and retrieves the next key/value pair that
 			satisfies the predicate of the cursor.
@@ -64,7 +169,30 @@ sldict_next(
 	}
 	else if ((cursor->status == cs_cursor_initialized) || (cursor->status == cs_cursor_active)) {
 		if (cursor->status == cs_cursor_active) {
-			if ((NULL == sl_cursor->current) || (test_predicate(cursor, sl_cursor->current->key) == boolean_false)) {
+			ion_boolean_t in_range = boolean_false;
+
+			if (NULL == sl_cursor->current) {
+				in_range = boolean_false;
+			}
+			else if (predicate_range == cursor->predicate->type) {
+				/* Records follow the first one in order, so only the upper bound can end a range */
+				in_range = cursor->dictionary->instance->compare(sl_cursor->current->key, cursor->predicate->statement.range.upper_bound, cursor->dictionary->instance->record.key_size) <= 0;
+			}
+			else if (predicate_predicate == cursor->predicate->type) {
+				/* The nodes the filter fails were passed over as the cursor moved */
+				in_range = boolean_true;
+			}
+			else {
+				in_range = test_predicate(cursor, sl_cursor->current->key);
+			}
+
+			if (NULL != sl_cursor->run_cursors) {
+				/* The runs may still hold records in range */
+				if (boolean_false == in_range) {
+					sl_cursor->current = NULL;
+				}
+			}
+			else if (boolean_false == in_range) {
 				cursor->status = cs_end_of_results;
 				return cursor->status;
 			}
@@ -74,11 +202,15 @@ sldict_next(
 			cursor->status = cs_cursor_active;
 		}
 
+		if (NULL != sl_cursor->run_cursors) {
+			return sldict_next_merged(sl_cursor, record);
+		}
+
 		/*Copy both key and value into user provided struct */
 		memcpy(record->key, sl_cursor->current->key, cursor->dictionary->instance->record.key_size);
 		memcpy(record->value, sl_cursor->current->value, cursor->dictionary->instance->record.value_size);
 
-		sl_cursor->current = sl_cursor->current->next[0];
+		sl_cursor->current = sldict_filter_from(cursor, sl_cursor->current->next[0]);
 		return cursor->status;
 	}
 
@@ -115,11 +247,60 @@ void
 sldict_destroy_cursor(
 	ion_dict_cursor_t **cursor
 ) {
+	ion_sldict_cursor_t *sl_cursor = (ion_sldict_cursor_t *) *cursor;
+	int					i;
+
+	for (i = 0; NULL != sl_cursor->run_cursors && i < sl_cursor->run_count; i++) {
+		if (NULL != sl_cursor->run_cursors[i]) {
+			sl_cursor->run_cursors[i]->destroy(&sl_cursor->run_cursors[i]);
+		}
+	}
+
+	ion_free(sl_cursor->run_cursors);
+	ion_free(sl_cursor->run_records);
+	ion_free(sl_cursor->run_valid);
 	(*cursor)->predicate->destroy(&(*cursor)->predicate);
-	free(*cursor);
+	ion_free(*cursor);
 	*cursor = NULL;
 }
 
+/**
+@brief	  Opens a cursor with the same predicate over each run of a
+			skiplist, each on its first record.
+*/
+static ion_err_t
+sldict_find_runs(
+	ion_sldict_cursor_t *sl_cursor,
+	ion_skiplist_t		*skip_list
+) {
+	ion_record_info_t	*info = &skip_list->super.record;
+	ion_err_t			err;
+	int					i;
+
+	sl_cursor->run_cursors	= ion_calloc(ion_alloc_cursor, skip_list->run_count, sizeof(ion_dict_cursor_t *));
+	sl_cursor->run_records	= ion_alloc(ion_alloc_cursor, skip_list->run_count * (info->key_size + info->value_size));
+	sl_cursor->run_valid	= ion_calloc(ion_alloc_cursor, skip_list->run_count, sizeof(ion_boolean_t));
+
+	if ((NULL == sl_cursor->run_cursors) || (NULL == sl_cursor->run_records) || (NULL == sl_cursor->run_valid)) {
+		return err_out_of_memory;
+	}
+
+	sl_cursor->run_count = skip_list->run_count;
+
+	for (i = 0; i < skip_list->run_count; i++) {
+		err = dictionary_find(&skip_list->runs[i], sl_cursor->super.predicate, &sl_cursor->run_cursors[i]);
+
+		if (err_ok != err) {
+			sl_cursor->run_cursors[i] = NULL;
+			return err;
+		}
+
+		sldict_advance_run(sl_cursor, i);
+	}
+
+	return err_ok;
+}
+
 /**
 @brief	  Finds multiple keys based on the provided predicate.
 
@@ -142,7 +323,7 @@ sldict_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
-	*cursor = malloc(sizeof(ion_sldict_cursor_t));
+	*cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_sldict_cursor_t));
 
 	ion_skiplist_t *skip_list = (ion_skiplist_t *) dictionary->instance;
 
@@ -150,16 +331,25 @@ sldict_find(
 		return err_out_of_memory;
 	}
 
+	ion_sldict_cursor_t *sl_cursor = (ion_sldict_cursor_t *) (*cursor);
+
+	sl_cursor->current		= NULL;
+	sl_cursor->run_count	= 0;
+	sl_cursor->run_cursors	= NULL;
+	sl_cursor->run_records	= NULL;
+	sl_cursor->run_valid	= NULL;
+
 	(*cursor)->dictionary	= dictionary;
 	(*cursor)->status		= cs_cursor_uninitialized;
 
 	(*cursor)->destroy		= sldict_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
 	(*cursor)->next			= sldict_next;
 
-	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
+	(*cursor)->predicate	= ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t));
 
 	if (NULL == (*cursor)->predicate) {
-		free(*cursor);
+		ion_free(*cursor);
 		return err_out_of_memory;
 	}
 
@@ -173,11 +363,11 @@ sldict_find(
 			/* TODO get ALL these lines within 80 cols */
 			ion_key_t target_key = predicate->statement.equality.equality_value;
 
-			(*cursor)->predicate->statement.equality.equality_value = malloc(key_size);
+			(*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.equality.equality_value) {
-				free((*cursor)->predicate);
-				free(*cursor);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
@@ -185,101 +375,54 @@ sldict_find(
 
 			ion_sl_node_t *loc = sl_find_node((ion_skiplist_t *) dictionary->instance, target_key);
 
-			if ((NULL == loc->key) || (dictionary->instance->compare(loc->key, target_key, key_size) != 0)) {
-				/* If this happens, that means the target key doesn't exist */
-				(*cursor)->status = cs_end_of_results;
-				return err_ok;
-			}
-			else {
-				(*cursor)->status = cs_cursor_initialized;
-
-				ion_sldict_cursor_t *sl_cursor = (ion_sldict_cursor_t *) (*cursor);
-
+			/* Unless the key is there, nothing in memory matches */
+			if ((NULL != loc->key) && (dictionary->instance->compare(loc->key, target_key, key_size) == 0)) {
 				sl_cursor->current = loc;
-				return err_ok;
 			}
 
 			break;
 		}
 
 		case predicate_range: {
-			(*cursor)->predicate->statement.range.lower_bound = malloc(key_size);
+			(*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.lower_bound) {
-				free((*cursor)->predicate);
-				free(*cursor);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
 			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
 
-			(*cursor)->predicate->statement.range.upper_bound = malloc(key_size);
+			(*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.upper_bound) {
-				free((*cursor)->predicate->statement.range.lower_bound);
-				free((*cursor)->predicate);
-				free(*cursor);
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
 				return err_out_of_memory;
 			}
 
 			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
 
-			/* Try to find the node containing the upper bound. */
-			ion_sl_node_t *loc = sl_find_node((ion_skiplist_t *) dictionary->instance, (*cursor)->predicate->statement.range.upper_bound);
-
-			if ((NULL == loc->key) || (dictionary->instance->compare(loc->key, (*cursor)->predicate->statement.range.lower_bound, key_size) < 0)) {
-				/* This means the returned node is smaller than the lower bound, which means that there are no valid records to return */
-				(*cursor)->status = cs_end_of_results;
-				return err_ok;
-			}
-			else {
-				loc = sl_find_node((ion_skiplist_t *) dictionary->instance, (*cursor)->predicate->statement.range.lower_bound);
-
-				if (NULL == loc->key) {
-					/* If this happens, then we hit the head node. Just move to the first valid data item (if exists) */
-					loc = loc->next[0];
-				}
-
-				/* Increment the location until we hit valid data. It is impossible to fall through here, since we just confirmed previously */
-				/* that there does indeed exist valid data (See above check). */
-				while (NULL != loc && (dictionary->instance->compare(loc->key, (*cursor)->predicate->statement.range.lower_bound, key_size) < 0)) {
-					loc = loc->next[0];
-				}
-
-				/* We sanity check this anyways just in case. */
-				if (NULL == loc) {
-					(*cursor)->status = cs_end_of_results;
-					return err_ok;
-				}
-
-				(*cursor)->status = cs_cursor_initialized;
-
-				ion_sldict_cursor_t *sl_cursor = (ion_sldict_cursor_t *) (*cursor);
+			/* Straight down the towers to the first key in range */
+			ion_sl_node_t *loc = sl_lower_bound((ion_skiplist_t *) dictionary->instance, (*cursor)->predicate->statement.range.lower_bound);
 
+			if ((NULL != loc) && (dictionary->instance->compare(loc->key, (*cursor)->predicate->statement.range.upper_bound, key_size) <= 0)) {
 				sl_cursor->current = loc;
-				return err_ok;
 			}
 
 			break;
 		}
 
 		case predicate_all_records: {
-			ion_sldict_cursor_t *sl_cursor = (ion_sldict_cursor_t *) (*cursor);
-
-			if (NULL == skip_list->head->next[0]) {
-				(*cursor)->status = cs_end_of_results;
-			}
-			else {
-				sl_cursor->current	= skip_list->head->next[0];
-				(*cursor)->status	= cs_cursor_initialized;
-			}
-
-			return err_ok;
+			sl_cursor->current = skip_list->head->next[0];
 			break;
 		}
 
 		case predicate_predicate: {
-			/* TODO not implemented */
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			sl_cursor->current								= sldict_filter_from(*cursor, skip_list->head->next[0]);
 			break;
 		}
 
@@ -289,6 +432,28 @@ sldict_find(
 		}
 	}
 
+	(*cursor)->status = cs_cursor_initialized;
+
+	if (0 != skip_list->run_count) {
+		ion_err_t	err = sldict_find_runs(sl_cursor, skip_list);
+		int			i;
+
+		if (err_ok != err) {
+			sldict_destroy_cursor(cursor);
+			return err;
+		}
+
+		for (i = 0; i < sl_cursor->run_count; i++) {
+			if (sl_cursor->run_valid[i]) {
+				return err_ok;
+			}
+		}
+	}
+
+	if (NULL == sl_cursor->current) {
+		(*cursor)->status = cs_end_of_results;
+	}
+
 	return err_ok;
 }
 
@@ -321,6 +486,65 @@ sldict_open_dictionary(
 	return err_not_implemented;
 }
 
+/**
+@brief		Tells the size of a skiplist dictionary, see
+			@ref dictionary_get_info. What was spilled to runs is not
+			counted, nor are the bounds given while there are any.
+*/
+static ion_err_t
+sldict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_skiplist_t	*skiplist	= (ion_skiplist_t *) dictionary->instance;
+	int				key_size	= skiplist->super.record.key_size;
+	ion_sl_node_t	*cursor;
+	ion_sl_level_t	h;
+
+	info->memory_bytes = (long) skiplist->arena_total;
+
+	if (0 != skiplist->run_count) {
+		return err_ok;
+	}
+
+	info->record_count	= (long) skiplist->count;
+	info->file_bytes	= 0;
+	info->ordered		= boolean_true;
+
+	if ((NULL == skiplist->head->next[0]) || (NULL == info->min_key) || (NULL == info->max_key)) {
+		return err_ok;
+	}
+
+	memcpy(info->min_key, skiplist->head->next[0]->key, key_size);
+
+	/* the last node is found down the towers, as a search past the end */
+	cursor = skiplist->head;
+
+	for (h = skiplist->head->height; h >= 0; h--) {
+		while (NULL != cursor->next[h]) {
+			cursor = cursor->next[h];
+		}
+	}
+
+	memcpy(info->max_key, cursor->key, key_size);
+	info->has_bounds = boolean_true;
+
+	return err_ok;
+}
+
+/**
+@brief		Builds an empty skiplist dictionary from records in ascending
+			key order, see @ref sl_bulk_load.
+*/
+static ion_status_t
+sldict_bulk_load(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_bulk_next_t	next,
+	void						*context
+) {
+	return sl_bulk_load((ion_skiplist_t *) dictionary->instance, next, context, boolean_false);
+}
+
 void
 sldict_init(
 	ion_dictionary_handler_t *handler
@@ -334,6 +558,13 @@ sldict_init(
 	handler->find				= sldict_find;
 	handler->close_dictionary	= sldict_close_dictionary;
 	handler->open_dictionary	= sldict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= sldict_get_ref;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= sldict_get_info;
+	handler->bulk_load			= sldict_bulk_load;
 }
 
 ion_status_t
@@ -356,11 +587,9 @@ sldict_create_dictionary(
 	ion_dictionary_handler_t	*handler,
 	ion_dictionary_t			*dictionary
 ) {
-	UNUSED(id);
-
 	int pnum, pden;
 
-	dictionary->instance = malloc(sizeof(ion_skiplist_t));
+	dictionary->instance = ion_alloc(ion_alloc_other, sizeof(ion_skiplist_t));
 
 	if (NULL == dictionary->instance) {
 		return err_out_of_memory;
@@ -377,6 +606,7 @@ sldict_create_dictionary(
 
 	if (err_ok == result) {
 		dictionary->handler = handler;
+		result				= sl_set_budget((ion_skiplist_t *) dictionary->instance, ION_SL_MEMORY_BUDGET, ION_SL_RUN_ID_BASE + id * ION_SL_RUN_IDS);
 	}
 
 	return result;
@@ -396,7 +626,7 @@ sldict_delete_dictionary(
 ) {
 	ion_err_t result = sl_destroy((ion_skiplist_t *) dictionary->instance);
 
-	free(dictionary->instance);
+	ion_free(dictionary->instance);
 	dictionary->instance = NULL;
 	return result;
 }
@@ -409,3 +639,18 @@ sldict_update(
 ) {
 	return sl_update((ion_skiplist_t *) dictionary->instance, key, value);
 }
+
+ion_err_t
+sldict_stats(
+	ion_dictionary_t	*dictionary,
+	ion_sl_stats_t		*stats
+) {
+	return sl_stats((ion_skiplist_t *) dictionary->instance, stats);
+}
+
+ion_err_t
+sldict_reset_stats(
+	ion_dictionary_t *dictionary
+) {
+	return sl_reset_stats((ion_skiplist_t *) dictionary->instance);
+}
@@ -65,6 +65,8 @@ sldict_insert(
 @param	  value_size
 				Size of the value in bytes.
 @param		dictionary_size
+				The maximum height of the skiplist, or 0 to have it grow
+				with the records.
 @param		compare
 @param	  handler
 				Handler to be bound to the dictionary instance being created.
@@ -136,6 +138,34 @@ sldict_update(
 	ion_value_t			value
 );
 
+/**
+@brief		Reads the shape and search statistics of a skiplist
+			dictionary, see @ref sl_stats.
+
+@param		dictionary
+				A skiplist dictionary.
+@param		stats
+				Filled with the statistics.
+@return		The status of the call.
+*/
+ion_err_t
+sldict_stats(
+	ion_dictionary_t	*dictionary,
+	ion_sl_stats_t		*stats
+);
+
+/**
+@brief		Starts a new measurement period for a skiplist dictionary.
+
+@param		dictionary
+				A skiplist dictionary.
+@return		The status of the call.
+*/
+ion_err_t
+sldict_reset_stats(
+	ion_dictionary_t *dictionary
+);
+
 #if defined(__cplusplus)
 }
 #endif
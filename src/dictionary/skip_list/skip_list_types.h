@@ -20,8 +20,89 @@ extern "C" {
 
 typedef int ion_sl_level_t;	/**< Height of a skiplist */
 
+/**
+@brief		The size in bytes of the blocks a skiplist carves its nodes
+			from. Each node, with its tower of links, key and value, is
+			one piece of a block, and destroying the skiplist frees the
+			blocks rather than the nodes. A node too large for a block
+			gets a block of its own.
+*/
+#if !defined(ION_SL_ARENA_BLOCK_SIZE)
+#if defined(ARDUINO)
+#define ION_SL_ARENA_BLOCK_SIZE 256
+#else
+#define ION_SL_ARENA_BLOCK_SIZE 4096
+#endif
+#endif
+
+/**
+@brief		How many bytes of nodes a skiplist created through the handler
+			may hold before it spills them to a run on disk, 0 for no
+			limit. See @ref sl_set_budget.
+*/
+#if !defined(ION_SL_MEMORY_BUDGET)
+#define ION_SL_MEMORY_BUDGET 0
+#endif
+
+/**
+@brief		The dictionary ids set aside for the runs of each skiplist
+			created through the handler. The runs of dictionary @c id are
+			numbered from @ref ION_SL_RUN_ID_BASE plus @c id times this.
+*/
+#if !defined(ION_SL_RUN_IDS)
+#define ION_SL_RUN_IDS 256
+#endif
+
+/**
+@brief		The first dictionary id given to runs of skiplists created
+			through the handler.
+*/
+#if !defined(ION_SL_RUN_ID_BASE)
+#define ION_SL_RUN_ID_BASE 0x10000
+#endif
+
+/**
+@brief		The state every skiplist's level generator starts from, so
+			that runs are reproducible unless @ref sl_seed is given
+			another.
+*/
+#if !defined(ION_SL_DEFAULT_SEED)
+#define ION_SL_DEFAULT_SEED 0x9E3779B9UL
+#endif
+
+/**
+@brief		The height a skiplist initialized with a @c maxheight of 0 starts
+			at, before it has grown.
+*/
+#if !defined(ION_SL_AUTO_HEIGHT_START)
+#define ION_SL_AUTO_HEIGHT_START 4
+#endif
+
+/**
+@brief		The most a skiplist initialized with a @c maxheight of 0 grows
+			to, which sizes its head.
+*/
+#if !defined(ION_SL_AUTO_HEIGHT_LIMIT)
+#if defined(ARDUINO)
+#define ION_SL_AUTO_HEIGHT_LIMIT 12
+#else
+#define ION_SL_AUTO_HEIGHT_LIMIT 32
+#endif
+#endif
+
+/**
+@brief		How many heights the level histogram of @ref ion_sl_stats_t
+			tells apart.
+*/
+#if !defined(ION_SL_STATS_LEVELS)
+#define ION_SL_STATS_LEVELS 16
+#endif
+
 /**
 @brief  Struct of a node in the skiplist.
+@details	The key, the tower of @p next links and the value follow the
+			node in that order, in the same piece of memory, so a hop reads
+			the key and the link it may take next from the lines it lands on.
 */
 typedef struct sl_node {
 	ion_key_t		key;		/**< Key of a skiplist node */
@@ -46,12 +127,73 @@ typedef struct skiplist {
 										the number of nodes */
 	int						pnum;	/**< Probability NUMerator, used in height gen */
 	int						pden;	/**< Probability DENominator, used in height gen */
+	int						level_bits;	/**< How many random bits each level
+										costs when p is 1/2 or 1/4, so a height
+										is read off one word, else 0 */
+	uint32_t				rng;	/**< The xorshift state heights are drawn
+									from, never 0 */
+	ion_byte_t				*arena;	/**< The block nodes are being carved from,
+									whose first bytes link to the block before it */
+	size_t					arena_used;	/**< How many bytes of @p arena are carved */
+	size_t					arena_size;	/**< How many bytes @p arena holds */
+	ion_sl_node_t			**free_nodes;	/**< Per height, the nodes deleted and
+											ready for reuse, linked through
+											their bottom link */
+	ion_sl_node_t			**finger;	/**< Per height, the last node before
+										the key searched last, where the next
+										search starts from */
+	size_t					arena_total;	/**< How many bytes of blocks the
+											arena holds */
+	size_t					budget;	/**< How many bytes the arena may hold
+									before the nodes are spilled, 0 for no
+									limit */
+	ion_dictionary_id_t		run_id;	/**< The id of the first run */
+	int						run_count;	/**< How many runs have been spilled */
+	ion_dictionary_t		*runs;	/**< The spilled runs, oldest first, each a
+									B+ tree bulk loaded in key order */
+	ion_dictionary_handler_t run_handler;	/**< The handler of the runs */
+	ion_byte_t				*run_value;	/**< Room for a value read from a run */
+	ion_sl_level_t			capacity;	/**< The tallest the head, finger and
+										free lists have room for */
+	ion_boolean_t			auto_height;	/**< Whether @p maxheight grows
+											with the number of nodes */
+	unsigned long			grow_at;	/**< The number of nodes at which an
+										automatic @p maxheight next grows */
+	unsigned long			count;	/**< How many nodes are in memory */
+	unsigned long			searches;	/**< Searches since the skiplist was
+										initialized or its stats reset */
+	unsigned long			hops;	/**< Links those searches followed */
 } ion_skiplist_t;
 
+/**
+@brief		The shape of a skiplist and the cost of its searches, see
+			@ref sl_stats.
+*/
+typedef struct {
+	unsigned long	nodes;		/**< Nodes in memory */
+	unsigned long	levels[ION_SL_STATS_LEVELS];	/**< Bin i counts the nodes of
+												 height index i, the last bin
+												 all taller ones */
+	ion_sl_level_t	maxheight;	/**< The current maximum height */
+	size_t			bytes;		/**< Bytes of arena the nodes are in */
+	int				runs;		/**< Runs spilled to disk */
+	unsigned long	searches;	/**< Searches counted */
+	unsigned long	hops;		/**< Links they followed, divided by
+								 @p searches the average hops per search */
+} ion_sl_stats_t;
+
 typedef struct
 	sldict_cursor {
 	ion_dict_cursor_t	super;			/**< Supertype of cursor */
 	ion_sl_node_t		*current;		/**< Current visited spot */
+	int					run_count;		/**< How many runs there were when
+										the cursor was made */
+	ion_dict_cursor_t	**run_cursors;	/**< A cursor over each of those
+										runs, or @c NULL without runs */
+	ion_byte_t			*run_records;	/**< The record each run cursor is
+										on, key then value */
+	ion_boolean_t		*run_valid;		/**< Whether each run cursor is on a
+										record */
 } ion_sldict_cursor_t;
 
 #if defined(__cplusplus)
@@ -0,0 +1,440 @@
+/******************************************************************************/
+/**
+@file
+@brief		Implementation of the unrolled skiplist.
+*/
+/******************************************************************************/
+
+#include "unrolled_skip_list.h"
+
+/**
+@brief		The bytes of a record, its key then its value.
+*/
+#define ION_USL_RECORD_SIZE(skiplist) ((skiplist)->super.record.key_size + (skiplist)->super.record.value_size)
+
+/**
+@brief		The bytes of a node with a tower of @p height and room for
+			@p records records.
+*/
+#define ION_USL_NODE_BYTES(skiplist, height, records) (sizeof(ion_usl_node_t) + sizeof(ion_usl_node_t *) * ((height) + 1) + (records) * ION_USL_RECORD_SIZE(skiplist))
+
+ion_byte_t *
+usl_record(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_usl_node_t			*node,
+	int						index
+) {
+	return (ion_byte_t *) &node->next[node->height + 1] + index * ION_USL_RECORD_SIZE(skiplist);
+}
+
+/**
+@brief		Allocates a node with room for a tower of @p height and
+			@p records records, holding none yet.
+*/
+static ion_usl_node_t *
+usl_new_node(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_sl_level_t			height,
+	int						records
+) {
+	ion_usl_node_t *node = ion_alloc(ion_alloc_node, ION_USL_NODE_BYTES(skiplist, height, records));
+
+	if (NULL != node) {
+		node->height	= (uint8_t) height;
+		node->count		= 0;
+		skiplist->bytes	+= ION_USL_NODE_BYTES(skiplist, height, records);
+	}
+
+	return node;
+}
+
+/**
+@brief		Draws the height of a new node.
+*/
+static ion_sl_level_t
+usl_gen_level(
+	ion_unrolled_skiplist_t *skiplist
+) {
+	uint32_t		threshold	= (uint32_t) skiplist->pnum * (UINT32_MAX / (uint32_t) skiplist->pden);
+	ion_sl_level_t	level		= 0;
+	uint32_t		x;
+
+	while (level < skiplist->maxheight - 1) {
+		x				= skiplist->rng;
+		x				^= x << 13;
+		x				^= x >> 17;
+		x				^= x << 5;
+		skiplist->rng	= x;
+
+		if (x >= threshold) {
+			break;
+		}
+
+		level++;
+	}
+
+	return level;
+}
+
+/**
+@brief		The position of the first record of a node whose key is not less
+			than, or if @p after is set greater than, @p key.
+*/
+static int
+usl_position(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_usl_node_t			*node,
+	ion_key_t				key,
+	ion_boolean_t			after
+) {
+	int low		= 0;
+	int high	= node->count;
+	int middle;
+	int cmp;
+
+	while (low < high) {
+		middle	= (low + high) / 2;
+		cmp		= skiplist->super.compare(usl_record(skiplist, node, middle), key, skiplist->super.record.key_size);
+
+		if ((cmp < 0) || (after && (0 == cmp))) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+/**
+@brief		Finds, on each level, the last node whose first key is less than
+			@p key, and keeps them in the path of the skiplist.
+@return		The one on the bottom level, possibly the head.
+*/
+static ion_usl_node_t *
+usl_search(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key
+) {
+	ion_usl_node_t	*cursor = skiplist->head;
+	ion_usl_node_t	*next;
+	ion_sl_level_t	h;
+
+	for (h = skiplist->head->height; h >= 0; h--) {
+		while (NULL != (next = cursor->next[h]) && skiplist->super.compare(usl_record(skiplist, next, 0), key, skiplist->super.record.key_size) < 0) {
+			cursor = next;
+		}
+
+		skiplist->path[h] = cursor;
+	}
+
+	return cursor;
+}
+
+ion_err_t
+usl_initialize(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	int						maxheight,
+	int						pnum,
+	int						pden
+) {
+	ion_sl_level_t h;
+
+	if ((0 >= maxheight) || (UINT8_MAX < maxheight) || (0 > pnum) || (pnum >= pden)) {
+		return err_invalid_initial_size;
+	}
+
+	skiplist->super.key_type			= key_type;
+	skiplist->super.record.key_size		= key_size;
+	skiplist->super.record.value_size	= value_size;
+	skiplist->maxheight					= maxheight;
+	skiplist->pnum						= pnum;
+	skiplist->pden						= pden;
+	skiplist->rng						= ION_SL_DEFAULT_SEED;
+	skiplist->count						= 0;
+	skiplist->nodes						= 0;
+	skiplist->bytes						= 0;
+	skiplist->path						= ion_alloc(ion_alloc_buffer, sizeof(ion_usl_node_t *) * maxheight);
+	skiplist->head						= usl_new_node(skiplist, maxheight - 1, 0);
+
+	if ((NULL == skiplist->path) || (NULL == skiplist->head)) {
+		ion_free(skiplist->path);
+		ion_free(skiplist->head);
+		return err_out_of_memory;
+	}
+
+	for (h = 0; h < maxheight; h++) {
+		skiplist->head->next[h] = NULL;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+usl_destroy(
+	ion_unrolled_skiplist_t *skiplist
+) {
+	ion_usl_node_t	*cursor = skiplist->head;
+	ion_usl_node_t	*next;
+
+	while (NULL != cursor) {
+		next = cursor->next[0];
+		ion_free(cursor);
+		cursor = next;
+	}
+
+	ion_free(skiplist->path);
+	skiplist->head	= NULL;
+	skiplist->path	= NULL;
+
+	return err_ok;
+}
+
+/**
+@brief		Moves the records of a full node from @p half on to a new node
+			linked right after it, using the path left by the search.
+@return		The new node, or @c NULL if there is no memory for it.
+*/
+static ion_usl_node_t *
+usl_split(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_usl_node_t			*node,
+	int						half
+) {
+	ion_usl_node_t	*right = usl_new_node(skiplist, usl_gen_level(skiplist), ION_USL_NODE_RECORDS);
+	ion_usl_node_t	*before;
+	ion_sl_level_t	h;
+
+	if (NULL == right) {
+		return NULL;
+	}
+
+	right->count	= (uint8_t) (node->count - half);
+	node->count		= (uint8_t) half;
+	skiplist->nodes++;
+	memcpy(usl_record(skiplist, right, 0), usl_record(skiplist, node, half), right->count * ION_USL_RECORD_SIZE(skiplist));
+
+	/* Nothing lies between the node and the last node before it on the levels it lacks */
+	for (h = 0; h <= right->height; h++) {
+		before			= (node->height >= h) ? node : skiplist->path[h];
+		right->next[h]	= before->next[h];
+		before->next[h] = right;
+	}
+
+	return right;
+}
+
+ion_status_t
+usl_insert(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_usl_node_t	*node = usl_search(skiplist, key);
+	ion_usl_node_t	*right;
+	ion_byte_t		*record;
+	int				size	= ION_USL_RECORD_SIZE(skiplist);
+	int				half;
+	int				position;
+
+	/* A key before every node's first goes to the front of the first node */
+	if (skiplist->head == node) {
+		node = skiplist->head->next[0];
+	}
+
+	if (NULL == node) {
+		if (NULL == (node = usl_split(skiplist, skiplist->head, 0))) {
+			return ION_STATUS_ERROR(err_out_of_memory);
+		}
+	}
+
+	position = usl_position(skiplist, node, key, boolean_true);
+
+	if (ION_USL_NODE_RECORDS == node->count) {
+		/* Appending at the very end leaves the full node full, so ascending inserts pack nodes */
+		half	= ((position == node->count) && (NULL == node->next[0])) ? node->count : node->count / 2;
+		right	= usl_split(skiplist, node, half);
+
+		if (NULL == right) {
+			return ION_STATUS_ERROR(err_out_of_memory);
+		}
+
+		if ((position > half) || (0 == right->count)) {
+			node		= right;
+			position	-= half;
+		}
+	}
+
+	record = usl_record(skiplist, node, position);
+	memmove(record + size, record, (node->count - position) * size);
+	memcpy(record, key, skiplist->super.record.key_size);
+	memcpy(record + skiplist->super.record.key_size, value, skiplist->super.record.value_size);
+	node->count++;
+	skiplist->count++;
+
+	return ION_STATUS_OK(1);
+}
+
+ion_usl_node_t *
+usl_lower_bound(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	int						*index
+) {
+	ion_usl_node_t *node = usl_search(skiplist, key);
+
+	if (skiplist->head != node) {
+		*index = usl_position(skiplist, node, key, boolean_false);
+
+		if (*index < node->count) {
+			return node;
+		}
+	}
+
+	/* The first key of the next node is not less than the key */
+	*index = 0;
+	return node->next[0];
+}
+
+ion_status_t
+usl_get_ref(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				*value
+) {
+	int				index;
+	ion_usl_node_t	*node = usl_lower_bound(skiplist, key, &index);
+	ion_byte_t		*record;
+
+	if (NULL == node) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	record = usl_record(skiplist, node, index);
+
+	if (0 != skiplist->super.compare(record, key, skiplist->super.record.key_size)) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	*value = record + skiplist->super.record.key_size;
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+usl_query(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_value_t		stored;
+	ion_status_t	status = usl_get_ref(skiplist, key, &stored);
+
+	if (err_ok == status.error) {
+		memcpy(value, stored, skiplist->super.record.value_size);
+	}
+
+	return status;
+}
+
+ion_status_t
+usl_update(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	int				index;
+	ion_usl_node_t	*node	= usl_lower_bound(skiplist, key, &index);
+	ion_status_t	status	= ION_STATUS_OK(0);
+	ion_byte_t		*record;
+
+	/* Records with the key are consecutive, possibly over several nodes */
+	while (NULL != node) {
+		if (index == node->count) {
+			node	= node->next[0];
+			index	= 0;
+			continue;
+		}
+
+		record = usl_record(skiplist, node, index);
+
+		if (0 != skiplist->super.compare(record, key, skiplist->super.record.key_size)) {
+			break;
+		}
+
+		memcpy(record + skiplist->super.record.key_size, value, skiplist->super.record.value_size);
+		status.count++;
+		index++;
+	}
+
+	if (0 == status.count) {
+		return usl_insert(skiplist, key, value);
+	}
+
+	return status;
+}
+
+ion_status_t
+usl_delete(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key
+) {
+	ion_usl_node_t	*node	= usl_search(skiplist, key);
+	ion_usl_node_t	*next;
+	ion_status_t	status	= ION_STATUS_ERROR(err_item_not_found);
+	int				size	= ION_USL_RECORD_SIZE(skiplist);
+	int				index	= 0;
+	int				end;
+	ion_sl_level_t	h;
+
+	if (skiplist->head == node) {
+		node = skiplist->head->next[0];
+	}
+	else {
+		index = usl_position(skiplist, node, key, boolean_false);
+	}
+
+	while (NULL != node) {
+		for (end = index; end < node->count && 0 == skiplist->super.compare(usl_record(skiplist, node, end), key, skiplist->super.record.key_size); end++) {}
+
+		if (end != index) {
+			memmove(usl_record(skiplist, node, index), usl_record(skiplist, node, end), (node->count - end) * size);
+			node->count		= (uint8_t) (node->count - (end - index));
+			skiplist->count	-= end - index;
+			status.error	= err_ok;
+			status.count	+= end - index;
+		}
+
+		/* A record past the key is left, so there are no more with it */
+		if (index < node->count) {
+			break;
+		}
+
+		next = node->next[0];
+
+		if (0 == node->count) {
+			/* Every node between the path and this one was emptied and unlinked too */
+			for (h = 0; h <= node->height; h++) {
+				skiplist->path[h]->next[h] = node->next[h];
+			}
+
+			skiplist->nodes--;
+			skiplist->bytes -= ION_USL_NODE_BYTES(skiplist, node->height, ION_USL_NODE_RECORDS);
+			ion_free(node);
+		}
+		else {
+			for (h = 0; h <= node->height; h++) {
+				skiplist->path[h] = node;
+			}
+		}
+
+		node	= next;
+		index	= 0;
+	}
+
+	return status;
+}
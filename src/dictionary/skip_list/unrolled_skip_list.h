@@ -0,0 +1,252 @@
+/******************************************************************************/
+/**
+@file
+@brief		A skiplist whose nodes each hold a small sorted array of
+			records, for boards with little RAM.
+@details	A node holds up to @ref ION_USL_NODE_RECORDS records, in key
+			order, back to back after its tower in one allocation. Records
+			across the nodes of the bottom level are in key order too, and
+			a node is found by the key of its first record. A full node is
+			split in half and a node emptied by deletes is freed, so the
+			pointers and allocation of a node are shared by several
+			records. Duplicate keys are kept, as in the skiplist.
+*/
+/******************************************************************************/
+
+#if !defined(UNROLLED_SKIP_LIST_H_)
+#define UNROLLED_SKIP_LIST_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "skip_list_types.h"
+
+/**
+@brief		The most records a node holds before it is split.
+*/
+#if !defined(ION_USL_NODE_RECORDS)
+#if defined(ARDUINO)
+#define ION_USL_NODE_RECORDS 8
+#else
+#define ION_USL_NODE_RECORDS 16
+#endif
+#endif
+
+/**
+@brief		The maximum height of an unrolled skiplist created through the
+			handler with a @c dictionary_size of 0.
+*/
+#if !defined(ION_USL_DEFAULT_HEIGHT)
+#define ION_USL_DEFAULT_HEIGHT 7
+#endif
+
+/**
+@brief		A node of an unrolled skiplist.
+@details	The tower is @p height + 1 links long, and the records,
+			key then value each, follow it.
+*/
+typedef struct usl_node {
+	uint8_t			height;	/**< Height index of the node (counts from 0) */
+	uint8_t			count;	/**< How many records the node holds */
+	struct usl_node *next[];	/**< The tower of links */
+} ion_usl_node_t;
+
+/**
+@brief		Struct of an unrolled skiplist.
+*/
+typedef struct unrolled_skiplist {
+	ion_dictionary_parent_t super;
+	ion_usl_node_t			*head;		/**< Entry point, holding no records */
+	ion_sl_level_t			maxheight;	/**< Maximum height of a tower */
+	int						pnum;		/**< Probability numerator of a tower
+										 growing a level */
+	int						pden;		/**< Probability denominator of a
+										 tower growing a level */
+	uint32_t				rng;		/**< The xorshift state heights are
+										 drawn from, never 0 */
+	ion_usl_node_t			**path;		/**< Per height, the last node before
+										 the key searched last */
+	unsigned long			count;		/**< The records held */
+	unsigned long			nodes;		/**< The nodes holding them */
+	size_t					bytes;		/**< The bytes of the nodes, the head
+										 among them */
+} ion_unrolled_skiplist_t;
+
+/**
+@brief		Initializes an unrolled skiplist.
+
+@param		skiplist
+				The skiplist to initialize.
+@param		key_type
+				The type of key that is being stored in the collection.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		maxheight
+				The maximum height of a tower, at most 255.
+@param		pnum
+				Probability numerator of a tower growing a level.
+@param		pden
+				Probability denominator of a tower growing a level.
+@return		The status of the initialization.
+*/
+ion_err_t
+usl_initialize(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	int						maxheight,
+	int						pnum,
+	int						pden
+);
+
+/**
+@brief		Frees every node of a skiplist.
+
+@param		skiplist
+				The skiplist to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+usl_destroy(
+	ion_unrolled_skiplist_t *skiplist
+);
+
+/**
+@brief		Inserts a record, after any others with the same key in its
+			node.
+
+@param		skiplist
+				The skiplist to insert into.
+@param		key
+				The key of the record.
+@param		value
+				The value of the record.
+@return		The status of the insertion.
+*/
+ion_status_t
+usl_insert(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				value
+);
+
+/**
+@brief		Replaces the value of every record with a key, inserting one if
+			there is none.
+
+@param		skiplist
+				The skiplist to update.
+@param		key
+				The key of the records.
+@param		value
+				The new value.
+@return		The status of the update, counting the records changed.
+*/
+ion_status_t
+usl_update(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				value
+);
+
+/**
+@brief		Deletes every record with a key.
+
+@param		skiplist
+				The skiplist to delete from.
+@param		key
+				The key of the records.
+@return		The status of the deletion, @c err_item_not_found if there was
+			no record with @p key.
+*/
+ion_status_t
+usl_delete(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key
+);
+
+/**
+@brief		Points at the value of the first record with a key, in its node.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value, valid until the next insert,
+				update or delete.
+@return		The status of the query.
+*/
+ion_status_t
+usl_get_ref(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				*value
+);
+
+/**
+@brief		Reads the value of the first record with a key.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value of the record.
+@return		The status of the query.
+*/
+ion_status_t
+usl_query(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	ion_value_t				value
+);
+
+/**
+@brief		Finds the first record whose key is not less than @p key.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search from.
+@param		index
+				Receives the position of the record in its node.
+@return		The node holding the record, or @c NULL if every key is less
+			than @p key.
+*/
+ion_usl_node_t *
+usl_lower_bound(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_key_t				key,
+	int						*index
+);
+
+/**
+@brief		The address of a record of a node.
+
+@param		skiplist
+				The skiplist of the node.
+@param		node
+				The node holding the record.
+@param		index
+				The position of the record in the node.
+@return		The key of the record, which its value follows.
+*/
+ion_byte_t *
+usl_record(
+	ion_unrolled_skiplist_t *skiplist,
+	ion_usl_node_t			*node,
+	int						index
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* UNROLLED_SKIP_LIST_H_ */
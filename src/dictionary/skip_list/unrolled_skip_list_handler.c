@@ -0,0 +1,407 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for the unrolled skiplist.
+*/
+/******************************************************************************/
+
+#include "unrolled_skip_list_handler.h"
+
+ion_status_t
+usldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return usl_insert((ion_unrolled_skiplist_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+usldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return usl_query((ion_unrolled_skiplist_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+usldict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return usl_get_ref((ion_unrolled_skiplist_t *) dictionary->instance, key, value);
+}
+
+ion_err_t
+usldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+
+	ion_unrolled_skiplist_t *skiplist;
+	ion_err_t				err;
+
+	if (NULL == (skiplist = ion_alloc(ion_alloc_other, sizeof(ion_unrolled_skiplist_t)))) {
+		return err_out_of_memory;
+	}
+
+	skiplist->super.compare = compare;
+
+	/* the same p as the skiplist, over nodes rather than records */
+	err						= usl_initialize(skiplist, key_type, key_size, value_size, (0 == dictionary_size) ? ION_USL_DEFAULT_HEIGHT : dictionary_size, 1, 4);
+
+	if (err_ok != err) {
+		ion_free(skiplist);
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) skiplist;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_status_t
+usldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return usl_delete((ion_unrolled_skiplist_t *) dictionary->instance, key);
+}
+
+ion_err_t
+usldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t result = usl_destroy((ion_unrolled_skiplist_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return result;
+}
+
+ion_status_t
+usldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return usl_update((ion_unrolled_skiplist_t *) dictionary->instance, key, value);
+}
+
+/**
+@brief		The last key a predicate takes, or @c NULL if it takes every key.
+*/
+static ion_key_t
+usldict_upper(
+	ion_predicate_t *predicate
+) {
+	if (predicate_equality == predicate->type) {
+		return predicate->statement.equality.equality_value;
+	}
+
+	if (predicate_range == predicate->type) {
+		return predicate->statement.range.upper_bound;
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Moves a predicate cursor on to the first record from where it is
+			that its filter passes, testing each in its node.
+*/
+static void
+usldict_filter(
+	ion_usldict_cursor_t *usl_cursor
+) {
+	ion_unrolled_skiplist_t *skiplist = (ion_unrolled_skiplist_t *) usl_cursor->super.dictionary->instance;
+	ion_byte_t				*found;
+
+	while (NULL != usl_cursor->node) {
+		found = usl_record(skiplist, usl_cursor->node, usl_cursor->index);
+
+		if (test_record_predicate(&usl_cursor->super, found, found + skiplist->super.record.key_size)) {
+			return;
+		}
+
+		if (++usl_cursor->index == usl_cursor->node->count) {
+			usl_cursor->node	= usl_cursor->node->next[0];
+			usl_cursor->index	= 0;
+		}
+	}
+}
+
+ion_err_t
+usldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_unrolled_skiplist_t *skiplist	= (ion_unrolled_skiplist_t *) dictionary->instance;
+	ion_key_size_t			key_size	= dictionary->instance->record.key_size;
+	ion_usldict_cursor_t	*usl_cursor;
+	ion_predicate_t			*copy;
+	ion_key_t				upper		= NULL;
+
+	if ((predicate_equality != predicate->type) && (predicate_range != predicate->type) && (predicate_all_records != predicate->type) && (predicate_predicate != predicate->type)) {
+		return err_invalid_predicate;
+	}
+
+	if (NULL == (usl_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_usldict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	/* the predicate and its keys in one piece */
+	if (NULL == (copy = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t) + key_size * 2))) {
+		ion_free(usl_cursor);
+		return err_out_of_memory;
+	}
+
+	usl_cursor->super.dictionary	= dictionary;
+	usl_cursor->super.predicate		= copy;
+	usl_cursor->super.next			= usldict_next;
+	usl_cursor->super.destroy		= usldict_destroy_cursor;
+	usl_cursor->super.next_batch	= usldict_next_batch;
+	usl_cursor->index				= 0;
+	copy->type						= predicate->type;
+
+	if (predicate_equality == predicate->type) {
+		copy->statement.equality.equality_value = (ion_byte_t *) (copy + 1);
+		memcpy(copy->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+		usl_cursor->node						= usl_lower_bound(skiplist, copy->statement.equality.equality_value, &usl_cursor->index);
+		upper									= copy->statement.equality.equality_value;
+	}
+	else if (predicate_range == predicate->type) {
+		copy->statement.range.lower_bound	= (ion_byte_t *) (copy + 1);
+		copy->statement.range.upper_bound	= (ion_byte_t *) copy->statement.range.lower_bound + key_size;
+		memcpy(copy->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+		memcpy(copy->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+		usl_cursor->node					= usl_lower_bound(skiplist, copy->statement.range.lower_bound, &usl_cursor->index);
+		upper								= copy->statement.range.upper_bound;
+	}
+	else if (predicate_predicate == predicate->type) {
+		copy->statement.other_predicate = predicate->statement.other_predicate;
+		usl_cursor->node				= skiplist->head->next[0];
+		/* the batches lean on records in order being in the predicate, which a filter breaks, so they go one by one */
+		usl_cursor->super.next_batch	= NULL;
+		usldict_filter(usl_cursor);
+	}
+	else {
+		usl_cursor->node = skiplist->head->next[0];
+	}
+
+	/* The first record in order is in the predicate unless it is past its last key */
+	if ((NULL == usl_cursor->node) || ((NULL != upper) && (skiplist->super.compare(usl_record(skiplist, usl_cursor->node, usl_cursor->index), upper, key_size) > 0))) {
+		usl_cursor->super.status = cs_end_of_results;
+	}
+	else {
+		usl_cursor->super.status = cs_cursor_initialized;
+	}
+
+	*cursor = (ion_dict_cursor_t *) usl_cursor;
+
+	return err_ok;
+}
+
+ion_cursor_status_t
+usldict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_usldict_cursor_t	*usl_cursor = (ion_usldict_cursor_t *) cursor;
+	ion_unrolled_skiplist_t *skiplist	= (ion_unrolled_skiplist_t *) cursor->dictionary->instance;
+	ion_byte_t				*found;
+
+	if (cs_cursor_active == cursor->status) {
+		/* Records follow the first one in order, so the first one outside the predicate ends it */
+		if ((NULL == usl_cursor->node) || ((NULL != usldict_upper(cursor->predicate)) && (boolean_false == test_predicate(cursor, usl_record(skiplist, usl_cursor->node, usl_cursor->index))))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else {
+		return cursor->status;
+	}
+
+	found = usl_record(skiplist, usl_cursor->node, usl_cursor->index);
+	memcpy(record->key, found, skiplist->super.record.key_size);
+	memcpy(record->value, found + skiplist->super.record.key_size, skiplist->super.record.value_size);
+
+	if (++usl_cursor->index == usl_cursor->node->count) {
+		usl_cursor->node	= usl_cursor->node->next[0];
+		usl_cursor->index	= 0;
+	}
+
+	if (predicate_predicate == cursor->predicate->type) {
+		usldict_filter(usl_cursor);
+	}
+
+	return cursor->status;
+}
+
+int
+usldict_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+) {
+	ion_usldict_cursor_t	*usl_cursor = (ion_usldict_cursor_t *) cursor;
+	ion_unrolled_skiplist_t *skiplist	= (ion_unrolled_skiplist_t *) cursor->dictionary->instance;
+	ion_key_size_t			key_size	= skiplist->super.record.key_size;
+	ion_value_size_t		value_size	= skiplist->super.record.value_size;
+	ion_key_t				upper		= usldict_upper(cursor->predicate);
+	ion_usl_node_t			*node		= usl_cursor->node;
+	int						index		= usl_cursor->index;
+	ion_boolean_t			past		= boolean_false;
+	ion_byte_t				*found;
+	int						read		= 0;
+	int						end;
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active != cursor->status) {
+		return 0;
+	}
+
+	while (read < max && !past) {
+		if (NULL == node) {
+			break;
+		}
+
+		end = (node->count - index < max - read) ? node->count : index + max - read;
+
+		/* The records start within the predicate, so only the last one wanted needs testing, unless it is past it */
+		if ((NULL != upper) && (skiplist->super.compare(usl_record(skiplist, node, end - 1), upper, key_size) > 0)) {
+			for (end = index; skiplist->super.compare(usl_record(skiplist, node, end), upper, key_size) <= 0; end++) {}
+
+			past = boolean_true;
+		}
+
+		for (; index < end; index++, read++) {
+			found = usl_record(skiplist, node, index);
+			memcpy((ion_byte_t *) keys + read * key_size, found, key_size);
+			memcpy((ion_byte_t *) values + read * value_size, found + key_size, value_size);
+		}
+
+		if (index == node->count) {
+			node	= node->next[0];
+			index	= 0;
+		}
+	}
+
+	usl_cursor->node	= node;
+	usl_cursor->index	= index;
+
+	if (past || (NULL == node)) {
+		cursor->status = cs_end_of_results;
+	}
+
+	return read;
+}
+
+void
+usldict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	/* the keys of the predicate live with it */
+	ion_free((*cursor)->predicate);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+usldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+ion_err_t
+usldict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+/**
+@brief		Tells the size of an unrolled skiplist dictionary, see
+			@ref dictionary_get_info. Its nodes are its pages.
+*/
+static ion_err_t
+usldict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_unrolled_skiplist_t *skiplist	= (ion_unrolled_skiplist_t *) dictionary->instance;
+	ion_usl_node_t			*node		= skiplist->head;
+	ion_sl_level_t			h;
+
+	info->record_count	= (long) skiplist->count;
+	info->file_bytes	= 0;
+	info->pages			= (long) skiplist->nodes;
+	info->memory_bytes	= (long) (skiplist->bytes + sizeof(ion_usl_node_t *) * skiplist->maxheight);
+	info->ordered		= boolean_true;
+
+	if ((0 == skiplist->count) || (NULL == info->min_key) || (NULL == info->max_key)) {
+		return err_ok;
+	}
+
+	/* the last node is found down the towers, as a search past the end */
+	for (h = skiplist->head->height; h >= 0; h--) {
+		while (NULL != node->next[h]) {
+			node = node->next[h];
+		}
+	}
+
+	memcpy(info->min_key, usl_record(skiplist, skiplist->head->next[0], 0), dictionary->instance->record.key_size);
+	memcpy(info->max_key, usl_record(skiplist, node, node->count - 1), dictionary->instance->record.key_size);
+	info->has_bounds = boolean_true;
+
+	return err_ok;
+}
+
+void
+usldict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= usldict_insert;
+	handler->create_dictionary	= usldict_create_dictionary;
+	handler->get				= usldict_query;
+	handler->update				= usldict_update;
+	handler->find				= usldict_find;
+	handler->remove				= usldict_delete;
+	handler->delete_dictionary	= usldict_delete_dictionary;
+	handler->close_dictionary	= usldict_close_dictionary;
+	handler->open_dictionary	= usldict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= usldict_get_ref;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= usldict_get_info;
+	handler->bulk_load			= NULL;
+}
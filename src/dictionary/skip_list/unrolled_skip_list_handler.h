@@ -0,0 +1,282 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for the unrolled skiplist.
+@details	Dictionaries created with it behave as those of the skiplist
+			handler, duplicate keys included, while several records share
+			each node.
+*/
+/******************************************************************************/
+
+#if !defined(UNROLLED_SKIP_LIST_HANDLER_H_)
+#define UNROLLED_SKIP_LIST_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "unrolled_skip_list.h"
+
+/**
+@brief		A cursor over an unrolled skiplist.
+*/
+typedef struct usldict_cursor {
+	ion_dict_cursor_t	super;	/**< Cursor supertype this type inherits
+								 from */
+	ion_usl_node_t		*node;	/**< The node of the record read next */
+	int					index;	/**< Its position in the node */
+} ion_usldict_cursor_t;
+
+/**
+@brief		Registers the unrolled skiplist handler.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+usldict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Inserts a record into the dictionary.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion.
+*/
+ion_status_t
+usldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Reads the value of the first record with a key.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value, allocated by the caller.
+@return		The status of the query.
+*/
+ion_status_t
+usldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at the value of the first record with a key, for
+			@ref dictionary_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the query.
+*/
+ion_status_t
+usldict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Creates an unrolled skiplist dictionary.
+
+@param		id
+				The id of the dictionary, unused.
+@param		key_type
+				The type of key stored.
+@param		key_size
+				Size of the key in bytes.
+@param		value_size
+				Size of the value in bytes.
+@param		dictionary_size
+				The maximum height of the skiplist, or 0 for
+				@ref ION_USL_DEFAULT_HEIGHT.
+@param		compare
+				The comparison function for keys.
+@param		handler
+				Handler to be bound to the dictionary instance being created.
+@param		dictionary
+				Receives the created dictionary instance.
+@return		The status of creation.
+*/
+ion_err_t
+usldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes every record with a key.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+usldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a dictionary and frees its records.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+usldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Replaces the value of every record with a key, inserting one if
+			there is none.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		The status of the update.
+*/
+ion_status_t
+usldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to match.
+@param		cursor
+				Receives a cursor over the records, in key order.
+@return		The status of the find.
+*/
+ion_err_t
+usldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the record, its buffers allocated by the caller.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+usldict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Reads up to @p max records of a cursor, for
+			@ref dictionary_next_batch.
+@details	Within a node the records are tested against the predicate
+			only at the last one wanted, as those before it are in order.
+
+@param		cursor
+				The cursor to read.
+@param		keys
+				Receives the keys of the records, back to back.
+@param		values
+				Receives their values, back to back.
+@param		max
+				The most records to read.
+@return		The number of records read.
+*/
+int
+usldict_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_key_t			keys,
+	ion_value_t			values,
+	int					max
+);
+
+/**
+@brief		Destroys a cursor and sets it to @c NULL.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+usldict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opening is not supported, the skiplist lives in memory only.
+
+@param		handler
+				The handler of the dictionary.
+@param		dictionary
+				The dictionary to open.
+@param		config
+				The configuration of the dictionary.
+@param		compare
+				The comparison function for keys.
+@return		@c err_not_implemented.
+*/
+ion_err_t
+usldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closing is not supported, the skiplist lives in memory only.
+
+@param		dictionary
+				The dictionary to close.
+@return		@c err_not_implemented.
+*/
+ion_err_t
+usldict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* UNROLLED_SKIP_LIST_HANDLER_H_ */
@@ -0,0 +1,297 @@
+/******************************************************************************/
+/**
+@file
+@brief		A static, in-memory dictionary of records loaded once in key
+			order, laid out for searches.
+@details	The slots of a sealed array of @c n records are numbered from
+			@c 1 to @c n, slot @c 0 being left empty so that the children of
+			slot @c i are @c 2i and <tt>2i + 1</tt>. Walking the slots in
+			order, left subtree first, visits the keys in key order, which
+			is how @ref sa_seal lays them out and how cursors read them.
+*/
+/******************************************************************************/
+
+#include "sorted_array.h"
+
+/**
+@brief		Makes room for twice as many records as an appending array
+			holds.
+*/
+static ion_err_t
+sa_grow(
+	ion_sorted_array_t *sorted_array
+) {
+	long		capacity = 2 * sorted_array->capacity;
+	ion_byte_t	*keys;
+	ion_byte_t	*values;
+
+	if (NULL == (keys = ion_realloc(ion_alloc_node, sorted_array->keys, capacity * sorted_array->super.record.key_size))) {
+		return err_out_of_memory;
+	}
+
+	sorted_array->keys = keys;
+
+	if (NULL == (values = ion_realloc(ion_alloc_node, sorted_array->values, capacity * sorted_array->super.record.value_size))) {
+		return err_out_of_memory;
+	}
+
+	sorted_array->values	= values;
+	sorted_array->capacity	= capacity;
+
+	return err_ok;
+}
+
+ion_err_t
+sa_initialize(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	long				records
+) {
+	if (records < 0) {
+		return err_invalid_initial_size;
+	}
+
+	sorted_array->super.key_type			= key_type;
+	sorted_array->super.record.key_size		= key_size;
+	sorted_array->super.record.value_size	= value_size;
+	sorted_array->sealed					= boolean_false;
+	sorted_array->count						= 0;
+	sorted_array->capacity					= (0 == records) ? ION_SA_INITIAL_RECORDS : records;
+	sorted_array->keys						= ion_alloc(ion_alloc_node, sorted_array->capacity * key_size);
+	sorted_array->values					= ion_alloc(ion_alloc_node, sorted_array->capacity * value_size);
+
+	if ((NULL == sorted_array->keys) || (NULL == sorted_array->values)) {
+		ion_free(sorted_array->keys);
+		ion_free(sorted_array->values);
+		return err_out_of_memory;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+sa_destroy(
+	ion_sorted_array_t *sorted_array
+) {
+	ion_free(sorted_array->keys);
+	ion_free(sorted_array->values);
+	sorted_array->keys		= NULL;
+	sorted_array->values	= NULL;
+	sorted_array->count		= 0;
+
+	return err_ok;
+}
+
+ion_status_t
+sa_append(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_err_t	err;
+	char		order;
+
+	if (sorted_array->sealed) {
+		return ION_STATUS_ERROR(err_illegal_state);
+	}
+
+	if (sorted_array->count > 0) {
+		order = sorted_array->super.compare(key, ION_SA_KEY(sorted_array, sorted_array->count - 1), sorted_array->super.record.key_size);
+
+		if (0 >= order) {
+			return ION_STATUS_ERROR((0 == order) ? err_duplicate_key : err_sorted_order_violation);
+		}
+	}
+
+	if ((sorted_array->count == sorted_array->capacity) && (err_ok != (err = sa_grow(sorted_array)))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	memcpy(ION_SA_KEY(sorted_array, sorted_array->count), key, sorted_array->super.record.key_size);
+	memcpy(ION_SA_VALUE(sorted_array, sorted_array->count), value, sorted_array->super.record.value_size);
+	sorted_array->count++;
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+sa_load(
+	ion_sorted_array_t	*sorted_array,
+	ion_sa_next_t		next,
+	void				*context
+) {
+	ion_status_t	status	= ION_STATUS_OK(0);
+	ion_status_t	appended;
+	ion_record_t	record;
+	ion_err_t		err;
+
+	record.key		= ion_alloc(ion_alloc_buffer, sorted_array->super.record.key_size);
+	record.value	= ion_alloc(ion_alloc_buffer, sorted_array->super.record.value_size);
+
+	if ((NULL == record.key) || (NULL == record.value)) {
+		ion_free(record.key);
+		ion_free(record.value);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	while (err_ok == (err = next(context, &record))) {
+		appended = sa_append(sorted_array, record.key, record.value);
+
+		if (err_ok != appended.error) {
+			err = appended.error;
+			break;
+		}
+
+		status.count++;
+	}
+
+	ion_free(record.key);
+	ion_free(record.value);
+
+	status.error = (err_item_not_found == err) ? sa_seal(sorted_array) : err;
+
+	return status;
+}
+
+long
+sa_first(
+	ion_sorted_array_t *sorted_array
+) {
+	long slot = 1;
+
+	if (0 == sorted_array->count) {
+		return 0;
+	}
+
+	while (2 * slot <= sorted_array->count) {
+		slot *= 2;
+	}
+
+	return slot;
+}
+
+long
+sa_next(
+	ion_sorted_array_t	*sorted_array,
+	long				slot
+) {
+	/* the least key of the right subtree, if there is one */
+	if (2 * slot + 1 <= sorted_array->count) {
+		slot = 2 * slot + 1;
+
+		while (2 * slot <= sorted_array->count) {
+			slot *= 2;
+		}
+
+		return slot;
+	}
+
+	/* else the first slot above whose left subtree this is */
+	while (slot & 1) {
+		slot >>= 1;
+	}
+
+	return slot >> 1;
+}
+
+ion_err_t
+sa_seal(
+	ion_sorted_array_t *sorted_array
+) {
+	ion_key_size_t		key_size	= sorted_array->super.record.key_size;
+	ion_value_size_t	value_size	= sorted_array->super.record.value_size;
+	ion_byte_t			*keys;
+	ion_byte_t			*values;
+	long				slot;
+	long				i;
+
+	if (sorted_array->sealed) {
+		return err_ok;
+	}
+
+	keys	= ion_alloc(ion_alloc_node, (sorted_array->count + 1) * key_size);
+	values	= ion_alloc(ion_alloc_node, (sorted_array->count + 1) * value_size);
+
+	if ((NULL == keys) || (NULL == values)) {
+		ion_free(keys);
+		ion_free(values);
+		return err_out_of_memory;
+	}
+
+	/* an in-order walk of the slots takes the records in key order */
+	for (i = 0, slot = sa_first(sorted_array); 0 != slot; i++, slot = sa_next(sorted_array, slot)) {
+		memcpy(keys + slot * key_size, ION_SA_KEY(sorted_array, i), key_size);
+		memcpy(values + slot * value_size, ION_SA_VALUE(sorted_array, i), value_size);
+	}
+
+	ion_free(sorted_array->keys);
+	ion_free(sorted_array->values);
+	sorted_array->keys		= keys;
+	sorted_array->values	= values;
+	sorted_array->capacity	= sorted_array->count;
+	sorted_array->sealed	= boolean_true;
+
+	return err_ok;
+}
+
+long
+sa_lower_bound(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key
+) {
+	long slot = 1;
+
+	/* go right past every key less than the one sought, left otherwise */
+	while (slot <= sorted_array->count) {
+		slot = 2 * slot + (sorted_array->super.compare(ION_SA_KEY(sorted_array, slot), key, sorted_array->super.record.key_size) < 0);
+	}
+
+	/* the last left turn was at the first key not less; undo the right turns after it, then it */
+	while (slot & 1) {
+		slot >>= 1;
+	}
+
+	return slot >> 1;
+}
+
+ion_status_t
+sa_get_ref(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	ion_err_t	err = sa_seal(sorted_array);
+	long		slot;
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	slot = sa_lower_bound(sorted_array, key);
+
+	if ((0 == slot) || (0 != sorted_array->super.compare(ION_SA_KEY(sorted_array, slot), key, sorted_array->super.record.key_size))) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	*value = ION_SA_VALUE(sorted_array, slot);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+sa_query(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_value_t		stored;
+	ion_status_t	status = sa_get_ref(sorted_array, key, &stored);
+
+	if (err_ok == status.error) {
+		memcpy(value, stored, sorted_array->super.record.value_size);
+	}
+
+	return status;
+}
@@ -0,0 +1,266 @@
+/******************************************************************************/
+/**
+@file
+@brief		A static, in-memory dictionary of records loaded once in key
+			order, laid out for searches.
+@details	Records are appended in ascending key order, then sealed. The
+			keys of a sealed array are kept in Eytzinger order: slot @c 1
+			holds the median, and the children of slot @c i are slots
+			@c 2i and <tt>2i + 1</tt>, as in a binary heap. A search then
+			descends with one comparison per level and no branch on its
+			outcome, and the first levels it reads share a few cache lines
+			for every search. Values are kept apart, at the slot of their
+			key, so a search only reads keys.
+
+			A sealed array cannot change. Keys are unique.
+*/
+/******************************************************************************/
+
+#if !defined(SORTED_ARRAY_H_)
+#define SORTED_ARRAY_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		How many records an array has room for before its first
+			append, when created with a size of 0. The room doubles as it
+			fills.
+*/
+#if !defined(ION_SA_INITIAL_RECORDS)
+#if defined(ARDUINO)
+#define ION_SA_INITIAL_RECORDS 8
+#else
+#define ION_SA_INITIAL_RECORDS 64
+#endif
+#endif
+
+/**
+@brief		Struct used to maintain an instance of a sorted array.
+*/
+typedef struct sorted_array {
+	ion_dictionary_parent_t super;
+	ion_boolean_t			sealed;		/**< Whether the records are laid
+										 out for searches, and can no
+										 longer change */
+	long					count;		/**< The records held */
+	long					capacity;	/**< The records there is room for
+										 while appending */
+	ion_byte_t				*keys;		/**< The keys, in key order while
+										 appending, then in Eytzinger order
+										 from slot 1 */
+	ion_byte_t				*values;	/**< The values, at the slot of their
+										 key */
+} ion_sorted_array_t;
+
+/**
+@brief		Supplies records to @ref sa_load.
+@param		context
+				The context given to @ref sa_load.
+@param		record
+				Key and value buffers, sized for the array, to fill with
+				the next record. Records must come in ascending key order.
+@return		@ref err_ok if @p record was filled, @ref err_item_not_found
+			once there are no more records, or any other error to abort
+			the load.
+*/
+typedef ion_err_t (*ion_sa_next_t)(
+	void			*context,
+	ion_record_t	*record
+);
+
+/**
+@brief		Initializes an empty array.
+
+@param		sorted_array
+				The array to initialize, whose @c super.compare is set.
+@param		key_type
+				The type of key that is being stored in the array.
+@param		key_size
+				The size of key that is being stored in the array.
+@param		value_size
+				The size of value that is being stored in the array.
+@param		records
+				How many records to make room for, 0 for
+				@ref ION_SA_INITIAL_RECORDS.
+@return		The status of the initialization.
+*/
+ion_err_t
+sa_initialize(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	long				records
+);
+
+/**
+@brief		Frees the memory of an array.
+
+@param		sorted_array
+				The array to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+sa_destroy(
+	ion_sorted_array_t *sorted_array
+);
+
+/**
+@brief		Appends a record to an array that is not sealed.
+
+@param		sorted_array
+				The array to append to.
+@param		key
+				The key of the record, which must be greater than every key
+				appended before it.
+@param		value
+				The value of the record.
+@return		The status of the append: @c err_sorted_order_violation if the
+			key is less than the last, @c err_duplicate_key if it is the
+			same, and @c err_illegal_state once the array is sealed.
+*/
+ion_status_t
+sa_append(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Appends every record of a sorted stream to an array, then seals
+			it.
+
+@param		sorted_array
+				The array to load, which is not sealed.
+@param		next
+				Called for each record in turn.
+@param		context
+				Passed through to @p next.
+@return		The status of the load; the count is the number of records
+			appended. The array is only sealed if the load succeeds.
+*/
+ion_status_t
+sa_load(
+	ion_sorted_array_t	*sorted_array,
+	ion_sa_next_t		next,
+	void				*context
+);
+
+/**
+@brief		Lays the records of an array out in Eytzinger order, after
+			which it cannot change. Sealing a sealed array does nothing.
+
+@param		sorted_array
+				The array to seal.
+@return		The status of the sealing.
+*/
+ion_err_t
+sa_seal(
+	ion_sorted_array_t *sorted_array
+);
+
+/**
+@brief		Finds the slot of the first key not less than @p key.
+
+@param		sorted_array
+				The sealed array to search.
+@param		key
+				The key to search for.
+@return		The slot, or 0 if every key is less than @p key.
+*/
+long
+sa_lower_bound(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key
+);
+
+/**
+@brief		Finds the slot of the least key of an array.
+
+@param		sorted_array
+				The sealed array to search.
+@return		The slot, or 0 if the array is empty.
+*/
+long
+sa_first(
+	ion_sorted_array_t *sorted_array
+);
+
+/**
+@brief		Finds the slot of the key that follows the key of a slot.
+
+@param		sorted_array
+				The sealed array to walk.
+@param		slot
+				A slot holding a key.
+@return		The slot, or 0 if @p slot holds the greatest key.
+*/
+long
+sa_next(
+	ion_sorted_array_t	*sorted_array,
+	long				slot
+);
+
+/**
+@brief		Looks up the value of a key, sealing the array first if it is
+			not.
+
+@param		sorted_array
+				The array to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value.
+@return		The status of the query.
+*/
+ion_status_t
+sa_query(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at the value of a key where the array holds it, sealing
+			the array first if it is not.
+
+@param		sorted_array
+				The array to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value, valid until the array is
+				destroyed.
+@return		The status of the query.
+*/
+ion_status_t
+sa_get_ref(
+	ion_sorted_array_t	*sorted_array,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		The key held by a slot.
+*/
+#define ION_SA_KEY(sorted_array, slot)		((sorted_array)->keys + (slot) * (sorted_array)->super.record.key_size)
+
+/**
+@brief		The value held by a slot.
+*/
+#define ION_SA_VALUE(sorted_array, slot)	((sorted_array)->values + (slot) * (sorted_array)->super.record.value_size)
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SORTED_ARRAY_H_ */
@@ -0,0 +1,365 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a static sorted array.
+*/
+/******************************************************************************/
+
+#include "sorted_array_dictionary_handler.h"
+
+/**
+@brief		Moves a cursor from its slot on to the first one, in key order,
+			whose record satisfies its predicate.
+@return		@c cs_valid_data, or @c cs_end_of_results once no slot left
+			can.
+*/
+static ion_cursor_status_t
+sadict_scan(
+	ion_sadict_cursor_t *cursor
+) {
+	ion_sorted_array_t	*sorted_array	= (ion_sorted_array_t *) cursor->super.dictionary->instance;
+	ion_predicate_t		*predicate		= cursor->super.predicate;
+	ion_key_t			key;
+
+	for (; 0 != cursor->slot; cursor->slot = sa_next(sorted_array, cursor->slot)) {
+		key = ION_SA_KEY(sorted_array, cursor->slot);
+
+		/* the slots are walked in key order, so nothing past the key or the upper bound can match */
+		if ((predicate_equality == predicate->type) && (0 != sorted_array->super.compare(key, predicate->statement.equality.equality_value, sorted_array->super.record.key_size))) {
+			break;
+		}
+
+		if ((predicate_range == predicate->type) && (0 < sorted_array->super.compare(key, predicate->statement.range.upper_bound, sorted_array->super.record.key_size))) {
+			break;
+		}
+
+		if (boolean_true == test_record_predicate(&cursor->super, key, ION_SA_VALUE(sorted_array, cursor->slot))) {
+			return cs_valid_data;
+		}
+	}
+
+	return cs_end_of_results;
+}
+
+ion_cursor_status_t
+sadict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_sadict_cursor_t *sadict_cursor	= (ion_sadict_cursor_t *) cursor;
+	ion_sorted_array_t	*sorted_array	= (ion_sorted_array_t *) cursor->dictionary->instance;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active == cursor->status) {
+		/* keys are unique, so an equality cursor has nothing past its first record */
+		if (predicate_equality == cursor->predicate->type) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		sadict_cursor->slot = sa_next(sorted_array, sadict_cursor->slot);
+
+		if (cs_end_of_results == sadict_scan(sadict_cursor)) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else {
+		return cs_invalid_cursor;
+	}
+
+	memcpy(record->key, ION_SA_KEY(sorted_array, sadict_cursor->slot), sorted_array->super.record.key_size);
+	memcpy(record->value, ION_SA_VALUE(sorted_array, sadict_cursor->slot), sorted_array->super.record.value_size);
+
+	return cursor->status;
+}
+
+ion_err_t
+sadict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_sorted_array_t	*sorted_array	= (ion_sorted_array_t *) dictionary->instance;
+	ion_key_size_t		key_size		= sorted_array->super.record.key_size;
+	ion_sadict_cursor_t *sadict_cursor;
+	ion_err_t			err;
+
+	if (err_ok != (err = sa_seal(sorted_array))) {
+		return err;
+	}
+
+	if (NULL == (sadict_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_sadict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	*cursor					= (ion_dict_cursor_t *) sadict_cursor;
+	(*cursor)->dictionary	= dictionary;
+	(*cursor)->status		= cs_cursor_uninitialized;
+	(*cursor)->destroy		= sadict_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
+	(*cursor)->next			= sadict_next;
+
+	if (NULL == ((*cursor)->predicate = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			/* the predicate may be destroyed while the cursor is open, so keep a copy of its key */
+			if (NULL == ((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+			sadict_cursor->slot = sa_lower_bound(sorted_array, predicate->statement.equality.equality_value);
+			break;
+		}
+
+		case predicate_range: {
+			if (NULL == ((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			if (NULL == ((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			sadict_cursor->slot = sa_lower_bound(sorted_array, predicate->statement.range.lower_bound);
+			break;
+		}
+
+		case predicate_predicate: {
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			sadict_cursor->slot								= sa_first(sorted_array);
+			break;
+		}
+
+		case predicate_all_records: {
+			sadict_cursor->slot = sa_first(sorted_array);
+			break;
+		}
+
+		default: {
+			ion_free((*cursor)->predicate);
+			ion_free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	(*cursor)->status = (cs_valid_data == sadict_scan(sadict_cursor)) ? cs_cursor_initialized : cs_end_of_results;
+
+	return err_ok;
+}
+
+ion_err_t
+sadict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_sorted_array_t	*sorted_array;
+	ion_err_t			err;
+
+	UNUSED(id);
+
+	if (NULL == (sorted_array = ion_alloc(ion_alloc_other, sizeof(ion_sorted_array_t)))) {
+		return err_out_of_memory;
+	}
+
+	sorted_array->super.compare = compare;
+
+	/* a size of -1 leaves the room to the array, as 0 does */
+	err							= sa_initialize(sorted_array, key_type, key_size, value_size, ((ion_dictionary_size_t) -1 == dictionary_size) ? 0 : (long) dictionary_size);
+
+	if (err_ok != err) {
+		ion_free(sorted_array);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) sorted_array;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_err_t
+sadict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+ion_err_t
+sadict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+ion_err_t
+sadict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = sa_destroy((ion_sorted_array_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+sadict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return sa_append((ion_sorted_array_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+sadict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return sa_query((ion_sorted_array_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+sadict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return sa_get_ref((ion_sorted_array_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+sadict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	UNUSED(dictionary);
+	UNUSED(key);
+	UNUSED(value);
+	return ION_STATUS_ERROR(err_not_implemented);
+}
+
+ion_status_t
+sadict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	UNUSED(dictionary);
+	UNUSED(key);
+	return ION_STATUS_ERROR(err_not_implemented);
+}
+
+void
+sadict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+/**
+@brief		Tells the size of a sorted array dictionary, see
+			@ref dictionary_get_info. Once sealed its smallest and largest
+			keys are at the ends of the leftmost and rightmost paths down
+			the Eytzinger layout.
+*/
+static ion_err_t
+sadict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_sorted_array_t	*sorted_array	= (ion_sorted_array_t *) dictionary->instance;
+	int					key_size		= sorted_array->super.record.key_size;
+	long				first			= 0;
+	long				last			= sorted_array->count - 1;
+
+	info->record_count	= sorted_array->count;
+	info->file_bytes	= 0;
+	info->memory_bytes	= (sorted_array->capacity + (sorted_array->sealed ? 1 : 0)) * (key_size + sorted_array->super.record.value_size);
+
+	if ((0 == sorted_array->count) || (NULL == info->min_key) || (NULL == info->max_key)) {
+		return err_ok;
+	}
+
+	if (sorted_array->sealed) {
+		for (first = 1; 2 * first <= sorted_array->count; first = 2 * first) {}
+
+		for (last = 1; 2 * last + 1 <= sorted_array->count; last = 2 * last + 1) {}
+	}
+
+	memcpy(info->min_key, sorted_array->keys + first * key_size, key_size);
+	memcpy(info->max_key, sorted_array->keys + last * key_size, key_size);
+	info->has_bounds = boolean_true;
+
+	return err_ok;
+}
+
+void
+sadict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= sadict_insert;
+	handler->create_dictionary	= sadict_create_dictionary;
+	handler->get				= sadict_query;
+	handler->update				= sadict_update;
+	handler->find				= sadict_find;
+	handler->remove				= sadict_delete;
+	handler->delete_dictionary	= sadict_delete_dictionary;
+	handler->open_dictionary	= sadict_open_dictionary;
+	handler->close_dictionary	= sadict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= sadict_get_ref;
+	handler->sync_dictionary	= NULL;
+	handler->get_info			= sadict_get_info;
+	handler->bulk_load			= NULL;
+}
@@ -0,0 +1,275 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a static sorted array.
+*/
+/******************************************************************************/
+
+#if !defined(SORTED_ARRAY_DICTIONARY_HANDLER_H_)
+#define SORTED_ARRAY_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "sorted_array.h"
+
+/**
+@brief		A cursor over a sorted array.
+@details	Cursors walk the slots in key order, from the lower bound of
+			an equality or range predicate. A sealed array does not change,
+			so cursors stay valid until it is deleted.
+*/
+typedef struct sadict_cursor {
+	ion_dict_cursor_t	super;	/**< Cursor supertype this type inherits
+								 from */
+	long				slot;	/**< The slot of the current record */
+} ion_sadict_cursor_t;
+
+/**
+@brief		Registers the sorted array handler.
+
+@details	Registers functions for handlers. This only needs to be called
+			once for each type of dictionary that is present.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+sadict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Appends a record to a sorted array dictionary that has not
+			been read yet.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert, greater than every key inserted
+				before it.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion, see @ref sa_append.
+*/
+ion_status_t
+sadict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value stored under a key, sealing the array on
+			the first read.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+sadict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at the value stored under a key, in the array, for
+			@ref dictionary_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the query.
+*/
+ion_status_t
+sadict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Creates an empty sorted array dictionary.
+
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The number of records to make room for, 0 for
+				@ref ION_SA_INITIAL_RECORDS.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+sadict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Refuses to delete a record, as a sorted array cannot change.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		@c err_not_implemented.
+*/
+ion_status_t
+sadict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a sorted array dictionary.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+sadict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Refuses to update a record, as a sorted array cannot change.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		@c err_not_implemented.
+*/
+ion_status_t
+sadict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records that satisfy a predicate, sealing the array
+			first.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+sadict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a sorted array cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+sadict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a sorted array cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+sadict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opens a sorted array dictionary, which is not implemented, as
+			it is kept in memory only.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		@c err_not_implemented.
+*/
+ion_err_t
+sadict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes a sorted array dictionary, which is not implemented, as
+			it is kept in memory only.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		@c err_not_implemented.
+*/
+ion_err_t
+sadict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SORTED_ARRAY_DICTIONARY_HANDLER_H_ */
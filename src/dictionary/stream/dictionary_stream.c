@@ -0,0 +1,619 @@
+/******************************************************************************/
+/**
+@file
+@brief		Export and import of dictionaries as streams of records, see
+			@ref dictionary_stream.h.
+*/
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "dictionary_stream.h"
+#include "../../file/page_codec.h"
+
+/**
+@brief		The bytes a stream begins with.
+*/
+#define ION_STREAM_MAGIC "IONS"
+
+/**
+@brief		The bytes of the header of a stream: its magic, version,
+			options, key type, a spare byte, and its key size, value size
+			and most records in a block as 4 bytes each.
+*/
+#define ION_STREAM_HEADER_SIZE 20
+
+/**
+@brief		The bytes of the header of a block: its count of records, the
+			length it takes in the stream and the hash of its records as
+			4 bytes each, then how it is coded.
+*/
+#define ION_STREAM_BLOCK_HEADER_SIZE 13
+
+/**
+@brief		How a block is coded, after its header.
+*/
+typedef enum ION_STREAM_CODING {
+	ion_stream_raw,		/**< Its records as they are. */
+	ion_stream_packed	/**< Its records through @ref page_codec_compress. */
+} ion_stream_coding_t;
+
+/**
+@brief		A block of records on its way to or from a stream.
+*/
+typedef struct {
+	FILE				*stream;			/**< The stream. */
+	ion_byte_t			*raw;				/**< The keys of the block, then
+												 its values. */
+	ion_byte_t			*packed;			/**< The block compressed. */
+	int					packed_cap;			/**< The room in @c packed. */
+	int					block_records;		/**< The most records a block
+												 holds. */
+	ion_key_size_t		key_size;			/**< The bytes of each key. */
+	ion_value_size_t	value_size;			/**< The bytes of each value. */
+	int					count;				/**< The records in @c raw. */
+	int					at;					/**< The next record read of it. */
+	uint32_t			records;			/**< The records of the blocks
+												 before it. */
+	ion_boolean_t		ended;				/**< Whether the end block was
+												 read. */
+	ion_err_t			error;				/**< Why reading stopped, if it
+												 did. */
+} ion_stream_block_t;
+
+/**
+@brief		Stores a number as 4 bytes, least significant first.
+*/
+static void
+dictionary_stream_put32(
+	ion_byte_t	*at,
+	uint32_t	number
+) {
+	at[0]	= (ion_byte_t) number;
+	at[1]	= (ion_byte_t) (number >> 8);
+	at[2]	= (ion_byte_t) (number >> 16);
+	at[3]	= (ion_byte_t) (number >> 24);
+}
+
+/**
+@brief		Reads a number stored by @ref dictionary_stream_put32.
+*/
+static uint32_t
+dictionary_stream_get32(
+	const ion_byte_t *at
+) {
+	return (uint32_t) at[0] | ((uint32_t) at[1] << 8) | ((uint32_t) at[2] << 16) | ((uint32_t) at[3] << 24);
+}
+
+/**
+@brief		Takes the buffers of a block of records of a dictionary.
+*/
+static ion_err_t
+dictionary_stream_block_init(
+	ion_stream_block_t	*block,
+	FILE				*stream,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					block_records
+) {
+	long raw_size = (long) block_records * (key_size + value_size);
+
+	memset(block, 0, sizeof(*block));
+	block->stream			= stream;
+	block->key_size			= key_size;
+	block->value_size		= value_size;
+	block->block_records	= block_records;
+	block->error			= err_ok;
+
+	/* incompressible blocks grow by about one byte in 255 */
+	if (raw_size <= PAGE_CODEC_MAX_PAGE) {
+		block->packed_cap	= (int) (raw_size + raw_size / 255 + 16);
+		block->packed		= ion_alloc(ion_alloc_buffer, block->packed_cap);
+	}
+
+	block->raw = ion_alloc(ion_alloc_buffer, raw_size);
+
+	if ((NULL == block->raw) || ((0 != block->packed_cap) && (NULL == block->packed))) {
+		ion_free(block->raw);
+		ion_free(block->packed);
+		return err_out_of_memory;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Frees the buffers of a block.
+*/
+static void
+dictionary_stream_block_free(
+	ion_stream_block_t *block
+) {
+	ion_free(block->raw);
+	ion_free(block->packed);
+}
+
+/**
+@brief		Writes the records of a block, their keys at the front of it
+			and their values @c block_records keys in.
+*/
+static ion_err_t
+dictionary_stream_write_block(
+	ion_stream_block_t	*block,
+	ion_boolean_t		compress
+) {
+	ion_byte_t	header[ION_STREAM_BLOCK_HEADER_SIZE];
+	int			keys_size	= block->count * block->key_size;
+	int			raw_size	= block->count * (block->key_size + block->value_size);
+	ion_byte_t	*out		= block->raw;
+	int			length		= raw_size;
+	int			packed;
+
+	/* the values of a short block follow its keys */
+	memmove(block->raw + keys_size, block->raw + block->block_records * block->key_size, block->count * block->value_size);
+
+	if (compress && (NULL != block->packed) && (0 < (packed = page_codec_compress(block->raw, raw_size, block->packed, block->packed_cap))) && (packed < raw_size)) {
+		out		= block->packed;
+		length	= packed;
+	}
+
+	dictionary_stream_put32(header, (uint32_t) block->count);
+	dictionary_stream_put32(header + 4, (uint32_t) length);
+	dictionary_stream_put32(header + 8, dictionary_hash_bytes(block->raw, raw_size, 0));
+	header[12] = (ion_byte_t) ((out == block->raw) ? ion_stream_raw : ion_stream_packed);
+
+	if ((1 != fwrite(header, sizeof(header), 1, block->stream)) || (1 != fwrite(out, length, 1, block->stream))) {
+		return err_file_write_error;
+	}
+
+	block->records	+= block->count;
+	block->count	= 0;
+	return err_ok;
+}
+
+/**
+@brief		Orders records by their keys, keeping records of equal keys in
+			the order they were given.
+@param		keys
+				The keys of the records, back to back.
+@param		order
+				The indexes of the records, put in the order of their keys.
+@param		scratch
+				Room for as many indexes.
+*/
+static void
+dictionary_stream_sort(
+	ion_dictionary_t	*dictionary,
+	ion_byte_t			*keys,
+	int					*order,
+	int					*scratch,
+	int					count
+) {
+	ion_key_size_t	key_size = dictionary->instance->record.key_size;
+	int				*from	= order;
+	int				*to		= scratch;
+	int				*swap;
+	int				width;
+	int				start;
+	int				middle;
+	int				end;
+	int				left;
+	int				right;
+	int				i;
+
+	for (i = 0; i < count; i++) {
+		order[i] = i;
+	}
+
+	/* bottom up, runs of width merged into runs of twice that */
+	for (width = 1; width < count; width *= 2) {
+		for (start = 0; start < count; start += 2 * width) {
+			middle	= (start + width < count) ? start + width : count;
+			end		= (start + 2 * width < count) ? start + 2 * width : count;
+			left	= start;
+			right	= middle;
+
+			for (i = start; i < end; i++) {
+				if ((left < middle) && ((right == end) || (0 >= dictionary->instance->compare(keys + from[left] * key_size, keys + from[right] * key_size, key_size)))) {
+					to[i] = from[left++];
+				}
+				else {
+					to[i] = from[right++];
+				}
+			}
+		}
+
+		swap	= from;
+		from	= to;
+		to		= swap;
+	}
+
+	if (from != order) {
+		memcpy(order, from, count * sizeof(int));
+	}
+}
+
+/**
+@brief		Reads every record of a cursor into memory, within
+			@ref ION_STREAM_SORT_BUDGET.
+*/
+static ion_err_t
+dictionary_stream_read_all(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			**keys,
+	ion_byte_t			**values,
+	int					*count
+) {
+	ion_key_size_t		key_size	= cursor->dictionary->instance->record.key_size;
+	ion_value_size_t	value_size	= cursor->dictionary->instance->record.value_size;
+	int					capacity	= (int) (ION_STREAM_SORT_BUDGET / (key_size + value_size));
+	int					room		= 0;
+	ion_byte_t			*grown;
+
+	*count = 0;
+
+	while (cs_end_of_results != cursor->status) {
+		if (*count == room) {
+			if (room == capacity) {
+				return err_out_of_memory;
+			}
+
+			room = (0 == room) ? 64 : room * 2;
+
+			if (room > capacity) {
+				room = capacity;
+			}
+
+			if (NULL == (grown = ion_realloc(ion_alloc_buffer, *keys, (size_t) room * key_size))) {
+				return err_out_of_memory;
+			}
+
+			*keys = grown;
+
+			if (NULL == (grown = ion_realloc(ion_alloc_buffer, *values, (size_t) room * value_size))) {
+				return err_out_of_memory;
+			}
+
+			*values = grown;
+		}
+
+		*count += dictionary_next_batch(cursor, *keys + (size_t) *count * key_size, *values + (size_t) *count * value_size, room - *count);
+
+		if ((*count < room) && (cs_end_of_results != cursor->status)) {
+			return err_illegal_state;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the records of a cursor in the order it gives them,
+			checking that order if the stream is sorted.
+*/
+static ion_err_t
+dictionary_stream_write_cursor(
+	ion_stream_block_t	*block,
+	ion_dict_cursor_t	*cursor,
+	ion_boolean_t		sorted,
+	ion_boolean_t		compress
+) {
+	ion_dictionary_t	*dictionary = cursor->dictionary;
+	ion_byte_t			*key;
+	ion_byte_t			*last		= NULL;
+	ion_err_t			err;
+	int					read;
+	int					i;
+
+	if (sorted && (NULL == (last = ion_alloc(ion_alloc_buffer, block->key_size)))) {
+		return err_out_of_memory;
+	}
+
+	for (err = err_ok; (err_ok == err) && (cs_end_of_results != cursor->status); ) {
+		read = dictionary_next_batch(cursor, block->raw, block->raw + block->block_records * block->key_size, block->block_records);
+
+		if ((read < block->block_records) && (cs_end_of_results != cursor->status)) {
+			err = err_illegal_state;
+			break;
+		}
+
+		for (i = 0; sorted && (i < read); i++) {
+			key = block->raw + i * block->key_size;
+
+			if ((0 != block->records + i) && (0 < dictionary->instance->compare(last, key, block->key_size))) {
+				err = err_sorted_order_violation;
+				break;
+			}
+
+			memcpy(last, key, block->key_size);
+		}
+
+		block->count = read;
+
+		if ((err_ok == err) && (0 != read)) {
+			err = dictionary_stream_write_block(block, compress);
+		}
+	}
+
+	ion_free(last);
+	return err;
+}
+
+/**
+@brief		Sorts the records of a cursor in memory, then writes them.
+*/
+static ion_err_t
+dictionary_stream_write_sorted(
+	ion_stream_block_t	*block,
+	ion_dict_cursor_t	*cursor,
+	ion_boolean_t		compress
+) {
+	ion_byte_t	*keys	= NULL;
+	ion_byte_t	*values = NULL;
+	int			*order	= NULL;
+	int			*scratch = NULL;
+	ion_err_t	err;
+	int			count;
+	int			i;
+
+	err = dictionary_stream_read_all(cursor, &keys, &values, &count);
+
+	if ((err_ok == err) && (0 != count)) {
+		order	= ion_alloc(ion_alloc_buffer, count * sizeof(int));
+		scratch = ion_alloc(ion_alloc_buffer, count * sizeof(int));
+
+		if ((NULL == order) || (NULL == scratch)) {
+			err = err_out_of_memory;
+		}
+	}
+
+	if ((err_ok == err) && (0 != count)) {
+		dictionary_stream_sort(cursor->dictionary, keys, order, scratch, count);
+
+		for (i = 0; (i < count) && (err_ok == err); i++) {
+			memcpy(block->raw + block->count * block->key_size, keys + (size_t) order[i] * block->key_size, block->key_size);
+			memcpy(block->raw + block->block_records * block->key_size + block->count * block->value_size, values + (size_t) order[i] * block->value_size, block->value_size);
+
+			if (++block->count == block->block_records) {
+				err = dictionary_stream_write_block(block, compress);
+			}
+		}
+
+		if ((err_ok == err) && (0 != block->count)) {
+			err = dictionary_stream_write_block(block, compress);
+		}
+	}
+
+	ion_free(keys);
+	ion_free(values);
+	ion_free(order);
+	ion_free(scratch);
+	return err;
+}
+
+ion_status_t
+dictionary_export(
+	ion_dictionary_t	*dictionary,
+	FILE				*stream,
+	int					options
+) {
+	ion_key_size_t			key_size	= dictionary->instance->record.key_size;
+	ion_value_size_t		value_size	= dictionary->instance->record.value_size;
+	int						block_records = ION_STREAM_BLOCK_SIZE / (key_size + value_size);
+	ion_boolean_t			compress	= (0 != (options & ion_stream_compressed));
+	ion_byte_t				header[ION_STREAM_HEADER_SIZE];
+	ion_stream_block_t		block;
+	ion_dictionary_info_t	info;
+	ion_predicate_t			predicate;
+	ion_dict_cursor_t		*cursor		= NULL;
+	ion_boolean_t			sorted;
+	ion_err_t				err;
+
+	if (0 == block_records) {
+		block_records = 1;
+	}
+
+	info.min_key	= NULL;
+	info.max_key	= NULL;
+	dictionary_get_info(dictionary, &info);
+	sorted			= info.ordered || (0 != (options & ion_stream_sorted));
+
+	if (err_ok != (err = dictionary_stream_block_init(&block, stream, key_size, value_size, block_records))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	memcpy(header, ION_STREAM_MAGIC, 4);
+	header[4]	= ION_STREAM_VERSION;
+	header[5]	= (ion_byte_t) ((sorted ? ion_stream_sorted : 0) | (compress ? ion_stream_compressed : 0));
+	header[6]	= (ion_byte_t) dictionary->instance->key_type;
+	header[7]	= 0;
+	dictionary_stream_put32(header + 8, (uint32_t) key_size);
+	dictionary_stream_put32(header + 12, (uint32_t) value_size);
+	dictionary_stream_put32(header + 16, (uint32_t) block_records);
+
+	if (1 != fwrite(header, sizeof(header), 1, stream)) {
+		err = err_file_write_error;
+	}
+	else if ((err_ok == (err = dictionary_build_predicate(&predicate, predicate_all_records))) && (err_ok == (err = dictionary_find(dictionary, &predicate, &cursor)))) {
+		err = (sorted && !info.ordered) ? dictionary_stream_write_sorted(&block, cursor, compress) : dictionary_stream_write_cursor(&block, cursor, sorted, compress);
+	}
+
+	if (NULL != cursor) {
+		cursor->destroy(&cursor);
+	}
+
+	/* the end block counts the records, and has no hash */
+	if (err_ok == err) {
+		memset(header, 0, ION_STREAM_BLOCK_HEADER_SIZE);
+		dictionary_stream_put32(header + 8, block.records);
+
+		if (1 != fwrite(header, ION_STREAM_BLOCK_HEADER_SIZE, 1, stream)) {
+			err = err_file_write_error;
+		}
+	}
+
+	dictionary_stream_block_free(&block);
+
+	return (ion_status_t) { err, (ion_result_count_t) block.records };
+}
+
+/**
+@brief		Reads the next block of a stream, or its end.
+@return		@c err_ok if a block of records was read, @c err_item_not_found
+			at the end of the stream, or why no block could be read.
+*/
+static ion_err_t
+dictionary_stream_read_block(
+	ion_stream_block_t *block
+) {
+	ion_byte_t	header[ION_STREAM_BLOCK_HEADER_SIZE];
+	uint32_t	count;
+	uint32_t	length;
+	int			raw_size;
+
+	block->at		= 0;
+	block->records	+= block->count;
+	block->count	= 0;
+
+	if (1 != fread(header, sizeof(header), 1, block->stream)) {
+		return err_file_incomplete_read;
+	}
+
+	count	= dictionary_stream_get32(header);
+	length	= dictionary_stream_get32(header + 4);
+
+	if (0 == count) {
+		block->ended = boolean_true;
+		return ((0 == length) && (dictionary_stream_get32(header + 8) == block->records)) ? err_item_not_found : err_file_read_error;
+	}
+
+	if (count > (uint32_t) block->block_records) {
+		return err_file_read_error;
+	}
+
+	raw_size = (int) count * (block->key_size + block->value_size);
+
+	if (ion_stream_raw == header[12]) {
+		if (length != (uint32_t) raw_size) {
+			return err_file_read_error;
+		}
+
+		if (1 != fread(block->raw, raw_size, 1, block->stream)) {
+			return err_file_incomplete_read;
+		}
+	}
+	else if ((ion_stream_packed == header[12]) && (length <= (uint32_t) block->packed_cap)) {
+		if (1 != fread(block->packed, length, 1, block->stream)) {
+			return err_file_incomplete_read;
+		}
+
+		if (raw_size != page_codec_decompress(block->packed, (int) length, block->raw, raw_size)) {
+			return err_file_read_error;
+		}
+	}
+	else {
+		return err_file_read_error;
+	}
+
+	if (dictionary_hash_bytes(block->raw, raw_size, 0) != dictionary_stream_get32(header + 8)) {
+		return err_file_read_error;
+	}
+
+	block->count = (int) count;
+	return err_ok;
+}
+
+/**
+@brief		Gives a bulk load the next record of a stream.
+*/
+static ion_err_t
+dictionary_stream_next(
+	void			*context,
+	ion_record_t	*record
+) {
+	ion_stream_block_t	*block = context;
+	ion_err_t			err;
+
+	while (block->at == block->count) {
+		if (block->ended) {
+			return err_item_not_found;
+		}
+
+		if (err_ok != (err = dictionary_stream_read_block(block))) {
+			if (err_item_not_found != err) {
+				block->error = err;
+			}
+
+			return err;
+		}
+	}
+
+	memcpy(record->key, block->raw + block->at * block->key_size, block->key_size);
+	memcpy(record->value, block->raw + block->count * block->key_size + block->at * block->value_size, block->value_size);
+	block->at++;
+	return err_ok;
+}
+
+ion_status_t
+dictionary_import(
+	ion_dictionary_t	*dictionary,
+	FILE				*stream
+) {
+	ion_key_size_t		key_size	= dictionary->instance->record.key_size;
+	ion_value_size_t	value_size	= dictionary->instance->record.value_size;
+	ion_byte_t			header[ION_STREAM_HEADER_SIZE];
+	ion_stream_block_t	block;
+	ion_status_t		status		= ION_STATUS_OK(0);
+	ion_status_t		inserted;
+	uint32_t			block_records;
+	ion_err_t			err;
+
+	if (1 != fread(header, sizeof(header), 1, stream)) {
+		return ION_STATUS_ERROR(err_file_incomplete_read);
+	}
+
+	if ((0 != memcmp(header, ION_STREAM_MAGIC, 4)) || (ION_STREAM_VERSION < header[4])) {
+		return ION_STATUS_ERROR(err_file_read_error);
+	}
+
+	block_records = dictionary_stream_get32(header + 16);
+
+	if ((header[6] != (ion_byte_t) dictionary->instance->key_type) || (dictionary_stream_get32(header + 8) != (uint32_t) key_size) || (dictionary_stream_get32(header + 12) != (uint32_t) value_size)) {
+		return ION_STATUS_ERROR(err_illegal_state);
+	}
+
+	if ((0 == block_records) || (block_records > (uint32_t) (0x7FFFFFFF / (key_size + value_size)))) {
+		return ION_STATUS_ERROR(err_file_read_error);
+	}
+
+	if (err_ok != (err = dictionary_stream_block_init(&block, stream, key_size, value_size, (int) block_records))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	if (0 != (header[5] & ion_stream_sorted)) {
+		status = dictionary_bulk_load(dictionary, dictionary_stream_next, &block);
+
+		/* the error of the stream, not what the load made of it */
+		if (err_ok != block.error) {
+			status.error = block.error;
+		}
+	}
+	else {
+		while (err_ok == (err = dictionary_stream_read_block(&block))) {
+			inserted		= dictionary_insert_many(dictionary, block.raw, block.raw + block.count * key_size, NULL, block.count);
+			status.count	+= inserted.count;
+
+			if (err_ok != inserted.error) {
+				err = inserted.error;
+				break;
+			}
+		}
+
+		if (err_item_not_found != err) {
+			status.error = err;
+		}
+	}
+
+	dictionary_stream_block_free(&block);
+	return status;
+}
@@ -0,0 +1,130 @@
+/******************************************************************************/
+/**
+@file
+@brief		Export of a dictionary to a stream of its records, and import of
+			such a stream into another, of any engine.
+@details	A stream is a header giving its version, its options and the
+			key type and sizes of its records, then blocks of records and
+			an end block. A block holds the keys of its records back to
+			back and then their values, as @ref dictionary_insert_many and
+			@ref dictionary_next_batch lay them out, checked by a hash and
+			compressed with @ref page_codec_compress when asked and when
+			that makes it smaller. The end block counts the records that
+			came before it, so a stream cut short after a whole block is
+			still caught.
+
+			A sorted stream holds its records in ascending key order, and
+			its import goes through @ref dictionary_bulk_load, which builds
+			an empty B+ tree or skiplist bottom up in one pass. Engines
+			whose cursors give their records in key order are exported
+			sorted as they are read. Others are sorted in memory first, if
+			asked to be, within @ref ION_STREAM_SORT_BUDGET.
+
+			The numbers of the header and blocks are little endian, so any
+			device reads them; keys and values are as the dictionary holds
+			them, so numeric keys and values only move between devices of
+			the same byte order.
+*/
+/******************************************************************************/
+
+#if !defined(DICTIONARY_STREAM_H_)
+#define DICTIONARY_STREAM_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "../dictionary_types.h"
+#include "../dictionary.h"
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		The version of the streams written, the newest one read.
+*/
+#define ION_STREAM_VERSION 1
+
+/**
+@brief		The bytes of records, keys and values, a block holds at most,
+			unless a single record is larger.
+@details	Larger blocks compress better and cost fewer calls, but take
+			twice their size in buffers on each side.
+*/
+#if !defined(ION_STREAM_BLOCK_SIZE)
+#if defined(ARDUINO)
+#define ION_STREAM_BLOCK_SIZE 256
+#else
+#define ION_STREAM_BLOCK_SIZE 32768
+#endif
+#endif
+
+/**
+@brief		How many bytes of records an export sorts in memory, for
+			dictionaries whose cursors do not give them in key order.
+*/
+#if !defined(ION_STREAM_SORT_BUDGET)
+#if defined(ARDUINO)
+#define ION_STREAM_SORT_BUDGET 1024
+#else
+#define ION_STREAM_SORT_BUDGET 67108864
+#endif
+#endif
+
+/**
+@brief		Options of an export, combined with @c |.
+*/
+typedef enum ION_STREAM_OPTION {
+	ion_stream_sorted		= 1,/**< Write the records in ascending key
+									 order, sorting them if the dictionary
+									 does not give them so. */
+	ion_stream_compressed	= 2	/**< Compress each block that shrinks. */
+} ion_stream_option_t;
+
+/**
+@brief		Writes every record of a dictionary to a stream.
+@param		dictionary
+				The open dictionary to export.
+@param		stream
+				Where the stream is written, from where it stands.
+@param		options
+				@ref ion_stream_option_t flags.
+@return		The number of records written, with the error that stopped
+			the export, if any. @c err_out_of_memory if records needing a
+			sort are more than @ref ION_STREAM_SORT_BUDGET, and
+			@c err_sorted_order_violation if a dictionary said to give its
+			records in order did not.
+*/
+ion_status_t
+dictionary_export(
+	ion_dictionary_t	*dictionary,
+	FILE				*stream,
+	int					options
+);
+
+/**
+@brief		Inserts the records of a stream written by
+			@ref dictionary_export into a dictionary.
+@details	The dictionary must have the key type and sizes of the stream.
+			A sorted stream is bulk loaded, see @ref dictionary_bulk_load;
+			the blocks of an unsorted one are inserted a block at a time.
+@param		dictionary
+				The open dictionary to import into.
+@param		stream
+				Where the stream is read, from where it stands.
+@return		The number of records inserted, with the error that stopped
+			the import, if any. @c err_illegal_state if the records of the
+			stream do not fit the dictionary, @c err_file_read_error if it
+			is not a stream, or a version too new or damaged, and
+			@c err_file_incomplete_read if it ends too soon.
+*/
+ion_status_t
+dictionary_import(
+	ion_dictionary_t	*dictionary,
+	FILE				*stream
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* DICTIONARY_STREAM_H_ */
@@ -0,0 +1,859 @@
+/******************************************************************************/
+/**
+@file
+@brief		An append-only store of records keyed by time.
+@details	The file starts with a header the size of a block, then holds
+			the blocks, each in a slot of its own. A block starts with its
+			seq, the number of records it holds and the bytes they take,
+			as little endian integers of 4, 2 and 2 bytes, followed by its
+			least and greatest keys. The records come next, each one a
+			varint key distance, missing from the first, then the value.
+			The greatest seq is the tail; blocks with a seq below the one
+			in the header were dropped and their slots are free.
+*/
+/******************************************************************************/
+
+#include "time_series.h"
+
+/**
+@brief		Marks the file as a time series.
+*/
+#define ION_TS_MAGIC			"ITS1"
+
+/**
+@brief		The bytes of the file header that are used.
+*/
+#define ION_TS_HEADER_BYTES		12
+
+/**
+@brief		The bytes before the bounds of a block.
+*/
+#define ION_TS_BLOCK_HEADER		8
+
+/**
+@brief		The most bytes a varint of 64 bits takes.
+*/
+#define ION_TS_MAX_VARINT		10
+
+/**
+@brief		Writes a little endian integer of @p bytes bytes.
+*/
+static void
+ts_put(
+	ion_byte_t	*to,
+	uint32_t	value,
+	int			bytes
+) {
+	int i;
+
+	for (i = 0; i < bytes; i++) {
+		to[i] = (ion_byte_t) (value >> (8 * i));
+	}
+}
+
+/**
+@brief		Reads a little endian integer of @p bytes bytes.
+*/
+static uint32_t
+ts_get(
+	const ion_byte_t	*from,
+	int					bytes
+) {
+	uint32_t	value = 0;
+	int			i;
+
+	for (i = 0; i < bytes; i++) {
+		value |= (uint32_t) from[i] << (8 * i);
+	}
+
+	return value;
+}
+
+/**
+@brief		The bits of a key, as an unsigned integer.
+*/
+static uint64_t
+ts_key_bits(
+	ion_time_series_t	*time_series,
+	ion_key_t			key
+) {
+	switch (time_series->super.record.key_size) {
+		case 1: {
+			uint8_t bits;
+
+			memcpy(&bits, key, sizeof(bits));
+			return bits;
+		}
+
+		case 2: {
+			uint16_t bits;
+
+			memcpy(&bits, key, sizeof(bits));
+			return bits;
+		}
+
+		case 4: {
+			uint32_t bits;
+
+			memcpy(&bits, key, sizeof(bits));
+			return bits;
+		}
+
+		default: {
+			uint64_t bits;
+
+			memcpy(&bits, key, sizeof(bits));
+			return bits;
+		}
+	}
+}
+
+/**
+@brief		Writes the bits of a key back as a key, dropping those that do
+			not fit.
+*/
+static void
+ts_bits_key(
+	ion_time_series_t	*time_series,
+	uint64_t			bits,
+	ion_key_t			key
+) {
+	switch (time_series->super.record.key_size) {
+		case 1: {
+			uint8_t narrow = (uint8_t) bits;
+
+			memcpy(key, &narrow, sizeof(narrow));
+			break;
+		}
+
+		case 2: {
+			uint16_t narrow = (uint16_t) bits;
+
+			memcpy(key, &narrow, sizeof(narrow));
+			break;
+		}
+
+		case 4: {
+			uint32_t narrow = (uint32_t) bits;
+
+			memcpy(key, &narrow, sizeof(narrow));
+			break;
+		}
+
+		default: {
+			memcpy(key, &bits, sizeof(bits));
+			break;
+		}
+	}
+}
+
+/**
+@brief		The bytes a varint of @p value takes.
+*/
+static int
+ts_varint_size(
+	uint64_t value
+) {
+	int size = 1;
+
+	while (value > 0x7F) {
+		value >>= 7;
+		size++;
+	}
+
+	return size;
+}
+
+/**
+@brief		The bytes before the first record of a block.
+*/
+static int
+ts_records_start(
+	ion_time_series_t *time_series
+) {
+	return ION_TS_BLOCK_HEADER + 2 * time_series->super.record.key_size;
+}
+
+/**
+@brief		The offset of the slot after the file header at @p slot.
+*/
+static ion_file_offset_t
+ts_slot_offset(
+	ion_time_series_t	*time_series,
+	long				slot
+) {
+	return (ion_file_offset_t) (slot + 1) * time_series->block_size;
+}
+
+/**
+@brief		Writes the seq of the oldest block and the block size to the
+			file header.
+*/
+static ion_err_t
+ts_write_header(
+	ion_time_series_t *time_series
+) {
+	ion_byte_t header[ION_TS_HEADER_BYTES];
+
+	memcpy(header, ION_TS_MAGIC, 4);
+	ts_put(header + 4, time_series->head_seq, 4);
+	ts_put(header + 8, (uint32_t) time_series->block_size, 4);
+
+	return ion_fwrite_at(time_series->file, 0, ION_TS_HEADER_BYTES, header);
+}
+
+/**
+@brief		Makes room for one more entry at the end of the directory,
+			moving the entries to the front or doubling the room.
+*/
+static ion_err_t
+ts_grow_directory(
+	ion_time_series_t *time_series
+) {
+	ion_byte_t	*directory;
+	long		capacity;
+
+	if (time_series->first + time_series->count < time_series->capacity) {
+		return err_ok;
+	}
+
+	/* moving is only worth it if it frees at least half the room */
+	if (time_series->first >= time_series->capacity / 2) {
+		memmove(time_series->directory, time_series->directory + time_series->first * time_series->entry_size, time_series->count * time_series->entry_size);
+		time_series->first = 0;
+		return err_ok;
+	}
+
+	capacity	= 2 * time_series->capacity;
+	directory	= ion_realloc(ion_alloc_node, time_series->directory, capacity * time_series->entry_size);
+
+	if (NULL == directory) {
+		return err_out_of_memory;
+	}
+
+	time_series->directory	= directory;
+	time_series->capacity	= capacity;
+
+	return err_ok;
+}
+
+/**
+@brief		Adds an entry for a block of the file to the end of the
+			directory.
+*/
+static ion_err_t
+ts_push_block(
+	ion_time_series_t	*time_series,
+	ion_file_offset_t	offset,
+	ion_byte_t			*block
+) {
+	ion_key_size_t	key_size = time_series->super.record.key_size;
+	ion_ts_block_t	*entry;
+	ion_err_t		err;
+
+	if (err_ok != (err = ts_grow_directory(time_series))) {
+		return err;
+	}
+
+	entry			= ION_TS_ENTRY(time_series, time_series->count);
+	entry->offset	= offset;
+	entry->seq		= ts_get(block, 4);
+	entry->count	= (uint16_t) ION_TS_BLOCK_COUNT(block);
+	memcpy(entry + 1, block + ION_TS_BLOCK_HEADER, 2 * key_size);
+	time_series->count++;
+
+	return err_ok;
+}
+
+/**
+@brief		Keeps the slot of a dropped block for a later block.
+*/
+static ion_err_t
+ts_free_slot(
+	ion_time_series_t	*time_series,
+	ion_file_offset_t	offset
+) {
+	ion_file_offset_t	*free_slots;
+	long				capacity;
+
+	if (time_series->free_count == time_series->free_capacity) {
+		capacity	= (0 == time_series->free_capacity) ? ION_TS_INITIAL_BLOCKS : 2 * time_series->free_capacity;
+		free_slots	= ion_realloc(ion_alloc_node, time_series->free_slots, capacity * sizeof(ion_file_offset_t));
+
+		if (NULL == free_slots) {
+			return err_out_of_memory;
+		}
+
+		time_series->free_slots		= free_slots;
+		time_series->free_capacity	= capacity;
+	}
+
+	time_series->free_slots[time_series->free_count++] = offset;
+
+	return err_ok;
+}
+
+/**
+@brief		Orders directory entries by seq.
+*/
+static int
+ts_compare_seq(
+	const void	*a,
+	const void	*b
+) {
+	uint32_t	seq_a	= ((const ion_ts_block_t *) a)->seq;
+	uint32_t	seq_b	= ((const ion_ts_block_t *) b)->seq;
+
+	return (seq_a > seq_b) - (seq_a < seq_b);
+}
+
+/**
+@brief		Builds the directory from the blocks of an existing file,
+			freeing the slots of dropped blocks, and takes the newest
+			block back as the tail.
+*/
+static ion_err_t
+ts_load(
+	ion_time_series_t *time_series
+) {
+	ion_byte_t			header[ION_TS_HEADER_BYTES];
+	ion_file_offset_t	file_end	= ion_fend(time_series->file);
+	ion_file_offset_t	offset;
+	ion_err_t			err;
+	long				slot;
+
+	if (err_ok != (err = ion_fread_at(time_series->file, 0, ION_TS_HEADER_BYTES, header))) {
+		return err;
+	}
+
+	if (0 != memcmp(header, ION_TS_MAGIC, 4)) {
+		return err_dictionary_initialization_failed;
+	}
+
+	time_series->head_seq	= ts_get(header + 4, 4);
+	time_series->block_size = (int) ts_get(header + 8, 4);
+	time_series->next_seq	= time_series->head_seq;
+
+	for (slot = 0; (offset = ts_slot_offset(time_series, slot)) < file_end; slot++) {
+		if (err_ok != (err = ion_fread_at(time_series->file, offset, ts_records_start(time_series), time_series->tail))) {
+			return err;
+		}
+
+		if ((ts_get(time_series->tail, 4) < time_series->head_seq) || (0 == ION_TS_BLOCK_COUNT(time_series->tail))) {
+			err = ts_free_slot(time_series, offset);
+		}
+		else {
+			err = ts_push_block(time_series, offset, time_series->tail);
+		}
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+	time_series->end = ts_slot_offset(time_series, slot);
+
+	if (0 == time_series->count) {
+		return err_ok;
+	}
+
+	/* slots are reused by newer blocks, so the file is not in seq order */
+	qsort(time_series->directory, time_series->count, time_series->entry_size, ts_compare_seq);
+	time_series->next_seq = ION_TS_ENTRY(time_series, time_series->count - 1)->seq + 1;
+
+	return ion_fread_at(time_series->file, ION_TS_ENTRY(time_series, time_series->count - 1)->offset, time_series->block_size, time_series->tail);
+}
+
+ion_err_t
+ts_initialize(
+	ion_time_series_t	*time_series,
+	ion_dictionary_id_t id,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					block_size
+) {
+	char		filename[ION_MAX_FILENAME_LENGTH];
+	ion_err_t	err;
+
+	if (((key_type_numeric_signed != key_type) && (key_type_numeric_unsigned != key_type)) || ((1 != key_size) && (2 != key_size) && (4 != key_size) && (8 != key_size))) {
+		return err_invalid_initial_size;
+	}
+
+	if (dictionary_get_filename(id, "tsb", filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_initialization_failed;
+	}
+
+	time_series->super.id				= id;
+	time_series->super.key_type			= key_type;
+	time_series->super.record.key_size	= key_size;
+	time_series->super.record.value_size = value_size;
+	time_series->block_size				= (0 == block_size) ? ION_TS_BLOCK_SIZE : block_size;
+	/* the bounds follow the entry, which keeps the alignment of its offset */
+	time_series->entry_size				= (int) ((sizeof(ion_ts_block_t) + 2 * key_size + sizeof(ion_file_offset_t) - 1) / sizeof(ion_file_offset_t) * sizeof(ion_file_offset_t));
+	time_series->first					= 0;
+	time_series->count					= 0;
+	time_series->capacity				= ION_TS_INITIAL_BLOCKS;
+	time_series->free_slots				= NULL;
+	time_series->free_count				= 0;
+	time_series->free_capacity			= 0;
+	time_series->head_seq				= 0;
+	time_series->next_seq				= 0;
+	time_series->tail_dirty				= boolean_false;
+	time_series->reads					= 0;
+	time_series->file					= ion_fopen(filename);
+
+#if defined(ARDUINO)
+
+	if (NULL == time_series->file.file) {
+#else
+
+	if (ION_NOFILE == time_series->file) {
+#endif
+		return err_file_open_error;
+	}
+
+	/* an existing file keeps its own block size, which is read first */
+	if (0 != ion_fend(time_series->file)) {
+		ion_byte_t header[ION_TS_HEADER_BYTES];
+
+		if ((err_ok == ion_fread_at(time_series->file, 0, ION_TS_HEADER_BYTES, header)) && (0 == memcmp(header, ION_TS_MAGIC, 4))) {
+			time_series->block_size = (int) ts_get(header + 8, 4);
+		}
+	}
+
+	/* a block holds the first record and at least one more, its length kept in 2 bytes */
+	if ((time_series->block_size < ts_records_start(time_series) + 2 * value_size + ION_TS_MAX_VARINT) || (time_series->block_size > 0xFFFF)) {
+		ion_fclose(time_series->file);
+		return err_invalid_initial_size;
+	}
+
+	time_series->directory	= ion_alloc(ion_alloc_node, time_series->capacity * time_series->entry_size);
+	time_series->tail		= ion_alloc(ion_alloc_buffer, 2 * time_series->block_size);
+
+	if ((NULL == time_series->directory) || (NULL == time_series->tail)) {
+		ion_free(time_series->directory);
+		ion_free(time_series->tail);
+		ion_fclose(time_series->file);
+		return err_out_of_memory;
+	}
+
+	time_series->block = time_series->tail + time_series->block_size;
+
+	if (0 == ion_fend(time_series->file)) {
+		time_series->end	= ts_slot_offset(time_series, 0);
+		err					= ts_write_header(time_series);
+	}
+	else {
+		err = ts_load(time_series);
+	}
+
+	if (err_ok != err) {
+		ion_free(time_series->directory);
+		ion_free(time_series->tail);
+		ion_free(time_series->free_slots);
+		ion_fclose(time_series->file);
+	}
+
+	return err;
+}
+
+ion_err_t
+ts_flush(
+	ion_time_series_t *time_series
+) {
+	ion_err_t err;
+
+	if (!time_series->tail_dirty) {
+		return err_ok;
+	}
+
+	/* whole blocks, so every write covers the same sectors */
+	err = ion_fwrite_at(time_series->file, ION_TS_ENTRY(time_series, time_series->count - 1)->offset, time_series->block_size, time_series->tail);
+
+	if (err_ok == err) {
+		err = ion_fflush(time_series->file);
+	}
+
+	if (err_ok == err) {
+		time_series->tail_dirty = boolean_false;
+	}
+
+	return err;
+}
+
+ion_err_t
+ts_close(
+	ion_time_series_t *time_series
+) {
+	ion_err_t	err			= ts_flush(time_series);
+	ion_err_t	close_err	= ion_fclose(time_series->file);
+
+	ion_free(time_series->directory);
+	ion_free(time_series->tail);
+	ion_free(time_series->free_slots);
+	time_series->directory	= NULL;
+	time_series->tail		= NULL;
+	time_series->free_slots = NULL;
+
+	return (err_ok != err) ? err : close_err;
+}
+
+ion_err_t
+ts_destroy(
+	ion_time_series_t *time_series
+) {
+	char filename[ION_MAX_FILENAME_LENGTH];
+
+	dictionary_get_filename(time_series->super.id, "tsb", filename);
+
+	/* nothing written is kept, so the tail need not go out first */
+	time_series->tail_dirty = boolean_false;
+	ts_close(time_series);
+
+	return ion_fremove(filename);
+}
+
+/**
+@brief		Writes out the tail and starts a new, empty one in a free slot
+			or at the end of the file.
+*/
+static ion_err_t
+ts_new_tail(
+	ion_time_series_t *time_series
+) {
+	ion_file_offset_t	offset;
+	ion_err_t			err;
+
+	if ((0 != time_series->count) && (err_ok != (err = ts_flush(time_series)))) {
+		return err;
+	}
+
+	if (0 != time_series->free_count) {
+		offset = time_series->free_slots[time_series->free_count - 1];
+	}
+	else {
+		offset = time_series->end;
+	}
+
+	memset(time_series->tail, 0, time_series->block_size);
+	ts_put(time_series->tail, time_series->next_seq, 4);
+	ts_put(time_series->tail + 6, (uint32_t) ts_records_start(time_series), 2);
+
+	if (err_ok != (err = ts_push_block(time_series, offset, time_series->tail))) {
+		return err;
+	}
+
+	if (0 != time_series->free_count) {
+		time_series->free_count--;
+	}
+	else {
+		time_series->end += time_series->block_size;
+	}
+
+	time_series->next_seq++;
+
+	return err_ok;
+}
+
+ion_status_t
+ts_append(
+	ion_time_series_t	*time_series,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_key_size_t		key_size	= time_series->super.record.key_size;
+	ion_value_size_t	value_size	= time_series->super.record.value_size;
+	ion_ts_block_t		*entry		= NULL;
+	uint64_t			delta		= 0;
+	ion_byte_t			*max_key;
+	ion_byte_t			*at;
+	ion_err_t			err;
+	int					used;
+	int					count;
+
+	if (0 != time_series->count) {
+		entry	= ION_TS_ENTRY(time_series, time_series->count - 1);
+		max_key = ION_TS_MAX_KEY(time_series, time_series->count - 1);
+
+		if (0 < time_series->super.compare(max_key, key, key_size)) {
+			return ION_STATUS_ERROR(err_sorted_order_violation);
+		}
+
+		/* the distance wraps with the key width, so it is right for signed keys too */
+		delta = ts_key_bits(time_series, key) - ts_key_bits(time_series, max_key);
+
+		if (key_size < 8) {
+			delta &= ((uint64_t) 1 << (8 * key_size)) - 1;
+		}
+	}
+
+	used = (NULL == entry) ? 0 : (int) ts_get(time_series->tail + 6, 2);
+
+	if ((NULL == entry) || (used + ts_varint_size(delta) + value_size > time_series->block_size)) {
+		if (err_ok != (err = ts_new_tail(time_series))) {
+			return ION_STATUS_ERROR(err);
+		}
+
+		entry	= ION_TS_ENTRY(time_series, time_series->count - 1);
+		used	= ts_records_start(time_series);
+	}
+
+	count	= ION_TS_BLOCK_COUNT(time_series->tail);
+	at		= time_series->tail + used;
+
+	if (0 == count) {
+		memcpy(time_series->tail + ION_TS_BLOCK_HEADER, key, key_size);
+	}
+	else {
+		do {
+			*at++	= (ion_byte_t) ((delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0));
+			delta	>>= 7;
+		} while (0 != delta);
+	}
+
+	memcpy(at, value, value_size);
+	at += value_size;
+	memcpy(time_series->tail + ION_TS_BLOCK_HEADER + key_size, key, key_size);
+	ts_put(time_series->tail + 4, (uint32_t) (count + 1), 2);
+	ts_put(time_series->tail + 6, (uint32_t) (at - time_series->tail), 2);
+
+	entry->count++;
+	memcpy(entry + 1, time_series->tail + ION_TS_BLOCK_HEADER, 2 * key_size);
+	time_series->tail_dirty = boolean_true;
+
+	return ION_STATUS_OK(1);
+}
+
+long
+ts_find_block(
+	ion_time_series_t	*time_series,
+	ion_key_t			key
+) {
+	long	low		= 0;
+	long	high	= time_series->count;
+	long	middle;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+
+		if (0 > time_series->super.compare(ION_TS_MAX_KEY(time_series, middle), key, time_series->super.record.key_size)) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+long
+ts_block_index(
+	ion_time_series_t	*time_series,
+	uint32_t			seq
+) {
+	uint32_t oldest;
+
+	if (0 == time_series->count) {
+		return 0;
+	}
+
+	/* the blocks in the directory have every seq from the oldest on */
+	oldest = ION_TS_ENTRY(time_series, 0)->seq;
+
+	if (seq < oldest) {
+		return 0;
+	}
+
+	return ((long) (seq - oldest) < time_series->count) ? (long) (seq - oldest) : time_series->count;
+}
+
+ion_err_t
+ts_read_block(
+	ion_time_series_t	*time_series,
+	long				index,
+	ion_byte_t			*block
+) {
+	if (time_series->count - 1 == index) {
+		memcpy(block, time_series->tail, time_series->block_size);
+		return err_ok;
+	}
+
+	time_series->reads++;
+
+	return ion_fread_at(time_series->file, ION_TS_ENTRY(time_series, index)->offset, time_series->block_size, block);
+}
+
+void
+ts_reader_start(
+	ion_time_series_t	*time_series,
+	ion_ts_reader_t		*reader,
+	ion_byte_t			*block
+) {
+	reader->block	= block;
+	reader->index	= 0;
+	reader->pos		= ts_records_start(time_series);
+	reader->key		= ts_key_bits(time_series, block + ION_TS_BLOCK_HEADER);
+}
+
+ion_boolean_t
+ts_reader_next(
+	ion_time_series_t	*time_series,
+	ion_ts_reader_t		*reader,
+	ion_key_t			key,
+	ion_byte_t			**value
+) {
+	uint64_t	delta = 0;
+	int			shift = 0;
+	ion_byte_t	byte;
+
+	if (reader->index >= ION_TS_BLOCK_COUNT(reader->block)) {
+		return boolean_false;
+	}
+
+	if (0 != reader->index) {
+		do {
+			byte	= reader->block[reader->pos++];
+			delta	|= (uint64_t) (byte & 0x7F) << shift;
+			shift	+= 7;
+		} while ((0 != (byte & 0x80)) && (shift < 64));
+
+		reader->key += delta;
+	}
+
+	ts_bits_key(time_series, reader->key, key);
+	*value		= reader->block + reader->pos;
+	reader->pos += time_series->super.record.value_size;
+	reader->index++;
+
+	return boolean_true;
+}
+
+ion_status_t
+ts_query(
+	ion_time_series_t	*time_series,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_key_size_t	key_size	= time_series->super.record.key_size;
+	long			index		= ts_find_block(time_series, key);
+	ion_byte_t		found[sizeof(uint64_t)];
+	ion_ts_reader_t reader;
+	ion_byte_t		*at;
+	ion_err_t		err;
+	int				order;
+
+	if ((index == time_series->count) || (0 < time_series->super.compare(ION_TS_MIN_KEY(time_series, index), key, key_size))) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	if (err_ok != (err = ts_read_block(time_series, index, time_series->block))) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	ts_reader_start(time_series, &reader, time_series->block);
+
+	while (ts_reader_next(time_series, &reader, found, &at)) {
+		order = time_series->super.compare(found, key, key_size);
+
+		if (0 == order) {
+			memcpy(value, at, time_series->super.record.value_size);
+			return ION_STATUS_OK(1);
+		}
+
+		if (0 < order) {
+			break;
+		}
+	}
+
+	return ION_STATUS_ERROR(err_item_not_found);
+}
+
+ion_status_t
+ts_update(
+	ion_time_series_t	*time_series,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_key_size_t		key_size	= time_series->super.record.key_size;
+	ion_status_t		status		= ION_STATUS_INITIALIZE;
+	long				index		= ts_find_block(time_series, key);
+	ion_byte_t			found[sizeof(uint64_t)];
+	ion_ts_reader_t		reader;
+	ion_byte_t			*block;
+	ion_byte_t			*at;
+	ion_result_count_t	changed;
+	int					order;
+
+	status.error = err_ok;
+
+	/* records of one key may run on into the blocks after the first */
+	for (; index < time_series->count && 0 >= time_series->super.compare(ION_TS_MIN_KEY(time_series, index), key, key_size); index++) {
+		block	= (time_series->count - 1 == index) ? time_series->tail : time_series->block;
+		changed = 0;
+
+		if ((block != time_series->tail) && (err_ok != (status.error = ts_read_block(time_series, index, block)))) {
+			return status;
+		}
+
+		ts_reader_start(time_series, &reader, block);
+
+		while (ts_reader_next(time_series, &reader, found, &at) && 0 <= (order = time_series->super.compare(key, found, key_size))) {
+			if (0 == order) {
+				memcpy(at, value, time_series->super.record.value_size);
+				changed++;
+			}
+		}
+
+		if (0 == changed) {
+			continue;
+		}
+
+		status.count += changed;
+
+		if (block == time_series->tail) {
+			time_series->tail_dirty = boolean_true;
+		}
+		else if (err_ok != (status.error = ion_fwrite_at(time_series->file, ION_TS_ENTRY(time_series, index)->offset, time_series->block_size, block))) {
+			return status;
+		}
+	}
+
+	if (0 == status.count) {
+		return ts_append(time_series, key, value);
+	}
+
+	return status;
+}
+
+ion_status_t
+ts_drop_before(
+	ion_time_series_t	*time_series,
+	ion_key_t			key
+) {
+	ion_status_t status = ION_STATUS_INITIALIZE;
+
+	status.error = err_ok;
+
+	while ((time_series->count > 1) && (0 > time_series->super.compare(ION_TS_MAX_KEY(time_series, 0), key, time_series->super.record.key_size))) {
+		if (err_ok != (status.error = ts_free_slot(time_series, ION_TS_ENTRY(time_series, 0)->offset))) {
+			break;
+		}
+
+		status.count += ION_TS_ENTRY(time_series, 0)->count;
+		time_series->first++;
+		time_series->count--;
+	}
+
+	if ((0 != status.count) && (0 != time_series->count)) {
+		/* the dropped blocks stay in the file until reused; the header says to skip them */
+		time_series->head_seq = ION_TS_ENTRY(time_series, 0)->seq;
+
+		if (err_ok == status.error) {
+			status.error = ts_write_header(time_series);
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,375 @@
+/******************************************************************************/
+/**
+@file
+@brief		An append-only store of records keyed by time, kept in
+			fixed-size blocks of a file.
+@details	Keys are integers that never go down, such as timestamps or
+			sequence numbers, and records are only ever appended after the
+			last one. They fill one block at a time: the block being
+			appended to, the tail, is kept in memory and written whole once
+			it is full, so the file only sees sequential block writes.
+
+			Each block starts with the least and greatest of its keys.
+			The first key is stored in full and every other one as the
+			varint distance from the key before it, so keys that step by a
+			steady small amount take a byte or two. A directory of every
+			block, with its bounds, is kept in memory, so a search reads
+			only the one block that can hold its key, and a range scan
+			only the blocks that overlap the range.
+
+			For retention, whole blocks of the oldest records are dropped
+			at a time, each by moving the start of the directory on by one.
+			The slots they leave in the file are reused by later blocks, so
+			a series that drops as fast as it appends keeps to a fixed
+			number of blocks and writes around them as a ring.
+*/
+/******************************************************************************/
+
+#if !defined(TIME_SERIES_H_)
+#define TIME_SERIES_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+#include "../../file/ion_file.h"
+
+/**
+@brief		The size, in bytes, of the blocks of a series created with a
+			size of 0.
+*/
+#if !defined(ION_TS_BLOCK_SIZE)
+#if defined(ARDUINO)
+#define ION_TS_BLOCK_SIZE 256
+#else
+#define ION_TS_BLOCK_SIZE 512
+#endif
+#endif
+
+/**
+@brief		How many blocks the directory has room for before its first
+			block. The room doubles as it fills.
+*/
+#if !defined(ION_TS_INITIAL_BLOCKS)
+#if defined(ARDUINO)
+#define ION_TS_INITIAL_BLOCKS 8
+#else
+#define ION_TS_INITIAL_BLOCKS 64
+#endif
+#endif
+
+/**
+@brief		An entry of the block directory, followed in memory by the
+			least then the greatest key of the block.
+*/
+typedef struct {
+	ion_file_offset_t	offset;	/**< Where the block is in the file */
+	uint32_t			seq;	/**< Its place in the series, counted
+								 from the first block ever written */
+	uint16_t			count;	/**< The records it holds */
+} ion_ts_block_t;
+
+/**
+@brief		Struct used to maintain an instance of a time series.
+*/
+typedef struct time_series {
+	ion_dictionary_parent_t super;
+	ion_file_handle_t		file;			/**< The file of blocks */
+	int						block_size;		/**< The bytes of a block */
+	int						entry_size;		/**< The bytes of a directory
+											 entry and its bounds */
+	ion_byte_t				*directory;		/**< The entries of the blocks
+											 oldest first, from
+											 @c first */
+	long					first;			/**< The entry of the oldest
+											 block */
+	long					count;			/**< The blocks from @c first,
+											 the tail last */
+	long					capacity;		/**< The entries there is room
+											 for */
+	ion_file_offset_t		*free_slots;	/**< Offsets of dropped blocks,
+											 to reuse */
+	long					free_count;		/**< How many */
+	long					free_capacity;	/**< How many there is room
+											 for */
+	ion_file_offset_t		end;			/**< Where a new slot goes */
+	uint32_t				head_seq;		/**< The seq of the oldest
+											 block, as kept in the file */
+	uint32_t				next_seq;		/**< The seq of the next block */
+	ion_byte_t				*tail;			/**< The block being appended
+											 to */
+	ion_boolean_t			tail_dirty;		/**< Whether it changed since
+											 it was written */
+	ion_byte_t				*block;			/**< Room to read another
+											 block into */
+	unsigned long			reads;			/**< Blocks read from the file */
+} ion_time_series_t;
+
+/**
+@brief		Reads the records of a block in key order.
+*/
+typedef struct {
+	ion_byte_t	*block;	/**< The block */
+	int			index;	/**< The records read */
+	int			pos;	/**< Where the next record starts */
+	uint64_t	key;	/**< The bits of the key read last */
+} ion_ts_reader_t;
+
+/**
+@brief		Opens the series of a dictionary, creating its file if there
+			is none.
+
+@param		time_series
+				The series to open, whose @c super.compare is set.
+@param		id
+				The id of the dictionary, which names its file.
+@param		key_type
+				@c key_type_numeric_signed or @c key_type_numeric_unsigned.
+@param		key_size
+				1, 2, 4 or 8.
+@param		value_size
+				The size of the values.
+@param		block_size
+				The bytes of a block, 0 for @ref ION_TS_BLOCK_SIZE. An
+				existing file keeps the size it was made with.
+@return		The status of the opening: @c err_invalid_initial_size if
+			the keys are not integers or a block cannot hold two records.
+*/
+ion_err_t
+ts_initialize(
+	ion_time_series_t	*time_series,
+	ion_dictionary_id_t id,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					block_size
+);
+
+/**
+@brief		Writes the tail, then closes the file and frees the memory of
+			a series.
+
+@param		time_series
+				The series to close.
+@return		The status of the closing.
+*/
+ion_err_t
+ts_close(
+	ion_time_series_t *time_series
+);
+
+/**
+@brief		Closes a series and removes its file.
+
+@param		time_series
+				The series to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+ts_destroy(
+	ion_time_series_t *time_series
+);
+
+/**
+@brief		Appends a record after the last one of a series.
+
+@param		time_series
+				The series to append to.
+@param		key
+				The key, no less than the last key appended.
+@param		value
+				The value.
+@return		The status of the append, @c err_sorted_order_violation if
+			@p key is less than the last key.
+*/
+ion_status_t
+ts_append(
+	ion_time_series_t	*time_series,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Reads the value of the first record of a key.
+
+@param		time_series
+				The series to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value.
+@return		The status of the query.
+*/
+ion_status_t
+ts_query(
+	ion_time_series_t	*time_series,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Changes the value of every record of a key, or appends one if
+			there is none.
+
+@param		time_series
+				The series to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		The status of the update; the count is the records changed.
+*/
+ion_status_t
+ts_update(
+	ion_time_series_t	*time_series,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Drops the oldest blocks while every key they hold is less
+			than @p key.
+
+@details	Each block dropped costs the same, however many records it
+			holds. The tail is kept, so records of the block being
+			appended to are never dropped, and the records of the oldest
+			block kept may be older than @p key.
+
+@param		time_series
+				The series to trim.
+@param		key
+				The oldest key to be sure to keep.
+@return		The status of the trim; the count is the records dropped.
+*/
+ion_status_t
+ts_drop_before(
+	ion_time_series_t	*time_series,
+	ion_key_t			key
+);
+
+/**
+@brief		Writes the tail to the file if it changed.
+
+@param		time_series
+				The series to write.
+@return		The status of the write.
+*/
+ion_err_t
+ts_flush(
+	ion_time_series_t *time_series
+);
+
+/**
+@brief		Finds the oldest block whose greatest key is no less than
+			@p key, the only one that may hold its first record.
+
+@param		time_series
+				The series to search.
+@param		key
+				The key to search for.
+@return		The index of the block among those in the directory, from 0,
+			or @c count if every key is less than @p key.
+*/
+long
+ts_find_block(
+	ion_time_series_t	*time_series,
+	ion_key_t			key
+);
+
+/**
+@brief		Finds a block by its seq.
+
+@param		time_series
+				The series to search.
+@param		seq
+				The seq of a block.
+@return		The index of the block, that of the oldest if it was
+			dropped, or @c count if there is none so new.
+*/
+long
+ts_block_index(
+	ion_time_series_t	*time_series,
+	uint32_t			seq
+);
+
+/**
+@brief		Copies a block, reading it from the file unless it is the
+			tail.
+
+@param		time_series
+				The series.
+@param		index
+				The index of the block, below @c count.
+@param		block
+				Receives @c block_size bytes.
+@return		The status of the read.
+*/
+ion_err_t
+ts_read_block(
+	ion_time_series_t	*time_series,
+	long				index,
+	ion_byte_t			*block
+);
+
+/**
+@brief		Starts reading the records of a block.
+*/
+void
+ts_reader_start(
+	ion_time_series_t	*time_series,
+	ion_ts_reader_t		*reader,
+	ion_byte_t			*block
+);
+
+/**
+@brief		Reads the next record of a block.
+
+@param		time_series
+				The series of the block.
+@param		reader
+				A reader started on the block.
+@param		key
+				Receives the key.
+@param		value
+				Receives a pointer to the value, in the block.
+@return		@c boolean_false once every record was read.
+*/
+ion_boolean_t
+ts_reader_next(
+	ion_time_series_t	*time_series,
+	ion_ts_reader_t		*reader,
+	ion_key_t			key,
+	ion_byte_t			**value
+);
+
+/**
+@brief		The directory entry of the block of an index.
+*/
+#define ION_TS_ENTRY(time_series, index)		((ion_ts_block_t *) ((time_series)->directory + ((time_series)->first + (index)) * (time_series)->entry_size))
+
+/**
+@brief		The least key of the block of an index.
+*/
+#define ION_TS_MIN_KEY(time_series, index)		((ion_byte_t *) (ION_TS_ENTRY(time_series, index) + 1))
+
+/**
+@brief		The greatest key of the block of an index.
+*/
+#define ION_TS_MAX_KEY(time_series, index)		(ION_TS_MIN_KEY(time_series, index) + (time_series)->super.record.key_size)
+
+/**
+@brief		The records held by the block of a block image.
+*/
+#define ION_TS_BLOCK_COUNT(block)				((int) (block)[4] | ((int) (block)[5] << 8))
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TIME_SERIES_H_ */
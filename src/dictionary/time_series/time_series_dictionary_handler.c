@@ -0,0 +1,476 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a time series.
+*/
+/******************************************************************************/
+
+#include "time_series_dictionary_handler.h"
+
+/**
+@brief		Copies a block for a cursor and starts reading it.
+*/
+static ion_err_t
+tsdict_load(
+	ion_tsdict_cursor_t *cursor,
+	long				index
+) {
+	ion_time_series_t	*time_series = (ion_time_series_t *) cursor->super.dictionary->instance;
+	ion_err_t			err;
+
+	if (err_ok != (err = ts_read_block(time_series, index, cursor->block))) {
+		return err;
+	}
+
+	cursor->seq = ION_TS_ENTRY(time_series, index)->seq;
+	ts_reader_start(time_series, &cursor->reader, cursor->block);
+
+	return err_ok;
+}
+
+/**
+@brief		Whether no record of a block, or of any after it, can satisfy
+			the predicate of a cursor.
+*/
+static ion_boolean_t
+tsdict_past_bound(
+	ion_tsdict_cursor_t *cursor,
+	long				index
+) {
+	ion_time_series_t	*time_series	= (ion_time_series_t *) cursor->super.dictionary->instance;
+	ion_predicate_t		*predicate		= cursor->super.predicate;
+	ion_key_t			min_key			= ION_TS_MIN_KEY(time_series, index);
+
+	if (predicate_equality == predicate->type) {
+		return 0 < time_series->super.compare(min_key, predicate->statement.equality.equality_value, time_series->super.record.key_size);
+	}
+
+	if (predicate_range == predicate->type) {
+		return 0 < time_series->super.compare(min_key, predicate->statement.range.upper_bound, time_series->super.record.key_size);
+	}
+
+	return boolean_false;
+}
+
+/**
+@brief		Reads the next record for a cursor, moving on to the next
+			block when its copy runs out.
+@return		@c boolean_false once there is no record left, or no block
+			left that can hold one that matches.
+*/
+static ion_boolean_t
+tsdict_step(
+	ion_tsdict_cursor_t *cursor
+) {
+	ion_time_series_t	*time_series = (ion_time_series_t *) cursor->super.dictionary->instance;
+	long				index;
+	int					read;
+
+	while (!ts_reader_next(time_series, &cursor->reader, cursor->key, &cursor->value)) {
+		index = ts_block_index(time_series, cursor->seq);
+
+		/* the copy was of the tail, which has had records appended since */
+		if ((index < time_series->count) && (ION_TS_ENTRY(time_series, index)->seq == cursor->seq) && (ION_TS_ENTRY(time_series, index)->count > cursor->reader.index)) {
+			read = cursor->reader.index;
+
+			if (err_ok != tsdict_load(cursor, index)) {
+				return boolean_false;
+			}
+
+			while (cursor->reader.index < read) {
+				ts_reader_next(time_series, &cursor->reader, cursor->key, &cursor->value);
+			}
+
+			continue;
+		}
+
+		index = ts_block_index(time_series, cursor->seq + 1);
+
+		if ((index >= time_series->count) || tsdict_past_bound(cursor, index) || (err_ok != tsdict_load(cursor, index))) {
+			return boolean_false;
+		}
+	}
+
+	return boolean_true;
+}
+
+/**
+@brief		Moves a cursor on to the next record that satisfies its
+			predicate.
+@return		@c cs_valid_data, or @c cs_end_of_results once no record left
+			can.
+*/
+static ion_cursor_status_t
+tsdict_scan(
+	ion_tsdict_cursor_t *cursor
+) {
+	ion_time_series_t	*time_series	= (ion_time_series_t *) cursor->super.dictionary->instance;
+	ion_predicate_t		*predicate		= cursor->super.predicate;
+
+	while (tsdict_step(cursor)) {
+		/* records are read in key order, so nothing past the key or the upper bound can match */
+		if ((predicate_equality == predicate->type) && (0 < time_series->super.compare(cursor->key, predicate->statement.equality.equality_value, time_series->super.record.key_size))) {
+			break;
+		}
+
+		if ((predicate_range == predicate->type) && (0 < time_series->super.compare(cursor->key, predicate->statement.range.upper_bound, time_series->super.record.key_size))) {
+			break;
+		}
+
+		if (boolean_true == test_record_predicate(&cursor->super, cursor->key, cursor->value)) {
+			return cs_valid_data;
+		}
+	}
+
+	return cs_end_of_results;
+}
+
+ion_cursor_status_t
+tsdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_tsdict_cursor_t *tsdict_cursor	= (ion_tsdict_cursor_t *) cursor;
+	ion_time_series_t	*time_series	= (ion_time_series_t *) cursor->dictionary->instance;
+
+	if ((cs_cursor_uninitialized == cursor->status) || (cs_end_of_results == cursor->status)) {
+		return cursor->status;
+	}
+
+	if (cs_cursor_initialized == cursor->status) {
+		cursor->status = cs_cursor_active;
+	}
+	else if (cs_cursor_active == cursor->status) {
+		if (cs_end_of_results == tsdict_scan(tsdict_cursor)) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+	}
+	else {
+		return cs_invalid_cursor;
+	}
+
+	memcpy(record->key, tsdict_cursor->key, time_series->super.record.key_size);
+	memcpy(record->value, tsdict_cursor->value, time_series->super.record.value_size);
+
+	return cursor->status;
+}
+
+ion_err_t
+tsdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_time_series_t	*time_series	= (ion_time_series_t *) dictionary->instance;
+	ion_key_size_t		key_size		= time_series->super.record.key_size;
+	ion_tsdict_cursor_t *tsdict_cursor;
+	long				index;
+
+	if (NULL == (tsdict_cursor = ion_alloc(ion_alloc_cursor, sizeof(ion_tsdict_cursor_t)))) {
+		return err_out_of_memory;
+	}
+
+	if (NULL == (tsdict_cursor->block = ion_alloc(ion_alloc_cursor, time_series->block_size))) {
+		ion_free(tsdict_cursor);
+		return err_out_of_memory;
+	}
+
+	*cursor					= (ion_dict_cursor_t *) tsdict_cursor;
+	(*cursor)->dictionary	= dictionary;
+	(*cursor)->status		= cs_cursor_uninitialized;
+	(*cursor)->destroy		= tsdict_destroy_cursor;
+	(*cursor)->next_batch	= NULL;
+	(*cursor)->next			= tsdict_next;
+
+	if (NULL == ((*cursor)->predicate = ion_alloc(ion_alloc_cursor, sizeof(ion_predicate_t)))) {
+		ion_free(tsdict_cursor->block);
+		ion_free(*cursor);
+		*cursor = NULL;
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			/* the predicate may be destroyed while the cursor is open, so keep a copy of its key */
+			if (NULL == ((*cursor)->predicate->statement.equality.equality_value = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(tsdict_cursor->block);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+			index = ts_find_block(time_series, predicate->statement.equality.equality_value);
+			break;
+		}
+
+		case predicate_range: {
+			if (NULL == ((*cursor)->predicate->statement.range.lower_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate);
+				ion_free(tsdict_cursor->block);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			if (NULL == ((*cursor)->predicate->statement.range.upper_bound = ion_alloc(ion_alloc_cursor, key_size))) {
+				ion_free((*cursor)->predicate->statement.range.lower_bound);
+				ion_free((*cursor)->predicate);
+				ion_free(tsdict_cursor->block);
+				ion_free(*cursor);
+				*cursor = NULL;
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			index = ts_find_block(time_series, predicate->statement.range.lower_bound);
+			break;
+		}
+
+		case predicate_predicate: {
+			(*cursor)->predicate->statement.other_predicate = predicate->statement.other_predicate;
+			index											= 0;
+			break;
+		}
+
+		case predicate_all_records: {
+			index = 0;
+			break;
+		}
+
+		default: {
+			ion_free((*cursor)->predicate);
+			ion_free(tsdict_cursor->block);
+			ion_free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	/* the blocks before the lower bound are never read */
+	if ((index >= time_series->count) || tsdict_past_bound(tsdict_cursor, index) || (err_ok != tsdict_load(tsdict_cursor, index))) {
+		(*cursor)->status = cs_end_of_results;
+		return err_ok;
+	}
+
+	(*cursor)->status = (cs_valid_data == tsdict_scan(tsdict_cursor)) ? cs_cursor_initialized : cs_end_of_results;
+
+	return err_ok;
+}
+
+ion_err_t
+tsdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_time_series_t	*time_series;
+	ion_err_t			err;
+
+	if (NULL == (time_series = ion_alloc(ion_alloc_other, sizeof(ion_time_series_t)))) {
+		return err_out_of_memory;
+	}
+
+	time_series->super.compare	= compare;
+
+	/* a size of -1 leaves the blocks to the series, as 0 does */
+	err							= ts_initialize(time_series, id, key_type, key_size, value_size, ((ion_dictionary_size_t) -1 == dictionary_size) ? 0 : (int) dictionary_size);
+
+	if (err_ok != err) {
+		ion_free(time_series);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) time_series;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+ion_err_t
+tsdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return tsdict_create_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+}
+
+ion_err_t
+tsdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = ts_close((ion_time_series_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_err_t
+tsdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t err = ts_destroy((ion_time_series_t *) dictionary->instance);
+
+	ion_free(dictionary->instance);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+tsdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return ts_append((ion_time_series_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+tsdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return ts_query((ion_time_series_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+tsdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return ts_update((ion_time_series_t *) dictionary->instance, key, value);
+}
+
+ion_status_t
+tsdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	UNUSED(dictionary);
+	UNUSED(key);
+	return ION_STATUS_ERROR(err_not_implemented);
+}
+
+ion_status_t
+tsdict_drop_before(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return ts_drop_before((ion_time_series_t *) dictionary->instance, key);
+}
+
+ion_err_t
+tsdict_flush(
+	ion_dictionary_t *dictionary
+) {
+	return ts_flush((ion_time_series_t *) dictionary->instance);
+}
+
+void
+tsdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	ion_free(((ion_tsdict_cursor_t *) *cursor)->block);
+	ion_free(*cursor);
+	*cursor = NULL;
+}
+
+/**
+@brief		Pushes every write of a time series dictionary through to storage.
+*/
+static ion_err_t
+tsdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_time_series_t	*time_series	= (ion_time_series_t *) dictionary->instance;
+	ion_err_t			err				= ts_flush(time_series);
+
+	if (err_ok == err) {
+		err = ion_fsync(time_series->file);
+	}
+
+	return err;
+}
+
+/**
+@brief		Tells the size of a time series dictionary, see
+			@ref dictionary_get_info. Its blocks are its pages, and its
+			records and bounds come from the directory of them held in
+			memory.
+*/
+static ion_err_t
+tsdict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_time_series_t	*time_series	= (ion_time_series_t *) dictionary->instance;
+	int					key_size		= time_series->super.record.key_size;
+	long				last			= time_series->count - 1;
+	long				index;
+
+	info->record_count	= 0;
+	info->pages			= time_series->count;
+	info->file_bytes	= (long) time_series->end;
+	info->memory_bytes	= time_series->capacity * time_series->entry_size + 2L * time_series->block_size + time_series->free_capacity * (long) sizeof(ion_file_offset_t);
+
+	for (index = 0; index < time_series->count; index++) {
+		info->record_count += ION_TS_ENTRY(time_series, index)->count;
+	}
+
+	/* a new tail holds nothing until its first record is appended */
+	if ((0 < last) && (0 == ION_TS_ENTRY(time_series, last)->count)) {
+		last--;
+	}
+
+	if ((0 == info->record_count) || (NULL == info->min_key) || (NULL == info->max_key)) {
+		return err_ok;
+	}
+
+	memcpy(info->min_key, ION_TS_MIN_KEY(time_series, 0), key_size);
+	memcpy(info->max_key, ION_TS_MAX_KEY(time_series, last), key_size);
+	info->has_bounds = boolean_true;
+
+	return err_ok;
+}
+
+void
+tsdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= tsdict_insert;
+	handler->create_dictionary	= tsdict_create_dictionary;
+	handler->get				= tsdict_query;
+	handler->update				= tsdict_update;
+	handler->find				= tsdict_find;
+	handler->remove				= tsdict_delete;
+	handler->delete_dictionary	= tsdict_delete_dictionary;
+	handler->open_dictionary	= tsdict_open_dictionary;
+	handler->close_dictionary	= tsdict_close_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= NULL;
+	handler->sync_dictionary	= tsdict_sync_dictionary;
+	handler->get_info			= tsdict_get_info;
+	handler->bulk_load			= NULL;
+}
@@ -0,0 +1,293 @@
+/******************************************************************************/
+/**
+@file
+@brief		The handler for a time series.
+*/
+/******************************************************************************/
+
+#if !defined(TIME_SERIES_DICTIONARY_HANDLER_H_)
+#define TIME_SERIES_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "time_series.h"
+
+/**
+@brief		A cursor over a time series.
+@details	Cursors read one block at a time into a copy of their own,
+			from the block that may hold the lower bound of an equality or
+			range predicate, and skip every block after the last one that
+			can. Records appended while a cursor is open are read once it
+			gets to them, and blocks dropped under it are skipped.
+*/
+typedef struct tsdict_cursor {
+	ion_dict_cursor_t	super;						/**< Cursor supertype this
+													 type inherits from */
+	uint32_t			seq;						/**< The seq of the block
+													 being read */
+	ion_byte_t			*block;						/**< Its copy */
+	ion_ts_reader_t		reader;						/**< Reads the copy */
+	ion_byte_t			key[sizeof(uint64_t)];		/**< The key of the
+													 current record */
+	ion_byte_t			*value;						/**< Its value, in the
+													 copy */
+} ion_tsdict_cursor_t;
+
+/**
+@brief		Registers the time series handler.
+
+@details	Registers functions for handlers. This only needs to be called
+			once for each type of dictionary that is present.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+tsdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Appends a record to a time series dictionary.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert, no less than every key inserted before
+				it.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion, see @ref ts_append.
+*/
+ion_status_t
+tsdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up the value of the first record of a key.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+tsdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Creates a time series dictionary, or opens the one already in
+			its file.
+
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to be stored in the dictionary, a signed
+				or unsigned integer.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param		value_size
+				The size of the values to be stored in the dictionary.
+@param		dictionary_size
+				The bytes of a block, 0 or -1 for @ref ION_TS_BLOCK_SIZE.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@param		handler
+				The handler for the specific dictionary being created.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+tsdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Refuses to delete a record; records leave a time series
+			oldest first, through @ref tsdict_drop_before.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		@c err_not_implemented.
+*/
+ion_status_t
+tsdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes a time series dictionary and its file.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+tsdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Changes the value of every record of a key, or appends one if
+			there is none.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update, see @ref ts_update.
+*/
+ion_status_t
+tsdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Drops the oldest blocks of a time series dictionary while
+			every key they hold is less than @p key.
+
+@param		dictionary
+				The instance of the dictionary to trim.
+@param		key
+				The oldest key to be sure to keep.
+@return		The status of the trim, see @ref ts_drop_before.
+*/
+ion_status_t
+tsdict_drop_before(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Writes the block being appended to, so every record appended
+			so far is in the file.
+
+@param		dictionary
+				The instance of the dictionary to write.
+@return		The status of the write.
+*/
+ion_err_t
+tsdict_flush(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Finds the records that satisfy a predicate.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+tsdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Reads the next record of a time series cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Receives the key and value of the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+tsdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a time series cursor.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+tsdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Opens a time series dictionary from its file.
+
+@param		handler
+				A pointer to the handler for the specific dictionary being
+				opened.
+@param		dictionary
+				The pointer declared by the caller that will reference
+				the instance of the dictionary opened.
+@param		config
+				The configuration info of the specific dictionary to be
+				opened.
+@param		compare
+				Function pointer for the comparison function for the
+				dictionary.
+@return		The status of opening the dictionary.
+*/
+ion_err_t
+tsdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Writes out a time series dictionary and closes it, to be
+			brought back later with @ref dictionary_open.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		The status of the closing.
+*/
+ion_err_t
+tsdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TIME_SERIES_DICTIONARY_HANDLER_H_ */
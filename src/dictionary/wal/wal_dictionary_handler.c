@@ -0,0 +1,732 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that keeps a write-ahead log of the changes to a
+			dictionary of any other handler.
+*/
+/******************************************************************************/
+
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "wal_dictionary_handler.h"
+
+/**
+@brief		The clock, in milliseconds, that the commit interval of a log
+			is measured with. It may be defined to another, for example
+			as @c millis() on Arduino; without a definition Arduino
+			builds commit by batch only.
+*/
+#if !defined(ION_WAL_CLOCK)
+#if defined(ARDUINO)
+#define ION_WAL_CLOCK() 0
+#else
+#include <time.h>
+#define ION_WAL_CLOCK() waldict_clock()
+
+/**
+@brief		Milliseconds of the monotonic clock.
+*/
+static unsigned long
+waldict_clock(
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long) now.tv_sec * 1000UL + (unsigned long) now.tv_nsec / 1000000UL;
+}
+
+#endif
+#endif
+
+/**
+@brief		The checksum of a group before any of its bytes, the FNV-1a
+			offset basis.
+*/
+#define ION_WAL_CHECKSUM_START 2166136261UL
+
+/**
+@brief		The bytes of the largest record of a log.
+*/
+#define ION_WAL_RECORD_SIZE(wal) (1 + (wal)->super.record.key_size + (wal)->super.record.value_size)
+
+/**
+@brief		The bytes of @c buffer that records of the open group may
+			fill, the commit record going after them.
+*/
+#define ION_WAL_GROUP_SIZE(wal) ((wal)->batch * ION_WAL_RECORD_SIZE(wal))
+
+/**
+@brief		Room past the open group, and its commit record, for the key
+			then value of a record being copied or replayed, or the
+			checksum of a commit record.
+*/
+#define ION_WAL_SCRATCH(wal) ((wal)->buffer + ION_WAL_GROUP_SIZE(wal) + 1 + sizeof(uint32_t))
+
+/**
+@brief		Adds some bytes to an FNV-1a checksum.
+*/
+static uint32_t
+waldict_checksum(
+	uint32_t	checksum,
+	ion_byte_t	*bytes,
+	int			length
+) {
+	int i;
+
+	for (i = 0; i < length; i++) {
+		checksum	^= bytes[i];
+		checksum	*= 16777619UL;
+	}
+
+	return checksum;
+}
+
+/**
+@brief		The bytes that follow the operation byte of a record.
+@return		The size, or -1 if @p op is not an operation.
+*/
+static int
+waldict_payload_size(
+	ion_wal_dictionary_t	*wal,
+	ion_byte_t				op
+) {
+	switch (op) {
+		case ION_WAL_INSERT:
+		case ION_WAL_UPDATE:
+			return wal->super.record.key_size + wal->super.record.value_size;
+
+		case ION_WAL_DELETE:
+			return wal->super.record.key_size;
+
+		case ION_WAL_COMMIT:
+			return sizeof(uint32_t);
+
+		default:
+			return -1;
+	}
+}
+
+/**
+@brief		Commits the open group of a log: writes it closed by a commit
+			record holding its checksum, then syncs the log.
+*/
+static ion_err_t
+waldict_commit_group(
+	ion_wal_dictionary_t *wal
+) {
+	ion_err_t err;
+
+	if (0 == wal->pending) {
+		return err_ok;
+	}
+
+	wal->buffer[wal->used] = ION_WAL_COMMIT;
+	memcpy(wal->buffer + wal->used + 1, &wal->checksum, sizeof(uint32_t));
+
+	err				= ion_fwrite(wal->file, wal->used + 1 + sizeof(uint32_t), wal->buffer);
+
+	wal->used		= 0;
+	wal->pending	= 0;
+	wal->checksum	= ION_WAL_CHECKSUM_START;
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	return ion_fsync(wal->file);
+}
+
+/**
+@brief		Adds a record to the open group of a log, writing out the
+			records before it if they fill the buffer.
+@details	Only a copy of a dictionary grows a group past a batch; every
+			other group is committed as it reaches one.
+*/
+static ion_err_t
+waldict_append(
+	ion_wal_dictionary_t	*wal,
+	ion_byte_t				op,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_key_size_t	key_size	= wal->super.record.key_size;
+	ion_byte_t		*record;
+	ion_err_t		err;
+
+	if (wal->used + 1 + waldict_payload_size(wal, op) > ION_WAL_GROUP_SIZE(wal)) {
+		err			= ion_fwrite(wal->file, wal->used, wal->buffer);
+		wal->used	= 0;
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+	if (0 == wal->pending) {
+		wal->since = ION_WAL_CLOCK();
+	}
+
+	record		= wal->buffer + wal->used;
+	record[0]	= op;
+	memcpy(record + 1, key, key_size);
+
+	if (ION_WAL_DELETE != op) {
+		memcpy(record + 1 + key_size, value, wal->super.record.value_size);
+	}
+
+	wal->checksum	= waldict_checksum(wal->checksum, record, 1 + waldict_payload_size(wal, op));
+	wal->used		+= 1 + waldict_payload_size(wal, op);
+	wal->pending++;
+
+	return err_ok;
+}
+
+/**
+@brief		Logs a change, committing the open group once it holds a
+			batch or has been open for the interval.
+*/
+static ion_err_t
+waldict_log(
+	ion_wal_dictionary_t	*wal,
+	ion_byte_t				op,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+	ion_err_t err = waldict_append(wal, op, key, value);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	if ((wal->pending >= wal->batch) || ((0 != wal->interval) && (ION_WAL_CLOCK() - wal->since >= wal->interval))) {
+		return waldict_commit_group(wal);
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Reads a log up to its first group that is torn or does not
+			match its checksum.
+@param		wal
+				The log, read from its start.
+@param		end
+				Receives the offset just past the last group committed
+				whole, 0 if there is none.
+*/
+static void
+waldict_scan(
+	ion_wal_dictionary_t	*wal,
+	ion_file_offset_t		*end
+) {
+	ion_byte_t			*scratch	= ION_WAL_SCRATCH(wal);
+	uint32_t			checksum	= ION_WAL_CHECKSUM_START;
+	uint32_t			stored;
+	ion_file_offset_t	offset		= 0;
+	ion_byte_t			op;
+	int					size;
+
+	*end = 0;
+
+	if (err_ok != ion_fseek(wal->file, 0, ION_FILE_START)) {
+		return;
+	}
+
+	while (err_ok == ion_fread(wal->file, 1, &op)) {
+		if (-1 == (size = waldict_payload_size(wal, op))) {
+			return;
+		}
+
+		if (ION_WAL_COMMIT == op) {
+			if ((err_ok != ion_fread(wal->file, sizeof(uint32_t), (ion_byte_t *) &stored)) || (stored != checksum)) {
+				return;
+			}
+
+			offset		+= 1 + size;
+			*end		= offset;
+			checksum	= ION_WAL_CHECKSUM_START;
+			continue;
+		}
+
+		if (err_ok != ion_fread(wal->file, size, scratch)) {
+			return;
+		}
+
+		checksum	= waldict_checksum(checksum, &op, 1);
+		checksum	= waldict_checksum(checksum, scratch, size);
+		offset		+= 1 + size;
+	}
+}
+
+/**
+@brief		Deletes every record of the wrapped dictionary, one key at a
+			time, as no handler can be asked to empty itself.
+*/
+static ion_err_t
+waldict_empty(
+	ion_wal_dictionary_t *wal
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	ion_cursor_status_t cursor_status;
+	ion_status_t		status;
+	ion_err_t			err;
+
+	record.key		= ION_WAL_SCRATCH(wal);
+	record.value	= (ion_byte_t *) record.key + wal->super.record.key_size;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+
+	while (boolean_true) {
+		if (err_ok != (err = dictionary_find(&wal->inner, &predicate, &cursor))) {
+			return err;
+		}
+
+		cursor_status = cursor->next(cursor, &record);
+		cursor->destroy(&cursor);
+
+		if ((cs_cursor_active != cursor_status) && (cs_cursor_initialized != cursor_status)) {
+			return err_ok;
+		}
+
+		status = dictionary_delete(&wal->inner, record.key);
+
+		if (err_ok != status.error) {
+			return status.error;
+		}
+	}
+}
+
+/**
+@brief		Applies the committed groups of a log, which end at @p end, to
+			the wrapped dictionary.
+*/
+static ion_err_t
+waldict_replay(
+	ion_wal_dictionary_t	*wal,
+	ion_file_offset_t		end
+) {
+	ion_byte_t			*scratch	= ION_WAL_SCRATCH(wal);
+	ion_byte_t			*value		= scratch + wal->super.record.key_size;
+	ion_file_offset_t	offset		= 0;
+	ion_status_t		status		= ION_STATUS_OK(0);
+	ion_byte_t			op;
+	int					size;
+	ion_err_t			err;
+
+	if (err_ok != (err = ion_fseek(wal->file, 0, ION_FILE_START))) {
+		return err;
+	}
+
+	while (offset < end) {
+		/* the scan has read these already, so they are all there */
+		ion_fread(wal->file, 1, &op);
+		size = waldict_payload_size(wal, op);
+
+		if (err_ok != (err = ion_fread(wal->file, size, scratch))) {
+			return err;
+		}
+
+		offset += 1 + size;
+
+		switch (op) {
+			case ION_WAL_INSERT: {
+				status = dictionary_insert(&wal->inner, scratch, value);
+				break;
+			}
+
+			case ION_WAL_UPDATE: {
+				status = dictionary_update(&wal->inner, scratch, value);
+				break;
+			}
+
+			case ION_WAL_DELETE: {
+				status = dictionary_delete(&wal->inner, scratch);
+
+				/* only deletes that found the key are logged, but a handler may count them differently */
+				if (err_item_not_found == status.error) {
+					status.error = err_ok;
+				}
+
+				break;
+			}
+		}
+
+		if (err_ok != status.error) {
+			return status.error;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Logs every record of the wrapped dictionary as an insert, in
+			one group.
+*/
+static ion_err_t
+waldict_copy(
+	ion_wal_dictionary_t *wal
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	ion_cursor_status_t cursor_status;
+	ion_err_t			err;
+
+	record.key		= ION_WAL_SCRATCH(wal);
+	record.value	= (ion_byte_t *) record.key + wal->super.record.key_size;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+
+	if (err_ok != (err = dictionary_find(&wal->inner, &predicate, &cursor))) {
+		return err;
+	}
+
+	while (cs_cursor_active == (cursor_status = cursor->next(cursor, &record)) || cs_cursor_initialized == cursor_status) {
+		if (err_ok != (err = waldict_append(wal, ION_WAL_INSERT, record.key, record.value))) {
+			cursor->destroy(&cursor);
+			return err;
+		}
+	}
+
+	cursor->destroy(&cursor);
+
+	if (cs_end_of_results != cursor_status) {
+		return err_dictionary_initialization_failed;
+	}
+
+	return waldict_commit_group(wal);
+}
+
+ion_err_t
+waldict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_size_t		batch,
+	unsigned long				interval
+) {
+	ion_wal_dictionary_t	*wal;
+	ion_record_info_t		*record = &dictionary->instance->record;
+	char					filename[ION_MAX_FILENAME_LENGTH];
+	ion_file_offset_t		end;
+	ion_err_t				err;
+
+	if (0 == batch) {
+		batch = ION_WAL_DEFAULT_BATCH;
+	}
+
+	if (dictionary_get_filename(dictionary->instance->id, "wal", filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_initialization_failed;
+	}
+
+	/* the open group, its commit record, then the scratch record, which a checksum read also fits */
+	wal = ion_alloc(ion_alloc_other, sizeof(ion_wal_dictionary_t) + batch * (1 + record->key_size + record->value_size) + 1 + sizeof(uint32_t) + record->key_size + record->value_size + sizeof(uint32_t));
+
+	if (NULL == wal) {
+		return err_out_of_memory;
+	}
+
+	wal->super			= *dictionary->instance;
+	wal->inner			= *dictionary;
+	wal->inner_handler	= *dictionary->handler;
+	wal->inner.handler	= &wal->inner_handler;
+	/* the durability too, so each write is pushed once */
+	wal->inner.durability.level	= durability_none;
+	wal->inner.durability.pending	= 0;
+#if ION_DICTIONARY_STATS
+	/* the counters stay with the caller's dictionary, so each operation counts once */
+	wal->inner.stats	= NULL;
+#endif
+	wal->batch			= batch;
+	wal->interval		= interval;
+	wal->pending		= 0;
+	wal->since			= 0;
+	wal->used			= 0;
+	wal->checksum		= ION_WAL_CHECKSUM_START;
+	wal->buffer			= (ion_byte_t *) (wal + 1);
+	wal->file			= ion_fopen(filename);
+
+#if defined(ARDUINO)
+
+	if (NULL == wal->file.file) {
+#else
+
+	if (ION_NOFILE == wal->file) {
+#endif
+		ion_free(wal);
+		return err_file_open_error;
+	}
+
+	waldict_scan(wal, &end);
+
+	if (0 != end) {
+		/* the log holds everything, whatever of it the dictionary was opened with */
+		err = waldict_empty(wal);
+
+		if (err_ok == err) {
+			err = waldict_replay(wal, end);
+		}
+	}
+	else {
+		err = err_ok;
+	}
+
+	/* drop a torn group, or where the file cannot be cut, write over it */
+	if ((err_ok == err) && (err_not_implemented == (err = ion_ftruncate(wal->file, end)))) {
+		err = err_ok;
+	}
+
+	if (err_ok == err) {
+		err = ion_fseek(wal->file, end, ION_FILE_START);
+	}
+
+	if ((err_ok == err) && (0 == end)) {
+		err = waldict_copy(wal);
+	}
+
+	if (err_ok != err) {
+		ion_fclose(wal->file);
+		ion_free(wal);
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) wal;
+	dictionary->handler		= handler;
+	dictionary_opened(dictionary);
+
+	return err_ok;
+}
+
+ion_err_t
+waldict_commit(
+	ion_dictionary_t *dictionary
+) {
+	if (waldict_insert != dictionary->handler->insert) {
+		return err_illegal_state;
+	}
+
+	return waldict_commit_group((ion_wal_dictionary_t *) dictionary->instance);
+}
+
+ion_status_t
+waldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_wal_dictionary_t	*wal	= (ion_wal_dictionary_t *) dictionary->instance;
+	ion_status_t			status	= dictionary_insert(&wal->inner, key, value);
+
+	if (err_ok == status.error) {
+		status.error = waldict_log(wal, ION_WAL_INSERT, key, value);
+	}
+
+	return status;
+}
+
+ion_status_t
+waldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return dictionary_get(&((ion_wal_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_status_t
+waldict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+) {
+	return dictionary_get_ref(&((ion_wal_dictionary_t *) dictionary->instance)->inner, key, value);
+}
+
+ion_err_t
+waldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+	UNUSED(key_type);
+	UNUSED(key_size);
+	UNUSED(value_size);
+	UNUSED(dictionary_size);
+	UNUSED(compare);
+	UNUSED(handler);
+	UNUSED(dictionary);
+	return err_dictionary_initialization_failed;
+}
+
+ion_status_t
+waldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_wal_dictionary_t	*wal	= (ion_wal_dictionary_t *) dictionary->instance;
+	ion_status_t			status	= dictionary_delete(&wal->inner, key);
+
+	if ((err_ok == status.error) && (0 != status.count)) {
+		status.error = waldict_log(wal, ION_WAL_DELETE, key, NULL);
+	}
+
+	return status;
+}
+
+ion_err_t
+waldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_wal_dictionary_t	*wal	= (ion_wal_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= dictionary_delete_dictionary(&wal->inner);
+	char					filename[ION_MAX_FILENAME_LENGTH];
+
+	ion_fclose(wal->file);
+	dictionary_get_filename(wal->super.id, "wal", filename);
+
+	if (err_ok == err) {
+		err = ion_fremove(filename);
+	}
+	else {
+		ion_fremove(filename);
+	}
+
+	ion_free(wal);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+ion_status_t
+waldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_wal_dictionary_t	*wal	= (ion_wal_dictionary_t *) dictionary->instance;
+	ion_status_t			status	= dictionary_update(&wal->inner, key, value);
+
+	if (err_ok == status.error) {
+		status.error = waldict_log(wal, ION_WAL_UPDATE, key, value);
+	}
+
+	return status;
+}
+
+ion_err_t
+waldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	return dictionary_find(&((ion_wal_dictionary_t *) dictionary->instance)->inner, predicate, cursor);
+}
+
+ion_err_t
+waldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_dictionary_initialization_failed;
+}
+
+ion_err_t
+waldict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_wal_dictionary_t	*wal = (ion_wal_dictionary_t *) dictionary->instance;
+	char					filename[ION_MAX_FILENAME_LENGTH];
+	ion_err_t				err;
+
+	if (err_ok != (err = waldict_commit_group(wal))) {
+		return err;
+	}
+
+	/* until the dictionary is closed, and its snapshot written, the log is all there is */
+	if (err_ok != (err = dictionary_close(&wal->inner))) {
+		return err;
+	}
+
+	ion_fclose(wal->file);
+	dictionary_get_filename(wal->super.id, "wal", filename);
+	err = ion_fremove(filename);
+
+	ion_free(wal);
+	dictionary->instance = NULL;
+
+	return err;
+}
+
+/**
+@brief		Pushes every write of a logged dictionary through to storage.
+*/
+static ion_err_t
+waldict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	/* a committed group is in the log, which is replayed on open */
+	return waldict_commit_group((ion_wal_dictionary_t *) dictionary->instance);
+}
+
+/**
+@brief		Tells the size of a logged dictionary, see
+			@ref dictionary_get_info, its log counted with the files of
+			the wrapped dictionary and its open group with its memory.
+*/
+static ion_err_t
+waldict_get_info(
+	ion_dictionary_t		*dictionary,
+	ion_dictionary_info_t	*info
+) {
+	ion_wal_dictionary_t	*wal	= (ion_wal_dictionary_t *) dictionary->instance;
+	ion_err_t				err		= dictionary_get_info(&wal->inner, info);
+
+	if (-1 != info->file_bytes) {
+		info->file_bytes += (long) ion_fend(wal->file);
+	}
+
+	if (-1 != info->memory_bytes) {
+		info->memory_bytes += (long) (ION_WAL_SCRATCH(wal) - wal->buffer) + ION_WAL_RECORD_SIZE(wal);
+	}
+
+	return err;
+}
+
+void
+waldict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= waldict_insert;
+	handler->create_dictionary	= waldict_create_dictionary;
+	handler->get				= waldict_query;
+	handler->update				= waldict_update;
+	handler->find				= waldict_find;
+	handler->remove				= waldict_delete;
+	handler->delete_dictionary	= waldict_delete_dictionary;
+	handler->close_dictionary	= waldict_close_dictionary;
+	handler->open_dictionary	= waldict_open_dictionary;
+	handler->get_many			= NULL;
+	handler->insert_many		= NULL;
+	handler->delete_many		= NULL;
+	handler->get_ref			= waldict_get_ref;
+	handler->sync_dictionary	= waldict_sync_dictionary;
+	handler->get_info			= waldict_get_info;
+	handler->bulk_load			= NULL;
+}
@@ -0,0 +1,348 @@
+/******************************************************************************/
+/**
+@file
+@brief		A handler that keeps a write-ahead log of the changes to a
+			dictionary of any other handler.
+@details	A dictionary is wrapped once it is created or opened, see
+			@ref waldict_wrap. Every insert, update and delete that
+			succeeds on the wrapped dictionary is then appended to a log
+			file as a record of an operation byte, the key and, but for
+			deletes, the value. Records are buffered and committed in
+			groups: a group is written, closed with a checksum of its
+			bytes and synced once it holds a batch of records, once its
+			first record is older than an interval, or on
+			@ref waldict_commit. A crash loses at most the open group,
+			and a group torn part way through its write fails its
+			checksum and is ignored.
+
+			The log begins with a copy of the records the dictionary
+			held when wrapped, so it alone rebuilds the dictionary. This
+			matters to in-memory dictionaries, which are opened from the
+			snapshot written when they were last closed and remove it
+			while doing so. Closing the dictionary removes the log once
+			the wrapped dictionary is closed and, if it is in memory,
+			its snapshot written.
+
+			To recover after a crash, create or open the dictionary as
+			usual and wrap it again. Finding a log, the wrap replays its
+			committed groups onto the dictionary, emptied first if it
+			held anything, in place of the copy.
+*/
+/******************************************************************************/
+
+#if !defined(WAL_DICTIONARY_HANDLER_H_)
+#define WAL_DICTIONARY_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+#include "../../key_value/kv_system.h"
+#include "../../file/ion_file.h"
+
+/**
+@brief		The number of records a group of a log wrapped with a batch
+			of 0 holds.
+*/
+#if !defined(ION_WAL_DEFAULT_BATCH)
+#if defined(ARDUINO)
+#define ION_WAL_DEFAULT_BATCH 4
+#else
+#define ION_WAL_DEFAULT_BATCH 64
+#endif
+#endif
+
+/**
+@brief		The operation of each record of a log, its first byte.
+*/
+#define ION_WAL_INSERT	1
+#define ION_WAL_UPDATE	2
+#define ION_WAL_DELETE	3
+#define ION_WAL_COMMIT	4
+
+/**
+@brief		A dictionary with a write-ahead log of its changes.
+@details	The open group is kept in @c buffer until it is committed,
+			room for a batch of records then the commit record that
+			closes them.
+*/
+typedef struct wal_dictionary {
+	ion_dictionary_parent_t		super;
+	ion_dictionary_t			inner;			/**< The wrapped dictionary */
+	ion_dictionary_handler_t	inner_handler;	/**< Its handler, kept here as
+												 the caller's is rebound to
+												 the log */
+	ion_file_handle_t			file;			/**< The log */
+	int							batch;			/**< The records a group holds */
+	unsigned long				interval;		/**< Milliseconds a group may
+												 stay open, 0 for no limit */
+	int							pending;		/**< Records in the open group */
+	unsigned long				since;			/**< The clock at the first of
+												 them */
+	int							used;			/**< Bytes of @c buffer in use */
+	uint32_t					checksum;		/**< Of the bytes of the open
+												 group so far */
+	ion_byte_t					*buffer;		/**< The open group */
+} ion_wal_dictionary_t;
+
+/**
+@brief		Registers the write-ahead log handler.
+
+@details	The handler cannot create dictionaries of its own, it only
+			serves those given to @ref waldict_wrap.
+
+@param		handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+waldict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Logs the changes to a dictionary, first replaying the log it
+			left behind, if any.
+
+@details	From then on the dictionary is used through @p handler as
+			before, and deleting or closing it also does away with the
+			log. Its own handler is copied, so it may be reused.
+
+@param		dictionary
+				A dictionary, created or opened with any handler.
+@param		handler
+				A handler registered with @ref waldict_init, to bind to
+				@p dictionary.
+@param		batch
+				The records a group holds before it is committed, 0 for
+				@ref ION_WAL_DEFAULT_BATCH. With 1, each change is synced
+				before it returns.
+@param		interval
+				The milliseconds a group may stay open, 0 for no limit.
+				It is checked as changes are logged, so a quiet
+				dictionary should be committed with @ref waldict_commit.
+@return		The status of the wrap. Unless it is @c err_ok,
+			@p dictionary is not wrapped, though a replay may have
+			changed it.
+*/
+ion_err_t
+waldict_wrap(
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_size_t		batch,
+	unsigned long				interval
+);
+
+/**
+@brief		Commits the open group of a log, if it holds any records.
+
+@param		dictionary
+				A dictionary wrapped with @ref waldict_wrap.
+@return		@c err_ok once the records are synced, @c err_illegal_state
+			if @p dictionary has no log, or the error writing it.
+*/
+ion_err_t
+waldict_commit(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Inserts a record into the wrapped dictionary, then logs it.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to store under @p key.
+@return		The status of the insertion, with the error logging it, if
+			any.
+*/
+ion_status_t
+waldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up a value in the wrapped dictionary.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives the value stored under @p key.
+@return		The status of the query.
+*/
+ion_status_t
+waldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Points at a value held by the wrapped dictionary, for
+			@ref dictionary_get_ref.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		key
+				The key to search for.
+@param		value
+				Receives a pointer to the value.
+@return		The status of the wrapped dictionary's lookup.
+*/
+ion_status_t
+waldict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			*value
+);
+
+/**
+@brief		Creating is not supported, wrap a dictionary instead.
+
+@param		id
+				Unused.
+@param		key_type
+				Unused.
+@param		key_size
+				Unused.
+@param		value_size
+				Unused.
+@param		dictionary_size
+				Unused.
+@param		compare
+				Unused.
+@param		handler
+				Unused.
+@param		dictionary
+				Unused.
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+waldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Deletes a key from the wrapped dictionary, then logs it if
+			anything was deleted.
+
+@param		dictionary
+				The instance of the dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion, with the error logging it, if
+			any.
+*/
+ion_status_t
+waldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Deletes the wrapped dictionary and then the log.
+
+@param		dictionary
+				The instance of the dictionary to delete.
+@return		The status of the deletion.
+*/
+ion_err_t
+waldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Updates a key in the wrapped dictionary, then logs it.
+
+@param		dictionary
+				The instance of the dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The value to store under @p key.
+@return		The status of the update, with the error logging it, if
+			any.
+*/
+ion_status_t
+waldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Finds the records of the wrapped dictionary that satisfy a
+			predicate.
+
+@param		dictionary
+				The instance of the dictionary to search.
+@param		predicate
+				The predicate to be used as the condition for matching.
+@param		cursor
+				The pointer to a cursor which is caller declared but callee
+				is responsible for populating.
+@return		The status of the operation.
+*/
+ion_err_t
+waldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Opening is not supported, open the dictionary to wrap
+			instead.
+
+@param		handler
+				Unused.
+@param		dictionary
+				Unused.
+@param		config
+				Unused.
+@param		compare
+				Unused.
+@return		@c err_dictionary_initialization_failed.
+*/
+ion_err_t
+waldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Commits the log and closes the wrapped dictionary, then
+			removes the log.
+
+@param		dictionary
+				A pointer to the specific dictionary instance to be closed.
+@return		The status of the close. Unless it is @c err_ok, the log is
+			kept.
+*/
+ion_err_t
+waldict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* WAL_DICTIONARY_HANDLER_H_ */
@@ -25,28 +25,291 @@
 /******************************************************************************/
 
 #include "SD_stdio_c_iface.h"
+#include "ion_file.h"
 #include <SD.h>
 
+/**
+@brief		Marks a file as having no sector buffered.
+*/
+#define ION_SD_NO_SECTOR ((unsigned long) -1)
+
 /**
 @brief		A structure that translates a file object to a C-compatible
 			struct.
 */
 struct _SD_File {
-	File	f;				/**< The Arduino SD File object we to use. */
-	int8_t	eof;			/**< A position telling us where the end of the
-								 file currently is. */
+	File			f;				/**< The Arduino SD File object we to use. */
+	int8_t			eof;			/**< A position telling us where the end of the
+										 file currently is. */
+	unsigned long	position;		/**< Where the next read or write goes. */
+	unsigned long	size;			/**< The bytes of the file, those buffered
+										 included. */
+	unsigned long	sector;			/**< Where the buffered sector starts, or
+										 @ref ION_SD_NO_SECTOR. */
+	size_t			length;			/**< The bytes of the file the buffer holds,
+										 less than a sector at its end. */
+	bool			dirty;			/**< Whether the buffer was written since it
+										 was read. */
+	uint8_t			buffer[ION_SD_BUFFER_SIZE];	/**< The buffered sector. */
 };
 
+/**
+@brief		Moves the card position of a file, counting the seek.
+@returns	Whether it could be moved.
+*/
+static bool
+sd_card_seek(
+	SD_FILE			*stream,
+	unsigned long	to
+) {
+#if ION_FILE_STATS
+	unsigned long	start	= micros();
+	bool			moved	= stream->f.seek(to);
+
+	ion_file_stats_count(stream, ion_file_io_seek, 0, micros() - start);
+	return moved;
+#else
+	return stream->f.seek(to);
+#endif
+}
+
+/**
+@brief		Writes bytes to the card at the position of a file, counting
+			them.
+@returns	How many were written.
+*/
+static size_t
+sd_card_write(
+	SD_FILE			*stream,
+	const uint8_t	*bytes,
+	size_t			count
+) {
+#if ION_FILE_STATS
+	unsigned long	start	= micros();
+	size_t			written = stream->f.write(bytes, count);
+
+	ion_file_stats_count(stream, ion_file_io_write, written, micros() - start);
+	return written;
+#else
+	return stream->f.write(bytes, count);
+#endif
+}
+
+/**
+@brief		Reads bytes from the card at the position of a file, counting
+			them.
+@returns	How many were read, or a negative number on an error.
+*/
+static int
+sd_card_read(
+	SD_FILE *stream,
+	uint8_t *bytes,
+	size_t	count
+) {
+#if ION_FILE_STATS
+	unsigned long	start	= micros();
+	int				read	= stream->f.read(bytes, count);
+
+	ion_file_stats_count(stream, ion_file_io_read, (read > 0) ? read : 0, micros() - start);
+	return read;
+#else
+	return stream->f.read(bytes, count);
+#endif
+}
+
+/**
+@brief		Writes the buffered sector of a file to the card, if it was
+			written.
+@returns	Whether it could be.
+*/
+static bool
+sd_write_back(
+	SD_FILE *stream
+) {
+	if (!stream->dirty) {
+		return true;
+	}
+
+	if (!sd_card_seek(stream, stream->sector) || (stream->length != sd_card_write(stream, stream->buffer, stream->length))) {
+		return false;
+	}
+
+	stream->dirty = false;
+	return true;
+}
+
+/**
+@brief		Buffers a sector of a file, writing back the one buffered before.
+@param		sector
+				Where the sector starts.
+@param		whole
+				Whether it is about to be overwritten whole, so need not be
+				read.
+@returns	Whether it could be.
+*/
+static bool
+sd_load(
+	SD_FILE			*stream,
+	unsigned long	sector,
+	bool			whole
+) {
+	int num_bytes;
+
+	if (sector == stream->sector) {
+		return true;
+	}
+
+	if (!sd_write_back(stream)) {
+		return false;
+	}
+
+	stream->sector	= ION_SD_NO_SECTOR;
+	stream->length	= 0;
+
+	/* once written back, the card holds every byte before the end of the file */
+	if (!whole && (sector < stream->f.size())) {
+		if (!sd_card_seek(stream, sector)) {
+			return false;
+		}
+
+		num_bytes = sd_card_read(stream, stream->buffer, ION_SD_BUFFER_SIZE);
+
+		if (num_bytes < 0) {
+			return false;
+		}
+
+		stream->length = num_bytes;
+	}
+
+	stream->sector = sector;
+	return true;
+}
+
+/**
+@brief		Writes bytes at the position of a file through its buffer.
+@param		bytes
+				The bytes, or @c NULL to write zeros.
+@param		count
+				How many.
+@returns	How many were written.
+*/
+static size_t
+sd_put(
+	SD_FILE			*stream,
+	const uint8_t	*bytes,
+	size_t			count
+) {
+	unsigned long	sector;
+	size_t			within;
+	size_t			chunk;
+	size_t			done = 0;
+
+	while (done < count) {
+		within	= stream->position % ION_SD_BUFFER_SIZE;
+		sector	= stream->position - within;
+		chunk	= ION_SD_BUFFER_SIZE - within;
+
+		if (chunk > count - done) {
+			chunk = count - done;
+		}
+
+		if (!sd_load(stream, sector, ION_SD_BUFFER_SIZE == chunk)) {
+			break;
+		}
+
+		if (NULL == bytes) {
+			memset(stream->buffer + within, 0, chunk);
+		}
+		else {
+			memcpy(stream->buffer + within, bytes + done, chunk);
+		}
+
+		if (within + chunk > stream->length) {
+			stream->length = within + chunk;
+		}
+
+		stream->dirty		= true;
+		stream->position	+= chunk;
+		done				+= chunk;
+
+		if (stream->position > stream->size) {
+			stream->size = stream->position;
+		}
+	}
+
+	return done;
+}
+
+/**
+@brief		Zero-extends a file to a size past its end, leaving its
+			position there.
+@details	The Arduino SD library cannot grow a file without writing it,
+			so whole sectors of zeros are written one after another from a
+			single seek, and only the partial sectors at either end go
+			through the buffer.
+@param		size
+				The size to extend to, past the end of the file.
+@returns	Whether the file could be extended.
+*/
+static bool
+sd_extend(
+	SD_FILE			*stream,
+	unsigned long	size
+) {
+	unsigned long	head;
+	unsigned long	sectors;
+
+	/* up to the end of the sector the file ends in */
+	stream->position	= stream->size;
+	head				= (ION_SD_BUFFER_SIZE - stream->size % ION_SD_BUFFER_SIZE) % ION_SD_BUFFER_SIZE;
+
+	if (head > size - stream->size) {
+		head = size - stream->size;
+	}
+
+	if (head != sd_put(stream, NULL, head)) {
+		return false;
+	}
+
+	sectors = (size - stream->size) / ION_SD_BUFFER_SIZE;
+
+	if (sectors > 0) {
+		/* the card then holds all of the file, and the buffer is reused for zeros */
+		if (!sd_write_back(stream) || !sd_card_seek(stream, stream->size)) {
+			return false;
+		}
+
+		stream->sector = ION_SD_NO_SECTOR;
+		memset(stream->buffer, 0, ION_SD_BUFFER_SIZE);
+
+		for (; sectors > 0; sectors--) {
+			if (ION_SD_BUFFER_SIZE != sd_card_write(stream, stream->buffer, ION_SD_BUFFER_SIZE)) {
+				return false;
+			}
+
+			stream->size		+= ION_SD_BUFFER_SIZE;
+			stream->position	= stream->size;
+		}
+	}
+
+	/* and the rest of the last sector */
+	return (size - stream->size) == sd_put(stream, NULL, size - stream->size);
+}
+
 int
 sd_fclose(
 	SD_FILE *stream
 ) {
+	int result = 0;
+
 	if (stream) {
+		result = sd_write_back(stream) ? 0 : -1;
+		ion_file_stats_closed(stream);
 		stream->f.close();
 	}
 
 	delete stream;
-	return 0;
+	return result;
 }
 
 int
@@ -71,7 +334,18 @@ int
 sd_fflush(
 	SD_FILE *stream
 ) {
+	if (!sd_write_back(stream)) {
+		return -1;
+	}
+
+#if ION_FILE_STATS
+	unsigned long start = micros();
+
 	stream->f.flush();
+	ion_file_stats_count(stream, ion_file_io_sync, 0, micros() - start);
+#else
+	stream->f.flush();
+#endif
 	return 0;
 }
 
@@ -80,7 +354,7 @@ sd_fsetpos(
 	SD_FILE		*stream,
 	ion_fpos_t	*pos
 ) {
-	return (stream) ? !(stream->f.seek(*pos)) : 1;
+	return (stream) ? (0 != sd_fseek(stream, *pos, SEEK_SET)) : 1;
 }
 
 int
@@ -88,7 +362,7 @@ sd_fgetpos(
 	SD_FILE		*stream,
 	ion_fpos_t	*pos
 ) {
-	*pos = (stream) ? stream->f.position() : 0;
+	*pos = (stream) ? stream->position : 0;
 	return 0;
 }
 
@@ -152,6 +426,7 @@ sd_fopen(
 	(file)->f = SD.open(filename, operation);
 
 	if (!((file)->f)) {
+		delete file;
 		return 0;
 	}
 
@@ -159,6 +434,11 @@ sd_fopen(
 		file->f.seek(0);
 	}
 
+	file->position	= file->f.position();
+	file->size		= file->f.size();
+	file->sector	= ION_SD_NO_SECTOR;
+	ion_file_stats_opened(file, filename);
+
 	return file;
 }
 
@@ -170,21 +450,44 @@ sd_fread(
 	SD_FILE *stream
 ) {
 	/* read is the size of bytes * num of size-bytes */
-	int num_bytes = stream->f.read((char *) ptr, size * nmemb);
+	size_t			count	= size * nmemb;
+	size_t			done	= 0;
+	unsigned long	sector;
+	size_t			within;
+	size_t			chunk;
+
+	while ((done < count) && (stream->position < stream->size)) {
+		within	= stream->position % ION_SD_BUFFER_SIZE;
+		sector	= stream->position - within;
+
+		if (!sd_load(stream, sector, false) || (within >= stream->length)) {
+			break;
+		}
+
+		chunk = stream->length - within;
+
+		if (chunk > count - done) {
+			chunk = count - done;
+		}
+
+		memcpy((uint8_t *) ptr + done, stream->buffer + within, chunk);
+		stream->position	+= chunk;
+		done				+= chunk;
+	}
 
 #if DEBUG
 	Serial.print("Bytes read : ");
-	Serial.println(num_bytes);
+	Serial.println(done);
 #endif
 
-	if (num_bytes < size * nmemb) {
+	if (done < count) {
 #if DEBUG
 		Serial.println("End of file");
 #endif
 		stream->eof = 1;
 	}
 
-	return num_bytes / size;
+	return (0 == size) ? 0 : done / size;
 }
 
 int
@@ -193,101 +496,50 @@ sd_fseek(
 	long int	offset,
 	int			whence
 ) {
+	long int target;
+
 	if (NULL == stream) {
 		return -1;
 	}
 
-	unsigned long	cur_pos = stream->f.position();
-	unsigned long	cur_end = stream->f.size();
-
-	stream->eof = 0;
-
 	switch (whence) {
-		case SEEK_SET:	/* seek from current position */
-		{
-			if (offset < 0) {
-				return -1;	/* can't seek before file */
-			}
-
-			if (offset > cur_end) {
-				if (!stream->f.seek(cur_end)) {
-					return -1;
-				}
-
-				unsigned long	bytes_to_pad	= offset - cur_end;
-				char			payload			= 0x0;
-				size_t			num_written		= sd_fwrite(&payload, sizeof(payload), bytes_to_pad, stream);
-
-				if (num_written != bytes_to_pad) {
-					return -1;
-				}
-
-				/* The file-position indicator has been implicitly moved by the write - no seek needed to be done now */
-				return 0;
-			}
-
-			return stream->f.seek(offset) ? 0 : -1;
+		case SEEK_SET:
+			target = offset;
 			break;
-		}
-
-		case SEEK_CUR: {
-			if (offset + cur_pos > cur_end) {
-				if (!stream->f.seek(cur_end)) {
-					return -1;
-				}
-
-				unsigned long	bytes_to_pad	= (offset + cur_pos) - cur_end;
-				char			payload			= 0x0;
-				size_t			num_written		= sd_fwrite(&payload, sizeof(payload), bytes_to_pad, stream);
-
-				if (num_written != bytes_to_pad) {
-					return -1;
-				}
-
-				/* The file-position indicator has been implicitly moved by the write - no seek needed to be done now */
-				return 0;
-			}
 
-			if (offset - cur_pos < 0) {
-				return -1;	/* too far past beginning of the file - assumes that offset is negative */
-			}
-
-			return stream->f.seek(cur_pos + offset) ? 0 : -1;
+		case SEEK_CUR:
+			target = stream->position + offset;
 			break;
-		}
-
-		case SEEK_END: {
-			if (offset > 0) {
-				if (!stream->f.seek(cur_end)) {
-					return -1;
-				}
-
-				unsigned long	bytes_to_pad	= offset;
-				char			payload			= 0x0;
-				size_t			num_written		= sd_fwrite(&payload, sizeof(payload), bytes_to_pad, stream);
 
-				if (num_written != bytes_to_pad) {
-					return -1;
-				}
-
-				/* The file-position indicator has been implicitly moved by the write - no seek needed to be done now */
-				return 0;
-			}
-
-			return stream->f.seek(cur_end + offset) ? 0 : -1;
+		case SEEK_END:
+			target = stream->size + offset;
 			break;
-		}
 
 		default:
 			return -1;
 	}
+
+	if (target < 0) {
+		return -1;	/* can't seek before file */
+	}
+
+	stream->eof = 0;
+
+	/* the buffered sector is only written once another is used */
+	if ((unsigned long) target > stream->size) {
+		/* The file-position indicator is moved by the write */
+		return sd_extend(stream, target) ? 0 : -1;
+	}
+
+	stream->position = target;
+	return 0;
 }
 
 long int
 sd_ftell(
 	SD_FILE *stream
 ) {
-	long int pos = (stream) ? stream->f.position() : -1;
+	long int pos = (stream) ? (long int) stream->position : -1;
 
 #if DEBUG
 	Serial.print("cur pos: ");
@@ -303,27 +555,11 @@ sd_fwrite(
 	size_t	nmemb,
 	SD_FILE *stream
 ) {
-	size_t	idx;
-	size_t	bytes_written	= 0;
-	size_t	total_count		= 0;
-
-	/* for each element, continue to write */
-	for (idx = 0; idx < nmemb; idx++) {
-		bytes_written = stream->f.write((uint8_t *) ptr, size);
-
-		if (bytes_written != size) {
-			return total_count;
-		}
-
-		total_count += 1;
+	if (0 == size) {
+		return 0;
 	}
 
-	if (total_count != nmemb) {
-		return -1;
-	}
-	else {
-		return total_count;
-	}
+	return sd_put(stream, (const uint8_t *) ptr, size * nmemb) / size;
 }
 
 int
@@ -337,8 +573,8 @@ void
 sd_rewind(
 	SD_FILE *stream
 ) {
-	stream->eof = 0;
-	stream->f.seek(0);
+	stream->eof			= 0;
+	stream->position	= 0;
 }
 
 int
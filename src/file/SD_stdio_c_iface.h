@@ -39,6 +39,18 @@ extern "C" {
 
 #include "kv_stdio_intercept.h"
 
+/**
+@brief		The bytes of a file each open file buffers, a sector of the card.
+@details	Writes are gathered in the buffer and reads served from it, so
+			small records written one after another cost one write of the
+			sector rather than a read, patch and write of it each. The
+			buffer goes to the card when another sector of the file is
+			used, and on flush and close.
+*/
+#if !defined(ION_SD_BUFFER_SIZE)
+#define ION_SD_BUFFER_SIZE 512
+#endif
+
 /**
 @brief		Wrapper around Arduino File type (a C++ object).
 */
@@ -46,10 +58,11 @@ typedef struct _SD_File SD_FILE;
 
 /**
 @brief		Wrapper around Arduino SD file close method.
+@details	The buffered sector is written first.
 @param		stream
 				A pointer to the C file struct type associated with an SD
 				file object.
-@returns	@c 0, always.
+@returns	@c 0, or @c -1 if the buffered sector could not be written.
 */
 int
 sd_fclose(
@@ -75,7 +88,7 @@ sd_feof(
 @param		stream
 				A pointer to the C file struct type associated with an SD
 				file object representing the file to flush.
-@returns	@c 0, always.
+@returns	@c 0, or @c -1 if the buffered sector could not be written.
 */
 int
 sd_fflush(
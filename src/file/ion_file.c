@@ -1,54 +1,1249 @@
+/* fileno, fsync, ftruncate, pread and pwrite are POSIX, not C99 */
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+/* O_DIRECT is not POSIX either */
+#if defined(ION_FILE_DIRECT) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <limits.h>
 #include "ion_file.h"
 
-ion_boolean_t
-ion_fexists(
-	char *name
+#if defined(ION_FILE_POSIX)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#if defined(ION_FILE_DIRECT) && !defined(O_DIRECT)
+#undef ION_FILE_DIRECT
+#endif
+#endif
+
+/**
+@brief		Takes and gives up a lock on what files share, the page cache
+			and the counters, so files can be used from several threads
+			at once, each by one of them. The cache lock is taken first
+			where both are.
+*/
+#if defined(ARDUINO)
+#define ION_FILE_LOCK(lock)
+#define ION_FILE_UNLOCK(lock)
+#else
+#include <pthread.h>
+#define ION_FILE_LOCK(lock)		pthread_mutex_lock(&(lock))
+#define ION_FILE_UNLOCK(lock)	pthread_mutex_unlock(&(lock))
+#endif
+
+/**
+@brief		The stream of a file handle, which keys its pages.
+*/
+#if defined(ARDUINO)
+#define ION_FILE_STREAM(file)	((void *) (file).file)
+#elif defined(ION_FILE_POSIX)
+/* descriptor 0 is a file too, so none is keyed NULL */
+#define ION_FILE_STREAM(file)	((void *) (intptr_t) ((file) + 1))
+#else
+#define ION_FILE_STREAM(file)	((void *) (file))
+#endif
+
+/**
+@brief		The end of every file, to write back or drop all its pages.
+*/
+#define ION_FILE_WHOLE			LONG_MAX
+
+#if ION_FILE_STATS
+
+/**
+@brief		The counters of the files counted, the first
+			@ref ion_file_stats_taken of them in use.
+*/
+static ion_file_io_stats_t	ion_file_stats_files[ION_FILE_STATS_FILES];
+
+/**
+@brief		The stream each entry counts for, @c NULL once it is closed.
+*/
+static void					*ion_file_stats_streams[ION_FILE_STATS_FILES];
+
+/**
+@brief		The entries in use.
+*/
+static int					ion_file_stats_taken	= 0;
+
+/**
+@brief		The entry found last, tried first, as transfers come in runs.
+*/
+static int					ion_file_stats_last		= 0;
+
+#if !defined(ARDUINO)
+
+/**
+@brief		Guards the counters.
+*/
+static pthread_mutex_t ion_file_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+@brief		Finds the entry counting an open file.
+@return		Its index, or -1 if it is not counted.
+*/
+static int
+ion_file_stats_find(
+	void *stream
+) {
+	int i;
+
+	if ((ion_file_stats_last < ion_file_stats_taken) && (stream == ion_file_stats_streams[ion_file_stats_last])) {
+		return ion_file_stats_last;
+	}
+
+	for (i = 0; i < ion_file_stats_taken; i++) {
+		if (stream == ion_file_stats_streams[i]) {
+			ion_file_stats_last = i;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+#endif
+
+void
+ion_file_stats_opened(
+	void		*stream,
+	const char	*name
+) {
+#if ION_FILE_STATS
+	ion_file_io_stats_t *entry	= NULL;
+	const char			*base	= strrchr(name, '/');
+	char				cut[ION_FILE_STATS_NAME];
+	int					id		= 0;
+	int					i;
+
+	base = (NULL == base) ? name : base + 1;
+	strncpy(cut, base, ION_FILE_STATS_NAME - 1);
+	cut[ION_FILE_STATS_NAME - 1] = '\0';
+
+	ION_FILE_LOCK(ion_file_stats_lock);
+
+	/* a file counted before goes on, otherwise a new entry or a closed one is taken */
+	for (i = 0; (i < ion_file_stats_taken) && (NULL == entry); i++) {
+		if ((NULL == ion_file_stats_streams[i]) && (0 == strcmp(cut, ion_file_stats_files[i].name))) {
+			entry = ion_file_stats_files + i;
+		}
+	}
+
+	if ((NULL == entry) && (ion_file_stats_taken < ION_FILE_STATS_FILES)) {
+		entry = ion_file_stats_files + ion_file_stats_taken++;
+		memset(entry, 0, sizeof(ion_file_io_stats_t));
+	}
+
+	for (i = 0; (i < ion_file_stats_taken) && (NULL == entry); i++) {
+		if (NULL == ion_file_stats_streams[i]) {
+			entry = ion_file_stats_files + i;
+			memset(entry, 0, sizeof(ion_file_io_stats_t));
+		}
+	}
+
+	if (NULL == entry) {
+		ION_FILE_UNLOCK(ion_file_stats_lock);
+		return;
+	}
+
+	strcpy(entry->name, cut);
+
+	/* the files of a dictionary are named by its ID */
+	for (i = 0; (cut[i] >= '0') && (cut[i] <= '9'); i++) {
+		id = id * 10 + (cut[i] - '0');
+	}
+
+	entry->dictionary_id								= ((i > 0) && ('.' == cut[i])) ? id : -1;
+	entry->open											= boolean_true;
+	ion_file_stats_streams[entry - ion_file_stats_files] = stream;
+	ION_FILE_UNLOCK(ion_file_stats_lock);
+#else
+	UNUSED(stream);
+	UNUSED(name);
+#endif
+}
+
+void
+ion_file_stats_closed(
+	void *stream
+) {
+#if ION_FILE_STATS
+	int i;
+
+	ION_FILE_LOCK(ion_file_stats_lock);
+	i = ion_file_stats_find(stream);
+
+	if (-1 != i) {
+		ion_file_stats_streams[i]		= NULL;
+		ion_file_stats_files[i].open	= boolean_false;
+	}
+
+	ION_FILE_UNLOCK(ion_file_stats_lock);
+
+#else
+	UNUSED(stream);
+#endif
+}
+
+void
+ion_file_stats_count(
+	void			*stream,
+	ion_file_io_t	kind,
+	unsigned long	num_bytes,
+	unsigned long	micros
+) {
+#if ION_FILE_STATS
+	ion_file_io_stats_t *entry;
+	int					i;
+
+	ION_FILE_LOCK(ion_file_stats_lock);
+	i = ion_file_stats_find(stream);
+
+	if (-1 == i) {
+		ION_FILE_UNLOCK(ion_file_stats_lock);
+		return;
+	}
+
+	entry			= ion_file_stats_files + i;
+	entry->micros	+= micros;
+
+	switch (kind) {
+		case ion_file_io_read:
+			entry->reads++;
+			entry->read_bytes += num_bytes;
+			break;
+
+		case ion_file_io_write:
+			entry->writes++;
+			entry->write_bytes += num_bytes;
+			break;
+
+		case ion_file_io_seek:
+			entry->seeks++;
+			break;
+
+		case ion_file_io_sync:
+			entry->syncs++;
+			break;
+	}
+
+	ION_FILE_UNLOCK(ion_file_stats_lock);
+#else
+	UNUSED(stream);
+	UNUSED(kind);
+	UNUSED(num_bytes);
+	UNUSED(micros);
+#endif
+}
+
+int
+ion_file_io_stats(
+	ion_file_io_stats_t *stats,
+	int					max
+) {
+#if ION_FILE_STATS
+	int taken;
+	int i;
+
+	ION_FILE_LOCK(ion_file_stats_lock);
+	taken = ion_file_stats_taken;
+
+	for (i = 0; (i < taken) && (i < max); i++) {
+		stats[i] = ion_file_stats_files[i];
+	}
+
+	ION_FILE_UNLOCK(ion_file_stats_lock);
+
+	return taken;
+#else
+	UNUSED(stats);
+	UNUSED(max);
+
+	return 0;
+#endif
+}
+
+void
+ion_file_io_stats_print(
+	void
+) {
+#if ION_FILE_STATS
+	ion_file_io_stats_t *entry;
+	int					i;
+
+	printf("%-19s %5s %8s %10s %8s %10s %8s %6s %10s\n", "file", "dict", "reads", "read_b", "writes", "write_b", "seeks", "syncs", "micros");
+
+	ION_FILE_LOCK(ion_file_stats_lock);
+
+	for (i = 0; i < ion_file_stats_taken; i++) {
+		entry = ion_file_stats_files + i;
+		printf("%-19s %5d %8lu %10lu %8lu %10lu %8lu %6lu %10lu%s\n", entry->name, entry->dictionary_id, entry->reads, entry->read_bytes, entry->writes, entry->write_bytes, entry->seeks, entry->syncs, entry->micros, entry->open ? "" : " (closed)");
+	}
+
+	ION_FILE_UNLOCK(ion_file_stats_lock);
+#endif
+}
+
+void
+ion_file_io_stats_reset(
+	void
+) {
+#if ION_FILE_STATS
+	int taken = 0;
+	int i;
+
+	ION_FILE_LOCK(ion_file_stats_lock);
+
+	/* closed files are forgotten, open ones kept in place of them */
+	for (i = 0; i < ion_file_stats_taken; i++) {
+		if (NULL == ion_file_stats_streams[i]) {
+			continue;
+		}
+
+		ion_file_stats_files[taken]			= ion_file_stats_files[i];
+		ion_file_stats_streams[taken]		= ion_file_stats_streams[i];
+		ion_file_stats_files[taken].reads		= 0;
+		ion_file_stats_files[taken].read_bytes	= 0;
+		ion_file_stats_files[taken].writes		= 0;
+		ion_file_stats_files[taken].write_bytes = 0;
+		ion_file_stats_files[taken].seeks		= 0;
+		ion_file_stats_files[taken].syncs		= 0;
+		ion_file_stats_files[taken].micros		= 0;
+		taken++;
+	}
+
+	ion_file_stats_taken	= taken;
+	ion_file_stats_last		= 0;
+	ION_FILE_UNLOCK(ion_file_stats_lock);
+#endif
+}
+
+#if ION_FILE_STATS && !defined(ARDUINO)
+#include <time.h>
+
+/**
+@brief		Microseconds of the monotonic clock, to time transfers by.
+*/
+static unsigned long
+ion_file_stats_clock(
+	void
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long) now.tv_sec * 1000000UL + (unsigned long) now.tv_nsec / 1000UL;
+}
+
+/**
+@brief		Reads the clock, to begin timing a transfer of a file.
+*/
+#define ION_FILE_STATS_BEGIN() \
+	unsigned long ion_file_stats_start = ion_file_stats_clock()
+
+/**
+@brief		Counts a transfer begun with @ref ION_FILE_STATS_BEGIN. On
+			Arduino the SD interface counts instead.
+*/
+#define ION_FILE_STATS_END(file, kind, num_bytes) \
+	ion_file_stats_count(ION_FILE_STREAM(file), (kind), (unsigned long) (num_bytes), ion_file_stats_clock() - ion_file_stats_start)
+
+#else
+
+#define ION_FILE_STATS_BEGIN()
+#define ION_FILE_STATS_END(file, kind, num_bytes)
+
+#endif
+
+/**
+@brief		A page of a file held by the cache.
+*/
+typedef struct {
+	void				*stream;	/**< Its file, @c NULL if unused */
+	ion_file_handle_t	file;		/**< The same, to read and write */
+	ion_file_offset_t	page;		/**< Its number in the file */
+	unsigned int		length;		/**< The bytes of it the file holds,
+									 less than a page at the end */
+	ion_boolean_t		dirty;		/**< Whether it was written since it
+									 was read */
+	unsigned long		used;		/**< When it was last used */
+	ion_byte_t			*data;		/**< Its bytes */
+} ion_file_cache_page_t;
+
+#if defined(ION_FILE_POSIX)
+
+/**
+@brief		Moves bytes between memory and a file descriptor, at an offset
+			or at its position, until they are all moved or it stops.
+@param		offset
+				Where in the file, negative for its position.
+@param		writing
+				Whether the bytes go to the file rather than come from it.
+@return		How many were moved, short at the end of the file or on an
+			error.
+*/
+static size_t
+ion_file_transfer(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	size_t				num_bytes,
+	ion_byte_t			*bytes,
+	ion_boolean_t		writing
+) {
+	size_t	done = 0;
+	ssize_t moved;
+
+	while (done < num_bytes) {
+		if (offset < 0) {
+			moved = writing ? write(file, bytes + done, num_bytes - done) : read(file, bytes + done, num_bytes - done);
+		}
+		else {
+			moved = writing ? pwrite(file, bytes + done, num_bytes - done, offset + done) : pread(file, bytes + done, num_bytes - done, offset + done);
+		}
+
+		if ((moved < 0) && (EINTR == errno)) {
+			continue;
+		}
+
+		if (moved <= 0) {
+			break;
+		}
+
+		done += moved;
+	}
+
+	return done;
+}
+
+#if defined(ION_FILE_DIRECT)
+
+/**
+@brief		Tells whether a transfer can be made as it is to a file opened
+			with @c O_DIRECT.
+*/
+#define ION_FILE_DIRECT_ALIGNED(offset, num_bytes, bytes) \
+	((0 == (offset) % ION_FILE_DIRECT_ALIGNMENT) && (0 == (num_bytes) % ION_FILE_DIRECT_ALIGNMENT) && (0 == (uintptr_t) (bytes) % ION_FILE_DIRECT_ALIGNMENT))
+
+/**
+@brief		Moves bytes between memory and a file opened with @c O_DIRECT,
+			at an offset, in whole aligned blocks.
+@details	A transfer not aligned goes through an aligned buffer of the
+			blocks it touches. Writing one, the blocks it covers only in
+			part are read first, and a file it leaves ending within a
+			block is cut back to its last byte written.
+@return		How many were moved, short at the end of the file or on an
+			error.
+*/
+static size_t
+ion_file_direct_transfer(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	size_t				num_bytes,
+	ion_byte_t			*bytes,
+	ion_boolean_t		writing
+) {
+	ion_file_offset_t	start	= offset - offset % ION_FILE_DIRECT_ALIGNMENT;
+	ion_file_offset_t	end		= offset + (ion_file_offset_t) num_bytes;
+	ion_file_offset_t	last;
+	struct stat			status;
+	ion_byte_t			*block;
+	size_t				done;
+	void				*buffer;
+
+	if (ION_FILE_DIRECT_ALIGNED(offset, num_bytes, bytes) || (0 == num_bytes)) {
+		return ion_file_transfer(file, offset, num_bytes, bytes, writing);
+	}
+
+	end		+= (ION_FILE_DIRECT_ALIGNMENT - end % ION_FILE_DIRECT_ALIGNMENT) % ION_FILE_DIRECT_ALIGNMENT;
+	last	= end - ION_FILE_DIRECT_ALIGNMENT;
+
+	if (0 != posix_memalign(&buffer, ION_FILE_DIRECT_ALIGNMENT, end - start)) {
+		return 0;
+	}
+
+	block = buffer;
+
+	if (!writing) {
+		done = ion_file_transfer(file, start, end - start, block, boolean_false);
+		done = (done > (size_t) (offset - start)) ? done - (offset - start) : 0;
+
+		if (done > num_bytes) {
+			done = num_bytes;
+		}
+
+		memcpy(bytes, block + (offset - start), done);
+		free(buffer);
+		return done;
+	}
+
+	if (0 != fstat(file, &status)) {
+		free(buffer);
+		return 0;
+	}
+
+	/* the bytes of the blocks around the write stay as the file has them */
+	memset(block, 0, end - start);
+
+	if ((offset != start) && (start < status.st_size)) {
+		ion_file_transfer(file, start, ION_FILE_DIRECT_ALIGNMENT, block, boolean_false);
+	}
+
+	if ((offset + (ion_file_offset_t) num_bytes != end) && (last < status.st_size) && ((last != start) || (offset == start))) {
+		ion_file_transfer(file, last, ION_FILE_DIRECT_ALIGNMENT, block + (last - start), boolean_false);
+	}
+
+	memcpy(block + (offset - start), bytes, num_bytes);
+	done = ion_file_transfer(file, start, end - start, block, boolean_true);
+	free(buffer);
+
+	if (done != (size_t) (end - start)) {
+		return 0;
+	}
+
+	/* the padding of the last block is not part of the file */
+	if ((end > status.st_size) && (offset + (ion_file_offset_t) num_bytes < end) && (0 != ftruncate(file, (offset + (ion_file_offset_t) num_bytes > status.st_size) ? offset + (ion_file_offset_t) num_bytes : status.st_size))) {
+		return 0;
+	}
+
+	return num_bytes;
+}
+
+#endif
+
+#endif
+
+/**
+@brief		Writes bytes at an offset of a file, past the cache.
+@return		How many were written.
+*/
+static size_t
+ion_file_pwrite(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	size_t				num_bytes,
+	ion_byte_t			*to_write
+) {
+	size_t written = 0;
+
+	ION_FILE_STATS_BEGIN();
+
+#if defined(ION_FILE_DIRECT)
+	written = ion_file_direct_transfer(file, offset, num_bytes, to_write, boolean_true);
+#elif defined(ION_FILE_POSIX)
+	written = ion_file_transfer(file, offset, num_bytes, to_write, boolean_true);
+#else
+
+	if (0 == fseek(ION_FILE_STREAM(file), offset, SEEK_SET)) {
+		ion_file_stats_count(ION_FILE_STREAM(file), ion_file_io_seek, 0, 0);
+		written = fwrite(to_write, 1, num_bytes, ION_FILE_STREAM(file));
+	}
+
+#endif
+	ION_FILE_STATS_END(file, ion_file_io_write, written);
+
+	return written;
+}
+
+/**
+@brief		Reads bytes at an offset of a file, past the cache.
+@return		How many were read, short at the end of the file.
+*/
+static size_t
+ion_file_pread(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	size_t				num_bytes,
+	ion_byte_t			*write_to
+) {
+	size_t read = 0;
+
+	ION_FILE_STATS_BEGIN();
+
+#if defined(ION_FILE_DIRECT)
+	read = ion_file_direct_transfer(file, offset, num_bytes, write_to, boolean_false);
+#elif defined(ION_FILE_POSIX)
+	read = ion_file_transfer(file, offset, num_bytes, write_to, boolean_false);
+#else
+
+	if (0 == fseek(ION_FILE_STREAM(file), offset, SEEK_SET)) {
+		ion_file_stats_count(ION_FILE_STREAM(file), ion_file_io_seek, 0, 0);
+		read = fread(write_to, 1, num_bytes, ION_FILE_STREAM(file));
+	}
+
+#if !defined(ARDUINO)
+	/* a read at the end stops short, which is not an error of the file */
+	clearerr(ION_FILE_STREAM(file));
+#endif
+#endif
+	ION_FILE_STATS_END(file, ion_file_io_read, read);
+
+	return read;
+}
+
+/**
+@brief		The shared page cache.
+*/
+static struct {
+	int						page_count;	/**< The pages configured */
+	unsigned int			page_size;	/**< Their bytes */
+	ion_file_cache_page_t	*pages;		/**< The pages, once taken */
+	ion_byte_t				*data;		/**< Their bytes */
+	unsigned long			clock;		/**< Ticks on every use */
+	ion_boolean_t			failed;		/**< Whether the memory could not
+										 be taken */
+	ion_file_cache_stats_t	stats;		/**< The counters */
+} ion_file_cache = {
+	ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE, NULL, NULL, 0, boolean_false, { 0, 0, 0, 0 }
+};
+
+#if !defined(ARDUINO)
+
+/**
+@brief		Guards the page cache, held through every use of it.
+*/
+static pthread_mutex_t ion_file_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+@brief		A file whose sync was put off by @ref ion_fsync_defer.
+*/
+typedef struct {
+	int		descriptor;	/**< Its descriptor */
+	void	*stream;	/**< What its counters are kept under, or NULL if
+						 it is not counted */
+} ion_file_deferred_t;
+
+/**
+@brief		The syncs put off, each file once.
+*/
+static struct {
+	ion_boolean_t		deferring;	/**< Whether syncs are put off */
+	pthread_t			thread;		/**< The thread putting them off */
+	ion_file_deferred_t *files;		/**< The files, in the order first
+									 synced */
+	int					count;		/**< The files */
+	int					capacity;	/**< The files there is room for */
+} ion_file_deferred;
+
+/**
+@brief		Guards the syncs put off.
+*/
+static pthread_mutex_t ion_file_defer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+@brief		Puts off the sync of a file, if the calling thread puts off its
+			syncs.
+@return		Whether it was put off. Without the memory to remember the
+			file it is not, and is synced at once.
+*/
+static ion_boolean_t
+ion_file_defer(
+	int		descriptor,
+	void	*stream
+) {
+	ion_file_deferred_t *files;
+	ion_boolean_t		deferred = boolean_false;
+	int					i;
+
+	ION_FILE_LOCK(ion_file_defer_lock);
+
+	if (ion_file_deferred.deferring && pthread_equal(ion_file_deferred.thread, pthread_self())) {
+		for (i = 0; (i < ion_file_deferred.count) && (ion_file_deferred.files[i].descriptor != descriptor); i++) {}
+
+		if (i == ion_file_deferred.capacity) {
+			files = realloc(ion_file_deferred.files, sizeof(ion_file_deferred_t) * (0 == i ? 8 : 2 * i));
+
+			if (NULL != files) {
+				ion_file_deferred.files		= files;
+				ion_file_deferred.capacity	= (0 == i) ? 8 : 2 * i;
+			}
+		}
+
+		if (i < ion_file_deferred.count) {
+			deferred = boolean_true;
+		}
+		else if (i < ion_file_deferred.capacity) {
+			ion_file_deferred.files[i].descriptor	= descriptor;
+			ion_file_deferred.files[i].stream		= stream;
+			ion_file_deferred.count++;
+			deferred								= boolean_true;
+		}
+	}
+
+	ION_FILE_UNLOCK(ion_file_defer_lock);
+
+	return deferred;
+}
+
+#endif
+
+/**
+@brief		Takes the memory of the cache on first use.
+@return		Whether there is a cache to use.
+*/
+static ion_boolean_t
+ion_file_cache_ready(
+	void
+) {
+	int i;
+
+	if (NULL != ion_file_cache.pages) {
+		return boolean_true;
+	}
+
+	if ((0 == ion_file_cache.page_count) || ion_file_cache.failed) {
+		return boolean_false;
+	}
+
+	ion_file_cache.pages	= malloc(ion_file_cache.page_count * sizeof(ion_file_cache_page_t));
+#if defined(ION_FILE_DIRECT)
+
+	/* pages are moved straight to files opened with O_DIRECT */
+	if (0 != posix_memalign((void **) &ion_file_cache.data, ION_FILE_DIRECT_ALIGNMENT, (size_t) ion_file_cache.page_count * ion_file_cache.page_size)) {
+		ion_file_cache.data = NULL;
+	}
+
+#else
+	ion_file_cache.data		= malloc((size_t) ion_file_cache.page_count * ion_file_cache.page_size);
+#endif
+
+	if ((NULL == ion_file_cache.pages) || (NULL == ion_file_cache.data)) {
+		/* files are then simply read and written directly */
+		free(ion_file_cache.pages);
+		free(ion_file_cache.data);
+		ion_file_cache.pages	= NULL;
+		ion_file_cache.data		= NULL;
+		ion_file_cache.failed	= boolean_true;
+		return boolean_false;
+	}
+
+	for (i = 0; i < ion_file_cache.page_count; i++) {
+		ion_file_cache.pages[i].stream	= NULL;
+		ion_file_cache.pages[i].page	= 0;
+		ion_file_cache.pages[i].length	= 0;
+		ion_file_cache.pages[i].dirty	= boolean_false;
+		ion_file_cache.pages[i].data	= ion_file_cache.data + (size_t) i * ion_file_cache.page_size;
+	}
+
+	return boolean_true;
+}
+
+/**
+@brief		Writes a dirty page back to its file.
+*/
+static ion_err_t
+ion_file_cache_write_back(
+	ion_file_cache_page_t *page
+) {
+	ion_file_offset_t offset = page->page * (ion_file_offset_t) ion_file_cache.page_size;
+
+	if (page->length != ion_file_pwrite(page->file, offset, page->length, page->data)) {
+		return err_file_incomplete_write;
+	}
+
+	page->dirty = boolean_false;
+	ion_file_cache.stats.write_backs++;
+
+	return err_ok;
+}
+
+/**
+@brief		Writes back the dirty pages of a file that hold any of a range
+			of its bytes, and drops them if asked.
+@param		first
+				The first byte of the range.
+@param		end
+				One past its last, @ref ION_FILE_WHOLE for every page.
+*/
+static ion_err_t
+ion_file_cache_sync(
+	void				*stream,
+	ion_file_offset_t	first,
+	ion_file_offset_t	end,
+	ion_boolean_t		drop
+) {
+	ion_file_cache_page_t	*page;
+	ion_file_offset_t		page_start;
+	ion_err_t				error;
+	int						i;
+
+	if (NULL == ion_file_cache.pages) {
+		return err_ok;
+	}
+
+	for (i = 0; i < ion_file_cache.page_count; i++) {
+		page = ion_file_cache.pages + i;
+
+		if (stream != page->stream) {
+			continue;
+		}
+
+		page_start = page->page * (ion_file_offset_t) ion_file_cache.page_size;
+
+		if ((page_start >= end) || (page_start + (ion_file_offset_t) ion_file_cache.page_size <= first)) {
+			continue;
+		}
+
+		if (page->dirty && (err_ok != (error = ion_file_cache_write_back(page)))) {
+			return error;
+		}
+
+		if (drop) {
+			page->stream = NULL;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Drops every page of a file, written back or not.
+*/
+static void
+ion_file_cache_drop(
+	void *stream
+) {
+	int i;
+
+	for (i = 0; (NULL != ion_file_cache.pages) && (i < ion_file_cache.page_count); i++) {
+		if (stream == ion_file_cache.pages[i].stream) {
+			ion_file_cache.pages[i].stream	= NULL;
+			ion_file_cache.pages[i].dirty	= boolean_false;
+		}
+	}
+}
+
+/**
+@brief		Reads a page from its file, as much of it as there is.
+*/
+static void
+ion_file_cache_fill(
+	ion_file_cache_page_t *page
+) {
+	page->length = ion_file_pread(page->file, page->page * (ion_file_offset_t) ion_file_cache.page_size, ion_file_cache.page_size, page->data);
+}
+
+/**
+@brief		Finds a page of a file in the cache, making room for it and
+			reading it if it is not there.
+@param		fill
+				Whether its bytes are needed, which they are not when it is
+				about to be overwritten whole.
+@param		error
+				Receives the error writing back the page evicted.
+@return		The page, or @c NULL with @p error set.
+*/
+static ion_file_cache_page_t *
+ion_file_cache_get(
+	ion_file_handle_t	file,
+	ion_file_offset_t	page_number,
+	ion_boolean_t		fill,
+	ion_err_t			*error
+) {
+	void					*stream = ION_FILE_STREAM(file);
+	ion_file_cache_page_t	*victim = ion_file_cache.pages;
+	ion_file_cache_page_t	*page;
+	int						i;
+
+	ion_file_cache.clock++;
+
+	for (i = 0; i < ion_file_cache.page_count; i++) {
+		page = ion_file_cache.pages + i;
+
+		if ((stream == page->stream) && (page_number == page->page)) {
+			page->used = ion_file_cache.clock;
+			ion_file_cache.stats.hits++;
+			return page;
+		}
+
+		/* an unused page is taken before the least recently used one */
+		if ((NULL != victim->stream) && ((NULL == page->stream) || (page->used < victim->used))) {
+			victim = page;
+		}
+	}
+
+	ion_file_cache.stats.misses++;
+
+	if (NULL != victim->stream) {
+		if (victim->dirty && (err_ok != (*error = ion_file_cache_write_back(victim)))) {
+			return NULL;
+		}
+
+		ion_file_cache.stats.evictions++;
+	}
+
+	victim->stream	= stream;
+	victim->file	= file;
+	victim->page	= page_number;
+	victim->dirty	= boolean_false;
+	victim->used	= ion_file_cache.clock;
+	victim->length	= 0;
+
+	if (fill) {
+		ion_file_cache_fill(victim);
+	}
+
+	return victim;
+}
+
+/**
+@brief		Tells whether a read or write at an offset goes past the cache,
+			being large enough to sweep it.
+*/
+static ion_boolean_t
+ion_file_cache_bypassed(
+	unsigned int num_bytes
+) {
+	return !ion_file_cache_ready() || (num_bytes > (ion_file_cache.page_count / 2) * ion_file_cache.page_size);
+}
+
+ion_err_t
+ion_file_cache_configure(
+	int				page_count,
+	unsigned int	page_size
+) {
+	ion_err_t	error;
+	int			i;
+
+	if (0 == page_size) {
+		return err_invalid_initial_size;
+	}
+
+	ION_FILE_LOCK(ion_file_cache_lock);
+
+	for (i = 0; (NULL != ion_file_cache.pages) && (i < ion_file_cache.page_count); i++) {
+		if ((NULL != ion_file_cache.pages[i].stream) && ion_file_cache.pages[i].dirty && (err_ok != (error = ion_file_cache_write_back(ion_file_cache.pages + i)))) {
+			ION_FILE_UNLOCK(ion_file_cache_lock);
+			return error;
+		}
+	}
+
+	free(ion_file_cache.pages);
+	free(ion_file_cache.data);
+	ion_file_cache.pages		= NULL;
+	ion_file_cache.data			= NULL;
+	ion_file_cache.failed		= boolean_false;
+	ion_file_cache.page_count	= page_count;
+	ion_file_cache.page_size	= page_size;
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+
+	return err_ok;
+}
+
+void
+ion_file_cache_stats(
+	ion_file_cache_stats_t *stats
+) {
+	ION_FILE_LOCK(ion_file_cache_lock);
+	*stats = ion_file_cache.stats;
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+}
+
+void
+ion_file_cache_reset_stats(
+	void
+) {
+	ION_FILE_LOCK(ion_file_cache_lock);
+	ion_file_cache.stats.hits			= 0;
+	ion_file_cache.stats.misses			= 0;
+	ion_file_cache.stats.evictions		= 0;
+	ion_file_cache.stats.write_backs	= 0;
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+}
+
+ion_boolean_t
+ion_fexists(
+	char *name
+) {
+#if defined(ARDUINO)
+	return (ion_boolean_t) SD_File_Exists(name);
+#else
+	return -1 != access(name, F_OK);
+#endif
+}
+
+ion_file_handle_t
+ion_fopen(
+	char *name
+) {
+#if defined(ARDUINO)
+
+	ion_file_handle_t toret;
+
+	toret.file = fopen(name, "r+");
+
+	if (NULL == toret.file) {
+		toret.file = fopen(name, "w+");
+	}
+
+	return toret;
+#elif defined(ION_FILE_POSIX)
+
+	/* read and write, creating it if it is not there, as C streams would */
+#if defined(ION_FILE_DIRECT)
+	ion_file_handle_t file = open(name, O_RDWR | O_CREAT | O_DIRECT, 0666);
+
+	/* a file system without direct transfers still has the file */
+	if ((-1 == file) && (EINVAL == errno)) {
+		file = open(name, O_RDWR | O_CREAT, 0666);
+	}
+
+#else
+	ion_file_handle_t file = open(name, O_RDWR | O_CREAT, 0666);
+#endif
+
+	if (ION_NOFILE != file) {
+		ion_file_stats_opened(ION_FILE_STREAM(file), name);
+	}
+
+	return file;
+#else
+
+	ion_file_handle_t file;
+
+	file = fopen(name, "r+b");
+
+	if (NULL == file) {
+		file = fopen(name, "w+b");
+	}
+
+	if (ION_NOFILE != file) {
+		ion_file_stats_opened(ION_FILE_STREAM(file), name);
+	}
+
+	return file;
+#endif
+}
+
+ion_err_t
+ion_fclose(
+	ion_file_handle_t file
+) {
+	ion_err_t error;
+
+	/* the file is closed even if its pages cannot be written, so they go too */
+	ION_FILE_LOCK(ion_file_cache_lock);
+	error = ion_file_cache_sync(ION_FILE_STREAM(file), 0, ION_FILE_WHOLE, boolean_false);
+	ion_file_cache_drop(ION_FILE_STREAM(file));
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+#if !defined(ARDUINO)
+	ion_file_stats_closed(ION_FILE_STREAM(file));
+#endif
+
+#if defined(ARDUINO)
+	fclose(file.file);
+	return error;
+#elif defined(ION_FILE_POSIX)
+	close(file);
+	return error;
+#else
+	fclose(file);
+	return error;
+#endif
+}
+
+ion_err_t
+ion_fflush(
+	ion_file_handle_t file
+) {
+	ion_err_t error;
+
+	ION_FILE_LOCK(ion_file_cache_lock);
+	error = ion_file_cache_sync(ION_FILE_STREAM(file), 0, ION_FILE_WHOLE, boolean_false);
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+#if defined(ARDUINO)
+
+	if (0 != fflush(file.file)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+#elif defined(ION_FILE_POSIX)
+
+	/* a descriptor holds nothing back */
+	return err_ok;
+#else
+
+	if (0 != fflush(file)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+#endif
+}
+
+ion_err_t
+ion_fsync(
+	ion_file_handle_t file
 ) {
-#if defined(ARDUINO)
-	return (ion_boolean_t) SD_File_Exists(name);
+	ion_err_t error;
+
+	error = ion_fflush(file);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+#if !defined(ARDUINO)
+
+#if defined(ION_FILE_POSIX)
+	int descriptor = file;
 #else
-	return -1 != access(name, F_OK);
+	int descriptor = fileno(file);
+#endif
+
+	if (ion_file_defer(descriptor, ION_FILE_STREAM(file))) {
+		return err_ok;
+	}
+
+	/* the SD library writes the card on flush, elsewhere ask the OS */
+	ION_FILE_STATS_BEGIN();
+	error = (0 != fsync(descriptor)) ? err_file_write_error : err_ok;
+	ION_FILE_STATS_END(file, ion_file_io_sync, 0);
+
 #endif
+	return error;
 }
 
-ion_file_handle_t
-ion_fopen(
-	char *name
+ion_err_t
+ion_fsync_stream(
+	FILE *stream
 ) {
-#if defined(ARDUINO)
+	if (0 != fflush(stream)) {
+		return err_file_write_error;
+	}
 
-	ion_file_handle_t toret;
+#if !defined(ARDUINO)
 
-	toret.file = fopen(name, "r+");
+	if (!ion_file_defer(fileno(stream), NULL) && (0 != fsync(fileno(stream)))) {
+		return err_file_write_error;
+	}
 
-	if (NULL == toret.file) {
-		toret.file = fopen(name, "w+");
+#endif
+	return err_ok;
+}
+
+ion_err_t
+ion_fsync_defer(
+	void
+) {
+#if !defined(ARDUINO)
+	ion_err_t error = err_ok;
+
+	ION_FILE_LOCK(ion_file_defer_lock);
+
+	if (ion_file_deferred.deferring) {
+		error = err_illegal_state;
+	}
+	else {
+		ion_file_deferred.deferring = boolean_true;
+		ion_file_deferred.thread	= pthread_self();
 	}
 
-	return toret;
+	ION_FILE_UNLOCK(ion_file_defer_lock);
+
+	return error;
 #else
+	return err_ok;
+#endif
+}
 
-	ion_file_handle_t file;
+ion_err_t
+ion_fsync_deferred(
+	void
+) {
+#if !defined(ARDUINO)
+	ion_file_deferred_t *files;
+	int					count;
+	int					i;
+	ion_err_t			error = err_ok;
 
-	file = fopen(name, "r+b");
+	ION_FILE_LOCK(ion_file_defer_lock);
 
-	if (NULL == file) {
-		file = fopen(name, "w+b");
+	if (!ion_file_deferred.deferring || !pthread_equal(ion_file_deferred.thread, pthread_self())) {
+		ION_FILE_UNLOCK(ion_file_defer_lock);
+		return err_illegal_state;
 	}
 
-	return file;
+	files							= ion_file_deferred.files;
+	count							= ion_file_deferred.count;
+	ion_file_deferred.deferring		= boolean_false;
+	ion_file_deferred.files			= NULL;
+	ion_file_deferred.count			= 0;
+	ion_file_deferred.capacity		= 0;
+	ION_FILE_UNLOCK(ion_file_defer_lock);
+
+	for (i = 0; i < count; i++) {
+#if ION_FILE_STATS
+		unsigned long ion_file_stats_start = ion_file_stats_clock();
+#endif
+
+		if ((0 != fsync(files[i].descriptor)) && (err_ok == error)) {
+			error = err_file_write_error;
+		}
+
+#if ION_FILE_STATS
+
+		if (NULL != files[i].stream) {
+			ion_file_stats_count(files[i].stream, ion_file_io_sync, 0, ion_file_stats_clock() - ion_file_stats_start);
+		}
+
+#endif
+	}
+
+	free(files);
+
+	return error;
+#else
+	return err_ok;
 #endif
 }
 
 ion_err_t
-ion_fclose(
-	ion_file_handle_t file
+ion_ftruncate(
+	ion_file_handle_t	file,
+	ion_file_offset_t	size
 ) {
 #if defined(ARDUINO)
-	fclose(file.file);
-	return err_ok;
+	UNUSED(file);
+	UNUSED(size);
+
+	return err_not_implemented;
 #else
-	fclose(file);
+	ion_err_t error;
+
+	error = ion_fflush(file);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	/* the pages past the new end, and the one it cuts, would be stale */
+	ION_FILE_LOCK(ion_file_cache_lock);
+	ion_file_cache_drop(ION_FILE_STREAM(file));
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+
+#if defined(ION_FILE_POSIX)
+
+	if (0 != ftruncate(file, size)) {
+#else
+
+	if (0 != ftruncate(fileno(file), size)) {
+#endif
+		return err_file_write_error;
+	}
+
 	return err_ok;
 #endif
 }
@@ -75,21 +1270,30 @@ ion_fseek(
 	ion_file_offset_t	seek_to,
 	int					origin
 ) {
-#if defined(ARDUINO)
-
-	if (0 != fseek(file.file, seek_to, origin)) {
-		return err_file_bad_seek;
-	}
+	ion_err_t error;
 
-	return err_ok;
-#else
+	/* the end of a file is where it is once its pages are written */
+	if (ION_FILE_END == origin) {
+		ION_FILE_LOCK(ion_file_cache_lock);
+		error = ion_file_cache_sync(ION_FILE_STREAM(file), 0, ION_FILE_WHOLE, boolean_false);
+		ION_FILE_UNLOCK(ion_file_cache_lock);
 
-	if (0 != fseek(file, seek_to, origin)) {
-		return err_file_bad_seek;
+		if (err_ok != error) {
+			return error;
+		}
 	}
 
-	return err_ok;
+	ION_FILE_STATS_BEGIN();
+#if defined(ARDUINO)
+	error = (0 != fseek(file.file, seek_to, origin)) ? err_file_bad_seek : err_ok;
+#elif defined(ION_FILE_POSIX)
+	error = (-1 == lseek(file, seek_to, origin)) ? err_file_bad_seek : err_ok;
+#else
+	error = (0 != fseek(file, seek_to, origin)) ? err_file_bad_seek : err_ok;
 #endif
+	ION_FILE_STATS_END(file, ion_file_io_seek, 0);
+
+	return error;
 }
 
 ion_file_offset_t
@@ -98,6 +1302,8 @@ ion_ftell(
 ) {
 #if defined(ARDUINO)
 	return ftell(file.file);
+#elif defined(ION_FILE_POSIX)
+	return (ion_file_offset_t) lseek(file, 0, SEEK_CUR);
 #else
 	return ftell(file);
 #endif
@@ -118,8 +1324,11 @@ ion_fend(
 	return to_return;
 }
 
-ion_err_t
-ion_fwrite(
+/**
+@brief		Writes bytes at the position of a file, past the cache.
+*/
+static ion_err_t
+ion_file_write(
 	ion_file_handle_t	file,
 	unsigned int		num_bytes,
 	ion_byte_t			*to_write
@@ -130,13 +1339,106 @@ ion_fwrite(
 		return err_file_incomplete_write;
 	}
 
+	return err_ok;
+#elif defined(ION_FILE_DIRECT)
+
+	ion_file_offset_t offset = ion_ftell(file);
+
+	if ((num_bytes != ion_file_direct_transfer(file, offset, num_bytes, to_write, boolean_true)) || (-1 == lseek(file, offset + num_bytes, SEEK_SET))) {
+		return err_file_incomplete_write;
+	}
+
+	return err_ok;
+#elif defined(ION_FILE_POSIX)
+
+	if (num_bytes != ion_file_transfer(file, -1, num_bytes, to_write, boolean_true)) {
+		return err_file_incomplete_write;
+	}
+
+	return err_ok;
+#else
+
+	if ((0 != num_bytes) && (1 != fwrite(to_write, num_bytes, 1, file))) {
+		return err_file_incomplete_write;
+	}
+
+	return err_ok;
+#endif
+}
+
+/**
+@brief		Reads bytes at the position of a file, past the cache.
+*/
+static ion_err_t
+ion_file_read(
+	ion_file_handle_t	file,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+#if defined(ARDUINO)
+
+	if (num_bytes != (fread(write_to, num_bytes, 1, file.file) * num_bytes)) {
+		return err_file_incomplete_read;
+	}
+
+	return err_ok;
+#elif defined(ION_FILE_DIRECT)
+
+	ion_file_offset_t offset = ion_ftell(file);
+
+	if ((num_bytes != ion_file_direct_transfer(file, offset, num_bytes, write_to, boolean_false)) || (-1 == lseek(file, offset + num_bytes, SEEK_SET))) {
+		return err_file_incomplete_read;
+	}
+
+	return err_ok;
+#elif defined(ION_FILE_POSIX)
+
+	if (num_bytes != ion_file_transfer(file, -1, num_bytes, write_to, boolean_false)) {
+		return err_file_incomplete_read;
+	}
+
 	return err_ok;
 #else
-	fwrite(to_write, num_bytes, 1, file);
+
+	if (1 != fread(write_to, num_bytes, 1, file)) {
+		return err_file_incomplete_read;
+	}
+
 	return err_ok;
 #endif
 }
 
+ion_err_t
+ion_fwrite(
+	ion_file_handle_t	file,
+	unsigned int		num_bytes,
+	ion_byte_t			*to_write
+) {
+	ion_file_offset_t	offset = ion_ftell(file);
+	unsigned long		write_backs;
+	ion_err_t			error;
+
+	/* cached pages of the bytes written go, rather than being patched */
+	ION_FILE_LOCK(ion_file_cache_lock);
+	write_backs = ion_file_cache.stats.write_backs;
+	error		= ion_file_cache_sync(ION_FILE_STREAM(file), offset, offset + num_bytes, boolean_true);
+	write_backs = ion_file_cache.stats.write_backs - write_backs;
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+
+	/* writing pages back moves the position of a stream */
+	if ((err_ok == error) && (0 != write_backs)) {
+		error = ion_fseek(file, offset, ION_FILE_START);
+	}
+
+	if (err_ok == error) {
+		ION_FILE_STATS_BEGIN();
+		error = ion_file_write(file, num_bytes, to_write);
+		ION_FILE_STATS_END(file, ion_file_io_write, (err_ok == error) ? num_bytes : 0);
+	}
+
+	return error;
+}
+
 ion_err_t
 ion_fwrite_at(
 	ion_file_handle_t	file,
@@ -144,15 +1446,162 @@ ion_fwrite_at(
 	unsigned int		num_bytes,
 	ion_byte_t			*to_write
 ) {
-	ion_err_t error;
+	ion_file_vector_t vector;
 
-	error = ion_fseek(file, offset, ION_FILE_START);
+	vector.bytes		= to_write;
+	vector.num_bytes	= num_bytes;
+
+	return ion_fwritev_at(file, offset, &vector, 1);
+}
+
+/**
+@brief		Moves bytes between a page and a run of vectors, from where the
+			last move stopped.
+@param		vector
+				The vector to go on from, moved past those used up.
+@param		within
+				Where in it, moved along.
+@param		gather
+				Whether the bytes go from the vectors to the page rather
+				than the other way.
+*/
+static void
+ion_file_scatter(
+	ion_file_vector_t	*vectors,
+	int					*vector,
+	unsigned int		*within,
+	ion_byte_t			*page_bytes,
+	unsigned int		num_bytes,
+	ion_boolean_t		gather
+) {
+	unsigned int chunk;
+
+	while (num_bytes > 0) {
+		chunk = vectors[*vector].num_bytes - *within;
+
+		if (chunk > num_bytes) {
+			chunk = num_bytes;
+		}
+
+		if (gather) {
+			memcpy(page_bytes, vectors[*vector].bytes + *within, chunk);
+		}
+		else {
+			memcpy(vectors[*vector].bytes + *within, page_bytes, chunk);
+		}
+
+		page_bytes	+= chunk;
+		num_bytes	-= chunk;
+		*within		+= chunk;
+
+		if (*within == vectors[*vector].num_bytes) {
+			(*vector)++;
+			*within = 0;
+		}
+	}
+}
+
+/**
+@brief		Adds up the bytes of a run of vectors.
+*/
+static unsigned int
+ion_file_vectors_size(
+	ion_file_vector_t	*vectors,
+	int					count
+) {
+	unsigned int	total = 0;
+	int				i;
+
+	for (i = 0; i < count; i++) {
+		total += vectors[i].num_bytes;
+	}
+
+	return total;
+}
+
+/**
+@brief		Makes a vectored write at an offset through the cache, its lock
+			held.
+*/
+static ion_err_t
+ion_file_cache_writev(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	ion_file_vector_t	*vectors,
+	int					count
+) {
+	ion_file_cache_page_t	*page;
+	ion_file_offset_t		page_number;
+	unsigned int			num_bytes	= ion_file_vectors_size(vectors, count);
+	unsigned int			within;
+	unsigned int			chunk;
+	unsigned int			at			= 0;
+	int						vector		= 0;
+	ion_err_t				error		= err_ok;
+
+	if (ion_file_cache_bypassed(num_bytes)) {
+		/* cached pages of the bytes written go, rather than being patched */
+		error = ion_file_cache_sync(ION_FILE_STREAM(file), offset, offset + num_bytes, boolean_true);
+
+		for (; (err_ok == error) && (vector < count); vector++) {
+			if (vectors[vector].num_bytes != ion_file_pwrite(file, offset, vectors[vector].num_bytes, vectors[vector].bytes)) {
+				error = err_file_incomplete_write;
+			}
+
+			offset += vectors[vector].num_bytes;
+		}
 
-	if (err_ok != error) {
 		return error;
 	}
 
-	error = ion_fwrite(file, num_bytes, to_write);
+	while (num_bytes > 0) {
+		page_number = offset / ion_file_cache.page_size;
+		within		= offset % ion_file_cache.page_size;
+		chunk		= ion_file_cache.page_size - within;
+
+		if (chunk > num_bytes) {
+			chunk = num_bytes;
+		}
+
+		/* a page written whole need not be read first */
+		page = ion_file_cache_get(file, page_number, chunk != ion_file_cache.page_size, &error);
+
+		if (NULL == page) {
+			return error;
+		}
+
+		/* a gap past the end of the file reads as zeros, as the file would */
+		if (within > page->length) {
+			memset(page->data + page->length, 0, within - page->length);
+		}
+
+		ion_file_scatter(vectors, &vector, &at, page->data + within, chunk, boolean_true);
+
+		if (within + chunk > page->length) {
+			page->length = within + chunk;
+		}
+
+		page->dirty = boolean_true;
+		offset		+= chunk;
+		num_bytes	-= chunk;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+ion_fwritev_at(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	ion_file_vector_t	*vectors,
+	int					count
+) {
+	ion_err_t error;
+
+	ION_FILE_LOCK(ion_file_cache_lock);
+	error = ion_file_cache_writev(file, offset, vectors, count);
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+
 	return error;
 }
 
@@ -180,21 +1629,28 @@ ion_fread(
 	unsigned int		num_bytes,
 	ion_byte_t			*write_to
 ) {
-#if defined(ARDUINO)
+	ion_file_offset_t	offset = ion_ftell(file);
+	unsigned long		write_backs;
+	ion_err_t			error;
 
-	if (num_bytes != (fread(write_to, num_bytes, 1, file.file) * num_bytes)) {
-		return err_file_incomplete_read;
-	}
+	ION_FILE_LOCK(ion_file_cache_lock);
+	write_backs = ion_file_cache.stats.write_backs;
+	error		= ion_file_cache_sync(ION_FILE_STREAM(file), offset, offset + num_bytes, boolean_false);
+	write_backs = ion_file_cache.stats.write_backs - write_backs;
+	ION_FILE_UNLOCK(ion_file_cache_lock);
 
-	return err_ok;
-#else
+	/* writing pages back moves the position of a stream */
+	if ((err_ok == error) && (0 != write_backs)) {
+		error = ion_fseek(file, offset, ION_FILE_START);
+	}
 
-	if (1 != fread(write_to, num_bytes, 1, file)) {
-		return err_file_incomplete_read;
+	if (err_ok == error) {
+		ION_FILE_STATS_BEGIN();
+		error = ion_file_read(file, num_bytes, write_to);
+		ION_FILE_STATS_END(file, ion_file_io_read, (err_ok == error) ? num_bytes : 0);
 	}
 
-	return err_ok;
-#endif
+	return error;
 }
 
 ion_err_t
@@ -204,14 +1660,96 @@ ion_fread_at(
 	unsigned int		num_bytes,
 	ion_byte_t			*write_to
 ) {
-	ion_err_t error;
+	ion_file_vector_t vector;
 
-	error = ion_fseek(file, offset, ION_FILE_START);
+	vector.bytes		= write_to;
+	vector.num_bytes	= num_bytes;
+
+	return ion_freadv_at(file, offset, &vector, 1);
+}
+
+/**
+@brief		Makes a vectored read at an offset through the cache, its lock
+			held.
+*/
+static ion_err_t
+ion_file_cache_readv(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	ion_file_vector_t	*vectors,
+	int					count
+) {
+	ion_file_cache_page_t	*page;
+	ion_file_offset_t		page_number;
+	unsigned int			num_bytes	= ion_file_vectors_size(vectors, count);
+	unsigned int			within;
+	unsigned int			chunk;
+	unsigned int			at			= 0;
+	int						vector		= 0;
+	ion_err_t				error		= err_ok;
+
+	if (ion_file_cache_bypassed(num_bytes)) {
+		error = ion_file_cache_sync(ION_FILE_STREAM(file), offset, offset + num_bytes, boolean_false);
+
+		for (; (err_ok == error) && (vector < count); vector++) {
+			if (vectors[vector].num_bytes != ion_file_pread(file, offset, vectors[vector].num_bytes, vectors[vector].bytes)) {
+				error = err_file_incomplete_read;
+			}
+
+			offset += vectors[vector].num_bytes;
+		}
 
-	if (err_ok != error) {
 		return error;
 	}
 
-	error = ion_fread(file, num_bytes, write_to);
+	while (num_bytes > 0) {
+		page_number = offset / ion_file_cache.page_size;
+		within		= offset % ion_file_cache.page_size;
+		chunk		= ion_file_cache.page_size - within;
+
+		if (chunk > num_bytes) {
+			chunk = num_bytes;
+		}
+
+		page = ion_file_cache_get(file, page_number, boolean_true, &error);
+
+		if (NULL == page) {
+			return error;
+		}
+
+		/* the file may have grown past the page since it was read, through pages written back since */
+		if (within + chunk > page->length) {
+			if (err_ok != (error = ion_file_cache_sync(ION_FILE_STREAM(file), 0, ION_FILE_WHOLE, boolean_false))) {
+				return error;
+			}
+
+			ion_file_cache_fill(page);
+
+			if (within + chunk > page->length) {
+				return err_file_incomplete_read;
+			}
+		}
+
+		ion_file_scatter(vectors, &vector, &at, page->data + within, chunk, boolean_false);
+		offset		+= chunk;
+		num_bytes	-= chunk;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+ion_freadv_at(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	ion_file_vector_t	*vectors,
+	int					count
+) {
+	ion_err_t error;
+
+	ION_FILE_LOCK(ion_file_cache_lock);
+	error = ion_file_cache_readv(file, offset, vectors, count);
+	ION_FILE_UNLOCK(ion_file_cache_lock);
+
 	return error;
 }
@@ -38,14 +38,176 @@ typedef struct file_handle {
 #include "stdio.h"
 #include "unistd.h"
 
+/**
+@brief		Define to keep files in C streams rather than POSIX file
+			descriptors.
+@details	By default files are descriptors, read and written at an offset
+			with @c pread and @c pwrite, so reading at an offset neither
+			seeks nor moves the position of the file. Reads at an offset
+			of the same file may then run from several threads at once.
+			Whichever way files are kept, the page cache and the counters
+			they share are locked, so different files may be used from
+			different threads.
+*/
+#if !defined(ION_FILE_STDIO)
+#define ION_FILE_POSIX
+#endif
+
+/**
+@brief		Define to open files with @c O_DIRECT, so the page cache is the
+			only cache of their bytes.
+@details	Only files kept as descriptors on systems with @c O_DIRECT are
+			opened so; a file system that refuses it, such as @c tmpfs,
+			gets the file opened as usual. Every transfer is then made in
+			whole blocks of @ref ION_FILE_DIRECT_ALIGNMENT bytes from memory
+			aligned as much, those not so through an aligned buffer of
+			their own; the pages of the cache are aligned and default to a
+			block each.
+*/
+#if defined(ION_FILE_DIRECT) && !defined(ION_FILE_POSIX)
+#undef ION_FILE_DIRECT
+#endif
+
+/**
+@brief		The alignment, in bytes, of the offsets, sizes and memory of
+			transfers of files opened with @c O_DIRECT.
+*/
+#if !defined(ION_FILE_DIRECT_ALIGNMENT)
+#define ION_FILE_DIRECT_ALIGNMENT 4096
+#endif
+
+#if defined(ION_FILE_POSIX)
+
+typedef int ion_file_handle_t;
+
+#define ION_NOFILE ((ion_file_handle_t) (-1))
+
+#else
+
 typedef FILE *ion_file_handle_t;
 
 #define ION_NOFILE ((ion_file_handle_t) (NULL))
 
+#endif
+
 #endif /* Clause ARDUINO */
 
 #define ION_FILE_NULL -1
 
+/**
+@brief		The pages the shared page cache holds, 0 to read and write
+			files directly.
+@details	Reads and writes at an offset go through a page cache shared
+			by every file, keyed by the file and the page. Their pages are
+			written back when evicted, and when the file is flushed,
+			synced, truncated, closed or seeked to its end, so callers that
+			stay within this API see their writes in order. Data written
+			through the cache is not in the file until then, and the
+			position of a file is left unspecified by a read or write at
+			an offset.
+*/
+#if !defined(ION_FILE_CACHE_PAGES)
+#if defined(ARDUINO)
+#define ION_FILE_CACHE_PAGES 4
+#else
+#define ION_FILE_CACHE_PAGES 64
+#endif
+#endif
+
+/**
+@brief		The bytes of each page of the shared page cache.
+*/
+#if !defined(ION_FILE_CACHE_PAGE_SIZE)
+#if defined(ARDUINO)
+#define ION_FILE_CACHE_PAGE_SIZE 128
+#elif defined(ION_FILE_DIRECT)
+#define ION_FILE_CACHE_PAGE_SIZE ION_FILE_DIRECT_ALIGNMENT
+#else
+#define ION_FILE_CACHE_PAGE_SIZE 512
+#endif
+#endif
+
+/**
+@brief		A run of bytes in memory, one of several read or written as
+			consecutive bytes of a file.
+*/
+typedef struct {
+	ion_byte_t		*bytes;		/**< Where they are */
+	unsigned int	num_bytes;	/**< How many */
+} ion_file_vector_t;
+
+/**
+@brief		Counters of the shared page cache.
+*/
+typedef struct {
+	unsigned long	hits;			/**< Pages found in the cache */
+	unsigned long	misses;			/**< Pages read into the cache */
+	unsigned long	evictions;		/**< Pages dropped to make room */
+	unsigned long	write_backs;	/**< Dirty pages written to their file */
+} ion_file_cache_stats_t;
+
+/**
+@brief		Whether the reads, writes, seeks and syncs that reach each file
+			are counted and timed.
+@details	Files of @ref ion_fopen are counted in this layer, past the
+			page cache; on Arduino, where every file is an SD file, the SD
+			interface counts instead, as its buffer reaches the card, and
+			includes the files of engines kept in C streams.
+*/
+#if !defined(ION_FILE_STATS)
+#if defined(ARDUINO)
+#define ION_FILE_STATS 0
+#else
+#define ION_FILE_STATS 1
+#endif
+#endif
+
+/**
+@brief		The files counted at once. A file opened when every entry is
+			taken by an open file is not counted.
+*/
+#if !defined(ION_FILE_STATS_FILES)
+#if defined(ARDUINO)
+#define ION_FILE_STATS_FILES 8
+#else
+#define ION_FILE_STATS_FILES 32
+#endif
+#endif
+
+/**
+@brief		The bytes of a file name kept with its counters, its end
+			included.
+*/
+#define ION_FILE_STATS_NAME 20
+
+/**
+@brief		The kinds of transfer counted for a file.
+*/
+typedef enum {
+	ion_file_io_read,	/**< Bytes read from it */
+	ion_file_io_write,	/**< Bytes written to it */
+	ion_file_io_seek,	/**< Its position moved */
+	ion_file_io_sync	/**< It pushed to storage */
+} ion_file_io_t;
+
+/**
+@brief		Counters of a file, kept by name, so a file closed and opened
+			again goes on from where it was.
+*/
+typedef struct {
+	char			name[ION_FILE_STATS_NAME];	/**< Its name, cut short if need be */
+	int				dictionary_id;	/**< The dictionary it belongs to, by
+									 its name, or -1 */
+	ion_boolean_t	open;			/**< Whether it is open */
+	unsigned long	reads;			/**< Reads of it */
+	unsigned long	read_bytes;		/**< The bytes they read */
+	unsigned long	writes;			/**< Writes to it */
+	unsigned long	write_bytes;	/**< The bytes they wrote */
+	unsigned long	seeks;			/**< Seeks of it */
+	unsigned long	syncs;			/**< Flushes and syncs of it */
+	unsigned long	micros;			/**< Microseconds spent in all of them */
+} ion_file_io_stats_t;
+
 ion_boolean_t
 ion_fexists(
 	char *name
@@ -61,6 +223,64 @@ ion_fclose(
 	ion_file_handle_t file
 );
 
+ion_err_t
+ion_fflush(
+	ion_file_handle_t file
+);
+
+ion_err_t
+ion_fsync(
+	ion_file_handle_t file
+);
+
+/**
+@brief		Pushes a stdio stream through to storage, as @ref ion_fsync does
+			for the files of @ref ion_fopen.
+@details	For the dictionaries that keep @c FILE streams of their own.
+@param		stream
+				The stream, open for writing.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+ion_fsync_stream(
+	FILE *stream
+);
+
+/**
+@brief		Puts off the syncs of the calling thread, so that many pushes
+			reach the device together.
+@details	Until @ref ion_fsync_deferred, @ref ion_fsync and
+			@ref ion_fsync_stream called from this thread only flush, and
+			the file is remembered to be forced once at the end. Those of
+			other threads sync as before. The files must stay open until
+			then. On Arduino, where the SD library writes the card on
+			flush, nothing is put off.
+@returns	@c err_ok, or @c err_illegal_state if syncs are already put
+			off.
+*/
+ion_err_t
+ion_fsync_defer(
+	void
+);
+
+/**
+@brief		Forces each file whose sync was put off by
+			@ref ion_fsync_defer, once and in the order first synced, and
+			syncs as before from then on.
+@returns	@c err_ok, the first error of the forced syncs, or
+			@c err_illegal_state if this thread did not put its syncs off.
+*/
+ion_err_t
+ion_fsync_deferred(
+	void
+);
+
+ion_err_t
+ion_ftruncate(
+	ion_file_handle_t	file,
+	ion_file_offset_t	size
+);
+
 ion_err_t
 ion_fremove(
 	char *name
@@ -113,6 +333,170 @@ ion_fread_at(
 	ion_byte_t			*write_to
 );
 
+/**
+@brief		Writes several runs of bytes to consecutive bytes of a file.
+
+@details	The runs go through the page cache together, so runs sharing a
+			page cost one lookup of it rather than one each.
+
+@param		file
+				The file to write.
+@param		offset
+				Where the first run goes.
+@param		vectors
+				The runs, in the order they go in the file.
+@param		count
+				How many.
+@return		The status of the write.
+*/
+ion_err_t
+ion_fwritev_at(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	ion_file_vector_t	*vectors,
+	int					count
+);
+
+/**
+@brief		Reads consecutive bytes of a file into several runs of bytes.
+
+@param		file
+				The file to read.
+@param		offset
+				Where the bytes of the first run are.
+@param		vectors
+				The runs, in the order their bytes are in the file.
+@param		count
+				How many.
+@return		The status of the read, @c err_file_incomplete_read if the
+			file ends first.
+*/
+ion_err_t
+ion_freadv_at(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	ion_file_vector_t	*vectors,
+	int					count
+);
+
+/**
+@brief		Resizes the shared page cache.
+
+@details	Dirty pages are written back and every page is dropped first.
+			The memory of the new pages is taken on first use. With
+			@ref ION_FILE_DIRECT, pages a multiple of
+			@ref ION_FILE_DIRECT_ALIGNMENT go to their file without a copy.
+
+@param		page_count
+				The pages to hold, 0 to read and write files directly.
+@param		page_size
+				The bytes of each page.
+@return		@c err_ok, @c err_invalid_initial_size if @p page_size is 0,
+			or the error writing a page back, in which case the cache is
+			left as it was.
+*/
+ion_err_t
+ion_file_cache_configure(
+	int				page_count,
+	unsigned int	page_size
+);
+
+/**
+@brief		Reads the counters of the shared page cache.
+
+@param		stats
+				Receives the counters.
+*/
+void
+ion_file_cache_stats(
+	ion_file_cache_stats_t *stats
+);
+
+/**
+@brief		Zeroes the counters of the shared page cache.
+*/
+void
+ion_file_cache_reset_stats(
+	void
+);
+
+/**
+@brief		Starts counting a file just opened.
+
+@details	Called by the layer that opens files, @ref ion_fopen or the SD
+			interface. A file counted before under the same name goes on
+			from its counters.
+
+@param		stream
+				What the file is known by until it is closed.
+@param		name
+				The name it was opened by.
+*/
+void
+ion_file_stats_opened(
+	void		*stream,
+	const char	*name
+);
+
+/**
+@brief		Stops counting a file about to be closed, keeping its counters.
+*/
+void
+ion_file_stats_closed(
+	void *stream
+);
+
+/**
+@brief		Counts a transfer of a file, if it is counted.
+
+@param		kind
+				What it was.
+@param		num_bytes
+				The bytes it moved, 0 for a seek or sync.
+@param		micros
+				The microseconds it took.
+*/
+void
+ion_file_stats_count(
+	void			*stream,
+	ion_file_io_t	kind,
+	unsigned long	num_bytes,
+	unsigned long	micros
+);
+
+/**
+@brief		Reads the counters of every file counted, open or closed.
+
+@param		stats
+				Receives them.
+@param		max
+				The most @p stats holds.
+@return		How many files there are, which may be more than @p max.
+*/
+int
+ion_file_io_stats(
+	ion_file_io_stats_t *stats,
+	int					max
+);
+
+/**
+@brief		Writes the counters of every file counted to @c stdout, one
+			line a file.
+*/
+void
+ion_file_io_stats_print(
+	void
+);
+
+/**
+@brief		Forgets the counters of every file, and counts those open from
+			zero.
+*/
+void
+ion_file_io_stats_reset(
+	void
+);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -37,6 +37,7 @@ lfb_put(
 	ion_file_offset_t	*wrote_at
 ) {
 	ion_file_offset_t	next_empty;
+	ion_file_vector_t	record[2];
 	ion_err_t			error;
 
 	next_empty = ION_LFB_NULL;
@@ -54,13 +55,13 @@ lfb_put(
 		*wrote_at = ion_fend(bag->file_handle);
 	}
 
-	error = ion_fwrite_at(bag->file_handle, *wrote_at, sizeof(ion_file_offset_t), (ion_byte_t *) &next);
+	/* the link and the item are written together */
+	record[0].bytes		= (ion_byte_t *) &next;
+	record[0].num_bytes = sizeof(ion_file_offset_t);
+	record[1].bytes		= to_write;
+	record[1].num_bytes = num_bytes;
 
-	if (err_ok != error) {
-		return error;
-	}
-
-	error = ion_fwrite_at(bag->file_handle, *wrote_at + sizeof(ion_file_offset_t), num_bytes, to_write);
+	error = ion_fwritev_at(bag->file_handle, *wrote_at, record, 2);
 
 	if (err_ok != error) {
 		return error;
@@ -78,18 +79,40 @@ lfb_get(
 	unsigned int		num_bytes,
 	ion_byte_t			*write_to,
 	ion_file_offset_t	*next
+) {
+	ion_file_vector_t record[2];
+
+	record[0].bytes		= (ion_byte_t *) next;
+	record[0].num_bytes = sizeof(ion_file_offset_t);
+	record[1].bytes		= write_to;
+	record[1].num_bytes = num_bytes;
+
+	return ion_freadv_at(bag->file_handle, offset, record, 2);
+}
+
+ion_err_t
+lfb_get_part(
+	ion_lfb_t			*bag,
+	ion_file_offset_t	offset,
+	unsigned int		skip,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to,
+	ion_file_offset_t	*next
 ) {
 	ion_err_t error;
 
+	/* the bytes from the start of an item come with its link in one read */
+	if (0 == skip) {
+		return lfb_get(bag, offset, num_bytes, write_to, next);
+	}
+
 	error = ion_fread_at(bag->file_handle, offset, sizeof(ion_file_offset_t), (ion_byte_t *) next);
 
-	if (err_ok != error) {
+	if ((err_ok != error) || (0 == num_bytes)) {
 		return error;
 	}
 
-	error = ion_fread_at(bag->file_handle, offset + sizeof(ion_file_offset_t), num_bytes, write_to);
-
-	return error;
+	return ion_fread_at(bag->file_handle, offset + sizeof(ion_file_offset_t) + skip, num_bytes, write_to);
 }
 
 /**
@@ -217,3 +240,43 @@ lfb_update_all(
 
 	return err_ok;
 }
+
+ion_err_t
+lfb_copy(
+	ion_lfb_t			*bag,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*buffer,
+	ion_lfb_t			*to,
+	ion_file_offset_t	*end
+) {
+	ion_err_t			error;
+	ion_file_offset_t	next;
+	ion_file_offset_t	link;
+	ion_file_vector_t	record[2];
+
+	record[0].bytes		= (ion_byte_t *) &link;
+	record[0].num_bytes = sizeof(ion_file_offset_t);
+	record[1].bytes		= buffer;
+	record[1].num_bytes = num_bytes;
+
+	while (ION_LFB_NULL != offset) {
+		error = lfb_get(bag, offset, num_bytes, buffer, &next);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		link	= (ION_LFB_NULL == next) ? ION_LFB_NULL : (ion_file_offset_t) (*end + sizeof(ion_file_offset_t) + num_bytes);
+		error	= ion_fwritev_at(to->file_handle, *end, record, 2);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		*end	+= sizeof(ion_file_offset_t) + num_bytes;
+		offset	= next;
+	}
+
+	return err_ok;
+}
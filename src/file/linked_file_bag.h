@@ -104,6 +104,35 @@ lfb_get(
 	ion_file_offset_t	*next
 );
 
+/**
+@brief		Reads some bytes of an item of the linked file bag, the others
+			not read.
+@param		bag
+				A pointer to the linked file bag handler object to read
+				from.
+@param		offset
+				Where the item is within the file bag.
+@param		skip
+				The bytes of the item passed over before those read.
+@param		num_bytes
+				The number of bytes to read into @p write_to.
+@param		write_to
+				Where they go.
+@param		next
+				Set to where the next item in this bag is located, as by
+				@ref lfb_get.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+lfb_get_part(
+	ion_lfb_t			*bag,
+	ion_file_offset_t	offset,
+	unsigned int		skip,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to,
+	ion_file_offset_t	*next
+);
+
 /**
 @brief		Attempt to delete a record stored at a given offset.
 @param		bag
@@ -202,6 +231,38 @@ lfb_update_all(
 	ion_result_count_t	*count
 );
 
+/**
+@brief		Copy all records kept within a specific bag to consecutive
+			records at the end of another bag, in the order they are
+			linked.
+@details	Each record copied is linked to the one written after it, so
+			the copy is read front to back. All records linked should be
+			the same size (@p num_bytes).
+@param		bag
+				A pointer to the linked file bag handler to copy from.
+@param		offset
+				The offset of the first record to copy.
+@param		num_bytes
+				The number of bytes of each record.
+@param		buffer
+				Room for one record's data.
+@param		to
+				A pointer to the linked file bag handler to copy to.
+@param		end
+				Where in @p to the first record is written, moved past the
+				last. The copy starts there, whatever @p to holds.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+lfb_copy(
+	ion_lfb_t			*bag,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*buffer,
+	ion_lfb_t			*to,
+	ion_file_offset_t	*end
+);
+
 #if defined(__cplusplus)
 }
 #endif
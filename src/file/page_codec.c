@@ -0,0 +1,355 @@
+/******************************************************************************/
+/**
+@file
+@brief		Compression of on-disk pages.
+@details	A compressed page is a run of sequences, each a token byte, the
+			literals it counts and then a back reference. The high nibble
+			of the token is the number of literals and the low nibble the
+			length of the match less @ref PAGE_CODEC_MIN_MATCH; either at
+			15 continues in the bytes that follow, 255 at a time. The
+			reference is the two byte distance back to the match. The last
+			sequence stops after its literals.
+*/
+/******************************************************************************/
+
+#include "page_codec.h"
+
+/**
+@brief		The shortest match worth a reference.
+*/
+#define PAGE_CODEC_MIN_MATCH 4
+
+/**
+@brief		Slot of the match table for the four bytes at @p p.
+*/
+static unsigned int
+page_codec_hash(
+	const ion_byte_t *p
+) {
+	uint32_t word;
+
+	memcpy(&word, p, sizeof(word));
+	return (unsigned int) ((word * 2654435761UL) & 0xFFFFFFFFUL) >> (32 - PAGE_CODEC_HASH_BITS);
+}
+
+/**
+@brief		Writes a length that did not fit its nibble.
+@return		The new end of the output, or NULL if it is full.
+*/
+static ion_byte_t *
+page_codec_put_length(
+	ion_byte_t	*op,
+	ion_byte_t	*end,
+	int			length
+) {
+	for (; length >= 255; length -= 255) {
+		if (op >= end) {
+			return NULL;
+		}
+
+		*op++ = 255;
+	}
+
+	if (op >= end) {
+		return NULL;
+	}
+
+	*op++ = (ion_byte_t) length;
+	return op;
+}
+
+/**
+@brief		Reads the rest of a length whose nibble was 15.
+@return		The length, or -1 if the input ends first.
+*/
+static int
+page_codec_get_length(
+	const ion_byte_t	**ip,
+	const ion_byte_t	*end,
+	int					length
+) {
+	ion_byte_t byte;
+
+	do {
+		if (*ip >= end) {
+			return -1;
+		}
+
+		byte	= *(*ip)++;
+		length	+= byte;
+	} while (255 == byte);
+
+	return length;
+}
+
+/**
+@brief		Writes one sequence; a @p match of 0 ends the page.
+@return		The new end of the output, or NULL if it is full.
+*/
+static ion_byte_t *
+page_codec_put_sequence(
+	ion_byte_t			*op,
+	ion_byte_t			*end,
+	const ion_byte_t	*literals,
+	int					num_literals,
+	int					offset,
+	int					match
+) {
+	ion_byte_t	*token;
+	int			extra = (0 == match) ? 0 : match - PAGE_CODEC_MIN_MATCH;
+
+	if (op >= end) {
+		return NULL;
+	}
+
+	token	= op++;
+	*token	= (ion_byte_t) ((((num_literals < 15) ? num_literals : 15) << 4) | ((extra < 15) ? extra : 15));
+
+	if ((num_literals >= 15) && (NULL == (op = page_codec_put_length(op, end, num_literals - 15)))) {
+		return NULL;
+	}
+
+	if (end - op < num_literals) {
+		return NULL;
+	}
+
+	memcpy(op, literals, num_literals);
+	op += num_literals;
+
+	if (0 == match) {
+		return op;
+	}
+
+	if (end - op < 2) {
+		return NULL;
+	}
+
+	*op++ = (ion_byte_t) (offset & 0xFF);
+	*op++ = (ion_byte_t) (offset >> 8);
+
+	if ((extra >= 15) && (NULL == (op = page_codec_put_length(op, end, extra - 15)))) {
+		return NULL;
+	}
+
+	return op;
+}
+
+int
+page_codec_compress(
+	const ion_byte_t	*in,
+	int					in_len,
+	ion_byte_t			*out,
+	int					out_cap
+) {
+	uint16_t	table[1 << PAGE_CODEC_HASH_BITS];
+	ion_byte_t	*op		= out;
+	ion_byte_t	*end	= out + out_cap;
+	int			anchor	= 0;
+	int			ip		= 0;
+	int			ref;
+	int			match;
+	unsigned	slot;
+
+	if ((in_len < 0) || (in_len > PAGE_CODEC_MAX_PAGE)) {
+		return -1;
+	}
+
+	memset(table, 0, sizeof(table));
+
+	while (ip + PAGE_CODEC_MIN_MATCH <= in_len) {
+		slot		= page_codec_hash(in + ip);
+		ref			= table[slot];
+		table[slot] = (uint16_t) ip;
+
+		/* the table starts out pointing at 0, the compare weeds that out */
+		if ((ref >= ip) || (0 != memcmp(in + ref, in + ip, PAGE_CODEC_MIN_MATCH))) {
+			ip++;
+			continue;
+		}
+
+		match = PAGE_CODEC_MIN_MATCH;
+
+		while ((ip + match < in_len) && (in[ref + match] == in[ip + match])) {
+			match++;
+		}
+
+		if (NULL == (op = page_codec_put_sequence(op, end, in + anchor, ip - anchor, ip - ref, match))) {
+			return -1;
+		}
+
+		ip		+= match;
+		anchor	= ip;
+	}
+
+	if (NULL == (op = page_codec_put_sequence(op, end, in + anchor, in_len - anchor, 0, 0))) {
+		return -1;
+	}
+
+	return (int) (op - out);
+}
+
+int
+page_codec_decompress(
+	const ion_byte_t	*in,
+	int					in_len,
+	ion_byte_t			*out,
+	int					out_cap
+) {
+	const ion_byte_t	*ip		= in;
+	const ion_byte_t	*end	= in + in_len;
+	ion_byte_t			*op		= out;
+	ion_byte_t			*op_end = out + out_cap;
+	ion_byte_t			token;
+	int					length;
+	int					offset;
+
+	while (ip < end) {
+		token	= *ip++;
+		length	= token >> 4;
+
+		if ((15 == length) && (-1 == (length = page_codec_get_length(&ip, end, length)))) {
+			return -1;
+		}
+
+		if ((end - ip < length) || (op_end - op < length)) {
+			return -1;
+		}
+
+		memcpy(op, ip, length);
+		ip	+= length;
+		op	+= length;
+
+		if (ip == end) {
+			break;
+		}
+
+		if (end - ip < 2) {
+			return -1;
+		}
+
+		offset	= ip[0] | (ip[1] << 8);
+		ip		+= 2;
+		length	= token & 0x0F;
+
+		if ((15 == length) && (-1 == (length = page_codec_get_length(&ip, end, length)))) {
+			return -1;
+		}
+
+		length += PAGE_CODEC_MIN_MATCH;
+
+		if ((0 == offset) || (offset > op - out) || (op_end - op < length)) {
+			return -1;
+		}
+
+		/* the match may overlap what it writes, so copy forwards a byte at a time */
+		for (; length > 0; length--, op++) {
+			*op = *(op - offset);
+		}
+	}
+
+	return (int) (op - out);
+}
+
+int
+page_codec_delta_encode(
+	const ion_byte_t	*keys,
+	int					stride,
+	int					count,
+	int					key_size,
+	ion_boolean_t		is_signed,
+	ion_byte_t			*out,
+	int					out_cap
+) {
+	uint64_t	mask		= (sizeof(uint32_t) == key_size) ? 0xFFFFFFFFULL : ~0ULL;
+	uint64_t	previous	= 0;
+	uint64_t	key;
+	uint64_t	delta;
+	int			used		= 0;
+	int			i;
+
+	for (i = 0; i < count; i++, keys += stride) {
+		if (sizeof(uint32_t) == key_size) {
+			uint32_t narrow;
+
+			memcpy(&narrow, keys, sizeof(narrow));
+			key = narrow;
+		}
+		else {
+			memcpy(&key, keys, sizeof(key));
+		}
+
+		delta = (key - previous) & mask;
+
+		/* zigzag the first key so a small negative one stays short */
+		if ((0 == i) && is_signed) {
+			uint64_t sign = (sizeof(uint32_t) == key_size) ? (key >> 31) & 1 : key >> 63;
+
+			delta = ((key << 1) & mask) ^ (0 - sign);
+			delta &= mask;
+		}
+
+		previous = key;
+
+		do {
+			if (used >= out_cap) {
+				return -1;
+			}
+
+			out[used++] = (ion_byte_t) ((delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0));
+			delta		>>= 7;
+		} while (0 != delta);
+	}
+
+	return used;
+}
+
+int
+page_codec_delta_decode(
+	const ion_byte_t	*in,
+	int					in_len,
+	ion_byte_t			*keys,
+	int					stride,
+	int					count,
+	int					key_size,
+	ion_boolean_t		is_signed
+) {
+	uint64_t	mask		= (sizeof(uint32_t) == key_size) ? 0xFFFFFFFFULL : ~0ULL;
+	uint64_t	previous	= 0;
+	uint64_t	delta;
+	int			used		= 0;
+	int			shift;
+	int			i;
+
+	for (i = 0; i < count; i++, keys += stride) {
+		delta = 0;
+
+		for (shift = 0;; shift += 7) {
+			if ((used >= in_len) || (shift > 63)) {
+				return -1;
+			}
+
+			delta |= (uint64_t) (in[used] & 0x7F) << shift;
+
+			if (0 == (in[used++] & 0x80)) {
+				break;
+			}
+		}
+
+		if ((0 == i) && is_signed) {
+			delta = (delta >> 1) ^ (0 - (delta & 1));
+		}
+
+		previous = (previous + delta) & mask;
+
+		if (sizeof(uint32_t) == key_size) {
+			uint32_t narrow = (uint32_t) previous;
+
+			memcpy(keys, &narrow, sizeof(narrow));
+		}
+		else {
+			memcpy(keys, &previous, sizeof(previous));
+		}
+	}
+
+	return used;
+}
@@ -0,0 +1,159 @@
+/******************************************************************************/
+/**
+@file
+@brief		Compression of on-disk pages, so fewer bytes move between the
+			device and the buffers that hold them.
+@details	Two codecs are given, to be combined by the structure that owns
+			the page. Integer keys in key order are stored as the distance
+			from the previous key, a frame of reference that turns long
+			monotonic keys into one or two byte varints. Everything else is
+			compressed with a byte-oriented LZ77 in the manner of LZ4:
+			literal runs and back references to earlier bytes of the page,
+			with no entropy stage, so decoding is a loop of copies that
+			costs little more than the memcpy it replaces. Both decode
+			straight into a caller's buffer.
+*/
+/******************************************************************************/
+
+#if !defined(PAGE_CODEC_H_)
+#define PAGE_CODEC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../key_value/kv_system.h"
+
+/**
+@brief		Log base 2 of the number of entries of the match table of
+			@ref page_codec_compress.
+@details	The table lives on the stack, two bytes an entry. Fewer
+			entries find fewer matches.
+*/
+#if !defined(PAGE_CODEC_HASH_BITS)
+#if defined(ARDUINO)
+#define PAGE_CODEC_HASH_BITS 6
+#else
+#define PAGE_CODEC_HASH_BITS 10
+#endif
+#endif
+
+/**
+@brief		The largest page, in bytes, either codec takes.
+*/
+#define PAGE_CODEC_MAX_PAGE 65535
+
+/**
+@brief		Compresses a page with the LZ77 codec.
+@param		in
+				The bytes to compress.
+@param		in_len
+				How many, at most @ref PAGE_CODEC_MAX_PAGE.
+@param		out
+				Receives the compressed bytes.
+@param		out_cap
+				The room in @p out.
+@return		The length of the compressed page, or -1 if it would not fit
+			in @p out_cap bytes. Incompressible input grows by about one
+			byte in 255.
+*/
+int
+page_codec_compress(
+	const ion_byte_t	*in,
+	int					in_len,
+	ion_byte_t			*out,
+	int					out_cap
+);
+
+/**
+@brief		Restores a page compressed with @ref page_codec_compress.
+@param		in
+				The compressed bytes.
+@param		in_len
+				How many.
+@param		out
+				Receives the page.
+@param		out_cap
+				The room in @p out.
+@return		The length of the page, or -1 if @p in is malformed or the
+			page would not fit in @p out_cap bytes. Input cut between two
+			sequences decodes to a shorter page, so the caller checks the
+			length it expects.
+*/
+int
+page_codec_decompress(
+	const ion_byte_t	*in,
+	int					in_len,
+	ion_byte_t			*out,
+	int					out_cap
+);
+
+/**
+@brief		Encodes integer keys as the distance of each from the one
+			before it.
+@details	The keys are native integers of @p key_size bytes, read
+			@p stride bytes apart. The first is stored relative to 0,
+			zigzagged if @p is_signed so small negative keys stay short.
+			Distances are taken modulo the key width and so always
+			decode, but only keys in ascending order keep them small.
+@param		keys
+				The first key.
+@param		stride
+				Bytes from one key to the next.
+@param		count
+				The number of keys.
+@param		key_size
+				4 or 8.
+@param		is_signed
+				Whether the keys are signed.
+@param		out
+				Receives the varints.
+@param		out_cap
+				The room in @p out.
+@return		The bytes written, or -1 if they would not fit.
+*/
+int
+page_codec_delta_encode(
+	const ion_byte_t	*keys,
+	int					stride,
+	int					count,
+	int					key_size,
+	ion_boolean_t		is_signed,
+	ion_byte_t			*out,
+	int					out_cap
+);
+
+/**
+@brief		Decodes keys encoded with @ref page_codec_delta_encode.
+@param		in
+				The varints.
+@param		in_len
+				How many bytes of them.
+@param		keys
+				Receives the first key, the others @p stride bytes apart.
+@param		stride
+				Bytes from one key to the next.
+@param		count
+				The number of keys.
+@param		key_size
+				4 or 8.
+@param		is_signed
+				Whether the keys are signed.
+@return		The bytes of @p in used, or -1 if it is malformed.
+*/
+int
+page_codec_delta_decode(
+	const ion_byte_t	*in,
+	int					in_len,
+	ion_byte_t			*keys,
+	int					stride,
+	int					count,
+	int					key_size,
+	ion_boolean_t		is_signed
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* PAGE_CODEC_H_ */
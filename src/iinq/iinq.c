@@ -1,6 +1,160 @@
+/* the monotonic clock profiled runs are timed by */
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
+#include <string.h>
+#if !defined(ARDUINO)
+#include <time.h>
+#endif
 #include "iinq.h"
 #include "../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+
+/**
+@brief		A source kept open between statements.
+*/
+typedef struct iinq_cached_source {
+	char						*name;			/**< Its schema file */
+	ion_dictionary_t			dictionary;		/**< The open dictionary */
+	ion_dictionary_handler_t	handler;		/**< Its handler */
+	ion_iinq_engine_t			engine;			/**< The kind of dictionary */
+	int							pins;			/**< Statements using it */
+	unsigned long				used;			/**< When it was last released */
+	struct iinq_cached_source	*next;			/**< The next source open */
+} ion_iinq_cached_source_t;
+
+/**
+@brief		The sources kept open, most recently opened first.
+*/
+static ion_iinq_cached_source_t	*iinq_sources		= NULL;
+
+/**
+@brief		Ticks on every release, to find the least recently used source.
+*/
+static unsigned long			iinq_source_clock	= 0;
+
+/**
+@brief		Numbers the files sorted runs are spilled to.
+*/
+static int						iinq_sort_next_run	= 0;
+
+/**
+@brief		Loads the handler of a kind of dictionary.
+@returns	The dictionary size it is created with.
+*/
+static ion_dictionary_size_t
+iinq_engine_init(
+	ion_iinq_engine_t			engine,
+	ion_dictionary_handler_t	*handler
+) {
+	switch (engine) {
+		case iinq_engine_file_hash:
+			oafdict_init(handler);
+			return IINQ_FILE_HASH_SIZE;
+
+		case iinq_engine_sorted_flat_file:
+			ffdict_init(handler);
+			return -1;
+
+		default:
+			bpptree_init(handler);
+			return -1;
+	}
+}
+
+/**
+@brief		Readies a dictionary just created or opened to be used as its
+			kind is.
+*/
+static void
+iinq_engine_ready(
+	ion_iinq_engine_t	engine,
+	ion_dictionary_t	*dictionary
+) {
+	/* sorted mode is not kept by the flat file itself */
+	if (iinq_engine_sorted_flat_file == engine) {
+		((ion_flat_file_t *) dictionary->instance)->sorted_mode = boolean_true;
+	}
+}
+
+/**
+@brief		Opens the dictionary named by a schema file, the master table
+			being open.
+@param		engine
+				Set to the kind of dictionary it is kept in, if not NULL.
+*/
+static ion_err_t
+iinq_open_schema(
+	char						*schema_file_name,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler,
+	ion_iinq_engine_t			*engine
+) {
+	ion_err_t			error;
+	FILE				*schema_file;
+	ion_dictionary_id_t	id;
+	ion_byte_t			kind;
+
+	if (NULL == (schema_file = fopen(schema_file_name, "rb"))) {
+		return err_file_open_error;
+	}
+
+	if (1 != fread(&id, sizeof(id), 1, schema_file)) {
+		fclose(schema_file);
+		return err_file_incomplete_read;
+	}
+
+	/* a schema from before the kind was written is of a B+ tree */
+	if (1 != fread(&kind, sizeof(kind), 1, schema_file)) {
+		kind = iinq_engine_bpp_tree;
+	}
+
+	if (0 != fclose(schema_file)) {
+		return err_file_close_error;
+	}
+
+	/* Load the handler. */
+	iinq_engine_init((ion_iinq_engine_t) kind, handler);
+
+	error = ion_open_dictionary(handler, dictionary, id);
+
+	if (err_ok == error) {
+		iinq_engine_ready((ion_iinq_engine_t) kind, dictionary);
+	}
+
+	if (NULL != engine) {
+		*engine = (ion_iinq_engine_t) kind;
+	}
+
+	return error;
+}
+
+/**
+@brief		Closes a source kept open and forgets it.
+*/
+static ion_err_t
+iinq_forget_source(
+	ion_iinq_cached_source_t *source
+) {
+	ion_iinq_cached_source_t	**link;
+	ion_err_t					error = err_ok;
+
+	for (link = &iinq_sources; *link != source; link = &(*link)->next) {}
+
+	*link = source->next;
+
+	if (NULL != source->dictionary.instance) {
+		error = ion_close_dictionary(&source->dictionary);
+	}
+
+	free(source->name);
+	free(source);
+
+	return error;
+}
 
 ion_err_t
 iinq_create_source(
@@ -8,11 +162,24 @@ iinq_create_source(
 	ion_key_type_t				key_type,
 	ion_key_size_t			key_size,
 	ion_value_size_t		value_size
+) {
+	return iinq_create_source_on(schema_file_name, iinq_engine_bpp_tree, key_type, key_size, value_size);
+}
+
+ion_err_t
+iinq_create_source_on(
+	char				*schema_file_name,
+	ion_iinq_engine_t	engine,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size
 ) {
 	ion_err_t					error;
-	FILE					*schema_file;
+	FILE						*schema_file;
 	ion_dictionary_t			dictionary;
 	ion_dictionary_handler_t	handler;
+	ion_dictionary_size_t		dictionary_size;
+	ion_byte_t					kind = (ion_byte_t) engine;
 
 	dictionary.handler		= &handler;
 
@@ -23,7 +190,7 @@ iinq_create_source(
 	}
 
 	/* Load the handler. */
-	bpptree_init(&handler);
+	dictionary_size = iinq_engine_init(engine, &handler);
 
 	/* If the file exists, fail. */
 	if (NULL != (schema_file = fopen(schema_file_name, "rb"))) {
@@ -38,13 +205,13 @@ iinq_create_source(
 			return err_file_bad_seek;
 		}
 
-		error = ion_master_table_create_dictionary(&handler, &dictionary, key_type, key_size, value_size, -1);
+		error = ion_master_table_create_dictionary(&handler, &dictionary, key_type, key_size, value_size, dictionary_size);
 
 		if (err_ok != error) {
 			return error;
 		}
 
-		if (1 != fwrite(&dictionary.instance->id, sizeof(dictionary.instance->id), 1, schema_file)) {
+		if ((1 != fwrite(&dictionary.instance->id, sizeof(dictionary.instance->id), 1, schema_file)) || (1 != fwrite(&kind, sizeof(kind), 1, schema_file))) {
 			return err_file_incomplete_read;
 		}
 
@@ -60,7 +227,10 @@ iinq_create_source(
 		error = err_file_open_error;
 	}
 
-	ion_close_master_table();
+	/* sources kept open keep the master table open too */
+	if (NULL == iinq_sources) {
+		ion_close_master_table();
+	}
 
 	return error;
 }
@@ -72,8 +242,6 @@ iinq_open_source(
 	ion_dictionary_handler_t	*handler
 ) {
 	ion_err_t				error;
-	FILE				*schema_file;
-	ion_dictionary_id_t id;
 
 	error = ion_init_master_table();
 
@@ -81,36 +249,178 @@ iinq_open_source(
 		return error;
 	}
 
-	/* Load the handler. */
-	bpptree_init(handler);
+	error = iinq_open_schema(schema_file_name, dictionary, handler, NULL);
 
-	/* If the schema file already exists. */
-	if (NULL != (schema_file = fopen(schema_file_name, "rb"))) {
-		if (0 != fseek(schema_file, 0, SEEK_SET)) {
-			return err_file_bad_seek;
+	/* sources kept open keep the master table open too */
+	if (NULL == iinq_sources) {
+		ion_close_master_table();
+	}
+
+	return error;
+}
+
+ion_err_t
+iinq_acquire_source(
+	char				*schema_file_name,
+	ion_dictionary_t	**dictionary
+) {
+	ion_iinq_cached_source_t	*source;
+	ion_err_t					error;
+
+	for (source = iinq_sources; NULL != source; source = source->next) {
+		if (0 == strcmp(source->name, schema_file_name)) {
+			source->pins++;
+			*dictionary = &source->dictionary;
+			return err_ok;
 		}
+	}
 
-		if (1 != fread(&id, sizeof(id), 1, schema_file)) {
-			return err_file_incomplete_read;
+	/* the master table stays open for the next source opened */
+	error = ion_init_master_table();
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	source = malloc(sizeof(ion_iinq_cached_source_t));
+
+	if (NULL == source) {
+		return err_out_of_memory;
+	}
+
+	source->name = malloc(strlen(schema_file_name) + 1);
+
+	if (NULL == source->name) {
+		free(source);
+		return err_out_of_memory;
+	}
+
+	strcpy(source->name, schema_file_name);
+	source->dictionary.handler	= &source->handler;
+	source->pins				= 1;
+	source->used				= 0;
+
+	error						= iinq_open_schema(schema_file_name, &source->dictionary, &source->handler, &source->engine);
+
+	if (err_ok != error) {
+		free(source->name);
+		free(source);
+		return error;
+	}
+
+	source->next	= iinq_sources;
+	iinq_sources	= source;
+	*dictionary		= &source->dictionary;
+
+	return err_ok;
+}
+
+/**
+@brief		The source kept open as a dictionary, or NULL if it is not.
+*/
+static ion_iinq_cached_source_t *
+iinq_find_cached(
+	ion_dictionary_t *dictionary
+) {
+	ion_iinq_cached_source_t *source;
+
+	for (source = iinq_sources; NULL != source; source = source->next) {
+		if (source->dictionary.instance == dictionary->instance) {
+			return source;
 		}
+	}
 
-		error = ion_open_dictionary(handler, dictionary, id);
+	return NULL;
+}
 
-		if (err_ok != error) {
-			return error;
+ion_boolean_t
+iinq_source_is_ordered(
+	ion_dictionary_t *dictionary
+) {
+	ion_iinq_cached_source_t *source = iinq_find_cached(dictionary);
+
+	return (NULL != source) && (iinq_engine_file_hash != source->engine);
+}
+
+ion_err_t
+iinq_release_source(
+	ion_dictionary_t *dictionary
+) {
+	ion_iinq_cached_source_t	*source;
+	ion_iinq_cached_source_t	*oldest = NULL;
+	int							idle	= 0;
+
+	for (source = iinq_sources; NULL != source; source = source->next) {
+		if (source->dictionary.instance == dictionary->instance) {
+			source->pins--;
+			source->used = ++iinq_source_clock;
 		}
+	}
 
-		if (0 != fclose(schema_file)) {
-			return err_file_close_error;
+	for (source = iinq_sources; NULL != source; source = source->next) {
+		if (0 == source->pins) {
+			idle++;
+
+			if ((NULL == oldest) || (source->used < oldest->used)) {
+				oldest = source;
+			}
 		}
+	}
 
-		error = err_ok;
+	if (idle > IINQ_SOURCE_CACHE_SIZE) {
+		return iinq_forget_source(oldest);
 	}
-	else {
-		error = err_file_open_error;
+
+	return err_ok;
+}
+
+ion_err_t
+iinq_close_source(
+	char *schema_file_name
+) {
+	ion_iinq_cached_source_t *source;
+
+	for (source = iinq_sources; NULL != source; source = source->next) {
+		if (0 == strcmp(source->name, schema_file_name)) {
+			if (0 != source->pins) {
+				return err_illegal_state;
+			}
+
+			return iinq_forget_source(source);
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+iinq_close_all_sources(
+	void
+) {
+	ion_iinq_cached_source_t	*source;
+	ion_iinq_cached_source_t	*next;
+	ion_err_t					error = err_ok;
+	ion_err_t					closed;
+
+	for (source = iinq_sources; NULL != source; source = next) {
+		next = source->next;
+
+		if (0 != source->pins) {
+			error = err_illegal_state;
+			continue;
+		}
+
+		closed = iinq_forget_source(source);
+
+		if (err_ok == error) {
+			error = closed;
+		}
 	}
 
-	ion_close_master_table();
+	/* the master table is only closed once nothing uses it */
+	if ((NULL == iinq_sources) && (err_ok != (closed = ion_close_master_table())) && (err_ok == error)) {
+		error = closed;
+	}
 
 	return error;
 }
@@ -121,26 +431,21 @@ iinq_insert(
 	ion_key_t	key,
 	ion_value_t value
 ) {
-	ion_err_t					error;
-	ion_status_t			status		= ION_STATUS_INITIALIZE;
-	ion_dictionary_t			dictionary;
-	ion_dictionary_handler_t	handler;
+	ion_err_t			error;
+	ion_status_t		status		= ION_STATUS_INITIALIZE;
+	ion_dictionary_t	*dictionary;
 
-	dictionary.handler		= &handler;
-
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
+	error					= iinq_acquire_source(schema_file_name, &dictionary);
 	if (err_ok != error) {
-		status				= ION_STATUS_ERROR(error);
-		goto RETURN;
+		return ION_STATUS_ERROR(error);
 	}
 
-	status					= dictionary_insert(&dictionary, key, value);
-	error					= ion_close_dictionary(&dictionary);
+	status					= dictionary_insert(dictionary, key, value);
+	error					= iinq_release_source(dictionary);
 	if (err_ok == status.error && err_ok != error) {
 		status.error		= error;
 	}
 
-	RETURN:
 	return status;
 }
 
@@ -150,26 +455,21 @@ iinq_update(
 	ion_key_t	key,
 	ion_value_t value
 ) {
-	ion_err_t					error;
-	ion_status_t			status		= ION_STATUS_INITIALIZE;
-	ion_dictionary_t			dictionary;
-	ion_dictionary_handler_t	handler;
-
-	dictionary.handler		= &handler;
+	ion_err_t			error;
+	ion_status_t		status		= ION_STATUS_INITIALIZE;
+	ion_dictionary_t	*dictionary;
 
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
+	error					= iinq_acquire_source(schema_file_name, &dictionary);
 	if (err_ok != error) {
-		status				= ION_STATUS_ERROR(error);
-		goto RETURN;
+		return ION_STATUS_ERROR(error);
 	}
 
-	status					= dictionary_update(&dictionary, key, value);
-	error					= ion_close_dictionary(&dictionary);
+	status					= dictionary_update(dictionary, key, value);
+	error					= iinq_release_source(dictionary);
 	if (err_ok == status.error && err_ok != error) {
 		status.error		= error;
 	}
 
-	RETURN:
 	return status;
 }
 
@@ -178,26 +478,21 @@ iinq_delete(
 	char 		*schema_file_name,
 	ion_key_t	key
 ) {
-	ion_err_t					error;
-	ion_status_t			status		= ION_STATUS_INITIALIZE;
-	ion_dictionary_t			dictionary;
-	ion_dictionary_handler_t	handler;
-
-	dictionary.handler		= &handler;
+	ion_err_t			error;
+	ion_status_t		status		= ION_STATUS_INITIALIZE;
+	ion_dictionary_t	*dictionary;
 
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
+	error					= iinq_acquire_source(schema_file_name, &dictionary);
 	if (err_ok != error) {
-		status				= ION_STATUS_ERROR(error);
-		goto RETURN;
+		return ION_STATUS_ERROR(error);
 	}
 
-	status					= dictionary_delete(&dictionary, key);
-	error					= ion_close_dictionary(&dictionary);
+	status					= dictionary_delete(dictionary, key);
+	error					= iinq_release_source(dictionary);
 	if (err_ok == status.error && err_ok != error) {
 		status.error		= error;
 	}
 
-	RETURN:
 	return status;
 }
 
@@ -209,16 +504,2144 @@ iinq_drop(
 	ion_dictionary_t			dictionary;
 	ion_dictionary_handler_t	handler;
 
+	/* a source kept open is closed first, so its files can go */
+	error					= iinq_close_source(schema_file_name);
+	if (err_ok != error) {
+		return error;
+	}
+
 	dictionary.handler		= &handler;
 
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
+	error					= ion_init_master_table();
 	if (err_ok != error) {
 		return error;
 	}
 
-	error					= dictionary_delete_dictionary(&dictionary);
+	error					= iinq_open_schema(schema_file_name, &dictionary, &handler, NULL);
+
+	/* its ID is freed with its files, for the next source made */
+	if (err_ok == error) {
+		error				= ion_master_table_delete_dictionary(&dictionary);
+		fremove(schema_file_name);
+	}
+
+	if (NULL == iinq_sources) {
+		ion_close_master_table();
+	}
+
+	return error;
+}
+
+/**
+@brief		Compares two results by the order of a sort.
+*/
+static int
+iinq_sort_compare(
+	ion_iinq_sort_t *sort,
+	unsigned char	*first,
+	unsigned char	*second
+) {
+	ion_iinq_order_t	*order;
+	int					comparison;
+	int					i;
+
+	for (i = 0; i < sort->order_count; i++) {
+		order		= &sort->order[i];
+		comparison	= sort->compare[i](first + order->offset, second + order->offset, order->size);
+
+		if (0 != comparison) {
+			return order->descending ? -comparison : comparison;
+		}
+	}
+
+	return 0;
+}
+
+/**
+@brief		The result a sort holds at an index, @c capacity being the
+			room for one more.
+*/
+static unsigned char *
+iinq_sort_row(
+	ion_iinq_sort_t *sort,
+	int				index
+) {
+	return sort->rows + (size_t) index * sort->num_bytes;
+}
+
+/**
+@brief		Swaps two results a sort holds, by way of the room for one more.
+*/
+static void
+iinq_sort_swap(
+	ion_iinq_sort_t *sort,
+	int				first,
+	int				second
+) {
+	unsigned char *spare = iinq_sort_row(sort, sort->capacity);
+
+	memcpy(spare, iinq_sort_row(sort, first), sort->num_bytes);
+	memcpy(iinq_sort_row(sort, first), iinq_sort_row(sort, second), sort->num_bytes);
+	memcpy(iinq_sort_row(sort, second), spare, sort->num_bytes);
+}
+
+/**
+@brief		Moves a result down a heap of the first @p count results held
+			until none under it comes after it.
+*/
+static void
+iinq_sort_sift(
+	ion_iinq_sort_t *sort,
+	int				count,
+	int				at
+) {
+	int child;
+
+	for (child = 2 * at + 1; child < count; child = 2 * at + 1) {
+		if ((child + 1 < count) && (iinq_sort_compare(sort, iinq_sort_row(sort, child + 1), iinq_sort_row(sort, child)) > 0)) {
+			child++;
+		}
+
+		if (iinq_sort_compare(sort, iinq_sort_row(sort, child), iinq_sort_row(sort, at)) <= 0) {
+			break;
+		}
+
+		iinq_sort_swap(sort, at, child);
+		at = child;
+	}
+}
+
+/**
+@brief		Makes a heap of the results held, the last in order first.
+*/
+static void
+iinq_sort_heapify(
+	ion_iinq_sort_t *sort
+) {
+	int i;
+
+	for (i = sort->count / 2 - 1; i >= 0; i--) {
+		iinq_sort_sift(sort, sort->count, i);
+	}
+}
+
+/**
+@brief		Puts the results held in order, by heap sort, as no more memory
+			is needed for it.
+*/
+static void
+iinq_sort_rows(
+	ion_iinq_sort_t *sort
+) {
+	int i;
+
+	iinq_sort_heapify(sort);
+
+	for (i = sort->count - 1; i > 0; i--) {
+		iinq_sort_swap(sort, 0, i);
+		iinq_sort_sift(sort, i, 0);
+	}
+}
+
+/**
+@brief		Passes a result on, unless the limit has been.
+@returns	Whether more results are wanted.
+*/
+static ion_boolean_t
+iinq_sort_pass(
+	ion_iinq_sort_t *sort,
+	unsigned char	*row
+) {
+	ion_iinq_result_t result;
+
+	if ((-1 != sort->limit) && (sort->passed >= sort->limit)) {
+		return boolean_false;
+	}
+
+	result.num_bytes	= sort->num_bytes;
+	result.data			= row;
+	sort->processor->execute(&result, sort->processor->state);
+	sort->passed++;
+
+	return (-1 == sort->limit) || (sort->passed < sort->limit);
+}
+
+/**
+@brief		Sorts the results held and writes them to a new file, as a run
+			to be merged.
+*/
+static ion_err_t
+iinq_sort_spill(
+	ion_iinq_sort_t *sort
+) {
+	ion_iinq_sort_run_t *run;
+	void				*grown;
+	char				name[ION_MAX_FILENAME_LENGTH];
+	ion_err_t			error;
+
+	grown = realloc(sort->runs, (sort->run_count + 1) * sizeof(ion_iinq_sort_run_t));
+
+	if (NULL == grown) {
+		return err_out_of_memory;
+	}
+
+	sort->runs			= grown;
+	run					= &sort->runs[sort->run_count];
+	run->id				= iinq_sort_next_run;
+	iinq_sort_next_run	= (iinq_sort_next_run + 1) % 10000000;
+	run->rows			= sort->count;
+	run->at				= 0;
+	snprintf(name, ION_MAX_FILENAME_LENGTH, "%d.srt", run->id);
+	run->file			= ion_fopen(name);
+
+	if (ION_NOFILE == run->file) {
+		return err_file_open_error;
+	}
+
+	sort->run_count++;
+	iinq_sort_rows(sort);
+
+	error = ion_ftruncate(run->file, 0);
+
+	if (err_ok == error) {
+		error = ion_fwrite_at(run->file, 0, (unsigned int) ((size_t) sort->count * sort->num_bytes), sort->rows);
+	}
+
+	sort->count = 0;
+
+	return error;
+}
+
+/**
+@brief		Merges the runs of a sort, passing on the least of the results
+			at their heads until none are left or the limit is passed on.
+*/
+static ion_err_t
+iinq_sort_merge(
+	ion_iinq_sort_t *sort
+) {
+	ion_iinq_sort_run_t *run;
+	unsigned char		*heads;
+	ion_err_t			error = err_ok;
+	int					least;
+	int					i;
+
+	heads = malloc((size_t) sort->run_count * sort->num_bytes);
+
+	if (NULL == heads) {
+		return err_out_of_memory;
+	}
+
+	for (i = 0; (err_ok == error) && (i < sort->run_count); i++) {
+		error = ion_fread_at(sort->runs[i].file, 0, sort->num_bytes, heads + (size_t) i * sort->num_bytes);
+	}
+
+	while (err_ok == error) {
+		least = -1;
+
+		for (i = 0; i < sort->run_count; i++) {
+			if ((0 != sort->runs[i].rows) && ((-1 == least) || (iinq_sort_compare(sort, heads + (size_t) i * sort->num_bytes, heads + (size_t) least * sort->num_bytes) < 0))) {
+				least = i;
+			}
+		}
+
+		if ((-1 == least) || !iinq_sort_pass(sort, heads + (size_t) least * sort->num_bytes)) {
+			break;
+		}
+
+		run		= &sort->runs[least];
+		run->rows--;
+		run->at += sort->num_bytes;
+
+		if (0 != run->rows) {
+			error = ion_fread_at(run->file, run->at, sort->num_bytes, heads + (size_t) least * sort->num_bytes);
+		}
+	}
+
+	free(heads);
+
+	return error;
+}
+
+void
+iinq_sort_begin(
+	ion_iinq_sort_t				*sort,
+	ion_iinq_order_t			*order,
+	int							count,
+	long						limit,
+	ion_iinq_query_processor_t	*processor
+) {
+	int i;
+
+	sort->order			= order;
+	sort->order_count	= (count > IINQ_MAX_ORDERS) ? IINQ_MAX_ORDERS : count;
+	sort->limit			= limit;
+	sort->passed		= 0;
+	sort->processor		= processor;
+	sort->error			= err_ok;
+	sort->num_bytes		= 0;
+	sort->rows			= NULL;
+	sort->count			= 0;
+	sort->capacity		= 0;
+	sort->top			= boolean_false;
+	sort->runs			= NULL;
+	sort->run_count		= 0;
+
+	for (i = 0; i < sort->order_count; i++) {
+		sort->compare[i] = dictionary_switch_compare(order[i].type, order[i].size);
+	}
+}
+
+ion_boolean_t
+iinq_sort_add(
+	ion_iinq_sort_t		*sort,
+	ion_iinq_result_t	*result
+) {
+	int i;
+
+	if (err_ok != sort->error) {
+		return boolean_false;
+	}
+
+	if (0 == sort->order_count) {
+		sort->num_bytes = result->num_bytes;
+		return iinq_sort_pass(sort, result->data);
+	}
+
+	if (NULL == sort->rows) {
+		sort->num_bytes = result->num_bytes;
+
+		for (i = 0; i < sort->order_count; i++) {
+			if (sort->order[i].offset + sort->order[i].size > sort->num_bytes) {
+				sort->error = err_invalid_predicate;
+				return boolean_false;
+			}
+		}
+
+		/* a limit fitting in memory keeps only that many, the least so far */
+		sort->top		= (-1 != sort->limit) && ((size_t) sort->limit * sort->num_bytes <= IINQ_SORT_BYTES);
+		sort->capacity	= sort->top ? (int) sort->limit : (int) (IINQ_SORT_BYTES / sort->num_bytes);
+		sort->capacity	= (sort->capacity < 1) ? 1 : sort->capacity;
+		sort->rows		= malloc((size_t) (sort->capacity + 1) * sort->num_bytes);
+
+		if (NULL == sort->rows) {
+			sort->error = err_out_of_memory;
+			return boolean_false;
+		}
+	}
+
+	if (sort->count < sort->capacity) {
+		memcpy(iinq_sort_row(sort, sort->count), result->data, sort->num_bytes);
+		sort->count++;
+
+		if (sort->top && (sort->count == sort->capacity)) {
+			iinq_sort_heapify(sort);
+		}
+
+		return boolean_true;
+	}
+
+	if (sort->top) {
+		/* the last of the least so far gives way to one before it */
+		if (iinq_sort_compare(sort, result->data, iinq_sort_row(sort, 0)) < 0) {
+			memcpy(iinq_sort_row(sort, 0), result->data, sort->num_bytes);
+			iinq_sort_sift(sort, sort->count, 0);
+		}
+
+		return boolean_true;
+	}
+
+	if (err_ok != (sort->error = iinq_sort_spill(sort))) {
+		return boolean_false;
+	}
+
+	memcpy(iinq_sort_row(sort, 0), result->data, sort->num_bytes);
+	sort->count = 1;
+
+	return boolean_true;
+}
+
+ion_err_t
+iinq_sort_end(
+	ion_iinq_sort_t *sort,
+	ion_err_t		error
+) {
+	char	name[ION_MAX_FILENAME_LENGTH];
+	int		i;
+
+	if (err_ok == error) {
+		error = sort->error;
+	}
+
+	if ((err_ok == error) && (0 != sort->run_count) && (0 != sort->count)) {
+		error = iinq_sort_spill(sort);
+	}
+
+	if ((err_ok == error) && (0 != sort->run_count)) {
+		error = iinq_sort_merge(sort);
+	}
+	else if (err_ok == error) {
+		iinq_sort_rows(sort);
+
+		for (i = 0; (i < sort->count) && iinq_sort_pass(sort, iinq_sort_row(sort, i)); i++) {}
+	}
+
+	for (i = 0; i < sort->run_count; i++) {
+		ion_fclose(sort->runs[i].file);
+		snprintf(name, ION_MAX_FILENAME_LENGTH, "%d.srt", sort->runs[i].id);
+		ion_fremove(name);
+	}
+
+	free(sort->rows);
+	free(sort->runs);
+	sort->rows		= NULL;
+	sort->runs		= NULL;
+	sort->count		= 0;
+	sort->run_count = 0;
+
+	return error;
+}
+
+/**
+@brief		The bytes held for each group ahead of its grouped result, the
+			index of the next group in its bucket and the results taken.
+*/
+#define IINQ_GROUP_HEADER	(2 * sizeof(int64_t))
+
+/**
+@brief		A group held.
+*/
+static unsigned char *
+iinq_group_at(
+	ion_iinq_group_t	*group,
+	int					index
+) {
+	return group->groups + (size_t) index * group->stride;
+}
+
+/**
+@brief		The bytes a group held is of.
+*/
+static unsigned char *
+iinq_group_bytes(
+	ion_iinq_group_t	*group,
+	unsigned char		*at
+) {
+	return at + IINQ_GROUP_HEADER + group->aggregate_count * sizeof(int64_t);
+}
+
+/**
+@brief		Reads the integer of a result an aggregate is of.
+*/
+static int64_t
+iinq_aggregate_read(
+	ion_iinq_aggregate_t	*aggregate,
+	unsigned char			*row
+) {
+	uint64_t	value = 0;
+	int64_t		read;
+
+	/* as many bytes as it has, in the order of this machine, widened by its sign */
+	switch (aggregate->size) {
+		case 1:
+			value = (key_type_numeric_signed == aggregate->sign) ? (uint64_t) (int64_t) (int8_t) row[aggregate->offset] : row[aggregate->offset];
+			break;
+
+		case 2: {
+			uint16_t half;
+
+			memcpy(&half, row + aggregate->offset, sizeof(half));
+			value = (key_type_numeric_signed == aggregate->sign) ? (uint64_t) (int64_t) (int16_t) half : half;
+			break;
+		}
+
+		case 4: {
+			uint32_t word;
+
+			memcpy(&word, row + aggregate->offset, sizeof(word));
+			value = (key_type_numeric_signed == aggregate->sign) ? (uint64_t) (int64_t) (int32_t) word : word;
+			break;
+		}
+
+		default:
+			memcpy(&value, row + aggregate->offset, sizeof(value));
+			break;
+	}
+
+	memcpy(&read, &value, sizeof(read));
+
+	return read;
+}
+
+/**
+@brief		Whether an integer an aggregate is of comes before another.
+*/
+static ion_boolean_t
+iinq_aggregate_less(
+	ion_iinq_aggregate_t	*aggregate,
+	int64_t					first,
+	int64_t					second
+) {
+	if (key_type_numeric_signed == aggregate->sign) {
+		return first < second;
+	}
+
+	return (uint64_t) first < (uint64_t) second;
+}
+
+/**
+@brief		Starts a group of the bytes of a result, its aggregates those
+			of that one result.
+*/
+static void
+iinq_group_start(
+	ion_iinq_group_t	*group,
+	unsigned char		*at,
+	unsigned char		*row
+) {
+	int64_t value;
+	int64_t one = 1;
+	int		i;
+
+	memcpy(at + sizeof(int64_t), &one, sizeof(one));
+	memcpy(iinq_group_bytes(group, at), row + group->offset, group->size);
+
+	for (i = 0; i < group->aggregate_count; i++) {
+		value = (aggregate_count == group->aggregates[i].type) ? 1 : iinq_aggregate_read(&group->aggregates[i], row);
+		memcpy(at + IINQ_GROUP_HEADER + i * sizeof(int64_t), &value, sizeof(value));
+	}
+}
+
+/**
+@brief		Takes a result into the aggregates of a group of its bytes.
+*/
+static void
+iinq_group_fold(
+	ion_iinq_group_t	*group,
+	unsigned char		*at,
+	unsigned char		*row
+) {
+	ion_iinq_aggregate_t	*aggregate;
+	unsigned char			*slot;
+	int64_t					value;
+	int64_t					held;
+	int						i;
+
+	memcpy(&held, at + sizeof(int64_t), sizeof(held));
+	held++;
+	memcpy(at + sizeof(int64_t), &held, sizeof(held));
+
+	for (i = 0; i < group->aggregate_count; i++) {
+		aggregate	= &group->aggregates[i];
+		slot		= at + IINQ_GROUP_HEADER + i * sizeof(int64_t);
+		value		= (aggregate_count == aggregate->type) ? 1 : iinq_aggregate_read(aggregate, row);
+		memcpy(&held, slot, sizeof(held));
+
+		switch (aggregate->type) {
+			case aggregate_min:
+				held = iinq_aggregate_less(aggregate, value, held) ? value : held;
+				break;
+
+			case aggregate_max:
+				held = iinq_aggregate_less(aggregate, held, value) ? value : held;
+				break;
+
+			default:
+				/* a count, sum or mean adds up, wrapping as unsigned integers do */
+				held = (int64_t) ((uint64_t) held + (uint64_t) value);
+				break;
+		}
+
+		memcpy(slot, &held, sizeof(held));
+	}
+}
+
+/**
+@brief		Makes a group held its grouped result, each mean being its sum
+			over the results taken.
+*/
+static void
+iinq_group_finish(
+	ion_iinq_group_t	*group,
+	unsigned char		*at,
+	ion_iinq_result_t	*grouped
+) {
+	unsigned char	*slot;
+	int64_t			taken;
+	int64_t			sum;
+	double			mean;
+	int				i;
+
+	memcpy(&taken, at + sizeof(int64_t), sizeof(taken));
+
+	for (i = 0; i < group->aggregate_count; i++) {
+		if (aggregate_avg != group->aggregates[i].type) {
+			continue;
+		}
+
+		slot	= at + IINQ_GROUP_HEADER + i * sizeof(int64_t);
+		memcpy(&sum, slot, sizeof(sum));
+		mean	= (key_type_numeric_signed == group->aggregates[i].sign) ? (double) sum / (double) taken : (double) (uint64_t) sum / (double) taken;
+		memcpy(slot, &mean, sizeof(mean));
+	}
+
+	grouped->num_bytes	= group->num_bytes;
+	grouped->data		= at + IINQ_GROUP_HEADER;
+}
+
+/**
+@brief		Grows the groups held to fit one more, rehashing them into
+			twice the buckets once there are more groups than buckets.
+*/
+static ion_err_t
+iinq_group_grow(
+	ion_iinq_group_t *group
+) {
+	unsigned char	*at;
+	uint32_t		hash;
+	void			*grown;
+	int				i;
+
+	if (group->count == group->capacity) {
+		grown = realloc(group->groups, (size_t) (2 * group->capacity) * group->stride);
+
+		if (NULL == grown) {
+			return err_out_of_memory;
+		}
+
+		group->groups	= grown;
+		group->capacity = 2 * group->capacity;
+	}
+
+	if (group->count < group->bucket_count) {
+		return err_ok;
+	}
+
+	grown = realloc(group->buckets, 2 * group->bucket_count * sizeof(int));
+
+	if (NULL == grown) {
+		return err_out_of_memory;
+	}
+
+	group->buckets		= grown;
+	group->bucket_count *= 2;
+
+	for (i = 0; i < group->bucket_count; i++) {
+		group->buckets[i] = -1;
+	}
+
+	for (i = 0; i < group->count; i++) {
+		at		= iinq_group_at(group, i);
+		hash	= dictionary_hash_bytes(iinq_group_bytes(group, at), group->size, 0) & (uint32_t) (group->bucket_count - 1);
+		memcpy(at, &group->buckets[hash], sizeof(int));
+		group->buckets[hash] = i;
+	}
+
+	return err_ok;
+}
+
+void
+iinq_group_begin(
+	ion_iinq_group_t		*group,
+	ion_iinq_result_size_t	offset,
+	ion_iinq_result_size_t	size,
+	ion_iinq_aggregate_t	*aggregates,
+	int						count,
+	ion_boolean_t			streaming
+) {
+	group->offset			= offset;
+	group->size				= size;
+	group->aggregates		= aggregates;
+	group->aggregate_count	= (count > IINQ_MAX_AGGREGATES) ? IINQ_MAX_AGGREGATES : count;
+	group->streaming		= streaming;
+	group->error			= err_ok;
+	group->num_bytes		= group->aggregate_count * sizeof(int64_t) + size;
+	group->stride			= (IINQ_GROUP_HEADER + group->num_bytes + sizeof(int64_t) - 1) / sizeof(int64_t) * sizeof(int64_t);
+	group->groups			= NULL;
+	group->count			= 0;
+	group->capacity			= 0;
+	group->buckets			= NULL;
+	group->bucket_count		= 0;
+	group->next				= 0;
+}
+
+ion_err_t
+iinq_group_add(
+	ion_iinq_group_t	*group,
+	ion_iinq_result_t	*result
+) {
+	ion_iinq_aggregate_t	*aggregate;
+	unsigned char			*bytes;
+	unsigned char			*at;
+	uint32_t				hash;
+	int						i;
+
+	if (err_ok != group->error) {
+		return group->error;
+	}
+
+	if (NULL == group->groups) {
+		for (i = 0; i < group->aggregate_count; i++) {
+			aggregate = &group->aggregates[i];
+
+			if ((aggregate_count != aggregate->type) && (((1 != aggregate->size) && (2 != aggregate->size) && (4 != aggregate->size) && (8 != aggregate->size)) || (aggregate->offset + aggregate->size > result->num_bytes))) {
+				return group->error = err_invalid_predicate;
+			}
+		}
+
+		if (group->offset + group->size > result->num_bytes) {
+			return group->error = err_invalid_predicate;
+		}
+
+		/* streaming holds the group being taken, then the one done */
+		group->capacity		= group->streaming ? 2 : 16;
+		group->groups		= malloc((size_t) group->capacity * group->stride);
+		group->bucket_count = group->streaming ? 0 : 16;
+		group->buckets		= group->streaming ? NULL : malloc(group->bucket_count * sizeof(int));
+
+		if ((NULL == group->groups) || (!group->streaming && (NULL == group->buckets))) {
+			return group->error = err_out_of_memory;
+		}
+
+		for (i = 0; i < group->bucket_count; i++) {
+			group->buckets[i] = -1;
+		}
+	}
+
+	bytes = result->data + group->offset;
+
+	if (group->streaming) {
+		at = iinq_group_at(group, 0);
+
+		if ((0 != group->count) && (0 == memcmp(iinq_group_bytes(group, at), bytes, group->size))) {
+			iinq_group_fold(group, at, result->data);
+			return err_ok;
+		}
+
+		if (0 != group->count) {
+			memcpy(iinq_group_at(group, 1), at, group->stride);
+			group->next = 1;
+		}
+
+		iinq_group_start(group, at, result->data);
+		group->count = 1;
+
+		return err_ok;
+	}
+
+	hash = dictionary_hash_bytes(bytes, group->size, 0) & (uint32_t) (group->bucket_count - 1);
+
+	for (i = group->buckets[hash]; -1 != i; memcpy(&i, at, sizeof(int))) {
+		at = iinq_group_at(group, i);
+
+		if (0 == memcmp(iinq_group_bytes(group, at), bytes, group->size)) {
+			iinq_group_fold(group, at, result->data);
+			return err_ok;
+		}
+	}
+
+	if (err_ok != (group->error = iinq_group_grow(group))) {
+		return group->error;
+	}
+
+	hash	= dictionary_hash_bytes(bytes, group->size, 0) & (uint32_t) (group->bucket_count - 1);
+	at		= iinq_group_at(group, group->count);
+	iinq_group_start(group, at, result->data);
+	memcpy(at, &group->buckets[hash], sizeof(int));
+	group->buckets[hash] = group->count;
+	group->count++;
+
+	return err_ok;
+}
+
+ion_boolean_t
+iinq_group_next(
+	ion_iinq_group_t	*group,
+	ion_iinq_result_t	*grouped,
+	ion_boolean_t		all
+) {
+	if (group->streaming) {
+		if (1 == group->next) {
+			group->next = 0;
+			iinq_group_finish(group, iinq_group_at(group, 1), grouped);
+			return boolean_true;
+		}
+
+		if (all && (1 == group->count)) {
+			group->count = 0;
+			iinq_group_finish(group, iinq_group_at(group, 0), grouped);
+			return boolean_true;
+		}
+
+		return boolean_false;
+	}
+
+	/* hashed groups are done only once every result is taken */
+	if (!all || (group->next >= group->count)) {
+		return boolean_false;
+	}
+
+	iinq_group_finish(group, iinq_group_at(group, group->next), grouped);
+	group->next++;
+
+	return boolean_true;
+}
+
+ion_err_t
+iinq_group_end(
+	ion_iinq_group_t *group
+) {
+	free(group->groups);
+	free(group->buckets);
+	group->groups		= NULL;
+	group->buckets		= NULL;
+	group->count		= 0;
+	group->capacity		= 0;
+	group->bucket_count = 0;
+
+	return group->error;
+}
+
+ion_boolean_t
+iinq_order_follows_key(
+	ion_dictionary_t	*dictionary,
+	ion_iinq_order_t	*order,
+	int					count
+) {
+	return (1 == count) && iinq_source_is_ordered(dictionary) && (0 == order[0].offset) && !order[0].descending && (order[0].size == (ion_iinq_result_size_t) dictionary->instance->record.key_size) && (order[0].type == dictionary->instance->key_type);
+}
+
+ion_err_t
+iinq_prepare(
+	ion_iinq_prepared_t		*query,
+	char					**schema_file_names,
+	int						count,
+	ion_iinq_where_func_t	where,
+	void					*where_state
+) {
+	ion_iinq_source_t	*source;
+	ion_err_t			error;
+	unsigned char		*buffer;
+	size_t				bounds	= 0;
+	int					i;
+
+	if ((count < 1) || (count > IINQ_PREPARED_MAX_SOURCES)) {
+		return err_out_of_bounds;
+	}
+
+	query->source_count			= 0;
+	query->where				= where;
+	query->where_state			= where_state;
+	query->result.num_bytes		= 0;
+	query->result.data			= NULL;
+	query->buffers				= NULL;
+	query->joined				= boolean_false;
+	query->join_records			= NULL;
+	query->join_buckets			= NULL;
+	query->join_capacity		= 0;
+	query->join_bucket_count	= 0;
+	query->merged				= boolean_false;
+	query->merge_held			= NULL;
+	query->profile				= NULL;
+	query->profile_every		= 0;
+	query->profile_count		= 0;
+	query->profiling			= boolean_false;
+	query->delivered			= NULL;
+	query->profile_files		= NULL;
+	query->profile_file_count	= 0;
+	query->field_count			= 0;
+	query->where_read_count		= (NULL == where) ? 0 : -1;
+	query->batch				= NULL;
+	query->batch_capacity		= 0;
+	query->order_count			= 0;
+	query->limit				= -1;
+	query->stopped				= boolean_false;
+	query->aggregate_count		= 0;
+	query->group_offset			= 0;
+	query->group_size			= 0;
+	query->having				= NULL;
+	query->having_state			= NULL;
+
+	for (i = 0; i < count; i++) {
+		source	= &query->sources[i];
+		error	= iinq_acquire_source(schema_file_names[i], &source->cached);
+
+		if (err_ok != error) {
+			iinq_finish(query);
+			return error;
+		}
+
+		query->source_count++;
+		source->dictionary			= *source->cached;
+		source->cursor				= NULL;
+		source->cleanup.reference	= source;
+		source->cleanup.last		= (0 == i) ? NULL : &query->sources[i - 1].cleanup;
+		source->cleanup.next		= NULL;
+
+		if (0 != i) {
+			query->sources[i - 1].cleanup.next = &source->cleanup;
+		}
+
+		query->result.num_bytes += source->dictionary.instance->record.key_size + source->dictionary.instance->record.value_size;
+		bounds					+= 2 * source->dictionary.instance->record.key_size;
+		dictionary_build_predicate(&source->predicate, predicate_all_records);
+	}
+
+	query->row_capacity = query->result.num_bytes;
+
+	/* the keys and values of the sources come first, then the result, then the bounds of their predicates */
+	query->buffers = malloc(2 * query->result.num_bytes + bounds);
+
+	if (NULL == query->buffers) {
+		iinq_finish(query);
+		return err_out_of_memory;
+	}
+
+	buffer = query->buffers;
+
+	for (i = 0; i < count; i++) {
+		source						= &query->sources[i];
+		source->key					= buffer;
+		buffer						+= source->dictionary.instance->record.key_size;
+		source->value				= buffer;
+		buffer						+= source->dictionary.instance->record.value_size;
+		source->ion_record.key		= source->key;
+		source->ion_record.value	= source->value;
+	}
+
+	query->result.data	= buffer;
+	buffer				+= query->result.num_bytes;
+
+	for (i = 0; i < count; i++) {
+		source				= &query->sources[i];
+		source->lower_bound = buffer;
+		buffer				+= source->dictionary.instance->record.key_size;
+		source->upper_bound = buffer;
+		buffer				+= source->dictionary.instance->record.key_size;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+iinq_where_key_equals(
+	ion_iinq_prepared_t *query,
+	int					source,
+	ion_key_t			key
+) {
+	ion_iinq_source_t *from;
+
+	if ((source < 0) || (source >= query->source_count)) {
+		return err_out_of_bounds;
+	}
+
+	from = &query->sources[source];
+	memcpy(from->lower_bound, key, from->dictionary.instance->record.key_size);
+
+	return dictionary_build_predicate(&from->predicate, predicate_equality, from->lower_bound);
+}
+
+ion_err_t
+iinq_where_key_range(
+	ion_iinq_prepared_t *query,
+	int					source,
+	ion_key_t			lower,
+	ion_key_t			upper
+) {
+	ion_iinq_source_t *from;
+
+	if ((source < 0) || (source >= query->source_count)) {
+		return err_out_of_bounds;
+	}
+
+	from = &query->sources[source];
+	memcpy(from->lower_bound, lower, from->dictionary.instance->record.key_size);
+	memcpy(from->upper_bound, upper, from->dictionary.instance->record.key_size);
+
+	return dictionary_build_predicate(&from->predicate, predicate_range, from->lower_bound, from->upper_bound);
+}
+
+/**
+@brief		The bytes of each value of a source a prepared query reads,
+			from the first of its fields it selects, joins on or tells
+			its condition reads to the last.
+*/
+static void
+iinq_prepared_window(
+	ion_iinq_prepared_t *query,
+	int					at,
+	ion_value_size_t	*offset,
+	ion_value_size_t	*size
+) {
+	ion_value_size_t		value_size	= query->sources[at].dictionary.instance->record.value_size;
+	ion_value_size_t		low			= value_size;
+	ion_value_size_t		high		= 0;
+	ion_iinq_projection_t	*field;
+	int						i;
+
+	*offset = 0;
+	*size	= value_size;
+
+	if ((0 == query->field_count) || (-1 == query->where_read_count)) {
+		return;
+	}
+
+	for (i = 0; i < query->field_count + query->where_read_count; i++) {
+		field = (i < query->field_count) ? &query->fields[i] : &query->where_reads[i - query->field_count];
+
+		if ((at == field->source) && field->field.in_value) {
+			low		= (field->field.offset < low) ? field->field.offset : low;
+			high	= (field->field.offset + field->field.size > high) ? field->field.offset + field->field.size : high;
+		}
+	}
+
+	if (query->joined && (at < 2) && query->on[at].in_value) {
+		low		= (query->on[at].offset < low) ? query->on[at].offset : low;
+		high	= (query->on[at].offset + query->on[at].size > high) ? query->on[at].offset + query->on[at].size : high;
+	}
+
+	*offset = (low < high) ? low : 0;
+	*size	= (low < high) ? high - low : 0;
+}
+
+/**
+@brief		Has a cursor of a source of a prepared query read only the
+			bytes of each value the query reads.
+*/
+static void
+iinq_prepared_project(
+	ion_iinq_prepared_t *query,
+	int					at,
+	ion_dict_cursor_t	*cursor
+) {
+	ion_value_size_t	offset;
+	ion_value_size_t	size;
+
+	iinq_prepared_window(query, at, &offset, &size);
+	dictionary_cursor_project(cursor, offset, size);
+}
+
+/**
+@brief		Steps the cursor of a source of a prepared query to its next
+			record, starting it over if it has none yet.
+@param		error
+				Set to the error of starting the cursor, if it fails.
+@return		Whether the source is at a record.
+*/
+static ion_boolean_t
+iinq_prepared_next(
+	ion_iinq_prepared_t *query,
+	ion_iinq_source_t	*source,
+	ion_err_t			*error
+) {
+	ion_iinq_operator_profile_t *profile = query->profiling ? &query->profile->sources[source - query->sources] : NULL;
+
+	if (NULL == source->cursor) {
+		if (err_ok != (*error = dictionary_find(&source->dictionary, &source->predicate, &source->cursor))) {
+			if (NULL != source->cursor) {
+				source->cursor->destroy(&source->cursor);
+			}
+
+			return boolean_false;
+		}
+
+		iinq_prepared_project(query, (int) (source - query->sources), source->cursor);
+	}
+
+	source->cursor_status = source->cursor->next(source->cursor, &source->ion_record);
+
+	if (NULL != profile) {
+		profile->nexts++;
+	}
+
+	if ((cs_cursor_active == source->cursor_status) || (cs_cursor_initialized == source->cursor_status)) {
+		if (NULL != profile) {
+			profile->rows_out++;
+		}
+
+		return boolean_true;
+	}
+
+	source->cursor->destroy(&source->cursor);
+
+	return boolean_false;
+}
+
+/**
+@brief		The bytes of a field of a record, as a join compares or a
+			query selects.
+*/
+static unsigned char *
+iinq_join_field(
+	ion_iinq_field_t	*field,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return (unsigned char *) (field->in_value ? value : key) + field->offset;
+}
+
+/**
+@brief		Passes the records the sources of a prepared query are at to
+			its processor, if they meet its condition.
+*/
+static void
+iinq_prepared_emit(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_query_processor_t	*processor
+) {
+	ion_iinq_source_t		*source;
+	ion_iinq_projection_t	*projection;
+	ion_iinq_result_size_t	at = 0;
+	int						i;
+
+	if (query->profiling) {
+		query->profile->where.rows_in++;
+	}
+
+	if ((NULL != query->where) && !query->where(query, query->where_state)) {
+		return;
+	}
+
+	if (query->profiling) {
+		query->profile->where.rows_out++;
+	}
+
+	for (i = 0; i < query->field_count; i++) {
+		projection	= &query->fields[i];
+		source		= &query->sources[projection->source];
+		memcpy(query->result.data + at, iinq_join_field(&projection->field, source->key, source->value), projection->field.size);
+		at			+= projection->field.size;
+	}
+
+	for (i = 0; (0 == query->field_count) && (i < query->source_count); i++) {
+		source	= &query->sources[i];
+		memcpy(query->result.data + at, source->key, source->dictionary.instance->record.key_size);
+		at		+= source->dictionary.instance->record.key_size;
+		memcpy(query->result.data + at, source->value, source->dictionary.instance->record.value_size);
+		at		+= source->dictionary.instance->record.value_size;
+	}
+
+	processor->execute(&query->result, processor->state);
+}
+
+/**
+@brief		Runs through every combination of the records of the sources
+			of a prepared query from @p from on, those before it staying
+			at the records they are at.
+*/
+static ion_err_t
+iinq_prepared_loop(
+	ion_iinq_prepared_t			*query,
+	int							from,
+	ion_iinq_query_processor_t	*processor
+) {
+	ion_err_t	error	= err_ok;
+	int			level	= from;
+
+	if (from >= query->source_count) {
+		iinq_prepared_emit(query, processor);
+		return err_ok;
+	}
+
+	/* each source runs through its records once for every combination of the sources before it */
+	while ((level >= from) && !query->stopped) {
+		if (!iinq_prepared_next(query, &query->sources[level], &error)) {
+			if (err_ok != error) {
+				break;
+			}
+
+			level--;
+			continue;
+		}
+
+		if (level + 1 < query->source_count) {
+			level++;
+			continue;
+		}
+
+		iinq_prepared_emit(query, processor);
+
+		if (query->stopped) {
+			break;
+		}
+	}
+
+	return error;
+}
+
+/**
+@brief		Runs a prepared query joined on equal fields, hashing the
+			source that tells it is smaller, or else the second.
+@details	The records hashed are taken as many as fit in
+			@ref IINQ_HASH_JOIN_BYTES at a time, and the other source is
+			read through once for each such part.
+*/
+static ion_err_t
+iinq_prepared_hash_join(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_query_processor_t	*processor
+) {
+	ion_dictionary_info_t	info[2];
+	ion_iinq_source_t		*build;
+	ion_iinq_source_t		*probe;
+	ion_iinq_field_t		*build_on;
+	ion_iinq_field_t		*probe_on;
+	ion_key_size_t			key_size;
+	ion_value_size_t		value_size;
+	unsigned char			*record;
+	unsigned char			*field;
+	size_t					stride;
+	size_t					capacity;
+	uint32_t				hash;
+	ion_err_t				error = err_ok;
+	ion_boolean_t			more;
+	void					*grown;
+	int						count;
+	int						at;
+	int						i;
+
+	for (i = 0; i < 2; i++) {
+		info[i].min_key = NULL;
+		info[i].max_key = NULL;
+
+		if (err_ok != dictionary_get_info(&query->sources[i].dictionary, &info[i])) {
+			info[i].record_count = -1;
+		}
+	}
+
+	i			= ((-1 != info[0].record_count) && ((-1 == info[1].record_count) || (info[0].record_count < info[1].record_count))) ? 0 : 1;
+	build		= &query->sources[i];
+	build_on	= &query->on[i];
+	probe		= &query->sources[1 - i];
+	probe_on	= &query->on[1 - i];
+	key_size	= build->dictionary.instance->record.key_size;
+	value_size	= build->dictionary.instance->record.value_size;
+	stride		= (sizeof(int) + key_size + value_size + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+
+	for (more = boolean_true; more && (err_ok == error) && !query->stopped;) {
+		/* a part of the records hashed, the table growing as far as it may */
+		count = 0;
+
+		while (boolean_true) {
+			capacity = (size_t) (count + 1) * stride;
+
+			if (capacity > query->join_capacity) {
+				if ((0 != count) && (capacity > IINQ_HASH_JOIN_BYTES)) {
+					break;
+				}
+
+				capacity	= (0 == query->join_capacity) ? stride * 16 : query->join_capacity * 2;
+				capacity	= (capacity > IINQ_HASH_JOIN_BYTES) ? IINQ_HASH_JOIN_BYTES / stride * stride : capacity;
+				capacity	= (capacity < stride) ? stride : capacity;
+				grown		= realloc(query->join_records, capacity);
+
+				if (NULL == grown) {
+					if (0 == count) {
+						error = err_out_of_memory;
+					}
+
+					break;
+				}
+
+				query->join_records		= grown;
+				query->join_capacity	= capacity;
+
+				if ((size_t) (count + 1) * stride > capacity) {
+					break;
+				}
+			}
+
+			if (!iinq_prepared_next(query, build, &error)) {
+				more = boolean_false;
+				break;
+			}
+
+			record = query->join_records + (size_t) count * stride;
+			memcpy(record + sizeof(int), build->key, key_size);
+			memcpy(record + sizeof(int) + key_size, build->value, value_size);
+			count++;
+		}
+
+		if ((err_ok != error) || (0 == count)) {
+			break;
+		}
+
+		/* as many buckets as records, to a power of 2 */
+		for (at = 1; at < count; at *= 2) {}
+
+		if (at > query->join_bucket_count) {
+			grown = realloc(query->join_buckets, at * sizeof(int));
+
+			if (NULL == grown) {
+				error = err_out_of_memory;
+				break;
+			}
+
+			query->join_buckets			= grown;
+			query->join_bucket_count	= at;
+		}
+
+		for (i = 0; i < at; i++) {
+			query->join_buckets[i] = -1;
+		}
+
+		for (i = 0; i < count; i++) {
+			record	= query->join_records + (size_t) i * stride;
+			field	= iinq_join_field(build_on, record + sizeof(int), record + sizeof(int) + key_size);
+			hash	= dictionary_hash_bytes(field, build_on->size, 0) & (uint32_t) (at - 1);
+			memcpy(record, &query->join_buckets[hash], sizeof(int));
+			query->join_buckets[hash] = i;
+		}
+
+		/* the other source read through once, each record finding its equals in the table */
+		while (iinq_prepared_next(query, probe, &error)) {
+			field	= iinq_join_field(probe_on, probe->key, probe->value);
+			hash	= dictionary_hash_bytes(field, probe_on->size, 0) & (uint32_t) (at - 1);
+
+			for (i = query->join_buckets[hash]; -1 != i; memcpy(&i, record, sizeof(int))) {
+				record = query->join_records + (size_t) i * stride;
+
+				if (0 != memcmp(field, iinq_join_field(build_on, record + sizeof(int), record + sizeof(int) + key_size), probe_on->size)) {
+					continue;
+				}
+
+				memcpy(build->key, record + sizeof(int), key_size);
+				memcpy(build->value, record + sizeof(int) + key_size, value_size);
+
+				if ((err_ok != (error = iinq_prepared_loop(query, 2, processor))) || query->stopped) {
+					break;
+				}
+			}
+
+			if ((err_ok != error) || query->stopped) {
+				break;
+			}
+		}
+	}
+
+	return error;
+}
+
+/**
+@brief		Runs a prepared query joined on the keys of two ordered
+			sources, reading both in order at once.
+@details	Each record of the second source with a key the first has is
+			joined as it is passed. A key the first source has again has
+			its equals in the second read again by an equality cursor,
+			the record the second source is at being held meanwhile.
+*/
+static ion_err_t
+iinq_prepared_merge_join(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_query_processor_t	*processor
+) {
+	ion_iinq_source_t		*outer		= &query->sources[0];
+	ion_iinq_source_t		*inner		= &query->sources[1];
+	ion_dictionary_parent_t *instance	= inner->dictionary.instance;
+	ion_key_size_t			key_size	= instance->record.key_size;
+	ion_value_size_t		value_size	= instance->record.value_size;
+	unsigned char			*key		= query->merge_held;
+	unsigned char			*held		= query->merge_held + key_size;
+	ion_dict_cursor_t		*again		= NULL;
+	ion_predicate_t			equal;
+	ion_cursor_status_t		status;
+	ion_err_t				error		= err_ok;
+	ion_boolean_t			has_outer;
+	ion_boolean_t			has_inner;
+	char					comparison;
+
+	has_outer	= iinq_prepared_next(query, outer, &error);
+	has_inner	= has_outer && iinq_prepared_next(query, inner, &error);
+
+	while (has_outer && has_inner && (err_ok == error) && !query->stopped) {
+		comparison = instance->compare(outer->key, inner->key, key_size);
+
+		if (comparison < 0) {
+			has_outer = iinq_prepared_next(query, outer, &error);
+			continue;
+		}
+
+		if (comparison > 0) {
+			has_inner = iinq_prepared_next(query, inner, &error);
+			continue;
+		}
+
+		/* the records of the second source with the key, joined as they are passed */
+		memcpy(key, inner->key, key_size);
+
+		do {
+			error = iinq_prepared_loop(query, 2, processor);
+		} while ((err_ok == error) && !query->stopped && (has_inner = iinq_prepared_next(query, inner, &error)) && (0 == instance->compare(inner->key, key, key_size)));
+
+		/* the first source having the key again, its equals are sought again */
+		while ((err_ok == error) && !query->stopped && (has_outer = iinq_prepared_next(query, outer, &error)) && (0 == instance->compare(outer->key, key, key_size))) {
+			if (has_inner) {
+				memcpy(held, inner->key, key_size);
+				memcpy(held + key_size, inner->value, value_size);
+			}
+
+			dictionary_build_predicate(&equal, predicate_equality, key);
+
+			if (err_ok != (error = dictionary_find(&inner->dictionary, &equal, &again))) {
+				break;
+			}
+
+			iinq_prepared_project(query, 1, again);
+
+			while ((err_ok == error) && !query->stopped) {
+				status = again->next(again, &inner->ion_record);
+
+				if (query->profiling) {
+					query->profile->sources[1].nexts++;
+				}
+
+				if ((cs_cursor_active != status) && (cs_cursor_initialized != status)) {
+					break;
+				}
+
+				if (query->profiling) {
+					query->profile->sources[1].rows_out++;
+				}
+
+				error = iinq_prepared_loop(query, 2, processor);
+			}
+
+			again->destroy(&again);
+
+			if (has_inner) {
+				memcpy(inner->key, held, key_size);
+				memcpy(inner->value, held + key_size, value_size);
+			}
+		}
+	}
+
+	if (NULL != again) {
+		again->destroy(&again);
+	}
+
+	return error;
+}
+
+ion_err_t
+iinq_join_on(
+	ion_iinq_prepared_t		*query,
+	const ion_iinq_field_t	fields[2]
+) {
+	ion_dictionary_parent_t *instance;
+	ion_boolean_t			merged	= boolean_true;
+	void					*held;
+	int						i;
+
+	if (query->source_count < 2) {
+		return err_illegal_state;
+	}
+
+	for (i = 0; i < 2; i++) {
+		instance = query->sources[i].dictionary.instance;
+
+		if ((0 == fields[i].size) || (fields[i].size != fields[0].size) || (fields[i].offset + fields[i].size > (fields[i].in_value ? instance->record.value_size : instance->record.key_size))) {
+			return err_invalid_predicate;
+		}
+
+		query->on[i]	= fields[i];
+		merged			= merged && iinq_source_is_ordered(&query->sources[i].dictionary) && !fields[i].in_value && (0 == fields[i].offset) && (fields[i].size == (ion_value_size_t) instance->record.key_size) && (instance->key_type == query->sources[0].dictionary.instance->key_type);
+	}
+
+	/* the key being merged and a record of the second source, held while its equals are read again */
+	if (merged) {
+		held = realloc(query->merge_held, 2 * (size_t) instance->record.key_size + instance->record.value_size);
+
+		if (NULL == held) {
+			return err_out_of_memory;
+		}
+
+		query->merge_held = held;
+	}
+
+	query->joined	= boolean_true;
+	query->merged	= merged;
+
+	return err_ok;
+}
+
+/**
+@brief		The bytes of each result a prepared query passes on, those of
+			its aggregates and the bytes grouped by if it is grouped.
+*/
+static ion_iinq_result_size_t
+iinq_prepared_passed_bytes(
+	ion_iinq_prepared_t *query
+) {
+	return (0 == query->aggregate_count) ? query->result.num_bytes : query->aggregate_count * sizeof(int64_t) + query->group_size;
+}
+
+ion_err_t
+iinq_where_reads(
+	ion_iinq_prepared_t			*query,
+	const ion_iinq_projection_t *fields,
+	int							count
+) {
+	ion_dictionary_parent_t *instance;
+	int						i;
+
+	if ((count < -1) || (count > IINQ_PREPARED_MAX_FIELDS)) {
+		return err_out_of_bounds;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((fields[i].source < 0) || (fields[i].source >= query->source_count)) {
+			return err_out_of_bounds;
+		}
+
+		instance = query->sources[fields[i].source].dictionary.instance;
+
+		if (fields[i].field.offset + fields[i].field.size > (fields[i].field.in_value ? instance->record.value_size : instance->record.key_size)) {
+			return err_invalid_predicate;
+		}
+
+		query->where_reads[i] = fields[i];
+	}
+
+	query->where_read_count = count;
+
+	return err_ok;
+}
+
+ion_err_t
+iinq_select(
+	ion_iinq_prepared_t			*query,
+	const ion_iinq_projection_t *fields,
+	int							count
+) {
+	ion_dictionary_parent_t *instance;
+	ion_iinq_result_size_t	num_bytes = 0;
+	int						i;
+
+	if ((count < 0) || (count > IINQ_PREPARED_MAX_FIELDS)) {
+		return err_out_of_bounds;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((fields[i].source < 0) || (fields[i].source >= query->source_count)) {
+			return err_out_of_bounds;
+		}
+
+		instance	= query->sources[fields[i].source].dictionary.instance;
+
+		if ((0 == fields[i].field.size) || (fields[i].field.offset + fields[i].field.size > (fields[i].field.in_value ? instance->record.value_size : instance->record.key_size))) {
+			return err_invalid_predicate;
+		}
+
+		num_bytes	+= fields[i].field.size;
+	}
+
+	/* the result is laid out where one of every record whole is */
+	if (num_bytes > query->row_capacity) {
+		return err_invalid_predicate;
+	}
+
+	for (i = 0; i < count; i++) {
+		query->fields[i] = fields[i];
+	}
+
+	query->field_count		= count;
+	query->result.num_bytes = (0 == count) ? query->row_capacity : num_bytes;
+
+	return err_ok;
+}
+
+/**
+@brief		A run of a prepared query in batches.
+*/
+typedef struct {
+	ion_iinq_prepared_t			*query;		/**< The query run */
+	ion_iinq_batch_t			batch;		/**< The results not yet passed on */
+	ion_iinq_batch_processor_t	*processor;	/**< What they are passed to */
+} iinq_batch_run_t;
+
+/**
+@brief		Takes a result of a prepared query into its batch, having the
+			next laid out after it, and passes the batch on once it is
+			full.
+*/
+static void
+iinq_batch_append(
+	ion_iinq_result_t	*result,
+	void				*state
+) {
+	iinq_batch_run_t	*run	= state;
+	unsigned char		*slot	= run->batch.data + (size_t) run->batch.count * run->batch.num_bytes;
+
+	/* a sorted result comes from the sort, not from where it was laid out */
+	if (result->data != slot) {
+		memcpy(slot, result->data, run->batch.num_bytes);
+	}
+
+	run->batch.count++;
+
+	if (IINQ_BATCH_ROWS == run->batch.count) {
+		run->processor->execute(&run->batch, run->processor->state);
+		run->batch.count = 0;
+	}
+
+	run->query->result.data = run->batch.data + (size_t) run->batch.count * run->batch.num_bytes;
+}
+
+ion_err_t
+iinq_execute_batched(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_batch_processor_t	*processor
+) {
+	ion_iinq_query_processor_t	append;
+	iinq_batch_run_t			run;
+	unsigned char				*row;
+	ion_iinq_result_size_t		passed;
+	size_t						needed;
+	ion_err_t					error;
+
+	/* a grouped result and one laid out from the sources differ in size, and each must fit */
+	passed	= iinq_prepared_passed_bytes(query);
+	needed	= (size_t) IINQ_BATCH_ROWS * ((passed > query->result.num_bytes) ? passed : query->result.num_bytes);
+
+	if (needed > query->batch_capacity) {
+		free(query->batch);
+		query->batch_capacity	= 0;
+		query->batch			= malloc(needed);
+
+		if (NULL == query->batch) {
+			return err_out_of_memory;
+		}
+
+		query->batch_capacity = needed;
+	}
+
+	/* each result is laid out straight into the batch, where the processor reads it */
+	row						= query->result.data;
+	run.query				= query;
+	run.batch.count			= 0;
+	run.batch.num_bytes		= passed;
+	run.batch.data			= query->batch;
+	run.processor			= processor;
+	append					= IINQ_QUERY_PROCESSOR(iinq_batch_append, &run);
+	query->result.data		= query->batch;
+
+	error					= iinq_execute(query, &append);
+	query->result.data		= row;
+
+	if (0 != run.batch.count) {
+		processor->execute(&run.batch, processor->state);
+	}
+
+	return error;
+}
+
+ion_err_t
+iinq_group_by(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_result_size_t		offset,
+	ion_iinq_result_size_t		size,
+	const ion_iinq_aggregate_t	*aggregates,
+	int							count
+) {
+	const ion_iinq_aggregate_t	*aggregate;
+	int							i;
+
+	if ((count < 0) || (count > IINQ_MAX_AGGREGATES)) {
+		return err_out_of_bounds;
+	}
+
+	if ((0 != count) && ((0 == size) || (offset + size > query->result.num_bytes))) {
+		return err_invalid_predicate;
+	}
+
+	for (i = 0; i < count; i++) {
+		aggregate = &aggregates[i];
+
+		if ((aggregate_count != aggregate->type) && (((1 != aggregate->size) && (2 != aggregate->size) && (4 != aggregate->size) && (8 != aggregate->size)) || (aggregate->offset + aggregate->size > query->result.num_bytes))) {
+			return err_invalid_predicate;
+		}
+
+		query->aggregates[i] = *aggregate;
+	}
+
+	query->aggregate_count	= count;
+	query->group_offset		= offset;
+	query->group_size		= size;
+
+	return err_ok;
+}
+
+void
+iinq_having(
+	ion_iinq_prepared_t		*query,
+	ion_iinq_having_func_t	having,
+	void					*having_state
+) {
+	query->having		= having;
+	query->having_state = having_state;
+}
+
+ion_err_t
+iinq_order_by(
+	ion_iinq_prepared_t		*query,
+	const ion_iinq_order_t	*order,
+	int						count
+) {
+	int i;
+
+	if ((count < 0) || (count > IINQ_MAX_ORDERS)) {
+		return err_out_of_bounds;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((0 == order[i].size) || (order[i].offset + order[i].size > iinq_prepared_passed_bytes(query))) {
+			return err_invalid_predicate;
+		}
+
+		query->order[i] = order[i];
+	}
+
+	query->order_count = count;
+
+	return err_ok;
+}
+
+void
+iinq_limit(
+	ion_iinq_prepared_t *query,
+	long				limit
+) {
+	query->limit = limit;
+}
+
+/**
+@brief		Takes a result of a prepared query into its sort, stopping the
+			run once the sort wants no more.
+*/
+static void
+iinq_sort_take(
+	ion_iinq_result_t	*result,
+	void				*state
+) {
+	ion_iinq_prepared_t *query = state;
+
+	if (query->profiling) {
+		query->profile->sort.rows_in++;
+	}
+
+	if (!iinq_sort_add(&query->sort, result)) {
+		query->stopped = boolean_true;
+	}
+}
+
+/**
+@brief		Passes the groups of a prepared query that are done and meet
+			its condition to its sort.
+*/
+static void
+iinq_group_pass(
+	ion_iinq_prepared_t *query,
+	ion_boolean_t		all
+) {
+	ion_iinq_result_t grouped;
+
+	while (!query->stopped && iinq_group_next(&query->group, &grouped, all)) {
+		if ((NULL == query->having) || query->having(&grouped, query->having_state)) {
+			if (query->profiling) {
+				query->profile->group.rows_out++;
+			}
+
+			iinq_sort_take(&grouped, query);
+		}
+	}
+}
+
+/**
+@brief		Takes a result of a prepared query into its groups, passing on
+			any group it finishes.
+*/
+static void
+iinq_group_take(
+	ion_iinq_result_t	*result,
+	void				*state
+) {
+	ion_iinq_prepared_t *query = state;
+
+	if (query->profiling) {
+		query->profile->group.rows_in++;
+	}
+
+	if (err_ok != iinq_group_add(&query->group, result)) {
+		query->stopped = boolean_true;
+		return;
+	}
+
+	iinq_group_pass(query, boolean_false);
+}
+
+/**
+@brief		Plans a run of a prepared query.
+*/
+static void
+iinq_prepared_plan(
+	ion_iinq_prepared_t *query,
+	ion_iinq_plan_t		*plan
+) {
+	ion_iinq_cached_source_t	*cached;
+	ion_iinq_source_t			*first = &query->sources[0];
+	ion_boolean_t				key_first;
+	ion_boolean_t				ordered;
+	int							i;
+
+	plan->source_count = query->source_count;
+
+	for (i = 0; i < query->source_count; i++) {
+		cached				= iinq_find_cached(&query->sources[i].dictionary);
+		plan->engines[i]	= (NULL == cached) ? iinq_engine_bpp_tree : cached->engine;
+		iinq_prepared_window(query, i, &plan->value_offset[i], &plan->value_size[i]);
+		plan->access[i]		= (predicate_equality == query->sources[i].predicate.type) ? iinq_access_seek : (predicate_range == query->sources[i].predicate.type) ? iinq_access_range : iinq_access_scan;
+	}
+
+	plan->join		= (query->source_count < 2) ? iinq_join_none : !query->joined ? iinq_join_nested_loop : query->merged ? iinq_join_merge : iinq_join_hash;
+	plan->filtered	= NULL != query->where;
+	plan->having	= (0 != query->aggregate_count) && (NULL != query->having);
+	plan->limit		= query->limit;
+
+	/* one ordered source, laid out with its key first, is read in the order of its key */
+	key_first		= (1 == query->source_count) && iinq_source_is_ordered(&first->dictionary) && ((0 == query->field_count) || ((0 == query->fields[0].source) && !query->fields[0].field.in_value && (0 == query->fields[0].field.offset) && (query->fields[0].field.size == first->dictionary.instance->record.key_size)));
+	ordered			= key_first && (0 == query->aggregate_count) && iinq_order_follows_key(&first->dictionary, query->order, query->order_count);
+	plan->grouping	= (0 == query->aggregate_count) ? iinq_grouping_none : (key_first && (0 == query->group_offset) && (query->group_size == (ion_iinq_result_size_t) first->dictionary.instance->record.key_size)) ? iinq_grouping_streaming : iinq_grouping_hash;
+	plan->sorting	= (0 == query->order_count) ? iinq_sorting_none : ordered ? iinq_sorting_by_key : ((-1 != query->limit) && ((size_t) query->limit * iinq_prepared_passed_bytes(query) <= IINQ_SORT_BYTES)) ? iinq_sorting_top : iinq_sorting_full;
+}
+
+/**
+@brief		Microseconds of a monotonic clock, to time profiled runs by.
+*/
+static unsigned long
+iinq_profile_clock(
+	void
+) {
+#if defined(ARDUINO)
+	return micros();
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long) now.tv_sec * 1000000UL + (unsigned long) now.tv_nsec / 1000UL;
+#endif
+}
+
+/**
+@brief		Counts a result of a profiled run out of its sort, then passes
+			it to the processor of the run.
+*/
+static void
+iinq_profile_deliver(
+	ion_iinq_result_t	*result,
+	void				*state
+) {
+	ion_iinq_prepared_t *query = state;
+
+	query->profile->sort.rows_out++;
+	query->delivered->execute(result, query->delivered->state);
+}
+
+/**
+@brief		Adds what a file did since its counters of @p before to an
+			operator, or all it did if they were reset since.
+*/
+static void
+iinq_profile_add_io(
+	ion_iinq_operator_profile_t *profile,
+	ion_file_io_stats_t			*after,
+	ion_file_io_stats_t			*before
+) {
+	if ((NULL != before) && ((after->reads < before->reads) || (after->writes < before->writes) || (after->micros < before->micros))) {
+		before = NULL;
+	}
+
+	profile->reads			+= after->reads - ((NULL == before) ? 0 : before->reads);
+	profile->read_bytes		+= after->read_bytes - ((NULL == before) ? 0 : before->read_bytes);
+	profile->writes			+= after->writes - ((NULL == before) ? 0 : before->writes);
+	profile->write_bytes	+= after->write_bytes - ((NULL == before) ? 0 : before->write_bytes);
+	profile->io_micros		+= after->micros - ((NULL == before) ? 0 : before->micros);
+}
+
+/**
+@brief		Ends a profiled run, adding what each file did during it to the
+			operator it belongs to.
+*/
+static void
+iinq_profile_end(
+	ion_iinq_prepared_t *query,
+	unsigned long		started
+) {
+	ion_iinq_operator_profile_t *profile;
+	ion_file_io_stats_t			*after	= query->profile_files + ION_FILE_STATS_FILES;
+	ion_file_io_stats_t			*before;
+	int							count;
+	int							i;
+	int							j;
+
+	query->profile->micros += iinq_profile_clock() - started;
+	query->profile->runs++;
+	count = ion_file_io_stats(after, ION_FILE_STATS_FILES);
+	count = (count > ION_FILE_STATS_FILES) ? ION_FILE_STATS_FILES : count;
+
+	for (i = 0; i < count; i++) {
+		before = NULL;
+
+		for (j = 0; (j < query->profile_file_count) && (NULL == before); j++) {
+			if (0 == strcmp(after[i].name, query->profile_files[j].name)) {
+				before = &query->profile_files[j];
+			}
+		}
+
+		/* the files of a source's dictionary are its own, runs spilled are the sort's */
+		profile = (NULL != strstr(after[i].name, ".srt")) ? &query->profile->sort : &query->profile->other;
+
+		for (j = 0; (j < query->source_count) && (&query->profile->other == profile); j++) {
+			if (after[i].dictionary_id == (int) query->sources[j].dictionary.instance->id) {
+				profile = &query->profile->sources[j];
+			}
+		}
+
+		iinq_profile_add_io(profile, &after[i], before);
+	}
+
+	query->profiling = boolean_false;
+}
+
+ion_err_t
+iinq_execute(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_query_processor_t	*processor
+) {
+	ion_iinq_query_processor_t	take;
+	ion_iinq_query_processor_t	deliver;
+	ion_iinq_plan_t				plan;
+	ion_iinq_result_size_t		num_bytes;
+	ion_err_t					error	= err_ok;
+	ion_err_t					grouped;
+	unsigned long				started = 0;
+	int							i;
+
+	num_bytes = iinq_prepared_passed_bytes(query);
+
+	if ((0 != query->aggregate_count) && (query->group_offset + query->group_size > query->result.num_bytes)) {
+		return err_invalid_predicate;
+	}
+
+	for (i = 0; i < query->order_count; i++) {
+		if (query->order[i].offset + query->order[i].size > num_bytes) {
+			return err_invalid_predicate;
+		}
+	}
+
+	/* one run of every so many counts what each operator does, the others counting nothing */
+	if ((NULL != query->profile) && (0 == query->profile_count++ % query->profile_every)) {
+		query->profiling			= boolean_true;
+		query->delivered			= processor;
+		deliver						= IINQ_QUERY_PROCESSOR(iinq_profile_deliver, query);
+		processor					= &deliver;
+		query->profile_file_count	= ion_file_io_stats(query->profile_files, ION_FILE_STATS_FILES);
+		query->profile_file_count	= (query->profile_file_count > ION_FILE_STATS_FILES) ? ION_FILE_STATS_FILES : query->profile_file_count;
+		started						= iinq_profile_clock();
+	}
+
+	iinq_prepared_plan(query, &plan);
+
+	iinq_sort_begin(&query->sort, query->order, (iinq_sorting_by_key == plan.sorting) ? 0 : query->order_count, query->limit, processor);
+	take			= IINQ_QUERY_PROCESSOR(iinq_sort_take, query);
+	query->stopped	= (0 == query->limit);
+
+	if (0 != query->aggregate_count) {
+		iinq_group_begin(&query->group, query->group_offset, query->group_size, query->aggregates, query->aggregate_count, iinq_grouping_streaming == plan.grouping);
+		take = IINQ_QUERY_PROCESSOR(iinq_group_take, query);
+	}
+
+	if (!query->stopped) {
+		error = (iinq_join_merge == plan.join) ? iinq_prepared_merge_join(query, &take) : (iinq_join_hash == plan.join) ? iinq_prepared_hash_join(query, &take) : iinq_prepared_loop(query, 0, &take);
+	}
+
+	if (0 != query->aggregate_count) {
+		if (err_ok == error) {
+			iinq_group_pass(query, boolean_true);
+		}
+
+		grouped = iinq_group_end(&query->group);
+		error	= (err_ok == error) ? grouped : error;
+	}
+
+	error = iinq_sort_end(&query->sort, error);
+
+	/* a query cut short by an error starts over when run again */
+	for (i = 0; i < query->source_count; i++) {
+		if (NULL != query->sources[i].cursor) {
+			query->sources[i].cursor->destroy(&query->sources[i].cursor);
+		}
+	}
+
+	if (query->profiling) {
+		iinq_profile_end(query, started);
+	}
+
+	return error;
+}
+
+void
+iinq_explain(
+	ion_iinq_prepared_t *query,
+	ion_iinq_plan_t		*plan
+) {
+	iinq_prepared_plan(query, plan);
+}
+
+void
+iinq_explain_print(
+	ion_iinq_prepared_t *query
+) {
+	static const char	*engines[]		= { "bpp_tree", "file_hash", "sorted_flat_file" };
+	static const char	*access[]		= { "scan", "seek", "range" };
+	static const char	*joins[]		= { "none", "nested_loop", "hash_join", "merge_join" };
+	static const char	*groupings[]	= { "none", "hash", "streaming" };
+	static const char	*sortings[]		= { "none", "by_key", "top", "full" };
+	ion_iinq_plan_t		plan;
+	int					i;
+
+	iinq_prepared_plan(query, &plan);
+
+	if (-1 != plan.limit) {
+		printf("limit %ld\n", plan.limit);
+	}
+
+	if (iinq_sorting_none != plan.sorting) {
+		printf("sort %s, %d parts\n", sortings[plan.sorting], query->order_count);
+	}
+
+	if (plan.having) {
+		printf("having\n");
+	}
+
+	if (iinq_grouping_none != plan.grouping) {
+		printf("group %s, %d aggregates\n", groupings[plan.grouping], query->aggregate_count);
+	}
+
+	if (plan.filtered) {
+		printf("where\n");
+	}
+
+	if (iinq_join_none != plan.join) {
+		printf("join %s\n", joins[plan.join]);
+	}
+
+	for (i = 0; i < plan.source_count; i++) {
+		printf("  source %d: %s %s, dictionary %d, value bytes %u of %u from %u\n", i, access[plan.access[i]], engines[plan.engines[i]], (int) query->sources[i].dictionary.instance->id, (unsigned int) plan.value_size[i], (unsigned int) query->sources[i].dictionary.instance->record.value_size, (unsigned int) plan.value_offset[i]);
+	}
+}
+
+ion_err_t
+iinq_profile(
+	ion_iinq_prepared_t *query,
+	ion_iinq_profile_t	*profile,
+	unsigned long		every
+) {
+	/* the file counters as a run begins, then as it ends */
+	if ((NULL != profile) && (NULL == query->profile_files)) {
+		query->profile_files = malloc(2 * ION_FILE_STATS_FILES * sizeof(ion_file_io_stats_t));
+
+		if (NULL == query->profile_files) {
+			return err_out_of_memory;
+		}
+	}
+
+	query->profile			= profile;
+	query->profile_every	= (0 == every) ? 1 : every;
+	query->profile_count	= 0;
+
+	return err_ok;
+}
+
+void
+iinq_profile_reset(
+	ion_iinq_profile_t *profile
+) {
+	memset(profile, 0, sizeof(ion_iinq_profile_t));
+}
+
+/**
+@brief		Writes the counters of one operator of a profile.
+*/
+static void
+iinq_profile_print_operator(
+	const char					*name,
+	ion_iinq_operator_profile_t *profile
+) {
+	printf("%-10s %10lu %10lu %10lu %8lu %10lu %8lu %10lu %10lu\n", name, profile->rows_in, profile->rows_out, profile->nexts, profile->reads, profile->read_bytes, profile->writes, profile->write_bytes, profile->io_micros);
+}
+
+void
+iinq_profile_print(
+	ion_iinq_prepared_t *query,
+	ion_iinq_profile_t	*profile
+) {
+	char	name[20];
+	int		i;
+
+	printf("%lu runs in %lu micros\n", profile->runs, profile->micros);
+	printf("%-10s %10s %10s %10s %8s %10s %8s %10s %10s\n", "operator", "rows_in", "rows_out", "nexts", "reads", "read_b", "writes", "write_b", "io_micros");
+	iinq_profile_print_operator("sort", &profile->sort);
+	iinq_profile_print_operator("group", &profile->group);
+	iinq_profile_print_operator("where", &profile->where);
+
+	for (i = 0; i < query->source_count; i++) {
+		sprintf(name, "source %d", i);
+		iinq_profile_print_operator(name, &profile->sources[i]);
+	}
+
+	iinq_profile_print_operator("other", &profile->other);
+}
+
+ion_err_t
+iinq_finish(
+	ion_iinq_prepared_t *query
+) {
+	ion_err_t	error = err_ok;
+	ion_err_t	released;
+	int			i;
+
+	for (i = 0; i < query->source_count; i++) {
+		if (NULL != query->sources[i].cursor) {
+			query->sources[i].cursor->destroy(&query->sources[i].cursor);
+		}
+
+		released = iinq_release_source(&query->sources[i].dictionary);
+
+		if (err_ok == error) {
+			error = released;
+		}
+	}
 
-	fremove(schema_file_name);
+	free(query->buffers);
+	free(query->join_records);
+	free(query->join_buckets);
+	free(query->merge_held);
+	free(query->profile_files);
+	free(query->batch);
+	query->buffers				= NULL;
+	query->merge_held			= NULL;
+	query->merged				= boolean_false;
+	query->profile_files		= NULL;
+	query->profile				= NULL;
+	query->batch				= NULL;
+	query->batch_capacity		= 0;
+	query->join_records			= NULL;
+	query->join_buckets			= NULL;
+	query->join_capacity		= 0;
+	query->join_bucket_count	= 0;
+	query->result.data			= NULL;
+	query->source_count			= 0;
 
 	return error;
 }
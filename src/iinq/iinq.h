@@ -8,6 +8,19 @@ extern "C" {
 
 #include "../dictionary/dictionary_types.h"
 #include "../dictionary/ion_master_table.h"
+#include "../file/ion_file.h"
+
+/**
+@brief		How many sources no statement is using are kept open, so the
+			next statement on one need not open its files again.
+*/
+#if !defined(IINQ_SOURCE_CACHE_SIZE)
+#if defined(ARDUINO)
+#define IINQ_SOURCE_CACHE_SIZE	2
+#else
+#define IINQ_SOURCE_CACHE_SIZE	8
+#endif
+#endif
 
 typedef unsigned int ion_iinq_result_size_t;
 
@@ -51,8 +64,37 @@ struct iinq_source {
 	ion_value_t				value;
 	ion_record_t			ion_record;
 	ion_iinq_cleanup_t			cleanup;
+	ion_dictionary_t			*cached;
+	ion_key_t				lower_bound;	/**< In a prepared query, room for the
+										 key or lower key its predicate is of */
+	ion_key_t				upper_bound;	/**< And for the upper key */
 };
 
+/**
+@brief		The dictionaries a source can be kept in.
+*/
+typedef enum ION_IINQ_ENGINE {
+	iinq_engine_bpp_tree,		/**< A B+ tree, read in key order */
+	iinq_engine_file_hash,		/**< An open address hash in a file, of
+								 @ref IINQ_FILE_HASH_SIZE records, for
+								 lookups of single keys */
+	iinq_engine_sorted_flat_file/**< A flat file in sorted mode, read in
+								 key order, each key inserted not less than
+								 the last, for logs */
+} ion_iinq_engine_t;
+
+/**
+@brief		The most records a source kept in an open address file hash
+			holds.
+*/
+#if !defined(IINQ_FILE_HASH_SIZE)
+#if defined(ARDUINO)
+#define IINQ_FILE_HASH_SIZE	256
+#else
+#define IINQ_FILE_HASH_SIZE	4096
+#endif
+#endif
+
 ion_err_t
 iinq_create_source(
 	char					*schema_file_name,
@@ -61,6 +103,44 @@ iinq_create_source(
 	ion_value_size_t		value_size
 );
 
+/**
+@brief		Creates a source kept in a dictionary of a kind, recording the
+			kind in its schema file so it is opened as one again.
+@details	@ref iinq_create_source creates a B+ tree. A schema file from
+			before kinds were recorded is opened as a B+ tree.
+@param		schema_file_name
+				The schema file of the source.
+@param		engine
+				The kind of dictionary it is kept in.
+@param		key_type
+				The type of its keys.
+@param		key_size
+				The bytes of each key.
+@param		value_size
+				The bytes of each value.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_create_source_on(
+	char				*schema_file_name,
+	ion_iinq_engine_t	engine,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size
+);
+
+/**
+@brief		Whether a source, open by @ref iinq_acquire_source, reads its
+			records in key order.
+@param		dictionary
+				The dictionary of the source.
+@returns	@c boolean_true for a B+ tree or sorted flat file.
+*/
+ion_boolean_t
+iinq_source_is_ordered(
+	ion_dictionary_t *dictionary
+);
+
 ion_err_t
 iinq_open_source(
 	char					*schema_file_name,
@@ -68,6 +148,61 @@ iinq_open_source(
 	ion_dictionary_handler_t	*handler
 );
 
+/**
+@brief		Gets a source for a statement, opening it only if it is not
+			already kept open.
+@details	The master table is left open while any source is, and the
+			source stays open once released until it is evicted or closed.
+			Changes to a source are only certain to reach its files once it
+			is closed, so @ref iinq_close_all_sources should be called before
+			exiting.
+@param		schema_file_name
+				The schema file of the source.
+@param		dictionary
+				Set to the open dictionary of the source.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_acquire_source(
+	char				*schema_file_name,
+	ion_dictionary_t	**dictionary
+);
+
+/**
+@brief		Ends the use of a source by a statement, closing the least
+			recently used source if more than @ref IINQ_SOURCE_CACHE_SIZE are
+			then unused.
+@param		dictionary
+				The dictionary of the source, or a copy of it.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_release_source(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Closes a source kept open, if it is.
+@param		schema_file_name
+				The schema file of the source.
+@returns	An error code describing the result of the call, being
+			@ref err_illegal_state if a statement is using it.
+*/
+ion_err_t
+iinq_close_source(
+	char *schema_file_name
+);
+
+/**
+@brief		Closes every source kept open, and then the master table.
+@returns	An error code describing the result of the call, being
+			@ref err_illegal_state if a statement is using a source.
+*/
+ion_err_t
+iinq_close_all_sources(
+	void
+);
+
 ion_status_t
 iinq_insert(
 	char 		*schema_file_name,
@@ -93,14 +228,962 @@ iinq_drop(
 	char *schema_file_name
 );
 
-#define CREATE_DICTIONARY(schema_name, key_type, key_size, value_size) \
+/**
+@brief		The most sources a prepared query joins, as many as @c FROM
+			takes.
+*/
+#define IINQ_PREPARED_MAX_SOURCES	8
+
+/**
+@brief		The most bytes of records a prepared query joined on equal
+			fields holds in memory at once. A source with more is taken a
+			part of this size at a time, the other source being read once
+			for each part.
+*/
+#if !defined(IINQ_HASH_JOIN_BYTES)
+#if defined(ARDUINO)
+#define IINQ_HASH_JOIN_BYTES	1024
+#else
+#define IINQ_HASH_JOIN_BYTES	(1024 * 1024)
+#endif
+#endif
+
+/**
+@brief		Bytes of the record of a source, which a join compares.
+*/
+typedef struct {
+	ion_boolean_t			in_value;	/**< Whether they are of the value, else
+										 of the key */
+	ion_value_size_t		offset;		/**< Where they start */
+	ion_value_size_t		size;		/**< How many there are */
+} ion_iinq_field_t;
+
+/**
+@brief		The most fields a prepared query selects.
+*/
+#define IINQ_PREPARED_MAX_FIELDS	8
+
+/**
+@brief		How many results a prepared query run in batches passes to its
+			processor at once.
+*/
+#if !defined(IINQ_BATCH_ROWS)
+#if defined(ARDUINO)
+#define IINQ_BATCH_ROWS	4
+#else
+#define IINQ_BATCH_ROWS	64
+#endif
+#endif
+
+/**
+@brief		A field of a source that a prepared query selects.
+*/
+typedef struct {
+	int					source;	/**< The index of the source */
+	ion_iinq_field_t	field;	/**< The bytes of its record */
+} ion_iinq_projection_t;
+
+/**
+@brief		Results passed to a processor together, one after another.
+*/
+typedef struct {
+	int						count;		/**< The results */
+	ion_iinq_result_size_t	num_bytes;	/**< The bytes of each */
+	unsigned char			*data;		/**< The first, each of the rest
+										 following the one before */
+} ion_iinq_batch_t;
+
+/**
+@brief		Function pointer type for processing the results of a query
+			a batch at a time.
+*/
+typedef void (*ion_iinq_batch_processor_func_t)(ion_iinq_batch_t *batch, void *state);
+
+typedef struct {
+	ion_iinq_batch_processor_func_t execute;
+	void							*state;
+} ion_iinq_batch_processor_t;
+
+#define IINQ_BATCH_PROCESSOR(execute, state)	((ion_iinq_batch_processor_t){ execute, state })
+
+/**
+@brief		The most bytes of results a query ordering them holds in memory
+			to sort at once. A query with more sorts them a part of this
+			size at a time into runs in files, then merges the runs.
+*/
+#if !defined(IINQ_SORT_BYTES)
+#if defined(ARDUINO)
+#define IINQ_SORT_BYTES	512
+#else
+#define IINQ_SORT_BYTES	(256 * 1024)
+#endif
+#endif
+
+/**
+@brief		The most fields results are ordered by.
+*/
+#define IINQ_MAX_ORDERS	4
+
+/**
+@brief		Bytes of each result that results are ordered by, the first of
+			several deciding and the rest breaking ties.
+*/
+typedef struct {
+	ion_iinq_result_size_t	offset;		/**< Where they start in a result */
+	ion_iinq_result_size_t	size;		/**< How many there are */
+	ion_key_type_t			type;		/**< How they compare, as keys of the
+										 type do */
+	ion_boolean_t			descending;	/**< Whether the greatest come first */
+} ion_iinq_order_t;
+
+/**
+@brief		Results sorted into a file, waiting to be merged.
+*/
+typedef struct {
+	ion_file_handle_t	file;	/**< The file */
+	int					id;		/**< The number it is named by */
+	long				rows;	/**< The results in it not yet merged */
+	ion_file_offset_t	at;		/**< Where the next is */
+} ion_iinq_sort_run_t;
+
+/**
+@brief		The results of a query on their way to its processor, put in
+			order and cut short at a limit.
+@details	Without an order, each result is passed on as it comes. With
+			an order and a limit whose results fit in
+			@ref IINQ_SORT_BYTES, the least are kept in a bounded heap.
+			Otherwise results are sorted in memory, spilling sorted runs
+			to files as it fills, and the runs are merged at the end.
+*/
+typedef struct {
+	ion_iinq_order_t			*order;								/**< What results are
+																	 ordered by */
+	ion_dictionary_compare_t	compare[IINQ_MAX_ORDERS];			/**< How each part of
+																	 the order compares */
+	int							order_count;						/**< How many parts it
+																	 has, 0 for none */
+	long						limit;								/**< The most results
+																	 passed on, -1 for
+																	 all */
+	long						passed;								/**< The results
+																	 passed on */
+	ion_iinq_query_processor_t	*processor;							/**< What they are
+																	 passed to */
+	ion_err_t					error;								/**< The first error
+																	 met */
+	ion_iinq_result_size_t		num_bytes;							/**< The bytes of each
+																	 result */
+	unsigned char				*rows;								/**< The results held,
+																	 then room for one
+																	 more */
+	int							count;								/**< How many */
+	int							capacity;							/**< How many fit */
+	ion_boolean_t				top;								/**< Whether they are
+																	 the least so far,
+																	 as a heap */
+	ion_iinq_sort_run_t			*runs;								/**< The runs in
+																	 files */
+	int							run_count;							/**< How many */
+} ion_iinq_sort_t;
+
+/**
+@brief		Begins taking the results of a query to order them.
+@param		sort
+				The sort to begin.
+@param		order
+				What results are ordered by, which must last until the sort
+				ends.
+@param		count
+				How many parts it has, up to @ref IINQ_MAX_ORDERS, or 0 to
+				pass results on as they come.
+@param		limit
+				The most results passed on, or -1 for all.
+@param		processor
+				What the results are passed to.
+*/
+void
+iinq_sort_begin(
+	ion_iinq_sort_t				*sort,
+	ion_iinq_order_t			*order,
+	int							count,
+	long						limit,
+	ion_iinq_query_processor_t	*processor
+);
+
+/**
+@brief		Takes a result of a query.
+@param		sort
+				A sort begun by @ref iinq_sort_begin.
+@param		result
+				The result, copied if it is kept.
+@returns	Whether more results are wanted, being @c boolean_false once
+			the limit is passed on or on an error.
+*/
+ion_boolean_t
+iinq_sort_add(
+	ion_iinq_sort_t		*sort,
+	ion_iinq_result_t	*result
+);
+
+/**
+@brief		Passes the results held on in order, and releases the memory
+			and files of a sort.
+@param		sort
+				A sort begun by @ref iinq_sort_begin.
+@param		error
+				How the query went. Nothing more is passed on unless it is
+				@c err_ok.
+@returns	@p error, or else the first error the sort met.
+*/
+ion_err_t
+iinq_sort_end(
+	ion_iinq_sort_t *sort,
+	ion_err_t		error
+);
+
+/**
+@brief		Whether results laid out with the key of a source first, read
+			from it in the order it gives records, are ordered already.
+@details	A source that gives records in key order, see
+			@ref iinq_source_is_ordered, needs no sort for an order of its
+			key alone.
+@param		dictionary
+				The source.
+@param		order
+				What results are ordered by.
+@param		count
+				How many parts it has.
+@returns	@c boolean_true if the order is the key, ascending.
+*/
+ion_boolean_t
+iinq_order_follows_key(
+	ion_dictionary_t	*dictionary,
+	ion_iinq_order_t	*order,
+	int					count
+);
+
+/**
+@brief		The most aggregates results are grouped with.
+*/
+#define IINQ_MAX_AGGREGATES	8
+
+/**
+@brief		What an aggregate makes of the results of a group.
+*/
+typedef enum ION_IINQ_AGGREGATE_TYPE {
+	aggregate_count,/**< How many there are */
+	aggregate_sum,	/**< The sum of an integer of each */
+	aggregate_min,	/**< The least */
+	aggregate_max,	/**< The greatest */
+	aggregate_avg	/**< The mean, as a @c double */
+} ion_iinq_aggregate_type_t;
+
+/**
+@brief		An aggregate of the results of each group, by an integer of
+			each result.
+*/
+typedef struct {
+	ion_iinq_aggregate_type_t	type;	/**< What it makes of them */
+	ion_iinq_result_size_t		offset;	/**< Where the integer starts in
+										 a result, unused by a count */
+	ion_iinq_result_size_t		size;	/**< Its bytes, 1, 2, 4 or 8 */
+	ion_key_type_t				sign;	/**< Whether it is
+										 @c key_type_numeric_signed or
+										 @c key_type_numeric_unsigned */
+} ion_iinq_aggregate_t;
+
+/**
+@brief		The results of a query gathered into groups of equal bytes,
+			each passed on as one result of its aggregates.
+@details	A grouped result holds each aggregate as an @c int64_t, or a
+			@c double for a mean, one after another, and then the bytes
+			the group is of. Groups are kept in a hash table until the last
+			result is taken, unless results come in order of the bytes, in
+			which case each group is passed on as soon as the next begins.
+*/
+typedef struct {
+	ion_iinq_result_size_t	offset;								/**< Where the bytes the
+																 group is of start in a
+																 result */
+	ion_iinq_result_size_t	size;								/**< How many there are */
+	ion_iinq_aggregate_t	*aggregates;						/**< The aggregates */
+	int						aggregate_count;					/**< How many */
+	ion_boolean_t			streaming;							/**< Whether results come
+																 in order of the group */
+	ion_err_t				error;								/**< The first error met */
+	ion_iinq_result_size_t	num_bytes;							/**< The bytes of each
+																 grouped result */
+	size_t					stride;								/**< The bytes of each
+																 group held */
+	unsigned char			*groups;							/**< The groups held */
+	int						count;								/**< How many */
+	int						capacity;							/**< How many fit */
+	int						*buckets;							/**< The first group of
+																 each bucket, -1 if none */
+	int						bucket_count;						/**< How many, a power
+																 of 2 */
+	int						next;								/**< The next group to be
+																 passed on */
+} ion_iinq_group_t;
+
+/**
+@brief		Begins gathering results of a query into groups.
+@param		group
+				The groups to begin.
+@param		offset
+				Where the bytes each group is of start in a result.
+@param		size
+				How many there are.
+@param		aggregates
+				The aggregates of each group, which must last until the
+				groups end.
+@param		count
+				How many, up to @ref IINQ_MAX_AGGREGATES.
+@param		streaming
+				Whether results come in order of the bytes, so that each
+				group is done when the next begins.
+*/
+void
+iinq_group_begin(
+	ion_iinq_group_t		*group,
+	ion_iinq_result_size_t	offset,
+	ion_iinq_result_size_t	size,
+	ion_iinq_aggregate_t	*aggregates,
+	int						count,
+	ion_boolean_t			streaming
+);
+
+/**
+@brief		Takes a result of a query into its group.
+@param		group
+				Groups begun by @ref iinq_group_begin.
+@param		result
+				The result.
+@returns	An error code describing the result of the call, being
+			@c err_invalid_predicate if the group or an aggregate does not
+			fit in the result.
+*/
+ion_err_t
+iinq_group_add(
+	ion_iinq_group_t	*group,
+	ion_iinq_result_t	*result
+);
+
+/**
+@brief		Gets the next group that is done.
+@param		group
+				Groups begun by @ref iinq_group_begin.
+@param		grouped
+				Set to the grouped result, valid until the next result is
+				taken or the groups end.
+@param		all
+				Whether every result has been taken, so every group is done.
+@returns	Whether there was a group done.
+*/
+ion_boolean_t
+iinq_group_next(
+	ion_iinq_group_t	*group,
+	ion_iinq_result_t	*grouped,
+	ion_boolean_t		all
+);
+
+/**
+@brief		Releases the memory of groups.
+@param		group
+				Groups begun by @ref iinq_group_begin.
+@returns	The first error the groups met.
+*/
+ion_err_t
+iinq_group_end(
+	ion_iinq_group_t *group
+);
+
+/**
+@brief		Function pointer type for the condition of a grouped prepared
+			query, reading the aggregates of each grouped result.
+*/
+typedef ion_boolean_t (*ion_iinq_having_func_t)(ion_iinq_result_t *grouped, void *state);
+
+/**
+@brief		How a prepared query reads a source.
+*/
+typedef enum ION_IINQ_ACCESS {
+	iinq_access_scan,	/**< Every record, in the order it is kept */
+	iinq_access_seek,	/**< Only the records with a key, sought */
+	iinq_access_range	/**< Only the records with keys in a range */
+} ion_iinq_access_t;
+
+/**
+@brief		How a prepared query joins its first two sources.
+*/
+typedef enum ION_IINQ_JOIN {
+	iinq_join_none,			/**< It has one source */
+	iinq_join_nested_loop,	/**< Every record of one to every record
+							 of the other */
+	iinq_join_hash,			/**< On equal fields, through a hash table
+							 of one */
+	iinq_join_merge			/**< On equal keys, both read in order */
+} ion_iinq_join_t;
+
+/**
+@brief		How a prepared query groups its results.
+*/
+typedef enum ION_IINQ_GROUPING {
+	iinq_grouping_none,		/**< It does not */
+	iinq_grouping_hash,		/**< In a hash table of every group */
+	iinq_grouping_streaming	/**< One group at a time, the results coming
+							 in the order of the bytes grouped by */
+} ion_iinq_grouping_t;
+
+/**
+@brief		How a prepared query orders its results.
+*/
+typedef enum ION_IINQ_SORTING {
+	iinq_sorting_none,		/**< It does not */
+	iinq_sorting_by_key,	/**< They come in the order of a key, and
+							 are passed on as they are */
+	iinq_sorting_top,		/**< The first of them, as many as are
+							 limited to, kept in a heap */
+	iinq_sorting_full		/**< All of them, spilled in sorted runs to
+							 files past @ref IINQ_SORT_BYTES */
+} ion_iinq_sorting_t;
+
+/**
+@brief		The plan a prepared query is run by, as it would next be run.
+*/
+typedef struct {
+	int					source_count;							/**< The sources read */
+	ion_iinq_engine_t	engines[IINQ_PREPARED_MAX_SOURCES];		/**< The kind of each */
+	ion_iinq_access_t	access[IINQ_PREPARED_MAX_SOURCES];		/**< How each is read */
+	ion_value_size_t	value_offset[IINQ_PREPARED_MAX_SOURCES];	/**< The first byte
+																 of each value of
+																 each read */
+	ion_value_size_t	value_size[IINQ_PREPARED_MAX_SOURCES];	/**< How many from
+																 there */
+	ion_iinq_join_t		join;									/**< How the first two
+																 are joined */
+	ion_boolean_t		filtered;								/**< Whether each
+																 combination meets a
+																 condition */
+	ion_iinq_grouping_t	grouping;								/**< How results are
+																 grouped */
+	ion_boolean_t		having;									/**< Whether the groups
+																 meet a condition */
+	ion_iinq_sorting_t	sorting;								/**< How results are
+																 ordered */
+	long				limit;									/**< The most results,
+																 -1 for all */
+} ion_iinq_plan_t;
+
+/**
+@brief		What one operator of a prepared query did over the runs
+			profiled.
+@details	The file counters are those of @ref ion_file_io_stats, taken
+			by the files of a source's dictionary for the source and by
+			the runs spilled for the sort.
+*/
+typedef struct {
+	unsigned long	rows_in;		/**< Rows taken in */
+	unsigned long	rows_out;		/**< Rows passed on */
+	unsigned long	nexts;			/**< Calls to the next of a cursor */
+	unsigned long	reads;			/**< Reads of files */
+	unsigned long	read_bytes;		/**< The bytes they read */
+	unsigned long	writes;			/**< Writes to files */
+	unsigned long	write_bytes;	/**< The bytes they wrote */
+	unsigned long	io_micros;		/**< Microseconds the files took */
+} ion_iinq_operator_profile_t;
+
+/**
+@brief		What each operator of a prepared query did over the runs
+			profiled.
+*/
+typedef struct {
+	unsigned long				runs;								/**< The runs profiled */
+	unsigned long				micros;								/**< Microseconds they
+																	 took */
+	ion_iinq_operator_profile_t	sources[IINQ_PREPARED_MAX_SOURCES];	/**< Reading each
+																	 source, rows out being
+																	 its records read */
+	ion_iinq_operator_profile_t	where;								/**< Combinations of
+																	 records, in, and those
+																	 meeting the condition */
+	ion_iinq_operator_profile_t	group;								/**< Results grouped, in,
+																	 and the groups meeting
+																	 the condition */
+	ion_iinq_operator_profile_t	sort;								/**< Results ordered and
+																	 limited, in, and those
+																	 passed to the processor */
+	ion_iinq_operator_profile_t	other;								/**< File counters of no
+																	 operator */
+} ion_iinq_profile_t;
+
+typedef struct iinq_prepared ion_iinq_prepared_t;
+
+/**
+@brief		Function pointer type for the condition of a prepared query,
+			reading the record of each source from @c sources of @p query.
+*/
+typedef ion_boolean_t (*ion_iinq_where_func_t)(ion_iinq_prepared_t *query, void *state);
+
+/**
+@brief		A query kept ready to be executed again and again, holding its
+			sources open, with its predicates built and its buffers taken.
+*/
+struct iinq_prepared {
+	int						source_count;						/**< The sources joined */
+	ion_iinq_source_t		sources[IINQ_PREPARED_MAX_SOURCES];	/**< Each with the record
+																 it is at */
+	ion_iinq_where_func_t	where;								/**< The condition, or NULL
+																 for every record */
+	void					*where_state;						/**< Passed to @c where */
+	ion_iinq_result_t		result;								/**< The records selected, as
+																 @c SELECT_ALL lays them out,
+																 or the fields selected */
+	ion_iinq_projection_t	fields[IINQ_PREPARED_MAX_FIELDS];	/**< The fields selected */
+	int						field_count;						/**< How many, 0 for every
+																 record whole */
+	ion_iinq_projection_t	where_reads[IINQ_PREPARED_MAX_FIELDS];	/**< The fields of
+																 values the condition
+																 reads */
+	int						where_read_count;					/**< How many, -1 for
+																 every value whole */
+	ion_iinq_result_size_t	row_capacity;						/**< The bytes of the result
+																 of every record whole */
+	unsigned char			*batch;								/**< The results of a run in
+																 batches */
+	size_t					batch_capacity;						/**< The bytes taken for
+																 @c batch */
+	ion_iinq_order_t		order[IINQ_MAX_ORDERS];				/**< What results are
+																 ordered by */
+	int						order_count;						/**< How many parts it
+																 has, 0 for none */
+	long					limit;								/**< The most results,
+																 -1 for all */
+	ion_iinq_sort_t			sort;								/**< The results of a
+																 run on their way */
+	ion_boolean_t			stopped;							/**< Whether the run has
+																 all it wants */
+	ion_iinq_aggregate_t	aggregates[IINQ_MAX_AGGREGATES];	/**< The aggregates of
+																 each group */
+	int						aggregate_count;					/**< How many, 0 for
+																 results not grouped */
+	ion_iinq_result_size_t	group_offset;						/**< Where the bytes each
+																 group is of start */
+	ion_iinq_result_size_t	group_size;							/**< How many there are */
+	ion_iinq_having_func_t	having;								/**< The condition of
+																 groups, or NULL for all */
+	void					*having_state;						/**< Passed to @c having */
+	ion_iinq_group_t		group;								/**< The groups of a run */
+	unsigned char			*buffers;							/**< The keys and values of the
+																 sources */
+	ion_boolean_t			joined;								/**< Whether the first two
+																 sources are joined on
+																 @c on */
+	ion_iinq_field_t		on[2];								/**< The field of each that
+																 must be equal */
+	ion_boolean_t			merged;								/**< Whether @c on is the key
+																 of both, read in order
+																 and merged, else hashed */
+	unsigned char			*merge_held;						/**< The key being merged and
+																 the record of the second
+																 source held past it */
+	unsigned char			*join_records;						/**< The records of the source
+																 hashed, each after the
+																 index of the next in its
+																 bucket */
+	int						*join_buckets;						/**< The first record of each
+																 bucket, -1 if none */
+	size_t					join_capacity;						/**< The bytes taken for
+																 @c join_records */
+	int						join_bucket_count;					/**< The buckets taken */
+	ion_iinq_profile_t		*profile;							/**< Where runs are
+																 profiled, or NULL */
+	unsigned long			profile_every;						/**< One run of how many
+																 is profiled */
+	unsigned long			profile_count;						/**< The runs since the
+																 last profiled */
+	ion_boolean_t			profiling;							/**< Whether this run is */
+	ion_iinq_query_processor_t	*delivered;						/**< The processor of a
+																 run profiled */
+	ion_file_io_stats_t		*profile_files;						/**< The file counters
+																 as the run began */
+	int						profile_file_count;					/**< How many */
+};
+
+/**
+@brief		Prepares a query selecting all of the records of its sources
+			joined one to another, as @c QUERY with @c SELECT_ALL does.
+@details	The sources are held open, so they are not closed by
+			@ref iinq_close_all_sources or dropped until the query is
+			finished.
+@param		query
+				The query to prepare.
+@param		schema_file_names
+				The schema files of its sources, the first the outermost
+				of the join.
+@param		count
+				How many there are, 1 to @ref IINQ_PREPARED_MAX_SOURCES.
+@param		where
+				The condition records must meet, or NULL for all.
+@param		where_state
+				Passed to @p where.
+@returns	An error code describing the result of the call. The query is
+			left holding nothing unless it is @c err_ok.
+*/
+ion_err_t
+iinq_prepare(
+	ion_iinq_prepared_t		*query,
+	char					**schema_file_names,
+	int						count,
+	ion_iinq_where_func_t	where,
+	void					*where_state
+);
+
+/**
+@brief		Joins the first two sources of a prepared query on a field of
+			each being equal, rather than every record of one to every
+			record of the other.
+@details	Where the fields are the whole keys of two ordered sources of
+			one key type, each run reads both in order of their keys at
+			once, merging them, so both are read once in constant memory
+			and only a key the first source repeats seeks its equals in
+			the second again. Otherwise each run reads the records of the
+			smaller source into a hash table, as far as
+			@ref IINQ_HASH_JOIN_BYTES allows, and reads the other once to
+			probe it, so both are read once where the table holds the
+			smaller whole. The results are the same
+			as those of a @c where comparing the fields, though they may
+			come in another order. Any sources after the first two are
+			joined to each pair as before.
+@param		query
+				A query prepared by @ref iinq_prepare with at least two
+				sources.
+@param		fields
+				The field of the first source and the one of the second,
+				of the same size.
+@returns	An error code describing the result of the call, being
+			@c err_invalid_predicate if the fields do not fit their
+			records or differ in size, or @c err_out_of_memory if a
+			merge cannot take the bytes it holds.
+*/
+ion_err_t
+iinq_join_on(
+	ion_iinq_prepared_t		*query,
+	const ion_iinq_field_t	fields[2]
+);
+
+/**
+@brief		Has a source of a prepared query read only the records with a
+			key, by an equality predicate, rather than all of them.
+@details	An ordered source then seeks to the key rather than reading
+			through every record for a @c where to pass over. The key is
+			copied, so it need not outlive the call.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		source
+				The index of the source among those it was prepared with.
+@param		key
+				The key.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_where_key_equals(
+	ion_iinq_prepared_t *query,
+	int					source,
+	ion_key_t			key
+);
+
+/**
+@brief		Has a source of a prepared query read only the records with
+			keys from @p lower to @p upper, by a range predicate.
+@details	See @ref iinq_where_key_equals.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		source
+				The index of the source among those it was prepared with.
+@param		lower
+				The least key read.
+@param		upper
+				The greatest key read.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_where_key_range(
+	ion_iinq_prepared_t *query,
+	int					source,
+	ion_key_t			lower,
+	ion_key_t			upper
+);
+
+/**
+@brief		Runs a prepared query, passing each result to @p processor.
+@details	The records are read as they are now, changes made since the
+			query was prepared or last run among them.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		processor
+				What is done with each result.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_execute(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_query_processor_t	*processor
+);
+
+/**
+@brief		Tells the fields of the values of its sources that the
+			condition of a prepared query reads, so the other bytes of
+			its values need not be read when it selects fields.
+@details	Keys are always read whole. A condition reading bytes it has
+			not told of reads what a cursor left in them.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		fields
+				The fields, up to @ref IINQ_PREPARED_MAX_FIELDS.
+@param		count
+				How many there are, or -1 for the condition reading every
+				value whole, as it is taken to until this is called.
+@returns	An error code describing the result of the call, being
+			@c err_invalid_predicate if a field does not fit its record.
+*/
+ion_err_t
+iinq_where_reads(
+	ion_iinq_prepared_t			*query,
+	const ion_iinq_projection_t *fields,
+	int							count
+);
+
+/**
+@brief		Has a prepared query pass only some fields of the records of its
+			sources, one after another, rather than every record whole.
+@details	Only the fields are copied for each result, so a processor
+			reading few of many bytes is not made to wait on the rest.
+			The cursor of each source is also had to read only the bytes
+			of its value from the first field of it to the last, those of
+			a join and those a condition reads among them, so a B+ tree
+			does not fetch the others from its file. A query with a
+			condition reads every value whole unless
+			@ref iinq_where_reads tells what the condition reads.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		fields
+				The fields, in the order they are laid out in each result.
+@param		count
+				How many there are, up to @ref IINQ_PREPARED_MAX_FIELDS, or
+				0 to select every record whole again.
+@returns	An error code describing the result of the call, being
+			@c err_invalid_predicate if a field does not fit its record or
+			the fields have more bytes than every record whole.
+*/
+ion_err_t
+iinq_select(
+	ion_iinq_prepared_t			*query,
+	const ion_iinq_projection_t *fields,
+	int							count
+);
+
+/**
+@brief		Has a prepared query gather its results into groups of equal
+			bytes, passing one result of aggregates for each group.
+@details	A query of one source grouped by its key gathers each group as
+			it is read rather than hashing them all, see
+			@ref ion_iinq_group_t. Orders then refer to grouped results.
+@param		query
+				A query prepared by @ref iinq_prepare, with the fields it
+				selects set.
+@param		offset
+				Where the bytes each group is of start in a result.
+@param		size
+				How many there are.
+@param		aggregates
+				The aggregates of each group; they are copied.
+@param		count
+				How many, up to @ref IINQ_MAX_AGGREGATES, or 0 for results
+				not grouped.
+@returns	An error code describing the result of the call, being
+			@c err_invalid_predicate if the group or an aggregate does not
+			fit in a result.
+*/
+ion_err_t
+iinq_group_by(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_result_size_t		offset,
+	ion_iinq_result_size_t		size,
+	const ion_iinq_aggregate_t	*aggregates,
+	int							count
+);
+
+/**
+@brief		Has a grouped prepared query pass only the groups meeting a
+			condition.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		having
+				The condition, or NULL for all groups.
+@param		having_state
+				Passed to @p having.
+*/
+void
+iinq_having(
+	ion_iinq_prepared_t		*query,
+	ion_iinq_having_func_t	having,
+	void					*having_state
+);
+
+/**
+@brief		Has a prepared query pass its results in an order.
+@details	A query of one source ordered by its key alone is read in
+			that order rather than sorted, see @ref iinq_order_follows_key.
+@param		query
+				A query prepared by @ref iinq_prepare, with the fields it
+				selects set.
+@param		order
+				What results are ordered by, as they are laid out; it is
+				copied.
+@param		count
+				How many parts it has, up to @ref IINQ_MAX_ORDERS, or 0 for
+				results in the order they are found.
+@returns	An error code describing the result of the call, being
+			@c err_invalid_predicate if a part does not fit in a result.
+*/
+ion_err_t
+iinq_order_by(
+	ion_iinq_prepared_t		*query,
+	const ion_iinq_order_t	*order,
+	int						count
+);
+
+/**
+@brief		Has a prepared query pass at most @p limit results.
+@details	Unless its results must be sorted, a run stops reading its
+			sources once it has them.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		limit
+				The most results, or -1 for all.
+*/
+void
+iinq_limit(
+	ion_iinq_prepared_t *query,
+	long				limit
+);
+
+/**
+@brief		Runs a prepared query, passing its results to @p processor
+			@ref IINQ_BATCH_ROWS at a time.
+@details	The results are laid out in a buffer the query keeps from one
+			run to the next, each as it would be passed by
+			@ref iinq_execute, so a processor is called once for many. The
+			batch is only valid until the processor returns.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		processor
+				What is done with each batch.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_execute_batched(
+	ion_iinq_prepared_t			*query,
+	ion_iinq_batch_processor_t	*processor
+);
+
+/**
+@brief		Tells the plan a prepared query would next be run by.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		plan
+				Receives the plan.
+*/
+void
+iinq_explain(
+	ion_iinq_prepared_t *query,
+	ion_iinq_plan_t		*plan
+);
+
+/**
+@brief		Writes the plan a prepared query would next be run by to
+			@c stdout, one line an operator, from the processor down to
+			the sources.
+*/
+void
+iinq_explain_print(
+	ion_iinq_prepared_t *query
+);
+
+/**
+@brief		Has the runs of a prepared query profiled, one of every
+			@p every, into @p profile.
+@details	A run not profiled counts nothing, and a run profiled only
+			adds to counters, reading the clock and the file counters
+			once as it begins and once as it ends, so a query may be left
+			profiled one run of many. The counters are added to, and are
+			not set to zero here.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@param		profile
+				Where the runs add to, which must outlive the query's
+				profiling, or NULL to profile no more.
+@param		every
+				One run of how many is profiled, 1 for every run.
+@returns	An error code describing the result of the call, being
+			@c err_out_of_memory if the file counters cannot be held.
+*/
+ion_err_t
+iinq_profile(
+	ion_iinq_prepared_t *query,
+	ion_iinq_profile_t	*profile,
+	unsigned long		every
+);
+
+/**
+@brief		Sets every counter of a profile to zero.
+*/
+void
+iinq_profile_reset(
+	ion_iinq_profile_t *profile
+);
+
+/**
+@brief		Writes a profile of a prepared query to @c stdout, one line an
+			operator.
+*/
+void
+iinq_profile_print(
+	ion_iinq_prepared_t *query,
+	ion_iinq_profile_t	*profile
+);
+
+/**
+@brief		Finishes with a prepared query, releasing its sources.
+@param		query
+				A query prepared by @ref iinq_prepare.
+@returns	An error code describing the result of the call.
+*/
+ion_err_t
+iinq_finish(
+	ion_iinq_prepared_t *query
+);
+
+#define _CREATE_DICTIONARY_4(schema_name, key_type, key_size, value_size) \
 iinq_create_source(#schema_name ".inq", key_type, key_size, value_size)
 
+#define _CREATE_DICTIONARY_5(schema_name, key_type, key_size, value_size, engine) \
+iinq_create_source_on(#schema_name ".inq", engine, key_type, key_size, value_size)
+
+#define _CREATE_DICTIONARY_GET_OVERRIDE(_1, _2, _3, _4, _5, MACRO, ...) MACRO
+
+/*
+ * The engine, one of ion_iinq_engine_t, may be given last, a B+ tree being kept otherwise.
+ */
+#define CREATE_DICTIONARY(...) \
+_CREATE_DICTIONARY_GET_OVERRIDE(__VA_ARGS__, _CREATE_DICTIONARY_5, _CREATE_DICTIONARY_4, THEBLACKWHOLE)(__VA_ARGS__)
+
 #define INSERT(schema_name, key, value) \
 iinq_insert(#schema_name ".inq", key, value)
 
 #define UPDATE(schema_name, key, value) \
-iinq_insert(#schema_name ".inq", key, value)
+iinq_update(#schema_name ".inq", key, value)
 
 #define DELETE_FROM(schema_name, key) \
 iinq_delete(#schema_name ".inq", key)
@@ -119,7 +1202,7 @@ while (NULL != copyer) { \
 	copyer						= copyer->next; \
 }
 
-#define _FROM_SOURCE_SINGLE(source) \
+#define _FROM_SOURCE_WITH(source, ...) \
 	ion_iinq_source_t source; \
 	source.cleanup.next			= NULL; \
 	source.cleanup.last			= last; \
@@ -133,22 +1216,25 @@ while (NULL != copyer) { \
 	last						= &source.cleanup; \
 	source.cleanup.next			= NULL; \
 	source.dictionary.handler	= &source.handler; \
-	error						= iinq_open_source(#source ".inq", &(source.dictionary), &(source.handler)); \
+	error						= iinq_acquire_source(#source ".inq", &(source.cached)); \
 	if (err_ok != error) { \
 		break; \
 	} \
+	source.dictionary			= *source.cached; \
 	source.key					= alloca(source.dictionary.instance->record.key_size); \
 	source.value				= alloca(source.dictionary.instance->record.value_size); \
 	source.ion_record.key		= source.key; \
 	source.ion_record.value		= source.value; \
 	result.num_bytes			+= source.dictionary.instance->record.key_size; \
 	result.num_bytes			+= source.dictionary.instance->record.value_size; \
-	error						= dictionary_build_predicate(&(source.predicate), predicate_all_records); \
+	error						= dictionary_build_predicate(&(source.predicate), __VA_ARGS__); \
 	if (err_ok != error) { \
 		break; \
 	} \
 	dictionary_find(&source.dictionary, &source.predicate, &source.cursor);
 
+#define _FROM_SOURCE_SINGLE(source) _FROM_SOURCE_WITH(source, predicate_all_records)
+
 #define _FROM_CHECK_CURSOR_SINGLE(source) \
 	(cs_cursor_active == (source.cursor_status = source.cursor->next(source.cursor, &source.ion_record)) || cs_cursor_initialized == source.cursor_status)
 
@@ -197,7 +1283,7 @@ while (NULL != copyer) { \
 #define _FROM_CHECK_CURSOR(sources) \
 	_FROM_CHECK_CURSOR_SINGLE(sources)
 
-#define FROM(...) \
+#define _FROM_BEGIN \
 	ion_iinq_cleanup_t	*first; \
 	ion_iinq_cleanup_t	*last; \
 	ion_iinq_cleanup_t	*ref_cursor; \
@@ -205,8 +1291,29 @@ while (NULL != copyer) { \
 	first		= NULL; \
 	last		= NULL; \
 	ref_cursor	= NULL; \
-	last_cursor	= NULL; \
+	last_cursor	= NULL;
+
+#define FROM(...) \
+	_FROM_BEGIN \
 	_FROM_SOURCES(__VA_ARGS__) \
+	_FROM_END
+
+/*
+ * A single source read only where its key is key, or from lower to upper, so an ordered source seeks
+ * rather than passing every record to WHERE. The keys must last the query, as IONIZE does within it. WHERE still
+ * tests each record found.
+ */
+#define FROM_KEY_EQUALS(source, key) \
+	_FROM_BEGIN \
+	_FROM_SOURCE_WITH(source, predicate_equality, (ion_key_t) (key)) \
+	_FROM_END
+
+#define FROM_KEY_RANGE(source, lower, upper) \
+	_FROM_BEGIN \
+	_FROM_SOURCE_WITH(source, predicate_range, (ion_key_t) (lower), (ion_key_t) (upper)) \
+	_FROM_END
+
+#define _FROM_END \
 	result.data	= alloca(result.num_bytes); \
 	ref_cursor	= first; \
 	/* Initialize all cursors except the last one. */ \
@@ -225,24 +1332,159 @@ while (NULL != copyer) { \
 
 #define WHERE(condition) (condition)
 
+/*
+ * Parts of an order of results, by the bytes of each from offset, compared as keys of type are.
+ */
+#define ASCENDING(offset, size, type) { (offset), (size), (type), boolean_false }
+#define DESCENDING(offset, size, type) { (offset), (size), (type), boolean_true }
+
+#define ORDER_BY(...) \
+	iinq_order			= (ion_iinq_order_t[]) { __VA_ARGS__ }; \
+	iinq_order_count	= sizeof((ion_iinq_order_t[]) { __VA_ARGS__ }) / sizeof(ion_iinq_order_t);
+
+#define LIMIT(count) \
+	iinq_limit = (count);
+
+/*
+ * Aggregates of the results of each group, by an integer of each from offset, of size bytes, of a signed or
+ * unsigned numeric type.
+ */
+#define COUNT_ALL { aggregate_count, 0, 0, key_type_numeric_signed }
+#define SUM_OF(offset, size, type) { aggregate_sum, (offset), (size), (type) }
+#define MIN_OF(offset, size, type) { aggregate_min, (offset), (size), (type) }
+#define MAX_OF(offset, size, type) { aggregate_max, (offset), (size), (type) }
+#define AVG_OF(offset, size, type) { aggregate_avg, (offset), (size), (type) }
+
+/*
+ * The results grouped by the bytes of each from offset, each group passed on as one result of its aggregates.
+ */
+#define GROUP_BY(offset, size, ...) \
+	iinq_group_offset		= (offset); \
+	iinq_group_size			= (size); \
+	iinq_aggregates			= (ion_iinq_aggregate_t[]) { __VA_ARGS__ }; \
+	iinq_aggregates_count	= sizeof((ion_iinq_aggregate_t[]) { __VA_ARGS__ }) / sizeof(ion_iinq_aggregate_t);
+
+/*
+ * A condition of each group, reading the grouped result as grouped, such as AGGREGATE(&grouped, 0) > 1.
+ */
+#define HAVING(condition) && (condition)
+
+/**
+@brief		The @p i th aggregate of a grouped result. A sort packs results
+			whatever the size of the bytes grouped by, so the aggregate may
+			be unaligned and is copied out rather than read where it lies.
+*/
+static inline int64_t
+iinq_aggregate(
+	const ion_iinq_result_t *result,
+	int						i
+) {
+	int64_t value;
+
+	memcpy(&value, result->data + i * sizeof(int64_t), sizeof(value));
+	return value;
+}
+
+/**
+@brief		The @p i th aggregate of a grouped result, a mean.
+*/
+static inline double
+iinq_aggregate_avg(
+	const ion_iinq_result_t *result,
+	int						i
+) {
+	double value;
+
+	memcpy(&value, result->data + i * sizeof(int64_t), sizeof(value));
+	return value;
+}
+
+/*
+ * The i-th aggregate of a grouped result, and the mean one is.
+ */
+#define AGGREGATE(result, i) iinq_aggregate((result), (i))
+#define AGGREGATE_AVG(result, i) iinq_aggregate_avg((result), (i))
+
+/*
+ * Passes a result to the sort, begun with the first of them.
+ */
+#define _QUERY_PASS(row, ordered, p) \
+	if (!iinq_sorting) { \
+		iinq_sorting = boolean_true; \
+		iinq_sort_begin(&iinq_sort, iinq_order, (ordered) ? 0 : iinq_order_count, iinq_limit, (p)); \
+	} \
+	iinq_stopped = !iinq_sort_add(&iinq_sort, &(row));
+
+/*
+ * Results go through groups, if any, and a sort, begun with the first of them, once the sources are open. A single
+ * source grouped or ordered by its key is read in order and neither hashed nor sorted, and without an order the
+ * sort passes results straight on, stopping the cursors once the limit is reached.
+ */
 #define QUERY(select, from, where, groupby, having, orderby, limit, when, p) \
 do { \
-	ion_err_t			error; \
-	ion_iinq_result_t	result; \
-	result.num_bytes	= 0; \
+	ion_err_t				error; \
+	ion_iinq_result_t		result; \
+	ion_iinq_result_t		grouped; \
+	ion_iinq_order_t		*iinq_order				= NULL; \
+	int						iinq_order_count		= 0; \
+	long					iinq_limit				= -1; \
+	ion_iinq_sort_t			iinq_sort; \
+	ion_boolean_t			iinq_sorting			= boolean_false; \
+	ion_iinq_aggregate_t	*iinq_aggregates		= NULL; \
+	int						iinq_aggregates_count	= 0; \
+	ion_iinq_result_size_t	iinq_group_offset		= 0; \
+	ion_iinq_result_size_t	iinq_group_size			= 0; \
+	ion_iinq_group_t		iinq_group; \
+	ion_boolean_t			iinq_grouping			= boolean_false; \
+	ion_boolean_t			iinq_stopped			= boolean_false; \
+	result.num_bytes		= 0; \
+	groupby \
+	orderby \
+	limit \
+	if (0 == iinq_limit) { \
+		break; \
+	} \
 	from/* This includes a loop declaration with some other stuff. */ \
 		if (!where) { \
 			continue; \
 		} \
 		select \
-		(p)->execute(&result, (p)->state); \
+		if (NULL == iinq_aggregates) { \
+			_QUERY_PASS(result, (first == last) && iinq_order_follows_key(&first->reference->dictionary, iinq_order, iinq_order_count), p) \
+		} \
+		else { \
+			if (!iinq_grouping) { \
+				iinq_grouping = boolean_true; \
+				iinq_group_begin(&iinq_group, iinq_group_offset, iinq_group_size, iinq_aggregates, iinq_aggregates_count, (first == last) && (0 == iinq_group_offset) && (iinq_group_size == (ion_iinq_result_size_t) first->reference->dictionary.instance->record.key_size) && iinq_source_is_ordered(&first->reference->dictionary)); \
+			} \
+			iinq_stopped = (err_ok != iinq_group_add(&iinq_group, &result)); \
+			while (!iinq_stopped && iinq_group_next(&iinq_group, &grouped, boolean_false)) { \
+				if (1 having) { \
+					_QUERY_PASS(grouped, boolean_false, p) \
+				} \
+			} \
+		} \
+		if (iinq_stopped) { \
+			break; \
+		} \
 	} \
 	IINQ_QUERY_CLEANUP: \
 	while (NULL != first) { \
 		first->reference->cursor->destroy(&first->reference->cursor); \
-		ion_close_dictionary(&first->reference->dictionary); \
+		iinq_release_source(&first->reference->dictionary); \
 		first			= first->next; \
 	}\
+	while (iinq_grouping && !iinq_stopped && iinq_group_next(&iinq_group, &grouped, boolean_true)) { \
+		if (1 having) { \
+			_QUERY_PASS(grouped, boolean_false, p) \
+		} \
+	} \
+	if (iinq_grouping) { \
+		iinq_group_end(&iinq_group); \
+	} \
+	if (iinq_sorting) { \
+		iinq_sort_end(&iinq_sort, err_ok); \
+	} \
 } while (0);
 
 #if defined(__cplusplus)
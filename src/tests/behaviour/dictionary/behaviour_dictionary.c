@@ -869,6 +869,438 @@ test_bhdct_get_all(
 	bhdct_takedown(tc, &dict);
 }
 
+/**
+@brief	This function tests a batched get of present and absent keys.
+*/
+void
+test_bhdct_get_many(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	int							keys[40];
+	int							values[40];
+	ion_status_t				statuses[40];
+	ion_status_t				status;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 40; i += 2) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), boolean_true);
+	}
+
+	for (i = 0; i < 40; i++) {
+		keys[i]		= i;
+		values[i]	= -1;
+	}
+
+	status = dictionary_get_many(&dict, keys, values, statuses, 40);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, status.count);
+
+	for (i = 0; i < 40; i++) {
+		if (0 == i % 2) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, statuses[i].count);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, values[i]);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, statuses[i].count);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, values[i]);
+		}
+	}
+
+	/* only the keys that are there */
+	for (i = 0; i < 20; i++) {
+		keys[i] = i * 2;
+	}
+
+	status = dictionary_get_many(&dict, keys, values, NULL, 20);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, status.count);
+
+	for (i = 0; i < 20; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 6, values[i]);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests pointing at stored values, where the dictionary can.
+*/
+void
+test_bhdct_get_ref(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_value_t					ref;
+	ion_status_t				status;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 20; i++) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 9, int), boolean_true);
+	}
+
+	status = dictionary_get_ref(&dict, IONIZE(3, int), &ref);
+
+	if (err_not_implemented != status.error) {
+		for (i = 0; i < 20; i++) {
+			status = dictionary_get_ref(&dict, IONIZE(i, int), &ref);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 9, *(int *) ref);
+		}
+
+		status = dictionary_get_ref(&dict, IONIZE(20, int), &ref);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, status.count);
+
+		/* the pointer sees the value as it is now */
+		bhdct_update(tc, &dict, IONIZE(7, int), IONIZE(-7, int), err_ok, 1, boolean_true);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_ref(&dict, IONIZE(7, int), &ref).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -7, *(int *) ref);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests what a dictionary tells of its size, where it can,
+		alone and summed over the master table.
+*/
+void
+test_bhdct_get_info(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_dictionary_info_t		info;
+	ion_dictionary_info_t		total;
+	ion_err_t					err;
+	int							min_key;
+	int							max_key;
+	int							count;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 20; i++) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), boolean_true);
+	}
+
+	info.min_key	= &min_key;
+	info.max_key	= &max_key;
+	err				= dictionary_get_info(&dict, &info);
+
+	if (err_not_implemented != err) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
+		PLANCK_UNIT_ASSERT_TRUE(tc, (-1 == info.record_count) || (20 == info.record_count));
+		PLANCK_UNIT_ASSERT_TRUE(tc, -1 <= info.file_bytes);
+		PLANCK_UNIT_ASSERT_TRUE(tc, -1 <= info.pages);
+		PLANCK_UNIT_ASSERT_TRUE(tc, -1 <= info.memory_bytes);
+
+		if (info.has_bounds) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, min_key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 19, max_key);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_get_info(&total, &count));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, count);
+		PLANCK_UNIT_ASSERT_TRUE(tc, info.record_count == total.record_count);
+		PLANCK_UNIT_ASSERT_TRUE(tc, info.memory_bytes == total.memory_bytes);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests a batched insert, read back one key at a time.
+*/
+void
+test_bhdct_insert_many(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	int							keys[40];
+	int							values[40];
+	ion_status_t				statuses[40];
+	ion_status_t				status;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 40; i++) {
+		keys[i]		= i;
+		values[i]	= i * 5;
+		statuses[i] = ION_STATUS_INITIALIZE;
+	}
+
+	status = dictionary_insert_many(&dict, keys, values, statuses, 40);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40, status.count);
+
+	for (i = 0; i < 40; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, statuses[i].count);
+		bhdct_get(tc, &dict, IONIZE(i, int), IONIZE(i * 5, int), err_ok, 1);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests a batched delete of present and absent keys.
+*/
+void
+test_bhdct_delete_many(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	int							keys[30];
+	ion_status_t				statuses[30];
+	ion_status_t				status;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 40; i++) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), boolean_true);
+	}
+
+	/* the even keys, the last ten of them past every key there is */
+	for (i = 0; i < 30; i++) {
+		keys[i] = i * 2;
+	}
+
+	status = dictionary_delete_many(&dict, keys, statuses, 30);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, status.count);
+
+	for (i = 0; i < 30; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i < 20) ? err_ok : err_item_not_found, statuses[i].error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i < 20) ? 1 : 0, statuses[i].count);
+	}
+
+	for (i = 0; i < 40; i++) {
+		if (0 == i % 2) {
+			bhdct_get(tc, &dict, IONIZE(i, int), NULL, err_item_not_found, 0);
+		}
+		else {
+			bhdct_get(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), err_ok, 1);
+		}
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests reading a range cursor several records at a time.
+*/
+void
+test_bhdct_next_batch(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	int							keys[7];
+	int							values[7];
+	ion_boolean_t				seen[50];
+	int							total;
+	int							read;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 50; i++) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 2, int), boolean_true);
+		seen[i] = boolean_false;
+	}
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(10, int), IONIZE(39, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	total = 0;
+
+	do {
+		read = dictionary_next_batch(cursor, keys, values, 7);
+
+		for (i = 0; i < read; i++) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 10 <= keys[i] && 39 >= keys[i]);
+			PLANCK_UNIT_ASSERT_FALSE(tc, seen[keys[i]]);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i] * 2, values[i]);
+			seen[keys[i]] = boolean_true;
+		}
+
+		total += read;
+	} while (7 == read);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 30, total);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, dictionary_next_batch(cursor, keys, values, 7));
+	cursor->destroy(&cursor);
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	Passes the records whose value is even and whose key is at least the
+		one in @p context.
+*/
+static ion_boolean_t
+bhdct_even_value_filter(
+	ion_key_t	key,
+	ion_value_t value,
+	void		*context
+) {
+	int k;
+	int v;
+
+	/* the records may not be aligned where the dictionary holds them */
+	memcpy(&k, key, sizeof(int));
+	memcpy(&v, value, sizeof(int));
+
+	return k >= *(int *) context && 0 == v % 2;
+}
+
+/**
+@brief	This function tests a predicate cursor, filtering on keys and values.
+*/
+void
+test_bhdct_find_predicate(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	ion_boolean_t				seen[50];
+	int							least	= 10;
+	int							total	= 0;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 50; i++) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), boolean_true);
+		seen[i] = boolean_false;
+	}
+
+	record.key		= malloc(sizeof(int));
+	record.value	= malloc(sizeof(int));
+
+	dictionary_build_predicate(&predicate, predicate_predicate, bhdct_even_value_filter, &least);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		int key = *(int *) record.key;
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, least <= key && 50 > key);
+		PLANCK_UNIT_ASSERT_FALSE(tc, seen[key]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 3, *(int *) record.value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, key % 2);
+		seen[key] = boolean_true;
+		total++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, total);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+
+	/* a filter nothing passes gives an empty cursor */
+	least = 50;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_FALSE(tc, cs_cursor_active == cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	free(record.key);
+	free(record.value);
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function reads a snapshot cursor while it changes every record of
+		the dictionary, and checks the cursor only sees them as they were.
+*/
+static void
+bhdct_read_snapshot(
+	planck_unit_test_t	*tc,
+	size_t				budget
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	ion_boolean_t				seen[40];
+	int							key;
+	int							value;
+	int							total	= 0;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (i = 0; i < 40; i++) {
+		bhdct_insert(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), boolean_true);
+		seen[i] = boolean_false;
+	}
+
+	record.key		= &key;
+	record.value	= &value;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find_snapshot(&dict, &predicate, budget, &cursor));
+
+	while (cs_cursor_active == dictionary_next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 <= key && 40 > key);
+		PLANCK_UNIT_ASSERT_FALSE(tc, seen[key]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 3, value);
+		seen[key] = boolean_true;
+		total++;
+
+		/* the record read goes, the next one changes and every fourth read brings a new one */
+		bhdct_delete(tc, &dict, IONIZE(key, int), err_ok, 1, boolean_true);
+		dictionary_update(&dict, IONIZE((key + 1) % 40, int), IONIZE(-1, int));
+
+		if (0 == total % 4) {
+			bhdct_insert(tc, &dict, IONIZE(100 + total, int), IONIZE(-1, int), boolean_true);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40, total);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+
+	bhdct_get(tc, &dict, IONIZE(104, int), IONIZE(-1, int), err_ok, 1);
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests snapshot cursors held in memory, and spilled to a
+		file past a budget of ten records.
+*/
+void
+test_bhdct_find_snapshot(
+	planck_unit_test_t *tc
+) {
+	bhdct_read_snapshot(tc, 0);
+	bhdct_read_snapshot(tc, 10 * 2 * sizeof(int));
+}
+
 /**
 @brief	This function tests a get of everything within a string key dictionary.
 */
@@ -904,6 +1336,77 @@ test_bhdct_get_all_string_key(
 	bhdct_takedown(tc, &dict);
 }
 
+/**
+@brief	This function tests a find of the string keys starting with some characters.
+*/
+void
+test_bhdct_find_prefix_string_key(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	char						key[ION_BHDCT_STRING_KEY_BUFFER_SIZE] = { 0 };
+	char						found[ION_BHDCT_STRING_KEY_BUFFER_SIZE];
+	int							value;
+	int							count;
+	int							sum;
+	int							i;
+
+	bhdct_setup_string_key(tc, &handler, &dict, ion_fill_none);
+
+	for (i = -20; i < 150; i += 3) {
+		sprintf(key, ION_BHDCT_STRING_KEY_PAYLOAD, i);
+		bhdct_insert(tc, &dict, key, IONIZE(i, int), boolean_true);
+	}
+
+	record.key		= found;
+	record.value	= &value;
+	count			= 0;
+	sum				= 0;
+
+	/* k1, k10 to k19 and k100 to k149, of which every third was inserted */
+	dictionary_build_predicate(&predicate, predicate_prefix, "k1", 2);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == strncmp("k1", found, 2));
+		sprintf(key, ION_BHDCT_STRING_KEY_PAYLOAD, value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == strcmp(key, found));
+		count++;
+		sum += value;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+
+	for (i = -20; i < 150; i += 3) {
+		sprintf(key, ION_BHDCT_STRING_KEY_PAYLOAD, i);
+
+		if (0 == strncmp("k1", key, 2)) {
+			count--;
+			sum -= i;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, sum);
+
+	/* no key starts with this */
+	dictionary_build_predicate(&predicate, predicate_prefix, "k-3", 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_FALSE(tc, cs_cursor_active == cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	/* a prefix longer than the keys */
+	dictionary_build_predicate(&predicate, predicate_prefix, "k1234567", 8);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, dictionary_find(&dict, &predicate, &cursor));
+
+	bhdct_takedown(tc, &dict);
+}
+
 /**
 @brief	This function tests deletion on an empty dictionary.
 		We expect to receive err_item_not_found and for everything to remain as-is.
@@ -1516,6 +2019,13 @@ bhdct_run_tests(
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_populated_multiple);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_all);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_many);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_ref);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_info);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_many);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_next_batch);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_find_predicate);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_find_snapshot);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_empty);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_nonexist_single);
@@ -1524,6 +2034,7 @@ bhdct_run_tests(
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_single);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_single_several);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_all);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_many);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_update_empty_single);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_update_nonexist_single);
@@ -1557,6 +2068,7 @@ bhdct_run_tests(
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_populated_single_string_key);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_populated_multiple_string_key);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_all_string_key);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_find_prefix_string_key);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_empty_string_key);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_nonexist_single_string_key);
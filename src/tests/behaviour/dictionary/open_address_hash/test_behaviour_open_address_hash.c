@@ -24,6 +24,9 @@
 #include "../../../planckunit/src/planck_unit.h"
 #include "../behaviour_dictionary.h"
 #include "../../../../dictionary/open_address_hash/open_address_hash_dictionary_handler.h"
+#if !defined(ARDUINO)
+#include "../../../../dictionary/open_address_hash/open_address_hash_concurrent_handler.h"
+#endif
 #include "test_behaviour_open_address_hash.h"
 
 void
@@ -31,4 +34,7 @@ runalltests_behaviour_open_address_hash(
 	void
 ) {
 	bhdct_run_tests(oadict_init, 200, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
+#if !defined(ARDUINO)
+	bhdct_run_tests(oacdict_init, 200, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
+#endif
 }
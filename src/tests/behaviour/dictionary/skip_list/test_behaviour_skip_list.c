@@ -24,6 +24,10 @@
 #include "../../../planckunit/src/planck_unit.h"
 #include "../behaviour_dictionary.h"
 #include "../../../../dictionary/skip_list/skip_list_handler.h"
+#include "../../../../dictionary/skip_list/unrolled_skip_list_handler.h"
+#if !defined(ARDUINO)
+#include "../../../../dictionary/skip_list/concurrent_skip_list_handler.h"
+#endif
 #include "test_behaviour_skip_list.h"
 
 void
@@ -32,7 +36,10 @@ runalltests_behaviour_skip_list(
 ) {
 #if defined(ARDUINO)
 	bhdct_run_tests(sldict_init, 7, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_STRING_INT);
+	bhdct_run_tests(usldict_init, 7, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_STRING_INT);
 #else
 	bhdct_run_tests(sldict_init, 7, ION_BHDCT_ALL_TESTS);
+	bhdct_run_tests(usldict_init, 7, ION_BHDCT_ALL_TESTS);
+	bhdct_run_tests(csldict_init, 7, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
 #endif
 }
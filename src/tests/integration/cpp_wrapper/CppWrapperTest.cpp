@@ -71,37 +71,31 @@ main(
 	dict->insert(4, w);
 
 	cout << "Testing equality query on key 3: " << endl;
-	Cursor<int, string> *eq_cursor = dict->equality(3);
+	Cursor<int, string> eq_cursor = dict->equality(3);
 
-	while (eq_cursor->next()) {
-		cout << "[eq] Got back [" << eq_cursor->getKey() << ", " << eq_cursor->getValue() << "]" << endl;
+	while (eq_cursor.next()) {
+		cout << "[eq] Got back [" << eq_cursor.getKey() << ", " << eq_cursor.getValue() << "]" << endl;
 	}
 
 	cout << endl;
 
-	delete eq_cursor;
-
 	cout << "Testing all records query: " << endl;
-	Cursor<int, string> *all_cursor = dict->allRecords();
+	Cursor<int, string> all_cursor = dict->allRecords();
 
-	while (all_cursor->next()) {
-		cout << "[all] Got back [" << all_cursor->getKey() << ", " << all_cursor->getValue() << "]" << endl;
+	while (all_cursor.next()) {
+		cout << "[all] Got back [" << all_cursor.getKey() << ", " << all_cursor.getValue() << "]" << endl;
 	}
 
 	cout << endl;
 
-	delete all_cursor;
-
 	cout << "Testing range query: 2<=key<=3 " << endl;
-	Cursor<int, string> *range_cursor = dict->range(2, 3);
+	Cursor<int, string> range_cursor = dict->range(2, 3);
 
-	while (range_cursor->next()) {
-		cout << "[range] Got back [" << range_cursor->getKey() << ", " << range_cursor->getValue() << "]" << endl;
+	while (range_cursor.next()) {
+		cout << "[range] Got back [" << range_cursor.getKey() << ", " << range_cursor.getValue() << "]" << endl;
 	}
 
 	cout << endl;
 
-	delete range_cursor;
-
 	delete dict;
 }
@@ -0,0 +1,170 @@
+/******************************************************************************/
+/**
+@file
+@brief		Times lookups through the C interface against the C++ wrapper,
+			whose comparator and hash come from the traits of its key type.
+@details	Each case loads the same keys both ways and times a pass of
+			gets over them, printing nanoseconds per get. Cases run one at
+			a time, since the wrappers all use dictionary id 0.
+*/
+/******************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+
+#include "../../../cpp_wrapper/BppTree.h"
+#include "../../../cpp_wrapper/OpenAddressHash.h"
+
+#define BENCH_KEYS		4000
+#define BENCH_PASSES	5
+
+/**
+@brief	A two-field key, ordered by C as bytes and by its traits as fields.
+*/
+struct bench_point_t {
+	int32_t x;
+	int32_t y;
+};
+
+template<>
+struct KeyTraits<bench_point_t>:public OrderedKeyTraits<bench_point_t, KeyTraits<bench_point_t> > {
+	static int
+	compare(
+		const bench_point_t &first,
+		const bench_point_t &second
+	) {
+		if (first.x != second.x) {
+			return (first.x > second.x) - (first.x < second.x);
+		}
+
+		return (first.y > second.y) - (first.y < second.y);
+	}
+};
+
+static bench_point_t
+bench_point(
+	int i
+) {
+	bench_point_t point = { (int32_t) (i * 7919 % BENCH_KEYS), (int32_t) i };
+
+	return point;
+}
+
+static double
+bench_since(
+	std::chrono::steady_clock::time_point	start,
+	int										ops
+) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ops;
+}
+
+/**
+@brief	Gets every key of a dictionary made through the C interface.
+*/
+template<typename K>
+static double
+bench_c_gets(
+	void (*init)(ion_dictionary_handler_t *),
+	ion_key_type_t			key_type,
+	ion_dictionary_size_t	dictionary_size,
+	K (*key_of)(int)
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	int							value;
+	long						found = 0;
+
+	init(&handler);
+	dictionary_create(&handler, &dict, 0, key_type, sizeof(K), sizeof(int), dictionary_size);
+
+	for (int i = 0; i < BENCH_KEYS; i++) {
+		K key = key_of(i);
+
+		dictionary_insert(&dict, &key, &i);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int pass = 0; pass < BENCH_PASSES; pass++) {
+		for (int i = 0; i < BENCH_KEYS; i++) {
+			K key = key_of(i);
+
+			found += err_ok == dictionary_get(&dict, &key, &value).error;
+		}
+	}
+
+	double ns = bench_since(start, BENCH_KEYS * BENCH_PASSES);
+
+	dictionary_delete_dictionary(&dict);
+
+	return (found == BENCH_KEYS * BENCH_PASSES) ? ns : -1;
+}
+
+/**
+@brief	Gets every key of a dictionary made through the wrapper.
+*/
+template<typename K, typename D>
+static double
+bench_cpp_gets(
+	D	*dict,
+	K (*key_of)(int)
+) {
+	long found = 0;
+
+	for (int i = 0; i < BENCH_KEYS; i++) {
+		dict->insert(key_of(i), i);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int pass = 0; pass < BENCH_PASSES; pass++) {
+		for (int i = 0; i < BENCH_KEYS; i++) {
+			dict->get(key_of(i));
+			found += err_ok == dict->last_status.error;
+		}
+	}
+
+	double ns = bench_since(start, BENCH_KEYS * BENCH_PASSES);
+
+	return (found == BENCH_KEYS * BENCH_PASSES) ? ns : -1;
+}
+
+static int32_t
+bench_int(
+	int i
+) {
+	return i * 7919;
+}
+
+int
+main(
+) {
+	double c_ns;
+	double cpp_ns;
+
+	c_ns = bench_c_gets<bench_point_t>(bpptree_init, key_type_char_array, 0, bench_point);
+	{
+		BppTree<bench_point_t, int> tree(key_type_char_array, sizeof(bench_point_t), sizeof(int));
+
+		cpp_ns = bench_cpp_gets(&tree, bench_point);
+	}
+	printf("bpptree, 8 byte struct keys: C %.1f ns/get, C++ %.1f ns/get\n", c_ns, cpp_ns);
+
+	c_ns = bench_c_gets<int32_t>(bpptree_init, key_type_numeric_signed, 0, bench_int);
+	{
+		BppTree<int32_t, int> tree(key_type_numeric_signed, sizeof(int32_t), sizeof(int));
+
+		cpp_ns = bench_cpp_gets(&tree, bench_int);
+	}
+	printf("bpptree, int32 keys: C %.1f ns/get, C++ %.1f ns/get\n", c_ns, cpp_ns);
+
+	c_ns = bench_c_gets<int32_t>(oadict_init, key_type_numeric_signed, BENCH_KEYS * 2, bench_int);
+	{
+		OpenAddressHash<int32_t, int> hash(key_type_numeric_signed, sizeof(int32_t), sizeof(int), BENCH_KEYS * 2);
+
+		cpp_ns = bench_cpp_gets(&hash, bench_int);
+	}
+	printf("open address hash, int32 keys: C %.1f ns/get, C++ %.1f ns/get\n", c_ns, cpp_ns);
+
+	return 0;
+}
@@ -10,7 +10,11 @@
 #include "../../planckunit/src/planck_unit.h"
 #include "../../../cpp_wrapper/Dictionary.h"
 #include "../../../cpp_wrapper/BppTree.h"
+#include "../../../cpp_wrapper/CuckooHash.h"
 #include "../../../cpp_wrapper/FlatFile.h"
+#include "../../../cpp_wrapper/LinearHash.h"
+#include "../../../cpp_wrapper/LsmTree.h"
+#include "../../../cpp_wrapper/AdaptiveRadixTree.h"
 #include "../../../cpp_wrapper/OpenAddressFileHash.h"
 #include "../../../cpp_wrapper/OpenAddressHash.h"
 #include "../../../cpp_wrapper/SkipList.h"
@@ -27,7 +31,7 @@ test_cpp_wrapper_create_and_destroy(
 	Dictionary<int, int> *dict = new BppTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int));
 
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict->dict.instance->key_type == key_type_numeric_signed);
-	PLANCK_UNIT_ASSERT_TRUE(tc, dict->dict.instance->compare == dictionary_compare_signed_value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_is_signed_compare(dict->dict.instance->compare));
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict->dict.instance->record.key_size == sizeof(int));
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict->dict.instance->record.value_size == sizeof(int));
 
@@ -117,6 +121,26 @@ test_cpp_wrapper_insert_on_all_implementations(
 	test_cpp_wrapper_insert_get(tc, dict);
 	test_cpp_wrapper_insert_get_edge_cases(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_insert_get(tc, dict);
+	test_cpp_wrapper_insert_get_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_insert_get(tc, dict);
+	test_cpp_wrapper_insert_get_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_insert_get(tc, dict);
+	test_cpp_wrapper_insert_get_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_insert_get(tc, dict);
+	test_cpp_wrapper_insert_get_edge_cases(tc, dict);
+	delete dict;
 }
 
 /**
@@ -208,6 +232,26 @@ test_cpp_wrapper_delete_on_all_implementations(
 	test_cpp_wrapper_insert_delete(tc, dict);
 	test_cpp_wrapper_insert_delete_edge_cases(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_insert_delete(tc, dict);
+	test_cpp_wrapper_insert_delete_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_insert_delete(tc, dict);
+	test_cpp_wrapper_insert_delete_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_insert_delete(tc, dict);
+	test_cpp_wrapper_insert_delete_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_insert_delete(tc, dict);
+	test_cpp_wrapper_insert_delete_edge_cases(tc, dict);
+	delete dict;
 }
 
 /**
@@ -297,6 +341,26 @@ test_cpp_wrapper_update_on_all_implementations(
 	test_cpp_wrapper_insert_update(tc, dict);
 	test_cpp_wrapper_insert_update_edge_cases(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_insert_update(tc, dict);
+	test_cpp_wrapper_insert_update_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_insert_update(tc, dict);
+	test_cpp_wrapper_insert_update_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_insert_update(tc, dict);
+	test_cpp_wrapper_insert_update_edge_cases(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_insert_update(tc, dict);
+	test_cpp_wrapper_insert_update_edge_cases(tc, dict);
+	delete dict;
 }
 
 /**
@@ -324,28 +388,28 @@ test_cpp_wrapper_equality_duplicates(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *eq_cursor = dict->equality(eq_key);
+	Cursor<int, int> eq_cursor = dict->equality(eq_key);
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, eq_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, eq_cursor.hasNext());
 
-	ion_cursor_status_t status = eq_cursor->next();
+	ion_cursor_status_t status = eq_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < eq_key; i++) {
-			if (nums[i] == eq_cursor->getKey()) {
+			if (nums[i] == eq_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], eq_cursor->getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], eq_cursor.getKey());
 
 		nums[curr_pos]	= -1;
-		status			= eq_cursor->next();
+		status			= eq_cursor.next();
 		records_found++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor.hasNext());
 
 	for (int i = 0; i < eq_key; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
@@ -353,7 +417,6 @@ test_cpp_wrapper_equality_duplicates(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eq_key, records_found);
-	delete eq_cursor;
 }
 
 /**
@@ -374,24 +437,23 @@ test_cpp_wrapper_equality_no_duplicates(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *eq_cursor = dict->equality(eq_key);
+	Cursor<int, int> eq_cursor = dict->equality(eq_key);
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, eq_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, eq_cursor.hasNext());
 
-	ion_cursor_status_t status = eq_cursor->next();
+	ion_cursor_status_t status = eq_cursor.next();
 
 	while (status) {
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eq_key, eq_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eq_key * 2, eq_cursor->getValue());
-		status = eq_cursor->next();
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eq_key, eq_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eq_key * 2, eq_cursor.getValue());
+		status = eq_cursor.next();
 		records_found++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor.hasNext());
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, records_found);
-	delete eq_cursor;
 }
 
 /**
@@ -409,12 +471,10 @@ test_cpp_wrapper_equality_edge_case1(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *eq_cursor = dict->equality(20);
+	Cursor<int, int> eq_cursor = dict->equality(20);
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor->hasNext());
-	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor->next());
-
-	delete eq_cursor;
+	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor.hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, eq_cursor.next());
 }
 
 /**
@@ -445,6 +505,22 @@ test_cpp_wrapper_equality_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
 	test_cpp_wrapper_equality_no_duplicates(tc, dict, 6);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
+	test_cpp_wrapper_equality_no_duplicates(tc, dict, 6);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
+	test_cpp_wrapper_equality_no_duplicates(tc, dict, 6);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_equality_no_duplicates(tc, dict, 6);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_equality_no_duplicates(tc, dict, 6);
+	delete dict;
 }
 
 /**
@@ -475,6 +551,22 @@ test_cpp_wrapper_equality_edge_case1_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
 	test_cpp_wrapper_equality_edge_case1(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
+	test_cpp_wrapper_equality_edge_case1(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
+	test_cpp_wrapper_equality_edge_case1(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_equality_edge_case1(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_equality_edge_case1(tc, dict);
+	delete dict;
 }
 
 /**
@@ -508,36 +600,35 @@ test_cpp_wrapper_range_simple(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *range_cursor	= dict->range(min_key, max_key);
-	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor->hasNext());
+	Cursor<int, int> range_cursor	= dict->range(min_key, max_key);
+	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor.hasNext());
 
-	ion_cursor_status_t status		= range_cursor->next();
+	ion_cursor_status_t status		= range_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < max_key + 5; i++) {
-			if (nums[i] == range_cursor->getKey()) {
+			if (nums[i] == range_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor.getValue());
 
 		nums[curr_pos]	= -1;
-		status			= range_cursor->next();
+		status			= range_cursor.next();
 		min_key++;
 		records_found++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor.hasNext());
 
 	for (int i = 0; i < records_expected; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
 	}
 
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, records_expected, records_found);
-	delete range_cursor;
 }
 
 /**
@@ -560,28 +651,28 @@ test_cpp_wrapper_range_edge_case1(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *range_cursor = dict->range(-1000, 1000);
+	Cursor<int, int> range_cursor = dict->range(-1000, 1000);
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor.hasNext());
 
-	ion_cursor_status_t status = range_cursor->next();
+	ion_cursor_status_t status = range_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < nums_length; i++) {
-			if (nums[i] == range_cursor->getKey()) {
+			if (nums[i] == range_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor.getValue());
 		nums[curr_pos]	= -1;
-		status			= range_cursor->next();
+		status			= range_cursor.next();
 		total_records++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor.hasNext());
 
 	for (int i = 0; i < nums_length; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
@@ -589,7 +680,6 @@ test_cpp_wrapper_range_edge_case1(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums_length, total_records);
-	delete range_cursor;
 }
 
 /**
@@ -613,28 +703,28 @@ test_cpp_wrapper_range_edge_case2(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *range_cursor = dict->range(15, 55);
+	Cursor<int, int> range_cursor = dict->range(15, 55);
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor.hasNext());
 
-	ion_cursor_status_t status = range_cursor->next();
+	ion_cursor_status_t status = range_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < 2; i++) {
-			if (expected_nums[i] == range_cursor->getKey()) {
+			if (expected_nums[i] == range_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_nums[curr_pos], range_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_nums[curr_pos], range_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_nums[curr_pos], range_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_nums[curr_pos], range_cursor.getValue());
 		expected_nums[curr_pos] = -1;
-		status					= range_cursor->next();
+		status					= range_cursor.next();
 		total_records++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor.hasNext());
 
 	for (int i = 0; i < 2; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, expected_nums[i]);
@@ -642,7 +732,6 @@ test_cpp_wrapper_range_edge_case2(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, total_records);
-	delete range_cursor;
 }
 
 /**
@@ -665,28 +754,28 @@ test_cpp_wrapper_range_edge_case3(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *range_cursor = dict->range(1, 5);
+	Cursor<int, int> range_cursor = dict->range(1, 5);
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, range_cursor.hasNext());
 
-	ion_cursor_status_t status = range_cursor->next();
+	ion_cursor_status_t status = range_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < nums_length; i++) {
-			if (nums[i] == range_cursor->getKey()) {
+			if (nums[i] == range_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], range_cursor.getValue());
 		nums[curr_pos]	= -1;
-		status			= range_cursor->next();
+		status			= range_cursor.next();
 		total_records++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, range_cursor.hasNext());
 
 	for (int i = 0; i < nums_length; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
@@ -694,7 +783,6 @@ test_cpp_wrapper_range_edge_case3(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums_length, total_records);
-	delete range_cursor;
 }
 
 /**
@@ -725,6 +813,22 @@ test_cpp_wrapper_range_simple_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
 	test_cpp_wrapper_range_simple(tc, dict, 5, 7);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_simple(tc, dict, 5, 7);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_simple(tc, dict, 5, 7);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_range_simple(tc, dict, 5, 7);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_range_simple(tc, dict, 5, 7);
+	delete dict;
 }
 
 /**
@@ -755,6 +859,22 @@ test_cpp_wrapper_range_edge_case1_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
 	test_cpp_wrapper_range_edge_case1(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_edge_case1(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_edge_case1(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_range_edge_case1(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_range_edge_case1(tc, dict);
+	delete dict;
 }
 
 /**
@@ -785,6 +905,22 @@ test_cpp_wrapper_range_edge_case2_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
 	test_cpp_wrapper_range_edge_case2(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_edge_case2(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_edge_case2(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_range_edge_case2(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_range_edge_case2(tc, dict);
+	delete dict;
 }
 
 /**
@@ -815,6 +951,22 @@ test_cpp_wrapper_range_edge_case3_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
 	test_cpp_wrapper_range_edge_case3(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_edge_case3(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 15);
+	test_cpp_wrapper_range_edge_case3(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_range_edge_case3(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_range_edge_case3(tc, dict);
+	delete dict;
 }
 
 /**
@@ -837,29 +989,29 @@ test_cpp_wrapper_all_records_simple(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *all_rec_cursor = dict->allRecords();
+	Cursor<int, int> all_rec_cursor = dict->allRecords();
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor.hasNext());
 
-	ion_cursor_status_t status = all_rec_cursor->next();
+	ion_cursor_status_t status = all_rec_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < random_positive_num; i++) {
-			if (nums[i] == all_rec_cursor->getKey()) {
+			if (nums[i] == all_rec_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos] * 2, all_rec_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos] * 2, all_rec_cursor.getValue());
 		nums[curr_pos]	= -1;
 
 		total_records++;
-		status			= all_rec_cursor->next();
+		status			= all_rec_cursor.next();
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor.hasNext());
 
 	for (int i = 0; i < random_positive_num; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
@@ -867,7 +1019,6 @@ test_cpp_wrapper_all_records_simple(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, random_positive_num, total_records);
-	delete all_rec_cursor;
 }
 
 /**
@@ -890,28 +1041,28 @@ test_cpp_wrapper_all_records_edge_cases1(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *all_rec_cursor = dict->allRecords();
+	Cursor<int, int> all_rec_cursor = dict->allRecords();
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor.hasNext());
 
-	ion_cursor_status_t status = all_rec_cursor->next();
+	ion_cursor_status_t status = all_rec_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < nums_length; i++) {
-			if (nums[i] == all_rec_cursor->getKey()) {
+			if (nums[i] == all_rec_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor.getValue());
 		nums[curr_pos]	= -1;
-		status			= all_rec_cursor->next();
+		status			= all_rec_cursor.next();
 		total_records++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor.hasNext());
 
 	for (int i = 0; i < nums_length; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
@@ -919,7 +1070,6 @@ test_cpp_wrapper_all_records_edge_cases1(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums_length, total_records);
-	delete all_rec_cursor;
 }
 
 /**
@@ -942,28 +1092,28 @@ test_cpp_wrapper_all_records_edge_cases2(
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dict->last_status.count);
 	}
 
-	Cursor<int, int> *all_rec_cursor = dict->allRecords();
+	Cursor<int, int> all_rec_cursor = dict->allRecords();
 
-	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor.hasNext());
 
-	ion_cursor_status_t status = all_rec_cursor->next();
+	ion_cursor_status_t status = all_rec_cursor.next();
 
 	while (status) {
 		for (int i = 0; i < nums_length; i++) {
-			if (nums[i] == all_rec_cursor->getKey()) {
+			if (nums[i] == all_rec_cursor.getKey()) {
 				curr_pos = i;
 				break;
 			}
 		}
 
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor->getKey());
-		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor->getValue());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor.getKey());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums[curr_pos], all_rec_cursor.getValue());
 		nums[curr_pos]	= -1;
-		status			= all_rec_cursor->next();
+		status			= all_rec_cursor.next();
 		total_records++;
 	}
 
-	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor->hasNext());
+	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor.hasNext());
 
 	for (int i = 0; i < nums_length; i++) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, nums[i]);
@@ -971,7 +1121,6 @@ test_cpp_wrapper_all_records_edge_cases2(
 
 	/* Check that same number of records are found as were inserted with desired key. */
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, nums_length, total_records);
-	delete all_rec_cursor;
 }
 
 /**
@@ -1002,6 +1151,22 @@ test_cpp_wrapper_all_records_simple_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
 	test_cpp_wrapper_all_records_simple(tc, dict, 8);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_simple(tc, dict, 8);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_simple(tc, dict, 8);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_all_records_simple(tc, dict, 8);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_all_records_simple(tc, dict, 8);
+	delete dict;
 }
 
 /**
@@ -1032,6 +1197,22 @@ test_cpp_wrapper_all_records_edge_cases1_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
 	test_cpp_wrapper_all_records_edge_cases1(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_edge_cases1(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_edge_cases1(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_all_records_edge_cases1(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_all_records_edge_cases1(tc, dict);
+	delete dict;
 }
 
 /**
@@ -1062,6 +1243,316 @@ test_cpp_wrapper_all_records_edge_cases2_on_all_implementations(
 	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
 	test_cpp_wrapper_all_records_edge_cases2(tc, dict);
 	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_edge_cases2(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_edge_cases2(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_all_records_edge_cases2(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_all_records_edge_cases2(tc, dict);
+	delete dict;
+}
+
+/**
+@brief	Tests reading an all records cursor several records at a time.
+*/
+void
+test_cpp_wrapper_next_batch(
+	planck_unit_test_t *tc,
+	Dictionary<int, int> *dict
+) {
+	int		keys[4];
+	int		values[4];
+	bool	seen[10]	= { false };
+	int		total		= 0;
+	int		read;
+
+	for (int i = 0; i < 10; i++) {
+		dict->insert(i, i * 7);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == dict->last_status.error);
+	}
+
+	Cursor<int, int> all_rec_cursor = dict->allRecords();
+
+	do {
+		read = all_rec_cursor.nextBatch(keys, values, 4);
+
+		for (int i = 0; i < read; i++) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 <= keys[i] && 10 > keys[i]);
+			PLANCK_UNIT_ASSERT_FALSE(tc, seen[keys[i]]);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i] * 7, values[i]);
+			seen[keys[i]] = true;
+		}
+
+		total += read;
+	} while (4 == read);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, total);
+	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor.hasNext());
+}
+
+/**
+@brief	Tests batched cursor reads on all implementations.
+*/
+void
+test_cpp_wrapper_next_batch_on_all_implementations(
+	planck_unit_test_t *tc
+) {
+	Dictionary<int, int> *dict;
+
+	dict = new BppTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int));
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new SkipList<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 7);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new FlatFile<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 30);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new OpenAddressHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 20);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_next_batch(tc, dict);
+	delete dict;
+}
+
+/**
+@brief	Tests reading records through the iterators of a cursor, across
+		several batches and across moving a cursor part way through.
+*/
+void
+test_cpp_wrapper_iterators(
+	planck_unit_test_t *tc,
+	Dictionary<int, int> *dict
+) {
+	bool	seen[50]	= { false };
+	int		total		= 0;
+
+	for (int i = 0; i < 50; i++) {
+		dict->insert(i, i * 3);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == dict->last_status.error);
+	}
+
+	Cursor<int, int> all_rec_cursor = dict->allRecords();
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor.isValid());
+
+	for (Cursor<int, int>::Record record : all_rec_cursor) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 <= record.key && 50 > record.key);
+		PLANCK_UNIT_ASSERT_FALSE(tc, seen[record.key]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, record.key * 3, record.value);
+		seen[record.key] = true;
+
+		if (3 == ++total) {
+			break;
+		}
+	}
+
+	/* The record the loop stopped on is read again by the moved cursor. */
+	Cursor<int, int> moved = static_cast<Cursor<int, int> &&>(all_rec_cursor);
+
+	PLANCK_UNIT_ASSERT_FALSE(tc, all_rec_cursor.isValid());
+	PLANCK_UNIT_ASSERT_TRUE(tc, all_rec_cursor.begin() == all_rec_cursor.end());
+
+	bool first = true;
+
+	for (Cursor<int, int>::Record record : moved) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 <= record.key && 50 > record.key);
+		PLANCK_UNIT_ASSERT_TRUE(tc, first || !seen[record.key]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, record.key * 3, record.value);
+
+		if (!first) {
+			total++;
+		}
+
+		seen[record.key]	= true;
+		first				= false;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, total);
+	PLANCK_UNIT_ASSERT_TRUE(tc, moved.begin() == moved.end());
+
+	int missing = 0;
+
+	for (Cursor<int, int>::Record record : dict->equality(100)) {
+		missing += record.key;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, missing);
+}
+
+/**
+@brief	Tests cursor iterators on all implementations.
+*/
+void
+test_cpp_wrapper_iterators_on_all_implementations(
+	planck_unit_test_t *tc
+) {
+	Dictionary<int, int> *dict;
+
+	dict = new BppTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int));
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new SkipList<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 7);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new FlatFile<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 30);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new OpenAddressHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 100);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 100);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 100);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_iterators(tc, dict);
+	delete dict;
+}
+
+/**
+@brief	A record to bulk insert, shaped as a @c std::pair is.
+*/
+struct test_cpp_wrapper_pair_t {
+	int first;
+	int second;
+};
+
+/**
+@brief	Tests inserting ranges of records: unsorted ones a batch at a time,
+		sorted ones through the engine's bulk loader where it has one, and
+		sorted ones into a dictionary no longer empty.
+*/
+void
+test_cpp_wrapper_bulk_insert(
+	planck_unit_test_t *tc,
+	Dictionary<int, int> *dict
+) {
+	test_cpp_wrapper_pair_t records[100];
+	ion_status_t			status;
+
+	for (int i = 0; i < 100; i++) {
+		records[i].first	= i * 3;
+		records[i].second	= i * 3 + 1;
+	}
+
+	status = dict->insert(records, 60, true);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 60, status.count);
+
+	/* the rest, sorted but after the first load, then out of order */
+	status = dict->insert(records + 60, records + 80, true);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, status.count);
+
+	for (int i = 80; i < 90; i++) {
+		test_cpp_wrapper_pair_t swap = records[i];
+
+		records[i]			= records[179 - i];
+		records[179 - i]	= swap;
+	}
+
+	status = dict->insert(records + 80, records + 100);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, dict->last_status.count);
+
+	for (int i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3 + 1, dict->get(i * 3));
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == dict->last_status.error);
+	}
+}
+
+/**
+@brief	Tests bulk inserts on all implementations.
+*/
+void
+test_cpp_wrapper_bulk_insert_on_all_implementations(
+	planck_unit_test_t *tc
+) {
+	Dictionary<int, int> *dict;
+
+	dict = new BppTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int));
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new SkipList<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 7);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new FlatFile<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 30);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new OpenAddressHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 200);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 200);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 200);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
+
+	dict = new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_bulk_insert(tc, dict);
+	delete dict;
 }
 
 /**
@@ -1099,7 +1590,7 @@ test_cpp_wrapper_open_close(
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
 
 	ion_dictionary_config_info_t config = {
-		gdict_id, 0, key_type, key_size, val_size, dict_size
+		gdict_id, 0, key_type, key_size, val_size, dict_size, 0, hash_function_seeded, 0, 0, 0, { 0 }
 	};
 
 	error = dict->open(config);
@@ -1135,9 +1626,158 @@ test_cpp_wrapper_open_close_on_all_implementations(
 	dict	= new OpenAddressFileHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
 	test_cpp_wrapper_open_close(tc, dict, 5, 12);
 	delete dict;
+	dict	= new LinearHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_open_close(tc, dict, 9, 17);
+	delete dict;
+
+	dict	= new CuckooHash<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_open_close(tc, dict, 9, 17);
+	delete dict;
+
+	dict	= new LsmTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	test_cpp_wrapper_open_close(tc, dict, 9, 17);
+	delete dict;
 	dict	= new SkipList<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 7);
 	test_cpp_wrapper_open_close(tc, dict, 1, 13);
 	delete dict;
+	dict	= new AdaptiveRadixTree<int, int>(key_type_numeric_signed, sizeof(int), sizeof(int), 0);
+	test_cpp_wrapper_open_close(tc, dict, 1, 13);
+	delete dict;
+}
+
+/**
+@brief	Tests that lookups and updates on an OpenAddressHash, which probe
+		the map directly for fixed-size keys, agree with the generic
+		dictionary path through inserts, resizes and deletes.
+*/
+void
+test_cpp_wrapper_open_address_hash_fixed_size(
+	planck_unit_test_t *tc
+) {
+	OpenAddressHash<long long, double>	oah(key_type_numeric_signed, sizeof(long long), sizeof(double), 8);
+	Dictionary<long long, double>		*dict = &oah;
+
+	for (long long i = 0; i < 200; i++) {
+		oah.insert(i * 1000003LL, i / 4.0);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah.last_status.error);
+	}
+
+	for (long long i = 0; i < 200; i += 2) {
+		oah.deleteRecord(i * 1000003LL);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah.last_status.error);
+	}
+
+	for (long long i = 0; i < 200; i++) {
+		double value = oah.get(i * 1000003LL);
+
+		if (0 == i % 2) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == oah.last_status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, oah.last_status.count);
+			dict->get(i * 1000003LL);
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == dict->last_status.error);
+			continue;
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah.last_status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, oah.last_status.count);
+		PLANCK_UNIT_ASSERT_TRUE(tc, i / 4.0 == value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, value == dict->get(i * 1000003LL));
+	}
+
+	/* one update in place, one that inserts */
+	oah.update(1000003LL, -1.5);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah.last_status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, -1.5 == dict->get(1000003LL));
+	oah.update(-7, 2.5);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah.last_status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2.5 == oah.get(-7));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2.5 == dict->get(-7));
+}
+
+/**
+@brief	A key ordered by its second field, then its first, unlike its bytes.
+*/
+struct test_cpp_wrapper_point_t {
+	int16_t x;
+	int16_t y;
+};
+
+template<>
+struct KeyTraits<test_cpp_wrapper_point_t>:public OrderedKeyTraits<test_cpp_wrapper_point_t, KeyTraits<test_cpp_wrapper_point_t> > {
+	static int
+	compare(
+		const test_cpp_wrapper_point_t	&first,
+		const test_cpp_wrapper_point_t	&second
+	) {
+		if (first.y != second.y) {
+			return (first.y > second.y) - (first.y < second.y);
+		}
+
+		return (first.x > second.x) - (first.x < second.x);
+	}
+};
+
+/**
+@brief	Tests that dictionaries take their comparator from the traits of
+		their key type: stock ones for integers, so engines keep their
+		native paths, and a key type's own order otherwise.
+*/
+void
+test_cpp_wrapper_key_traits(
+	planck_unit_test_t *tc
+) {
+	/* the wrappers all use dictionary id 0, so one file-backed one at a time */
+	{
+		BppTree<int32_t, int> ints(key_type_numeric_signed, sizeof(int32_t), sizeof(int));
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_switch_compare(key_type_numeric_signed, sizeof(int32_t)) == ints.dict.instance->compare);
+	}
+	{
+		BppTree<uint64_t, int> longs(key_type_numeric_unsigned, sizeof(uint64_t), sizeof(int));
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_switch_compare(key_type_numeric_unsigned, sizeof(uint64_t)) == longs.dict.instance->compare);
+	}
+
+	BppTree<test_cpp_wrapper_point_t, int>	tree(key_type_char_array, sizeof(test_cpp_wrapper_point_t), sizeof(int));
+	SkipList<test_cpp_wrapper_point_t, int> list(key_type_char_array, sizeof(test_cpp_wrapper_point_t), sizeof(int), 7);
+	Dictionary<test_cpp_wrapper_point_t, int> *dicts[] = { &tree, &list };
+
+	for (int d = 0; d < 2; d++) {
+		Dictionary<test_cpp_wrapper_point_t, int> *dict = dicts[d];
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_compare_char_array != dict->dict.instance->compare);
+
+		/* x runs down as y runs up, so byte order and key order disagree */
+		for (int i = 0; i < 30; i++) {
+			test_cpp_wrapper_point_t point = { (int16_t) (300 - i * 7 % 30), (int16_t) (i % 10) };
+
+			dict->insert(point, i);
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == dict->last_status.error);
+		}
+
+		test_cpp_wrapper_point_t	last	= { INT16_MIN, INT16_MIN };
+		int							total	= 0;
+
+		for (Cursor<test_cpp_wrapper_point_t, int>::Record record : dict->allRecords()) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 > KeyTraits<test_cpp_wrapper_point_t>::compare(last, record.key));
+			last = record.key;
+			total++;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 30, total);
+
+		test_cpp_wrapper_point_t	low		= { INT16_MIN, 3 };
+		test_cpp_wrapper_point_t	high	= { INT16_MAX, 4 };
+
+		total = 0;
+
+		for (Cursor<test_cpp_wrapper_point_t, int>::Record record : dict->range(low, high)) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 3 == record.key.y || 4 == record.key.y);
+			total++;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, total);
+	}
 }
 
 /**
@@ -1162,6 +1802,11 @@ cpp_wrapper_getsuite_1(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_simple_on_all_implementations);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_edge_cases1_on_all_implementations);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_edge_cases2_on_all_implementations);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_next_batch_on_all_implementations);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_iterators_on_all_implementations);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_open_address_hash_fixed_size);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_key_traits);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_bulk_insert_on_all_implementations);
 
 	return suite;
 }
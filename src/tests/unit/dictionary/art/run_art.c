@@ -0,0 +1,8 @@
+#include "test_art.h"
+
+int
+main(
+) {
+	runalltests_art();
+	return 0;
+}
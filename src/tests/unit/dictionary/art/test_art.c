@@ -0,0 +1,442 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the node kinds, prefixes, key orders and duplicates of
+			the adaptive radix tree.
+*/
+/******************************************************************************/
+
+#include <stdio.h>
+#include "test_art.h"
+
+/**
+@brief		The size of the string keys of the tests.
+*/
+#define ION_ART_TEST_STRING 17
+
+/**
+@brief		Asserts that iterating over a tree from @p start reads
+			@p count keys, as they are stored, each greater than the one
+			before.
+*/
+static void
+check_art_order(
+	planck_unit_test_t	*tc,
+	ion_art_t			*art,
+	ion_byte_t			*start,
+	int					count
+) {
+	ion_art_iterator_t	iterator;
+	ion_key_size_t		key_size	= art->super.record.key_size;
+	ion_byte_t			*last		= NULL;
+	int					read		= 0;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_iterator_start(art, &iterator, start));
+
+	for (; NULL != iterator.leaf; art_iterator_next(&iterator)) {
+		if (NULL != last) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 < memcmp(ION_ART_LEAF_KEY(iterator.leaf), last, key_size));
+		}
+		else if (NULL != start) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 <= memcmp(ION_ART_LEAF_KEY(iterator.leaf), start, key_size));
+		}
+
+		last = ION_ART_LEAF_KEY(iterator.leaf);
+		read++;
+	}
+
+	art_iterator_stop(&iterator);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count, read);
+}
+
+/**
+@brief		Tests that the root of a tree of one byte keys grows through
+			every kind of node as keys are inserted, and shrinks back as
+			they are deleted.
+*/
+void
+test_art_node_kinds(
+	planck_unit_test_t *tc
+) {
+	ion_art_t		art;
+	unsigned char	key;
+	int				value;
+	int				i;
+	int				j;
+
+	art.super.compare = dictionary_compare_unsigned_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_initialize(&art, key_type_numeric_unsigned, sizeof(unsigned char), sizeof(int)));
+
+	for (i = 0; i < 256; i++) {
+		/* spread the bytes so that every node adds children out of order */
+		key = (unsigned char) (i * 97);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_insert(&art, &key, &i).error);
+
+		if (0 == i) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_ART_LEAF, art.root->type);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i < 4) ? ION_ART_NODE4 : (i < 16) ? ION_ART_NODE16 : (i < 48) ? ION_ART_NODE48 : ION_ART_NODE256, art.root->type);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i + 1, art.root->children);
+		}
+	}
+
+	check_art_order(tc, &art, NULL, 256);
+
+	for (i = 0; i < 256; i++) {
+		key = (unsigned char) (i * 97);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, art_delete(&art, &key).count);
+
+		/* the kinds shrink a few children short of where they grew */
+		j = 255 - i;
+
+		if (0 == j) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, NULL == art.root);
+		}
+		else if (1 == j) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_ART_LEAF, art.root->type);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (j <= 3) ? ION_ART_NODE4 : (j <= 12) ? ION_ART_NODE16 : (j <= 37) ? ION_ART_NODE48 : ION_ART_NODE256, art.root->type);
+		}
+
+		if (0 == i % 16) {
+			for (j = i + 1; j < 256; j++) {
+				key = (unsigned char) (j * 97);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_query(&art, &key, &value).error);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, j, value);
+			}
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, art.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_destroy(&art));
+}
+
+/**
+@brief		Counts the string keys not less than @p start.
+*/
+static int
+count_strings_from(
+	char	keys[][ION_ART_TEST_STRING],
+	int		count,
+	char	*start
+) {
+	int from = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		from += (0 <= strcmp(keys[i], start));
+	}
+
+	return from;
+}
+
+/**
+@brief		Tests string keys sharing prefixes longer than a node holds,
+			split at every depth by inserts and joined again by deletes.
+*/
+void
+test_art_long_prefixes(
+	planck_unit_test_t *tc
+) {
+	ion_art_t	art;
+	char		keys[300][ION_ART_TEST_STRING];
+	char		start[ION_ART_TEST_STRING];
+	int			value;
+	int			i;
+	int			n;
+
+	art.super.compare = dictionary_compare_null_terminated_string;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_initialize(&art, key_type_null_terminated_string, ION_ART_TEST_STRING, sizeof(int)));
+
+	/* zero padded, the keys share up to 13 bytes; unpadded, some are prefixes of others up to their terminators */
+	for (i = 0; i < 150; i++) {
+		memset(keys[i], 0, ION_ART_TEST_STRING);
+		memset(keys[150 + i], 0, ION_ART_TEST_STRING);
+		sprintf(keys[i], "%016d", i * 7919);
+		sprintf(keys[150 + i], "%d", i);
+	}
+
+	for (i = 0; i < 300; i++) {
+		n = (i * 101) % 300;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_insert(&art, keys[n], &n).error);
+	}
+
+	for (i = 0; i < 300; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_query(&art, keys[i], &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, art_query(&art, "0000000000007918", &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, art_query(&art, "150", &value).error);
+
+	check_art_order(tc, &art, NULL, 300);
+
+	/* unpadded, "0" comes before the padded keys, and the rest after them */
+	memset(start, 0, ION_ART_TEST_STRING);
+	strcpy(start, "0000000000007919");
+	check_art_order(tc, &art, (ion_byte_t *) start, count_strings_from(keys, 300, start));
+	strcpy(start, "0000000000007920");
+	check_art_order(tc, &art, (ion_byte_t *) start, count_strings_from(keys, 300, start));
+	memset(start, 0, ION_ART_TEST_STRING);
+	strcpy(start, "5");
+	check_art_order(tc, &art, (ion_byte_t *) start, count_strings_from(keys, 300, start));
+	strcpy(start, "99999");
+	check_art_order(tc, &art, (ion_byte_t *) start, 0);
+
+	for (i = 0; i < 300; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, art_delete(&art, keys[i]).count);
+	}
+
+	for (i = 0; i < 300; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == i % 2) ? err_item_not_found : err_ok, art_query(&art, keys[i], &value).error);
+	}
+
+	check_art_order(tc, &art, NULL, 150);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_destroy(&art));
+}
+
+/**
+@brief		Tests that signed keys are iterated over in numeric order,
+			negative ones first.
+*/
+void
+test_art_signed_order(
+	planck_unit_test_t *tc
+) {
+	ion_art_t			art;
+	ion_art_iterator_t	iterator;
+	ion_byte_t			start[sizeof(int)];
+	int					key;
+	int					i;
+
+	art.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_initialize(&art, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	for (i = 0; i < 1001; i++) {
+		key = ((i * 389) % 1001) * 1000 - 500000;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_insert(&art, &key, &i).error);
+	}
+
+	key = -2500;
+	art_encode_key(&art, &key, start);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_iterator_start(&art, &iterator, start));
+
+	for (i = -2000; NULL != iterator.leaf; i += 1000, art_iterator_next(&iterator)) {
+		art_decode_key(&art, ION_ART_LEAF_KEY(iterator.leaf), &key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 501000, i);
+	art_iterator_stop(&iterator);
+
+	key = 500001;
+	art_encode_key(&art, &key, start);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_iterator_start(&art, &iterator, start));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == iterator.leaf);
+	art_iterator_stop(&iterator);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_destroy(&art));
+}
+
+/**
+@brief		Tests that records with the same key are kept in the order
+			they were inserted, and are updated and deleted together.
+*/
+void
+test_art_duplicates(
+	planck_unit_test_t *tc
+) {
+	ion_art_t			art;
+	ion_art_iterator_t	iterator;
+	ion_value_t			reference;
+	int					value;
+	int					i;
+
+	art.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_initialize(&art, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	for (i = 0; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_insert(&art, IONIZE(5, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_insert(&art, IONIZE(6, int), IONIZE(60, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_query(&art, IONIZE(5, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_iterator_start(&art, &iterator, NULL));
+
+	for (i = 0; i < 3; i++, art_iterator_next(&iterator)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, NEUTRALIZE(ION_ART_LEAF_VALUE(&art, iterator.leaf), int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 60, NEUTRALIZE(ION_ART_LEAF_VALUE(&art, iterator.leaf), int));
+	art_iterator_stop(&iterator);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, art_update(&art, IONIZE(5, int), IONIZE(50, int)).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_get_ref(&art, IONIZE(5, int), &reference).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, NEUTRALIZE(reference, int));
+
+	/* an update of a key not there inserts it */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, art_update(&art, IONIZE(7, int), IONIZE(70, int)).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, art.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, art_delete(&art, IONIZE(5, int)).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, art_delete(&art, IONIZE(5, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, art_query(&art, IONIZE(5, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, art.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, art_destroy(&art));
+}
+
+/**
+@brief		Tests range and equality cursors over an adaptive radix tree
+			dictionary of signed keys.
+*/
+void
+test_art_dictionary_cursors(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	int							key;
+	int							value;
+	int							i;
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	artdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+
+	for (i = -100; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(3 * i, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(0, int), IONIZE(1000, int)).error);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(-10, int), IONIZE(10, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = -3; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * i, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+
+		/* the duplicate of 0 follows it */
+		if ((0 == i) && (0 == value)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, value);
+			value = 0;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, i);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(0, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 0; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, i);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(1, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+#if ION_ALLOC_TRACKING
+
+/**
+@brief		Tests that a tree bound to a pool takes its nodes, leaves,
+			cursors and their predicates from it, and gives all of it back.
+*/
+void
+test_art_dictionary_pool(
+	planck_unit_test_t *tc
+) {
+	static long double			memory[32768 / sizeof(long double)];
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_allocator_t				allocator;
+	ion_pool_t					pool;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	size_t						filled;
+	int							key;
+	int							value;
+	int							i;
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_pool_init(&pool, memory, sizeof(memory), &allocator));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_allocator(1, &allocator));
+
+	artdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i, int)).error);
+	}
+
+	filled = pool.available;
+	PLANCK_UNIT_ASSERT_TRUE(tc, filled < pool.size);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(10, int), IONIZE(19, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_TRUE(tc, pool.available < filled);
+
+	for (i = 10; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, i);
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_TRUE(tc, filled == pool.available);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, pool.size == pool.available);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_allocator(1, NULL));
+}
+
+#endif
+
+planck_unit_suite_t *
+art_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_art_node_kinds);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_art_long_prefixes);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_art_signed_order);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_art_duplicates);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_art_dictionary_cursors);
+#if ION_ALLOC_TRACKING
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_art_dictionary_pool);
+#endif
+
+	return suite;
+}
+
+void
+runalltests_art(
+) {
+	planck_unit_suite_t *suite = art_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,26 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the adaptive radix tree.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_ART_H_)
+#define TEST_ART_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/art/art_dictionary_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_art(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_ART_H_ */
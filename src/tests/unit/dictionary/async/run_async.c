@@ -0,0 +1,8 @@
+#include "test_async.h"
+
+int
+main(
+) {
+	runalltests_async();
+	return 0;
+}
@@ -0,0 +1,364 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the asynchronous dictionary operations, on file-backed
+			dictionaries run side by side.
+*/
+/******************************************************************************/
+
+#include "test_async.h"
+
+/**
+@brief		The number of dictionaries the tests run operations on.
+*/
+#define ASYNC_TEST_DICTIONARIES 3
+
+/**
+@brief		The number of records put in each.
+*/
+#define ASYNC_TEST_RECORDS		40
+
+/**
+@brief		The number of dictionaries opened together at startup.
+*/
+#define ASYNC_TEST_OPENS		6
+
+/**
+@brief		A flat file, a B+ tree and a file hash, which do all block on
+			their files.
+*/
+static void
+async_test_setup(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*handlers,
+	ion_dictionary_t			*dictionaries
+) {
+	int i;
+
+	ffdict_init(&handlers[0]);
+	bpptree_init(&handlers[1]);
+	oafdict_init(&handlers[2]);
+
+	for (i = 0; i < ASYNC_TEST_DICTIONARIES; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handlers[i], &dictionaries[i], 60 + i, key_type_numeric_signed, sizeof(int), sizeof(int), ASYNC_TEST_RECORDS * 2));
+	}
+}
+
+/**
+@brief		Deletes the dictionaries of @ref async_test_setup.
+*/
+static void
+async_test_takedown(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionaries
+) {
+	int i;
+
+	for (i = 0; i < ASYNC_TEST_DICTIONARIES; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionaries[i]));
+	}
+}
+
+/**
+@brief		Tests that requests without a callback are all polled once,
+			and make the operations they were submitted for.
+*/
+void
+test_async_poll(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handlers[ASYNC_TEST_DICTIONARIES];
+	ion_dictionary_t			dictionaries[ASYNC_TEST_DICTIONARIES];
+	ion_async_pool_t			pool;
+	ion_async_request_t			requests[ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS];
+	ion_async_request_t			*request;
+	int							keys[ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS];
+	int							values[ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS];
+	int							polled;
+	int							i;
+
+	async_test_setup(tc, handlers, dictionaries);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(&pool, ASYNC_TEST_DICTIONARIES));
+
+	for (i = 0; i < ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS; i++) {
+		keys[i]		= i / ASYNC_TEST_DICTIONARIES;
+		values[i]	= i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_insert(&pool, &requests[i], &dictionaries[i % ASYNC_TEST_DICTIONARIES], &keys[i], &values[i], NULL, NULL));
+	}
+
+	for (polled = 0; NULL != (request = dictionary_async_poll(&pool, boolean_true)); polled++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, request->done);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, request->status.error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS, polled);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == dictionary_async_poll(&pool, boolean_false));
+
+	/* read them back, in the other order */
+	for (i = ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS - 1; i >= 0; i--) {
+		values[i] = -1;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_get(&pool, &requests[i], &dictionaries[i % ASYNC_TEST_DICTIONARIES], &keys[i], &values[i], NULL, NULL));
+	}
+
+	for (i = 0; i < ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_wait(&pool, &requests[i]).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, values[i]);
+	}
+
+	/* waited on, so none are left to poll */
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == dictionary_async_poll(&pool, boolean_true));
+
+	dictionary_async_stop(&pool);
+	async_test_takedown(tc, dictionaries);
+}
+
+/**
+@brief		Tests that the operations on one dictionary are made in the
+			order they were submitted.
+*/
+void
+test_async_order(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handlers[ASYNC_TEST_DICTIONARIES];
+	ion_dictionary_t			dictionaries[ASYNC_TEST_DICTIONARIES];
+	ion_async_pool_t			pool;
+	ion_async_request_t			requests[5];
+	int							key		= 7;
+	int							first	= 1;
+	int							second	= 2;
+	int							value	= 0;
+	int							value2	= 0;
+
+	async_test_setup(tc, handlers, dictionaries);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(&pool, 2));
+
+	dictionary_async_insert(&pool, &requests[0], &dictionaries[1], &key, &first, NULL, NULL);
+	dictionary_async_update(&pool, &requests[1], &dictionaries[1], &key, &second, NULL, NULL);
+	dictionary_async_get(&pool, &requests[2], &dictionaries[1], &key, &value, NULL, NULL);
+	dictionary_async_delete(&pool, &requests[3], &dictionaries[1], &key, NULL, NULL);
+	dictionary_async_get(&pool, &requests[4], &dictionaries[1], &key, &value2, NULL, NULL);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_async_wait(&pool, &requests[4]).error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_async_done(&pool, &requests[2]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, requests[2].status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, second, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, requests[3].status.count);
+
+	dictionary_async_stop(&pool);
+	async_test_takedown(tc, dictionaries);
+}
+
+/**
+@brief		The state the callbacks of @ref test_async_callback share.
+*/
+typedef struct {
+	pthread_mutex_t		lock;
+	pthread_cond_t		ended;
+	ion_async_pool_t	*pool;
+	int					chains;
+	int					completed;
+	int					failed;
+	int					key[ASYNC_TEST_DICTIONARIES];
+	int					value[ASYNC_TEST_DICTIONARIES];
+} async_test_chain_t;
+
+/**
+@brief		Checks a get and submits the request again for the next key,
+			until each of its dictionary has been read.
+*/
+static void
+async_test_next_get(
+	ion_async_request_t *request,
+	void				*context
+) {
+	async_test_chain_t	*chain	= context;
+	int					*key	= request->key;
+	int					i		= (int) (key - chain->key);
+
+	pthread_mutex_lock(&chain->lock);
+	chain->completed++;
+
+	if ((err_ok != request->status.error) || (chain->value[i] != *key * 10)) {
+		chain->failed++;
+	}
+
+	if (++*key < ASYNC_TEST_RECORDS) {
+		pthread_mutex_unlock(&chain->lock);
+		dictionary_async_get(chain->pool, request, request->dictionary, key, &chain->value[i], async_test_next_get, chain);
+		return;
+	}
+
+	chain->chains--;
+	pthread_cond_signal(&chain->ended);
+	pthread_mutex_unlock(&chain->lock);
+}
+
+/**
+@brief		Tests that callbacks are called on completion, and that one
+			may submit its request again.
+*/
+void
+test_async_callback(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handlers[ASYNC_TEST_DICTIONARIES];
+	ion_dictionary_t			dictionaries[ASYNC_TEST_DICTIONARIES];
+	ion_async_pool_t			pool;
+	ion_async_request_t			requests[ASYNC_TEST_DICTIONARIES];
+	async_test_chain_t			chain;
+	int							key;
+	int							value;
+	int							i;
+
+	async_test_setup(tc, handlers, dictionaries);
+
+	for (i = 0; i < ASYNC_TEST_DICTIONARIES; i++) {
+		for (key = 0; key < ASYNC_TEST_RECORDS; key++) {
+			value = key * 10;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionaries[i], &key, &value).error);
+		}
+	}
+
+	pthread_mutex_init(&chain.lock, NULL);
+	pthread_cond_init(&chain.ended, NULL);
+	chain.pool		= &pool;
+	chain.chains	= ASYNC_TEST_DICTIONARIES;
+	chain.completed = 0;
+	chain.failed	= 0;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(&pool, ASYNC_TEST_DICTIONARIES));
+
+	for (i = 0; i < ASYNC_TEST_DICTIONARIES; i++) {
+		chain.key[i] = 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_get(&pool, &requests[i], &dictionaries[i], &chain.key[i], &chain.value[i], async_test_next_get, &chain));
+	}
+
+	/* a stopping pool takes no more requests, so the chains must end first */
+	pthread_mutex_lock(&chain.lock);
+
+	while (chain.chains > 0) {
+		pthread_cond_wait(&chain.ended, &chain.lock);
+	}
+
+	pthread_mutex_unlock(&chain.lock);
+	dictionary_async_stop(&pool);
+	pthread_cond_destroy(&chain.ended);
+	pthread_mutex_destroy(&chain.lock);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ASYNC_TEST_DICTIONARIES * ASYNC_TEST_RECORDS, chain.completed);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, chain.failed);
+
+	async_test_takedown(tc, dictionaries);
+}
+
+/**
+@brief		Tests that the dictionaries of a use are opened side by side,
+			with what they held, and that a missing one fails alone.
+*/
+void
+test_async_open_by_use(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handlers[ASYNC_TEST_OPENS];
+	ion_dictionary_t				dictionaries[ASYNC_TEST_OPENS];
+	ion_dictionary_id_t				ids[ASYNC_TEST_OPENS];
+	ion_dictionary_id_t				created[ASYNC_TEST_OPENS];
+	ion_err_t						errors[ASYNC_TEST_OPENS];
+	ion_dictionary_config_info_t	config;
+	ion_async_pool_t				pool;
+	int								count;
+	int								key;
+	int								value;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	/* the third is put to another use */
+	for (i = 0; i < ASYNC_TEST_OPENS; i++) {
+		bpptree_init(&handlers[i]);
+		config = (ion_dictionary_config_info_t) {
+			.id = 0, .use_type = (2 == i) ? 9 : 8, .type = key_type_numeric_signed, .key_size = sizeof(int), .value_size = sizeof(int), .dictionary_size = ASYNC_TEST_RECORDS
+		};
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_from_config(&handlers[i], &dictionaries[i], &config));
+		created[i] = config.id;
+
+		for (key = 0; key < ASYNC_TEST_RECORDS; key++) {
+			value = key + i * 1000;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionaries[i], &key, &value).error);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionaries[i]));
+		bpptree_init(&handlers[i]);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(&pool, 3));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_open_by_use(&pool, &ion_master_table_default, handlers, dictionaries, ids, ASYNC_TEST_OPENS, 8, &count, errors));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ASYNC_TEST_OPENS - 1, count);
+
+	for (i = 0; i < count; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, errors[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, created[(i < 2) ? i : i + 1], ids[i]);
+
+		for (key = 0; key < ASYNC_TEST_RECORDS; key++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionaries[i], &key, &value).error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key + ((i < 2) ? i : i + 1) * 1000, value);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionaries[i]));
+	}
+
+	/* the one not found does not keep the other from opening */
+	ids[0]	= created[2];
+	ids[1]	= ion_master_table_next_id + 5;
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != dictionary_async_open_dictionaries(&pool, &ion_master_table_default, handlers, dictionaries, ids, 2, errors));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, errors[0]);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != errors[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionaries[0]));
+
+	dictionary_async_stop(&pool);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+}
+
+/**
+@brief		Tests that a pool is only started with a sensible number of
+			workers.
+*/
+void
+test_async_workers(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t pool;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, dictionary_async_start(&pool, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, dictionary_async_start(&pool, ION_ASYNC_MAX_WORKERS + 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(&pool, 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == dictionary_async_poll(&pool, boolean_true));
+	dictionary_async_stop(&pool);
+}
+
+planck_unit_suite_t *
+async_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_async_poll);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_async_order);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_async_callback);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_async_workers);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_async_open_by_use);
+
+	return suite;
+}
+
+void
+runalltests_async(
+) {
+	planck_unit_suite_t *suite = async_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,29 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the asynchronous dictionary operations.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_ASYNC_H_)
+#define TEST_ASYNC_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/async/dictionary_async.h"
+#include "../../../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../../../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../../../../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_async(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_ASYNC_H_ */
@@ -0,0 +1,8 @@
+#include "test_bitmap_index.h"
+
+int
+main(
+) {
+	runalltests_bitmap_index();
+	return 0;
+}
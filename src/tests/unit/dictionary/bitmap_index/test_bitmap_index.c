@@ -0,0 +1,422 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the compressed bitmaps and the bitmap indexes built from
+			them.
+*/
+/******************************************************************************/
+
+#include "test_bitmap_index.h"
+
+/**
+@brief		The values of the records of the index tests.
+*/
+typedef struct {
+	int status;	/**< The key modulo 4 */
+	int sensor;	/**< The key modulo 10 */
+	int reading;	/**< The key times 10 */
+} ion_bidx_test_value_t;
+
+/**
+@brief		The fields of an @ref ion_bidx_test_value_t that are indexed.
+*/
+static ion_bidx_field_t bidx_test_fields[] = {
+	{ 0, sizeof(int) }, { sizeof(int), sizeof(int) }
+};
+
+/**
+@brief		Makes the value of a key.
+*/
+static ion_bidx_test_value_t
+bidx_test_value(
+	int key
+) {
+	ion_bidx_test_value_t value;
+
+	value.status	= key % 4;
+	value.sensor	= key % 10;
+	value.reading	= key * 10;
+
+	return value;
+}
+
+/**
+@brief		Creates a skip list of @p count records, keys @c 0 and on, and
+			indexes its status and sensor fields, inserting the records
+			of the second half after the wrap.
+*/
+static void
+bidx_test_create(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*inner_handler,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	int							count
+) {
+	ion_bidx_test_value_t	value;
+	int						i;
+
+	sldict_init(inner_handler);
+	bidxdict_init(handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(inner_handler, dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(ion_bidx_test_value_t), 7));
+
+	for (i = 0; i < count / 2; i++) {
+		value = bidx_test_value(i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, IONIZE(i, int), &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_wrap(dictionary, handler, bidx_test_fields, 2));
+
+	for (; i < count; i++) {
+		value = bidx_test_value(i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, IONIZE(i, int), &value).error);
+	}
+}
+
+/**
+@brief		Reads the records of a set of rows, asserting that each one
+			has the value of its key.
+@param[out]	count
+					Set to how many there were.
+*/
+static void
+bidx_test_count_rows(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	ion_bitmap_t		*rows,
+	int					modulo,
+	int					remainder,
+	int					*count
+) {
+	ion_dict_cursor_t		*cursor = NULL;
+	ion_record_t			record;
+	ion_bidx_test_value_t	value;
+	int						key;
+	int						wrong	= 0;
+
+	*count			= 0;
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_find_rows(dictionary, rows, &cursor));
+
+	/* the cursor is released before anything read is asserted on */
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		wrong += (remainder != key % modulo) || (key * 10 != value.reading);
+		(*count)++;
+	}
+
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, wrong);
+}
+
+/**
+@brief		Tests that positions are added, found, walked in order and
+			removed, as arrays and as bitmaps.
+*/
+void
+test_bitmap_add_remove(
+	planck_unit_test_t *tc
+) {
+	ion_bitmap_t	bitmap;
+	uint32_t		position;
+	uint32_t		i;
+
+	ion_bitmap_init(&bitmap);
+	position = 0;
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_next(&bitmap, &position));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&bitmap, 70000));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&bitmap, 5));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&bitmap, 5));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&bitmap, 0xFFFFFFFFUL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, ion_bitmap_cardinality(&bitmap));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, bitmap.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&bitmap, 70000));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_contains(&bitmap, 6));
+
+	position = 6;
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_next(&bitmap, &position));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 70000, position);
+	position++;
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_next(&bitmap, &position));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0xFFFFFFFFUL == position);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_remove(&bitmap, 70000));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_remove(&bitmap, 70000));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, bitmap.count);
+
+	/* past the array limit the container turns into a bitmap */
+	for (i = 0; i < 3 * ION_BITMAP_ARRAY_MAX; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&bitmap, i));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != bitmap.containers[0].words);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * ION_BITMAP_ARRAY_MAX / 2 + 1, bitmap.containers[0].cardinality);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&bitmap, 5));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_contains(&bitmap, 7));
+
+	for (i = 0, position = 0; ion_bitmap_next(&bitmap, &position) && (position < 65536); i++, position++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, (5 == position) || (0 == position % 2));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * ION_BITMAP_ARRAY_MAX / 2 + 1, i);
+
+	/* and back into an array once it holds half as many */
+	for (i = 0; i <= 2 * ION_BITMAP_ARRAY_MAX; i += 2) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_remove(&bitmap, i));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == bitmap.containers[0].words);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_BITMAP_ARRAY_MAX / 2, bitmap.containers[0].cardinality);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&bitmap, 2 * ION_BITMAP_ARRAY_MAX + 2));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_contains(&bitmap, 2 * ION_BITMAP_ARRAY_MAX));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&bitmap, 5));
+
+	ion_bitmap_free(&bitmap);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_bitmap_cardinality(&bitmap));
+}
+
+/**
+@brief		Tests intersections and unions of arrays, bitmaps and
+			containers found on one side only.
+*/
+void
+test_bitmap_and_or(
+	planck_unit_test_t *tc
+) {
+	ion_bitmap_t	a;
+	ion_bitmap_t	b;
+	ion_bitmap_t	result;
+	uint32_t		position;
+	uint32_t		i;
+
+	ion_bitmap_init(&a);
+	ion_bitmap_init(&b);
+	ion_bitmap_init(&result);
+
+	/* a is dense below 65536, b is not; each has a container the other lacks */
+	for (i = 0; i < 20000; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&a, i));
+	}
+
+	for (i = 0; i < 20000; i += 7) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&b, i));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&a, 100000));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&b, 200000));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_and(&a, &b, &result));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (20000 + 13) / 14, ion_bitmap_cardinality(&result));
+
+	for (position = 0; ion_bitmap_next(&result, &position); position++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, position % 14);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_or(&a, &b, &result));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10000 + (20000 + 6) / 7 - (20000 + 13) / 14 + 2, ion_bitmap_cardinality(&result));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&result, 100000));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&result, 200000));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&result, 7));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_contains(&result, 9));
+
+	/* two bitmaps whose intersection is small enough for an array */
+	ion_bitmap_free(&b);
+
+	for (i = 0; i < 20000; i++) {
+		if ((1 == i % 2) || (0 == i % 10)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_add(&b, i));
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != b.containers[0].words);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_and(&a, &b, &result));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2000, ion_bitmap_cardinality(&result));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == result.containers[0].words);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_bitmap_contains(&result, 20));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_bitmap_contains(&result, 4));
+
+	ion_bitmap_free(&a);
+	ion_bitmap_free(&b);
+	ion_bitmap_free(&result);
+}
+
+/**
+@brief		Tests that the rows of values of two fields are found and
+			combined, for records inserted before and after the wrap.
+*/
+void
+test_bitmap_index_match(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_bitmap_t				status_rows;
+	ion_bitmap_t				sensor_rows;
+	ion_bitmap_t				result;
+	int							count;
+
+	bidx_test_create(tc, &inner_handler, &handler, &dictionary, 200);
+	ion_bitmap_init(&status_rows);
+	ion_bitmap_init(&sensor_rows);
+	ion_bitmap_init(&result);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 0, IONIZE(1, int), &status_rows));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, ion_bitmap_cardinality(&status_rows));
+	bidx_test_count_rows(tc, &dictionary, &status_rows, 4, 1, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 1, IONIZE(3, int), &sensor_rows));
+	bidx_test_count_rows(tc, &dictionary, &sensor_rows, 10, 3, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, count);
+
+	/* status 1 and sensor 3 leaves the keys that are 13 modulo 20 */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_and(&status_rows, &sensor_rows, &result));
+	bidx_test_count_rows(tc, &dictionary, &result, 20, 13, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_bitmap_or(&status_rows, &sensor_rows, &result));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 60, ion_bitmap_cardinality(&result));
+
+	/* a value that no record has matches no rows */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 0, IONIZE(9, int), &result));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_bitmap_cardinality(&result));
+	bidx_test_count_rows(tc, &dictionary, &result, 1, 0, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, bidxdict_match(&dictionary, 2, IONIZE(1, int), &result));
+
+	ion_bitmap_free(&status_rows);
+	ion_bitmap_free(&sensor_rows);
+	ion_bitmap_free(&result);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that deletes and updates move rows between the bitmaps,
+			and that freed rows are reused.
+*/
+void
+test_bitmap_index_changes(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_bidx_dictionary_t		*index_dict;
+	ion_bidx_test_value_t		value;
+	ion_bitmap_t				rows;
+	ion_status_t				status;
+	int							count;
+	int							i;
+
+	bidx_test_create(tc, &inner_handler, &handler, &dictionary, 40);
+	index_dict = (ion_bidx_dictionary_t *) dictionary.instance;
+	ion_bitmap_init(&rows);
+
+	/* read before the deletes, so the cursor meets rows freed under it */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 0, IONIZE(2, int), &rows));
+
+	for (i = 2; i < 40; i += 8) {
+		status = dictionary_delete(&dictionary, IONIZE(i, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	}
+
+	bidx_test_count_rows(tc, &dictionary, &rows, 8, 6, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 0, IONIZE(2, int), &rows));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, ion_bitmap_cardinality(&rows));
+
+	/* the freed rows are filled before the table grows */
+	for (i = 100; i < 105; i++) {
+		value = bidx_test_value(i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40, index_dict->row_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_bitmap_cardinality(&index_dict->free_rows));
+
+	/* an update moves the rows of the key to the bitmaps of its new value */
+	value			= bidx_test_value(7);
+	value.status	= 9;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(7, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 0, IONIZE(9, int), &rows));
+	bidx_test_count_rows(tc, &dictionary, &rows, 1000, 7, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 0, IONIZE(3, int), &rows));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10 + 1 - 1, ion_bitmap_cardinality(&rows));
+
+	/* the last record of a value takes the value out of the index */
+	value.status = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(7, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, index_dict->indexes[0].count);
+
+	/* an update of a missing key inserts it */
+	value = bidx_test_value(501);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(501, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bidxdict_match(&dictionary, 1, IONIZE(1, int), &rows));
+	bidx_test_count_rows(tc, &dictionary, &rows, 10, 1, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(501, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5010, value.reading);
+
+	ion_bitmap_free(&rows);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that fields outside the value are refused, and that an
+			unwrapped dictionary has no indexes.
+*/
+void
+test_bitmap_index_invalid(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_bidx_field_t			past_end = { sizeof(int), sizeof(ion_bidx_test_value_t) };
+	ion_bitmap_t				rows;
+	ion_dict_cursor_t			*cursor;
+
+	sldict_init(&inner_handler);
+	bidxdict_init(&handler);
+	ion_bitmap_init(&rows);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&inner_handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(ion_bidx_test_value_t), 7));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, bidxdict_wrap(&dictionary, &handler, &past_end, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, bidxdict_wrap(&dictionary, &handler, bidx_test_fields, 0));
+	PLANCK_UNIT_ASSERT_TRUE(tc, &inner_handler == dictionary.handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, bidxdict_match(&dictionary, 0, IONIZE(0, int), &rows));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, bidxdict_find_rows(&dictionary, &rows, &cursor));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+planck_unit_suite_t *
+bitmap_index_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bitmap_add_remove);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bitmap_and_or);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bitmap_index_match);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bitmap_index_changes);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bitmap_index_invalid);
+
+	return suite;
+}
+
+void
+runalltests_bitmap_index(
+) {
+	planck_unit_suite_t *suite = bitmap_index_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
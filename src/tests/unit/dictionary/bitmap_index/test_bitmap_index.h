@@ -0,0 +1,28 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the bitmaps and the bitmap indexes kept on other
+			dictionaries.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_BITMAP_INDEX_H_)
+#define TEST_BITMAP_INDEX_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/bitmap_index/bitmap_index_dictionary_handler.h"
+#include "../../../../dictionary/skip_list/skip_list_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_bitmap_index(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_BITMAP_INDEX_H_ */
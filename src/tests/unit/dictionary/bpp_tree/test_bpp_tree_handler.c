@@ -117,12 +117,2262 @@ run_bpptreehandler_generic_test_set_1(
 	cleanup_generic_dictionary_test(&test);
 }
 
+/**
+@brief		Loads and probes a tree through a small buffer pool, checking that
+			every key survives eviction and that the pool counters move.
+*/
+void
+bpptree_buffer_pool_check(
+	planck_unit_test_t		*tc,
+	ion_bpp_buffer_policy_t policy
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_buffer_stats_t		stats;
+	ion_bpp_external_address_t	rec;
+	char						*name		= "bppool.bpt";
+	int							num_keys	= 2000;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 16;
+	info.policy		= policy;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncNone;
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < num_keys; i++) {
+		int key = (i * 7919) % num_keys;
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &key, key * 2));
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, &i, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 2, rec);
+	}
+
+	bBufferStats(tree, &stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.hits > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.misses > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.evictions > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.writebacks <= stats.evictions);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+}
+
+void
+test_bpptree_buffer_pool_lrr(
+	planck_unit_test_t *tc
+) {
+	bpptree_buffer_pool_check(tc, bPolicyLRR);
+}
+
+void
+test_bpptree_buffer_pool_clock(
+	planck_unit_test_t *tc
+) {
+	bpptree_buffer_pool_check(tc, bPolicyClock);
+}
+
+/**
+@brief		Holds dirty nodes back for group writes and checks that, after
+			a sync, a second handle on the same file sees every key.
+*/
+void
+test_bpptree_group_commit(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_handle_t			reader;
+	ion_bpp_buffer_stats_t		stats;
+	ion_bpp_external_address_t	rec;
+	char						*name		= "bpgroup.bpt";
+	int							num_keys	= 2000;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 16;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 8;
+	info.syncPolicy = bSyncFsync;
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < num_keys; i++) {
+		int key = (i * 7919) % num_keys;
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &key, key * 2));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+
+	bBufferStats(tree, &stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.groupWrites > 0);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &reader));
+
+	for (i = 0; i < num_keys; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(reader, &i, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 2, rec);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(reader));
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+}
+
+/**
+@brief		Record source for the bulk load tests: even keys from zero, with
+			every hundredth key repeated once, and optionally one key out
+			of order.
+*/
+typedef struct {
+	int				next_key;	/**< Next key to hand out. */
+	int				num_keys;	/**< Number of distinct keys. */
+	ion_boolean_t	repeat;		/**< Whether the current key is repeated. */
+	int				swap_at;	/**< Key that is handed out too early, or -1. */
+} bpptree_bulk_source_t;
+
+ion_err_t
+bpptree_bulk_source_next(
+	void			*context,
+	ion_record_t	*record
+) {
+	bpptree_bulk_source_t	*source = context;
+	int						key;
+
+	if (source->next_key >= 2 * source->num_keys) {
+		return err_item_not_found;
+	}
+
+	key = source->next_key;
+
+	if (key == source->swap_at) {
+		key = 0;
+	}
+
+	*(int *) record->key	= key;
+	*(int *) record->value	= source->repeat ? -key : key * 3;
+
+	if ((0 == key % 200) && !source->repeat) {
+		source->repeat = boolean_true;
+	}
+	else {
+		source->repeat		= boolean_false;
+		source->next_key	+= 2;
+	}
+
+	return err_ok;
+}
+
+void
+bpptree_bulk_load_check(
+	planck_unit_test_t	*tc,
+	int					num_keys
+) {
+	ion_generic_test_t		test;
+	bpptree_bulk_source_t	source;
+	ion_status_t			status;
+	ion_predicate_t			predicate;
+	ion_dict_cursor_t		*cursor;
+	ion_record_t			record;
+	int						key;
+	int						value;
+	int						last;
+	int						found;
+	int						expected;
+	int						i;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	dictionary_test_init(&test, tc);
+
+	source.next_key = 0;
+	source.num_keys = num_keys;
+	source.repeat	= boolean_false;
+	source.swap_at	= -1;
+
+	expected		= num_keys + (num_keys + 99) / 100;
+	status			= bpptree_bulk_load(&test.dictionary, bpptree_bulk_source_next, &source);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, status.count);
+
+	/* every record comes back in order */
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	dictionary_find(&test.dictionary, &predicate, &cursor);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+	last			= -1;
+	found			= 0;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, key >= last);
+		PLANCK_UNIT_ASSERT_TRUE(tc, (value == key * 3) || (value == -key));
+		last = key;
+		found++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, found);
+
+	/* the tree keeps working for ordinary inserts, lookups and deletes */
+	for (i = 1; i < 2 * num_keys; i += 2) {
+		status = dictionary_insert(&test.dictionary, IONIZE(i, int), IONIZE(i * 3, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (i = 0; i < 2 * num_keys; i += 3) {
+		status = dictionary_delete(&test.dictionary, IONIZE(i, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (i = 0; i < 2 * num_keys; i++) {
+		status = dictionary_get(&test.dictionary, IONIZE(i, int), &value);
+
+		if (0 == i % 3) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_TRUE(tc, (value == i * 3) || (value == -i));
+		}
+	}
+
+	/* only an empty tree can be bulk loaded */
+	source.next_key = 0;
+	status			= bpptree_bulk_load(&test.dictionary, bpptree_bulk_source_next, &source);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, status.error);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+void
+test_bpptree_bulk_load_small(
+	planck_unit_test_t *tc
+) {
+	bpptree_bulk_load_check(tc, 5);
+}
+
+void
+test_bpptree_bulk_load_large(
+	planck_unit_test_t *tc
+) {
+	bpptree_bulk_load_check(tc, 5000);
+}
+
+void
+test_bpptree_bulk_load_out_of_order(
+	planck_unit_test_t *tc
+) {
+	ion_generic_test_t		test;
+	bpptree_bulk_source_t	source;
+	ion_status_t			status;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	dictionary_test_init(&test, tc);
+
+	source.next_key = 0;
+	source.num_keys = 100;
+	source.repeat	= boolean_false;
+	source.swap_at	= 50;
+
+	status			= bpptree_bulk_load(&test.dictionary, bpptree_bulk_source_next, &source);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, status.error);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+void
+bpptree_inline_values_check(
+	planck_unit_test_t	*tc,
+	int					value_size,
+	ion_boolean_t		expect_inline
+) {
+	ion_generic_test_t	test;
+	ion_status_t		status;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	ion_byte_t			value[64];
+	ion_byte_t			expected[64];
+	int					key;
+	int					found;
+	int					i;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), value_size, -1);
+	dictionary_test_init(&test, tc);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, expect_inline == ((ion_bpptree_t *) test.dictionary.instance)->inline_values);
+
+	/* three values under one key, newest last */
+	for (i = 0; i < 3; i++) {
+		memset(value, 'a' + i, value_size);
+		status = dictionary_insert(&test.dictionary, IONIZE(5, int), value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	status = dictionary_insert(&test.dictionary, IONIZE(7, int), value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+	/* a lookup sees the newest value */
+	memset(expected, 'c', value_size);
+	status = dictionary_get(&test.dictionary, IONIZE(5, int), value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(expected, value, value_size));
+
+	/* a cursor sees every value of the key, newest first */
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(5, int));
+	dictionary_find(&test.dictionary, &predicate, &cursor);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) value;
+	found			= 0;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		memset(expected, 'c' - found, value_size);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, key);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(expected, value, value_size));
+		found++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, found);
+
+	/* updates and deletes reach every value of the key */
+	memset(value, 'z', value_size);
+	status = dictionary_update(&test.dictionary, IONIZE(5, int), value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, status.count);
+
+	memset(expected, 'z', value_size);
+	status = dictionary_get(&test.dictionary, IONIZE(5, int), value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(expected, value, value_size));
+
+	status = dictionary_delete(&test.dictionary, IONIZE(5, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, status.count);
+
+	status = dictionary_get(&test.dictionary, IONIZE(5, int), value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+
+	status = dictionary_delete(&test.dictionary, IONIZE(7, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+void
+test_bpptree_inline_values(
+	planck_unit_test_t *tc
+) {
+	bpptree_inline_values_check(tc, sizeof(int), boolean_true);
+}
+
+void
+test_bpptree_wide_values(
+	planck_unit_test_t *tc
+) {
+	bpptree_inline_values_check(tc, 40, boolean_false);
+}
+
+/**
+@brief		Deletes every key of a tree whose values would leave the leaves
+			at their narrowest, which once left scatter looping forever.
+*/
+void
+test_bpptree_narrow_nodes(
+	planck_unit_test_t *tc
+) {
+	ion_generic_test_t	test;
+	ion_status_t		status;
+	ion_byte_t			value[16];
+	int					k;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), sizeof(value), -1);
+	dictionary_test_init(&test, tc);
+	memset(value, 'n', sizeof(value));
+
+	for (k = 0; k < 20; k++) {
+		status = dictionary_insert(&test.dictionary, IONIZE(k, int), value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (k = 0; k < 20; k++) {
+		status = dictionary_delete(&test.dictionary, IONIZE(k, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+		status = dictionary_get(&test.dictionary, IONIZE(k, int), value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	}
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+/**
+@brief		Churns a tree with several values per key, compacts its value
+			file and checks that each key's values are one run, in order.
+*/
+void
+bpptree_compact_values_check(
+	planck_unit_test_t	*tc,
+	int					value_size
+) {
+	ion_generic_test_t			test;
+	ion_bpptree_t				*bpptree;
+	ion_status_t				status;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_byte_t					value[40];
+	ion_bpp_external_address_t	rec;
+	ion_file_offset_t			next;
+	ion_file_offset_t			before;
+	int							record_size = sizeof(ion_file_offset_t) + value_size;
+	int							stored;
+	int							values;
+	int							found;
+	int							key;
+	int							k;
+	int							r;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), value_size, -1);
+	dictionary_test_init(&test, tc);
+	bpptree = (ion_bpptree_t *) test.dictionary.instance;
+	memset(value, 0, sizeof(value));
+
+	/* four values a key, interleaved, then a third of the keys churned */
+	for (r = 0; r < 4; r++) {
+		for (k = 0; k < 50; k++) {
+			*(int *) value	= k * 100 + r;
+			status			= dictionary_insert(&test.dictionary, IONIZE(k, int), value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		}
+	}
+
+	for (k = 0; k < 50; k += 3) {
+		status = dictionary_delete(&test.dictionary, IONIZE(k, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (r = 0; r < 2; r++) {
+		for (k = 0; k < 50; k += 3) {
+			*(int *) value	= k * 100 + r;
+			status			= dictionary_insert(&test.dictionary, IONIZE(k, int), value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		}
+	}
+
+	/* 17 keys hold two values, 33 hold four, the newest inline if it fits */
+	stored	= 17 * 2 + 33 * 4 - (bpptree->inline_values ? 50 : 0);
+	before	= ion_fend(bpptree->values.file_handle);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_compact_values(&test.dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, stored * record_size, ion_fend(bpptree->values.file_handle));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_fend(bpptree->values.file_handle) < before);
+
+	for (k = 0; k < 50; k++) {
+		values = (0 == k % 3) ? 2 : 4;
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(bpptree->tree, &k, &rec));
+
+		for (found = bpptree->inline_values ? 1 : 0; found < values; found++, rec = next) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lfb_get(&bpptree->values, rec, value_size, value, &next));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (found + 1 == values) ? ION_LFB_NULL : rec + record_size, next);
+		}
+
+		/* and every value is still there, newest first */
+		dictionary_build_predicate(&predicate, predicate_equality, IONIZE(k, int));
+		dictionary_find(&test.dictionary, &predicate, &cursor);
+
+		record.key		= (ion_key_t) &key;
+		record.value	= (ion_value_t) value;
+		found			= 0;
+
+		while (cs_cursor_active == cursor->next(cursor, &record)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, k * 100 + values - 1 - found, *(int *) value);
+			found++;
+		}
+
+		cursor->destroy(&cursor);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, values, found);
+	}
+
+	/* the bag is appended to as before */
+	*(int *) value	= -1;
+	status			= dictionary_insert(&test.dictionary, IONIZE(1, int), value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	status			= dictionary_delete(&test.dictionary, IONIZE(1, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, status.count);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+void
+test_bpptree_compact_values(
+	planck_unit_test_t *tc
+) {
+	bpptree_compact_values_check(tc, sizeof(int));
+	bpptree_compact_values_check(tc, 40);
+}
+
+/**
+@brief		Fills a tree with 8 byte keys in scattered order and checks that
+			lookups and a full scan see them in numeric order.
+*/
+void
+bpptree_wide_key_order_check(
+	planck_unit_test_t	*tc,
+	ion_key_type_t		key_type
+) {
+	ion_generic_test_t	test;
+	ion_status_t		status;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	uint64_t			key;
+	uint64_t			last;
+	int					value;
+	int					found;
+	int					i;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type, sizeof(uint64_t), sizeof(int), -1);
+	dictionary_test_init(&test, tc);
+
+	/* keys step across zero, and across the sign bit for unsigned keys */
+	for (i = 0; i < 500; i++) {
+		key		= (uint64_t) ((i * 211) % 500 - 250) << 40;
+		status	= dictionary_insert(&test.dictionary, &key, IONIZE((i * 211) % 500, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (i = 0; i < 500; i++) {
+		key		= (uint64_t) (i - 250) << 40;
+		status	= dictionary_get(&test.dictionary, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	dictionary_find(&test.dictionary, &predicate, &cursor);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+	found			= 0;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		if (0 != found) {
+			if (key_type_numeric_signed == key_type) {
+				PLANCK_UNIT_ASSERT_TRUE(tc, (int64_t) key > (int64_t) last);
+			}
+			else {
+				PLANCK_UNIT_ASSERT_TRUE(tc, key > last);
+			}
+		}
+
+		last = key;
+		found++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 500, found);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+void
+test_bpptree_signed_wide_keys(
+	planck_unit_test_t *tc
+) {
+	bpptree_wide_key_order_check(tc, key_type_numeric_signed);
+}
+
+void
+test_bpptree_unsigned_wide_keys(
+	planck_unit_test_t *tc
+) {
+	bpptree_wide_key_order_check(tc, key_type_numeric_unsigned);
+}
+
+/**
+@brief		Runs ranges whose lower bound falls between stored keys, with
+			lookups elsewhere in the tree in between cursor steps.
+*/
+void
+test_bpptree_range_scan(
+	planck_unit_test_t *tc
+) {
+	ion_generic_test_t	test;
+	ion_status_t		status;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	int					key;
+	int					value;
+	int					other;
+	int					found;
+	int					lower;
+	int					i;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	dictionary_test_init(&test, tc);
+
+	for (i = 0; i < 2000; i += 2) {
+		status = dictionary_insert(&test.dictionary, IONIZE(i, int), IONIZE(i * 3, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (lower = 1; lower < 2000; lower += 38) {
+		dictionary_build_predicate(&predicate, predicate_range, IONIZE(lower, int), IONIZE(lower + 40, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&test.dictionary, &predicate, &cursor));
+
+		record.key		= (ion_key_t) &key;
+		record.value	= (ion_value_t) &value;
+		found			= 0;
+
+		while (cs_cursor_active == cursor->next(cursor, &record)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, lower + 1 + 2 * found, key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 3, value);
+			found++;
+
+			/* moves the tree's own position, but not the cursor's */
+			dictionary_get(&test.dictionary, IONIZE(1998 - key, int), &other);
+		}
+
+		cursor->destroy(&cursor);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (lower + 40 < 2000) ? 20 : (1999 - lower) / 2, found);
+	}
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+/**
+@brief		Checks that two open trees keep separate statistics, and that a
+			reset starts the counters over.
+*/
+void
+test_bpptree_stats(
+	planck_unit_test_t *tc
+) {
+	ion_generic_test_t			busy;
+	ion_dictionary_handler_t	idle_handler;
+	ion_dictionary_t			idle;
+	ion_bpptree_stats_t			stats;
+	int							value;
+	int							i;
+
+	init_generic_dictionary_test(&busy, bpptree_init, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	dictionary_test_init(&busy, tc);
+
+	/* the generic test always uses id 1, the idle tree needs other files */
+	bpptree_init(&idle_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&idle_handler, &idle, 2, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+
+	/* enough keys to split the root however large the nodes are */
+	for (i = 0; i < 2000; i++) {
+		dictionary_insert(&busy.dictionary, IONIZE(i, int), IONIZE(i, int));
+	}
+
+	for (i = 0; i < 100; i++) {
+		dictionary_get(&busy.dictionary, IONIZE(i, int), &value);
+	}
+
+	dictionary_update(&busy.dictionary, IONIZE(1, int), IONIZE(2, int));
+	dictionary_delete(&busy.dictionary, IONIZE(1, int));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_stats(&busy.dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2000, stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, stats.get.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.update.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.remove.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2000, stats.tree.keysIns);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.tree.keysDel);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.tree.maxHeight > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.tree.hitRate <= 1000);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_stats(&idle, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.tree.keysIns);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.tree.buffers.misses);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_reset_stats(&busy.dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_stats(&busy.dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.tree.keysIns);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.tree.maxHeight > 0);
+
+	dictionary_delete_dictionary(&idle);
+	cleanup_generic_dictionary_test(&busy);
+}
+
+/**
+@brief		Grows and shrinks a tree of wide string keys with inline values,
+			so that internal nodes, which leave the values out, split and
+			join, and checks every key and value along the way.
+*/
+void
+test_bpptree_wide_string_keys(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_stats_t				stats;
+	ion_bpp_external_address_t	rec;
+	char						*name		= "bpwide.bpt";
+	int							num_keys	= 3000;
+	char						key[32];
+	char						value[16];
+	char						expected[16];
+	int							j;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(key);
+	info.valueSize	= sizeof(value);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 512;
+	info.comp		= dictionary_compare_char_array;
+	info.bufCt		= 16;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncNone;
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < num_keys; i++) {
+		j = (i * 7919) % num_keys;
+		memset(key, 0, sizeof(key));
+		memset(value, 0, sizeof(value));
+		sprintf(key, "customer/%05d", j);
+		sprintf(value, "v%d", j);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKeyValue(tree, key, value, j));
+	}
+
+	for (i = 0; i < num_keys; i += 2) {
+		memset(key, 0, sizeof(key));
+		sprintf(key, "customer/%05d", i);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, key, &rec));
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		memset(key, 0, sizeof(key));
+		sprintf(key, "customer/%05d", i);
+
+		if (0 == i % 2) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrKeyNotFound == bFindKey(tree, key, &rec));
+			continue;
+		}
+
+		memset(expected, 0, sizeof(expected));
+		sprintf(expected, "v%d", i);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, key, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bCurrentValue(tree, value));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(expected, value, sizeof(value)));
+	}
+
+	bStats(tree, &stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.maxHeight >= 2);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+}
+
+/**
+@brief		Size of a file in bytes, or -1 if it can't be read.
+*/
+long
+bpptree_file_size(
+	char *name
+) {
+	FILE	*file;
+	long	size;
+
+	if (NULL == (file = fopen(name, "rb"))) {
+		return -1;
+	}
+
+	size = (0 == fseek(file, 0, SEEK_END)) ? ftell(file) : -1;
+	fclose(file);
+	return size;
+}
+
+/**
+@brief		Slides a window of keys along, checking that freed nodes are
+			reused instead of growing the file, then thins the tree out and
+			checks that compaction shrinks the file and loses no key.
+*/
+void
+test_bpptree_free_nodes(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_stats_t				stats;
+	ion_bpp_external_address_t	rec;
+	char						*name	= "bpfree.bpt";
+	int							window	= 500;
+	int							rounds	= 6000;
+	long						peak;
+	long						size;
+	int							key;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 16;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncFlush;	/* the file is measured through another handle */
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	peak = 0;
+
+	for (i = 0; i < rounds; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &i, i));
+
+		if (i >= window) {
+			key = i - window;
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &key, &rec));
+		}
+
+		if (i == 2 * window) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+			peak = bpptree_file_size(name);
+		}
+	}
+
+	/* the window never holds more keys, so the file barely grows */
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+	size = bpptree_file_size(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, peak > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, size <= 2 * peak);
+
+	/* keep every tenth key of the window */
+	for (i = rounds - window; i < rounds; i++) {
+		if (0 != i % 10) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &i, &rec));
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+	bStats(tree, &stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.freeNodes > 0);
+	size = bpptree_file_size(name);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bCompact(tree));
+	bStats(tree, &stats);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.freeNodes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptree_file_size(name) < size);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = rounds - window; i < rounds; i++) {
+		if (0 == i % 10) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, &i, &rec));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrKeyNotFound == bFindKey(tree, &i, &rec));
+		}
+	}
+
+	/* the compacted tree still takes inserts */
+	for (i = 0; i < window; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &i, i));
+	}
+
+	for (i = 0; i < window; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, &i, &rec));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+}
+
+/**
+@brief		Inserts and deletes pseudo-random keys in a tree of small nodes,
+			then checks that exactly the keys still held are found. Keys
+			are drawn from [0, key_range), at most 1000.
+*/
+void
+bpptree_churn_check(
+	planck_unit_test_t	*tc,
+	int					sector_size,
+	int					key_range,
+	int					rounds,
+	unsigned int		seed
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	char						*name = "bpchurn.bpt";
+	char						held[1000];
+	int							key;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = sector_size;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 16;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncNone;
+	info.compress	= boolean_false;
+
+	memset(held, 0, sizeof(held));
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < rounds; i++) {
+		seed	= seed * 1103515245U + 12345U;
+		key		= (seed >> 8) % key_range;
+
+		if (held[key]) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &key, &rec));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, rec);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &key, key));
+		}
+
+		held[key] = !held[key];
+	}
+
+	for (key = 0; key < key_range; key++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, (held[key] ? bErrOk : bErrKeyNotFound) == bFindKey(tree, &key, &rec));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+}
+
+/**
+@brief		Churns keys through a tree of 10-key nodes. An insert that
+			became the first key of a leaf reached through an LT branch
+			once rewrote the ancestor's first separator instead of the one
+			the descent went right of, and later lookups went astray.
+*/
+void
+test_bpptree_separator_update(
+	planck_unit_test_t *tc
+) {
+	bpptree_churn_check(tc, 256, 1000, 2000, 1);
+}
+
+/**
+@brief		Churns keys through a tree of 6-key nodes, where scatter() has
+			to leave nodes short of half full. It once swung between two
+			and three children forever, and with that fixed, deletes that
+			only regathered a child at exactly half let one run dry.
+*/
+void
+test_bpptree_small_node_churn(
+	planck_unit_test_t *tc
+) {
+	bpptree_churn_check(tc, 160, 1000, 3000, 7);
+}
+
+/**
+@brief		Creates a tree with 1 KiB nodes through the master table and
+			checks that the page size is recorded and used again when the
+			dictionary is reopened.
+*/
+void
+test_bpptree_page_size(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_t				wide;
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_id_t				id;
+	char							name[ION_MAX_FILENAME_LENGTH];
+	char							wide_key[100];
+	long							size;
+	int								value;
+	int								i;
+
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_paged(&handler, &dictionary, key_type_numeric_signed, sizeof(int), sizeof(int), -1, 1024));
+	id = dictionary.instance->id;
+
+	for (i = 0; i < 1000; i++) {
+		dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i * 3, int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(id, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1024, config.page_size);
+
+	/* a root of 3 nodes, then whole nodes */
+	dictionary_get_filename(id, "bpt", name);
+	size = bpptree_file_size(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, size > 3 * 1024);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, size % 1024);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &dictionary, id));
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(i, int), &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, value);
+	}
+
+	/* the default nodes grow to fit keys too wide for them */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary(&handler, &wide, key_type_char_array, sizeof(wide_key), sizeof(int), -1));
+	memset(wide_key, 0, sizeof(wide_key));
+	strcpy(wide_key, "wide");
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&wide, wide_key, IONIZE(7, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&wide, wide_key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 7, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&wide));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_master_table());
+}
+
+/**
+@brief		Round trips pages through both codecs of the page codec and
+			checks that they reject what they cannot hold or decode.
+*/
+void
+test_bpptree_page_codec(
+	planck_unit_test_t *tc
+) {
+	ion_byte_t	page[512];
+	ion_byte_t	packed[600];
+	ion_byte_t	restored[512];
+	int32_t		keys[64];
+	int32_t		keys_out[64];
+	uint64_t	wide[16];
+	uint64_t	wide_out[16];
+	uint32_t	state = 12345;
+	int			len;
+	int			i;
+
+	/* repetitive entries shrink to a fraction */
+	for (i = 0; i < (int) sizeof(page); i++) {
+		page[i] = (ion_byte_t) ((0 == i % 16) ? i / 16 : 0);
+	}
+
+	len = page_codec_compress(page, sizeof(page), packed, sizeof(packed));
+	PLANCK_UNIT_ASSERT_TRUE(tc, len > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, len < (int) sizeof(page) / 2);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(page), page_codec_decompress(packed, len, restored, sizeof(restored)));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(page, restored, sizeof(page)));
+
+	/* a page too small for the output is refused, a truncated input comes up short */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, page_codec_decompress(packed, len, restored, sizeof(restored) - 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, page_codec_decompress(packed, len / 2, restored, sizeof(restored)) < (int) sizeof(page));
+
+	/* noise grows a little, and round trips all the same */
+	for (i = 0; i < (int) sizeof(page); i++) {
+		state	= state * 1103515245 + 12345;
+		page[i] = (ion_byte_t) (state >> 16);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, page_codec_compress(page, sizeof(page), packed, sizeof(page)));
+	len = page_codec_compress(page, sizeof(page), packed, sizeof(packed));
+	PLANCK_UNIT_ASSERT_TRUE(tc, len > (int) sizeof(page));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(page), page_codec_decompress(packed, len, restored, sizeof(restored)));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(page, restored, sizeof(page)));
+
+	/* ascending keys from a negative start take a byte each */
+	for (i = 0; i < 64; i++) {
+		keys[i] = -20 + 3 * i;
+	}
+
+	len = page_codec_delta_encode((ion_byte_t *) keys, sizeof(int32_t), 64, sizeof(int32_t), boolean_true, packed, sizeof(packed));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 64, len);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, len, page_codec_delta_decode(packed, len, (ion_byte_t *) keys_out, sizeof(int32_t), 64, sizeof(int32_t), boolean_true));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(keys, keys_out, sizeof(keys)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, page_codec_delta_encode((ion_byte_t *) keys, sizeof(int32_t), 64, sizeof(int32_t), boolean_true, packed, 63));
+
+	/* keys out of order still decode, through the wrap of the key width */
+	for (i = 0; i < 16; i++) {
+		wide[i] = (0 == i % 2) ? ~0ULL - i : (uint64_t) i << 40;
+	}
+
+	len = page_codec_delta_encode((ion_byte_t *) wide, sizeof(uint64_t), 16, sizeof(uint64_t), boolean_false, packed, sizeof(packed));
+	PLANCK_UNIT_ASSERT_TRUE(tc, len > 0);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, len, page_codec_delta_decode(packed, len, (ion_byte_t *) wide_out, sizeof(uint64_t), 16, sizeof(uint64_t), boolean_false));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(wide, wide_out, sizeof(wide)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, page_codec_delta_decode(packed, len - 1, (ion_byte_t *) wide_out, sizeof(uint64_t), 16, sizeof(uint64_t), boolean_false));
+}
+
+/**
+@brief		Copies a file as far as it has been written, as a crash could
+			leave it.
+*/
+void
+bpptree_copy_file_to(
+	char	*from,
+	char	*to
+) {
+	FILE	*in		= fopen(from, "rb");
+	FILE	*out	= fopen(to, "wb");
+	char	buffer[512];
+	size_t	got;
+
+	while ((NULL != in) && (NULL != out) && (0 < (got = fread(buffer, 1, sizeof(buffer), in)))) {
+		fwrite(buffer, 1, got, out);
+	}
+
+	if (NULL != in) {
+		fclose(in);
+	}
+
+	if (NULL != out) {
+		fclose(out);
+	}
+}
+
+/**
+@brief		Flips a byte of a file, as a write torn by a crash could.
+*/
+void
+bpptree_flip_byte(
+	char	*name,
+	long	at
+) {
+	FILE	*file = fopen(name, "r+b");
+	int		byte;
+
+	if (NULL == file) {
+		return;
+	}
+
+	fseek(file, at, SEEK_SET);
+	byte = fgetc(file);
+	fseek(file, at, SEEK_SET);
+	fputc(byte ^ 0xFF, file);
+	fclose(file);
+}
+
+/**
+@brief		Counts the keys from 0 up to @p num_keys a tree holds.
+*/
+int
+bpptree_count_keys(
+	ion_bpp_handle_t	tree,
+	int					num_keys
+) {
+	ion_bpp_external_address_t	rec;
+	int							found = 0;
+	int							i;
+
+	for (i = 0; i < num_keys; i++) {
+		found += (bErrOk == bFindKey(tree, &i, &rec));
+	}
+
+	return found;
+}
+
+/**
+@brief		Churns logged trees, plain and compressed, checking that they
+			are cleaned as they go, keep their keys across reopening and
+			shrink when compacted.
+*/
+void
+test_bpptree_log(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_stats_t				stats;
+	ion_bpp_external_address_t	rec;
+	char						*name		= "bplog.bpt";
+	int							num_keys	= 3000;
+	long						size;
+	int							value;
+	int							round;
+	int							pass;
+	int							key;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 16;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncFlush;	/* the file is measured through another handle */
+	info.compress	= boolean_false;
+	info.logged		= boolean_true;
+
+	for (pass = 0; pass < 2; pass++) {
+		info.compress	= (1 == pass);
+		info.logged		= boolean_true;
+		ion_fremove(name);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+		for (i = 0; i < num_keys; i++) {
+			key		= (i * 7919) % num_keys;
+			value	= key % 7;
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKeyValue(tree, &key, &value, key));
+		}
+
+		/* a quarter of the keys deleted and put back each round, committed each time */
+		for (round = 0; round < 8; round++) {
+			for (key = round % 4; key < num_keys; key += 4) {
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &key, &rec));
+			}
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+
+			for (key = round % 4; key < num_keys; key += 4) {
+				value = key % 7;
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKeyValue(tree, &key, &value, key));
+			}
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+		}
+
+		bStats(tree, &stats);
+		PLANCK_UNIT_ASSERT_TRUE(tc, stats.segmentsCleaned > 0);
+		PLANCK_UNIT_ASSERT_TRUE(tc, (long) stats.fileBytes == bpptree_file_size(name));
+
+		/* thinned out, then compacted */
+		for (key = 0; key < num_keys; key++) {
+			if (0 != key % 10) {
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &key, &rec));
+			}
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+		size = bpptree_file_size(name);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bCompact(tree));
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+		PLANCK_UNIT_ASSERT_TRUE(tc, bpptree_file_size(name) < size);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+
+		/* the file stays a log, whatever info asks */
+		info.compress	= boolean_false;
+		info.logged		= boolean_false;
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+		for (key = 0; key < num_keys; key++) {
+			if (0 != key % 10) {
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrKeyNotFound == bFindKey(tree, &key, &rec));
+				continue;
+			}
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, &key, &rec));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, rec);
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bCurrentValue(tree, &value));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key % 7, value);
+		}
+
+		/* the compacted log still takes inserts */
+		for (key = 1; key < num_keys; key += 10) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKeyValue(tree, &key, &value, key));
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * num_keys / 10, bpptree_count_keys(tree, num_keys));
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	}
+
+	ion_fremove(name);
+}
+
+/**
+@brief		Opens copies of a logged tree taken between commits, and with
+			either superblock torn, checking each is the tree of a commit.
+*/
+void
+test_bpptree_log_crash(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_handle_t			copy;
+	ion_bpp_external_address_t	rec;
+	char						*name	= "bplogc.bpt";
+	char						*image	= "bplogi.bpt";
+	int							found[2];
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= ION_BPP_MIN_BUFFER_COUNT;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncFlush;
+	info.compress	= boolean_false;
+	info.logged		= boolean_true;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < 500; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &i, i));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+
+	/* the small pool writes nodes back long before the next commit */
+	for (i = 500; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &i, i));
+	}
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &i, &rec));
+	}
+
+	bpptree_copy_file_to(name, image);
+	info.iName = image;
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &copy));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 500, bpptree_count_keys(copy, 500));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, bpptree_count_keys(copy, 1000) - 500);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(copy));
+
+	/* with one superblock torn, the other commit is the tree */
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bSync(tree));
+
+	for (i = 0; i < 2; i++) {
+		ion_fremove(image);
+		bpptree_copy_file_to(name, image);
+		bpptree_flip_byte(image, i * info.sectorSize + 8);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &copy));
+		found[i] = bpptree_count_keys(copy, 1000);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(copy));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, ((500 == found[0]) && (900 == found[1])) || ((900 == found[0]) && (500 == found[1])));
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+	ion_fremove(image);
+}
+
+/**
+@brief		Creates a logged dictionary through the master table and checks
+			that it is a log, and still one once opened again.
+*/
+void
+test_bpptree_log_option(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_id_t				id;
+	char							name[ION_MAX_FILENAME_LENGTH];
+	char							magic[4];
+	FILE							*file;
+	uint32_t						option;
+	int								value;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	bpptree_init(&handler);
+
+	memset(&config, 0, sizeof(config));
+	config.type				= key_type_numeric_signed;
+	config.key_size			= sizeof(int);
+	config.value_size		= sizeof(int);
+	config.dictionary_size	= -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_log_structured, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_from_config(&handler, &dictionary, &config));
+	id = dictionary.instance->id;
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i * 3, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary));
+
+	dictionary_get_filename(id, "bpt", name);
+	file = fopen(name, "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(magic), fread(magic, 1, sizeof(magic), file));
+	fclose(file);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp("IBPL", magic, sizeof(magic)));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(id, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&config, dictionary_option_log_structured, &option));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, option);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &dictionary, id));
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(i, int), &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_master_table());
+}
+
+/**
+@brief		Creates a tree through the master table with its buffer count
+			and compression set in its options, and one without, and
+			checks that both are kept in the master table and used again
+			when it is reopened: the one with options holds more buffers
+			and reads fewer bytes.
+*/
+void
+test_bpptree_options(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary[2];
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_info_t			info[2];
+	ion_bpp_stats_t					stats[2];
+	ion_dictionary_id_t				id[2];
+	uint32_t						option;
+	int								value;
+	int								pass;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	bpptree_init(&handler);
+
+	for (pass = 0; pass < 2; pass++) {
+		memset(&config, 0, sizeof(config));
+		config.type				= key_type_numeric_signed;
+		config.key_size			= sizeof(int);
+		config.value_size		= sizeof(int);
+		config.dictionary_size	= -1;
+		config.page_size		= 512;
+
+		if (1 == pass) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_buffer_count, 16));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_compression, 1));
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_from_config(&handler, &dictionary[pass], &config));
+		id[pass] = dictionary[pass].instance->id;
+
+		for (i = 0; i < 3000; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary[pass], IONIZE(i, int), IONIZE(i % 7, int)).error);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[pass]));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(id[0], &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get_option(&config, dictionary_option_buffer_count, &option));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(id[1], &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&config, dictionary_option_buffer_count, &option));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 16, option);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&config, dictionary_option_compression, &option));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, option);
+
+	for (pass = 0; pass < 2; pass++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &dictionary[pass], id[pass]));
+
+		for (i = 0; i < 3000; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary[pass], IONIZE(i, int), &value).error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i % 7, value);
+		}
+
+		info[pass].min_key	= NULL;
+		info[pass].max_key	= NULL;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_info(&dictionary[pass], &info[pass]));
+		bStats(((ion_bpptree_t *) dictionary[pass].instance)->tree, &stats[pass]);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, info[1].memory_bytes > info[0].memory_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2 * stats[1].bytesRead < stats[0].bytesRead);
+
+	for (pass = 0; pass < 2; pass++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary[pass]));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_master_table());
+}
+
+/**
+@brief		Fills a tree with compressed nodes and one without, and checks
+			that the compressed one reads far fewer bytes, finds every
+			key after a reopen and keeps its format when reopened with
+			compression off.
+*/
+void
+test_bpptree_compression(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_stats_t				stats;
+	ion_bpp_external_address_t	rec;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	char						*name		= "bpcomp.bpt";
+	int							num_keys	= 3000;
+	unsigned long				plain_bytes = 0;
+	int							value;
+	int							pass;
+	int							key;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 512;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 0;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncNone;
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	for (pass = 0; pass < 2; pass++) {
+		info.compress = (1 == pass);
+		ion_fremove(name);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+		for (i = 0; i < num_keys; i++) {
+			key		= 2 * i - num_keys;
+			value	= i % 7;
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKeyValue(tree, &key, &value, i));
+		}
+
+		/* every other key deleted, so nodes are joined and freed too */
+		for (i = 0; i < num_keys; i += 2) {
+			key = 2 * i - num_keys;
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bDeleteKey(tree, &key, &rec));
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+
+		/* the file keeps the format it was made with */
+		info.compress = boolean_false;
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+		for (i = 0; i < num_keys; i++) {
+			key = 2 * i - num_keys;
+
+			if (0 == i % 2) {
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrKeyNotFound == bFindKey(tree, &key, &rec));
+			}
+			else {
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, &key, &rec));
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+				PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bCurrentValue(tree, &value));
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i % 7, value);
+			}
+		}
+
+		bStats(tree, &stats);
+		PLANCK_UNIT_ASSERT_TRUE(tc, stats.diskReads > 0);
+
+		if (0 == pass) {
+			plain_bytes = stats.bytesRead;
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrNotEmpty == bSetCompression(tree, boolean_true));
+		}
+		else {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 2 * stats.bytesRead < plain_bytes);
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	}
+
+	ion_fremove(name);
+
+	/* a dictionary of uncompressed nodes can only start compressing while empty */
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_set_compression(&dictionary, boolean_true));
+
+	for (i = 0; i < num_keys; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i * 3, int)).error);
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(i, int), &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_set_compression(&dictionary, boolean_false));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(1, int), IONIZE(3, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_BPP_DEFAULT_COMPRESS ? err_ok : err_illegal_state, bpptree_set_compression(&dictionary, boolean_true));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that the node buffer pool can be resized while a walk of
+			the keys is under way, and that trees in a memory budget share
+			it by how busy they are.
+*/
+void
+test_bpptree_budget(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			busy;
+	ion_dictionary_t			quiet;
+	ion_bpptree_t				*busy_tree;
+	ion_bpptree_t				*quiet_tree;
+	char						*name		= "bpbudget.bpt";
+	int							num_keys	= 2000;
+	size_t						total;
+	size_t						granted;
+	int							value;
+	int							key;
+	int							i;
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = ION_BPPTREE_DEFAULT_PAGE_SIZE;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 0;
+	info.policy		= bPolicyClock;
+	info.groupCt	= 4;
+	info.syncPolicy = bSyncNone;
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < num_keys; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKeyValue(tree, &i, &i, i));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindFirstKey(tree, &key, &rec));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, key);
+
+	/* grown, then shrunk back, each time part way through the walk */
+	for (i = 1; i < num_keys; i++) {
+		if (num_keys / 3 == i) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bResize(tree, 64));
+		}
+		else if (2 * num_keys / 3 == i) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bResize(tree, 0));
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindNextKey(tree, &key, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrKeyNotFound == bFindNextKey(tree, &key, &rec));
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+
+	/* the minimums of two trees and 40 buffers to share, with nodes as
+	 * the handler makes them for int keys and values */
+	total = 2 * (size_t) bPoolSize(info, ION_BPP_MIN_BUFFER_COUNT) + 40 * (size_t) (bPoolSize(info, 1) - bPoolSize(info, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_budget_set(total));
+
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &busy, 1, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &quiet, 2, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	busy_tree	= (ion_bpptree_t *) busy.instance;
+	quiet_tree	= (ion_bpptree_t *) quiet.instance;
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2 * busy_tree->budget.minimum + 40 * (size_t) busy_tree->pool_buffer == total);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_out_of_memory, ion_budget_set(total - 1 - 40 * (size_t) busy_tree->pool_buffer));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_budget_set(total));
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, total == ion_budget_get(&granted));
+	PLANCK_UNIT_ASSERT_TRUE(tc, granted <= total);
+
+	for (i = 0; i < num_keys; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&busy, IONIZE(i, int), IONIZE(i * 3, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&quiet, IONIZE(1, int), IONIZE(2, int)).error);
+
+	for (i = 0; i < 4 * ION_MEMORY_BUDGET_PERIOD; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&busy, IONIZE(i % num_keys, int), &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i % num_keys) * 3, value);
+	}
+
+	/* the busy tree took most of what was spare, without going over */
+	PLANCK_UNIT_ASSERT_TRUE(tc, busy_tree->budget.granted - busy_tree->budget.minimum > 4 * (quiet_tree->budget.granted - quiet_tree->budget.minimum));
+	ion_budget_get(&granted);
+	PLANCK_UNIT_ASSERT_TRUE(tc, granted <= total);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&quiet, IONIZE(1, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&busy));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&quiet));
+
+	ion_budget_get(&granted);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == granted);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_budget_set(0));
+}
+
+/**
+@brief		Tests the page cache of the file layer with a few small pages,
+			so that writes are held, evicted and written back.
+*/
+void
+test_bpptree_file_cache(
+	planck_unit_test_t *tc
+) {
+	char					*name = "fcache.bin";
+	ion_file_handle_t		file;
+	ion_file_cache_stats_t	stats;
+	ion_byte_t				bytes[1000];
+	ion_byte_t				read[1000];
+	ion_byte_t				patch[4] = { 0xA1, 0xA2, 0xA3, 0xA4 };
+	int						i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, ion_file_cache_configure(4, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(4, 64));
+	ion_file_cache_reset_stats();
+
+	for (i = 0; i < 1000; i++) {
+		bytes[i] = (ion_byte_t) (i * 7);
+	}
+
+	ion_fremove(name);
+	file = ion_fopen(name);
+
+	for (i = 0; i < 1000; i += 10) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, i, 10, bytes + i));
+	}
+
+	/* the pages of the end of the file are still held, and count in it */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, ion_fend(file));
+
+	for (i = 0; i < 1000; i += 25) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, i, 25, read + i));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes, read, sizeof(bytes)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_incomplete_read, ion_fread_at(file, 990, 20, read));
+
+	ion_file_cache_stats(&stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.hits > stats.misses);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.evictions > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.write_backs >= 1000 / 64);
+
+	/* reads and writes at the position see the cached pages, and are seen by them */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 3, 4, patch));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fseek(file, 0, ION_FILE_START));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread(file, 10, read));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(patch, read + 3, 4));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 500, 10, read));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fseek(file, 502, ION_FILE_START));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, 4, patch));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 500, 10, read));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(patch, read + 2, 4));
+	memcpy(bytes + 3, patch, 4);
+	memcpy(bytes + 502, patch, 4);
+
+	/* a write past the end leaves zeros before it */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 1030, 4, patch));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 1000, 34, read));
+
+	for (i = 0; i < 30; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, read[i]);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(patch, read + 30, 4));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+
+	/* every page held was written on close */
+	file = ion_fopen(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1034, ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(0, 64));
+	ion_file_cache_reset_stats();
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 0, 1000, read));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes, read, sizeof(bytes)));
+	ion_file_cache_stats(&stats);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.misses);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	ion_fremove(name);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE));
+}
+
+/**
+@brief		Tests that reads and writes at an offset, past the page cache,
+			leave the position of a file where it was.
+*/
+void
+test_bpptree_file_positioned(
+	planck_unit_test_t *tc
+) {
+	char				*name = "fpos.bin";
+	ion_file_handle_t	file;
+	ion_byte_t			bytes[64];
+	ion_byte_t			read[64];
+	int					i;
+
+	for (i = 0; i < 64; i++) {
+		bytes[i] = (ion_byte_t) (i + 1);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(0, ION_FILE_CACHE_PAGE_SIZE));
+	ion_fremove(name);
+	file = ion_fopen(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, 8, bytes));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 8, 56, bytes + 8));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 0, 64, read));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes, read, sizeof(bytes)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_incomplete_read, ion_fread_at(file, 60, 8, read));
+
+#if defined(ION_FILE_POSIX)
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, ion_ftell(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread(file, 8, read));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes + 8, read, 8));
+#endif
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE));
+}
+
+/**
+@brief		Tests runs of bytes read and written together, across pages of
+			the cache and past it.
+*/
+void
+test_bpptree_file_vectors(
+	planck_unit_test_t *tc
+) {
+	char				*name = "fvec.bin";
+	ion_file_handle_t	file;
+	ion_file_vector_t	vectors[3];
+	ion_byte_t			bytes[100];
+	ion_byte_t			read[100];
+	int					pass;
+	int					i;
+
+	for (i = 0; i < 100; i++) {
+		bytes[i] = (ion_byte_t) (3 * i + 1);
+	}
+
+	/* pages of 16 bytes, then no cache at all */
+	for (pass = 0; pass < 2; pass++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(0 == pass ? 16 : 0, 16));
+		ion_fremove(name);
+		file = ion_fopen(name);
+
+		vectors[0].bytes		= bytes;
+		vectors[0].num_bytes	= 8;
+		vectors[1].bytes		= bytes + 8;
+		vectors[1].num_bytes	= 0;
+		vectors[2].bytes		= bytes + 8;
+		vectors[2].num_bytes	= 92;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwritev_at(file, 5, vectors, 3));
+
+		memset(read, 0, sizeof(read));
+		vectors[0].bytes		= read;
+		vectors[0].num_bytes	= 37;
+		vectors[1].bytes		= read + 37;
+		vectors[1].num_bytes	= 1;
+		vectors[2].bytes		= read + 38;
+		vectors[2].num_bytes	= 62;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_freadv_at(file, 5, vectors, 3));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes, read, sizeof(bytes)));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_incomplete_read, ion_freadv_at(file, 6, vectors, 3));
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	}
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE));
+}
+
+/**
+@brief		Tests transfers that straddle blocks of
+			@ref ION_FILE_DIRECT_ALIGNMENT, with the cache and without it,
+			which with @ref ION_FILE_DIRECT go through aligned buffers and
+			must leave the file exactly as long as what was written.
+*/
+void
+test_bpptree_file_direct(
+	planck_unit_test_t *tc
+) {
+	char				*name	= "fdirect.bin";
+	size_t				block	= ION_FILE_DIRECT_ALIGNMENT;
+	ion_file_handle_t	file;
+	ion_byte_t			*bytes;
+	ion_byte_t			*read;
+	int					pass;
+	size_t				i;
+
+	bytes	= malloc(3 * block + 1);
+	read	= malloc(3 * block + 1);
+	PLANCK_UNIT_ASSERT_TRUE(tc, (NULL != bytes) && (NULL != read));
+
+	for (i = 0; i < 3 * block + 1; i++) {
+		bytes[i] = (ion_byte_t) (7 * i + 3);
+	}
+
+	/* the default cache, then none, so the misaligned buffer goes to the file */
+	for (pass = 0; pass < 2; pass++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(0 == pass ? ION_FILE_CACHE_PAGES : 0, ION_FILE_CACHE_PAGE_SIZE));
+		ion_fremove(name);
+		file = ion_fopen(name);
+		PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 0, 1, bytes));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, ion_fend(file));
+
+		/* across the first block boundary, then a whole block from an odd address */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, block - 3, 10, bytes + block - 3));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, block + 7, ion_fend(file));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 2 * block, block, bytes + 2 * block + 1));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * block, ion_fend(file));
+
+		/* the bytes between are the ones written or the zeros of the gaps */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 0, 3 * block, read + 1));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bytes[0], read[1]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, read[2]);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes + block - 3, read + 1 + block - 3, 10));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, read[1 + block + 7]);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes + 2 * block + 1, read + 1 + 2 * block, block));
+
+		/* rewriting the middle of a block keeps the rest of it */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, block + 1, 2, bytes));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, block - 3, 10, read));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes + block - 3, read, 4));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes, read + 4, 2));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(bytes + block + 3, read + 6, 4));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * block, ion_fend(file));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_incomplete_read, ion_fread_at(file, 3 * block - 1, 2, read));
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	}
+
+	free(bytes);
+	free(read);
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE));
+}
+
+/**
+@brief		Finds the counters of a file by its name.
+@return		Whether it is counted.
+*/
+static ion_boolean_t
+bpptree_file_io_stats_find(
+	char				*name,
+	ion_file_io_stats_t *found
+) {
+	ion_file_io_stats_t stats[ION_FILE_STATS_FILES];
+	int					count = ion_file_io_stats(stats, ION_FILE_STATS_FILES);
+	int					i;
+
+	for (i = 0; i < count; i++) {
+		if (0 == strcmp(name, stats[i].name)) {
+			*found = stats[i];
+			return boolean_true;
+		}
+	}
+
+	return boolean_false;
+}
+
+/**
+@brief		Tests that the transfers reaching each file are counted for it,
+			attributed to the dictionary its name gives, and kept across
+			closing and opening it again.
+*/
+void
+test_bpptree_file_io_stats(
+	planck_unit_test_t *tc
+) {
+#if ION_FILE_STATS
+	char				*name = "fstats.bin";
+	ion_file_handle_t	file;
+	ion_file_io_stats_t stats;
+	ion_generic_test_t	test;
+	ion_byte_t			bytes[10];
+	int					i;
+
+	memset(bytes, 7, sizeof(bytes));
+	ion_file_io_stats_reset();
+
+	/* with no cache every call reaches the file */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(0, ION_FILE_CACHE_PAGE_SIZE));
+	ion_fremove(name);
+	file = ion_fopen(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 0, 10, bytes));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 2, 8, bytes));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fsync(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptree_file_io_stats_find(name, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, stats.dictionary_id);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !stats.open);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.writes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, stats.write_bytes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.reads);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, stats.read_bytes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.syncs);
+
+	/* opened again, it goes on from there */
+	file = ion_fopen(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fseek(file, 4, ION_FILE_START));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, 2, bytes));
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptree_file_io_stats_find(name, &stats));
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.open);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, stats.writes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 12, stats.write_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.seeks >= 1);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE));
+
+	/* the index and the values of a tree are told apart, both its own */
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), 40, -1);
+	dictionary_test_init(&test, tc);
+
+	for (i = 0; i < 200; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&test.dictionary, IONIZE(i, int), (ion_value_t) "a value too long to keep in the leaves!").error);
+	}
+
+	cleanup_generic_dictionary_test(&test);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptree_file_io_stats_find("1.bpt", &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.dictionary_id);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.write_bytes > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptree_file_io_stats_find("1.val", &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.dictionary_id);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.write_bytes >= 200 * (40 + sizeof(ion_file_offset_t)));
+
+	/* a reset forgets closed files */
+	ion_file_io_stats_reset();
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_file_io_stats(&stats, 1));
+#else
+	UNUSED(tc);
+#endif
+}
+
+/**
+@brief		Tests a tree kept in a file cache of pages smaller than its
+			nodes, which are read and written across several of them.
+*/
+void
+test_bpptree_small_file_cache(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	char						*name	= "bpcache.bpt";
+	int							count	= 2000;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(3, 48));
+
+	info.iName		= name;
+	info.keySize	= sizeof(int);
+	info.valueSize	= 0;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_compare_signed_value;
+	info.bufCt		= 4;
+	info.policy		= bPolicyLRR;
+	info.groupCt	= 0;
+	info.syncPolicy = bSyncNone;
+	info.compress	= boolean_false;
+	info.logged		= boolean_false;
+
+	ion_fremove(name);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < count; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bInsertKey(tree, &i, i * 2));
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bOpen(info, &tree));
+
+	for (i = 0; i < count; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bFindKey(tree, &i, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 2, rec);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bClose(tree));
+	ion_fremove(name);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_file_cache_configure(ION_FILE_CACHE_PAGES, ION_FILE_CACHE_PAGE_SIZE));
+}
+
+/**
+@brief		Checks that a cursor had to read some bytes of each value
+			reads those bytes and leaves the others of its record alone,
+			for values of @p value_size bytes.
+*/
+static void
+bpptree_projected_values_check(
+	planck_unit_test_t	*tc,
+	int					value_size
+) {
+	ion_generic_test_t	test;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	ion_byte_t			value[40];
+	ion_byte_t			read[40];
+	int					key;
+	int					found	= 0;
+	int					i;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), value_size, -1);
+	dictionary_test_init(&test, tc);
+
+	for (i = 0; i < 100; i++) {
+		memset(value, i, sizeof(value));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&test.dictionary, IONIZE(i, int), value).error);
+	}
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&test.dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, value_size, cursor->value_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, dictionary_cursor_project(cursor, 4, value_size - 3));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_cursor_project(cursor, 4, 2));
+
+	record.key		= (ion_key_t) &key;
+	record.value	= read;
+	memset(read, 0xEE, sizeof(read));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		for (i = 0; i < value_size; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ((4 <= i) && (i < 6)) ? key : 0xEE, read[i]);
+		}
+
+		memset(read, 0xEE, sizeof(read));
+		found++;
+
+		/* part way, every byte again */
+		if (50 == found) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_cursor_project(cursor, 0, value_size));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, read[0]);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, read[value_size - 1]);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_cursor_project(cursor, 4, 2));
+			memset(read, 0xEE, sizeof(read));
+			found++;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, found);
+	cursor->destroy(&cursor);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+/**
+@brief		Tests that only the bytes of values a cursor is projected to are
+			read, from the leaves and from the file of values alike.
+*/
+void
+test_bpptree_projected_values(
+	planck_unit_test_t *tc
+) {
+	bpptree_projected_values_check(tc, 8);
+	bpptree_projected_values_check(tc, 40);
+}
+
 planck_unit_suite_t *
 bpptreehandler_get_suite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, run_bpptreehandler_generic_test_set_1);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_buffer_pool_lrr);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_buffer_pool_clock);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_bulk_load_small);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_bulk_load_large);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_bulk_load_out_of_order);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_inline_values);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_wide_values);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_narrow_nodes);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_signed_wide_keys);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_unsigned_wide_keys);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_range_scan);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_group_commit);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_stats);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_wide_string_keys);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_free_nodes);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_separator_update);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_small_node_churn);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_page_size);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_page_codec);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_compression);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_options);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_log);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_log_crash);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_log_option);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_budget);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_file_cache);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_file_positioned);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_file_vectors);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_file_direct);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_file_io_stats);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_small_file_cache);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_compact_values);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_projected_values);
 
 	return suite;
 }
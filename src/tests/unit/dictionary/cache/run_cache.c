@@ -0,0 +1,8 @@
+#include "test_cache.h"
+
+int
+main(
+) {
+	runalltests_cache();
+	return 0;
+}
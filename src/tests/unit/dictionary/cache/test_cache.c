@@ -0,0 +1,324 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the cache put in front of other dictionaries, its hits,
+			evictions and the writes it passes through.
+*/
+/******************************************************************************/
+
+#include "test_cache.h"
+
+/**
+@brief		Creates a dictionary of int keys and values with @p init, and
+			wraps it in a cache of @p capacity records.
+*/
+static void
+cache_test_setup(
+	planck_unit_test_t			*tc,
+	void (*init)(ion_dictionary_handler_t *),
+	ion_dictionary_handler_t	*inner_handler,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_size_t		capacity
+) {
+	init(inner_handler);
+	cachedict_init(handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(inner_handler, dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 64));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, cachedict_wrap(dictionary, handler, capacity));
+}
+
+/**
+@brief		Gets a key and checks its value.
+*/
+static void
+cache_test_get(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					key,
+	int					expected
+) {
+	int				value	= 0;
+	ion_status_t	status	= dictionary_get(dictionary, IONIZE(key, int), &value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, value);
+}
+
+/**
+@brief		Checks the counters of a cache.
+*/
+static void
+cache_test_stats(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	uint32_t			hits,
+	uint32_t			misses,
+	uint32_t			evictions
+) {
+	ion_cache_stats_t stats;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, cachedict_get_stats(dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, hits, stats.hits);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, misses, stats.misses);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, evictions, stats.evictions);
+}
+
+/**
+@brief		Tests that gets read through once and are then answered from
+			the cache.
+*/
+void
+test_cache_read_through(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	int							value;
+	int							i;
+
+	cache_test_setup(tc, oafdict_init, &inner_handler, &handler, &dictionary, 8);
+
+	for (i = 0; i < 20; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i * 7, int)).error);
+	}
+
+	cache_test_get(tc, &dictionary, 3, 21);
+	cache_test_get(tc, &dictionary, 3, 21);
+	cache_test_get(tc, &dictionary, 5, 35);
+	cache_test_get(tc, &dictionary, 3, 21);
+	cache_test_stats(tc, &dictionary, 2, 2, 0);
+
+	/* a key that is not there is not cached either */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, IONIZE(20, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, IONIZE(20, int), &value).error);
+	cache_test_stats(tc, &dictionary, 2, 4, 0);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that updates, deletes and inserts are seen by the gets
+			that follow them.
+*/
+void
+test_cache_writes(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	int							value;
+	int							i;
+
+	cache_test_setup(tc, oafdict_init, &inner_handler, &handler, &dictionary, 8);
+
+	for (i = 0; i < 10; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i, int)).error);
+		cache_test_get(tc, &dictionary, i, i);
+	}
+
+	/* written through, so the next get is a hit */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(9, int), IONIZE(-9, int)).error);
+	cache_test_get(tc, &dictionary, 9, -9);
+	cache_test_stats(tc, &dictionary, 1, 10, 2);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, IONIZE(9, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, IONIZE(9, int), &value).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(9, int), IONIZE(90, int)).error);
+	cache_test_get(tc, &dictionary, 9, 90);
+	cache_test_stats(tc, &dictionary, 1, 12, 3);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that a cache smaller than the keys read keeps returning
+			the right values as it evicts, and keeps the keys read often.
+*/
+void
+test_cache_eviction(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_cache_stats_t			stats;
+	int							round;
+	int							i;
+
+	cache_test_setup(tc, bpptree_init, &inner_handler, &handler, &dictionary, 4);
+
+	for (i = 0; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i * 3, int)).error);
+	}
+
+	/* key 0 is read between every other key, so the clock nearly always finds it hot */
+	for (round = 0; round < 3; round++) {
+		for (i = 1; i < 50; i++) {
+			cache_test_get(tc, &dictionary, 0, 0);
+			cache_test_get(tc, &dictionary, i, i * 3);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, cachedict_get_stats(&dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * 3 * 49, stats.hits + stats.misses);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, stats.misses - 4, stats.evictions);
+	/* only the reads of key 0 can hit, nine in ten of them at least */
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.hits <= 3 * 49 && stats.hits * 10 >= 3 * 49 * 9);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that a duplicate insert does not leave a stale value in
+			the cache, and that cursors read the wrapped dictionary.
+*/
+void
+test_cache_duplicates_and_find(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	int							key;
+	int							value;
+	int							count;
+
+	cache_test_setup(tc, bpptree_init, &inner_handler, &handler, &dictionary, 8);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(4, int), IONIZE(1, int)).error);
+	cache_test_get(tc, &dictionary, 4, 1);
+
+	/* the insert drops the key, so the get reads whichever value the tree gives */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(4, int), IONIZE(2, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(4, int), &value).error);
+	cache_test_stats(tc, &dictionary, 0, 2, 0);
+
+	/* an update changes every record of the key */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, dictionary_update(&dictionary, IONIZE(4, int), IONIZE(3, int)).count);
+	cache_test_get(tc, &dictionary, 4, 3);
+
+	record.key		= &key;
+	record.value	= &value;
+	count			= 0;
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(4, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, value);
+		count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, count);
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that the counters are only read from dictionaries behind
+			a cache.
+*/
+void
+test_cache_stats_not_wrapped(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_cache_stats_t			stats;
+
+	oafdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 16));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, cachedict_get_stats(&dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that caches in a memory budget share it by how busy
+			they are, and keep returning the right values as they are
+			resized.
+*/
+void
+test_cache_budget(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			busy;
+	ion_dictionary_t			quiet;
+	ion_cache_dictionary_t		*busy_cache;
+	ion_cache_dictionary_t		*quiet_cache;
+	size_t						granted;
+	int							i;
+
+	oafdict_init(&inner_handler);
+	cachedict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_budget_set(1024));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&inner_handler, &busy, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 64));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, cachedict_wrap(&busy, &handler, 64));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&inner_handler, &quiet, 2, key_type_numeric_signed, sizeof(int), sizeof(int), 64));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, cachedict_wrap(&quiet, &handler, 64));
+	busy_cache	= (ion_cache_dictionary_t *) busy.instance;
+	quiet_cache = (ion_cache_dictionary_t *) quiet.instance;
+
+	/* neither fits all it asked for, so they are short of the limit */
+	PLANCK_UNIT_ASSERT_TRUE(tc, busy_cache->capacity < 64 && quiet_cache->capacity < 64);
+
+	for (i = 0; i < 40; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&busy, IONIZE(i, int), IONIZE(i * 5, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&quiet, IONIZE(i, int), IONIZE(-i, int)).error);
+		cache_test_get(tc, &quiet, i, -i);
+	}
+
+	for (i = 0; i < 4 * ION_MEMORY_BUDGET_PERIOD; i++) {
+		cache_test_get(tc, &busy, i % 40, (i % 40) * 5);
+	}
+
+	/* all 40 keys of the busy cache now fit, at the cost of the quiet one */
+	PLANCK_UNIT_ASSERT_TRUE(tc, busy_cache->capacity >= 40);
+	PLANCK_UNIT_ASSERT_TRUE(tc, quiet_cache->capacity < busy_cache->capacity / 4);
+	ion_budget_get(&granted);
+	PLANCK_UNIT_ASSERT_TRUE(tc, granted <= 1024);
+
+	for (i = 0; i < 40; i++) {
+		cache_test_get(tc, &quiet, i, -i);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&busy));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&quiet));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_budget_set(0));
+}
+
+planck_unit_suite_t *
+cache_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cache_read_through);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cache_writes);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cache_eviction);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cache_duplicates_and_find);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cache_stats_not_wrapped);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cache_budget);
+
+	return suite;
+}
+
+void
+runalltests_cache(
+) {
+	planck_unit_suite_t *suite = cache_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,28 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the cache put in front of other dictionaries.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_CACHE_H_)
+#define TEST_CACHE_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/cache/cache_dictionary_handler.h"
+#include "../../../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../../../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_cache(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_CACHE_H_ */
@@ -0,0 +1,8 @@
+#include "test_cuckoo_hash.h"
+
+int
+main(
+) {
+	runalltests_cuckoo_hash();
+	return 0;
+}
@@ -0,0 +1,273 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the operations and displacements of the cuckoo hash
+			table.
+*/
+/******************************************************************************/
+
+#include "test_cuckoo_hash.h"
+
+/**
+@brief		The page size of the small tables, holding 7 int records a page.
+*/
+#define ION_CKH_TEST_SMALL_PAGE 64
+
+/**
+@brief		Creates a table of int keys and values.
+*/
+static ion_err_t
+initialize_cuckoo_hash(
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	int					size,
+	int					page_size
+) {
+	cuckoo_hash->super.compare = dictionary_compare_signed_value;
+	return ckh_initialize(cuckoo_hash, 0, key_type_numeric_signed, sizeof(int), sizeof(int), size, page_size);
+}
+
+/**
+@brief		Asserts that every record of a table is in one of the two
+			distinct pages its key addresses, and that the table holds
+			@p expected records.
+*/
+static void
+check_cuckoo_hash_buckets(
+	planck_unit_test_t	*tc,
+	ion_cuckoo_hash_t	*cuckoo_hash,
+	int					expected
+) {
+	int bucket;
+	int records = 0;
+
+	for (bucket = 0; bucket < cuckoo_hash->header.bucket_count; bucket++) {
+		ion_byte_t	*page = ckh_read_page(cuckoo_hash, bucket);
+		int			slot;
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != page);
+
+		for (slot = 0; slot < cuckoo_hash->records_per_page; slot++) {
+			ion_byte_t	*record = ckh_page_slot(cuckoo_hash, page, slot);
+			int			buckets[2];
+
+			if (ION_CKH_IN_USE == *record) {
+				ckh_buckets_of(cuckoo_hash, record + 1, buckets);
+				PLANCK_UNIT_ASSERT_TRUE(tc, buckets[0] != buckets[1]);
+				PLANCK_UNIT_ASSERT_TRUE(tc, (bucket == buckets[0]) || (bucket == buckets[1]));
+				records++;
+			}
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, cuckoo_hash->header.record_count);
+}
+
+/**
+@brief		Tests that a new table is sized for the records it expects.
+*/
+void
+test_cuckoo_hash_initialize(
+	planck_unit_test_t *tc
+) {
+	ion_cuckoo_hash_t cuckoo_hash;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_cuckoo_hash(&cuckoo_hash, 100, 0));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_CKH_DEFAULT_PAGE_SIZE, cuckoo_hash.header.page_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_CKH_DEFAULT_PAGE_SIZE / 9, cuckoo_hash.records_per_page);
+	PLANCK_UNIT_ASSERT_TRUE(tc, cuckoo_hash.header.bucket_count * cuckoo_hash.records_per_page * ION_CKH_LOAD_PERCENT >= 100 * 100);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2 <= cuckoo_hash.header.bucket_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, cuckoo_hash.header.record_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, wc_insert_unique, cuckoo_hash.write_concern);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_destroy(&cuckoo_hash));
+}
+
+/**
+@brief		Tests inserts, queries, updates and deletes.
+*/
+void
+test_cuckoo_hash_insert_query_delete(
+	planck_unit_test_t *tc
+) {
+	ion_cuckoo_hash_t	cuckoo_hash;
+	int					key;
+	int					value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_cuckoo_hash(&cuckoo_hash, 50, 0));
+
+	for (key = 0; key < 20; key++) {
+		value = key * 3;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_insert(&cuckoo_hash, &key, &value).error);
+	}
+
+	key		= 7;
+	value	= 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, ckh_insert(&cuckoo_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_query(&cuckoo_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 21, value);
+
+	value = 100;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, ckh_update(&cuckoo_hash, &key, &value).count);
+	value = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_query(&cuckoo_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, value);
+
+	/* an update of an absent key inserts it */
+	key		= 50;
+	value	= 5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_update(&cuckoo_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 21, cuckoo_hash.header.record_count);
+
+	key = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_delete(&cuckoo_hash, &key).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ckh_delete(&cuckoo_hash, &key).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ckh_query(&cuckoo_hash, &key, &value).error);
+
+	check_cuckoo_hash_buckets(tc, &cuckoo_hash, 20);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_destroy(&cuckoo_hash));
+}
+
+/**
+@brief		Tests that a table of small pages fills to the load it is
+			sized for, displacing records to make room, and that every
+			record stays in one of its two pages.
+*/
+void
+test_cuckoo_hash_high_load(
+	planck_unit_test_t *tc
+) {
+	ion_cuckoo_hash_t	cuckoo_hash;
+	int					key;
+	int					value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_cuckoo_hash(&cuckoo_hash, 300, ION_CKH_TEST_SMALL_PAGE));
+
+	for (key = 0; key < 300; key++) {
+		value = key * 7;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_insert(&cuckoo_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 300 * 100 >= cuckoo_hash.header.bucket_count * cuckoo_hash.records_per_page * (ION_CKH_LOAD_PERCENT - 5));
+
+	for (key = 0; key < 300; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_query(&cuckoo_hash, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 7, value);
+	}
+
+	check_cuckoo_hash_buckets(tc, &cuckoo_hash, 300);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_destroy(&cuckoo_hash));
+}
+
+/**
+@brief		Tests that an insert into a full table fails with
+			@c err_max_capacity and leaves every record where it was.
+*/
+void
+test_cuckoo_hash_full(
+	planck_unit_test_t *tc
+) {
+	ion_cuckoo_hash_t	cuckoo_hash;
+	int					key;
+	int					value;
+	int					slots;
+
+	/* every key of a table of two pages may go in either */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_cuckoo_hash(&cuckoo_hash, 1, ION_CKH_TEST_SMALL_PAGE));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, cuckoo_hash.header.bucket_count);
+
+	slots = cuckoo_hash.header.bucket_count * cuckoo_hash.records_per_page;
+
+	for (key = 0; key < slots; key++) {
+		value = key;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_insert(&cuckoo_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_max_capacity, ckh_insert(&cuckoo_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ckh_query(&cuckoo_hash, &key, &value).error);
+
+	for (key = 0; key < slots; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_query(&cuckoo_hash, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+	}
+
+	check_cuckoo_hash_buckets(tc, &cuckoo_hash, slots);
+
+	/* a delete makes room again */
+	key = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_delete(&cuckoo_hash, &key).error);
+	key = slots;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_insert(&cuckoo_hash, &key, &value).error);
+
+	check_cuckoo_hash_buckets(tc, &cuckoo_hash, slots);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_destroy(&cuckoo_hash));
+}
+
+/**
+@brief		Tests that a closed table opens again with its records and
+			layout, whatever settings it is opened with.
+*/
+void
+test_cuckoo_hash_reopen(
+	planck_unit_test_t *tc
+) {
+	ion_cuckoo_hash_t	cuckoo_hash;
+	ion_ckh_header_t	header;
+	int					key;
+	int					value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_cuckoo_hash(&cuckoo_hash, 100, ION_CKH_TEST_SMALL_PAGE));
+
+	for (key = 0; key < 100; key++) {
+		value = key + 1;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_insert(&cuckoo_hash, &key, &value).error);
+	}
+
+	header = cuckoo_hash.header;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_close(&cuckoo_hash));
+
+	/* a table of other sizes does not open it */
+	cuckoo_hash.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, ckh_initialize(&cuckoo_hash, 0, key_type_numeric_signed, sizeof(int), 2 * sizeof(int), 1, 0));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_cuckoo_hash(&cuckoo_hash, 1000, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(&header, &cuckoo_hash.header, sizeof(header)));
+
+	for (key = 0; key < 100; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_query(&cuckoo_hash, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key + 1, value);
+	}
+
+	check_cuckoo_hash_buckets(tc, &cuckoo_hash, 100);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ckh_destroy(&cuckoo_hash));
+}
+
+planck_unit_suite_t *
+cuckoo_hash_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cuckoo_hash_initialize);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cuckoo_hash_insert_query_delete);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cuckoo_hash_high_load);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cuckoo_hash_full);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cuckoo_hash_reopen);
+
+	return suite;
+}
+
+void
+runalltests_cuckoo_hash(
+) {
+	planck_unit_suite_t *suite = cuckoo_hash_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+
+	fremove("0.ckh");
+}
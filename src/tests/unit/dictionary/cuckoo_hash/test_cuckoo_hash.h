@@ -0,0 +1,26 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the cuckoo hash table.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_CUCKOO_HASH_H_)
+#define TEST_CUCKOO_HASH_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/cuckoo_hash/cuckoo_hash.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_cuckoo_hash(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_CUCKOO_HASH_H_ */
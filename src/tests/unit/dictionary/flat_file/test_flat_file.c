@@ -124,7 +124,9 @@ ftest_insert(
 
 		memset(expected_result, ION_FLAT_FILE_STATUS_OCCUPIED, sizeof(ion_flat_file_row_status_t));
 		memcpy(expected_result + sizeof(ion_flat_file_row_status_t), key, flat_file->super.record.key_size);
+#if !ION_FLAT_FILE_SPLIT_VALUES
 		memcpy(expected_result + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size, value, flat_file->super.record.value_size);
+#endif
 
 		ion_byte_t read_buffer[flat_file->row_size];
 
@@ -142,6 +144,15 @@ ftest_insert(
 				ion_err_t			err = flat_file_read_row(flat_file, cur_index, &test_row);
 
 				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
+#if ION_FLAT_FILE_SPLIT_VALUES
+
+				/* Only the key is in the data file, so a duplicate key may hold another value. */
+				if (0 != memcmp(test_row.value, value, flat_file->super.record.value_size)) {
+					fseek(flat_file->data_file, flat_file->start_of_data + ++cur_index * flat_file->row_size, SEEK_SET);
+					continue;
+				}
+
+#endif
 				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_FLAT_FILE_STATUS_OCCUPIED, test_row.row_status);
 				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(test_row.key, key, flat_file->super.record.key_size));
 				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(test_row.value, value, flat_file->super.record.value_size));
@@ -263,6 +274,58 @@ ftest_file_scan(
 	if (err_ok == expected_status) {
 		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, flat_file->super.compare(target_key, row.key, flat_file->super.record.key_size));
 	}
+
+	/* The typed scan must agree with the predicate scan. */
+	found_loc	= -1;
+	err			= flat_file_scan_match(flat_file, start_location, &found_loc, &row, scan_direction, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, target_key, NULL });
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_status, err);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_location, found_loc);
+
+	if (err_ok == expected_status) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, flat_file->super.compare(target_key, row.key, flat_file->super.record.key_size));
+	}
+}
+
+/**
+@brief		Asserts that a typed range scan finds the same rows as the range predicate,
+			in both directions and from every start location.
+*/
+void
+ftest_file_scan_match_range(
+	planck_unit_test_t	*tc,
+	ion_flat_file_t		*flat_file,
+	ion_key_t			lower_bound,
+	ion_key_t			upper_bound
+) {
+	ion_fpos_t			num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t			start;
+	ion_byte_t			direction;
+	ion_fpos_t			expected_loc;
+	ion_fpos_t			found_loc;
+	ion_flat_file_row_t row;
+	ion_err_t			expected;
+	ion_err_t			err;
+
+	for (direction = ION_FLAT_FILE_SCAN_BACKWARDS; direction <= ION_FLAT_FILE_SCAN_FORWARDS; direction++) {
+		for (start = -1; start < num_rows; start++) {
+			expected_loc	= -1;
+			found_loc		= -1;
+			expected		= flat_file_scan(flat_file, start, &expected_loc, &row, direction, flat_file_predicate_within_bounds, lower_bound, upper_bound);
+			err				= flat_file_scan_match(flat_file, start, &found_loc, &row, direction, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_WITHIN_BOUNDS, lower_bound, upper_bound });
+
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, err);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_loc, found_loc);
+
+			expected_loc	= -1;
+			found_loc		= -1;
+			expected		= flat_file_scan(flat_file, start, &expected_loc, &row, direction, flat_file_predicate_not_empty);
+			err				= flat_file_scan_match(flat_file, start, &found_loc, &row, direction, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL });
+
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, err);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_loc, found_loc);
+		}
+	}
 }
 
 /**
@@ -449,6 +512,215 @@ test_flat_file_scan_cases_large_buf(
 	ftest_takedown(tc, &flat_file);
 }
 
+/**
+@brief		Tests that typed range scans agree with the predicate scans, both for
+			natively compared keys and for keys that go through the comparator.
+*/
+void
+test_flat_file_scan_match_ranges(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+
+	for (i = 0; i < 20; i++) {
+		ftest_insert(tc, &flat_file, IONIZE((i * 7) % 20 - 10, int), IONIZE(i, int), err_ok, 1, boolean_true);
+	}
+
+	ftest_file_scan_match_range(tc, &flat_file, IONIZE(-3, int), IONIZE(2, int));
+	ftest_file_scan_match_range(tc, &flat_file, IONIZE(8, int), IONIZE(50, int));
+	ftest_file_scan_match_range(tc, &flat_file, IONIZE(30, int), IONIZE(50, int));
+
+	ftest_takedown(tc, &flat_file);
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(short), sizeof(int), 3);
+
+	for (i = 0; i < 20; i++) {
+		ftest_insert(tc, &flat_file, IONIZE((i * 7) % 20 - 10, short), IONIZE(i, int), err_ok, 1, boolean_true);
+	}
+
+	ftest_file_scan_match_range(tc, &flat_file, IONIZE(-3, short), IONIZE(2, short));
+	ftest_file_scan_match_range(tc, &flat_file, IONIZE(-50, short), IONIZE(-9, short));
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Steps through every match of @p match one row at a time, the way a cursor
+			does, and checks that each block of rows is only loaded once.
+*/
+void
+ftest_file_scan_match_steps(
+	planck_unit_test_t		*tc,
+	ion_flat_file_t			*flat_file,
+	ion_byte_t				direction,
+	ion_flat_file_match_t	*match,
+	int						key_modulus
+) {
+	ion_fpos_t			num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t			loc			= -1;
+	ion_fpos_t			expected	= ION_FLAT_FILE_SCAN_FORWARDS == direction ? 0 : num_rows - 1;
+	ion_fpos_t			step		= ION_FLAT_FILE_SCAN_FORWARDS == direction ? 1 : -1;
+	ion_fpos_t			region		= -1;
+	int					num_loads	= 0;
+	ion_flat_file_row_t row;
+	ion_err_t			err;
+
+	while (err_ok == (err = flat_file_scan_match(flat_file, loc, &loc, &row, direction, match))) {
+		while ((NULL != match->lower_bound) && (expected % key_modulus != NEUTRALIZE(match->lower_bound, int))) {
+			expected += step;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, loc);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected % key_modulus, NEUTRALIZE(row.key, int));
+
+		if (region != flat_file->current_loaded_region) {
+			region = flat_file->current_loaded_region;
+			num_loads++;
+		}
+
+		/* The row is then read as a cache hit, as a cursor does. */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(flat_file, loc, &row));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected % key_modulus, NEUTRALIZE(row.key, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, region, flat_file->current_loaded_region);
+
+		expected	+= step;
+		loc			+= step;
+
+		if (-1 == loc) {
+			break;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == err || err_file_hit_eof == err);
+	PLANCK_UNIT_ASSERT_TRUE(tc, num_loads <= (num_rows + (ion_fpos_t) flat_file->num_buffered - 1) / (ion_fpos_t) flat_file->num_buffered);
+}
+
+/**
+@brief		Tests that scans started inside the loaded region finish it before reading on,
+			in both directions and for sparse and dense matches.
+*/
+void
+test_flat_file_scan_match_steps(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+
+	for (i = 0; i < 30; i++) {
+		ftest_insert(tc, &flat_file, IONIZE(i % 5, int), IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	ftest_file_scan_match_steps(tc, &flat_file, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL }, 5);
+	ftest_file_scan_match_steps(tc, &flat_file, ION_FLAT_FILE_SCAN_BACKWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL }, 5);
+	ftest_file_scan_match_steps(tc, &flat_file, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, IONIZE(3, int), NULL }, 5);
+	ftest_file_scan_match_steps(tc, &flat_file, ION_FLAT_FILE_SCAN_BACKWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, IONIZE(0, int), NULL }, 5);
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Tests that rows read through the mapping of the data file, where one is
+			used, see every write and follow the file as it grows.
+*/
+void
+test_flat_file_mapped_rows(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t		flat_file;
+	ion_flat_file_row_t row;
+	ion_fpos_t			loc;
+	int					i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 2);
+
+#if ION_FLAT_FILE_USE_MMAP
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != flat_file.map);
+#endif
+
+	for (i = 0; i < 500; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_insert(&flat_file, IONIZE(i, int), IONIZE(i, int)).error);
+
+		/* Each new row must be visible straight away, wherever it is read from. */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(&flat_file, i, &row));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, NEUTRALIZE(row.value, int));
+	}
+
+	ftest_update(tc, &flat_file, IONIZE(250, int), IONIZE(-1, int), err_ok, 1);
+	ftest_delete(tc, &flat_file, IONIZE(3, int), err_ok, 1, boolean_true);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_scan_match(&flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, IONIZE(250, int), NULL }));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 250, loc);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, NEUTRALIZE(row.value, int));
+
+	/* The last row was swapped into the hole left by the delete. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(&flat_file, 3, &row));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 499, NEUTRALIZE(row.key, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_hit_eof, flat_file_scan_match(&flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, IONIZE(3, int), NULL }));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 499, loc);
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Tests that a flat file given no dictionary size buffers a device block
+			of rows, and that long scans in both directions, which cross several
+			read-ahead windows, find every row where it lies.
+*/
+void
+test_flat_file_long_scans(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t		flat_file;
+	ion_flat_file_row_t row;
+	ion_fpos_t			loc;
+	int					keys[1000];
+	int					num_rows = 0;
+	int					target;
+	int					i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_initialize(&flat_file, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+	flat_file.super.compare	= dictionary_compare_signed_value;
+	flat_file.super.id		= 0;
+	PLANCK_UNIT_ASSERT_TRUE(tc, flat_file.num_buffered > 1);
+	PLANCK_UNIT_ASSERT_TRUE(tc, flat_file.num_buffered * flat_file.row_size <= 65536);
+
+	while (num_rows < 20000) {
+		for (i = 0; i < 1000; i++) {
+			keys[i] = num_rows + i;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, flat_file_insert_batch(&flat_file, keys, keys, 1000).count);
+		num_rows += 1000;
+	}
+
+	for (target = 0; target < num_rows; target += 997) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_scan_match(&flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, &target, NULL }));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, target, loc);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, target, NEUTRALIZE(row.value, int));
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_scan_match(&flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_KEY, &target, NULL }));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, target, loc);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, target, NEUTRALIZE(row.value, int));
+	}
+
+	/* Walk the whole file one row at a time, backwards, as a reverse cursor does. */
+	loc = -1;
+
+	for (i = num_rows - 1; i >= 0; i--) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_scan_match(&flat_file, loc, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, &(ion_flat_file_match_t) { ION_FLAT_FILE_MATCH_NOT_EMPTY, NULL, NULL }));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, loc);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, NEUTRALIZE(row.key, int));
+		loc--;
+	}
+
+	ftest_takedown(tc, &flat_file);
+}
+
 /**
 @brief		Tests the deletion edge case of deleting the last thing in the flat file.
 */
@@ -521,6 +793,174 @@ test_flat_file_sort_binary_search_cases(
 	ftest_takedown(tc, &flat_file);
 }
 
+/**
+@brief		Checks a sorted search of every key from @p low to @p high against the
+			location where a linear walk of the rows finds it.
+*/
+void
+ftest_file_binary_search_walk(
+	planck_unit_test_t	*tc,
+	ion_flat_file_t		*flat_file,
+	int					low,
+	int					high
+) {
+	ion_fpos_t			num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_flat_file_row_t row;
+	ion_fpos_t			expected_loc;
+	ion_fpos_t			i;
+	int					target;
+
+	for (target = low; target <= high; target++) {
+		/* The first row equal to the target, or else the last row less than it. */
+		expected_loc = -1;
+
+		for (i = 0; i < num_rows; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(flat_file, i, &row));
+
+			if (NEUTRALIZE(row.key, int) < target) {
+				expected_loc = i;
+			}
+			else {
+				if (NEUTRALIZE(row.key, int) == target) {
+					expected_loc = i;
+				}
+
+				break;
+			}
+		}
+
+		ftest_file_binary_search(tc, flat_file, IONIZE(target, int), -1 == expected_loc ? err_item_not_found : err_ok, expected_loc);
+	}
+}
+
+/**
+@brief		Tests sorted searches that span many blocks, with duplicate runs that cross
+			block boundaries, as the search index grows with appends.
+*/
+void
+test_flat_file_sort_binary_search_many_blocks(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+	flat_file.sorted_mode = boolean_true;
+
+	ftest_file_binary_search_walk(tc, &flat_file, -2, 2);
+
+	for (i = 0; i < 40; i++) {
+		/* Keys 0, 2, 4, ... each repeated four times, so runs straddle blocks of three rows. */
+		ftest_insert(tc, &flat_file, IONIZE((i / 4) * 2, int), IONIZE(i, int), err_ok, 1, boolean_false);
+
+		if (0 == i % 7) {
+			ftest_file_binary_search_walk(tc, &flat_file, -2, 22);
+		}
+	}
+
+	ftest_file_binary_search_walk(tc, &flat_file, -2, 22);
+
+	ftest_takedown(tc, &flat_file);
+}
+
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+
+/**
+@brief		Checks a sorted search of every key from @p low to @p high against the
+			location found in @p keys, the keys of the rows in order.
+*/
+void
+ftest_file_binary_search_keys(
+	planck_unit_test_t	*tc,
+	ion_flat_file_t		*flat_file,
+	int					*keys,
+	int					count,
+	int					low,
+	int					high
+) {
+	int target;
+	int i;
+
+	for (target = low; target <= high; target++) {
+		/* The first row not less than the target. */
+		for (i = 0; i < count && keys[i] < target; i++) {}
+
+		if ((i < count) && (keys[i] == target)) {
+			ftest_file_binary_search(tc, flat_file, IONIZE(target, int), err_ok, i);
+		}
+		else {
+			ftest_file_binary_search(tc, flat_file, IONIZE(target, int), 0 == i ? err_item_not_found : err_ok, i - 1);
+		}
+	}
+}
+
+/**
+@brief		Tests that sorted searches through the learned model find what the rows hold,
+			that appends extend the model and that it is refit once rows move.
+*/
+void
+test_flat_file_sort_learned_index(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				*keys	= malloc(3200 * sizeof(int));
+	uint32_t		seed	= 1;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 32);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 3000; i++) {
+		keys[i] = i * 3;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3000, flat_file_insert_batch(&flat_file, keys, keys, 3000).count);
+	ftest_file_binary_search_keys(tc, &flat_file, keys, 3000, -2, 9001);
+
+	/* Evenly spread keys need a single segment. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, flat_file.num_segments);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3000, flat_file.learned_rows);
+
+	/* A long run of duplicates, then keys packed closer. */
+	for (i = 3000; i < 3200; i++) {
+		keys[i] = i < 3050 ? 9000 : 9000 + (i - 3049) * 2;
+		ftest_insert(tc, &flat_file, IONIZE(keys[i], int), IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3200, flat_file.learned_rows);
+	ftest_file_binary_search_keys(tc, &flat_file, keys, 3200, 8900, 9310);
+
+	/* Compaction moves rows, so the model is fit again by the next search. */
+	ftest_delete(tc, &flat_file, IONIZE(9000, int), err_ok, 50, boolean_false);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_compact(&flat_file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, flat_file.learned_rows);
+
+	memmove(keys + 3000, keys + 3050, 150 * sizeof(int));
+	ftest_file_binary_search_keys(tc, &flat_file, keys, 3150, 8990, 9310);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3150, flat_file.learned_rows);
+
+	ftest_takedown(tc, &flat_file);
+
+	/* Randomly spaced keys, with a buffer that leaves the model an error of 2 rows, need
+	   more segments than the model may take, so searches go to the fence index. */
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 3200; i++) {
+		seed	= seed * 1103515245 + 12345;
+		keys[i] = 0 == i ? 0 : keys[i - 1] + (0 == (seed >> 16) % 2 ? 1 : 40);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3200, flat_file_insert_batch(&flat_file, keys, keys, 3200).count);
+	ftest_file_binary_search_keys(tc, &flat_file, keys, 3200, keys[1500] - 50, keys[1500] + 50);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, flat_file.learned_rows);
+
+	ftest_takedown(tc, &flat_file);
+	free(keys);
+}
+
+#endif
+
 /**
 @brief		Tests a sorted get on an empty store.
 */
@@ -763,6 +1203,495 @@ test_flat_file_sort_update_many_exist_duplicates(
 	ftest_takedown(tc, &flat_file);
 }
 
+/**
+@brief		Counts the rows up to the EOF position of a flat file, deleted or not.
+*/
+ion_fpos_t
+ftest_num_rows(
+	ion_flat_file_t *flat_file
+) {
+	return (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+}
+
+/**
+@brief		Tests that sorted mode deletes leave tombstones that searches skip, and that
+			compaction, explicit or triggered by the tombstone count, packs the live rows.
+*/
+void
+test_flat_file_sort_delete_tombstones(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	ion_fpos_t		num_rows;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 40; i++) {
+		ftest_insert(tc, &flat_file, IONIZE(i / 2, int), IONIZE(i / 2 * 10, int), err_ok, 1, boolean_false);
+	}
+
+	ftest_delete(tc, &flat_file, IONIZE(4, int), err_ok, 2, boolean_true);
+	ftest_delete(tc, &flat_file, IONIZE(4, int), err_item_not_found, 0, boolean_true);
+	ftest_get(tc, &flat_file, IONIZE(4, int), err_item_not_found, NULL);
+	ftest_get(tc, &flat_file, IONIZE(3, int), err_ok, IONIZE(30, int));
+	ftest_get(tc, &flat_file, IONIZE(5, int), err_ok, IONIZE(50, int));
+
+	/* An upsert of a deleted key reuses its tombstone rather than breaking the order. */
+	ftest_update(tc, &flat_file, IONIZE(4, int), IONIZE(77, int), err_ok, 1);
+	ftest_get(tc, &flat_file, IONIZE(4, int), err_ok, IONIZE(77, int));
+
+	ftest_delete(tc, &flat_file, IONIZE(0, int), err_ok, 2, boolean_true);
+	ftest_delete(tc, &flat_file, IONIZE(19, int), err_ok, 2, boolean_true);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40, ftest_num_rows(&flat_file));
+	ftest_file_binary_search(tc, &flat_file, IONIZE(1, int), err_ok, 2);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_compact(&flat_file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 35, ftest_num_rows(&flat_file));
+	ftest_file_binary_search(tc, &flat_file, IONIZE(1, int), err_ok, 0);
+	ftest_get(tc, &flat_file, IONIZE(0, int), err_item_not_found, NULL);
+	ftest_get(tc, &flat_file, IONIZE(4, int), err_ok, IONIZE(77, int));
+	ftest_get(tc, &flat_file, IONIZE(18, int), err_ok, IONIZE(180, int));
+
+	/* Deleting over half of the rows compacts on the way. */
+	for (i = 5; i < 15; i++) {
+		ftest_delete(tc, &flat_file, IONIZE(i, int), err_ok, 2, boolean_true);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, ftest_num_rows(&flat_file) < 35);
+
+	for (i = 0; i < 20; i++) {
+		if ((0 == i) || ((i >= 5) && (i < 15)) || (19 == i)) {
+			ftest_get(tc, &flat_file, IONIZE(i, int), err_item_not_found, NULL);
+		}
+		else if (4 != i) {
+			ftest_get(tc, &flat_file, IONIZE(i, int), err_ok, IONIZE(i * 10, int));
+		}
+	}
+
+	/* The compacted file is cut to size, so a reopen finds no stale rows. */
+	num_rows = ftest_num_rows(&flat_file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+	flat_file.sorted_mode = boolean_true;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, num_rows, ftest_num_rows(&flat_file));
+	ftest_get(tc, &flat_file, IONIZE(18, int), err_ok, IONIZE(180, int));
+	ftest_get(tc, &flat_file, IONIZE(10, int), err_item_not_found, NULL);
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Tests that lookups stay correct while the Bloom filter, where one is kept,
+			answers misses, and that it survives a close and reopen, or its loss.
+*/
+void
+test_flat_file_bloom_filter(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	FILE			*bloom_file;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 200; i += 2) {
+		ftest_insert(tc, &flat_file, IONIZE(i, int), IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	for (i = 0; i < 200; i++) {
+		ftest_get(tc, &flat_file, IONIZE(i, int), 0 == i % 2 ? err_ok : err_item_not_found, IONIZE(i, int));
+	}
+
+	ftest_delete(tc, &flat_file, IONIZE(51, int), err_item_not_found, 0, boolean_false);
+	ftest_delete(tc, &flat_file, IONIZE(50, int), err_ok, 1, boolean_false);
+	ftest_get(tc, &flat_file, IONIZE(50, int), err_item_not_found, NULL);
+
+	/* The filter is saved next to the data file on close, and loaded on reopen. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+#if ION_FLAT_FILE_USE_BLOOM
+	bloom_file = fopen("0.ffb", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != bloom_file);
+	fclose(bloom_file);
+#endif
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 200; i++) {
+		ftest_get(tc, &flat_file, IONIZE(i, int), (0 == i % 2) && (50 != i) ? err_ok : err_item_not_found, IONIZE(i, int));
+	}
+
+	/* Without the sidecar, the filter is rebuilt from the rows, and must still hold the deleted key so that an update revives it in place. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+	fremove("0.ffb");
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	flat_file.sorted_mode = boolean_true;
+
+	ftest_get(tc, &flat_file, IONIZE(51, int), err_item_not_found, NULL);
+	ftest_update(tc, &flat_file, IONIZE(50, int), IONIZE(-50, int), err_ok, 1);
+	ftest_get(tc, &flat_file, IONIZE(50, int), err_ok, IONIZE(-50, int));
+	ftest_update(tc, &flat_file, IONIZE(201, int), IONIZE(201, int), err_ok, 1);
+	ftest_get(tc, &flat_file, IONIZE(201, int), err_ok, IONIZE(201, int));
+
+	/* Compaction rebuilds the filter from the rows that remain. */
+	for (i = 0; i < 100; i += 2) {
+		ftest_delete(tc, &flat_file, IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_compact(&flat_file));
+
+	for (i = 0; i < 202; i++) {
+		ftest_get(tc, &flat_file, IONIZE(i, int), ((i >= 100) && (i < 200) && (0 == i % 2)) || (201 == i) ? err_ok : err_item_not_found, IONIZE(i, int));
+	}
+
+	ftest_takedown(tc, &flat_file);
+
+	/* Destroying the flat file removes its sidecar too. */
+	bloom_file = fopen("0.ffb", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == bloom_file);
+}
+
+/**
+@brief		Tests that where the rows end is saved on close and trusted on reopen only
+			while the data file is as it was closed.
+*/
+void
+test_flat_file_saved_meta(
+	planck_unit_test_t *tc
+) {
+#if ION_FLAT_FILE_SAVE_META
+	ion_flat_file_t flat_file;
+	ion_fpos_t		eof_position;
+	FILE			*file;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 20; i++) {
+		ftest_insert(tc, &flat_file, IONIZE(i, int), IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	/* Sorted deletes leave tombstones, which a scan of the rows does not count. */
+	ftest_delete(tc, &flat_file, IONIZE(3, int), err_ok, 1, boolean_false);
+	ftest_delete(tc, &flat_file, IONIZE(7, int), err_ok, 1, boolean_false);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, flat_file.num_tombstones);
+	eof_position = flat_file.eof_position;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+	file = fopen("0.ffm", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	fclose(file);
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	flat_file.sorted_mode = boolean_true;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eof_position, flat_file.eof_position);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, flat_file.num_tombstones);
+	ftest_get(tc, &flat_file, IONIZE(19, int), err_ok, IONIZE(19, int));
+
+	/* Loading removes the sidecar, so a session cut short leaves none. */
+	file = fopen("0.ffm", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == file);
+
+	/* A data file grown since it was closed is scanned. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+	file = fopen("0.ffs", "ab");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, fwrite(&(ion_flat_file_row_status_t) { ION_FLAT_FILE_STATUS_EMPTY }, sizeof(ion_flat_file_row_status_t), 1, file));
+	fclose(file);
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	flat_file.sorted_mode = boolean_true;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, eof_position, flat_file.eof_position);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, flat_file.num_tombstones);
+	ftest_get(tc, &flat_file, IONIZE(19, int), err_ok, IONIZE(19, int));
+
+	/* Destroying the flat file removes the sidecar its close saves. */
+	ftest_takedown(tc, &flat_file);
+	file = fopen("0.ffm", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == file);
+#else
+	UNUSED(tc);
+#endif
+}
+
+/**
+@brief		Tests records whose values are much larger than their keys, through
+			swap deletes, tombstones and compaction, in whichever layout is built.
+*/
+void
+test_flat_file_large_values(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	ion_byte_t		value[200];
+	int				i;
+
+	for (i = 0; i < 2; i++) {
+		ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(value), 4);
+		flat_file.sorted_mode = 1 == i;
+
+#if ION_FLAT_FILE_SPLIT_VALUES
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(ion_flat_file_row_status_t) + sizeof(int), flat_file.row_size);
+#else
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(ion_flat_file_row_status_t) + sizeof(int) + sizeof(value), flat_file.row_size);
+#endif
+
+		int key;
+
+		for (key = 0; key < 40; key++) {
+			memset(value, key, sizeof(value));
+			ftest_insert(tc, &flat_file, IONIZE(key, int), value, err_ok, 1, boolean_true);
+		}
+
+		for (key = 0; key < 40; key += 3) {
+			ftest_delete(tc, &flat_file, IONIZE(key, int), err_ok, 1, boolean_false);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_compact(&flat_file));
+		memset(value, 0xFF, sizeof(value));
+		ftest_update(tc, &flat_file, IONIZE(20, int), value, err_ok, 1);
+
+		for (key = 0; key < 40; key++) {
+			memset(value, 20 == key ? 0xFF : key, sizeof(value));
+			ftest_get(tc, &flat_file, IONIZE(key, int), 0 == key % 3 ? err_item_not_found : err_ok, value);
+		}
+
+		ftest_takedown(tc, &flat_file);
+	}
+}
+
+/**
+@brief		Tests point operations on an unsorted flat file with duplicate keys while it
+			grows and shrinks, which the key index, where one is kept, must follow.
+*/
+void
+test_flat_file_key_index(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				keys[100];
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 8);
+
+	/* The first lookup of a stored key builds the index while the file is small, so the inserts after it grow the index. */
+	ftest_insert(tc, &flat_file, IONIZE(-1, int), IONIZE(-1, int), err_ok, 1, boolean_false);
+	ftest_get(tc, &flat_file, IONIZE(-1, int), err_ok, IONIZE(-1, int));
+	ftest_delete(tc, &flat_file, IONIZE(-1, int), err_ok, 1, boolean_false);
+
+	for (i = 0; i < 100; i++) {
+		keys[i] = i;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, flat_file_insert_batch(&flat_file, keys, keys, 100).count);
+
+	for (i = 0; i < 400; i++) {
+		ftest_insert(tc, &flat_file, IONIZE(i % 100, int), IONIZE(i % 100, int), err_ok, 1, boolean_false);
+	}
+
+#if ION_FLAT_FILE_USE_INDEX
+	PLANCK_UNIT_ASSERT_TRUE(tc, flat_file.index_ready);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 500, flat_file.index_count);
+#endif
+
+	/* Each delete swaps rows of other keys in from the end of the file. */
+	for (i = 0; i < 100; i += 2) {
+		ftest_delete(tc, &flat_file, IONIZE(i, int), err_ok, 5, boolean_false);
+	}
+
+	for (i = 1; i < 100; i += 4) {
+		ftest_update(tc, &flat_file, IONIZE(i, int), IONIZE(-i, int), err_ok, 5);
+	}
+
+	ftest_update(tc, &flat_file, IONIZE(1000, int), IONIZE(1000, int), err_ok, 1);
+	ftest_delete(tc, &flat_file, IONIZE(98, int), err_item_not_found, 0, boolean_false);
+
+#if ION_FLAT_FILE_USE_INDEX
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 251, flat_file.index_count);
+#endif
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_compact(&flat_file));
+
+	for (i = 0; i < 100; i++) {
+		ftest_get(tc, &flat_file, IONIZE(i, int), 0 == i % 2 ? err_item_not_found : err_ok, IONIZE(1 == i % 4 ? -i : i, int));
+	}
+
+	ftest_get(tc, &flat_file, IONIZE(1000, int), err_ok, IONIZE(1000, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 251, ftest_num_rows(&flat_file));
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Tests batched appends, in both modes, and that a sorted batch is only
+			written if all of it keeps the order.
+*/
+void
+test_flat_file_insert_batch(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				keys[10];
+	int				values[10];
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+
+	for (i = 0; i < 10; i++) {
+		keys[i]		= 9 - i;
+		values[i]	= i;
+	}
+
+	ion_status_t status = flat_file_insert_batch(&flat_file, keys, values, 10);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, ftest_num_rows(&flat_file));
+
+	for (i = 0; i < 10; i++) {
+		ftest_get(tc, &flat_file, IONIZE(i, int), err_ok, IONIZE(9 - i, int));
+	}
+
+	ftest_takedown(tc, &flat_file);
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+	flat_file.sorted_mode = boolean_true;
+
+	for (i = 0; i < 10; i++) {
+		keys[i]		= i * 2;
+		values[i]	= i;
+	}
+
+	status = flat_file_insert_batch(&flat_file, keys, values, 10);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, status.count);
+	ftest_file_binary_search_walk(tc, &flat_file, -1, 19);
+
+	/* Out of order within the batch */
+	keys[0] = 20;
+	keys[1] = 24;
+	keys[2] = 22;
+	status	= flat_file_insert_batch(&flat_file, keys, values, 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, ftest_num_rows(&flat_file));
+
+	/* Out of order with the rows already stored */
+	keys[0] = 17;
+	keys[1] = 20;
+	keys[2] = 22;
+	status	= flat_file_insert_batch(&flat_file, keys, values, 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, ftest_num_rows(&flat_file));
+
+	keys[0] = 18;
+	status	= flat_file_insert_batch(&flat_file, keys, values, 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 13, ftest_num_rows(&flat_file));
+	ftest_file_binary_search_walk(tc, &flat_file, -1, 23);
+	ftest_insert(tc, &flat_file, IONIZE(23, int), IONIZE(0, int), err_ok, 1, boolean_true);
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Checks that the span of every range from @p low to @p high gives the
+			rows a walk of the file finds within it, read @p max rows at a time.
+*/
+void
+ftest_file_span_walk(
+	planck_unit_test_t	*tc,
+	ion_flat_file_t		*flat_file,
+	int					low,
+	int					high,
+	int					max
+) {
+	ion_fpos_t				num_rows = ftest_num_rows(flat_file);
+	ion_flat_file_span_t	span;
+	ion_flat_file_row_t		row;
+	ion_fpos_t				i;
+	int						keys[4];
+	int						values[4];
+	int						lower;
+	int						upper;
+	int						count;
+	int						j;
+
+	for (lower = low; lower <= high; lower++) {
+		for (upper = lower - 1; upper <= high; upper++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_find_span(flat_file, IONIZE(lower, int), IONIZE(upper, int), &span));
+			i		= 0;
+			count	= 0;
+			j		= 0;
+
+			/* Each row read must be the next occupied row in range, in file order. */
+			do {
+				if (j == count) {
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_span(flat_file, &span, keys, values, max, &count));
+					j = 0;
+				}
+
+				for (; i < num_rows; i++) {
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(flat_file, i, &row));
+
+					if ((ION_FLAT_FILE_STATUS_OCCUPIED == row.row_status) && (NEUTRALIZE(row.key, int) >= lower) && (NEUTRALIZE(row.key, int) <= upper)) {
+						break;
+					}
+				}
+
+				if (j == count) {
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, num_rows, i);
+					break;
+				}
+
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, NEUTRALIZE(row.key, int), keys[j]);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, NEUTRALIZE(row.value, int), values[j]);
+				i++;
+				j++;
+			} while (boolean_true);
+		}
+	}
+}
+
+/**
+@brief		Tests that spans of sorted files hold exactly the rows of their range,
+			across blocks, duplicate runs at either edge and tombstones.
+*/
+void
+test_flat_file_sort_spans(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t			flat_file;
+	ion_flat_file_span_t	span;
+	int						i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, flat_file_find_span(&flat_file, IONIZE(0, int), IONIZE(1, int), &span));
+
+	flat_file.sorted_mode = boolean_true;
+	ftest_file_span_walk(tc, &flat_file, -1, 1, 4);
+
+	for (i = 0; i < 60; i++) {
+		/* Keys 0, 2, 4, ... each repeated three times, so runs straddle blocks of three rows. */
+		ftest_insert(tc, &flat_file, IONIZE((i / 3) * 2, int), IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	ftest_file_span_walk(tc, &flat_file, -2, 40, 4);
+	ftest_file_span_walk(tc, &flat_file, 10, 20, 1);
+
+	ftest_delete(tc, &flat_file, IONIZE(0, int), err_ok, 3, boolean_true);
+	ftest_delete(tc, &flat_file, IONIZE(12, int), err_ok, 3, boolean_true);
+	ftest_delete(tc, &flat_file, IONIZE(38, int), err_ok, 3, boolean_true);
+	ftest_file_span_walk(tc, &flat_file, -2, 40, 4);
+	ftest_file_span_walk(tc, &flat_file, 8, 16, 2);
+
+	ftest_takedown(tc, &flat_file);
+}
+
 planck_unit_suite_t *
 flat_file_getsuite(
 ) {
@@ -771,13 +1700,26 @@ flat_file_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_create_destroy);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_insert_single);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_insert_many);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_insert_batch);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_bloom_filter);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_saved_meta);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_large_values);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_key_index);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_scan_cases_small_buf);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_scan_cases_large_buf);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_scan_match_ranges);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_scan_match_steps);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_mapped_rows);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_long_scans);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_delete_edge_case);
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_insert_bad_sort);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_insert_good_sort);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_binary_search_cases);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_binary_search_many_blocks);
+#if ION_FLAT_FILE_USE_LEARNED_INDEX
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_learned_index);
+#endif
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_get_empty);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_get_single_nonexist);
@@ -793,6 +1735,9 @@ flat_file_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_update_many_exist);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_update_many_exist_duplicates);
 
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_delete_tombstones);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_spans);
+
 	return suite;
 }
 
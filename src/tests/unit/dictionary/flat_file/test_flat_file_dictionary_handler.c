@@ -23,11 +23,96 @@
 
 #include "test_flat_file_dictionary_handler.h"
 
+/**
+@brief		Tests that range cursors of a sorted flat file give the records of
+			their range, one at a time and in batches, skipping deleted ones.
+*/
+void
+test_flat_file_handler_sorted_range(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	int							keys[8];
+	int							values[8];
+	int							key;
+	int							value;
+	int							lower;
+	int							upper;
+	int							expected;
+	int							read;
+	int							i;
+
+	ffdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 40, key_type_numeric_signed, sizeof(int), sizeof(int), 4));
+	((ion_flat_file_t *) dictionary.instance)->sorted_mode = boolean_true;
+
+	for (key = 0; key < 100; key++) {
+		value = key * 10;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+	}
+
+	key = 50;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dictionary_delete(&dictionary, &key).count);
+
+	record.key		= &key;
+	record.value	= &value;
+	expected		= 20;
+	lower	= 20;
+	upper	= 60;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_build_predicate(&predicate, predicate_range, &lower, &upper));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	while (cs_cursor_active == dictionary_next(cursor, &record)) {
+		expected += (50 == expected) ? 1 : 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected * 10, value);
+		expected++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 61, expected);
+	cursor->destroy(&cursor);
+
+	expected = 45;
+	lower	= 45;
+	upper	= 1000;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_build_predicate(&predicate, predicate_range, &lower, &upper));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	while (0 != (read = dictionary_next_batch(cursor, keys, values, 8))) {
+		for (i = 0; i < read; i++) {
+			expected += (50 == expected) ? 1 : 0;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, keys[i]);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected * 10, values[i]);
+			expected++;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, expected);
+	cursor->destroy(&cursor);
+
+	lower	= 200;
+	upper	= 300;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_build_predicate(&predicate, predicate_range, &lower, &upper));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, dictionary_next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
 planck_unit_suite_t *
 flat_file_handler_getsuite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_handler_sorted_range);
+
 	return suite;
 }
 
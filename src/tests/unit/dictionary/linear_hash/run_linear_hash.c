@@ -0,0 +1,8 @@
+#include "test_linear_hash.h"
+
+int
+main(
+) {
+	runalltests_linear_hash();
+	return 0;
+}
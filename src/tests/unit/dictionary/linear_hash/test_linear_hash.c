@@ -0,0 +1,335 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the operations and growth of the linear hash table.
+*/
+/******************************************************************************/
+
+#include "test_linear_hash.h"
+
+/**
+@brief		The page size of the small tables, holding 6 int records a page.
+*/
+#define ION_LH_TEST_SMALL_PAGE 64
+
+/**
+@brief		Creates a table of int keys and values.
+*/
+static ion_err_t
+initialize_linear_hash(
+	ion_linear_hash_t	*linear_hash,
+	int					size,
+	int					page_size,
+	ion_byte_t			hash_function
+) {
+	linear_hash->super.compare = dictionary_compare_signed_value;
+	return lh_initialize(linear_hash, 0, key_type_numeric_signed, sizeof(int), sizeof(int), size, page_size, hash_function);
+}
+
+/**
+@brief		Asserts that every record of a table is in the bucket its key
+			addresses, and that the table holds @p expected records.
+*/
+static void
+check_linear_hash_buckets(
+	planck_unit_test_t	*tc,
+	ion_linear_hash_t	*linear_hash,
+	int					expected
+) {
+	int bucket;
+	int records = 0;
+
+	for (bucket = 0; bucket < linear_hash->header.bucket_count; bucket++) {
+		int overflow = ION_LH_NO_PAGE;
+
+		do {
+			ion_byte_t	*page = lh_read_page(linear_hash, bucket, overflow);
+			int			slot;
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, NULL != page);
+
+			for (slot = 0; slot < linear_hash->records_per_page; slot++) {
+				ion_byte_t *record = lh_page_slot(linear_hash, page, slot);
+
+				if (ION_LH_IN_USE == *record) {
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bucket, lh_bucket_of(linear_hash, record + 1));
+					records++;
+				}
+			}
+
+			overflow = lh_page_link(page);
+		} while (ION_LH_NO_PAGE != overflow);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, linear_hash->header.record_count);
+}
+
+/**
+@brief		Tests that a new table is sized for the records it expects.
+*/
+void
+test_linear_hash_initialize(
+	planck_unit_test_t *tc
+) {
+	ion_linear_hash_t linear_hash;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 100, 0, hash_function_seeded));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_LH_DEFAULT_PAGE_SIZE, linear_hash.header.page_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (ION_LH_DEFAULT_PAGE_SIZE - 4) / 9, linear_hash.records_per_page);
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash.header.initial_buckets * linear_hash.records_per_page * ION_LH_SPLIT_PERCENT >= 100 * 100);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, linear_hash.header.initial_buckets, linear_hash.header.bucket_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, linear_hash.header.level);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, linear_hash.header.next_split);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, linear_hash.header.record_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, wc_insert_unique, linear_hash.write_concern);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_destroy(&linear_hash));
+}
+
+/**
+@brief		Tests inserts, queries, updates and deletes on a table that
+			does not grow.
+*/
+void
+test_linear_hash_insert_query_delete(
+	planck_unit_test_t *tc
+) {
+	ion_linear_hash_t	linear_hash;
+	int					key;
+	int					value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 50, 0, hash_function_seeded));
+
+	for (key = 0; key < 20; key++) {
+		value = key * 3;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	key		= 7;
+	value	= 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, lh_insert(&linear_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_query(&linear_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 21, value);
+
+	value = 100;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, lh_update(&linear_hash, &key, &value).count);
+	value = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_query(&linear_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, value);
+
+	/* an update of an absent key inserts it */
+	key		= 50;
+	value	= 5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_update(&linear_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 21, linear_hash.header.record_count);
+
+	key = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_delete(&linear_hash, &key).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, lh_delete(&linear_hash, &key).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, lh_query(&linear_hash, &key, &value).error);
+
+	check_linear_hash_buckets(tc, &linear_hash, 20);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_destroy(&linear_hash));
+}
+
+/**
+@brief		Tests that a table created for one record grows a bucket at a
+			time to hold many, keeping every record reachable.
+*/
+void
+test_linear_hash_growth(
+	planck_unit_test_t *tc
+) {
+	ion_linear_hash_t	linear_hash;
+	int					key;
+	int					value;
+	int					buckets;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 1, ION_LH_TEST_SMALL_PAGE, hash_function_seeded));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, linear_hash.records_per_page);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, linear_hash.header.bucket_count);
+
+	for (key = 0; key < 500; key++) {
+		value	= -key;
+		buckets = linear_hash.header.bucket_count;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+		/* growth is spread over the inserts, at most one bucket each */
+		PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash.header.bucket_count - buckets <= 1);
+	}
+
+	/* the table stays within its split threshold */
+	PLANCK_UNIT_ASSERT_TRUE(tc, (long) linear_hash.header.record_count * 100 <= (long) ION_LH_SPLIT_PERCENT * linear_hash.header.bucket_count * linear_hash.records_per_page);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, linear_hash.header.bucket_count, (linear_hash.header.initial_buckets << linear_hash.header.level) + linear_hash.header.next_split);
+
+	for (key = 0; key < 500; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_query(&linear_hash, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -key, value);
+	}
+
+	check_linear_hash_buckets(tc, &linear_hash, 500);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_destroy(&linear_hash));
+}
+
+/**
+@brief		Tests that keys sharing a bucket chain overflow pages, and that
+			the pages emptied by deletes are reused.
+*/
+void
+test_linear_hash_overflow(
+	planck_unit_test_t *tc
+) {
+	ion_linear_hash_t	linear_hash;
+	int					i;
+	int					key;
+	int					value = 1;
+	int					overflow_count;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 1, ION_LH_TEST_SMALL_PAGE, hash_function_modulo));
+
+	/* multiples of a large power of two stay in bucket 0 however the table grows */
+	for (i = 0; i < 20; i++) {
+		key = i << 20;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash.header.overflow_count >= 3);
+	check_linear_hash_buckets(tc, &linear_hash, 20);
+
+	for (i = 0; i < 20; i++) {
+		key = i << 20;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_query(&linear_hash, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_delete(&linear_hash, &key).error);
+	}
+
+	overflow_count = linear_hash.header.overflow_count;
+
+	for (i = 0; i < 20; i++) {
+		key = i << 21;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, overflow_count, linear_hash.header.overflow_count);
+	check_linear_hash_buckets(tc, &linear_hash, 20);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_destroy(&linear_hash));
+}
+
+/**
+@brief		Tests that the overflow pages a split empties are freed for
+			other chains.
+*/
+void
+test_linear_hash_split_frees_overflow(
+	planck_unit_test_t *tc
+) {
+	ion_linear_hash_t	linear_hash;
+	int					key;
+	int					value = 1;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 1, ION_LH_TEST_SMALL_PAGE, hash_function_modulo));
+
+	/* with the modulo hash, multiples of 4 stay in bucket 0 through the first two splits */
+	for (key = 0; key <= 16; key += 4) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, linear_hash.header.bucket_count);
+
+	/* the other even keys share bucket 0 until the second split, overflowing its page */
+	for (key = 2; key <= 14; key += 4) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, linear_hash.header.bucket_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, linear_hash.header.overflow_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_LH_NO_PAGE, linear_hash.header.free_overflow);
+
+	/* the second split moves them all to bucket 2, emptying the overflow page */
+	key = 18;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, linear_hash.header.bucket_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, linear_hash.header.free_overflow);
+	check_linear_hash_buckets(tc, &linear_hash, 10);
+
+	/* and the next chain to overflow takes the freed page */
+	for (key = 1; key <= 49; key += 8) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, linear_hash.header.overflow_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_LH_NO_PAGE, linear_hash.header.free_overflow);
+	check_linear_hash_buckets(tc, &linear_hash, 17);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_destroy(&linear_hash));
+}
+
+/**
+@brief		Tests that a closed table opens again with its records and
+			layout, whatever settings it is opened with.
+*/
+void
+test_linear_hash_reopen(
+	planck_unit_test_t *tc
+) {
+	ion_linear_hash_t	linear_hash;
+	ion_lh_header_t		header;
+	int					key;
+	int					value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 1, ION_LH_TEST_SMALL_PAGE, hash_function_seeded));
+
+	for (key = 0; key < 100; key++) {
+		value = key + 1;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_insert(&linear_hash, &key, &value).error);
+	}
+
+	header = linear_hash.header;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_close(&linear_hash));
+
+	/* a table of other sizes does not open it */
+	linear_hash.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, lh_initialize(&linear_hash, 0, key_type_numeric_signed, sizeof(int), 2 * sizeof(int), 1, 0, hash_function_seeded));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_linear_hash(&linear_hash, 1000, 0, hash_function_modulo));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(&header, &linear_hash.header, sizeof(header)));
+
+	for (key = 0; key < 100; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_query(&linear_hash, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key + 1, value);
+	}
+
+	check_linear_hash_buckets(tc, &linear_hash, 100);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lh_destroy(&linear_hash));
+}
+
+planck_unit_suite_t *
+linear_hash_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_initialize);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_insert_query_delete);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_growth);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_overflow);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_split_frees_overflow);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_reopen);
+
+	return suite;
+}
+
+void
+runalltests_linear_hash(
+) {
+	planck_unit_suite_t *suite = linear_hash_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+
+	fremove("0.lhb");
+	fremove("0.lho");
+}
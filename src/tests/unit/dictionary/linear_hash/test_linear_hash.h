@@ -0,0 +1,26 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the linear hash table.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_LINEAR_HASH_H_)
+#define TEST_LINEAR_HASH_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/linear_hash/linear_hash.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_linear_hash(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_LINEAR_HASH_H_ */
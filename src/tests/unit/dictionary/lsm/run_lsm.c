@@ -0,0 +1,8 @@
+#include "test_lsm.h"
+
+int
+main(
+) {
+	runalltests_lsm();
+	return 0;
+}
@@ -0,0 +1,332 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the flushes, merges and tombstones of the log-structured
+			merge tree.
+*/
+/******************************************************************************/
+
+#include "test_lsm.h"
+
+/**
+@brief		The number of records the memtables of the tests hold, so that
+			a few dozen inserts flush and merge runs.
+*/
+#define ION_LSM_TEST_MEMTABLE 8
+
+/**
+@brief		Creates a tree of int keys and values.
+*/
+static ion_err_t
+initialize_lsm(
+	ion_lsm_t *lsm
+) {
+	lsm->super.compare = dictionary_compare_signed_value;
+	return lsm_initialize(lsm, 0, key_type_numeric_signed, sizeof(int), sizeof(int), ION_LSM_TEST_MEMTABLE);
+}
+
+/**
+@brief		Asserts that the runs of a tree are newest first, their levels
+			never decreasing and no level holding a full fanout of runs.
+*/
+static void
+check_lsm_levels(
+	planck_unit_test_t	*tc,
+	ion_lsm_t			*lsm
+) {
+	int i;
+	int same = 1;
+
+	for (i = 1; i < lsm->header.run_count; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, lsm->runs[i - 1].info.level <= lsm->runs[i].info.level);
+		PLANCK_UNIT_ASSERT_TRUE(tc, lsm->runs[i - 1].info.number > lsm->runs[i].info.number);
+
+		same = (lsm->runs[i - 1].info.level == lsm->runs[i].info.level) ? same + 1 : 1;
+		PLANCK_UNIT_ASSERT_TRUE(tc, same < ION_LSM_FANOUT);
+	}
+}
+
+/**
+@brief		Asserts that a merge over the whole tree reads @p expected live
+			keys, in ascending order, each with the value @p offset above
+			it.
+*/
+static void
+check_lsm_merge(
+	planck_unit_test_t	*tc,
+	ion_lsm_t			*lsm,
+	int					expected,
+	int					offset
+) {
+	ion_lsm_merge_t merge;
+	int				records = 0;
+	int				last	= -1;
+	int				key;
+	int				value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_merge_start(lsm, &merge, boolean_true, 0, lsm->header.run_count, NULL));
+
+	while (err_ok == lsm_merge_next(&merge)) {
+		if (ION_LSM_TOMBSTONE == merge.current[sizeof(int)]) {
+			continue;
+		}
+
+		memcpy(&key, merge.current, sizeof(int));
+		memcpy(&value, merge.current + sizeof(int) + 1, sizeof(int));
+		PLANCK_UNIT_ASSERT_TRUE(tc, key > last);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key + offset, value);
+		last = key;
+		records++;
+	}
+
+	lsm_merge_stop(&merge);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, records);
+}
+
+/**
+@brief		Tests that records are found once the memtable is flushed, and
+			that full levels are merged into the next.
+*/
+void
+test_lsm_flush_and_merge(
+	planck_unit_test_t *tc
+) {
+	ion_lsm_t	lsm;
+	int			key;
+	int			value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_lsm(&lsm));
+
+	/* descending, so every run overlaps the ones before it */
+	for (key = 199; key >= 0; key--) {
+		value = key + 1;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, lsm_insert(&lsm, &key, &value).count);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 200 / ION_LSM_TEST_MEMTABLE, lsm.flushes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, lsm.merges > 0);
+	PLANCK_UNIT_ASSERT_TRUE(tc, lsm.header.run_count < 200 / ION_LSM_TEST_MEMTABLE);
+	check_lsm_levels(tc, &lsm);
+
+	for (key = 0; key < 200; key++) {
+		value = 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_query(&lsm, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key + 1, value);
+	}
+
+	key = 200;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, lsm_query(&lsm, &key, &value).error);
+
+	check_lsm_merge(tc, &lsm, 200, 1);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_destroy(&lsm));
+}
+
+/**
+@brief		Tests that the newest value of a key wins, in queries and
+			merges alike.
+*/
+void
+test_lsm_newest_wins(
+	planck_unit_test_t *tc
+) {
+	ion_lsm_t	lsm;
+	int			key;
+	int			value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_lsm(&lsm));
+
+	for (key = 0; key < 40; key++) {
+		value = key;
+		lsm_insert(&lsm, &key, &value);
+	}
+
+	/* the even keys get newer values, in runs that cover the old ones */
+	for (key = 0; key < 40; key += 2) {
+		value = key + 100;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, lsm_update(&lsm, &key, &value).count);
+	}
+
+	for (key = 0; key < 40; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_query(&lsm, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == key % 2) ? key + 100 : key, value);
+	}
+
+	for (key = 1; key < 40; key += 2) {
+		value = key + 100;
+		lsm_update(&lsm, &key, &value);
+	}
+
+	check_lsm_merge(tc, &lsm, 40, 100);
+	check_lsm_levels(tc, &lsm);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_destroy(&lsm));
+}
+
+/**
+@brief		Tests that deletes hide keys held by runs, and that compaction
+			drops the tombstones along with the keys.
+*/
+void
+test_lsm_tombstones(
+	planck_unit_test_t *tc
+) {
+	ion_lsm_t	lsm;
+	int			key;
+	int			value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_lsm(&lsm));
+
+	/* with no runs yet, deletes take records out of the memtable */
+	for (key = 0; key < 4; key++) {
+		value = key;
+		lsm_insert(&lsm, &key, &value);
+	}
+
+	key = 2;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, lsm_delete(&lsm, &key).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, lsm.memtable.count);
+
+	for (key = 4; key < 64; key++) {
+		value = key;
+		lsm_insert(&lsm, &key, &value);
+	}
+
+	for (key = 0; key < 64; key += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (2 == key) ? err_item_not_found : err_ok, lsm_delete(&lsm, &key).error);
+	}
+
+	for (key = 0; key < 64; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == key % 2) ? err_item_not_found : err_ok, lsm_query(&lsm, &key, &value).error);
+	}
+
+	key = 10;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, lsm_delete(&lsm, &key).error);
+	check_lsm_merge(tc, &lsm, 32, 0);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_compact(&lsm));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, lsm.header.run_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 32, lsm.runs[0].info.records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, lsm.memtable.count);
+
+	/* a key deleted before the compaction can come back */
+	key		= 10;
+	value	= 7;
+	lsm_insert(&lsm, &key, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_query(&lsm, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 7, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_destroy(&lsm));
+}
+
+/**
+@brief		Tests that a merge started from a key reads the keys from it
+			on, in every source.
+*/
+void
+test_lsm_merge_from_key(
+	planck_unit_test_t *tc
+) {
+	ion_lsm_t		lsm;
+	ion_lsm_merge_t merge;
+	int				key;
+	int				value;
+	int				expected;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_lsm(&lsm));
+
+	/* every third key, so most keys sought lie between two in a run */
+	for (key = 0; key < 150; key += 3) {
+		value = key;
+		lsm_insert(&lsm, &key, &value);
+	}
+
+	key = 100;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_merge_start(&lsm, &merge, boolean_true, 0, lsm.header.run_count, &key));
+
+	for (expected = 102; expected < 150; expected += 3) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_merge_next(&merge));
+		memcpy(&key, merge.current, sizeof(int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, lsm_merge_next(&merge));
+	lsm_merge_stop(&merge);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_destroy(&lsm));
+}
+
+/**
+@brief		Tests that a closed tree opens with its records, deletes and
+			runs, and that a new tree of the same id starts empty.
+*/
+void
+test_lsm_reopen(
+	planck_unit_test_t *tc
+) {
+	ion_lsm_t	lsm;
+	int			key;
+	int			value;
+	int			runs;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_lsm(&lsm));
+
+	for (key = 0; key < 61; key++) {
+		value = key * 2;
+		lsm_insert(&lsm, &key, &value);
+	}
+
+	key = 5;
+	lsm_delete(&lsm, &key);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_close(&lsm));
+
+	lsm.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, lsm_open(&lsm, 0, key_type_numeric_signed, sizeof(int), 2 * sizeof(int), ION_LSM_TEST_MEMTABLE));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_open(&lsm, 0, key_type_numeric_signed, sizeof(int), sizeof(int), ION_LSM_TEST_MEMTABLE));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, lsm.memtable.count);
+	check_lsm_levels(tc, &lsm);
+
+	for (key = 0; key < 61; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (5 == key) ? err_item_not_found : err_ok, lsm_query(&lsm, &key, &value).error);
+
+		if (5 != key) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 2, value);
+		}
+	}
+
+	runs = lsm.header.run_count;
+	PLANCK_UNIT_ASSERT_TRUE(tc, runs > 0);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_close(&lsm));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_lsm(&lsm));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, lsm.header.run_count);
+	key = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, lsm_query(&lsm, &key, &value).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, lsm_destroy(&lsm));
+}
+
+planck_unit_suite_t *
+lsm_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_lsm_flush_and_merge);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_lsm_newest_wins);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_lsm_tombstones);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_lsm_merge_from_key);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_lsm_reopen);
+
+	return suite;
+}
+
+void
+runalltests_lsm(
+) {
+	planck_unit_suite_t *suite = lsm_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,26 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the log-structured merge tree.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_LSM_H_)
+#define TEST_LSM_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/lsm/lsm.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_lsm(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_LSM_H_ */
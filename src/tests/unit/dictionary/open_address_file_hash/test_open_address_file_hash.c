@@ -221,6 +221,9 @@ test_open_address_file_hashmap_find_item_location(
 			/* printf("current file pos: %i\n",(int)	ftell(map.file)); */
 		}
 
+		/* the buckets were written behind the map's back */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_rebuild_fingerprints(&map));
+
 		/* and now check key positions */
 		for (i = 0; i < map.map_size; i++) {
 			int location;
@@ -276,6 +279,9 @@ test_open_address_file_hashmap_simple_insert(
 			}
 		}
 
+		/* the file is read directly, so it has to be up to date */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_sync(&map));
+
 		for (i = 0; i < map.map_size; i++) {
 			/* set the position in the file */
 			fseek(map.file, ((((i + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), SEEK_SET);
@@ -979,6 +985,477 @@ test_open_address_file_hashmap_capacity(
 	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
 }
 
+/**
+@brief		Tests that sustained inserts and deletes of colliding keys
+			leave no tombstones behind and every live key reachable.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_churn(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_record_info_t	record;
+	ion_status_t		status;
+	int					i, j;
+	int					key;
+	int					value;
+	int					size		= 16;
+	int					num_live	= 12;
+	int					bucket_size;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_file_hash_map(size, &record, &map);
+	bucket_size			= SIZEOF(STATUS) + record.key_size + record.value_size;
+
+	/* keys are spread over a few home buckets only, so clusters form and wrap */
+	for (i = 0; i < 2000; i++) {
+		key		= (i % 5) * 3 + (i / 5) * size;
+		value	= i;
+		status	= oafh_insert(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+		if (i >= num_live - 1) {
+			j		= i - (num_live - 1);
+			key		= (j % 5) * 3 + (j / 5) * size;
+			status	= oafh_delete(&map, &key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		}
+
+		for (j = (i >= num_live - 1) ? i - (num_live - 2) : 0; j <= i; j++) {
+			key		= (j % 5) * 3 + (j / 5) * size;
+			status	= oafh_query(&map, &key, &value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, j, value);
+		}
+	}
+
+	ion_hash_bucket_t *item = malloc(bucket_size);
+
+	frewind(map.file);
+
+	for (i = 0; i < size; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 1 == fread(item, bucket_size, 1, map.file));
+		PLANCK_UNIT_ASSERT_TRUE(tc, ION_DELETED != item->status);
+	}
+
+	free(item);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief		Tests that the probe counters of a file map follow a cluster
+			that wraps around the end of the table, and that the bucket
+			counts match its contents.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_stats(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_record_info_t	record;
+	ion_hash_stats_t	stats;
+	int					keys[]	= { 0, 10, 20, 9, 19 };
+	int					i;
+	int					value	= 0;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_file_hash_map(10, &record, &map);
+
+	/* 0, 10 and 20 share bucket 0; 19 wraps from bucket 9 past them */
+	for (i = 0; i < 5; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &keys[i], &value).error);
+	}
+
+	i = 20;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &i, &value).error);
+	i = 30;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oafh_query(&map, &i, &value).error);
+	i = 10;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_delete(&map, &i).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_stats(&map, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, (int) stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 12, (int) stats.insert.probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, stats.insert.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, (int) stats.insert.histogram[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, (int) stats.insert.histogram[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) stats.insert.histogram[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, (int) stats.get.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, (int) stats.get.probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, stats.get.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) stats.remove.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, stats.remove.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) stats.wraps);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, stats.buckets);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, stats.occupied);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.deleted);
+
+	/* a reset clears the probe counters, not the bucket counts */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_reset_stats(&map));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_stats(&map, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (int) stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.get.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (int) stats.wraps);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, stats.occupied);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief	  Tests that the fingerprints follow the buckets, and spare the
+			file reads of lookups they rule out.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_fingerprints(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_record_info_t	record;
+	int					keys[]	= { 0, 10, 1, 2 };
+	int					i;
+	int					value	= 7;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_file_hash_map(10, &record, &map);
+
+	/* 0 and 10 share bucket 0, pushing 1 and 2 along */
+	for (i = 0; i < 4; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &keys[i], &value).error);
+	}
+
+	/* bucket 5 is free, so the lookup ends without reading the file */
+	i = 5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oafh_query(&map, &i, &value).error);
+#if ION_OAFH_USE_FINGERPRINTS
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, map.page.count);
+#endif
+
+	i = 2;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &i, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 7, value);
+
+	/* deleting 0 shifts 10, 1 and 2 back a bucket each */
+	i = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_delete(&map, &i).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oafh_query(&map, &i, &value).error);
+
+	for (i = 1; i < 4; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &keys[i], &value).error);
+	}
+
+#if ION_OAFH_USE_FINGERPRINTS
+	ion_byte_t fingerprints[10];
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != map.fingerprints);
+
+	for (i = 0; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == (map.fingerprints[i] & 0x80));
+	}
+
+	for (i = 3; i < 10; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0x80, map.fingerprints[i]);
+	}
+
+	/* rebuilding them from the file gives the same bytes */
+	memcpy(fingerprints, map.fingerprints, 10);
+	memset(map.fingerprints, 0x80, 10);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_rebuild_fingerprints(&map));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(fingerprints, map.fingerprints, 10));
+#endif
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief		Reads the status of a bucket straight from the file of a map.
+*/
+static char
+file_bucket_status(
+	ion_file_hashmap_t	*map,
+	int					loc
+) {
+	char status = 0;
+
+	/* a mapped file is written behind the stream, so drop what it has read */
+	fflush(map->file);
+	fseek(map->file, (long) loc * (SIZEOF(STATUS) + map->super.record.key_size + map->super.record.value_size), SEEK_SET);
+	fread(&status, SIZEOF(STATUS), 1, map->file);
+
+	return status;
+}
+
+/**
+@brief	  Tests that writes are held back in pages until they are synced,
+			or written back in one go once every page is in use.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_write_back(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_record_info_t	record;
+	int					i;
+	int					key;
+	int					value = 3;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_file_hash_map(1000, &record, &map);
+
+	int page = map.page.capacity;
+
+	/* a mapped file takes writes in place, holding nothing back */
+	ion_boolean_t held_back = ION_OAFH_WRITE_BACK_PAGES > 0;
+
+#if ION_OAFH_USE_MMAP
+	held_back = held_back && (NULL == map.map);
+#endif
+
+	key = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &key, &value).error);
+
+	if (held_back) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_EMPTY, file_bucket_status(&map, 0));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_sync(&map));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_IN_USE, file_bucket_status(&map, 0));
+
+	/* more pages than are held back write back the first ones */
+	for (i = 1; i <= ION_OAFH_WRITE_BACK_PAGES + 2; i++) {
+		key = i * page;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_IN_USE, file_bucket_status(&map, page));
+
+	if (held_back) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_EMPTY, file_bucket_status(&map, (ION_OAFH_WRITE_BACK_PAGES + 2) * page));
+	}
+
+	/* a delete of a record written back is held back too */
+	key = page;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_delete(&map, &key).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oafh_query(&map, &key, &value).error);
+
+	for (i = 2; i <= ION_OAFH_WRITE_BACK_PAGES + 2; i++) {
+		key = i * page;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_sync(&map));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_EMPTY, file_bucket_status(&map, page));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_IN_USE, file_bucket_status(&map, (ION_OAFH_WRITE_BACK_PAGES + 2) * page));
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief	  Tests that a bulk build lays records out as inserting them
+			would, wrapping those that run off the end.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_bulk_build(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_record_info_t	record;
+	int					keys[]		= { 9, 0, 19, 10, 5, 20 };
+	int					buckets[]	= { 9, 0, 3, 1, 5, 2 };
+	int					records[1400];
+	int					i;
+	int					location;
+	int					value;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_file_hash_map(10, &record, &map);
+
+	for (i = 0; i < 6; i++) {
+		records[2 * i]		= keys[i];
+		records[2 * i + 1]	= keys[i] * 2;
+	}
+
+	ion_status_t status = oafh_bulk_build(&map, (ion_byte_t *) records, 6);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, status.count);
+
+	/* 0, 10 and 20 fill buckets 0 to 2, and 19 wraps from 9 past them */
+	for (i = 0; i < 6; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_find_item_loc(&map, &keys[i], &location));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, buckets[i], location);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &keys[i], &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i] * 2, value);
+	}
+
+	/* a batch with a key twice is turned away whole */
+	records[0]	= 1;
+	records[2]	= 11;
+	records[4]	= 1;
+	status		= oafh_bulk_build(&map, (ion_byte_t *) records, 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &keys[5], &value).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_max_capacity, oafh_bulk_build(&map, (ion_byte_t *) records, 11).error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+
+	/* a larger map, built over several pages, replacing what it held */
+	initialize_file_hash_map(1000, &record, &map);
+	i = 5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &i, &i).error);
+
+	for (i = 0; i < 700; i++) {
+		records[2 * i]		= i * 7 + 1;
+		records[2 * i + 1]	= i;
+	}
+
+	status = oafh_bulk_build(&map, (ion_byte_t *) records, 700);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 700, status.count);
+
+	i = 5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oafh_query(&map, &i, &value).error);
+
+	for (i = 0; i < 700; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &records[2 * i], &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	/* the built map takes inserts and deletes as any other */
+	i = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &i, &i).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_delete(&map, &records[0]).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &records[2], &value).error);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief		Counts the records in use in the file of a map, read through
+			a stream of its own.
+*/
+static int
+file_records_in_use(
+	ion_file_hashmap_t *map
+) {
+	char	filename[ION_MAX_FILENAME_LENGTH];
+	int		record_size = SIZEOF(STATUS) + map->super.record.key_size + map->super.record.value_size;
+	char	bucket[64];
+	int		records		= 0;
+	FILE	*file;
+
+	dictionary_get_filename(map->super.id, "oaf", filename);
+
+	if (NULL == (file = fopen(filename, "rb"))) {
+		return -1;
+	}
+
+	while (1 == fread(bucket, record_size, 1, file)) {
+		if (ION_IN_USE == bucket[0]) {
+			records++;
+		}
+	}
+
+	fclose(file);
+	return records;
+}
+
+/**
+@brief	  Tests that a map whose file is mapped writes its buckets in
+			place, where any reader of the file sees them, and that a
+			bulk build, update and delete go through the mapping too.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_mapped(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_record_info_t	record;
+	int					records[400];
+	int					i;
+	int					value;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_file_hash_map(1000, &record, &map);
+
+#if ION_OAFH_USE_MMAP
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != map.map);
+#endif
+
+	for (i = 0; i < 500; i++) {
+		value = i * 2;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_insert(&map, &i, &value).error);
+	}
+
+#if ION_OAFH_USE_MMAP
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 500, file_records_in_use(&map));
+#endif
+
+	i		= 250;
+	value	= -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_update(&map, &i, &value).error);
+	i = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_delete(&map, &i).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_sync(&map));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 499, file_records_in_use(&map));
+
+	i = 250;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &i, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, value);
+	i = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oafh_query(&map, &i, &value).error);
+
+	for (i = 0; i < 200; i++) {
+		records[2 * i]		= i * 3;
+		records[2 * i + 1]	= i;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 200, oafh_bulk_build(&map, (ion_byte_t *) records, 200).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_sync(&map));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 200, file_records_in_use(&map));
+
+	for (i = 0; i < 200; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oafh_query(&map, &records[2 * i], &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
 planck_unit_suite_t *
 open_address_file_hashmap_getsuite(
 ) {
@@ -998,6 +1475,12 @@ open_address_file_hashmap_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_delete_1);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_delete_2);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_capacity);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_churn);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_stats);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_fingerprints);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_write_back);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_bulk_build);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_mapped);
 
 	return suite;
 }
@@ -101,12 +101,42 @@ test_open_address_file_hashmap_handler_create_destroy(
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->super.record.key_size) == record.key_size);
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->super.record.value_size) == record.value_size);
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->map_size) == size);
-	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->compute_hash) == &oafh_compute_simple_hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->compute_hash) == &oafh_compute_seeded_hash);
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->write_concern) == wc_insert_unique);
 	PLANCK_UNIT_ASSERT_TRUE(tc, test_dictionary.handler->delete_dictionary(&test_dictionary) == err_ok);
 	PLANCK_UNIT_ASSERT_TRUE(tc, test_dictionary.instance == NULL);
 }
 
+/**
+@brief		Tests that the hash function stored in the config is the one an
+			opened dictionary hashes with.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_handler_config_hash_function(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		map_handler;
+	ion_dictionary_t				test_dictionary;
+	ion_dictionary_config_info_t	config = {
+		.id = 1, .use_type = 0, .type = key_type_numeric_signed, .key_size = sizeof(int), .value_size = 10, .dictionary_size = 10, .hash_function = hash_function_modulo
+	};
+
+	oafdict_init(&map_handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&map_handler, &test_dictionary, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->compute_hash) == &oafh_compute_simple_hash);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test_dictionary));
+
+	config.hash_function = hash_function_seeded;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&map_handler, &test_dictionary, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->compute_hash) == &oafh_compute_seeded_hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_file_hashmap_t *) test_dictionary.instance)->seed) == 1);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test_dictionary));
+}
+
 void
 test_open_address_file_dictionary_cursor_equality(
 	planck_unit_test_t *tc
@@ -490,11 +520,11 @@ test_open_address_file_dictionary_cursor_range(
 	while (cs_cursor_active == (cursor_status = cursor->next(cursor, &record))) {
 		PLANCK_UNIT_ASSERT_TRUE(tc, cs_cursor_active == cursor_status);
 
-		/* check that value is correct that has been returned */
+		/* check that value is correct that has been returned; hashing does not keep key order */
 		ion_value_t str;
 
 		str = malloc(record_info.value_size);
-		sprintf((char *) str, "value : %i", (*(int *) predicate.statement.range.lower_bound) + result_count);
+		sprintf((char *) str, "value : %i", *(int *) record.key);
 
 		PLANCK_UNIT_ASSERT_TRUE(tc, ION_IS_EQUAL == memcmp(record.value, str, record_info.value_size));
 		result_count++;
@@ -519,6 +549,77 @@ test_open_address_file_dictionary_cursor_range(
 	dictionary_delete_dictionary(&test_dictionary);
 }
 
+/**
+@brief		Tests that a scan of every record reads the file in chunks,
+			and reads them again once the map is written to.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_dictionary_cursor_all_records(
+	planck_unit_test_t *tc
+) {
+	ion_record_info_t			record_info;
+	ion_dictionary_handler_t	map_handler;
+	ion_dictionary_t			test_dictionary;
+	ion_dict_cursor_t			*cursor;
+	ion_predicate_t				predicate;
+	ion_record_t				record;
+	int							i;
+	int							first;
+	int							result_count = 0;
+
+	/* room for the values of three digit keys */
+	record_info.key_size	= sizeof(int);
+	record_info.value_size	= 12;
+
+	createFileTestDictionary(&map_handler, &record_info, 300, &test_dictionary, key_type_numeric_signed);
+
+	/* the odd keys leave holes for the scan to skip */
+	for (i = 1; i < 300; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&test_dictionary, &i).error);
+	}
+
+	record.key		= malloc(record_info.key_size);
+	record.value	= malloc(record_info.value_size);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&test_dictionary, &predicate, &cursor));
+#if ION_OAFH_USE_MMAP
+	/* a mapped file is scanned in place, without a chunk */
+	PLANCK_UNIT_ASSERT_TRUE(tc, (NULL == ((ion_file_hashmap_t *) test_dictionary.instance)->map) == (NULL != ((ion_oafdict_cursor_t *) cursor)->chunk.buckets));
+#else
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ((ion_oafdict_cursor_t *) cursor)->chunk.buckets);
+#endif
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, *(int *) record.key % 2);
+		result_count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 150, result_count);
+	cursor->destroy(&cursor);
+
+	/* records deleted while the cursor is open are not returned from its chunk */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&test_dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+	first = *(int *) record.key;
+
+	for (i = 0; i < 300; i += 2) {
+		if (i != first) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&test_dictionary, &i).error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	free(record.key);
+	free(record.value);
+	dictionary_delete_dictionary(&test_dictionary);
+}
+
 planck_unit_suite_t *
 open_address_file_hashmap_handler_getsuite(
 ) {
@@ -526,6 +627,7 @@ open_address_file_hashmap_handler_getsuite(
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_handler_function_registration);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_handler_create_destroy);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_handler_config_hash_function);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_predicate_equality);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_predicate_range_signed);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_predicate_range_unsigned);
@@ -533,6 +635,7 @@ open_address_file_hashmap_handler_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_handler_query_with_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_handler_query_no_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_cursor_range);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_dictionary_cursor_all_records);
 
 	return suite;
 }
@@ -1,10 +1,12 @@
 #include "test_open_address_hash.h"
 #include "test_open_address_hash_dictionary_handler.h"
+#include "test_open_address_hash_concurrent_handler.h"
 
 int
 main(
 ) {
 	runalltests_open_address_hash();
 	runalltests_open_address_hash_handler();
+	runalltests_open_address_hash_concurrent_handler();
 	return 0;
 }
@@ -22,7 +22,7 @@ check_map(
 	ion_hashmap_t *map
 ) {
 	int i;
-	int bucket_size = map->super.record.key_size + map->super.record.value_size + sizeof(char);
+	int bucket_size = map->bucket_size;
 
 	for (i = 0; i < map->map_size; i++) {
 		int j;
@@ -115,6 +115,60 @@ test_open_address_hashmap_compute_simple_hash(
 	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
 }
 
+/**
+@brief		Tests that the seeded hash uses the whole key. Integer keys that
+			are all multiples of the map size, which the simple hash sends
+			to one slot, must cover the map, and strings sharing their
+			leading @c int must be told apart.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_compute_seeded_hash(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t	map;
+	int				i;
+	int				key;
+	ion_hash_t		hash;
+	ion_boolean_t	used[ION_STD_MAP_SIZE]	= { 0 };
+	int				num_used				= 0;
+
+	initialize_hash_map_std_conditions(&map);
+
+	for (i = 0; i < ION_MAX_HASH_TEST; i++) {
+		key		= i * map.map_size;
+		hash	= oah_compute_seeded_hash(&map, &key, sizeof(key));
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, hash >= 0 && hash < map.map_size);
+		PLANCK_UNIT_ASSERT_TRUE(tc, oah_compute_simple_hash(&map, &key, sizeof(key)) == 0);
+
+		if (!used[hash]) {
+			used[hash] = boolean_true;
+			num_used++;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, map.map_size, num_used);
+
+	/* the same key hashes the same way again, and the seed moves it */
+	key = 42;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, oah_compute_seeded_hash(&map, &key, sizeof(key)), oah_compute_seeded_hash(&map, &key, sizeof(key)));
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_hash_key(key_type_numeric_signed, &key, sizeof(key), 0) != dictionary_hash_key(key_type_numeric_signed, &key, sizeof(key), 1));
+
+	/* bytes past a string's terminator do not change its hash */
+	char	first[12]	= "abcdX\0junk1";
+	char	second[12]	= "abcdX\0junk2";
+	char	third[12]	= "abcdY\0junk1";
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_hash_key(key_type_null_terminated_string, first, sizeof(first), 0) == dictionary_hash_key(key_type_null_terminated_string, second, sizeof(second), 0));
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_hash_key(key_type_char_array, first, sizeof(first), 0) == dictionary_hash_key(key_type_char_array, second, sizeof(second), 0));
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_hash_key(key_type_null_terminated_string, first, sizeof(first), 0) != dictionary_hash_key(key_type_null_terminated_string, third, sizeof(third), 0));
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
 /**
 @brief	  Test locating an element in the hashmap and returns the theoretical
 			location of the item.
@@ -166,8 +220,8 @@ test_open_address_hashmap_find_item_location(
 	ion_hash_bucket_t	*item_ptr	= (ion_hash_bucket_t *) item;
 	char				*pos_ptr	= map.entry;
 
-	/* Bucket size includes flags, data, value */
-	int bucket_size					= sizeof(char) + record.key_size + record.value_size;
+	/* Bucket size includes flags, data, value and padding */
+	int bucket_size					= map.bucket_size;
 
 	for (offset = 0; offset < map.map_size; offset++) {
 		/* apply continual offsets to traverse map */
@@ -187,10 +241,12 @@ test_open_address_hashmap_find_item_location(
 			sprintf(str, "%02i is key", i);
 			/* Copy it directly into the slot */
 			memcpy((item_ptr->data + record.key_size), str, 10);
-			memcpy(pos_ptr, item_ptr, bucket_size);
+			memcpy(pos_ptr, item_ptr, SIZEOF(STATUS) + record.key_size + record.value_size);
 			pos_ptr = map.entry + ((((i + 1 + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size));
 		}
 
+		oah_rebuild_control_bytes(&map);
+
 		/* and now check key positions */
 		for (i = 0; i < map.map_size; i++) {
 			int location;
@@ -231,7 +287,7 @@ test_open_address_hashmap_simple_insert(
 
 #endif
 
-	int bucket_size = sizeof(char) + record.key_size + record.value_size;
+	int bucket_size = map.bucket_size;
 
 	for (offset = 0; offset < map.map_size; offset++) {
 		/* apply continual offsets */
@@ -973,6 +1029,458 @@ test_open_address_hashmap_capacity(
 	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
 }
 
+/**
+@brief		Tests that sustained inserts and deletes of colliding keys
+			leave no tombstones behind and every live key reachable.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_churn(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t		map;
+	ion_record_info_t	record;
+	ion_status_t		status;
+	int					i, j;
+	int					key;
+	int					value;
+	int					size		= 16;
+	int					num_live	= 12;
+	int					bucket_size;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_hash_map(size, &record, &map);
+	bucket_size			= map.bucket_size;
+
+	/* keys are spread over a few home buckets only, so clusters form and wrap */
+	for (i = 0; i < 2000; i++) {
+		key		= (i % 5) * 3 + (i / 5) * size;
+		value	= i;
+		status	= oah_insert(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+		if (i >= num_live - 1) {
+			j		= i - (num_live - 1);
+			key		= (j % 5) * 3 + (j / 5) * size;
+			status	= oah_delete(&map, &key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		}
+
+		for (j = (i >= num_live - 1) ? i - (num_live - 2) : 0; j <= i; j++) {
+			key		= (j % 5) * 3 + (j / 5) * size;
+			status	= oah_query(&map, &key, &value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, j, value);
+		}
+	}
+
+	for (i = 0; i < size; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, ION_DELETED != ((ion_hash_bucket_t *) (map.entry + i * bucket_size))->status);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
+/**
+@brief		Tests a map with fewer buckets than a group of control bytes,
+			so every probe reads control bytes repeated past the end.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_small_map(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t		map;
+	ion_record_info_t	record;
+	ion_status_t		status;
+	int					i;
+	int					value;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_hash_map(3, &record, &map);
+
+	for (i = 0; i < 3; i++) {
+		value	= i + 100;
+		status	= oah_insert(&map, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	i		= 3;
+	status	= oah_insert(&map, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_max_capacity, status.error);
+
+	i		= 1;
+	status	= oah_delete(&map, &i);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	status	= oah_query(&map, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+
+	for (i = 0; i < 3; i += 2) {
+		status = oah_query(&map, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i + 100, value);
+	}
+
+	/* the freed bucket takes a new key */
+	i		= 3;
+	value	= 103;
+	status	= oah_insert(&map, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	status	= oah_query(&map, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 103, value);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
+/**
+@brief		Tests that buckets are laid out as configured: keys aligned
+			to @ref ION_OAH_BUCKET_ALIGN, no bucket across a cache line,
+			and packed back to back when neither is asked for.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_bucket_layout(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t		map;
+	ion_record_info_t	record;
+	ion_hash_bucket_t	*item;
+	int					i;
+	char				value[3];
+
+	/* an odd bucket size, which packed buckets straddle lines with */
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(value);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_hash_map(50, &record, &map);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, map.bucket_size >= SIZEOF(STATUS) + record.key_size + record.value_size);
+
+	if ((1 == ION_OAH_BUCKET_ALIGN) && (0 == ION_OAH_CACHE_LINE)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SIZEOF(STATUS) + record.key_size + record.value_size, map.bucket_size);
+	}
+
+	for (i = 0; i < 50; i++) {
+		item = (ion_hash_bucket_t *) (map.entry + map.bucket_size * i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (int) ((uintptr_t) item->data % ION_OAH_BUCKET_ALIGN));
+
+#if ION_OAH_CACHE_LINE > 0
+		PLANCK_UNIT_ASSERT_TRUE(tc, (uintptr_t) item / ION_OAH_CACHE_LINE == ((uintptr_t) item->data + record.key_size + record.value_size - 1) / ION_OAH_CACHE_LINE);
+#endif
+
+		memset(value, i, sizeof(value));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_insert(&map, &i, value).error);
+	}
+
+	for (i = 0; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_query(&map, &i, value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value[2]);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
+/**
+@brief		Tests that a resizable map grows past its initial size while
+			moving records a few at a time, keeps every record reachable
+			throughout, and shrinks back after most are deleted.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_resize(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t		map;
+	ion_record_info_t	record;
+	ion_status_t		status;
+	int					i, j;
+	int					value;
+	ion_boolean_t		saw_resize	= boolean_false;
+	int					num_records = 1000;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_hash_map(4, &record, &map);
+	map.resizable		= boolean_true;
+
+	for (i = 0; i < num_records; i++) {
+		value	= i * 3;
+		status	= oah_insert(&map, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+		if (NULL != map.old_entry) {
+			saw_resize = boolean_true;
+		}
+
+		/* records still in the previous table are found too */
+		if (0 == i % 97) {
+			for (j = 0; j <= i; j++) {
+				status = oah_query(&map, &j, &value);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, j * 3, value);
+			}
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, saw_resize);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, num_records, map.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, (long) map.map_size * ION_OAH_GROW_LOAD_PERCENT >= (long) num_records * 100);
+
+	/* duplicates are still caught while records are moving */
+	i		= 5;
+	status	= oah_insert(&map, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, status.error);
+
+	int grown_size = map.map_size;
+
+	for (i = 10; i < num_records; i++) {
+		status = oah_delete(&map, &i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	oah_finish_rehash(&map);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == map.old_entry);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, map.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map.map_size < grown_size);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map.map_size >= 4);
+
+	for (i = 0; i < num_records; i++) {
+		status = oah_query(&map, &i, &value);
+
+		if (i < 10) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, value);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
+/**
+@brief		Tests that a batched lookup finds the same records as single
+			ones, including records not yet moved out of the previous
+			table of a resize.
+
+@param		tc
+				Test case.
+*/
+void
+test_open_address_hashmap_get_many(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t		map;
+	ion_record_info_t	record;
+	ion_status_t		status;
+	ion_status_t		statuses[150];
+	int					keys[150];
+	int					values[150];
+	int					num_records = 0;
+	int					i;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_hash_map(4, &record, &map);
+	map.resizable		= boolean_true;
+
+	/* stop partway through a resize */
+	while ((num_records < 100) || (NULL == map.old_entry)) {
+		values[0]	= num_records * 3;
+		status		= oah_insert(&map, &num_records, &values[0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		num_records++;
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, num_records < 150);
+
+	for (i = 0; i < 150; i++) {
+		keys[i]		= 149 - i;
+		values[i]	= -1;
+	}
+
+	status = oah_get_many(&map, keys, values, statuses, 150);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, num_records, status.count);
+
+	for (i = 0; i < 150; i++) {
+		if (keys[i] < num_records) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i] * 3, values[i]);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, values[i]);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
+/**
+@brief		Tests that a map saved to a snapshot loads back with the same
+			records, also when the snapshot's bucket positions have to be
+			ignored.
+
+@param		tc
+				Test case.
+*/
+void
+test_open_address_hashmap_save_load(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t		map;
+	ion_hashmap_t		loaded;
+	ion_record_info_t	record;
+	ion_status_t		status;
+	FILE				*file;
+	uint32_t			check	= 0;
+	int					i;
+	int					value;
+	int					pass;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	map.super.compare	= dictionary_compare_signed_value;
+	oah_initialize(&map, oah_compute_seeded_hash, map.super.key_type, record.key_size, record.value_size, 8);
+	map.seed			= 77;
+	map.resizable		= boolean_true;
+
+	for (i = 0; i < 300; i++) {
+		value = i * 5;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_insert(&map, &i, &value).error);
+	}
+
+	for (i = 0; i < 300; i += 3) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_delete(&map, &i).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_save(&map, "oah_test.oas"));
+
+	/* the second pass is told the snapshot came from a build placing keys elsewhere */
+	for (pass = 0; pass < 2; pass++) {
+		if (1 == pass) {
+			file = fopen("oah_test.oas", "r+b");
+			PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+			fseek(file, sizeof(uint32_t), SEEK_SET);
+			fwrite(&check, sizeof(check), 1, file);
+			fclose(file);
+		}
+
+		loaded.super.compare = dictionary_compare_signed_value;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_load(&loaded, "oah_test.oas"));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, map.map_size, loaded.map_size);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, map.count, loaded.count);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, map.seed, loaded.seed);
+		PLANCK_UNIT_ASSERT_TRUE(tc, loaded.resizable);
+		PLANCK_UNIT_ASSERT_TRUE(tc, oah_compute_seeded_hash == loaded.compute_hash);
+
+		for (i = 0; i < 300; i++) {
+			status = oah_query(&loaded, &i, &value);
+
+			if (0 == i % 3) {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+			}
+			else {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 5, value);
+			}
+		}
+
+		/* and it carries on as a map */
+		i		= 1000;
+		value	= 1;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_insert(&loaded, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_query(&loaded, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_destroy(&loaded));
+	}
+
+	fremove("oah_test.oas");
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_open_error, oah_load(&loaded, "oah_test.oas"));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_destroy(&map));
+}
+
+/**
+@brief		Tests that the probe counters of a map follow a cluster
+			that wraps around the end of the table, and that the bucket
+			counts match its contents.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_stats(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t			map;
+	ion_record_info_t	record;
+	ion_hash_stats_t	stats;
+	int					keys[]	= { 0, 10, 20, 9, 19 };
+	int					i;
+	int					value	= 0;
+
+	record.key_size		= sizeof(int);
+	record.value_size	= sizeof(int);
+	map.super.key_type	= key_type_numeric_signed;
+	initialize_hash_map(10, &record, &map);
+
+	/* 0, 10 and 20 share bucket 0; 19 wraps from bucket 9 past them */
+	for (i = 0; i < 5; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_insert(&map, &keys[i], &value).error);
+	}
+
+	i = 20;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_query(&map, &i, &value).error);
+	i = 30;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, oah_query(&map, &i, &value).error);
+	i = 10;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_delete(&map, &i).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_stats(&map, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, (int) stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 12, (int) stats.insert.probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, stats.insert.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, (int) stats.insert.histogram[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, (int) stats.insert.histogram[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) stats.insert.histogram[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, (int) stats.get.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, (int) stats.get.probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, stats.get.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) stats.remove.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, stats.remove.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) stats.wraps);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, stats.buckets);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, stats.occupied);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.deleted);
+
+	/* a reset clears the probe counters, not the bucket counts */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_reset_stats(&map));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, oah_stats(&map, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (int) stats.insert.calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.get.max_probes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (int) stats.wraps);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, stats.occupied);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
 planck_unit_suite_t *
 open_address_hashmap_getsuite(
 ) {
@@ -980,6 +1488,7 @@ open_address_hashmap_getsuite(
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_initialize);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_compute_simple_hash);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_compute_seeded_hash);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_get_location);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_find_item_location);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_simple_insert);
@@ -992,6 +1501,13 @@ open_address_hashmap_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_delete_1);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_delete_2);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_capacity);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_churn);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_small_map);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_bucket_layout);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_resize);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_get_many);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_save_load);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_stats);
 
 	return suite;
 }
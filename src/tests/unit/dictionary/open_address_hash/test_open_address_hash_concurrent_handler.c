@@ -0,0 +1,263 @@
+/**
+@file
+@brief		Tests of the concurrent open address hash handler, run from
+			several threads at once.
+*/
+
+#include "test_open_address_hash_concurrent_handler.h"
+
+#define ION_OAC_TEST_WRITERS			8
+#define ION_OAC_TEST_READERS			4
+#define ION_OAC_TEST_KEYS_PER_WRITER	2000
+#define ION_OAC_TEST_ROUNDS				3
+
+/**
+@brief		What the threads of a test share.
+*/
+typedef struct {
+	ion_dictionary_t	dictionary;
+	int					writers_done;	/**< Read and written atomically */
+	int					bad_reads;		/**< Read and written atomically */
+} ion_oac_test_t;
+
+/**
+@brief		A writer and the test it takes part in.
+*/
+typedef struct {
+	ion_oac_test_t	*test;
+	int				first_key;
+} ion_oac_test_writer_t;
+
+/**
+@brief		The value stored under a key after a given round of updates.
+*/
+static int
+oac_test_value(
+	int key,
+	int round
+) {
+	return key * 7 + round;
+}
+
+/**
+@brief		Inserts its own keys, updates all of them a few times, then
+			deletes the odd ones.
+*/
+static void *
+oac_test_writer(
+	void *argument
+) {
+	ion_oac_test_writer_t	*writer = argument;
+	ion_dictionary_t		*dictionary = &writer->test->dictionary;
+	int						key;
+	int						value;
+	int						round;
+
+	for (key = writer->first_key; key < writer->first_key + ION_OAC_TEST_KEYS_PER_WRITER; key++) {
+		value = oac_test_value(key, 0);
+
+		if (err_ok != dictionary_insert(dictionary, &key, &value).error) {
+			__atomic_add_fetch(&writer->test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	for (round = 1; round <= ION_OAC_TEST_ROUNDS; round++) {
+		for (key = writer->first_key; key < writer->first_key + ION_OAC_TEST_KEYS_PER_WRITER; key++) {
+			value = oac_test_value(key, round);
+			dictionary_update(dictionary, &key, &value);
+		}
+	}
+
+	for (key = writer->first_key + 1; key < writer->first_key + ION_OAC_TEST_KEYS_PER_WRITER; key += 2) {
+		dictionary_delete(dictionary, &key);
+	}
+
+	__atomic_add_fetch(&writer->test->writers_done, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/**
+@brief		Looks keys up until the writers are done, counting any value
+			that was never stored under its key.
+*/
+static void *
+oac_test_reader(
+	void *argument
+) {
+	ion_oac_test_t	*test	= argument;
+	int				total	= ION_OAC_TEST_WRITERS * ION_OAC_TEST_KEYS_PER_WRITER;
+	uint32_t		random	= 12345;
+	int				key;
+	int				value;
+	ion_status_t	status;
+
+	while (__atomic_load_n(&test->writers_done, __ATOMIC_ACQUIRE) < ION_OAC_TEST_WRITERS) {
+		random	= random * 1103515245 + 12345;
+		key		= (random >> 8) % total;
+		value	= -1;
+		status	= dictionary_get(&test->dictionary, &key, &value);
+
+		if ((err_ok == status.error) && ((value < oac_test_value(key, 0)) || (value > oac_test_value(key, ION_OAC_TEST_ROUNDS)))) {
+			__atomic_add_fetch(&test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+		else if ((err_ok != status.error) && (-1 != value)) {
+			__atomic_add_fetch(&test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Tests that concurrent writers and lock-free readers only ever
+			see values that were stored, and that every write lands.
+
+@param		tc
+				Test case.
+*/
+void
+test_open_address_concurrent_threads(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_oac_test_t				test;
+	ion_oac_test_writer_t		writers[ION_OAC_TEST_WRITERS];
+	pthread_t					threads[ION_OAC_TEST_WRITERS + ION_OAC_TEST_READERS];
+	int							total = ION_OAC_TEST_WRITERS * ION_OAC_TEST_KEYS_PER_WRITER;
+	int							i;
+	int							key;
+	int							value;
+	ion_status_t				status;
+
+	oacdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &test.dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), total));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_OAC_STRIPES, ((ion_oac_hashmap_t *) test.dictionary.instance)->stripe_count);
+
+	test.writers_done	= 0;
+	test.bad_reads		= 0;
+
+	for (i = 0; i < ION_OAC_TEST_READERS; i++) {
+		pthread_create(&threads[ION_OAC_TEST_WRITERS + i], NULL, oac_test_reader, &test);
+	}
+
+	for (i = 0; i < ION_OAC_TEST_WRITERS; i++) {
+		writers[i].test			= &test;
+		writers[i].first_key	= i * ION_OAC_TEST_KEYS_PER_WRITER;
+		pthread_create(&threads[i], NULL, oac_test_writer, &writers[i]);
+	}
+
+	for (i = 0; i < ION_OAC_TEST_WRITERS + ION_OAC_TEST_READERS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, test.bad_reads);
+
+	for (key = 0; key < total; key++) {
+		status = dictionary_get(&test.dictionary, &key, &value);
+
+		if (0 == key % 2) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, oac_test_value(key, ION_OAC_TEST_ROUNDS), value);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test.dictionary));
+}
+
+/**
+@brief		Tests cursors, which walk the stripes one after another.
+
+@param		tc
+				Test case.
+*/
+void
+test_open_address_concurrent_cursors(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	int							key;
+	int							value;
+	int							found;
+	int							seen[1000] = { 0 };
+
+	oacdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 2, key_type_numeric_signed, sizeof(int), sizeof(int), 1000));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ((ion_oac_hashmap_t *) dictionary.instance)->stripe_count > 1);
+
+	for (key = 0; key < 1000; key++) {
+		value = key * 2;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+	}
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	/* every record once, whichever stripe it is in */
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, key >= 0 && key < 1000);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 2, value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, seen[key]);
+		seen[key] = 1;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, found);
+	cursor->destroy(&cursor);
+
+	/* a range picks its records out of every stripe */
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(100, int), IONIZE(199, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, key >= 100 && key <= 199);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, found);
+	cursor->destroy(&cursor);
+
+	/* an equality only needs the key's stripe */
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(567, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 567, key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1134, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(5000, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+planck_unit_suite_t *
+open_address_hashmap_concurrent_handler_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_concurrent_threads);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_concurrent_cursors);
+
+	return suite;
+}
+
+void
+runalltests_open_address_hash_concurrent_handler(
+) {
+	planck_unit_suite_t *suite = open_address_hashmap_concurrent_handler_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_OPEN_ADDRESS_HASH_CONCURRENT_HANDLER_H_
+#define TEST_OPEN_ADDRESS_HASH_CONCURRENT_HANDLER_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/dictionary_types.h"
+#include "./../../../../dictionary/dictionary.h"
+#include "../../../../dictionary/open_address_hash/open_address_hash_concurrent_handler.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+void
+runalltests_open_address_hash_concurrent_handler(
+);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
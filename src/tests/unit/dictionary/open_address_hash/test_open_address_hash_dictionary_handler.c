@@ -101,7 +101,7 @@ test_open_address_hashmap_handler_create_destroy(
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_hashmap_t *) test_dictionary.instance)->super.record.key_size) == record.key_size);
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_hashmap_t *) test_dictionary.instance)->super.record.value_size) == record.value_size);
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_hashmap_t *) test_dictionary.instance)->map_size) == size);
-	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_hashmap_t *) test_dictionary.instance)->compute_hash) == &oah_compute_simple_hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_hashmap_t *) test_dictionary.instance)->compute_hash) == &oah_compute_seeded_hash);
 	PLANCK_UNIT_ASSERT_TRUE(tc, (((ion_hashmap_t *) test_dictionary.instance)->write_concern) == wc_insert_unique);
 	PLANCK_UNIT_ASSERT_TRUE(tc, test_dictionary.handler->delete_dictionary(&test_dictionary) == err_ok);
 	PLANCK_UNIT_ASSERT_TRUE(tc, test_dictionary.instance == NULL);
@@ -479,11 +479,11 @@ test_open_address_dictionary_cursor_range(
 	while (cs_cursor_active == (cursor_status = cursor->next(cursor, &record))) {
 		PLANCK_UNIT_ASSERT_TRUE(tc, cs_cursor_active == cursor_status);
 
-		/* check that value is correct that has been returned */
+		/* check that value is correct that has been returned; hashing does not keep key order */
 		ion_value_t str;
 
 		str = malloc(record_info.value_size);
-		sprintf((char *) str, "value : %i", (*(int *) predicate.statement.range.lower_bound) + result_count);
+		sprintf((char *) str, "value : %i", *(int *) record.key);
 
 		PLANCK_UNIT_ASSERT_TRUE(tc, ION_IS_EQUAL == memcmp(record.value, str, record_info.value_size));
 		PLANCK_UNIT_ASSERT_TRUE(tc, *(int *) (record.key) >= *(int *) (cursor->predicate->statement.range.lower_bound));
@@ -510,6 +510,48 @@ test_open_address_dictionary_cursor_range(
 	dictionary_delete_dictionary(&test_dictionary);
 }
 
+/**
+@brief		Tests that closing a dictionary leaves a snapshot that opening
+			it again loads and removes.
+
+@param		tc
+				Test case.
+*/
+void
+test_open_address_dictionary_handler_close_open(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		map_handler;
+	ion_dictionary_t				test_dictionary;
+	ion_dictionary_config_info_t	config = { 7, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 20, 0, hash_function_seeded };
+	FILE							*file;
+	int								i;
+	int								value;
+
+	oadict_init(&map_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&map_handler, &test_dictionary, 7, key_type_numeric_signed, sizeof(int), sizeof(int), 20));
+
+	for (i = 0; i < 50; i++) {
+		value = i * 4;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&test_dictionary, &i, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&test_dictionary));
+	file = fopen("7.oas", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	fclose(file);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&map_handler, &test_dictionary, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == fopen("7.oas", "rb"));
+
+	for (i = 0; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&test_dictionary, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 4, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test_dictionary));
+}
+
 planck_unit_suite_t *
 open_address_hashmap_handler_getsuite(
 ) {
@@ -524,6 +566,7 @@ open_address_hashmap_handler_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_handler_query_with_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_handler_query_no_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_cursor_range);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_handler_close_open);
 
 	return suite;
 }
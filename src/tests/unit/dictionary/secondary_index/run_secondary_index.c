@@ -0,0 +1,8 @@
+#include "test_secondary_index.h"
+
+int
+main(
+) {
+	runalltests_secondary_index();
+	return 0;
+}
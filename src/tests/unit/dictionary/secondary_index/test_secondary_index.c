@@ -0,0 +1,362 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the secondary indexes registered in the master table and
+			kept with the writes to the dictionaries they index.
+*/
+/******************************************************************************/
+
+#include "test_secondary_index.h"
+
+/**
+@brief		The values of the records of the tests.
+*/
+typedef struct {
+	int sensor;		/**< The key modulo 5 */
+	int reading;	/**< The key times 10 */
+} ion_sidx_test_value_t;
+
+/**
+@brief		Makes the value of a key.
+*/
+static ion_sidx_test_value_t
+sidx_test_value(
+	int key
+) {
+	ion_sidx_test_value_t value;
+
+	value.sensor	= key % 5;
+	value.reading	= key * 10;
+
+	return value;
+}
+
+/**
+@brief		Starts a fresh master table and creates a B+ tree in it of
+			@p count records, keys @c 0 and on, wrapped with no indexes.
+*/
+static void
+sidx_test_create(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*inner_handler,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	int							count
+) {
+	ion_sidx_test_value_t	value;
+	int						i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	bpptree_init(inner_handler);
+	sidxdict_init(handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary(inner_handler, dictionary, key_type_numeric_signed, sizeof(int), sizeof(ion_sidx_test_value_t), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_wrap(dictionary, handler, NULL, 0));
+
+	for (i = 0; i < count; i++) {
+		value = sidx_test_value(i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, IONIZE(i, int), &value).error);
+	}
+}
+
+/**
+@brief		Deletes a dictionary and its indexes and the master table.
+*/
+static void
+sidx_test_destroy(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary
+) {
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+}
+
+/**
+@brief		Checks the number of records found through an index for a
+			range of indexed values, and that each is the record of its
+			key and lies in the range.
+*/
+static void
+sidx_test_expect(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					index,
+	int					lower,
+	int					upper,
+	int					expected
+) {
+	ion_dict_cursor_t		*cursor = NULL;
+	ion_sidx_test_value_t	value;
+	ion_sidx_test_value_t	stored;
+	ion_record_t			record;
+	int						key;
+	int						field;
+	int						count	= 0;
+
+	record.key		= &key;
+	record.value	= &value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_find_by_index(dictionary, index, &lower, &upper, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		field = (0 == index) ? value.sensor : value.reading;
+		PLANCK_UNIT_ASSERT_TRUE(tc, lower <= field && field <= upper);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(dictionary, &key, &stored).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, stored.reading, value.reading);
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, count);
+}
+
+/**
+@brief		Tests indexes created on a dictionary holding records already,
+			and the records found through them.
+*/
+void
+test_secondary_index_find(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		inner_handler;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_handler_t		index_handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config = { 0 };
+	ion_sidx_test_value_t			value;
+	int								i;
+
+	sidx_test_create(tc, &inner_handler, &handler, &dictionary, 20);
+
+	bpptree_init(&index_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handler, 0, sizeof(int), 0));
+	ffdict_init(&index_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handler, sizeof(int), sizeof(int), 0));
+
+	for (i = 20; i < 40; i++) {
+		value = sidx_test_value(i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(i, int), &value).error);
+	}
+
+	sidx_test_expect(tc, &dictionary, 0, 2, 2, 8);
+	sidx_test_expect(tc, &dictionary, 0, 1, 3, 24);
+	sidx_test_expect(tc, &dictionary, 0, 5, 9, 0);
+	sidx_test_expect(tc, &dictionary, 1, 100, 150, 6);
+	sidx_test_expect(tc, &dictionary, 1, 390, 1000, 1);
+
+	/* the definitions are in the master table, in the order they were made */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_index_master_table(dictionary.instance->id, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, config.index_offset);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(int), config.index_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_index_master_table(dictionary.instance->id, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(int), config.index_offset);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_find_index_master_table(dictionary.instance->id, &config));
+
+	sidx_test_destroy(tc, &dictionary);
+}
+
+/**
+@brief		Tests that updates and deletes move and remove records in the
+			indexes.
+*/
+void
+test_secondary_index_changes(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	index_handler;
+	ion_dictionary_t			dictionary;
+	ion_sidx_test_value_t		value;
+
+	sidx_test_create(tc, &inner_handler, &handler, &dictionary, 20);
+	bpptree_init(&index_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handler, 0, sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handler, sizeof(int), sizeof(int), 0));
+
+	/* a new sensor moves the record between values of the first index */
+	value.sensor	= 4;
+	value.reading	= 20;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(2, int), &value).error);
+	sidx_test_expect(tc, &dictionary, 0, 2, 2, 3);
+	sidx_test_expect(tc, &dictionary, 0, 4, 4, 5);
+	sidx_test_expect(tc, &dictionary, 1, 20, 20, 1);
+
+	/* a new reading leaves the first index as it was */
+	value.reading = 25;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(2, int), &value).error);
+	sidx_test_expect(tc, &dictionary, 0, 4, 4, 5);
+	sidx_test_expect(tc, &dictionary, 1, 20, 20, 0);
+	sidx_test_expect(tc, &dictionary, 1, 25, 25, 1);
+
+	/* an update of a missing key inserts it */
+	value.sensor	= 2;
+	value.reading	= 1000;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(100, int), &value).error);
+	sidx_test_expect(tc, &dictionary, 0, 2, 2, 4);
+	sidx_test_expect(tc, &dictionary, 1, 1000, 1000, 1);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, IONIZE(7, int)).error);
+	sidx_test_expect(tc, &dictionary, 0, 2, 2, 3);
+	sidx_test_expect(tc, &dictionary, 1, 70, 70, 0);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_delete(&dictionary, IONIZE(7, int)).error);
+
+	sidx_test_destroy(tc, &dictionary);
+}
+
+/**
+@brief		Tests that a batch insert writes the indexes in a batch too.
+*/
+void
+test_secondary_index_insert_many(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	index_handler;
+	ion_dictionary_t			dictionary;
+	ion_sidx_test_value_t		values[10];
+	ion_status_t				statuses[10];
+	int							keys[10];
+	int							i;
+
+	sidx_test_create(tc, &inner_handler, &handler, &dictionary, 0);
+	bpptree_init(&index_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handler, 0, sizeof(int), 0));
+
+	for (i = 0; i < 10; i++) {
+		keys[i]		= i;
+		values[i]	= sidx_test_value(i);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, dictionary_insert_many(&dictionary, keys, values, statuses, 10).count);
+	sidx_test_expect(tc, &dictionary, 0, 3, 3, 2);
+
+	for (i = 0; i < 10; i++) {
+		keys[i]		= i + 10;
+		values[i]	= sidx_test_value(i + 10);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, dictionary_insert_many(&dictionary, keys, values, NULL, 10).count);
+	sidx_test_expect(tc, &dictionary, 0, 3, 3, 4);
+	sidx_test_expect(tc, &dictionary, 0, 0, 4, 20);
+
+	sidx_test_destroy(tc, &dictionary);
+}
+
+/**
+@brief		Tests that the indexes are opened again with their dictionary
+			and leave the master table with it.
+*/
+void
+test_secondary_index_reopen(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		inner_handler;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_handler_t		index_handlers[2];
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	configs[3];
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_handler_t		*opened;
+	ion_dictionary_id_t				id;
+	int								i;
+
+	sidx_test_create(tc, &inner_handler, &handler, &dictionary, 30);
+	bpptree_init(&index_handlers[0]);
+	ffdict_init(&index_handlers[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handlers[0], 0, sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_create_index(&dictionary, &index_handlers[1], sizeof(int), sizeof(int), 0));
+
+	id = dictionary.instance->id;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&inner_handler, &dictionary, id));
+	opened = dictionary.handler;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, sidxdict_wrap(&dictionary, &handler, index_handlers, 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, opened == dictionary.handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sidxdict_wrap(&dictionary, &handler, index_handlers, 2));
+
+	sidx_test_expect(tc, &dictionary, 0, 1, 1, 6);
+	sidx_test_expect(tc, &dictionary, 1, 100, 200, 11);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, IONIZE(11, int)).error);
+	sidx_test_expect(tc, &dictionary, 0, 1, 1, 5);
+
+	/* removing the dictionary from the master table removes its indexes */
+	configs[0].id = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(id, &configs[0]));
+	configs[1].id = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_index_master_table(id, &configs[1]));
+	configs[2] = configs[1];
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_index_master_table(id, &configs[2]));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary));
+	config.id = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_find_index_master_table(id, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_lookup_in_master_table(id, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_lookup_in_master_table(configs[1].id, &config));
+
+	/* the files are still there to delete */
+	for (i = 0; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open((0 == i) ? &inner_handler : &index_handlers[i - 1], &dictionary, &configs[i]));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+}
+
+/**
+@brief		Tests the errors of dictionaries not wrapped and of bad
+			indexes.
+*/
+void
+test_secondary_index_invalid(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	index_handler;
+	ion_dictionary_t			dictionary;
+	ion_dict_cursor_t			*cursor = NULL;
+	int							field	= 0;
+
+	sidx_test_create(tc, &inner_handler, &handler, &dictionary, 5);
+	bpptree_init(&index_handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, sidxdict_create_index(&dictionary, &index_handler, sizeof(int), 0, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, sidxdict_create_index(&dictionary, &index_handler, sizeof(int) + 1, sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, sidxdict_find_by_index(&dictionary, 0, &field, &field, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, sidxdict_create_index(&((ion_sidx_dictionary_t *) dictionary.instance)->inner, &index_handler, 0, sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, sidxdict_find_by_index(&((ion_sidx_dictionary_t *) dictionary.instance)->inner, 0, &field, &field, &cursor));
+
+	sidx_test_destroy(tc, &dictionary);
+}
+
+planck_unit_suite_t *
+secondary_index_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_secondary_index_find);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_secondary_index_changes);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_secondary_index_insert_many);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_secondary_index_reopen);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_secondary_index_invalid);
+
+	return suite;
+}
+
+void
+runalltests_secondary_index(
+) {
+	planck_unit_suite_t *suite = secondary_index_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
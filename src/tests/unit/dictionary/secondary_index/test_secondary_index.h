@@ -0,0 +1,28 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the secondary indexes kept through the master table.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_SECONDARY_INDEX_H_)
+#define TEST_SECONDARY_INDEX_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/secondary_index/secondary_index_dictionary_handler.h"
+#include "../../../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../../../dictionary/flat_file/flat_file_dictionary_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_secondary_index(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_SECONDARY_INDEX_H_ */
@@ -0,0 +1,8 @@
+#include "test_shard.h"
+
+int
+main(
+) {
+	runalltests_shard();
+	return 0;
+}
@@ -0,0 +1,469 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the sharded dictionary front-end, over skip lists sharded
+			by hash and B+ trees sharded by range.
+*/
+/******************************************************************************/
+
+#include "test_shard.h"
+
+/**
+@brief		The number of shards, and of workers running them.
+*/
+#define SHARD_TEST_SHARDS	4
+
+/**
+@brief		The number of records put in a sharded dictionary.
+*/
+#define SHARD_TEST_RECORDS	400
+
+/**
+@brief		The number of threads using a sharded dictionary at once.
+*/
+#define SHARD_TEST_THREADS	4
+
+/**
+@brief		The least keys of the shards by range after the first.
+*/
+static int shard_test_splits[SHARD_TEST_SHARDS - 1] = { 100, 200, 300 };
+
+/**
+@brief		Starts a pool and makes a dictionary of shards on it: skip
+			lists by hash if @p splits is @c NULL, else B+ trees by range.
+*/
+static void
+shard_test_setup(
+	planck_unit_test_t			*tc,
+	ion_async_pool_t			*pool,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_handler_t	*engines,
+	ion_dictionary_t			*dictionary,
+	int							*splits
+) {
+	ion_dictionary_t	shards[SHARD_TEST_SHARDS];
+	int					i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(pool, SHARD_TEST_SHARDS));
+	shardict_init(handler);
+
+	for (i = 0; i < SHARD_TEST_SHARDS; i++) {
+		if (NULL == splits) {
+			sldict_init(&engines[i]);
+		}
+		else {
+			bpptree_init(&engines[i]);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&engines[i], &shards[i], 70 + i, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, shardict_wrap(dictionary, handler, shards, SHARD_TEST_SHARDS, splits, pool));
+}
+
+/**
+@brief		Deletes the dictionary of @ref shard_test_setup and stops its
+			pool.
+*/
+static void
+shard_test_takedown(
+	planck_unit_test_t	*tc,
+	ion_async_pool_t	*pool,
+	ion_dictionary_t	*dictionary
+) {
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(dictionary));
+	dictionary_async_stop(pool);
+}
+
+/**
+@brief		Inserts the keys from @p first up to @p end, each with twice
+			itself.
+*/
+static void
+shard_test_fill(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					first,
+	int					end
+) {
+	int key;
+	int value;
+
+	for (key = first; key < end; key++) {
+		value = key * 2;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, &key, &value).error);
+	}
+}
+
+/**
+@brief		Reads a cursor to its end, checking each record is the one
+			after the last in order and holds twice its key.
+@param[out]	read
+					Set to the number of records read.
+*/
+static void
+shard_test_read(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	int					first,
+	int					*read
+) {
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					key;
+	int					value;
+
+	*read			= 0;
+	record.key		= &key;
+	record.value	= &value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(dictionary, predicate, &cursor));
+
+	while (cs_cursor_active == dictionary_next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, first + *read, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 2, value);
+		(*read)++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == cursor);
+}
+
+/**
+@brief		Tests that shards are only wrapped when they agree, and that
+			keys go to the shard of their range.
+*/
+void
+test_shard_wrap(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t			pool;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	engines[SHARD_TEST_SHARDS];
+	ion_dictionary_t			shards[2];
+	ion_dictionary_t			dictionary;
+	int							key;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_async_start(&pool, 2));
+	shardict_init(&handler);
+	sldict_init(&engines[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&engines[0], &shards[0], 70, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&engines[0], &shards[1], 71, key_type_numeric_signed, sizeof(int), sizeof(long), 7));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, shardict_wrap(&dictionary, &handler, shards, 0, NULL, &pool));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, shardict_wrap(&dictionary, &handler, shards, ION_SHARD_MAX + 1, NULL, &pool));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, shardict_wrap(&dictionary, &handler, shards, 2, NULL, &pool));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, shardict_wrap(&dictionary, &handler, shards, 1, NULL, NULL));
+
+	for (i = 0; i < 2; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&shards[i]));
+	}
+
+	dictionary_async_stop(&pool);
+
+	shard_test_setup(tc, &pool, &handler, engines, &dictionary, shard_test_splits);
+
+	key = -5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, shardict_shard_of(&dictionary, &key));
+	key = 99;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, shardict_shard_of(&dictionary, &key));
+	key = 100;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, shardict_shard_of(&dictionary, &key));
+	key = 250;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, shardict_shard_of(&dictionary, &key));
+	key = 300;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, shardict_shard_of(&dictionary, &key));
+	key = 1000;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, shardict_shard_of(&dictionary, &key));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == shardict_get_shard(&dictionary, SHARD_TEST_SHARDS));
+
+	shard_test_takedown(tc, &pool, &dictionary);
+}
+
+/**
+@brief		Tests that records are inserted, read, updated and deleted in
+			the shard of their key.
+*/
+void
+test_shard_operations(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t			pool;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	engines[SHARD_TEST_SHARDS];
+	ion_dictionary_t			dictionary;
+	ion_dictionary_info_t		info;
+	int							used[SHARD_TEST_SHARDS] = { 0 };
+	int							key;
+	int							value;
+	int							i;
+
+	shard_test_setup(tc, &pool, &handler, engines, &dictionary, NULL);
+	shard_test_fill(tc, &dictionary, 0, SHARD_TEST_RECORDS);
+
+	for (key = 0; key < SHARD_TEST_RECORDS; key++) {
+		i = shardict_shard_of(&dictionary, &key);
+		used[i]++;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(shardict_get_shard(&dictionary, i), &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(shardict_get_shard(&dictionary, (i + 1) % SHARD_TEST_SHARDS), &key, &value).error);
+
+		value = key * 3;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, &key, &value).error);
+	}
+
+	/* the hash spreads the keys over every shard */
+	for (i = 0; i < SHARD_TEST_SHARDS; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 < used[i]);
+	}
+
+	for (key = 0; key < SHARD_TEST_RECORDS; key += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &key).error);
+	}
+
+	for (key = 0; key < SHARD_TEST_RECORDS; key++) {
+		if (0 == key % 2) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, &key, &value).error);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, &value).error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 3, value);
+		}
+	}
+
+	info.min_key	= NULL;
+	info.max_key	= NULL;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_info(&dictionary, &info));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SHARD_TEST_RECORDS / 2, info.record_count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !info.has_bounds);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_sync(&dictionary));
+
+	shard_test_takedown(tc, &pool, &dictionary);
+}
+
+/**
+@brief		A thread of @ref test_shard_threads and what it does.
+*/
+typedef struct {
+	planck_unit_test_t	*tc;			/**< The test */
+	ion_dictionary_t	*dictionary;	/**< The dictionary used together */
+	int					first;			/**< The first of its keys */
+} shard_test_thread_t;
+
+/**
+@brief		Inserts and reads back keys of its own, alongside the others.
+*/
+static void
+shard_test_thread_check(
+	shard_test_thread_t *thread
+) {
+	int end = thread->first + SHARD_TEST_RECORDS / SHARD_TEST_THREADS;
+	int key;
+	int value;
+
+	shard_test_fill(thread->tc, thread->dictionary, thread->first, end);
+
+	for (key = thread->first; key < end; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(thread->tc, err_ok, dictionary_get(thread->dictionary, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(thread->tc, key * 2, value);
+	}
+}
+
+/**
+@brief		Runs @ref shard_test_thread_check on a thread of its own.
+*/
+static void *
+shard_test_thread(
+	void *argument
+) {
+	shard_test_thread_check(argument);
+	return NULL;
+}
+
+/**
+@brief		Tests that several threads can operate on a sharded dictionary
+			at once.
+*/
+void
+test_shard_threads(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t			pool;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	engines[SHARD_TEST_SHARDS];
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	pthread_t					threads[SHARD_TEST_THREADS];
+	shard_test_thread_t			arguments[SHARD_TEST_THREADS];
+	int							read;
+	int							i;
+
+	shard_test_setup(tc, &pool, &handler, engines, &dictionary, NULL);
+
+	for (i = 0; i < SHARD_TEST_THREADS; i++) {
+		arguments[i].tc			= tc;
+		arguments[i].dictionary = &dictionary;
+		arguments[i].first		= i * (SHARD_TEST_RECORDS / SHARD_TEST_THREADS);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&threads[i], NULL, shard_test_thread, &arguments[i]));
+	}
+
+	for (i = 0; i < SHARD_TEST_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	shard_test_read(tc, &dictionary, &predicate, 0, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SHARD_TEST_RECORDS, read);
+
+	shard_test_takedown(tc, &pool, &dictionary);
+}
+
+/**
+@brief		Tests that batches are spread over the shards and report the
+			status of each key.
+*/
+void
+test_shard_batches(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t			pool;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	engines[SHARD_TEST_SHARDS];
+	ion_dictionary_t			dictionary;
+	ion_status_t				statuses[SHARD_TEST_RECORDS];
+	ion_status_t				status;
+	int							keys[SHARD_TEST_RECORDS];
+	int							values[SHARD_TEST_RECORDS];
+	int							i;
+
+	shard_test_setup(tc, &pool, &handler, engines, &dictionary, NULL);
+
+	for (i = 0; i < SHARD_TEST_RECORDS; i++) {
+		keys[i]		= i;
+		values[i]	= i * 2;
+	}
+
+	status = dictionary_insert_many(&dictionary, keys, values, statuses, SHARD_TEST_RECORDS);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SHARD_TEST_RECORDS, status.count);
+
+	/* every other key deleted, so half are found */
+	for (i = 0; i < SHARD_TEST_RECORDS / 2; i++) {
+		keys[i] = i * 2;
+	}
+
+	status = dictionary_delete_many(&dictionary, keys, NULL, SHARD_TEST_RECORDS / 2);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+	for (i = 0; i < SHARD_TEST_RECORDS; i++) {
+		keys[i]		= i;
+		values[i]	= -1;
+	}
+
+	status = dictionary_get_many(&dictionary, keys, values, statuses, SHARD_TEST_RECORDS);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SHARD_TEST_RECORDS / 2, status.count);
+
+	for (i = 0; i < SHARD_TEST_RECORDS; i++) {
+		if (0 == i % 2) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, statuses[i].error);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 2, values[i]);
+		}
+	}
+
+	shard_test_takedown(tc, &pool, &dictionary);
+}
+
+/**
+@brief		Tests that the cursors over shards by hash merge them in order.
+*/
+void
+test_shard_cursor_merge(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t			pool;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	engines[SHARD_TEST_SHARDS];
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	int							read;
+
+	shard_test_setup(tc, &pool, &handler, engines, &dictionary, NULL);
+	shard_test_fill(tc, &dictionary, 0, SHARD_TEST_RECORDS);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	shard_test_read(tc, &dictionary, &predicate, 0, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SHARD_TEST_RECORDS, read);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(50, int), IONIZE(249, int));
+	shard_test_read(tc, &dictionary, &predicate, 50, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 200, read);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(77, int));
+	shard_test_read(tc, &dictionary, &predicate, 77, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, read);
+
+	shard_test_takedown(tc, &pool, &dictionary);
+}
+
+/**
+@brief		Tests that the cursors over shards by range read only the
+			shards of the range, in order.
+*/
+void
+test_shard_cursor_ranges(
+	planck_unit_test_t *tc
+) {
+	ion_async_pool_t			pool;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_handler_t	engines[SHARD_TEST_SHARDS];
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	int							read;
+
+	shard_test_setup(tc, &pool, &handler, engines, &dictionary, shard_test_splits);
+	shard_test_fill(tc, &dictionary, 0, SHARD_TEST_RECORDS);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	shard_test_read(tc, &dictionary, &predicate, 0, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, SHARD_TEST_RECORDS, read);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(150, int), IONIZE(250, int));
+	shard_test_read(tc, &dictionary, &predicate, 150, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 101, read);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(120, int), IONIZE(130, int));
+	shard_test_read(tc, &dictionary, &predicate, 120, &read);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 11, read);
+
+	shard_test_takedown(tc, &pool, &dictionary);
+}
+
+planck_unit_suite_t *
+shard_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_shard_wrap);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_shard_operations);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_shard_threads);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_shard_batches);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_shard_cursor_merge);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_shard_cursor_ranges);
+
+	return suite;
+}
+
+void
+runalltests_shard(
+) {
+	planck_unit_suite_t *suite = shard_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,28 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the sharded dictionary front-end.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_SHARD_H_)
+#define TEST_SHARD_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/shard/shard_dictionary_handler.h"
+#include "../../../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../../../dictionary/skip_list/skip_list_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_shard(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_SHARD_H_ */
@@ -8,6 +8,8 @@
 
 #include "test_skip_list.h"
 #include "test_skip_list_handler.h"
+#include "test_concurrent_skip_list.h"
+#include "test_unrolled_skip_list.h"
 
 int
 main(
@@ -15,5 +17,7 @@ main(
 ) {
 	runalltests_skiplist();
 	runalltests_skiplist_handler();
+	runalltests_concurrent_skiplist();
+	runalltests_unrolled_skiplist();
 	return 0;
 }
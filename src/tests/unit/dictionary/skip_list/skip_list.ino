@@ -3,6 +3,7 @@
 #include <SD.h>
 #include "test_skip_list.h"
 #include "test_skip_list_handler.h"
+#include "test_unrolled_skip_list.h"
 
 void
 setup(
@@ -12,6 +13,7 @@ setup(
 	Serial.begin(BAUD_RATE);
 	runalltests_skiplist();
 	runalltests_skiplist_handler();
+	runalltests_unrolled_skiplist();
 }
 
 void
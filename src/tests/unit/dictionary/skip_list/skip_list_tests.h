@@ -17,6 +17,7 @@
 #include "../../../../dictionary/skip_list/skip_list_handler.h"
 #include "../../../../dictionary/dictionary_types.h"
 #include "./../../../../dictionary/dictionary.h"
+#include "../../../../util/keygen/keygen.h"
 
 #if DEBUG
 #define PRINT_HEADER() printf("=== [%d:%s] ===\n", __LINE__, __func__);
@@ -0,0 +1,306 @@
+/**
+@file
+@brief		Tests of the concurrent skiplist handler, run from several
+			threads at once.
+*/
+
+#include "test_concurrent_skip_list.h"
+
+#define ION_CSL_TEST_WRITERS			8
+#define ION_CSL_TEST_READERS			4
+#define ION_CSL_TEST_KEYS_PER_WRITER	2000
+#define ION_CSL_TEST_ROUNDS				3
+
+/**
+@brief		What the threads of a test share.
+*/
+typedef struct {
+	ion_dictionary_t	dictionary;
+	int					writers_done;	/**< Read and written atomically */
+	int					bad_reads;		/**< Read and written atomically */
+} ion_csl_test_t;
+
+/**
+@brief		A writer and the test it takes part in.
+*/
+typedef struct {
+	ion_csl_test_t	*test;
+	int				first_key;
+} ion_csl_test_writer_t;
+
+/**
+@brief		The value stored under a key after a given round of updates.
+*/
+static int
+csl_test_value(
+	int key,
+	int round
+) {
+	return key * 7 + round;
+}
+
+/**
+@brief		Inserts its own keys, updates all of them a few times, then
+			deletes the odd ones. Writers' keys interleave, so they insert
+			and delete next to each other.
+*/
+static void *
+csl_test_writer(
+	void *argument
+) {
+	ion_csl_test_writer_t	*writer		= argument;
+	ion_dictionary_t		*dictionary = &writer->test->dictionary;
+	int						i;
+	int						key;
+	int						value;
+	int						round;
+
+	for (i = 0; i < ION_CSL_TEST_KEYS_PER_WRITER; i++) {
+		key		= i * ION_CSL_TEST_WRITERS + writer->first_key;
+		value	= csl_test_value(key, 0);
+
+		if (err_ok != dictionary_insert(dictionary, &key, &value).error) {
+			__atomic_add_fetch(&writer->test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	for (round = 1; round <= ION_CSL_TEST_ROUNDS; round++) {
+		for (i = 0; i < ION_CSL_TEST_KEYS_PER_WRITER; i++) {
+			key		= i * ION_CSL_TEST_WRITERS + writer->first_key;
+			value	= csl_test_value(key, round);
+			dictionary_update(dictionary, &key, &value);
+		}
+	}
+
+	for (i = 0; i < ION_CSL_TEST_KEYS_PER_WRITER; i++) {
+		key = i * ION_CSL_TEST_WRITERS + writer->first_key;
+
+		if ((0 != key % 2) && (err_ok != dictionary_delete(dictionary, &key).error)) {
+			__atomic_add_fetch(&writer->test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	__atomic_add_fetch(&writer->test->writers_done, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/**
+@brief		Looks keys up until the writers are done, counting any value
+			that was never stored under its key.
+*/
+static void *
+csl_test_reader(
+	void *argument
+) {
+	ion_csl_test_t	*test	= argument;
+	int				total	= ION_CSL_TEST_WRITERS * ION_CSL_TEST_KEYS_PER_WRITER;
+	uint32_t		random	= 12345;
+	int				key;
+	int				value;
+	ion_status_t	status;
+
+	while (__atomic_load_n(&test->writers_done, __ATOMIC_ACQUIRE) < ION_CSL_TEST_WRITERS) {
+		random	= random * 1103515245 + 12345;
+		key		= (random >> 8) % total;
+		value	= -1;
+		status	= dictionary_get(&test->dictionary, &key, &value);
+
+		if ((err_ok == status.error) && ((value < csl_test_value(key, 0)) || (value > csl_test_value(key, ION_CSL_TEST_ROUNDS)))) {
+			__atomic_add_fetch(&test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+		else if ((err_ok != status.error) && (-1 != value)) {
+			__atomic_add_fetch(&test->bad_reads, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Walks the whole skiplist with cursors until the writers are
+			done, counting any cursor that returns keys out of order or
+			values never stored under them.
+*/
+static void *
+csl_test_scanner(
+	void *argument
+) {
+	ion_csl_test_t		*test = argument;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	int					key;
+	int					value;
+	int					last;
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	while (__atomic_load_n(&test->writers_done, __ATOMIC_ACQUIRE) < ION_CSL_TEST_WRITERS) {
+		dictionary_build_predicate(&predicate, predicate_all_records);
+
+		if (err_ok != dictionary_find(&test->dictionary, &predicate, &cursor)) {
+			__atomic_add_fetch(&test->bad_reads, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}
+
+		for (last = -1; cs_cursor_active == cursor->next(cursor, &record); last = key) {
+			if ((key <= last) || (value < csl_test_value(key, 0)) || (value > csl_test_value(key, ION_CSL_TEST_ROUNDS))) {
+				__atomic_add_fetch(&test->bad_reads, 1, __ATOMIC_RELAXED);
+			}
+		}
+
+		cursor->destroy(&cursor);
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Tests that concurrent writers, lock-free readers and cursors
+			only ever see values that were stored, and that every write
+			lands.
+
+@param		tc
+				Test case.
+*/
+void
+test_concurrent_skiplist_threads(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_csl_test_t				test;
+	ion_csl_test_writer_t		writers[ION_CSL_TEST_WRITERS];
+	pthread_t					threads[ION_CSL_TEST_WRITERS + ION_CSL_TEST_READERS];
+	int							total = ION_CSL_TEST_WRITERS * ION_CSL_TEST_KEYS_PER_WRITER;
+	int							i;
+	int							key;
+	int							value;
+	ion_status_t				status;
+
+	csldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &test.dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 12));
+
+	test.writers_done	= 0;
+	test.bad_reads		= 0;
+
+	for (i = 0; i < ION_CSL_TEST_READERS; i++) {
+		pthread_create(&threads[ION_CSL_TEST_WRITERS + i], NULL, (0 == i % 2) ? csl_test_reader : csl_test_scanner, &test);
+	}
+
+	for (i = 0; i < ION_CSL_TEST_WRITERS; i++) {
+		writers[i].test			= &test;
+		writers[i].first_key	= i;
+		pthread_create(&threads[i], NULL, csl_test_writer, &writers[i]);
+	}
+
+	for (i = 0; i < ION_CSL_TEST_WRITERS + ION_CSL_TEST_READERS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, test.bad_reads);
+
+	for (key = 0; key < total; key++) {
+		status = dictionary_get(&test.dictionary, &key, &value);
+
+		if (0 == key % 2) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, csl_test_value(key, ION_CSL_TEST_ROUNDS), value);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test.dictionary));
+}
+
+/**
+@brief		Tests that a cursor keeps its place by key, so writes between
+			its steps neither stop it nor make it repeat a record.
+
+@param		tc
+				Test case.
+*/
+void
+test_concurrent_skiplist_cursor_writes(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	int							key;
+	int							value;
+	int							other;
+	int							found;
+
+	csldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 2, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+
+	for (key = 0; key < 100; key += 2) {
+		value = key;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+	}
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(10, int), IONIZE(50, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10 + found * 2, key);
+
+		/* the record just read goes, and the one after it moves up a key */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &key).error);
+		other = key + 2;
+
+		if (other <= 50) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &other).error);
+			other = key + 1;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &other, &other).error);
+			other = key + 2;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &other, &other).error);
+			other = key + 1;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &other).error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 21, found);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, key < 10 || key > 50);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 29, found);
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+planck_unit_suite_t *
+concurrent_skiplist_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_concurrent_skiplist_threads);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_concurrent_skiplist_cursor_writes);
+
+	return suite;
+}
+
+void
+runalltests_concurrent_skiplist(
+) {
+	planck_unit_suite_t *suite = concurrent_skiplist_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_CONCURRENT_SKIP_LIST_H_
+#define TEST_CONCURRENT_SKIP_LIST_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/dictionary_types.h"
+#include "./../../../../dictionary/dictionary.h"
+#include "../../../../dictionary/skip_list/concurrent_skip_list_handler.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+void
+runalltests_concurrent_skiplist(
+);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -253,10 +253,13 @@ test_skiplist_randomized_insert(
 
 	strcpy((char *) str, "random");
 
-	int i;
+	ion_keygen_t	keys;
+	int				i;
+
+	ion_keygen_init(&keys, ion_keygen_uniform, 101, 1);
 
 	for (i = 0; i < 100; i++) {
-		int key				= rand() % 101;
+		int key				= (int) ion_keygen_next(&keys);
 
 		ion_status_t status = sl_insert(&skiplist, (ion_key_t) &key, str);
 
@@ -493,12 +496,15 @@ test_skiplist_get_node_several(
 
 	initialize_skiplist_std_conditions(&skiplist);
 
-	int			targets[50];
-	ion_byte_t	buffer[10];
-	int			i;
+	int				targets[50];
+	ion_byte_t		buffer[10];
+	ion_keygen_t	keys;
+	int				i;
+
+	ion_keygen_init(&keys, ion_keygen_uniform, 1000, 1);
 
 	for (i = 0; i < 50; i++) {
-		int key = rand() % 1000;
+		int key = (int) ion_keygen_next(&keys);
 
 		targets[i] = key;
 		sprintf((char *) buffer, "TEST %d", key);
@@ -1922,6 +1928,533 @@ test_skiplist_big_keys(
 	sl_destroy(&skiplist);
 }
 
+/**
+@brief	  Tests that each node is carved with its tower, key and value as
+			one piece of the arena, and that deleted nodes are reused by
+			later inserts rather than carving more.
+
+@param	  tc
+				Test case.
+*/
+void
+test_skiplist_node_arena(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t	skiplist;
+	ion_byte_t		*arena;
+	size_t			arena_used;
+	int				i;
+
+	/* a numerator of 0 keeps every node at the lowest height */
+	initialize_skiplist(&skiplist, key_type_numeric_signed, dictionary_compare_signed_value, 7, sizeof(int), 10, 0, 4);
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == sl_insert(&skiplist, (ion_key_t) &i, (ion_value_t) (char *) { "arena" }).error);
+	}
+
+	for (i = 0; i < 100; i++) {
+		ion_sl_node_t *node = sl_find_node(&skiplist, (ion_key_t) &i);
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == node->height);
+		PLANCK_UNIT_ASSERT_TRUE(tc, (ion_byte_t *) node < (ion_byte_t *) node->key);
+		PLANCK_UNIT_ASSERT_TRUE(tc, (ion_byte_t *) node->next >= (ion_byte_t *) node->key + sizeof(int));
+		PLANCK_UNIT_ASSERT_TRUE(tc, (ion_byte_t *) node->value == (ion_byte_t *) (node->next + 1));
+		PLANCK_UNIT_ASSERT_TRUE(tc, *(int *) node->key == i);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, (char *) node->value, "arena");
+	}
+
+	arena		= skiplist.arena;
+	arena_used	= skiplist.arena_used;
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == sl_delete(&skiplist, (ion_key_t) &i).error);
+	}
+
+	for (i = 100; i < 200; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == sl_insert(&skiplist, (ion_key_t) &i, (ion_value_t) (char *) { "reused" }).error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, arena == skiplist.arena);
+	PLANCK_UNIT_ASSERT_TRUE(tc, arena_used == skiplist.arena_used);
+
+	for (i = 100; i < 200; i++) {
+		ion_sl_node_t *node = sl_find_node(&skiplist, (ion_key_t) &i);
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, *(int *) node->key == i);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, (char *) node->value, "reused");
+	}
+
+	sl_destroy(&skiplist);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == skiplist.arena);
+}
+
+/**
+@brief	  Tests that heights are drawn from each skiplist's own generator,
+			so equal seeds give equal heights, and that they stay within the
+			skiplist and follow p, whether read off one word or drawn per
+			level.
+
+@param	  tc
+				Test case.
+*/
+void
+test_skiplist_gen_level(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t	first;
+	ion_skiplist_t	second;
+	int				pnums[]		= { 1, 1, 1 };
+	int				pdens[]		= { 2, 4, 3 };
+	int				i;
+	int				j;
+	int				raised;
+
+	for (j = 0; j < 3; j++) {
+		initialize_skiplist(&first, key_type_numeric_signed, dictionary_compare_signed_value, 7, sizeof(int), sizeof(int), pnums[j], pdens[j]);
+		initialize_skiplist(&second, key_type_numeric_signed, dictionary_compare_signed_value, 7, sizeof(int), sizeof(int), pnums[j], pdens[j]);
+
+		sl_seed(&first, 42);
+		sl_seed(&second, 42);
+
+		raised = 0;
+
+		for (i = 0; i < 3000; i++) {
+			ion_sl_level_t level = sl_gen_level(&first);
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, level == sl_gen_level(&second));
+			PLANCK_UNIT_ASSERT_TRUE(tc, (0 <= level) && (level < 7));
+
+			if (0 < level) {
+				raised++;
+			}
+		}
+
+		/* about p of the heights are above the lowest */
+		PLANCK_UNIT_ASSERT_TRUE(tc, raised * pdens[j] > 3000 * pnums[j] * 9 / 10);
+		PLANCK_UNIT_ASSERT_TRUE(tc, raised * pdens[j] < 3000 * pnums[j] * 11 / 10);
+
+		sl_destroy(&first);
+		sl_destroy(&second);
+	}
+}
+
+/**
+@brief	  The comparisons made by @ref sl_test_counting_compare.
+*/
+static long sl_test_comparisons;
+
+/**
+@brief	  Compares signed keys, counting each comparison.
+*/
+static char
+sl_test_counting_compare(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	sl_test_comparisons++;
+	return dictionary_compare_signed_value(first_key, second_key, key_size);
+}
+
+/**
+@brief	  Checks that every level of a skiplist is in order and only
+			links nodes tall enough for it.
+@param[out]	count
+					Set to the length of the bottom level.
+*/
+static void
+sl_test_check_levels(
+	planck_unit_test_t	*tc,
+	ion_skiplist_t		*skiplist,
+	int					*count
+) {
+	ion_sl_node_t	*cursor;
+	ion_sl_level_t	h;
+
+	*count = 0;
+
+	for (h = 0; h <= skiplist->head->height; h++) {
+		for (cursor = skiplist->head->next[h]; NULL != cursor; cursor = cursor->next[h]) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, cursor->height >= h);
+
+			if (NULL != cursor->next[h]) {
+				PLANCK_UNIT_ASSERT_TRUE(tc, *(int *) cursor->key <= *(int *) cursor->next[h]->key);
+			}
+
+			if (0 == h) {
+				(*count)++;
+			}
+		}
+	}
+}
+
+/**
+@brief	  Tests that searches start from where the last one ended, so
+			ascending inserts stay cheap, while searches far from the last
+			key and in either direction stay correct.
+
+@param	  tc
+				Test case.
+*/
+void
+test_skiplist_finger(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t	skiplist;
+	long			from_finger;
+	long			from_head;
+	int				key;
+	int				value;
+	int				count;
+	int				i;
+
+	initialize_skiplist(&skiplist, key_type_numeric_signed, sl_test_counting_compare, 16, sizeof(int), sizeof(int), 1, 4);
+
+	sl_test_comparisons = 0;
+
+	for (key = 0; key < 4000; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&skiplist, &key, &key).error);
+	}
+
+	from_finger = sl_test_comparisons;
+
+	/* a search from the head passes its top levels' nodes whatever the key */
+	sl_test_comparisons = 0;
+
+	for (key = 0; key < 4000; key++) {
+		for (i = 0; i <= skiplist.head->height; i++) {
+			skiplist.finger[i] = skiplist.head;
+		}
+
+		sl_find_node(&skiplist, &key);
+	}
+
+	from_head = sl_test_comparisons;
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, from_finger / 4000 < 12);
+	PLANCK_UNIT_ASSERT_TRUE(tc, from_finger < from_head);
+	sl_test_check_levels(tc, &skiplist, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4000, count);
+
+	/* deleting behind and ahead of the last key, and near it */
+	for (i = 0; i < 4000; i += 3) {
+		key = (i * 7) % 4000;
+
+		if (0 != key % 2) {
+			sl_delete(&skiplist, &key);
+		}
+
+		key = 3999 - i;
+		sl_delete(&skiplist, &key);
+	}
+
+	sl_test_check_levels(tc, &skiplist, &count);
+
+	/* inserting backwards, then finding everything in a scattered order */
+	for (key = 5999; key >= 4000; key--) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&skiplist, &key, &key).error);
+	}
+
+	sl_test_check_levels(tc, &skiplist, &count);
+
+	for (i = 0; i < 6000; i++) {
+		key = (i * 2654435761U) % 6000;
+
+		ion_status_t status = sl_query(&skiplist, &key, &value);
+
+		if (err_ok == status.error) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+		}
+		else {
+			/* only deleted keys are missing */
+			PLANCK_UNIT_ASSERT_TRUE(tc, key < 4000);
+		}
+	}
+
+	for (key = 4000; key < 6000; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&skiplist, &key, &value).error);
+	}
+
+	sl_destroy(&skiplist);
+}
+
+/**
+@brief	  Tests that a skiplist with a budget spills its records to runs,
+			stays within the budget and still reaches every record.
+
+@param	  tc
+				CuTest dependency
+*/
+void
+test_skiplist_spill(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t	skiplist;
+	ion_value_t		ref;
+	int				key;
+	int				value;
+
+	initialize_skiplist(&skiplist, key_type_numeric_signed, dictionary_compare_signed_value, 7, sizeof(int), sizeof(int), 1, 4);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_set_budget(&skiplist, 3 * ION_SL_ARENA_BLOCK_SIZE, 900));
+
+	for (key = 0; key < 2000; key++) {
+		value = key * 2;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&skiplist, &key, &value).error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, skiplist.arena_total <= 3 * ION_SL_ARENA_BLOCK_SIZE);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, skiplist.run_count > 1);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, sl_set_budget(&skiplist, 0, 900));
+
+	for (key = 0; key < 2000; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&skiplist, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 2, value);
+	}
+
+	/* an update reaches a spilled record, a delete removes it from its run */
+	key		= 3;
+	value	= -3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, sl_update(&skiplist, &key, &value).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&skiplist, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -3, value);
+
+	key = 4;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, sl_delete(&skiplist, &key).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, sl_query(&skiplist, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, sl_delete(&skiplist, &key).error);
+
+	/* an update of a missing key inserts it */
+	key		= 5000;
+	value	= 1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_update(&skiplist, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&skiplist, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, value);
+
+	/* only records in memory can be pointed at, the others may be in a run */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_get_ref(&skiplist, &key, &ref).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, *(int *) ref);
+	key = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_not_implemented, sl_get_ref(&skiplist, &key, &ref).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_destroy(&skiplist));
+}
+
+/**
+@brief	  Supplies the keys 0, 0, 1, 1, 2, 2, ... up to a limit, for
+			@ref test_skiplist_bulk_load. The context is a pair of the next
+			index and the number of records to supply.
+*/
+static ion_err_t
+sl_test_bulk_next(
+	void			*context,
+	ion_record_t	*record
+) {
+	int *state = context;
+
+	if (state[0] >= state[1]) {
+		return err_item_not_found;
+	}
+
+	*(int *) record->key	= state[0] / 2;
+	*(int *) record->value	= state[0];
+	state[0]++;
+
+	return err_ok;
+}
+
+/**
+@brief	  Supplies keys counting down, which a bulk load must refuse.
+*/
+static ion_err_t
+sl_test_bulk_next_descending(
+	void			*context,
+	ion_record_t	*record
+) {
+	int *state = context;
+
+	*(int *) record->key	= state[1] - state[0];
+	*(int *) record->value	= 0;
+	state[0]++;
+
+	return err_ok;
+}
+
+/**
+@brief	  Tests that a bulk load links sorted records without searching,
+			with balanced or random heights, and refuses unsorted records
+			and a skiplist that is not empty.
+
+@param	  tc
+				CuTest dependency
+*/
+void
+test_skiplist_bulk_load(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t	skiplist;
+	ion_sl_node_t	*cursor;
+	ion_status_t	status;
+	int				state[2];
+	int				key;
+	int				value;
+	int				count;
+	int				i;
+
+	initialize_skiplist(&skiplist, key_type_numeric_signed, sl_test_counting_compare, 8, sizeof(int), sizeof(int), 1, 4);
+
+	state[0]			= 0;
+	state[1]			= 5000;
+	sl_test_comparisons = 0;
+	status				= sl_bulk_load(&skiplist, sl_test_bulk_next, state, boolean_true);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5000, status.count);
+
+	/* one comparison per record, only to check the order */
+	PLANCK_UNIT_ASSERT_TRUE(tc, sl_test_comparisons < 5000);
+	sl_test_check_levels(tc, &skiplist, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5000, count);
+
+	/* every fourth node is a level taller, every sixteenth two, and so on */
+	for (i = 1, cursor = skiplist.head->next[0]; NULL != cursor; i++, cursor = cursor->next[0]) {
+		for (key = i, value = 0; 0 == key % 4; key /= 4) {
+			value++;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, value, cursor->height);
+	}
+
+	for (key = 0; key < 2500; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&skiplist, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 2, value);
+	}
+
+	/* the skiplist carries on as usual after the load */
+	key		= 9000;
+	value	= 1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&skiplist, &key, &value).error);
+	key = -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&skiplist, &key, &value).error);
+	key = 7;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, sl_delete(&skiplist, &key).count);
+	sl_test_check_levels(tc, &skiplist, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5000, count);
+
+	state[0] = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, sl_bulk_load(&skiplist, sl_test_bulk_next, state, boolean_true).error);
+	sl_destroy(&skiplist);
+
+	/* random heights, and records out of order stop the load */
+	initialize_skiplist(&skiplist, key_type_numeric_signed, sl_test_counting_compare, 8, sizeof(int), sizeof(int), 1, 4);
+	state[0]	= 0;
+	status		= sl_bulk_load(&skiplist, sl_test_bulk_next, state, boolean_false);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5000, status.count);
+	sl_test_check_levels(tc, &skiplist, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5000, count);
+	sl_destroy(&skiplist);
+
+	initialize_skiplist(&skiplist, key_type_numeric_signed, sl_test_counting_compare, 8, sizeof(int), sizeof(int), 1, 4);
+	state[0]	= 0;
+	status		= sl_bulk_load(&skiplist, sl_test_bulk_next_descending, state, boolean_false);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	sl_test_check_levels(tc, &skiplist, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, count);
+	sl_destroy(&skiplist);
+}
+
+/**
+@brief	  Tests that a skiplist without a maximum height grows one as its
+			nodes do, and that its statistics describe its shape and the
+			cost of its searches.
+
+@param	  tc
+				CuTest dependency
+*/
+void
+test_skiplist_auto_height(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t	grown;
+	ion_skiplist_t	fixed;
+	ion_sl_stats_t	stats;
+	unsigned long	grown_hops;
+	unsigned long	total;
+	uint32_t		seed;
+	int				key;
+	int				value;
+	int				count;
+	int				i;
+
+	initialize_skiplist(&grown, key_type_numeric_signed, dictionary_compare_signed_value, 0, sizeof(int), sizeof(int), 1, 4);
+	initialize_skiplist(&fixed, key_type_numeric_signed, dictionary_compare_signed_value, 3, sizeof(int), sizeof(int), 1, 4);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_SL_AUTO_HEIGHT_START, grown.maxheight);
+
+	for (i = 0; i < 20000; i++) {
+		key = (i * 7919) % 20000;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&grown, &key, &key).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_insert(&fixed, &key, &key).error);
+	}
+
+	/* a level more at each of 4^3, 4^4 ... 4^7 nodes, on top of the first 4 */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_stats(&grown, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20000, stats.nodes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, stats.maxheight);
+	sl_test_check_levels(tc, &grown, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20000, count);
+
+	for (i = 0, total = 0; i < ION_SL_STATS_LEVELS; i++) {
+		total += stats.levels[i];
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20000, total);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.levels[0] > stats.levels[1] * 2);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 != stats.levels[5]);
+
+	sl_reset_stats(&grown);
+	sl_reset_stats(&fixed);
+
+	/* scattered keys, so that the finger gives neither list a head start */
+	for (i = 0, seed = 1; i < 1000; i++) {
+		seed	= seed * 1103515245U + 12345U;
+		key		= (int) ((seed >> 8) % 20000);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&grown, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_query(&fixed, &key, &value).error);
+	}
+
+	sl_stats(&grown, &stats);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, stats.searches);
+	grown_hops = stats.hops;
+
+	/* too short a list passes far more nodes on each level */
+	sl_stats(&fixed, &stats);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, stats.maxheight);
+	PLANCK_UNIT_ASSERT_TRUE(tc, grown_hops / 1000 < 40);
+	PLANCK_UNIT_ASSERT_TRUE(tc, grown_hops * 4 < stats.hops);
+
+	for (key = 0; key < 5000; key++) {
+		sl_delete(&grown, &key);
+	}
+
+	sl_stats(&grown, &stats);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 15000, stats.nodes);
+
+	sl_destroy(&grown);
+	sl_destroy(&fixed);
+}
+
 /**
 @brief	  Creates the suite to test using PlanckUnit test cases.
 @return	 Pointer to a PlanckUnit test suite.
@@ -2026,6 +2559,12 @@ skiplist_getsuite_3(
 	/* Variation Tests */
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_different_size);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_big_keys);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_node_arena);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_gen_level);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_finger);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_spill);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_bulk_load);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_auto_height);
 
 	return suite;
 }
@@ -129,7 +129,7 @@ test_dictionary_creation(
 	ion_skiplist_t *skiplist = (ion_skiplist_t *) dict.instance;
 
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->key_type == key_type_numeric_signed);
-	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->compare == dictionary_compare_signed_value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_is_signed_compare(dict.instance->compare));
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->record.key_size == sizeof(int));
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->record.value_size == 10);
 	PLANCK_UNIT_ASSERT_TRUE(tc, skiplist != NULL);
@@ -455,6 +455,176 @@ test_slhandler_cursor_range_exact_results(
 	dictionary_delete_dictionary(&dict);
 }
 
+/**
+@brief	  The comparisons made by @ref slhandler_counting_compare.
+*/
+static long slhandler_comparisons;
+
+/**
+@brief	  Compares signed keys, counting each comparison.
+*/
+static char
+slhandler_counting_compare(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	slhandler_comparisons++;
+	return dictionary_compare_signed_value(first_key, second_key, key_size);
+}
+
+/**
+@brief	  Tests that a narrow range over a large skiplist seeks to its
+			lower bound and stops at its upper one, without touching the
+			keys before or after it.
+
+@param	  tc
+				Test case.
+*/
+void
+test_slhandler_cursor_range_seek(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_dictionary_t			dict;
+	ion_dictionary_handler_t	handler;
+	ion_dict_cursor_t			*cursor;
+	ion_predicate_t				predicate;
+	ion_record_t				record;
+	int							key;
+	int							value;
+	int							found;
+
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dict, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 16));
+	dict.instance->compare = slhandler_counting_compare;
+
+	/* even keys only, the last two twice */
+	for (key = 0; key < 20000; key += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dict, &key, &key).error);
+	}
+
+	key = 19998;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dict, &key, &key).error);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	/* move the finger far from the range, so the seek does not start near it */
+	key = 0;
+	dictionary_get(&dict, &key, &value);
+
+	slhandler_comparisons = 0;
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(12001, int), IONIZE(12020, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 12002 + found * 2, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, found);
+	PLANCK_UNIT_ASSERT_TRUE(tc, slhandler_comparisons < 200);
+	cursor->destroy(&cursor);
+
+	/* a range between two keys holds nothing */
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(501, int), IONIZE(501, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+
+	/* past the last key there is nothing, up to it the duplicates count */
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(20000, int), IONIZE(30000, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(19995, int), IONIZE(19998, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 19996 == key || 19998 == key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, found);
+	cursor->destroy(&cursor);
+
+	dictionary_delete_dictionary(&dict);
+}
+
+/**
+@brief	  Tests that cursors merge the records in memory with those spilled
+			to runs, in key order.
+
+@param	  tc
+				Test case.
+*/
+void
+test_slhandler_cursor_spilled(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_dictionary_t			dict;
+	ion_dictionary_handler_t	handler;
+	ion_dict_cursor_t			*cursor;
+	ion_predicate_t				predicate;
+	ion_record_t				record;
+	int							key;
+	int							value;
+	int							found;
+	int							i;
+
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dict, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sl_set_budget((ion_skiplist_t *) dict.instance, 2 * ION_SL_ARENA_BLOCK_SIZE, 910));
+
+	/* scattered keys, so that every run spans the whole range */
+	for (i = 0; i < 1500; i++) {
+		key		= (i * 7) % 1500;
+		value	= key + 1;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dict, &key, &value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, ((ion_skiplist_t *) dict.instance)->run_count > 1);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, found, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key + 1, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1500, found);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(100, int), IONIZE(199, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100 + found, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, found);
+	cursor->destroy(&cursor);
+
+	/* the first key went to the oldest run */
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(0, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	dictionary_delete_dictionary(&dict);
+}
+
 /**
 @brief	  Creates the suite to test using PlanckUnit test cases.
 @return	 Pointer to a PlanckUnit test suite.
@@ -477,6 +647,8 @@ skiplist_handler_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_with_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_lower_missing);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_exact_results);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_seek);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_spilled);
 
 	return suite;
 }
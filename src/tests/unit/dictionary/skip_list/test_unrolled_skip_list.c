@@ -0,0 +1,365 @@
+/**
+@file
+@brief		Tests of the unrolled skiplist and its handler.
+*/
+
+#include "test_unrolled_skip_list.h"
+
+#define ION_USL_TEST_KEYS	500
+#define ION_USL_TEST_OPS	20000
+
+/**
+@brief		Checks that the records are in order, that every node holds
+			some and no more than a node may, and that every level links
+			exactly the nodes tall enough for it.
+@param[out]	records
+					Set to the number of records.
+@param[out]	nodes
+					Set to the number of nodes.
+*/
+static void
+usl_test_check(
+	planck_unit_test_t		*tc,
+	ion_unrolled_skiplist_t *skiplist,
+	int						*records,
+	int						*nodes
+) {
+	ion_usl_node_t	*node;
+	ion_sl_level_t	h;
+	int				last = 0;
+	int				tall;
+	int				linked;
+	int				i;
+
+	*records	= 0;
+	*nodes		= 0;
+
+	for (node = skiplist->head->next[0]; NULL != node; node = node->next[0]) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 < node->count && ION_USL_NODE_RECORDS >= node->count);
+
+		for (i = 0; i < node->count; i++) {
+			int key = *(int *) usl_record(skiplist, node, i);
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 == *records || last <= key);
+			last = key;
+			(*records)++;
+		}
+
+		(*nodes)++;
+	}
+
+	for (h = 1; h <= skiplist->head->height; h++) {
+		tall	= 0;
+		linked	= 0;
+
+		for (node = skiplist->head->next[0]; NULL != node; node = node->next[0]) {
+			tall += node->height >= h;
+		}
+
+		for (node = skiplist->head->next[h]; NULL != node; node = node->next[h]) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, node->height >= h);
+			linked++;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, tall, linked);
+	}
+}
+
+/**
+@brief		Tests random inserts, updates and deletes, duplicates included,
+			against a table of how many records each key has.
+*/
+void
+test_usl_against_model(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dict_cursor_t			*cursor;
+	ion_predicate_t				predicate;
+	ion_record_t				record;
+	ion_status_t				status;
+	static int					count[ION_USL_TEST_KEYS];
+	static int					value[ION_USL_TEST_KEYS];
+	uint32_t					seed = 7;
+	int							records;
+	int							total;
+	int							key;
+	int							got;
+	int							op;
+	int							nodes;
+	int							i;
+
+	usldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+
+	for (key = 0; key < ION_USL_TEST_KEYS; key++) {
+		count[key]	= 0;
+		value[key]	= key;
+	}
+
+	for (op = 0; op < ION_USL_TEST_OPS; op++) {
+		seed	= seed * 1103515245U + 12345U;
+		key		= (int) ((seed >> 8) % ION_USL_TEST_KEYS);
+
+		switch ((seed >> 24) % 8) {
+			case 0:
+				status = dictionary_delete(&dictionary, &key);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count[key], status.count);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == count[key]) ? err_item_not_found : err_ok, status.error);
+				count[key] = 0;
+				break;
+
+			case 1:
+				value[key]	= op;
+				status		= dictionary_update(&dictionary, &key, &value[key]);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == count[key]) ? 1 : count[key], status.count);
+				count[key]	= (0 == count[key]) ? 1 : count[key];
+				break;
+
+			case 2:
+				status = dictionary_get(&dictionary, &key, &got);
+
+				if (0 == count[key]) {
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+				}
+				else {
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+					PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, value[key], got);
+				}
+
+				break;
+
+			default:
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value[key]).error);
+				count[key]++;
+				break;
+		}
+	}
+
+	for (key = 0, total = 0; key < ION_USL_TEST_KEYS; key++) {
+		total += count[key];
+	}
+
+	usl_test_check(tc, (ion_unrolled_skiplist_t *) dictionary.instance, &records, &nodes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, total, records);
+
+	/* every record once, in key order */
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &got;
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 0; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 < count[key]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, value[key], got);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, total, i);
+	cursor->destroy(&cursor);
+
+	dictionary_delete_dictionary(&dictionary);
+}
+
+/**
+@brief		Tests that ascending inserts fill every node but the last, and
+			that duplicates spread over several nodes are all found.
+*/
+void
+test_usl_packing_and_duplicates(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dict_cursor_t			*cursor;
+	ion_predicate_t				predicate;
+	ion_record_t				record;
+	int							records;
+	int							key;
+	int							value;
+	int							found;
+	int							nodes;
+
+	usldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+
+	for (key = 0; key < 1000; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+	}
+
+	usl_test_check(tc, (ion_unrolled_skiplist_t *) dictionary.instance, &records, &nodes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (1000 + ION_USL_NODE_RECORDS - 1) / ION_USL_NODE_RECORDS, nodes);
+
+	/* more copies of a key than a node holds */
+	key = 500;
+
+	for (value = 0; value < 3 * ION_USL_NODE_RECORDS; value++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+	}
+
+	usl_test_check(tc, (ion_unrolled_skiplist_t *) dictionary.instance, &records, &nodes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000 + 3 * ION_USL_NODE_RECORDS, records);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(500, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 500, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1 + 3 * ION_USL_NODE_RECORDS, found);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(499, int), IONIZE(501, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (found = 0; cs_cursor_active == cursor->next(cursor, &record); found++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 499 <= key && 501 >= key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 + 3 * ION_USL_NODE_RECORDS, found);
+	cursor->destroy(&cursor);
+
+	key = 500;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1 + 3 * ION_USL_NODE_RECORDS, dictionary_delete(&dictionary, &key).count);
+	usl_test_check(tc, (ion_unrolled_skiplist_t *) dictionary.instance, &records, &nodes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 999, records);
+
+	/* a range between two keys holds nothing */
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(500, int), IONIZE(500, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+
+	dictionary_delete_dictionary(&dictionary);
+}
+
+/**
+@brief		Reads every record of a cursor, alternating between the batched
+			read and single records when @p mixed is set.
+@return		The number of records read.
+*/
+static int
+usl_test_read_all(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	int					batch,
+	ion_boolean_t		mixed,
+	int					*keys,
+	int					*values
+) {
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	int					total = 0;
+	int					read;
+
+	dictionary_find(dictionary, predicate, &cursor);
+
+	do {
+		read	= dictionary_next_batch(cursor, keys + total, values + total, batch);
+		total	+= read;
+
+		if (mixed && (read == batch)) {
+			record.key		= (ion_key_t) (keys + total);
+			record.value	= (ion_value_t) (values + total);
+
+			if (cs_cursor_active == cursor->next(cursor, &record)) {
+				total++;
+			}
+		}
+	} while (read == batch && cs_end_of_results != cursor->status);
+
+	cursor->destroy(&cursor);
+
+	return total;
+}
+
+/**
+@brief		Tests that batched cursor reads give the records single reads
+			do, for batches that do and do not line up with the nodes.
+*/
+void
+test_usl_next_batch(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicates[3];
+	static int					expected_keys[1100];
+	static int					expected_values[1100];
+	static int					keys[1100];
+	static int					values[1100];
+	static const int			batches[] = { 1, 5, ION_USL_NODE_RECORDS, 33, 2000 };
+	int							expected;
+	int							key;
+	int							value;
+	int							p;
+	int							b;
+
+	usldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+
+	for (key = 0; key < 1000; key++) {
+		dictionary_insert(&dictionary, &key, IONIZE(key * 3, int));
+	}
+
+	/* duplicates over several nodes, within every predicate */
+	key = 500;
+
+	for (value = 0; value < 3 * ION_USL_NODE_RECORDS; value++) {
+		dictionary_insert(&dictionary, &key, &value);
+	}
+
+	dictionary_build_predicate(&predicates[0], predicate_equality, IONIZE(500, int));
+	dictionary_build_predicate(&predicates[1], predicate_range, IONIZE(101, int), IONIZE(700, int));
+	dictionary_build_predicate(&predicates[2], predicate_all_records);
+
+	for (p = 0; p < 3; p++) {
+		/* a batch of one is a single read */
+		expected = usl_test_read_all(&dictionary, &predicates[p], 1, boolean_false, expected_keys, expected_values);
+
+		for (b = 0; b < (int) (sizeof(batches) / sizeof(batches[0])); b++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, usl_test_read_all(&dictionary, &predicates[p], batches[b], boolean_false, keys, values));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(expected_keys, keys, expected * sizeof(int)));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(expected_values, values, expected * sizeof(int)));
+
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, usl_test_read_all(&dictionary, &predicates[p], batches[b], boolean_true, keys, values));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(expected_keys, keys, expected * sizeof(int)));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(expected_values, values, expected * sizeof(int)));
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1 + 3 * ION_USL_NODE_RECORDS, usl_test_read_all(&dictionary, &predicates[0], 1, boolean_false, keys, values));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 600 + 3 * ION_USL_NODE_RECORDS, usl_test_read_all(&dictionary, &predicates[1], 1, boolean_false, keys, values));
+
+	dictionary_delete_dictionary(&dictionary);
+}
+
+planck_unit_suite_t *
+unrolled_skiplist_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_usl_against_model);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_usl_packing_and_duplicates);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_usl_next_batch);
+
+	return suite;
+}
+
+void
+runalltests_unrolled_skiplist(
+) {
+	planck_unit_suite_t *suite = unrolled_skiplist_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_UNROLLED_SKIP_LIST_H_
+#define TEST_UNROLLED_SKIP_LIST_H_
+
+#include <stdio.h>
+#include <string.h>
+#include "skip_list_tests.h"
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/dictionary_types.h"
+#include "./../../../../dictionary/dictionary.h"
+#include "../../../../dictionary/skip_list/unrolled_skip_list_handler.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+void
+runalltests_unrolled_skiplist(
+);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
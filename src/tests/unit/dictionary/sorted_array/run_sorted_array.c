@@ -0,0 +1,8 @@
+#include "test_sorted_array.h"
+
+int
+main(
+) {
+	runalltests_sorted_array();
+	return 0;
+}
@@ -0,0 +1,307 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the appends, layout and searches of the static sorted
+			array.
+*/
+/******************************************************************************/
+
+#include "test_sorted_array.h"
+
+/**
+@brief		Creates an array of int keys and values.
+*/
+static ion_err_t
+initialize_sorted_array(
+	ion_sorted_array_t	*sorted_array,
+	long				records
+) {
+	sorted_array->super.compare = dictionary_compare_signed_value;
+	return sa_initialize(sorted_array, key_type_numeric_signed, sizeof(int), sizeof(int), records);
+}
+
+/**
+@brief		A stream of the keys @c 0, @c 2, @c 4 and on, each with a value
+			of its key plus one.
+*/
+typedef struct {
+	int remaining;	/**< The records left to supply */
+	int key;		/**< The key of the next record */
+} ion_sa_test_source_t;
+
+/**
+@brief		Reads the next record of an @ref ion_sa_test_source_t.
+*/
+static ion_err_t
+next_source_record(
+	void			*context,
+	ion_record_t	*record
+) {
+	ion_sa_test_source_t	*source = (ion_sa_test_source_t *) context;
+	int						value	= source->key + 1;
+
+	if (0 == source->remaining) {
+		return err_item_not_found;
+	}
+
+	memcpy(record->key, &source->key, sizeof(int));
+	memcpy(record->value, &value, sizeof(int));
+	source->key += 2;
+	source->remaining--;
+
+	return err_ok;
+}
+
+/**
+@brief		Loads the keys @c 0, @c 2 and on up to @p count records, then
+			asserts that every key is found, that no odd key is, and that
+			the slots are walked in key order.
+*/
+static void
+check_sorted_array(
+	planck_unit_test_t	*tc,
+	int					count
+) {
+	ion_sorted_array_t		sorted_array;
+	ion_sa_test_source_t	source = { count, 0 };
+	ion_status_t			status;
+	long					slot;
+	int						i;
+	int						value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_sorted_array(&sorted_array, 0));
+
+	status = sa_load(&sorted_array, next_source_record, &source);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count, status.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, sorted_array.sealed);
+
+	for (i = 0, slot = sa_first(&sorted_array); 0 != slot; i++, slot = sa_next(&sorted_array, slot)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * i, NEUTRALIZE(ION_SA_KEY(&sorted_array, slot), int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * i + 1, NEUTRALIZE(ION_SA_VALUE(&sorted_array, slot), int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count, i);
+
+	for (i = -1; i <= 2 * count; i++) {
+		status	= sa_query(&sorted_array, IONIZE(i, int), &value);
+		slot	= sa_lower_bound(&sorted_array, IONIZE(i, int));
+
+		if ((i >= 0) && (0 == i % 2) && (i < 2 * count)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i + 1, value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, NEUTRALIZE(ION_SA_KEY(&sorted_array, slot), int));
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+
+			/* the first key past an absent one is the next even key, if any */
+			if (i < 2 * count - 1) {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i < 0) ? 0 : i + 1, NEUTRALIZE(ION_SA_KEY(&sorted_array, slot), int));
+			}
+			else {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, slot);
+			}
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_destroy(&sorted_array));
+}
+
+/**
+@brief		Tests that appends must come in ascending key order, and stop
+			once the array is sealed.
+*/
+void
+test_sorted_array_append_order(
+	planck_unit_test_t *tc
+) {
+	ion_sorted_array_t sorted_array;
+
+	/* room for two records, so that the third grows the array */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_sorted_array(&sorted_array, 2));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_append(&sorted_array, IONIZE(3, int), IONIZE(30, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_append(&sorted_array, IONIZE(5, int), IONIZE(50, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, sa_append(&sorted_array, IONIZE(5, int), IONIZE(51, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, sa_append(&sorted_array, IONIZE(4, int), IONIZE(40, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_append(&sorted_array, IONIZE(9, int), IONIZE(90, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, sorted_array.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, sorted_array.capacity);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_seal(&sorted_array));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_seal(&sorted_array));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, sa_append(&sorted_array, IONIZE(10, int), IONIZE(100, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, sorted_array.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_destroy(&sorted_array));
+}
+
+/**
+@brief		Tests that a sealed array holds its keys in Eytzinger order.
+*/
+void
+test_sorted_array_layout(
+	planck_unit_test_t *tc
+) {
+	ion_sorted_array_t	sorted_array;
+	int					expected[] = { 0, 7, 3, 11, 1, 5, 9, 13, 0, 2, 4, 6, 8, 10, 12 };
+	int					i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_sorted_array(&sorted_array, 0));
+
+	for (i = 0; i < 14; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_append(&sorted_array, IONIZE(i, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_seal(&sorted_array));
+
+	/* a complete tree of 15 slots missing its last leaf; slot 0 is unused */
+	for (i = 1; i <= 14; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected[i], NEUTRALIZE(ION_SA_KEY(&sorted_array, i), int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, sa_first(&sorted_array));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_destroy(&sorted_array));
+}
+
+/**
+@brief		Tests searches of arrays of every shape of tree, from empty to
+			several levels deep.
+*/
+void
+test_sorted_array_search(
+	planck_unit_test_t *tc
+) {
+	int counts[]	= { 0, 1, 2, 3, 7, 8, 100 };
+	int i;
+
+	for (i = 0; i < (int) (sizeof(counts) / sizeof(counts[0])); i++) {
+		check_sorted_array(tc, counts[i]);
+	}
+}
+
+/**
+@brief		Tests that a load stops at the first record out of order,
+			leaving the array unsealed.
+*/
+void
+test_sorted_array_load_out_of_order(
+	planck_unit_test_t *tc
+) {
+	ion_sorted_array_t		sorted_array;
+	ion_sa_test_source_t	source = { 3, 4 };
+	ion_status_t			status;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_sorted_array(&sorted_array, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_append(&sorted_array, IONIZE(6, int), IONIZE(7, int)).error);
+
+	status = sa_load(&sorted_array, next_source_record, &source);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, status.count);
+	PLANCK_UNIT_ASSERT_FALSE(tc, sorted_array.sealed);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, sa_destroy(&sorted_array));
+}
+
+/**
+@brief		Tests the cursors, references and unsupported changes of a
+			sorted array dictionary.
+*/
+void
+test_sorted_array_dictionary(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_value_t					reference;
+	int							key;
+	int							value;
+	int							i;
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	sadict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+
+	for (i = 0; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(3 * i, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, dictionary_insert(&dictionary, IONIZE(1, int), IONIZE(0, int)).error);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(10, int), IONIZE(40, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 4; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * i, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 14, i);
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(27, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 27, key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(28, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 0; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * i, key);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, i);
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_ref(&dictionary, IONIZE(42, int), &reference).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 14, NEUTRALIZE(reference, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get_ref(&dictionary, IONIZE(43, int), &reference).error);
+
+	/* the first read sealed the dictionary */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_insert(&dictionary, IONIZE(200, int), IONIZE(0, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_not_implemented, dictionary_update(&dictionary, IONIZE(3, int), IONIZE(0, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_not_implemented, dictionary_delete(&dictionary, IONIZE(3, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(3, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+planck_unit_suite_t *
+sorted_array_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_sorted_array_append_order);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_sorted_array_layout);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_sorted_array_search);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_sorted_array_load_out_of_order);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_sorted_array_dictionary);
+
+	return suite;
+}
+
+void
+runalltests_sorted_array(
+) {
+	planck_unit_suite_t *suite = sorted_array_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
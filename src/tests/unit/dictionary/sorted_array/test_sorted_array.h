@@ -0,0 +1,26 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the static sorted array.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_SORTED_ARRAY_H_)
+#define TEST_SORTED_ARRAY_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/sorted_array/sorted_array_dictionary_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_sorted_array(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_SORTED_ARRAY_H_ */
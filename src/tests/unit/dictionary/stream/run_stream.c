@@ -0,0 +1,8 @@
+#include "test_stream.h"
+
+int
+main(
+) {
+	runalltests_stream();
+	return 0;
+}
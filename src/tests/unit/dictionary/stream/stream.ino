@@ -0,0 +1,16 @@
+#include <SPI.h>
+#include <SD.h>
+#include "test_stream.h"
+
+void
+setup(
+) {
+	SPI.begin();
+	SD.begin(SD_CS_PIN);
+	Serial.begin(BAUD_RATE);
+	runalltests_stream();
+}
+
+void
+loop(
+) {}
@@ -0,0 +1,406 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the export of dictionaries to streams and their import,
+			between B+ trees, skip lists and open address hash tables.
+*/
+/******************************************************************************/
+
+#include <string.h>
+#include "test_stream.h"
+
+/**
+@brief		The number of records put in a dictionary to export.
+*/
+#define STREAM_TEST_RECORDS 5000
+
+/**
+@brief		The value of a key, repeating so blocks compress.
+*/
+#define STREAM_TEST_VALUE(key) ((key) % 16)
+
+/**
+@brief		The files streams are written to.
+*/
+#define STREAM_TEST_FILE	"stream.dat"
+#define STREAM_TEST_COPY	"stream2.dat"
+
+/**
+@brief		Makes a dictionary of int keys and values with a handler.
+*/
+static void
+stream_test_create(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_value_size_t			value_size
+) {
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(handler, dictionary, id, key_type_numeric_signed, sizeof(int), value_size, STREAM_TEST_RECORDS * 2));
+}
+
+/**
+@brief		Inserts the keys below @p count, out of order, each with its
+			@ref STREAM_TEST_VALUE.
+*/
+static void
+stream_test_fill(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					count
+) {
+	int i;
+	int key;
+	int value;
+
+	for (i = 0; i < count; i++) {
+		key		= (i * 37) % count;
+		value	= STREAM_TEST_VALUE(key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, &key, &value).error);
+	}
+}
+
+/**
+@brief		Checks a dictionary holds each key below @p count with its
+			value, and nothing else, in key order if @p ordered.
+*/
+static void
+stream_test_check(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					count,
+	ion_boolean_t		ordered
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					key;
+	int					value;
+	int					read	= 0;
+
+	record.key		= &key;
+	record.value	= &value;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_build_predicate(&predicate, predicate_all_records));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(dictionary, &predicate, &cursor));
+
+	while (cs_cursor_active == dictionary_next(cursor, &record)) {
+		if (ordered) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, read, key);
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, (0 <= key) && (key < count));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_VALUE(key), value);
+		read++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count, read);
+}
+
+/**
+@brief		Reads the option flags from the header of a stream.
+*/
+static int
+stream_test_flags(
+	FILE *stream
+) {
+	unsigned char header[6];
+
+	rewind(stream);
+
+	if (1 != fread(header, sizeof(header), 1, stream)) {
+		return -1;
+	}
+
+	rewind(stream);
+	return header[5];
+}
+
+/**
+@brief		Copies a stream, cut to @p length bytes, with the byte at
+			@p flip inverted if it is not negative.
+@return		The copy, from its start.
+*/
+static FILE *
+stream_test_copy(
+	FILE	*stream,
+	long	length,
+	long	flip
+) {
+	FILE	*copy = fopen(STREAM_TEST_COPY, "w+b");
+	long	at;
+	int		byte;
+
+	rewind(stream);
+
+	for (at = 0; (at < length) && (EOF != (byte = fgetc(stream))); at++) {
+		fputc((at == flip) ? (byte ^ 0xFF) : byte, copy);
+	}
+
+	rewind(copy);
+	return copy;
+}
+
+/**
+@brief		Imports a stream into a new skip list, expecting an error.
+*/
+static void
+stream_test_import_fails(
+	planck_unit_test_t	*tc,
+	FILE				*stream,
+	ion_value_size_t	value_size,
+	ion_err_t			expected
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+
+	sldict_init(&handler);
+	stream_test_create(tc, &handler, &dictionary, 92, value_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, dictionary_import(&dictionary, stream).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that a B+ tree exports sorted, with its blocks compressed,
+			and imports into a skip list as it was.
+*/
+void
+test_stream_round_trip(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	tree_handler;
+	ion_dictionary_handler_t	list_handler;
+	ion_dictionary_t			tree;
+	ion_dictionary_t			list;
+	FILE						*stream = fopen(STREAM_TEST_FILE, "w+b");
+	long						packed;
+	long						raw;
+	ion_status_t				status;
+
+	bpptree_init(&tree_handler);
+	sldict_init(&list_handler);
+	stream_test_create(tc, &tree_handler, &tree, 90, sizeof(int));
+	stream_test_create(tc, &list_handler, &list, 91, sizeof(int));
+	stream_test_fill(tc, &tree, STREAM_TEST_RECORDS);
+
+	status = dictionary_export(&tree, stream, 0);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	raw = ftell(stream);
+
+	/* ordered engines are written sorted without being asked */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_stream_sorted, stream_test_flags(stream));
+	fclose(stream);
+
+	stream = fopen(STREAM_TEST_FILE, "w+b");
+	status = dictionary_export(&tree, stream, ion_stream_compressed);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	packed = ftell(stream);
+	PLANCK_UNIT_ASSERT_TRUE(tc, packed < raw);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_stream_sorted | ion_stream_compressed, stream_test_flags(stream));
+
+	status = dictionary_import(&list, stream);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	stream_test_check(tc, &list, STREAM_TEST_RECORDS, boolean_true);
+
+	fclose(stream);
+	ion_fremove(STREAM_TEST_FILE);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&tree));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&list));
+}
+
+/**
+@brief		Tests that a hash table exports as its cursor gives its records
+			unless asked to sort them, and that both import.
+*/
+void
+test_stream_unordered(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	hash_handler;
+	ion_dictionary_handler_t	tree_handler;
+	ion_dictionary_t			hash;
+	ion_dictionary_t			copy;
+	ion_dictionary_t			tree;
+	FILE						*stream = fopen(STREAM_TEST_FILE, "w+b");
+	ion_status_t				status;
+
+	oadict_init(&hash_handler);
+	bpptree_init(&tree_handler);
+	stream_test_create(tc, &hash_handler, &hash, 93, sizeof(int));
+	stream_test_create(tc, &hash_handler, &copy, 94, sizeof(int));
+	stream_test_create(tc, &tree_handler, &tree, 95, sizeof(int));
+	stream_test_fill(tc, &hash, STREAM_TEST_RECORDS);
+
+	status = dictionary_export(&hash, stream, ion_stream_compressed);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_stream_compressed, stream_test_flags(stream));
+
+	status = dictionary_import(&copy, stream);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	stream_test_check(tc, &copy, STREAM_TEST_RECORDS, boolean_false);
+	fclose(stream);
+
+	stream = fopen(STREAM_TEST_FILE, "w+b");
+	status = dictionary_export(&hash, stream, ion_stream_sorted);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_stream_sorted, stream_test_flags(stream));
+
+	status = dictionary_import(&tree, stream);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	stream_test_check(tc, &tree, STREAM_TEST_RECORDS, boolean_true);
+
+	fclose(stream);
+	ion_fremove(STREAM_TEST_FILE);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&hash));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&copy));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&tree));
+}
+
+/**
+@brief		Tests that streams cut short, damaged, too new or of other
+			records are refused.
+*/
+void
+test_stream_damaged(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			tree;
+	FILE						*stream = fopen(STREAM_TEST_FILE, "w+b");
+	FILE						*copy;
+	long						length;
+
+	bpptree_init(&handler);
+	stream_test_create(tc, &handler, &tree, 96, sizeof(int));
+	stream_test_fill(tc, &tree, STREAM_TEST_RECORDS);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_export(&tree, stream, ion_stream_compressed).error);
+	length = ftell(stream);
+
+	copy = stream_test_copy(stream, length, -1);
+	stream_test_import_fails(tc, copy, sizeof(int), err_ok);
+	fclose(copy);
+
+	/* the end block is cut */
+	copy = stream_test_copy(stream, length - 4, -1);
+	stream_test_import_fails(tc, copy, sizeof(int), err_file_incomplete_read);
+	fclose(copy);
+
+	/* a byte of the records of the first block */
+	copy = stream_test_copy(stream, length, 40);
+	stream_test_import_fails(tc, copy, sizeof(int), err_file_read_error);
+	fclose(copy);
+
+	/* the version */
+	copy = stream_test_copy(stream, length, 4);
+	stream_test_import_fails(tc, copy, sizeof(int), err_file_read_error);
+	fclose(copy);
+
+	copy = stream_test_copy(stream, length, -1);
+	stream_test_import_fails(tc, copy, sizeof(long long), err_illegal_state);
+	fclose(copy);
+
+	fclose(stream);
+	ion_fremove(STREAM_TEST_FILE);
+	ion_fremove(STREAM_TEST_COPY);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&tree));
+}
+
+/**
+@brief		Gives the keys below @ref STREAM_TEST_RECORDS in order, each
+			with its value.
+*/
+static ion_err_t
+stream_test_next(
+	void			*context,
+	ion_record_t	*record
+) {
+	int *next = context;
+
+	if (STREAM_TEST_RECORDS == *next) {
+		return err_item_not_found;
+	}
+
+	*(int *) record->key	= *next;
+	*(int *) record->value	= STREAM_TEST_VALUE(*next);
+	(*next)++;
+	return err_ok;
+}
+
+/**
+@brief		Tests bulk loads, into an empty B+ tree and, by inserts, into
+			a tree that has records and a hash table, which has no loader.
+*/
+void
+test_stream_bulk_load(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	tree_handler;
+	ion_dictionary_handler_t	hash_handler;
+	ion_dictionary_t			tree;
+	ion_dictionary_t			hash;
+	ion_status_t				status;
+	int							next;
+	int							key		= STREAM_TEST_RECORDS;
+	int							value	= STREAM_TEST_VALUE(key);
+
+	bpptree_init(&tree_handler);
+	oadict_init(&hash_handler);
+	stream_test_create(tc, &tree_handler, &tree, 97, sizeof(int));
+	stream_test_create(tc, &hash_handler, &hash, 98, sizeof(int));
+
+	next	= 0;
+	status	= dictionary_bulk_load(&tree, stream_test_next, &next);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	stream_test_check(tc, &tree, STREAM_TEST_RECORDS, boolean_true);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&tree));
+
+	/* a tree that has records is loaded by inserts */
+	stream_test_create(tc, &tree_handler, &tree, 97, sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&tree, &key, &value).error);
+
+	next	= 0;
+	status	= dictionary_bulk_load(&tree, stream_test_next, &next);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dictionary_delete(&tree, &key).count);
+	stream_test_check(tc, &tree, STREAM_TEST_RECORDS, boolean_true);
+
+	next	= 0;
+	status	= dictionary_bulk_load(&hash, stream_test_next, &next);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, STREAM_TEST_RECORDS, status.count);
+	stream_test_check(tc, &hash, STREAM_TEST_RECORDS, boolean_false);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&tree));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&hash));
+}
+
+planck_unit_suite_t *
+stream_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_stream_round_trip);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_stream_unordered);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_stream_damaged);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_stream_bulk_load);
+
+	return suite;
+}
+
+void
+runalltests_stream(
+) {
+	planck_unit_suite_t *suite = stream_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
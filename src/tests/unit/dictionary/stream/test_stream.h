@@ -0,0 +1,30 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the export and import of dictionaries as streams.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_STREAM_H_)
+#define TEST_STREAM_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/stream/dictionary_stream.h"
+#include "../../../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../../../dictionary/skip_list/skip_list_handler.h"
+#include "../../../../dictionary/open_address_hash/open_address_hash_dictionary_handler.h"
+#include "../../../../file/ion_file.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_stream(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_STREAM_H_ */
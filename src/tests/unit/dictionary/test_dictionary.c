@@ -148,6 +148,56 @@ test_dictionary_compare_numerics(
 	}
 }
 
+/**
+@brief	Tests that the comparators picked for each numeric key width order
+		keys as the byte by byte ones do, the sign bit included.
+*/
+void
+test_dictionary_compare_widths(
+	planck_unit_test_t *tc
+) {
+	static const ion_byte_t		edges[]		= { 0x00, 0x01, 0x7F, 0x80, 0xFF };
+	static const ion_key_size_t sizes[]		= { 1, 2, 3, 4, 8 };
+	ion_key_type_t				types[]		= { key_type_numeric_signed, key_type_numeric_unsigned };
+	ion_dictionary_compare_t	generic[]	= { dictionary_compare_signed_value, dictionary_compare_unsigned_value };
+	ion_dictionary_compare_t	compare;
+	ion_byte_t					first[8];
+	ion_byte_t					second[8];
+	uint32_t					seed		= 1;
+	int							expected;
+	int							actual;
+	int							t;
+	int							s;
+	int							i;
+	int							b;
+
+	for (t = 0; t < 2; t++) {
+		for (s = 0; s < (int) (sizeof(sizes) / sizeof(sizes[0])); s++) {
+			compare = dictionary_switch_compare(types[t], sizes[s]);
+			PLANCK_UNIT_ASSERT_TRUE(tc, (0 == t) ? dictionary_is_signed_compare(compare) : dictionary_is_unsigned_compare(compare));
+
+			for (i = 0; i < 2000; i++) {
+				/* mostly the bytes where the order of signed and unsigned keys turns */
+				for (b = 0; b < sizes[s]; b++) {
+					seed		= seed * 1103515245U + 12345U;
+					first[b]	= (seed >> 28) < 10 ? edges[(seed >> 8) % 5] : (ion_byte_t) (seed >> 8);
+					seed		= seed * 1103515245U + 12345U;
+					second[b]	= (seed >> 28) < 10 ? edges[(seed >> 8) % 5] : (ion_byte_t) (seed >> 8);
+				}
+
+				/* and equal keys often enough */
+				if (0 == i % 7) {
+					memcpy(second, first, sizes[s]);
+				}
+
+				expected	= generic[t](first, second, sizes[s]);
+				actual		= compare(first, second, sizes[s]);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (expected > 0) - (expected < 0), (actual > 0) - (actual < 0));
+			}
+		}
+	}
+}
+
 void
 test_dictionary_master_table(
 	planck_unit_test_t *tc
@@ -255,13 +305,1035 @@ test_dictionary_master_table(
 	/**************/
 }
 
+/**
+@brief		Tests that the master table answers lookups by ID and by use
+			from memory, kept current as dictionaries come and go, and
+			loaded again when the table is opened.
+*/
+void
+test_dictionary_master_table_directory(
+	planck_unit_test_t *tc
+) {
+#if ION_MASTER_TABLE_DIRECTORY
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config;
+	ion_dict_use_t					uses[4] = { 5, 7, 5, 5 };
+	FILE							*table;
+	char							name[ION_MAX_FILENAME_LENGTH];
+	int								pass;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	ffdict_init(&handler);
+
+	for (i = 0; i < 4; i++) {
+		config = (ion_dictionary_config_info_t) {
+			.id = 0, .use_type = uses[i], .type = key_type_numeric_signed, .key_size = sizeof(int), .value_size = 4 + i, .dictionary_size = 10
+		};
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_from_config(&handler, &dictionary, &config));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary));
+	}
+
+	/* the one in the middle of its use goes */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &dictionary, 3));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary));
+
+	/* as created, then as loaded again */
+	for (pass = 0; pass < 2; pass++) {
+		/* lookups do not touch the file */
+		table					= ion_master_table_file;
+		ion_master_table_file	= NULL;
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(2, &config));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, config.id);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 7, config.use_type);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, config.value_size);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_lookup_in_master_table(3, &config));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_lookup_in_master_table(100, &config));
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_by_use_master_table(&config, 5, ION_MASTER_TABLE_FIND_FIRST));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, config.id);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_by_use_master_table(&config, 5, ION_MASTER_TABLE_FIND_LAST));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, config.id);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_by_use_master_table(&config, 7, ION_MASTER_TABLE_FIND_LAST));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, config.id);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_find_by_use_master_table(&config, 6, ION_MASTER_TABLE_FIND_FIRST));
+
+		ion_master_table_file = table;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	}
+
+	/* the last of a use going leaves the one before it last */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &dictionary, 4));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_find_by_use_master_table(&config, 5, ION_MASTER_TABLE_FIND_LAST));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, config.id);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+
+	for (i = 1; i <= 4; i++) {
+		dictionary_get_filename(i, "ffs", name);
+		fremove(name);
+		dictionary_get_filename(i, "ffb", name);
+		fremove(name);
+	}
+
+#else
+	UNUSED(tc);
+#endif
+}
+
+/**
+@brief		Tests that dictionaries opened by ID are shared while open, kept
+			open once closed, and closed for good least recently used
+			first.
+*/
+void
+test_dictionary_master_table_open_cache(
+	planck_unit_test_t *tc
+) {
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				first;
+	ion_dictionary_t				second;
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_parent_t			*instance;
+	char							name[ION_MAX_FILENAME_LENGTH];
+	int								value;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	ffdict_init(&handler);
+
+	for (i = 0; i < ION_MASTER_TABLE_OPEN_CACHE + 2; i++) {
+		config = (ion_dictionary_config_info_t) {
+			.id = 0, .use_type = 0, .type = key_type_numeric_signed, .key_size = sizeof(int), .value_size = sizeof(int), .dictionary_size = 10
+		};
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_from_config(&handler, &first, &config));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&first));
+	}
+
+	/* both openers have the one dictionary */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &first, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &second, 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, first.instance == second.instance);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&first, IONIZE(1, int), IONIZE(10, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&second, IONIZE(1, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_delete_dictionary(&first));
+
+	instance = first.instance;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&first));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&second));
+
+	/* the data file goes, so only the dictionary kept open still has the record */
+	dictionary_get_filename(1, "ffs", name);
+	fremove(name);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &first, 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, instance == first.instance);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&first, IONIZE(1, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&first));
+
+	/* closing as many others as are kept puts it out, being the least recently used */
+	for (i = 2; i < ION_MASTER_TABLE_OPEN_CACHE + 2; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &first, i));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&first));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &first, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&first, IONIZE(1, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&first));
+
+	/* one taken out of the table is not given out again */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &first, 2));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&first));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, ion_open_dictionary(&handler, &first, 2));
+
+	/* the one kept open alone may be deleted */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_open_dictionary(&handler, &first, 3));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&first));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+
+	for (i = 1; i <= ION_MASTER_TABLE_OPEN_CACHE + 2; i++) {
+		dictionary_get_filename(i, "ffs", name);
+		fremove(name);
+		dictionary_get_filename(i, "ffb", name);
+		fremove(name);
+	}
+
+#else
+	UNUSED(tc);
+#endif
+}
+
+/**
+@brief		Creates a dictionary of integers through the master table,
+			checking the ID it is given.
+*/
+void
+test_dictionary_master_table_create_expect(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id
+) {
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary(handler, dictionary, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, id, dictionary->instance->id);
+}
+
+/**
+@brief		Tests that the IDs of dictionaries deleted with their files are
+			given out again, across opening the table again and in
+			batches.
+*/
+void
+test_dictionary_master_table_reuse(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary[4];
+	ion_dictionary_config_info_t	config;
+	char							name[ION_MAX_FILENAME_LENGTH];
+	int								value;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	ffdict_init(&handler);
+
+	for (i = 0; i < 4; i++) {
+		test_dictionary_master_table_create_expect(tc, &handler, &dictionary[i], i + 1);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary[1], IONIZE(1, int), IONIZE(10, int)).error);
+
+	/* one kept on file keeps its ID, one deleted frees its ID */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary[0]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_delete_dictionary(&dictionary[1]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_lookup_in_master_table(2, &config));
+
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[1], 2);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary[1], IONIZE(1, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(2, &config));
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[0], 5);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[0]));
+
+	/* the freed are kept in the table, the last freed given out first */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_delete_dictionary(&dictionary[3]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_delete_dictionary(&dictionary[1]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[2]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[1], 2);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_begin_batch());
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[3], 4);
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[0], 6);
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[2], 7);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_end_batch());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, ion_master_table_next_id);
+
+	for (i = 0; i < 4; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[i]));
+	}
+
+	/* a batch cut short still leaves the IDs it gave out taken */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_begin_batch());
+	test_dictionary_master_table_create_expect(tc, &handler, &dictionary[0], 8);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[0]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, fclose(ion_master_table_file));
+	ion_master_table_file = NULL;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, ion_master_table_end_batch());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, ion_master_table_next_id);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+
+	for (i = 1; i <= 8; i++) {
+		dictionary_get_filename(i, "ffs", name);
+		fremove(name);
+		dictionary_get_filename(i, "ffb", name);
+		fremove(name);
+	}
+}
+
+/**
+@brief		Tests that master tables opened side by side each keep their own
+			records and IDs, and share dictionaries only among their own
+			openers.
+*/
+void
+test_dictionary_master_table_instances(
+	planck_unit_test_t *tc
+) {
+	ion_master_table_t				tables[2];
+	ion_master_table_t				spare;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary[2];
+	ion_dictionary_t				again;
+	ion_dictionary_config_info_t	config;
+	char							*names[2] = { "mt_a.tbl", "mt_b.tbl" };
+	int								value;
+	int								t;
+
+	ffdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_open_error, ion_mt_open(&spare, "a_name_too_long.tbl", 0));
+
+	for (t = 0; t < 2; t++) {
+		fremove(names[t]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_open(&tables[t], names[t], t * 100));
+	}
+
+	/* each gives out IDs above its own base, so their files are apart */
+	for (t = 0; t < 2; t++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_create_dictionary(&tables[t], &handler, &dictionary[t], key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, t * 100 + 1, dictionary[t].instance->id);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary[t], IONIZE(1, int), IONIZE(t + 10, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[t]));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_mt_lookup(&tables[0], 101, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_mt_lookup(&tables[1], 1, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_lookup(&tables[1], 101, &config));
+
+	for (t = 0; t < 2; t++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_close(&tables[t]));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_open(&tables[t], names[t], t * 100));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, tables[t].next_row);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_open_dictionary(&tables[t], &handler, &dictionary[t], t * 100 + 1));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary[t], IONIZE(1, int), &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, t + 10, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, ion_mt_open_dictionary(&tables[1], &handler, &again, 1));
+#if ION_MASTER_TABLE_OPEN_CACHE > 0
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_open_dictionary(&tables[0], &handler, &again, 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, again.instance == dictionary[0].instance);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&again));
+#endif
+
+	/* a freed ID is given out again by its own table only */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_delete_dictionary(&tables[1], &dictionary[1]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_create_dictionary(&tables[1], &handler, &dictionary[1], key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 101, dictionary[1].instance->id);
+
+	for (t = 0; t < 2; t++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_delete_dictionary(&tables[t], &dictionary[t]));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_close(&tables[t]));
+		fremove(names[t]);
+	}
+}
+
+/**
+@brief		Tests that a table given many IDs keeps them all across opening
+			it again, its file growing past what is first mapped of it,
+			and that each record is read back from where it was written.
+*/
+void
+test_dictionary_master_table_many(
+	planck_unit_test_t *tc
+) {
+	ion_master_table_t				table;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config;
+	ion_dictionary_id_t				id;
+	int								pass;
+
+	sldict_init(&handler);
+	fremove("mt_many.tbl");
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_open(&table, "mt_many.tbl", 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_begin_batch(&table));
+
+	for (id = 1; id <= 300; id++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_create_dictionary(&table, &handler, &dictionary, key_type_numeric_signed, sizeof(int), id, 7));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, id, dictionary.instance->id);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_end_batch(&table));
+
+	/* as written, then as opened again */
+	for (pass = 0; pass < 2; pass++) {
+		for (id = 1; id <= 300; id++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_lookup(&table, id, &config));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, id, config.id);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, id, config.value_size);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ion_mt_lookup(&table, 301, &config));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_close(&table));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_open(&table, "mt_many.tbl", 0));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 301, table.next_row);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_mt_close(&table));
+	fremove("mt_many.tbl");
+}
+
+/**
+@brief		Tests that options set in a config are read back, replaced when
+			set again, refused once there is no room for them, and kept
+			by the master table across opening it again.
+*/
+void
+test_dictionary_options(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_config_info_t	config = { 0 };
+	ion_dictionary_config_info_t	found;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_id_t				id;
+	uint32_t						value;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get_option(&config, dictionary_option_buffer_count, &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_set_option(&config, dictionary_option_end, 1));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_buffer_count, 300));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_compression, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_buffer_count, 0x12345678UL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&config, dictionary_option_buffer_count, &value));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0x12345678UL == value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&config, dictionary_option_compression, &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get_option(&config, dictionary_option_cache_size, &value));
+
+	/* one option too many finds no room, and leaves the rest */
+	for (i = 0; err_ok == dictionary_set_option(&config, (ion_dictionary_option_t) (100 + i), 0xFFFFFFFFUL); i++) {}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_max_capacity, dictionary_set_option(&config, (ion_dictionary_option_t) (100 + i), 0xFFFFFFFFUL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&config, dictionary_option_compression, &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, value);
+
+	/* options of a version not known are not read, nor written over */
+	config.options[0] = ION_DICTIONARY_OPTIONS_VERSION + 1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get_option(&config, dictionary_option_compression, &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_set_option(&config, dictionary_option_compression, 0));
+
+	memset(&config, 0, sizeof(config));
+	config.type				= key_type_numeric_signed;
+	config.key_size			= sizeof(int);
+	config.value_size		= sizeof(int);
+	config.dictionary_size	= 7;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_option(&config, dictionary_option_cache_size, 64));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_create_dictionary_from_config(&handler, &dictionary, &config));
+	id = dictionary.instance->id;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(id, &found));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_option(&found, dictionary_option_cache_size, &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 64, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get_option(&found, dictionary_option_buffer_count, &value));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+}
+
+#if ION_DICTIONARY_STATS
+
+/**
+@brief		Tests that a dictionary counts the operations made on it once
+			it is asked to, and each kind apart.
+*/
+void
+test_dictionary_stats(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_stats_t		stats;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	int							keys[4];
+	int							values[4];
+	int							key;
+	int							value;
+	unsigned long				latencies;
+	int							i;
+
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_get_stats(&dictionary, &stats));
+
+	/* not counted yet */
+	dictionary_insert(&dictionary, IONIZE(100, int), IONIZE(100, int));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_stats_enable(&dictionary));
+
+	for (i = 0; i < 10; i++) {
+		dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i * 2, int));
+	}
+
+	dictionary_get(&dictionary, IONIZE(3, int), &value);
+	dictionary_get(&dictionary, IONIZE(50, int), &value);
+	dictionary_update(&dictionary, IONIZE(4, int), IONIZE(-4, int));
+	dictionary_delete(&dictionary, IONIZE(5, int));
+
+	/* a batch counts as one operation */
+	for (i = 0; i < 4; i++) {
+		keys[i] = i;
+	}
+
+	dictionary_get_many(&dictionary, keys, values, NULL, 4);
+
+	record.key		= &key;
+	record.value	= &value;
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(0, int), IONIZE(2, int));
+	dictionary_find(&dictionary, &predicate, &cursor);
+
+	while (cs_cursor_active == dictionary_next(cursor, &record)) {}
+
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_stats(&dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, stats.ops[dictionary_op_insert].calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10 * 2 * sizeof(int), stats.ops[dictionary_op_insert].bytes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, stats.ops[dictionary_op_get].calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.ops[dictionary_op_get].errors);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5 * 2 * sizeof(int), stats.ops[dictionary_op_get].bytes);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.ops[dictionary_op_update].calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.ops[dictionary_op_delete].calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.ops[dictionary_op_find].calls);
+	/* three records, then the read that ends the cursor */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, stats.ops[dictionary_op_next].calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * 2 * sizeof(int), stats.ops[dictionary_op_next].bytes);
+
+	/* every operation lands in one bucket of its histogram */
+	latencies = 0;
+
+	for (i = 0; i < ION_DICTIONARY_STATS_BUCKETS; i++) {
+		latencies += stats.ops[dictionary_op_insert].latency[i];
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, latencies);
+
+	/* enabling again starts over */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_stats_enable(&dictionary));
+	dictionary_get(&dictionary, IONIZE(7, int), &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_stats(&dictionary, &stats));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stats.ops[dictionary_op_insert].calls);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, stats.ops[dictionary_op_get].calls);
+
+	dictionary_stats_disable(&dictionary);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_get_stats(&dictionary, &stats));
+
+	/* the counters go with the dictionary */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_stats_enable(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == dictionary.stats);
+}
+
+#endif
+
+#if ION_ALLOC_TRACKING
+
+/**
+@brief		Tests that what a dictionary allocates is charged to it by kind,
+			apart from another dictionary, and freed with it.
+*/
+void
+test_dictionary_memory(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_t			other;
+	ion_alloc_usage_t			usage;
+	ion_alloc_usage_t			other_usage;
+	ion_alloc_account_t			account;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	int							i;
+
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 91, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &other, 92, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_alloc_unattributed != dictionary.alloc_account);
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary.alloc_account != other.alloc_account);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_memory(&other, &other_usage));
+
+	for (i = 0; i < 100; i++) {
+		dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i, int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_memory(&dictionary, &usage));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < usage.kinds[ion_alloc_node].current);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < usage.kinds[ion_alloc_other].current);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, usage.kinds[ion_alloc_cursor].current);
+	PLANCK_UNIT_ASSERT_TRUE(tc, usage.total.current == usage.kinds[ion_alloc_node].current + usage.kinds[ion_alloc_other].current + usage.kinds[ion_alloc_buffer].current);
+
+	/* the inserts were not charged to the other dictionary */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_memory(&other, &usage));
+	PLANCK_UNIT_ASSERT_TRUE(tc, other_usage.total.current == usage.total.current);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_memory(&dictionary, &usage));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < usage.kinds[ion_alloc_cursor].current);
+
+	/* a cursor destroyed outside any operation is still counted off */
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_memory(&dictionary, &usage));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, usage.kinds[ion_alloc_cursor].current);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < usage.kinds[ion_alloc_cursor].peak);
+
+	/* a reset peak starts from what is held now */
+	ion_alloc_reset_peak(dictionary.alloc_account);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_memory(&dictionary, &usage));
+	PLANCK_UNIT_ASSERT_TRUE(tc, usage.total.current == usage.total.peak);
+
+	account = dictionary.alloc_account;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_get_memory(&dictionary, &usage));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_alloc_get_usage(account, &usage));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, usage.total.current);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&other));
+}
+
+/**
+@brief		Inserts into a skiplist dictionary taking its memory from an
+			allocator, and checks that a cursor works over what it holds.
+@param		handler
+				The handler it is created with, which must outlive it.
+*/
+static void
+test_dictionary_allocator_fill(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_allocator_t				*allocator
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					key;
+	int					value;
+	int					i;
+
+	sldict_init(handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_allocator(id, allocator));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(handler, dictionary, id, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+
+	for (i = 0; i < 200; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, IONIZE(i, int), IONIZE(i * 3, int)).error);
+	}
+
+	for (i = 0; i < 200; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(dictionary, IONIZE(i, int)).error);
+	}
+
+	record.key		= &key;
+	record.value	= &value;
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(dictionary, &predicate, &cursor));
+
+	for (i = 1; cs_cursor_active == dictionary_next(cursor, &record); i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 201, i);
+	cursor->destroy(&cursor);
+}
+
+/**
+@brief		Tests that a dictionary bound to a pool takes its memory from
+			it, gives it all back when deleted, and fails cleanly when
+			the pool is full.
+*/
+void
+test_dictionary_allocator_pool(
+	planck_unit_test_t *tc
+) {
+	static long double			memory[32768 / sizeof(long double)];
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_allocator_t				allocator;
+	ion_pool_t					pool;
+	ion_status_t				status;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, ion_pool_init(&pool, memory, 1, &allocator));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_pool_init(&pool, memory, sizeof(memory), &allocator));
+	PLANCK_UNIT_ASSERT_TRUE(tc, sizeof(memory) == pool.available);
+
+	test_dictionary_allocator_fill(tc, &handler, &dictionary, 93, &allocator);
+	PLANCK_UNIT_ASSERT_TRUE(tc, pool.available < pool.size);
+
+	/* another allocator cannot replace one still holding its memory */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, dictionary_set_allocator(93, NULL));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, pool.size == pool.available);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != pool.free);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == pool.free->next);
+
+	/* a pool that runs out fails the insert, not the process */
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 93, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	status = ION_STATUS_OK(0);
+
+	for (i = 0; i < 10000 && err_ok == status.error; i++) {
+		status = dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i, int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_out_of_memory, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, pool.size == pool.available);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_allocator(93, NULL));
+}
+
+/**
+@brief		Tests that a dictionary bound to an arena takes its memory from
+			it and reuses what it frees.
+*/
+void
+test_dictionary_allocator_arena(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_allocator_t				allocator;
+	ion_arena_t					arena;
+	void						*chunks;
+
+	ion_arena_init(&arena, &allocator);
+	test_dictionary_allocator_fill(tc, &handler, &dictionary, 94, &allocator);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != arena.chunks);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	chunks = arena.chunks;
+
+	/* the second time around every block is one freed the first time */
+	test_dictionary_allocator_fill(tc, &handler, &dictionary, 94, &allocator);
+	PLANCK_UNIT_ASSERT_TRUE(tc, chunks == arena.chunks);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_allocator(94, NULL));
+	ion_arena_destroy(&arena);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == arena.chunks);
+}
+
+#endif
+
+/**
+@brief		The pushes made through @ref test_dictionary_counting_sync.
+*/
+static int durability_syncs;
+
+/**
+@brief		What @ref test_dictionary_counting_sync pushes with.
+*/
+static ion_err_t (*flat_file_sync_dictionary)(
+	ion_dictionary_t *
+);
+
+/**
+@brief		Counts a push of the writes of a dictionary, then makes it.
+*/
+static ion_err_t
+test_dictionary_counting_sync(
+	ion_dictionary_t *dictionary
+) {
+	durability_syncs++;
+	return flat_file_sync_dictionary(dictionary);
+}
+
+/**
+@brief		Tests that a dictionary pushes its writes as its durability
+			asks, and only then.
+*/
+void
+test_dictionary_durability(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config = {
+		77, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 1
+	};
+	int								keys[3]		= { 20, 21, 22 };
+	int								values[3]	= { 0, 1, 2 };
+	int								i;
+
+	/* nothing of a dictionary in memory can be pushed */
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 76, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_not_implemented, dictionary_set_durability(&dictionary, durability_sync, 0, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_durability(&dictionary, durability_none, 0, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_sync(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+
+	ffdict_init(&handler);
+	flat_file_sync_dictionary	= handler.sync_dictionary;
+	handler.sync_dictionary		= test_dictionary_counting_sync;
+	durability_syncs			= 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, config.id, config.type, config.key_size, config.value_size, config.dictionary_size));
+
+	if (durability_none == ION_DEFAULT_DURABILITY) {
+		for (i = 0; i < 3; i++) {
+			dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i, int));
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, durability_syncs);
+	}
+
+	/* every write, but not one that changes nothing */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_durability(&dictionary, durability_sync, 0, 0));
+	durability_syncs = 0;
+	dictionary_insert(&dictionary, IONIZE(10, int), IONIZE(10, int));
+	dictionary_update(&dictionary, IONIZE(10, int), IONIZE(11, int));
+	dictionary_delete(&dictionary, IONIZE(12, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, durability_syncs);
+	dictionary_delete(&dictionary, IONIZE(10, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, durability_syncs);
+
+	/* every third record, a batch counting each of its records */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_durability(&dictionary, durability_group, 3, 0));
+	durability_syncs = 0;
+	dictionary_insert(&dictionary, IONIZE(13, int), IONIZE(13, int));
+	dictionary_insert(&dictionary, IONIZE(14, int), IONIZE(14, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, durability_syncs);
+	dictionary_insert(&dictionary, IONIZE(15, int), IONIZE(15, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, durability_syncs);
+	dictionary_insert_many(&dictionary, keys, values, NULL, 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, durability_syncs);
+	dictionary_insert(&dictionary, IONIZE(16, int), IONIZE(16, int));
+
+	/* what the group held back is pushed before the policy changes */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_durability(&dictionary, durability_close, 0, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, durability_syncs);
+
+	/* and the rest only on close */
+	durability_syncs = 0;
+
+	for (i = 30; i < 35; i++) {
+		dictionary_insert(&dictionary, IONIZE(i, int), IONIZE(i, int));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, durability_syncs);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, durability_syncs);
+
+	/* the policy is not kept */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_DEFAULT_DURABILITY, dictionary.durability.level);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(34, int), &i).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 34, i);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that a checkpoint pushes every open dictionary that keeps
+			anything in storage once, leaving them open, and that their
+			records can then be read from their files.
+*/
+void
+test_dictionary_checkpoint(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_handler_t		memory_handler;
+	ion_dictionary_handler_t		plain_handler;
+	ion_dictionary_t				dictionary[2];
+	ion_dictionary_t				memory;
+	ion_dictionary_t				reader;
+	ion_dictionary_config_info_t	config;
+	char							name[ION_MAX_FILENAME_LENGTH];
+	int								value;
+	int								i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	ffdict_init(&handler);
+	flat_file_sync_dictionary	= handler.sync_dictionary;
+	handler.sync_dictionary		= test_dictionary_counting_sync;
+	sldict_init(&memory_handler);
+
+	for (i = 0; i < 2; i++) {
+		test_dictionary_master_table_create_expect(tc, &handler, &dictionary[i], i + 1);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_set_durability(&dictionary[i], durability_none, 0, 0));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary[i], IONIZE(i, int), IONIZE(10 + i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&memory_handler, &memory, 50, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+
+	/* one push of each in storage, the one in memory has none */
+	durability_syncs = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_checkpoint());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, durability_syncs);
+
+	/* what was pushed is read from the file by another opening */
+	ffdict_init(&plain_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(1, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&plain_handler, &reader, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&reader, IONIZE(0, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&reader));
+
+	/* the dictionaries are still open, and one closed is pushed no more */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary[1], IONIZE(2, int), IONIZE(12, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[0]));
+	durability_syncs = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_checkpoint());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, durability_syncs);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary[1], IONIZE(2, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 12, value);
+
+	/* syncs are put off by one at a time */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fsync_defer());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, ion_master_table_checkpoint());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fsync_deferred());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, ion_fsync_deferred());
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&memory));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_dictionary(&dictionary[1]));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, ion_master_table_checkpoint());
+	fremove(ION_MASTER_TABLE_FILENAME);
+
+	for (i = 1; i <= 2; i++) {
+		dictionary_get_filename(i, "ffs", name);
+		fremove(name);
+		dictionary_get_filename(i, "ffb", name);
+		fremove(name);
+	}
+}
+
+/**
+@brief		Tests what dictionaries tell of their size, one at a time and
+			summed over the master table.
+*/
+void
+test_dictionary_info(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	memory_handler;
+	ion_dictionary_handler_t	file_handler;
+	ion_dictionary_t			memory;
+	ion_dictionary_t			file;
+	ion_dictionary_t			outside;
+	ion_dictionary_info_t		info;
+	ion_dictionary_info_t		memory_info;
+	ion_dictionary_info_t		total;
+	int							min_key;
+	int							max_key;
+	int							count;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	sldict_init(&memory_handler);
+	ffdict_init(&file_handler);
+	test_dictionary_master_table_create_expect(tc, &memory_handler, &memory, 1);
+	test_dictionary_master_table_create_expect(tc, &file_handler, &file, 2);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&memory_handler, &outside, 50, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+
+	for (i = 0; i < 20; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&memory, IONIZE(19 - i, int), IONIZE(i, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&outside, IONIZE(i, int), IONIZE(i, int)).error);
+	}
+
+	for (i = 0; i < 5; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&file, IONIZE(i, int), IONIZE(i, int)).error);
+	}
+
+	/* a skiplist counts its records and finds its ends */
+	memory_info.min_key = &min_key;
+	memory_info.max_key = &max_key;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_info(&memory, &memory_info));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, memory_info.record_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memory_info.file_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < memory_info.memory_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, memory_info.has_bounds);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, min_key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 19, max_key);
+
+	/* a flat file knows its rows, but not how many are deleted */
+	info.min_key	= NULL;
+	info.max_key	= NULL;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get_info(&file, &info));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, info.record_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, info.pages);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 5 * 2 * (long) sizeof(int) <= info.file_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !info.has_bounds);
+
+	/* the table sums its own, the one outside it is left out */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_get_info(&total, &count));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, total.record_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, total.pages);
+	PLANCK_UNIT_ASSERT_TRUE(tc, info.file_bytes == total.file_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, info.memory_bytes + memory_info.memory_bytes == total.memory_bytes);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !total.has_bounds);
+
+	/* one no longer open is no longer counted */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_master_table_get_info(&total, &count));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, total.record_count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&outside));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&memory));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, ion_master_table_get_info(&total, &count));
+	fremove(ION_MASTER_TABLE_FILENAME);
+}
+
 planck_unit_suite_t *
 dictionary_getsuite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_compare_numerics);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_compare_widths);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table_directory);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table_open_cache);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table_reuse);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table_instances);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table_many);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_options);
+#if ION_DICTIONARY_STATS
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_stats);
+#endif
+#if ION_ALLOC_TRACKING
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_memory);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_allocator_pool);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_allocator_arena);
+#endif
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_durability);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_checkpoint);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_info);
 
 	return suite;
 }
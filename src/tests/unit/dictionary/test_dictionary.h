@@ -8,7 +8,9 @@
 #include "../../../dictionary/dictionary_types.h"
 #include "./../../../dictionary/dictionary.h"
 #include "./../../../dictionary/ion_master_table.h"
+#include "./../../../file/ion_file.h"
 #include "../../../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../../../dictionary/skip_list/skip_list_handler.h"
 
 #ifdef  __cplusplus
 extern "C" {
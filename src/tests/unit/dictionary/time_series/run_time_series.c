@@ -0,0 +1,8 @@
+#include "test_time_series.h"
+
+int
+main(
+) {
+	runalltests_time_series();
+	return 0;
+}
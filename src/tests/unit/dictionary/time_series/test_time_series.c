@@ -0,0 +1,439 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the appends, block skipping and retention of the time
+			series.
+*/
+/******************************************************************************/
+
+#include "test_time_series.h"
+
+/**
+@brief		The bytes of the blocks of the tests, which hold nine records of
+			int keys a step under 128 apart and int values.
+*/
+#define TS_TEST_BLOCK_SIZE	64
+
+/**
+@brief		The records a block of the tests holds.
+*/
+#define TS_TEST_PER_BLOCK	9
+
+/**
+@brief		Opens the series of int keys and values of @p id.
+*/
+static ion_err_t
+initialize_time_series(
+	ion_time_series_t	*time_series,
+	ion_dictionary_id_t id
+) {
+	time_series->super.compare = dictionary_compare_signed_value;
+	return ts_initialize(time_series, id, key_type_numeric_signed, sizeof(int), sizeof(int), TS_TEST_BLOCK_SIZE);
+}
+
+/**
+@brief		Appends the keys @c 0, @p step and on up to @p count records,
+			each with its index as the value.
+*/
+static void
+fill_time_series(
+	planck_unit_test_t	*tc,
+	ion_time_series_t	*time_series,
+	int					count,
+	int					step
+) {
+	int i;
+
+	for (i = 0; i < count; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_append(time_series, IONIZE(step * i, int), IONIZE(i, int)).error);
+	}
+}
+
+/**
+@brief		Tests that records fill one block after another, keep to key
+			order, and are each found again.
+*/
+void
+test_time_series_append_query(
+	planck_unit_test_t *tc
+) {
+	ion_time_series_t	time_series;
+	int					value;
+	int					i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_time_series(&time_series, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ts_query(&time_series, IONIZE(0, int), &value).error);
+
+	fill_time_series(tc, &time_series, 100, 3);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (100 + TS_TEST_PER_BLOCK - 1) / TS_TEST_PER_BLOCK, time_series.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, ts_append(&time_series, IONIZE(296, int), IONIZE(0, int)).error);
+
+	for (i = -1; i <= 300; i++) {
+		if ((i >= 0) && (0 == i % 3) && (i < 300)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_query(&time_series, IONIZE(i, int), &value).error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i / 3, value);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, ts_query(&time_series, IONIZE(i, int), &value).error);
+		}
+	}
+
+	/* a key equal to the last one is still in order */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_append(&time_series, IONIZE(297, int), IONIZE(1000, int)).error);
+
+	/* a step too wide for one varint byte takes more room, but still decodes */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_append(&time_series, IONIZE(1000000, int), IONIZE(7, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_query(&time_series, IONIZE(1000000, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 7, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_destroy(&time_series));
+}
+
+/**
+@brief		Tests that sizes the series cannot work with are refused.
+*/
+void
+test_time_series_invalid(
+	planck_unit_test_t *tc
+) {
+	ion_time_series_t time_series;
+
+	time_series.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, ts_initialize(&time_series, 1, key_type_numeric_signed, 3, sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, ts_initialize(&time_series, 1, key_type_char_array, sizeof(int), sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_initial_size, ts_initialize(&time_series, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 16));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_initialize(&time_series, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_TS_BLOCK_SIZE, time_series.block_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_destroy(&time_series));
+}
+
+/**
+@brief		Tests that a range cursor reads only the blocks that overlap
+			its range, and that appends made while it is open are read.
+*/
+void
+test_time_series_range_skip(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_time_series_t			*time_series;
+	unsigned long				reads;
+	int							key;
+	int							value;
+	int							i;
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	tsdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 2, key_type_numeric_signed, sizeof(int), sizeof(int), TS_TEST_BLOCK_SIZE));
+	time_series = (ion_time_series_t *) dictionary.instance;
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(2 * i, int), IONIZE(i, int)).error);
+	}
+
+	reads = time_series->reads;
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(1001, int), IONIZE(1100, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 501; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * i, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 551, i);
+	cursor->destroy(&cursor);
+
+	/* 50 records span at most seven blocks of nine, of the more than a hundred there are */
+	PLANCK_UNIT_ASSERT_TRUE(tc, time_series->reads - reads <= 7);
+
+	reads = time_series->reads;
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(1501, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_TRUE(tc, time_series->reads - reads <= 1);
+
+	/* past the last key nothing is read at all */
+	reads = time_series->reads;
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(5000, int), IONIZE(6000, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, reads, time_series->reads);
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 0; i < 995; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * i, key);
+	}
+
+	/* appends to the tail under the cursor, then into blocks after it */
+	for (i = 1000; i < 1030; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(2 * i, int), IONIZE(i, int)).error);
+	}
+
+	for (i = 995; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * i, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1030, i);
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_not_implemented, dictionary_delete(&dictionary, IONIZE(2, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that the records of a key that run over several blocks
+			are all found and all updated.
+*/
+void
+test_time_series_duplicates(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_status_t				status;
+	int							key;
+	int							value;
+	int							i;
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	tsdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 3, key_type_numeric_signed, sizeof(int), sizeof(int), TS_TEST_BLOCK_SIZE));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(4, int), IONIZE(-1, int)).error);
+
+	for (i = 0; i < 30; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(5, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(6, int), IONIZE(-1, int)).error);
+
+	dictionary_build_predicate(&predicate, predicate_equality, IONIZE(5, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 0; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 30, i);
+	cursor->destroy(&cursor);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(5, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, value);
+
+	status = dictionary_update(&dictionary, IONIZE(5, int), IONIZE(77, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 30, status.count);
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(4, int), IONIZE(6, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (i = 0; cs_cursor_active == cursor->next(cursor, &record); i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (5 == key) ? 77 : -1, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 32, i);
+	cursor->destroy(&cursor);
+
+	/* an update of a key there is none of appends it */
+	status = dictionary_update(&dictionary, IONIZE(9, int), IONIZE(90, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(9, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 90, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, dictionary_update(&dictionary, IONIZE(8, int), IONIZE(80, int)).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that whole blocks of old records are dropped, and that
+			their slots are written again before the file grows.
+*/
+void
+test_time_series_drop_before(
+	planck_unit_test_t *tc
+) {
+	ion_time_series_t	time_series;
+	ion_file_offset_t	end;
+	ion_status_t		status;
+	long				blocks;
+	int					value;
+	int					oldest;
+	int					i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_time_series(&time_series, 4));
+	fill_time_series(tc, &time_series, 100, 1);
+	blocks = time_series.count;
+
+	/* nothing is older than the first key */
+	status = ts_drop_before(&time_series, IONIZE(0, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, status.count);
+
+	status = ts_drop_before(&time_series, IONIZE(50, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50 / TS_TEST_PER_BLOCK * TS_TEST_PER_BLOCK, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, blocks - 50 / TS_TEST_PER_BLOCK, time_series.count);
+
+	oldest = status.count;
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i < oldest) ? err_item_not_found : err_ok, ts_query(&time_series, IONIZE(i, int), &value).error);
+	}
+
+	/* the freed slots are taken before the file grows */
+	end = time_series.end;
+
+	for (i = 100; i < 100 + oldest; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_append(&time_series, IONIZE(i, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, end, time_series.end);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, time_series.free_count);
+
+	/* reopened, the blocks are back in seq order though their slots are not */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_close(&time_series));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, initialize_time_series(&time_series, 4));
+
+	for (i = 0; i < 100 + oldest; i++) {
+		status = ts_query(&time_series, IONIZE(i, int), &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (i < oldest) ? err_item_not_found : err_ok, status.error);
+	}
+
+	/* the tail is never dropped */
+	status = ts_drop_before(&time_series, IONIZE(100000, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, time_series.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_query(&time_series, IONIZE(100 + oldest - 1, int), &value).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_destroy(&time_series));
+}
+
+/**
+@brief		Tests that a closed series is read back from its file,
+			through the dictionary interface, and appended to again.
+*/
+void
+test_time_series_reopen(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config = { 5, 0, key_type_numeric_signed, sizeof(int), sizeof(int), TS_TEST_BLOCK_SIZE };
+	int								value;
+	int								i;
+
+	tsdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 5, key_type_numeric_signed, sizeof(int), sizeof(int), TS_TEST_BLOCK_SIZE));
+
+	for (i = 0; i < 40; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(10 * i, int), IONIZE(i, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+
+	for (i = 0; i < 40; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(10 * i, int), &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	/* the tail was taken back, so keys go on from where they stopped */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, dictionary_insert(&dictionary, IONIZE(385, int), IONIZE(0, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, IONIZE(400, int), IONIZE(40, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, tsdict_flush(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, IONIZE(400, int), &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests keys that go from negative to positive, narrow and wide.
+*/
+void
+test_time_series_signed_keys(
+	planck_unit_test_t *tc
+) {
+	ion_time_series_t	time_series;
+	ion_byte_t			*value;
+	ion_ts_reader_t		reader;
+	int64_t				wide;
+	int					found;
+	int					i;
+
+	time_series.super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_initialize(&time_series, 6, key_type_numeric_signed, sizeof(int8_t), sizeof(int), TS_TEST_BLOCK_SIZE));
+
+	for (i = -128; i < 128; i += 5) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_append(&time_series, IONIZE(i, int8_t), IONIZE(i, int)).error);
+	}
+
+	for (i = -128; i < 128; i += 5) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_query(&time_series, IONIZE(i, int8_t), &found).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, found);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_destroy(&time_series));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_initialize(&time_series, 6, key_type_numeric_signed, sizeof(int64_t), sizeof(int), 0));
+
+	for (i = -20; i < 20; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_append(&time_series, IONIZE((int64_t) i * 1000000000000LL, int64_t), IONIZE(i, int)).error);
+	}
+
+	ts_reader_start(&time_series, &reader, time_series.tail);
+
+	for (i = -20; ts_reader_next(&time_series, &reader, (ion_key_t) &wide, &value); i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, (int64_t) i * 1000000000000LL == wide);
+		/* values follow varints, so they are not aligned */
+		memcpy(&found, value, sizeof(int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, found);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20, i);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ts_destroy(&time_series));
+}
+
+planck_unit_suite_t *
+time_series_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_append_query);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_invalid);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_range_skip);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_duplicates);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_drop_before);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_reopen);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_time_series_signed_keys);
+
+	return suite;
+}
+
+void
+runalltests_time_series(
+) {
+	planck_unit_suite_t *suite = time_series_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
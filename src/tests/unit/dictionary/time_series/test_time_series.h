@@ -0,0 +1,26 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the time series.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_TIME_SERIES_H_)
+#define TEST_TIME_SERIES_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/time_series/time_series_dictionary_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_time_series(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_TIME_SERIES_H_ */
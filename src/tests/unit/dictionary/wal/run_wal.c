@@ -0,0 +1,8 @@
+#include "test_wal.h"
+
+int
+main(
+) {
+	runalltests_wal();
+	return 0;
+}
@@ -0,0 +1,381 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests the write-ahead log of dictionary changes, its group
+			commits and its replay after a crash.
+*/
+/******************************************************************************/
+
+#include <time.h>
+
+#include "test_wal.h"
+
+/**
+@brief		The identifier of the dictionaries the tests log.
+*/
+#define WAL_TEST_ID 7
+
+/**
+@brief		Removes the log and snapshot a test may have left behind.
+*/
+static void
+wal_test_clean(
+) {
+	char filename[ION_MAX_FILENAME_LENGTH];
+
+	dictionary_get_filename(WAL_TEST_ID, "wal", filename);
+	ion_fremove(filename);
+	dictionary_get_filename(WAL_TEST_ID, "ffs", filename);
+	ion_fremove(filename);
+}
+
+/**
+@brief		Creates an empty skip list of int keys and values.
+*/
+static void
+wal_test_create(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*inner_handler,
+	ion_dictionary_t			*dictionary
+) {
+	sldict_init(inner_handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(inner_handler, dictionary, WAL_TEST_ID, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+}
+
+/**
+@brief		Creates an empty skip list and wraps it in a log, replaying
+			whatever log a crash left.
+*/
+static void
+wal_test_setup(
+	planck_unit_test_t			*tc,
+	ion_dictionary_handler_t	*inner_handler,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_size_t		batch,
+	unsigned long				interval
+) {
+	wal_test_create(tc, inner_handler, dictionary);
+	waldict_init(handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, waldict_wrap(dictionary, handler, batch, interval));
+}
+
+/**
+@brief		Does away with a wrapped dictionary as a crash would: the
+			open group is lost and the log is left as it is.
+*/
+static void
+wal_test_crash(
+	ion_dictionary_t *dictionary
+) {
+	ion_wal_dictionary_t *wal = (ion_wal_dictionary_t *) dictionary->instance;
+
+	ion_fclose(wal->file);
+	dictionary_delete_dictionary(&wal->inner);
+	ion_free(wal);
+}
+
+/**
+@brief		Counts the records of a dictionary.
+@param[out]	count
+					Set to the number of records.
+*/
+static void
+wal_test_count(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					*count
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					key;
+	int					value;
+
+	*count			= 0;
+	record.key		= &key;
+	record.value	= &value;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(dictionary, &predicate, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		(*count)++;
+	}
+
+	cursor->destroy(&cursor);
+}
+
+/**
+@brief		Gets a key and checks its value.
+*/
+static void
+wal_test_get(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					key,
+	int					expected
+) {
+	int				value	= 0;
+	ion_status_t	status	= dictionary_get(dictionary, IONIZE(key, int), &value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, value);
+}
+
+/**
+@brief		Inserts keys from @p from up to but not including @p to, each
+			with a value of ten times the key.
+*/
+static void
+wal_test_insert(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					from,
+	int					to
+) {
+	int i;
+
+	for (i = from; i < to; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(dictionary, IONIZE(i, int), IONIZE(i * 10, int)).error);
+	}
+}
+
+/**
+@brief		Tests that inserts, updates and deletes are replayed after a
+			crash, and that closing leaves a snapshot in place of the log.
+*/
+void
+test_wal_replay(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		inner_handler;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config = {
+		WAL_TEST_ID, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 7
+	};
+	char							filename[ION_MAX_FILENAME_LENGTH];
+	int								count;
+	int								i;
+
+	wal_test_clean();
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 4, 0);
+
+	/* twelve changes, three whole groups */
+	wal_test_insert(tc, &dictionary, 0, 10);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, IONIZE(3, int), IONIZE(33, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dictionary_delete(&dictionary, IONIZE(5, int)).count);
+
+	/* a delete that finds nothing is not logged, or it would open a fourth group */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_delete(&dictionary, IONIZE(50, int)).error);
+	wal_test_crash(&dictionary);
+
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 4, 0);
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, count);
+	wal_test_get(tc, &dictionary, 3, 33);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, IONIZE(5, int), &i).error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	dictionary_get_filename(WAL_TEST_ID, "wal", filename);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !ion_fexists(filename));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&inner_handler, &dictionary, &config));
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, count);
+	wal_test_get(tc, &dictionary, 9, 90);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	wal_test_clean();
+}
+
+/**
+@brief		Tests that a crash loses only the open group, and that a
+			commit closes one early.
+*/
+void
+test_wal_group_commit(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	int							count;
+
+	wal_test_clean();
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 4, 0);
+	wal_test_insert(tc, &dictionary, 0, 6);
+	wal_test_crash(&dictionary);
+
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 4, 0);
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, count);
+
+	wal_test_insert(tc, &dictionary, 4, 6);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, waldict_commit(&dictionary));
+	wal_test_insert(tc, &dictionary, 6, 7);
+	wal_test_crash(&dictionary);
+
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 4, 0);
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, count);
+	wal_test_get(tc, &dictionary, 5, 50);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	wal_test_clean();
+}
+
+/**
+@brief		Tests that a torn group at the end of the log is ignored and
+			written over.
+*/
+void
+test_wal_torn_group(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	char						filename[ION_MAX_FILENAME_LENGTH];
+	ion_byte_t					torn[]	= { ION_WAL_INSERT, 1, 2, 3, 4, 5, 6, 7, 8, ION_WAL_COMMIT, 0, 0, 0, 0 };
+	ion_file_handle_t			file;
+	int							count;
+
+	wal_test_clean();
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 1, 0);
+	wal_test_insert(tc, &dictionary, 0, 3);
+	wal_test_crash(&dictionary);
+
+	/* a group that was written whole, but with the wrong checksum */
+	dictionary_get_filename(WAL_TEST_ID, "wal", filename);
+	file = ion_fopen(filename);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fseek(file, 0, ION_FILE_END));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, sizeof(torn), torn));
+	ion_fclose(file);
+
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 1, 0);
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, count);
+	wal_test_insert(tc, &dictionary, 3, 4);
+	wal_test_crash(&dictionary);
+
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 1, 0);
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, count);
+	wal_test_get(tc, &dictionary, 3, 30);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	wal_test_clean();
+}
+
+/**
+@brief		Tests that the records a dictionary holds when wrapped are
+			logged, and that a log is replayed in place of whatever the
+			dictionary it is replayed onto holds.
+*/
+void
+test_wal_copy(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	int							count;
+
+	wal_test_clean();
+	wal_test_create(tc, &inner_handler, &dictionary);
+	wal_test_insert(tc, &dictionary, 0, 3);
+	waldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, waldict_wrap(&dictionary, &handler, 4, 0));
+	wal_test_insert(tc, &dictionary, 3, 4);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, waldict_commit(&dictionary));
+	wal_test_crash(&dictionary);
+
+	/* as if opened from a snapshot the log has since moved past */
+	wal_test_create(tc, &inner_handler, &dictionary);
+	wal_test_insert(tc, &dictionary, 0, 2);
+	wal_test_insert(tc, &dictionary, 100, 102);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, waldict_wrap(&dictionary, &handler, 4, 0));
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, count);
+	wal_test_get(tc, &dictionary, 2, 20);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, IONIZE(100, int), IONIZE(0, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	wal_test_clean();
+}
+
+#if !defined(ARDUINO)
+
+/**
+@brief		Tests that a group is committed by the first change logged
+			after it has been open for the interval.
+*/
+void
+test_wal_interval(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	clock_t						start;
+	int							count;
+
+	wal_test_clean();
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 100, 1);
+	wal_test_insert(tc, &dictionary, 0, 1);
+
+	/* spinning spends processor time no faster than the wall clock goes */
+	start = clock();
+
+	while ((clock() - start) * 1000 / CLOCKS_PER_SEC < 5) {}
+
+	wal_test_insert(tc, &dictionary, 1, 2);
+	wal_test_crash(&dictionary);
+
+	wal_test_setup(tc, &inner_handler, &handler, &dictionary, 100, 1);
+	wal_test_count(tc, &dictionary, &count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	wal_test_clean();
+}
+
+#endif
+
+/**
+@brief		Tests that a dictionary without a log cannot be committed.
+*/
+void
+test_wal_commit_not_wrapped(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	inner_handler;
+	ion_dictionary_t			dictionary;
+
+	wal_test_create(tc, &inner_handler, &dictionary);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, waldict_commit(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+planck_unit_suite_t *
+wal_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_wal_replay);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_wal_group_commit);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_wal_torn_group);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_wal_copy);
+#if !defined(ARDUINO)
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_wal_interval);
+#endif
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_wal_commit_not_wrapped);
+
+	return suite;
+}
+
+void
+runalltests_wal(
+) {
+	planck_unit_suite_t *suite = wal_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
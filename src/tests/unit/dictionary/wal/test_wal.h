@@ -0,0 +1,27 @@
+/******************************************************************************/
+/**
+@file
+@brief		Tests for the write-ahead log of dictionary changes.
+*/
+/******************************************************************************/
+
+#if !defined(TEST_WAL_H_)
+#define TEST_WAL_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/wal/wal_dictionary_handler.h"
+#include "../../../../dictionary/skip_list/skip_list_handler.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void
+runalltests_wal(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TEST_WAL_H_ */
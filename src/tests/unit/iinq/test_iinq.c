@@ -1,4 +1,7 @@
 #include "test_iinq.h"
+#include "../../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../../../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
 
 void
 iinq_test_create_open_source(
@@ -246,6 +249,1345 @@ iinq_test_create_query_select_all_from_where_two_dictionaries(
 	DROP(test2);
 }
 
+IINQ_NEW_PROCESSOR_FUNC(count_results) {
+	UNUSED(result);
+	(*(int *) state)++;
+}
+
+int
+iinq_test_count_kept(
+	void
+) {
+	int							count;
+	ion_iinq_query_processor_t	processor;
+
+	count		= 0;
+	processor	= IINQ_QUERY_PROCESSOR(count_results, &count);
+
+	QUERY(
+		SELECT_ALL,
+		FROM(kept),
+		WHERE(NEUTRALIZE(kept.value, int) == NEUTRALIZE(kept.key, int) * 2),
+		,
+		,
+		,
+		,
+		,
+		&processor
+	);
+
+	return count;
+}
+
+void
+iinq_test_sources_kept_open(
+	planck_unit_test_t	*tc
+) {
+	ion_err_t					error;
+	ion_status_t			status;
+	ion_dictionary_t			*dictionary;
+	ion_dictionary_t			*again;
+	int						i;
+
+	error		= CREATE_DICTIONARY(kept, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	for (i = 0; i < 10; i++) {
+		status	= INSERT(kept, IONIZE(i, int), IONIZE(i * 2, int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+		/* Nothing was closed between the statements. */
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ion_master_table_file);
+	}
+
+	error		= iinq_acquire_source("kept.inq", &dictionary);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	error		= iinq_acquire_source("kept.inq", &again);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary == again);
+
+	/* A source in use is not closed. */
+	error		= iinq_close_all_sources();
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ion_master_table_file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_release_source(again));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_release_source(dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, iinq_test_count_kept());
+
+	error		= iinq_close_all_sources();
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_master_table_file);
+
+	/* The records reached the files, and the source opens again. */
+	status		= INSERT(kept, IONIZE(10, int), IONIZE(20, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 11, iinq_test_count_kept());
+
+	error		= DROP(kept);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+ion_boolean_t
+iinq_test_value_is_double(
+	ion_iinq_prepared_t *query,
+	void				*state
+) {
+	UNUSED(state);
+	return NEUTRALIZE(query->sources[0].value, int) == NEUTRALIZE(query->sources[0].key, int) * 2;
+}
+
+IINQ_NEW_PROCESSOR_FUNC(sum_join_keys) {
+	(*(int *) state) += NEUTRALIZE(result->data, int) * 100 + NEUTRALIZE(result->data + 2 * sizeof(int), int);
+}
+
+void
+iinq_test_prepared_query(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_prepared_t			join;
+	ion_iinq_query_processor_t	processor;
+	char						*single[1]	= { "ready.inq" };
+	char						*both[2]	= { "ready.inq", "other.inq" };
+	int							count;
+	int							sum;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(ready, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(other, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	for (i = 0; i < 10; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(ready, IONIZE(i, int), IONIZE(i * 2, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(ready, IONIZE(100, int), IONIZE(1, int)).error);
+
+	for (i = 1; i <= 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(other, IONIZE(i, int), IONIZE(0, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_out_of_bounds, iinq_prepare(&query, single, 0, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_file_open_error, iinq_prepare(&query, (char *[]) { "ready.inq", "missing.inq" }, 2, NULL, NULL));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, single, 1, iinq_test_value_is_double, NULL));
+	processor = IINQ_QUERY_PROCESSOR(count_results, &count);
+
+	/* run again and again, each run sees what was written before it */
+	for (i = 0; i < 3; i++) {
+		count = 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10 + i, count);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(ready, IONIZE(10 + i, int), IONIZE((10 + i) * 2, int)).error);
+	}
+
+	/* a prepared query holds its sources */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, DROP(ready));
+
+	/* every record of the one joined to every record of the other */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&join, both, 2, NULL, NULL));
+
+	for (i = 0; i < 2; i++) {
+		count = 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 14 * 3, count);
+	}
+
+	sum			= 0;
+	processor	= IINQ_QUERY_PROCESSOR(sum_join_keys, &sum);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+	/* the keys of ready sum to 0 + ... + 12 + 100, each with 3 of other, whose keys sum to 6 */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (78 + 100) * 3 * 100 + 6 * 14, sum);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&join));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(ready));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(other));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+ion_boolean_t
+iinq_test_value_is_key(
+	ion_iinq_prepared_t *query,
+	void				*state
+) {
+	UNUSED(state);
+	return NEUTRALIZE(query->sources[0].value, int) == NEUTRALIZE(query->sources[1].key, int);
+}
+
+IINQ_NEW_PROCESSOR_FUNC(sum_joined) {
+	int *sums = state;
+
+	sums[0]++;
+	/* the key of the first, the value of the second and the key of the third */
+	sums[1] += NEUTRALIZE(result->data, int) * 1000 + NEUTRALIZE(result->data + 3 * sizeof(int), int);
+
+	if (result->num_bytes > 4 * sizeof(int)) {
+		sums[1] += NEUTRALIZE(result->data + 4 * sizeof(int), int) * 7;
+	}
+}
+
+void
+iinq_test_hash_join(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			loop;
+	ion_iinq_prepared_t			join;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_field_t			fields[2]	= { { boolean_true, 0, sizeof(int) }, { boolean_false, 0, sizeof(int) } };
+	ion_iinq_field_t			unfit[2]	= { { boolean_true, 1, sizeof(int) }, { boolean_false, 0, sizeof(int) } };
+	char						*names[3]	= { "facts.inq", "dims.inq", "third.inq" };
+	int							expected[2];
+	int							sums[2];
+	int							count;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(facts, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(dims, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(third, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	/* each fact names a dimension in its value, some of them missing */
+	for (i = 0; i < 200; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(facts, IONIZE(i, int), IONIZE(i % 13, int)).error);
+	}
+
+	for (i = 0; i < 10; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(dims, IONIZE(i, int), IONIZE(i * 10, int)).error);
+	}
+
+	for (i = 0; i < 2; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(third, IONIZE(i + 1, int), IONIZE(0, int)).error);
+	}
+
+	/* as many sources as are given, the hash join keeping to the results of the nested loop */
+	for (count = 2; count <= 3; count++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&loop, names, count, iinq_test_value_is_key, NULL));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&join, names, count, NULL, NULL));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_join_on(&join, unfit));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_join_on(&join, fields));
+
+		expected[0] = 0;
+		expected[1] = 0;
+		processor	= IINQ_QUERY_PROCESSOR(sum_joined, expected);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&loop, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (200 - 3 * 15) * (count - 1), expected[0]);
+
+		for (i = 0; i < 2; i++) {
+			sums[0]		= 0;
+			sums[1]		= 0;
+			processor	= IINQ_QUERY_PROCESSOR(sum_joined, sums);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected[0], sums[0]);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected[1], sums[1]);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&join));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&loop));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&join, names, 1, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_illegal_state, iinq_join_on(&join, fields));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&join));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(facts));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(dims));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(third));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		How many nodes of a source's tree have been read, from its
+			buffers or its file.
+*/
+unsigned long
+iinq_test_node_reads(
+	ion_iinq_source_t *source
+) {
+	ion_bpp_stats_t stats;
+
+	bStats(((ion_bpptree_t *) source->dictionary.instance)->tree, &stats);
+
+	return stats.buffers.hits + stats.buffers.misses;
+}
+
+int
+iinq_test_count_pushed_equal(
+	int key
+) {
+	int							count;
+	ion_iinq_query_processor_t	processor;
+
+	count		= 0;
+	processor	= IINQ_QUERY_PROCESSOR(count_results, &count);
+
+	QUERY(
+		SELECT_ALL,
+		FROM_KEY_EQUALS(pushed, IONIZE(key, int)),
+		WHERE(1),
+		,
+		,
+		,
+		,
+		,
+		&processor
+	);
+
+	return count;
+}
+
+int
+iinq_test_count_pushed_range(
+	int lower,
+	int upper
+) {
+	int							count;
+	ion_iinq_query_processor_t	processor;
+
+	count		= 0;
+	processor	= IINQ_QUERY_PROCESSOR(count_results, &count);
+
+	QUERY(
+		SELECT_ALL,
+		FROM_KEY_RANGE(pushed, IONIZE(lower, int), IONIZE(upper, int)),
+		WHERE(NEUTRALIZE(pushed.value, int) == NEUTRALIZE(pushed.key, int) + 1),
+		,
+		,
+		,
+		,
+		,
+		&processor
+	);
+
+	return count;
+}
+
+void
+iinq_test_key_pushdown(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_query_processor_t	processor;
+	char						*names[1] = { "pushed.inq" };
+	unsigned long				reads[3];
+	int							count;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(pushed, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	for (i = 0; i < 2000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(pushed, IONIZE(i, int), IONIZE(i + 1, int)).error);
+	}
+
+	/* the cursor is only given the records the key allows */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, iinq_test_count_pushed_equal(42));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, iinq_test_count_pushed_equal(5000));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 11, iinq_test_count_pushed_range(100, 110));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, names, 1, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_out_of_bounds, iinq_where_key_equals(&query, 1, IONIZE(42, int)));
+	processor	= IINQ_QUERY_PROCESSOR(count_results, &count);
+
+	count		= 0;
+	reads[0]	= iinq_test_node_reads(&query.sources[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2000, count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_where_key_equals(&query, 0, IONIZE(42, int)));
+	count		= 0;
+	reads[1]	= iinq_test_node_reads(&query.sources[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, count);
+	reads[2]	= iinq_test_node_reads(&query.sources[0]);
+
+	/* a seek reads a path down the tree, not every leaf */
+	PLANCK_UNIT_ASSERT_TRUE(tc, 4 * (reads[2] - reads[1]) < reads[1] - reads[0]);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_where_key_range(&query, 0, IONIZE(1990, int), IONIZE(2100, int)));
+
+	for (i = 0; i < 2; i++) {
+		count = 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, count);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(pushed));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		Counts the batches and the results a batched query passes, and
+			sums the first integer of each result.
+*/
+void
+iinq_test_sum_batch(
+	ion_iinq_batch_t	*batch,
+	void				*state
+) {
+	int *sums = state;
+	int i;
+
+	sums[0]++;
+	sums[1] += batch->count;
+
+	for (i = 0; i < batch->count; i++) {
+		sums[2] += NEUTRALIZE(batch->data + i * batch->num_bytes, int);
+	}
+}
+
+void
+iinq_test_batched_results(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_batch_processor_t	processor;
+	ion_iinq_projection_t		value[1]	= { { 0, { boolean_true, 0, sizeof(int) } } };
+	ion_iinq_projection_t		unfit[1]	= { { 0, { boolean_true, 1, sizeof(int) } } };
+	ion_iinq_projection_t		other[1]	= { { 1, { boolean_false, 0, sizeof(int) } } };
+	ion_iinq_projection_t		wide[3]		= { { 0, { boolean_false, 0, sizeof(int) } }, { 0, { boolean_true, 0, sizeof(int) } }, { 0, { boolean_false, 0, sizeof(int) } } };
+	char						*names[1]	= { "batched.inq" };
+	int							sums[3];
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(batched, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	for (i = 0; i < 150; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(batched, IONIZE(i, int), IONIZE(i * 3, int)).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, names, 1, NULL, NULL));
+	processor = IINQ_BATCH_PROCESSOR(iinq_test_sum_batch, sums);
+
+	/* the batch is kept from one run to the next */
+	for (i = 0; i < 2; i++) {
+		memset(sums, 0, sizeof(sums));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute_batched(&query, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (150 + IINQ_BATCH_ROWS - 1) / IINQ_BATCH_ROWS, sums[0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 150, sums[1]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 149 * 150 / 2, sums[2]);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_select(&query, unfit, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_out_of_bounds, iinq_select(&query, other, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_select(&query, wide, 3));
+
+	/* only the value is laid out for each result */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_select(&query, value, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(int), query.result.num_bytes);
+	memset(sums, 0, sizeof(sums));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute_batched(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 150, sums[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * 149 * 150 / 2, sums[2]);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_select(&query, NULL, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * sizeof(int), query.result.num_bytes);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(batched));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		The keys and values of the results of a query, as they came.
+*/
+typedef struct {
+	int count;
+	int keys[16];
+	int values[16];
+} iinq_test_rows_t;
+
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_record_row) {
+	iinq_test_rows_t *rows = state;
+
+	if (rows->count < 16) {
+		rows->keys[rows->count]		= NEUTRALIZE(result->data, int);
+		rows->values[rows->count]	= NEUTRALIZE(result->data + sizeof(int), int);
+	}
+
+	rows->count++;
+}
+
+void
+iinq_test_query_top_values(
+	iinq_test_rows_t *rows
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(iinq_test_record_row, rows);
+
+	QUERY(
+		SELECT_ALL,
+		FROM(ordered),
+		WHERE(1),
+		,
+		,
+		ORDER_BY(DESCENDING(sizeof(int), sizeof(int), key_type_numeric_signed), ASCENDING(0, sizeof(int), key_type_numeric_signed)),
+		LIMIT(5),
+		,
+		&processor
+	);
+}
+
+void
+iinq_test_query_first_keys(
+	iinq_test_rows_t *rows
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(iinq_test_record_row, rows);
+
+	QUERY(
+		SELECT_ALL,
+		FROM(ordered),
+		WHERE(NEUTRALIZE(ordered.value, int) != 0),
+		,
+		,
+		ORDER_BY(ASCENDING(0, sizeof(int), key_type_numeric_signed)),
+		LIMIT(3),
+		,
+		&processor
+	);
+}
+
+void
+iinq_test_query_limited(
+	iinq_test_rows_t *rows
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(iinq_test_record_row, rows);
+
+	QUERY(
+		SELECT_ALL,
+		FROM(ordered),
+		WHERE(1),
+		,
+		,
+		,
+		LIMIT(4),
+		,
+		&processor
+	);
+}
+
+ion_boolean_t
+iinq_test_count_read(
+	ion_iinq_prepared_t *query,
+	void				*state
+) {
+	UNUSED(query);
+	(*(int *) state)++;
+	return boolean_true;
+}
+
+void
+iinq_test_order_limit(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_order_t			by_value[1] = { DESCENDING(sizeof(int), sizeof(int), key_type_numeric_signed) };
+	ion_iinq_order_t			by_key[1]	= { ASCENDING(0, sizeof(int), key_type_numeric_signed) };
+	ion_iinq_order_t			unfit[1]	= { ASCENDING(sizeof(int) + 1, sizeof(int), key_type_numeric_signed) };
+	char						*names[1]	= { "ordered.inq" };
+	iinq_test_rows_t			rows;
+	int							read;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(ordered, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	/* keys 0 to 299 out of order, each valued at its last digit */
+	for (i = 0; i < 300; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(ordered, IONIZE(i * 7 % 300, int), IONIZE(i * 7 % 300 % 10, int)).error);
+	}
+
+	rows.count = 0;
+	iinq_test_query_top_values(&rows);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, rows.count);
+
+	for (i = 0; i < 5; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9 + 10 * i, rows.keys[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, rows.values[i]);
+	}
+
+	/* read in key order, stopping at the limit */
+	rows.count = 0;
+	iinq_test_query_first_keys(&rows);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, rows.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, rows.keys[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, rows.keys[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, rows.keys[2]);
+
+	rows.count = 0;
+	iinq_test_query_limited(&rows);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, rows.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, names, 1, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_order_by(&query, unfit, 1));
+	processor = IINQ_QUERY_PROCESSOR(iinq_test_record_row, &rows);
+
+	/* every result sorted, with no limit */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_value, 1));
+	rows.count = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 300, rows.count);
+
+	for (i = 0; i < 16; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, rows.values[i]);
+	}
+
+	iinq_limit(&query, 0);
+	rows.count = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, rows.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+
+	/* in key order, a limit stops the source being read */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, names, 1, iinq_test_count_read, &read));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_key, 1));
+	iinq_limit(&query, 2);
+	read		= 0;
+	rows.count	= 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, rows.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, rows.keys[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, rows.keys[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, read);
+
+	/* by anything else, every record is read to find the least */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_value, 1));
+	read = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 300, read);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(ordered));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		Checks that results come in descending order of the integer at
+			their middle, counting them and any out of order.
+*/
+typedef struct {
+	int count;
+	int unordered;
+	int last;
+} iinq_test_descending_t;
+
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_check_descending) {
+	iinq_test_descending_t	*check	= state;
+	int						at		= NEUTRALIZE(result->data + result->num_bytes / 2, int);
+
+	if ((0 != check->count) && (at > check->last)) {
+		check->unordered++;
+	}
+
+	check->last = at;
+	check->count++;
+}
+
+void
+iinq_test_external_sort(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_sort_t				sort;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_order_t			order[1] = { DESCENDING(512, sizeof(int), key_type_numeric_signed) };
+	ion_iinq_result_t			result;
+	iinq_test_descending_t		check;
+	unsigned char				row[1024];
+	int							rows;
+	int							value;
+	int							i;
+	int							j;
+
+	result.num_bytes	= sizeof(row);
+	result.data			= row;
+	processor			= IINQ_QUERY_PROCESSOR(iinq_test_check_descending, &check);
+	rows				= 4 * IINQ_SORT_BYTES / (int) sizeof(row) + 3;
+
+	/* more results than fit in memory, unlimited and then limited past what a heap holds */
+	for (j = 0; j < 2; j++) {
+		memset(&check, 0, sizeof(check));
+		iinq_sort_begin(&sort, order, 1, (0 == j) ? -1 : rows - 1, &processor);
+
+		for (i = 0; i < rows; i++) {
+			memset(row, i, sizeof(row));
+			value = (i * 37) % rows;
+			memcpy(row + 512, &value, sizeof(int));
+			PLANCK_UNIT_ASSERT_TRUE(tc, iinq_sort_add(&sort, &result));
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 != sort.run_count);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_sort_end(&sort, err_ok));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == j) ? rows : rows - 1, check.count);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, check.unordered);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (0 == j) ? 0 : 1, check.last);
+	}
+
+	/* the runs are gone once the sort ends */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, sort.run_count);
+}
+
+/**
+@brief		The grouped results of a query, as they came: the bytes grouped
+			by, an integer, and the aggregates before them.
+*/
+typedef struct {
+	int		aggregates;
+	int		count;
+	int		groups[8];
+	int64_t values[8][5];
+} iinq_test_groups_t;
+
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_record_group) {
+	iinq_test_groups_t	*groups = state;
+	int					i;
+
+	if (groups->count < 8) {
+		memcpy(&groups->groups[groups->count], result->data + groups->aggregates * sizeof(int64_t), sizeof(int));
+
+		for (i = 0; i < groups->aggregates; i++) {
+			groups->values[groups->count][i] = AGGREGATE(result, i);
+		}
+	}
+
+	groups->count++;
+}
+
+void
+iinq_test_query_grouped(
+	iinq_test_groups_t *groups
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(iinq_test_record_group, groups);
+
+	groups->aggregates = 5;
+
+	QUERY(
+		SELECT_ALL,
+		FROM(sales),
+		WHERE(1),
+		GROUP_BY(sizeof(int), sizeof(int), COUNT_ALL, SUM_OF(2 * sizeof(int), sizeof(int), key_type_numeric_signed), MIN_OF(2 * sizeof(int), sizeof(int), key_type_numeric_signed), MAX_OF(2 * sizeof(int), sizeof(int), key_type_numeric_signed), AVG_OF(2 * sizeof(int), sizeof(int), key_type_numeric_signed)),
+		HAVING(0 != NEUTRALIZE(grouped.data + 5 * sizeof(int64_t), int) % 2),
+		ORDER_BY(DESCENDING(sizeof(int64_t), sizeof(int64_t), key_type_numeric_signed)),
+		,
+		,
+		&processor
+	);
+}
+
+void
+iinq_test_query_grouped_by_key(
+	iinq_test_groups_t *groups
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(iinq_test_record_group, groups);
+
+	groups->aggregates = 1;
+
+	QUERY(
+		SELECT_ALL,
+		FROM(sales),
+		WHERE(1),
+		GROUP_BY(0, sizeof(int), COUNT_ALL),
+		,
+		,
+		LIMIT(3),
+		,
+		&processor
+	);
+}
+
+ion_boolean_t
+iinq_test_sum_over(
+	ion_iinq_result_t	*grouped,
+	void				*state
+) {
+	return AGGREGATE(grouped, 0) > *(int *) state;
+}
+
+void
+iinq_test_group_by(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_batch_processor_t	batched;
+	ion_iinq_aggregate_t		aggregates[2]	= { SUM_OF(2 * sizeof(int), sizeof(int), key_type_numeric_signed), AVG_OF(2 * sizeof(int), sizeof(int), key_type_numeric_signed) };
+	ion_iinq_aggregate_t		unfit[1]		= { SUM_OF(2 * sizeof(int), 3, key_type_numeric_signed) };
+	ion_iinq_order_t			by_group[1]		= { ASCENDING(2 * sizeof(int64_t), sizeof(int), key_type_numeric_signed) };
+	char						*names[1]		= { "sales.inq" };
+	iinq_test_groups_t			groups;
+	double						mean;
+	int							sale[2];
+	int							over			= 3950;
+	int							read;
+	int							sums[3];
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(sales, key_type_numeric_signed, sizeof(int), 2 * sizeof(int)));
+
+	/* sales 0 to 199, each of the region of its last digit over 5, of its own amount */
+	for (i = 0; i < 200; i++) {
+		sale[0] = i % 5;
+		sale[1] = i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(sales, IONIZE(i, int), sale).error);
+	}
+
+	/* 40 sales a region, summing to 40 times the region and 3900 */
+	memset(&groups, 0, sizeof(groups));
+	iinq_test_query_grouped(&groups);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, groups.count);
+
+	for (i = 0; i < 2; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 - 2 * i, groups.groups[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40, (int) groups.values[i][0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40 * groups.groups[i] + 3900, (int) groups.values[i][1]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, groups.groups[i], (int) groups.values[i][2]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 195 + groups.groups[i], (int) groups.values[i][3]);
+		memcpy(&mean, &groups.values[i][4], sizeof(mean));
+		PLANCK_UNIT_ASSERT_TRUE(tc, mean == groups.groups[i] + 97.5);
+	}
+
+	/* grouped by the key, each group is done as the next begins */
+	memset(&groups, 0, sizeof(groups));
+	iinq_test_query_grouped_by_key(&groups);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, groups.count);
+
+	for (i = 0; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, groups.groups[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, (int) groups.values[i][0]);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, names, 1, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_group_by(&query, sizeof(int), sizeof(int), unfit, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_group_by(&query, 3 * sizeof(int), sizeof(int), aggregates, 2));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_group_by(&query, sizeof(int), sizeof(int), aggregates, 2));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_group, 1));
+	iinq_having(&query, iinq_test_sum_over, &over);
+
+	memset(&groups, 0, sizeof(groups));
+	groups.aggregates	= 2;
+	processor			= IINQ_QUERY_PROCESSOR(iinq_test_record_group, &groups);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, groups.count);
+
+	for (i = 0; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 + i, groups.groups[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40 * (2 + i) + 3900, (int) groups.values[i][0]);
+	}
+
+	/* grouped results in batches, their first integer being the sums */
+	memset(sums, 0, sizeof(sums));
+	batched = IINQ_BATCH_PROCESSOR(iinq_test_sum_batch, sums);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute_batched(&query, &batched));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, sums[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 40 * 9 + 3 * 3900, sums[2]);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+
+	/* grouped by the key, a limit stops the source being read once its groups are done */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, names, 1, iinq_test_count_read, &read));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_group_by(&query, 0, sizeof(int), aggregates, 1));
+	iinq_limit(&query, 3);
+	read				= 0;
+	groups.count		= 0;
+	groups.aggregates	= 1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, groups.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, groups.groups[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, read);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(sales));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		The sums and means of groups by a single byte, by the byte.
+*/
+typedef struct {
+	int				count;
+	unsigned char	regions[3];
+	int64_t			sums[3];
+	double			means[3];
+} iinq_test_tallies_t;
+
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_record_tally) {
+	iinq_test_tallies_t *tallies	= state;
+	unsigned char		region		= result->data[2 * sizeof(int64_t)];
+
+	if (region < 3) {
+		tallies->sums[region]	= AGGREGATE(result, 0);
+		tallies->means[region]	= AGGREGATE_AVG(result, 1);
+	}
+
+	tallies->regions[tallies->count % 3] = region;
+	tallies->count++;
+}
+
+void
+iinq_test_query_tallied(
+	iinq_test_tallies_t *tallies
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(iinq_test_record_tally, tallies);
+
+	QUERY(
+		SELECT_ALL,
+		FROM(tallies),
+		WHERE(1),
+		GROUP_BY(sizeof(int), 1, SUM_OF(sizeof(int) + 1, sizeof(int), key_type_numeric_signed), AVG_OF(sizeof(int) + 1, sizeof(int), key_type_numeric_signed)),
+		HAVING(AGGREGATE_AVG(&grouped, 1) > 14),
+		ORDER_BY(DESCENDING(0, sizeof(int64_t), key_type_numeric_signed)),
+		,
+		,
+		&processor
+	);
+}
+
+/**
+@brief		Groups by a single byte and orders the groups, which the sort
+			holds an odd number of bytes long, so that the aggregates of
+			the grouped results passed on lie unaligned.
+*/
+void
+iinq_test_group_by_unaligned(
+	planck_unit_test_t *tc
+) {
+	iinq_test_tallies_t tallies;
+	unsigned char		tally[1 + sizeof(int)];
+	int					i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(tallies, key_type_numeric_signed, sizeof(int), sizeof(tally)));
+
+	/* tallies 0 to 29, each of the region of it over 3, of its own amount */
+	for (i = 0; i < 30; i++) {
+		tally[0] = (unsigned char) (i % 3);
+		memcpy(tally + 1, &i, sizeof(int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(tallies, IONIZE(i, int), tally).error);
+	}
+
+	/* 10 tallies a region, summing to 10 times the region and 135, region 0 failing the having and the rest by sum */
+	memset(&tallies, 0, sizeof(tallies));
+	iinq_test_query_tallied(&tallies);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, tallies.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (int) tallies.sums[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, tallies.regions[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, tallies.regions[1]);
+
+	for (i = 1; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10 * i + 135, (int) tallies.sums[i]);
+		PLANCK_UNIT_ASSERT_TRUE(tc, tallies.means[i] == i + 13.5);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(tallies));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+void
+iinq_test_query_looked_up(
+	int *count
+) {
+	ion_iinq_query_processor_t processor = IINQ_QUERY_PROCESSOR(count_results, count);
+
+	QUERY(
+		SELECT_ALL,
+		FROM_KEY_EQUALS(lookups, IONIZE(42, int)),
+		WHERE(NEUTRALIZE(lookups.value, int) == 84),
+		,
+		,
+		,
+		,
+		,
+		&processor
+	);
+}
+
+void
+iinq_test_engines(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_order_t			by_key[1]	= { ASCENDING(0, sizeof(int), key_type_numeric_signed) };
+	ion_dictionary_t			*dictionary;
+	ion_dictionary_id_t			id;
+	iinq_test_rows_t			rows;
+	FILE						*schema;
+	int							count;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(lookups, key_type_numeric_signed, sizeof(int), sizeof(int), iinq_engine_file_hash));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(log, key_type_numeric_signed, sizeof(int), sizeof(int), iinq_engine_sorted_flat_file));
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(lookups, IONIZE(i, int), IONIZE(i * 2, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(log, IONIZE(i, int), IONIZE(i * 2, int)).error);
+	}
+
+	/* opened again from their schema files, as the kind they were made */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_acquire_source("lookups.inq", &dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, oafdict_insert == dictionary->handler->insert);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !iinq_source_is_ordered(dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_release_source(dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_acquire_source("log.inq", &dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ffdict_insert == dictionary->handler->insert);
+	PLANCK_UNIT_ASSERT_TRUE(tc, iinq_source_is_ordered(dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_release_source(dictionary));
+
+	/* the log stays sorted, taking no key before its last */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_sorted_order_violation, INSERT(log, IONIZE(5, int), IONIZE(0, int)).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(log, IONIZE(100, int), IONIZE(200, int)).error);
+
+	count = 0;
+	iinq_test_query_looked_up(&count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, count);
+
+	/* a hash gives its records in no order, so an order of its key is sorted */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, (char *[]) { "lookups.inq" }, 1, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_key, 1));
+	iinq_limit(&query, 3);
+	processor	= IINQ_QUERY_PROCESSOR(iinq_test_record_row, &rows);
+	rows.count	= 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, rows.count);
+
+	for (i = 0; i < 3; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rows.keys[i]);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+
+	/* a schema of only an ID, from before kinds were written, is of a B+ tree */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(older, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	schema = fopen("older.inq", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != schema);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, fread(&id, sizeof(id), 1, schema));
+	fclose(schema);
+	schema = fopen("older.inq", "wb");
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, fwrite(&id, sizeof(id), 1, schema));
+	fclose(schema);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_acquire_source("older.inq", &dictionary));
+	PLANCK_UNIT_ASSERT_TRUE(tc, iinq_source_is_ordered(dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, id, dictionary->instance->id);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_release_source(dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(lookups));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(log));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(older));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		A condition of a join, the keys of the first two sources being
+			equal.
+*/
+static ion_boolean_t
+iinq_test_key_is_key(
+	ion_iinq_prepared_t *query,
+	void				*state
+) {
+	UNUSED(state);
+	return NEUTRALIZE(query->sources[0].key, int) == NEUTRALIZE(query->sources[1].key, int);
+}
+
+void
+iinq_test_merge_join(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			loop;
+	ion_iinq_prepared_t			join;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_field_t			keys[2]		= { { boolean_false, 0, sizeof(int) }, { boolean_false, 0, sizeof(int) } };
+	char						*names[4][3] = {
+		{ "orders.inq", "items.inq", "third.inq" }, { "orders.inq", "shipped.inq", "third.inq" }, { "orders.inq", "lookups.inq", "third.inq" }, { "items.inq", "orders.inq", "third.inq" }
+	};
+	int							expected[2];
+	int							sums[2];
+	int							count;
+	int							i;
+	int							j;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(orders, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(items, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(shipped, key_type_numeric_signed, sizeof(int), sizeof(int), iinq_engine_sorted_flat_file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(lookups, key_type_numeric_signed, sizeof(int), sizeof(int), iinq_engine_file_hash));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(third, key_type_numeric_signed, sizeof(int), sizeof(int)));
+
+	/* keys repeated on either side, some on both */
+	for (i = 0; i < 300; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(orders, IONIZE(i, int), IONIZE(i % 7, int)).error);
+
+		if (0 == i % 20) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(orders, IONIZE(i, int), IONIZE(i % 11, int)).error);
+		}
+	}
+
+	for (i = -30; i < 600; i += 3) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(items, IONIZE(i, int), IONIZE(i * 2, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(shipped, IONIZE(i, int), IONIZE(i * 2, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(lookups, IONIZE(i, int), IONIZE(i * 2, int)).error);
+
+		if (0 == i % 12) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(items, IONIZE(i, int), IONIZE(i * 5, int)).error);
+		}
+	}
+
+	for (i = 0; i < 2; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(third, IONIZE(i + 1, int), IONIZE(0, int)).error);
+	}
+
+	/* merged where both are ordered on their keys, hashed where one is not, keeping to the nested loop */
+	for (j = 0; j < 4; j++) {
+		for (count = 2; count <= 3; count++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&loop, names[j], count, iinq_test_key_is_key, NULL));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&join, names[j], count, NULL, NULL));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_join_on(&join, keys));
+			PLANCK_UNIT_ASSERT_TRUE(tc, (2 != j) == join.merged);
+
+			expected[0] = 0;
+			expected[1] = 0;
+			processor	= IINQ_QUERY_PROCESSOR(sum_joined, expected);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&loop, &processor));
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 < expected[0]);
+
+			for (i = 0; i < 2; i++) {
+				sums[0]		= 0;
+				sums[1]		= 0;
+				processor	= IINQ_QUERY_PROCESSOR(sum_joined, sums);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected[0], sums[0]);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected[1], sums[1]);
+			}
+
+			/* a merge stops as soon as it has all it wants */
+			iinq_limit(&join, 5);
+			sums[0] = 0;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, sums[0]);
+
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&join));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&loop));
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(orders));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(items));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(shipped));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(lookups));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(third));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+void
+iinq_test_explain_profile(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			join;
+	ion_iinq_prepared_t			query;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_plan_t				plan;
+	ion_iinq_profile_t			profile;
+	ion_iinq_field_t			keys[2]			= { { boolean_false, 0, sizeof(int) }, { boolean_false, 0, sizeof(int) } };
+	ion_iinq_order_t			by_key[1]		= { ASCENDING(0, sizeof(int), key_type_numeric_signed) };
+	ion_iinq_order_t			by_value[1]		= { DESCENDING(sizeof(int), sizeof(int), key_type_numeric_signed) };
+	ion_iinq_aggregate_t		aggregates[1]	= { COUNT_ALL };
+	int							sums[2];
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(orders, key_type_numeric_signed, sizeof(int), sizeof(int)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(lookups, key_type_numeric_signed, sizeof(int), sizeof(int), iinq_engine_file_hash));
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(orders, IONIZE(i, int), IONIZE(i % 7, int)).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(lookups, IONIZE(i * 2, int), IONIZE(i, int)).error);
+	}
+
+	/* each join and way of reading a source as it was chosen */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&join, (char *[]) { "orders.inq", "lookups.inq" }, 2, NULL, NULL));
+	iinq_explain(&join, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, plan.source_count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_join_nested_loop, plan.join);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_engine_bpp_tree, plan.engines[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_engine_file_hash, plan.engines[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_access_scan, plan.access[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_join_on(&join, keys));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_where_key_range(&join, 0, IONIZE(10, int), IONIZE(59, int)));
+	iinq_explain(&join, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_join_hash, plan.join);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_access_range, plan.access[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_access_scan, plan.access[1]);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !plan.filtered);
+	iinq_explain_print(&join);
+
+	/* every operator counted, the sources by the records their cursors gave */
+	iinq_profile_reset(&profile);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_profile(&join, &profile, 1));
+	sums[0]		= 0;
+	sums[1]		= 0;
+	processor	= IINQ_QUERY_PROCESSOR(sum_joined, sums);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 25, sums[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, profile.runs);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, profile.sources[0].rows_out);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 51, profile.sources[0].nexts);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, profile.sources[1].rows_out);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 25, profile.where.rows_in);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 25, profile.where.rows_out);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 25, profile.sort.rows_in);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 25, profile.sort.rows_out);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, profile.group.rows_in);
+	iinq_profile_print(&join, &profile);
+
+	/* one run of three profiled, and none once profiling stops */
+	iinq_profile_reset(&profile);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_profile(&join, &profile, 3));
+
+	for (i = 0; i < 7; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, profile.runs);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 75, profile.sort.rows_out);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_profile(&join, NULL, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&join, &processor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, profile.runs);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&join));
+
+	/* the sorts and groupings of one source */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, (char *[]) { "orders.inq" }, 1, NULL, NULL));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_where_key_equals(&query, 0, IONIZE(42, int)));
+	iinq_explain(&query, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_join_none, plan.join);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_access_seek, plan.access[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_sorting_none, plan.sorting);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_grouping_none, plan.grouping);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_key, 1));
+	iinq_explain(&query, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_sorting_by_key, plan.sorting);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, by_value, 1));
+	iinq_explain(&query, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_sorting_full, plan.sorting);
+	iinq_limit(&query, 3);
+	iinq_explain(&query, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_sorting_top, plan.sorting);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, plan.limit);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_order_by(&query, NULL, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_group_by(&query, 0, sizeof(int), aggregates, 1));
+	iinq_explain(&query, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_grouping_streaming, plan.grouping);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_group_by(&query, sizeof(int), sizeof(int), aggregates, 1));
+	iinq_explain(&query, &plan);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, iinq_grouping_hash, plan.grouping);
+	iinq_explain_print(&query);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(orders));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(lookups));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
+/**
+@brief		A condition of rows of wide values, the int at 8 bytes in
+			being of an even hundred.
+*/
+static ion_boolean_t
+iinq_test_wide_even(
+	ion_iinq_prepared_t *query,
+	void				*state
+) {
+	UNUSED(state);
+	return 0 == NEUTRALIZE((unsigned char *) query->sources[0].value + 2 * sizeof(int), int) / 100 % 2;
+}
+
+void
+iinq_test_projection_pushdown(
+	planck_unit_test_t	*tc
+) {
+	ion_iinq_prepared_t			query;
+	ion_iinq_query_processor_t	processor;
+	ion_iinq_plan_t				plan;
+	ion_iinq_projection_t		amount[1]	= { { 0, { boolean_true, 15 * sizeof(int), sizeof(int) } } };
+	ion_iinq_projection_t		read[1]		= { { 0, { boolean_true, 2 * sizeof(int), sizeof(int) } } };
+	char						*names[3]	= { "wide.inq", "wide_log.inq", "wide_hash.inq" };
+	int							value[16];
+	iinq_test_rows_t			rows;
+	unsigned char				*bytes;
+	int							j;
+	int							i;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(wide, key_type_numeric_signed, sizeof(int), sizeof(value)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(wide_log, key_type_numeric_signed, sizeof(int), sizeof(value), iinq_engine_sorted_flat_file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, CREATE_DICTIONARY(wide_hash, key_type_numeric_signed, sizeof(int), sizeof(value), iinq_engine_file_hash));
+
+	for (i = 0; i < 50; i++) {
+		for (j = 0; j < 16; j++) {
+			value[j] = i * 100 + j;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(wide, IONIZE(i, int), value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(wide_log, IONIZE(i, int), value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, INSERT(wide_hash, IONIZE(i, int), value).error);
+	}
+
+	for (j = 0; j < 3; j++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, &names[j], 1, NULL, NULL));
+		iinq_explain(&query, &plan);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(value), plan.value_size[0]);
+
+		/* only the bytes selected are read into the value, the others left as they were */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_select(&query, amount, 1));
+		iinq_explain(&query, &plan);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 15 * sizeof(int), plan.value_offset[0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(int), plan.value_size[0]);
+		iinq_explain_print(&query);
+
+		bytes = query.sources[0].value;
+		memset(bytes, 0xAB, sizeof(value));
+		processor	= IINQ_QUERY_PROCESSOR(iinq_test_record_row, &rows);
+		rows.count	= 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50, rows.count);
+
+		for (i = 0; i < 15 * (int) sizeof(int); i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0xAB, bytes[i]);
+		}
+
+		for (i = 0; i < 16; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 15, rows.keys[i] % 100);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+
+		/* a condition reads the whole of each value, unless told what it reads */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_prepare(&query, &names[j], 1, iinq_test_wide_even, NULL));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_select(&query, amount, 1));
+		iinq_explain(&query, &plan);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(value), plan.value_size[0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, iinq_where_reads(&query, (ion_iinq_projection_t[]) { { 0, { boolean_true, sizeof(value), 1 } } }, 1));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_where_reads(&query, read, 1));
+		iinq_explain(&query, &plan);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * sizeof(int), plan.value_offset[0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 14 * sizeof(int), plan.value_size[0]);
+
+		bytes = query.sources[0].value;
+		memset(bytes, 0xAB, sizeof(value));
+		rows.count = 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_execute(&query, &processor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 25, rows.count);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0xAB, bytes[0]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0xAB, bytes[2 * sizeof(int) - 1]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_finish(&query));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(wide));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(wide_log));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, DROP(wide_hash));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, iinq_close_all_sources());
+}
+
 planck_unit_suite_t *
 iinq_get_suite(
 ) {
@@ -256,6 +1598,19 @@ iinq_get_suite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_create_insert_update_delete_drop_dictionary_intint);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_create_query_select_all_from_where_single_dictionary);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_create_query_select_all_from_where_two_dictionaries);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_sources_kept_open);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_prepared_query);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_hash_join);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_key_pushdown);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_batched_results);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_order_limit);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_external_sort);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_group_by);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_group_by_unaligned);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_engines);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_merge_join);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_explain_profile);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_projection_pushdown);
 
 	return suite;
 }
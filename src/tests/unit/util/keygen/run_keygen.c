@@ -0,0 +1,9 @@
+#include "test_keygen.h"
+
+int
+main(
+	void
+) {
+	run_all_tests_keygen();
+	return 0;
+}
@@ -0,0 +1,228 @@
+#include <string.h>
+#include "test_keygen.h"
+
+#define TEST_KEYGEN_KEYS	100
+#define TEST_KEYGEN_DRAWS	10000
+
+/**
+@brief		Counts how often each key is drawn, checking every key is in range.
+*/
+static void
+test_keygen_histogram(
+	planck_unit_test_t	*tc,
+	ion_keygen_t		*generator,
+	uint32_t			*counts,
+	int					draws
+) {
+	uint32_t	key;
+	int			i;
+
+	memset(counts, 0, sizeof(uint32_t) * generator->count);
+
+	for (i = 0; i < draws; i++) {
+		key = ion_keygen_next(generator);
+		PLANCK_UNIT_ASSERT_TRUE(tc, key < generator->count);
+		counts[key]++;
+	}
+}
+
+/**
+@brief		Tests that generators of the same seed give the same keys, and
+			that a reset rewinds them.
+*/
+void
+test_keygen_reproducible(
+	planck_unit_test_t *tc
+) {
+	ion_keygen_distribution_t	distributions[]	= { ion_keygen_sequential, ion_keygen_uniform, ion_keygen_zipfian, ion_keygen_hotspot, ion_keygen_latest };
+	ion_keygen_t				first;
+	ion_keygen_t				second;
+	uint32_t					keys[50];
+	int							d;
+	int							i;
+	int							differ;
+
+	for (d = 0; d < (int) (sizeof(distributions) / sizeof(distributions[0])); d++) {
+		ion_keygen_init(&first, distributions[d], TEST_KEYGEN_KEYS, 42);
+		ion_keygen_init(&second, distributions[d], TEST_KEYGEN_KEYS, 42);
+
+		for (i = 0; i < 50; i++) {
+			keys[i] = ion_keygen_next(&first);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i], ion_keygen_next(&second));
+		}
+
+		ion_keygen_reset(&first);
+
+		for (i = 0; i < 50; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i], ion_keygen_next(&first));
+		}
+
+		if (ion_keygen_sequential != distributions[d]) {
+			ion_keygen_init(&second, distributions[d], TEST_KEYGEN_KEYS, 43);
+			differ = 0;
+
+			for (i = 0; i < 50; i++) {
+				differ += keys[i] != ion_keygen_next(&second);
+			}
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 < differ);
+		}
+	}
+}
+
+/**
+@brief		Tests that a sequential stream counts up and wraps at its count.
+*/
+void
+test_keygen_sequential(
+	planck_unit_test_t *tc
+) {
+	ion_keygen_t	generator;
+	int				i;
+
+	ion_keygen_init(&generator, ion_keygen_sequential, 10, 7);
+
+	for (i = 0; i < 25; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i % 10, ion_keygen_next(&generator));
+	}
+}
+
+/**
+@brief		Tests that a uniform stream draws every key about as often.
+*/
+void
+test_keygen_uniform(
+	planck_unit_test_t *tc
+) {
+	ion_keygen_t	generator;
+	uint32_t		counts[TEST_KEYGEN_KEYS];
+	int				i;
+
+	ion_keygen_init(&generator, ion_keygen_uniform, TEST_KEYGEN_KEYS, 1);
+	test_keygen_histogram(tc, &generator, counts, TEST_KEYGEN_DRAWS);
+
+	for (i = 0; i < TEST_KEYGEN_KEYS; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 50 < counts[i] && 150 > counts[i]);
+	}
+}
+
+/**
+@brief		Tests that a Zipfian stream favours a few keys heavily, and not
+			the lowest ones.
+*/
+void
+test_keygen_zipfian(
+	planck_unit_test_t *tc
+) {
+	ion_keygen_t	generator;
+	uint32_t		counts[TEST_KEYGEN_KEYS];
+	uint32_t		top	= 0;
+	uint32_t		low	= 0;
+	int				hottest = 0;
+	int				i;
+
+	ion_keygen_init(&generator, ion_keygen_zipfian, TEST_KEYGEN_KEYS, 1);
+	test_keygen_histogram(tc, &generator, counts, TEST_KEYGEN_DRAWS);
+
+	for (i = 0; i < TEST_KEYGEN_KEYS; i++) {
+		if (counts[i] > top) {
+			top		= counts[i];
+			hottest = i;
+		}
+
+		if (i < 10) {
+			low += counts[i];
+		}
+	}
+
+	/* the most popular of 100 ranks takes about a fifth of the draws */
+	PLANCK_UNIT_ASSERT_TRUE(tc, TEST_KEYGEN_DRAWS / 10 < top);
+	/* scattered, so the lowest keys are not the most popular */
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 != hottest);
+	PLANCK_UNIT_ASSERT_TRUE(tc, TEST_KEYGEN_DRAWS / 2 > low);
+}
+
+/**
+@brief		Tests that a hot spot stream draws its share from the hot keys.
+*/
+void
+test_keygen_hotspot(
+	planck_unit_test_t *tc
+) {
+	ion_keygen_t	generator;
+	uint32_t		counts[TEST_KEYGEN_KEYS];
+	uint32_t		hot = 0;
+	int				i;
+
+	ion_keygen_init(&generator, ion_keygen_hotspot, TEST_KEYGEN_KEYS, 1);
+	ion_keygen_set_hotspot(&generator, 10, 90);
+	test_keygen_histogram(tc, &generator, counts, TEST_KEYGEN_DRAWS);
+
+	for (i = 0; i < 10; i++) {
+		hot += counts[i];
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, TEST_KEYGEN_DRAWS * 87 / 100 < hot && TEST_KEYGEN_DRAWS * 93 / 100 > hot);
+
+	for (i = 10; i < TEST_KEYGEN_KEYS; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 < counts[i]);
+	}
+}
+
+/**
+@brief		Tests that a latest stream favours the highest keys, and follows
+			them as it grows.
+*/
+void
+test_keygen_latest(
+	planck_unit_test_t *tc
+) {
+	ion_keygen_t	generator;
+	uint32_t		counts[TEST_KEYGEN_KEYS];
+	int				i;
+	uint32_t		key;
+	int				newest = 0;
+
+	ion_keygen_init(&generator, ion_keygen_latest, TEST_KEYGEN_KEYS / 2, 1);
+	test_keygen_histogram(tc, &generator, counts, TEST_KEYGEN_DRAWS);
+
+	for (i = 0; i < TEST_KEYGEN_KEYS / 2 - 1; i++) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, counts[TEST_KEYGEN_KEYS / 2 - 1] > counts[i]);
+	}
+
+	ion_keygen_grow(&generator, TEST_KEYGEN_KEYS);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, TEST_KEYGEN_KEYS, generator.count);
+
+	for (i = 0; i < 1000; i++) {
+		key = ion_keygen_next(&generator);
+		PLANCK_UNIT_ASSERT_TRUE(tc, key < TEST_KEYGEN_KEYS);
+		newest += TEST_KEYGEN_KEYS - 1 == key;
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 100 < newest);
+}
+
+planck_unit_suite_t *
+keygen_get_suite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_keygen_reproducible);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_keygen_sequential);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_keygen_uniform);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_keygen_zipfian);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_keygen_hotspot);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_keygen_latest);
+
+	return suite;
+}
+
+void
+run_all_tests_keygen(
+) {
+	planck_unit_suite_t *suite = keygen_get_suite();
+
+	planck_unit_run_suite(suite);
+
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,19 @@
+#ifndef PLANCK_UNIT_TEST_KEYGEN_H
+#define PLANCK_UNIT_TEST_KEYGEN_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../util/keygen/keygen.h"
+
+void
+run_all_tests_keygen(
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* PLANCK_UNIT_TEST_KEYGEN_H */
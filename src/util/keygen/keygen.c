@@ -0,0 +1,180 @@
+/******************************************************************************/
+/**
+@file
+@brief		Seeded generators of key streams for benchmarks and tests.
+*/
+/******************************************************************************/
+#include <math.h>
+#include "keygen.h"
+
+/**
+@brief		Scatters a Zipfian rank over @p count keys with FNV-1a.
+*/
+static uint32_t
+ion_keygen_scatter(
+	uint32_t	rank,
+	uint32_t	count
+) {
+	uint32_t	hash = 2166136261UL;
+	int			i;
+
+	for (i = 0; i < 4; i++) {
+		hash	^= (rank >> (i * 8)) & 0xFF;
+		hash	*= 16777619UL;
+	}
+
+	return hash % count;
+}
+
+/**
+@brief		Sums the Zipfian constants of any keys added since the last sum,
+			as YCSB does, and recomputes those that depend on the count.
+*/
+static void
+ion_keygen_zeta(
+	ion_keygen_t *generator
+) {
+	double zeta2 = 1.0 + generator->half;
+
+	while (generator->zeta_count < generator->count) {
+		generator->zeta_count++;
+		generator->zetan += 1.0 / pow((double) generator->zeta_count, ION_KEYGEN_ZIPFIAN_THETA);
+	}
+
+	generator->eta = (1.0 - pow(2.0 / generator->count, 1.0 - ION_KEYGEN_ZIPFIAN_THETA)) / (1.0 - zeta2 / generator->zetan);
+}
+
+/**
+@brief		Draws a Zipfian rank in <tt>[0, count)</tt>, 0 the most popular.
+*/
+static uint32_t
+ion_keygen_rank(
+	ion_keygen_t *generator
+) {
+	double		u	= (ion_keygen_random(generator) >> 8) * (1.0 / 16777216.0);
+	double		uz	= u * generator->zetan;
+	uint32_t	rank;
+
+	if (uz < 1.0) {
+		return 0;
+	}
+
+	if (uz < 1.0 + generator->half) {
+		return (1 < generator->count) ? 1 : 0;
+	}
+
+	rank = (uint32_t) (generator->count * pow(generator->eta * u - generator->eta + 1.0, generator->alpha));
+
+	return (rank < generator->count) ? rank : generator->count - 1;
+}
+
+void
+ion_keygen_init(
+	ion_keygen_t				*generator,
+	ion_keygen_distribution_t	distribution,
+	uint32_t					count,
+	uint32_t					seed
+) {
+	generator->distribution		= distribution;
+	generator->seed				= (0 == seed) ? 1 : seed;
+	generator->state			= generator->seed;
+	generator->count			= (0 == count) ? 1 : count;
+	generator->next				= 0;
+	generator->hot_percent		= 20;
+	generator->hot_op_percent	= 80;
+	generator->zeta_count		= 0;
+	generator->zetan			= 0;
+
+	if ((ion_keygen_zipfian == distribution) || (ion_keygen_latest == distribution)) {
+		generator->half		= pow(0.5, ION_KEYGEN_ZIPFIAN_THETA);
+		generator->alpha	= 1.0 / (1.0 - ION_KEYGEN_ZIPFIAN_THETA);
+		ion_keygen_zeta(generator);
+	}
+}
+
+void
+ion_keygen_set_hotspot(
+	ion_keygen_t	*generator,
+	uint8_t			hot_percent,
+	uint8_t			hot_op_percent
+) {
+	generator->hot_percent		= (100 < hot_percent) ? 100 : hot_percent;
+	generator->hot_op_percent	= (100 < hot_op_percent) ? 100 : hot_op_percent;
+}
+
+void
+ion_keygen_grow(
+	ion_keygen_t	*generator,
+	uint32_t		count
+) {
+	if (count <= generator->count) {
+		return;
+	}
+
+	generator->count = count;
+
+	if ((ion_keygen_zipfian == generator->distribution) || (ion_keygen_latest == generator->distribution)) {
+		ion_keygen_zeta(generator);
+	}
+}
+
+uint32_t
+ion_keygen_random(
+	ion_keygen_t *generator
+) {
+	uint32_t x = generator->state;
+
+	x					^= x << 13;
+	x					^= x >> 17;
+	x					^= x << 5;
+	generator->state	= x;
+
+	return x;
+}
+
+uint32_t
+ion_keygen_next(
+	ion_keygen_t *generator
+) {
+	uint32_t	hot;
+	uint32_t	key;
+
+	switch (generator->distribution) {
+		case ion_keygen_sequential:
+			key = generator->next;
+			generator->next = (generator->next + 1 < generator->count) ? generator->next + 1 : 0;
+			return key;
+
+		case ion_keygen_zipfian:
+			return ion_keygen_scatter(ion_keygen_rank(generator), generator->count);
+
+		case ion_keygen_latest:
+			return generator->count - 1 - ion_keygen_rank(generator);
+
+		case ion_keygen_hotspot:
+			hot = (uint32_t) (((uint64_t) generator->count * generator->hot_percent) / 100);
+
+			if ((ion_keygen_random(generator) % 100) < generator->hot_op_percent) {
+				if (0 != hot) {
+					return ion_keygen_random(generator) % hot;
+				}
+			}
+			else if (hot < generator->count) {
+				return hot + ion_keygen_random(generator) % (generator->count - hot);
+			}
+
+			/* an empty side of the spot falls to the other */
+			return ion_keygen_random(generator) % generator->count;
+
+		default:
+			return ion_keygen_random(generator) % generator->count;
+	}
+}
+
+void
+ion_keygen_reset(
+	ion_keygen_t *generator
+) {
+	generator->state	= generator->seed;
+	generator->next		= 0;
+}
@@ -0,0 +1,162 @@
+/******************************************************************************/
+/**
+@file
+@brief		Seeded generators of key streams for benchmarks and tests.
+@details	A generator draws keys in <tt>[0, count)</tt> sequentially,
+			uniformly, Zipfian-skewed, from a hot spot, or skewed toward
+			the latest keys, as the YCSB workloads do. Draws come from a
+			32-bit xorshift generator, which unlike the 16-bit cycle of
+			@ref lfsr_t is long enough for a workload's operations, and
+			which gives the same stream for the same seed on AVR and on
+			hosts. The sequential, uniform and hot spot streams are all
+			integer arithmetic and so match exactly; the Zipfian and latest
+			streams map each draw through floating point, which on AVR is
+			single precision, so a rare draw near a rank boundary may land
+			on the neighbouring rank.
+*/
+/******************************************************************************/
+#if !defined(ION_KEYGEN_H_)
+#define ION_KEYGEN_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+@brief		The skew of the Zipfian and latest streams, YCSB's constant.
+*/
+#if !defined(ION_KEYGEN_ZIPFIAN_THETA)
+#define ION_KEYGEN_ZIPFIAN_THETA 0.99
+#endif
+
+/**
+@brief		How a generator picks its keys.
+*/
+typedef enum {
+	ion_keygen_sequential,	/**< 0, 1, 2 and so on, wrapping at the count. */
+	ion_keygen_uniform,		/**< Every key alike. */
+	ion_keygen_zipfian,		/**< Zipfian ranks, scattered over the keys so
+								 that popular keys are not neighbours. */
+	ion_keygen_hotspot,		/**< A share of the draws from a hot share of
+								 the keys, the lowest ones, the rest from the
+								 others. */
+	ion_keygen_latest,		/**< Zipfian ranks counted back from the highest
+								 key, so the latest inserted are the most
+								 popular. */
+} ion_keygen_distribution_t;
+
+/**
+@brief		A key stream generator, caller allocated.
+*/
+typedef struct {
+	ion_keygen_distribution_t	distribution;	/**< How keys are picked. */
+	uint32_t					seed;			/**< Restored by a reset. */
+	uint32_t					state;			/**< Of the xorshift
+													 generator. */
+	uint32_t					count;			/**< Keys to pick among. */
+	uint32_t					next;			/**< The next sequential
+													 key. */
+	uint8_t						hot_percent;	/**< Of the keys, hot. */
+	uint8_t						hot_op_percent;	/**< Of the draws, hot. */
+	uint32_t					zeta_count;		/**< Keys @c zetan sums. */
+	double						zetan;			/**< Of the Zipfian ranks, */
+	double						eta;			/**< kept up as the count */
+	double						alpha;			/**< grows. */
+	double						half;			/**< 0.5 to the power of
+													 theta. */
+} ion_keygen_t;
+
+/**
+@brief		Initializes a generator.
+@details	A hot spot stream starts with a fifth of the keys taking four
+			fifths of the draws, see @ref ion_keygen_set_hotspot.
+@param		generator
+				The generator to initialize.
+@param		distribution
+				How it picks its keys.
+@param		count
+				How many keys it picks among, at least 1.
+@param		seed
+				Its seed. Generators with the same seed, distribution and
+				count give the same keys.
+*/
+void
+ion_keygen_init(
+	ion_keygen_t				*generator,
+	ion_keygen_distribution_t	distribution,
+	uint32_t					count,
+	uint32_t					seed
+);
+
+/**
+@brief		Sets the hot spot of a hot spot stream.
+@param		generator
+				The generator to change.
+@param		hot_percent
+				The share of the keys, the lowest, that are hot.
+@param		hot_op_percent
+				The share of the draws that pick a hot key.
+*/
+void
+ion_keygen_set_hotspot(
+	ion_keygen_t	*generator,
+	uint8_t			hot_percent,
+	uint8_t			hot_op_percent
+);
+
+/**
+@brief		Grows the keys a generator picks among, as when keys are
+			inserted after it is initialized. The latest stream then favours
+			the new keys.
+@param		generator
+				The generator to grow.
+@param		count
+				How many keys it picks among now, no fewer than before.
+*/
+void
+ion_keygen_grow(
+	ion_keygen_t	*generator,
+	uint32_t		count
+);
+
+/**
+@brief		Draws the next 32 random bits of a generator, for whatever else
+			a workload decides by chance.
+@param		generator
+				The generator to draw from.
+@return		The bits.
+*/
+uint32_t
+ion_keygen_random(
+	ion_keygen_t *generator
+);
+
+/**
+@brief		Draws the next key of a generator.
+@param		generator
+				The generator to draw from.
+@return		A key in <tt>[0, count)</tt>.
+*/
+uint32_t
+ion_keygen_next(
+	ion_keygen_t *generator
+);
+
+/**
+@brief		Rewinds a generator to the first key of its stream. A grown
+			generator keeps its count.
+@param		generator
+				The generator to rewind.
+*/
+void
+ion_keygen_reset(
+	ion_keygen_t *generator
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_KEYGEN_H_ */